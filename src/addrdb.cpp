@@ -20,6 +20,7 @@
 #include <univalue.h>
 #include <util/fs.h>
 #include <util/fs_helpers.h>
+#include <util/readwritefile.h>
 #include <util/settings.h>
 #include <util/system.h>
 #include <util/translation.h>
@@ -31,14 +32,19 @@ class DbNotFoundError : public std::exception
     using std::exception::exception;
 };
 
+//! Size past which the peers.dat journal is folded into a fresh peers.dat
+static constexpr uint64_t MAX_PEERS_JOURNAL_SIZE{2 << 20};
+
 template <typename Stream, typename Data>
-bool SerializeDB(Stream& stream, const Data& data)
+bool SerializeDB(Stream& stream, const Data& data, uint256* checksum = nullptr)
 {
     // Write and commit header, data
     try {
         HashedSourceWriter hashwriter{stream};
         hashwriter << Params().MessageStart() << data;
-        stream << hashwriter.GetHash();
+        const uint256 hash{hashwriter.GetHash()};
+        stream << hash;
+        if (checksum) *checksum = hash;
     } catch (const std::exception& e) {
         return error("%s: Serialize or I/O error - %s", __func__, e.what());
     }
@@ -47,7 +53,7 @@ bool SerializeDB(Stream& stream, const Data& data)
 }
 
 template <typename Data>
-bool SerializeFileDB(const std::string& prefix, const fs::path& path, const Data& data, int version)
+bool SerializeFileDB(const std::string& prefix, const fs::path& path, const Data& data, int version, uint256* checksum = nullptr)
 {
     // Generate random temporary filename
     const uint16_t randv{GetRand<uint16_t>()};
@@ -64,7 +70,7 @@ bool SerializeFileDB(const std::string& prefix, const fs::path& path, const Data
     }
 
     // Serialize
-    if (!SerializeDB(fileout, data)) {
+    if (!SerializeDB(fileout, data, checksum)) {
         fileout.fclose();
         remove(pathTmp);
         return false;
@@ -86,7 +92,7 @@ bool SerializeFileDB(const std::string& prefix, const fs::path& path, const Data
 }
 
 template <typename Stream, typename Data>
-void DeserializeDB(Stream& stream, Data& data, bool fCheckSum = true)
+uint256 DeserializeDB(Stream& stream, Data& data, bool fCheckSum = true)
 {
     CHashVerifier<Stream> verifier(&stream);
     // de-serialize file header (network specific magic number) and ..
@@ -107,11 +113,13 @@ void DeserializeDB(Stream& stream, Data& data, bool fCheckSum = true)
         if (hashTmp != verifier.GetHash()) {
             throw std::runtime_error{"Checksum mismatch, data corrupted"};
         }
+        return hashTmp;
     }
+    return uint256{};
 }
 
 template <typename Data>
-void DeserializeFileDB(const fs::path& path, Data& data, int version)
+uint256 DeserializeFileDB(const fs::path& path, Data& data, int version)
 {
     // open input file, and associate with CAutoFile
     FILE* file = fsbridge::fopen(path, "rb");
@@ -119,7 +127,62 @@ void DeserializeFileDB(const fs::path& path, Data& data, int version)
     if (filein.IsNull()) {
         throw DbNotFoundError{};
     }
-    DeserializeDB(filein, data);
+    return DeserializeDB(filein, data);
+}
+
+/**
+ * The peers.dat journal starts with the checksum of the peers.dat it applies to,
+ * followed by the segments written by AddrMan::SerializeChanges(), each framed
+ * like a database file of its own so a torn append is detected on reading.
+ */
+bool AppendPeersJournal(const fs::path& path, const CDataStream& changes)
+{
+    FILE* file = fsbridge::fopen(path, "ab");
+    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+    if (fileout.IsNull()) {
+        return error("%s: Failed to open file %s", __func__, fs::PathToString(path));
+    }
+    const std::vector<unsigned char> segment{UCharCast(changes.data()), UCharCast(changes.data() + changes.size())};
+    if (!SerializeDB(fileout, segment)) {
+        return false;
+    }
+    if (!FileCommit(fileout.Get())) {
+        return error("%s: Failed to flush file %s", __func__, fs::PathToString(path));
+    }
+    return true;
+}
+
+/**
+ * Apply the peers.dat journal to an addrman just loaded from a peers.dat with the given checksum.
+ * @returns false if the journal belongs to another peers.dat or is damaged, in which case
+ *          a fresh peers.dat should be written to start a new journal.
+ */
+bool ReadPeersJournal(const fs::path& path, const uint256& peers_checksum, AddrMan& addrman)
+{
+    const auto [read, contents]{ReadBinaryFile(path)};
+    if (!read) return false;
+    CDataStream ss{MakeUCharSpan(contents), SER_DISK, CLIENT_VERSION};
+    int segments{0};
+    try {
+        uint256 journal_checksum;
+        DeserializeDB(ss, journal_checksum);
+        if (journal_checksum != peers_checksum) {
+            LogPrintf("Ignoring peers_journal.dat because it was written for a different peers.dat\n");
+            return false;
+        }
+        while (!ss.empty()) {
+            std::vector<unsigned char> segment;
+            DeserializeDB(ss, segment);
+            CDataStream ss_changes{segment, SER_DISK, CLIENT_VERSION};
+            addrman.UnserializeChanges(ss_changes);
+            ++segments;
+        }
+    } catch (const std::exception& e) {
+        LogPrintf("Stopped reading peers_journal.dat after %d segments (%s)\n", segments, e.what());
+        return false;
+    }
+    LogPrint(BCLog::ADDRMAN, "Applied %d segments from peers_journal.dat\n", segments);
+    return true;
 }
 } // namespace
 
@@ -172,10 +235,32 @@ bool CBanDB::Read(banmap_t& banSet)
     return true;
 }
 
-bool DumpPeerAddresses(const ArgsManager& args, const AddrMan& addr)
+bool DumpPeerAddresses(const ArgsManager& args, AddrMan& addr)
 {
     const auto pathAddr = args.GetDataDirNet() / "peers.dat";
-    return SerializeFileDB("peers", pathAddr, addr, CLIENT_VERSION);
+    const auto path_journal{args.GetDataDirNet() / "peers_journal.dat"};
+    const bool use_journal{args.GetBoolArg("-peersjournal", DEFAULT_PEERS_JOURNAL)};
+
+    if (use_journal && fs::exists(path_journal) && fs::file_size(path_journal) < MAX_PEERS_JOURNAL_SIZE) {
+        CDataStream ss_changes(SER_DISK, CLIENT_VERSION);
+        if (const auto changes{addr.SerializeChanges(ss_changes)}) {
+            if (*changes == 0 || AppendPeersJournal(path_journal, ss_changes)) return true;
+            // The changes are gone from addrman now, so only a snapshot can save them.
+        }
+    }
+
+    // Serialize to memory first so addrman is not locked while writing to disk.
+    CDataStream ss_peers(SER_DISK, CLIENT_VERSION);
+    addr.SerializeSnapshot(ss_peers);
+    uint256 checksum;
+    if (!SerializeFileDB("peers", pathAddr, ss_peers, CLIENT_VERSION, &checksum)) {
+        return false;
+    }
+    if (!use_journal) {
+        fs::remove(path_journal);
+        return true;
+    }
+    return SerializeFileDB("peers_journal", path_journal, checksum, CLIENT_VERSION);
 }
 
 void ReadFromStream(AddrMan& addr, CDataStream& ssPeers)
@@ -190,9 +275,15 @@ std::optional<bilingual_str> LoadAddrman(const NetGroupManager& netgroupman, con
 
     const auto start{SteadyClock::now()};
     const auto path_addr{args.GetDataDirNet() / "peers.dat"};
+    const auto path_journal{args.GetDataDirNet() / "peers_journal.dat"};
     try {
-        DeserializeFileDB(path_addr, *addrman, CLIENT_VERSION);
+        const uint256 checksum{DeserializeFileDB(path_addr, *addrman, CLIENT_VERSION)};
+        // A journal left behind with -peersjournal off is still applied once, and then
+        // folded into peers.dat.
+        const bool rewrite{fs::exists(path_journal) &&
+                           (!ReadPeersJournal(path_journal, checksum, *addrman) || !args.GetBoolArg("-peersjournal", DEFAULT_PEERS_JOURNAL))};
         LogPrintf("Loaded %i addresses from peers.dat  %dms\n", addrman->Size(), Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
+        if (rewrite) DumpPeerAddresses(args, *addrman);
     } catch (const DbNotFoundError&) {
         // Addrman can be in an inconsistent state after failure, reset it
         addrman = std::make_unique<AddrMan>(netgroupman, /*deterministic=*/false, /*consistency_check_ratio=*/check_addrman);
@@ -20,7 +20,10 @@ class CDataStream;
 class NetGroupManager;
 struct bilingual_str;
 
-bool DumpPeerAddresses(const ArgsManager& args, const AddrMan& addr);
+/** Default for -peersjournal, append changed addrman entries to peers_journal.dat instead of rewriting peers.dat */
+static constexpr bool DEFAULT_PEERS_JOURNAL{false};
+
+bool DumpPeerAddresses(const ArgsManager& args, AddrMan& addr);
 /** Only used by tests. */
 void ReadFromStream(AddrMan& addr, CDataStream& ssPeers);
 
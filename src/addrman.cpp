@@ -9,6 +9,7 @@
 #include <hash.h>
 #include <logging.h>
 #include <logging/timer.h>
+#include <memusage.h>
 #include <netaddress.h>
 #include <protocol.h>
 #include <random.h>
@@ -42,6 +43,10 @@ static constexpr auto ADDRMAN_REPLACEMENT{4h};
 static constexpr size_t ADDRMAN_SET_TRIED_COLLISION_SIZE{10};
 /** The maximum time we'll spend trying to resolve a tried table collision */
 static constexpr auto ADDRMAN_TEST_WINDOW{40min};
+/** Record types of a journal segment, see AddrManImpl::SerializeChanges() */
+static constexpr uint8_t JOURNAL_REMOVED{0};
+static constexpr uint8_t JOURNAL_NEW{1};
+static constexpr uint8_t JOURNAL_TRIED{2};
 
 int AddrInfo::GetTriedBucket(const uint256& nKey, const NetGroupManager& netgroupman) const
 {
@@ -128,10 +133,8 @@ AddrManImpl::~AddrManImpl()
 }
 
 template <typename Stream>
-void AddrManImpl::Serialize(Stream& s_) const
+void AddrManImpl::Serialize_(Stream& s_) const
 {
-    LOCK(cs);
-
     /**
      * Serialized format.
      * * format version byte (@see `Format`)
@@ -226,10 +229,17 @@ void AddrManImpl::Serialize(Stream& s_) const
     s << m_netgroupman.GetAsmapChecksum();
 }
 
+template <typename Stream>
+void AddrManImpl::Serialize(Stream& s_) const
+{
+    ReadLock lock(cs);
+    Serialize_(s_);
+}
+
 template <typename Stream>
 void AddrManImpl::Unserialize(Stream& s_)
 {
-    LOCK(cs);
+    WriteLock lock(cs);
 
     assert(vRandom.empty());
 
@@ -394,6 +404,7 @@ void AddrManImpl::Unserialize(Stream& s_)
     if (nLost + nLostUnk > 0) {
         LogPrint(BCLog::ADDRMAN, "addrman lost %i new and %i tried addresses due to collisions or invalid addresses\n", nLostUnk, nLost);
     }
+    ResetChanges();
 
     const int check_code{CheckAddrman()};
     if (check_code != 0) {
@@ -403,10 +414,175 @@ void AddrManImpl::Unserialize(Stream& s_)
     }
 }
 
-AddrInfo* AddrManImpl::Find(const CService& addr, int* pnId)
+void AddrManImpl::SerializeSnapshot(CDataStream& s)
+{
+    WriteLock lock(cs);
+    Serialize_(s);
+    ResetChanges();
+}
+
+std::optional<size_t> AddrManImpl::SerializeChanges(CDataStream& s_)
 {
-    AssertLockHeld(cs);
+    WriteLock lock(cs);
+
+    if (m_changes_overflowed) return std::nullopt;
+
+    /**
+     * Journal segment format.
+     * * asmap checksum the new bucket numbers below were computed with
+     * * number of records
+     * * for each record, a JOURNAL_* type byte followed by
+     *   * JOURNAL_REMOVED: the address
+     *   * JOURNAL_NEW: the entry and the new buckets it is in
+     *   * JOURNAL_TRIED: the entry
+     *
+     * A record holds the resulting state of an entry rather than the operations that
+     * led to it, so replaying the segments in order restores the table they were
+     * taken from no matter how often an entry changed in between.
+     */
+    OverrideStream<CDataStream> s(&s_, s_.GetType(), s_.GetVersion() | ADDRV2_FORMAT);
+
+    // Collect the buckets of all changed new entries in one pass over the new table.
+    std::unordered_map<int, std::vector<int>> new_buckets;
+    for (const CService& addr : m_changed) {
+        int nId;
+        const AddrInfo* pinfo = Find(addr, &nId);
+        if (pinfo && !pinfo->fInTried) new_buckets.emplace(nId, std::vector<int>{});
+    }
+    if (!new_buckets.empty()) {
+        for (int bucket = 0; bucket < ADDRMAN_NEW_BUCKET_COUNT; ++bucket) {
+            for (int i = 0; i < ADDRMAN_BUCKET_SIZE; ++i) {
+                if (vvNew[bucket][i] == -1) continue;
+                const auto it{new_buckets.find(vvNew[bucket][i])};
+                if (it != new_buckets.end()) it->second.push_back(bucket);
+            }
+        }
+    }
+
+    s << m_netgroupman.GetAsmapChecksum();
+    WriteCompactSize(s, m_changed.size());
+    for (const CService& addr : m_changed) {
+        int nId;
+        const AddrInfo* pinfo = Find(addr, &nId);
+        if (!pinfo) {
+            s << JOURNAL_REMOVED << addr;
+        } else if (pinfo->fInTried) {
+            s << JOURNAL_TRIED << *pinfo;
+        } else {
+            s << JOURNAL_NEW << *pinfo << new_buckets[nId];
+        }
+    }
+
+    const size_t count{m_changed.size()};
+    m_changed.clear();
+    return count;
+}
+
+void AddrManImpl::UnserializeChanges(CDataStream& s_)
+{
+    WriteLock lock(cs);
+
+    OverrideStream<CDataStream> s(&s_, s_.GetType(), s_.GetVersion() | ADDRV2_FORMAT);
+
+    uint256 serialized_asmap_checksum;
+    s >> serialized_asmap_checksum;
+    const bool restore_bucketing{serialized_asmap_checksum == m_netgroupman.GetAsmapChecksum()};
+
+    const uint64_t count{ReadCompactSize(s)};
+    if (count > ADDRMAN_JOURNAL_MAX_CHANGES) {
+        throw std::ios_base::failure(strprintf("Corrupt AddrMan journal: %u records, should be at most %u",
+                                               count, ADDRMAN_JOURNAL_MAX_CHANGES));
+    }
+
+    // Read the whole segment before touching the table.
+    struct Record {
+        uint8_t type;
+        AddrInfo info;
+        std::vector<int> buckets;
+    };
+    std::vector<Record> records(count);
+    for (Record& record : records) {
+        s >> record.type;
+        if (record.type == JOURNAL_REMOVED) {
+            CService addr;
+            s >> addr;
+            record.info = AddrInfo{CAddress{addr, NODE_NONE}, CNetAddr{}};
+        } else if (record.type == JOURNAL_NEW) {
+            s >> record.info >> record.buckets;
+        } else if (record.type == JOURNAL_TRIED) {
+            s >> record.info;
+        } else {
+            throw std::ios_base::failure(strprintf("Corrupt AddrMan journal: unknown record type %u", record.type));
+        }
+    }
+
+    // Take out every entry a record is about, then put back the ones that still
+    // exist where the record says they are.
+    std::unordered_set<int> ids;
+    for (const Record& record : records) {
+        int nId;
+        if (Find(record.info, &nId)) ids.insert(nId);
+    }
+    RemoveEntries(ids);
+
+    int lost{0};
+    for (Record& record : records) {
+        if (record.type == JOURNAL_REMOVED || Find(record.info)) continue;
+        if (!record.info.IsValid()) {
+            ++lost;
+            continue;
+        }
+        if (record.type == JOURNAL_TRIED) {
+            const int bucket{record.info.GetTriedBucket(nKey, m_netgroupman)};
+            const int bucket_pos{record.info.GetBucketPosition(nKey, false, bucket)};
+            if (vvTried[bucket][bucket_pos] != -1) {
+                ++lost;
+                continue;
+            }
+            int nId;
+            AddrInfo& info = *Create(record.info, record.info.source, &nId);
+            info.m_last_success = record.info.m_last_success;
+            info.nAttempts = record.info.nAttempts;
+            info.fInTried = true;
+            vvTried[bucket][bucket_pos] = nId;
+            nNew--;
+            nTried++;
+            m_network_counts[info.GetNetwork()].n_new--;
+            m_network_counts[info.GetNetwork()].n_tried++;
+        } else {
+            if (!restore_bucketing) {
+                record.buckets = {record.info.GetNewBucket(nKey, m_netgroupman)};
+            }
+            int nId;
+            AddrInfo& info = *Create(record.info, record.info.source, &nId);
+            info.m_last_success = record.info.m_last_success;
+            info.nAttempts = record.info.nAttempts;
+            for (const int bucket : record.buckets) {
+                if (info.nRefCount >= ADDRMAN_NEW_BUCKETS_PER_ADDRESS) break;
+                if (bucket < 0 || bucket >= ADDRMAN_NEW_BUCKET_COUNT) continue;
+                const int bucket_pos{info.GetBucketPosition(nKey, true, bucket)};
+                if (vvNew[bucket][bucket_pos] == -1) {
+                    vvNew[bucket][bucket_pos] = nId;
+                    ++info.nRefCount;
+                }
+            }
+            if (info.nRefCount == 0) {
+                Delete(nId);
+                ++lost;
+            }
+        }
+    }
+    if (lost > 0) {
+        LogPrint(BCLog::ADDRMAN, "addrman lost %i addresses from the journal due to collisions or invalid addresses\n", lost);
+    }
+
+    // The table now matches what is on disk again.
+    ResetChanges();
+    Check();
+}
 
+AddrInfo* AddrManImpl::Find(const CService& addr, int* pnId)
+{
     const auto it = mapAddr.find(addr);
     if (it == mapAddr.end())
         return nullptr;
@@ -420,8 +596,6 @@ AddrInfo* AddrManImpl::Find(const CService& addr, int* pnId)
 
 AddrInfo* AddrManImpl::Create(const CAddress& addr, const CNetAddr& addrSource, int* pnId)
 {
-    AssertLockHeld(cs);
-
     int nId = nIdCount++;
     mapInfo[nId] = AddrInfo(addr, addrSource);
     mapAddr[addr] = nId;
@@ -429,6 +603,7 @@ AddrInfo* AddrManImpl::Create(const CAddress& addr, const CNetAddr& addrSource,
     vRandom.push_back(nId);
     nNew++;
     m_network_counts[addr.GetNetwork()].n_new++;
+    MarkChanged(addr);
     if (pnId)
         *pnId = nId;
     return &mapInfo[nId];
@@ -436,8 +611,6 @@ AddrInfo* AddrManImpl::Create(const CAddress& addr, const CNetAddr& addrSource,
 
 void AddrManImpl::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2) const
 {
-    AssertLockHeld(cs);
-
     if (nRndPos1 == nRndPos2)
         return;
 
@@ -460,8 +633,6 @@ void AddrManImpl::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2) const
 
 void AddrManImpl::Delete(int nId)
 {
-    AssertLockHeld(cs);
-
     assert(mapInfo.count(nId) != 0);
     AddrInfo& info = mapInfo[nId];
     assert(!info.fInTried);
@@ -470,15 +641,47 @@ void AddrManImpl::Delete(int nId)
     SwapRandom(info.nRandomPos, vRandom.size() - 1);
     m_network_counts[info.GetNetwork()].n_new--;
     vRandom.pop_back();
+    MarkChanged(info);
     mapAddr.erase(info);
     mapInfo.erase(nId);
     nNew--;
 }
 
-void AddrManImpl::ClearNew(int nUBucket, int nUBucketPos)
+void AddrManImpl::RemoveEntries(const std::unordered_set<int>& ids)
 {
-    AssertLockHeld(cs);
+    if (ids.empty()) return;
+
+    for (int bucket = 0; bucket < ADDRMAN_NEW_BUCKET_COUNT; ++bucket) {
+        for (int i = 0; i < ADDRMAN_BUCKET_SIZE; ++i) {
+            const int nId{vvNew[bucket][i]};
+            if (nId != -1 && ids.count(nId)) {
+                vvNew[bucket][i] = -1;
+                mapInfo[nId].nRefCount--;
+            }
+        }
+    }
+    for (const int nId : ids) {
+        assert(mapInfo.count(nId) != 0);
+        AddrInfo& info = mapInfo[nId];
+        if (info.fInTried) {
+            const int bucket{info.GetTriedBucket(nKey, m_netgroupman)};
+            const int bucket_pos{info.GetBucketPosition(nKey, false, bucket)};
+            assert(vvTried[bucket][bucket_pos] == nId);
+            vvTried[bucket][bucket_pos] = -1;
+            info.fInTried = false;
+            nTried--;
+            m_network_counts[info.GetNetwork()].n_tried--;
+            // Delete() takes entries from the new table.
+            nNew++;
+            m_network_counts[info.GetNetwork()].n_new++;
+        }
+        m_tried_collisions.erase(nId);
+        Delete(nId);
+    }
+}
 
+void AddrManImpl::ClearNew(int nUBucket, int nUBucketPos)
+{
     // if there is an entry in the specified bucket, delete it.
     if (vvNew[nUBucket][nUBucketPos] != -1) {
         int nIdDelete = vvNew[nUBucket][nUBucketPos];
@@ -486,6 +689,7 @@ void AddrManImpl::ClearNew(int nUBucket, int nUBucketPos)
         assert(infoDelete.nRefCount > 0);
         infoDelete.nRefCount--;
         vvNew[nUBucket][nUBucketPos] = -1;
+        MarkChanged(infoDelete);
         LogPrint(BCLog::ADDRMAN, "Removed %s from new[%i][%i]\n", infoDelete.ToStringAddrPort(), nUBucket, nUBucketPos);
         if (infoDelete.nRefCount == 0) {
             Delete(nIdDelete);
@@ -495,7 +699,7 @@ void AddrManImpl::ClearNew(int nUBucket, int nUBucketPos)
 
 void AddrManImpl::MakeTried(AddrInfo& info, int nId)
 {
-    AssertLockHeld(cs);
+    MarkChanged(info);
 
     // remove the entry from all new buckets
     const int start_bucket{info.GetNewBucket(nKey, m_netgroupman)};
@@ -525,6 +729,7 @@ void AddrManImpl::MakeTried(AddrInfo& info, int nId)
         AddrInfo& infoOld = mapInfo[nIdEvict];
 
         // Remove the to-be-evicted item from the tried set.
+        MarkChanged(infoOld);
         infoOld.fInTried = false;
         vvTried[nKBucket][nKBucketPos] = -1;
         nTried--;
@@ -554,8 +759,6 @@ void AddrManImpl::MakeTried(AddrInfo& info, int nId)
 
 bool AddrManImpl::AddSingle(const CAddress& addr, const CNetAddr& source, std::chrono::seconds time_penalty)
 {
-    AssertLockHeld(cs);
-
     if (!addr.IsRoutable())
         return false;
 
@@ -573,10 +776,14 @@ bool AddrManImpl::AddSingle(const CAddress& addr, const CNetAddr& source, std::c
         const auto update_interval{currently_online ? 1h : 24h};
         if (pinfo->nTime < addr.nTime - update_interval - time_penalty) {
             pinfo->nTime = std::max(NodeSeconds{0s}, addr.nTime - time_penalty);
+            MarkChanged(*pinfo);
         }
 
         // add services
-        pinfo->nServices = ServiceFlags(pinfo->nServices | addr.nServices);
+        if ((pinfo->nServices | addr.nServices) != pinfo->nServices) {
+            pinfo->nServices = ServiceFlags(pinfo->nServices | addr.nServices);
+            MarkChanged(*pinfo);
+        }
 
         // do not update if no new information is present
         if (addr.nTime <= pinfo->nTime) {
@@ -595,7 +802,7 @@ bool AddrManImpl::AddSingle(const CAddress& addr, const CNetAddr& source, std::c
         int nFactor = 1;
         for (int n = 0; n < pinfo->nRefCount; n++)
             nFactor *= 2;
-        if (nFactor > 1 && (insecure_rand.randrange(nFactor) != 0))
+        if (nFactor > 1 && (WITH_LOCK(m_rand_mutex, return insecure_rand.randrange(nFactor)) != 0))
             return false;
     } else {
         pinfo = Create(addr, source, &nId);
@@ -617,6 +824,7 @@ bool AddrManImpl::AddSingle(const CAddress& addr, const CNetAddr& source, std::c
             ClearNew(nUBucket, nUBucketPos);
             pinfo->nRefCount++;
             vvNew[nUBucket][nUBucketPos] = nId;
+            MarkChanged(*pinfo);
             LogPrint(BCLog::ADDRMAN, "Added %s mapped to AS%i to new[%i][%i]\n",
                      addr.ToStringAddrPort(), m_netgroupman.GetMappedAS(addr), nUBucket, nUBucketPos);
         } else {
@@ -630,8 +838,6 @@ bool AddrManImpl::AddSingle(const CAddress& addr, const CNetAddr& source, std::c
 
 bool AddrManImpl::Good_(const CService& addr, bool test_before_evict, NodeSeconds time)
 {
-    AssertLockHeld(cs);
-
     int nId;
 
     m_last_good = time;
@@ -647,6 +853,7 @@ bool AddrManImpl::Good_(const CService& addr, bool test_before_evict, NodeSecond
     info.m_last_success = time;
     info.m_last_try = time;
     info.nAttempts = 0;
+    MarkChanged(info);
     // nTime is not updated here, to avoid leaking information about
     // currently-connected peers.
 
@@ -696,8 +903,6 @@ bool AddrManImpl::Add_(const std::vector<CAddress>& vAddr, const CNetAddr& sourc
 
 void AddrManImpl::Attempt_(const CService& addr, bool fCountFailure, NodeSeconds time)
 {
-    AssertLockHeld(cs);
-
     AddrInfo* pinfo = Find(addr);
 
     // if not found, bail out
@@ -711,26 +916,29 @@ void AddrManImpl::Attempt_(const CService& addr, bool fCountFailure, NodeSeconds
     if (fCountFailure && info.m_last_count_attempt < m_last_good) {
         info.m_last_count_attempt = time;
         info.nAttempts++;
+        MarkChanged(info);
     }
 }
 
 std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool newOnly) const
 {
-    AssertLockHeld(cs);
-
     if (vRandom.empty()) return {};
 
     if (newOnly && nNew == 0) return {};
 
+    // Concurrent selections only share the tables, each draws from its own
+    // generator seeded from insecure_rand.
+    FastRandomContext rng{WITH_LOCK(m_rand_mutex, return insecure_rand.rand256())};
+
     // Use a 50% chance for choosing between tried and new table entries.
     if (!newOnly &&
-       (nTried > 0 && (nNew == 0 || insecure_rand.randbool() == 0))) {
+       (nTried > 0 && (nNew == 0 || rng.randbool() == 0))) {
         // use a tried node
         double fChanceFactor = 1.0;
         while (1) {
             // Pick a tried bucket, and an initial position in that bucket.
-            int nKBucket = insecure_rand.randrange(ADDRMAN_TRIED_BUCKET_COUNT);
-            int nKBucketPos = insecure_rand.randrange(ADDRMAN_BUCKET_SIZE);
+            int nKBucket = rng.randrange(ADDRMAN_TRIED_BUCKET_COUNT);
+            int nKBucketPos = rng.randrange(ADDRMAN_BUCKET_SIZE);
             // Iterate over the positions of that bucket, starting at the initial one,
             // and looping around.
             int i;
@@ -745,7 +953,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool newOnly) const
             assert(it_found != mapInfo.end());
             const AddrInfo& info{it_found->second};
             // With probability GetChance() * fChanceFactor, return the entry.
-            if (insecure_rand.randbits(30) < fChanceFactor * info.GetChance() * (1 << 30)) {
+            if (rng.randbits(30) < fChanceFactor * info.GetChance() * (1 << 30)) {
                 LogPrint(BCLog::ADDRMAN, "Selected %s from tried\n", info.ToStringAddrPort());
                 return {info, info.m_last_try};
             }
@@ -757,8 +965,8 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool newOnly) const
         double fChanceFactor = 1.0;
         while (1) {
             // Pick a new bucket, and an initial position in that bucket.
-            int nUBucket = insecure_rand.randrange(ADDRMAN_NEW_BUCKET_COUNT);
-            int nUBucketPos = insecure_rand.randrange(ADDRMAN_BUCKET_SIZE);
+            int nUBucket = rng.randrange(ADDRMAN_NEW_BUCKET_COUNT);
+            int nUBucketPos = rng.randrange(ADDRMAN_BUCKET_SIZE);
             // Iterate over the positions of that bucket, starting at the initial one,
             // and looping around.
             int i;
@@ -773,7 +981,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool newOnly) const
             assert(it_found != mapInfo.end());
             const AddrInfo& info{it_found->second};
             // With probability GetChance() * fChanceFactor, return the entry.
-            if (insecure_rand.randbits(30) < fChanceFactor * info.GetChance() * (1 << 30)) {
+            if (rng.randbits(30) < fChanceFactor * info.GetChance() * (1 << 30)) {
                 LogPrint(BCLog::ADDRMAN, "Selected %s from new\n", info.ToStringAddrPort());
                 return {info, info.m_last_try};
             }
@@ -785,8 +993,6 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool newOnly) const
 
 std::vector<CAddress> AddrManImpl::GetAddr_(size_t max_addresses, size_t max_pct, std::optional<Network> network) const
 {
-    AssertLockHeld(cs);
-
     size_t nNodes = vRandom.size();
     if (max_pct != 0) {
         nNodes = max_pct * nNodes / 100;
@@ -796,6 +1002,7 @@ std::vector<CAddress> AddrManImpl::GetAddr_(size_t max_addresses, size_t max_pct
     }
 
     // gather a list of random nodes, skipping those of low quality
+    LOCK(m_rand_mutex);
     const auto now{Now<NodeSeconds>()};
     std::vector<CAddress> addresses;
     for (unsigned int n = 0; n < vRandom.size(); n++) {
@@ -823,8 +1030,6 @@ std::vector<CAddress> AddrManImpl::GetAddr_(size_t max_addresses, size_t max_pct
 
 void AddrManImpl::Connected_(const CService& addr, NodeSeconds time)
 {
-    AssertLockHeld(cs);
-
     AddrInfo* pinfo = Find(addr);
 
     // if not found, bail out
@@ -837,13 +1042,12 @@ void AddrManImpl::Connected_(const CService& addr, NodeSeconds time)
     const auto update_interval{20min};
     if (time - info.nTime > update_interval) {
         info.nTime = time;
+        MarkChanged(info);
     }
 }
 
 void AddrManImpl::SetServices_(const CService& addr, ServiceFlags nServices)
 {
-    AssertLockHeld(cs);
-
     AddrInfo* pinfo = Find(addr);
 
     // if not found, bail out
@@ -853,13 +1057,14 @@ void AddrManImpl::SetServices_(const CService& addr, ServiceFlags nServices)
     AddrInfo& info = *pinfo;
 
     // update info
-    info.nServices = nServices;
+    if (info.nServices != nServices) {
+        info.nServices = nServices;
+        MarkChanged(info);
+    }
 }
 
 void AddrManImpl::ResolveCollisions_()
 {
-    AssertLockHeld(cs);
-
     for (std::set<int>::iterator it = m_tried_collisions.begin(); it != m_tried_collisions.end();) {
         int id_new = *it;
 
@@ -921,14 +1126,12 @@ void AddrManImpl::ResolveCollisions_()
 
 std::pair<CAddress, NodeSeconds> AddrManImpl::SelectTriedCollision_()
 {
-    AssertLockHeld(cs);
-
     if (m_tried_collisions.size() == 0) return {};
 
     std::set<int>::iterator it = m_tried_collisions.begin();
 
     // Selects a random element from m_tried_collisions
-    std::advance(it, insecure_rand.randrange(m_tried_collisions.size()));
+    std::advance(it, WITH_LOCK(m_rand_mutex, return insecure_rand.randrange(m_tried_collisions.size())));
     int id_new = *it;
 
     // If id_new not found in mapInfo remove it from m_tried_collisions
@@ -949,8 +1152,6 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::SelectTriedCollision_()
 
 std::optional<AddressPosition> AddrManImpl::FindAddressEntry_(const CAddress& addr)
 {
-    AssertLockHeld(cs);
-
     AddrInfo* addr_info = Find(addr);
 
     if (!addr_info) return std::nullopt;
@@ -972,8 +1173,6 @@ std::optional<AddressPosition> AddrManImpl::FindAddressEntry_(const CAddress& ad
 
 size_t AddrManImpl::Size_(std::optional<Network> net, std::optional<bool> in_new) const
 {
-    AssertLockHeld(cs);
-
     if (!net.has_value()) {
         if (in_new.has_value()) {
             return *in_new ? nNew : nTried;
@@ -992,13 +1191,27 @@ size_t AddrManImpl::Size_(std::optional<Network> net, std::optional<bool> in_new
     return 0;
 }
 
-void AddrManImpl::Check() const
+void AddrManImpl::MarkChanged(const CService& addr)
+{
+    if (m_changes_overflowed) return;
+    m_changed.insert(addr);
+    if (m_changed.size() > ADDRMAN_JOURNAL_MAX_CHANGES) {
+        m_changes_overflowed = true;
+        m_changed.clear();
+    }
+}
+
+void AddrManImpl::ResetChanges()
 {
-    AssertLockHeld(cs);
+    m_changed.clear();
+    m_changes_overflowed = false;
+}
 
+void AddrManImpl::Check() const
+{
     // Run consistency checks 1 in m_consistency_check_ratio times if enabled
     if (m_consistency_check_ratio == 0) return;
-    if (insecure_rand.randrange(m_consistency_check_ratio) >= 1) return;
+    if (WITH_LOCK(m_rand_mutex, return insecure_rand.randrange(m_consistency_check_ratio)) >= 1) return;
 
     const int err{CheckAddrman()};
     if (err) {
@@ -1009,8 +1222,6 @@ void AddrManImpl::Check() const
 
 int AddrManImpl::CheckAddrman() const
 {
-    AssertLockHeld(cs);
-
     LOG_TIME_MILLIS_WITH_CATEGORY_MSG_ONCE(
         strprintf("new %i, tried %i, total %u", nNew, nTried, vRandom.size()), BCLog::ADDRMAN);
 
@@ -1114,16 +1325,23 @@ int AddrManImpl::CheckAddrman() const
 
 size_t AddrManImpl::Size(std::optional<Network> net, std::optional<bool> in_new) const
 {
-    LOCK(cs);
+    ReadLock lock(cs);
     Check();
     auto ret = Size_(net, in_new);
     Check();
     return ret;
 }
 
+size_t AddrManImpl::DynamicMemoryUsage() const
+{
+    ReadLock lock(cs);
+    return memusage::DynamicUsage(mapInfo) + memusage::DynamicUsage(mapAddr) + memusage::DynamicUsage(vRandom) +
+           memusage::DynamicUsage(m_tried_collisions) + memusage::DynamicUsage(m_network_counts) + memusage::DynamicUsage(m_changed);
+}
+
 bool AddrManImpl::Add(const std::vector<CAddress>& vAddr, const CNetAddr& source, std::chrono::seconds time_penalty)
 {
-    LOCK(cs);
+    WriteLock lock(cs);
     Check();
     auto ret = Add_(vAddr, source, time_penalty);
     Check();
@@ -1132,7 +1350,7 @@ bool AddrManImpl::Add(const std::vector<CAddress>& vAddr, const CNetAddr& source
 
 bool AddrManImpl::Good(const CService& addr, NodeSeconds time)
 {
-    LOCK(cs);
+    WriteLock lock(cs);
     Check();
     auto ret = Good_(addr, /*test_before_evict=*/true, time);
     Check();
@@ -1141,7 +1359,7 @@ bool AddrManImpl::Good(const CService& addr, NodeSeconds time)
 
 void AddrManImpl::Attempt(const CService& addr, bool fCountFailure, NodeSeconds time)
 {
-    LOCK(cs);
+    WriteLock lock(cs);
     Check();
     Attempt_(addr, fCountFailure, time);
     Check();
@@ -1149,7 +1367,7 @@ void AddrManImpl::Attempt(const CService& addr, bool fCountFailure, NodeSeconds
 
 void AddrManImpl::ResolveCollisions()
 {
-    LOCK(cs);
+    WriteLock lock(cs);
     Check();
     ResolveCollisions_();
     Check();
@@ -1157,7 +1375,7 @@ void AddrManImpl::ResolveCollisions()
 
 std::pair<CAddress, NodeSeconds> AddrManImpl::SelectTriedCollision()
 {
-    LOCK(cs);
+    WriteLock lock(cs);
     Check();
     auto ret = SelectTriedCollision_();
     Check();
@@ -1166,7 +1384,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::SelectTriedCollision()
 
 std::pair<CAddress, NodeSeconds> AddrManImpl::Select(bool newOnly) const
 {
-    LOCK(cs);
+    ReadLock lock(cs);
     Check();
     auto addrRet = Select_(newOnly);
     Check();
@@ -1175,7 +1393,7 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select(bool newOnly) const
 
 std::vector<CAddress> AddrManImpl::GetAddr(size_t max_addresses, size_t max_pct, std::optional<Network> network) const
 {
-    LOCK(cs);
+    WriteLock lock(cs);
     Check();
     auto addresses = GetAddr_(max_addresses, max_pct, network);
     Check();
@@ -1184,7 +1402,7 @@ std::vector<CAddress> AddrManImpl::GetAddr(size_t max_addresses, size_t max_pct,
 
 void AddrManImpl::Connected(const CService& addr, NodeSeconds time)
 {
-    LOCK(cs);
+    WriteLock lock(cs);
     Check();
     Connected_(addr, time);
     Check();
@@ -1192,7 +1410,7 @@ void AddrManImpl::Connected(const CService& addr, NodeSeconds time)
 
 void AddrManImpl::SetServices(const CService& addr, ServiceFlags nServices)
 {
-    LOCK(cs);
+    WriteLock lock(cs);
     Check();
     SetServices_(addr, nServices);
     Check();
@@ -1200,7 +1418,7 @@ void AddrManImpl::SetServices(const CService& addr, ServiceFlags nServices)
 
 std::optional<AddressPosition> AddrManImpl::FindAddressEntry(const CAddress& addr)
 {
-    LOCK(cs);
+    WriteLock lock(cs);
     Check();
     auto entry = FindAddressEntry_(addr);
     Check();
@@ -1224,6 +1442,21 @@ void AddrMan::Unserialize(Stream& s_)
     m_impl->Unserialize<Stream>(s_);
 }
 
+void AddrMan::SerializeSnapshot(CDataStream& s)
+{
+    m_impl->SerializeSnapshot(s);
+}
+
+std::optional<size_t> AddrMan::SerializeChanges(CDataStream& s)
+{
+    return m_impl->SerializeChanges(s);
+}
+
+void AddrMan::UnserializeChanges(CDataStream& s)
+{
+    m_impl->UnserializeChanges(s);
+}
+
 // explicit instantiation
 template void AddrMan::Serialize(HashedSourceWriter<CAutoFile>& s) const;
 template void AddrMan::Serialize(CDataStream& s) const;
@@ -1237,6 +1470,11 @@ size_t AddrMan::Size(std::optional<Network> net, std::optional<bool> in_new) con
     return m_impl->Size(net, in_new);
 }
 
+size_t AddrMan::DynamicMemoryUsage() const
+{
+    return memusage::DynamicUsage(m_impl) + m_impl->DynamicMemoryUsage();
+}
+
 bool AddrMan::Add(const std::vector<CAddress>& vAddr, const CNetAddr& source, std::chrono::seconds time_penalty)
 {
     return m_impl->Add(vAddr, source, time_penalty);
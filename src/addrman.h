@@ -99,6 +99,25 @@ public:
     template <typename Stream>
     void Unserialize(Stream& s_);
 
+    /**
+     * Serialize the whole table like Serialize(), and start recording the changes
+     * returned by SerializeChanges() afresh from this state.
+     */
+    void SerializeSnapshot(CDataStream& s);
+
+    /**
+     * Serialize the entries that changed since the table was loaded or last written
+     * with SerializeSnapshot() or SerializeChanges(), as a segment of the journal
+     * kept next to peers.dat.
+     *
+     * @return The number of changed entries written, or std::nullopt if too many
+     *         entries changed to keep track of and a snapshot must be written instead.
+     */
+    std::optional<size_t> SerializeChanges(CDataStream& s);
+
+    /** Apply a journal segment written by SerializeChanges() on top of the loaded table. */
+    void UnserializeChanges(CDataStream& s);
+
     /**
     * Return size information about addrman.
     *
@@ -108,6 +127,9 @@ public:
     */
     size_t Size(std::optional<Network> net = std::nullopt, std::optional<bool> in_new = std::nullopt) const;
 
+    //! Memory held by addrman, including its tables of buckets.
+    size_t DynamicMemoryUsage() const;
+
     /**
      * Attempt to add one or more addresses to addrman's new table.
      *
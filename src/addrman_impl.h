@@ -10,7 +10,9 @@
 #include <netaddress.h>
 #include <protocol.h>
 #include <serialize.h>
+#include <streams.h>
 #include <sync.h>
+#include <threadsafety.h>
 #include <timedata.h>
 #include <uint256.h>
 #include <util/time.h>
@@ -32,6 +34,8 @@ static constexpr int ADDRMAN_NEW_BUCKET_COUNT{1 << ADDRMAN_NEW_BUCKET_COUNT_LOG2
 /** Maximum allowed number of entries in buckets for new and tried addresses */
 static constexpr int32_t ADDRMAN_BUCKET_SIZE_LOG2{6};
 static constexpr int ADDRMAN_BUCKET_SIZE{1 << ADDRMAN_BUCKET_SIZE_LOG2};
+/** Number of changed entries past which a journal segment stops being cheaper than a full snapshot */
+static constexpr size_t ADDRMAN_JOURNAL_MAX_CHANGES{16384};
 
 /**
  * Extended statistics about a CAddress
@@ -112,8 +116,16 @@ public:
     template <typename Stream>
     void Unserialize(Stream& s_) EXCLUSIVE_LOCKS_REQUIRED(!cs);
 
+    void SerializeSnapshot(CDataStream& s) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    std::optional<size_t> SerializeChanges(CDataStream& s) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
+    void UnserializeChanges(CDataStream& s) EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
     size_t Size(std::optional<Network> net, std::optional<bool> in_new) const EXCLUSIVE_LOCKS_REQUIRED(!cs);
 
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(!cs);
+
     bool Add(const std::vector<CAddress>& vAddr, const CNetAddr& source, std::chrono::seconds time_penalty)
         EXCLUSIVE_LOCKS_REQUIRED(!cs);
 
@@ -145,11 +157,16 @@ public:
     friend class AddrManDeterministic;
 
 private:
-    //! A mutex to protect the inner data structures.
-    mutable Mutex cs;
+    //! A mutex to protect the inner data structures. Select() and Size() only
+    //! read them and take it shared, so they don't serialize against each other.
+    mutable SharedMutex cs;
+
+    //! Protects insecure_rand, which is also drawn from while cs is held shared.
+    //! Always taken after cs.
+    mutable Mutex m_rand_mutex;
 
     //! Source of random numbers for randomization in inner loops
-    mutable FastRandomContext insecure_rand GUARDED_BY(cs);
+    mutable FastRandomContext insecure_rand GUARDED_BY(m_rand_mutex);
 
     //! secret key to randomize bucket select with
     uint256 nKey;
@@ -223,6 +240,23 @@ private:
     /** Number of entries in addrman per network and new/tried table. */
     std::unordered_map<Network, NewTriedCount> m_network_counts GUARDED_BY(cs);
 
+    //! Addresses whose entry was created, modified, moved or deleted since the
+    //! table was loaded or last written with SerializeSnapshot()/SerializeChanges().
+    std::unordered_set<CService, CServiceHash> m_changed GUARDED_BY(cs);
+
+    //! Set when more than ADDRMAN_JOURNAL_MAX_CHANGES entries changed, after which
+    //! changes are no longer tracked until the next snapshot.
+    bool m_changes_overflowed GUARDED_BY(cs){false};
+
+    //! Record addr as changed for the next journal segment.
+    void MarkChanged(const CService& addr) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    //! Forget the recorded changes, after the table was written or read in full.
+    void ResetChanges() EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    template <typename Stream>
+    void Serialize_(Stream& s_) const SHARED_LOCKS_REQUIRED(cs);
+
     //! Find an entry.
     AddrInfo* Find(const CService& addr, int* pnId = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -232,6 +266,9 @@ private:
     //! Swap two elements in vRandom.
     void SwapRandom(unsigned int nRandomPos1, unsigned int nRandomPos2) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    //! Remove a set of entries from wherever they are in the new and tried tables, and delete them.
+    void RemoveEntries(const std::unordered_set<int>& ids) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     //! Delete an entry. It must not be in tried, and have refcount 0.
     void Delete(int nId) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -251,7 +288,7 @@ private:
 
     void Attempt_(const CService& addr, bool fCountFailure, NodeSeconds time) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
-    std::pair<CAddress, NodeSeconds> Select_(bool newOnly) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    std::pair<CAddress, NodeSeconds> Select_(bool newOnly) const SHARED_LOCKS_REQUIRED(cs);
 
     std::vector<CAddress> GetAddr_(size_t max_addresses, size_t max_pct, std::optional<Network> network) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -265,15 +302,15 @@ private:
 
     std::optional<AddressPosition> FindAddressEntry_(const CAddress& addr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
-    size_t Size_(std::optional<Network> net, std::optional<bool> in_new) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    size_t Size_(std::optional<Network> net, std::optional<bool> in_new) const SHARED_LOCKS_REQUIRED(cs);
 
     //! Consistency check, taking into account m_consistency_check_ratio.
     //! Will std::abort if an inconsistency is detected.
-    void Check() const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void Check() const SHARED_LOCKS_REQUIRED(cs);
 
     //! Perform consistency check, regardless of m_consistency_check_ratio.
     //! @returns an error code or zero.
-    int CheckAddrman() const EXCLUSIVE_LOCKS_REQUIRED(cs);
+    int CheckAddrman() const SHARED_LOCKS_REQUIRED(cs);
 };
 
 #endif // BITCOIN_ADDRMAN_IMPL_H
@@ -9,13 +9,17 @@
 #include <util/check.h>
 #include <util/time.h>
 
+#include <atomic>
 #include <optional>
+#include <thread>
 #include <vector>
 
 /* A "source" is a source address from which we have received a bunch of other addresses. */
 
 static constexpr size_t NUM_SOURCES = 64;
 static constexpr size_t NUM_ADDRESSES_PER_SOURCE = 256;
+/* Threads calling Select() next to the benchmarked one. */
+static constexpr size_t NUM_CONCURRENT_READERS = 3;
 
 static NetGroupManager EMPTY_NETGROUPMAN{std::vector<bool>()};
 static constexpr uint32_t ADDRMAN_CONSISTENCY_CHECK_RATIO{0};
@@ -95,6 +99,55 @@ static void AddrManSelect(benchmark::Bench& bench)
     });
 }
 
+/* Run fn while NUM_CONCURRENT_READERS threads keep selecting addresses from addrman. */
+template <typename Fn>
+static void WithConcurrentReaders(const AddrMan& addrman, Fn&& fn)
+{
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < NUM_CONCURRENT_READERS; ++i) {
+        readers.emplace_back([&] {
+            while (!stop) {
+                (void)addrman.Select();
+            }
+        });
+    }
+    fn();
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+}
+
+static void AddrManSelectConcurrentReaders(benchmark::Bench& bench)
+{
+    AddrMan addrman{EMPTY_NETGROUPMAN, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
+
+    FillAddrMan(addrman);
+
+    WithConcurrentReaders(addrman, [&] {
+        bench.run([&] {
+            const auto& address = addrman.Select();
+            assert(address.first.GetPort() > 0);
+        });
+    });
+}
+
+static void AddrManAttemptConcurrentReaders(benchmark::Bench& bench)
+{
+    AddrMan addrman{EMPTY_NETGROUPMAN, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
+
+    FillAddrMan(addrman);
+
+    size_t addr_i{0};
+    WithConcurrentReaders(addrman, [&] {
+        bench.run([&] {
+            addrman.Attempt(g_addresses[addr_i % NUM_SOURCES][addr_i / NUM_SOURCES % NUM_ADDRESSES_PER_SOURCE], /*fCountFailure=*/false);
+            ++addr_i;
+        });
+    });
+}
+
 static void AddrManGetAddr(benchmark::Bench& bench)
 {
     AddrMan addrman{EMPTY_NETGROUPMAN, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
@@ -135,5 +188,7 @@ static void AddrManAddThenGood(benchmark::Bench& bench)
 
 BENCHMARK(AddrManAdd, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManSelect, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AddrManSelectConcurrentReaders, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AddrManAttemptConcurrentReaders, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManGetAddr, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManAddThenGood, benchmark::PriorityLevel::HIGH);
@@ -5,7 +5,10 @@
 #include <bench/bench.h>
 
 #include <clientversion.h>
+#include <crypto/chacha20.h>
+#include <crypto/scrypt.h>
 #include <crypto/sha256.h>
+#include <crypto/siphash.h>
 #include <util/fs.h>
 #include <util/strencodings.h>
 #include <util/system.h>
@@ -62,6 +65,9 @@ int main(int argc, char** argv)
     ArgsManager argsman;
     SetupBenchArgs(argsman);
     SHA256AutoDetect();
+    ChaCha20AutoDetect();
+    ScryptAutoDetect();
+    SipHashAutoDetect();
     std::string error;
     if (!argsman.ParseParameters(argc, argv, error)) {
         tfm::format(std::cerr, "Error parsing command line arguments: %s\n", error);
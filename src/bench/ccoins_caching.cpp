@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 #include <coins.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <script/signingprovider.h>
 #include <test/util/transaction_utils.h>
 
@@ -50,4 +51,39 @@ static void CCoinsCaching(benchmark::Bench& bench)
     ECC_Stop();
 }
 
+namespace {
+/** Parent view that drops what is written to it, standing in for the coins database */
+class CCoinsViewSink : public CCoinsView
+{
+public:
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase) override
+    {
+        if (erase) mapCoins.clear();
+        return true;
+    }
+};
+} // namespace
+
+// Fill a cache with the outputs of a block's worth of transactions and flush
+// it, as connecting blocks does, so the nodes of the coins map are allocated
+// and freed over and over.
+static void CCoinsCachingFlush(benchmark::Bench& bench)
+{
+    CCoinsViewSink sink;
+    CCoinsViewCache coins(&sink, /*deterministic=*/true);
+    FastRandomContext rng{/*fDeterministic=*/true};
+
+    bench.run([&] {
+        for (uint32_t i = 0; i < 2000; ++i) {
+            Coin coin;
+            coin.out.nValue = COIN;
+            coin.out.scriptPubKey << OP_1;
+            coins.AddCoin(COutPoint{rng.rand256(), i}, std::move(coin), /*possible_overwrite=*/false);
+        }
+        bool success{coins.Flush()};
+        assert(success);
+    });
+}
+
 BENCHMARK(CCoinsCaching, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCoinsCachingFlush, benchmark::PriorityLevel::HIGH);
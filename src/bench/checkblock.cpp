@@ -6,9 +6,18 @@
 #include <bench/data.h>
 
 #include <chainparams.h>
+#include <checkqueue.h>
+#include <coins.h>
+#include <consensus/merkle.h>
 #include <consensus/validation.h>
+#include <pos/pos.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
 #include <streams.h>
+#include <test/util/setup_common.h>
+#include <util/check.h>
 #include <util/system.h>
+#include <util/translation.h>
 #include <validation.h>
 
 // These are the two major time-sinks which happen after we have fully received
@@ -50,5 +59,154 @@ static void DeserializeAndCheckBlockTest(benchmark::Bench& bench)
     });
 }
 
+//! Coinstake spending the first coinbase of the test chain back to itself
+static CTransactionRef CreateBenchCoinStake(TestChain100Setup& setup)
+{
+    const CTransactionRef& prev = setup.m_coinbase_txns.at(0);
+    CMutableTransaction tx;
+    tx.vin.emplace_back(COutPoint(prev->GetHash(), 0));
+    tx.vout.emplace_back(0, CScript());
+    tx.vout.emplace_back(prev->vout[0].nValue, prev->vout[0].scriptPubKey);
+
+    FillableSigningProvider keystore;
+    keystore.AddKey(setup.coinbaseKey);
+    std::map<COutPoint, Coin> coins;
+    {
+        LOCK(cs_main);
+        Coin coin;
+        Assert(setup.m_node.chainman->ActiveChainstate().CoinsTip().GetCoin(tx.vin[0].prevout, coin));
+        coins.emplace(tx.vin[0].prevout, coin);
+    }
+    std::map<int, bilingual_str> input_errors;
+    Assert(SignTransaction(tx, &keystore, coins, SIGHASH_ALL, input_errors));
+    return MakeTransactionRef(tx);
+}
+
+//! Easy enough for a kernel to be found in a few hundred timestamps, without overflowing once weighted
+static constexpr uint32_t BENCH_STAKE_BITS{0x1c00ffff};
+
+static void CheckProofOfStakeTest(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    Chainstate& chainstate{testing_setup->m_node.chainman->ActiveChainstate()};
+    const CTransactionRef coinstake{CreateBenchCoinStake(*testing_setup)};
+
+    // A timestamp never checked before, so the stake is never in the kernel cache
+    LOCK(cs_main);
+    const CBlockIndex* tip{chainstate.m_chain.Tip()};
+    int64_t time{tip->GetBlockTime()};
+    bench.unit("coinstake").run([&] {
+        time += nStakeTimestampMask + 1;
+        BlockValidationState state;
+        uint256 hash_proof, target_proof;
+        CheckProofOfStake(chainstate, state, tip, *coinstake, time, BENCH_STAKE_BITS, hash_proof, target_proof);
+    });
+}
+
+static void CheckProofOfStakeCachedTest(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    Chainstate& chainstate{testing_setup->m_node.chainman->ActiveChainstate()};
+    const CTransactionRef coinstake{CreateBenchCoinStake(*testing_setup)};
+
+    // Find a timestamp with a kernel, which also puts the stake in the kernel cache
+    LOCK(cs_main);
+    const CBlockIndex* tip{chainstate.m_chain.Tip()};
+    int64_t time{tip->GetBlockTime()};
+    uint256 hash_proof, target_proof;
+    do {
+        time += nStakeTimestampMask + 1;
+        BlockValidationState state;
+        if (CheckProofOfStake(chainstate, state, tip, *coinstake, time, BENCH_STAKE_BITS, hash_proof, target_proof)) break;
+    } while (true);
+
+    // The same stake checked again, as for a block the staker already checked
+    bench.unit("coinstake").run([&] {
+        BlockValidationState state;
+        bool checked = CheckProofOfStake(chainstate, state, tip, *coinstake, time, BENCH_STAKE_BITS, hash_proof, target_proof);
+        assert(checked);
+    });
+}
+
+//! Block of the coinbase and a coinstake, signed by the staker, as most blocks of the chain are
+static CBlock CreateBenchCoinStakeBlock(TestChain100Setup& setup)
+{
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript() << 101 << OP_0;
+    coinbase.vout.emplace_back(0, CScript());
+
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    block.vtx.push_back(CreateBenchCoinStake(setup));
+    {
+        LOCK(cs_main);
+        const CBlockIndex* tip{setup.m_node.chainman->ActiveChain().Tip()};
+        block.hashPrevBlock = tip->GetBlockHash();
+        block.nTime = (tip->GetBlockTime() + nStakeTimestampMask + 1) & ~int64_t{nStakeTimestampMask};
+    }
+    block.nBits = BENCH_STAKE_BITS;
+    block.nNonce = 0;
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    Assert(setup.coinbaseKey.Sign(block.GetHash(), block.vchBlockSig));
+    Assert(IsCoinStakeOnlyBlock(block));
+    return block;
+}
+
+static void CheckCoinStakeBlockTest(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    const CBlock block{CreateBenchCoinStakeBlock(*testing_setup)};
+    const Consensus::Params& params{Params().GetConsensus()};
+
+    // Checked inline, as ConnectBlock checks a block of only the coinbase and coinstake
+    bench.unit("block").run([&] {
+        const CBlock copy{block}; // Not marked as checked
+        BlockValidationState state;
+        bool checked = CheckBlock(copy, state, params);
+        assert(checked);
+    });
+}
+
+static void CheckCoinStakeBlockQueuedTest(benchmark::Bench& bench)
+{
+    if (GetNumCores() <= 1) return;
+
+    const auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    const CBlock block{CreateBenchCoinStakeBlock(*testing_setup)};
+    const Consensus::Params& params{Params().GetConsensus()};
+    CCheckQueue<CBlockCheck> queue{128};
+    queue.StartWorkerThreads(GetNumCores() - 1);
+
+    // The same checks handed to the script check threads, as for a block with more to verify
+    bench.unit("block").run([&] {
+        std::vector<CBlockCheck> checks;
+        BlockValidationState state;
+        bool checked = CheckBlock(block, state, params, true, true, &checks);
+        CCheckQueueControl<CBlockCheck> control(&queue);
+        control.Add(std::move(checks));
+        checked = checked && control.Wait();
+        assert(checked);
+    });
+    queue.StopWorkerThreads();
+}
+
+static void CoinStakeBlockMerkleRootTest(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    const CBlock block{CreateBenchCoinStakeBlock(*testing_setup)};
+
+    bench.unit("block").run([&] {
+        bool mutated;
+        const uint256 root{BlockMerkleRoot(block, &mutated)};
+        assert(root == block.hashMerkleRoot && !mutated);
+    });
+}
+
 BENCHMARK(DeserializeBlockTest, benchmark::PriorityLevel::HIGH);
 BENCHMARK(DeserializeAndCheckBlockTest, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CheckProofOfStakeTest, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CheckProofOfStakeCachedTest, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CheckCoinStakeBlockTest, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CheckCoinStakeBlockQueuedTest, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CoinStakeBlockMerkleRootTest, benchmark::PriorityLevel::HIGH);
@@ -4,6 +4,7 @@
 
 #include <bench/bench.h>
 #include <checkqueue.h>
+#include <crypto/sha256.h>
 #include <key.h>
 #include <prevector.h>
 #include <pubkey.h>
@@ -65,3 +66,52 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     ECC_Stop();
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob, benchmark::PriorityLevel::HIGH);
+
+//! Check doing some hashing, as a stand in for a signature check
+struct HashJob {
+    unsigned char data[64]{};
+    int rounds;
+    explicit HashJob(int rounds_in) : rounds(rounds_in) {}
+    bool operator()()
+    {
+        for (int i = 0; i < rounds; ++i) {
+            CSHA256().Write(data, sizeof(data)).Finalize(data);
+        }
+        return true;
+    }
+};
+
+//! Run blocks of batches of checks each, as ConnectBlock adds them a transaction at a time
+static void RunCheckQueueBlocks(benchmark::Bench& bench, size_t batches, size_t batch_size, int rounds)
+{
+    if (GetNumCores() <= 1) return;
+
+    CCheckQueue<HashJob> queue{QUEUE_BATCH_SIZE};
+    queue.StartWorkerThreads(GetNumCores() - 1);
+    const std::vector<std::vector<HashJob>> vBatches(batches, std::vector<HashJob>(batch_size, HashJob{rounds}));
+
+    bench.batch(batches * batch_size).unit("job").run([&] {
+        CCheckQueueControl<HashJob> control(&queue);
+        for (auto vChecks : vBatches) {
+            control.Add(std::move(vChecks));
+        }
+        control.Wait();
+    });
+    queue.StopWorkerThreads();
+}
+
+// A proof of stake block of its coinstake only: a handful of checks, which
+// should not wake every worker
+static void CCheckQueueSmallBlock(benchmark::Bench& bench)
+{
+    RunCheckQueueBlocks(bench, 1, 2, 100);
+}
+
+// A block full of storage transactions, each spending one input to carry
+// its chunks: many batches of a single check
+static void CCheckQueueLargeBlock(benchmark::Bench& bench)
+{
+    RunCheckQueueBlocks(bench, 2000, 1, 100);
+}
+BENCHMARK(CCheckQueueSmallBlock, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CCheckQueueLargeBlock, benchmark::PriorityLevel::HIGH);
@@ -15,6 +15,8 @@
 #include <random.h>
 #include <uint256.h>
 
+#include <vector>
+
 /* Number of bytes to hash per iteration */
 static const uint64_t BUFFER_SIZE = 1000*1000;
 
@@ -90,6 +92,37 @@ static void SipHash_32b(benchmark::Bench& bench)
     });
 }
 
+//! Outpoints hashed as a block's spent coins are looked up in the coins cache
+static constexpr size_t SIPHASH_BATCH_SIZE{4096};
+
+static void SipHashOutpoints(benchmark::Bench& bench, bool batch)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<uint256> hashes;
+    std::vector<const uint256*> ptrs;
+    std::vector<uint32_t> ns;
+    for (size_t i = 0; i < SIPHASH_BATCH_SIZE; ++i) {
+        hashes.push_back(rng.rand256());
+        ns.push_back(rng.randrange(8));
+    }
+    for (const uint256& hash : hashes) ptrs.push_back(&hash);
+    std::vector<uint64_t> out(SIPHASH_BATCH_SIZE);
+
+    bench.batch(SIPHASH_BATCH_SIZE).unit("outpoint").run([&] {
+        if (batch) {
+            SipHashUint256ExtraBatch(1, 2, ptrs, ns, out);
+        } else {
+            for (size_t i = 0; i < SIPHASH_BATCH_SIZE; ++i) {
+                out[i] = SipHashUint256Extra(1, 2, hashes[i], ns[i]);
+            }
+        }
+        ankerl::nanobench::doNotOptimizeAway(out);
+    });
+}
+
+static void SipHashOutpointsEach(benchmark::Bench& bench) { SipHashOutpoints(bench, /*batch=*/false); }
+static void SipHashOutpointsBatch(benchmark::Bench& bench) { SipHashOutpoints(bench, /*batch=*/true); }
+
 static void FastRandom_32bit(benchmark::Bench& bench)
 {
     FastRandomContext rng(true);
@@ -158,6 +191,8 @@ BENCHMARK(SHA3_256_1M, benchmark::PriorityLevel::HIGH);
 
 BENCHMARK(SHA256_32b, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SipHash_32b, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SipHashOutpointsEach, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SipHashOutpointsBatch, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SHA256D64_1024, benchmark::PriorityLevel::HIGH);
 BENCHMARK(FastRandom_32bit, benchmark::PriorityLevel::HIGH);
 BENCHMARK(FastRandom_1bit, benchmark::PriorityLevel::HIGH);
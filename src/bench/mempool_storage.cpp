@@ -0,0 +1,196 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <blockencodings.h>
+#include <consensus/validation.h>
+#include <kernel/mempool_entry.h>
+#include <node/miner.h>
+#include <opfile/src/protocol.h>
+#include <policy/policy.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
+#include <script/standard.h>
+#include <test/util/mining.h>
+#include <test/util/script.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <util/check.h>
+#include <util/translation.h>
+#include <validation.h>
+
+#include <map>
+#include <vector>
+
+//! Storage chains in the workload, and transactions in each, as a put of a large file chains its batches
+static constexpr int STORAGE_CHAINS{4};
+static constexpr int STORAGE_CHAIN_LENGTH{25};
+//! Chunk payload per OP_RETURN output, which keeps a full batch under MAX_STANDARD_TX_WEIGHT
+static constexpr size_t STORAGE_CHUNK_BYTES{300};
+//! Payment fan-outs in the workload, each paying PAYMENT_OUTPUTS outputs spent on by a child each
+static constexpr int PAYMENT_FANOUTS{20};
+static constexpr int PAYMENT_OUTPUTS{10};
+//! Payments spending coins a coinstake of the next block spends too
+static constexpr int COINSTAKE_CONFLICTS{10};
+static constexpr CAmount WORKLOAD_FEE{1000000};
+
+/** Lynx mempool traffic: storage chains mixed with payments, in an order they can be accepted in */
+struct StorageWorkload {
+    std::vector<CTransactionRef> txs;
+    //! Spends conflicting with some of txs, as the coinstake of a block confirming them
+    std::vector<CTransactionRef> coinstakes;
+};
+
+static StorageWorkload CreateStorageWorkload(TestChain100Setup& setup)
+{
+    const CScript script{GetScriptForRawPubKey(setup.coinbaseKey.GetPubKey())};
+    FillableSigningProvider keystore;
+    keystore.AddKey(setup.coinbaseKey);
+
+    // Spend the given outputs of prev, splitting what is left after the fee over num_outputs
+    // outputs to script, after which come the OP_RETURN outputs in data
+    const auto spend = [&](const CTransactionRef& prev, const std::vector<uint32_t>& prev_outs, int num_outputs, const std::vector<CScript>& data = {}) {
+        CMutableTransaction tx;
+        std::map<COutPoint, Coin> coins;
+        CAmount value{-WORKLOAD_FEE};
+        for (const uint32_t n : prev_outs) {
+            tx.vin.emplace_back(COutPoint{prev->GetHash(), n});
+            coins.emplace(tx.vin.back().prevout, Coin{prev->vout[n], 0, prev->IsCoinBase(), false});
+            value += prev->vout[n].nValue;
+        }
+        for (int i = 0; i < num_outputs; ++i) {
+            tx.vout.emplace_back(value / num_outputs, script);
+        }
+        for (const CScript& chunk : data) {
+            tx.vout.emplace_back(0, chunk);
+        }
+        std::map<int, bilingual_str> input_errors;
+        Assert(SignTransaction(tx, &keystore, coins, SIGHASH_ALL, input_errors));
+        return MakeTransactionRef(tx);
+    };
+
+    StorageWorkload workload;
+    size_t coinbase{0};
+    std::vector<CTransactionRef> chain_tips;
+    std::vector<CTransactionRef> fanouts;
+    for (int i = 0; i < STORAGE_CHAINS; ++i) {
+        chain_tips.push_back(setup.m_coinbase_txns[coinbase++]);
+    }
+    for (int i = 0; i < PAYMENT_FANOUTS; ++i) {
+        fanouts.push_back(spend(setup.m_coinbase_txns[coinbase++], {0}, PAYMENT_OUTPUTS));
+        workload.txs.push_back(fanouts.back());
+    }
+
+    // Interleave the storage batches with the payment children, as they arrive
+    FastRandomContext det_rand{true};
+    for (int batch = 0; batch < STORAGE_CHAIN_LENGTH; ++batch) {
+        for (CTransactionRef& tip : chain_tips) {
+            std::vector<CScript> data;
+            for (int n = 0; n < OPRETURN_PER_TX; ++n) {
+                std::vector<unsigned char> chunk{OPENCODING_MAGIC_BIN, OPENCODING_MAGIC_BIN + OPENCODING_MAGICLEN};
+                const auto payload{det_rand.randbytes(STORAGE_CHUNK_BYTES - chunk.size())};
+                chunk.insert(chunk.end(), payload.begin(), payload.end());
+                data.push_back(CScript() << OP_RETURN << chunk);
+            }
+            tip = spend(tip, {0}, 1, data);
+            workload.txs.push_back(tip);
+        }
+        for (const CTransactionRef& fanout : fanouts) {
+            if (batch < PAYMENT_OUTPUTS) workload.txs.push_back(spend(fanout, {static_cast<uint32_t>(batch)}, 1));
+        }
+    }
+
+    for (int i = 0; i < COINSTAKE_CONFLICTS; ++i) {
+        const CTransactionRef& staked{setup.m_coinbase_txns[coinbase++]};
+        workload.txs.push_back(spend(staked, {0}, 2));
+        workload.coinstakes.push_back(spend(staked, {0}, 1));
+    }
+    return workload;
+}
+
+static void AcceptWorkload(TestChain100Setup& setup, const StorageWorkload& workload)
+{
+    LOCK(::cs_main);
+    for (const CTransactionRef& tx : workload.txs) {
+        const MempoolAcceptResult res{setup.m_node.chainman->ProcessTransaction(tx)};
+        assert(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
+    }
+}
+
+static void MempoolStorageAccept(benchmark::Bench& bench)
+{
+    auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    const StorageWorkload workload{CreateStorageWorkload(*testing_setup)};
+    CTxMemPool& pool{*testing_setup->m_node.mempool};
+
+    // Emptying the mempool again for the next run is timed too, though it is
+    // little next to accepting. Not by TrimToSize(), which would raise the
+    // mempool minimum fee above the workload's.
+    bench.unit("tx").batch(workload.txs.size()).run([&] {
+        AcceptWorkload(*testing_setup, workload);
+        LOCK2(::cs_main, pool.cs);
+        for (const CTransactionRef& tx : workload.txs) {
+            pool.removeRecursive(*tx, MemPoolRemovalReason::EXPIRY);
+        }
+    });
+}
+
+static void MempoolStorageAssembleBlock(benchmark::Bench& bench)
+{
+    auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    AcceptWorkload(*testing_setup, CreateStorageWorkload(*testing_setup));
+    node::BlockAssembler::Options assembler_options;
+    assembler_options.test_block_validity = false;
+
+    bench.run([&] {
+        PrepareBlock(testing_setup->m_node, P2WSH_OP_TRUE, assembler_options);
+    });
+}
+
+static void MempoolStorageEviction(benchmark::Bench& bench)
+{
+    // A storage share below the workload's storage transactions, so the
+    // storage ones are evicted first
+    auto testing_setup{MakeNoLogFileContext<TestChain100Setup>(CBaseChainParams::REGTEST, {"-maxstoragemempool=4"})};
+    const StorageWorkload workload{CreateStorageWorkload(*testing_setup)};
+    CTxMemPool& pool{*testing_setup->m_node.mempool};
+
+    LOCK2(::cs_main, pool.cs);
+    bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        for (const CTransactionRef& tx : workload.txs) {
+            LockPoints lp;
+            pool.addUnchecked(CTxMemPoolEntry(tx, WORKLOAD_FEE, /*time=*/0, /*entry_height=*/1,
+                                              /*spends_coinbase=*/false, /*sigops_cost=*/4, lp));
+        }
+        pool.removeForBlock(workload.coinstakes, /*nBlockHeight=*/101);
+        pool.TrimToSize(pool.DynamicMemoryUsage() * 3 / 4);
+        pool.TrimToSize(0);
+    });
+}
+
+static void MempoolStorageCompactBlock(benchmark::Bench& bench)
+{
+    // A compact block of payments only, received while the storage chains wait in the
+    // mempool, so most of the mempool is looked at for transactions the block lacks
+    auto testing_setup{MakeNoLogFileContext<TestChain100Setup>()};
+    const StorageWorkload workload{CreateStorageWorkload(*testing_setup)};
+    AcceptWorkload(*testing_setup, workload);
+    CBlock block;
+    block.vtx.push_back(testing_setup->m_coinbase_txns.back());
+    for (const CTransactionRef& tx : workload.txs) {
+        if (tx->vout.size() < OPRETURN_PER_TX) block.vtx.push_back(tx);
+    }
+    const CBlockHeaderAndShortTxIDs cmpctblock{block, /*prefill_bytes=*/0};
+
+    bench.unit("block").run([&] {
+        PartiallyDownloadedBlock partial_block{testing_setup->m_node.mempool.get()};
+        const ReadStatus status{partial_block.InitData(cmpctblock, {})};
+        assert(status == READ_STATUS_OK);
+    });
+}
+
+BENCHMARK(MempoolStorageAccept, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolStorageAssembleBlock, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolStorageEviction, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MempoolStorageCompactBlock, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,329 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <consensus/amount.h>
+#include <consensus/merkle.h>
+#include <consensus/validation.h>
+#include <key.h>
+#include <pos/minter.h>
+#include <pos/pos.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <util/check.h>
+#include <util/time.h>
+#include <util/translation.h>
+#include <validation.h>
+#include <wallet/scriptpubkeyman.h>
+#include <wallet/wallet.h>
+#include <wallet/walletdb.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+using wallet::CWallet;
+using wallet::CreateMockWalletDatabase;
+
+//! Synthetic wallet a staking benchmark runs against
+struct StakeBenchConfig {
+    //! Number of coins staking
+    int num_coins;
+    //! Value of each coin
+    CAmount amount;
+    //! Age of the coins once staking starts, in seconds
+    int64_t age;
+};
+
+//! Target at which a stake of 1 coin finds a kernel about once in 2^13 timestamps
+static constexpr uint32_t STAKE_BENCH_BITS{0x1c010000};
+
+struct StakeBenchChain {
+    std::unique_ptr<TestChain100Setup> testing_setup;
+    std::unique_ptr<CWallet> wallet{};
+    std::vector<COutPoint> coins{};
+    //! Time of the block holding the coins
+    int64_t coin_time{0};
+};
+
+/**
+ * Chain holding config.num_coins coins of config.amount, deep enough to stake
+ * and config.age old, and a legacy wallet owning only those coins
+ */
+static StakeBenchChain MakeStakeBenchChain(const StakeBenchConfig& config)
+{
+    StakeBenchChain chain{MakeNoLogFileContext<TestChain100Setup>()};
+    TestChain100Setup& setup{*chain.testing_setup};
+    Chainstate& chainstate{setup.m_node.chainman->ActiveChainstate()};
+
+    // Mature enough coinbases to fan out to the coins staked
+    setup.mineBlocks(COINBASE_MATURITY);
+
+    CKey stake_key;
+    stake_key.MakeNewKey(true);
+    const CScript stake_script{GetScriptForDestination(PKHash(stake_key.GetPubKey()))};
+
+    CMutableTransaction tx;
+    std::map<COutPoint, Coin> spent;
+    CAmount value_in{0};
+    {
+        LOCK(cs_main);
+        for (const auto& coinbase : setup.m_coinbase_txns) {
+            if (value_in >= config.num_coins * config.amount) break;
+            const COutPoint prevout{coinbase->GetHash(), 0};
+            Coin coin;
+            if (!chainstate.CoinsTip().GetCoin(prevout, coin) || chainstate.m_chain.Height() + 1 - coin.nHeight < COINBASE_MATURITY) continue;
+            tx.vin.emplace_back(prevout);
+            value_in += coin.out.nValue;
+            spent.emplace(prevout, coin);
+        }
+    }
+    Assert(value_in >= config.num_coins * config.amount);
+    tx.vout.assign(config.num_coins, CTxOut{config.amount, stake_script});
+
+    FillableSigningProvider keystore;
+    keystore.AddKey(setup.coinbaseKey);
+    std::map<int, bilingual_str> input_errors;
+    Assert(SignTransaction(tx, &keystore, spent, SIGHASH_ALL, input_errors));
+    const CBlock block{setup.CreateAndProcessBlock({tx}, CScript() << OP_TRUE)};
+    chain.coin_time = block.GetBlockTime();
+    for (int n = 0; n < config.num_coins; ++n) {
+        chain.coins.emplace_back(tx.GetHash(), n);
+    }
+
+    // Bury the coins past the depth required to stake, then age them
+    setup.mineBlocks(COINBASE_MATURITY);
+    SetMockTime(GetTime() + config.age);
+
+    chain.wallet = std::make_unique<CWallet>(setup.m_node.chain.get(), "", CreateMockWalletDatabase());
+    CWallet& wallet{*chain.wallet};
+    {
+        LOCK2(wallet.cs_wallet, ::cs_main);
+        wallet.SetLastBlockProcessed(chainstate.m_chain.Height(), chainstate.m_chain.Tip()->GetBlockHash());
+    }
+    wallet.LoadWallet();
+    {
+        LOCK(wallet.cs_wallet);
+        wallet.SetupLegacyScriptPubKeyMan();
+        auto spk_man{wallet.GetLegacyScriptPubKeyMan()};
+        LOCK(spk_man->cs_KeyStore);
+        Assert(spk_man->AddKeyPubKey(stake_key, stake_key.GetPubKey()));
+        wallet.m_stake_policy.combine_threshold = 1000 * COIN;
+    }
+    wallet::WalletRescanReserver reserver(wallet);
+    reserver.reserve();
+    const CWallet::ScanResult result{wallet.ScanForWalletTransactions(Params().GenesisBlock().GetHash(), /*start_height=*/0, /*max_height=*/{}, reserver, /*fUpdate=*/false, /*save_progress=*/false)};
+    Assert(result.status == CWallet::ScanResult::SUCCESS);
+    return chain;
+}
+
+//! Kernel hashes as a node validating coinstakes computes them, with nothing cached
+static void StakeKernelHash(benchmark::Bench& bench, const StakeBenchConfig& config)
+{
+    const StakeBenchChain chain{MakeStakeBenchChain(config)};
+    const CBlockIndex* tip{WITH_LOCK(cs_main, return chain.testing_setup->m_node.chainman->ActiveChain().Tip())};
+
+    int64_t time{GetTime()};
+    bench.unit("kernel").batch(chain.coins.size()).run([&] {
+        time += nStakeTimestampMask + 1;
+        for (const COutPoint& prevout : chain.coins) {
+            uint256 hash_proof, target_proof;
+            CheckStakeKernelHash(tip, STAKE_BENCH_BITS, chain.coin_time, config.amount, prevout, time, hash_proof, target_proof);
+        }
+    });
+}
+
+//! Search of the whole wallet by a single worker, from one kernel found to the next
+static void StakeTimeToFirstHit(benchmark::Bench& bench, const StakeBenchConfig& config)
+{
+    const StakeBenchChain chain{MakeStakeBenchChain(config)};
+    Chainstate& chainstate{chain.testing_setup->m_node.chainman->ActiveChainstate()};
+    const CBlockIndex* tip{WITH_LOCK(cs_main, return chainstate.m_chain.Tip())};
+
+    int64_t search_time{GetTime()};
+    bench.unit("kernel found").run([&] {
+        COutPoint prevout;
+        int64_t time;
+        while (!FindStakeKernel(chainstate, tip, STAKE_BENCH_BITS, search_time, DEFAULT_STAKE_LOOKAHEAD, chain.coins, prevout, time)) {
+            search_time += DEFAULT_STAKE_LOOKAHEAD * (nStakeTimestampMask + 1);
+        }
+        search_time = time + nStakeTimestampMask + 1;
+    });
+}
+
+//! Coinstake attempts of the staker, one timestamp each, signing the coinstake whenever a kernel is found
+static void StakeCreateCoinStake(benchmark::Bench& bench, const StakeBenchConfig& config)
+{
+    const StakeBenchChain chain{MakeStakeBenchChain(config)};
+    Chainstate& chainstate{chain.testing_setup->m_node.chainman->ActiveChainstate()};
+    CBlockIndex* tip{WITH_LOCK(cs_main, return chainstate.m_chain.Tip())};
+
+    int64_t time{GetTime()};
+    bench.unit("attempt").run([&] {
+        time += nStakeTimestampMask + 1;
+        CMutableTransaction coinstake;
+        CKey key;
+        CreateCoinStake(chain.wallet.get(), tip, STAKE_BENCH_BITS, time, tip->nHeight + 1, /*nFees=*/0, coinstake, key, chainstate);
+    });
+}
+
+static constexpr StakeBenchConfig STAKE_BENCH_SMALL{100, COIN, 60 * 60};
+static constexpr StakeBenchConfig STAKE_BENCH_MEDIUM{1000, COIN, 60 * 60};
+static constexpr StakeBenchConfig STAKE_BENCH_LARGE{10000, COIN, 60 * 60};
+
+/** Proof-of-stake block on the tip of a bench chain, staked and signed as the staker does */
+struct StakeBenchBlock {
+    StakeBenchChain chain;
+    const CBlockIndex* tip{nullptr};
+    CBlock block{};
+    //! Kernel hash of the coinstake
+    uint256 hash_proof{};
+};
+
+static StakeBenchBlock MakeStakeBenchBlock(const StakeBenchConfig& config)
+{
+    StakeBenchBlock staked{MakeStakeBenchChain(config)};
+    Chainstate& chainstate{staked.chain.testing_setup->m_node.chainman->ActiveChainstate()};
+    CBlockIndex* tip{WITH_LOCK(cs_main, return chainstate.m_chain.Tip())};
+    staked.tip = tip;
+
+    CMutableTransaction coinstake;
+    CKey key;
+    int64_t time{GetTime() & ~int64_t{nStakeTimestampMask}};
+    while (!CreateCoinStake(staked.chain.wallet.get(), tip, STAKE_BENCH_BITS, time, tip->nHeight + 1, /*nFees=*/0, coinstake, key, chainstate)) {
+        time += nStakeTimestampMask + 1;
+        coinstake = CMutableTransaction{};
+    }
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript() << (tip->nHeight + 1) << OP_0;
+    coinbase.vout.emplace_back(0, CScript());
+
+    CBlock& block{staked.block};
+    block.nVersion = tip->nVersion;
+    block.hashPrevBlock = tip->GetBlockHash();
+    block.nTime = time;
+    block.nBits = STAKE_BENCH_BITS;
+    block.vtx = {MakeTransactionRef(std::move(coinbase)), MakeTransactionRef(std::move(coinstake))};
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    Assert(SignBlockWithKey(block, key));
+
+    // Check the signature apart, so the stake is not cached
+    LOCK(cs_main);
+    BlockValidationState state;
+    uint256 target_proof;
+    std::vector<CStakeSignatureCheck> checks;
+    Assert(CheckProofOfStake(chainstate, state, tip, *block.vtx[1], block.nTime, block.nBits, staked.hash_proof, target_proof, &checks));
+    for (auto& check : checks) Assert(check());
+    return staked;
+}
+
+//! Coinstake check of a block not seen before: coin lookup, kernel hash and kernel signature
+static void StakeCheckProofOfStake(benchmark::Bench& bench)
+{
+    const StakeBenchBlock staked{MakeStakeBenchBlock(STAKE_BENCH_SMALL)};
+    Chainstate& chainstate{staked.chain.testing_setup->m_node.chainman->ActiveChainstate()};
+    const CTransaction& coinstake{*staked.block.vtx[1]};
+
+    LOCK(cs_main);
+    bench.unit("coinstake").run([&] {
+        BlockValidationState state;
+        uint256 hash_proof, target_proof;
+        std::vector<CStakeSignatureCheck> checks;
+        Assert(CheckProofOfStake(chainstate, state, staked.tip, coinstake, staked.block.nTime, staked.block.nBits, hash_proof, target_proof, &checks));
+        for (auto& check : checks) Assert(check());
+    });
+}
+
+//! Coinstake check of a block seen before on the same parent, skipping the kernel signature
+static void StakeCheckProofOfStakeCached(benchmark::Bench& bench)
+{
+    const StakeBenchBlock staked{MakeStakeBenchBlock(STAKE_BENCH_SMALL)};
+    Chainstate& chainstate{staked.chain.testing_setup->m_node.chainman->ActiveChainstate()};
+    const CTransaction& coinstake{*staked.block.vtx[1]};
+
+    LOCK(cs_main);
+    bench.unit("coinstake").run([&] {
+        BlockValidationState state;
+        uint256 hash_proof, target_proof;
+        Assert(CheckProofOfStake(chainstate, state, staked.tip, coinstake, staked.block.nTime, staked.block.nBits, hash_proof, target_proof));
+    });
+}
+
+static void StakeComputeModifier(benchmark::Bench& bench)
+{
+    const StakeBenchBlock staked{MakeStakeBenchBlock(STAKE_BENCH_SMALL)};
+
+    bench.unit("modifier").run([&] {
+        ankerl::nanobench::doNotOptimizeAway(ComputeStakeModifier(staked.tip, staked.hash_proof));
+    });
+}
+
+static void StakeCheckTimestamp(benchmark::Bench& bench)
+{
+    int64_t time{GetTime()};
+    bench.unit("timestamp").run([&] {
+        ankerl::nanobench::doNotOptimizeAway(CheckCoinStakeTimestamp(++time));
+    });
+}
+
+//! Block signature against the key of the coinstake output, hashing the header each time as validation does
+static void StakeCheckBlockSignature(benchmark::Bench& bench)
+{
+    const StakeBenchBlock staked{MakeStakeBenchBlock(STAKE_BENCH_SMALL)};
+
+    bench.unit("block").run([&] {
+        Assert(CheckBlockSignature(staked.block));
+    });
+}
+
+//! Duplicate stake lookup of a block, among as many kernels as are remembered
+static void StakeCheckUnique(benchmark::Bench& bench)
+{
+    const StakeBenchBlock staked{MakeStakeBenchBlock(STAKE_BENCH_SMALL)};
+    FastRandomContext rng{/*fDeterministic=*/true};
+    for (size_t i = 0; i < MAX_STAKE_SEEN; ++i) {
+        g_stake_seen.Insert(COutPoint{rng.rand256(), 0}, rng.rand256());
+    }
+    Assert(CheckStakeUnique(staked.block, /*fUpdate=*/true));
+
+    bench.unit("block").run([&] {
+        Assert(CheckStakeUnique(staked.block, /*fUpdate=*/false));
+    });
+}
+
+static void StakeKernelHash100(benchmark::Bench& bench) { StakeKernelHash(bench, STAKE_BENCH_SMALL); }
+static void StakeKernelHash1000(benchmark::Bench& bench) { StakeKernelHash(bench, STAKE_BENCH_MEDIUM); }
+static void StakeKernelHash10000(benchmark::Bench& bench) { StakeKernelHash(bench, STAKE_BENCH_LARGE); }
+static void StakeTimeToFirstHit100(benchmark::Bench& bench) { StakeTimeToFirstHit(bench, STAKE_BENCH_SMALL); }
+static void StakeTimeToFirstHit1000(benchmark::Bench& bench) { StakeTimeToFirstHit(bench, STAKE_BENCH_MEDIUM); }
+static void StakeTimeToFirstHit10000(benchmark::Bench& bench) { StakeTimeToFirstHit(bench, STAKE_BENCH_LARGE); }
+static void StakeCreateCoinStake100(benchmark::Bench& bench) { StakeCreateCoinStake(bench, STAKE_BENCH_SMALL); }
+static void StakeCreateCoinStake1000(benchmark::Bench& bench) { StakeCreateCoinStake(bench, STAKE_BENCH_MEDIUM); }
+static void StakeCreateCoinStake10000(benchmark::Bench& bench) { StakeCreateCoinStake(bench, STAKE_BENCH_LARGE); }
+
+BENCHMARK(StakeKernelHash100, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeKernelHash1000, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeKernelHash10000, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeTimeToFirstHit100, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeTimeToFirstHit1000, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeTimeToFirstHit10000, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeCreateCoinStake100, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeCreateCoinStake1000, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeCreateCoinStake10000, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeCheckProofOfStake, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeCheckProofOfStakeCached, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeComputeModifier, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeCheckTimestamp, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeCheckBlockSignature, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StakeCheckUnique, benchmark::PriorityLevel::HIGH);
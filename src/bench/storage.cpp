@@ -0,0 +1,217 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <key_io.h>
+#include <opfile/src/chunk.h>
+#include <opfile/src/decode.h>
+#include <opfile/src/encode.h>
+#include <opfile/src/protocol.h>
+#include <opfile/src/util.h>
+#include <random.h>
+#include <script/script.h>
+#include <storage/auth.h>
+#include <storage/storage.h>
+#include <storage/util.h>
+#include <test/util/mining.h>
+#include <test/util/script.h>
+#include <test/util/setup_common.h>
+#include <util/check.h>
+#include <util/fs.h>
+#include <util/strencodings.h>
+#include <validation.h>
+
+#include <string>
+#include <vector>
+
+//! Size of the file stored by the encode and decode benchmarks, 128 protocol 00 chunks
+static constexpr int STORAGE_BENCH_FILELEN{64 << 10};
+
+//! Authenticate with a fresh key, returned to sign header chunks with
+static CKey SetBenchAuthUser()
+{
+    CKey key;
+    key.MakeNewKey(true);
+    std::string wif{EncodeSecret(key)};
+    Assert(set_auth_user(wif));
+    return key;
+}
+
+//! Encode a file of filelen random bytes under uuid into OP_RETURN scripts, header chunk first
+static std::vector<CScript> EncodeAsset(const CKey& key, const fs::path& dir, int filelen, const std::string& uuid = "")
+{
+    const std::string filepath{fs::PathToString(dir / "asset")};
+    Assert(generate_random_binary(filepath, filelen));
+
+    std::pair<std::string, std::string> putinfo{filepath, uuid};
+    int error_level, total_chunks;
+    std::vector<std::string> encoded_chunks;
+    Assert(build_chunks_with_headers(putinfo, key, error_level, total_chunks, encoded_chunks));
+
+    std::vector<CScript> scripts;
+    for (const auto& chunk : encoded_chunks) {
+        scripts.push_back(CScript() << OP_RETURN << ParseHex(chunk));
+    }
+    return scripts;
+}
+
+static void StorageEncodeChunks(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    const CKey key{SetBenchAuthUser()};
+
+    const std::string filepath{fs::PathToString(testing_setup->m_path_root / "asset")};
+    Assert(generate_random_binary(filepath, STORAGE_BENCH_FILELEN));
+    std::pair<std::string, std::string> putinfo{filepath, ""};
+
+    bench.unit("byte").batch(STORAGE_BENCH_FILELEN).run([&] {
+        int error_level, total_chunks;
+        std::vector<std::string> encoded_chunks;
+        bool ok = build_chunks_with_headers(putinfo, key, error_level, total_chunks, encoded_chunks);
+        assert(ok);
+    });
+}
+
+static void StorageDecodeChunks(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    const CKey key{SetBenchAuthUser()};
+    std::vector<CScript> scripts{EncodeAsset(key, testing_setup->m_path_root, STORAGE_BENCH_FILELEN)};
+
+    std::pair<std::string, std::string> get_info{"decoded", fs::PathToString(testing_setup->m_path_root)};
+
+    bench.unit("byte").batch(STORAGE_BENCH_FILELEN).run([&] {
+        int error_level, total_chunks;
+        bool ok = build_file_from_chunks(get_info, error_level, total_chunks, scripts);
+        assert(ok);
+    });
+}
+
+static void StorageCheckChunkContextual(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    const CKey key{SetBenchAuthUser()};
+    std::vector<CScript> scripts{EncodeAsset(key, testing_setup->m_path_root, STORAGE_BENCH_FILELEN)};
+
+    // Per output, as the hex based chunk checks see them
+    bench.unit("output").batch(scripts.size()).run([&] {
+        for (const auto& script : scripts) {
+            int offset, protocol, error_level;
+            std::string opdata{HexStr(script)}, chunk;
+            strip_opreturndata_from_chunk(opdata, chunk, offset);
+            bool valid = check_chunk_contextual(opdata, protocol, error_level, offset);
+            assert(valid);
+        }
+    });
+}
+
+static void StorageIsOpreturnAnAuthdata(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    const CKey key{SetBenchAuthUser()};
+    std::vector<CScript> scripts{EncodeAsset(key, testing_setup->m_path_root, STORAGE_BENCH_FILELEN)};
+
+    // Storage chunks, none of them authdata, as met when scanning blocks for it
+    bench.unit("output").batch(scripts.size()).run([&] {
+        for (const auto& script : scripts) {
+            int error_level;
+            bool authdata = is_opreturn_an_authdata(script, error_level);
+            assert(!authdata);
+        }
+    });
+}
+
+static void StorageChunkHash(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    const CKey key{SetBenchAuthUser()};
+    const std::vector<CScript> scripts{EncodeAsset(key, testing_setup->m_path_root, STORAGE_BENCH_FILELEN)};
+    std::vector<chunk_view> views(scripts.size() - 1);
+    for (size_t i = 0; i < views.size(); ++i) {
+        int error_level;
+        Assert(parse_chunk_from_script(scripts[i + 1], views[i], error_level));
+    }
+
+    // The checksums of a file's data chunks, as checked when it is decoded
+    bench.unit("byte").batch(STORAGE_BENCH_FILELEN).run([&] {
+        for (const auto& view : views) {
+            bool valid = is_valid_chunkhash(view);
+            assert(valid);
+        }
+    });
+}
+
+static void StorageHexlifyFromBin(benchmark::Bench& bench)
+{
+    const std::vector<unsigned char> data{FastRandomContext{true}.randbytes(OPENCODING_CHUNKMAX)};
+    std::vector<char> hex(2 * data.size() + 1);
+
+    // One chunk of data, as hashed and hex encoded per chunk
+    bench.unit("byte").batch(data.size()).run([&] {
+        hexlify_from_bin(hex.data(), data.data(), data.size());
+        ankerl::nanobench::doNotOptimizeAway(hex);
+    });
+}
+
+static void StorageBinlifyFromHex(benchmark::Bench& bench)
+{
+    const std::string hex{HexStr(FastRandomContext{true}.randbytes(OPENCODING_CHUNKMAX))};
+    std::vector<unsigned char> data(hex.size() / 2);
+
+    bench.unit("byte").batch(data.size()).run([&] {
+        binlify_from_hex(data.data(), hex.data(), hex.size());
+        ankerl::nanobench::doNotOptimizeAway(data);
+    });
+}
+
+static void StorageScanBlocksForUuids(benchmark::Bench& bench)
+{
+    auto testing_setup{MakeNoLogFileContext<const TestingSetup>()};
+    const node::NodeContext& node{testing_setup->m_node};
+    const CKey key{SetBenchAuthUser()};
+
+    CScriptWitness witness;
+    witness.stack.push_back(WITNESS_STACK_ELEM_OP_TRUE);
+
+    // Mature coinbases to pay for the asset transactions
+    constexpr int NUM_ASSETS{50};
+    std::vector<CTxIn> coins;
+    for (int b{0}; b < COINBASE_MATURITY + NUM_ASSETS; ++b) {
+        coins.push_back(MineBlock(node, P2WSH_OP_TRUE));
+    }
+
+    // A chain with one small asset per block, amid empty blocks
+    for (int n{0}; n < NUM_ASSETS; ++n) {
+        CMutableTransaction tx;
+        tx.vin.push_back(coins.at(n));
+        tx.vin.back().scriptWitness = witness;
+        for (const auto& script : EncodeAsset(key, testing_setup->m_path_root, 2 * OPENCODING_CHUNKMAX, strprintf("%064x", n + 1))) {
+            tx.vout.emplace_back(0, script);
+        }
+        {
+            LOCK(::cs_main);
+            const MempoolAcceptResult res{node.chainman->ProcessTransaction(MakeTransactionRef(tx))};
+            assert(res.m_result_type == MempoolAcceptResult::ResultType::VALID);
+        }
+        for (int b{0}; b < 4; ++b) {
+            MineBlock(node, P2WSH_OP_TRUE);
+        }
+    }
+
+    bench.run([&] {
+        std::vector<std::string> uuids;
+        bool ok = scan_blocks_for_uuids(*node.chainman, uuids, 0);
+        assert(ok && uuids.size() == NUM_ASSETS);
+    });
+}
+
+BENCHMARK(StorageEncodeChunks, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StorageDecodeChunks, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StorageCheckChunkContextual, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StorageIsOpreturnAnAuthdata, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StorageChunkHash, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StorageHexlifyFromBin, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StorageBinlifyFromHex, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StorageScanBlocksForUuids, benchmark::PriorityLevel::HIGH);
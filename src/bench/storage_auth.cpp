@@ -0,0 +1,69 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <crypto/common.h>
+#include <hash.h>
+#include <key.h>
+#include <storage/auth.h>
+#include <uint256.h>
+#include <util/check.h>
+
+#include <optional>
+#include <vector>
+
+static uint160 AuthMember(uint32_t n)
+{
+    uint160 hash;
+    WriteLE32(hash.begin(), n);
+    return hash;
+}
+
+static void AuthMemberLookup(benchmark::Bench& bench, uint32_t members)
+{
+    std::vector<uint160> list;
+    for (uint32_t n = 0; n < members; n++) {
+        list.push_back(AuthMember(n));
+    }
+    set_auth_state(list, 0);
+
+    // Half of the lookups miss, as for an unauthenticated RPC user
+    uint32_t count = 0;
+    bench.run([&] {
+        bool found = is_auth_member(AuthMember(count++ % (2 * members)));
+        ankerl::nanobench::doNotOptimizeAway(found);
+    });
+
+    set_auth_state({}, 0);
+}
+
+//! Header signatures of a list scan, recovered to their tenants in one batch
+static void AuthRecoverSigners(benchmark::Bench& bench)
+{
+    ECC_Start();
+    CKey key;
+    key.MakeNewKey(/*fCompressed=*/true);
+    const uint160 tenant{Hash160(key.GetPubKey())};
+
+    std::vector<signed_hash> headers(1024);
+    for (uint32_t n = 0; n < headers.size(); n++) {
+        headers[n].hash = Hash(AuthMember(n));
+        Assert(key.SignCompact(headers[n].hash, headers[n].signature));
+    }
+
+    // After the first run the signers come from the cache, as for repeated list scans
+    std::vector<std::optional<uint160>> signers;
+    bench.batch(headers.size()).unit("header").run([&] {
+        recover_signers(headers, signers);
+        assert(signers.back() == tenant);
+    });
+    ECC_Stop();
+}
+
+static void AuthMemberLookup100(benchmark::Bench& bench) { AuthMemberLookup(bench, 100); }
+static void AuthMemberLookup10000(benchmark::Bench& bench) { AuthMemberLookup(bench, 10000); }
+
+BENCHMARK(AuthMemberLookup100, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AuthMemberLookup10000, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AuthRecoverSigners, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,78 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <opfile/src/protocol.h>
+#include <random.h>
+#include <script/standard.h>
+#include <storage/storage.h>
+#include <storage/util.h>
+#include <test/util/setup_common.h>
+#include <util/check.h>
+#include <util/translation.h>
+#include <wallet/test/util.h>
+#include <wallet/wallet.h>
+
+#include <map>
+#include <vector>
+
+using wallet::CWallet;
+using wallet::CreateMockWalletDatabase;
+using wallet::DBErrors;
+using wallet::WALLET_FLAG_DESCRIPTORS;
+
+//! Chunk outputs of a putfile transaction, as many as a storage batch holds
+static constexpr int STORAGE_SIGN_OUTPUTS{256};
+
+//! Sign a putfile transaction of STORAGE_SIGN_OUTPUTS full chunks, spending one wallet output
+static void StorageSign(benchmark::Bench& bench, bool generic)
+{
+    const auto test_setup = MakeNoLogFileContext<const TestingSetup>();
+
+    CWallet wallet{test_setup->m_node.chain.get(), "", CreateMockWalletDatabase()};
+    {
+        LOCK(wallet.cs_wallet);
+        wallet.SetWalletFlag(WALLET_FLAG_DESCRIPTORS);
+        wallet.SetupDescriptorScriptPubKeyMans();
+        if (wallet.LoadWallet() != DBErrors::LOAD_OK) assert(false);
+    }
+
+    const CScript script{GetScriptForDestination(wallet::getNewDestination(wallet, OutputType::BECH32))};
+    const opreturn_input input{COutPoint{GetRandHash(), 0}, Coin{CTxOut{100 * COIN, script}, /*nHeightIn=*/1, /*fCoinBaseIn=*/false, /*fCoinStakeIn=*/false}};
+
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<std::vector<unsigned char>> payload;
+    for (int i = 0; i < STORAGE_SIGN_OUTPUTS; ++i) {
+        payload.push_back(rng.randbytes(OPENCODING_CHUNKMAX));
+    }
+
+    bench.unit("tx").run([&] {
+        CMutableTransaction tx;
+        if (generic) {
+            // Through the wallet's signing, once for the size and once with the fee, as before
+            tx.vin.emplace_back(input.outpoint);
+            tx.vout.push_back(input.coin.out);
+            for (const auto& chunk : payload) {
+                tx.vout.push_back(build_opreturn_txout(chunk));
+            }
+            const std::map<COutPoint, Coin> coins{{input.outpoint, input.coin}};
+            std::map<int, bilingual_str> input_errors;
+            bool ok = wallet.SignTransaction(tx, coins, SIGHASH_DEFAULT, input_errors);
+            tx.vout[0].nValue -= COIN;
+            ok &= wallet.SignTransaction(tx, coins, SIGHASH_DEFAULT, input_errors);
+            assert(ok);
+        } else {
+            bool ok = build_selfsend_transaction(&wallet, input, payload, tx);
+            assert(ok);
+        }
+        ankerl::nanobench::doNotOptimizeAway(tx);
+    });
+}
+
+static void StorageSignGeneric(benchmark::Bench& bench) { StorageSign(bench, /*generic=*/true); }
+static void StorageSignSelfsend(benchmark::Bench& bench) { StorageSign(bench, /*generic=*/false); }
+
+BENCHMARK(StorageSignGeneric, benchmark::PriorityLevel::LOW);
+BENCHMARK(StorageSignSelfsend, benchmark::PriorityLevel::LOW);
@@ -0,0 +1,79 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <key_io.h>
+#include <opfile/src/protocol.h>
+#include <random.h>
+#include <script/descriptor.h>
+#include <script/standard.h>
+#include <storage/util.h>
+#include <test/util/setup_common.h>
+#include <util/check.h>
+#include <wallet/test/util.h>
+#include <wallet/wallet.h>
+
+#include <vector>
+
+using wallet::CWallet;
+using wallet::CreateMockWalletDatabase;
+using wallet::DBErrors;
+using wallet::WALLET_FLAG_DESCRIPTORS;
+using wallet::WalletDescriptor;
+
+//! Chunk outputs of a storage transaction, each of which block sync asks the wallet about
+static constexpr int ISMINE_CHUNK_OUTPUTS{256};
+//! Outputs paying to scripts the wallet does not watch
+static constexpr int ISMINE_OTHER_OUTPUTS{64};
+
+//! Ask a descriptor wallet whether each output of a block of storage and payment transactions is its
+static void WalletIsMine(benchmark::Bench& bench, int extra_descriptors)
+{
+    const auto test_setup = MakeNoLogFileContext<const TestingSetup>();
+
+    CWallet wallet{test_setup->m_node.chain.get(), "", CreateMockWalletDatabase()};
+    {
+        LOCK(wallet.cs_wallet);
+        wallet.SetWalletFlag(WALLET_FLAG_DESCRIPTORS);
+        wallet.SetupDescriptorScriptPubKeyMans();
+        if (wallet.LoadWallet() != DBErrors::LOAD_OK) assert(false);
+
+        // As imported keys each add a ScriptPubKeyMan of their own
+        for (int i = 0; i < extra_descriptors; ++i) {
+            CKey key;
+            key.MakeNewKey(/*fCompressed=*/true);
+            FlatSigningProvider keys;
+            std::string error;
+            std::unique_ptr<Descriptor> desc{Parse("combo(" + EncodeSecret(key) + ")", keys, error, /*require_checksum=*/false)};
+            WalletDescriptor w_desc{std::move(desc), /*creation_time=*/0, /*range_start=*/0, /*range_end=*/0, /*next_index=*/0};
+            Assert(wallet.AddWalletDescriptor(w_desc, keys, /*label=*/"", /*internal=*/false));
+        }
+    }
+
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<CTxOut> outputs;
+    for (int i = 0; i < ISMINE_CHUNK_OUTPUTS; ++i) {
+        outputs.push_back(build_opreturn_txout(rng.randbytes(OPENCODING_CHUNKMAX)));
+    }
+    for (int i = 0; i < ISMINE_OTHER_OUTPUTS; ++i) {
+        outputs.emplace_back(COIN, GetScriptForDestination(WitnessV0KeyHash{uint160{rng.randbytes(20)}}));
+    }
+    outputs.emplace_back(COIN, GetScriptForDestination(wallet::getNewDestination(wallet, OutputType::BECH32)));
+
+    bench.unit("output").batch(outputs.size()).run([&] {
+        LOCK(wallet.cs_wallet);
+        int mine{0};
+        for (const CTxOut& txout : outputs) {
+            if (wallet.IsMine(txout)) ++mine;
+        }
+        assert(mine == 1);
+    });
+}
+
+static void WalletIsMineDescriptors(benchmark::Bench& bench) { WalletIsMine(bench, /*extra_descriptors=*/0); }
+static void WalletIsMineManyDescriptors(benchmark::Bench& bench) { WalletIsMine(bench, /*extra_descriptors=*/100); }
+
+BENCHMARK(WalletIsMineDescriptors, benchmark::PriorityLevel::HIGH);
+BENCHMARK(WalletIsMineManyDescriptors, benchmark::PriorityLevel::HIGH);
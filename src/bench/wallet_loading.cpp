@@ -52,7 +52,23 @@ static void AddTx(CWallet& wallet)
     wallet.AddToWallet(MakeTransactionRef(mtx), TxStateInactive{});
 }
 
-static void WalletLoading(benchmark::Bench& bench, bool legacy_wallet)
+/** Add a coinstake spending prevout, split in two as a staking wallet's are, and return its first stake output */
+static COutPoint AddStakeTx(CWallet& wallet, const COutPoint& prevout)
+{
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(prevout);
+    mtx.vout.emplace_back();
+    mtx.vout[0].SetEmpty();
+    for (int i = 0; i < 2; ++i) {
+        mtx.vout.push_back({COIN, GetScriptForDestination(*Assert(wallet.GetNewDestination(OutputType::BECH32, "")))});
+    }
+
+    const CTransactionRef tx{MakeTransactionRef(mtx)};
+    wallet.AddToWallet(tx, TxStateInactive{});
+    return {tx->GetHash(), 1};
+}
+
+static void WalletLoading(benchmark::Bench& bench, bool legacy_wallet, bool staking = false)
 {
     const auto test_setup = MakeNoLogFileContext<TestingSetup>();
     test_setup->m_args.ForceSetArg("-unsafesqlitesync", "1");
@@ -74,8 +90,16 @@ static void WalletLoading(benchmark::Bench& bench, bool legacy_wallet)
     auto wallet = BenchLoadWallet(std::move(database), context, options);
 
     // Generate a bunch of transactions and addresses to put into the wallet
-    for (int i = 0; i < 1000; ++i) {
-        AddTx(*wallet);
+    if (staking) {
+        // A long staking history: each coinstake spends an output of the one before
+        COutPoint stake{uint256::ONE, 0};
+        for (int i = 0; i < 10000; ++i) {
+            stake = AddStakeTx(*wallet, stake);
+        }
+    } else {
+        for (int i = 0; i < 1000; ++i) {
+            AddTx(*wallet);
+        }
     }
 
     database = DuplicateMockDatabase(wallet->GetDatabase(), options);
@@ -100,4 +124,6 @@ BENCHMARK(WalletLoadingLegacy, benchmark::PriorityLevel::HIGH);
 #ifdef USE_SQLITE
 static void WalletLoadingDescriptors(benchmark::Bench& bench) { WalletLoading(bench, /*legacy_wallet=*/false); }
 BENCHMARK(WalletLoadingDescriptors, benchmark::PriorityLevel::HIGH);
+static void WalletLoadingStaking(benchmark::Bench& bench) { WalletLoading(bench, /*legacy_wallet=*/false, /*staking=*/true); }
+BENCHMARK(WalletLoadingStaking, benchmark::PriorityLevel::HIGH);
 #endif
@@ -22,31 +22,177 @@
 #include <node/blockstorage.h>
 #include <node/caches.h>
 #include <node/chainstate.h>
+#include <pos/pos.h>
 #include <scheduler.h>
 #include <script/sigcache.h>
+#include <txdb.h>
+#include <util/strencodings.h>
 #include <util/system.h>
 #include <util/thread.h>
+#include <util/time.h>
 #include <validation.h>
 #include <validationinterface.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <filesystem>
 #include <functional>
+#include <iomanip>
 #include <iosfwd>
+#include <optional>
+#include <string>
+
+/** Blocks to replay, as given by -replay=<first>[:<last>] */
+struct ReplayRange {
+    int first{0};
+    std::optional<int> last;
+};
+
+static double Seconds(SteadyClock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+/**
+ * Disconnect the active chain back to the parent of range.first with the undo
+ * data, then time connecting it again up to range.last, which runs the same
+ * ConnectTip path as the node: contextual and proof-of-stake checks, scripts,
+ * the coins cache and its flushes. The coins cache is flushed and emptied
+ * before timing, so runs with the same options start alike. The blocks past
+ * range.last are held back with InvalidateBlock and connected again, untimed,
+ * once done, leaving the datadir at the tip it had.
+ */
+static bool ReplayBlocks(ChainstateManager& chainman, const ReplayRange& range)
+{
+    Chainstate& chainstate = WITH_LOCK(::cs_main, return chainman.ActiveChainstate());
+    CBlockIndex* first;
+    CBlockIndex* held_back;
+    int last;
+    uint64_t txs;
+    {
+        LOCK(::cs_main);
+        const CChain& chain = chainstate.m_chain;
+        last = range.last.value_or(chain.Height());
+        if (range.first < 1 || last < range.first || last > chain.Height()) {
+            std::cerr << "Replay range " << range.first << ":" << last << " is not within blocks 1 to " << chain.Height() << " of the active chain" << std::endl;
+            return false;
+        }
+        first = chain[range.first];
+        held_back = chain.Next(chain[last]);
+        txs = chain[last]->nChainTx - chain[range.first - 1]->nChainTx;
+    }
+    const int blocks{last - range.first + 1};
+
+    std::cout << "Disconnecting " << (WITH_LOCK(::cs_main, return chainstate.m_chain.Height()) - range.first + 1) << " blocks..." << std::endl;
+    BlockValidationState state;
+    if (!chainstate.InvalidateBlock(state, first)) {
+        std::cerr << "Failed to disconnect block " << range.first << " (" << state.ToString() << ")" << std::endl;
+        return false;
+    }
+    WITH_LOCK(::cs_main, chainstate.ResetBlockFailureFlags(first));
+    if (held_back && !chainstate.InvalidateBlock(state, held_back)) {
+        std::cerr << "Failed to hold back block " << last + 1 << " (" << state.ToString() << ")" << std::endl;
+        return false;
+    }
+    WITH_LOCK(::cs_main, chainstate.ForceFlushStateToDisk());
+
+    std::cout << "Replaying blocks " << range.first << " to " << last << "..." << std::endl;
+    const BlockConnectStats before{GetBlockConnectStats()};
+    const auto start{SteadyClock::now()};
+    const bool connected{chainstate.ActivateBestChain(state, nullptr)};
+    const auto connect_time{SteadyClock::now() - start};
+    const BlockConnectStats after{GetBlockConnectStats()};
+    const int height{WITH_LOCK(::cs_main, return chainstate.m_chain.Height())};
+    if (!connected || height != last) {
+        std::cerr << "Replay stopped at block " << height << " (" << state.ToString() << ")" << std::endl;
+        return false;
+    }
+    const auto flush_start{SteadyClock::now()};
+    WITH_LOCK(::cs_main, chainstate.ForceFlushStateToDisk());
+    const auto flush_time{SteadyClock::now() - flush_start};
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "Replayed " << blocks << " blocks, " << txs << " transactions in " << Seconds(connect_time) << "s" << std::endl
+              << "\t" << blocks / Seconds(connect_time) << " blocks/s, " << txs / Seconds(connect_time) << " tx/s" << std::endl
+              << "\t" << std::left << std::setw(14) << "Phase" << std::right << std::setw(12) << "Total (s)" << std::setw(16) << "Per block (ms)" << std::endl;
+    for (const auto& [phase, time] : {
+             std::pair{"load_block", after.load_block - before.load_block},
+             {"check", after.check - before.check},
+             {"forks", after.forks - before.forks},
+             {"connect", after.connect - before.connect},
+             {"verify", after.verify - before.verify},
+             {"undo", after.undo - before.undo},
+             {"index", after.index - before.index},
+             {"connect_total", after.connect_total - before.connect_total},
+             {"flush", after.flush - before.flush},
+             {"chainstate", after.chainstate - before.chainstate},
+             {"post_connect", after.post_connect - before.post_connect},
+             {"total", after.total - before.total},
+             {"final_flush", flush_time},
+         }) {
+        std::cout << "\t" << std::left << std::setw(14) << phase << std::right << std::setw(12) << Seconds(time)
+                  << std::setw(16) << Seconds(time) * 1000 / blocks << std::endl;
+    }
+    std::cout << "\t" << "Coins cache: " << after.coins_cache_count << " coins, " << (after.coins_cache_usage >> 20) << " MiB" << std::endl;
+
+    if (held_back) {
+        std::cout << "Reconnecting the blocks held back..." << std::endl;
+        WITH_LOCK(::cs_main, chainstate.ResetBlockFailureFlags(held_back));
+        if (!chainstate.ActivateBestChain(state, nullptr)) {
+            std::cerr << "Failed to reconnect the blocks held back (" << state.ToString() << ")" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
 
 int main(int argc, char* argv[])
 {
     // SETUP: Argument parsing and handling
-    if (argc != 2) {
+    std::optional<ReplayRange> replay;
+    int64_t dbcache{nDefaultDbCache};
+    int script_threads{DEFAULT_SCRIPTCHECK_THREADS};
+    std::optional<uint256> assumed_valid_block;
+    int arg{1};
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        const std::string option{argv[arg]};
+        const auto value{option.substr(option.find('=') + 1)};
+        bool valid{option.find('=') != std::string::npos};
+        if (option.rfind("-replay=", 0) == 0) {
+            const auto colon{value.find(':')};
+            replay.emplace();
+            valid = valid && ParseInt32(value.substr(0, colon), &replay->first);
+            if (colon != std::string::npos) valid = valid && ParseInt32(value.substr(colon + 1), &replay->last.emplace());
+        } else if (option.rfind("-dbcache=", 0) == 0) {
+            valid = valid && ParseInt64(value, &dbcache);
+        } else if (option.rfind("-par=", 0) == 0) {
+            valid = valid && ParseInt32(value, &script_threads);
+        } else if (option.rfind("-assumevalid=", 0) == 0) {
+            valid = valid && (value == "0" || IsHex(value));
+            assumed_valid_block = value == "0" ? uint256{} : uint256S(value);
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            std::cerr << "Invalid option " << option << std::endl;
+            return 1;
+        }
+    }
+    if (arg != argc - 1) {
         std::cerr
-            << "Usage: " << argv[0] << " DATADIR" << std::endl
+            << "Usage: " << argv[0] << " [options] DATADIR" << std::endl
             << "Display DATADIR information, and process hex-encoded blocks on standard input." << std::endl
             << std::endl
+            << "Options:" << std::endl
+            << "  -replay=<first>[:<last>]  Instead of reading blocks, disconnect the active chain back to block <first>" << std::endl
+            << "                            and time connecting it again up to <last> (default: the tip), by phase" << std::endl
+            << "  -dbcache=<n>              Database cache size in MiB (default: " << nDefaultDbCache << ")" << std::endl
+            << "  -par=<n>                  Script verification threads, as the option of lynxd (default: " << DEFAULT_SCRIPTCHECK_THREADS << ")" << std::endl
+            << "  -assumevalid=<hex>        Skip the scripts of this block and its ancestors, 0 to verify all (default: the chain's)" << std::endl
+            << std::endl
             << "IMPORTANT: THIS EXECUTABLE IS EXPERIMENTAL, FOR TESTING ONLY, AND EXPECTED TO" << std::endl
             << "           BREAK IN FUTURE VERSIONS. DO NOT USE ON YOUR ACTUAL DATADIR." << std::endl;
         return 1;
     }
-    std::filesystem::path abs_datadir = std::filesystem::absolute(argv[1]);
+    std::filesystem::path abs_datadir = std::filesystem::absolute(argv[arg]);
     std::filesystem::create_directories(abs_datadir);
     gArgs.ForceSetArg("-datadir", abs_datadir.string());
 
@@ -67,6 +213,7 @@ int main(int argc, char* argv[])
     kernel::ValidationCacheSizes validation_cache_sizes{};
     Assert(InitSignatureCache(validation_cache_sizes.signature_cache_bytes));
     Assert(InitScriptExecutionCache(validation_cache_sizes.script_execution_cache_bytes));
+    Assert(InitStakeKernelCache(DEFAULT_STAKE_KERNEL_CACHE_BYTES));
 
 
     // SETUP: Scheduling and Background Signals
@@ -79,19 +226,29 @@ int main(int argc, char* argv[])
 
     GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
 
+    // As lynxd does with -par, counting the thread connecting blocks
+    if (script_threads <= 0) script_threads += GetNumCores();
+    script_threads = std::min(std::max(script_threads - 1, 0), MAX_SCRIPTCHECK_THREADS);
+    if (script_threads >= 1) StartScriptCheckWorkerThreads(script_threads);
+
 
     // SETUP: Chainstate
     const ChainstateManager::Options chainman_opts{
         .chainparams = *chainparams,
         .datadir = gArgs.GetDataDirNet(),
         .adjusted_time_callback = NodeClock::now,
+        .assumed_valid_block = assumed_valid_block,
     };
     ChainstateManager chainman{chainman_opts, {}};
 
+    // As node::CalculateCacheSizes() does without indexes
+    int64_t total_cache{std::clamp(dbcache, nMinDbCache, nMaxDbCache) << 20};
     node::CacheSizes cache_sizes;
-    cache_sizes.block_tree_db = 2 << 20;
-    cache_sizes.coins_db = 2 << 22;
-    cache_sizes.coins = (450 << 20) - (2 << 20) - (2 << 22);
+    cache_sizes.block_tree_db = std::min(total_cache / 8, nMaxBlockDBCache << 20);
+    total_cache -= cache_sizes.block_tree_db;
+    cache_sizes.coins_db = std::min({total_cache / 2, (total_cache / 4) + (1 << 23), nMaxCoinsDBCache << 20});
+    total_cache -= cache_sizes.coins_db;
+    cache_sizes.coins = total_cache;
     node::ChainstateLoadOptions options;
     options.check_interrupt = [] { return false; };
     auto [status, error] = node::LoadChainstate(chainman, cache_sizes, options);
@@ -114,6 +271,11 @@ int main(int argc, char* argv[])
         }
     }
 
+    if (replay) {
+        ReplayBlocks(chainman, *replay);
+        goto epilogue;
+    }
+
     // Main program logic starts here
     std::cout
         << "Hello! I'm going to print out some information about your datadir." << std::endl
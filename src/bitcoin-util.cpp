@@ -13,10 +13,21 @@
 #include <clientversion.h>
 #include <compat/compat.h>
 #include <core_io.h>
+#include <key.h>
+#include <key_io.h>
+#include <opfile/src/encode.h>
+#include <opfile/src/protocol.h>
+#include <opfile/src/util.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <storage/worker.h>
 #include <streams.h>
+#include <univalue.h>
 #include <util/exception.h>
+#include <util/fs_helpers.h>
 #include <util/system.h>
 #include <util/translation.h>
+#include <util/tune.h>
 #include <version.h>
 
 #include <atomic>
@@ -34,8 +45,15 @@ static void SetupBitcoinUtilArgs(ArgsManager &argsman)
     SetupHelpOptions(argsman);
 
     argsman.AddArg("-version", "Print version and exit", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storagecompact", strprintf("Encode assets with the compact chunk protocol 02, for storagetx (default: %u)", DEFAULT_STORAGE_COMPACT), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storagecompress", strprintf("Encode assets compressed when that makes them smaller, with the compact chunk protocol only, for storagetx (default: %u)", DEFAULT_STORAGE_COMPRESS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storagecontenthash", strprintf("Encode assets with the sha256 of the file in their header, implies -storagecompact, for storagetx (default: %u)", DEFAULT_STORAGE_CONTENTHASH), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storageencrypt", strprintf("Encode assets encrypted with the tenant key, so only the tenant can read them, implies -storagecompact, for storagetx (default: %u)", DEFAULT_STORAGE_ENCRYPT), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 
     argsman.AddCommand("grind", "Perform proof of work on hex header string");
+    argsman.AddCommand("tune", "Probe the cores, memory and disk of the machine, and print config file settings tuned for them. Takes the data directory whose disk is probed, the default one if not given");
+    argsman.AddCommand("storagetx", "Encode a file for storage offline, signed by the tenant key given in WIF, and print its uuid and the unsigned transactions carrying its chunks. "
+                                    "Fund, sign and broadcast each in order with fundrawtransaction, signrawtransactionwithwallet and sendrawtransaction. Takes the file, the key and optionally the uuid to store the file under");
 
     SetupChainParamsBaseOptions(argsman);
 }
@@ -147,6 +165,76 @@ static int Grind(const std::vector<std::string>& args, std::string& strPrint)
     return EXIT_SUCCESS;
 }
 
+static int Tune(const std::vector<std::string>& args, std::string& strPrint)
+{
+    if (args.size() > 1) {
+        strPrint = "Takes at most the data directory";
+        return EXIT_FAILURE;
+    }
+
+    const fs::path datadir{args.empty() ? GetDefaultDataDir() : fs::PathFromString(args[0])};
+    const HardwareProfile hardware{ProbeHardware(datadir)};
+    strPrint = "# Performance settings tuned for " + HardwareSummary(hardware);
+    for (const auto& [name, value] : TunedSettings(hardware)) {
+        strPrint += "\n" + name + "=" + value;
+    }
+    return EXIT_SUCCESS;
+}
+
+static int StorageTx(const ArgsManager& argsman, const std::vector<std::string>& args, std::string& strPrint)
+{
+    if (args.size() < 2 || args.size() > 3) {
+        strPrint = "Must specify the file, the tenant key and optionally the uuid";
+        return EXIT_FAILURE;
+    }
+
+    const CKey key{DecodeSecret(args[1])};
+    if (!key.IsValid()) {
+        strPrint = "Invalid tenant key";
+        return EXIT_FAILURE;
+    }
+    // The uuid is chosen here rather than by the encoder, to print it
+    const std::string uuid{args.size() > 2 ? args[2] : generate_uuid(OPENCODING_UUID)};
+    if (uuid.size() != OPENCODING_UUID * 2 || !IsHex(uuid)) {
+        strPrint = "Invalid uuid, must be 64 hex characters";
+        return EXIT_FAILURE;
+    }
+
+    UniValue txs{UniValue::VARR};
+    const auto add_batch{[&](std::vector<std::vector<unsigned char>>& batch) {
+        // The payloads of a batch as the OP_RETURN outputs of one transaction, the wallet funding
+        // it adds the inputs and the change
+        CMutableTransaction tx;
+        tx.nVersion = CTransaction::CURRENT_VERSION;
+        for (const auto& payload : batch) {
+            tx.vout.emplace_back(0, CScript() << OP_RETURN << payload);
+        }
+        txs.push_back(EncodeHexTx(CTransaction{tx}));
+        return true;
+    }};
+
+    std::pair<std::string, std::string> putinfo{args[0], uuid};
+    int error_level{0}, total_chunks{0};
+    std::vector<unsigned char> signed_header;
+    const bool encrypt{argsman.GetBoolArg("-storageencrypt", DEFAULT_STORAGE_ENCRYPT)};
+    const bool content_hash{argsman.GetBoolArg("-storagecontenthash", DEFAULT_STORAGE_CONTENTHASH)};
+    // only the compact chunk protocol encrypts and carries the content hash
+    const bool compact{argsman.GetBoolArg("-storagecompact", encrypt || content_hash || DEFAULT_STORAGE_COMPACT)};
+    const bool compress{argsman.GetBoolArg("-storagecompress", DEFAULT_STORAGE_COMPRESS)};
+    const Span<const unsigned char> encrypt_secret{encrypt ? Span<const unsigned char>{key.begin(), key.size()} : Span<const unsigned char>{}};
+    if (!stream_chunks_with_headers(putinfo, key, error_level, total_chunks, add_batch, compact, compress, content_hash, encrypt_secret, signed_header)) {
+        strPrint = strprintf("Could not encode %s (error %d)", args[0], error_level);
+        return EXIT_FAILURE;
+    }
+
+    UniValue result{UniValue::VOBJ};
+    result.pushKV("uuid", uuid);
+    result.pushKV("chunks", total_chunks);
+    result.pushKV("transactions", txs);
+    strPrint = result.write(2);
+    return EXIT_SUCCESS;
+}
+
 MAIN_FUNCTION
 {
     ArgsManager& args = gArgs;
@@ -176,6 +264,13 @@ MAIN_FUNCTION
     try {
         if (cmd->command == "grind") {
             ret = Grind(cmd->args, strPrint);
+        } else if (cmd->command == "tune") {
+            ret = Tune(cmd->args, strPrint);
+        } else if (cmd->command == "storagetx") {
+            // Signing the header chunk needs the elliptic curve context
+            ECC_Start();
+            ret = StorageTx(args, cmd->args, strPrint);
+            ECC_Stop();
         } else {
             assert(false); // unknown command should be caught earlier
         }
@@ -9,22 +9,59 @@
 #include <crypto/sha256.h>
 #include <crypto/siphash.h>
 #include <random.h>
+#include <script/script.h>
 #include <streams.h>
 #include <txmempool.h>
 #include <validation.h>
 #include <util/system.h>
 
+#include <algorithm>
 #include <unordered_map>
 
-CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block) :
-        nonce(GetRand<uint64_t>()),
-        shorttxids(block.vtx.size() - 1), prefilledtxn(1), header(block), vchBlockSig(block.vchBlockSig) {
+//! Bytes of the OP_RETURN outputs of a transaction, which storage chunks are uploaded in
+static size_t NullDataBytes(const CTransaction& tx)
+{
+    size_t bytes{0};
+    for (const CTxOut& txout : tx.vout) {
+        if (!txout.scriptPubKey.empty() && txout.scriptPubKey[0] == OP_RETURN) bytes += txout.scriptPubKey.size();
+    }
+    return bytes;
+}
+
+CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, size_t prefill_bytes, const std::function<bool(const CTransaction&)>& is_likely_missing) :
+        nonce(GetRand<uint64_t>()), header(block), vchBlockSig(block.vchBlockSig) {
     FillShortTxIDSelector();
-    //TODO: Use our mempool prior to block acceptance to predictively fill more than just the coinbase
-    prefilledtxn[0] = {0, block.vtx[0]};
-    for (size_t i = 1; i < block.vtx.size(); i++) {
-        const CTransaction& tx = *block.vtx[i];
-        shorttxids[i - 1] = GetShortID(tx.GetWitnessHash());
+
+    // Pick the transactions to prefill, storage transactions first as they are both
+    // the costliest to request and the likeliest to have been evicted from mempools
+    std::vector<bool> prefill(block.vtx.size());
+    prefill[0] = true;
+    if (prefill_bytes > 0) {
+        std::vector<std::pair<size_t, size_t>> candidates;
+        for (size_t i = 1; i < block.vtx.size(); i++) {
+            const size_t nulldata_bytes{NullDataBytes(*block.vtx[i])};
+            if (nulldata_bytes > 0 || (is_likely_missing && is_likely_missing(*block.vtx[i]))) {
+                candidates.emplace_back(nulldata_bytes, i);
+            }
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (const auto& [nulldata_bytes, i] : candidates) {
+            const size_t tx_size{block.vtx[i]->GetTotalSize()};
+            if (tx_size > prefill_bytes) continue;
+            prefill_bytes -= tx_size;
+            prefill[i] = true;
+        }
+    }
+
+    // Prefilled transactions are stored by their distance from the previous one
+    size_t next_index{0};
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        if (prefill[i]) {
+            prefilledtxn.push_back({static_cast<uint16_t>(i - next_index), block.vtx[i]});
+            next_index = i + 1;
+        } else {
+            shorttxids.push_back(GetShortID(block.vtx[i]->GetWitnessHash()));
+        }
     }
 }
 
@@ -104,11 +141,25 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
     if (shorttxids.size() != cmpctblock.shorttxids.size())
         return READ_STATUS_FAILED; // Short ID collision
 
+    // Each compact block brings its own SipHash key, so the short IDs of the mempool
+    // are computed again for every one and can not be kept. What can be avoided is
+    // probing the map for each of them: most mempool transactions are not in the
+    // block, and a bitmap of about 16 bits per short ID of the block turns away all
+    // but a few percent of them with a single lookup in a bitmap that stays in cache.
+    size_t filter_bits{64};
+    while (filter_bits < cmpctblock.shorttxids.size() * 16) filter_bits <<= 1;
+    const uint64_t filter_mask{filter_bits - 1};
+    std::vector<bool> filter(filter_bits);
+    for (const uint64_t shortid : cmpctblock.shorttxids) {
+        filter[shortid & filter_mask] = true;
+    }
+
     std::vector<bool> have_txn(txn_available.size());
     {
     LOCK(pool->cs);
     for (size_t i = 0; i < pool->vTxHashes.size(); i++) {
         uint64_t shortid = cmpctblock.GetShortID(pool->vTxHashes[i].first);
+        if (!filter[shortid & filter_mask]) continue;
         std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
         if (idit != shorttxids.end()) {
             if (!have_txn[idit->second]) {
@@ -204,7 +255,9 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<
         return READ_STATUS_INVALID;
 
     BlockValidationState state;
-    CheckBlockFn check_block = m_check_block_mock ? m_check_block_mock : CheckBlock;
+    CheckBlockFn check_block = m_check_block_mock ? m_check_block_mock : [](const CBlock& block, BlockValidationState& state, const Consensus::Params& params, bool check_pow, bool check_merkle_root) {
+        return CheckBlock(block, state, params, check_pow, check_merkle_root);
+    };
     if (!check_block(block, state, Params().GetConsensus(), /*fCheckPoW=*/true, /*fCheckMerkleRoot=*/true)) {
         // TODO: We really want to just check merkle tree manually here,
         // but that is expensive, and CheckBlock caches a block's
@@ -110,7 +110,13 @@ public:
     // Dummy for deserialization
     CBlockHeaderAndShortTxIDs() {}
 
-    CBlockHeaderAndShortTxIDs(const CBlock& block);
+    /**
+     * Besides the coinbase, prefill up to prefill_bytes of the transactions peers are
+     * likely missing: those carrying OP_RETURN data (storage chunks), which mempools
+     * evict unevenly, and those is_likely_missing picks out. The ones carrying the
+     * most data go first.
+     */
+    explicit CBlockHeaderAndShortTxIDs(const CBlock& block, size_t prefill_bytes = 0, const std::function<bool(const CTransaction&)>& is_likely_missing = {});
 
     uint64_t GetShortID(const uint256& txhash) const;
 
@@ -89,6 +89,8 @@ constexpr uint32_t BASIC_FILTER_M = 784931;
 enum class BlockFilterType : uint8_t
 {
     BASIC = 0,
+    //! Lynx storage filter, over the uuids and tenants of the assets a block stores
+    STORAGE = 1,
     INVALID = 255,
 };
 
@@ -128,6 +130,9 @@ public:
     //! Construct a new BlockFilter of the specified type from a block.
     BlockFilter(BlockFilterType filter_type, const CBlock& block, const CBlockUndo& block_undo);
 
+    //! Construct a new BlockFilter of the specified type over elements gathered by the caller.
+    BlockFilter(BlockFilterType filter_type, const uint256& block_hash, const GCSFilter::ElementSet& elements);
+
     BlockFilterType GetFilterType() const { return m_filter_type; }
     const uint256& GetBlockHash() const LIFETIMEBOUND { return m_block_hash; }
     const GCSFilter& GetFilter() const LIFETIMEBOUND { return m_filter; }
@@ -2,68 +2,153 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
-#include <chainparams.h>
+#include <blocktime.h>
+
+#include <chain.h>
 #include <logging.h>
-#include <validation.h>
+#include <tinyformat.h>
+#include <util/time.h>
+#include <util/trace.h>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+std::string BlockTimeWindowName(BlockTimeWindow window)
+{
+    switch (window) {
+    case BlockTimeWindow::HOUR: return "hour";
+    case BlockTimeWindow::DAY: return "day";
+    case BlockTimeWindow::WEEK: return "week";
+    case BlockTimeWindow::FORTNIGHT: return "fortnight";
+    case BlockTimeWindow::MONTH: return "month";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+int64_t BlockTimeWindowSpan(BlockTimeWindow window)
+{
+    switch (window) {
+    case BlockTimeWindow::HOUR: return 60 * 60;
+    case BlockTimeWindow::DAY: return 24 * 60 * 60;
+    case BlockTimeWindow::WEEK: return 7 * 24 * 60 * 60;
+    case BlockTimeWindow::FORTNIGHT: return 14 * 24 * 60 * 60;
+    case BlockTimeWindow::MONTH: return 28 * 24 * 60 * 60;
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
 
-bool CalculateAverageBlocktime(CBlockIndex* pindex, uint32_t timeSpan, uint32_t& blocks, double& calcAverage)
+void BlockTimeStats::SetTip(const CBlockIndex* pindex)
 {
-    blocks = 0;
-    uint32_t gapAverage = 0;
-    uint32_t nowTime = pindex->nTime;
-    uint32_t beginTime = pindex->nTime;
-
-    while (pindex && ((beginTime - nowTime) / 60) < timeSpan) {
-        blocks += 1;
-        pindex = pindex->pprev;
-        if (!pindex) return false;
-        gapAverage = gapAverage + (nowTime - pindex->nTime);
-        nowTime = pindex->nTime;
+    LOCK(m_mutex);
+    if (!m_blocks.empty() && pindex->pprev == m_blocks.back()) {
+        m_blocks.push_back(pindex);
+    } else if (m_blocks.size() >= 2 && m_blocks[m_blocks.size() - 2] == pindex) {
+        m_blocks.pop_back();
+    } else {
+        m_blocks.assign(1, pindex);
+        m_first.fill(0);
     }
+    Adjust();
+}
 
-    calcAverage = (double)gapAverage / blocks;
-    return pindex->nHeight >= blocks;
+void BlockTimeStats::Clear()
+{
+    LOCK(m_mutex);
+    m_blocks.clear();
+    m_first.fill(0);
 }
 
-void ShowAverageSpans(const CBlockIndex* pindex)
+void BlockTimeStats::Adjust()
 {
-    CBlockIndex* ppindex = (CBlockIndex*)pindex;
+    AssertLockHeld(m_mutex);
+    const int64_t tip_time = m_blocks.back()->GetBlockTime();
+    const size_t longest = (size_t)BlockTimeWindow::MONTH;
 
-    char stringHour[24], stringDay[24], stringWeek[24], stringBiweek[24], stringMonth[24];
-    uint32_t calcBlocksHour, calcBlocksDay, calcBlocksWeek, calcBlocksBiweek, calcBlocksMonth; 
-    double calcAverageHour, calcAverageDay, calcAverageWeek, calcAverageBiweek, calcAverageMonth;
+    while (true) {
+        // Windows only move by the blocks connected or disconnected since, bar reorders of block times
+        for (size_t w = 0; w < NUM_BLOCK_TIME_WINDOWS; ++w) {
+            const int64_t span = BlockTimeWindowSpan((BlockTimeWindow)w);
+            size_t& first = m_first[w];
+            first = std::min(first, m_blocks.size() - 1);
+            while (first + 1 < m_blocks.size() && tip_time - m_blocks[first]->GetBlockTime() >= span) {
+                ++first;
+            }
+            while (first > 0 && tip_time - m_blocks[first - 1]->GetBlockTime() < span) {
+                --first;
+            }
+        }
 
-    if (!CalculateAverageBlocktime(ppindex, 60, calcBlocksHour, calcAverageHour)) {
-        sprintf(stringHour, "n/a (n/a)");
-    } else {
-        sprintf(stringHour, "%.02fs (%d blk)", calcAverageHour, calcBlocksHour);
+        // Keep the block before the longest window, unless it reaches back to genesis
+        if (m_first[longest] > 0 || !m_blocks.front()->pprev) break;
+        m_blocks.push_front(m_blocks.front()->pprev);
+        for (size_t& first : m_first) {
+            ++first;
+        }
     }
 
-    if (!CalculateAverageBlocktime(ppindex, 1440, calcBlocksDay, calcAverageDay)) {
-        sprintf(stringDay, "n/a (n/a)");
-    } else {
-        sprintf(stringDay, "%.02fs (%d blk)", calcAverageDay, calcBlocksDay);
+    while (*std::min_element(m_first.begin(), m_first.end()) > 1) {
+        m_blocks.pop_front();
+        for (size_t& first : m_first) {
+            --first;
+        }
     }
+}
 
-    if (!CalculateAverageBlocktime(ppindex, 10080, calcBlocksWeek, calcAverageWeek)) {
-        sprintf(stringWeek, "n/a (n/a)");
-    } else {
-        sprintf(stringWeek, "%.02fs (%d blk)", calcAverageWeek, calcBlocksWeek);
-    }
+BlockTimeWindowStats BlockTimeStats::GetWindowStats(BlockTimeWindow window) const
+{
+    LOCK(m_mutex);
+    BlockTimeWindowStats stats;
+    if (m_blocks.empty()) return stats;
 
-    if (!CalculateAverageBlocktime(ppindex, 20160, calcBlocksBiweek, calcAverageBiweek)) {
-        sprintf(stringBiweek, "n/a (n/a)");
-    } else {
-        sprintf(stringBiweek, "%.02fs (%d blk)", calcAverageBiweek, calcBlocksBiweek);
-    }
+    const size_t first = m_first[(size_t)window];
+    stats.blocks = m_blocks.size() - first;
+    stats.complete = first > 0;
+    if (!stats.complete) return stats;
 
-    if (!CalculateAverageBlocktime(ppindex, 40320, calcBlocksMonth, calcAverageMonth)) {
-        sprintf(stringMonth, "n/a (n/a)");
-    } else {
-        sprintf(stringMonth, "%.02fs (%d blk)", calcAverageMonth, calcBlocksMonth);
+    stats.average = double(m_blocks.back()->GetBlockTime() - m_blocks[first - 1]->GetBlockTime()) / stats.blocks;
+
+    std::vector<int64_t> intervals;
+    intervals.reserve(stats.blocks);
+    for (size_t i = first; i < m_blocks.size(); ++i) {
+        intervals.push_back(m_blocks[i]->GetBlockTime() - m_blocks[i - 1]->GetBlockTime());
     }
+    auto percentile = [&](int p) {
+        auto nth = intervals.begin() + (intervals.size() - 1) * p / 100;
+        std::nth_element(intervals.begin(), nth, intervals.end());
+        return *nth;
+    };
+    stats.p10 = percentile(10);
+    stats.p50 = percentile(50);
+    stats.p90 = percentile(90);
+    return stats;
+}
+
+const CBlockIndex* BlockTimeStats::GetTip() const
+{
+    LOCK(m_mutex);
+    return m_blocks.empty() ? nullptr : m_blocks.back();
+}
 
-    LogPrintAlways(BCLog::NONE, "Block Statistics - last hour: %s, day: %s, week: %s, fortnight: %s, month: %s\n",
-        stringHour, stringDay, stringWeek, stringBiweek, stringMonth);
+void ShowAverageSpans(const BlockTimeStats& stats)
+{
+    const auto start{SteadyClock::now()};
+    std::string spans;
+    int complete{0};
+    for (size_t w = 0; w < NUM_BLOCK_TIME_WINDOWS; ++w) {
+        const BlockTimeWindow window = (BlockTimeWindow)w;
+        const BlockTimeWindowStats window_stats = stats.GetWindowStats(window);
+        spans += strprintf("%s%s: ", w == 0 ? "last " : ", ", BlockTimeWindowName(window));
+        if (!window_stats.complete) {
+            spans += "n/a (n/a)";
+        } else {
+            spans += strprintf("%.02fs (%d blk, median %ds)", window_stats.average, window_stats.blocks, window_stats.p50);
+            ++complete;
+        }
+    }
 
+    LogPrintAlways(BCLog::NONE, "Block Statistics - %s\n", spans);
+    TRACE2(validation, block_time_spans,
+        complete,
+        Ticks<std::chrono::microseconds>(SteadyClock::now() - start));
 }
@@ -0,0 +1,85 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKTIME_H
+#define BITCOIN_BLOCKTIME_H
+
+#include <sync.h>
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+class CBlockIndex;
+
+/** Rolling windows, ending at the tip, the block time statistics are kept for */
+enum class BlockTimeWindow {
+    HOUR,
+    DAY,
+    WEEK,
+    FORTNIGHT,
+    MONTH,
+};
+static constexpr size_t NUM_BLOCK_TIME_WINDOWS = 5;
+
+std::string BlockTimeWindowName(BlockTimeWindow window);
+//! Length of window in seconds
+int64_t BlockTimeWindowSpan(BlockTimeWindow window);
+
+/** Spacing of the blocks within one window */
+struct BlockTimeWindowStats {
+    //! Blocks within the window, each counted with the interval from its parent
+    uint32_t blocks{0};
+    //! False if the window reaches back to genesis, which leaves the rest undefined
+    bool complete{false};
+    //! Mean interval in seconds
+    double average{0};
+    //! Percentiles of the intervals in seconds
+    int64_t p10{0};
+    int64_t p50{0};
+    int64_t p90{0};
+};
+
+/**
+ * Block intervals over rolling windows ending at the tip
+ * Kept up to date in amortized O(1) per block connected or disconnected, instead
+ * of walking the chain back over every window each time they are shown.
+ * A window holds the blocks back from the tip whose time is less than its span
+ * before the tip's, and the blocks of the longest window are kept along with
+ * the block before them.
+ */
+class BlockTimeStats
+{
+public:
+    /**
+     * Move to the new tip
+     * Connecting or disconnecting one block is incremental, anything else rebuilds
+     * the windows by walking back from pindex
+     */
+    void SetTip(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    void Clear() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Statistics of one window, the percentiles taking time linear in its blocks */
+    BlockTimeWindowStats GetWindowStats(BlockTimeWindow window) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Tip the windows end at, nullptr before the first SetTip() */
+    const CBlockIndex* GetTip() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    /** Move the first block of each window, and the blocks kept, to the tip */
+    void Adjust() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    mutable Mutex m_mutex;
+    //! Blocks of the longest window and the block before them, oldest first
+    std::deque<const CBlockIndex*> m_blocks GUARDED_BY(m_mutex);
+    //! Index in m_blocks of the oldest block of each window
+    std::array<size_t, NUM_BLOCK_TIME_WINDOWS> m_first GUARDED_BY(m_mutex){};
+};
+
+/** Log the average block interval of each window */
+void ShowAverageSpans(const BlockTimeStats& stats);
+
+#endif // BITCOIN_BLOCKTIME_H
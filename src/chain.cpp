@@ -12,12 +12,66 @@ std::string CBlockFileInfo::ToString() const
     return strprintf("CBlockFileInfo(blocks=%u, size=%u, heights=%u...%u, time=%s...%s)", nBlocks, nSize, nHeightFirst, nHeightLast, FormatISO8601Date(nTimeFirst), FormatISO8601Date(nTimeLast));
 }
 
+void CChain::IndexHeight(int height)
+{
+    if ((m_hashes + 1) * 4 > m_hash_slots.size() * 3) {
+        std::vector<HashSlot> slots(std::max<size_t>(m_hash_slots.size() * 2, 16));
+        std::swap(slots, m_hash_slots);
+        for (const HashSlot& slot : slots) {
+            if (slot.height < 0) continue;
+            size_t i = slot.key & (m_hash_slots.size() - 1);
+            while (m_hash_slots[i].height >= 0) i = (i + 1) & (m_hash_slots.size() - 1);
+            m_hash_slots[i] = slot;
+        }
+    }
+    const uint32_t key{HashKey(vChain[height]->GetBlockHash())};
+    size_t i = key & (m_hash_slots.size() - 1);
+    while (m_hash_slots[i].height >= 0) i = (i + 1) & (m_hash_slots.size() - 1);
+    m_hash_slots[i] = HashSlot{key, height};
+    ++m_hashes;
+}
+
+void CChain::UnindexHeight(int height)
+{
+    const size_t mask{m_hash_slots.size() - 1};
+    size_t i = HashKey(vChain[height]->GetBlockHash()) & mask;
+    while (m_hash_slots[i].height != height) i = (i + 1) & mask;
+    // Shift back the slots after it that were probed past it, so lookups never stop short of them
+    for (size_t j = (i + 1) & mask; m_hash_slots[j].height >= 0; j = (j + 1) & mask) {
+        const size_t home{m_hash_slots[j].key & mask};
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            m_hash_slots[i] = m_hash_slots[j];
+            i = j;
+        }
+    }
+    m_hash_slots[i] = HashSlot{};
+    --m_hashes;
+}
+
+CBlockIndex* CChain::Find(const uint256& hash) const
+{
+    if (m_hash_slots.empty()) return nullptr;
+    const uint32_t key{HashKey(hash)};
+    const size_t mask{m_hash_slots.size() - 1};
+    for (size_t i = key & mask; m_hash_slots[i].height >= 0; i = (i + 1) & mask) {
+        if (m_hash_slots[i].key == key && vChain[m_hash_slots[i].height]->GetBlockHash() == hash) {
+            return vChain[m_hash_slots[i].height];
+        }
+    }
+    return nullptr;
+}
+
 void CChain::SetTip(CBlockIndex& block)
 {
     CBlockIndex* pindex = &block;
+    for (int height = Height(); height > pindex->nHeight; --height) {
+        UnindexHeight(height);
+    }
     vChain.resize(pindex->nHeight + 1);
     while (pindex && vChain[pindex->nHeight] != pindex) {
+        if (vChain[pindex->nHeight]) UnindexHeight(pindex->nHeight);
         vChain[pindex->nHeight] = pindex;
+        IndexHeight(pindex->nHeight);
         pindex = pindex->pprev;
     }
 }
@@ -48,7 +102,25 @@ CBlockLocator GetLocator(const CBlockIndex* index)
 
 CBlockLocator CChain::GetLocator() const
 {
-    return ::GetLocator(Tip());
+    return GetLocator(Tip());
+}
+
+CBlockLocator CChain::GetLocator(const CBlockIndex* index) const
+{
+    int step = 1;
+    std::vector<uint256> have;
+    if (index == nullptr) return CBlockLocator{std::move(have)};
+
+    have.reserve(32);
+    while (index) {
+        have.emplace_back(index->GetBlockHash());
+        if (index->nHeight == 0) break;
+        int height = std::max(index->nHeight - step, 0);
+        // Once in this chain, the ancestors of index are in it too
+        index = Contains(index) ? vChain[height] : index->GetAncestor(height);
+        if (have.size() > 10) step *= 2;
+    }
+    return CBlockLocator{std::move(have)};
 }
 
 const CBlockIndex *CChain::FindFork(const CBlockIndex *pindex) const {
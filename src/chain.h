@@ -8,6 +8,7 @@
 
 #include <arith_uint256.h>
 #include <consensus/params.h>
+#include <crypto/common.h>
 #include <flatfile.h>
 #include <kernel/cs_main.h>
 #include <primitives/block.h>
@@ -220,6 +221,14 @@ public:
     //! (memory only) Maximum nTime in the chain up to and including this block.
     unsigned int nTimeMax{0};
 
+    //! (memory only) The last proof-of-stake block up to and including this one,
+    //! see GetLastPoSBlockIndex(). Set when the block is indexed.
+    const CBlockIndex* pindexLastPoS{nullptr};
+
+    //! (memory only) nBits a proof-of-stake block on top of this one must have,
+    //! see GetNextWorkRequiredPoS(). 0 if not cached.
+    uint32_t nNextPoSBits{0};
+
     explicit CBlockIndex(const CBlockHeader& block)
         : nVersion{block.nVersion},
           hashMerkleRoot{block.hashMerkleRoot},
@@ -416,28 +425,120 @@ int64_t GetBlockProofEquivalentTime(const CBlockIndex& to, const CBlockIndex& fr
 const CBlockIndex* LastCommonAncestor(const CBlockIndex* pa, const CBlockIndex* pb);
 
 
-/** Used to marshal pointers into hashes for db storage. */
+/** Which fields a compact block index record stores, and which it leaves to the parent's record. */
+enum BlockIndexRecordFields : uint8_t {
+    RECORD_AMOUNTS = (1 << 0),        //!< nMint and nMoneySupply are stored
+    RECORD_STAKE_MODIFIER = (1 << 1), //!< nStakeModifier is stored
+    RECORD_PREVOUT_STAKE = (1 << 2),  //!< prevoutStake is stored
+    RECORD_HASH_PROOF = (1 << 3),     //!< hashProof is stored
+
+    //! nHeight is one above the parent's, and nTime is stored as its distance from the parent's
+    RECORD_PARENT_HEADER = (1 << 4),
+    RECORD_PARENT_VERSION = (1 << 5),        //!< nVersion is the parent's
+    RECORD_PARENT_BITS = (1 << 6),           //!< nBits is the parent's
+    RECORD_PARENT_STAKE_MODIFIER = (1 << 7), //!< nStakeModifier is computed from the parent's and prevoutStake
+
+    //! What the fields of a legacy record amount to
+    RECORD_LEGACY = RECORD_AMOUNTS | RECORD_STAKE_MODIFIER | RECORD_PREVOUT_STAKE | RECORD_HASH_PROOF,
+    RECORD_PARENT_MASK = RECORD_PARENT_HEADER | RECORD_PARENT_VERSION | RECORD_PARENT_BITS | RECORD_PARENT_STAKE_MODIFIER,
+};
+
+/**
+ * Used to marshal pointers into hashes for db storage.
+ *
+ * With -blockindexcompact, records are written in a compact form which leaves out null
+ * proof-of-stake fields and stores the header fields that follow from the parent's relative
+ * to it. Those are only known once the parent's record has been read as well, see
+ * CBlockTreeDB::LoadBlockIndexGuts(). Otherwise they are written in the legacy form, which
+ * stores every field and which versions before the compact one read as well.
+ */
 class CDiskBlockIndex : public CBlockIndex
 {
 public:
+    //! Written in place of the client version to tell compact records from legacy ones,
+    //! whose version is the client version that wrote them.
+    static constexpr int COMPACT_RECORD_VERSION{1000000};
+
     uint256 hashPrev;
+    uint8_t nRecordFields{RECORD_LEGACY};
+    //! With RECORD_PARENT_HEADER, nTime minus the parent's nTime
+    uint32_t nTimeFromParent{0};
 
     CDiskBlockIndex()
     {
         hashPrev = uint256();
     }
 
-    explicit CDiskBlockIndex(const CBlockIndex* pindex) : CBlockIndex(*pindex)
+    explicit CDiskBlockIndex(const CBlockIndex* pindex, bool compact = false, bool stake_modifier_from_parent = false) : CBlockIndex(*pindex)
     {
         hashPrev = (pprev ? pprev->GetBlockHash() : uint256());
+        if (!compact) return;
+
+        nRecordFields = 0;
+        if (nMint != 0 || nMoneySupply != 0) nRecordFields |= RECORD_AMOUNTS;
+        if (!prevoutStake.IsNull()) nRecordFields |= RECORD_PREVOUT_STAKE;
+        if (!hashProof.IsNull()) nRecordFields |= RECORD_HASH_PROOF;
+        if (stake_modifier_from_parent) {
+            nRecordFields |= RECORD_PARENT_STAKE_MODIFIER;
+        } else if (!nStakeModifier.IsNull()) {
+            nRecordFields |= RECORD_STAKE_MODIFIER;
+        }
+        if (pprev) {
+            nRecordFields |= RECORD_PARENT_HEADER;
+            nTimeFromParent = nTime - pprev->nTime;
+            if (nVersion == pprev->nVersion) nRecordFields |= RECORD_PARENT_VERSION;
+            if (nBits == pprev->nBits) nRecordFields |= RECORD_PARENT_BITS;
+        }
     }
 
     SERIALIZE_METHODS(CDiskBlockIndex, obj)
     {
         LOCK(::cs_main);
         int _nVersion = s.GetVersion();
-        if (!(s.GetType() & SER_GETHASH)) READWRITE(VARINT_MODE(_nVersion, VarIntMode::NONNEGATIVE_SIGNED));
+        if (!(s.GetType() & SER_GETHASH)) {
+            // A record storing every field is written in the legacy form
+            SER_WRITE(obj, _nVersion = obj.nRecordFields == RECORD_LEGACY ? _nVersion : COMPACT_RECORD_VERSION);
+            READWRITE(VARINT_MODE(_nVersion, VarIntMode::NONNEGATIVE_SIGNED));
+        }
+        if (_nVersion < COMPACT_RECORD_VERSION) {
+            SER_READ(obj, obj.nRecordFields = RECORD_LEGACY);
+            SerializeLegacy(s, obj, ser_action);
+            return;
+        }
+
+        READWRITE(VARINT(obj.nStatus));
+        READWRITE(VARINT(obj.nTx));
+        if (obj.nStatus & (BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO)) READWRITE(VARINT_MODE(obj.nFile, VarIntMode::NONNEGATIVE_SIGNED));
+        if (obj.nStatus & BLOCK_HAVE_DATA) READWRITE(VARINT(obj.nDataPos));
+        if (obj.nStatus & BLOCK_HAVE_UNDO) READWRITE(VARINT(obj.nUndoPos));
+
+        READWRITE(obj.nRecordFields);
+        if (obj.nRecordFields & RECORD_AMOUNTS) READWRITE(obj.nMint, obj.nMoneySupply);
+        if (obj.nRecordFields & RECORD_STAKE_MODIFIER) READWRITE(obj.nStakeModifier);
+        if (obj.nRecordFields & RECORD_PREVOUT_STAKE) READWRITE(obj.prevoutStake);
+        if (obj.nRecordFields & RECORD_HASH_PROOF) READWRITE(obj.hashProof);
+
+        // block header
+        if (!(obj.nRecordFields & RECORD_PARENT_VERSION)) READWRITE(obj.nVersion);
+        READWRITE(obj.hashPrev);
+        READWRITE(obj.hashMerkleRoot);
+        if (obj.nRecordFields & RECORD_PARENT_HEADER) {
+            // Zigzag the distance so that blocks timestamped before their parent stay short
+            uint32_t time_zigzag{0};
+            SER_WRITE(obj, time_zigzag = (obj.nTimeFromParent << 1) ^ (obj.nTimeFromParent >> 31 ? 0xffffffff : 0));
+            READWRITE(VARINT(time_zigzag));
+            SER_READ(obj, obj.nTimeFromParent = (time_zigzag >> 1) ^ (time_zigzag & 1 ? 0xffffffff : 0));
+        } else {
+            READWRITE(VARINT_MODE(obj.nHeight, VarIntMode::NONNEGATIVE_SIGNED));
+            READWRITE(obj.nTime);
+        }
+        if (!(obj.nRecordFields & RECORD_PARENT_BITS)) READWRITE(obj.nBits);
+        READWRITE(obj.nNonce);
+    }
 
+    template <typename Stream, typename Type, typename Operation>
+    static void SerializeLegacy(Stream& s, Type& obj, Operation ser_action) EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
+    {
         READWRITE(VARINT_MODE(obj.nHeight, VarIntMode::NONNEGATIVE_SIGNED));
         READWRITE(VARINT(obj.nStatus));
         READWRITE(VARINT(obj.nTx));
@@ -460,6 +561,9 @@ public:
         READWRITE(obj.nNonce);
     }
 
+    //! Whether fields are left to the parent's record
+    bool HasParentFields() const { return nRecordFields & RECORD_PARENT_MASK; }
+
     uint256 ConstructBlockHash() const
     {
         CBlockHeader block;
@@ -482,6 +586,19 @@ class CChain
 private:
     std::vector<CBlockIndex*> vChain;
 
+    /** A slot of the hash index of vChain: the first bytes of a block hash and the height of the block, -1 if empty */
+    struct HashSlot {
+        uint32_t key{0};
+        int32_t height{-1};
+    };
+    //! Open addressing, linear probing index of vChain by block hash, a power of two slots kept at most 3/4 full
+    std::vector<HashSlot> m_hash_slots;
+    size_t m_hashes{0};
+
+    static uint32_t HashKey(const uint256& hash) { return ReadLE32(hash.begin()); }
+    void IndexHeight(int height);
+    void UnindexHeight(int height);
+
 public:
     CChain() = default;
     CChain(const CChain&) = delete;
@@ -507,6 +624,9 @@ public:
         return vChain[nHeight];
     }
 
+    /** Returns the index entry of the block with hash in this chain, or nullptr if it is not in it. */
+    CBlockIndex* Find(const uint256& hash) const;
+
     /** Efficiently check whether a block is present in this chain. */
     bool Contains(const CBlockIndex* pindex) const
     {
@@ -528,12 +648,18 @@ public:
         return int(vChain.size()) - 1;
     }
 
-    /** Set/initialize a chain with a given tip. */
+    /** Set/initialize a chain with a given tip. The blocks in it must have their hash set. */
     void SetTip(CBlockIndex& block);
 
     /** Return a CBlockLocator that refers to the tip in of this chain. */
     CBlockLocator GetLocator() const;
 
+    /**
+     * Return a CBlockLocator that refers to index, as ::GetLocator() does. The
+     * entries in this chain are read from it rather than found in the skip list.
+     */
+    CBlockLocator GetLocator(const CBlockIndex* index) const;
+
     /** Find the last common block between this chain and a block index entry. */
     const CBlockIndex* FindFork(const CBlockIndex* pindex) const;
 
@@ -33,6 +33,13 @@ void ReadRegTestArgs(const ArgsManager& args, CChainParams::RegTestOptions& opti
 {
     if (auto value = args.GetBoolArg("-fastprune")) options.fastprune = *value;
 
+    if (auto value = args.GetArg("-regtestauthuser")) {
+        if (value->size() != 40 || !IsHex(*value)) {
+            throw std::runtime_error(strprintf("Invalid hash160 (%s) for -regtestauthuser.", *value));
+        }
+        options.init_auth_user = uint160S(*value);
+    }
+
     for (const std::string& arg : args.GetArgs("-testactivationheight")) {
         const auto found{arg.find('@')};
         if (found == std::string::npos) {
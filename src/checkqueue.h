@@ -9,9 +9,14 @@
 #include <tinyformat.h>
 #include <util/syscall_sandbox.h>
 #include <util/threadnames.h>
+#include <util/time.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <iterator>
+#include <memory>
 #include <vector>
 
 template <typename T>
@@ -26,11 +31,27 @@ class CCheckQueueControl;
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Each worker has a queue of its own, which Add spreads the checks over, so
+  * the workers take their batches without contending for one lock. A worker
+  * out of checks steals from the others. Batches are sized to the measured
+  * cost of a check, and Add wakes only as many workers as it has batches for,
+  * so a block of a few checks does not wake every thread.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
+    //! Checks queued for one worker, guarded by a lock of their own
+    struct WorkerQueue {
+        Mutex m_mutex;
+        std::deque<T> m_checks GUARDED_BY(m_mutex);
+    };
+
+    //! Run time aimed at for a batch: long enough to make taking it cheap,
+    //! short enough for the workers to finish about together
+    static constexpr int64_t BATCH_TARGET_NANOS{1'000'000};
+
     //! Mutex to protect the inner state
     Mutex m_mutex;
 
@@ -40,25 +61,33 @@ private:
     //! Master thread blocks on this when out of work
     std::condition_variable m_master_cv;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue GUARDED_BY(m_mutex);
+    //! The queues of the master, first, and the workers. As the order of
+    //! booleans doesn't matter, each is used as a LIFO (stack) by its owner,
+    //! and stolen from at the other end.
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
 
-    //! The number of workers (including the master) that are idle.
-    int nIdle GUARDED_BY(m_mutex){0};
+    //! Checks in the queues. Added to under m_mutex, so a worker waiting for
+    //! checks misses none
+    std::atomic<int> m_queued{0};
 
-    //! The total number of workers (including the master).
-    int nTotal GUARDED_BY(m_mutex){0};
+    //! The number of worker threads (not the master) that are idle.
+    int nIdle GUARDED_BY(m_mutex){0};
 
     //! The temporary evaluation result.
-    bool fAllOk GUARDED_BY(m_mutex){true};
+    std::atomic<bool> m_all_ok{true};
 
     /**
      * Number of verifications that haven't completed yet.
      * This includes elements that are no longer queued, but still in the
      * worker's own batches.
      */
-    unsigned int nTodo GUARDED_BY(m_mutex){0};
+    std::atomic<int> m_todo{0};
+
+    //! Moving average of the run time of a check, 0 until one is measured
+    std::atomic<int64_t> m_check_nanos{0};
+
+    //! The queue of the worker Add starts spreading checks from next
+    size_t m_next_queue GUARDED_BY(m_mutex){0};
 
     //! The maximum number of elements to be processed in one batch
     const unsigned int nBatchSize;
@@ -66,63 +95,86 @@ private:
     std::vector<std::thread> m_worker_threads;
     bool m_request_stop GUARDED_BY(m_mutex){false};
 
+    //! Checks run in BATCH_TARGET_NANOS at the measured cost, at most nBatchSize
+    unsigned int CostBatchSize() const
+    {
+        const int64_t cost{m_check_nanos.load(std::memory_order_relaxed)};
+        return cost > 0 ? std::clamp<int64_t>(BATCH_TARGET_NANOS / cost, 1, nBatchSize) : nBatchSize;
+    }
+
+    //! Checks to take at once. Aim for increasingly smaller batches as the
+    //! queues drain, so all workers finish approximately simultaneously.
+    unsigned int BatchSize() const
+    {
+        const int share{m_queued.load(std::memory_order_relaxed) / int(m_queues.size() + 1)};
+        return std::max(1U, std::min(CostBatchSize(), (unsigned int)std::max(share, 0)));
+    }
+
+    //! Move up to max checks into checks from the queue of slot, from its
+    //! back, or else steal them from the front of another's
+    unsigned int Take(size_t slot, std::vector<T>& checks, unsigned int max) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        for (size_t i = 0; i < m_queues.size(); ++i) {
+            WorkerQueue& queue = *m_queues[(slot + i) % m_queues.size()];
+            LOCK(queue.m_mutex);
+            if (queue.m_checks.empty()) continue;
+            // Leave a worker stolen from half of its checks
+            const size_t size{i == 0 ? queue.m_checks.size() : (queue.m_checks.size() + 1) / 2};
+            const unsigned int n = std::min<size_t>(max, size);
+            const auto first = i == 0 ? queue.m_checks.end() - n : queue.m_checks.begin();
+            checks.assign(std::make_move_iterator(first), std::make_move_iterator(first + n));
+            queue.m_checks.erase(first, first + n);
+            m_queued -= n;
+            return n;
+        }
+        return 0;
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    bool Loop(size_t slot) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
+        const bool fMaster{slot == 0};
         std::condition_variable& cond = fMaster ? m_master_cv : m_worker_cv;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
         do {
-            {
+            const unsigned int nNow{Take(slot, vChecks, BatchSize())};
+            if (nNow == 0) {
                 WAIT_LOCK(m_mutex, lock);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        m_master_cv.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty() && !m_request_stop) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        fAllOk = true;
-                        // return the current status
-                        return fRet;
+                while (m_queued <= 0 && !m_request_stop) {
+                    if (fMaster && m_todo == 0) {
+                        // return the current status, and reset it for new work later
+                        return m_all_ok.exchange(true);
                     }
-                    nIdle++;
+                    if (!fMaster) nIdle++;
                     cond.wait(lock); // wait
-                    nIdle--;
+                    if (!fMaster) nIdle--;
                 }
                 if (m_request_stop) {
                     return false;
                 }
-
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                auto start_it = queue.end() - nNow;
-                vChecks.assign(std::make_move_iterator(start_it), std::make_move_iterator(queue.end()));
-                queue.erase(start_it, queue.end());
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                continue;
             }
+
+            // Check whether we need to do work at all
+            bool fOk = m_all_ok;
+            const auto start{SteadyClock::now()};
             // execute work
             for (T& check : vChecks)
                 if (fOk)
                     fOk = check();
+            if (fOk) {
+                const int64_t sample{std::chrono::duration_cast<std::chrono::nanoseconds>(SteadyClock::now() - start).count() / nNow};
+                const int64_t cost{m_check_nanos.load(std::memory_order_relaxed)};
+                m_check_nanos.store(cost > 0 ? cost + (sample - cost) / 8 : std::max<int64_t>(sample, 1), std::memory_order_relaxed);
+            }
+            // the checks are destroyed before they count as done
             vChecks.clear();
+            if (!fOk) m_all_ok = false;
+            if (m_todo.fetch_sub(nNow) == int(nNow) && !fMaster) {
+                // We processed the last element; inform the master it can exit and return the result
+                WITH_LOCK(m_mutex, m_master_cv.notify_one());
+            }
         } while (true);
     }
 
@@ -132,8 +184,9 @@ public:
 
     //! Create a new check queue
     explicit CCheckQueue(unsigned int nBatchSizeIn)
-        : nBatchSize(nBatchSizeIn)
+        : nBatchSize(std::max(1U, nBatchSizeIn))
     {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
     }
 
     //! Create a pool of new worker threads.
@@ -142,15 +195,20 @@ public:
         {
             LOCK(m_mutex);
             nIdle = 0;
-            nTotal = 0;
-            fAllOk = true;
+            m_next_queue = 0;
+            m_all_ok = true;
         }
         assert(m_worker_threads.empty());
+        // the master's queue, then one for each worker
+        m_queues.resize(1);
+        for (int n = 0; n < threads_num; ++n) {
+            m_queues.push_back(std::make_unique<WorkerQueue>());
+        }
         for (int n = 0; n < threads_num; ++n) {
             m_worker_threads.emplace_back([this, n]() {
                 util::ThreadRename(strprintf("scriptch.%i", n));
                 SetSyscallSandboxPolicy(SyscallSandboxPolicy::VALIDATION_SCRIPT_CHECK);
-                Loop(false /* worker thread */);
+                Loop(n + 1 /* worker thread */);
             });
         }
     }
@@ -158,7 +216,7 @@ public:
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        return Loop(true /* master thread */);
+        return Loop(0 /* master thread */);
     }
 
     //! Add a batch of checks to the queue
@@ -168,16 +226,33 @@ public:
             return;
         }
 
+        const unsigned int batch{CostBatchSize()};
+        const size_t batches{(vChecks.size() + batch - 1) / batch};
+        int wake;
         {
             LOCK(m_mutex);
-            queue.insert(queue.end(), std::make_move_iterator(vChecks.begin()), std::make_move_iterator(vChecks.end()));
-            nTodo += vChecks.size();
+            m_todo += vChecks.size();
+            // A part for each worker that is woken, in the queues of the
+            // workers, or the master's when there are none
+            const size_t workers{m_queues.size() - 1};
+            const size_t parts{workers ? std::min(batches, workers) : 1};
+            auto it = vChecks.begin();
+            for (size_t part = 0; part < parts; ++part) {
+                const auto last = it + (vChecks.end() - it) / (parts - part);
+                WorkerQueue& queue = *m_queues[workers ? 1 + m_next_queue++ % workers : 0];
+                LOCK(queue.m_mutex);
+                queue.m_checks.insert(queue.m_checks.end(), std::make_move_iterator(it), std::make_move_iterator(last));
+                it = last;
+            }
+            m_queued += vChecks.size();
+            wake = std::min<int>(parts, nIdle);
+            if (wake == nIdle) wake = -1;
         }
 
-        if (vChecks.size() == 1) {
-            m_worker_cv.notify_one();
-        } else {
+        if (wake < 0) {
             m_worker_cv.notify_all();
+        } else {
+            while (wake--) m_worker_cv.notify_one();
         }
     }
 
@@ -15,6 +15,7 @@ uint256 CCoinsView::GetBestBlock() const { return uint256(); }
 std::vector<uint256> CCoinsView::GetHeadBlocks() const { return std::vector<uint256>(); }
 bool CCoinsView::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase) { return false; }
 std::unique_ptr<CCoinsViewCursor> CCoinsView::Cursor() const { return nullptr; }
+std::vector<std::unique_ptr<CCoinsViewCursor>> CCoinsView::RangeCursors(size_t count) const { return {}; }
 
 bool CCoinsView::HaveCoin(const COutPoint &outpoint) const
 {
@@ -22,6 +23,19 @@ bool CCoinsView::HaveCoin(const COutPoint &outpoint) const
     return GetCoin(outpoint, coin);
 }
 
+size_t CCoinsView::GetCoins(const std::vector<COutPoint>& outpoints, std::vector<std::optional<Coin>>& coins, size_t workers) const
+{
+    coins.assign(outpoints.size(), std::nullopt);
+    size_t found{0};
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        Coin coin;
+        if (!GetCoin(outpoints[i], coin)) continue;
+        coins[i] = std::move(coin);
+        ++found;
+    }
+    return found;
+}
+
 CCoinsViewBacked::CCoinsViewBacked(CCoinsView *viewIn) : base(viewIn) { }
 bool CCoinsViewBacked::GetCoin(const COutPoint &outpoint, Coin &coin) const { return base->GetCoin(outpoint, coin); }
 bool CCoinsViewBacked::HaveCoin(const COutPoint &outpoint) const { return base->HaveCoin(outpoint); }
@@ -30,11 +44,12 @@ std::vector<uint256> CCoinsViewBacked::GetHeadBlocks() const { return base->GetH
 void CCoinsViewBacked::SetBackend(CCoinsView &viewIn) { base = &viewIn; }
 bool CCoinsViewBacked::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase) { return base->BatchWrite(mapCoins, hashBlock, erase); }
 std::unique_ptr<CCoinsViewCursor> CCoinsViewBacked::Cursor() const { return base->Cursor(); }
+std::vector<std::unique_ptr<CCoinsViewCursor>> CCoinsViewBacked::RangeCursors(size_t count) const { return base->RangeCursors(count); }
 size_t CCoinsViewBacked::EstimateSize() const { return base->EstimateSize(); }
 
 CCoinsViewCache::CCoinsViewCache(CCoinsView* baseIn, bool deterministic) :
     CCoinsViewBacked(baseIn), m_deterministic(deterministic),
-    cacheCoins(0, SaltedOutpointHasher(/*deterministic=*/deterministic))
+    cacheCoins{0, SaltedOutpointHasher{/*deterministic=*/deterministic}, CCoinsMap::key_equal{}, &m_cache_coins_memory_resource}
 {}
 
 size_t CCoinsViewCache::DynamicMemoryUsage() const {
@@ -67,6 +82,40 @@ bool CCoinsViewCache::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return false;
 }
 
+size_t CCoinsViewCache::GetCoins(const std::vector<COutPoint>& outpoints, std::vector<std::optional<Coin>>& coins, size_t workers) const {
+    coins.assign(outpoints.size(), std::nullopt);
+    size_t found{0};
+    // Look up the coins missing from the cache in the base all at once, and cache them as FetchCoin() would
+    std::vector<COutPoint> missing;
+    std::vector<size_t> missing_pos;
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        CCoinsMap::const_iterator it = cacheCoins.find(outpoints[i]);
+        if (it == cacheCoins.end()) {
+            missing.push_back(outpoints[i]);
+            missing_pos.push_back(i);
+        } else if (!it->second.coin.IsSpent()) {
+            coins[i] = it->second.coin;
+            ++found;
+        }
+    }
+    if (missing.empty()) return found;
+
+    std::vector<std::optional<Coin>> fetched;
+    base->GetCoins(missing, fetched, workers);
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (!fetched[i]) continue;
+        auto [it, inserted] = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(missing[i]), std::forward_as_tuple(std::move(*fetched[i])));
+        if (inserted) {
+            if (it->second.coin.IsSpent()) it->second.flags = CCoinsCacheEntry::FRESH;
+            cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+        }
+        if (it->second.coin.IsSpent()) continue;
+        coins[missing_pos[i]] = it->second.coin;
+        ++found;
+    }
+    return found;
+}
+
 void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possible_overwrite) {
     assert(!coin.IsSpent());
     if (coin.out.scriptPubKey.IsUnspendable()) return;
@@ -107,6 +156,15 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possi
            (bool)it->second.coin.IsCoinBase());
 }
 
+void CCoinsViewCache::AddFetchedCoin(const COutPoint& outpoint, Coin&& coin) {
+    if (cacheCoins.count(outpoint)) return;
+    CCoinsMap::iterator it = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(coin))).first;
+    if (it->second.coin.IsSpent()) {
+        it->second.flags = CCoinsCacheEntry::FRESH;
+    }
+    cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+}
+
 void CCoinsViewCache::EmplaceCoinInternalDANGER(COutPoint&& outpoint, Coin&& coin) {
     cachedCoinsUsage += coin.DynamicMemoryUsage();
     cacheCoins.emplace(
@@ -254,9 +312,13 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
 
 bool CCoinsViewCache::Flush() {
     bool fOk = base->BatchWrite(cacheCoins, hashBlock, /*erase=*/true);
-    if (fOk && !cacheCoins.empty()) {
-        /* BatchWrite must erase all cacheCoins elements when erase=true. */
-        throw std::logic_error("Not all cached coins were erased");
+    if (fOk) {
+        if (!cacheCoins.empty()) {
+            /* BatchWrite must erase all cacheCoins elements when erase=true. */
+            throw std::logic_error("Not all cached coins were erased");
+        }
+        // Hand the chunks of the pool back, which erasing the entries doesn't
+        ReallocateCache();
     }
     cachedCoinsUsage = 0;
     return fOk;
@@ -315,7 +377,9 @@ void CCoinsViewCache::ReallocateCache()
     // Cache should be empty when we're calling this.
     assert(cacheCoins.size() == 0);
     cacheCoins.~CCoinsMap();
-    ::new (&cacheCoins) CCoinsMap(0, SaltedOutpointHasher(/*deterministic=*/m_deterministic));
+    m_cache_coins_memory_resource.~CCoinsMapMemoryResource();
+    ::new (&m_cache_coins_memory_resource) CCoinsMapMemoryResource{};
+    ::new (&cacheCoins) CCoinsMap{0, SaltedOutpointHasher{/*deterministic=*/m_deterministic}, CCoinsMap::key_equal{}, &m_cache_coins_memory_resource};
 }
 
 void CCoinsViewCache::SanityCheck() const
@@ -364,3 +428,16 @@ bool CCoinsViewErrorCatcher::GetCoin(const COutPoint &outpoint, Coin &coin) cons
         std::abort();
     }
 }
+
+size_t CCoinsViewErrorCatcher::GetCoins(const std::vector<COutPoint>& outpoints, std::vector<std::optional<Coin>>& coins, size_t workers) const {
+    try {
+        return base->GetCoins(outpoints, coins, workers);
+    } catch(const std::runtime_error& e) {
+        for (const auto& f : m_err_callbacks) {
+            f();
+        }
+        LogPrintf("Error reading from database: %s\n", e.what());
+        // As in GetCoin(), a failed read can't be told apart from missing coins
+        std::abort();
+    }
+}
@@ -0,0 +1,159 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_COMPRESSEDHEADERS_H
+#define BITCOIN_COMPRESSEDHEADERS_H
+
+#include <primitives/block.h>
+#include <serialize.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <ios>
+#include <vector>
+
+/** Version of the "cheaders" encoding, sent in "sendcheaders" */
+static constexpr uint64_t COMPRESSED_HEADERS_VERSION{1};
+/** Most headers one "cheaders" message carries, MAX_HEADERS_RESULTS of a "headers" message */
+static constexpr uint64_t MAX_COMPRESSED_HEADERS{2000};
+
+/**
+ * The values of a header field seen last, most recent first, so a header
+ * refers to a value it repeats by its position instead of sending it again.
+ * Proof of stake and proof of work blocks alternate between two nBits, which
+ * two positions cover.
+ */
+template <typename T>
+class RecentValues
+{
+private:
+    std::array<T, 3> m_values{};
+    size_t m_size{0};
+
+public:
+    /** Position of the value plus one, 0 if it is not among the recent ones */
+    uint8_t Find(const T& value) const
+    {
+        for (size_t i = 0; i < m_size; ++i) {
+            if (m_values[i] == value) return i + 1;
+        }
+        return 0;
+    }
+
+    /** The value at a position Find() returned, moved to the front */
+    T Use(uint8_t index)
+    {
+        if (index == 0 || index > m_size) throw std::ios_base::failure("compressed header refers to an unknown value");
+        std::rotate(m_values.begin(), m_values.begin() + index - 1, m_values.begin() + index);
+        return m_values[0];
+    }
+
+    /** Put a value sent in full at the front, dropping the oldest */
+    void Add(const T& value)
+    {
+        m_size = std::min(m_size + 1, m_values.size());
+        std::rotate(m_values.begin(), m_values.begin() + m_size - 1, m_values.begin() + m_size);
+        m_values[0] = value;
+    }
+};
+
+/**
+ * Headers of consecutive blocks, as "cheaders" carries them instead of
+ * "headers", in about half the bytes.
+ *
+ * The first header is serialized in full. Each following one is:
+ * - a flags byte, whose bits 0-1 give the position of its nVersion among the
+ *   recent ones and bits 2-3 that of its nBits, 0 when the value follows;
+ * - nVersion and nBits, when not among the recent ones;
+ * - nTime as a zigzag VARINT of the difference from the previous nTime;
+ * - hashMerkleRoot and nNonce.
+ * hashPrevBlock is left out, as it is the hash of the header before.
+ */
+struct CompressedHeaders {
+    static constexpr uint8_t INDEX_MASK{0x03};
+    static constexpr int BITS_SHIFT{2};
+
+    std::vector<CBlockHeader> headers;
+
+    CompressedHeaders() = default;
+    explicit CompressedHeaders(std::vector<CBlockHeader> headers_in) : headers{std::move(headers_in)} {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        WriteCompactSize(s, headers.size());
+        if (headers.empty()) return;
+        s << headers[0];
+        RecentValues<int32_t> versions;
+        RecentValues<uint32_t> bits;
+        versions.Add(headers[0].nVersion);
+        bits.Add(headers[0].nBits);
+        for (size_t i = 1; i < headers.size(); ++i) {
+            const CBlockHeader& header{headers[i]};
+            const uint8_t version_index{versions.Find(header.nVersion)};
+            const uint8_t bits_index{bits.Find(header.nBits)};
+            s << uint8_t(version_index | (bits_index << BITS_SHIFT));
+            if (version_index) {
+                versions.Use(version_index);
+            } else {
+                s << header.nVersion;
+                versions.Add(header.nVersion);
+            }
+            if (bits_index) {
+                bits.Use(bits_index);
+            } else {
+                s << header.nBits;
+                bits.Add(header.nBits);
+            }
+            const int64_t delta{int64_t{header.nTime} - int64_t{headers[i - 1].nTime}};
+            WriteVarInt<Stream, VarIntMode::DEFAULT, uint64_t>(s, delta < 0 ? (uint64_t(-delta) << 1) - 1 : uint64_t(delta) << 1);
+            s << header.hashMerkleRoot << header.nNonce;
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        headers.clear();
+        const uint64_t count{ReadCompactSize(s)};
+        // Each header is hashed to link the next, so more than a message may hold is turned away first
+        if (count > MAX_COMPRESSED_HEADERS) throw std::ios_base::failure("too many compressed headers");
+        if (count == 0) return;
+        // Grown one header at a time, a count the message is too short for fails before taking the memory
+        headers.emplace_back();
+        s >> headers[0];
+        RecentValues<int32_t> versions;
+        RecentValues<uint32_t> bits;
+        versions.Add(headers[0].nVersion);
+        bits.Add(headers[0].nBits);
+        for (uint64_t i = 1; i < count; ++i) {
+            CBlockHeader header;
+            uint8_t flags;
+            s >> flags;
+            if (flags >> (2 * BITS_SHIFT)) throw std::ios_base::failure("compressed header has unknown flags");
+            if (const uint8_t version_index = flags & INDEX_MASK) {
+                header.nVersion = versions.Use(version_index);
+            } else {
+                s >> header.nVersion;
+                versions.Add(header.nVersion);
+            }
+            if (const uint8_t bits_index = (flags >> BITS_SHIFT) & INDEX_MASK) {
+                header.nBits = bits.Use(bits_index);
+            } else {
+                s >> header.nBits;
+                bits.Add(header.nBits);
+            }
+            const uint64_t zigzag{ReadVarInt<Stream, VarIntMode::DEFAULT, uint64_t>(s)};
+            if (zigzag >> 33) throw std::ios_base::failure("compressed header time out of range");
+            const int64_t delta{zigzag & 1 ? -int64_t(zigzag >> 1) - 1 : int64_t(zigzag >> 1)};
+            header.nTime = uint32_t(int64_t{headers.back().nTime} + delta);
+            s >> header.hashMerkleRoot >> header.nNonce;
+            header.hashPrevBlock = headers.back().GetHash();
+            headers.push_back(header);
+        }
+    }
+};
+
+#endif // BITCOIN_COMPRESSEDHEADERS_H
@@ -5,6 +5,8 @@
 #include <consensus/merkle.h>
 #include <hash.h>
 
+#include <algorithm>
+
 /*     WARNING! If you're reading this because you're learning about crypto
        and/or designing a new system that will use merkle trees, keep in mind
        that the following merkle tree algorithm has a serious flaw related to
@@ -62,8 +64,25 @@ uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated) {
 }
 
 
+/* Most blocks of a proof-of-stake chain hold only the coinbase and coinstake,
+   so their root of two leaves is hashed without allocating the vector the
+   general case works in. The same mutation is detected: both leaves equal. */
+static uint256 ComputeMerkleRootOfPair(const uint256& left, const uint256& right, bool* mutated)
+{
+    unsigned char pair[64];
+    std::copy(left.begin(), left.end(), pair);
+    std::copy(right.begin(), right.end(), pair + 32);
+    if (mutated) *mutated = left == right;
+    uint256 root;
+    SHA256D64(root.begin(), pair, 1);
+    return root;
+}
+
 uint256 BlockMerkleRoot(const CBlock& block, bool* mutated)
 {
+    if (block.vtx.size() == 2) {
+        return ComputeMerkleRootOfPair(block.vtx[0]->GetHash(), block.vtx[1]->GetHash(), mutated);
+    }
     std::vector<uint256> leaves;
     leaves.resize(block.vtx.size());
     for (size_t s = 0; s < block.vtx.size(); s++) {
@@ -74,6 +93,9 @@ uint256 BlockMerkleRoot(const CBlock& block, bool* mutated)
 
 uint256 BlockWitnessMerkleRoot(const CBlock& block, bool* mutated)
 {
+    if (block.vtx.size() == 2) {
+        return ComputeMerkleRootOfPair(uint256{}, block.vtx[1]->GetWitnessHash(), mutated);
+    }
     std::vector<uint256> leaves;
     leaves.resize(block.vtx.size());
     leaves[0].SetNull(); // The witness hash of the coinbase is 0.
@@ -8,9 +8,26 @@
 #include <crypto/common.h>
 #include <crypto/chacha20.h>
 
+#include <compat/cpuid.h>
+
 #include <algorithm>
+#include <assert.h>
 #include <string.h>
 
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+namespace chacha20_avx2
+{
+void Crypt_8way(const uint32_t* input, const unsigned char* m, unsigned char* c, size_t blocks);
+}
+#endif
+
+namespace {
+typedef void (*Crypt8WayFn)(const uint32_t* input, const unsigned char* m, unsigned char* c, size_t blocks);
+
+//! Eight blocks at once, when the CPU allows
+Crypt8WayFn Crypt8Way = nullptr;
+} // namespace
+
 constexpr static inline uint32_t rotl32(uint32_t v, int c) { return (v << c) | (v >> (32 - c)); }
 
 #define QUARTERROUND(a,b,c,d) \
@@ -64,6 +81,13 @@ inline void ChaCha20Aligned::Keystream64(unsigned char* c, size_t blocks)
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
+    if (Crypt8Way && blocks >= 8) {
+        const size_t wide = blocks & ~size_t{7};
+        Crypt8Way(input, nullptr, c, wide);
+        Seek64((uint64_t{input[8]} | (uint64_t{input[9]} << 32)) + wide);
+        c += wide * 64;
+        blocks -= wide;
+    }
     if (!blocks) return;
 
     j4 = input[0];
@@ -161,6 +185,14 @@ inline void ChaCha20Aligned::Crypt64(const unsigned char* m, unsigned char* c, s
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
+    if (Crypt8Way && blocks >= 8) {
+        const size_t wide = blocks & ~size_t{7};
+        Crypt8Way(input, m, c, wide);
+        Seek64((uint64_t{input[8]} | (uint64_t{input[9]} << 32)) + wide);
+        m += wide * 64;
+        c += wide * 64;
+        blocks -= wide;
+    }
     if (!blocks) return;
 
     j4 = input[0];
@@ -322,3 +354,68 @@ void ChaCha20::Crypt(const unsigned char* m, unsigned char* c, size_t bytes)
         m_bufleft = 64 - bytes;
     }
 }
+
+namespace {
+#if defined(USE_ASM) && defined(HAVE_GETCPUID) && defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+
+bool SelfTest()
+{
+    // Eleven blocks, eight at once and three after, against the first keystream block
+    // of each counter alone, with the counter crossing into its upper word
+    static const unsigned char key[32] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+                                          17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32};
+    const uint64_t start{0xFFFFFFFCULL};
+    unsigned char in[64 * 11], out[64 * 11], block[64];
+    for (size_t i = 0; i < sizeof(in); ++i) in[i] = i;
+
+    ChaCha20Aligned wide{key};
+    wide.SetIV(0x0102030405060708ULL);
+    wide.Seek64(start);
+    wide.Crypt64(in, out, 11);
+    for (int i = 0; i < 11; ++i) {
+        ChaCha20Aligned single{key};
+        single.SetIV(0x0102030405060708ULL);
+        single.Seek64(start + i);
+        // A single block never takes the eight-way path
+        single.Keystream64(block, 1);
+        for (int j = 0; j < 64; ++j) {
+            if (out[i * 64 + j] != (in[i * 64 + j] ^ block[j])) return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+std::string ChaCha20AutoDetect()
+{
+    std::string ret = "standard";
+    Crypt8Way = nullptr;
+#if defined(USE_ASM) && defined(HAVE_GETCPUID) && defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    const bool enabled_avx = have_xsave && have_avx && AVXEnabled();
+    GetCPUID(0, 0, eax, ebx, ecx, edx);
+    bool have_avx2 = false;
+    if (eax >= 7) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+    if (have_avx2 && enabled_avx) {
+        Crypt8Way = chacha20_avx2::Crypt_8way;
+        ret = "avx2(8way)";
+    }
+#endif
+
+    assert(SelfTest());
+    return ret;
+}
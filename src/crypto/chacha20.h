@@ -7,6 +7,7 @@
 
 #include <cstdlib>
 #include <stdint.h>
+#include <string>
 
 // classes for ChaCha20 256-bit stream cipher developed by Daniel J. Bernstein
 // https://cr.yp.to/chacha/chacha-20080128.pdf */
@@ -81,4 +82,9 @@ public:
     void Crypt(const unsigned char* input, unsigned char* output, size_t bytes);
 };
 
+/** Autodetect the best available ChaCha20 implementation, which runs of eight or more
+ *  blocks use. Returns the name of the implementation.
+ */
+std::string ChaCha20AutoDetect();
+
 #endif // BITCOIN_CRYPTO_CHACHA20_H
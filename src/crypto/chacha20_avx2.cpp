@@ -0,0 +1,84 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include <crypto/common.h>
+
+namespace chacha20_avx2 {
+namespace {
+
+__m256i inline K(uint32_t x) { return _mm256_set1_epi32(x); }
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+__m256i inline RotL(__m256i x, int n) { return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n)); }
+
+void inline __attribute__((always_inline)) QuarterRound(__m256i& a, __m256i& b, __m256i& c, __m256i& d)
+{
+    a = Add(a, b); d = RotL(Xor(d, a), 16);
+    c = Add(c, d); b = RotL(Xor(b, c), 12);
+    a = Add(a, b); d = RotL(Xor(d, a), 8);
+    c = Add(c, d); b = RotL(Xor(b, c), 7);
+}
+
+} // namespace
+
+/** ChaCha20 blocks of the key and nonce in input, eight at once, one per lane, from the
+ *  block counter in input[8..9] on. XORs them into m to c, or writes the keystream to c
+ *  when m is null. blocks is a multiple of 8; the caller advances the counter. */
+void Crypt_8way(const uint32_t* input, const unsigned char* m, unsigned char* c, size_t blocks)
+{
+    uint64_t pos{uint64_t{input[8]} | (uint64_t{input[9]} << 32)};
+    for (; blocks >= 8; blocks -= 8, pos += 8, c += 512) {
+        __m256i j[16];
+        j[0] = K(0x61707865);
+        j[1] = K(0x3320646e);
+        j[2] = K(0x79622d32);
+        j[3] = K(0x6b206574);
+        for (int i = 0; i < 8; ++i) {
+            j[4 + i] = K(input[i]);
+        }
+        j[12] = _mm256_set_epi32(pos + 7, pos + 6, pos + 5, pos + 4, pos + 3, pos + 2, pos + 1, pos);
+        j[13] = _mm256_set_epi32((pos + 7) >> 32, (pos + 6) >> 32, (pos + 5) >> 32, (pos + 4) >> 32,
+                                 (pos + 3) >> 32, (pos + 2) >> 32, (pos + 1) >> 32, pos >> 32);
+        j[14] = K(input[10]);
+        j[15] = K(input[11]);
+
+        __m256i x[16];
+        for (int i = 0; i < 16; ++i) {
+            x[i] = j[i];
+        }
+        for (int i = 0; i < 10; ++i) {
+            QuarterRound(x[0], x[4], x[8], x[12]);
+            QuarterRound(x[1], x[5], x[9], x[13]);
+            QuarterRound(x[2], x[6], x[10], x[14]);
+            QuarterRound(x[3], x[7], x[11], x[15]);
+            QuarterRound(x[0], x[5], x[10], x[15]);
+            QuarterRound(x[1], x[6], x[11], x[12]);
+            QuarterRound(x[2], x[7], x[8], x[13]);
+            QuarterRound(x[3], x[4], x[9], x[14]);
+        }
+
+        // Word w of block b is in lane b of x[w]
+        alignas(32) uint32_t words[16][8];
+        for (int i = 0; i < 16; ++i) {
+            _mm256_store_si256((__m256i*)words[i], Add(x[i], j[i]));
+        }
+        for (int b = 0; b < 8; ++b) {
+            for (int w = 0; w < 16; ++w) {
+                uint32_t word = words[w][b];
+                if (m) word ^= ReadLE32(m + b * 64 + w * 4);
+                WriteLE32(c + b * 64 + w * 4, word);
+            }
+        }
+        if (m) m += 512;
+    }
+}
+
+} // namespace chacha20_avx2
+
+#endif
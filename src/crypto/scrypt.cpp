@@ -29,10 +29,30 @@
 
 #include <crypto/scrypt.h>
 
+#include <compat/cpuid.h>
+#include <crypto/common.h>
+
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 
+#include <cassert>
+#include <memory>
+
+#if defined(USE_ASM) && defined(__SSE2__)
+namespace scrypt_sse2
+{
+void ROMix_4way(uint32_t* X, uint32_t* V);
+}
+#endif
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+namespace scrypt_avx2
+{
+void ROMix_8way(uint32_t* X, uint32_t* V);
+}
+#endif
+
 typedef struct SHA256_CTXContext {
     uint32_t total[2];
     uint32_t state[8];
@@ -507,3 +527,142 @@ void scrypt_1024_1_1_256(const CBlockHeader& input, char *output)
     memcpy(blockheader, &input, 80);
     scrypt_1024_1_1_256(blockheader, output);
 }
+
+namespace {
+
+/**
+ * Mixing of several inputs at once, X and V interleaved by word: word k of
+ * lane l is at X[k * lanes + l], and word k of block i at V[(i * 32 + k) * lanes + l]
+ */
+typedef void (*ROMixFn)(uint32_t* X, uint32_t* V);
+
+ROMixFn ROMix_4way = nullptr;
+ROMixFn ROMix_8way = nullptr;
+
+void ScryptLanes(const char *input, char *output, size_t lanes, ROMixFn romix, uint32_t *V)
+{
+	uint8_t B[SCRYPT_BATCH_MAX][128];
+	uint32_t X[32 * SCRYPT_BATCH_MAX];
+
+	for (size_t l = 0; l < lanes; l++) {
+		PBKDF2_SHA256((const uint8_t *)input + 80 * l, 80, (const uint8_t *)input + 80 * l, 80, 1, B[l], 128);
+		for (size_t k = 0; k < 32; k++)
+			X[k * lanes + l] = le32dec(&B[l][4 * k]);
+	}
+
+	romix(X, V);
+
+	for (size_t l = 0; l < lanes; l++) {
+		for (size_t k = 0; k < 32; k++)
+			le32enc(&B[l][4 * k], X[k * lanes + l]);
+		PBKDF2_SHA256((const uint8_t *)input + 80 * l, 80, B[l], 128, 1, (uint8_t *)output + 32 * l, 32);
+	}
+}
+
+/** Check that the multi-buffer implementations agree with the generic one. */
+bool SelfTest()
+{
+	char input[80 * SCRYPT_BATCH_MAX];
+	for (size_t i = 0; i < sizeof(input); i++)
+		input[i] = (char)(i * 7 + 3);
+
+	char expected[32 * SCRYPT_BATCH_MAX], output[32 * SCRYPT_BATCH_MAX];
+	for (size_t l = 0; l < SCRYPT_BATCH_MAX; l++)
+		scrypt_1024_1_1_256(input + 80 * l, expected + 32 * l);
+
+	std::unique_ptr<uint32_t[]> scratchpad(new uint32_t[32 * 1024 * SCRYPT_BATCH_MAX + 16]);
+	uint32_t *V = (uint32_t *)(((uintptr_t)scratchpad.get() + 63) & ~(uintptr_t)63);
+	if (ROMix_4way) {
+		ScryptLanes(input, output, 4, ROMix_4way, V);
+		if (memcmp(output, expected, 32 * 4) != 0) return false;
+	}
+	if (ROMix_8way) {
+		ScryptLanes(input, output, 8, ROMix_8way, V);
+		if (memcmp(output, expected, 32 * 8) != 0) return false;
+	}
+	return true;
+}
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+	uint32_t a, d;
+	__asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+	return (a & 6) == 6;
+}
+#endif
+
+} // namespace
+
+std::string ScryptAutoDetect()
+{
+	std::string ret = "generic";
+#if defined(USE_ASM) && defined(HAVE_GETCPUID)
+	bool have_sse2 = false;
+	bool have_xsave = false;
+	bool have_avx = false;
+	[[maybe_unused]] bool have_avx2 = false;
+	[[maybe_unused]] bool enabled_avx = false;
+
+	uint32_t eax, ebx, ecx, edx;
+	GetCPUID(1, 0, eax, ebx, ecx, edx);
+	have_sse2 = (edx >> 26) & 1;
+	have_xsave = (ecx >> 27) & 1;
+	have_avx = (ecx >> 28) & 1;
+	if (have_xsave && have_avx) {
+		enabled_avx = AVXEnabled();
+	}
+	GetCPUID(0, 0, eax, ebx, ecx, edx);
+	if (eax >= 7) {
+		GetCPUID(7, 0, eax, ebx, ecx, edx);
+		have_avx2 = (ebx >> 5) & 1;
+	}
+
+#if defined(__SSE2__)
+	if (have_sse2) {
+		ROMix_4way = scrypt_sse2::ROMix_4way;
+		ret = "sse2(4way)";
+	}
+#endif
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+	if (have_avx2 && have_avx && enabled_avx) {
+		ROMix_8way = scrypt_avx2::ROMix_8way;
+		ret += ",avx2(8way)";
+	}
+#endif
+#endif // defined(USE_ASM) && defined(HAVE_GETCPUID)
+
+	assert(SelfTest());
+	return ret;
+}
+
+void scrypt_1024_1_1_256_batch(const char *input, char *output, size_t count)
+{
+	if (ROMix_4way && count >= 4) {
+		// The interleaved scratchpad is too large for the stack, and is kept for the next batch
+		static thread_local std::unique_ptr<uint32_t[]> scratchpad;
+		if (!scratchpad) scratchpad.reset(new uint32_t[32 * 1024 * SCRYPT_BATCH_MAX + 16]);
+		uint32_t *V = (uint32_t *)(((uintptr_t)scratchpad.get() + 63) & ~(uintptr_t)63);
+		while (ROMix_8way && count >= 8) {
+			ScryptLanes(input, output, 8, ROMix_8way, V);
+			input += 80 * 8;
+			output += 32 * 8;
+			count -= 8;
+		}
+		while (count >= 4) {
+			ScryptLanes(input, output, 4, ROMix_4way, V);
+			input += 80 * 4;
+			output += 32 * 4;
+			count -= 4;
+		}
+	}
+
+	char scratchpad[SCRYPT_SCRATCHPAD_SIZE];
+	for (; count > 0; count--) {
+		scrypt_1024_1_1_256_sp(input, output, scratchpad);
+		input += 80;
+		output += 32;
+	}
+}
@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#include <string>
+
 class CBlockHeader;
 
 static const int SCRYPT_SCRATCHPAD_SIZE = 131072 + 63;
@@ -14,6 +16,19 @@ void scrypt_1024_1_1_256_sp_generic(const char *input, char *output, char *scrat
 
 #define scrypt_1024_1_1_256_sp(input, output, scratchpad) scrypt_1024_1_1_256_sp_generic((input), (output), (scratchpad))
 
+//! Most inputs scrypt_1024_1_1_256_batch() hashes at once
+static const size_t SCRYPT_BATCH_MAX = 8;
+
+/** Autodetect the best available multi-buffer scrypt implementation. Returns the name of it. */
+std::string ScryptAutoDetect();
+
+/**
+ * Compute scrypt_1024_1_1_256 of count 80 byte inputs laid out one after the other,
+ * writing count 32 byte hashes to output
+ * Up to SCRYPT_BATCH_MAX inputs are hashed at once with SIMD, where the CPU has it
+ */
+void scrypt_1024_1_1_256_batch(const char *input, char *output, size_t count);
+
 void
 PBKDF2_SHA256(const uint8_t *passwd, size_t passwdlen, const uint8_t *salt,
     size_t saltlen, uint64_t c, uint8_t *buf, size_t dkLen);
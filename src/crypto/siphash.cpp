@@ -4,6 +4,17 @@
 
 #include <crypto/siphash.h>
 
+#include <compat/cpuid.h>
+
+#include <cassert>
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+namespace siphash_avx2
+{
+void SipHashUint256_4way(uint64_t k0, uint64_t k1, const uint256* const* vals, const uint32_t* extras, uint64_t* out);
+}
+#endif
+
 #define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
 
 #define SIPROUND do { \
@@ -171,3 +182,97 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+
+namespace {
+
+typedef void (*SipHash4WayFn)(uint64_t k0, uint64_t k1, const uint256* const* vals, const uint32_t* extras, uint64_t* out);
+
+SipHash4WayFn SipHash4Way = nullptr;
+
+void SipHashBatch(uint64_t k0, uint64_t k1, Span<const uint256* const> vals, const uint32_t* extras, Span<uint64_t> out)
+{
+    assert(out.size() == vals.size());
+    size_t i = 0;
+    if (SipHash4Way) {
+        for (; i + 4 <= vals.size(); i += 4) {
+            SipHash4Way(k0, k1, vals.data() + i, extras ? extras + i : nullptr, out.data() + i);
+        }
+    }
+    for (; i < vals.size(); ++i) {
+        out[i] = extras ? SipHashUint256Extra(k0, k1, *vals[i], extras[i]) : SipHashUint256(k0, k1, *vals[i]);
+    }
+}
+
+#if defined(USE_ASM) && defined(HAVE_GETCPUID) && defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+
+bool SelfTest()
+{
+    // The batch of six, four at once and two after, must match hashing each
+    uint256 vals[6];
+    const uint256* ptrs[6];
+    uint32_t extras[6];
+    for (int i = 0; i < 6; ++i) {
+        for (int j = 0; j < 32; ++j) {
+            *(vals[i].begin() + j) = i * 32 + j;
+        }
+        ptrs[i] = &vals[i];
+        extras[i] = 0x01000000U * i + 7;
+    }
+    uint64_t out[6];
+    SipHashBatch(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL, ptrs, nullptr, out);
+    for (int i = 0; i < 6; ++i) {
+        if (out[i] != SipHashUint256(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL, vals[i])) return false;
+    }
+    SipHashBatch(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL, ptrs, extras, out);
+    for (int i = 0; i < 6; ++i) {
+        if (out[i] != SipHashUint256Extra(0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL, vals[i], extras[i])) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void SipHashUint256Batch(uint64_t k0, uint64_t k1, Span<const uint256* const> vals, Span<uint64_t> out)
+{
+    SipHashBatch(k0, k1, vals, nullptr, out);
+}
+
+void SipHashUint256ExtraBatch(uint64_t k0, uint64_t k1, Span<const uint256* const> vals, Span<const uint32_t> extras, Span<uint64_t> out)
+{
+    assert(extras.size() == vals.size());
+    SipHashBatch(k0, k1, vals, extras.data(), out);
+}
+
+std::string SipHashAutoDetect()
+{
+    std::string ret = "standard";
+    SipHash4Way = nullptr;
+#if defined(USE_ASM) && defined(HAVE_GETCPUID) && defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    const bool enabled_avx = have_xsave && have_avx && AVXEnabled();
+    GetCPUID(0, 0, eax, ebx, ecx, edx);
+    bool have_avx2 = false;
+    if (eax >= 7) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+    if (have_avx2 && enabled_avx) {
+        SipHash4Way = siphash_avx2::SipHashUint256_4way;
+        ret = "avx2(4way)";
+    }
+#endif
+
+    assert(SelfTest());
+    return ret;
+}
@@ -7,8 +7,11 @@
 
 #include <stdint.h>
 
+#include <span.h>
 #include <uint256.h>
 
+#include <string>
+
 /** SipHash-2-4 */
 class CSipHasher
 {
@@ -44,4 +47,16 @@ public:
 uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256& val);
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint32_t extra);
 
+/** SipHashUint256 of each of vals into out, which is as long.
+ *  Four values are hashed at once where SipHashAutoDetect found AVX2.
+ */
+void SipHashUint256Batch(uint64_t k0, uint64_t k1, Span<const uint256* const> vals, Span<uint64_t> out);
+/** SipHashUint256Extra of each of vals with the extra of the same index into out, both as long as vals. */
+void SipHashUint256ExtraBatch(uint64_t k0, uint64_t k1, Span<const uint256* const> vals, Span<const uint32_t> extras, Span<uint64_t> out);
+
+/** Autodetect the best available batch SipHash implementation.
+ *  Returns the name of the implementation.
+ */
+std::string SipHashAutoDetect();
+
 #endif // BITCOIN_CRYPTO_SIPHASH_H
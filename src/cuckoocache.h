@@ -283,12 +283,15 @@ private:
      * scan succeeds, the epochs are aged and old elements are allow_erased. The
      * cheap heuristic is reset to retrigger after the worst case growth of the
      * current epoch's elements would exceed the epoch_size.
+     *
+     * @returns the number of old elements allow_erased that had not been erased
+     * yet, which are evicted without having been used
      */
-    void epoch_check()
+    uint32_t epoch_check()
     {
         if (epoch_heuristic_counter != 0) {
             --epoch_heuristic_counter;
-            return;
+            return 0;
         }
         // count the number of elements from the latest epoch which
         // have not been erased.
@@ -300,12 +303,15 @@ private:
         // epoch size, then allow_erase on all elements in the old epoch (marked
         // false) and move all elements in the current epoch to the old epoch
         // but do not call allow_erase on their indices.
+        uint32_t evicted = 0;
         if (epoch_unused_count >= epoch_size) {
             for (uint32_t i = 0; i < size; ++i)
                 if (epoch_flags[i])
                     epoch_flags[i] = false;
-                else
+                else {
+                    evicted += !collection_flags.bit_is_set(i);
                     allow_erase(i);
+                }
             epoch_heuristic_counter = epoch_size;
         } else
             // reset the epoch_heuristic_counter to next do a scan when worst
@@ -316,6 +322,7 @@ private:
             // < epoch_size` in this branch
             epoch_heuristic_counter = std::max(1u, std::max(epoch_size / 16,
                         epoch_size - epoch_unused_count));
+        return evicted;
     }
 
 public:
@@ -395,10 +402,12 @@ public:
      * @post one of the following: All previously inserted elements and e are
      * now in the table, one previously inserted element is evicted from the
      * table, the entry attempted to be inserted is evicted.
+     * @returns the number of elements evicted without having been erased: aged
+     * out by the start of a new epoch, or dropped for lack of depth
      */
-    inline void insert(Element e)
+    inline uint32_t insert(Element e)
     {
-        epoch_check();
+        const uint32_t evicted = epoch_check();
         uint32_t last_loc = invalid();
         bool last_epoch = true;
         std::array<uint32_t, 8> locs = compute_hashes(e);
@@ -408,7 +417,7 @@ public:
             if (table[loc] == e) {
                 please_keep(loc);
                 epoch_flags[loc] = last_epoch;
-                return;
+                return evicted;
             }
         for (uint8_t depth = 0; depth < depth_limit; ++depth) {
             // First try to insert to an empty slot, if one exists
@@ -418,7 +427,7 @@ public:
                 table[loc] = std::move(e);
                 please_keep(loc);
                 epoch_flags[loc] = last_epoch;
-                return;
+                return evicted;
             }
             /** Swap with the element at the location that was
             * not the last one looked at. Example:
@@ -444,6 +453,37 @@ public:
             // Recompute the locs -- unfortunately happens one too many times!
             locs = compute_hashes(e);
         }
+        return evicted + 1;
+    }
+
+    /** resize_bytes moves the elements not garbage collected into a table of
+     * the given approximate size, as setup_bytes sizes it. Elements may be
+     * evicted, as by insert, if the new table is not larger.
+     *
+     * Unlike setup, resize_bytes may be called again, but it requires that
+     * there are no concurrent reads or erases.
+     *
+     * @param bytes the approximate number of bytes to use for this data
+     * structure
+     * @returns A pair of the maximum number of elements storable and the
+     * approximate total size of these elements in bytes, or std::nullopt (and
+     * the table is left as it is) if the size requested is too large.
+     */
+    std::optional<std::pair<uint32_t, size_t>> resize_bytes(size_t bytes)
+    {
+        if (std::numeric_limits<uint32_t>::max() < bytes / sizeof(Element)) {
+            return std::nullopt;
+        }
+        std::vector<Element> kept;
+        for (uint32_t i = 0; i < size; ++i) {
+            if (!collection_flags.bit_is_set(i)) kept.push_back(std::move(table[i]));
+        }
+        auto result = setup_bytes(bytes);
+        std::fill(epoch_flags.begin(), epoch_flags.end(), false);
+        for (Element& e : kept) {
+            insert(std::move(e));
+        }
+        return result;
     }
 
     /** contains iterates through the hash locations for a given element
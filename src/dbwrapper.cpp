@@ -6,16 +6,23 @@
 
 #include <logging.h>
 #include <random.h>
+#include <sync.h>
 #include <tinyformat.h>
 #include <util/fs.h>
 #include <util/fs_helpers.h>
 #include <util/strencodings.h>
+#include <util/time.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <cstdarg>
 #include <cstdint>
 #include <cstdio>
+#include <exception>
+#include <future>
 #include <leveldb/cache.h>
 #include <leveldb/db.h>
 #include <leveldb/env.h>
@@ -25,7 +32,9 @@
 #include <leveldb/options.h>
 #include <leveldb/status.h>
 #include <memory>
+#include <numeric>
 #include <optional>
+#include <thread>
 
 class CBitcoinLevelDBLogger : public leveldb::Logger {
 public:
@@ -110,12 +119,13 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static leveldb::Options GetOptions(size_t nCacheSize, const DBOptions& db_options)
 {
     leveldb::Options options;
     options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    options.write_buffer_size = db_options.write_buffer_size.value_or(nCacheSize / 4); // up to two write buffers may be held in memory simultaneously
+    options.filter_policy = leveldb::NewBloomFilterPolicy(db_options.bloom_bits);
+    if (db_options.max_file_size) options.max_file_size = *db_options.max_file_size;
     options.compression = leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
@@ -127,19 +137,186 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
+//! Longest background compactions wait for blocks to connect, so a stream of them never starves compactions
+static constexpr auto MAX_COMPACTION_DEFERRAL{2s};
+//! Table file writes a compaction may get ahead of its rate by, before it sleeps
+static constexpr auto COMPACTION_RATE_BURST{100ms};
+
+static GlobalMutex g_deferral_mutex;
+static std::condition_variable g_deferral_cv;
+static int g_deferrals GUARDED_BY(g_deferral_mutex){0};
+
+DeferCompactions::DeferCompactions()
+{
+    WITH_LOCK(g_deferral_mutex, ++g_deferrals);
+}
+
+DeferCompactions::~DeferCompactions()
+{
+    WITH_LOCK(g_deferral_mutex, --g_deferrals);
+    g_deferral_cv.notify_all();
+}
+
+/** Counts of the background work of a database, kept by the work still running as the database closes */
+struct CompactionCounters {
+    const std::string name;
+    std::atomic<uint64_t> runs{0};
+    std::atomic<int64_t> micros{0};
+    std::atomic<uint64_t> bytes_written{0};
+    std::atomic<int64_t> deferred_micros{0};
+    std::atomic<int64_t> throttled_micros{0};
+
+    explicit CompactionCounters(const std::string& db_name) : name{db_name} {}
+};
+
+/**
+ * The environment of a database, counting and timing the background work
+ * LevelDB schedules on it. The work waits for DeferCompactions, and the table
+ * files it writes are throttled to the compaction rate of the database.
+ */
+class CompactionEnv : public leveldb::EnvWrapper
+{
+    class ThrottledFile : public leveldb::WritableFile
+    {
+        CompactionEnv& m_env;
+        const std::unique_ptr<leveldb::WritableFile> m_file;
+
+    public:
+        ThrottledFile(CompactionEnv& env, leveldb::WritableFile* file) : m_env{env}, m_file{file} {}
+        leveldb::Status Append(const leveldb::Slice& data) override
+        {
+            m_env.Throttle(data.size());
+            return m_file->Append(data);
+        }
+        leveldb::Status Close() override { return m_file->Close(); }
+        leveldb::Status Flush() override { return m_file->Flush(); }
+        leveldb::Status Sync() override { return m_file->Sync(); }
+        std::string GetName() const override { return m_file->GetName(); }
+    };
+
+    struct Work {
+        std::shared_ptr<CompactionCounters> counters;
+        void (*function)(void*);
+        void* arg;
+    };
+
+    static void Run(void* arg)
+    {
+        // The database may close as soon as function returns, so only the counters are used after
+        const std::unique_ptr<Work> work{static_cast<Work*>(arg)};
+        CompactionCounters& counters{*work->counters};
+        const auto start{SteadyClock::now()};
+        {
+            WAIT_LOCK(g_deferral_mutex, lock);
+            g_deferral_cv.wait_for(lock, MAX_COMPACTION_DEFERRAL, []() EXCLUSIVE_LOCKS_REQUIRED(g_deferral_mutex) { return g_deferrals == 0; });
+        }
+        const auto started{SteadyClock::now()};
+        const uint64_t bytes_before{counters.bytes_written};
+        work->function(work->arg);
+        const auto finished{SteadyClock::now()};
+        counters.deferred_micros += Ticks<std::chrono::microseconds>(started - start);
+        counters.micros += Ticks<std::chrono::microseconds>(finished - started);
+        ++counters.runs;
+        LogPrint(BCLog::LEVELDB, "Compaction of %s took %.2fms after waiting %.2fms, writing %u bytes\n", counters.name,
+                 Ticks<MillisecondsDouble>(finished - started), Ticks<MillisecondsDouble>(started - start), counters.bytes_written - bytes_before);
+    }
+
+    const size_t m_rate;
+    Mutex m_rate_mutex;
+    //! When the table files written so far are paid for at m_rate
+    SteadyClock::time_point m_paid_until GUARDED_BY(m_rate_mutex);
+
+public:
+    const std::shared_ptr<CompactionCounters> m_counters;
+
+    CompactionEnv(leveldb::Env* target, const std::string& name, size_t rate)
+        : leveldb::EnvWrapper{target}, m_rate{rate}, m_counters{std::make_shared<CompactionCounters>(name)} {}
+
+    size_t Rate() const { return m_rate; }
+
+    void Schedule(void (*function)(void*), void* arg) override
+    {
+        target()->Schedule(&CompactionEnv::Run, new Work{m_counters, function, arg});
+    }
+
+    leveldb::Status NewWritableFile(const std::string& name, leveldb::WritableFile** result) override
+    {
+        leveldb::Status status{target()->NewWritableFile(name, result)};
+        // Table files, as opposed to the log and manifest, which are written as the database is
+        if (status.ok() && name.size() > 4 && name.compare(name.size() - 4, 4, ".ldb") == 0) {
+            *result = new ThrottledFile(*this, *result);
+        }
+        return status;
+    }
+
+    void Throttle(size_t bytes)
+    {
+        m_counters->bytes_written += bytes;
+        if (m_rate == 0) return;
+        const auto now{SteadyClock::now()};
+        std::chrono::microseconds wait;
+        {
+            LOCK(m_rate_mutex);
+            m_paid_until = std::max(m_paid_until, now) + std::chrono::microseconds{bytes * 1000000 / m_rate};
+            wait = std::chrono::duration_cast<std::chrono::microseconds>(m_paid_until - now - COMPACTION_RATE_BURST);
+        }
+        if (wait.count() > 0) {
+            std::this_thread::sleep_for(wait);
+            m_counters->throttled_micros += wait.count();
+        }
+    }
+};
+
+static GlobalMutex g_databases_mutex;
+//! Signalled as CompactDatabase() calls finish, for databases closing to wait for them
+static std::condition_variable g_databases_cv;
+//! Databases open, for GetDatabaseStats()
+static std::vector<CDBWrapper*> g_databases GUARDED_BY(g_databases_mutex);
+
+std::vector<DBStats> GetDatabaseStats()
+{
+    LOCK(g_databases_mutex);
+    std::vector<DBStats> stats;
+    for (const CDBWrapper* db : g_databases) {
+        stats.push_back(db->GetStats());
+    }
+    return stats;
+}
+
+std::optional<DBStats> CompactDatabase(const std::string& name)
+{
+    CDBWrapper* db{nullptr};
+    {
+        LOCK(g_databases_mutex);
+        for (CDBWrapper* open : g_databases) {
+            if (open->m_name == name) db = open;
+        }
+        if (!db) return std::nullopt;
+        // The database waits for the count to drop before it closes
+        ++db->m_manual_compactions;
+    }
+    db->Compact();
+    LOCK(g_databases_mutex);
+    --db->m_manual_compactions;
+    g_databases_cv.notify_all();
+    return db->GetStats();
+}
+
 CDBWrapper::CDBWrapper(const DBParams& params)
-    : m_name{fs::PathToString(params.path.stem())}, m_path{params.path}, m_is_memory{params.memory_only}
+    : m_name{params.name.empty() ? fs::PathToString(params.path.stem()) : params.name}, m_path{params.path}, m_is_memory{params.memory_only}
 {
     penv = nullptr;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(params.cache_bytes);
+    options = GetOptions(params.cache_bytes, params.options);
     options.create_if_missing = true;
+    m_bloom_bits = params.options.bloom_bits;
+    LogPrint(BCLog::LEVELDB, "LevelDB options for %s: write_buffer_size=%u bloom_bits=%d max_file_size=%u\n",
+             m_name, options.write_buffer_size, m_bloom_bits, options.max_file_size);
     if (params.memory_only) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
-        options.env = penv;
     } else {
         if (params.wipe_data) {
             LogPrintf("Wiping LevelDB in %s\n", fs::PathToString(params.path));
@@ -149,6 +326,8 @@ CDBWrapper::CDBWrapper(const DBParams& params)
         TryCreateDirectories(params.path);
         LogPrintf("Opening LevelDB in %s\n", fs::PathToString(params.path));
     }
+    m_compaction_env = std::make_unique<CompactionEnv>(penv ? penv : leveldb::Env::Default(), m_name, params.options.compaction_rate.value_or(0));
+    options.env = m_compaction_env.get();
     // PathToString() return value is safe to pass to leveldb open function,
     // because on POSIX leveldb passes the byte string directly to ::open(), and
     // on Windows it converts from UTF-8 to UTF-16 before calling ::CreateFileW
@@ -158,9 +337,7 @@ CDBWrapper::CDBWrapper(const DBParams& params)
     LogPrintf("Opened LevelDB successfully\n");
 
     if (params.options.force_compact) {
-        LogPrintf("Starting database compaction of %s\n", fs::PathToString(params.path));
-        pdb->CompactRange(nullptr, nullptr);
-        LogPrintf("Finished database compaction of %s\n", fs::PathToString(params.path));
+        Compact();
     }
 
     // The base-case obfuscation key, which is a noop.
@@ -181,10 +358,17 @@ CDBWrapper::CDBWrapper(const DBParams& params)
     }
 
     LogPrintf("Using obfuscation key for %s: %s\n", fs::PathToString(params.path), HexStr(obfuscate_key));
+
+    WITH_LOCK(g_databases_mutex, g_databases.push_back(this));
 }
 
 CDBWrapper::~CDBWrapper()
 {
+    {
+        WAIT_LOCK(g_databases_mutex, lock);
+        g_databases_cv.wait(lock, [this]() EXCLUSIVE_LOCKS_REQUIRED(g_databases_mutex) { return m_manual_compactions == 0; });
+        g_databases.erase(std::find(g_databases.begin(), g_databases.end(), this));
+    }
     delete pdb;
     pdb = nullptr;
     delete options.filter_policy;
@@ -197,6 +381,58 @@ CDBWrapper::~CDBWrapper()
     options.env = nullptr;
 }
 
+std::vector<std::optional<std::string>> CDBWrapper::ReadManyRaw(const std::vector<std::string>& keys, size_t workers) const
+{
+    std::vector<std::optional<std::string>> values(keys.size());
+    if (keys.empty()) return values;
+
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+    leveldb::ReadOptions options{readoptions};
+    options.snapshot = pdb->GetSnapshot();
+    // Look up the keys order[begin, end). The iterator is kept at the first
+    // key not below the key looked up last, so a key below the one it is at
+    // is missing, and the key after the last found is a step away.
+    const auto lookup = [&](size_t begin, size_t end) {
+        std::unique_ptr<leveldb::Iterator> it{pdb->NewIterator(options)};
+        bool positioned{false};
+        for (size_t i = begin; i < end; ++i) {
+            const leveldb::Slice key{keys[order[i]]};
+            if (positioned && it->Valid() && it->key().compare(key) < 0) it->Next();
+            if (!positioned || (it->Valid() && it->key().compare(key) < 0)) {
+                it->Seek(key);
+                positioned = true;
+            }
+            if (it->Valid() && it->key().compare(key) == 0) values[order[i]] = it->value().ToString();
+        }
+        dbwrapper_private::HandleError(it->status());
+    };
+
+    workers = std::clamp<size_t>(workers, 1, keys.size());
+    std::vector<std::future<void>> futures;
+    for (size_t worker = 1; worker < workers; ++worker) {
+        futures.push_back(std::async(std::launch::async, lookup, keys.size() * worker / workers, keys.size() * (worker + 1) / workers));
+    }
+    std::exception_ptr error;
+    try {
+        lookup(0, keys.size() / workers);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (auto& future : futures) {
+        try {
+            future.get();
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    pdb->ReleaseSnapshot(options.snapshot);
+    if (error) std::rethrow_exception(error);
+    return values;
+}
+
 bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
 {
     const bool log_memory = LogAcceptCategory(BCLog::LEVELDB, BCLog::Level::Debug);
@@ -225,6 +461,43 @@ size_t CDBWrapper::DynamicMemoryUsage() const
     return parsed.value();
 }
 
+DBStats CDBWrapper::GetStats() const
+{
+    DBStats stats;
+    stats.name = m_name;
+    if (!m_is_memory) stats.path = m_path;
+    stats.write_buffer_size = options.write_buffer_size;
+    stats.bloom_bits = m_bloom_bits;
+    stats.max_file_size = options.max_file_size;
+    pdb->GetProperty("leveldb.stats", &stats.leveldb_stats);
+    for (int level = 0; level < 7; ++level) {
+        std::string files;
+        if (!pdb->GetProperty("leveldb.num-files-at-level" + ToString(level), &files)) break;
+        stats.files_per_level.push_back(ToIntegral<int>(files).value_or(0));
+    }
+    stats.memory_usage = DynamicMemoryUsage();
+    // All keys, which never start with more than a few 0xff bytes
+    const std::string last_key(16, '\xff');
+    const leveldb::Range range("", last_key);
+    pdb->GetApproximateSizes(&range, 1, &stats.approximate_size);
+    stats.compaction_rate = m_compaction_env->Rate();
+    const CompactionCounters& counters{*m_compaction_env->m_counters};
+    stats.compactions = counters.runs;
+    stats.compaction_micros = counters.micros;
+    stats.compaction_bytes_written = counters.bytes_written;
+    stats.compaction_deferred_micros = counters.deferred_micros;
+    stats.compaction_throttled_micros = counters.throttled_micros;
+    return stats;
+}
+
+void CDBWrapper::Compact()
+{
+    LogPrintf("Starting database compaction of %s\n", m_name);
+    const auto start{SteadyClock::now()};
+    pdb->CompactRange(nullptr, nullptr);
+    LogPrintf("Finished database compaction of %s in %.2fs\n", m_name, Ticks<SecondsDouble>(SteadyClock::now() - start));
+}
+
 // Prefixed with null character to avoid collisions with other keys
 //
 // We must use a string constructor which specifies length so that we copy
@@ -251,6 +524,19 @@ bool CDBWrapper::IsEmpty()
     return !(it->Valid());
 }
 
+std::vector<std::unique_ptr<CDBIterator>> CDBWrapper::NewIterators(size_t count) const
+{
+    leveldb::DB* db{pdb};
+    const std::shared_ptr<const leveldb::Snapshot> snapshot{pdb->GetSnapshot(), [db](const leveldb::Snapshot* snapshot) { db->ReleaseSnapshot(snapshot); }};
+    leveldb::ReadOptions options{iteroptions};
+    options.snapshot = snapshot.get();
+    std::vector<std::unique_ptr<CDBIterator>> iterators;
+    for (size_t i = 0; i < count; ++i) {
+        iterators.push_back(std::make_unique<CDBIterator>(*this, pdb->NewIterator(options), snapshot));
+    }
+    return iterators;
+}
+
 CDBIterator::~CDBIterator() { delete piter; }
 bool CDBIterator::Valid() const { return piter->Valid(); }
 void CDBIterator::SeekToFirst() { piter->SeekToFirst(); }
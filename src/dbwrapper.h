@@ -15,6 +15,8 @@
 #include <cstddef>
 #include <cstdint>
 #include <exception>
+#include <memory>
+#include <optional>
 #include <leveldb/db.h>
 #include <leveldb/iterator.h>
 #include <leveldb/options.h>
@@ -27,6 +29,7 @@
 namespace leveldb {
 class Env;
 }
+class CompactionEnv;
 
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
@@ -35,12 +38,22 @@ static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 struct DBOptions {
     //! Compact database on startup.
     bool force_compact = false;
+    //! Size of the in-memory write buffer, a quarter of the cache size if unset.
+    std::optional<size_t> write_buffer_size{};
+    //! Bits per key of the bloom filters of table blocks.
+    int bloom_bits = 10;
+    //! Size table files are written up to, LevelDB's default if unset.
+    std::optional<size_t> max_file_size{};
+    //! Bytes per second background compactions write table files at most, unlimited if unset.
+    std::optional<size_t> compaction_rate{};
 };
 
 //! Application-specific storage settings.
 struct DBParams {
     //! Location in the filesystem where leveldb data will be stored.
     fs::path path;
+    //! Name the database goes by in logs and stats, the stem of path if empty.
+    std::string name{};
     //! Configures various leveldb cache settings.
     size_t cache_bytes;
     //! If true, use leveldb's memory environment.
@@ -62,6 +75,55 @@ public:
 
 class CDBWrapper;
 
+/** Settings and LevelDB internal statistics of an open database, see GetDatabaseStats(). */
+struct DBStats {
+    std::string name;
+    std::optional<fs::path> path;
+    size_t write_buffer_size{0};
+    int bloom_bits{0};
+    size_t max_file_size{0};
+    //! LevelDB's "leveldb.stats" report of its compactions
+    std::string leveldb_stats;
+    std::vector<int> files_per_level;
+    size_t memory_usage{0};
+    uint64_t approximate_size{0};
+    //! Bytes per second compactions write at most, 0 if unlimited
+    size_t compaction_rate{0};
+    //! Runs of background work, each a compaction or a flush of the write buffer
+    uint64_t compactions{0};
+    //! Time spent in them, and the bytes of table files they wrote
+    int64_t compaction_micros{0};
+    uint64_t compaction_bytes_written{0};
+    //! Time compactions waited for blocks to connect, and slept to keep to compaction_rate
+    int64_t compaction_deferred_micros{0};
+    int64_t compaction_throttled_micros{0};
+};
+
+/** Statistics of every database open, in the order they were opened. */
+std::vector<DBStats> GetDatabaseStats();
+
+/**
+ * Compact the whole of the database named name, and return its statistics
+ * after, or nullopt if there is no such database open. This takes as long as
+ * the compaction, and the database is not closed before it finishes.
+ */
+std::optional<DBStats> CompactDatabase(const std::string& name);
+
+/**
+ * While one is alive, background compactions of every database wait for it,
+ * for up to MAX_COMPACTION_DEFERRAL, so their I/O keeps out of the way of a
+ * block connecting.
+ */
+class DeferCompactions
+{
+public:
+    DeferCompactions();
+    ~DeferCompactions();
+
+    DeferCompactions(const DeferCompactions&) = delete;
+    DeferCompactions& operator=(const DeferCompactions&) = delete;
+};
+
 namespace dbwrapper {
     using leveldb::DestroyDB;
 }
@@ -158,15 +220,18 @@ class CDBIterator
 private:
     const CDBWrapper &parent;
     leveldb::Iterator *piter;
+    //! The snapshot piter reads, if shared with other iterators. Released with the last of them.
+    std::shared_ptr<const leveldb::Snapshot> m_snapshot;
 
 public:
 
     /**
      * @param[in] _parent          Parent CDBWrapper instance.
      * @param[in] _piter           The original leveldb iterator.
+     * @param[in] snapshot         The snapshot _piter reads, kept until the iterator is gone.
      */
-    CDBIterator(const CDBWrapper &_parent, leveldb::Iterator *_piter) :
-        parent(_parent), piter(_piter) { };
+    CDBIterator(const CDBWrapper &_parent, leveldb::Iterator *_piter, std::shared_ptr<const leveldb::Snapshot> snapshot = nullptr) :
+        parent(_parent), piter(_piter), m_snapshot(std::move(snapshot)) { };
     ~CDBIterator();
 
     bool Valid() const;
@@ -210,6 +275,7 @@ public:
 class CDBWrapper
 {
     friend const std::vector<unsigned char>& dbwrapper_private::GetObfuscateKey(const CDBWrapper &w);
+    friend std::optional<DBStats> CompactDatabase(const std::string& name);
 private:
     //! custom environment this database is using (may be nullptr in case of default environment)
     leveldb::Env* penv;
@@ -252,6 +318,18 @@ private:
     //! whether or not the database resides in memory
     bool m_is_memory;
 
+    //! bits per key of the bloom filter policy in options
+    int m_bloom_bits;
+
+    //! environment of options, timing and throttling the compactions over penv or the default one
+    std::unique_ptr<CompactionEnv> m_compaction_env;
+
+    //! CompactDatabase() calls running, guarded by the mutex of the databases open
+    int m_manual_compactions{0};
+
+    //! Look up serialized keys from one snapshot, see ReadMany(). Values are returned as stored.
+    std::vector<std::optional<std::string>> ReadManyRaw(const std::vector<std::string>& keys, size_t workers) const;
+
 public:
     CDBWrapper(const DBParams& params);
     ~CDBWrapper();
@@ -285,6 +363,47 @@ public:
         return true;
     }
 
+    /**
+     * Look up many keys at once, as of one snapshot of the database. values[i]
+     * is set to the value of keys[i], and left empty if there is none.
+     *
+     * The keys are looked up in sorted order through one iterator, so keys
+     * next to each other, such as the outputs of a transaction, cost a step of
+     * the iterator rather than a lookup. With more than one worker, the sorted
+     * keys are split in runs looked up on threads of their own.
+     *
+     * Returns the number of values found.
+     */
+    template <typename K, typename V>
+    size_t ReadMany(const std::vector<K>& keys, std::vector<std::optional<V>>& values, size_t workers = 1) const
+    {
+        std::vector<std::string> raw_keys;
+        raw_keys.reserve(keys.size());
+        for (const K& key : keys) {
+            DataStream ssKey{};
+            ssKey.reserve(DBWRAPPER_PREALLOC_KEY_SIZE);
+            ssKey << key;
+            raw_keys.emplace_back(reinterpret_cast<const char*>(ssKey.data()), ssKey.size());
+        }
+
+        const std::vector<std::optional<std::string>> raw_values{ReadManyRaw(raw_keys, workers)};
+        values.assign(keys.size(), std::nullopt);
+        size_t found{0};
+        for (size_t i = 0; i < raw_values.size(); ++i) {
+            if (!raw_values[i]) continue;
+            try {
+                CDataStream ssValue{MakeByteSpan(*raw_values[i]), SER_DISK, CLIENT_VERSION};
+                ssValue.Xor(obfuscate_key);
+                V value;
+                ssValue >> value;
+                values[i] = std::move(value);
+                ++found;
+            } catch (const std::exception&) {
+            }
+        }
+        return found;
+    }
+
     template <typename K, typename V>
     bool Write(const K& key, const V& value, bool fSync = false)
     {
@@ -333,11 +452,19 @@ public:
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
+    DBStats GetStats() const;
+
+    //! Compact the whole database, taking as long as that takes.
+    void Compact();
+
     CDBIterator *NewIterator()
     {
         return new CDBIterator(*this, pdb->NewIterator(iteroptions));
     }
 
+    //! Iterators over one snapshot of the database, to read it on as many threads at once.
+    std::vector<std::unique_ptr<CDBIterator>> NewIterators(size_t count) const;
+
     /**
      * Return true if the database managed by this class contains no entries.
      */
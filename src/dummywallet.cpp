@@ -38,10 +38,16 @@ void DummyWalletInit::AddWalletOptions(ArgsManager& argsman) const
         "-maxtxfee=<amt>",
         "-mintxfee=<amt>",
         "-paytxfee=<amt>",
+        "-rescanthreads=<n>",
         "-signer=<cmd>",
         "-spendzeroconfchange",
+        "-stakecombinethreshold=<amt>",
+        "-stakemaxcombine=<n>",
+        "-stakemaxsplit=<n>",
+        "-staketargetsize=<amt>",
         "-txconfirmtarget=<n>",
         "-wallet=<path>",
+        "-walletarchivedepth=<n>",
         "-walletbroadcast",
         "-walletdir=<dir>",
         "-walletnotify=<cmd>",
@@ -52,6 +58,7 @@ void DummyWalletInit::AddWalletOptions(ArgsManager& argsman) const
         "-walletrejectlongchains",
         "-walletcrosschain",
         "-unsafesqlitesync",
+        "-walletsqlitewal",
     });
 }
 
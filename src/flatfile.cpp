@@ -10,6 +10,13 @@
 #include <tinyformat.h>
 #include <util/fs_helpers.h>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 FlatFileSeq::FlatFileSeq(fs::path dir, const char* prefix, size_t chunk_size) :
     m_dir(std::move(dir)),
     m_prefix(prefix),
@@ -97,3 +104,72 @@ bool FlatFileSeq::Flush(const FlatFilePos& pos, bool finalize)
     fclose(file);
     return true;
 }
+
+FlatFileMapping::~FlatFileMapping()
+{
+#ifndef WIN32
+    munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+}
+
+/** Map the whole file at path read-only, nullptr on failure */
+static std::shared_ptr<const FlatFileMapping> MapFile(const fs::path& path)
+{
+#ifndef WIN32
+    const int fd{open(path.c_str(), O_RDONLY)};
+    if (fd == -1) return nullptr;
+    struct stat st;
+    void* data{MAP_FAILED};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // The mapping keeps the file referenced
+    close(fd);
+    if (data == MAP_FAILED) {
+        LogPrint(BCLog::BLOCKSTORE, "Unable to map file %s\n", fs::PathToString(path));
+        return nullptr;
+    }
+    return std::make_shared<const FlatFileMapping>(static_cast<const std::byte*>(data), st.st_size);
+#else
+    return nullptr;
+#endif
+}
+
+std::shared_ptr<const FlatFileMapping> FlatFileMapCache::Get(const FlatFileSeq& seq, const FlatFilePos& pos, size_t size)
+{
+    if (pos.IsNull()) return nullptr;
+    const size_t end{size_t{pos.nPos} + size};
+    fs::path path{seq.FileName(pos)};
+
+    LOCK(m_mutex);
+    if (m_max_files == 0) return nullptr;
+    for (auto it = m_mappings.begin(); it != m_mappings.end(); ++it) {
+        if (it->first != path) continue;
+        if (end <= it->second->Data().size()) {
+            m_mappings.splice(m_mappings.begin(), m_mappings, it);
+            return it->second;
+        }
+        // The file grew since
+        m_mappings.erase(it);
+        break;
+    }
+
+    auto mapping{MapFile(path)};
+    if (!mapping || end > mapping->Data().size()) return nullptr;
+    m_mappings.emplace_front(std::move(path), mapping);
+    if (m_mappings.size() > m_max_files) m_mappings.pop_back();
+    return mapping;
+}
+
+void FlatFileMapCache::Erase(const fs::path& path)
+{
+    LOCK(m_mutex);
+    m_mappings.remove_if([&](const auto& entry) { return entry.first == path; });
+}
+
+void FlatFileMapCache::SetMaxFiles(size_t max_files)
+{
+    LOCK(m_mutex);
+    m_max_files = max_files;
+    while (m_mappings.size() > m_max_files) m_mappings.pop_back();
+}
@@ -6,9 +6,13 @@
 #ifndef BITCOIN_FLATFILE_H
 #define BITCOIN_FLATFILE_H
 
+#include <list>
+#include <memory>
 #include <string>
 
 #include <serialize.h>
+#include <span.h>
+#include <sync.h>
 #include <util/fs.h>
 
 struct FlatFilePos
@@ -86,4 +90,57 @@ public:
     bool Flush(const FlatFilePos& pos, bool finalize = false);
 };
 
+/**
+ * A read-only memory mapping of a whole file of a FlatFileSeq, covering the
+ * file as large as it was when mapped.
+ */
+class FlatFileMapping
+{
+private:
+    const std::byte* m_data;
+    size_t m_size;
+
+public:
+    FlatFileMapping(const std::byte* data, size_t size) : m_data(data), m_size(size) {}
+    ~FlatFileMapping();
+
+    FlatFileMapping(const FlatFileMapping&) = delete;
+    FlatFileMapping& operator=(const FlatFileMapping&) = delete;
+
+    Span<const std::byte> Data() const { return {m_data, m_size}; }
+};
+
+/**
+ * FlatFileMapCache keeps read-only memory mappings of the most recently read
+ * files of flat file sequences, so reads out of them are memory accesses instead of
+ * an open, a seek and a read each.
+ *
+ * A file growing past its mapping is mapped again. A mapping stays valid for
+ * as long as a reader holds it, even once evicted or its file is removed.
+ * Memory mapping is not used on Windows.
+ */
+class FlatFileMapCache
+{
+private:
+    Mutex m_mutex;
+    //! Mappings by file name, the most recently read first
+    std::list<std::pair<fs::path, std::shared_ptr<const FlatFileMapping>>> m_mappings GUARDED_BY(m_mutex);
+    size_t m_max_files GUARDED_BY(m_mutex);
+
+public:
+    explicit FlatFileMapCache(size_t max_files) : m_max_files(max_files) {}
+
+    /**
+     * Get a mapping of the file of seq at pos covering at least size bytes from it.
+     * Returns nullptr if mapping is disabled or fails, or the file is shorter.
+     */
+    std::shared_ptr<const FlatFileMapping> Get(const FlatFileSeq& seq, const FlatFilePos& pos, size_t size) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Drop the mapping of a file, which is removed. */
+    void Erase(const fs::path& path) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Set how many files to keep mapped, 0 to disable mapping. */
+    void SetMaxFiles(size_t max_files) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
 #endif // BITCOIN_FLATFILE_H
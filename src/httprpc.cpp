@@ -5,9 +5,16 @@
 #include <httprpc.h>
 
 #include <crypto/hmac_sha256.h>
+#include <crypto/sha256.h>
 #include <httpserver.h>
+#include <logging.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
+#include <random.h>
+#include <sync.h>
+#include <uint256.h>
+#include <util/hasher.h>
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/system.h>
@@ -17,13 +24,18 @@
 #include <iterator>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 /** WWW-Authenticate to present with 401 Unauthorized response */
 static const char* WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
 
+/** Whether the requests of a batch are spread over the idle HTTP workers, see -rpcbatchparallel */
+static bool g_rpc_batch_parallel{DEFAULT_RPC_BATCH_PARALLEL};
+
 /** Simple one-shot callback timer to be used by the RPC mechanism to e.g.
  * re-lock the wallet.
  */
@@ -71,6 +83,17 @@ static std::vector<std::vector<std::string>> g_rpcauth;
 static std::map<std::string, std::set<std::string>> g_rpc_whitelist;
 static bool g_rpc_whitelist_default = false;
 
+/** Most credentials kept authorized, the cache is emptied past this */
+static constexpr size_t MAX_RPC_AUTH_CACHE_SIZE{128};
+/**
+ * Credentials already checked against -rpcauth or the cookie, by their salted
+ * hash, and the user they authorize. A client that sends the same Authorization
+ * header with every call pays for one hash rather than an HMAC per -rpcauth entry.
+ */
+static Mutex g_rpc_auth_cache_mutex;
+static uint256 g_rpc_auth_cache_salt GUARDED_BY(g_rpc_auth_cache_mutex);
+static std::unordered_map<uint256, std::string, SaltedTxidHasher> g_rpc_auth_cache GUARDED_BY(g_rpc_auth_cache_mutex);
+
 static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const UniValue& id)
 {
     // Send error reply from json-rpc error object
@@ -88,6 +111,66 @@ static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const Uni
     req->WriteReply(nStatus, strReply);
 }
 
+/**
+ * Sends the result of a single request as the method writes it, with chunked
+ * transfer encoding. Once the reply has started an error can no longer be
+ * reported, only the connection dropped.
+ */
+class HTTPResultStream final : public RPCResultStream
+{
+public:
+    HTTPResultStream(HTTPRequest* req, const UniValue& id) : m_req(req), m_id(id) {}
+
+    JSONWriter& Start() override
+    {
+        assert(!m_writer);
+        m_req->WriteHeader("Content-Type", "application/json");
+        m_req->WriteReplyStart(HTTP_OK);
+        m_writer.emplace([this](Span<const unsigned char> piece) {
+            m_bytes_written += piece.size();
+            return m_req->WriteReplyChunk(piece);
+        });
+        // The members of the reply JSONRPCReply() gives, in the same order
+        m_writer->BeginObject();
+        m_writer->Key("result");
+        return *m_writer;
+    }
+
+    bool Started() const override { return m_writer.has_value(); }
+
+    size_t BytesWritten() const { return m_bytes_written; }
+
+    /// Finish the reply once the method has returned, or drop it if the method failed.
+    bool Finish(bool complete)
+    {
+        assert(m_writer);
+        if (complete) {
+            try {
+                m_writer->Key("error");
+                m_writer->Value(NullUniValue);
+                m_writer->Key("id");
+                m_writer->Value(m_id);
+                m_writer->EndObject();
+                m_writer->Flush();
+                complete = m_req->WriteReplyChunk(MakeUCharSpan(std::string_view{"\n"}));
+            } catch (const JSONWriterClosed&) {
+                complete = false;
+            }
+        }
+        if (!complete) {
+            LogPrint(BCLog::RPC, "Streamed reply cut short\n");
+        }
+        m_req->WriteReplyEnd(complete);
+        return complete;
+    }
+
+private:
+    HTTPRequest* const m_req;
+    const UniValue& m_id;
+    std::optional<JSONWriter> m_writer;
+    size_t m_bytes_written{0};
+};
+
 //This function checks username and password against -rpcauth
 //entries from config file.
 static bool multiUserAuthorized(std::string strUserPass)
@@ -121,12 +204,27 @@ static bool multiUserAuthorized(std::string strUserPass)
     return false;
 }
 
+static uint256 RPCAuthCacheKey(const std::string& strAuth) EXCLUSIVE_LOCKS_REQUIRED(g_rpc_auth_cache_mutex)
+{
+    uint256 key;
+    CSHA256().Write(g_rpc_auth_cache_salt.begin(), g_rpc_auth_cache_salt.size()).Write(reinterpret_cast<const unsigned char*>(strAuth.data()), strAuth.size()).Finalize(key.begin());
+    return key;
+}
+
 static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUsernameOut)
 {
     if (strRPCUserColonPass.empty()) // Belt-and-suspenders measure if InitRPCAuthentication was not called
         return false;
     if (strAuth.substr(0, 6) != "Basic ")
         return false;
+    {
+        LOCK(g_rpc_auth_cache_mutex);
+        const auto cached{g_rpc_auth_cache.find(RPCAuthCacheKey(strAuth))};
+        if (cached != g_rpc_auth_cache.end()) {
+            strAuthUsernameOut = cached->second;
+            return true;
+        }
+    }
     std::string_view strUserPass64 = TrimStringView(std::string_view{strAuth}.substr(6));
     auto userpass_data = DecodeBase64(strUserPass64);
     std::string strUserPass;
@@ -137,10 +235,22 @@ static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUserna
         strAuthUsernameOut = strUserPass.substr(0, strUserPass.find(':'));
 
     //Check if authorized under single-user field
-    if (TimingResistantEqual(strUserPass, strRPCUserColonPass)) {
-        return true;
+    if (!TimingResistantEqual(strUserPass, strRPCUserColonPass) && !multiUserAuthorized(strUserPass)) {
+        return false;
     }
-    return multiUserAuthorized(strUserPass);
+
+    // Only credentials that passed are kept, failed attempts are checked, and slowed, every time
+    LOCK(g_rpc_auth_cache_mutex);
+    if (g_rpc_auth_cache.size() >= MAX_RPC_AUTH_CACHE_SIZE) g_rpc_auth_cache.clear();
+    g_rpc_auth_cache.emplace(RPCAuthCacheKey(strAuth), strAuthUsernameOut);
+    return true;
+}
+
+bool RPCMethodAllowed(const std::string& user, const std::string& method)
+{
+    const auto whitelist{g_rpc_whitelist.find(user)};
+    if (whitelist == g_rpc_whitelist.end()) return !g_rpc_whitelist_default;
+    return whitelist->second.count(method);
 }
 
 static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
@@ -159,6 +269,7 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
     }
 
     JSONRPCRequest jreq;
+    HTTPResultStream result_stream{req, jreq.id};
     jreq.context = context;
     jreq.peerAddr = req->GetPeer().ToStringAddrPort();
     if (!RPCAuthorized(authHeader.second, jreq.authUser)) {
@@ -198,10 +309,17 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
                 req->WriteReply(HTTP_FORBIDDEN);
                 return false;
             }
+            jreq.result_stream = &result_stream;
             UniValue result = tableRPC.execute(jreq);
+            if (result_stream.Started()) {
+                const bool complete{result_stream.Finish(/*complete=*/true)};
+                RecordRPCBytesOut(jreq.strMethod, result_stream.BytesWritten());
+                return complete;
+            }
 
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            RecordRPCBytesOut(jreq.strMethod, strReply.size());
 
         // array of requests
         } else if (valRequest.isArray()) {
@@ -221,7 +339,7 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
                     }
                 }
             }
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+            strReply = JSONRPCExecBatch(jreq, valRequest.get_array(), g_rpc_batch_parallel ? RPCParallelFor{HTTPParallelFor} : RPCParallelFor{});
         }
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
@@ -229,9 +347,11 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strReply);
     } catch (const UniValue& objError) {
+        if (result_stream.Started()) return result_stream.Finish(/*complete=*/false);
         JSONErrorReply(req, objError, jreq.id);
         return false;
     } catch (const std::exception& e) {
+        if (result_stream.Started()) return result_stream.Finish(/*complete=*/false);
         JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
         return false;
     }
@@ -240,6 +360,11 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
 
 static bool InitRPCAuthentication()
 {
+    {
+        LOCK(g_rpc_auth_cache_mutex);
+        g_rpc_auth_cache.clear();
+        g_rpc_auth_cache_salt = GetRandHash();
+    }
     if (gArgs.GetArg("-rpcpassword", "") == "")
     {
         LogPrintf("Using random cookie authentication.\n");
@@ -296,6 +421,7 @@ bool StartHTTPRPC(const std::any& context)
     LogPrint(BCLog::RPC, "Starting HTTP RPC server\n");
     if (!InitRPCAuthentication())
         return false;
+    g_rpc_batch_parallel = gArgs.GetBoolArg("-rpcbatchparallel", DEFAULT_RPC_BATCH_PARALLEL);
 
     auto handle_rpc = [context](HTTPRequest* req, const std::string&) { return HTTPReq_JSONRPC(context, req); };
     RegisterHTTPHandler("/", true, handle_rpc);
@@ -325,4 +451,5 @@ void StopHTTPRPC()
         RPCUnsetTimerInterface(httpRPCTimerInterface.get());
         httpRPCTimerInterface.reset();
     }
+    WITH_LOCK(g_rpc_auth_cache_mutex, g_rpc_auth_cache.clear());
 }
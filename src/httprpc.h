@@ -6,6 +6,10 @@
 #define BITCOIN_HTTPRPC_H
 
 #include <any>
+#include <string>
+
+//! Default for -rpcbatchparallel
+static const bool DEFAULT_RPC_BATCH_PARALLEL{true};
 
 /** Start HTTP RPC subsystem.
  * Precondition; HTTP and RPC has been started.
@@ -19,6 +23,9 @@ void InterruptHTTPRPC();
  */
 void StopHTTPRPC();
 
+/** Whether -rpcwhitelist lets user call method. */
+bool RPCMethodAllowed(const std::string& user, const std::string& method);
+
 /** Start HTTP REST subsystem.
  * Precondition; HTTP and RPC has been started.
  */
@@ -31,4 +38,15 @@ void InterruptREST();
  */
 void StopREST();
 
+/** Start serving /metrics on -metricsport.
+ * Precondition; HTTP has been started.
+ */
+void StartMetrics(const std::any& context);
+/** Interrupt the metrics server.
+ */
+void InterruptMetrics();
+/** Stop serving /metrics on -metricsport.
+ */
+void StopMetrics();
+
 #endif // BITCOIN_HTTPRPC_H
@@ -21,10 +21,13 @@
 #include <util/threadnames.h>
 #include <util/translation.h>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <deque>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string>
@@ -67,16 +70,25 @@ private:
 };
 
 /** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+ * Work items are simply callable objects. Each item is queued for a client, and
+ * clients take turns, so one client's burst does not hold up everyone else's requests.
  */
 template <typename WorkItem>
 class WorkQueue
 {
 private:
+    using Clock = std::chrono::steady_clock;
+
     Mutex cs;
     std::condition_variable cond GUARDED_BY(cs);
-    std::deque<std::unique_ptr<WorkItem>> queue GUARDED_BY(cs);
+    //! Items waiting per client, with the time each was queued
+    std::map<std::string, std::deque<std::pair<std::unique_ptr<WorkItem>, Clock::time_point>>> queues GUARDED_BY(cs);
+    //! Clients with items waiting, in the order they take their turn
+    std::deque<std::string> turns GUARDED_BY(cs);
+    size_t depth GUARDED_BY(cs){0};
     bool running GUARDED_BY(cs){true};
+    //! Threads waiting for an item
+    size_t idle GUARDED_BY(cs){0};
     const size_t maxDepth;
 
 public:
@@ -86,14 +98,17 @@ public:
     /** Precondition: worker threads have all stopped (they have been joined).
      */
     ~WorkQueue() = default;
-    /** Enqueue a work item */
-    bool Enqueue(WorkItem* item) EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    /** Enqueue a work item for a client */
+    bool Enqueue(WorkItem* item, const std::string& client = "") EXCLUSIVE_LOCKS_REQUIRED(!cs)
     {
         LOCK(cs);
-        if (!running || queue.size() >= maxDepth) {
+        if (!running || depth >= maxDepth) {
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        auto& queue{queues[client]};
+        if (queue.empty()) turns.push_back(client);
+        queue.emplace_back(std::unique_ptr<WorkItem>(item), Clock::now());
+        ++depth;
         cond.notify_one();
         return true;
     }
@@ -104,16 +119,52 @@ public:
             std::unique_ptr<WorkItem> i;
             {
                 WAIT_LOCK(cs, lock);
-                while (running && queue.empty())
+                ++idle;
+                while (running && depth == 0)
                     cond.wait(lock);
-                if (!running && queue.empty())
+                --idle;
+                if (!running && depth == 0)
                     break;
-                i = std::move(queue.front());
-                queue.pop_front();
+                const auto queue{queues.find(turns.front())};
+                i = std::move(queue->second.front().first);
+                queue->second.pop_front();
+                --depth;
+                if (queue->second.empty()) {
+                    queues.erase(queue);
+                } else {
+                    turns.push_back(turns.front());
+                }
+                turns.pop_front();
             }
             (*i)();
         }
     }
+    /** Threads that would take an item enqueued now, less the items already waiting for one */
+    size_t Idle() EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    {
+        LOCK(cs);
+        return idle > depth ? idle - depth : 0;
+    }
+    /** Items waiting for a thread */
+    size_t Depth() EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    {
+        LOCK(cs);
+        return depth;
+    }
+    /** Whether the items waiting would keep another of the given number of threads busy:
+     * no thread is free, and either as many items wait as there are threads, or one has
+     * waited longer than max_wait */
+    bool Backlogged(size_t threads, std::chrono::milliseconds max_wait) EXCLUSIVE_LOCKS_REQUIRED(!cs)
+    {
+        LOCK(cs);
+        if (!running || idle > 0 || depth == 0) return false;
+        if (depth >= threads) return true;
+        const auto now{Clock::now()};
+        for (const auto& [client, queue] : queues) {
+            if (now - queue.front().second > max_wait) return true;
+        }
+        return false;
+    }
     /** Interrupt and exit loops */
     void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!cs)
     {
@@ -123,6 +174,17 @@ public:
     }
 };
 
+/** Work item running part of a request on another worker, see HTTPParallelFor */
+class HTTPHelperWorkItem final : public HTTPClosure
+{
+public:
+    explicit HTTPHelperWorkItem(std::function<void()> func) : m_func(std::move(func)) {}
+    void operator()() override { m_func(); }
+
+private:
+    std::function<void()> m_func;
+};
+
 struct HTTPPathHandler
 {
     HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
@@ -140,6 +202,8 @@ struct HTTPPathHandler
 static struct event_base* eventBase = nullptr;
 //! HTTP server
 static struct evhttp* eventHTTP = nullptr;
+//! Metrics HTTP server, on the same event loop and work queue, nullptr without -metricsport
+static struct evhttp* eventHTTPMetrics = nullptr;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
 //! Work queue for handling longer requests off the event loop thread
@@ -147,12 +211,39 @@ static std::unique_ptr<WorkQueue<HTTPClosure>> g_work_queue{nullptr};
 //! Handlers for (sub)paths
 static GlobalMutex g_httppathhandlers_mutex;
 static std::vector<HTTPPathHandler> pathHandlers GUARDED_BY(g_httppathhandlers_mutex);
+static std::vector<HTTPPathHandler> metricsPathHandlers GUARDED_BY(g_httppathhandlers_mutex);
 //! Bound listening sockets
 static std::vector<evhttp_bound_socket *> boundSockets;
+static std::vector<evhttp_bound_socket *> boundMetricsSockets;
 //! Track active requests
 static GlobalMutex g_requests_mutex;
 static std::condition_variable g_requests_cv;
 static std::unordered_set<evhttp_request*> g_requests GUARDED_BY(g_requests_mutex);
+//! Worker threads, which grow in number up to g_max_http_workers while requests wait for one
+static GlobalMutex g_http_workers_mutex;
+static std::vector<std::thread> g_thread_http_workers GUARDED_BY(g_http_workers_mutex);
+static std::atomic<size_t> g_http_workers{0};
+static size_t g_max_http_workers{0};
+//! Connections that have had a request, only used on the main http thread
+static std::unordered_set<evhttp_connection*> g_http_connections;
+static std::atomic<uint64_t> g_http_connections_total{0};
+static std::atomic<size_t> g_http_connections_open{0};
+static std::atomic<uint64_t> g_http_requests_total{0};
+static std::atomic<uint64_t> g_http_requests_reused{0};
+static std::atomic<uint64_t> g_http_requests_rejected{0};
+
+/** State of a reply sent with chunked transfer encoding, shared with the main http thread */
+struct HTTPReplyStream
+{
+    Mutex mutex;
+    std::condition_variable cond;
+    //! bytes queued by WriteReplyChunk and not yet written to the socket
+    size_t unsent GUARDED_BY(mutex){0};
+    //! bytes handed to libevent since its output buffer was last empty
+    size_t handed GUARDED_BY(mutex){0};
+    //! the connection is gone, the rest of the reply goes nowhere
+    bool closed GUARDED_BY(mutex){false};
+};
 
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr& netaddr)
@@ -211,7 +302,41 @@ std::string RequestMethodString(HTTPRequest::RequestMethod m)
     assert(false);
 }
 
-/** HTTP request callback */
+/** Called by libevent when a connection that had a request is freed */
+static void http_connection_close_cb(struct evhttp_connection* conn, void*)
+{
+    if (g_http_connections.erase(conn)) --g_http_connections_open;
+}
+
+/** Count a request, and the connection it came on unless that is kept alive from an earlier one */
+static void CountHTTPRequest(evhttp_connection* conn)
+{
+    ++g_http_requests_total;
+    if (!conn) return;
+    if (!g_http_connections.insert(conn).second) {
+        ++g_http_requests_reused;
+        return;
+    }
+    ++g_http_connections_total;
+    ++g_http_connections_open;
+    evhttp_connection_set_closecb(conn, http_connection_close_cb, nullptr);
+}
+
+static void HTTPWorkQueueRun(WorkQueue<HTTPClosure>* queue, int worker_num);
+
+/** Start another worker thread if requests keep waiting for one and the pool may still grow */
+static void MaybeAddHTTPWorker()
+{
+    if (g_http_workers >= g_max_http_workers || !g_work_queue->Backlogged(g_http_workers, HTTP_WORKER_MAX_WAIT)) return;
+    LOCK(g_http_workers_mutex);
+    // Interrupt() stops the queue before the workers are joined, so none starts after
+    if (!g_work_queue->Backlogged(g_http_workers, HTTP_WORKER_MAX_WAIT)) return;
+    const int worker_num = g_http_workers++;
+    LogPrint(BCLog::HTTP, "Requests are waiting on all %d worker threads, starting another\n", worker_num);
+    g_thread_http_workers.emplace_back(HTTPWorkQueueRun, g_work_queue.get(), worker_num);
+}
+
+/** HTTP request callback, arg is set for requests to the metrics server */
 static void http_request_cb(struct evhttp_request* req, void* arg)
 {
     // Track requests and notify when a request is completed.
@@ -235,6 +360,7 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
             }
         }
     }
+    CountHTTPRequest(evhttp_request_get_connection(req));
     std::unique_ptr<HTTPRequest> hreq(new HTTPRequest(req));
 
     // Early address-based allow check
@@ -260,8 +386,9 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
     std::string strURI = hreq->GetURI();
     std::string path;
     LOCK(g_httppathhandlers_mutex);
-    std::vector<HTTPPathHandler>::const_iterator i = pathHandlers.begin();
-    std::vector<HTTPPathHandler>::const_iterator iend = pathHandlers.end();
+    const std::vector<HTTPPathHandler>& handlers{arg ? metricsPathHandlers : pathHandlers};
+    std::vector<HTTPPathHandler>::const_iterator i = handlers.begin();
+    std::vector<HTTPPathHandler>::const_iterator iend = handlers.end();
     for (; i != iend; ++i) {
         bool match = false;
         if (i->exactMatch)
@@ -276,11 +403,15 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
+        // Requests from the same address take turns with those from others
+        const std::string client{hreq->GetPeer().ToStringAddr()};
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
         assert(g_work_queue);
-        if (g_work_queue->Enqueue(item.get())) {
+        if (g_work_queue->Enqueue(item.get(), client)) {
             item.release(); /* if true, queue took ownership */
+            MaybeAddHTTPWorker();
         } else {
+            ++g_http_requests_rejected;
             LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
             item->req->WriteReply(HTTP_SERVICE_UNAVAILABLE, "Work queue depth exceeded");
         }
@@ -289,6 +420,45 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
     }
 }
 
+void HTTPParallelFor(size_t count, const std::function<void(size_t)>& fn)
+{
+    struct State {
+        std::atomic<size_t> next{0};
+        Mutex mutex;
+        std::condition_variable cond;
+        size_t done GUARDED_BY(mutex){0};
+    };
+    const auto state{std::make_shared<State>()};
+
+    // Each thread takes the next entry until none is left. fn is only used for
+    // an entry taken, which the caller waits for, so a helper starting late
+    // touches nothing but the state it shares.
+    const auto work{[state, count, &fn] {
+        size_t ran{0};
+        for (size_t i = state->next++; i < count; i = state->next++) {
+            fn(i);
+            ++ran;
+        }
+        if (ran == 0) return;
+        LOCK(state->mutex);
+        state->done += ran;
+        state->cond.notify_all();
+    }};
+
+    // Only idle workers are asked to help, so requests queued are not held up
+    // and the queue keeps room for them
+    size_t helpers{count > 1 && g_work_queue ? std::min(count - 1, g_work_queue->Idle()) : 0};
+    for (; helpers > 0; --helpers) {
+        auto item{std::make_unique<HTTPHelperWorkItem>(work)};
+        if (!g_work_queue->Enqueue(item.get())) break;
+        item.release(); // the queue took ownership
+    }
+
+    work();
+    WAIT_LOCK(state->mutex, lock);
+    state->cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(state->mutex) { return state->done == count; });
+}
+
 /** Callback to reject HTTP requests after shutdown. */
 static void http_reject_request_cb(struct evhttp_request* req, void*)
 {
@@ -349,6 +519,35 @@ static bool HTTPBindAddresses(struct evhttp* http)
     return !boundSockets.empty();
 }
 
+/** Bind the metrics server to -metricsbind, or to localhost, on -metricsport */
+static bool HTTPBindMetricsAddresses(struct evhttp* http)
+{
+    const uint16_t metrics_port{static_cast<uint16_t>(gArgs.GetIntArg("-metricsport", DEFAULT_METRICS_PORT))};
+    std::vector<std::pair<std::string, uint16_t>> endpoints;
+    if (gArgs.IsArgSet("-metricsbind")) {
+        for (const std::string& bind : gArgs.GetArgs("-metricsbind")) {
+            uint16_t port{metrics_port};
+            std::string host;
+            SplitHostPort(bind, port, host);
+            endpoints.emplace_back(host, port);
+        }
+    } else {
+        endpoints.emplace_back("::1", metrics_port);
+        endpoints.emplace_back("127.0.0.1", metrics_port);
+    }
+
+    for (const auto& [host, port] : endpoints) {
+        LogPrintf("Binding metrics on address %s port %i\n", host, port);
+        evhttp_bound_socket* bind_handle = evhttp_bind_socket_with_handle(http, host.empty() ? nullptr : host.c_str(), port);
+        if (bind_handle) {
+            boundMetricsSockets.push_back(bind_handle);
+        } else {
+            LogPrintf("Binding metrics on address %s port %i failed.\n", host, port);
+        }
+    }
+    return !boundMetricsSockets.empty();
+}
+
 /** Simple wrapper to set thread name and run work queue */
 static void HTTPWorkQueueRun(WorkQueue<HTTPClosure>* queue, int worker_num)
 {
@@ -414,6 +613,24 @@ bool InitHTTPServer()
         return false;
     }
 
+    raii_evhttp metrics_ctr{nullptr};
+    if (gArgs.GetIntArg("-metricsport", DEFAULT_METRICS_PORT) != 0) {
+        metrics_ctr = obtain_evhttp(base_ctr.get());
+        struct evhttp* metrics = metrics_ctr.get();
+        if (!metrics) {
+            LogPrintf("couldn't create evhttp for metrics. Exiting.\n");
+            return false;
+        }
+        evhttp_set_timeout(metrics, gArgs.GetIntArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
+        evhttp_set_max_headers_size(metrics, MAX_HEADERS_SIZE);
+        evhttp_set_max_body_size(metrics, MAX_HEADERS_SIZE);
+        evhttp_set_gencb(metrics, http_request_cb, metrics);
+        if (!HTTPBindMetricsAddresses(metrics)) {
+            LogPrintf("Unable to bind any endpoint for metrics server\n");
+            return false;
+        }
+    }
+
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)gArgs.GetIntArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
     LogPrintfCategory(BCLog::HTTP, "creating work queue of depth %d\n", workQueueDepth);
@@ -422,6 +639,7 @@ bool InitHTTPServer()
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
+    eventHTTPMetrics = metrics_ctr.release();
     return true;
 }
 
@@ -434,18 +652,20 @@ void UpdateHTTPServerLogging(bool enable) {
 }
 
 static std::thread g_thread_http;
-static std::vector<std::thread> g_thread_http_workers;
 
 void StartHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
     int rpcThreads = std::max((long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintfCategory(BCLog::HTTP, "starting %d worker threads\n", rpcThreads);
+    g_max_http_workers = std::max<int64_t>(gArgs.GetIntArg("-rpcmaxthreads", DEFAULT_HTTP_MAX_THREADS), rpcThreads);
+    LogPrintfCategory(BCLog::HTTP, "starting %d worker threads, growing up to %d\n", rpcThreads, g_max_http_workers);
     g_thread_http = std::thread(ThreadHTTP, eventBase);
 
+    LOCK(g_http_workers_mutex);
     for (int i = 0; i < rpcThreads; i++) {
         g_thread_http_workers.emplace_back(HTTPWorkQueueRun, g_work_queue.get(), i);
     }
+    g_http_workers = rpcThreads;
 }
 
 void InterruptHTTPServer()
@@ -455,6 +675,9 @@ void InterruptHTTPServer()
         // Reject requests on current connections
         evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
     }
+    if (eventHTTPMetrics) {
+        evhttp_set_gencb(eventHTTPMetrics, http_reject_request_cb, nullptr);
+    }
     if (g_work_queue) {
         g_work_queue->Interrupt();
     }
@@ -465,10 +688,12 @@ void StopHTTPServer()
     LogPrint(BCLog::HTTP, "Stopping HTTP server\n");
     if (g_work_queue) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
-        for (auto& thread : g_thread_http_workers) {
+        std::vector<std::thread> workers;
+        WITH_LOCK(g_http_workers_mutex, workers.swap(g_thread_http_workers));
+        for (auto& thread : workers) {
             thread.join();
         }
-        g_thread_http_workers.clear();
+        g_http_workers = 0;
     }
     // Unlisten sockets, these are what make the event loop running, which means
     // that after this and all connections are closed the event loop will quit.
@@ -476,6 +701,10 @@ void StopHTTPServer()
         evhttp_del_accept_socket(eventHTTP, socket);
     }
     boundSockets.clear();
+    for (evhttp_bound_socket* socket : boundMetricsSockets) {
+        evhttp_del_accept_socket(eventHTTPMetrics, socket);
+    }
+    boundMetricsSockets.clear();
     {
         WAIT_LOCK(g_requests_mutex, lock);
         if (!g_requests.empty()) {
@@ -492,6 +721,10 @@ void StopHTTPServer()
         event_base_once(eventBase, -1, EV_TIMEOUT, [](evutil_socket_t, short, void*) {
             evhttp_free(eventHTTP);
             eventHTTP = nullptr;
+            if (eventHTTPMetrics) {
+                evhttp_free(eventHTTPMetrics);
+                eventHTTPMetrics = nullptr;
+            }
         }, nullptr, nullptr);
     }
     if (eventBase) {
@@ -504,6 +737,20 @@ void StopHTTPServer()
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
 }
 
+HTTPServerStats GetHTTPServerStats()
+{
+    HTTPServerStats stats;
+    stats.workers = g_http_workers;
+    stats.max_workers = g_max_http_workers;
+    stats.queue_depth = g_work_queue ? g_work_queue->Depth() : 0;
+    stats.requests = g_http_requests_total;
+    stats.requests_reused = g_http_requests_reused;
+    stats.requests_rejected = g_http_requests_rejected;
+    stats.connections = g_http_connections_total;
+    stats.connections_open = g_http_connections_open;
+    return stats;
+}
+
 struct event_base* EventBase()
 {
     return eventBase;
@@ -541,7 +788,11 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req, bool _replySent) : req(_re
 
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (m_stream && !replySent) {
+        // A streamed reply the handler didn't finish is cut short
+        LogPrintf("%s: Unfinished reply\n", __func__);
+        WriteReplyEnd(false);
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -622,6 +873,126 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = nullptr; // transferred back to main thread
 }
 
+/** Called by libevent once everything handed to it for a streamed reply is written */
+static void http_stream_flushed_cb(struct evhttp_connection*, void* arg)
+{
+    HTTPReplyStream* stream = static_cast<HTTPReplyStream*>(arg);
+    {
+        LOCK(stream->mutex);
+        stream->unsent -= stream->handed;
+        stream->handed = 0;
+    }
+    stream->cond.notify_all();
+}
+
+/** Called by libevent when the connection of a streamed reply is freed */
+static void http_stream_close_cb(struct evhttp_connection* conn, void* arg)
+{
+    if (conn) http_connection_close_cb(conn, nullptr);
+    HTTPReplyStream* stream = static_cast<HTTPReplyStream*>(arg);
+    WITH_LOCK(stream->mutex, stream->closed = true);
+    stream->cond.notify_all();
+}
+
+void HTTPRequest::WriteReplyStart(int nStatus)
+{
+    assert(!replySent && !m_stream && req);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    m_stream = std::make_shared<HTTPReplyStream>();
+    auto req_copy = req;
+    auto stream = m_stream;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, stream, nStatus]{
+        // A client gone before the reply started leaves the request without a connection
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (!conn) {
+            http_stream_close_cb(nullptr, stream.get());
+            return;
+        }
+        evhttp_connection_set_closecb(conn, http_stream_close_cb, stream.get());
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+}
+
+bool HTTPRequest::WriteReplyChunk(Span<const unsigned char> data)
+{
+    assert(!replySent && m_stream);
+    auto stream = m_stream;
+    {
+        LOCK(stream->mutex);
+        if (stream->closed) return false;
+        stream->unsent += data.size();
+    }
+    if (!data.empty()) {
+        auto req_copy = req;
+        HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, stream, chunk = std::string(data.begin(), data.end())]{
+            if (!evhttp_request_get_connection(req_copy)) {
+                http_stream_close_cb(nullptr, stream.get());
+                return;
+            }
+            struct evbuffer* evb = evhttp_request_get_output_buffer(req_copy);
+            assert(evb);
+            evbuffer_add(evb, chunk.data(), chunk.size());
+            WITH_LOCK(stream->mutex, stream->handed += chunk.size());
+            evhttp_send_reply_chunk_with_cb(req_copy, evb, http_stream_flushed_cb, stream.get());
+            // Replies to HEAD requests have no body, libevent leaves the chunk be
+            if (evbuffer_get_length(evb) > 0) {
+                evbuffer_drain(evb, evbuffer_get_length(evb));
+                http_stream_flushed_cb(nullptr, stream.get());
+            }
+        });
+        ev->trigger(nullptr);
+    }
+
+    WAIT_LOCK(stream->mutex, lock);
+    while (stream->unsent > HTTP_STREAM_WINDOW && !stream->closed) {
+        if (ShutdownRequested()) return false;
+        stream->cond.wait_for(lock, std::chrono::seconds{1});
+    }
+    return !stream->closed;
+}
+
+void HTTPRequest::WriteReplyEnd(bool complete)
+{
+    assert(!replySent && m_stream && req);
+    auto req_copy = req;
+    auto stream = m_stream;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, stream, complete]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            evhttp_connection_set_closecb(conn, http_connection_close_cb, nullptr);
+        }
+        if (conn && complete) {
+            evhttp_send_reply_end(req_copy);
+            // Re-enable reading from the socket, as in WriteReply.
+            if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+                if (bev) {
+                    bufferevent_enable(bev, EV_READ | EV_WRITE);
+                }
+            }
+            return;
+        }
+
+        // evhttp never completes a request dropped here, stop tracking it
+        WITH_LOCK(g_requests_mutex, g_requests.erase(req_copy));
+        g_requests_cv.notify_all();
+        if (conn) {
+            // Frees the request with the connection
+            evhttp_connection_free(conn);
+        } else {
+            // Frees the request the closed connection left behind
+            evhttp_send_reply_end(req_copy);
+        }
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+    m_stream.reset();
+}
+
 CService HTTPRequest::GetPeer() const
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -697,24 +1068,25 @@ std::optional<std::string> GetQueryParameterFromUri(const char* uri, const std::
     return result;
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, bool metrics)
 {
-    LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
+    LogPrint(BCLog::HTTP, "Registering HTTP%s handler for %s (exactmatch %d)\n", metrics ? " metrics" : "", prefix, exactMatch);
     LOCK(g_httppathhandlers_mutex);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    (metrics ? metricsPathHandlers : pathHandlers).push_back(HTTPPathHandler(prefix, exactMatch, handler));
 }
 
-void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
+void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch, bool metrics)
 {
     LOCK(g_httppathhandlers_mutex);
-    std::vector<HTTPPathHandler>::iterator i = pathHandlers.begin();
-    std::vector<HTTPPathHandler>::iterator iend = pathHandlers.end();
+    std::vector<HTTPPathHandler>& handlers{metrics ? metricsPathHandlers : pathHandlers};
+    std::vector<HTTPPathHandler>::iterator i = handlers.begin();
+    std::vector<HTTPPathHandler>::iterator iend = handlers.end();
     for (; i != iend; ++i)
         if (i->prefix == prefix && i->exactMatch == exactMatch)
             break;
     if (i != iend)
     {
-        LogPrint(BCLog::HTTP, "Unregistering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-        pathHandlers.erase(i);
+        LogPrint(BCLog::HTTP, "Unregistering HTTP%s handler for %s (exactmatch %d)\n", metrics ? " metrics" : "", prefix, exactMatch);
+        handlers.erase(i);
     }
 }
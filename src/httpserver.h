@@ -5,18 +5,31 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
+#include <span.h>
+
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 
 static const int DEFAULT_HTTP_THREADS=4;
+static const int DEFAULT_HTTP_MAX_THREADS=16;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
+//! Default for -metricsport, 0 for no metrics server
+static const uint16_t DEFAULT_METRICS_PORT{0};
+//! Bytes of a streamed reply that may wait on the client before WriteReplyChunk blocks
+static const size_t HTTP_STREAM_WINDOW = 1 << 20;
+//! How long a request may wait on busy workers before another worker is started for it
+static constexpr std::chrono::milliseconds HTTP_WORKER_MAX_WAIT{100};
 
 struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPReplyStream;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -32,6 +45,23 @@ void InterruptHTTPServer();
 /** Stop HTTP server */
 void StopHTTPServer();
 
+/** Load of the HTTP server, since it started */
+struct HTTPServerStats {
+    size_t workers{0};
+    size_t max_workers{0};
+    //! Requests waiting for a worker
+    size_t queue_depth{0};
+    uint64_t requests{0};
+    //! Requests on a connection kept alive from an earlier request
+    uint64_t requests_reused{0};
+    //! Requests turned away because the work queue was full
+    uint64_t requests_rejected{0};
+    uint64_t connections{0};
+    size_t connections_open{0};
+};
+
+HTTPServerStats GetHTTPServerStats();
+
 /** Change logging level for libevent. */
 void UpdateHTTPServerLogging(bool enable);
 
@@ -39,11 +69,20 @@ void UpdateHTTPServerLogging(bool enable);
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Handlers of the metrics server, on -metricsport, are kept
+ * apart from those of the RPC port.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, bool metrics = false);
 /** Unregister handler for prefix */
-void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
+void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch, bool metrics = false);
+
+/**
+ * Run fn(i) for every i in [0, count) on the calling thread and on the HTTP
+ * workers that are idle, returning once all have run. A handler uses it to
+ * spread independent parts of a request over the worker pool. The calling
+ * thread takes part, so it completes when no worker is free. fn must not throw.
+ */
+void HTTPParallelFor(size_t count, const std::function<void(size_t)>& fn);
 
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
@@ -58,6 +97,7 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    std::shared_ptr<HTTPReplyStream> m_stream;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, bool replySent = false);
@@ -124,6 +164,29 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a reply with chunked transfer encoding, to be sent with WriteReplyChunk
+     * and finished with WriteReplyEnd.
+     *
+     * @note call this instead of WriteReply, after any WriteHeader.
+     */
+    void WriteReplyStart(int nStatus);
+
+    /**
+     * Send the next chunk of a reply started with WriteReplyStart.
+     * Blocks while more than HTTP_STREAM_WINDOW bytes are still waiting on the client.
+     * Returns false once the connection is closed or the node is shutting down.
+     */
+    bool WriteReplyChunk(Span<const unsigned char> data);
+
+    /**
+     * Finish a reply started with WriteReplyStart. Unless complete, the connection
+     * is dropped instead, so the client sees the body was cut short.
+     *
+     * @note As with WriteReply, do not call any other HTTPRequest methods after this.
+     */
+    void WriteReplyEnd(bool complete = true);
 };
 
 /** Get the query parameter value from request uri for a specified key, or std::nullopt if the key
@@ -0,0 +1,201 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <crypto/sha256.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <script/script.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <utility>
+
+
+constexpr uint8_t DB_ADDRESS_OUTPUT{'o'};
+constexpr uint8_t DB_ADDRESS_SPENT{'s'};
+
+std::unique_ptr<AddressIndex> g_address_index;
+
+/**
+ * Key of an output, [DB_ADDRESS_OUTPUT, script hash, height (BE), txid, vout (BE)].
+ * The height and vout are big endian so the outputs of a script are ordered
+ * by height, then by transaction. The value is the output's value.
+ */
+struct DBOutputKey {
+    uint256 script_hash;
+    int height{0};
+    COutPoint outpoint;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_ADDRESS_OUTPUT);
+        s << script_hash;
+        ser_writedata32be(s, height);
+        s << outpoint.hash;
+        ser_writedata32be(s, outpoint.n);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_ADDRESS_OUTPUT) {
+            throw std::ios_base::failure("Invalid format for address index DB output key");
+        }
+        s >> script_hash;
+        height = ser_readdata32be(s);
+        s >> outpoint.hash;
+        outpoint.n = ser_readdata32be(s);
+    }
+};
+
+static uint256 ScriptHash(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+/** Records a block contributes to the index. */
+struct BlockAddressRecords {
+    std::vector<std::pair<DBOutputKey, CAmount>> outputs;
+    std::vector<std::pair<COutPoint, AddressSpend>> spends;
+};
+
+static void ParseBlock(const CBlock& block, int height, BlockAddressRecords& records)
+{
+    for (const auto& tx : block.vtx) {
+        const uint256& txid{tx->GetHash()};
+        if (!tx->IsCoinBase()) {
+            for (uint32_t i = 0; i < tx->vin.size(); ++i) {
+                records.spends.emplace_back(tx->vin[i].prevout, AddressSpend{txid, i, height});
+            }
+        }
+        for (uint32_t n = 0; n < tx->vout.size(); ++n) {
+            const CTxOut& out{tx->vout[n]};
+            // Neither the coinstake marker nor data outputs can be spent
+            if (out.IsEmpty() || out.scriptPubKey.IsUnspendable()) continue;
+            records.outputs.emplace_back(DBOutputKey{ScriptHash(out.scriptPubKey), height, COutPoint{txid, n}}, out.nValue);
+        }
+    }
+}
+
+/** Access to the address index database (indexes/address/) */
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    bool ReadSpend(const COutPoint& outpoint, AddressSpend& spend) const;
+
+    /// Write the records of a connected block.
+    bool WriteRecords(const BlockAddressRecords& records);
+
+    /// Erase the records of a disconnected block.
+    bool EraseRecords(const BlockAddressRecords& records);
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "address", n_cache_size, f_memory, f_wipe)
+{}
+
+bool AddressIndex::DB::ReadSpend(const COutPoint& outpoint, AddressSpend& spend) const
+{
+    return Read(std::make_pair(DB_ADDRESS_SPENT, outpoint), spend);
+}
+
+bool AddressIndex::DB::WriteRecords(const BlockAddressRecords& records)
+{
+    CDBBatch batch(*this);
+    for (const auto& [key, value] : records.outputs) {
+        batch.Write(key, value);
+    }
+    for (const auto& [outpoint, spend] : records.spends) {
+        batch.Write(std::make_pair(DB_ADDRESS_SPENT, outpoint), spend);
+    }
+    return WriteBatch(batch);
+}
+
+bool AddressIndex::DB::EraseRecords(const BlockAddressRecords& records)
+{
+    CDBBatch batch(*this);
+    for (const auto& [key, value] : records.outputs) {
+        batch.Erase(key);
+    }
+    for (const auto& [outpoint, spend] : records.spends) {
+        batch.Erase(std::make_pair(DB_ADDRESS_SPENT, outpoint));
+    }
+    return WriteBatch(batch);
+}
+
+AddressIndex::AddressIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "addressindex"), m_db(std::make_unique<AddressIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AddressIndex::~AddressIndex() = default;
+
+bool AddressIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    // Exclude genesis block transaction because outputs are not spendable.
+    if (block.height == 0) return true;
+
+    assert(block.data);
+    BlockAddressRecords records;
+    ParseBlock(*block.data, block.height, records);
+    return m_db->WriteRecords(records);
+}
+
+bool AddressIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    LOCK(cs_main);
+    const CBlockIndex* iter_tip{m_chainstate->m_blockman.LookupBlockIndex(current_tip.hash)};
+    const CBlockIndex* new_tip_index{m_chainstate->m_blockman.LookupBlockIndex(new_tip.hash)};
+
+    do {
+        std::shared_ptr<const CBlock> block;
+        if (!ReadRewoundBlock(*iter_tip, block)) return false;
+
+        BlockAddressRecords records;
+        ParseBlock(*block, iter_tip->nHeight, records);
+        if (!m_db->EraseRecords(records)) return false;
+
+        iter_tip = iter_tip->GetAncestor(iter_tip->nHeight - 1);
+    } while (new_tip_index != iter_tip);
+
+    return true;
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+bool AddressIndex::FindOutputs(const CScript& script, const AddressQuery& query, std::vector<AddressOutput>& outputs) const
+{
+    const uint256 script_hash{ScriptHash(script)};
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    for (db_it->Seek(DBOutputKey{script_hash, query.start_height, COutPoint{uint256(), 0}}); db_it->Valid(); db_it->Next()) {
+        DBOutputKey key;
+        if (!db_it->GetKey(key) || key.script_hash != script_hash || key.height > query.end_height) break;
+
+        AddressOutput output{key.height, key.outpoint, /*value=*/0, /*spent=*/std::nullopt};
+        if (!db_it->GetValue(output.value)) {
+            return error("%s: Cannot read address index output %s", __func__, key.outpoint.ToString());
+        }
+        AddressSpend spend;
+        if (m_db->ReadSpend(key.outpoint, spend)) output.spent = spend;
+        if (query.unspent_only && output.spent) continue;
+
+        outputs.push_back(std::move(output));
+        if (query.count > 0 && outputs.size() >= query.count) break;
+    }
+    return true;
+}
+
+bool AddressIndex::FindSpend(const COutPoint& outpoint, AddressSpend& spend) const
+{
+    return m_db->ReadSpend(outpoint, spend);
+}
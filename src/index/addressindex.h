@@ -0,0 +1,93 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <consensus/amount.h>
+#include <index/base.h>
+#include <primitives/transaction.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <limits>
+#include <optional>
+#include <vector>
+
+class CScript;
+
+static constexpr bool DEFAULT_ADDRESSINDEX{false};
+
+/** The input spending an indexed output. */
+struct AddressSpend {
+    uint256 txid;
+    uint32_t input{0};
+    int height{0};
+
+    SERIALIZE_METHODS(AddressSpend, obj) { READWRITE(obj.txid, obj.input, obj.height); }
+};
+
+/** An output paying to an indexed script, with the input spending it if it is spent. */
+struct AddressOutput {
+    int height{0};
+    COutPoint outpoint;
+    CAmount value{0};
+    std::optional<AddressSpend> spent;
+};
+
+/** Outputs of a script to look up, see AddressIndex::FindOutputs. */
+struct AddressQuery {
+    int start_height{0}; //!< inclusive range of heights the outputs are created at
+    int end_height{std::numeric_limits<int>::max()};
+    size_t count{0};     //!< most outputs to return, 0 for all in range
+    bool unspent_only{false};
+};
+
+/**
+ * AddressIndex records, for every spendable output in the chain, the script
+ * it pays to, and for every spent output the input spending it, so that the
+ * outputs and spends of a script can be listed without a rescan or an
+ * external indexer.
+ *
+ * Outputs are keyed by the SHA256 of their scriptPubKey, then by height, so
+ * the outputs of a script over a range of heights cost a seek and a scan of
+ * the range. Unspendable outputs, such as the OP_RETURN chunks of stored
+ * assets, are left out.
+ */
+class AddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    bool AllowPrune() const override { return false; }
+
+protected:
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AddressIndex() override;
+
+    /// Look up the outputs paying to script, in order of height, with the
+    /// inputs spending them.
+    bool FindOutputs(const CScript& script, const AddressQuery& query, std::vector<AddressOutput>& outputs) const;
+
+    /// Look up the input spending an output. Returns false if it is unspent or not indexed.
+    bool FindSpend(const COutPoint& outpoint, AddressSpend& spend) const;
+};
+
+/// The global address index, used by the address RPCs. May be null.
+extern std::unique_ptr<AddressIndex> g_address_index;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
@@ -13,6 +13,7 @@
 #include <node/interface_ui.h>
 #include <shutdown.h>
 #include <tinyformat.h>
+#include <undo.h>
 #include <util/syscall_sandbox.h>
 #include <util/system.h>
 #include <util/thread.h>
@@ -20,13 +21,19 @@
 #include <validation.h> // For g_chainman
 #include <warnings.h>
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 #include <utility>
 
 using node::ReadBlockFromDisk;
+using node::UndoReadFromDisk;
 
 constexpr uint8_t DB_BEST_BLOCK{'B'};
 
+//! Most disconnected blocks an index keeps for rewinding, as deeper reorgs are rare
+constexpr size_t MAX_DISCONNECTED_BLOCKS{100};
+
 constexpr auto SYNC_LOG_INTERVAL{30s};
 constexpr auto SYNC_LOCATOR_WRITE_INTERVAL{30s};
 
@@ -49,14 +56,29 @@ CBlockLocator GetLocator(interfaces::Chain& chain, const uint256& block_hash)
     return locator;
 }
 
+/** Name of an index database, its directory under indexes/ */
+static std::string IndexDBName(const fs::path& path)
+{
+    fs::path relative{path.lexically_relative(gArgs.GetDataDirNet() / "indexes")};
+    if (relative.empty() || *relative.begin() == "..") return fs::PathToString(path.stem());
+    if (relative.filename() == "db") relative = relative.parent_path();
+    return fs::PathToString(relative);
+}
+
 BaseIndex::DB::DB(const fs::path& path, size_t n_cache_size, bool f_memory, bool f_wipe, bool f_obfuscate) :
     CDBWrapper{DBParams{
         .path = path,
+        .name = IndexDBName(path),
         .cache_bytes = n_cache_size,
         .memory_only = f_memory,
         .wipe_data = f_wipe,
         .obfuscate = f_obfuscate,
-        .options = [] { DBOptions options; node::ReadDatabaseArgs(gArgs, options); return options; }()}}
+        .options = [&] {
+            DBOptions options;
+            // Checked at startup already
+            (void)node::ReadDatabaseArgs(gArgs, options, IndexDBName(path));
+            return options;
+        }()}}
 {}
 
 bool BaseIndex::DB::ReadBestBlock(CBlockLocator& locator) const
@@ -138,6 +160,78 @@ bool BaseIndex::Init()
     return true;
 }
 
+void IndexSyncBlocks::Join(const BaseIndex& index, int height)
+{
+    LOCK(m_mutex);
+    m_heights[&index] = height;
+}
+
+void IndexSyncBlocks::Leave(const BaseIndex& index)
+{
+    LOCK(m_mutex);
+    m_heights.erase(&index);
+    if (m_heights.empty()) m_blocks.clear();
+    m_cv.notify_all();
+}
+
+std::shared_ptr<const CBlock> IndexSyncBlocks::Get(const BaseIndex& index, const CBlockIndex& pindex, const CThreadInterrupt& interrupt)
+{
+    const uint256 hash{pindex.GetBlockHash()};
+    WAIT_LOCK(m_mutex, lock);
+    m_heights[&index] = pindex.nHeight;
+    m_cv.notify_all();
+
+    // The index furthest behind never waits, so neither does any index for long
+    const auto held_back = [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return std::any_of(m_heights.begin(), m_heights.end(), [&](const auto& other) {
+            const int gap{pindex.nHeight - other.second};
+            return gap > WINDOW && gap <= MAX_WAIT_GAP;
+        });
+    };
+    while (held_back() && !interrupt) {
+        m_cv.wait_for(lock, std::chrono::milliseconds{100});
+    }
+    if (interrupt) return nullptr;
+
+    while (true) {
+        const auto it{m_blocks.find(hash)};
+        if (it == m_blocks.end()) break;
+        if (!it->second.reading) return it->second.block;
+        m_cv.wait(lock);
+    }
+
+    // Drop the blocks every index is past, or that are too far behind to be taken
+    const int min_height{std::min_element(m_heights.begin(), m_heights.end(), [](const auto& a, const auto& b) {
+        return a.second < b.second;
+    })->second};
+    for (auto it = m_blocks.begin(); it != m_blocks.end();) {
+        if (!it->second.reading && (it->second.height < min_height || it->second.height + WINDOW < pindex.nHeight)) {
+            it = m_blocks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_blocks.emplace(hash, Entry{pindex.nHeight});
+    auto block{std::make_shared<CBlock>()};
+    bool read;
+    {
+        REVERSE_LOCK(lock);
+        read = ReadBlockFromDisk(*block, &pindex, Params().GetConsensus());
+    }
+    // Entries being read are never dropped
+    const auto it{m_blocks.find(hash)};
+    if (read) {
+        it->second.block = block;
+        it->second.reading = false;
+    } else {
+        m_blocks.erase(it);
+        block.reset();
+    }
+    m_cv.notify_all();
+    return block;
+}
+
 static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev, CChain& chain) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     AssertLockHeld(cs_main);
@@ -159,8 +253,6 @@ void BaseIndex::ThreadSync()
     SetSyscallSandboxPolicy(SyscallSandboxPolicy::TX_INDEX);
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
-        auto& consensus_params = Params().GetConsensus();
-
         std::chrono::steady_clock::time_point last_log_time{0s};
         std::chrono::steady_clock::time_point last_locator_write_time{0s};
         while (true) {
@@ -205,14 +297,20 @@ void BaseIndex::ThreadSync()
                 Commit();
             }
 
-            CBlock block;
+            const std::shared_ptr<const CBlock> block{m_sync_blocks->Get(*this, *pindex, m_interrupt)};
+            if (!block && m_interrupt) {
+                SetBestBlockIndex(pindex->pprev);
+                // No need to handle errors in Commit. See rationale above.
+                Commit();
+                return;
+            }
             interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex);
-            if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            if (!block) {
                 FatalError("%s: Failed to read block %s from disk",
                            __func__, pindex->GetBlockHash().ToString());
                 return;
             } else {
-                block_info.data = &block;
+                block_info.data = block.get();
             }
             if (!CustomAppend(block_info)) {
                 FatalError("%s: Failed to write block %s to index database",
@@ -269,6 +367,62 @@ bool BaseIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_ti
         return false;
     }
 
+    LOCK(m_disconnected_mutex);
+    m_disconnected.erase(std::remove_if(m_disconnected.begin(), m_disconnected.end(), [&](const auto& disconnected) {
+        return disconnected->pindex->nHeight > new_tip->nHeight;
+    }), m_disconnected.end());
+
+    return true;
+}
+
+void BaseIndex::BlockDisconnectedWithUndo(const std::shared_ptr<const DisconnectedBlock>& disconnected)
+{
+    // Until synced, the sync thread rewinds from disk
+    if (!m_synced) {
+        return;
+    }
+
+    LOCK(m_disconnected_mutex);
+    if (m_disconnected.size() >= MAX_DISCONNECTED_BLOCKS) {
+        m_disconnected.erase(m_disconnected.begin());
+    }
+    m_disconnected.push_back(disconnected);
+}
+
+std::shared_ptr<const DisconnectedBlock> BaseIndex::FindDisconnected(const CBlockIndex& pindex) const
+{
+    LOCK(m_disconnected_mutex);
+    const auto it{std::find_if(m_disconnected.begin(), m_disconnected.end(), [&](const auto& disconnected) {
+        return disconnected->pindex == &pindex;
+    })};
+    return it != m_disconnected.end() ? *it : nullptr;
+}
+
+bool BaseIndex::ReadRewoundBlock(const CBlockIndex& pindex, std::shared_ptr<const CBlock>& block) const
+{
+    if (const auto disconnected{FindDisconnected(pindex)}) {
+        block = disconnected->block;
+        return true;
+    }
+    auto read{std::make_shared<CBlock>()};
+    if (!ReadBlockFromDisk(*read, &pindex, Params().GetConsensus())) {
+        return error("%s: Failed to read block %s from disk", __func__, pindex.GetBlockHash().ToString());
+    }
+    block = std::move(read);
+    return true;
+}
+
+bool BaseIndex::ReadRewoundUndo(const CBlockIndex& pindex, std::shared_ptr<const CBlockUndo>& undo) const
+{
+    if (const auto disconnected{FindDisconnected(pindex)}; disconnected && disconnected->undo) {
+        undo = disconnected->undo;
+        return true;
+    }
+    auto read{std::make_shared<CBlockUndo>()};
+    if (!UndoReadFromDisk(*read, &pindex)) {
+        return error("%s: Failed to read undo data of block %s from disk", __func__, pindex.GetBlockHash().ToString());
+    }
+    undo = std::move(read);
     return true;
 }
 
@@ -392,8 +546,9 @@ bool BaseIndex::Start()
     // removed in followup https://github.com/bitcoin/bitcoin/pull/24230
     m_chainstate = &m_chain->context()->chainman->ActiveChainstate();
     // Need to register this ValidationInterface before running Init(), so that
-    // callbacks are not missed if Init sets m_synced to true.
-    RegisterValidationInterface(this);
+    // callbacks are not missed if Init sets m_synced to true. Notifications come
+    // on a lane of the index's own, so that a slow index holds up no one else.
+    RegisterValidationInterface(this, /*lane=*/GetName());
     if (!Init()) return false;
 
     const CBlockIndex* index = m_best_block_index.load();
@@ -401,7 +556,14 @@ bool BaseIndex::Start()
         return false;
     }
 
-    m_thread_sync = std::thread(&util::TraceThread, GetName(), [this] { ThreadSync(); });
+    // Sync on its own if not sharing blocks with other indexes
+    if (!m_sync_blocks) m_sync_blocks = std::make_shared<IndexSyncBlocks>();
+    if (!m_synced) m_sync_blocks->Join(*this, index ? index->nHeight : -1);
+
+    m_thread_sync = std::thread(&util::TraceThread, GetName(), [this] {
+        ThreadSync();
+        m_sync_blocks->Leave(*this);
+    });
     return true;
 }
 
@@ -414,6 +576,11 @@ void BaseIndex::Stop()
     }
 }
 
+size_t BaseIndex::EstimateDiskSize() const
+{
+    return GetDB().EstimateSize(uint8_t{0x00}, uint8_t{0xff});
+}
+
 IndexSummary BaseIndex::GetSummary() const
 {
     IndexSummary summary{};
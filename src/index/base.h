@@ -7,13 +7,20 @@
 
 #include <dbwrapper.h>
 #include <interfaces/chain.h>
+#include <sync.h>
+#include <uint256.h>
 #include <util/threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <condition_variable>
+#include <map>
+#include <memory>
 #include <string>
 
+class BaseIndex;
 class CBlock;
 class CBlockIndex;
+class CBlockUndo;
 class Chainstate;
 namespace interfaces {
 class Chain;
@@ -25,6 +32,48 @@ struct IndexSummary {
     int best_block_height{0};
 };
 
+/**
+ * Blocks shared between the initial syncs of indexes, so rebuilding several
+ * indexes reads each block from disk once. Each index still syncs on its own
+ * thread, appending and committing in height order, so the indexes work on a
+ * block in parallel: the first one to need it reads it, and the others take
+ * it from here.
+ *
+ * To keep them sharing, an index is held back from running more than WINDOW
+ * blocks ahead of an index close behind it. An index further behind than
+ * MAX_WAIT_GAP catches up on its own until it is close.
+ */
+class IndexSyncBlocks
+{
+private:
+    struct Entry {
+        int height;
+        //! Null while it is being read
+        std::shared_ptr<const CBlock> block{};
+        bool reading{true};
+    };
+
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    std::map<uint256, Entry> m_blocks GUARDED_BY(m_mutex);
+    //! Height of the block each syncing index is at
+    std::map<const BaseIndex*, int> m_heights GUARDED_BY(m_mutex);
+
+public:
+    static constexpr int WINDOW{32};
+    static constexpr int MAX_WAIT_GAP{1000};
+
+    /// Start sharing blocks with the given index, which synced up to height.
+    void Join(const BaseIndex& index, int height) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Stop sharing blocks with the given index, and stop holding others back for it.
+    void Leave(const BaseIndex& index) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Get the block at pindex for index, reading it from disk unless another
+    /// index did. Returns null if it could not be read, or on interrupt.
+    std::shared_ptr<const CBlock> Get(const BaseIndex& index, const CBlockIndex& pindex, const CThreadInterrupt& interrupt) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
 /**
  * Base class for indices of blockchain data. This implements
  * CValidationInterface and ensures blocks are indexed sequentially according
@@ -68,6 +117,7 @@ private:
 
     std::thread m_thread_sync;
     CThreadInterrupt m_interrupt;
+    std::shared_ptr<IndexSyncBlocks> m_sync_blocks;
 
     /// Read best block locator and check that data needed to sync has not been pruned.
     bool Init();
@@ -92,6 +142,12 @@ private:
     /// Loop over disconnected blocks and call CustomRewind.
     bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip);
 
+    /// Blocks disconnected since the index last rewound, in the order they
+    /// were, with the undo data DisconnectTip read for them.
+    mutable Mutex m_disconnected_mutex;
+    std::vector<std::shared_ptr<const DisconnectedBlock>> m_disconnected GUARDED_BY(m_disconnected_mutex);
+    std::shared_ptr<const DisconnectedBlock> FindDisconnected(const CBlockIndex& pindex) const EXCLUSIVE_LOCKS_REQUIRED(!m_disconnected_mutex);
+
     virtual bool AllowPrune() const = 0;
 
 protected:
@@ -101,6 +157,8 @@ protected:
 
     void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
 
+    void BlockDisconnectedWithUndo(const std::shared_ptr<const DisconnectedBlock>& disconnected) override EXCLUSIVE_LOCKS_REQUIRED(!m_disconnected_mutex);
+
     void ChainStateFlushed(const CBlockLocator& locator) override;
 
     /// Initialize internal state from the database and block index.
@@ -117,6 +175,12 @@ protected:
     /// be an ancestor of the current best block.
     [[nodiscard]] virtual bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) { return true; }
 
+    /// Read a block CustomRewind rewinds past, or its undo data, taking what
+    /// DisconnectTip loaded when the block was disconnected, or else reading
+    /// it from disk.
+    bool ReadRewoundBlock(const CBlockIndex& pindex, std::shared_ptr<const CBlock>& block) const EXCLUSIVE_LOCKS_REQUIRED(!m_disconnected_mutex);
+    bool ReadRewoundUndo(const CBlockIndex& pindex, std::shared_ptr<const CBlockUndo>& undo) const EXCLUSIVE_LOCKS_REQUIRED(!m_disconnected_mutex);
+
     virtual DB& GetDB() const = 0;
 
     /// Get the name of the index for display in logs.
@@ -139,6 +203,10 @@ public:
 
     void Interrupt();
 
+    /// Share the blocks read for the initial sync with the other indexes given
+    /// the same IndexSyncBlocks. Must be called before Start().
+    void SetSyncBlocks(std::shared_ptr<IndexSyncBlocks> sync_blocks) { m_sync_blocks = std::move(sync_blocks); }
+
     /// Start initializes the sync state and registers the instance as a
     /// ValidationInterface so that it stays in sync with blockchain updates.
     [[nodiscard]] bool Start();
@@ -146,6 +214,10 @@ public:
     /// Stops the instance from staying in sync with blockchain updates.
     void Stop();
 
+    /// Estimated size of the index database on disk, not counting any files
+    /// of its own, such as the filters of a block filter index.
+    size_t EstimateDiskSize() const;
+
     /// Get a summary of the index and its state.
     IndexSummary GetSummary() const;
 };
@@ -4,10 +4,14 @@
 
 #include <map>
 
+#include <chainparams.h>
 #include <dbwrapper.h>
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <node/blockstorage.h>
+#include <opfile/src/chunk.h>
+#include <opfile/src/decode.h>
+#include <storage/chunk.h>
 #include <util/fs_helpers.h>
 #include <util/system.h>
 #include <validation.h>
@@ -214,6 +218,46 @@ size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos& pos, const BlockFilter&
     return data_size;
 }
 
+GCSFilter::ElementSet StorageFilterElements(const CBlock& block, int height)
+{
+    GCSFilter::ElementSet elements;
+
+    // Assets are only recognised after the storage activation height
+    if (height <= int(Params().GetConsensus().nUUIDBlockStart)) return elements;
+
+    for (const CTransactionRef& tx : block.vtx) {
+        if (tx->IsCoinBase() || tx->IsCoinStake()) continue;
+
+        for (const CTxOut& txout : tx->vout) {
+            const CScript& script = txout.scriptPubKey;
+            if (!script.IsOpReturn()) continue;
+
+            // Authdata; additions gate fetching a tenant's assets
+            auth_view auth;
+            if (parse_auth_from_script(script, auth)) {
+                if (auth.operation == OPAUTH_ADDUSER_BIN) {
+                    const uint160 user{get_hash160_from_auth(auth)};
+                    elements.emplace(user.begin(), user.end());
+                }
+                continue;
+            }
+
+            chunk_view view;
+            int error_level;
+            if (!parse_chunk_from_script(script, view, error_level)) continue;
+            elements.emplace(view.uuid.begin(), view.uuid.end());
+
+            // The signer of the header chunk is the tenant storing the asset
+            uint160 tenant;
+            if (view.chunklen == 0 && recover_tenant_from_header(view, tenant)) {
+                elements.emplace(tenant.begin(), tenant.end());
+            }
+        }
+    }
+
+    return elements;
+}
+
 bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
 {
     CBlockUndo block_undo;
@@ -223,7 +267,8 @@ bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
         // pindex variable gives indexing code access to node internals. It
         // will be removed in upcoming commit
         const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
-        if (!UndoReadFromDisk(block_undo, pindex)) {
+        // The storage filter only looks at the outputs of the block
+        if (m_filter_type != BlockFilterType::STORAGE && !UndoReadFromDisk(block_undo, pindex)) {
             return false;
         }
 
@@ -241,7 +286,9 @@ bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
         prev_header = read_out.second.header;
     }
 
-    BlockFilter filter(m_filter_type, *Assert(block.data), block_undo);
+    BlockFilter filter{m_filter_type == BlockFilterType::STORAGE ?
+                           BlockFilter(m_filter_type, block.hash, StorageFilterElements(*Assert(block.data), block.height)) :
+                           BlockFilter(m_filter_type, *Assert(block.data), block_undo)};
 
     size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
     if (bytes_written == 0) return false;
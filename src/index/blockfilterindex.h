@@ -75,6 +75,13 @@ public:
                                std::vector<uint256>& hashes_out) const;
 };
 
+/**
+ * The elements of the storage filter of a block: the uuid of every chunk it
+ * holds, the tenant recovered from every header chunk and the user of every
+ * authdata addition. Empty below the storage activation height.
+ */
+GCSFilter::ElementSet StorageFilterElements(const CBlock& block, int height);
+
 /**
  * Get a block filter index by type. Returns nullptr if index has not been initialized or was
  * already destroyed.
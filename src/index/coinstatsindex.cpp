@@ -19,7 +19,6 @@ using kernel::CCoinsStats;
 using kernel::GetBogoSize;
 using kernel::TxOutSer;
 
-using node::ReadBlockFromDisk;
 using node::UndoReadFromDisk;
 
 static constexpr uint8_t DB_BLOCK_HASH{'s'};
@@ -118,7 +117,8 @@ bool CoinStatsIndex::CustomAppend(const interfaces::BlockInfo& block)
 {
     CBlockUndo block_undo;
     const CBlockIndex* pindex = WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash));
-    uint256 prevHash = pindex->pprev->GetBlockHash();
+    // The genesis block has no parent to seed its subsidy
+    const uint256 prevHash{pindex->pprev ? pindex->pprev->GetBlockHash() : uint256{}};
     const CAmount block_subsidy{GetBlockSubsidy(block.height, Params().GetConsensus(), prevHash)};
     m_total_subsidy += block_subsidy;
 
@@ -283,17 +283,13 @@ bool CoinStatsIndex::CustomRewind(const interfaces::BlockKey& current_tip, const
         LOCK(cs_main);
         const CBlockIndex* iter_tip{m_chainstate->m_blockman.LookupBlockIndex(current_tip.hash)};
         const CBlockIndex* new_tip_index{m_chainstate->m_blockman.LookupBlockIndex(new_tip.hash)};
-        const auto& consensus_params{Params().GetConsensus()};
 
         do {
-            CBlock block;
-
-            if (!ReadBlockFromDisk(block, iter_tip, consensus_params)) {
-                return error("%s: Failed to read block %s from disk",
-                             __func__, iter_tip->GetBlockHash().ToString());
-            }
+            std::shared_ptr<const CBlock> block;
+            std::shared_ptr<const CBlockUndo> block_undo;
+            if (!ReadRewoundBlock(*iter_tip, block) || !ReadRewoundUndo(*iter_tip, block_undo)) return false;
 
-            ReverseBlock(block, iter_tip);
+            ReverseBlock(*block, *block_undo, iter_tip);
 
             iter_tip = iter_tip->GetAncestor(iter_tip->nHeight - 1);
         } while (new_tip_index != iter_tip);
@@ -400,9 +396,8 @@ bool CoinStatsIndex::CustomCommit(CDBBatch& batch)
 }
 
 // Reverse a single block as part of a reorg
-bool CoinStatsIndex::ReverseBlock(const CBlock& block, const CBlockIndex* pindex)
+bool CoinStatsIndex::ReverseBlock(const CBlock& block, const CBlockUndo& block_undo, const CBlockIndex* pindex)
 {
-    CBlockUndo block_undo;
     std::pair<uint256, DBVal> read_out;
 
     uint256 prevHash = pindex->pprev->GetBlockHash();
@@ -411,10 +406,6 @@ bool CoinStatsIndex::ReverseBlock(const CBlock& block, const CBlockIndex* pindex
 
     // Ignore genesis block
     if (pindex->nHeight > 0) {
-        if (!UndoReadFromDisk(block_undo, pindex)) {
-            return false;
-        }
-
         if (!m_db->Read(DBHeightKey(pindex->nHeight - 1), read_out)) {
             return false;
         }
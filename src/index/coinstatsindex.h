@@ -38,7 +38,7 @@ private:
     CAmount m_total_unspendables_scripts{0};
     CAmount m_total_unspendables_unclaimed_rewards{0};
 
-    bool ReverseBlock(const CBlock& block, const CBlockIndex* pindex);
+    bool ReverseBlock(const CBlock& block, const CBlockUndo& block_undo, const CBlockIndex* pindex);
 
     bool AllowPrune() const override { return true; }
 
@@ -54,6 +54,9 @@ protected:
     BaseIndex::DB& GetDB() const override { return *m_db; }
 
 public:
+    // Rewinding reverses each block with its undo data.
+    bool WantsDisconnectedUndo() const override { return true; }
+
     // Constructs the index, which becomes available to be queried.
     explicit CoinStatsIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
 
@@ -0,0 +1,281 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/stakeindex.h>
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <consensus/consensus.h>
+#include <crypto/sha256.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <optional>
+#include <utility>
+
+using node::UndoReadFromDisk;
+
+constexpr uint8_t DB_STAKE_BLOCK{'b'};
+constexpr uint8_t DB_STAKE_SCRIPT{'a'};
+constexpr uint8_t DB_STAKE_TOTALS{'t'};
+
+std::unique_ptr<StakeIndex> g_stake_index;
+
+namespace {
+
+/** Staking from the genesis block up to and including a height. */
+struct StakeTotals {
+    uint64_t pos_blocks{0};
+    CAmount stake_amount{0};
+    CAmount reward{0};
+    //! Sum of the work of the stake targets, as GetBlockProof() takes it
+    uint256 kernel_work;
+    //! Time of the last proof-of-stake block, 0 if there is none yet
+    uint32_t last_stake_time{0};
+
+    SERIALIZE_METHODS(StakeTotals, obj)
+    {
+        READWRITE(obj.pos_blocks, obj.stake_amount, obj.reward, obj.kernel_work, obj.last_stake_time);
+    }
+};
+
+/** Key of a height, [prefix, height (BE)], so the keys of a prefix are ordered by height. */
+template <uint8_t prefix>
+struct DBHeightKey {
+    int height{0};
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, prefix);
+        ser_writedata32be(s, height);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != prefix) {
+            throw std::ios_base::failure("Invalid format for stake index DB height key");
+        }
+        height = ser_readdata32be(s);
+    }
+};
+
+using DBBlockKey = DBHeightKey<DB_STAKE_BLOCK>;
+using DBTotalsKey = DBHeightKey<DB_STAKE_TOTALS>;
+
+/** Key of a stake by its staker, [DB_STAKE_SCRIPT, script hash, height (BE)]. */
+struct DBScriptKey {
+    uint256 script_hash;
+    int height{0};
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_STAKE_SCRIPT);
+        s << script_hash;
+        ser_writedata32be(s, height);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != DB_STAKE_SCRIPT) {
+            throw std::ios_base::failure("Invalid format for stake index DB script key");
+        }
+        s >> script_hash;
+        height = ser_readdata32be(s);
+    }
+};
+
+uint256 StakerHash(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+/** The work of a stake target, as GetBlockProof() has it, 0 if bits is not a valid target */
+arith_uint256 StakeWork(uint32_t bits)
+{
+    bool negative;
+    bool overflow;
+    arith_uint256 target;
+    target.SetCompact(bits, &negative, &overflow);
+    if (negative || overflow || target == 0) return 0;
+    return (~target / (target + 1)) + 1;
+}
+
+}; // namespace
+
+bool ReadStakeRecord(const CBlock& block, const CBlockUndo& block_undo, StakeRecord& record)
+{
+    if (!block.IsProofOfStake() || block.vtx.size() < 2 || !block.vtx[1]->IsCoinStake()) return false;
+    const CTransaction& coinstake{*block.vtx[1]};
+    // The coinbase has no undo data, so the coinstake's comes first
+    if (block_undo.vtxundo.empty() || block_undo.vtxundo[0].vprevout.size() != coinstake.vin.size()) return false;
+    const std::vector<Coin>& spent{block_undo.vtxundo[0].vprevout};
+
+    record.staker_script = coinstake.vout[1].scriptPubKey;
+    record.kernel = coinstake.vin[0].prevout;
+    record.stake_amount = spent[0].out.nValue;
+    record.reward = coinstake.GetValueOut();
+    for (const Coin& coin : spent) {
+        record.reward -= coin.out.nValue;
+    }
+    return true;
+}
+
+/** Access to the stake index database (indexes/stake/) */
+class StakeIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    bool ReadTotals(int height, StakeTotals& totals) const
+    {
+        return Read(DBTotalsKey{height}, totals);
+    }
+
+    /// Write the totals up to height, and the stake of the block at height if it has one.
+    bool WriteBlock(int height, const StakeTotals& totals, const std::optional<StakeRecord>& stake);
+
+    /// Erase the stakes and totals of the heights above new_height up to old_height.
+    bool EraseBlocks(int old_height, int new_height);
+};
+
+StakeIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "stake", n_cache_size, f_memory, f_wipe)
+{}
+
+bool StakeIndex::DB::WriteBlock(int height, const StakeTotals& totals, const std::optional<StakeRecord>& stake)
+{
+    CDBBatch batch(*this);
+    batch.Write(DBTotalsKey{height}, totals);
+    if (stake) {
+        batch.Write(DBBlockKey{height}, *stake);
+        batch.Write(DBScriptKey{StakerHash(stake->staker_script), height}, *stake);
+    }
+    return WriteBatch(batch);
+}
+
+bool StakeIndex::DB::EraseBlocks(int old_height, int new_height)
+{
+    CDBBatch batch(*this);
+    for (int height = old_height; height > new_height; --height) {
+        StakeRecord stake;
+        if (Read(DBBlockKey{height}, stake)) {
+            batch.Erase(DBBlockKey{height});
+            batch.Erase(DBScriptKey{StakerHash(stake.staker_script), height});
+        }
+        batch.Erase(DBTotalsKey{height});
+    }
+    return WriteBatch(batch);
+}
+
+StakeIndex::StakeIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "stakeindex"), m_db(std::make_unique<StakeIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+StakeIndex::~StakeIndex() = default;
+
+bool StakeIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    StakeTotals totals;
+    if (block.height > 0 && !m_db->ReadTotals(block.height - 1, totals)) {
+        return error("%s: Cannot read stake totals at height %d", __func__, block.height - 1);
+    }
+
+    assert(block.data);
+    std::optional<StakeRecord> stake;
+    if (block.height > 0 && block.data->IsProofOfStake()) {
+        const CBlockIndex* pindex{WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash))};
+        CBlockUndo block_undo;
+        if (!UndoReadFromDisk(block_undo, pindex)) {
+            return error("%s: Failed to read undo data of block %s", __func__, block.hash.ToString());
+        }
+        StakeRecord record;
+        if (ReadStakeRecord(*block.data, block_undo, record)) {
+            record.height = block.height;
+            record.block_hash = block.hash;
+            record.time = block.data->nTime;
+            record.bits = block.data->nBits;
+            record.hash_proof = WITH_LOCK(cs_main, return pindex->hashProof);
+
+            ++totals.pos_blocks;
+            totals.stake_amount += record.stake_amount;
+            totals.reward += record.reward;
+            totals.kernel_work = ArithToUint256(UintToArith256(totals.kernel_work) + StakeWork(record.bits));
+            totals.last_stake_time = record.time;
+            stake = std::move(record);
+        }
+    }
+    return m_db->WriteBlock(block.height, totals, stake);
+}
+
+bool StakeIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    return m_db->EraseBlocks(current_tip.height, new_tip.height);
+}
+
+BaseIndex::DB& StakeIndex::GetDB() const { return *m_db; }
+
+bool StakeIndex::FindStakes(const CScript& script, int start_height, int end_height, size_t count, std::vector<StakeRecord>& stakes) const
+{
+    const uint256 script_hash{StakerHash(script)};
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    for (db_it->Seek(DBScriptKey{script_hash, start_height}); db_it->Valid(); db_it->Next()) {
+        DBScriptKey key;
+        if (!db_it->GetKey(key) || key.script_hash != script_hash || key.height > end_height) break;
+
+        StakeRecord stake;
+        if (!db_it->GetValue(stake)) {
+            return error("%s: Cannot read stake at height %d", __func__, key.height);
+        }
+        stakes.push_back(std::move(stake));
+        if (count > 0 && stakes.size() >= count) break;
+    }
+    return true;
+}
+
+bool StakeIndex::FindStake(int height, StakeRecord& stake) const
+{
+    return m_db->Read(DBBlockKey{height}, stake);
+}
+
+bool StakeIndex::GetStats(int start_height, int end_height, StakeRangeStats& stats) const
+{
+    StakeTotals before;
+    StakeTotals to;
+    if (start_height > 0 && !m_db->ReadTotals(start_height - 1, before)) return false;
+    if (!m_db->ReadTotals(end_height, to)) return false;
+
+    stats.start_height = start_height;
+    stats.end_height = end_height;
+    stats.pos_blocks = to.pos_blocks - before.pos_blocks;
+    stats.stake_amount = to.stake_amount - before.stake_amount;
+    stats.reward = to.reward - before.reward;
+
+    // As GetPoSKernelPS(), the work of each stake over the time since the one
+    // before it. With no stake before the range, its first stake only starts
+    // the clock.
+    arith_uint256 work{UintToArith256(to.kernel_work) - UintToArith256(before.kernel_work)};
+    uint32_t since{before.last_stake_time};
+    if (stats.pos_blocks > 0 && since == 0) {
+        std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+        db_it->Seek(DBBlockKey{start_height});
+        StakeRecord first;
+        if (!db_it->Valid() || !db_it->GetValue(first)) return false;
+        work -= StakeWork(first.bits);
+        since = first.time;
+    }
+    if (to.last_stake_time > since) {
+        stats.kernels_per_second = work.getdouble() / (to.last_stake_time - since) * (nStakeTimestampMask + 1);
+    }
+    return true;
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_STAKEINDEX_H
+#define BITCOIN_INDEX_STAKEINDEX_H
+
+#include <consensus/amount.h>
+#include <index/base.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <limits>
+#include <vector>
+
+class CBlock;
+class CBlockUndo;
+
+static constexpr bool DEFAULT_STAKEINDEX{false};
+
+/** The coinstake of a proof-of-stake block. */
+struct StakeRecord {
+    int height{0};
+    uint256 block_hash;
+    uint32_t time{0};
+    uint32_t bits{0};
+    //! Script of the first coinstake output, the one staking
+    CScript staker_script;
+    //! The coin whose kernel met the target, the first coinstake input
+    COutPoint kernel;
+    //! Value of the kernel coin
+    CAmount stake_amount{0};
+    //! Value of the coinstake outputs less that of its inputs: the subsidy and fees claimed
+    CAmount reward{0};
+    uint256 hash_proof;
+
+    SERIALIZE_METHODS(StakeRecord, obj)
+    {
+        READWRITE(obj.height, obj.block_hash, obj.time, obj.bits, obj.staker_script, obj.kernel,
+                  obj.stake_amount, obj.reward, obj.hash_proof);
+    }
+};
+
+/** Staking over a range of heights, see StakeIndex::GetStats. */
+struct StakeRangeStats {
+    int start_height{0};
+    int end_height{0};
+    uint64_t pos_blocks{0};
+    CAmount stake_amount{0};
+    CAmount reward{0};
+    //! Kernel hashes per second the stakes of the range took, as GetPoSKernelPS() estimates it
+    double kernels_per_second{0};
+};
+
+/**
+ * Fill in the staker script, kernel, stake amount and reward of a
+ * proof-of-stake block out of the block and its undo data.
+ * Returns false if the block has no coinstake.
+ */
+bool ReadStakeRecord(const CBlock& block, const CBlockUndo& block_undo, StakeRecord& record);
+
+/**
+ * StakeIndex records the coinstake of every proof-of-stake block, so the
+ * staking history of a script and the staking over a range of heights are
+ * looked up without walking the blocks.
+ *
+ * Besides a record per proof-of-stake block, it keeps running totals at
+ * every height, so the statistics of any range are the difference of two
+ * reads.
+ */
+class StakeIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    bool AllowPrune() const override { return false; }
+
+protected:
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit StakeIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~StakeIndex() override;
+
+    /// Look up the stakes of blocks in [start_height, end_height] staked by
+    /// script, in order of height. count is the most to return, 0 for all.
+    bool FindStakes(const CScript& script, int start_height, int end_height, size_t count, std::vector<StakeRecord>& stakes) const;
+
+    /// Look up the stake of the block at height. Returns false if it is not a proof-of-stake block.
+    bool FindStake(int height, StakeRecord& stake) const;
+
+    /// Sum the stakes of blocks in [start_height, end_height], which must be indexed.
+    bool GetStats(int start_height, int end_height, StakeRangeStats& stats) const;
+};
+
+/// The global stake index, used by the staking history RPCs. May be null.
+extern std::unique_ptr<StakeIndex> g_stake_index;
+
+#endif // BITCOIN_INDEX_STAKEINDEX_H
@@ -0,0 +1,958 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/storageindex.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <node/interface_ui.h>
+#include <opfile/src/chunk.h>
+#include <opfile/src/decode.h>
+#include <opfile/src/protocol.h>
+#include <storage/chunk.h>
+#include <sync.h>
+#include <undo.h>
+#include <util/strencodings.h>
+#include <util/system.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+using node::ReadTransactionFromDisk;
+using node::UndoReadFromDisk;
+
+constexpr uint8_t DB_STORAGE_HEADER{'h'};
+constexpr uint8_t DB_STORAGE_LENGTH{'l'};
+constexpr uint8_t DB_STORAGE_CHUNK{'c'};
+constexpr uint8_t DB_STORAGE_AUTH{'a'};
+constexpr uint8_t DB_STORAGE_TENANT{'t'};
+constexpr uint8_t DB_STORAGE_RECENT{'r'};
+constexpr uint8_t DB_STORAGE_PAYLOAD{'p'};
+constexpr uint8_t DB_STORAGE_CONTENT{'f'};
+constexpr uint8_t DB_STORAGE_USAGE{'u'};
+constexpr uint8_t DB_STORAGE_ASSET_USAGE{'s'};
+constexpr uint8_t DB_STORAGE_KEEP_PAYLOADS{'P'};
+constexpr uint8_t DB_STORAGE_VERSION{'V'};
+
+//! Version of the index layout, 1 added the listing keys, 2 the usage totals
+static constexpr int STORAGE_INDEX_VERSION{2};
+//! Size of the batches payloads are kept in when starting to keep them
+static constexpr size_t MAX_PAYLOAD_BATCH_SIZE{16 << 20};
+
+std::unique_ptr<StorageIndex> g_storage_index;
+
+int64_t StorageAssetInfo::GetFileLength() const
+{
+    if (!length) return 0;
+    return int64_t(length->chunk_total - 1) * get_chunkmax_for_version(header.protocol) + length->final_chunk_len;
+}
+
+std::string StorageListCursor::ToString() const
+{
+    DataStream stream{};
+    ser_writedata32be(stream, uint32_t(STORAGE_MEMPOOL_HEIGHT - height));
+    stream << uuid;
+    return HexStr(stream);
+}
+
+std::optional<StorageListCursor> StorageListCursor::FromString(const std::string& str)
+{
+    if (str.size() != (4 + uint256::size()) * 2 || !IsHex(str)) return std::nullopt;
+    DataStream stream{ParseHex(str)};
+    StorageListCursor cursor;
+    cursor.height = STORAGE_MEMPOOL_HEIGHT - int(ser_readdata32be(stream));
+    stream >> cursor.uuid;
+    if (cursor.height < 0) return std::nullopt;
+    return cursor;
+}
+
+/**
+ * Listing key of an asset, under the tenant that signed its header ('t') or
+ * across all tenants ('r'). The height is stored inverted and big endian, so
+ * that the database orders higher heights first. The value is the header time.
+ */
+struct DBListKey {
+    std::optional<uint160> tenant;
+    int height{0};
+    uint256 uuid;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, tenant ? DB_STORAGE_TENANT : DB_STORAGE_RECENT);
+        if (tenant) s << *tenant;
+        ser_writedata32be(s, uint32_t(STORAGE_MEMPOOL_HEIGHT - height));
+        s << uuid;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix == DB_STORAGE_TENANT) {
+            tenant.emplace();
+            s >> *tenant;
+        } else if (prefix == DB_STORAGE_RECENT) {
+            tenant.reset();
+        } else {
+            throw std::ios_base::failure("Invalid format for storage index DB listing key");
+        }
+        height = STORAGE_MEMPOOL_HEIGHT - int(ser_readdata32be(s));
+        s >> uuid;
+    }
+};
+
+/** Parse a hex uuid into its binary key form. */
+static bool UUIDToKey(const std::string& uuid, uint256& key)
+{
+    if (uuid.size() != OPENCODING_UUID * 2 || !IsHex(uuid)) return false;
+    key = uint256{ParseHex(uuid)};
+    return true;
+}
+
+/** A transaction of a block carrying chunks, counted towards the asset of its first chunk. */
+struct StorageTxRecord {
+    uint256 uuid;
+    size_t index{0}; //!< position in the block
+    CAmount fee{0};  //!< as read from the undo data of the block
+};
+
+/** Records a block contributes to the index. */
+struct BlockStorageRecords {
+    std::vector<std::pair<uint256, StorageHeaderRecord>> headers;
+    std::vector<std::pair<uint256, StorageLengthRecord>> lengths;
+    std::vector<std::pair<std::pair<uint256, uint32_t>, StorageChunkRecord>> chunks;
+    std::vector<std::pair<uint160, int>> auths;
+    std::vector<StorageTxRecord> txs;
+
+    bool empty() const { return headers.empty() && lengths.empty() && chunks.empty() && auths.empty(); }
+};
+
+/** Access to the storage index database (indexes/storage/) */
+class StorageIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    bool ReadHeader(const uint256& uuid, StorageHeaderRecord& record) const;
+    bool ReadLength(const uint256& uuid, StorageLengthRecord& record) const;
+    bool ReadChunk(const uint256& uuid, uint32_t chunknum, StorageChunkRecord& record) const;
+    bool ReadAuth(const uint160& hash160, int& height) const;
+    //! The kept script of a chunk, the header chunk being chunknum 0
+    bool ReadPayload(const uint256& uuid, uint32_t chunknum, CScript& script) const;
+
+    /// Write a block's worth of new records. Records for keys that are
+    /// already indexed are left untouched, so the first occurrence wins.
+    bool WriteRecords(const BlockStorageRecords& records);
+
+    /// Erase the records of a disconnected block at the given height.
+    bool EraseRecords(const BlockStorageRecords& records, int height);
+
+    /// Record the version of the layout, in a new index. Older ones are wiped by OpenDB.
+    bool Upgrade();
+
+    /// Record whether payloads are kept from here on. Starting to keep them
+    /// reads the payloads of the records indexed so far from the block files.
+    bool KeepPayloads(bool keep);
+};
+
+StorageIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "storage", n_cache_size, f_memory, f_wipe)
+{}
+
+bool StorageIndex::DB::ReadHeader(const uint256& uuid, StorageHeaderRecord& record) const
+{
+    return Read(std::make_pair(DB_STORAGE_HEADER, uuid), record);
+}
+
+bool StorageIndex::DB::ReadLength(const uint256& uuid, StorageLengthRecord& record) const
+{
+    return Read(std::make_pair(DB_STORAGE_LENGTH, uuid), record);
+}
+
+bool StorageIndex::DB::ReadChunk(const uint256& uuid, uint32_t chunknum, StorageChunkRecord& record) const
+{
+    return Read(std::make_pair(DB_STORAGE_CHUNK, std::make_pair(uuid, chunknum)), record);
+}
+
+bool StorageIndex::DB::ReadAuth(const uint160& hash160, int& height) const
+{
+    return Read(std::make_pair(DB_STORAGE_AUTH, hash160), height);
+}
+
+bool StorageIndex::DB::ReadPayload(const uint256& uuid, uint32_t chunknum, CScript& script) const
+{
+    return Read(std::make_pair(DB_STORAGE_PAYLOAD, std::make_pair(uuid, chunknum)), script);
+}
+
+/** Add records to the batch unless their key is already indexed or was seen earlier in the block. */
+template <typename K, typename V>
+static void WriteFirstOccurrences(const CDBWrapper& db, CDBBatch& batch, uint8_t prefix, const std::vector<std::pair<K, V>>& records)
+{
+    std::set<K> seen;
+    for (const auto& [key, record] : records) {
+        if (!seen.insert(key).second || db.Exists(std::make_pair(prefix, key))) continue;
+        batch.Write(std::make_pair(prefix, key), record);
+    }
+}
+
+static void WriteListKeys(CDBBatch& batch, const uint256& uuid, const StorageHeaderRecord& header)
+{
+    batch.Write(DBListKey{header.tenant, header.height, uuid}, header.time);
+    batch.Write(DBListKey{std::nullopt, header.height, uuid}, header.time);
+}
+
+static void EraseListKeys(CDBBatch& batch, const uint256& uuid, const StorageHeaderRecord& header)
+{
+    batch.Erase(DBListKey{header.tenant, header.height, uuid});
+    batch.Erase(DBListKey{std::nullopt, header.height, uuid});
+}
+
+/**
+ * Usage totals of the tenants and assets a block changes, read from the
+ * database on first use and written back with the records of the block.
+ * Usage of an asset counts towards its tenant once its header is indexed.
+ */
+class UsageChanges
+{
+private:
+    const CDBWrapper& m_db;
+    std::map<uint160, StorageUsage> m_tenants;
+    std::map<uint256, StorageUsage> m_assets;
+    //! Signer of the header of each asset looked up, if it is indexed
+    std::map<uint256, std::optional<uint160>> m_signers;
+
+public:
+    explicit UsageChanges(const CDBWrapper& db) : m_db(db) {}
+
+    StorageUsage& Tenant(const uint160& tenant)
+    {
+        auto [it, inserted] = m_tenants.try_emplace(tenant);
+        if (inserted) m_db.Read(std::make_pair(DB_STORAGE_USAGE, tenant), it->second);
+        return it->second;
+    }
+
+    StorageUsage& Asset(const uint256& uuid)
+    {
+        auto [it, inserted] = m_assets.try_emplace(uuid);
+        if (inserted) m_db.Read(std::make_pair(DB_STORAGE_ASSET_USAGE, uuid), it->second);
+        return it->second;
+    }
+
+    void SetSigner(const uint256& uuid, const uint160& tenant) { m_signers[uuid] = tenant; }
+
+    //! Add to the usage of an asset, and of its tenant if the header is indexed. Negative amounts take away
+    void Add(const uint256& uuid, int64_t bytes, CAmount fees)
+    {
+        auto [it, inserted] = m_signers.try_emplace(uuid);
+        StorageHeaderRecord header;
+        if (inserted && m_db.Read(std::make_pair(DB_STORAGE_HEADER, uuid), header)) it->second = header.tenant;
+
+        StorageUsage& asset{Asset(uuid)};
+        asset.bytes += bytes;
+        asset.fees += fees;
+        if (it->second) {
+            StorageUsage& tenant{Tenant(*it->second)};
+            tenant.bytes += bytes;
+            tenant.fees += fees;
+        }
+    }
+
+    void Write(CDBBatch& batch) const
+    {
+        // Totals back at zero are dropped, so that reorgs leave nothing behind
+        for (const auto& [tenant, usage] : m_tenants) {
+            if (usage.assets == 0 && usage.bytes == 0 && usage.fees == 0) {
+                batch.Erase(std::make_pair(DB_STORAGE_USAGE, tenant));
+            } else {
+                batch.Write(std::make_pair(DB_STORAGE_USAGE, tenant), usage);
+            }
+        }
+        for (const auto& [uuid, usage] : m_assets) {
+            if (usage.bytes == 0 && usage.fees == 0) {
+                batch.Erase(std::make_pair(DB_STORAGE_ASSET_USAGE, uuid));
+            } else {
+                batch.Write(std::make_pair(DB_STORAGE_ASSET_USAGE, uuid), usage);
+            }
+        }
+    }
+};
+
+bool StorageIndex::DB::WriteRecords(const BlockStorageRecords& records)
+{
+    CDBBatch batch(*this);
+    UsageChanges usage(*this);
+
+    // Headers are written as in WriteFirstOccurrences, each along with its listing keys.
+    // The tenant takes on the usage of the chunks confirmed before the header
+    std::set<uint256> seen;
+    for (const auto& [key, record] : records.headers) {
+        if (!seen.insert(key).second || Exists(std::make_pair(DB_STORAGE_HEADER, key))) continue;
+        batch.Write(std::make_pair(DB_STORAGE_HEADER, key), record);
+        WriteListKeys(batch, key, record);
+        if (!record.payload.empty()) batch.Write(std::make_pair(DB_STORAGE_PAYLOAD, std::make_pair(key, uint32_t{0})), record.payload);
+        if (record.content_hash) batch.Write(std::make_pair(DB_STORAGE_CONTENT, std::make_pair(*record.content_hash, key)), record.tenant);
+
+        const StorageUsage& asset{usage.Asset(key)};
+        StorageUsage& tenant{usage.Tenant(record.tenant)};
+        tenant.assets++;
+        tenant.bytes += asset.bytes;
+        tenant.fees += asset.fees;
+        usage.SetSigner(key, record.tenant);
+    }
+    WriteFirstOccurrences(*this, batch, DB_STORAGE_LENGTH, records.lengths);
+    // Chunks likewise, each along with its payload if it is kept
+    std::set<std::pair<uint256, uint32_t>> seen_chunks;
+    for (const auto& [key, record] : records.chunks) {
+        if (!seen_chunks.insert(key).second || Exists(std::make_pair(DB_STORAGE_CHUNK, key))) continue;
+        batch.Write(std::make_pair(DB_STORAGE_CHUNK, key), record);
+        if (!record.payload.empty()) batch.Write(std::make_pair(DB_STORAGE_PAYLOAD, key), record.payload);
+        usage.Add(key.first, record.data_len, 0);
+    }
+    WriteFirstOccurrences(*this, batch, DB_STORAGE_AUTH, records.auths);
+    for (const auto& tx : records.txs) {
+        usage.Add(tx.uuid, 0, tx.fee);
+    }
+    usage.Write(batch);
+    return WriteBatch(batch);
+}
+
+bool StorageIndex::DB::EraseRecords(const BlockStorageRecords& records, int height)
+{
+    CDBBatch batch(*this);
+    UsageChanges usage(*this);
+
+    // Usage is taken away in the reverse order it was added in: the chunks and
+    // fees of the block first, then what the headers brought to their tenants.
+    // Keys the block carries twice were written once
+    std::set<std::pair<uint256, uint32_t>> seen_chunks;
+    for (const auto& entry : records.chunks) {
+        if (!seen_chunks.insert(entry.first).second) continue;
+        StorageChunkRecord record;
+        if (ReadChunk(entry.first.first, entry.first.second, record) && record.height == height) {
+            batch.Erase(std::make_pair(DB_STORAGE_CHUNK, entry.first));
+            batch.Erase(std::make_pair(DB_STORAGE_PAYLOAD, entry.first));
+            // The data length comes from the chunk parsed again, it is not kept in the record
+            usage.Add(entry.first.first, -int64_t(entry.second.data_len), 0);
+        }
+    }
+    for (const auto& tx : records.txs) {
+        usage.Add(tx.uuid, 0, -tx.fee);
+    }
+    std::set<uint256> seen;
+    for (const auto& entry : records.headers) {
+        if (!seen.insert(entry.first).second) continue;
+        StorageHeaderRecord record;
+        if (ReadHeader(entry.first, record) && record.height == height) {
+            batch.Erase(std::make_pair(DB_STORAGE_HEADER, entry.first));
+            batch.Erase(std::make_pair(DB_STORAGE_PAYLOAD, std::make_pair(entry.first, uint32_t{0})));
+            EraseListKeys(batch, entry.first, record);
+            // The content hash comes from the header parsed again, it is not kept in the record
+            if (entry.second.content_hash) batch.Erase(std::make_pair(DB_STORAGE_CONTENT, std::make_pair(*entry.second.content_hash, entry.first)));
+
+            const StorageUsage& asset{usage.Asset(entry.first)};
+            StorageUsage& tenant{usage.Tenant(record.tenant)};
+            tenant.assets--;
+            tenant.bytes -= asset.bytes;
+            tenant.fees -= asset.fees;
+        }
+    }
+    for (const auto& entry : records.lengths) {
+        StorageLengthRecord record;
+        if (ReadLength(entry.first, record) && record.height == height) {
+            batch.Erase(std::make_pair(DB_STORAGE_LENGTH, entry.first));
+        }
+    }
+    for (const auto& entry : records.auths) {
+        int auth_height;
+        if (ReadAuth(entry.first, auth_height) && auth_height == height) {
+            batch.Erase(std::make_pair(DB_STORAGE_AUTH, entry.first));
+        }
+    }
+    usage.Write(batch);
+    return WriteBatch(batch);
+}
+
+bool StorageIndex::DB::Upgrade()
+{
+    int version{0};
+    if (Read(DB_STORAGE_VERSION, version) && version >= STORAGE_INDEX_VERSION) return true;
+    return Write(DB_STORAGE_VERSION, STORAGE_INDEX_VERSION);
+}
+
+/** Read the script of an output from the block files, reusing tx when it is already the transaction at pos. */
+static bool ReadOutputScript(const CDiskTxPos& pos, uint32_t vout, CDiskTxPos& tx_pos, CTransactionRef& tx, CScript& script)
+{
+    if (!tx || pos.nFile != tx_pos.nFile || pos.nPos != tx_pos.nPos || pos.nTxOffset != tx_pos.nTxOffset) {
+        if (!StorageIndex::ReadTransaction(pos, tx)) return false;
+        tx_pos = pos;
+    }
+    if (vout >= tx->vout.size()) return false;
+    script = tx->vout[vout].scriptPubKey;
+    return true;
+}
+
+bool StorageIndex::DB::KeepPayloads(bool keep)
+{
+    const bool kept{Exists(DB_STORAGE_KEEP_PAYLOADS)};
+    if (!keep) {
+        // Payloads written from now on would be missing, should they be kept again
+        return !kept || Erase(DB_STORAGE_KEEP_PAYLOADS, /*fSync=*/true);
+    }
+    if (kept) return true;
+
+    // Chunks of a transaction are consecutive records, so the transaction is read once
+    CDBBatch batch(*this);
+    CDiskTxPos tx_pos;
+    CTransactionRef tx;
+    size_t count{0};
+    std::unique_ptr<CDBIterator> db_it(NewIterator());
+    for (db_it->Seek(std::make_pair(DB_STORAGE_CHUNK, std::make_pair(uint256(), uint32_t{0}))); db_it->Valid(); db_it->Next()) {
+        std::pair<uint8_t, std::pair<uint256, uint32_t>> key;
+        if (!db_it->GetKey(key) || key.first != DB_STORAGE_CHUNK) break;
+
+        StorageChunkRecord record;
+        CScript script;
+        if (!db_it->GetValue(record) || !ReadOutputScript(record.pos, record.vout, tx_pos, tx, script)) {
+            return error("%s: Cannot read the payload of chunk %d of %s", __func__, key.second.second, HexStr(key.second.first));
+        }
+        batch.Write(std::make_pair(DB_STORAGE_PAYLOAD, key.second), script);
+        count++;
+        if (batch.SizeEstimate() > MAX_PAYLOAD_BATCH_SIZE) {
+            if (!WriteBatch(batch)) return false;
+            batch.Clear();
+        }
+    }
+    for (db_it->Seek(std::make_pair(DB_STORAGE_HEADER, uint256())); db_it->Valid(); db_it->Next()) {
+        std::pair<uint8_t, uint256> key;
+        if (!db_it->GetKey(key) || key.first != DB_STORAGE_HEADER) break;
+
+        StorageHeaderRecord record;
+        CScript script;
+        if (!db_it->GetValue(record) || !ReadOutputScript(record.pos, record.vout, tx_pos, tx, script)) {
+            return error("%s: Cannot read the payload of the header of %s", __func__, HexStr(key.second));
+        }
+        batch.Write(std::make_pair(DB_STORAGE_PAYLOAD, std::make_pair(key.second, uint32_t{0})), script);
+        count++;
+        if (batch.SizeEstimate() > MAX_PAYLOAD_BATCH_SIZE) {
+            if (!WriteBatch(batch)) return false;
+            batch.Clear();
+        }
+    }
+    if (count > 0) LogPrintf("%s: kept the payloads of %d chunks\n", __func__, count);
+
+    batch.Write(DB_STORAGE_KEEP_PAYLOADS, true);
+    return WriteBatch(batch, /*fSync=*/true);
+}
+
+/** Records of the storage transactions in the mempool, looked up by key and by txid. */
+class StorageIndex::Mempool
+{
+public:
+    Mutex m_mutex;
+    std::map<uint256, BlockStorageRecords> m_txs GUARDED_BY(m_mutex);
+
+    // Each key maps to the first transaction seen carrying it, with its record
+    std::map<uint256, std::pair<uint256, StorageHeaderRecord>> m_headers GUARDED_BY(m_mutex);
+    std::map<uint256, std::pair<uint256, StorageLengthRecord>> m_lengths GUARDED_BY(m_mutex);
+    std::map<std::pair<uint256, uint32_t>, std::pair<uint256, StorageChunkRecord>> m_chunks GUARDED_BY(m_mutex);
+
+    void Add(const uint256& txid, const BlockStorageRecords& records) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void Remove(const uint256& txid) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+template <typename K, typename V>
+static void AddKeys(std::map<K, std::pair<uint256, V>>& map, const uint256& txid, const std::vector<std::pair<K, V>>& records)
+{
+    for (const auto& [key, record] : records) {
+        map.emplace(key, std::make_pair(txid, record));
+    }
+}
+
+template <typename K, typename V>
+static void RemoveKeys(std::map<K, std::pair<uint256, V>>& map, const uint256& txid, const std::vector<std::pair<K, V>>& records)
+{
+    for (const auto& entry : records) {
+        auto it = map.find(entry.first);
+        if (it != map.end() && it->second.first == txid) map.erase(it);
+    }
+}
+
+void StorageIndex::Mempool::Add(const uint256& txid, const BlockStorageRecords& records)
+{
+    LOCK(m_mutex);
+    if (!m_txs.emplace(txid, records).second) return;
+    AddKeys(m_headers, txid, records.headers);
+    AddKeys(m_lengths, txid, records.lengths);
+    AddKeys(m_chunks, txid, records.chunks);
+}
+
+void StorageIndex::Mempool::Remove(const uint256& txid)
+{
+    LOCK(m_mutex);
+    auto it = m_txs.find(txid);
+    if (it == m_txs.end()) return;
+    RemoveKeys(m_headers, txid, it->second.headers);
+    RemoveKeys(m_lengths, txid, it->second.lengths);
+    RemoveKeys(m_chunks, txid, it->second.chunks);
+    m_txs.erase(it);
+}
+
+std::unique_ptr<StorageIndex::DB> StorageIndex::OpenDB(size_t n_cache_size, bool f_memory, bool f_wipe)
+{
+    auto db{std::make_unique<StorageIndex::DB>(n_cache_size, f_memory, f_wipe)};
+
+    // The fees of the assets indexed so far are only in the undo data of their blocks
+    int version{0};
+    CBlockLocator locator;
+    if (db->ReadBestBlock(locator) && !(db->Read(DB_STORAGE_VERSION, version) && version >= STORAGE_INDEX_VERSION)) {
+        LogPrintf("Storage index was written before the usage totals, rebuilding it\n");
+        db.reset();
+        db = std::make_unique<StorageIndex::DB>(n_cache_size, f_memory, /*f_wipe=*/true);
+    }
+    return db;
+}
+
+StorageIndex::StorageIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe, bool keep_payloads)
+    : BaseIndex(std::move(chain), "storageindex"), m_db(OpenDB(n_cache_size, f_memory, f_wipe)),
+      m_mempool(std::make_unique<StorageIndex::Mempool>()), m_keep_payloads(keep_payloads)
+{}
+
+StorageIndex::~StorageIndex() = default;
+
+/**
+ * Extract the storage records carried by a transaction. When rewinding only
+ * the keys are of interest, so recover_tenant skips the signature recovery.
+ * keep_payloads copies the chunk scripts into the records.
+ */
+static void ParseTransactionChunks(const CTransactionRef& tx, const CDiskTxPos& tx_pos, int height, int64_t time, bool recover_tenant, bool keep_payloads, BlockStorageRecords& records)
+{
+    // Unconfirmed transactions are kept with their records, as they can not be read from disk
+    const CTransactionRef mempool_tx{height == STORAGE_MEMPOOL_HEIGHT ? tx : nullptr};
+
+    for (uint32_t vout = 0; vout < tx->vout.size(); vout++) {
+        const CScript& script{tx->vout[vout].scriptPubKey};
+        if (!script.IsOpReturn()) continue;
+
+        // Authdata; only additions matter, they gate fetching a tenant's assets
+        auth_view auth;
+        if (parse_auth_from_script(script, auth)) {
+            if (auth.operation == OPAUTH_ADDUSER_BIN) {
+                records.auths.emplace_back(get_hash160_from_auth(auth), height);
+            }
+            continue;
+        }
+
+        chunk_view view;
+        int error_level;
+        if (!parse_chunk_from_script(script, view, error_level)) continue;
+        const uint256 key{view.uuid};
+
+        if (view.chunklen == 0) {
+            // Header chunk; the signer of the header is the tenant at storeasset time
+            StorageHeaderRecord record;
+            // An unrecoverable signature still lists for the manager, as with the chain scan
+            if (recover_tenant) recover_tenant_from_header(view, record.tenant);
+            record.protocol = view.version;
+            record.height = height;
+            record.time = time;
+            record.pos = tx_pos;
+            record.vout = vout;
+            record.tx = mempool_tx;
+            if (keep_payloads) record.payload = script;
+            if (view.flags & OPENCODING_FLAG_CONTENTHASH) record.content_hash = uint256{view.contenthash};
+            records.headers.emplace_back(key, record);
+
+            // Protocol 02 carries the filelength in the header rather than the final chunk
+            if (view.chunktotal > 0) {
+                StorageLengthRecord length;
+                length.height = height;
+                length.chunk_total = view.chunktotal;
+                length.final_chunk_len = view.filelen - uint64_t(view.chunktotal - 1) * OPENCODING_COMPACT_CHUNKMAX;
+                records.lengths.emplace_back(key, length);
+            }
+            continue;
+        }
+
+        // Data chunk, protocol 02 ones do not know the chunktotal
+        if (view.chunknum == 0 || (view.version != OPENCODING_COMPACT && view.chunknum > view.chunktotal)) continue;
+
+        StorageChunkRecord chunk;
+        chunk.height = height;
+        chunk.pos = tx_pos;
+        chunk.vout = vout;
+        chunk.tx = mempool_tx;
+        if (keep_payloads) chunk.payload = script;
+        chunk.data_len = view.data.size();
+        records.chunks.emplace_back(std::make_pair(key, view.chunknum), chunk);
+
+        // Only the final chunk carries information about the filelength
+        if (view.version == OPENCODING_COMPACT || view.chunknum != view.chunktotal) continue;
+
+        StorageLengthRecord length;
+        length.height = height;
+        length.chunk_total = view.chunktotal;
+        length.final_chunk_len = view.chunklen;
+        records.lengths.emplace_back(key, length);
+    }
+}
+
+/** Extract the storage records carried by a block. The fees of the transactions are left to ReadFees. */
+static void ParseBlockChunks(const CBlock& block, const FlatFilePos& block_pos, int height, bool recover_tenant, bool keep_payloads, BlockStorageRecords& records)
+{
+    CDiskTxPos pos(block_pos, GetSizeOfCompactSize(block.vtx.size()));
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransactionRef& tx{block.vtx[i]};
+        const CDiskTxPos tx_pos{pos};
+        pos.nTxOffset += ::GetSerializeSize(*tx, CLIENT_VERSION);
+
+        // Skip irrelevant transactions
+        if (tx->IsCoinBase() || tx->IsCoinStake()) continue;
+
+        const size_t headers{records.headers.size()};
+        const size_t chunks{records.chunks.size()};
+        ParseTransactionChunks(tx, tx_pos, height, block.nTime, recover_tenant, keep_payloads, records);
+        if (records.headers.size() > headers) {
+            records.txs.push_back({records.headers[headers].first, i});
+        } else if (records.chunks.size() > chunks) {
+            records.txs.push_back({records.chunks[chunks].first.first, i});
+        }
+    }
+}
+
+/** Fill in the fees of the transactions carrying chunks, from the undo data of the block. */
+static bool ReadFees(const CBlock& block, const CBlockUndo& block_undo, const CBlockIndex* pindex, BlockStorageRecords& records)
+{
+    for (auto& tx : records.txs) {
+        // The coinbase has no undo data
+        if (tx.index == 0 || tx.index > block_undo.vtxundo.size()) {
+            return error("%s: No undo data for transaction %d of block %s", __func__, tx.index, pindex->GetBlockHash().ToString());
+        }
+        CAmount value_in{0};
+        for (const Coin& coin : block_undo.vtxundo[tx.index - 1].vprevout) {
+            value_in += coin.out.nValue;
+        }
+        tx.fee = value_in - block.vtx[tx.index]->GetValueOut();
+    }
+    return true;
+}
+
+bool StorageIndex::CustomInit(const std::optional<interfaces::BlockKey>& block)
+{
+    if (!m_db->Upgrade()) return false;
+    if (m_keep_payloads) {
+        LogPrintf("%s: keeping the payloads of stored assets, so their block files can be pruned\n", GetName());
+    }
+    return m_db->KeepPayloads(m_keep_payloads);
+}
+
+bool StorageIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    // Assets are only recognised after the storage activation height
+    if (block.height <= int(Params().GetConsensus().nUUIDBlockStart)) return true;
+
+    assert(block.data);
+
+    // Transactions now confirmed are read from the block files from here on
+    for (const auto& tx : block.data->vtx) {
+        m_mempool->Remove(tx->GetHash());
+    }
+
+    BlockStorageRecords records;
+    ParseBlockChunks(*block.data, {block.file_number, block.data_pos}, block.height, /*recover_tenant=*/true, m_keep_payloads, records);
+    if (records.empty()) return true;
+
+    if (!records.txs.empty()) {
+        const CBlockIndex* pindex{WITH_LOCK(cs_main, return m_chainstate->m_blockman.LookupBlockIndex(block.hash))};
+        CBlockUndo block_undo;
+        if (!UndoReadFromDisk(block_undo, pindex)) {
+            return error("%s: Failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!ReadFees(*block.data, block_undo, pindex, records)) return false;
+    }
+
+    if (!m_db->WriteRecords(records)) return false;
+
+    // Tell of the assets this block completes, once the index follows the tip
+    if (GetSummary().synced) {
+        std::set<uint256> touched;
+        for (const auto& [key, header] : records.headers) touched.insert(key);
+        for (const auto& [key, length] : records.lengths) touched.insert(key);
+        for (const auto& [key, chunk] : records.chunks) touched.insert(key.first);
+        for (const uint256& key : touched) {
+            const std::string uuid{HexStr(key)};
+            uint32_t confirmed, total;
+            if (FindConfirmations(uuid, confirmed, total) && total > 0 && confirmed == total) {
+                uiInterface.NotifyAssetConfirmed(uuid, block.height);
+            }
+        }
+    }
+    return true;
+}
+
+bool StorageIndex::CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip)
+{
+    LOCK(cs_main);
+    const CBlockIndex* iter_tip{m_chainstate->m_blockman.LookupBlockIndex(current_tip.hash)};
+    const CBlockIndex* new_tip_index{m_chainstate->m_blockman.LookupBlockIndex(new_tip.hash)};
+    const auto& consensus_params{Params().GetConsensus()};
+
+    do {
+        if (iter_tip->nHeight > int(consensus_params.nUUIDBlockStart)) {
+            std::shared_ptr<const CBlock> block;
+            if (!ReadRewoundBlock(*iter_tip, block)) return false;
+
+            BlockStorageRecords records;
+            ParseBlockChunks(*block, iter_tip->GetBlockPos(), iter_tip->nHeight, /*recover_tenant=*/false, /*keep_payloads=*/false, records);
+            std::shared_ptr<const CBlockUndo> block_undo;
+            if (!records.txs.empty() && (!ReadRewoundUndo(*iter_tip, block_undo) || !ReadFees(*block, *block_undo, iter_tip, records))) return false;
+            if (!records.empty() && !m_db->EraseRecords(records, iter_tip->nHeight)) return false;
+        }
+
+        iter_tip = iter_tip->GetAncestor(iter_tip->nHeight - 1);
+    } while (new_tip_index != iter_tip);
+
+    return true;
+}
+
+BaseIndex::DB& StorageIndex::GetDB() const { return *m_db; }
+
+void StorageIndex::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence)
+{
+    if (tx->IsCoinBase() || tx->IsCoinStake()) return;
+
+    BlockStorageRecords records;
+    ParseTransactionChunks(tx, CDiskTxPos{}, STORAGE_MEMPOOL_HEIGHT, GetTime(), /*recover_tenant=*/true, /*keep_payloads=*/false, records);
+
+    // Authlist additions only count once confirmed
+    records.auths.clear();
+    if (records.empty()) return;
+
+    m_mempool->Add(tx->GetHash(), records);
+}
+
+void StorageIndex::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
+{
+    m_mempool->Remove(tx->GetHash());
+}
+
+bool StorageIndex::FindLength(const uint256& key, StorageLengthRecord& record) const
+{
+    if (m_db->ReadLength(key, record)) return true;
+
+    LOCK(m_mempool->m_mutex);
+    auto it = m_mempool->m_lengths.find(key);
+    if (it == m_mempool->m_lengths.end()) return false;
+    record = it->second.second;
+    return true;
+}
+
+bool StorageIndex::FindAsset(const std::string& uuid, StorageAssetInfo& info) const
+{
+    uint256 key;
+    if (!UUIDToKey(uuid, key)) return false;
+    if (!m_db->ReadHeader(key, info.header)) {
+        LOCK(m_mempool->m_mutex);
+        auto it = m_mempool->m_headers.find(key);
+        if (it == m_mempool->m_headers.end()) return false;
+        info.header = it->second.second;
+    } else if (m_keep_payloads && !m_db->ReadPayload(key, 0, info.header.payload)) {
+        return error("%s: Cannot read the payload of the header of %s", __func__, uuid);
+    }
+
+    info.uuid = uuid;
+    StorageLengthRecord length;
+    if (FindLength(key, length)) {
+        info.length = length;
+    } else {
+        info.length.reset();
+    }
+    return true;
+}
+
+bool StorageIndex::FindChunks(const std::string& uuid, uint32_t chunk_total, std::vector<StorageChunkRecord>& chunks) const
+{
+    return FindChunks(uuid, 1, chunk_total, chunks);
+}
+
+bool StorageIndex::FindChunks(const std::string& uuid, uint32_t first, uint32_t last, std::vector<StorageChunkRecord>& chunks) const
+{
+    chunks.clear();
+    uint256 key;
+    if (!UUIDToKey(uuid, key) || first < 1 || last < first) return false;
+
+    chunks.resize(last - first + 1);
+    for (uint32_t chunknum = first; chunknum <= last; chunknum++) {
+        StorageChunkRecord& chunk{chunks[chunknum - first]};
+        if (m_db->ReadChunk(key, chunknum, chunk)) {
+            if (m_keep_payloads && !m_db->ReadPayload(key, chunknum, chunk.payload)) {
+                return error("%s: Cannot read the payload of chunk %d of %s", __func__, chunknum, uuid);
+            }
+            continue;
+        }
+
+        LOCK(m_mempool->m_mutex);
+        auto it = m_mempool->m_chunks.find(std::make_pair(key, chunknum));
+        if (it == m_mempool->m_chunks.end()) return false;
+        chunk = it->second.second;
+    }
+    return true;
+}
+
+bool StorageIndex::FindConfirmations(const std::string& uuid, uint32_t& confirmed, uint32_t& total) const
+{
+    confirmed = 0;
+    total = 0;
+
+    StorageAssetInfo info;
+    if (!FindAsset(uuid, info)) return false;
+
+    uint256 key;
+    UUIDToKey(uuid, key);
+    if (info.header.height != STORAGE_MEMPOOL_HEIGHT) confirmed++;
+    if (!info.length) return true;
+
+    total = info.length->chunk_total + 1;
+    StorageChunkRecord record;
+    for (uint32_t chunknum = 1; chunknum <= info.length->chunk_total; chunknum++) {
+        if (m_db->ReadChunk(key, chunknum, record)) confirmed++;
+    }
+    return true;
+}
+
+bool StorageIndex::FindContent(const uint256& content_hash, const uint160& tenant, std::string& uuid) const
+{
+    // Assets of every tenant with that content, in uuid order
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    for (db_it->Seek(std::make_pair(DB_STORAGE_CONTENT, std::make_pair(content_hash, uint256()))); db_it->Valid(); db_it->Next()) {
+        std::pair<uint8_t, std::pair<uint256, uint256>> key;
+        if (!db_it->GetKey(key) || key.first != DB_STORAGE_CONTENT || key.second.first != content_hash) break;
+
+        uint160 signer;
+        if (!db_it->GetValue(signer) || signer != tenant) continue;
+
+        // Only an asset whose every chunk is confirmed stands in for the file
+        uint32_t confirmed, total;
+        const std::string found{HexStr(key.second.second)};
+        if (FindConfirmations(found, confirmed, total) && total > 0 && confirmed == total) {
+            uuid = found;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StorageIndex::FindTenantUsage(const uint160& tenant, StorageUsage& usage) const
+{
+    return m_db->Read(std::make_pair(DB_STORAGE_USAGE, tenant), usage);
+}
+
+bool StorageIndex::GetTotals(StorageIndexTotals& totals) const
+{
+    totals = {};
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    for (db_it->Seek(std::make_pair(DB_STORAGE_HEADER, uint256())); db_it->Valid(); db_it->Next()) {
+        std::pair<uint8_t, uint256> key;
+        if (!db_it->GetKey(key) || key.first != DB_STORAGE_HEADER) break;
+        ++totals.assets;
+    }
+    for (db_it->Seek(std::make_pair(DB_STORAGE_CHUNK, std::make_pair(uint256(), uint32_t{0}))); db_it->Valid(); db_it->Next()) {
+        std::pair<uint8_t, std::pair<uint256, uint32_t>> key;
+        if (!db_it->GetKey(key) || key.first != DB_STORAGE_CHUNK) break;
+        ++totals.chunks;
+    }
+    for (db_it->Seek(std::make_pair(DB_STORAGE_USAGE, uint160())); db_it->Valid(); db_it->Next()) {
+        std::pair<uint8_t, uint160> key;
+        if (!db_it->GetKey(key) || key.first != DB_STORAGE_USAGE) break;
+
+        StorageUsage usage;
+        if (!db_it->GetValue(usage)) {
+            return error("%s: Cannot read the usage of tenant %s", __func__, key.second.ToString());
+        }
+        ++totals.tenants;
+        totals.bytes += usage.bytes;
+        totals.fees += usage.fees;
+    }
+    return true;
+}
+
+bool StorageIndex::FindAuthHeight(const uint160& hash160, int& height) const
+{
+    return m_db->ReadAuth(hash160, height);
+}
+
+bool StorageIndex::ReadTransaction(const CDiskTxPos& pos, CTransactionRef& tx)
+{
+    CBlockHeader header;
+    return ReadTransactionFromDisk(pos, pos.nTxOffset, header, tx);
+}
+
+bool StorageIndex::ListAssets(std::vector<StorageAssetInfo>& assets, const StorageListQuery& query, std::optional<StorageListCursor>& next) const
+{
+    assets.clear();
+    next.reset();
+    const StorageListCursor start{query.cursor.value_or(StorageListCursor{STORAGE_MEMPOOL_HEIGHT, uint256()})};
+
+    // Once the page is full, the next asset found becomes the start of the following page
+    auto add = [&](const uint256& key, const StorageHeaderRecord& header) {
+        if (query.count > 0 && assets.size() >= size_t(query.count)) {
+            next = StorageListCursor{header.height, key};
+            return false;
+        }
+        StorageAssetInfo info;
+        info.uuid = HexStr(key);
+        info.header = header;
+        StorageLengthRecord length;
+        if (FindLength(key, length)) info.length = length;
+        assets.push_back(std::move(info));
+        return true;
+    };
+    auto in_range = [&](int64_t time) { return time >= query.start_time && time <= query.end_time; };
+
+    // Assets whose header chunk is still unconfirmed come first, in uuid order
+    if (start.height == STORAGE_MEMPOOL_HEIGHT) {
+        std::vector<std::pair<uint256, StorageHeaderRecord>> unconfirmed;
+        {
+            LOCK(m_mempool->m_mutex);
+            for (auto it = m_mempool->m_headers.lower_bound(start.uuid); it != m_mempool->m_headers.end(); ++it) {
+                const StorageHeaderRecord& header{it->second.second};
+                if (query.tenant && header.tenant != *query.tenant) continue;
+                if (!in_range(header.time)) continue;
+                unconfirmed.emplace_back(it->first, header);
+            }
+        }
+        for (const auto& [key, header] : unconfirmed) {
+            StorageHeaderRecord record;
+            if (m_db->ReadHeader(key, record)) continue;
+            if (!add(key, header)) return true;
+        }
+    }
+
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    for (db_it->Seek(DBListKey{query.tenant, start.height, start.uuid}); db_it->Valid(); db_it->Next()) {
+        DBListKey key;
+        if (!db_it->GetKey(key) || key.tenant != query.tenant) break;
+
+        int64_t time;
+        if (!db_it->GetValue(time)) {
+            return error("%s: Cannot read storage index listing for %s", __func__, HexStr(key.uuid));
+        }
+        // Block times are ordered up to MAX_FUTURE_BLOCK_TIME, nothing further down is in range
+        if (time < query.start_time - MAX_FUTURE_BLOCK_TIME) break;
+        if (!in_range(time)) continue;
+
+        StorageHeaderRecord header;
+        if (!m_db->ReadHeader(key.uuid, header)) {
+            return error("%s: Cannot read storage index record for %s", __func__, HexStr(key.uuid));
+        }
+        if (!add(key.uuid, header)) break;
+    }
+
+    return true;
+}
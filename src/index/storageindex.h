@@ -0,0 +1,244 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_STORAGEINDEX_H
+#define BITCOIN_INDEX_STORAGEINDEX_H
+
+#include <consensus/amount.h>
+#include <index/base.h>
+#include <index/disktxpos.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+static constexpr bool DEFAULT_STORAGEINDEX{false};
+//! Height given to records of unconfirmed transactions in the mempool
+static constexpr int STORAGE_MEMPOOL_HEIGHT{std::numeric_limits<int>::max()};
+
+/** Metadata recorded for an asset's header chunk (chunklen 0). */
+struct StorageHeaderRecord {
+    uint160 tenant;     //!< hash160 of the key that signed the header chunk
+    uint8_t protocol{0};
+    int height{0};
+    int64_t time{0};
+    CDiskTxPos pos;
+    uint32_t vout{0};
+    CTransactionRef tx; //!< unconfirmed transaction holding the chunk, not serialized
+    CScript payload;    //!< the chunk's script when the index keeps payloads, not serialized
+    std::optional<uint256> content_hash; //!< sha256 of the file, from protocol 02 headers carrying it, not serialized
+
+    SERIALIZE_METHODS(StorageHeaderRecord, obj)
+    {
+        READWRITE(obj.tenant, obj.protocol, obj.height, obj.time, obj.pos, obj.vout);
+    }
+};
+
+/** Metadata recorded for an asset's final data chunk (chunknum == chunktotal), or from its protocol 02 header chunk. */
+struct StorageLengthRecord {
+    int height{0};
+    uint32_t chunk_total{0};
+    uint32_t final_chunk_len{0};
+
+    SERIALIZE_METHODS(StorageLengthRecord, obj)
+    {
+        READWRITE(obj.height, obj.chunk_total, obj.final_chunk_len);
+    }
+};
+
+/** Location of a single data chunk of an asset. */
+struct StorageChunkRecord {
+    int height{0};
+    CDiskTxPos pos;
+    uint32_t vout{0};
+    CTransactionRef tx; //!< unconfirmed transaction holding the chunk, not serialized
+    CScript payload;    //!< the chunk's script when the index keeps payloads, not serialized
+    uint32_t data_len{0}; //!< bytes of the file the chunk carries, not serialized
+
+    SERIALIZE_METHODS(StorageChunkRecord, obj)
+    {
+        READWRITE(obj.height, obj.pos, obj.vout);
+    }
+};
+
+/** What the confirmed chunks of a tenant, or of a single asset, take up. */
+struct StorageUsage {
+    uint64_t assets{0}; //!< header chunks the tenant signed, 0 for a single asset
+    uint64_t bytes{0};  //!< bytes of the file carried by the data chunks
+    CAmount fees{0};    //!< fees of the transactions carrying the chunks
+
+    SERIALIZE_METHODS(StorageUsage, obj)
+    {
+        READWRITE(obj.assets, obj.bytes, obj.fees);
+    }
+};
+
+/** What the index holds, as getstoragestats reports it. */
+struct StorageIndexTotals {
+    uint64_t assets{0};  //!< header chunks indexed, confirmed
+    uint64_t chunks{0};  //!< data chunks indexed, confirmed
+    uint64_t tenants{0}; //!< tenants with confirmed assets
+    uint64_t bytes{0};   //!< bytes of the files of those tenants
+    CAmount fees{0};     //!< fees of the transactions carrying their chunks
+};
+
+/** Combined view of an indexed asset, as returned by lookups. */
+struct StorageAssetInfo {
+    std::string uuid;
+    StorageHeaderRecord header;
+    std::optional<StorageLengthRecord> length;
+
+    /** Filelength is (totalchunks - 1) * chunkmax + finalchunklength, or 0 if the final chunk is not yet indexed.
+     *  chunkmax depends on the protocol of the header. */
+    int64_t GetFileLength() const;
+};
+
+/** Position in a listing of assets, which are ordered newest first (by header height), then by uuid. */
+struct StorageListCursor {
+    int height{0};
+    uint256 uuid;
+
+    /** Opaque hex form handed to RPC clients. */
+    std::string ToString() const;
+    static std::optional<StorageListCursor> FromString(const std::string& str);
+};
+
+/** Page of assets to list, see StorageIndex::ListAssets. */
+struct StorageListQuery {
+    std::optional<uint160> tenant;           //!< only the assets of this tenant, or all if unset
+    int count{0};                            //!< page size, 0 for all remaining assets
+    std::optional<StorageListCursor> cursor; //!< first asset of the page, as returned with the previous one
+    int64_t start_time{0};                   //!< inclusive range of header times
+    int64_t end_time{std::numeric_limits<int64_t>::max()};
+};
+
+/**
+ * StorageIndex records per-UUID metadata for assets stored through the Lynx
+ * storage protocol (header chunk location and signer, chunk total and final
+ * chunk length), the location of every data chunk, and the height at which
+ * each authlist member was first added, so that the storage RPCs can answer
+ * list/fetch queries with index lookups instead of scanning the chain from
+ * nUUIDBlockStart.
+ *
+ * Chunks of unconfirmed transactions are tracked in memory as they enter and
+ * leave the mempool, at STORAGE_MEMPOOL_HEIGHT, so that an asset can be listed
+ * and fetched straight after it is stored. Confirmed records take precedence.
+ *
+ * Assets whose header carries the sha256 of the file are also keyed by it, so
+ * that a tenant storing a file again can be given the asset already stored.
+ *
+ * The usage of each tenant (assets, bytes and fees of the confirmed chunks) is
+ * kept as a running total, updated as blocks are connected and disconnected,
+ * so that it is read with one lookup. Transactions confirmed before the header
+ * of their asset count towards the tenant once the header confirms.
+ *
+ * Listing keys order the assets of each tenant, and of all tenants together,
+ * newest first, so that a page of the list RPC costs a seek and a scan of the
+ * page rather than a pass over every asset.
+ *
+ * On a pruning node the index also keeps the script of every header and data
+ * chunk, so that assets stay fetchable once their block files are deleted.
+ * The index then takes a prune lock, so no block file is deleted before the
+ * index has kept the payloads it holds.
+ */
+class StorageIndex final : public BaseIndex
+{
+protected:
+    class DB;
+    class Mempool;
+
+private:
+    const std::unique_ptr<DB> m_db;
+    const std::unique_ptr<Mempool> m_mempool;
+    //! Whether the chunk scripts are kept, so the block files can be pruned
+    const bool m_keep_payloads;
+
+    bool FindLength(const uint256& key, StorageLengthRecord& record) const;
+
+    /// Open the database, wiping one written before the usage totals, which are rebuilt from the blocks.
+    static std::unique_ptr<DB> OpenDB(size_t n_cache_size, bool f_memory, bool f_wipe);
+
+    bool AllowPrune() const override { return m_keep_payloads; }
+
+protected:
+    bool CustomInit(const std::optional<interfaces::BlockKey>& block) override;
+
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool CustomRewind(const interfaces::BlockKey& current_tip, const interfaces::BlockKey& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    void TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence) override;
+
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) override;
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    /// keep_payloads is set on pruning nodes, see above.
+    explicit StorageIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false, bool keep_payloads = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~StorageIndex() override;
+
+    /// The fees of the storage transactions of a block rewound are read from its undo data.
+    bool WantsDisconnectedUndo() const override { return true; }
+
+    /// Look up an asset by its (hex) uuid. Returns false if no header chunk is indexed for it.
+    bool FindAsset(const std::string& uuid, StorageAssetInfo& info) const;
+
+    /// Look up the location of every data chunk of an asset, in chunk order.
+    /// Returns false unless all chunk_total chunks are indexed.
+    bool FindChunks(const std::string& uuid, uint32_t chunk_total, std::vector<StorageChunkRecord>& chunks) const;
+
+    /// Look up the location of data chunks first to last of an asset, in chunk order.
+    /// Returns false unless all of them are indexed.
+    bool FindChunks(const std::string& uuid, uint32_t first, uint32_t last, std::vector<StorageChunkRecord>& chunks) const;
+
+    /// Look up a confirmed asset of tenant whose header carries content_hash, the
+    /// sha256 of the file, so an upload of the same file can be skipped.
+    bool FindContent(const uint256& content_hash, const uint160& tenant, std::string& uuid) const;
+
+    /// Look up the usage of the confirmed assets of tenant. Returns false if it has none.
+    bool FindTenantUsage(const uint160& tenant, StorageUsage& usage) const;
+
+    /// Look up the lowest height at which hash160 was added to the authlist.
+    bool FindAuthHeight(const uint160& hash160, int& height) const;
+
+    /// Look up how many of an asset's chunks (header included) are confirmed.
+    /// total is 0 while the final data chunk is not yet seen.
+    bool FindConfirmations(const std::string& uuid, uint32_t& confirmed, uint32_t& total) const;
+
+    /// Read an indexed transaction from the block files.
+    static bool ReadTransaction(const CDiskTxPos& pos, CTransactionRef& tx);
+
+    /// Read the transaction holding a record, from the mempool or the block files.
+    template <typename Record>
+    static bool ReadTransaction(const Record& record, CTransactionRef& tx)
+    {
+        if (record.tx) {
+            tx = record.tx;
+            return true;
+        }
+        return ReadTransaction(record.pos, tx);
+    }
+
+    /// Count what the index holds, walking the keys of every asset and chunk.
+    bool GetTotals(StorageIndexTotals& totals) const;
+
+    /// Return a page of indexed assets newest first (by header height, then
+    /// uuid), unconfirmed ones leading. next is set to the first asset of the
+    /// following page, if there is one.
+    bool ListAssets(std::vector<StorageAssetInfo>& assets, const StorageListQuery& query, std::optional<StorageListCursor>& next) const;
+};
+
+/// The global storage index, used by the storage RPCs and worker. May be null.
+extern std::unique_ptr<StorageIndex> g_storage_index;
+
+#endif // BITCOIN_INDEX_STORAGEINDEX_H
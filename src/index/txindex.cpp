@@ -4,18 +4,56 @@
 
 #include <index/txindex.h>
 
+#include <crypto/common.h>
 #include <index/disktxpos.h>
+#include <interfaces/chain.h>
 #include <logging.h>
 #include <node/blockstorage.h>
+#include <node/jobs.h>
 #include <util/system.h>
 #include <validation.h>
 
-using node::OpenBlockFile;
+#include <algorithm>
+#include <atomic>
 
+using node::ReadTransactionFromDisk;
+
+//! Entries keyed by the full txid, written before the compact format
 constexpr uint8_t DB_TXINDEX{'t'};
+constexpr uint8_t DB_TXINDEX_COMPACT{'x'};
+
+//! Bytes of the txid kept in the keys of the compact format
+static constexpr int TXID_PREFIX_BYTES{8};
+//! Entries of the full txid format moved to the compact one in one batch
+static constexpr size_t MIGRATE_BATCH_SIZE{10'000};
+//! About the bytes an entry of the full txid format takes on disk, to estimate how many there are
+static constexpr size_t LEGACY_ENTRY_BYTES{42};
 
 std::unique_ptr<TxIndex> g_txindex;
 
+namespace {
+/**
+ * Key of an entry of the compact format: the first TXID_PREFIX_BYTES of the
+ * txid, then the position of the transaction as VARINTs, with an empty value.
+ * Transactions whose txids start the same get keys of their own, which
+ * lookups tell apart by reading the transactions, so writes never read first.
+ */
+struct CompactTxKey {
+    uint64_t prefix{0};
+    CDiskTxPos pos;
+
+    SERIALIZE_METHODS(CompactTxKey, obj)
+    {
+        READWRITE(Using<BigEndianFormatter<TXID_PREFIX_BYTES>>(obj.prefix), obj.pos);
+    }
+};
+
+uint64_t TxidPrefix(const uint256& txid)
+{
+    return ReadBE64(txid.begin());
+}
+} // namespace
+
 
 /** Access to the txindex database (indexes/txindex/) */
 class TxIndex::DB : public BaseIndex::DB
@@ -23,32 +61,88 @@ class TxIndex::DB : public BaseIndex::DB
 public:
     explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
 
-    /// Read the disk location of the transaction data with the given hash. Returns false if the
-    /// transaction hash is not indexed.
-    bool ReadTxPos(const uint256& txid, CDiskTxPos& pos) const;
+    //! Whether entries of the full txid format may remain
+    std::atomic<bool> m_legacy_entries{false};
+
+    /// Read the disk locations of the transactions whose hash may be txid: the
+    /// one of the full txid format, then those of the compact format under its prefix.
+    std::vector<CDiskTxPos> ReadTxPos(const uint256& txid);
 
     /// Write a batch of transaction positions to the DB.
     bool WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos);
+
+    /// About how many entries of the full txid format remain.
+    uint64_t EstimateLegacyEntries() const;
+
+    /// Move up to count entries of the full txid format to the compact one,
+    /// adding them to moved. Clears m_legacy_entries once none remain.
+    bool MigrateLegacyEntries(size_t count, uint64_t& moved);
 };
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
     BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe)
-{}
+{
+    std::unique_ptr<CDBIterator> it{NewIterator()};
+    it->Seek(DB_TXINDEX);
+    std::pair<uint8_t, uint256> key;
+    m_legacy_entries = it->Valid() && it->GetKey(key) && key.first == DB_TXINDEX;
+}
 
-bool TxIndex::DB::ReadTxPos(const uint256 &txid, CDiskTxPos& pos) const
+std::vector<CDiskTxPos> TxIndex::DB::ReadTxPos(const uint256& txid)
 {
-    return Read(std::make_pair(DB_TXINDEX, txid), pos);
+    std::vector<CDiskTxPos> positions;
+    // Before the compact entries, as the migration moves entries from one format to the other
+    if (m_legacy_entries) {
+        CDiskTxPos pos;
+        if (Read(std::make_pair(DB_TXINDEX, txid), pos)) positions.push_back(pos);
+    }
+
+    // The first position of the first file packs to the lowest bytes, so it seeks to the first key of the prefix
+    const uint64_t prefix{TxidPrefix(txid)};
+    std::unique_ptr<CDBIterator> it{NewIterator()};
+    it->Seek(std::make_pair(DB_TXINDEX_COMPACT, CompactTxKey{prefix, CDiskTxPos{FlatFilePos{0, 0}, 0}}));
+    std::pair<uint8_t, CompactTxKey> key;
+    while (it->Valid() && it->GetKey(key) && key.first == DB_TXINDEX_COMPACT && key.second.prefix == prefix) {
+        positions.push_back(key.second.pos);
+        it->Next();
+    }
+    return positions;
 }
 
 bool TxIndex::DB::WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos)
 {
     CDBBatch batch(*this);
     for (const auto& tuple : v_pos) {
-        batch.Write(std::make_pair(DB_TXINDEX, tuple.first), tuple.second);
+        batch.Write(std::make_pair(DB_TXINDEX_COMPACT, CompactTxKey{TxidPrefix(tuple.first), tuple.second}), Span<const unsigned char>{});
     }
     return WriteBatch(batch);
 }
 
+uint64_t TxIndex::DB::EstimateLegacyEntries() const
+{
+    return EstimateSize(DB_TXINDEX, uint8_t(DB_TXINDEX + 1)) / LEGACY_ENTRY_BYTES;
+}
+
+bool TxIndex::DB::MigrateLegacyEntries(size_t count, uint64_t& moved)
+{
+    CDBBatch batch(*this);
+    std::unique_ptr<CDBIterator> it{NewIterator()};
+    it->Seek(DB_TXINDEX);
+    std::pair<uint8_t, uint256> key;
+    size_t batched{0};
+    for (; batched < count && it->Valid() && it->GetKey(key) && key.first == DB_TXINDEX; it->Next(), ++batched) {
+        CDiskTxPos pos;
+        if (!it->GetValue(pos)) return error("%s: cannot read the position of %s", __func__, key.second.ToString());
+        batch.Write(std::make_pair(DB_TXINDEX_COMPACT, CompactTxKey{TxidPrefix(key.second), pos}), Span<const unsigned char>{});
+        batch.Erase(key);
+    }
+    // Both formats change in one batch, so a lookup finds the entry in one or the other
+    if (!WriteBatch(batch)) return false;
+    moved += batched;
+    if (batched < count) m_legacy_entries = false;
+    return true;
+}
+
 TxIndex::TxIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
     : BaseIndex(std::move(chain), "txindex"), m_db(std::make_unique<TxIndex::DB>(n_cache_size, f_memory, f_wipe))
 {}
@@ -75,28 +169,51 @@ BaseIndex::DB& TxIndex::GetDB() const { return *m_db; }
 
 bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
 {
-    CDiskTxPos postx;
-    if (!m_db->ReadTxPos(tx_hash, postx)) {
-        return false;
+    bool found{false};
+    for (const CDiskTxPos& postx : m_db->ReadTxPos(tx_hash)) {
+        CBlockHeader header;
+        CTransactionRef candidate;
+        // A transaction whose txid only starts the same is skipped
+        if (!ReadTransactionFromDisk(postx, postx.nTxOffset, header, candidate) || candidate->GetHash() != tx_hash) {
+            continue;
+        }
+        if (found) {
+            // Indexed again after a reorg: the block in the active chain wins
+            bool in_active_chain{false};
+            m_chain->findBlock(header.GetHash(), interfaces::FoundBlock().inActiveChain(in_active_chain));
+            if (!in_active_chain) continue;
+        }
+        block_hash = header.GetHash();
+        tx = std::move(candidate);
+        found = true;
     }
+    return found;
+}
 
-    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-    if (file.IsNull()) {
-        return error("%s: OpenBlockFile failed", __func__);
-    }
-    CBlockHeader header;
-    try {
-        file >> header;
-        if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
-            return error("%s: fseek(...) failed", __func__);
+bool TxIndex::HasLegacyEntries() const
+{
+    return m_db->m_legacy_entries;
+}
+
+bool TxIndex::MigrateLegacyEntries()
+{
+    const uint64_t total{m_db->EstimateLegacyEntries()};
+    LogPrintf("%s: moving about %d entries to the compact format. Versions before it can't read the moved entries: "
+              "to downgrade, rebuild the index with -reindex, or remove indexes/txindex first.\n", GetName(), total);
+    uint64_t moved{0};
+    while (m_db->m_legacy_entries) {
+        if (node::JobCancelRequested()) {
+            LogPrintf("%s: moved %d entries to the compact format, the rest move on the next start\n", GetName(), moved);
+            return false;
         }
-        file >> tx;
-    } catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
-    }
-    if (tx->GetHash() != tx_hash) {
-        return error("%s: txid mismatch", __func__);
+        if (!m_db->MigrateLegacyEntries(MIGRATE_BATCH_SIZE, moved)) {
+            return error("%s: failed to move entries to the compact format", GetName());
+        }
+        node::SetJobProgress(moved, std::max(moved, total));
+        node::JobYield();
     }
-    block_hash = header.GetHash();
+    LogPrintf("%s: moved %d entries to the compact format\n", GetName(), moved);
+    // Reclaim the space of the entries erased now rather than as the levels they are in happen to compact
+    m_db->Compact();
     return true;
 }
@@ -12,7 +12,9 @@ static constexpr bool DEFAULT_TXINDEX{true};
 /**
  * TxIndex is used to look up transactions included in the blockchain by hash.
  * The index is written to a LevelDB database and records the filesystem
- * location of each transaction by transaction hash.
+ * location of each transaction under a prefix of its hash, with the location
+ * packed as VARINTs. Databases written before keyed each location by the full
+ * hash; their entries are read as well until MigrateLegacyEntries() moves them.
  */
 class TxIndex final : public BaseIndex
 {
@@ -43,6 +45,14 @@ public:
     /// @param[out]  tx  The transaction itself.
     /// @return  true if transaction is found, false otherwise
     bool FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const;
+
+    /// Whether entries keyed by the full txid remain to be moved to the compact format.
+    bool HasLegacyEntries() const;
+
+    /// Move the entries keyed by the full txid to the compact format, a batch
+    /// at a time, on a job of the JobQueue. Returns false if cancelled or on
+    /// error, the entries left then being moved on the next start.
+    bool MigrateLegacyEntries();
 };
 
 /// The global transaction index, used in GetTransaction. May be null.
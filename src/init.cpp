@@ -13,6 +13,7 @@
 #include <kernel/mempool_persist.h>
 #include <kernel/validation_cache_sizes.h>
 
+#include <addrdb.h>
 #include <addrman.h>
 #include <banman.h>
 #include <blockfilter.h>
@@ -23,14 +24,19 @@
 #include <hash.h>
 #include <httprpc.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
+#include <index/base.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/stakeindex.h>
+#include <index/storageindex.h>
 #include <index/txindex.h>
 #include <init/common.h>
 #include <interfaces/chain.h>
 #include <interfaces/init.h>
 #include <interfaces/node.h>
 #include <interfaces/wallet.h>
+#include <lynxconfig.h>
 #include <mapport.h>
 #include <net.h>
 #include <net_permissions.h>
@@ -39,14 +45,19 @@
 #include <netgroup.h>
 #include <node/blockmanager_args.h>
 #include <node/blockstorage.h>
+#include <node/blocktemplatecache.h>
 #include <node/caches.h>
 #include <node/chainstate.h>
 #include <node/chainstatemanager_args.h>
 #include <node/context.h>
 #include <node/interface_ui.h>
+#include <node/jobs.h>
+#include <node/memorybudget.h>
 #include <node/mempool_args.h>
 #include <node/mempool_persist_args.h>
 #include <node/miner.h>
+#include <node/profiler.h>
+#include <node/startup.h>
 #include <node/txreconciliation.h>
 #include <node/validation_cache_args.h>
 #include <policy/feerate.h>
@@ -70,6 +81,11 @@
 #include <script/standard.h>
 #include <shutdown.h>
 #include <storage/auth.h>
+#include <storage/authsync.h>
+#include <storage/cache.h>
+#include <storage/funding.h>
+#include <storage/peerfetch.h>
+#include <storage/uploads.h>
 #include <storage/util.h>
 #include <storage/worker.h>
 #include <sync.h>
@@ -83,11 +99,13 @@
 #include <util/fs_helpers.h>
 #include <util/moneystr.h>
 #include <util/strencodings.h>
+#include <util/sock.h>
 #include <util/string.h>
 #include <util/syscall_sandbox.h>
 #include <util/syserror.h>
 #include <util/system.h>
 #include <util/thread.h>
+#include <util/threadaffinity.h>
 #include <util/threadnames.h>
 #include <util/translation.h>
 #include <validation.h>
@@ -101,6 +119,7 @@
 #include <cstdio>
 #include <fstream>
 #include <functional>
+#include <limits>
 #include <set>
 #include <string>
 #include <thread>
@@ -126,12 +145,17 @@ using kernel::DumpMempool;
 using kernel::ValidationCacheSizes;
 
 using node::ApplyArgsManOptions;
+using node::BlockTemplateCache;
 using node::CacheSizes;
 using node::CalculateCacheSizes;
+using node::DEFAULT_BLOCK_TEMPLATE_CACHE;
+using node::DEFAULT_CHECK_STORED_POW;
 using node::DEFAULT_PERSIST_MEMPOOL;
 using node::DEFAULT_PRINTPRIORITY;
+using node::DEFAULT_REINDEX_THREADS;
 using node::DEFAULT_STOPAFTERBLOCKIMPORT;
 using node::LoadChainstate;
+using node::MAX_REINDEX_THREADS;
 using node::MempoolPath;
 using node::ShouldPersistMempool;
 using node::NodeContext;
@@ -139,9 +163,6 @@ using node::ThreadImport;
 using node::VerifyLoadedChainstate;
 using node::fReindex;
 
-std::thread chunkman;
-std::thread stakeman;
-
 static constexpr bool DEFAULT_PROXYRANDOMIZE{true};
 static constexpr bool DEFAULT_REST_ENABLE{false};
 static constexpr bool DEFAULT_I2P_ACCEPT_INCOMING{true};
@@ -229,6 +250,7 @@ void Interrupt(NodeContext& node)
     InterruptHTTPRPC();
     InterruptRPC();
     InterruptREST();
+    InterruptMetrics();
     InterruptTorControl();
     InterruptMapPort();
     if (node.connman)
@@ -236,10 +258,22 @@ void Interrupt(NodeContext& node)
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    if (g_address_index) {
+        g_address_index->Interrupt();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Interrupt(); });
     if (g_coin_stats_index) {
         g_coin_stats_index->Interrupt();
     }
+    if (g_stake_index) {
+        g_stake_index->Interrupt();
+    }
+    if (g_storage_index) {
+        g_storage_index->Interrupt();
+    }
+    if (node::g_job_queue) {
+        node::g_job_queue->Interrupt();
+    }
 }
 
 void Shutdown(NodeContext& node)
@@ -259,10 +293,19 @@ void Shutdown(NodeContext& node)
 
     StopHTTPRPC();
     StopREST();
+    StopMetrics();
     StopRPC();
     StopHTTPServer();
+    // A profile not written by stopprofiler is dropped
+    node::g_profiler.Stop();
+    if (node::g_job_queue) {
+        node::g_job_queue->Stop();
+        node::g_job_queue.reset();
+    }
+    g_storage_funding.reset();
+    g_storage_uploads.reset();
 #ifdef ENABLE_WALLET
-    StopThreadStakeMiner();
+    stakeman_shutdown();
 #endif
     for (const auto& client : node.chain_clients) {
         client->flush();
@@ -272,6 +315,7 @@ void Shutdown(NodeContext& node)
     // Because these depend on each-other, we make sure that neither can be
     // using the other before destroying them.
     if (node.peerman) UnregisterValidationInterface(node.peerman.get());
+    if (node.peerman) node.peerman->StopMessageWorkers();
     if (node.connman) node.connman->Stop();
 
     StopTorControl();
@@ -284,6 +328,7 @@ void Shutdown(NodeContext& node)
 
     // After the threads that potentially access these pointers have been stopped,
     // destruct and reset all to nullptr.
+    g_asset_chunk_fetcher.reset();
     node.peerman.reset();
     node.connman.reset();
     node.banman.reset();
@@ -311,15 +356,42 @@ void Shutdown(NodeContext& node)
     // CValidationInterface callbacks, flush them...
     GetMainSignals().FlushBackgroundCallbacks();
 
+    // Write authList only after flushing background callbacks.
+    if (g_auth_list_sync) {
+        g_auth_list_sync->Stop();
+        g_auth_list_sync.reset();
+    }
+    if (g_storage_cache) {
+        g_storage_cache->Stop();
+        g_storage_cache.reset();
+    }
+    if (node::g_block_template_cache) {
+        node::g_block_template_cache->Stop();
+        node::g_block_template_cache.reset();
+    }
+    node::g_memory_budget.reset();
+
     // Stop and delete all indexes only after flushing background callbacks.
     if (g_txindex) {
         g_txindex->Stop();
         g_txindex.reset();
     }
+    if (g_address_index) {
+        g_address_index->Stop();
+        g_address_index.reset();
+    }
     if (g_coin_stats_index) {
         g_coin_stats_index->Stop();
         g_coin_stats_index.reset();
     }
+    if (g_stake_index) {
+        g_stake_index->Stop();
+        g_stake_index.reset();
+    }
+    if (g_storage_index) {
+        g_storage_index->Stop();
+        g_storage_index.reset();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Stop(); });
     DestroyAllBlockFilterIndexes();
 
@@ -368,6 +440,7 @@ void Shutdown(NodeContext& node)
     }
 
     LogPrintf("%s: done\n", __func__);
+    LogInstance().StopAsync();
 }
 
 /**
@@ -445,23 +518,38 @@ void SetupServerArgs(ArgsManager& argsman)
 #if HAVE_SYSTEM
     argsman.AddArg("-alertnotify=<cmd>", "Execute command when an alert is raised (%s in cmd is replaced by message)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
+    argsman.AddArg("-addressindex", strprintf("Maintain an index of the outputs paying to each script and the inputs spending them, used by the getaddressoutputs and getspentinfo RPCs (default: %u)", DEFAULT_ADDRESSINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-assumevalid=<hex>", strprintf("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s, signet: %s)", defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex(), signetChainParams->GetConsensus().defaultAssumeValid.GetHex()), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-autotune", strprintf("When creating the config file on first run, probe the cores, memory and disk of the machine and write settings tuned for them into it (default: %u)", DEFAULT_AUTOTUNE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-backgroundflush", strprintf("Write the coins cache to disk on a background thread when it is flushed periodically or for its size, so block connection doesn't wait on it (default: %u)", DEFAULT_BACKGROUND_FLUSH), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockcachesize=<n>", strprintf("Maximum memory in MiB for blocks read repeatedly, kept deserialized, 0 to disable (default: %u)", node::DEFAULT_BLOCK_CACHE_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockcompression", strprintf("Write new blocks to the block files compressed when that makes them smaller. Blocks are read either way (default: %u)", node::DEFAULT_BLOCK_COMPRESSION), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockfilemaps=<n>", strprintf("Number of block files to keep memory-mapped for reading blocks out of, 0 to read them with file I/O (default: %u)", node::DEFAULT_BLOCK_FILE_MAPS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockindexcompact", strprintf("Store block index records in a compact form, about half the size. Versions before it can't read them: restart with -blockindexcompact=0 before downgrading, which rewrites them in the legacy form, or run a full -reindex with the older version (default: %u)", DEFAULT_BLOCK_INDEX_COMPACT), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksdir=<dir>", "Specify directory to hold blocks subdirectory for *.dat files (default: <datadir>)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #if HAVE_SYSTEM
     argsman.AddArg("-blocknotify=<cmd>", "Execute command when the best block changes (%s in cmd is replaced by block hash)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
     argsman.AddArg("-blockreconstructionextratxn=<n>", strprintf("Extra transactions to keep in memory for compact block reconstructions (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-cmpctblockprefill=<n>", strprintf("Bytes of the transactions peers are likely missing, storage transactions first, to send along in compact blocks (default: %u)", DEFAULT_CMPCTBLOCK_PREFILL_BYTES), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-compressedheaders", strprintf("Exchange headers with the peers supporting it as \"cheaders\" messages, which leave out the previous block hash and encode time, version and bits against the headers before, in about half the bytes (default: %u)", DEFAULT_COMPRESSED_HEADERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-blocksonly", strprintf("Whether to reject transactions from network peers. Automatic broadcast and rebroadcast of any transactions from inbound peers is disabled, unless the peer has the 'forcerelay' permission. RPC transactions are not affected. (default: %u)", DEFAULT_BLOCKSONLY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-coinstatsindex", strprintf("Maintain coinstats index used by the gettxoutsetinfo RPC (default: %u)", DEFAULT_COINSTATSINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-conf=<file>", strprintf("Specify path to read-only configuration file. Relative paths will be prefixed by datadir location (only useable from command line, not configuration file) (default: %s)", BITCOIN_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-datadir=<dir>", "Specify data directory", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (%d to %d, default: %d). In addition, unused mempool memory is shared for this cache (see -maxmempool).", nMinDbCache, nMaxDbCache, nDefaultDbCache), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dboption=[<db>:]<name>=<n>", "Set a LevelDB option of database <db> (chainstate, blockindex, or an index such as txindex), or of all databases without <db>. <name> is writebuffer (write buffer size in MiB, default: a quarter of the database's cache), bloombits (bloom filter bits per key, default: 10), maxfilesize (table file size in MiB, default: 2) or compactionrate (MiB per second background compactions write at most, default: unlimited). Overrides -dbprofile. Can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbprofile=[<db>:]<profile>", "Tune database <db> (see -dboption), or all databases without <db>, for a profile: default, ssd, hdd or archive. Can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-includeconf=<file>", "Specify additional configuration file, relative to the -datadir path (only useable from configuration file, not command line)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-loadblock=<file>", "Imports blocks from external file on startup", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-maxmempool=<n>", strprintf("Keep the transaction memory pool below <n> megabytes (default: %u)", DEFAULT_MAX_MEMPOOL_SIZE_MB), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-maxstoragemempool=<n>", strprintf("Keep the storage transactions in the memory pool below <n> megabytes, evicting them ahead of other transactions (default: %u)", DEFAULT_MAX_STORAGE_MEMPOOL_SIZE_MB), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-maxorphanchaintx=<n>", strprintf("Keep at most <n> more unconnectable transactions in memory that spend other unconnectable ones, such as chains of storage transactions received out of order (default: %u)", DEFAULT_MAX_ORPHAN_CHAIN_TRANSACTIONS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-maxorphantx=<n>", strprintf("Keep at most <n> unconnectable transactions in memory (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-memorybudget=<n>", strprintf("Scale the coins cache, the memory pool and the block cache down together when the process nears <n> MiB resident or the kernel reports memory pressure, and back up once it subsides, 0 to disable (default: %u). Their sizes are also changed by setcachesizes", node::DEFAULT_MEMORY_BUDGET), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-mempoolexpiry=<n>", strprintf("Do not keep transactions in the mempool longer than <n> hours (default: %u)", DEFAULT_MEMPOOL_EXPIRY_HOURS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-messageworkers=<n>", strprintf("Number of threads the per-peer work on received messages not needing the chain state lock is done on (deserializing and checking blocks and large transactions, serving blocks), up to %d, 0 to do it on the message handler (default: %d)", MAX_MESSAGE_WORKERS, DEFAULT_MESSAGE_WORKERS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet: %s, signet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex(), signetChainParams->GetConsensus().nMinimumChainWork.GetHex()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-par=<n>", strprintf("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -469,15 +557,29 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-pid=<file>", strprintf("Specify pid file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)", BITCOIN_PID_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk. This will also rebuild active optional indexes.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks. Deactivate all optional indexes before running this.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-reindexthreads=<n>", strprintf("Number of block files to parse and check on threads of their own during -reindex, ahead of the one whose blocks are being indexed (0 to %d, 0 = parse each file as it is indexed, default: %d)", MAX_REINDEX_THREADS, DEFAULT_REINDEX_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-settings=<file>", strprintf("Specify path to dynamic settings data file. Can be disabled with -nosettings. File is written at runtime and not meant to be edited by users (use %s instead for custom settings). Relative paths will be prefixed by datadir location. (default: %s)", BITCOIN_CONF_FILENAME, BITCOIN_SETTINGS_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #if HAVE_SYSTEM
     argsman.AddArg("-startupnotify=<cmd>", "Execute command on startup.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-shutdownnotify=<cmd>", "Execute command immediately before beginning shutdown. The need for shutdown may be urgent, so be careful not to delay it long (if the command doesn't require interaction with the server, consider having it fork into the background).", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
-    argsman.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storagecachesize=<n>", strprintf("Keep up to <n> MiB of fetched assets in the datadir, so that repeated fetches are copied from disk (0 to disable, default: %d)", DEFAULT_STORAGE_CACHE_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storagecompact", strprintf("Store assets with the compact chunk protocol 02, which nodes from before it can not fetch (default: %u)", DEFAULT_STORAGE_COMPACT), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storagecompress", strprintf("Store assets compressed when that makes them smaller, with the compact chunk protocol only (default: %u)", DEFAULT_STORAGE_COMPRESS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storagecontenthash", strprintf("Store assets with the sha256 of the file in their header, for store's reuse argument to find, which nodes from before it can not fetch. Implies -storagecompact (default: %u)", DEFAULT_STORAGE_CONTENTHASH), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storageencrypt", strprintf("Store assets encrypted with the tenant key, so only the tenant can read them, implies -storagecompact (default: %u)", DEFAULT_STORAGE_ENCRYPT), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storagefundingoutputs=<n>", strprintf("Keep <n> outputs of -storagefundingsize split off in the first wallet, locked, to pay for putfile transactions without scanning the wallet. The pool is refilled in the background as uploads spend it (0 to disable, default: %d)", DEFAULT_STORAGE_FUNDING_OUTPUTS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storagefundingsize=<amt>", strprintf("Value (in %s) of each output of the storage funding pool, at least 1 (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_STORAGE_FUNDING_SIZE)), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storagequota=<n>", strprintf("Refuse to store a file that takes the confirmed usage of the tenant, as tenantusage reports it, past <n> MiB. Requires -storageindex (0 for no quota, default: %d)", DEFAULT_STORAGE_QUOTA), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-stakeindex", strprintf("Maintain an index of the coinstakes of proof-of-stake blocks, used by the getstakinghistory and getstakingstats RPCs (default: %u)", DEFAULT_STAKEINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storageindex", strprintf("Maintain an index of stored assets, used by the storage RPC calls. With -prune it also keeps the chunks of the assets, so they can be fetched once their blocks are pruned (default: %u)", DEFAULT_STORAGEINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-jobthreads=<n>", strprintf("Number of background jobs, such as store and fetch jobs, run concurrently. Store jobs are run one at a time, and large store and fetch jobs leave a thread to the small ones (default: %d)", node::DEFAULT_JOB_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-storageworkers=<n>", "Deprecated, use -jobthreads", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-threadaffinity=<placement>", "Pin a group of threads to cores, so they keep their caches and the memory they allocate stays on their NUMA node. Groups are validation (script checks, block loading, validation interface), stake and net (socket and message handlers). <placement> is <group>=<cpus>, with a list of CPUs such as 0-7,16 or of NUMA nodes such as node1; numa, to pin validation to the first NUMA node and net and stake to the last on a machine with several; or none. Can be specified multiple times, later ones replacing what earlier ones gave a group. Only supported on Linux (default: none)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call. Its entries are stored in a compact format that older versions can't read, which need it rebuilt with -reindex (default: %u)", DEFAULT_TXINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blockfilterindex=<type>",
                  strprintf("Maintain an index of compact filters by block (default: %s, values: %s).", DEFAULT_BLOCKFILTERINDEX, ListBlockFilterTypes()) +
-                 " If <type> is not supplied or if <type> = 1, indexes for all known types are enabled.",
+                 " If <type> is not supplied or if <type> = 1, indexes for all known types but storage are enabled.",
                  ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 
     argsman.AddArg("-addnode=<ip>", strprintf("Add a node to connect to and attempt to keep the connection open (see the addnode RPC help for more info). This option can be specified multiple times to add multiple nodes; connections are limited to %u at a time and are counted separately from the -maxconnections limit.", MAX_ADDNODE_CONNECTIONS), ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::CONNECTION);
@@ -504,8 +606,11 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-i2pacceptincoming", strprintf("Whether to accept inbound I2P connections (default: %i). Ignored if -i2psam is not set. Listening for inbound I2P connections is done through the SAM proxy, not by binding to a local address and port.", DEFAULT_I2P_ACCEPT_INCOMING), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-onlynet=<net>", "Make automatic outbound connections only to network <net> (" + Join(GetNetworkNames(), ", ") + "). Inbound and manual connections are not affected by this option. It can be specified multiple times to allow multiple networks.", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerbloomfilters", strprintf("Support filtering of blocks and transaction with bloom filters (default: %u)", DEFAULT_PEERBLOOMFILTERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-peersjournal", strprintf("Append changed peer addresses to peers_journal.dat instead of rewriting peers.dat on every flush (default: %u)", DEFAULT_PEERS_JOURNAL), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerblockfilters", strprintf("Serve compact block filters to peers per BIP 157 (default: %u)", DEFAULT_PEERBLOCKFILTERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
-    argsman.AddArg("-txreconciliation", strprintf("Enable transaction reconciliations per BIP 330 (default: %d)", DEFAULT_TXRECONCILIATION_ENABLE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-peerstorage", strprintf("Serve the chunks of stored assets to peers, which requires -storageindex (default: %u)", DEFAULT_PEERSTORAGE), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-storagepeerfetch", strprintf("Fetch assets whose blocks are not held locally from peers serving stored assets (default: %u)", DEFAULT_STORAGEPEERFETCH), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-txreconciliation", strprintf("Announce transactions to the peers supporting it by reconciling sets of them per BIP 330 (Erlay), flooding them to only a share of the outbound ones (default: %d)", DEFAULT_TXRECONCILIATION_ENABLE), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     // TODO: remove the sentence "Nodes not using ... incoming connections." once the changes from
     // https://github.com/bitcoin/bitcoin/pull/23542 have become widespread.
     argsman.AddArg("-port=<port>", strprintf("Listen for connections on <port>. Nodes not using the default ports (default: %u, testnet: %u, signet: %u, regtest: %u) are unlikely to get incoming connections. Not relevant for I2P (see doc/i2p.md).", defaultChainParams->GetDefaultPort(), testnetChainParams->GetDefaultPort(), signetChainParams->GetDefaultPort(), regtestChainParams->GetDefaultPort()), ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::CONNECTION);
@@ -513,6 +618,7 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-proxyrandomize", strprintf("Randomize credentials for every proxy connection. This enables Tor stream isolation (default: %u)", DEFAULT_PROXYRANDOMIZE), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-seednode=<ip>", "Connect to a node to retrieve peer addresses, and disconnect. This option can be specified multiple times to connect to multiple nodes.", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-networkactive", "Enable all P2P network activity (default: 1). Can be changed by the setnetworkactive RPC command", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-socketevents=<mode>", "Method for checking the sockets of the connections for readiness: poll (rebuild the set of sockets on each iteration), epoll (Linux) or kqueue (BSD and macOS), the last two keep the sockets registered with the kernel (default: poll)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-timeout=<n>", strprintf("Specify socket connection timeout in milliseconds. If an initial attempt to connect is unsuccessful after this amount of time, drop it (minimum: 1, default: %d)", DEFAULT_CONNECT_TIMEOUT), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peertimeout=<n>", strprintf("Specify a p2p connection timeout delay in seconds. After connecting to a peer, wait this amount of time before considering disconnection based on inactivity (minimum: 1, default: %d)", DEFAULT_PEER_CONNECT_TIMEOUT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
     argsman.AddArg("-torcontrol=<ip>:<port>", strprintf("Tor control port to use if onion listening enabled (default: %s)", DEFAULT_TOR_CONTROL), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
@@ -547,22 +653,38 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-zmqpubrawblock=<address>", "Enable publish raw block in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtx=<address>", "Enable publish raw transaction in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequence=<address>", "Enable publish hash block and tx sequence in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubjob=<address>", "Enable publish finished background jobs in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubassetconfirmed=<address>", "Enable publish stored assets with every chunk mined in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubauthlist=<address>", "Enable publish storage authlist changes in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubstake=<address>", "Enable publish stake attempts in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashblockhwm=<n>", strprintf("Set publish hash block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashtxhwm=<n>", strprintf("Set publish hash transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawblockhwm=<n>", strprintf("Set publish raw block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtxhwm=<n>", strprintf("Set publish raw transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequencehwm=<n>", strprintf("Set publish hash sequence message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubjobhwm=<n>", strprintf("Set publish job outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubassetconfirmedhwm=<n>", strprintf("Set publish asset confirmed outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubauthlisthwm=<n>", strprintf("Set publish authlist outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubstakehwm=<n>", strprintf("Set publish stake outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
     hidden_args.emplace_back("-zmqpubrawblock=<address>");
     hidden_args.emplace_back("-zmqpubrawtx=<address>");
     hidden_args.emplace_back("-zmqpubsequence=<n>");
+    hidden_args.emplace_back("-zmqpubjob=<address>");
+    hidden_args.emplace_back("-zmqpubassetconfirmed=<address>");
+    hidden_args.emplace_back("-zmqpubauthlist=<address>");
+    hidden_args.emplace_back("-zmqpubstake=<address>");
     hidden_args.emplace_back("-zmqpubhashblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubhashtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubsequencehwm=<n>");
+    hidden_args.emplace_back("-zmqpubjobhwm=<n>");
+    hidden_args.emplace_back("-zmqpubassetconfirmedhwm=<n>");
+    hidden_args.emplace_back("-zmqpubauthlisthwm=<n>");
+    hidden_args.emplace_back("-zmqpubstakehwm=<n>");
 #endif
 
     argsman.AddArg("-checkblocks=<n>", strprintf("How many blocks to check at startup (default: %u, 0 = all)", DEFAULT_CHECKBLOCKS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -570,6 +692,7 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-checkblockindex", strprintf("Do a consistency check for the block tree, chainstate, and other validation data structures occasionally. (default: %u, regtest: %u)", defaultChainParams->DefaultConsistencyChecks(), regtestChainParams->DefaultConsistencyChecks()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-checkaddrman=<n>", strprintf("Run addrman consistency checks every <n> operations. Use 0 to disable. (default: %u)", DEFAULT_ADDRMAN_CONSISTENCY_CHECKS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-checkmempool=<n>", strprintf("Run mempool consistency checks every <n> transactions. Use 0 to disable. (default: %u, regtest: %u)", defaultChainParams->DefaultConsistencyChecks(), regtestChainParams->DefaultConsistencyChecks()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-checkstoredpow", strprintf("Recheck the proof of work of every block read back from disk, including those already connected (default: %u)", DEFAULT_CHECK_STORED_POW), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-checkpoints", strprintf("Enable rejection of any forks from the known historical chain until block %s (default: %u)", defaultChainParams->Checkpoints().GetHeight(), DEFAULT_CHECKPOINTS_ENABLED), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-deprecatedrpc=<method>", "Allows deprecated RPC method(s) to be used", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-stopafterblockimport", strprintf("Stop running after importing blocks from disk (default: %u)", DEFAULT_STOPAFTERBLOCKIMPORT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -578,9 +701,14 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-limitancestorsize=<n>", strprintf("Do not accept transactions whose size with all in-mempool ancestors exceeds <n> kilobytes (default: %u)", DEFAULT_ANCESTOR_SIZE_LIMIT_KVB), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-limitdescendantcount=<n>", strprintf("Do not accept transactions if any ancestor would have <n> or more in-mempool descendants (default: %u)", DEFAULT_DESCENDANT_LIMIT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-limitdescendantsize=<n>", strprintf("Do not accept transactions if any ancestor would have more than <n> kilobytes of in-mempool descendants (default: %u).", DEFAULT_DESCENDANT_SIZE_LIMIT_KVB), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-limitstoragechaincount=<n>", strprintf("Raise the ancestor and descendant count limits to <n> for storage transactions, as a large upload chains them (default: %u)", DEFAULT_STORAGE_CHAIN_LIMIT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-limitstoragechainsize=<n>", strprintf("Raise the ancestor and descendant size limits to <n> kilobytes for storage transactions (default: %u)", DEFAULT_STORAGE_CHAIN_SIZE_LIMIT_KVB), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-lockprofile", strprintf("Record how long each lock site, such as those of cs_main, waits for and holds its mutex, as reported by getlockstats (default: %u)", DEFAULT_LOCK_PROFILING), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-addrmantest", "Allows to test address relay on localhost", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-capturemessages", "Capture all P2P messages to disk", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-mocktime=<n>", "Replace actual time with " + UNIX_EPOCH_TIME + " (default: 0)", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg("-sigcachebudget=<n>", strprintf("Let the signature cache and script execution cache grow beyond -maxsigcachesize while entries are evicted before use, such as during transaction bursts, up to a sum of <n> MiB (default: %u)", DEFAULT_SIG_CACHE_BUDGET), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-schedulerthreads=<n>", strprintf("Number of threads running scheduled background tasks, so that a long task does not hold up the others (minimum: 1, default: %d)", DEFAULT_SCHEDULER_THREADS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-maxsigcachesize=<n>", strprintf("Limit sum of signature cache and script execution cache sizes to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_BYTES >> 20), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg("-maxtipage=<n>",
                    strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)",
@@ -608,11 +736,16 @@ void SetupServerArgs(ArgsManager& argsman)
 
     argsman.AddArg("-blockmaxweight=<n>", strprintf("Set maximum BIP141 block weight (default: %d)", DEFAULT_BLOCK_MAX_WEIGHT), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
     argsman.AddArg("-blockmintxfee=<amt>", strprintf("Set lowest fee rate (in %s/kvB) for transactions to be included in block creation. (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_MIN_TX_FEE)), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
+    argsman.AddArg("-blocktemplatecache", strprintf("Keep the transactions for the next block selected as the mempool changes, instead of selecting them for each block template (default: %u)", DEFAULT_BLOCK_TEMPLATE_CACHE), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
     argsman.AddArg("-blockversion=<n>", "Override block version to test forking scenarios", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::BLOCK_CREATION);
 
+    argsman.AddArg("-blockrendercache=<n>", strprintf("Keep up to <n> MiB of blocks rendered as hex and JSON for getblock and REST, once they have %d confirmations (0 to disable, default: %d)", BLOCK_RENDER_CACHE_MIN_DEPTH, DEFAULT_BLOCK_RENDER_CACHE_MB), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg("-metricsbind=<addr>[:port]", "Bind to given address to serve metrics on -metricsport. Port is optional and overrides -metricsport. Use [host]:port notation for IPv6. This option can be specified multiple times (default: 127.0.0.1 and ::1 i.e., localhost)", ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::RPC);
+    argsman.AddArg("-metricsport=<port>", "Serve node metrics in the Prometheus text format at /metrics on <port>, to the hosts allowed by -rpcallowip and without authentication. Implies -server (default: 0, disabled)", ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::RPC);
     argsman.AddArg("-rest", strprintf("Accept public REST requests (default: %u)", DEFAULT_REST_ENABLE), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcallowip=<ip>", "Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcauth=<userpw>", "Username and HMAC-SHA-256 hashed password for JSON-RPC connections. The field <userpw> comes in the format: <USERNAME>:<SALT>$<HASH>. A canonical python script is included in share/rpcauth. The client then connects normally using the rpcuser=<USERNAME>/rpcpassword=<PASSWORD> pair of arguments. This option can be specified multiple times", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
+    argsman.AddArg("-rpcbatchparallel", strprintf("Execute the requests of a JSON-RPC batch concurrently on the RPC threads that are idle, replying in order. Batches calling a wallet method are executed in order regardless (default: %u)", DEFAULT_RPC_BATCH_PARALLEL), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcbind=<addr>[:port]", "Bind to given address to listen for JSON-RPC connections. Do not expose the RPC server to untrusted networks such as the public internet! This option is ignored unless -rpcallowip is also passed. Port is optional and overrides -rpcport. Use [host]:port notation for IPv6. This option can be specified multiple times (default: 127.0.0.1 and ::1 i.e., localhost)", ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::RPC);
     argsman.AddArg("-rpcdoccheck", strprintf("Throw a non-fatal error at runtime if the documentation for an RPC is incorrect (default: %u)", DEFAULT_RPC_DOC_CHECK), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::RPC);
     argsman.AddArg("-rpccookiefile=<loc>", "Location of the auth cookie. Relative paths will be prefixed by a net-specific datadir location. (default: data dir)", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
@@ -620,7 +753,9 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-rpcport=<port>", strprintf("Listen for JSON-RPC connections on <port> (default: %u, testnet: %u, signet: %u, regtest: %u)", defaultBaseParams->RPCPort(), testnetBaseParams->RPCPort(), signetBaseParams->RPCPort(), regtestBaseParams->RPCPort()), ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::RPC);
     argsman.AddArg("-rpcserialversion", strprintf("Sets the serialization of raw transaction or block hex returned in non-verbose mode, non-segwit(0) or segwit(1) (default: %d)", DEFAULT_RPC_SERIALIZE_VERSION), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcservertimeout=<n>", strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::RPC);
+    argsman.AddArg("-rpcslowlog=<ms>", strprintf("Log RPC calls taking longer than <ms> milliseconds, with their parameters, except those of calls holding keys or passphrases (0 to disable, default: %d)", DEFAULT_RPC_SLOW_LOG), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcthreads=<n>", strprintf("Set the number of threads to service RPC calls (default: %d)", DEFAULT_HTTP_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg("-rpcmaxthreads=<n>", strprintf("Start more threads to service RPC calls while calls keep waiting for one, up to this many in all (default: %d)", DEFAULT_HTTP_MAX_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcuser=<user>", "Username for JSON-RPC connections", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
     argsman.AddArg("-rpcwhitelist=<whitelist>", "Set a whitelist to filter incoming RPC calls for a specific user. The field <whitelist> comes in the format: <USERNAME>:<rpc 1>,<rpc 2>,...,<rpc n>. If multiple whitelists are set for a given user, they are set-intersected. See -rpcwhitelistdefault documentation for information on default whitelist behavior.", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcwhitelistdefault", "Sets default behavior for rpc whitelisting. Unless rpcwhitelistdefault is set to 0, if any -rpcwhitelist is set, the rpc server acts as if all rpc users are subject to empty-unless-otherwise-specified whitelists. If rpcwhitelistdefault is set to 1 and no -rpcwhitelist is set, rpc server acts as if all rpc users are subject to empty whitelists.", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
@@ -628,6 +763,9 @@ void SetupServerArgs(ArgsManager& argsman)
     argsman.AddArg("-server", "Accept command line and JSON-RPC commands", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-disablestaking", "Prevent staking thread immediately on startup (default: false)", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-stakethreadconddelayms", "Number of milliseconds to delay staking for on error condition (default: 60000)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-stakelookahead=<n>", strprintf("Number of coinstake timestamps to search ahead for a kernel, sleeping until the earliest found, 0 to search each one when it comes (default: %d)", DEFAULT_STAKE_LOOKAHEAD), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-stakeworkers=<n>", strprintf("Number of threads searching a wallet for a kernel, once it has over %u stakeable outputs per thread (default: %d)", MIN_STAKE_KERNELS_PER_WORKER, DEFAULT_STAKE_WORKERS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-stakingthreads=<n>", strprintf("Number of stake threads, which share the wallets, each taking the wallet due next of the greatest balance (default: %d)", DEFAULT_STAKING_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-stakethreadignorepeers", "Ignore the current initialblockdownload state and peer checks when staking (default: false)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 
 #if HAVE_DECL_FORK
@@ -681,9 +819,11 @@ static bool AppInitServers(NodeContext& node)
         return false;
     StartRPC();
     node.rpc_interruption_point = RpcInterruptionPoint;
+    g_block_render_cache.SetMaxSize(std::max<int64_t>(0, args.GetIntArg("-blockrendercache", DEFAULT_BLOCK_RENDER_CACHE_MB)) << 20);
     if (!StartHTTPRPC(&node))
         return false;
     if (args.GetBoolArg("-rest", DEFAULT_REST_ENABLE)) StartREST(&node);
+    if (args.GetIntArg("-metricsport", DEFAULT_METRICS_PORT) != 0) StartMetrics(&node);
     StartHTTPServer();
     return true;
 }
@@ -743,6 +883,12 @@ void InitParameterInteraction(ArgsManager& args)
         }
     }
 
+    if (args.GetIntArg("-metricsport", DEFAULT_METRICS_PORT) != 0) {
+        // the metrics server runs on the HTTP server of -server
+        if (args.SoftSetBoolArg("-server", true))
+            LogPrintf("%s: parameter interaction: -metricsport set -> setting -server=1\n", __func__);
+    }
+
     if (args.IsArgSet("-externalip")) {
         // if an explicit public IP is specified, do not try to find others
         if (args.SoftSetBoolArg("-discover", false))
@@ -763,6 +909,15 @@ void InitParameterInteraction(ArgsManager& args)
         if (args.SoftSetBoolArg("-whitelistrelay", true))
             LogPrintf("%s: parameter interaction: -whitelistforcerelay=1 -> setting -whitelistrelay=1\n", __func__);
     }
+    // Only the compact chunk protocol encrypts, the older ones would store the file as it is
+    if (args.GetBoolArg("-storageencrypt", DEFAULT_STORAGE_ENCRYPT)) {
+        if (args.SoftSetBoolArg("-storagecompact", true))
+            LogPrintf("%s: parameter interaction: -storageencrypt=1 -> setting -storagecompact=1\n", __func__);
+    }
+    if (args.GetBoolArg("-storagecontenthash", DEFAULT_STORAGE_CONTENTHASH)) {
+        if (args.SoftSetBoolArg("-storagecompact", true))
+            LogPrintf("%s: parameter interaction: -storagecontenthash=1 -> setting -storagecompact=1\n", __func__);
+    }
     if (args.IsArgSet("-onlynet")) {
         const auto onlynets = args.GetArgs("-onlynet");
         bool clearnet_reachable = std::any_of(onlynets.begin(), onlynets.end(), [](const auto& net) {
@@ -893,6 +1048,8 @@ bool AppInitParameterInteraction(const ArgsManager& args, bool use_syscall_sandb
     std::string blockfilterindex_value = args.GetArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX);
     if (blockfilterindex_value == "" || blockfilterindex_value == "1") {
         g_enabled_filter_types = AllBlockFilterTypes();
+        // The storage filter is only of use to storage clients, it is built when named
+        g_enabled_filter_types.erase(BlockFilterType::STORAGE);
     } else if (blockfilterindex_value != "0") {
         const std::vector<std::string> names = args.GetArgs("-blockfilterindex");
         for (const auto& name : names) {
@@ -913,6 +1070,15 @@ bool AppInitParameterInteraction(const ArgsManager& args, bool use_syscall_sandb
         nLocalServices = ServiceFlags(nLocalServices | NODE_COMPACT_FILTERS);
     }
 
+    // Signal NODE_STORAGE if peerstorage and the storage index are both enabled.
+    if (args.GetBoolArg("-peerstorage", DEFAULT_PEERSTORAGE)) {
+        if (!args.GetBoolArg("-storageindex", DEFAULT_STORAGEINDEX)) {
+            return InitError(_("Cannot set -peerstorage without -storageindex."));
+        }
+
+        nLocalServices = ServiceFlags(nLocalServices | NODE_STORAGE);
+    }
+
     // If -forcednsseed is set to true, ensure -dnsseed has not been set to false
     if (args.GetBoolArg("-forcednsseed", DEFAULT_FORCEDNSSEED) && !args.GetBoolArg("-dnsseed", DEFAULT_DNSSEED)){
         return InitError(_("Cannot set -forcednsseed to true when setting -dnsseed to false."));
@@ -965,6 +1131,19 @@ bool AppInitParameterInteraction(const ArgsManager& args, bool use_syscall_sandb
         return InitError(Untranslated("peertimeout must be a positive integer."));
     }
 
+    // Set before the threads of any group start, each is pinned as it is named
+    if (args.IsArgSet("-threadaffinity")) {
+        std::vector<util::ThreadPlacement> placements;
+        std::string error;
+        if (!util::ParseThreadAffinity(args.GetArgs("-threadaffinity"), util::ReadNumaNodes(), placements, error)) {
+            return InitError(Untranslated(error));
+        }
+        for (const util::ThreadPlacement& placement : placements) {
+            LogPrintf("Pinning the %s threads to %d cores\n", placement.group, placement.cpus.size());
+        }
+        util::SetThreadPlacements(std::move(placements));
+    }
+
     // Sanity check argument for min fee for including tx in block
     // TODO: Harmonize which arguments need sanity checking and where that happens
     if (args.IsArgSet("-blockmintxfee")) {
@@ -977,6 +1156,8 @@ bool AppInitParameterInteraction(const ArgsManager& args, bool use_syscall_sandb
 
     if (!g_wallet_init_interface.ParameterInteraction()) return false;
 
+    g_lock_profiling = args.GetBoolArg("-lockprofile", DEFAULT_LOCK_PROFILING);
+
     // Option to startup with mocktime set (used for regression testing):
     SetMockTime(args.GetIntArg("-mocktime", 0)); // SetMockTime(0) is a no-op
 
@@ -994,9 +1175,18 @@ bool AppInitParameterInteraction(const ArgsManager& args, bool use_syscall_sandb
         if (args.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX)) {
             return InitError(_("-reindex-chainstate option is not compatible with -coinstatsindex. Please temporarily disable coinstatsindex while using -reindex-chainstate, or replace -reindex-chainstate with -reindex to fully rebuild all indexes."));
         }
-        if (g_enabled_filter_types.count(BlockFilterType::BASIC)) {
+        if (!g_enabled_filter_types.empty()) {
             return InitError(_("-reindex-chainstate option is not compatible with -blockfilterindex. Please temporarily disable blockfilterindex while using -reindex-chainstate, or replace -reindex-chainstate with -reindex to fully rebuild all indexes."));
         }
+        if (args.GetBoolArg("-storageindex", DEFAULT_STORAGEINDEX)) {
+            return InitError(_("-reindex-chainstate option is not compatible with -storageindex. Please temporarily disable storageindex while using -reindex-chainstate, or replace -reindex-chainstate with -reindex to fully rebuild all indexes."));
+        }
+        if (args.GetBoolArg("-stakeindex", DEFAULT_STAKEINDEX)) {
+            return InitError(_("-reindex-chainstate option is not compatible with -stakeindex. Please temporarily disable stakeindex while using -reindex-chainstate, or replace -reindex-chainstate with -reindex to fully rebuild all indexes."));
+        }
+        if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+            return InitError(_("-reindex-chainstate option is not compatible with -addressindex. Please temporarily disable addressindex while using -reindex-chainstate, or replace -reindex-chainstate with -reindex to fully rebuild all indexes."));
+        }
         if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
             return InitError(_("-reindex-chainstate option is not compatible with -txindex. Please temporarily disable txindex while using -reindex-chainstate, or replace -reindex-chainstate with -reindex to fully rebuild all indexes."));
         }
@@ -1132,11 +1322,14 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
 
     ValidationCacheSizes validation_cache_sizes{};
     ApplyArgsManOptions(args, validation_cache_sizes);
-    if (!InitSignatureCache(validation_cache_sizes.signature_cache_bytes)
-        || !InitScriptExecutionCache(validation_cache_sizes.script_execution_cache_bytes))
+    if (!InitSignatureCache(validation_cache_sizes.signature_cache_bytes, validation_cache_sizes.signature_cache_max_bytes)
+        || !InitScriptExecutionCache(validation_cache_sizes.script_execution_cache_bytes, validation_cache_sizes.script_execution_cache_max_bytes))
     {
         return InitError(strprintf(_("Unable to allocate memory for -maxsigcachesize: '%s' MiB"), args.GetIntArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_BYTES >> 20)));
     }
+    if (!InitStakeKernelCache(DEFAULT_STAKE_KERNEL_CACHE_BYTES)) {
+        return InitError(_("Unable to allocate memory for the stake kernel cache"));
+    }
 
     int script_threads = args.GetIntArg("-par", DEFAULT_SCRIPTCHECK_THREADS);
     if (script_threads <= 0) {
@@ -1159,13 +1352,17 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     assert(!node.scheduler);
     node.scheduler = std::make_unique<CScheduler>();
 
-    // Start the lightweight task scheduler thread
+    // Start the lightweight task scheduler threads
     node.scheduler->m_service_thread = std::thread(util::TraceThread, "scheduler", [&] { node.scheduler->serviceQueue(); });
+    const int scheduler_threads{std::max<int>(1, args.GetIntArg("-schedulerthreads", DEFAULT_SCHEDULER_THREADS))};
+    for (int i = 1; i < scheduler_threads; ++i) {
+        node.scheduler->m_extra_service_threads.emplace_back(util::TraceThread, strprintf("scheduler.%i", i), [&] { node.scheduler->serviceQueue(); });
+    }
 
     // Gather some entropy once per minute.
     node.scheduler->scheduleEvery([]{
         RandAddPeriodic();
-    }, std::chrono::minutes{1});
+    }, std::chrono::minutes{1}, "randaddperiodic");
 
     GetMainSignals().RegisterBackgroundSignalScheduler(*node.scheduler);
 
@@ -1215,6 +1412,9 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     fDiscover = args.GetBoolArg("-discover", true);
     const bool ignores_incoming_txs{args.GetBoolArg("-blocksonly", DEFAULT_BLOCKSONLY)};
 
+    // Steps run alongside the others, waited for where the first step needing them begins
+    node::StartupSteps startup;
+
     {
 
         // Read asmap file if configured
@@ -1243,20 +1443,18 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         assert(!node.netgroupman);
         node.netgroupman = std::make_unique<NetGroupManager>(std::move(asmap));
 
-        // Initialize addrman
+        // Initialize addrman, while the block chain loads
         assert(!node.addrman);
-        uiInterface.InitMessage(_("Loading P2P addresses…").translated);
-        if (const auto error{LoadAddrman(*node.netgroupman, args, node.addrman)}) {
-            return InitError(*error);
-        }
+        startup.Start("addrman", [&node, &args] {
+            if (const auto error{LoadAddrman(*node.netgroupman, args, node.addrman)}) {
+                return InitError(*error);
+            }
+            return true;
+        });
     }
 
     assert(!node.banman);
     node.banman = std::make_unique<BanMan>(args.GetDataDirNet() / "banlist", &uiInterface, args.GetIntArg("-bantime", DEFAULT_MISBEHAVING_BANTIME));
-    assert(!node.connman);
-    node.connman = std::make_unique<CConnman>(GetRand<uint64_t>(),
-                                              GetRand<uint64_t>(),
-                                              *node.addrman, *node.netgroupman, args.GetBoolArg("-networkactive", true));
 
     assert(!node.fee_estimator);
     // Don't initialize fee estimation with old data if we don't relay transactions,
@@ -1280,6 +1478,7 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     for (const std::string port_option : {
         "-i2psam",
         "-onion",
+        "-metricsbind",
         "-proxy",
         "-rpcbind",
         "-torcontrol",
@@ -1289,6 +1488,10 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         "-zmqpubrawblock",
         "-zmqpubrawtx",
         "-zmqpubsequence",
+        "-zmqpubjob",
+        "-zmqpubassetconfirmed",
+        "-zmqpubauthlist",
+        "-zmqpubstake",
     }) {
         for (const std::string& socket_addr : args.GetArgs(port_option)) {
             std::string host_out;
@@ -1433,13 +1636,16 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     g_zmq_notification_interface = CZMQNotificationInterface::Create();
 
     if (g_zmq_notification_interface) {
-        RegisterValidationInterface(g_zmq_notification_interface);
+        RegisterValidationInterface(g_zmq_notification_interface, /*lane=*/"zmq");
     }
 #endif
 
     // ********************************************************* Step 7: load block chain
 
     fReindex = args.GetBoolArg("-reindex", false);
+    node::g_check_stored_pow = args.GetBoolArg("-checkstoredpow", DEFAULT_CHECK_STORED_POW);
+    node::g_block_cache.SetMaxBytes(std::max<int64_t>(0, args.GetIntArg("-blockcachesize", node::DEFAULT_BLOCK_CACHE_SIZE)) << 20);
+    node::g_block_file_maps.SetMaxFiles(std::max<int64_t>(0, args.GetIntArg("-blockfilemaps", node::DEFAULT_BLOCK_FILE_MAPS)));
     bool fReindexChainState = args.GetBoolArg("-reindex-chainstate", false);
     ChainstateManager::Options chainman_opts{
         .chainparams = chainparams,
@@ -1459,6 +1665,9 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1f MiB for transaction index database\n", cache_sizes.tx_index * (1.0 / 1024 / 1024));
     }
+    if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+        LogPrintf("* Using %.1f MiB for address index database\n", cache_sizes.address_index * (1.0 / 1024 / 1024));
+    }
     for (BlockFilterType filter_type : g_enabled_filter_types) {
         LogPrintf("* Using %.1f MiB for %s block filter index database\n",
                   cache_sizes.filter_index * (1.0 / 1024 / 1024), BlockFilterTypeName(filter_type));
@@ -1481,6 +1690,9 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     if (mempool_opts.max_size_bytes < 0 || mempool_opts.max_size_bytes < descendant_limit_bytes) {
         return InitError(strprintf(_("-maxmempool must be at least %d MB"), std::ceil(descendant_limit_bytes / 1'000'000.0)));
     }
+    if (mempool_opts.max_storage_size_bytes < 0) {
+        return InitError(_("-maxstoragemempool must not be negative"));
+    }
     LogPrintf("* Using %.1f MiB for in-memory UTXO set (plus up to %.1f MiB of unused mempool space)\n", cache_sizes.coins * (1.0 / 1024 / 1024), mempool_opts.max_size_bytes * (1.0 / 1024 / 1024));
 
     for (bool fLoaded = false; !fLoaded && !ShutdownRequested();) {
@@ -1557,25 +1769,52 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
 
     ChainstateManager& chainman = *Assert(node.chainman);
 
+    if (!startup.Wait("addrman")) {
+        return false;
+    }
+    assert(!node.connman);
+    node.connman = std::make_unique<CConnman>(GetRand<uint64_t>(),
+                                              GetRand<uint64_t>(),
+                                              *node.addrman, *node.netgroupman, args.GetBoolArg("-networkactive", true));
+
     assert(!node.peerman);
     node.peerman = PeerManager::make(*node.connman, *node.addrman, node.banman.get(),
                                      chainman, *node.mempool, ignores_incoming_txs);
     RegisterValidationInterface(node.peerman.get());
 
+    if (args.GetBoolArg("-storagepeerfetch", DEFAULT_STORAGEPEERFETCH)) {
+        PeerManager& peerman{*node.peerman};
+        g_asset_chunk_fetcher = std::make_unique<AssetChunkFetcher>(
+            [&peerman] { return peerman.GetStoragePeers(); },
+            [&peerman](NodeId peer, const AssetChunksRequest& request) { return peerman.RequestAssetChunks(peer, request); });
+    }
+
     // ********************************************************* Step 8: start indexers
+    // Indexes catching up read each block once between them
+    const auto index_sync_blocks{std::make_shared<IndexSyncBlocks>()};
     if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         if (const auto error{WITH_LOCK(cs_main, return CheckLegacyTxindex(*Assert(chainman.m_blockman.m_block_tree_db)))}) {
             return InitError(*error);
         }
 
         g_txindex = std::make_unique<TxIndex>(interfaces::MakeChain(node), cache_sizes.tx_index, false, fReindex);
+        g_txindex->SetSyncBlocks(index_sync_blocks);
         if (!g_txindex->Start()) {
             return false;
         }
     }
 
+    if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+        g_address_index = std::make_unique<AddressIndex>(interfaces::MakeChain(node), cache_sizes.address_index, false, fReindex);
+        g_address_index->SetSyncBlocks(index_sync_blocks);
+        if (!g_address_index->Start()) {
+            return false;
+        }
+    }
+
     for (const auto& filter_type : g_enabled_filter_types) {
         InitBlockFilterIndex([&]{ return interfaces::MakeChain(node); }, filter_type, cache_sizes.filter_index, false, fReindex);
+        GetBlockFilterIndex(filter_type)->SetSyncBlocks(index_sync_blocks);
         if (!GetBlockFilterIndex(filter_type)->Start()) {
             return false;
         }
@@ -1583,18 +1822,41 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
 
     if (args.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX)) {
         g_coin_stats_index = std::make_unique<CoinStatsIndex>(interfaces::MakeChain(node), /*cache_size=*/0, false, fReindex);
+        g_coin_stats_index->SetSyncBlocks(index_sync_blocks);
         if (!g_coin_stats_index->Start()) {
             return false;
         }
     }
 
-    // ********************************************************* Step 9: load wallet
-    for (const auto& client : node.chain_clients) {
-        if (!client->load()) {
+    if (args.GetBoolArg("-stakeindex", DEFAULT_STAKEINDEX)) {
+        g_stake_index = std::make_unique<StakeIndex>(interfaces::MakeChain(node), /*cache_size=*/0, false, fReindex);
+        g_stake_index->SetSyncBlocks(index_sync_blocks);
+        if (!g_stake_index->Start()) {
+            return false;
+        }
+    }
+
+    if (args.GetBoolArg("-storageindex", DEFAULT_STORAGEINDEX)) {
+        // A pruning node keeps the payloads of stored assets, so they stay fetchable
+        g_storage_index = std::make_unique<StorageIndex>(interfaces::MakeChain(node), /*cache_size=*/0, false, fReindex,
+                                                         /*keep_payloads=*/chainman.m_blockman.IsPruneMode());
+        g_storage_index->SetSyncBlocks(index_sync_blocks);
+        if (!g_storage_index->Start()) {
             return false;
         }
     }
 
+    // ********************************************************* Step 9: load wallet
+    // Wallets load while the authList is read and the node starts, staking waits for them
+    startup.Start("wallets", [&node] {
+        for (const auto& client : node.chain_clients) {
+            if (!client->load()) {
+                return false;
+            }
+        }
+        return true;
+    });
+
     // ********************************************************* Step 10: data directory maintenance
 
     LogPrintf("Setting NODE_NETWORK on non-prune mode\n");
@@ -1616,6 +1878,16 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
     // On startup setup auth user parameters
     build_auth_list(chainparams.GetConsensus());
 
+    // Load authList from disk where possible, rather than rescanning the chain. It follows
+    // the blocks connected meanwhile, so it is read alongside the block import
+    g_auth_list_sync = std::make_unique<AuthListSync>(args.GetDataDirNet() / "authlist.dat");
+    startup.Start("authlist", [&chainman] {
+        if (!g_auth_list_sync->Start(chainman)) {
+            return InitError(strprintf(_("Error while parsing authdata chunks")));
+        }
+        return true;
+    });
+
     // On first startup, warn on low block storage space
     if (!fReindex && !fReindexChainState && chain_active_height <= 1) {
         uint64_t assumed_chain_bytes{chainparams.AssumedBlockchainSize() * 1024 * 1024 * 1024};
@@ -1839,21 +2111,69 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
 
     connOptions.m_i2p_accept_incoming = args.GetBoolArg("-i2pacceptincoming", DEFAULT_I2P_ACCEPT_INCOMING);
 
+    const std::string socket_events{args.GetArg("-socketevents", "poll")};
+    const std::optional<SocketEventsMode> socket_events_mode{SocketEventsModeFromString(socket_events)};
+    if (!socket_events_mode) {
+        return InitError(strprintf(_("Unknown -socketevents mode '%s'"), socket_events));
+    }
+    if (!SocketEventsModeAvailable(*socket_events_mode)) {
+        return InitError(strprintf(_("-socketevents mode '%s' is not available on this platform"), socket_events));
+    }
+    connOptions.m_socket_events_mode = *socket_events_mode;
+
     if (!node.connman->Start(*node.scheduler, connOptions)) {
         return false;
     }
 
     // ********************************************************* Step 12.3: read authdata
 
-LogPrint (BCLog::ALL, "MAX_PACKAGE_COUNT %d\n", MAX_PACKAGE_COUNT);
-LogPrint (BCLog::ALL, "MAX_PACKAGE_SIZE %d\n", MAX_PACKAGE_SIZE);
-LogPrint (BCLog::ALL, "MAX_PROTOCOL_MESSAGE_LENGTH %d\n", MAX_PROTOCOL_MESSAGE_LENGTH);
+LogPrint (BCLog::NET, "MAX_PACKAGE_COUNT %d\n", MAX_PACKAGE_COUNT);
+LogPrint (BCLog::NET, "MAX_PACKAGE_SIZE %d\n", MAX_PACKAGE_SIZE);
+LogPrint (BCLog::NET, "MAX_PROTOCOL_MESSAGE_LENGTH %d\n", MAX_PROTOCOL_MESSAGE_LENGTH);
+
+    if (!startup.Wait("authlist")) {
+        return false;
+    }
+
+    const int64_t storage_cache_size{args.GetIntArg("-storagecachesize", DEFAULT_STORAGE_CACHE_SIZE)};
+    if (storage_cache_size > 0) {
+        g_storage_cache = std::make_unique<StorageCache>(args.GetDataDirNet() / "storagecache", uint64_t(storage_cache_size) << 20);
+        if (!g_storage_cache->Start(chainman)) {
+            return InitError(strprintf(_("Unable to open storage cache directory")));
+        }
+    }
+
+    if (args.GetBoolArg("-blocktemplatecache", DEFAULT_BLOCK_TEMPLATE_CACHE)) {
+        node::BlockAssembler::Options assembler_options;
+        ApplyArgsManOptions(args, assembler_options);
+        node::g_block_template_cache = std::make_unique<BlockTemplateCache>(chainman.ActiveChainstate(), *node.mempool, assembler_options);
+        node::g_block_template_cache->Start();
+    }
+
+    node::CacheLimits cache_targets;
+    cache_targets.coins_cache = cache_sizes.coins;
+    cache_targets.max_mempool = mempool_opts.max_size_bytes;
+    cache_targets.max_storage_mempool = mempool_opts.max_storage_size_bytes;
+    cache_targets.block_cache = std::max<int64_t>(0, args.GetIntArg("-blockcachesize", node::DEFAULT_BLOCK_CACHE_SIZE)) << 20;
+    node::g_memory_budget = std::make_unique<node::MemoryBudget>(chainman, *node.mempool, cache_targets,
+                                                                 std::max<int64_t>(0, args.GetIntArg("-memorybudget", node::DEFAULT_MEMORY_BUDGET)) << 20,
+                                                                 descendant_limit_bytes);
+
+    // The job threads are shared by the storage worker, chain scans and the staking manager
+    node::g_job_queue = std::make_unique<node::JobQueue>();
+    node::g_job_queue->Start(args.GetIntArg("-jobthreads", args.GetIntArg("-storageworkers", node::DEFAULT_JOB_THREADS)));
 
-    if (!scan_blocks_for_authdata(chainman)) {
-        return InitError(strprintf(_("Error while parsing authdata chunks")));
+    // Entries of the txindex written before its compact format move to it in the background
+    if (g_txindex && g_txindex->HasLegacyEntries()) {
+        node::g_job_queue->Submit("txindexmigrate", []() -> UniValue {
+            return g_txindex->MigrateLegacyEntries();
+        }, /*id=*/"", /*group=*/"txindexmigrate", node::JobPriority::LOW, /*owner=*/"", /*large=*/true);
     }
 
     // ********************************************************* Step 12.5: start staking
+    if (!startup.Wait("wallets")) {
+        return false;
+    }
 #ifdef ENABLE_WALLET
     size_t num_wallets = 0;
     if (node.wallet_loader && node.wallet_loader->context()) {
@@ -1865,16 +2185,32 @@ LogPrint (BCLog::ALL, "MAX_PROTOCOL_MESSAGE_LENGTH %d\n", MAX_PROTOCOL_MESSAGE_L
         if (disablestaking) {
             LogPrintf("-disablestaking is enabled\n");
         } else {
-            stakeman = std::thread(&stakeman_handler, std::ref(*node.wallet_loader->context()), std::ref(chainman), node.connman.get());
-            stakeman.detach();
+            stakeman_init(*node.wallet_loader->context(), chainman, node.connman.get());
         }
         set_wallet_context(node.wallet_loader->context());
         set_chainman_context(chainman);
-        chunkman = std::thread(&thread_storage_worker);
-        chunkman.detach();
     }
 #endif
 
+    const int64_t storage_funding_outputs{args.GetIntArg("-storagefundingoutputs", DEFAULT_STORAGE_FUNDING_OUTPUTS)};
+    if (storage_funding_outputs > 0) {
+        CAmount storage_funding_size{DEFAULT_STORAGE_FUNDING_SIZE};
+        if (args.IsArgSet("-storagefundingsize")) {
+            const std::optional<CAmount> parsed{ParseMoney(args.GetArg("-storagefundingsize", ""))};
+            if (!parsed || *parsed < COIN) {
+                return InitError(AmountErrMsg("storagefundingsize", args.GetArg("-storagefundingsize", "")));
+            }
+            storage_funding_size = *parsed;
+        }
+        g_storage_funding = std::make_unique<StorageFunding>(int(std::min<int64_t>(storage_funding_outputs, std::numeric_limits<int>::max())), storage_funding_size);
+        refill_storage_funding();
+    }
+
+    // Puts a shutdown or crash cut short, resumed from the batches they committed
+    g_storage_uploads = std::make_unique<StorageUploads>(args.GetDataDirNet() / "storageuploads.dat");
+    g_storage_uploads->Load();
+    resume_storage_uploads();
+
     // ********************************************************* Step 13: finished
 
     // At this point, the RPC is "started", but still in warmup, which means it
@@ -1897,10 +2233,22 @@ LogPrint (BCLog::ALL, "MAX_PROTOCOL_MESSAGE_LENGTH %d\n", MAX_PROTOCOL_MESSAGE_L
     BanMan* banman = node.banman.get();
     node.scheduler->scheduleEvery([banman]{
         banman->DumpBanlist();
-    }, DUMP_BANS_INTERVAL);
+    }, DUMP_BANS_INTERVAL, "dumpbanlist");
 
     if (node.peerman) node.peerman->StartScheduledTasks(*node.scheduler);
 
+    if (node::g_block_template_cache) {
+        node.scheduler->scheduleEvery([]{
+            node::g_block_template_cache->RebuildIfStale();
+        }, node::BLOCK_TEMPLATE_REBUILD_INTERVAL, "blocktemplate");
+    }
+
+    if (args.GetIntArg("-memorybudget", node::DEFAULT_MEMORY_BUDGET) > 0) {
+        node.scheduler->scheduleEvery([]{
+            node::g_memory_budget->Check();
+        }, node::MEMORY_BUDGET_INTERVAL, "memorybudget");
+    }
+
 #if HAVE_SYSTEM
     StartupNotify(args);
 #endif
@@ -16,6 +16,7 @@
 
 #include <functional>
 #include <memory>
+#include <optional>
 #include <stddef.h>
 #include <stdint.h>
 #include <string>
@@ -34,6 +35,7 @@ enum class TransactionError;
 struct CNodeStateStats;
 struct bilingual_str;
 namespace node {
+struct JobInfo;
 struct NodeContext;
 } // namespace node
 namespace wallet {
@@ -207,6 +209,19 @@ public:
     //! Broadcast transaction.
     virtual TransactionError broadcastTransaction(CTransactionRef tx, CAmount max_tx_fee, std::string& err_string) = 0;
 
+    //! Queue a job listing a page of count stored assets of the tenant authenticated, from
+    //! cursor, or from the newest if empty. Returns the job id, or empty on failure.
+    virtual std::string listStorageAssets(int count, const std::string& cursor) = 0;
+
+    //! Queue a job fetching a stored asset into the directory path. Returns the job id, or empty on failure.
+    virtual std::string fetchStorageAsset(const std::string& uuid, const std::string& path) = 0;
+
+    //! Get a job queued, as last seen by the job queue.
+    virtual std::optional<node::JobInfo> getJob(const std::string& id) = 0;
+
+    //! Cancel a job not finished yet.
+    virtual bool cancelJob(const std::string& id) = 0;
+
     //! Get wallet loader.
     virtual WalletLoader& walletLoader() = 0;
 
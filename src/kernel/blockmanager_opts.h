@@ -13,6 +13,8 @@ namespace kernel {
  */
 struct BlockManagerOpts {
     uint64_t prune_target{0};
+    //! Write new blocks compressed when that makes them smaller
+    bool compress_blocks{false};
 };
 
 } // namespace kernel
@@ -205,7 +205,8 @@ public:
         };
 
         m_assumeutxo_data = MapAssumeutxo{
-         // TODO to be specified in a future patch.
+            // Entries are added once a snapshot has been produced with dumptxoutset and
+            // its UTXO hash and stake modifier reproduced by independent nodes.
         };
 
         chainTxData = ChainTxData{
@@ -546,12 +547,24 @@ public:
         consensus.nMinimumChainWork = uint256{};
         consensus.defaultAssumeValid = uint256{};
 
+        // Lynx specific parameters, the hard forks active from the start as on testnet
+        consensus.HardForkHeight = 1;
+        consensus.HardFork2Height = 2;
+        consensus.HardFork3Height = 3;
+        consensus.HardForkRule2DifficultyPrevBlockCount = 10;
+        consensus.HardForkRule2LowerLimitMinBalance = 0.001*COIN;
+        consensus.HardForkRule2UpperLimitMinBalance = 100000000*COIN;
+        consensus.PowTargetSpacingV1 = 30;
+        consensus.PowTargetSpacingV2 = 60;
+        consensus.PowTargetSpacingV3 = 30;
+
         pchMessageStart[0] = 0xfa;
         pchMessageStart[1] = 0xbf;
         pchMessageStart[2] = 0xb5;
         pchMessageStart[3] = 0xda;
         nDefaultPort = 18444;
         nPruneAfterHeight = opts.fastprune ? 100 : 1000;
+        if (opts.init_auth_user) consensus.initAuthUser = *opts.init_auth_user;
         m_assumed_blockchain_size = 0;
         m_assumed_chain_state_size = 0;
 
@@ -598,11 +611,13 @@ public:
         m_assumeutxo_data = MapAssumeutxo{
             {
                 110,
-                {AssumeutxoHash{uint256S("0x1ebbf5850204c0bdb15bf030f47c7fe91d45c44c712697e4509ba67adb01c618")}, 110},
+                {AssumeutxoHash{uint256S("0x1ebbf5850204c0bdb15bf030f47c7fe91d45c44c712697e4509ba67adb01c618")}, 110,
+                 uint256S("0xcfe2e7741b422dbbd889e6ae43a192358d506f8806dab2d677584b0d85aa9d6c")},
             },
             {
                 200,
-                {AssumeutxoHash{uint256S("0x51c8d11d8b5c1de51543c579736e786aa2736206d1e11e627568029ce092cf62")}, 200},
+                {AssumeutxoHash{uint256S("0x51c8d11d8b5c1de51543c579736e786aa2736206d1e11e627568029ce092cf62")}, 200,
+                 uint256S("0x032a11dc35fe2e7096aa19070645ae41dd5fc47f6447e08f88467d67b6a00741")},
             },
         };
 
@@ -52,6 +52,12 @@ struct AssumeutxoData {
     //! We need to hardcode the value here because this is computed cumulatively using block data,
     //! which we do not necessarily have at the time of snapshot load.
     const unsigned int nChainTx;
+
+    //! Used to populate the nStakeModifier of the snapshot base block.
+    //!
+    //! Like nChainTx it is computed cumulatively from the chain, and staking on top of the
+    //! snapshot needs it before the background chainstate has caught up.
+    const uint256 stake_modifier;
 };
 
 using MapAssumeutxo = std::map<int, const AssumeutxoData>;
@@ -153,6 +159,8 @@ public:
         std::unordered_map<Consensus::DeploymentPos, VersionBitsParameters> version_bits_parameters{};
         std::unordered_map<Consensus::BuriedDeployment, int> activation_heights{};
         bool fastprune{false};
+        //! Replaces the initial user managing the authList
+        std::optional<uint160> init_auth_user{};
     };
 
     static std::unique_ptr<const CChainParams> RegTest(const RegTestOptions& options);
@@ -40,6 +40,8 @@ struct ChainstateManagerOpts {
     //! If the tip is older than this, the node is considered to be in initial block download.
     std::chrono::seconds max_tip_age{DEFAULT_MAX_TIP_AGE};
     DBOptions block_tree_db{};
+    //! Whether block index records are written in the compact form, which older versions can't read
+    bool compact_block_index{DEFAULT_BLOCK_INDEX_COMPACT};
     DBOptions coins_db{};
     CoinsViewOptions coins_view{};
 };
@@ -23,16 +23,24 @@
 #include <validation.h>
 #include <version.h>
 
+#include <algorithm>
 #include <cassert>
+#include <deque>
+#include <future>
 #include <iosfwd>
 #include <iterator>
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 namespace kernel {
 
+//! Ranges of the coins per worker, see ComputeUTXOStats()
+static constexpr size_t UTXO_STATS_RANGES_PER_WORKER{4};
+
 CCoinsStats::CCoinsStats(int block_height, const uint256& block_hash)
     : nHeight(block_height),
       hashBlock(block_hash) {}
@@ -69,7 +77,8 @@ DataStream TxOutSer(const COutPoint& outpoint, const Coin& coin)
 //! It is also possible, though very unlikely, that a change in this
 //! construction could cause a previously invalid (and potentially malicious)
 //! UTXO snapshot to be considered valid.
-static void ApplyHash(HashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+template <typename Stream>
+static void ApplyHash(Stream& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
     for (auto it = outputs.begin(); it != outputs.end(); ++it) {
         if (it == outputs.begin()) {
@@ -111,22 +120,17 @@ static void ApplyStats(CCoinsStats& stats, const uint256& hash, const std::map<u
     }
 }
 
-//! Calculate statistics about the unspent transaction output set
+//! Apply the coins of a cursor to the statistics and the hash
 template <typename T>
-static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point)
+static bool ApplyCursor(CCoinsViewCursor& cursor, CCoinsStats& stats, T& hash_obj, const std::function<void()>& interruption_point)
 {
-    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
-    assert(pcursor);
-
-    PrepareHash(hash_obj, stats);
-
     uint256 prevkey;
     std::map<uint32_t, Coin> outputs;
-    while (pcursor->Valid()) {
+    while (cursor.Valid()) {
         interruption_point();
         COutPoint key;
         Coin coin;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
+        if (cursor.GetKey(key) && cursor.GetValue(coin)) {
             if (!outputs.empty() && key.hash != prevkey) {
                 ApplyStats(stats, prevkey, outputs);
                 ApplyHash(hash_obj, prevkey, outputs);
@@ -138,12 +142,77 @@ static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, c
         } else {
             return error("%s: unable to read value", __func__);
         }
-        pcursor->Next();
+        cursor.Next();
     }
     if (!outputs.empty()) {
         ApplyStats(stats, prevkey, outputs);
         ApplyHash(hash_obj, prevkey, outputs);
     }
+    return true;
+}
+
+//! What a range of the coins is hashed into, to be combined in the hash of the whole set.
+//! The serialized hash is a stream, so the coins of a range are serialized to be hashed in order.
+static DataStream RangeHash(const HashWriter&) { return DataStream{}; }
+static MuHash3072 RangeHash(const MuHash3072&) { return MuHash3072{}; }
+static std::nullptr_t RangeHash(std::nullptr_t) { return nullptr; }
+
+static void CombineHash(HashWriter& ss, const DataStream& range) { ss.write(MakeByteSpan(range)); }
+static void CombineHash(MuHash3072& muhash, const MuHash3072& range) { muhash *= range; }
+static void CombineHash(std::nullptr_t, std::nullptr_t) {}
+
+static void CombineStats(CCoinsStats& stats, const CCoinsStats& range)
+{
+    stats.nTransactions += range.nTransactions;
+    stats.nTransactionOutputs += range.nTransactionOutputs;
+    stats.nBogoSize += range.nBogoSize;
+    stats.coins_count += range.coins_count;
+    if (stats.total_amount.has_value()) {
+        stats.total_amount = range.total_amount.has_value() ? CheckedAdd(*stats.total_amount, *range.total_amount) : std::nullopt;
+    }
+}
+
+//! Calculate statistics about the unspent transaction output set
+template <typename T>
+static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, const std::function<void()>& interruption_point, size_t workers)
+{
+    PrepareHash(hash_obj, stats);
+
+    // Split the coins in more ranges than workers, so the ranges read ahead of
+    // the one being combined stay small
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    if (workers > 1) cursors = view->RangeCursors(workers * UTXO_STATS_RANGES_PER_WORKER);
+    if (cursors.empty()) {
+        std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
+        assert(pcursor);
+        if (!ApplyCursor(*pcursor, stats, hash_obj, interruption_point)) return false;
+    } else {
+        using RangeResult = std::optional<std::pair<CCoinsStats, decltype(RangeHash(hash_obj))>>;
+        const auto apply_range{[&](CCoinsViewCursor* cursor) -> RangeResult {
+            std::pair<CCoinsStats, decltype(RangeHash(hash_obj))> range{CCoinsStats{}, RangeHash(hash_obj)};
+            if (!ApplyCursor(*cursor, range.first, range.second, interruption_point)) return std::nullopt;
+            return range;
+        }};
+        // At most workers ranges are read at once, and combined in order as they finish
+        std::deque<std::future<RangeResult>> pending;
+        size_t next{0};
+        bool success{true};
+        while (next < cursors.size() || !pending.empty()) {
+            while (next < cursors.size() && pending.size() < workers) {
+                pending.push_back(std::async(std::launch::async, apply_range, cursors[next++].get()));
+            }
+            const RangeResult range{pending.front().get()};
+            pending.pop_front();
+            if (!range) {
+                success = false;
+                next = cursors.size();
+                continue;
+            }
+            CombineStats(stats, range->first);
+            CombineHash(hash_obj, range->second);
+        }
+        if (!success) return false;
+    }
 
     FinalizeHash(hash_obj, stats);
 
@@ -152,8 +221,9 @@ static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj, c
     return true;
 }
 
-std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point)
+std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point, size_t workers)
 {
+    if (workers == 0) workers = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, MAX_UTXO_STATS_WORKERS);
     CBlockIndex* pindex = WITH_LOCK(::cs_main, return blockman.LookupBlockIndex(view->GetBestBlock()));
     CCoinsStats stats{Assert(pindex)->nHeight, pindex->GetBlockHash()};
 
@@ -161,14 +231,14 @@ std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsV
         switch (hash_type) {
         case(CoinStatsHashType::HASH_SERIALIZED): {
             HashWriter ss{};
-            return ComputeUTXOStats(view, stats, ss, interruption_point);
+            return ComputeUTXOStats(view, stats, ss, interruption_point, workers);
         }
         case(CoinStatsHashType::MUHASH): {
             MuHash3072 muhash;
-            return ComputeUTXOStats(view, stats, muhash, interruption_point);
+            return ComputeUTXOStats(view, stats, muhash, interruption_point, workers);
         }
         case(CoinStatsHashType::NONE): {
-            return ComputeUTXOStats(view, stats, nullptr, interruption_point);
+            return ComputeUTXOStats(view, stats, nullptr, interruption_point, workers);
         }
         } // no default case, so the compiler can warn about missing cases
         assert(false);
@@ -9,6 +9,7 @@
 #include <streams.h>
 #include <uint256.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <optional>
@@ -22,6 +23,9 @@ class BlockManager;
 } // namespace node
 
 namespace kernel {
+//! Most threads the coins are read and hashed on, by default one per core
+static constexpr size_t MAX_UTXO_STATS_WORKERS{16};
+
 enum class CoinStatsHashType {
     HASH_SERIALIZED,
     MUHASH,
@@ -74,7 +78,12 @@ uint64_t GetBogoSize(const CScript& script_pub_key);
 
 DataStream TxOutSer(const COutPoint& outpoint, const Coin& coin);
 
-std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point = {});
+/**
+ * Compute the statistics and hash of the coins of view. Views that can split
+ * their coins in ranges are read on workers threads, 0 for one per core, and
+ * the partial statistics and hashes of the ranges combined in order.
+ */
+std::optional<CCoinsStats> ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView* view, node::BlockManager& blockman, const std::function<void()>& interruption_point = {}, size_t workers = 0);
 } // namespace kernel
 
 #endif // BITCOIN_KERNEL_COINSTATS_H
@@ -6,7 +6,9 @@
 
 #include <policy/policy.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 
 namespace kernel {
 /**
@@ -24,6 +26,10 @@ struct MemPoolLimits {
     int64_t descendant_count{DEFAULT_DESCENDANT_LIMIT};
     //! The maximum allowed size in virtual bytes of an entry and its descendants within a package.
     int64_t descendant_size_vbytes{DEFAULT_DESCENDANT_SIZE_LIMIT_KVB * 1'000};
+    //! The least the ancestor and descendant count limits are raised to for storage transactions, see IsStorageTx().
+    int64_t storage_chain_count{DEFAULT_STORAGE_CHAIN_LIMIT};
+    //! The least the ancestor and descendant size limits are raised to for storage transactions.
+    int64_t storage_chain_size_vbytes{DEFAULT_STORAGE_CHAIN_SIZE_LIMIT_KVB * 1'000};
 
     /**
      * @return MemPoolLimits with all the limits set to the maximum
@@ -31,7 +37,21 @@ struct MemPoolLimits {
     static constexpr MemPoolLimits NoLimits()
     {
         int64_t no_limit{std::numeric_limits<int64_t>::max()};
-        return {no_limit, no_limit, no_limit, no_limit};
+        return {no_limit, no_limit, no_limit, no_limit, no_limit, no_limit};
+    }
+
+    /**
+     * @return these limits as they apply to storage transactions, which a
+     * large upload chains beyond the limits for other transactions
+     */
+    constexpr MemPoolLimits ForStorage() const
+    {
+        MemPoolLimits limits{*this};
+        limits.ancestor_count = std::max(ancestor_count, storage_chain_count);
+        limits.ancestor_size_vbytes = std::max(ancestor_size_vbytes, storage_chain_size_vbytes);
+        limits.descendant_count = std::max(descendant_count, storage_chain_count);
+        limits.descendant_size_vbytes = std::max(descendant_size_vbytes, storage_chain_size_vbytes);
+        return limits;
     }
 };
 } // namespace kernel
@@ -36,6 +36,8 @@ using fsbridge::FopenFn;
 namespace kernel {
 
 static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+//! Transactions read and script checked together while loading
+static constexpr size_t MEMPOOL_LOAD_BATCH_SIZE{1000};
 
 bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active_chainstate, FopenFn mockable_fopen_function)
 {
@@ -64,19 +66,34 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
         uint64_t num;
         file >> num;
         while (num) {
-            --num;
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta) {
-                pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+            // Read a batch, verify its scripts in parallel, then accept it one by one
+            std::vector<std::pair<CTransactionRef, int64_t>> batch;
+            while (num && batch.size() < MEMPOOL_LOAD_BATCH_SIZE) {
+                --num;
+                CTransactionRef tx;
+                int64_t nTime;
+                int64_t nFeeDelta;
+                file >> tx;
+                file >> nTime;
+                file >> nFeeDelta;
+
+                CAmount amountdelta = nFeeDelta;
+                if (amountdelta) {
+                    pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+                }
+                if (nTime > TicksSinceEpoch<std::chrono::seconds>(now - pool.m_expiry)) {
+                    batch.emplace_back(std::move(tx), nTime);
+                } else {
+                    ++expired;
+                }
             }
-            if (nTime > TicksSinceEpoch<std::chrono::seconds>(now - pool.m_expiry)) {
+
+            std::vector<CTransactionRef> txs;
+            txs.reserve(batch.size());
+            for (const auto& [tx, nTime] : batch) txs.push_back(tx);
+            PrecheckTransactionScripts(active_chainstate, pool, txs);
+
+            for (const auto& [tx, nTime] : batch) {
                 LOCK(cs_main);
                 const auto& accepted = AcceptToMemoryPool(active_chainstate, tx, nTime, /*bypass_limits=*/false, /*test_accept=*/false);
                 if (accepted.m_result_type == MempoolAcceptResult::ResultType::VALID) {
@@ -92,8 +109,6 @@ bool LoadMempool(CTxMemPool& pool, const fs::path& load_path, Chainstate& active
                         ++failed;
                     }
                 }
-            } else {
-                ++expired;
             }
             if (ShutdownRequested())
                 return false;
@@ -14,6 +14,9 @@ namespace kernel {
 struct ValidationCacheSizes {
     size_t signature_cache_bytes{DEFAULT_MAX_SIG_CACHE_BYTES / 2};
     size_t script_execution_cache_bytes{DEFAULT_MAX_SIG_CACHE_BYTES / 2};
+    //! Sizes each cache may grow to under eviction pressure, no growth if not above its size
+    size_t signature_cache_max_bytes{0};
+    size_t script_execution_cache_max_bytes{0};
 };
 }
 
@@ -86,6 +86,7 @@ bool BCLog::Logger::StartLogging()
 
 void BCLog::Logger::DisconnectTestLogger()
 {
+    StopAsync();
     StdLockGuard scoped_lock(m_cs);
     m_buffering = true;
     if (m_fileout != nullptr) fclose(m_fileout);
@@ -183,7 +184,8 @@ const CLogCategoryDesc LogCategories[] =
     {BCLog::TXRECONCILIATION, "txreconciliation"},
     {BCLog::SCAN, "scan"},
     {BCLog::POS, "pos"},
-    //{BCLog::DATASTORE, "datastore"},
+    {BCLog::STORAGE, "storage"},
+    {BCLog::AUTH, "auth"},
     {BCLog::ALL, "1"},
     {BCLog::ALL, "all"},
 };
@@ -290,6 +292,10 @@ std::string LogCategoryToStr(BCLog::LogFlags category)
         return "scan";
     case BCLog::LogFlags::POS:
         return "pos";
+    case BCLog::LogFlags::STORAGE:
+        return "storage";
+    case BCLog::LogFlags::AUTH:
+        return "auth";
     case BCLog::LogFlags::ALL:
         return "all";
     }
@@ -393,9 +399,8 @@ namespace BCLog {
     }
 } // namespace BCLog
 
-void BCLog::Logger::LogPrintStr(const std::string& str, const std::string& logging_function, const std::string& source_file, int source_line, BCLog::LogFlags category, BCLog::Level level)
+std::string BCLog::Logger::FormatLogStr(const std::string& str, const std::string& logging_function, const std::string& source_file, int source_line, BCLog::LogFlags category, BCLog::Level level)
 {
-    StdLockGuard scoped_lock(m_cs);
     std::string str_prefixed = LogEscapeMessage(str);
 
     if ((category != LogFlags::NONE || level != Level::None) && m_started_new_line) {
@@ -430,6 +435,31 @@ void BCLog::Logger::LogPrintStr(const std::string& str, const std::string& loggi
     str_prefixed = LogTimestampStr(str_prefixed);
 
     m_started_new_line = !str.empty() && str[str.size()-1] == '\n';
+    return str_prefixed;
+}
+
+void BCLog::Logger::LogPrintStr(const std::string& str, const std::string& logging_function, const std::string& source_file, int source_line, BCLog::LogFlags category, BCLog::Level level)
+{
+    if (m_async) {
+        {
+            std::lock_guard<std::mutex> lock(m_async_mutex);
+            // Checked again, as StopAsync may have run since
+            if (m_async) {
+                std::string str_prefixed = FormatLogStr(str, logging_function, source_file, source_line, category, level);
+                if (m_async_bytes + str_prefixed.size() > LOG_ASYNC_MAX_BYTES) {
+                    ++m_async_dropped;
+                    return;
+                }
+                m_async_bytes += str_prefixed.size();
+                m_async_queue.push_back(std::move(str_prefixed));
+                m_async_cond.notify_one();
+                return;
+            }
+        }
+    }
+
+    StdLockGuard scoped_lock(m_cs);
+    std::string str_prefixed = FormatLogStr(str, logging_function, source_file, source_line, category, level);
 
     if (m_buffering) {
         // buffer if we haven't started logging yet
@@ -437,13 +467,22 @@ void BCLog::Logger::LogPrintStr(const std::string& str, const std::string& loggi
         return;
     }
 
+    WriteLogStrs(Span{&str_prefixed, 1});
+}
+
+void BCLog::Logger::WriteLogStrs(Span<const std::string> strs)
+{
     if (m_print_to_console) {
         // print to console
-        fwrite(str_prefixed.data(), 1, str_prefixed.size(), stdout);
+        for (const std::string& str : strs) {
+            fwrite(str.data(), 1, str.size(), stdout);
+        }
         fflush(stdout);
     }
     for (const auto& cb : m_print_callbacks) {
-        cb(str_prefixed);
+        for (const std::string& str : strs) {
+            cb(str);
+        }
     }
     if (m_print_to_file) {
         assert(m_fileout != nullptr);
@@ -458,7 +497,66 @@ void BCLog::Logger::LogPrintStr(const std::string& str, const std::string& loggi
                 m_fileout = new_fileout;
             }
         }
-        FileWriteStr(str_prefixed, m_fileout);
+        if (strs.size() == 1) {
+            FileWriteStr(strs[0], m_fileout);
+        } else {
+            // One write for all, as the file is unbuffered
+            std::string joined;
+            for (const std::string& str : strs) {
+                joined += str;
+            }
+            FileWriteStr(joined, m_fileout);
+        }
+    }
+}
+
+void BCLog::Logger::StartAsync()
+{
+    std::lock_guard<std::mutex> lock(m_async_mutex);
+    if (m_async) return;
+    m_async_stop = false;
+    m_async_thread = std::thread([this] {
+        util::ThreadRename("logger");
+        AsyncWriter();
+    });
+    m_async = true;
+}
+
+void BCLog::Logger::StopAsync()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_async_mutex);
+        if (!m_async) return;
+        m_async_stop = true;
+    }
+    m_async_cond.notify_one();
+    m_async_thread.join();
+}
+
+void BCLog::Logger::AsyncWriter()
+{
+    std::vector<std::string> strs;
+    while (true) {
+        std::unique_lock<std::mutex> lock(m_async_mutex);
+        m_async_cond.wait(lock, [this] { return m_async_stop || !m_async_queue.empty(); });
+        strs.swap(m_async_queue);
+        m_async_bytes = 0;
+        if (m_async_dropped) {
+            strs.push_back(LogTimestampStr(strprintf("Logging: dropped %d messages, as the log could not keep up\n", m_async_dropped)));
+            m_async_dropped = 0;
+        }
+        if (m_async_stop) {
+            // Written before m_async is cleared, so that the messages LogPrintStr writes from then on come after
+            StdLockGuard scoped_lock(m_cs);
+            WriteLogStrs(strs);
+            m_async = false;
+            return;
+        }
+        lock.unlock();
+
+        StdLockGuard scoped_lock(m_cs);
+        WriteLogStrs(strs);
+        strs.clear();
     }
 }
 
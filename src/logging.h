@@ -6,17 +6,20 @@
 #ifndef BITCOIN_LOGGING_H
 #define BITCOIN_LOGGING_H
 
+#include <span.h>
 #include <threadsafety.h>
 #include <tinyformat.h>
 #include <util/fs.h>
 #include <util/string.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <list>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -25,6 +28,9 @@ static const bool DEFAULT_LOGIPS        = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
 static const bool DEFAULT_LOGSOURCELOCATIONS = false;
+static const bool DEFAULT_LOGASYNC = false;
+//! Most bytes of messages waiting for the -logasync writer thread, beyond which messages are dropped
+static constexpr size_t LOG_ASYNC_MAX_BYTES{16 << 20};
 extern const char * const DEFAULT_DEBUGLOGFILE;
 
 extern bool fLogIPs;
@@ -69,7 +75,8 @@ namespace BCLog {
         TXRECONCILIATION = (1 << 27),
         SCAN        = (1 << 28),
         POS         = (1 << 29),
-        //DATASTORE   = (1 << 30),
+        STORAGE     = (1 << 30),
+        AUTH        = (1U << 31),
         ALL         = ~(uint32_t)0,
     };
     enum class Level {
@@ -113,6 +120,24 @@ namespace BCLog {
         /** Slots that connect to the print signal */
         std::list<std::function<void(const std::string&)>> m_print_callbacks GUARDED_BY(m_cs) {};
 
+        /** Prefix a message with its timestamp, thread, source location and category, as configured. */
+        std::string FormatLogStr(const std::string& str, const std::string& logging_function, const std::string& source_file, int source_line, BCLog::LogFlags category, BCLog::Level level);
+        /** Write formatted messages to the console, the print callbacks and the log file. */
+        void WriteLogStrs(Span<const std::string> strs) EXCLUSIVE_LOCKS_REQUIRED(m_cs);
+
+        //! Set once StartAsync has started m_async_thread, which then writes the messages LogPrintStr queues
+        std::atomic<bool> m_async{false};
+        //! Guards the m_async_ members below. A std::mutex, as m_cs, which the writer thread takes while writing.
+        std::mutex m_async_mutex;
+        std::condition_variable m_async_cond;
+        std::vector<std::string> m_async_queue;
+        size_t m_async_bytes{0};
+        uint64_t m_async_dropped{0};
+        bool m_async_stop{false};
+        std::thread m_async_thread;
+
+        void AsyncWriter();
+
     public:
         bool m_print_to_console = false;
         bool m_print_to_file = false;
@@ -131,6 +156,8 @@ namespace BCLog {
         /** Returns whether logs will be written to any output */
         bool Enabled() const
         {
+            // Without taking m_cs, which the writer thread may hold while it writes
+            if (m_async) return true;
             StdLockGuard scoped_lock(m_cs);
             return m_buffering || m_print_to_console || m_print_to_file || !m_print_callbacks.empty();
         }
@@ -155,6 +182,17 @@ namespace BCLog {
         /** Only for testing */
         void DisconnectTestLogger();
 
+        /**
+         * Have a writer thread write to the console, the log file and the print
+         * callbacks, so that LogPrintStr only formats a message and queues it.
+         * While more than LOG_ASYNC_MAX_BYTES of messages wait, further ones are
+         * dropped, and the writer logs how many. Messages still queued are lost
+         * if the process dies, so StopAsync before exiting. Requires StartLogging.
+         */
+        void StartAsync();
+        /** Write the queued messages and stop the writer thread, going back to writing each message in LogPrintStr. */
+        void StopAsync();
+
         void ShrinkDebugFile();
 
         std::unordered_map<LogFlags, Level> CategoryLevels() const
@@ -265,6 +303,26 @@ static inline void LogPrintf_(const std::string& logging_function, const std::st
         }                                                 \
     } while (0)
 
+// Log conditionally, as LogPrint, but only the first of every `every` messages of this
+// call site, for call sites on hot paths such as per coin or per uuid. Each message
+// logged after the first is followed by a count of those suppressed in between.
+#define LogPrintEvery(category, every, ...)                                                    \
+    do {                                                                                       \
+        if (LogAcceptCategory((category), BCLog::Level::Debug)) {                              \
+            static std::atomic<uint64_t> log_every_count{0};                                   \
+            const uint64_t log_every_n{log_every_count++};                                     \
+            if (log_every_n % (every) == 0) {                                                  \
+                LogPrintLevel_(category, BCLog::Level::None, __VA_ARGS__);                     \
+                if (log_every_n > 0) {                                                         \
+                    LogPrintLevel_(category, BCLog::Level::None, "(%d similar messages suppressed)\n", (every) - 1); \
+                }                                                                              \
+            }                                                                                  \
+        }                                                                                      \
+    } while (0)
+
+//! Default `every` of LogPrintEvery
+static constexpr uint64_t LOG_EVERY_DEFAULT{100};
+
 template <typename... Args>
 bool error(const char* fmt, const Args&... args)
 {
@@ -1,12 +1,16 @@
+#include <lynxconfig.h>
+
 #include <chainparams.h>
 #include <opfile/src/util.h>
 #include <storage/util.h>
 #include <util/system.h>
+#include <util/tune.h>
 
 #include <fstream>
 #include <iostream>
+#include <optional>
 
-void write_lynx_config(std::string& configpath, std::string passwordMain, std::string usernameMain, std::string passwordTest, std::string usernameTest)
+void write_lynx_config(std::string& configpath, std::string passwordMain, std::string usernameMain, std::string passwordTest, std::string usernameTest, const std::optional<HardwareProfile>& hardware)
 {
     std::ofstream config(configpath);
     config << "# Changes to this file will take effect after the Lynx daemon is restarted" << std::endl;
@@ -30,6 +34,14 @@ void write_lynx_config(std::string& configpath, std::string passwordMain, std::s
     config << "# Set value to 1 to disable staking or 0 to enable staking thread on startup" << std::endl;
     config << "disablestaking=0" << std::endl;
     config << "" << std::endl;
+    if (hardware) {
+        config << "# Performance settings tuned for " << HardwareSummary(*hardware) << std::endl;
+        config << "# Run 'lynx-util tune' to tune them again after changing the hardware" << std::endl;
+        for (const auto& [name, value] : TunedSettings(*hardware)) {
+            config << name << "=" << value << std::endl;
+        }
+        config << "" << std::endl;
+    }
     config << "# Mainnet network" << std::endl;
     config << "main.rpcuser=" << usernameMain << std::endl;
     config << "main.rpcpassword=" << passwordMain << std::endl;
@@ -55,6 +67,10 @@ void check_lynx_config(const ArgsManager& args)
         std::string usernameMain = generate_uuid(16);
         std::string passwordTest = generate_uuid(16);
         std::string usernameTest = generate_uuid(16);
-        write_lynx_config(configpath, passwordMain, usernameMain, passwordTest, usernameTest);
+        std::optional<HardwareProfile> hardware;
+        if (args.GetBoolArg("-autotune", DEFAULT_AUTOTUNE)) {
+            hardware = ProbeHardware(args.GetDataDirBase());
+        }
+        write_lynx_config(configpath, passwordMain, usernameMain, passwordTest, usernameTest, hardware);
     }
 }
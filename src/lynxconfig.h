@@ -3,6 +3,9 @@
 
 #include <util/system.h>
 
+//! Write settings tuned for the hardware into the config file created on first run
+static const bool DEFAULT_AUTOTUNE = true;
+
 void check_lynx_config(const ArgsManager& args);
 
 #endif // LYNXCONFIG_H
@@ -15,6 +15,7 @@
 #include <clientversion.h>
 #include <compat/compat.h>
 #include <consensus/consensus.h>
+#include <crypto/common.h>
 #include <crypto/sha256.h>
 #include <i2p.h>
 #include <logging.h>
@@ -56,6 +57,7 @@
 #include <functional>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <math.h>
 
@@ -90,6 +92,9 @@ static constexpr std::chrono::seconds MAX_UPLOAD_TIMEFRAME{60 * 60 * 24};
 // A random time period (0 to 1 seconds) is added to feeler connections to prevent synchronization.
 static constexpr auto FEELER_SLEEP_WINDOW{1s};
 
+/** Maximum number of queued buffers gathered into one send call, well within IOV_MAX */
+static constexpr size_t MAX_SEND_GATHER{64};
+
 /** Used to pass flags to the Bind() function */
 enum BindFlags {
     BF_NONE         = 0,
@@ -588,6 +593,7 @@ CNode* CConnman::ConnectNode(CAddress addrConnect, const char *pszDest, bool fCo
                              CNodeOptions{
                                  .i2p_sam_session = std::move(i2p_transient_session),
                                  .recv_flood_size = nReceiveFloodSize,
+                                 .recv_buffer_pool = &m_recv_buffer_pool,
                              });
     pnode->AddRef();
 
@@ -636,6 +642,20 @@ Network CNode::ConnectedThroughNetwork() const
     return m_inbound_onion ? NET_ONION : addr.GetNetClass();
 }
 
+void CNode::AddBytesPerMsgType(mapMsgTypeSize& sent, mapMsgTypeSize& recv)
+{
+    {
+        LOCK(cs_vSend);
+        for (const auto& [msg_type, bytes] : mapSendBytesPerMsgType) {
+            sent[msg_type] += bytes;
+        }
+    }
+    LOCK(cs_vRecv);
+    for (const auto& [msg_type, bytes] : mapRecvBytesPerMsgType) {
+        recv[msg_type] += bytes;
+    }
+}
+
 #undef X
 #define X(name) stats.name = name
 void CNode::CopyStats(CNodeStats& stats)
@@ -669,6 +689,10 @@ void CNode::CopyStats(CNodeStats& stats)
         X(mapRecvBytesPerMsgType);
         X(nRecvBytes);
     }
+    {
+        LOCK(m_msg_time_mutex);
+        X(m_msg_time_per_msg_type);
+    }
     X(m_permission_flags);
 
     X(m_last_ping_time);
@@ -690,6 +714,7 @@ bool CNode::ReceiveMsgBytes(Span<const uint8_t> msg_bytes, bool& complete)
     m_last_recv = std::chrono::duration_cast<std::chrono::seconds>(time);
     nRecvBytes += msg_bytes.size();
     while (msg_bytes.size() > 0) {
+        const auto deserialize_start{SteadyClock::now()};
         // absorb network data
         int handled = m_deserializer->Read(msg_bytes);
         if (handled < 0) {
@@ -701,6 +726,8 @@ bool CNode::ReceiveMsgBytes(Span<const uint8_t> msg_bytes, bool& complete)
             // decompose a transport agnostic CNetMessage from the deserializer
             bool reject_message{false};
             CNetMessage msg = m_deserializer->GetMessage(time, reject_message);
+            msg.m_deserialize_time = std::exchange(m_partial_deserialize_time, 0us) +
+                                     std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - deserialize_start);
             if (reject_message) {
                 // Message deserialization failed. Drop the message but don't disconnect the peer.
                 // store the size of the corrupt message
@@ -721,6 +748,8 @@ bool CNode::ReceiveMsgBytes(Span<const uint8_t> msg_bytes, bool& complete)
             vRecvMsg.push_back(std::move(msg));
 
             complete = true;
+        } else {
+            m_partial_deserialize_time += std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - deserialize_start);
         }
     }
 
@@ -758,11 +787,11 @@ int V1TransportDeserializer::readHeader(Span<const uint8_t> msg_bytes)
     // reject messages larger than MAX_SIZE or MAX_PROTOCOL_MESSAGE_LENGTH
     if (hdr.nMessageSize > MAX_SIZE || hdr.nMessageSize > MAX_PROTOCOL_MESSAGE_LENGTH) {
 
-LogPrint (BCLog::ALL, "hdr.nMessageSize %u\n", hdr.nMessageSize);
-LogPrint (BCLog::ALL, "MAX_SIZE %u\n", MAX_SIZE);
-LogPrint (BCLog::ALL, "MAX_PROTOCOL_MESSAGE_LENGTH %u\n", MAX_PROTOCOL_MESSAGE_LENGTH);
-LogPrint (BCLog::ALL, " %s\n", SanitizeString(hdr.GetCommand()));
-LogPrint (BCLog::ALL, " %u\n", m_node_id);
+LogPrint (BCLog::NET, "hdr.nMessageSize %u\n", hdr.nMessageSize);
+LogPrint (BCLog::NET, "MAX_SIZE %u\n", MAX_SIZE);
+LogPrint (BCLog::NET, "MAX_PROTOCOL_MESSAGE_LENGTH %u\n", MAX_PROTOCOL_MESSAGE_LENGTH);
+LogPrint (BCLog::NET, " %s\n", SanitizeString(hdr.GetCommand()));
+LogPrint (BCLog::NET, " %u\n", m_node_id);
 
         LogPrint(BCLog::NET, "Header error: Size too large (%s, %u bytes), peer=%d\n", SanitizeString(hdr.GetCommand()), hdr.nMessageSize, m_node_id);
         return -1;
@@ -781,7 +810,15 @@ int V1TransportDeserializer::readData(Span<const uint8_t> msg_bytes)
 
     if (vRecv.size() < nDataPos + nCopy) {
         // Allocate up to 256 KiB ahead, but never more than the total message size.
-        vRecv.resize(std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024));
+        const size_t size{std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024)};
+        if (m_buffer_pool && hdr.nMessageSize >= RecvBufferPool::MIN_POOLED_SIZE && vRecv.capacity() < size) {
+            // Move what arrived so far to a larger buffer, pooling the one outgrown
+            CDataStream buffer{m_buffer_pool->Take(size, hdr.nMessageSize, vRecv.GetType(), vRecv.GetVersion())};
+            buffer.write(Span{vRecv.data(), nDataPos});
+            m_buffer_pool->Return(std::move(vRecv));
+            vRecv = std::move(buffer);
+        }
+        vRecv.resize(size);
     }
 
     hasher.Write(msg_bytes.first(nCopy));
@@ -805,6 +842,7 @@ CNetMessage V1TransportDeserializer::GetMessage(const std::chrono::microseconds
     reject_message = false;
     // decompose a single CNetMessage from the TransportDeserializer
     CNetMessage msg(std::move(vRecv));
+    if (m_buffer_pool) msg.m_buffer_pool = m_buffer_pool;
 
     // store message type string, time, and sizes
     msg.m_type = hdr.GetCommand();
@@ -836,6 +874,45 @@ CNetMessage V1TransportDeserializer::GetMessage(const std::chrono::microseconds
     return msg;
 }
 
+CDataStream RecvBufferPool::Take(size_t min_size, size_t full_size, int type, int version)
+{
+    CDataStream buffer{type, version};
+    {
+        LOCK(m_mutex);
+        auto it{m_buffers.lower_bound(full_size)};
+        if (it == m_buffers.end()) it = m_buffers.lower_bound(min_size);
+        if (it != m_buffers.end()) {
+            m_bytes -= it->first;
+            buffer = std::move(it->second);
+            m_buffers.erase(it);
+            buffer.SetVersion(version);
+            return buffer;
+        }
+    }
+    // Sizes double, up to that of the whole message
+    size_t capacity{MIN_POOLED_SIZE};
+    while (capacity < min_size) capacity <<= 1;
+    buffer.reserve(std::min(capacity, std::max(min_size, full_size)));
+    return buffer;
+}
+
+void RecvBufferPool::Return(CDataStream&& buffer)
+{
+    buffer.clear();
+    const size_t capacity{buffer.capacity()};
+    if (capacity < MIN_POOLED_SIZE) return;
+    LOCK(m_mutex);
+    if (m_bytes + capacity > m_max_bytes) return;
+    m_bytes += capacity;
+    m_buffers.emplace(capacity, std::move(buffer));
+}
+
+size_t RecvBufferPool::PooledBytes() const
+{
+    LOCK(m_mutex);
+    return m_bytes;
+}
+
 void V1TransportSerializer::prepareForTransport(CSerializedNetMsg& msg, std::vector<unsigned char>& header) const
 {
     // create dbl-sha256 checksum
@@ -856,8 +933,17 @@ size_t CConnman::SocketSendData(CNode& node) const
     size_t nSentSize = 0;
 
     while (it != node.vSendMsg.end()) {
-        const auto& data = *it;
-        assert(data.size() > node.nSendOffset);
+        // Gather the queued messages (headers and payloads alike) into one call
+        std::array<Span<const unsigned char>, MAX_SEND_GATHER> buffers;
+        size_t buffer_count{0};
+        size_t gathered_size{0};
+        auto gather_end = it;
+        for (; gather_end != node.vSendMsg.end() && buffer_count < buffers.size(); ++gather_end) {
+            const size_t offset{gather_end == it ? node.nSendOffset : 0};
+            assert(gather_end->size() > offset);
+            buffers[buffer_count++] = Span{*gather_end}.subspan(offset);
+            gathered_size += gather_end->size() - offset;
+        }
         int nBytes = 0;
         {
             LOCK(node.m_sock_mutex);
@@ -866,24 +952,31 @@ size_t CConnman::SocketSendData(CNode& node) const
             }
             int flags = MSG_NOSIGNAL | MSG_DONTWAIT;
 #ifdef MSG_MORE
-            if (it + 1 != node.vSendMsg.end()) {
+            // Hold back a partial segment while more is queued than fits into one call
+            if (gather_end != node.vSendMsg.end()) {
                 flags |= MSG_MORE;
             }
 #endif
-            nBytes = node.m_sock->Send(reinterpret_cast<const char*>(data.data()) + node.nSendOffset, data.size() - node.nSendOffset, flags);
+            nBytes = node.m_sock->SendMany(Span{buffers.data(), buffer_count}, flags);
         }
         if (nBytes > 0) {
             node.m_last_send = GetTime<std::chrono::seconds>();
             node.nSendBytes += nBytes;
-            node.nSendOffset += nBytes;
             nSentSize += nBytes;
-            if (node.nSendOffset == data.size()) {
+            for (size_t sent = nBytes; sent > 0;) {
+                const size_t left{it->size() - node.nSendOffset};
+                if (sent < left) {
+                    node.nSendOffset += sent;
+                    break;
+                }
+                sent -= left;
                 node.nSendOffset = 0;
-                node.nSendSize -= data.size();
-                node.fPauseSend = node.nSendSize > nSendBufferMaxSize;
+                node.nSendSize -= it->size();
                 it++;
-            } else {
-                // could not send full message; stop sending more
+            }
+            node.fPauseSend = node.nSendSize > nSendBufferMaxSize;
+            if (size_t(nBytes) < gathered_size) {
+                // could not send all that was gathered; stop sending more
                 break;
             }
         } else {
@@ -1076,6 +1169,7 @@ void CConnman::CreateNodeFromAcceptedSocket(std::unique_ptr<Sock>&& sock,
                                  .permission_flags = permission_flags,
                                  .prefer_evict = discouraged,
                                  .recv_flood_size = nReceiveFloodSize,
+                                 .recv_buffer_pool = &m_recv_buffer_pool,
                              });
     pnode->AddRef();
     m_msgproc->InitializeNode(*pnode, nodeServices);
@@ -1151,6 +1245,7 @@ void CConnman::DisconnectNodes()
             {
                 // remove from m_nodes
                 m_nodes.erase(remove(m_nodes.begin(), m_nodes.end(), pnode), m_nodes.end());
+                WITH_LOCK(m_closed_bytes_mutex, pnode->AddBytesPerMsgType(m_closed_send_bytes, m_closed_recv_bytes));
 
                 // release outbound grant (if any)
                 pnode->grantOutbound.Release();
@@ -1276,6 +1371,76 @@ Sock::EventsPerSock CConnman::GenerateWaitSockets(Span<CNode* const> nodes)
     return events_per_sock;
 }
 
+Sock::EventsPerSock CConnman::WaitReadySockets(Span<CNode* const> nodes)
+{
+    // Same as GenerateWaitSockets(): drain the send buffer first, otherwise receive if there
+    // is space left in the receive buffer.
+    const auto requested_events = [](CNode& node) {
+        if (WITH_LOCK(node.cs_vSend, return !node.vSendMsg.empty())) return Sock::SEND;
+        if (!node.fPauseRecv) return Sock::RECV;
+        return Sock::Event{0};
+    };
+    const auto ready_events = [](const CNode& node) {
+        return Sock::Event((node.m_recv_ready ? Sock::RECV : 0) | (node.m_send_ready ? Sock::SEND : 0));
+    };
+
+    // Register the new nodes. Their sockets are ready until a call would block, as nothing
+    // may have been tried on them yet. Don't wait if any node is ready already.
+    bool any_ready{false};
+    for (CNode* pnode : nodes) {
+        if (!pnode->m_sock_events_registered) {
+            LOCK(pnode->m_sock_mutex);
+            if (!pnode->m_sock) continue;
+            if (!m_sock_events->Add(*pnode->m_sock, pnode->GetId(), /*edge_triggered=*/true)) {
+                LogPrint(BCLog::NET, "failed to register socket for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(WSAGetLastError()));
+                pnode->fDisconnect = true;
+                continue;
+            }
+            pnode->m_sock_events_registered = true;
+            pnode->m_recv_ready = true;
+            pnode->m_send_ready = true;
+        }
+        any_ready = any_ready || (requested_events(*pnode) & ready_events(*pnode));
+    }
+
+    const auto timeout = any_ready ? 0ms : std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS);
+    std::vector<std::pair<uint64_t, Sock::Event>> occurred;
+    if (!m_sock_events->Wait(timeout, occurred)) {
+        interruptNet.sleep_for(timeout);
+    }
+
+    Sock::EventsPerSock events_per_sock;
+    std::unordered_map<NodeId, Sock::Event> node_events;
+    for (const auto& [key, event] : occurred) {
+        if (key > uint64_t(std::numeric_limits<NodeId>::max())) {
+            // Listening sockets are registered with keys counting down from the top
+            const size_t index = std::numeric_limits<uint64_t>::max() - key;
+            if (index < vhListenSocket.size()) {
+                events_per_sock.emplace(vhListenSocket[index].sock, Sock::Events{Sock::RECV}).first->second.occurred = Sock::RECV;
+            }
+        } else {
+            node_events[NodeId(key)] |= event;
+        }
+    }
+
+    for (CNode* pnode : nodes) {
+        if (!pnode->m_sock_events_registered) continue;
+        if (const auto it = node_events.find(pnode->GetId()); it != node_events.end()) {
+            // An error is noticed by the next recv or send
+            if (it->second & (Sock::RECV | Sock::ERR)) pnode->m_recv_ready = true;
+            if (it->second & (Sock::SEND | Sock::ERR)) pnode->m_send_ready = true;
+        }
+        const Sock::Event requested{requested_events(*pnode)};
+        const Sock::Event ready{Sock::Event(requested & ready_events(*pnode))};
+        if (!ready) continue;
+        LOCK(pnode->m_sock_mutex);
+        if (!pnode->m_sock) continue;
+        events_per_sock.emplace(pnode->m_sock, Sock::Events{requested}).first->second.occurred = ready;
+    }
+
+    return events_per_sock;
+}
+
 void CConnman::SocketHandler()
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
@@ -1287,13 +1452,18 @@ void CConnman::SocketHandler()
 
         const auto timeout = std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS);
 
-        // Check for the readiness of the already connected sockets and the
-        // listening sockets in one call ("readiness" as in poll(2) or
-        // select(2)). If none are ready, wait for a short while and return
-        // empty sets.
-        events_per_sock = GenerateWaitSockets(snap.Nodes());
-        if (events_per_sock.empty() || !events_per_sock.begin()->first->WaitMany(timeout, events_per_sock)) {
-            interruptNet.sleep_for(timeout);
+        if (m_sock_events) {
+            // The kernel keeps track of the sockets, only those ready are returned.
+            events_per_sock = WaitReadySockets(snap.Nodes());
+        } else {
+            // Check for the readiness of the already connected sockets and the
+            // listening sockets in one call ("readiness" as in poll(2) or
+            // select(2)). If none are ready, wait for a short while and return
+            // empty sets.
+            events_per_sock = GenerateWaitSockets(snap.Nodes());
+            if (events_per_sock.empty() || !events_per_sock.begin()->first->WaitMany(timeout, events_per_sock)) {
+                interruptNet.sleep_for(timeout);
+            }
         }
 
         // Service (send/receive) each of the already connected nodes.
@@ -1343,6 +1513,8 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
                 }
                 nBytes = pnode->m_sock->Recv(pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
             }
+            // A short read drained the socket, wait for the next edge
+            if (nBytes < int(sizeof(pchBuf))) pnode->m_recv_ready = false;
             if (nBytes > 0)
             {
                 bool notify = false;
@@ -1379,8 +1551,11 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
 
         if (sendSet) {
             // Send data
-            size_t bytes_sent = WITH_LOCK(pnode->cs_vSend, return SocketSendData(*pnode));
+            const auto [bytes_sent, data_left] = WITH_LOCK(pnode->cs_vSend,
+                return std::make_pair(SocketSendData(*pnode), !pnode->vSendMsg.empty()));
             if (bytes_sent) RecordBytesSent(bytes_sent);
+            // Not all could be sent, wait for the next edge
+            if (data_left) pnode->m_send_ready = false;
         }
 
         if (InactivityCheck(*pnode)) pnode->fDisconnect = true;
@@ -2353,6 +2528,20 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
         return false;
     }
 
+    if (m_socket_events_mode != SocketEventsMode::POLL) {
+        m_sock_events = SockEvents::Make(m_socket_events_mode);
+        if (!m_sock_events) {
+            return false;
+        }
+        for (size_t i = 0; i < vhListenSocket.size(); ++i) {
+            // Level-triggered, as only one connection is accepted per iteration
+            if (!m_sock_events->Add(*vhListenSocket[i].sock, std::numeric_limits<uint64_t>::max() - i, /*edge_triggered=*/false)) {
+                LogPrintf("Error: failed to register listening socket: %s\n", NetworkErrorString(WSAGetLastError()));
+                return false;
+            }
+        }
+    }
+
     Proxy i2p_sam;
     if (GetProxy(NET_I2P, i2p_sam) && connOptions.m_i2p_accept_incoming) {
         m_i2p_sam_session = std::make_unique<i2p::sam::Session>(gArgs.GetDataDirNet() / "i2p_private_key",
@@ -2434,7 +2623,7 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     }
 
     // Dump network addresses
-    scheduler.scheduleEvery([this] { DumpAddresses(); }, DUMP_PEERS_INTERVAL);
+    scheduler.scheduleEvery([this] { DumpAddresses(); }, DUMP_PEERS_INTERVAL, "dumpaddresses");
 
     return true;
 }
@@ -2524,6 +2713,7 @@ void CConnman::StopNodes()
     }
     m_nodes_disconnected.clear();
     vhListenSocket.clear();
+    m_sock_events.reset();
     semOutbound.reset();
     semAddnode.reset();
 }
@@ -2635,6 +2825,20 @@ size_t CConnman::GetNodeCount(ConnectionDirection flags) const
     return nNum;
 }
 
+void CConnman::GetBytesPerMsgType(mapMsgTypeSize& sent, mapMsgTypeSize& recv) const
+{
+    // Peers move to the closed totals under m_nodes_mutex, so none is counted twice or missed
+    LOCK(m_nodes_mutex);
+    {
+        LOCK(m_closed_bytes_mutex);
+        sent = m_closed_send_bytes;
+        recv = m_closed_recv_bytes;
+    }
+    for (CNode* pnode : m_nodes) {
+        pnode->AddBytesPerMsgType(sent, recv);
+    }
+}
+
 void CConnman::GetNodeStats(std::vector<CNodeStats>& vstats) const
 {
     vstats.clear();
@@ -2790,6 +2994,54 @@ uint64_t CConnman::GetTotalBytesSent() const
     return nTotalBytesSent;
 }
 
+MsgProcessingTime& MsgProcessingTime::operator+=(const MsgProcessingTime& other)
+{
+    count += other.count;
+    deserialize += other.deserialize;
+    handler += other.handler;
+    cs_main_wait += other.cs_main_wait;
+    return *this;
+}
+
+void DurationHistogram::Add(std::chrono::microseconds duration)
+{
+    const uint64_t micros{uint64_t(std::max<int64_t>(duration.count(), 0))};
+    ++buckets[std::min<size_t>(CountBits(micros), NUM_BUCKETS - 1)];
+    total += duration;
+}
+
+void CNode::RecordMsgProcessingTime(const std::string& msg_type, const MsgProcessingTime& time)
+{
+    LOCK(m_msg_time_mutex);
+    m_msg_time_per_msg_type[msg_type] += time;
+}
+
+const std::string& CConnman::MsgTypeForStats(const std::string& msg_type)
+{
+    static const std::unordered_set<std::string> known_types{getAllNetMessageTypes().begin(), getAllNetMessageTypes().end()};
+    return known_types.count(msg_type) ? msg_type : NET_MESSAGE_TYPE_OTHER;
+}
+
+void CConnman::RecordMsgProcessingTime(CNode& node, const std::string& msg_type, const MsgProcessingTime& time)
+{
+    // To prevent a memory DOS, only allow known message types.
+    const std::string& stats_type{MsgTypeForStats(msg_type)};
+    node.RecordMsgProcessingTime(stats_type, time);
+
+    LOCK(m_msg_histograms_mutex);
+    MsgProcessingHistograms& histograms{m_msg_histograms[stats_type]};
+    histograms.count += time.count;
+    histograms.deserialize.Add(time.deserialize);
+    histograms.handler.Add(time.handler);
+    histograms.cs_main_wait.Add(time.cs_main_wait);
+}
+
+mapMsgTypeHistograms CConnman::GetMsgProcessingHistograms() const
+{
+    LOCK(m_msg_histograms_mutex);
+    return m_msg_histograms;
+}
+
 ServiceFlags CConnman::GetLocalServices() const
 {
     return nLocalServices;
@@ -2805,7 +3057,7 @@ CNode::CNode(NodeId idIn,
              ConnectionType conn_type_in,
              bool inbound_onion,
              CNodeOptions&& node_opts)
-    : m_deserializer{std::make_unique<V1TransportDeserializer>(V1TransportDeserializer(Params(), idIn, SER_NETWORK, INIT_PROTO_VERSION))},
+    : m_deserializer{std::make_unique<V1TransportDeserializer>(V1TransportDeserializer(Params(), idIn, SER_NETWORK, INIT_PROTO_VERSION, node_opts.recv_buffer_pool))},
       m_serializer{std::make_unique<V1TransportSerializer>(V1TransportSerializer())},
       m_permission_flags{node_opts.permission_flags},
       m_sock{sock},
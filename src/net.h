@@ -29,6 +29,7 @@
 #include <util/sock.h>
 #include <util/threadinterrupt.h>
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -192,6 +193,38 @@ extern std::map<CNetAddr, LocalServiceInfo> mapLocalHost GUARDED_BY(g_maplocalho
 extern const std::string NET_MESSAGE_TYPE_OTHER;
 using mapMsgTypeSize = std::map</* message type */ std::string, /* total bytes */ uint64_t>;
 
+/** Time received messages took: in the transport deserializer, in the message handler, and blocked on cs_main within the handler. */
+struct MsgProcessingTime {
+    uint64_t count{0};
+    std::chrono::microseconds deserialize{0};
+    std::chrono::microseconds handler{0};
+    std::chrono::microseconds cs_main_wait{0};
+
+    MsgProcessingTime& operator+=(const MsgProcessingTime& other);
+};
+using mapMsgTypeTime = std::map</* message type */ std::string, MsgProcessingTime>;
+
+/**
+ * Counts of durations in power-of-two microsecond buckets: bucket 0 holds durations
+ * below 1us, bucket i those in [2^(i-1), 2^i) us, and the last bucket everything longer.
+ */
+struct DurationHistogram {
+    static constexpr size_t NUM_BUCKETS{24};
+    std::array<uint64_t, NUM_BUCKETS> buckets{};
+    std::chrono::microseconds total{0};
+
+    void Add(std::chrono::microseconds duration);
+};
+
+/** MsgProcessingTime with the distribution of each duration rather than only its total. */
+struct MsgProcessingHistograms {
+    uint64_t count{0};
+    DurationHistogram deserialize;
+    DurationHistogram handler;
+    DurationHistogram cs_main_wait;
+};
+using mapMsgTypeHistograms = std::map</* message type */ std::string, MsgProcessingHistograms>;
+
 class CNodeStats
 {
 public:
@@ -213,6 +246,7 @@ public:
     mapMsgTypeSize mapSendBytesPerMsgType;
     uint64_t nRecvBytes;
     mapMsgTypeSize mapRecvBytesPerMsgType;
+    mapMsgTypeTime m_msg_time_per_msg_type;
     NetPermissionFlags m_permission_flags;
     std::chrono::microseconds m_last_ping_time;
     std::chrono::microseconds m_min_ping_time;
@@ -229,6 +263,45 @@ public:
 };
 
 
+/** Most bytes of message buffers kept for reuse once their messages are processed */
+static constexpr size_t MAX_RECV_BUFFER_POOL_BYTES{2 * MAX_PROTOCOL_MESSAGE_LENGTH};
+
+/**
+ * Buffers of large incoming messages, such as blocks and storage
+ * transactions, kept once the messages are processed for those that follow.
+ *
+ * A large message grows into buffers of sizes doubling from MIN_POOLED_SIZE,
+ * each taken from the pool or allocated, rather than being reallocated every
+ * 256 KiB: it is copied a few times instead of once per 256 KiB. Where the
+ * pool holds a buffer the whole message fits in, the message is read straight
+ * into it. Buffers come back once their message is processed, or outgrown,
+ * up to max_bytes pooled; small messages are left to the allocator.
+ */
+class RecvBufferPool
+{
+public:
+    //! Messages below this size are not read into pooled buffers
+    static constexpr size_t MIN_POOLED_SIZE{256 * 1024};
+
+    explicit RecvBufferPool(size_t max_bytes) : m_max_bytes{max_bytes} {}
+
+    /** An empty buffer of at least min_size bytes, if one is pooled of full_size, that one. */
+    CDataStream Take(size_t min_size, size_t full_size, int type, int version) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Keep a buffer for reuse. Buffers below MIN_POOLED_SIZE, or past max_bytes pooled, are freed. */
+    void Return(CDataStream&& buffer) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Bytes of the buffers pooled. */
+    size_t PooledBytes() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    const size_t m_max_bytes;
+    mutable Mutex m_mutex;
+    //! Buffers by capacity
+    std::multimap<size_t, CDataStream> m_buffers GUARDED_BY(m_mutex);
+    size_t m_bytes GUARDED_BY(m_mutex){0};
+};
+
 /** Transport protocol agnostic message container.
  * Ideally it should only contain receive time, payload,
  * type and size.
@@ -236,7 +309,9 @@ public:
 class CNetMessage {
 public:
     CDataStream m_recv;                  //!< received message data
+    RecvBufferPool* m_buffer_pool{nullptr}; //!< pool m_recv goes back to once the message is processed
     std::chrono::microseconds m_time{0}; //!< time of message receipt
+    std::chrono::microseconds m_deserialize_time{0}; //!< time the transport spent on the message
     uint32_t m_message_size{0};          //!< size of the payload
     uint32_t m_raw_message_size{0};      //!< used wire size of the message (including header/checksum)
     std::string m_type;
@@ -250,6 +325,10 @@ public:
     CNetMessage(const CNetMessage&) = delete;
     CNetMessage& operator=(CNetMessage&&) = default;
     CNetMessage& operator=(const CNetMessage&) = delete;
+    ~CNetMessage()
+    {
+        if (m_buffer_pool) m_buffer_pool->Return(std::move(m_recv));
+    }
 
     void SetVersion(int nVersionIn)
     {
@@ -285,6 +364,7 @@ private:
     CDataStream hdrbuf;             // partially received header
     CMessageHeader hdr;             // complete header
     CDataStream vRecv;              // received message data
+    RecvBufferPool* const m_buffer_pool; // large messages are read into buffers from it, if set
     unsigned int nHdrPos;
     unsigned int nDataPos;
 
@@ -304,11 +384,12 @@ private:
     }
 
 public:
-    V1TransportDeserializer(const CChainParams& chain_params, const NodeId node_id, int nTypeIn, int nVersionIn)
+    V1TransportDeserializer(const CChainParams& chain_params, const NodeId node_id, int nTypeIn, int nVersionIn, RecvBufferPool* buffer_pool = nullptr)
         : m_chain_params(chain_params),
           m_node_id(node_id),
           hdrbuf(nTypeIn, nVersionIn),
-          vRecv(nTypeIn, nVersionIn)
+          vRecv(nTypeIn, nVersionIn),
+          m_buffer_pool(buffer_pool)
     {
         Reset();
     }
@@ -357,6 +438,7 @@ struct CNodeOptions
     std::unique_ptr<i2p::sam::Session> i2p_sam_session = nullptr;
     bool prefer_evict = false;
     size_t recv_flood_size{DEFAULT_MAXRECEIVEBUFFER * 1000};
+    RecvBufferPool* recv_buffer_pool{nullptr};
 };
 
 /** Information about a peer */
@@ -424,6 +506,15 @@ public:
     const uint64_t nKeyedNetGroup;
     std::atomic_bool fPauseRecv{false};
     std::atomic_bool fPauseSend{false};
+    /** Whether m_sock is registered with CConnman::m_sock_events. Used only by SocketHandler thread */
+    bool m_sock_events_registered{false};
+    /**
+     * Whether the socket may be read from or written to without blocking, as last reported by
+     * the edge-triggered CConnman::m_sock_events and until a call would block. Used only by
+     * SocketHandler thread
+     */
+    bool m_recv_ready{false};
+    bool m_send_ready{false};
 
     const ConnectionType m_conn_type;
 
@@ -613,7 +704,13 @@ public:
 
     void CloseSocketDisconnect() EXCLUSIVE_LOCKS_REQUIRED(!m_sock_mutex);
 
-    void CopyStats(CNodeStats& stats) EXCLUSIVE_LOCKS_REQUIRED(!m_subver_mutex, !m_addr_local_mutex, !cs_vSend, !cs_vRecv);
+    void CopyStats(CNodeStats& stats) EXCLUSIVE_LOCKS_REQUIRED(!m_subver_mutex, !m_addr_local_mutex, !cs_vSend, !cs_vRecv, !m_msg_time_mutex);
+
+    //! Add the bytes sent and received of each message type to sent and recv
+    void AddBytesPerMsgType(mapMsgTypeSize& sent, mapMsgTypeSize& recv) EXCLUSIVE_LOCKS_REQUIRED(!cs_vSend, !cs_vRecv);
+
+    /** Account the time a received message took under its type (as returned by CConnman::MsgTypeForStats()). */
+    void RecordMsgProcessingTime(const std::string& msg_type, const MsgProcessingTime& time) EXCLUSIVE_LOCKS_REQUIRED(!m_msg_time_mutex);
 
     std::string ConnectionTypeAsString() const { return ::ConnectionTypeAsString(m_conn_type); }
 
@@ -642,6 +739,12 @@ private:
     mapMsgTypeSize mapSendBytesPerMsgType GUARDED_BY(cs_vSend);
     mapMsgTypeSize mapRecvBytesPerMsgType GUARDED_BY(cs_vRecv);
 
+    //! Transport time spent on the message being received so far
+    std::chrono::microseconds m_partial_deserialize_time GUARDED_BY(cs_vRecv){0};
+
+    mutable Mutex m_msg_time_mutex;
+    mapMsgTypeTime m_msg_time_per_msg_type GUARDED_BY(m_msg_time_mutex);
+
     /**
      * If an I2P session is created per connection (for outbound transient I2P
      * connections) then it is stored here so that it can be destroyed when the
@@ -727,6 +830,7 @@ public:
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
         bool m_i2p_accept_incoming;
+        SocketEventsMode m_socket_events_mode{SocketEventsMode::POLL};
     };
 
     void Init(const Options& connOptions) EXCLUSIVE_LOCKS_REQUIRED(!m_added_nodes_mutex, !m_total_bytes_sent_mutex)
@@ -757,6 +861,7 @@ public:
             m_added_nodes = connOptions.m_added_nodes;
         }
         m_onion_binds = connOptions.onion_binds;
+        m_socket_events_mode = connOptions.m_socket_events_mode;
     }
 
     CConnman(uint64_t seed0, uint64_t seed1, AddrMan& addrman, const NetGroupManager& netgroupman,
@@ -885,9 +990,21 @@ public:
 
     std::chrono::seconds GetMaxOutboundTimeLeftInCycle() const EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex);
 
+    //! Bytes sent and received of each message type since startup, by the peers connected and those gone
+    void GetBytesPerMsgType(mapMsgTypeSize& sent, mapMsgTypeSize& recv) const EXCLUSIVE_LOCKS_REQUIRED(!m_closed_bytes_mutex);
+
     uint64_t GetTotalBytesRecv() const;
     uint64_t GetTotalBytesSent() const EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex);
 
+    /** The message type received messages are accounted under: msg_type if it is known, NET_MESSAGE_TYPE_OTHER otherwise. */
+    static const std::string& MsgTypeForStats(const std::string& msg_type);
+
+    /** Account the time a message received from node took, both for the node and in the histograms across all peers. */
+    void RecordMsgProcessingTime(CNode& node, const std::string& msg_type, const MsgProcessingTime& time) EXCLUSIVE_LOCKS_REQUIRED(!m_msg_histograms_mutex);
+
+    /** Histograms of the time received messages took since startup, per message type. */
+    mapMsgTypeHistograms GetMsgProcessingHistograms() const EXCLUSIVE_LOCKS_REQUIRED(!m_msg_histograms_mutex);
+
     /** Get a unique deterministic randomizer. */
     CSipHasher GetDeterministicRandomizer(uint64_t id) const;
 
@@ -951,6 +1068,15 @@ private:
      */
     Sock::EventsPerSock GenerateWaitSockets(Span<CNode* const> nodes);
 
+    /**
+     * Same as `GenerateWaitSockets()` and waiting for them, but using the persistent
+     * registrations of `m_sock_events`: register new nodes, wait for their readiness to change
+     * and return the sockets which are ready for the IO that would be requested.
+     * @param[in] nodes Select from these nodes' sockets.
+     * @return sockets with the `occurred` events set
+     */
+    Sock::EventsPerSock WaitReadySockets(Span<CNode* const> nodes);
+
     /**
      * Check connected and listening sockets for IO readiness and process them accordingly.
      */
@@ -1026,6 +1152,9 @@ private:
     std::chrono::seconds nMaxOutboundCycleStartTime GUARDED_BY(m_total_bytes_sent_mutex) {0};
     uint64_t nMaxOutboundLimit GUARDED_BY(m_total_bytes_sent_mutex);
 
+    mutable Mutex m_msg_histograms_mutex;
+    mapMsgTypeHistograms m_msg_histograms GUARDED_BY(m_msg_histograms_mutex);
+
     // P2P timeout in seconds
     std::chrono::seconds m_peer_connect_timeout;
 
@@ -1045,9 +1174,15 @@ private:
     Mutex m_addr_fetches_mutex;
     std::vector<std::string> m_added_nodes GUARDED_BY(m_added_nodes_mutex);
     mutable Mutex m_added_nodes_mutex;
+    //! Buffers of large messages received, shared by the peers. Outlives them, as their messages go back to it
+    RecvBufferPool m_recv_buffer_pool{MAX_RECV_BUFFER_POOL_BYTES};
     std::vector<CNode*> m_nodes GUARDED_BY(m_nodes_mutex);
     std::list<CNode*> m_nodes_disconnected;
     mutable RecursiveMutex m_nodes_mutex;
+    //! Bytes of each message type of the peers no longer in m_nodes, for GetBytesPerMsgType()
+    mutable Mutex m_closed_bytes_mutex;
+    mapMsgTypeSize m_closed_send_bytes GUARDED_BY(m_closed_bytes_mutex);
+    mapMsgTypeSize m_closed_recv_bytes GUARDED_BY(m_closed_bytes_mutex);
     std::atomic<NodeId> nLastNodeId{0};
     unsigned int nPrevNodeCount{0};
 
@@ -1165,6 +1300,15 @@ private:
      */
     std::vector<CService> m_onion_binds;
 
+    /** How to check the sockets for readiness, see `-socketevents`. */
+    SocketEventsMode m_socket_events_mode{SocketEventsMode::POLL};
+
+    /**
+     * Persistent registrations of the listening and connected sockets, nullptr if
+     * `Sock::WaitMany()` is used instead. Used only by SocketHandler thread.
+     */
+    std::unique_ptr<SockEvents> m_sock_events;
+
     /**
      * Mutex protecting m_i2p_sam_sessions.
      */
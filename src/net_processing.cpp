@@ -10,6 +10,7 @@
 #include <blockencodings.h>
 #include <blockfilter.h>
 #include <chainparams.h>
+#include <compressedheaders.h>
 #include <consensus/amount.h>
 #include <consensus/validation.h>
 #include <deploymentstatus.h>
@@ -30,6 +31,7 @@
 #include <random.h>
 #include <reverse_iterator.h>
 #include <scheduler.h>
+#include <storage/peerfetch.h>
 #include <streams.h>
 #include <sync.h>
 #include <timedata.h>
@@ -40,18 +42,25 @@
 #include <util/check.h> // For NDEBUG compile time check
 #include <util/strencodings.h>
 #include <util/system.h>
+#include <util/thread.h>
 #include <util/trace.h>
 #include <validation.h>
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <future>
 #include <memory>
 #include <optional>
+#include <thread>
 #include <typeinfo>
 
 using node::ReadBlockFromDisk;
+using node::RawBlockHasWitness;
 using node::ReadRawBlockFromDisk;
 
 /** How long to cache transactions in mapRelay for normal relay */
@@ -108,8 +117,25 @@ static constexpr auto OVERLOADED_PEER_TX_DELAY{2s};
 static constexpr auto GETDATA_TX_INTERVAL{60s};
 /** Limit to avoid sending big packets. Not used in processing incoming GETDATA for compatibility */
 static const unsigned int MAX_GETDATA_SZ = 1000;
+/** Most orphans of a chain accepted in one pass over a peer's orphan work set, before other peers get their turn */
+static constexpr unsigned int MAX_ORPHAN_CHAIN_PASS{100};
+/** Serialized size of a transaction from which it is deserialized on a message worker */
+static constexpr size_t MIN_WORKER_TX_SIZE{16000};
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 1024;
+/** Number of blocks kept requested from a single peer until its block download throughput is measured. */
+static const int DEFAULT_BLOCKS_IN_TRANSIT_PER_PEER = 16;
+/** Number of blocks kept requested from a single peer, however slow it is. */
+static const int MIN_BLOCKS_IN_TRANSIT_PER_PEER = 4;
+/** How long the blocks requested from a peer should keep it busy at its measured throughput, on top of its ping time. */
+static constexpr auto BLOCK_DOWNLOAD_TARGET_QUEUE{2s};
+/** Weight of a new sample in the moving averages of a peer's block download throughput and block size. */
+static constexpr double BLOCK_DOWNLOAD_SAMPLE_WEIGHT{0.2};
+/** How many times longer than a peer should need for a block it must have been at it, before the block
+ *  holding back the download window is requested from an idle peer instead. */
+static constexpr double BLOCK_REASSIGN_FACTOR{4};
+/** Least time a peer gets to send the block holding back the download window before it is reassigned. */
+static constexpr auto BLOCK_REASSIGN_TIMEOUT_MIN{1s};
 /** Default time during which a peer must stall block download progress before being disconnected.
  * the actual timeout is increased temporarily if peers are disconnected for hitting the timeout */
 static constexpr auto BLOCK_STALLING_TIMEOUT_DEFAULT{2s};
@@ -118,6 +144,7 @@ static constexpr auto BLOCK_STALLING_TIMEOUT_MAX{64s};
 /** Number of headers sent in one getheaders result. We rely on the assumption that if a peer sends
  *  less than this number, we reached its tip. Changing this value is a protocol upgrade. */
 static const unsigned int MAX_HEADERS_RESULTS = 2000;
+static_assert(MAX_COMPRESSED_HEADERS == MAX_HEADERS_RESULTS, "a cheaders message holds as many headers as a headers message");
 /** Maximum depth of blocks we're willing to serve as compact blocks to peers
  *  when requested. For older blocks, a regular BLOCK response will be sent. */
 static const int MAX_CMPCTBLOCK_DEPTH = 5;
@@ -125,9 +152,11 @@ static const int MAX_CMPCTBLOCK_DEPTH = 5;
 static const int MAX_BLOCKTXN_DEPTH = 10;
 /** Size of the "block download window": how far ahead of our current height do we fetch?
  *  Larger windows tolerate larger download speed differences between peer, but increase the potential
- *  degree of disordering of blocks on disk (which make reindexing and pruning harder). We'll probably
- *  want to make this a per-peer adaptive value at some point. */
+ *  degree of disordering of blocks on disk (which make reindexing and pruning harder). It is widened
+ *  up to MAX_BLOCK_DOWNLOAD_WINDOW to the blocks kept in flight from the peers we measured. */
 static const unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
+/** Largest block download window, when the peers we download from keep more blocks in flight together. */
+static const unsigned int MAX_BLOCK_DOWNLOAD_WINDOW = 8192;
 /** Block download timeout base, expressed in multiples of the block interval (i.e. 10 min) */
 static constexpr double BLOCK_DOWNLOAD_TIMEOUT_BASE = 1;
 /** Additional block download timeout per parallel downloading peer (i.e. 5 min) */
@@ -254,6 +283,13 @@ struct Peer {
     /** This peer's reported block height when we connected */
     std::atomic<int> m_starting_height{-1};
 
+    /** Whether a message of this peer is being worked on by a message worker, holding back its later messages */
+    std::atomic_bool m_message_offloaded{false};
+
+    Mutex m_deserialized_tx_mutex;
+    /** A transaction deserialized by a message worker, processed before the next message of this peer */
+    CTransactionRef m_deserialized_tx GUARDED_BY(m_deserialized_tx_mutex);
+
     /** The pong reply we're expecting, or 0 if no pong expected. */
     std::atomic<uint64_t> m_ping_nonce_sent{0};
     /** When the last ping was sent, or 0 if no ping was ever sent */
@@ -368,6 +404,23 @@ struct Peer {
     /** Total number of addresses that were processed (excludes rate-limited ones). */
     std::atomic<uint64_t> m_addr_processed{0};
 
+    /** Compact blocks from this peer rebuilt without requesting any transactions */
+    std::atomic<uint64_t> m_cmpctblocks_reconstructed{0};
+    /** Compact blocks from this peer rebuilt after requesting the missing transactions */
+    std::atomic<uint64_t> m_cmpctblocks_txn_requested{0};
+    /** Compact blocks from this peer that could not be rebuilt, so the full block was requested */
+    std::atomic<uint64_t> m_cmpctblocks_failed{0};
+
+    /** Transactions announced to this peer by flooding */
+    std::atomic<uint64_t> m_txs_flooded{0};
+    /** Transactions added to the set to reconcile with this peer instead */
+    std::atomic<uint64_t> m_txs_reconciled{0};
+    /** Transactions announced to this peer as found missing by reconciliations */
+    std::atomic<uint64_t> m_recon_txs_announced{0};
+    /** Reconciliations with this peer finished, and those failing to find the difference */
+    std::atomic<uint64_t> m_recon_rounds{0};
+    std::atomic<uint64_t> m_recon_failed{0};
+
     /** Whether we've sent this peer a getheaders in response to an inv prior to initial-headers-sync completing */
     bool m_inv_triggered_getheaders_before_sync GUARDED_BY(NetEventsInterface::g_msgproc_mutex){false};
 
@@ -397,6 +450,9 @@ struct Peer {
     /** Whether this peer wants invs or headers (when possible) for block announcements */
     bool m_prefers_headers GUARDED_BY(NetEventsInterface::g_msgproc_mutex){false};
 
+    /** Whether this peer sent "sendcheaders", so headers are sent to it as "cheaders" */
+    std::atomic<bool> m_wants_cheaders{false};
+
     explicit Peer(NodeId id, ServiceFlags our_services)
         : m_id{id}
         , m_our_services{our_services}
@@ -434,6 +490,14 @@ struct CNodeState {
     //! When the first entry in vBlocksInFlight started downloading. Don't care when vBlocksInFlight is empty.
     std::chrono::microseconds m_downloading_since{0us};
     int nBlocksInFlight{0};
+    //! Moving average of the peer's block download throughput in bytes per second, 0 until measured.
+    double m_block_bytes_per_sec{0};
+    //! Moving average of the size of the blocks the peer sent us, valid once the throughput is.
+    double m_avg_block_size{0};
+    //! Number of blocks to keep requested from the peer, sized by its throughput, the block size and its ping time.
+    int m_blocks_in_transit_target{DEFAULT_BLOCKS_IN_TRANSIT_PER_PEER};
+    //! The part of m_blocks_in_transit_total that is this peer's, 0 until its throughput is measured.
+    int m_blocks_in_transit_counted{0};
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload{false};
     /** Whether this peer wants invs or cmpctblocks (when possible) for block announcements. */
@@ -493,6 +557,7 @@ public:
     PeerManagerImpl(CConnman& connman, AddrMan& addrman,
                     BanMan* banman, ChainstateManager& chainman,
                     CTxMemPool& pool, bool ignore_incoming_txs);
+    ~PeerManagerImpl() override;
 
     /** Overridden from CValidationInterface. */
     void BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected) override
@@ -516,9 +581,12 @@ public:
 
     /** Implement PeerManager */
     void StartScheduledTasks(CScheduler& scheduler) override;
+    void StopMessageWorkers() override EXCLUSIVE_LOCKS_REQUIRED(!m_work_queue_mutex);
     void CheckForStaleTipAndEvictPeers() override;
     std::optional<std::string> FetchBlock(NodeId peer_id, const CBlockIndex& block_index) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
+    std::vector<NodeId> GetStoragePeers() override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
+    bool RequestAssetChunks(NodeId peer_id, const AssetChunksRequest& request) override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     bool GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) const override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     bool IgnoresIncomingTxs() override { return m_ignore_incoming_txs; }
     void SendPings() override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
@@ -587,10 +655,11 @@ private:
     /**
      * Reconsider orphan transactions after a parent has been accepted to the mempool.
      *
-     * @peer[in]  peer     The peer whose orphan transactions we will reconsider. Generally only
-     *                     one orphan will be reconsidered on each call of this function. If an
-     *                     accepted orphan has orphaned children, those will need to be
-     *                     reconsidered, creating more work, possibly for other peers.
+     * @peer[in]  peer     The peer whose orphan transactions we will reconsider. An orphan
+     *                     rejected ends the call. Accepted ones are followed by those of their
+     *                     orphaned children this peer sent, so that a chain resolves in one
+     *                     pass of up to MAX_ORPHAN_CHAIN_PASS orphans. Children other peers
+     *                     sent are reconsidered in their turn.
      * @return             True if meaningful work was done (an orphan was accepted/rejected).
      *                     If no meaningful work was done, then the work set for this peer
      *                     will be empty.
@@ -683,6 +752,9 @@ private:
     /** Send a version message to a peer */
     void PushNodeVersion(CNode& pnode, const Peer& peer);
 
+    /** Announce the transactions a reconciliation with the peer found it to miss */
+    void AnnounceReconciledTxs(CNode& node, Peer& peer, const std::vector<uint256>& wtxids);
+
     /** Send a ping message every PING_INTERVAL or if requested via RPC. May
      *  mark the peer to be disconnected if a ping has timed out.
      *  We use mockable time for ping timeouts, so setmocktime may cause pings
@@ -726,6 +798,19 @@ private:
     /** Whether this node is running in -blocksonly mode */
     const bool m_ignore_incoming_txs;
 
+    /** Bytes of the transactions peers are likely missing to prefill compact blocks with */
+    const size_t m_cmpctblock_prefill_bytes;
+
+    /** Whether headers are exchanged as "cheaders" with the peers that support it (-compressedheaders) */
+    const bool m_compressed_headers;
+
+    /** Send headers of consecutive blocks as "cheaders" if the peer wants them, else as "headers" */
+    void PushHeaders(CNode& node, const Peer& peer, const std::vector<CBlock>& headers);
+
+    /** Compact block prefilled with the transactions peers are likely missing. When the block
+     *  has yet to be connected, those include the ones missing from our own mempool. */
+    CBlockHeaderAndShortTxIDs MakeCompactBlock(const CBlock& block, bool check_mempool) const;
+
     bool RejectIncomingTxs(const CNode& peer) const;
 
     /** Whether we've completed initial sync yet, for determining when to turn
@@ -885,8 +970,19 @@ private:
      * If "from_peer" is specified, then only remove the block if it is in
      * flight from that peer (to avoid one peer's network traffic from
      * affecting another's state).
+     * If "block_size" is specified, the block was received from that peer and
+     * is a sample of its block download throughput.
      */
-    void RemoveBlockRequest(const uint256& hash, std::optional<NodeId> from_peer) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    void RemoveBlockRequest(const uint256& hash, std::optional<NodeId> from_peer, size_t block_size = 0) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /** Resize the number of blocks kept requested from a peer to its measured throughput. */
+    void UpdateBlocksInTransitTarget(CNodeState& state, std::chrono::microseconds min_ping_time) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /** How far ahead of the last block in common with a peer to fetch. */
+    int GetBlockDownloadWindow() const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /** Whether the block holding back the download window has been in flight from its peer for too long. */
+    bool IsBlockDownloadStalled(const CBlockIndex& block, std::chrono::microseconds now) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     /* Mark a block as in flight
      * Returns false, still setting pit, if the block was already in flight from the same peer
@@ -915,7 +1011,27 @@ private:
         LOCKS_EXCLUDED(::cs_main);
 
     /** Process a new block. Perform any post-processing housekeeping */
-    void ProcessBlock(CNode& node, const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked);
+    void ProcessBlock(NodeId peer_id, const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked);
+
+    /** Deserialize a `block` message and check it before processing it */
+    void ProcessBlockMessage(Peer& peer, CDataStream& vRecv);
+
+    /**
+     * Run task for peer on a message worker, holding back the later messages of the peer
+     * until it is done. The node, if given, is kept alive for the task.
+     * False if there are no workers, or they are stopped.
+     */
+    bool QueueMessageWork(const PeerRef& peer, CNode* node, std::function<void()> task) EXCLUSIVE_LOCKS_REQUIRED(!m_work_queue_mutex);
+    void ThreadMessageWorker() EXCLUSIVE_LOCKS_REQUIRED(!m_work_queue_mutex);
+
+    /** Threads the per-peer work not needing cs_main is done on (deserializing and checking
+     *  blocks and large transactions, serving blocks from disk), so that an expensive message
+     *  holds up the peer sending it rather than all of them */
+    std::vector<std::thread> m_message_workers;
+    Mutex m_work_queue_mutex;
+    std::condition_variable m_work_queue_cv;
+    std::deque<std::function<void()>> m_work_queue GUARDED_BY(m_work_queue_mutex);
+    bool m_message_workers_stop GUARDED_BY(m_work_queue_mutex){false};
 
     /** Relay map (txid or wtxid -> CTransactionRef) */
     typedef std::map<uint256, CTransactionRef> MapRelay;
@@ -937,6 +1053,9 @@ private:
     /** Number of peers from which we're downloading blocks. */
     int m_peers_downloading_from GUARDED_BY(cs_main) = 0;
 
+    /** Sum of the blocks kept requested from the peers whose throughput is measured, sizing the download window. */
+    int m_blocks_in_transit_total GUARDED_BY(cs_main) = 0;
+
     /** Storage for orphan information */
     TxOrphanage m_orphanage;
 
@@ -996,6 +1115,12 @@ private:
      * @param[in]   peer            The peer that we received the request from
      * @param[in]   vRecv           The raw message received
      */
+    /**
+     * Handle a getassetchunks request, answering with the chunks the storage
+     * index holds. Disconnects the peer if we do not serve stored assets.
+     */
+    void ProcessGetAssetChunks(CNode& node, Peer& peer, CDataStream& vRecv);
+
     void ProcessGetCFilters(CNode& node, Peer& peer, CDataStream& vRecv);
 
     /**
@@ -1122,7 +1247,7 @@ bool PeerManagerImpl::IsBlockRequested(const uint256& hash)
     return mapBlocksInFlight.find(hash) != mapBlocksInFlight.end();
 }
 
-void PeerManagerImpl::RemoveBlockRequest(const uint256& hash, std::optional<NodeId> from_peer)
+void PeerManagerImpl::RemoveBlockRequest(const uint256& hash, std::optional<NodeId> from_peer, size_t block_size)
 {
     auto it = mapBlocksInFlight.find(hash);
     if (it == mapBlocksInFlight.end()) {
@@ -1142,7 +1267,15 @@ void PeerManagerImpl::RemoveBlockRequest(const uint256& hash, std::optional<Node
 
     if (state->vBlocksInFlight.begin() == list_it) {
         // First block on the queue was received, update the start download time for the next one
-        state->m_downloading_since = std::max(state->m_downloading_since, GetTime<std::chrono::microseconds>());
+        const auto now{GetTime<std::chrono::microseconds>()};
+        if (from_peer && block_size > 0 && now > state->m_downloading_since) {
+            // The peer was sending this block since then
+            const double bytes_per_sec{block_size / std::chrono::duration<double>{now - state->m_downloading_since}.count()};
+            const double weight{state->m_block_bytes_per_sec > 0 ? BLOCK_DOWNLOAD_SAMPLE_WEIGHT : 1};
+            state->m_block_bytes_per_sec += weight * (bytes_per_sec - state->m_block_bytes_per_sec);
+            state->m_avg_block_size += weight * (block_size - state->m_avg_block_size);
+        }
+        state->m_downloading_since = std::max(state->m_downloading_since, now);
     }
     state->vBlocksInFlight.erase(list_it);
 
@@ -1189,6 +1322,44 @@ bool PeerManagerImpl::BlockRequested(NodeId nodeid, const CBlockIndex& block, st
     return true;
 }
 
+void PeerManagerImpl::UpdateBlocksInTransitTarget(CNodeState& state, std::chrono::microseconds min_ping_time)
+{
+    if (state.m_block_bytes_per_sec == 0) return;
+
+    // Enough blocks for the peer to keep sending during a round trip and a while after
+    std::chrono::duration<double> busy_time{BLOCK_DOWNLOAD_TARGET_QUEUE};
+    if (min_ping_time != std::chrono::microseconds::max()) busy_time += min_ping_time;
+    const double blocks{std::ceil(state.m_block_bytes_per_sec * busy_time.count() / std::max(state.m_avg_block_size, 1.0))};
+    state.m_blocks_in_transit_target = int(std::clamp<double>(blocks, MIN_BLOCKS_IN_TRANSIT_PER_PEER, MAX_BLOCKS_IN_TRANSIT_PER_PEER));
+
+    m_blocks_in_transit_total += state.m_blocks_in_transit_target - state.m_blocks_in_transit_counted;
+    state.m_blocks_in_transit_counted = state.m_blocks_in_transit_target;
+}
+
+int PeerManagerImpl::GetBlockDownloadWindow() const
+{
+    // Wide enough for each of the peers to get its share
+    return std::clamp<int>(m_blocks_in_transit_total, BLOCK_DOWNLOAD_WINDOW, MAX_BLOCK_DOWNLOAD_WINDOW);
+}
+
+bool PeerManagerImpl::IsBlockDownloadStalled(const CBlockIndex& block, std::chrono::microseconds now)
+{
+    const auto it{mapBlocksInFlight.find(block.GetBlockHash())};
+    if (it == mapBlocksInFlight.end()) return false;
+    const auto& [node_id, list_it] = it->second;
+    const CNodeState* state{State(node_id)};
+    assert(state != nullptr);
+
+    // Only judge the block the peer is sending now, and not a compact block being filled. Without
+    // a measured throughput the peer is left to the stalling logic.
+    if (state->vBlocksInFlight.begin() != list_it || list_it->partialBlock) return false;
+    if (state->m_block_bytes_per_sec == 0) return false;
+
+    const std::chrono::duration<double> timeout{std::max<std::chrono::duration<double>>(BLOCK_REASSIGN_TIMEOUT_MIN,
+        std::chrono::duration<double>{BLOCK_REASSIGN_FACTOR * state->m_avg_block_size / state->m_block_bytes_per_sec})};
+    return now - state->m_downloading_since > timeout;
+}
+
 void PeerManagerImpl::MaybeSetPeerAsAnnouncingHeaderAndIDs(NodeId nodeid)
 {
     AssertLockHeld(cs_main);
@@ -1338,7 +1509,7 @@ void PeerManagerImpl::FindNextBlocksToDownload(const Peer& peer, unsigned int co
     // Never fetch further than the best block we know the peer has, or more than BLOCK_DOWNLOAD_WINDOW + 1 beyond the last
     // linked block we have in common with this peer. The +1 is so we can detect stalling, namely if we would be able to
     // download that next block if the window were 1 larger.
-    int nWindowEnd = state->pindexLastCommonBlock->nHeight + BLOCK_DOWNLOAD_WINDOW;
+    int nWindowEnd = state->pindexLastCommonBlock->nHeight + GetBlockDownloadWindow();
     int nMaxHeight = std::min<int>(state->pindexBestKnownBlock->nHeight, nWindowEnd + 1);
     NodeId waitingfor = -1;
     while (pindexWalk->nHeight < nMaxHeight) {
@@ -1386,6 +1557,19 @@ void PeerManagerImpl::FindNextBlocksToDownload(const Peer& peer, unsigned int co
             } else if (waitingfor == -1) {
                 // This is the first already-in-flight block.
                 waitingfor = mapBlocksInFlight[pindex->GetBlockHash()].first;
+                if (waitingfor != peer.m_id && state->nBlocksInFlight == 0 &&
+                    pindex->pprev == state->pindexLastCommonBlock &&
+                    IsBlockDownloadStalled(*pindex, GetTime<std::chrono::microseconds>())) {
+                    // It holds back the window and its peer is slow to send it, while this
+                    // one is idle. Requesting it moves it over.
+                    LogPrint(BCLog::NET, "Reassigning stalled block %s (%d) from peer=%d to peer=%d\n",
+                             pindex->GetBlockHash().ToString(), pindex->nHeight, waitingfor, peer.m_id);
+                    waitingfor = peer.m_id;
+                    vBlocks.push_back(pindex);
+                    if (vBlocks.size() == count) {
+                        return;
+                    }
+                }
             }
         }
     }
@@ -1487,7 +1671,7 @@ void PeerManagerImpl::ReattemptInitialBroadcast(CScheduler& scheduler)
     // Schedule next run for 10-15 minutes in the future.
     // We add randomness on every cycle to avoid the possibility of P2P fingerprinting.
     const std::chrono::milliseconds delta = 10min + GetRandMillis(5min);
-    scheduler.scheduleFromNow([&] { ReattemptInitialBroadcast(scheduler); }, delta);
+    scheduler.scheduleFromNow([&] { ReattemptInitialBroadcast(scheduler); }, delta, "rebroadcast");
 }
 
 void PeerManagerImpl::FinalizeNode(const CNode& node)
@@ -1520,9 +1704,12 @@ void PeerManagerImpl::FinalizeNode(const CNode& node)
     m_orphanage.EraseForPeer(nodeid);
     m_txrequest.DisconnectedPeer(nodeid);
     if (m_txreconciliation) m_txreconciliation->ForgetPeer(nodeid);
+    if (g_asset_chunk_fetcher) g_asset_chunk_fetcher->PeerDisconnected(nodeid);
     m_num_preferred_download_peers -= state->fPreferredDownload;
     m_peers_downloading_from -= (state->nBlocksInFlight != 0);
     assert(m_peers_downloading_from >= 0);
+    m_blocks_in_transit_total -= state->m_blocks_in_transit_counted;
+    assert(m_blocks_in_transit_total >= 0);
     m_outbound_peers_with_protect_from_disconnect -= state->m_chain_sync.m_protect;
     assert(m_outbound_peers_with_protect_from_disconnect >= 0);
 
@@ -1533,6 +1720,7 @@ void PeerManagerImpl::FinalizeNode(const CNode& node)
         assert(mapBlocksInFlight.empty());
         assert(m_num_preferred_download_peers == 0);
         assert(m_peers_downloading_from == 0);
+        assert(m_blocks_in_transit_total == 0);
         assert(m_outbound_peers_with_protect_from_disconnect == 0);
         assert(m_wtxid_relay_peers == 0);
         assert(m_txrequest.Size() == 0);
@@ -1613,6 +1801,14 @@ bool PeerManagerImpl::GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) c
     stats.m_ping_wait = ping_wait;
     stats.m_addr_processed = peer->m_addr_processed.load();
     stats.m_addr_rate_limited = peer->m_addr_rate_limited.load();
+    stats.m_cmpctblocks_reconstructed = peer->m_cmpctblocks_reconstructed.load();
+    stats.m_cmpctblocks_txn_requested = peer->m_cmpctblocks_txn_requested.load();
+    stats.m_cmpctblocks_failed = peer->m_cmpctblocks_failed.load();
+    stats.m_txs_flooded = peer->m_txs_flooded.load();
+    stats.m_txs_reconciled = peer->m_txs_reconciled.load();
+    stats.m_recon_txs_announced = peer->m_recon_txs_announced.load();
+    stats.m_recon_rounds = peer->m_recon_rounds.load();
+    stats.m_recon_failed = peer->m_recon_failed.load();
     stats.m_addr_relay_enabled = peer->m_addr_relay_enabled.load();
     {
         LOCK(peer->m_headers_sync_mutex);
@@ -1787,6 +1983,29 @@ std::optional<std::string> PeerManagerImpl::FetchBlock(NodeId peer_id, const CBl
     return std::nullopt;
 }
 
+std::vector<NodeId> PeerManagerImpl::GetStoragePeers()
+{
+    std::vector<NodeId> peers;
+    m_connman.ForEachNode([&](CNode* node) {
+        if (!node->fSuccessfullyConnected || node->fDisconnect) return;
+        PeerRef peer = GetPeerRef(node->GetId());
+        if (peer && (peer->m_their_services & NODE_STORAGE)) peers.push_back(node->GetId());
+    });
+    return peers;
+}
+
+bool PeerManagerImpl::RequestAssetChunks(NodeId peer_id, const AssetChunksRequest& request)
+{
+    PeerRef peer = GetPeerRef(peer_id);
+    if (peer == nullptr || !(peer->m_their_services & NODE_STORAGE)) return false;
+
+    return m_connman.ForNode(peer_id, [this, &request](CNode* node) {
+        const CNetMsgMaker msgMaker(node->GetCommonVersion());
+        this->m_connman.PushMessage(node, msgMaker.Make(NetMsgType::GETASSETCHUNKS, request));
+        return true;
+    });
+}
+
 std::unique_ptr<PeerManager> PeerManager::make(CConnman& connman, AddrMan& addrman,
                                                BanMan* banman, ChainstateManager& chainman,
                                                CTxMemPool& pool, bool ignore_incoming_txs)
@@ -1803,13 +2022,71 @@ PeerManagerImpl::PeerManagerImpl(CConnman& connman, AddrMan& addrman,
       m_banman(banman),
       m_chainman(chainman),
       m_mempool(pool),
-      m_ignore_incoming_txs(ignore_incoming_txs)
+      m_ignore_incoming_txs(ignore_incoming_txs),
+      m_cmpctblock_prefill_bytes(std::max<int64_t>(0, gArgs.GetIntArg("-cmpctblockprefill", DEFAULT_CMPCTBLOCK_PREFILL_BYTES))),
+      m_compressed_headers(gArgs.GetBoolArg("-compressedheaders", DEFAULT_COMPRESSED_HEADERS))
 {
-    // While Erlay support is incomplete, it must be enabled explicitly via -txreconciliation.
-    // This argument can go away after Erlay support is complete.
+    // Reconciling transaction announcements (Erlay) with the peers supporting it is opt-in.
     if (gArgs.GetBoolArg("-txreconciliation", DEFAULT_TXRECONCILIATION_ENABLE)) {
         m_txreconciliation = std::make_unique<TxReconciliationTracker>(TXRECONCILIATION_VERSION);
     }
+
+    const int message_workers{std::clamp<int>(gArgs.GetIntArg("-messageworkers", DEFAULT_MESSAGE_WORKERS), 0, MAX_MESSAGE_WORKERS)};
+    for (int n = 0; n < message_workers; ++n) {
+        m_message_workers.emplace_back(&util::TraceThread, strprintf("msgwork.%i", n), [this] { ThreadMessageWorker(); });
+    }
+}
+
+PeerManagerImpl::~PeerManagerImpl()
+{
+    StopMessageWorkers();
+}
+
+void PeerManagerImpl::StopMessageWorkers()
+{
+    WITH_LOCK(m_work_queue_mutex, m_message_workers_stop = true);
+    m_work_queue_cv.notify_all();
+    for (std::thread& worker : m_message_workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+bool PeerManagerImpl::QueueMessageWork(const PeerRef& peer, CNode* node, std::function<void()> task)
+{
+    {
+        LOCK(m_work_queue_mutex);
+        if (m_message_workers.empty() || m_message_workers_stop) return false;
+        if (node) node->AddRef();
+        peer->m_message_offloaded = true;
+        m_work_queue.push_back([this, peer, node, task = std::move(task)] {
+            try {
+                task();
+            } catch (const std::exception& e) {
+                LogPrint(BCLog::NET, "Message work for peer=%d: Exception '%s' (%s) caught\n", peer->m_id, e.what(), typeid(e).name());
+            }
+            if (node) node->Release();
+            peer->m_message_offloaded = false;
+            m_connman.WakeMessageHandler();
+        });
+    }
+    m_work_queue_cv.notify_one();
+    return true;
+}
+
+void PeerManagerImpl::ThreadMessageWorker()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            WAIT_LOCK(m_work_queue_mutex, lock);
+            m_work_queue_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_work_queue_mutex) { return m_message_workers_stop || !m_work_queue.empty(); });
+            // Finish the work queued before stopping, its peers being held up until then
+            if (m_work_queue.empty()) return;
+            task = std::move(m_work_queue.front());
+            m_work_queue.pop_front();
+        }
+        task();
+    }
 }
 
 void PeerManagerImpl::StartScheduledTasks(CScheduler& scheduler)
@@ -1819,11 +2096,11 @@ void PeerManagerImpl::StartScheduledTasks(CScheduler& scheduler)
     // combine them in one function and schedule at the quicker (peer-eviction)
     // timer.
     static_assert(EXTRA_PEER_CHECK_INTERVAL < STALE_CHECK_INTERVAL, "peer eviction timer should be less than stale tip check timer");
-    scheduler.scheduleEvery([this] { this->CheckForStaleTipAndEvictPeers(); }, std::chrono::seconds{EXTRA_PEER_CHECK_INTERVAL});
+    scheduler.scheduleEvery([this] { this->CheckForStaleTipAndEvictPeers(); }, std::chrono::seconds{EXTRA_PEER_CHECK_INTERVAL}, "staletipcheck");
 
     // schedule next run for 10-15 minutes in the future
     const std::chrono::milliseconds delta = 10min + GetRandMillis(5min);
-    scheduler.scheduleFromNow([&] { ReattemptInitialBroadcast(scheduler); }, delta);
+    scheduler.scheduleFromNow([&] { ReattemptInitialBroadcast(scheduler); }, delta, "rebroadcast");
 }
 
 /**
@@ -1879,13 +2156,22 @@ void PeerManagerImpl::BlockDisconnected(const std::shared_ptr<const CBlock> &blo
     m_recent_confirmed_transactions.reset();
 }
 
+CBlockHeaderAndShortTxIDs PeerManagerImpl::MakeCompactBlock(const CBlock& block, bool check_mempool) const
+{
+    if (!check_mempool) return CBlockHeaderAndShortTxIDs{block, m_cmpctblock_prefill_bytes};
+    // What we only learnt of from the block itself, peers likely haven't seen either
+    return CBlockHeaderAndShortTxIDs{block, m_cmpctblock_prefill_bytes, [this](const CTransaction& tx) {
+        return !m_mempool.exists(GenTxid::Wtxid(tx.GetWitnessHash()));
+    }};
+}
+
 /**
  * Maintain state about the best-seen block and fast-announce a compact block
  * to compatible peers.
  */
 void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock)
 {
-    auto pcmpctblock = std::make_shared<const CBlockHeaderAndShortTxIDs>(*pblock);
+    auto pcmpctblock = std::make_shared<const CBlockHeaderAndShortTxIDs>(MakeCompactBlock(*pblock, /*check_mempool=*/true));
     const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
 
     LOCK(cs_main);
@@ -1915,8 +2201,11 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
         ProcessBlockAvailability(pnode->GetId());
         CNodeState &state = *State(pnode->GetId());
         // If the peer has, or we announced to them the previous block already,
-        // but we don't think they have this one, go ahead and announce it
-        if (state.m_requested_hb_cmpctblocks && !PeerHasHeader(&state, pindex) && PeerHasHeader(&state, pindex->pprev)) {
+        // but we don't think they have this one, go ahead and announce it.
+        // Fast block peers get it even in low-bandwidth mode, so a staked block
+        // reaches the operator's other stakers before it is connected here.
+        const bool fast_block{state.m_provides_cmpctblocks && pnode->HasPermission(NetPermissionFlags::FastBlock)};
+        if ((state.m_requested_hb_cmpctblocks || fast_block) && !PeerHasHeader(&state, pindex) && PeerHasHeader(&state, pindex->pprev)) {
 
             LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", "PeerManager::NewPoWValidBlock",
                     hashBlock.ToString(), pnode->GetId());
@@ -2087,7 +2376,7 @@ void PeerManagerImpl::RelayAddress(NodeId originator,
     const CSipHasher hasher{m_connman.GetDeterministicRandomizer(RANDOMIZER_ID_ADDRESS_RELAY)
                                 .Write(hash_addr)
                                 .Write(time_addr)};
-    FastRandomContext insecure_rand;
+    FastRandomContext& insecure_rand{GetThreadRandomContext()};
 
     // Relay reachable addresses to 2 peers. Unreachable addresses are relayed randomly to 1 or 2 peers.
     unsigned int nRelayNodes = (fReachable || (hasher.Finalize() & 1)) ? 2 : 1;
@@ -2115,6 +2404,16 @@ void PeerManagerImpl::RelayAddress(NodeId originator,
     }
 }
 
+void PeerManagerImpl::PushHeaders(CNode& node, const Peer& peer, const std::vector<CBlock>& headers)
+{
+    const CNetMsgMaker msg_maker(node.GetCommonVersion());
+    if (peer.m_wants_cheaders) {
+        m_connman.PushMessage(&node, msg_maker.Make(NetMsgType::CHEADERS, CompressedHeaders{std::vector<CBlockHeader>(headers.begin(), headers.end())}));
+    } else {
+        m_connman.PushMessage(&node, msg_maker.Make(NetMsgType::HEADERS, headers));
+    }
+}
+
 void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv& inv)
 {
     std::shared_ptr<const CBlock> a_recent_block;
@@ -2184,15 +2483,26 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
     std::shared_ptr<const CBlock> pblock;
     if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
         pblock = a_recent_block;
-    } else if (inv.IsMsgWitnessBlk()) {
-        // Fast-path: in this case it is possible to serve the block directly from disk,
-        // as the network format matches the format on disk
+    } else if (inv.IsMsgWitnessBlk() || inv.IsMsgBlk()) {
+        // Fast-path: serve the block directly from disk when the network format matches
+        // the format on disk, which for a block without witnesses it does either way
         std::vector<uint8_t> block_data;
         if (!ReadRawBlockFromDisk(block_data, pindex->GetBlockPos(), m_chainparams.MessageStart())) {
             assert(!"cannot load block from disk");
         }
-        m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, Span{block_data}));
-        // Don't set pblock as we've sent the block
+        if (inv.IsMsgWitnessBlk() || !RawBlockHasWitness(block_data)) {
+            // Hand the bytes read over as they are, rather than copying them into the message
+            CSerializedNetMsg msg;
+            msg.m_type = NetMsgType::BLOCK;
+            msg.data = std::move(block_data);
+            m_connman.PushMessage(&pfrom, std::move(msg));
+            // Don't set pblock as we've sent the block
+        } else {
+            // Strip the witnesses, decoding what was read rather than reading it again
+            std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
+            SpanReader{SER_NETWORK, PROTOCOL_VERSION, block_data} >> *pblockRead;
+            pblock = pblockRead;
+        }
     } else {
         // Send block from disk
         std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
@@ -2239,8 +2549,7 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
                 if (a_recent_compact_block && a_recent_compact_block->header.GetHash() == pindex->GetBlockHash()) {
                     m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::CMPCTBLOCK, *a_recent_compact_block));
                 } else {
-                    CBlockHeaderAndShortTxIDs cmpctblock{*pblock};
-                    m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::CMPCTBLOCK, cmpctblock));
+                    m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::CMPCTBLOCK, MakeCompactBlock(*pblock, /*check_mempool=*/false)));
                 }
             } else {
                 m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, *pblock));
@@ -2263,6 +2572,21 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
     }
 }
 
+void PeerManagerImpl::AnnounceReconciledTxs(CNode& node, Peer& peer, const std::vector<uint256>& wtxids)
+{
+    peer.m_recon_txs_announced += wtxids.size();
+    const CNetMsgMaker msgMaker(node.GetCommonVersion());
+    std::vector<CInv> invs;
+    for (const uint256& wtxid : wtxids) {
+        invs.emplace_back(MSG_WTX, wtxid);
+        if (invs.size() == MAX_INV_SZ) {
+            m_connman.PushMessage(&node, msgMaker.Make(NetMsgType::INV, invs));
+            invs.clear();
+        }
+    }
+    if (!invs.empty()) m_connman.PushMessage(&node, msgMaker.Make(NetMsgType::INV, invs));
+}
+
 CTransactionRef PeerManagerImpl::FindTxForGetData(const Peer::TxRelay& tx_relay, const GenTxid& gtxid, const std::chrono::seconds mempool_req, const std::chrono::seconds now)
 {
     auto txinfo = m_mempool.info(gtxid);
@@ -2355,7 +2679,19 @@ void PeerManagerImpl::ProcessGetData(CNode& pfrom, Peer& peer, const std::atomic
     if (it != peer.m_getdata_requests.end() && !pfrom.fPauseSend) {
         const CInv &inv = *it++;
         if (inv.IsGenBlkMsg()) {
-            ProcessGetBlockData(pfrom, peer, inv);
+            // Reading the block from disk and serializing it holds up only this peer on a
+            // message worker, which sends the notfound after it to keep to the order.
+            PeerRef peer_ref{GetPeerRef(peer.m_id)};
+            if (peer_ref && QueueMessageWork(peer_ref, &pfrom, [this, &pfrom, peer_ref, inv, vNotFound] {
+                    ProcessGetBlockData(pfrom, *peer_ref, inv);
+                    if (!vNotFound.empty()) {
+                        m_connman.PushMessage(&pfrom, CNetMsgMaker(pfrom.GetCommonVersion()).Make(NetMsgType::NOTFOUND, vNotFound));
+                    }
+                })) {
+                vNotFound.clear();
+            } else {
+                ProcessGetBlockData(pfrom, peer, inv);
+            }
         }
         // else: If the first item on the queue is an unknown type, we erase it
         // and continue processing the queue on the next call.
@@ -2682,7 +3018,7 @@ void PeerManagerImpl::HeadersDirectFetchBlocks(CNode& pfrom, const Peer& peer, c
             std::vector<CInv> vGetData;
             // Download as much as possible, from earliest to latest.
             for (const CBlockIndex *pindex : reverse_iterate(vToFetch)) {
-                if (nodestate->nBlocksInFlight >= MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+                if (nodestate->nBlocksInFlight >= nodestate->m_blocks_in_transit_target) {
                     // Can't download any more from this peer
                     break;
                 }
@@ -2892,9 +3228,10 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, Peer& peer,
     // something new (if these headers are valid).
     bool received_new_header{last_received_header == nullptr};
 
-    // Now process all the headers.
+    // Now process all the headers. CheckHeadersPoW() has checked their proof
+    // of work, when they were received if they are redownloaded ones.
     BlockValidationState state;
-    if (!m_chainman.ProcessNewBlockHeaders(headers, /*min_pow_checked=*/true, state, &pindexLast)) {
+    if (!m_chainman.ProcessNewBlockHeaders(headers, /*min_pow_checked=*/true, state, &pindexLast, /*pow_checked=*/true)) {
         if (state.IsInvalid()) {
             MaybePunishNodeForBlock(pfrom.GetId(), state, via_compact_block, "invalid header received");
             return;
@@ -2925,6 +3262,7 @@ bool PeerManagerImpl::ProcessOrphanTx(Peer& peer)
     LOCK(cs_main);
 
     CTransactionRef porphanTx = nullptr;
+    unsigned int accepted{0};
 
     while (CTransactionRef porphanTx = m_orphanage.GetTxToReconsider(peer.m_id)) {
         const MempoolAcceptResult result = m_chainman.ProcessTransaction(porphanTx);
@@ -2939,7 +3277,8 @@ bool PeerManagerImpl::ProcessOrphanTx(Peer& peer)
             for (const CTransactionRef& removedTx : result.m_replaced_transactions.value()) {
                 AddToCompactExtraTransactions(removedTx);
             }
-            return true;
+            // Go on with the children just added to the work set, such as the next batches of a storage upload
+            if (++accepted >= MAX_ORPHAN_CHAIN_PASS) return true;
         } else if (state.GetResult() != TxValidationResult::TX_MISSING_INPUTS) {
             if (state.IsInvalid()) {
                 LogPrint(BCLog::MEMPOOL, "   invalid orphan tx %s from peer=%d. %s\n",
@@ -2986,7 +3325,7 @@ bool PeerManagerImpl::ProcessOrphanTx(Peer& peer)
         }
     }
 
-    return false;
+    return accepted > 0;
 }
 
 bool PeerManagerImpl::PrepareBlockFilterRequest(CNode& node, Peer& peer,
@@ -2995,8 +3334,10 @@ bool PeerManagerImpl::PrepareBlockFilterRequest(CNode& node, Peer& peer,
                                                 const CBlockIndex*& stop_index,
                                                 BlockFilterIndex*& filter_index)
 {
+    // The storage filter is served alongside the basic one, when its index is enabled
     const bool supported_filter_type =
-        (filter_type == BlockFilterType::BASIC &&
+        ((filter_type == BlockFilterType::BASIC ||
+          (filter_type == BlockFilterType::STORAGE && GetBlockFilterIndex(filter_type))) &&
          (peer.m_our_services & NODE_COMPACT_FILTERS));
     if (!supported_filter_type) {
         LogPrint(BCLog::NET, "peer %d requested unsupported block filter type: %d\n",
@@ -3042,6 +3383,32 @@ bool PeerManagerImpl::PrepareBlockFilterRequest(CNode& node, Peer& peer,
     return true;
 }
 
+void PeerManagerImpl::ProcessGetAssetChunks(CNode& node, Peer& peer, CDataStream& vRecv)
+{
+    AssetChunksRequest request;
+    vRecv >> request;
+
+    if (!(peer.m_our_services & NODE_STORAGE)) {
+        LogPrint(BCLog::NET, "peer %d requested asset chunks, which we do not serve\n", node.GetId());
+        node.fDisconnect = true;
+        return;
+    }
+    if (request.count > MAX_ASSET_CHUNKS_PER_MSG) {
+        LogPrint(BCLog::NET, "peer %d requested too many asset chunks: %u / %u\n",
+                 node.GetId(), request.count, MAX_ASSET_CHUNKS_PER_MSG);
+        node.fDisconnect = true;
+        return;
+    }
+
+    const AssetChunks answer{serve_asset_chunks(request)};
+    if (answer.chunk_total == 0) {
+        // A count of 0 asks for the header chunk alone
+        LogPrint(BCLog::NET, "Asset chunks of uuid %s requested by peer %d not held: first=%u, count=%u\n",
+                 asset_uuid_to_hex(request.uuid), node.GetId(), request.first, request.count);
+    }
+    m_connman.PushMessage(&node, CNetMsgMaker(node.GetCommonVersion()).Make(NetMsgType::ASSETCHUNKS, answer));
+}
+
 void PeerManagerImpl::ProcessGetCFilters(CNode& node,Peer& peer, CDataStream& vRecv)
 {
     uint8_t filter_type_ser;
@@ -3157,12 +3524,15 @@ void PeerManagerImpl::ProcessGetCFCheckPt(CNode& node, Peer& peer, CDataStream&
     m_connman.PushMessage(&node, std::move(msg));
 }
 
-void PeerManagerImpl::ProcessBlock(CNode& node, const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked)
+void PeerManagerImpl::ProcessBlock(NodeId peer_id, const std::shared_ptr<const CBlock>& block, bool force_processing, bool min_pow_checked)
 {
     bool new_block{false};
     m_chainman.ProcessNewBlock(block, force_processing, min_pow_checked, &new_block);
     if (new_block) {
-        node.m_last_block_time = GetTime<std::chrono::seconds>();
+        m_connman.ForNode(peer_id, [](CNode* node) {
+            node->m_last_block_time = GetTime<std::chrono::seconds>();
+            return true;
+        });
         // In case this block came from a different peer than we requested
         // from, we can erase the block request now anyway (as we just stored
         // this block to disk).
@@ -3174,6 +3544,45 @@ void PeerManagerImpl::ProcessBlock(CNode& node, const std::shared_ptr<const CBlo
     }
 }
 
+void PeerManagerImpl::ProcessBlockMessage(Peer& peer, CDataStream& vRecv)
+{
+    std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+    const size_t block_size{vRecv.size()};
+    vRecv >> *pblock;
+
+    LogPrint(BCLog::NET, "received block %s peer=%d\n", pblock->GetHash().ToString(), peer.m_id);
+
+    bool forceProcessing = false;
+    const uint256 hash(pblock->GetHash());
+    bool min_pow_checked = false;
+    {
+        LOCK(cs_main);
+        // Always process the block if we requested it, since we may
+        // need it even when it's not a candidate for a new best tip.
+        forceProcessing = IsBlockRequested(hash);
+        RemoveBlockRequest(hash, peer.m_id, block_size);
+        // mapBlockSource is only used for punishing peers and setting
+        // which peers send us compact blocks, so the race between here and
+        // cs_main in ProcessNewBlock is fine.
+        mapBlockSource.emplace(hash, std::make_pair(peer.m_id, true));
+
+        // Check work on this block against our anti-dos thresholds.
+        const CBlockIndex* prev_block = m_chainman.m_blockman.LookupBlockIndex(pblock->hashPrevBlock);
+        if (prev_block && prev_block->nChainWork + CalculateHeadersWork({pblock->GetBlockHeader()}) >= GetAntiDoSWorkThreshold()) {
+            min_pow_checked = true;
+        }
+    }
+
+    // Do the checks that are context-free (merkle root, transactions, block signature)
+    // outside of cs_main, before anything else can see the block to race on
+    // CBlock::fChecked. ProcessNewBlock() skips them once passed, and repeats
+    // them to report the block if they failed.
+    BlockValidationState state;
+    CheckBlock(*pblock, state, m_chainparams.GetConsensus());
+
+    ProcessBlock(peer.m_id, pblock, forceProcessing, min_pow_checked);
+}
+
 void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDataStream& vRecv,
                                      const std::chrono::microseconds time_received,
                                      const std::atomic<bool>& interruptMsgProc)
@@ -3434,6 +3843,11 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::SENDCMPCT, /*high_bandwidth=*/false, /*version=*/CMPCTBLOCKS_VERSION));
         }
 
+        if (m_compressed_headers) {
+            // Peers not knowing the message ignore it, and keep receiving "headers"
+            m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::SENDCHEADERS, COMPRESSED_HEADERS_VERSION));
+        }
+
         if (m_txreconciliation) {
             if (!peer->m_wtxid_relay || !m_txreconciliation->IsPeerRegistered(pfrom.GetId())) {
                 // We could have optimistically pre-registered/registered the peer. In that case,
@@ -3466,6 +3880,16 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         return;
     }
 
+    if (msg_type == NetMsgType::SENDCHEADERS) {
+        uint64_t version{0};
+        vRecv >> version;
+        // Only the encoding we know, a later one would be announced by a later version
+        if (m_compressed_headers && version == COMPRESSED_HEADERS_VERSION) {
+            peer->m_wants_cheaders = true;
+        }
+        return;
+    }
+
     if (msg_type == NetMsgType::SENDCMPCT) {
         bool sendcmpct_hb{false};
         uint64_t sendcmpct_version{0};
@@ -3621,7 +4045,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         const bool rate_limited = !pfrom.HasPermission(NetPermissionFlags::Addr);
         uint64_t num_proc = 0;
         uint64_t num_rate_limit = 0;
-        Shuffle(vAddr.begin(), vAddr.end(), FastRandomContext());
+        Shuffle(vAddr.begin(), vAddr.end(), GetThreadRandomContext());
         for (CAddress& addr : vAddr)
         {
             if (interruptMsgProc)
@@ -3750,7 +4174,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             // use if we turned on sync with all peers).
             CNodeState& state{*Assert(State(pfrom.GetId()))};
             if (state.fSyncStarted || (!peer->m_inv_triggered_getheaders_before_sync && *best_block != m_last_block_inv_triggering_headers_sync)) {
-                if (MaybeSendGetHeaders(pfrom, GetLocator(m_chainman.m_best_header), *peer)) {
+                if (MaybeSendGetHeaders(pfrom, m_chainman.ActiveChain().GetLocator(m_chainman.m_best_header), *peer)) {
                     LogPrint(BCLog::NET, "getheaders (%d) %s to peer=%d\n",
                             m_chainman.m_best_header->nHeight, best_block->ToString(),
                             pfrom.GetId());
@@ -3937,7 +4361,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             LogPrint(BCLog::NET, "Ignoring getheaders from peer=%d because active chain has too little work; sending empty response\n", pfrom.GetId());
             // Just respond with an empty headers message, to tell the peer to
             // go away but not treat us as unresponsive.
-            m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::HEADERS, std::vector<CBlock>()));
+            PushHeaders(pfrom, *peer, {});
             return;
         }
 
@@ -3987,11 +4411,13 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         // will re-announce the new block via headers (or compact blocks again)
         // in the SendMessages logic.
         nodestate->pindexBestHeaderSent = pindex ? pindex : m_chainman.ActiveChain().Tip();
-        m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::HEADERS, vHeaders));
+        PushHeaders(pfrom, *peer, vHeaders);
         return;
     }
 
     if (msg_type == NetMsgType::TX) {
+        CTransactionRef ptx{WITH_LOCK(peer->m_deserialized_tx_mutex, return std::move(peer->m_deserialized_tx))};
+
         if (RejectIncomingTxs(pfrom)) {
             LogPrint(BCLog::NET, "transaction sent in violation of protocol peer=%d\n", pfrom.GetId());
             pfrom.fDisconnect = true;
@@ -4003,8 +4429,21 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         // is not considered a protocol violation, so don't punish the peer.
         if (m_chainman.ActiveChainstate().IsInitialBlockDownload()) return;
 
-        CTransactionRef ptx;
-        vRecv >> ptx;
+        if (!ptx && vRecv.size() >= MIN_WORKER_TX_SIZE) {
+            // Leave deserializing and hashing a large transaction to a message worker,
+            // picking it up again before the next message of this peer.
+            auto data{std::make_shared<CDataStream>(std::move(vRecv))};
+            if (QueueMessageWork(peer, /*node=*/nullptr, [peer, data] {
+                    CTransactionRef tx;
+                    *data >> tx;
+                    LOCK(peer->m_deserialized_tx_mutex);
+                    peer->m_deserialized_tx = std::move(tx);
+                })) {
+                return;
+            }
+            *data >> ptx;
+        }
+        if (!ptx) vRecv >> ptx;
         const CTransaction& tx = *ptx;
 
         const uint256& txid = ptx->GetHash();
@@ -4119,7 +4558,8 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
                 // DoS prevention: do not allow m_orphanage to grow unbounded (see CVE-2012-3789)
                 unsigned int nMaxOrphanTx = (unsigned int)std::max((int64_t)0, gArgs.GetIntArg("-maxorphantx", DEFAULT_MAX_ORPHAN_TRANSACTIONS));
-                m_orphanage.LimitOrphans(nMaxOrphanTx);
+                unsigned int nMaxOrphanChainTx = (unsigned int)std::max((int64_t)0, gArgs.GetIntArg("-maxorphanchaintx", DEFAULT_MAX_ORPHAN_CHAIN_TRANSACTIONS));
+                m_orphanage.LimitOrphans(nMaxOrphanTx, nMaxOrphanChainTx);
             } else {
                 LogPrint(BCLog::MEMPOOL, "not keeping orphan with rejected parents %s\n",tx.GetHash().ToString());
                 // We will continue to reject this tx since it has rejected
@@ -4215,7 +4655,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         if (!prev_block) {
             // Doesn't connect (or is genesis), instead of DoSing in AcceptBlockHeader, request deeper headers
             if (!m_chainman.ActiveChainstate().IsInitialBlockDownload()) {
-                MaybeSendGetHeaders(pfrom, GetLocator(m_chainman.m_best_header), *peer);
+                MaybeSendGetHeaders(pfrom, m_chainman.ActiveChain().GetLocator(m_chainman.m_best_header), *peer);
             }
             return;
         } else if (prev_block->nChainWork + CalculateHeadersWork({cmpctblock.header}) < GetAntiDoSWorkThreshold()) {
@@ -4320,6 +4760,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                     return;
                 } else if (status == READ_STATUS_FAILED) {
                     // Duplicate txindexes, the block is now in-flight, so just request it
+                    ++peer->m_cmpctblocks_failed;
                     std::vector<CInv> vInv(1);
                     vInv[0] = CInv(MSG_BLOCK | GetFetchFlags(*peer), blockhash);
                     m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::GETDATA, vInv));
@@ -4357,6 +4798,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 status = tempBlock.FillBlock(*pblock, dummy);
                 if (status == READ_STATUS_OK) {
                     fBlockReconstructed = true;
+                    ++peer->m_cmpctblocks_reconstructed;
                 }
             }
         } else {
@@ -4403,7 +4845,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             // we have a chain with at least the minimum chain work), and we ignore
             // compact blocks with less work than our tip, it is safe to treat
             // reconstructed compact blocks as having been requested.
-            ProcessBlock(pfrom, pblock, /*force_processing=*/true, /*min_pow_checked=*/true);
+            ProcessBlock(pfrom.GetId(), pblock, /*force_processing=*/true, /*min_pow_checked=*/true);
             LOCK(cs_main); // hold cs_main for CBlockIndex::IsValid()
             if (pindex->IsValid(BLOCK_VALID_TRANSACTIONS)) {
                 // Clear download state for this block, which is in
@@ -4447,6 +4889,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 return;
             } else if (status == READ_STATUS_FAILED) {
                 // Might have collided, fall back to getdata now :(
+                ++peer->m_cmpctblocks_failed;
                 std::vector<CInv> invs;
                 invs.push_back(CInv(MSG_BLOCK | GetFetchFlags(*peer), resp.blockhash));
                 m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::GETDATA, invs));
@@ -4470,6 +4913,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 // updated, etc.
                 RemoveBlockRequest(resp.blockhash, pfrom.GetId()); // it is now an empty pointer
                 fBlockRead = true;
+                ++(resp.txn.empty() ? peer->m_cmpctblocks_reconstructed : peer->m_cmpctblocks_txn_requested);
                 // mapBlockSource is used for potentially punishing peers and
                 // updating which peers send us compact blocks, so the race
                 // between here and cs_main in ProcessNewBlock is fine.
@@ -4486,12 +4930,12 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             // disk-space attacks), but this should be safe due to the
             // protections in the compact block handler -- see related comment
             // in compact block optimistic reconstruction handling.
-            ProcessBlock(pfrom, pblock, /*force_processing=*/true, /*min_pow_checked=*/true);
+            ProcessBlock(pfrom.GetId(), pblock, /*force_processing=*/true, /*min_pow_checked=*/true);
         }
         return;
     }
 
-    if (msg_type == NetMsgType::HEADERS)
+    if (msg_type == NetMsgType::HEADERS || msg_type == NetMsgType::CHEADERS)
     {
         // Ignore headers received while importing
         if (m_chainman.m_blockman.LoadingBlocks()) {
@@ -4505,16 +4949,26 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
         std::vector<CBlockHeader> headers;
 
-        // Bypass the normal CBlock deserialization, as we don't want to risk deserializing 2000 full blocks.
-        unsigned int nCount = ReadCompactSize(vRecv);
-        if (nCount > MAX_HEADERS_RESULTS) {
-            Misbehaving(*peer, 20, strprintf("headers message size = %u", nCount));
-            return;
-        }
-        headers.resize(nCount);
-        for (unsigned int n = 0; n < nCount; n++) {
-            vRecv >> headers[n];
-            ReadCompactSize(vRecv); // ignore tx count; assume it is 0.
+        if (msg_type == NetMsgType::CHEADERS) {
+            CompressedHeaders compressed;
+            vRecv >> compressed;
+            if (compressed.headers.size() > MAX_HEADERS_RESULTS) {
+                Misbehaving(*peer, 20, strprintf("cheaders message size = %u", compressed.headers.size()));
+                return;
+            }
+            headers = std::move(compressed.headers);
+        } else {
+            // Bypass the normal CBlock deserialization, as we don't want to risk deserializing 2000 full blocks.
+            unsigned int nCount = ReadCompactSize(vRecv);
+            if (nCount > MAX_HEADERS_RESULTS) {
+                Misbehaving(*peer, 20, strprintf("headers message size = %u", nCount));
+                return;
+            }
+            headers.resize(nCount);
+            for (unsigned int n = 0; n < nCount; n++) {
+                vRecv >> headers[n];
+                ReadCompactSize(vRecv); // ignore tx count; assume it is 0.
+            }
         }
 
         ProcessHeadersMessage(pfrom, *peer, std::move(headers), /*via_compact_block=*/false);
@@ -4544,32 +4998,12 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             return;
         }
 
-        std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-        vRecv >> *pblock;
-
-        LogPrint(BCLog::NET, "received block %s peer=%d\n", pblock->GetHash().ToString(), pfrom.GetId());
-
-        bool forceProcessing = false;
-        const uint256 hash(pblock->GetHash());
-        bool min_pow_checked = false;
-        {
-            LOCK(cs_main);
-            // Always process the block if we requested it, since we may
-            // need it even when it's not a candidate for a new best tip.
-            forceProcessing = IsBlockRequested(hash);
-            RemoveBlockRequest(hash, pfrom.GetId());
-            // mapBlockSource is only used for punishing peers and setting
-            // which peers send us compact blocks, so the race between here and
-            // cs_main in ProcessNewBlock is fine.
-            mapBlockSource.emplace(hash, std::make_pair(pfrom.GetId(), true));
-
-            // Check work on this block against our anti-dos thresholds.
-            const CBlockIndex* prev_block = m_chainman.m_blockman.LookupBlockIndex(pblock->hashPrevBlock);
-            if (prev_block && prev_block->nChainWork + CalculateHeadersWork({pblock->GetBlockHeader()}) >= GetAntiDoSWorkThreshold()) {
-                min_pow_checked = true;
-            }
+        // Leave deserializing and checking the block to a message worker, holding
+        // back the later messages of this peer only until it has been processed.
+        auto data{std::make_shared<CDataStream>(std::move(vRecv))};
+        if (!QueueMessageWork(peer, /*node=*/nullptr, [this, peer, data] { ProcessBlockMessage(*peer, *data); })) {
+            ProcessBlockMessage(*peer, *data);
         }
-        ProcessBlock(pfrom, pblock, forceProcessing, min_pow_checked);
         return;
     }
 
@@ -4603,7 +5037,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         } else {
             vAddr = m_connman.GetAddresses(pfrom, MAX_ADDR_TO_SEND, MAX_PCT_ADDR_TO_SEND);
         }
-        FastRandomContext insecure_rand;
+        FastRandomContext& insecure_rand{GetThreadRandomContext()};
         for (const CAddress &addr : vAddr) {
             PushAddress(*peer, addr, insecure_rand);
         }
@@ -4797,6 +5231,20 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         return;
     }
 
+    if (msg_type == NetMsgType::GETASSETCHUNKS) {
+        ProcessGetAssetChunks(pfrom, *peer, vRecv);
+        return;
+    }
+
+    if (msg_type == NetMsgType::ASSETCHUNKS) {
+        AssetChunks answer;
+        vRecv >> answer;
+        if (!g_asset_chunk_fetcher || !g_asset_chunk_fetcher->ProcessAnswer(pfrom.GetId(), std::move(answer))) {
+            LogPrint(BCLog::NET, "Ignoring unrequested assetchunks from peer=%d\n", pfrom.GetId());
+        }
+        return;
+    }
+
     if (msg_type == NetMsgType::GETCFILTERS) {
         ProcessGetCFilters(pfrom, *peer, vRecv);
         return;
@@ -4812,6 +5260,66 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         return;
     }
 
+    // Received from a peer we respond to reconciliations, requesting a sketch of our set.
+    if (msg_type == NetMsgType::REQRECON) {
+        if (!m_txreconciliation) {
+            LogPrintLevel(BCLog::NET, BCLog::Level::Debug, "reqrecon from peer=%d ignored, as our node does not have txreconciliation enabled\n", pfrom.GetId());
+            return;
+        }
+        uint16_t peer_recon_set_size, peer_q;
+        vRecv >> peer_recon_set_size >> peer_q;
+        if (!m_txreconciliation->HandleReconciliationRequest(pfrom.GetId(), peer_recon_set_size, peer_q)) {
+            LogPrintLevel(BCLog::NET, BCLog::Level::Debug, "txreconciliation protocol violation from peer=%d (unexpected reqrecon); disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+        }
+        return;
+    }
+
+    // Received from a peer we requested a reconciliation from, sketching its set.
+    if (msg_type == NetMsgType::SKETCH) {
+        if (!m_txreconciliation) {
+            LogPrintLevel(BCLog::NET, BCLog::Level::Debug, "sketch from peer=%d ignored, as our node does not have txreconciliation enabled\n", pfrom.GetId());
+            return;
+        }
+        std::vector<uint8_t> skdata;
+        vRecv >> skdata;
+        std::vector<uint32_t> txs_to_request;
+        std::vector<uint256> txs_to_announce;
+        const std::optional<bool> recon_succeeded{m_txreconciliation->HandleSketch(pfrom.GetId(), skdata, txs_to_request, txs_to_announce)};
+        if (!recon_succeeded) {
+            LogPrintLevel(BCLog::NET, BCLog::Level::Debug, "txreconciliation protocol violation from peer=%d (unexpected or oversized sketch); disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+        ++peer->m_recon_rounds;
+        if (!*recon_succeeded) ++peer->m_recon_failed;
+        // On failure the peer announces its whole set too, as we do ours
+        m_connman.PushMessage(&pfrom, CNetMsgMaker(pfrom.GetCommonVersion()).Make(NetMsgType::RECONCILDIFF, uint8_t{*recon_succeeded}, txs_to_request));
+        AnnounceReconciledTxs(pfrom, *peer, txs_to_announce);
+        return;
+    }
+
+    // Received from a peer we sent a sketch, telling the transactions it found it misses.
+    if (msg_type == NetMsgType::RECONCILDIFF) {
+        if (!m_txreconciliation) {
+            LogPrintLevel(BCLog::NET, BCLog::Level::Debug, "reconcildiff from peer=%d ignored, as our node does not have txreconciliation enabled\n", pfrom.GetId());
+            return;
+        }
+        uint8_t recon_succeeded;
+        std::vector<uint32_t> ask_shortids;
+        vRecv >> recon_succeeded >> ask_shortids;
+        std::vector<uint256> txs_to_announce;
+        if (!m_txreconciliation->HandleReconciliationDifference(pfrom.GetId(), recon_succeeded != 0, ask_shortids, txs_to_announce)) {
+            LogPrintLevel(BCLog::NET, BCLog::Level::Debug, "txreconciliation protocol violation from peer=%d (unexpected reconcildiff); disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+        ++peer->m_recon_rounds;
+        if (!recon_succeeded) ++peer->m_recon_failed;
+        AnnounceReconciledTxs(pfrom, *peer, txs_to_announce);
+        return;
+    }
+
     if (msg_type == NetMsgType::NOTFOUND) {
         std::vector<CInv> vInv;
         vRecv >> vInv;
@@ -4879,6 +5387,20 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     PeerRef peer = GetPeerRef(pfrom->GetId());
     if (peer == nullptr) return false;
 
+    // Keep to the order of the messages while one of the peer is with a message worker
+    if (peer->m_message_offloaded) return false;
+
+    // A transaction deserialized by a message worker goes before the next message
+    if (WITH_LOCK(peer->m_deserialized_tx_mutex, return peer->m_deserialized_tx != nullptr)) {
+        CDataStream empty{SER_NETWORK, pfrom->GetCommonVersion()};
+        try {
+            ProcessMessage(*pfrom, NetMsgType::TX, empty, GetTime<std::chrono::microseconds>(), interruptMsgProc);
+        } catch (const std::exception& e) {
+            LogPrint(BCLog::NET, "%s(%s): Exception '%s' (%s) caught\n", __func__, NetMsgType::TX, e.what(), typeid(e).name());
+        }
+        return true;
+    }
+
     {
         LOCK(peer->m_getdata_requests_mutex);
         if (!peer->m_getdata_requests.empty()) {
@@ -4928,7 +5450,24 @@ bool PeerManagerImpl::ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt
     msg.SetVersion(pfrom->GetCommonVersion());
 
     try {
-        ProcessMessage(*pfrom, msg.m_type, msg.m_recv, msg.m_time, interruptMsgProc);
+        MsgProcessingTime processing_time;
+        {
+            LockWaitAccount cs_main_wait{cs_main};
+            const auto handler_start{SteadyClock::now()};
+            ProcessMessage(*pfrom, msg.m_type, msg.m_recv, msg.m_time, interruptMsgProc);
+            processing_time.handler = std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - handler_start);
+            processing_time.cs_main_wait = cs_main_wait.Waited();
+        }
+        processing_time.count = 1;
+        processing_time.deserialize = msg.m_deserialize_time;
+        TRACE5(net, processed_message,
+            pfrom->GetId(),
+            msg.m_type.c_str(),
+            count_microseconds(processing_time.deserialize),
+            count_microseconds(processing_time.handler),
+            count_microseconds(processing_time.cs_main_wait)
+        );
+        m_connman.RecordMsgProcessingTime(*pfrom, msg.m_type, processing_time);
         if (interruptMsgProc) return false;
         {
             LOCK(peer->m_getdata_requests_mutex);
@@ -4991,7 +5530,7 @@ void PeerManagerImpl::ConsiderEviction(CNode& pto, Peer& peer, std::chrono::seco
                 // getheaders in-flight already, in which case the peer should
                 // still respond to us with a sufficiently high work chain tip.
                 MaybeSendGetHeaders(pto,
-                        GetLocator(state.m_chain_sync.m_work_header->pprev),
+                        m_chainman.ActiveChain().GetLocator(state.m_chain_sync.m_work_header->pprev),
                         peer);
                 LogPrint(BCLog::NET, "sending getheaders to outbound peer=%d to verify chain work (current best known block:%s, benchmark blockhash: %s)\n", pto.GetId(), state.pindexBestKnownBlock != nullptr ? state.pindexBestKnownBlock->GetBlockHash().ToString() : "<none>", state.m_chain_sync.m_work_header->GetBlockHash().ToString());
                 state.m_chain_sync.m_sent_getheaders = true;
@@ -5219,7 +5758,7 @@ void PeerManagerImpl::MaybeSendAddr(CNode& node, Peer& peer, std::chrono::micros
         }
         if (std::optional<CService> local_service = GetLocalAddrForPeer(node)) {
             CAddress local_addr{*local_service, peer.m_our_services, Now<NodeSeconds>()};
-            FastRandomContext insecure_rand;
+            FastRandomContext& insecure_rand{GetThreadRandomContext()};
             PushAddress(peer, local_addr, insecure_rand);
         }
         peer.m_next_local_addr_send = GetExponentialRand(current_time, AVG_LOCAL_ADDRESS_BROADCAST_INTERVAL);
@@ -5459,7 +5998,7 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                    got back an empty response.  */
                 if (pindexStart->pprev)
                     pindexStart = pindexStart->pprev;
-                if (MaybeSendGetHeaders(*pto, GetLocator(pindexStart), *peer)) {
+                if (MaybeSendGetHeaders(*pto, m_chainman.ActiveChain().GetLocator(pindexStart), *peer)) {
                     LogPrint(BCLog::NET, "initial getheaders (%d) to peer=%d (startheight:%d)\n", pindexStart->nHeight, pto->GetId(), peer->m_starting_height);
 
                     state.fSyncStarted = true;
@@ -5561,8 +6100,7 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                         CBlock block;
                         bool ret = ReadBlockFromDisk(block, pBestIndex, consensusParams);
                         assert(ret);
-                        CBlockHeaderAndShortTxIDs cmpctblock{block};
-                        m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::CMPCTBLOCK, cmpctblock));
+                        m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::CMPCTBLOCK, MakeCompactBlock(block, /*check_mempool=*/false)));
                     }
                     state.pindexBestHeaderSent = pBestIndex;
                 } else if (peer->m_prefers_headers) {
@@ -5575,7 +6113,7 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                         LogPrint(BCLog::NET, "%s: sending header %s to peer=%d\n", __func__,
                                 vHeaders.front().GetHash().ToString(), pto->GetId());
                     }
-                    m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::HEADERS, vHeaders));
+                    PushHeaders(*pto, *peer, vHeaders);
                     state.pindexBestHeaderSent = pBestIndex;
                 } else
                     fRevertToInv = true;
@@ -5720,10 +6258,16 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                             continue;
                         }
                         if (tx_relay->m_bloom_filter && !tx_relay->m_bloom_filter->IsRelevantAndUpdate(*txinfo.tx)) continue;
-                        // Send
+                        // Send, or leave it to the next reconciliation with a peer reconciling
                         tx_relay->m_recently_announced_invs.insert(hash);
-                        vInv.push_back(inv);
-                        nRelayedTransactions++;
+                        if (m_txreconciliation && !m_txreconciliation->ShouldFanoutTo(pto->GetId(), wtxid) &&
+                            m_txreconciliation->AddToSet(pto->GetId(), wtxid)) {
+                            ++peer->m_txs_reconciled;
+                        } else {
+                            vInv.push_back(inv);
+                            nRelayedTransactions++;
+                            ++peer->m_txs_flooded;
+                        }
                         {
                             // Expire old relay messages
                             while (!g_relay_expiration.empty() && g_relay_expiration.front().first < current_time)
@@ -5756,6 +6300,21 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                             tx_relay->m_tx_inventory_known_filter.insert(txid);
                         }
                     }
+
+                    // Answer a reconciliation the peer requested along with our announcements,
+                    // so that the timing of the sketch tells no more than they do
+                    if (m_txreconciliation) {
+                        if (const auto skdata{m_txreconciliation->RespondToReconciliationRequest(pto->GetId())}) {
+                            m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::SKETCH, *skdata));
+                        }
+                    }
+                }
+
+                if (m_txreconciliation) {
+                    if (const auto request{m_txreconciliation->InitiateReconciliationRequest(pto->GetId(), current_time)}) {
+                        const auto [recon_set_size, q]{*request};
+                        m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::REQRECON, recon_set_size, q));
+                    }
                 }
         }
         if (!vInv.empty())
@@ -5832,10 +6391,11 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
         // Message: getdata (blocks)
         //
         std::vector<CInv> vGetData;
-        if (CanServeBlocks(*peer) && ((sync_blocks_and_headers_from_peer && !IsLimitedPeer(*peer)) || !m_chainman.ActiveChainstate().IsInitialBlockDownload()) && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        UpdateBlocksInTransitTarget(state, pto->m_min_ping_time);
+        if (CanServeBlocks(*peer) && ((sync_blocks_and_headers_from_peer && !IsLimitedPeer(*peer)) || !m_chainman.ActiveChainstate().IsInitialBlockDownload()) && state.nBlocksInFlight < state.m_blocks_in_transit_target) {
             std::vector<const CBlockIndex*> vToDownload;
             NodeId staller = -1;
-            FindNextBlocksToDownload(*peer, MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller);
+            FindNextBlocksToDownload(*peer, state.m_blocks_in_transit_target - state.nBlocksInFlight, vToDownload, staller);
             for (const CBlockIndex *pindex : vToDownload) {
                 uint32_t nFetchFlags = GetFetchFlags(*peer);
                 vGetData.push_back(CInv(MSG_BLOCK | nFetchFlags, pindex->GetBlockHash()));
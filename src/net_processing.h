@@ -10,14 +10,24 @@
 #include <validationinterface.h>
 
 class AddrMan;
+struct AssetChunksRequest;
 class CChainParams;
 class CTxMemPool;
 class ChainstateManager;
 
 /** Default for -maxorphantx, maximum number of orphan transactions kept in memory */
 static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
+/** Default for -maxorphanchaintx, orphan transactions spending other orphans kept beyond -maxorphantx */
+static const unsigned int DEFAULT_MAX_ORPHAN_CHAIN_TRANSACTIONS = 400;
 /** Default number of orphan+recently-replaced txn to keep around for block reconstruction */
 static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 100;
+/** Default for -messageworkers, threads the per-peer work on received messages not needing cs_main is done on */
+static const int DEFAULT_MESSAGE_WORKERS{2};
+static const int MAX_MESSAGE_WORKERS{16};
+/** Default for -cmpctblockprefill, bytes of the transactions peers are likely missing to send along in compact blocks */
+static const int64_t DEFAULT_CMPCTBLOCK_PREFILL_BYTES{200000};
+/** Default for -compressedheaders, exchanging headers as "cheaders" with the peers that support it */
+static const bool DEFAULT_COMPRESSED_HEADERS{true};
 static const bool DEFAULT_PEERBLOOMFILTERS = false;
 static const bool DEFAULT_PEERBLOCKFILTERS = false;
 /** Threshold for marking a node to be discouraged, e.g. disconnected and added to the discouragement filter. */
@@ -33,6 +43,14 @@ struct CNodeStateStats {
     CAmount m_fee_filter_received;
     uint64_t m_addr_processed = 0;
     uint64_t m_addr_rate_limited = 0;
+    uint64_t m_cmpctblocks_reconstructed = 0;
+    uint64_t m_cmpctblocks_txn_requested = 0;
+    uint64_t m_cmpctblocks_failed = 0;
+    uint64_t m_txs_flooded = 0;
+    uint64_t m_txs_reconciled = 0;
+    uint64_t m_recon_txs_announced = 0;
+    uint64_t m_recon_rounds = 0;
+    uint64_t m_recon_failed = 0;
     bool m_addr_relay_enabled{false};
     ServiceFlags their_services;
     int64_t presync_height{-1};
@@ -55,9 +73,22 @@ public:
      */
     virtual std::optional<std::string> FetchBlock(NodeId peer_id, const CBlockIndex& block_index) = 0;
 
+    /** Peers fully connected that advertise NODE_STORAGE, to fetch the chunks of stored assets from */
+    virtual std::vector<NodeId> GetStoragePeers() = 0;
+
+    /**
+     * Ask a peer for chunks of a stored asset, answered through g_asset_chunk_fetcher.
+     *
+     * @returns false if the peer is not fully connected or does not advertise NODE_STORAGE
+     */
+    virtual bool RequestAssetChunks(NodeId peer_id, const AssetChunksRequest& request) = 0;
+
     /** Begin running background tasks, should only be called once */
     virtual void StartScheduledTasks(CScheduler& scheduler) = 0;
 
+    /** Finish the work queued for the message workers and do any received afterwards on the message handler */
+    virtual void StopMessageWorkers() = 0;
+
     /** Get statistics from node state */
     virtual bool GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats) const = 0;
 
@@ -25,6 +25,8 @@ std::optional<bilingual_str> ApplyArgsManOptions(const ArgsManager& args, BlockM
     }
     opts.prune_target = nPruneTarget;
 
+    opts.compress_blocks = args.GetBoolArg("-blockcompression", opts.compress_blocks);
+
     return std::nullopt;
 }
 } // namespace node
@@ -0,0 +1,186 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockreader.h>
+
+#include <chain.h>
+#include <clientversion.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <streams.h>
+#include <sync.h>
+#include <util/system.h>
+#include <util/threadnames.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <thread>
+
+namespace node {
+namespace {
+/** State shared between the reader threads and the consumer. */
+template <typename Block>
+struct ReadAheadQueue {
+    struct Slot {
+        Block block;
+        bool ready{false};
+        bool ok{false};
+    };
+
+    Mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<Slot> m_slots GUARDED_BY(m_mutex);
+    size_t m_next_read GUARDED_BY(m_mutex){0};
+    size_t m_next_consume GUARDED_BY(m_mutex){0};
+    bool m_stop GUARDED_BY(m_mutex){false};
+
+    explicit ReadAheadQueue(size_t lookahead) : m_slots(lookahead) {}
+};
+
+/**
+ * Read blocks with read(block, index) on the reader threads and hand them to
+ * consume(index, block) in order. The Block objects are swapped between the
+ * threads and slots rather than made afresh, so buffers they hold are reused.
+ */
+template <typename Block, typename ReadFn, typename ConsumeFn>
+bool ReadInOrder(const std::vector<const CBlockIndex*>& blocks, const ReadFn& read, const ConsumeFn& consume,
+                 int threads, size_t lookahead)
+{
+    threads = std::min<int>(threads, blocks.size());
+    lookahead = std::max<size_t>(lookahead, 1);
+
+    // Not worth spinning up threads, read in line
+    if (threads <= 1) {
+        Block block;
+        for (const CBlockIndex* pindex : blocks) {
+            if (!read(block, *pindex)) {
+                return false;
+            }
+            if (!consume(*pindex, block)) break;
+        }
+        return true;
+    }
+
+    ReadAheadQueue<Block> queue(lookahead);
+
+    auto reader = [&](int n) {
+        util::ThreadRename(strprintf("blockreader.%i", n));
+        Block block;
+        while (true) {
+            size_t i;
+            {
+                WAIT_LOCK(queue.m_mutex, lock);
+                queue.m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(queue.m_mutex) {
+                    return queue.m_stop || queue.m_next_read >= blocks.size() || queue.m_next_read < queue.m_next_consume + lookahead;
+                });
+                if (queue.m_stop || queue.m_next_read >= blocks.size()) return;
+                i = queue.m_next_read++;
+            }
+
+            const bool ok{read(block, *blocks[i])};
+
+            {
+                LOCK(queue.m_mutex);
+                auto& slot{queue.m_slots[i % lookahead]};
+                std::swap(slot.block, block);
+                slot.ok = ok;
+                slot.ready = true;
+            }
+            queue.m_cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (int n = 0; n < threads; n++) {
+        workers.emplace_back(reader, n);
+    }
+
+    bool result{true};
+    Block block;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        bool ok;
+        {
+            WAIT_LOCK(queue.m_mutex, lock);
+            auto& slot{queue.m_slots[i % lookahead]};
+            queue.m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(queue.m_mutex) { return slot.ready; });
+            std::swap(block, slot.block);
+            ok = slot.ok;
+            slot.ready = false;
+            queue.m_next_consume = i + 1;
+        }
+        queue.m_cv.notify_all();
+
+        if (!ok) {
+            LogPrintf("%s: Failed to read block %s from disk\n", __func__, blocks[i]->GetBlockHash().ToString());
+            result = false;
+            break;
+        }
+        if (!consume(*blocks[i], block)) break;
+    }
+
+    {
+        LOCK(queue.m_mutex);
+        queue.m_stop = true;
+    }
+    queue.m_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    return result;
+}
+} // namespace
+
+bool ReadBlocksInOrder(const std::vector<const CBlockIndex*>& blocks, const Consensus::Params& consensus_params,
+                       const BlockConsumer& consumer, int threads, size_t lookahead)
+{
+    return ReadInOrder<CBlock>(
+        blocks,
+        [&](CBlock& block, const CBlockIndex& index) { return ReadBlockFromDisk(block, &index, consensus_params); },
+        consumer, threads, lookahead);
+}
+
+bool ReadBlockViewsInOrder(const std::vector<const CBlockIndex*>& blocks, const CMessageHeader::MessageStartChars& message_start,
+                           const BlockViewConsumer& consumer, int threads, size_t lookahead)
+{
+    // Reused for every block, as the raw block buffers are
+    std::vector<CTransactionView> txs;
+    bool corrupt{false};
+    const bool result{ReadInOrder<std::vector<uint8_t>>(
+        blocks,
+        [&](std::vector<uint8_t>& block, const CBlockIndex& index) {
+            const FlatFilePos pos{WITH_LOCK(::cs_main, return index.GetBlockPos())};
+            return ReadRawBlockFromDisk(block, pos, message_start);
+        },
+        [&](const CBlockIndex& index, const std::vector<uint8_t>& block) {
+            CBlockHeader header;
+            txs.clear();
+            try {
+                SpanReader stream{SER_DISK, CLIENT_VERSION, block};
+                stream >> header;
+                const uint64_t tx_count{ReadCompactSize(stream)};
+                Span<const unsigned char> data{block};
+                data = data.last(stream.size());
+                for (uint64_t i = 0; i < tx_count; ++i) {
+                    txs.emplace_back(data);
+                }
+            } catch (const std::ios_base::failure& e) {
+                LogPrintf("%s: Failed to read block %s: %s\n", __func__, index.GetBlockHash().ToString(), e.what());
+                corrupt = true;
+                return false;
+            }
+            if (header.GetHash() != index.GetBlockHash()) {
+                LogPrintf("%s: Block read for %s does not match its index\n", __func__, index.GetBlockHash().ToString());
+                corrupt = true;
+                return false;
+            }
+            return consumer(index, header, txs);
+        },
+        threads, lookahead)};
+    return result && !corrupt;
+}
+} // namespace node
@@ -0,0 +1,57 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKREADER_H
+#define BITCOIN_NODE_BLOCKREADER_H
+
+#include <protocol.h>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class CBlock;
+class CBlockHeader;
+class CBlockIndex;
+class CTransactionView;
+namespace Consensus {
+struct Params;
+}
+
+namespace node {
+//! Default number of threads reading blocks ahead of the consumer
+static constexpr int DEFAULT_BLOCKREADER_THREADS{4};
+//! Default number of blocks that may be read ahead of the consumer
+static constexpr size_t DEFAULT_BLOCKREADER_LOOKAHEAD{32};
+
+//! Called once per block, in the order given. Return false to stop reading.
+using BlockConsumer = std::function<bool(const CBlockIndex& index, const CBlock& block)>;
+//! As BlockConsumer, with the block's header and a view of each of its transactions
+using BlockViewConsumer = std::function<bool(const CBlockIndex& index, const CBlockHeader& header, const std::vector<CTransactionView>& txs)>;
+
+/**
+ * Read the given blocks from disk and hand them to the consumer in the order
+ * given. Reading and deserializing happens on a small pool of threads that
+ * stays up to lookahead blocks ahead of the consumer, so chain scans are not
+ * bound by serial block I/O.
+ *
+ * Returns false if a block could not be read. Stopping early from the
+ * consumer is not an error.
+ */
+bool ReadBlocksInOrder(const std::vector<const CBlockIndex*>& blocks, const Consensus::Params& consensus_params,
+                       const BlockConsumer& consumer, int threads = DEFAULT_BLOCKREADER_THREADS,
+                       size_t lookahead = DEFAULT_BLOCKREADER_LOOKAHEAD);
+
+/**
+ * As ReadBlocksInOrder, for scans that only look at transaction outputs: the
+ * blocks are read raw and their transactions handed over as CTransactionViews
+ * into the raw block, without deserializing them. Read buffers are reused, so
+ * a scan allocates nothing per transaction or output.
+ */
+bool ReadBlockViewsInOrder(const std::vector<const CBlockIndex*>& blocks, const CMessageHeader::MessageStartChars& message_start,
+                           const BlockViewConsumer& consumer, int threads = DEFAULT_BLOCKREADER_THREADS,
+                           size_t lookahead = DEFAULT_BLOCKREADER_LOOKAHEAD);
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKREADER_H
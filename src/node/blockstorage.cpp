@@ -7,10 +7,13 @@
 #include <chain.h>
 #include <clientversion.h>
 #include <consensus/validation.h>
+#include <core_memusage.h>
+#include <crypto/common.h>
 #include <flatfile.h>
 #include <hash.h>
 #include <logging.h>
 #include <kernel/chainparams.h>
+#include <opfile/src/compress.h>
 #include <pow.h>
 #include <reverse_iterator.h>
 #include <shutdown.h>
@@ -22,11 +25,151 @@
 #include <util/system.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <deque>
+#include <future>
 #include <map>
+#include <optional>
 #include <unordered_map>
 
 namespace node {
 std::atomic_bool fReindex(false);
+std::atomic_bool g_check_stored_pow{DEFAULT_CHECK_STORED_POW};
+std::atomic<uint64_t> g_stored_pow_skipped{0};
+FlatFileMapCache g_block_file_maps{DEFAULT_BLOCK_FILE_MAPS};
+BlockCache g_block_cache{DEFAULT_BLOCK_CACHE_SIZE << 20};
+DecompressedBlockCache g_decompressed_blocks{DECOMPRESSED_BLOCK_CACHE_SIZE};
+
+std::shared_ptr<const CBlock> BlockCache::Get(const uint256& hash)
+{
+    LOCK(m_mutex);
+    const auto it{m_by_hash.find(hash)};
+    if (it == m_by_hash.end()) {
+        ++m_misses;
+        return nullptr;
+    }
+    ++m_hits;
+    m_blocks.splice(m_blocks.begin(), m_blocks, it->second.first);
+    return *it->second.first;
+}
+
+void BlockCache::Offer(const uint256& hash, const CBlock& block)
+{
+    LOCK(m_mutex);
+    if (m_max_bytes == 0 || m_by_hash.count(hash)) return;
+    if (!m_missed_set.count(hash)) {
+        m_missed.push_back(hash);
+        m_missed_set.insert(hash);
+        if (m_missed.size() > MAX_MISSED) {
+            m_missed_set.erase(m_missed.front());
+            m_missed.pop_front();
+        }
+        return;
+    }
+
+    // The transactions are shared with the block read, the copy is of the references
+    const size_t usage{RecursiveDynamicUsage(block) + sizeof(CBlock)};
+    if (usage > m_max_bytes) return;
+    m_blocks.push_front(std::make_shared<const CBlock>(block));
+    m_by_hash.emplace(hash, std::make_pair(m_blocks.begin(), usage));
+    m_bytes += usage;
+    Trim();
+}
+
+void BlockCache::Trim()
+{
+    while (m_bytes > m_max_bytes) {
+        const auto it{m_by_hash.find(m_blocks.back()->GetHash())};
+        m_bytes -= it->second.second;
+        m_by_hash.erase(it);
+        m_blocks.pop_back();
+    }
+}
+
+void BlockCache::SetMaxBytes(size_t max_bytes)
+{
+    LOCK(m_mutex);
+    m_max_bytes = max_bytes;
+    Trim();
+}
+
+BlockCacheStats BlockCache::GetStats() const
+{
+    LOCK(m_mutex);
+    return {m_hits, m_misses, m_blocks.size(), m_bytes, m_max_bytes};
+}
+
+std::shared_ptr<const std::vector<uint8_t>> DecompressedBlockCache::Get(const FlatFilePos& pos)
+{
+    LOCK(m_mutex);
+    for (auto it = m_blocks.begin(); it != m_blocks.end(); ++it) {
+        if (it->first != pos) continue;
+        m_blocks.splice(m_blocks.begin(), m_blocks, it);
+        return it->second;
+    }
+    return nullptr;
+}
+
+void DecompressedBlockCache::Add(const FlatFilePos& pos, std::shared_ptr<const std::vector<uint8_t>> block)
+{
+    LOCK(m_mutex);
+    if (m_max_blocks == 0) return;
+    m_blocks.remove_if([&](const Entry& entry) { return entry.first == pos; });
+    m_blocks.emplace_front(pos, std::move(block));
+    if (m_blocks.size() > m_max_blocks) m_blocks.pop_back();
+}
+
+void DecompressedBlockCache::EraseFile(int file)
+{
+    LOCK(m_mutex);
+    m_blocks.remove_if([&](const Entry& entry) { return entry.first.nFile == file; });
+}
+
+void CompressBlock(Span<const uint8_t> block, std::vector<uint8_t>& record)
+{
+    record.clear();
+    CVectorWriter writer{SER_DISK, CLIENT_VERSION, record, 0};
+    WriteCompactSize(writer, block.size());
+    std::vector<unsigned char> packed;
+    for (size_t offset = 0; offset < block.size(); offset += COMPRESS_BLOCK) {
+        const Span<const uint8_t> raw{block.subspan(offset, std::min(COMPRESS_BLOCK, block.size() - offset))};
+        packed.clear();
+        compress_block(raw.data(), raw.size(), packed);
+        // Incompressible pieces are kept as they are
+        const Span<const uint8_t> data{packed.size() < raw.size() ? Span<const uint8_t>{packed} : raw};
+        WriteCompactSize(writer, raw.size());
+        WriteCompactSize(writer, data.size());
+        writer.write(AsBytes(data));
+    }
+}
+
+bool DecompressBlock(Span<const uint8_t> record, std::vector<uint8_t>& block)
+{
+    try {
+        SpanReader reader{SER_DISK, CLIENT_VERSION, record};
+        const uint64_t size{ReadCompactSize(reader)};
+        block.resize(size);
+        for (uint64_t done = 0; done < size;) {
+            const uint64_t raw_size{ReadCompactSize(reader)};
+            const uint64_t data_size{ReadCompactSize(reader)};
+            if (raw_size == 0 || raw_size > COMPRESS_BLOCK || data_size > raw_size ||
+                raw_size > size - done || data_size > reader.size()) {
+                return false;
+            }
+            const Span<const uint8_t> data{record.last(reader.size()).first(data_size)};
+            if (data_size == raw_size) {
+                std::copy(data.begin(), data.end(), block.begin() + done);
+            } else if (!decompress_block(data.data(), data_size, block.data() + done, raw_size)) {
+                return false;
+            }
+            reader.ignore(data_size);
+            done += raw_size;
+        }
+        return reader.empty();
+    } catch (const std::ios_base::failure&) {
+        return false;
+    }
+}
 
 bool CBlockIndexWorkComparator::operator()(const CBlockIndex* pa, const CBlockIndex* pb) const
 {
@@ -67,6 +210,13 @@ std::vector<CBlockIndex*> BlockManager::GetAllBlockIndices()
     return rv;
 }
 
+size_t BlockManager::DynamicMemoryUsage() const
+{
+    AssertLockHeld(cs_main);
+    return memusage::DynamicUsage(m_block_index) + memusage::DynamicUsage(m_dirty_blockindex) + memusage::DynamicUsage(m_blocks_unlinked) +
+           memusage::DynamicUsage(m_blockfile_info) + memusage::DynamicUsage(m_dirty_fileinfo);
+}
+
 CBlockIndex* BlockManager::LookupBlockIndex(const uint256& hash)
 {
     AssertLockHeld(cs_main);
@@ -104,6 +254,7 @@ CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block, CBlockInde
         pindexNew->BuildSkip();
     }
     pindexNew->nTimeMax = (pindexNew->pprev ? std::max(pindexNew->pprev->nTimeMax, pindexNew->nTime) : pindexNew->nTime);
+    pindexNew->pindexLastPoS = GetLastPoSBlockIndex(pindexNew);
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + GetBlockProof(*pindexNew);
     pindexNew->RaiseValidity(BLOCK_VALID_TREE);
     if (best_header == nullptr || best_header->nChainWork < pindexNew->nChainWork) {
@@ -267,6 +418,7 @@ bool BlockManager::LoadBlockIndex(const Consensus::Params& consensus_params)
         if (ShutdownRequested()) return false;
         pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
         pindex->nTimeMax = (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime) : pindex->nTime);
+        pindex->pindexLastPoS = GetLastPoSBlockIndex(pindex);
 
         // We can link the chain of blocks for which we've received transactions at some point, or
         // blocks that are assumed-valid on the basis of snapshot load (see
@@ -291,6 +443,11 @@ bool BlockManager::LoadBlockIndex(const Consensus::Params& consensus_params)
         if (pindex->pprev) {
             pindex->BuildSkip();
         }
+        // Only blocks near the top get built on, the difficulty on older ones
+        // is computed when asked for
+        if (!vSortedByHeight.empty() && pindex->nHeight + NEXT_POS_BITS_CACHE_DEPTH > vSortedByHeight.back()->nHeight) {
+            CacheNextWorkRequiredPoS(*pindex, consensus_params);
+        }
     }
 
     return true;
@@ -466,39 +623,31 @@ CBlockFileInfo* BlockManager::GetBlockFileInfo(size_t n)
     return &m_blockfile_info.at(n);
 }
 
-static bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const uint256& hashBlock, const CMessageHeader::MessageStartChars& messageStart)
+//! Append the undo record of a block, whose undo data goes at pos.nPos past its header, to stream
+static void SerializeUndoRecord(DataStream& stream, const CBlockUndo& blockundo, const uint256& hashBlock, const CMessageHeader::MessageStartChars& messageStart)
 {
-    // Open history file to append
-    AutoFile fileout{OpenUndoFile(pos)};
-    if (fileout.IsNull()) {
-        return error("%s: OpenUndoFile failed", __func__);
-    }
-
     // Write index header
     unsigned int nSize = GetSerializeSize(blockundo, CLIENT_VERSION);
-    fileout << messageStart << nSize;
+    stream << messageStart << nSize;
 
     // Write undo data
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0) {
-        return error("%s: ftell failed", __func__);
-    }
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << blockundo;
+    stream << blockundo;
 
     // calculate & write checksum
     HashWriter hasher{};
     hasher << hashBlock;
     hasher << blockundo;
-    fileout << hasher.GetHash();
-
-    return true;
+    stream << hasher.GetHash();
 }
 
 bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
 {
     const FlatFilePos pos{WITH_LOCK(::cs_main, return pindex->GetUndoPos())};
+    return UndoReadFromDisk(blockundo, pos, pindex->pprev->GetBlockHash());
+}
 
+bool UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint256& hash_prev)
+{
     if (pos.IsNull()) {
         return error("%s: no undo data available", __func__);
     }
@@ -513,7 +662,7 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
     uint256 hashChecksum;
     HashVerifier verifier{filein}; // Use HashVerifier as reserializing may lose data, c.f. commit d342424301013ec47dc146a4beb49d5c9319d80a
     try {
-        verifier << pindex->pprev->GetBlockHash();
+        verifier << hash_prev;
         verifier >> blockundo;
         filein >> hashChecksum;
     } catch (const std::exception& e) {
@@ -528,8 +677,28 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
     return true;
 }
 
+bool BlockManager::WritePendingUndo()
+{
+    LOCK(m_pending_undo_mutex);
+    if (m_pending_undo.empty()) return true;
+    AutoFile fileout{OpenUndoFile(m_pending_undo_pos)};
+    if (fileout.IsNull()) {
+        return error("%s: OpenUndoFile failed", __func__);
+    }
+    try {
+        fileout.write(MakeByteSpan(m_pending_undo));
+    } catch (const std::exception& e) {
+        return error("%s: I/O error - %s", __func__, e.what());
+    }
+    m_pending_undo.clear();
+    return true;
+}
+
 void BlockManager::FlushUndoFile(int block_file, bool finalize)
 {
+    if (!WritePendingUndo()) {
+        AbortNode("Writing undo data to disk failed. This is likely the result of an I/O error.");
+    }
     FlatFilePos undo_pos_old(block_file, m_blockfile_info[block_file].nUndoSize);
     if (!UndoFileSeq().Flush(undo_pos_old, finalize)) {
         AbortNode("Flushing undo file to disk failed. This is likely the result of an I/O error.");
@@ -549,6 +718,11 @@ void BlockManager::FlushBlockFile(bool fFinalize, bool finalize_undo)
     }
     assert(static_cast<int>(m_blockfile_info.size()) > m_last_blockfile);
 
+    // The undo records held back may be in an undo file other than the last
+    if (!WritePendingUndo()) {
+        AbortNode("Writing undo data to disk failed. This is likely the result of an I/O error.");
+    }
+
     FlatFilePos block_pos_old(m_last_blockfile, m_blockfile_info[m_last_blockfile].nSize);
     if (!BlockFileSeq().Flush(block_pos_old, fFinalize)) {
         AbortNode("Flushing block file to disk failed. This is likely the result of an I/O error.");
@@ -574,6 +748,8 @@ void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune)
     std::error_code ec;
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         FlatFilePos pos(*it, 0);
+        g_block_file_maps.Erase(BlockFileSeq().FileName(pos));
+        g_decompressed_blocks.EraseFile(*it);
         const bool removed_blockfile{fs::remove(BlockFileSeq().FileName(pos), ec)};
         const bool removed_undofile{fs::remove(UndoFileSeq().FileName(pos), ec)};
         if (removed_blockfile || removed_undofile) {
@@ -685,7 +861,8 @@ bool BlockManager::FindUndoPos(BlockValidationState& state, int nFile, FlatFileP
     return true;
 }
 
-static bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos, const CMessageHeader::MessageStartChars& messageStart)
+/** Write block, or the compressed block record of it if record is not empty */
+static bool WriteBlockToDisk(const CBlock& block, Span<const uint8_t> record, FlatFilePos& pos, const CMessageHeader::MessageStartChars& messageStart)
 {
     // Open history file to append
     CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
@@ -694,7 +871,7 @@ static bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos, const CMessa
     }
 
     // Write index header
-    unsigned int nSize = GetSerializeSize(block, fileout.GetVersion());
+    unsigned int nSize = record.empty() ? GetSerializeSize(block, fileout.GetVersion()) : (record.size() | BLOCK_RECORD_COMPRESSED);
     fileout << messageStart << nSize;
 
     // Write block
@@ -703,7 +880,11 @@ static bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos, const CMessa
         return error("WriteBlockToDisk: ftell failed");
     }
     pos.nPos = (unsigned int)fileOutPos;
-    fileout << block;
+    if (record.empty()) {
+        fileout << block;
+    } else {
+        fileout.write(AsBytes(record));
+    }
 
     return true;
 }
@@ -717,7 +898,21 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValid
         if (!FindUndoPos(state, pindex->nFile, _pos, ::GetSerializeSize(blockundo, CLIENT_VERSION) + 40)) {
             return error("ConnectBlock(): FindUndoPos failed");
         }
-        if (!UndoWriteToDisk(blockundo, _pos, pindex->pprev->GetBlockHash(), chainparams.MessageStart())) {
+        // Hold the record back to be written with those of the next blocks, unless it
+        // doesn't follow them in the undo file
+        const bool follows{WITH_LOCK(m_pending_undo_mutex, return m_pending_undo.empty() ||
+                                     (_pos.nFile == m_pending_undo_pos.nFile && _pos.nPos == m_pending_undo_pos.nPos + m_pending_undo.size()))};
+        if (!follows && !WritePendingUndo()) {
+            return AbortNode(state, "Failed to write undo data");
+        }
+        {
+            LOCK(m_pending_undo_mutex);
+            if (m_pending_undo.empty()) m_pending_undo_pos = _pos;
+            SerializeUndoRecord(m_pending_undo, blockundo, pindex->pprev->GetBlockHash(), chainparams.MessageStart());
+        }
+        // The undo data follows the message start and size of the record
+        _pos.nPos += CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int);
+        if (WITH_LOCK(m_pending_undo_mutex, return m_pending_undo.size()) >= UNDO_BATCH_BYTES && !WritePendingUndo()) {
             return AbortNode(state, "Failed to write undo data");
         }
         // rev files are written in block height order, whereas blk files are written as blocks come in (often out of order)
@@ -738,26 +933,127 @@ bool BlockManager::WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValid
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams)
+/**
+ * Map the block file holding the block at pos, and point block at the block's
+ * bytes in it, which are those of a compressed block record if compressed is
+ * set. Returns nullptr if the file cannot be mapped, or the header before the
+ * block does not fit it or start with message_start if given, for the caller
+ * to read the file instead.
+ */
+static std::shared_ptr<const FlatFileMapping> MapBlock(const FlatFilePos& pos, const CMessageHeader::MessageStartChars* message_start, Span<const uint8_t>& block, bool& compressed)
 {
-    block.SetNull();
+    if (pos.nPos < BLOCK_SERIALIZATION_HEADER_SIZE) return nullptr;
+    const FlatFilePos hpos{pos.nFile, static_cast<unsigned int>(pos.nPos - BLOCK_SERIALIZATION_HEADER_SIZE)};
+    auto mapping{g_block_file_maps.Get(BlockFileSeq(), hpos, BLOCK_SERIALIZATION_HEADER_SIZE)};
+    if (!mapping) return nullptr;
+
+    const Span<const uint8_t> header{UCharCast(mapping->Data().data()) + hpos.nPos, BLOCK_SERIALIZATION_HEADER_SIZE};
+    if (message_start && memcmp(header.data(), *message_start, CMessageHeader::MESSAGE_START_SIZE)) return nullptr;
+    uint32_t size{ReadLE32(header.data() + CMessageHeader::MESSAGE_START_SIZE)};
+    compressed = size & BLOCK_RECORD_COMPRESSED;
+    size &= ~BLOCK_RECORD_COMPRESSED;
+    if (size > MAX_SIZE) return nullptr;
+    if (size_t{pos.nPos} + size > mapping->Data().size()) {
+        // Written since the file was mapped
+        mapping = g_block_file_maps.Get(BlockFileSeq(), pos, size);
+        if (!mapping) return nullptr;
+    }
+    block = Span{UCharCast(mapping->Data().data()) + pos.nPos, size};
+    return mapping;
+}
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+/**
+ * Point block at the serialized block at pos: in the mapped block file, in
+ * g_decompressed_blocks, or in buffer, read from the file. holder keeps what
+ * block points into alive. A compressed block record is decompressed once and
+ * added to g_decompressed_blocks. message_start, if given, must start the
+ * header of the record.
+ */
+static bool ReadBlockBytes(const FlatFilePos& pos, const CMessageHeader::MessageStartChars* message_start,
+                           Span<const uint8_t>& block, std::vector<uint8_t>& buffer, std::shared_ptr<const void>& holder)
+{
+    if (auto decompressed{g_decompressed_blocks.Get(pos)}) {
+        block = *decompressed;
+        holder = std::move(decompressed);
+        return true;
     }
 
-    // Read block
+    Span<const uint8_t> stored;
+    bool compressed{false};
+    if (auto mapping{MapBlock(pos, message_start, stored, compressed)}) {
+        holder = std::move(mapping);
+    } else {
+        if (pos.nPos < BLOCK_SERIALIZATION_HEADER_SIZE) {
+            return error("%s: No block record header before %s", __func__, pos.ToString());
+        }
+        FlatFilePos hpos = pos;
+        hpos.nPos -= BLOCK_SERIALIZATION_HEADER_SIZE; // Seek back 8 bytes for meta header
+        AutoFile filein{OpenBlockFile(hpos, true)};
+        if (filein.IsNull()) {
+            return error("%s: OpenBlockFile failed for %s", __func__, pos.ToString());
+        }
+
+        try {
+            CMessageHeader::MessageStartChars blk_start;
+            unsigned int blk_size;
+
+            filein >> blk_start >> blk_size;
+
+            if (message_start && memcmp(blk_start, *message_start, CMessageHeader::MESSAGE_START_SIZE)) {
+                return error("%s: Block magic mismatch for %s: %s versus expected %s", __func__, pos.ToString(),
+                             HexStr(blk_start),
+                             HexStr(*message_start));
+            }
+
+            compressed = blk_size & BLOCK_RECORD_COMPRESSED;
+            blk_size &= ~BLOCK_RECORD_COMPRESSED;
+            if (blk_size > MAX_SIZE) {
+                return error("%s: Block data is larger than maximum deserialization size for %s: %s versus %s", __func__, pos.ToString(),
+                             blk_size, MAX_SIZE);
+            }
+
+            buffer.resize(blk_size); // Zeroing of memory is intentional here
+            filein.read(MakeWritableByteSpan(buffer));
+        } catch (const std::exception& e) {
+            return error("%s: Read from block file failed: %s for %s", __func__, e.what(), pos.ToString());
+        }
+        stored = buffer;
+    }
+
+    if (!compressed) {
+        block = stored;
+        return true;
+    }
+    auto decompressed{std::make_shared<std::vector<uint8_t>>()};
+    if (!DecompressBlock(stored, *decompressed)) {
+        return error("%s: Malformed compressed block at %s", __func__, pos.ToString());
+    }
+    g_decompressed_blocks.Add(pos, decompressed);
+    block = *decompressed;
+    holder = std::move(decompressed);
+    return true;
+}
+
+bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams, bool check_pow)
+{
+    block.SetNull();
+
+    // Deserialize straight out of the mapped file or the decompressed block
+    Span<const uint8_t> data;
+    std::vector<uint8_t> buffer;
+    std::shared_ptr<const void> holder;
+    if (!ReadBlockBytes(pos, /*message_start=*/nullptr, data, buffer, holder)) {
+        return error("ReadBlockFromDisk: Failed to read block at %s", pos.ToString());
+    }
     try {
-        filein >> block;
+        SpanReader{SER_DISK, CLIENT_VERSION, data} >> block;
     } catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s at %s", __func__, e.what(), pos.ToString());
+        return error("%s: Deserialize error - %s at %s", __func__, e.what(), pos.ToString());
     }
 
     // Check the header
     bool isPoS = block.IsProofOfStake();
-    if (!isPoS && !CheckProofOfWork(block.GetPoWHash(), block.nBits, consensusParams)) {
+    if (!isPoS && check_pow && !CheckProofOfWork(block.GetPoWHash(), block.nBits, consensusParams)) {
         return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
     }
 
@@ -771,64 +1067,171 @@ bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::P
 
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
-    const FlatFilePos block_pos{WITH_LOCK(cs_main, return pindex->GetBlockPos())};
+    FlatFilePos block_pos;
+    bool validated;
+    {
+        LOCK(cs_main);
+        block_pos = pindex->GetBlockPos();
+        validated = pindex->IsValid(BLOCK_VALID_SCRIPTS);
+    }
 
-    if (!ReadBlockFromDisk(block, block_pos, consensusParams)) {
+    // Only blocks read before, and so checked, are cached
+    if (const auto cached{g_block_cache.Get(pindex->GetBlockHash())}) {
+        block = *cached;
+        return true;
+    }
+
+    // The header of a block this far validated had its proof of work checked, and
+    // matching the hash below ties what was read to it, so the scrypt can be skipped
+    const bool check_pow{!validated || g_check_stored_pow};
+    if (!ReadBlockFromDisk(block, block_pos, consensusParams, check_pow)) {
         return false;
     }
     if (block.GetHash() != pindex->GetBlockHash()) {
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
                      pindex->ToString(), block_pos.ToString());
     }
+    if (!check_pow && !block.IsProofOfStake()) ++g_stored_pow_skipped;
+    g_block_cache.Offer(pindex->GetBlockHash(), block);
     return true;
 }
 
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start)
 {
-    FlatFilePos hpos = pos;
-    hpos.nPos -= 8; // Seek back 8 bytes for meta header
-    AutoFile filein{OpenBlockFile(hpos, true)};
-    if (filein.IsNull()) {
-        return error("%s: OpenBlockFile failed for %s", __func__, pos.ToString());
+    Span<const uint8_t> data;
+    std::shared_ptr<const void> holder;
+    if (!ReadBlockBytes(pos, &message_start, data, block, holder)) {
+        return false;
     }
+    // Read into block unless it was mapped or decompressed
+    if (data.data() != block.data()) {
+        block.assign(data.begin(), data.end());
+    }
+    return true;
+}
 
-    try {
-        CMessageHeader::MessageStartChars blk_start;
-        unsigned int blk_size;
-
-        filein >> blk_start >> blk_size;
-
-        if (memcmp(blk_start, message_start, CMessageHeader::MESSAGE_START_SIZE)) {
-            return error("%s: Block magic mismatch for %s: %s versus expected %s", __func__, pos.ToString(),
-                         HexStr(blk_start),
-                         HexStr(message_start));
+bool ReadTransactionFromDisk(const FlatFilePos& pos, unsigned int tx_offset, CBlockHeader& header, CTransactionRef& tx)
+{
+    Span<const uint8_t> data;
+    bool compressed{false};
+    std::shared_ptr<const void> holder{MapBlock(pos, /*message_start=*/nullptr, data, compressed)};
+    if (!holder) {
+        if (pos.nPos < BLOCK_SERIALIZATION_HEADER_SIZE) {
+            return error("%s: No block record header before %s", __func__, pos.ToString());
         }
-
-        if (blk_size > MAX_SIZE) {
-            return error("%s: Block data is larger than maximum deserialization size for %s: %s versus %s", __func__, pos.ToString(),
-                         blk_size, MAX_SIZE);
+        FlatFilePos hpos = pos;
+        hpos.nPos -= BLOCK_SERIALIZATION_HEADER_SIZE;
+        CAutoFile file(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
+        if (file.IsNull()) {
+            return error("%s: OpenBlockFile failed", __func__);
         }
+        // A block stored as is is only read up to the transaction
+        try {
+            CMessageHeader::MessageStartChars blk_start;
+            unsigned int blk_size;
+            file >> blk_start >> blk_size;
+            compressed = blk_size & BLOCK_RECORD_COMPRESSED;
+            if (!compressed) {
+                file >> header;
+                if (fseek(file.Get(), tx_offset, SEEK_CUR)) {
+                    return error("%s: fseek(...) failed", __func__);
+                }
+                file >> tx;
+                return true;
+            }
+        } catch (const std::exception& e) {
+            return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
 
-        block.resize(blk_size); // Zeroing of memory is intentional here
-        filein.read(MakeWritableByteSpan(block));
+    std::vector<uint8_t> buffer;
+    if (compressed && !ReadBlockBytes(pos, /*message_start=*/nullptr, data, buffer, holder)) {
+        return false;
+    }
+    try {
+        SpanReader stream{SER_DISK, CLIENT_VERSION, data};
+        stream >> header;
+        stream.ignore(tx_offset);
+        stream >> tx;
     } catch (const std::exception& e) {
-        return error("%s: Read from block file failed: %s for %s", __func__, e.what(), pos.ToString());
+        return error("%s: Deserialize error - %s at %s", __func__, e.what(), pos.ToString());
     }
-
     return true;
 }
 
+bool RawBlockHasWitness(Span<const uint8_t> block)
+{
+    SpanReader stream{SER_DISK, CLIENT_VERSION, block};
+    stream.ignore(::GetSerializeSize(CBlockHeader{}, PROTOCOL_VERSION));
+    const uint64_t tx_count{ReadCompactSize(stream)};
+    for (uint64_t i = 0; i < tx_count; ++i) {
+        stream.ignore(sizeof(int32_t)); // nVersion
+        const uint64_t in_count{ReadCompactSize(stream)};
+        // A stored transaction spends at least one input, so an empty vin is the witness marker
+        if (in_count == 0) return true;
+        for (uint64_t in = 0; in < in_count; ++in) {
+            stream.ignore(sizeof(uint256) + sizeof(uint32_t)); // prevout
+            stream.ignore(ReadCompactSize(stream)); // scriptSig
+            stream.ignore(sizeof(uint32_t)); // nSequence
+        }
+        const uint64_t out_count{ReadCompactSize(stream)};
+        for (uint64_t out = 0; out < out_count; ++out) {
+            stream.ignore(sizeof(CAmount));
+            stream.ignore(ReadCompactSize(stream)); // scriptPubKey
+        }
+        stream.ignore(sizeof(uint32_t)); // nLockTime
+    }
+    return false;
+}
+
+/** Size of the block record at pos as stored, compressed or not, without its header */
+static std::optional<unsigned int> ReadStoredBlockSize(const FlatFilePos& pos)
+{
+    Span<const uint8_t> stored;
+    bool compressed;
+    if (MapBlock(pos, /*message_start=*/nullptr, stored, compressed)) return stored.size();
+
+    if (pos.nPos < BLOCK_SERIALIZATION_HEADER_SIZE) return std::nullopt;
+    FlatFilePos hpos = pos;
+    hpos.nPos -= BLOCK_SERIALIZATION_HEADER_SIZE;
+    AutoFile filein{OpenBlockFile(hpos, true)};
+    if (filein.IsNull()) return std::nullopt;
+    try {
+        CMessageHeader::MessageStartChars blk_start;
+        unsigned int blk_size;
+        filein >> blk_start >> blk_size;
+        return blk_size & ~BLOCK_RECORD_COMPRESSED;
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
 FlatFilePos BlockManager::SaveBlockToDisk(const CBlock& block, int nHeight, CChain& active_chain, const CChainParams& chainparams, const FlatFilePos* dbp)
 {
     unsigned int nBlockSize = ::GetSerializeSize(block, CLIENT_VERSION);
     FlatFilePos blockPos;
+    // Data of the compressed block record to write, empty to write the block as is
+    std::vector<uint8_t> record;
     const auto position_known {dbp != nullptr};
     if (position_known) {
         blockPos = *dbp;
+        // A block found during -reindex may have been stored compressed
+        nBlockSize = ReadStoredBlockSize(blockPos).value_or(nBlockSize);
     } else {
         // when known, blockPos.nPos points at the offset of the block data in the blk file. that already accounts for
         // the serialization header present in the file (the 4 magic message start bytes + the 4 length bytes = 8 bytes = BLOCK_SERIALIZATION_HEADER_SIZE).
         // we add BLOCK_SERIALIZATION_HEADER_SIZE only for new blocks since they will have the serialization header added when written to disk.
+        if (m_opts.compress_blocks) {
+            std::vector<uint8_t> serialized;
+            serialized.reserve(nBlockSize);
+            CVectorWriter{SER_DISK, CLIENT_VERSION, serialized, 0} << block;
+            CompressBlock(serialized, record);
+            if (record.size() < nBlockSize) {
+                nBlockSize = record.size();
+            } else {
+                record.clear();
+            }
+        }
         nBlockSize += static_cast<unsigned int>(BLOCK_SERIALIZATION_HEADER_SIZE);
     }
     if (!FindBlockPos(blockPos, nBlockSize, nHeight, active_chain, block.GetBlockTime(), position_known)) {
@@ -836,7 +1239,7 @@ FlatFilePos BlockManager::SaveBlockToDisk(const CBlock& block, int nHeight, CCha
         return FlatFilePos();
     }
     if (!position_known) {
-        if (!WriteBlockToDisk(block, blockPos, chainparams.MessageStart())) {
+        if (!WriteBlockToDisk(block, record, blockPos, chainparams.MessageStart())) {
             AbortNode("Failed to write block");
             return FlatFilePos();
         }
@@ -871,26 +1274,63 @@ void ThreadImport(ChainstateManager& chainman, std::vector<fs::path> vImportFile
 
         // -reindex
         if (fReindex) {
-            int nFile = 0;
+            int nFile = WITH_LOCK(::cs_main, return chainman.m_blockman.m_block_tree_db->ReadReindexProgress());
+            if (nFile > 0) {
+                LogPrintf("Resuming reindex at block file blk%05u.dat\n", (unsigned int)nFile);
+            }
             // Map of disk positions for blocks with unknown parent (only used for reindex);
             // parent hash -> child disk position, multiple children can have the same parent.
             std::multimap<uint256, FlatFilePos> blocks_with_unknown_parent;
+            // Block files being parsed ahead of the one whose blocks are accepted, in order
+            const size_t parse_threads = std::clamp<int64_t>(args.GetIntArg("-reindexthreads", DEFAULT_REINDEX_THREADS), 0, MAX_REINDEX_THREADS);
+            std::deque<std::future<std::optional<std::vector<ExternalBlock>>>> parsing;
+            int next_parse{nFile};
             while (true) {
                 FlatFilePos pos(nFile, 0);
-                if (!fs::exists(GetBlockPosFilename(pos))) {
-                    break; // No block files left to reindex
-                }
-                FILE* file = OpenBlockFile(pos, true);
-                if (!file) {
-                    break; // This error is logged in OpenBlockFile
+                if (parse_threads > 0) {
+                    while (parsing.size() < parse_threads) {
+                        parsing.push_back(std::async(std::launch::async, [parse_pos = FlatFilePos(next_parse++, 0), &chainman]() -> std::optional<std::vector<ExternalBlock>> {
+                            if (!fs::exists(GetBlockPosFilename(parse_pos))) return std::nullopt;
+                            FILE* file = OpenBlockFile(parse_pos, true);
+                            if (!file) return std::nullopt;
+                            return ParseBlockFile(file, parse_pos.nFile, chainman.GetParams());
+                        }));
+                    }
+                    const std::optional<std::vector<ExternalBlock>> blocks{parsing.front().get()};
+                    parsing.pop_front();
+                    if (!blocks) {
+                        break; // No block files left to reindex
+                    }
+                    LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
+                    chainman.ActiveChainstate().LoadExternalBlocks(*blocks, blocks_with_unknown_parent);
+                } else {
+                    if (!fs::exists(GetBlockPosFilename(pos))) {
+                        break; // No block files left to reindex
+                    }
+                    FILE* file = OpenBlockFile(pos, true);
+                    if (!file) {
+                        break; // This error is logged in OpenBlockFile
+                    }
+                    LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
+                    chainman.ActiveChainstate().LoadExternalBlockFile(file, &pos, &blocks_with_unknown_parent);
                 }
-                LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
-                chainman.ActiveChainstate().LoadExternalBlockFile(file, &pos, &blocks_with_unknown_parent);
                 if (ShutdownRequested()) {
                     LogPrintf("Shutdown requested. Exit %s\n", __func__);
                     return;
                 }
                 nFile++;
+
+                // Once the block index is on disk, record where to resume. That is the first
+                // file of a block still waiting for its parent, which a resumed reindex must
+                // come across again.
+                int resume_file{nFile};
+                for (const auto& [parent, child_pos] : blocks_with_unknown_parent) {
+                    resume_file = std::min(resume_file, child_pos.nFile);
+                }
+                BlockValidationState state;
+                if (chainman.ActiveChainstate().FlushStateToDisk(state, FlushStateMode::ALWAYS)) {
+                    WITH_LOCK(::cs_main, chainman.m_blockman.m_block_tree_db->WriteReindexProgress(resume_file));
+                }
             }
             WITH_LOCK(::cs_main, chainman.m_blockman.m_block_tree_db->WriteReindexing(false));
             fReindex = false;
@@ -7,16 +7,24 @@
 
 #include <attributes.h>
 #include <chain.h>
+#include <flatfile.h>
 #include <kernel/blockmanager_opts.h>
 #include <kernel/cs_main.h>
 #include <protocol.h>
+#include <span.h>
+#include <streams.h>
 #include <sync.h>
 #include <txdb.h>
 #include <util/fs.h>
 
 #include <atomic>
 #include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 class ArgsManager;
@@ -36,6 +44,15 @@ struct Params;
 
 namespace node {
 static constexpr bool DEFAULT_STOPAFTERBLOCKIMPORT{false};
+//! -reindexthreads default, block files parsed ahead of the one whose blocks are accepted
+static constexpr int64_t DEFAULT_REINDEX_THREADS{2};
+static constexpr int64_t MAX_REINDEX_THREADS{16};
+//! Undo records held back to be written to the undo file in one go, see BlockManager::WritePendingUndo()
+static constexpr size_t UNDO_BATCH_BYTES{4 << 20};
+//! Blocks of a reorganization whose undo data is read ahead on threads of their own
+static constexpr size_t UNDO_PREFETCH_BLOCKS{16};
+//! Blocks from the top of the block index whose next proof-of-stake nBits are cached when it is loaded
+static constexpr int NEXT_POS_BITS_CACHE_DEPTH{2016};
 
 /** The pre-allocation chunk size for blk?????.dat files (since 0.8) */
 static const unsigned int BLOCKFILE_CHUNK_SIZE = 0x1000000; // 16 MiB
@@ -46,9 +63,131 @@ static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 
 /** Size of header written by WriteBlockToDisk before a serialized CBlock */
 static constexpr size_t BLOCK_SERIALIZATION_HEADER_SIZE = CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int);
+/**
+ * Flag of the size in the header of a block record holding the block
+ * compressed, see CompressBlock(). Sizes are below MAX_SIZE, so the bit is
+ * free, and records without it are read as they always were.
+ */
+static constexpr uint32_t BLOCK_RECORD_COMPRESSED{0x80000000};
+//! Default for -blockcompression
+static constexpr bool DEFAULT_BLOCK_COMPRESSION{false};
 
 extern std::atomic_bool fReindex;
 
+//! Default for -checkstoredpow
+static constexpr bool DEFAULT_CHECK_STORED_POW{false};
+/**
+ * Recheck the proof of work of blocks read back from disk even when their index
+ * entry is already validated up to BLOCK_VALID_SCRIPTS
+ */
+extern std::atomic_bool g_check_stored_pow;
+/** Proof-of-work checks ReadBlockFromDisk() skipped for blocks with a validated index entry */
+extern std::atomic<uint64_t> g_stored_pow_skipped;
+
+//! Default for -blockfilemaps, none where address space is short
+static constexpr unsigned int DEFAULT_BLOCK_FILE_MAPS{sizeof(void*) >= 8 ? 16 : 0};
+/** Read-only mappings of the blk?????.dat files blocks are read out of */
+extern FlatFileMapCache g_block_file_maps;
+
+//! Default for -blockcachesize, in MiB
+static constexpr int64_t DEFAULT_BLOCK_CACHE_SIZE{32};
+
+struct BlockCacheStats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+    size_t blocks{0};
+    size_t bytes{0};
+    size_t max_bytes{0};
+};
+
+/**
+ * Size-bounded cache of the blocks ReadBlockFromDisk() reads, by hash, so the
+ * blocks read over and over (tip blocks served to peers, read by indexes and
+ * RPC callers) are deserialized once.
+ *
+ * A block is only cached on its second read in a short while, so a scan
+ * reading each block once, as an index catching up does, doesn't push the
+ * blocks read repeatedly out. The least recently read blocks are evicted
+ * first.
+ */
+class BlockCache
+{
+private:
+    using LruList = std::list<std::shared_ptr<const CBlock>>;
+
+    //! Number of recently missed hashes remembered, to cache them when read again
+    static constexpr size_t MAX_MISSED{1024};
+
+    mutable Mutex m_mutex;
+    LruList m_blocks GUARDED_BY(m_mutex);
+    std::unordered_map<uint256, std::pair<LruList::iterator, size_t>, BlockHasher> m_by_hash GUARDED_BY(m_mutex);
+    //! Hashes missed recently, the oldest first
+    std::deque<uint256> m_missed GUARDED_BY(m_mutex);
+    std::unordered_set<uint256, BlockHasher> m_missed_set GUARDED_BY(m_mutex);
+    size_t m_bytes GUARDED_BY(m_mutex){0};
+    size_t m_max_bytes GUARDED_BY(m_mutex);
+    uint64_t m_hits GUARDED_BY(m_mutex){0};
+    uint64_t m_misses GUARDED_BY(m_mutex){0};
+
+    void Trim() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+public:
+    explicit BlockCache(size_t max_bytes) : m_max_bytes(max_bytes) {}
+
+    /** The block with this hash, nullptr if it is not cached. Counts a hit or a miss. */
+    std::shared_ptr<const CBlock> Get(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Offer a block read after a miss, which is cached if it missed before. */
+    void Offer(const uint256& hash, const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Set the memory budget, 0 to disable the cache. */
+    void SetMaxBytes(size_t max_bytes) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    BlockCacheStats GetStats() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+/** Cache of the blocks read by ReadBlockFromDisk(CBlock&, const CBlockIndex*, ...) */
+extern BlockCache g_block_cache;
+
+/**
+ * The serialized blocks of the compressed block records read last, by
+ * position, so a block whose transactions are read one at a time, or that is
+ * served to several peers, is decompressed once.
+ */
+class DecompressedBlockCache
+{
+private:
+    using Entry = std::pair<FlatFilePos, std::shared_ptr<const std::vector<uint8_t>>>;
+
+    mutable Mutex m_mutex;
+    //! Most recently read first
+    std::list<Entry> m_blocks GUARDED_BY(m_mutex);
+    const size_t m_max_blocks;
+
+public:
+    explicit DecompressedBlockCache(size_t max_blocks) : m_max_blocks(max_blocks) {}
+
+    std::shared_ptr<const std::vector<uint8_t>> Get(const FlatFilePos& pos) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    void Add(const FlatFilePos& pos, std::shared_ptr<const std::vector<uint8_t>> block) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Drop the blocks of a block file, as it is pruned. */
+    void EraseFile(int file) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+//! Number of decompressed blocks kept in g_decompressed_blocks
+static constexpr size_t DECOMPRESSED_BLOCK_CACHE_SIZE{8};
+extern DecompressedBlockCache g_decompressed_blocks;
+
+/**
+ * Compress a serialized block into the data of a compressed block record: the
+ * block size as a CompactSize, then the block in the stream format of
+ * opfile/src/compress.h, pieces of COMPRESS_BLOCK bytes in lz4 block format.
+ */
+void CompressBlock(Span<const uint8_t> block, std::vector<uint8_t>& record);
+/** Decompress the data of a compressed block record. Returns false if it is malformed. */
+bool DecompressBlock(Span<const uint8_t> record, std::vector<uint8_t>& block);
+
 // Because validation code takes pointers to the map's CBlockIndex objects, if
 // we ever switch to another associative container, we need to either use a
 // container that has stable addressing (true of all std associative
@@ -88,8 +227,8 @@ private:
      */
     bool LoadBlockIndex(const Consensus::Params& consensus_params)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
-    void FlushBlockFile(bool fFinalize = false, bool finalize_undo = false);
-    void FlushUndoFile(int block_file, bool finalize = false);
+    void FlushBlockFile(bool fFinalize = false, bool finalize_undo = false) EXCLUSIVE_LOCKS_REQUIRED(!m_pending_undo_mutex);
+    void FlushUndoFile(int block_file, bool finalize = false) EXCLUSIVE_LOCKS_REQUIRED(!m_pending_undo_mutex);
     bool FindBlockPos(FlatFilePos& pos, unsigned int nAddSize, unsigned int nHeight, CChain& active_chain, uint64_t nTime, bool fKnown);
     bool FindUndoPos(BlockValidationState& state, int nFile, FlatFilePos& pos, unsigned int nAddSize);
 
@@ -130,6 +269,16 @@ private:
     /** Dirty block file entries. */
     std::set<int> m_dirty_fileinfo;
 
+    /**
+     * Undo records of connected blocks not written to their undo file yet,
+     * back to back from m_pending_undo_pos. They are written in one go by
+     * WritePendingUndo(), before the undo file is flushed, so before the
+     * block index pointing at them is.
+     */
+    Mutex m_pending_undo_mutex;
+    FlatFilePos m_pending_undo_pos GUARDED_BY(m_pending_undo_mutex);
+    DataStream m_pending_undo GUARDED_BY(m_pending_undo_mutex);
+
     /**
      * Map from external index name to oldest block that must not be pruned.
      *
@@ -153,6 +302,9 @@ public:
 
     std::vector<CBlockIndex*> GetAllBlockIndices() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+    /** Memory held by the block index, its entries being whole CBlockIndex, and the block file info. */
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     /**
      * All pairs A->B, where A (or one of its ancestors) misses transactions, but B has transactions.
      * Pruned nodes may have entries where B is missing data.
@@ -185,7 +337,14 @@ public:
     CBlockFileInfo* GetBlockFileInfo(size_t n);
 
     bool WriteUndoDataForBlock(const CBlockUndo& blockundo, BlockValidationState& state, CBlockIndex* pindex, const CChainParams& chainparams)
-        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+        EXCLUSIVE_LOCKS_REQUIRED(::cs_main, !m_pending_undo_mutex);
+
+    /**
+     * Write the undo records held back by WriteUndoDataForBlock() to their
+     * undo file, without syncing it. Called once the blocks of a step of
+     * ActivateBestChain() are connected, before anything reads their undo data.
+     */
+    bool WritePendingUndo() EXCLUSIVE_LOCKS_REQUIRED(!m_pending_undo_mutex);
 
     /** Store block on disk. If dbp is not nullptr, then it provides the known position of the block within a block file on disk. */
     FlatFilePos SaveBlockToDisk(const CBlock& block, int nHeight, CChain& active_chain, const CChainParams& chainparams, const FlatFilePos* dbp);
@@ -231,11 +390,29 @@ fs::path GetBlockPosFilename(const FlatFilePos& pos);
 void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune);
 
 /** Functions for disk access for blocks */
-bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams);
+bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos, const Consensus::Params& consensusParams, bool check_pow = true);
+/**
+ * Read the block of pindex, checking that it is the block indexed
+ * The proof of work is only checked if pindex isn't validated up to BLOCK_VALID_SCRIPTS,
+ * which every block connected has been, assumevalid or not, unless -checkstoredpow
+ * Blocks read repeatedly are copied out of g_block_cache instead
+ */
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
 bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start);
+/**
+ * Read the header of the block at pos, and the transaction tx_offset bytes
+ * past it, as the transaction indexes locate transactions.
+ */
+bool ReadTransactionFromDisk(const FlatFilePos& pos, unsigned int tx_offset, CBlockHeader& header, CTransactionRef& tx);
+/**
+ * Whether a block as read by ReadRawBlockFromDisk carries witness data, i.e. whether it
+ * serializes differently without witnesses. Walks the transactions without decoding them.
+ */
+bool RawBlockHasWitness(Span<const uint8_t> block);
 
 bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex);
+/** Read the undo data at pos of the block whose parent is hash_prev. Takes no lock, for reading ahead. */
+bool UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint256& hash_prev);
 
 void ThreadImport(ChainstateManager& chainman, std::vector<fs::path> vImportFiles, const ArgsManager& args, const fs::path& mempool_path);
 } // namespace node
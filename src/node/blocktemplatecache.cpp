@@ -0,0 +1,182 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blocktemplatecache.h>
+
+#include <chain.h>
+#include <consensus/consensus.h>
+#include <consensus/tx_verify.h>
+#include <consensus/validation.h>
+#include <logging.h>
+#include <script/script.h>
+#include <txmempool.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <algorithm>
+
+namespace node {
+std::unique_ptr<BlockTemplateCache> g_block_template_cache;
+
+BlockTemplateCache::BlockTemplateCache(Chainstate& chainstate, CTxMemPool& mempool, const BlockAssembler::Options& options)
+    : m_chainstate{chainstate}, m_mempool{mempool}, m_options{ClampOptions(options)}
+{
+}
+
+void BlockTemplateCache::Start()
+{
+    RegisterValidationInterface(this);
+    // Select on the scheduler thread, so no mempool event is applied out of order
+    CallFunctionInValidationInterfaceQueue([this] { Rebuild(); });
+}
+
+void BlockTemplateCache::Stop()
+{
+    UnregisterValidationInterface(this);
+}
+
+void BlockTemplateCache::Rebuild()
+{
+    const auto time_start{SteadyClock::now()};
+
+    std::unique_ptr<CBlockTemplate> block_template;
+    int height;
+    int64_t lock_time_cutoff;
+    {
+        LOCK(::cs_main);
+        const CBlockIndex* tip{m_chainstate.m_chain.Tip()};
+        if (!tip) return;
+        block_template = BlockAssembler{m_chainstate, &m_mempool, m_options}.CreateNewBlock(CScript{}, /*fProofOfStake=*/true);
+        if (!block_template) return;
+        height = tip->nHeight + 1;
+        lock_time_cutoff = tip->GetMedianTimePast();
+    }
+
+    const CBlock& block{block_template->block};
+    BlockTxSelection selection;
+    selection.tip_hash = block.hashPrevBlock;
+    std::set<uint256> selected;
+    // Reserve space for the coinbase as BlockAssembler does
+    uint64_t weight{4000};
+    int64_t sigops_cost{400};
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        selection.txs.push_back(block.vtx[i]);
+        selection.fees.push_back(block_template->vTxFees[i]);
+        selection.sigops_cost.push_back(block_template->vTxSigOpsCost[i]);
+        selected.insert(block.vtx[i]->GetHash());
+        weight += GetTransactionWeight(*block.vtx[i]);
+        sigops_cost += block_template->vTxSigOpsCost[i];
+    }
+
+    LOCK(m_mutex);
+    m_selection = std::move(selection);
+    m_selected = std::move(selected);
+    m_weight = weight;
+    m_sigops_cost = sigops_cost;
+    m_height = height;
+    m_lock_time_cutoff = lock_time_cutoff;
+    m_stale = false;
+
+    LogPrint(BCLog::BENCH, "BlockTemplateCache: selected %u txs for height %d in %.2fms\n",
+             m_selection.txs.size(), m_height, Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
+}
+
+void BlockTemplateCache::RebuildIfStale()
+{
+    if (WITH_LOCK(m_mutex, return m_stale && !m_selection.tip_hash.IsNull())) {
+        Rebuild();
+    }
+}
+
+void BlockTemplateCache::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence)
+{
+    LOCK(m_mempool.cs);
+    const auto it{m_mempool.GetIter(tx->GetHash())};
+    // Already gone again, its removal follows
+    if (!it) return;
+    const CTxMemPoolEntry& entry{**it};
+
+    LOCK(m_mutex);
+    if (m_selection.tip_hash.IsNull() || m_selected.count(tx->GetHash())) return;
+    if (!IsFinalTx(*tx, m_height, m_lock_time_cutoff)) return;
+
+    const auto& parents{entry.GetMemPoolParentsConst()};
+    const bool parents_selected{std::all_of(parents.begin(), parents.end(), [&](const CTxMemPoolEntry& parent) EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return m_selected.count(parent.GetTx().GetHash()) > 0;
+    })};
+    // The same tests addPackageTxs() makes of a package
+    if (parents_selected &&
+        entry.GetModifiedFee() >= m_options.blockMinFeeRate.GetFee(entry.GetTxSize()) &&
+        m_weight + WITNESS_SCALE_FACTOR * entry.GetTxSize() < m_options.nBlockMaxWeight &&
+        m_sigops_cost + entry.GetSigOpCost() < MAX_BLOCK_SIGOPS_COST) {
+        m_selection.txs.push_back(tx);
+        m_selection.fees.push_back(entry.GetFee());
+        m_selection.sigops_cost.push_back(entry.GetSigOpCost());
+        m_selected.insert(tx->GetHash());
+        m_weight += entry.GetTxWeight();
+        m_sigops_cost += entry.GetSigOpCost();
+        return;
+    }
+
+    // Taking it, or it pulling in its ancestors, could make for a better block
+    if (entry.GetModFeesWithAncestors() >= m_options.blockMinFeeRate.GetFee(entry.GetSizeWithAncestors())) {
+        m_stale = true;
+    }
+}
+
+void BlockTemplateCache::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
+{
+    LOCK(m_mutex);
+    if (!m_selected.count(tx->GetHash())) return;
+
+    // Drop it along with the selected transactions spending it, whose own
+    // removals follow, so the selection stays a valid block in between
+    std::set<uint256> removed{tx->GetHash()};
+    BlockTxSelection kept;
+    kept.tip_hash = m_selection.tip_hash;
+    for (size_t i = 0; i < m_selection.txs.size(); ++i) {
+        const CTransaction& selected_tx{*m_selection.txs[i]};
+        const bool spends_removed{std::any_of(selected_tx.vin.begin(), selected_tx.vin.end(), [&](const CTxIn& txin) {
+            return removed.count(txin.prevout.hash) > 0;
+        })};
+        if (removed.count(selected_tx.GetHash()) || spends_removed) {
+            removed.insert(selected_tx.GetHash());
+            m_selected.erase(selected_tx.GetHash());
+            m_weight -= GetTransactionWeight(selected_tx);
+            m_sigops_cost -= m_selection.sigops_cost[i];
+            continue;
+        }
+        kept.txs.push_back(m_selection.txs[i]);
+        kept.fees.push_back(m_selection.fees[i]);
+        kept.sigops_cost.push_back(m_selection.sigops_cost[i]);
+    }
+    m_selection = std::move(kept);
+    m_stale = true;
+}
+
+void BlockTemplateCache::UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
+{
+    if (fInitialDownload) {
+        LOCK(m_mutex);
+        m_selection = BlockTxSelection{};
+        m_selected.clear();
+        m_stale = false;
+        return;
+    }
+    Rebuild();
+}
+
+std::unique_ptr<CBlockTemplate> BlockTemplateCache::CreateNewBlock(const CScript& scriptPubKeyIn, bool fProofOfStake)
+{
+    const BlockTxSelection selection{WITH_LOCK(m_mutex, return m_selection)};
+    BlockAssembler assembler{m_chainstate, &m_mempool, m_options};
+    if (!selection.tip_hash.IsNull()) {
+        if (auto block_template{assembler.CreateNewBlock(scriptPubKeyIn, fProofOfStake, selection)}) {
+            return block_template;
+        }
+    }
+    // No selection for the tip yet
+    return assembler.CreateNewBlock(scriptPubKeyIn, fProofOfStake);
+}
+} // namespace node
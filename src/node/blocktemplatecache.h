@@ -0,0 +1,89 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKTEMPLATECACHE_H
+#define BITCOIN_NODE_BLOCKTEMPLATECACHE_H
+
+#include <node/miner.h>
+#include <sync.h>
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <chrono>
+#include <memory>
+#include <set>
+
+class Chainstate;
+class CTxMemPool;
+
+namespace node {
+//! Default for -blocktemplatecache
+static constexpr bool DEFAULT_BLOCK_TEMPLATE_CACHE{true};
+//! How often a cached selection known to be short of the best one is selected again
+static constexpr std::chrono::seconds BLOCK_TEMPLATE_REBUILD_INTERVAL{1};
+
+/**
+ * Block transaction selection kept ready for the next block, so a template is
+ * assembled without running a package selection under cs_main and mempool.cs.
+ *
+ * The selection is made afresh on each new tip. Transactions entering the
+ * mempool afterwards are appended as long as their in-mempool parents are
+ * already selected and they fit; transactions leaving it are dropped along
+ * with their selected descendants. Either way the selection may now be short
+ * of the best one, and it is made afresh by the periodic RebuildIfStale().
+ * A selection falling behind the mempool like that still makes a valid block.
+ *
+ * All updates run on the scheduler thread, in order with the validation
+ * interface callbacks, so every mempool event applies to the selection it
+ * follows.
+ */
+class BlockTemplateCache final : public CValidationInterface
+{
+private:
+    Chainstate& m_chainstate;
+    CTxMemPool& m_mempool;
+    const BlockAssembler::Options m_options;
+
+    Mutex m_mutex;
+    //! Selection for the tip, tip_hash is null when there is none (before the first tip, or in IBD)
+    BlockTxSelection m_selection GUARDED_BY(m_mutex);
+    //! Txids in m_selection
+    std::set<uint256> m_selected GUARDED_BY(m_mutex);
+    uint64_t m_weight GUARDED_BY(m_mutex){0};
+    int64_t m_sigops_cost GUARDED_BY(m_mutex){0};
+    //! Height and locktime cutoff of the block the selection is for
+    int m_height GUARDED_BY(m_mutex){0};
+    int64_t m_lock_time_cutoff GUARDED_BY(m_mutex){0};
+    //! Whether a selection made now could be better
+    bool m_stale GUARDED_BY(m_mutex){false};
+
+    void Rebuild() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+protected:
+    void TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence) override;
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) override;
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override;
+
+public:
+    BlockTemplateCache(Chainstate& chainstate, CTxMemPool& mempool, const BlockAssembler::Options& options);
+
+    /// Make the first selection and start following the chain and mempool through the validation interface.
+    void Start();
+
+    /// Stop following the chain and mempool.
+    void Stop();
+
+    /// Select again if the selection could be better. Called periodically on the scheduler thread.
+    void RebuildIfStale() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Construct a new block template with coinbase to scriptPubKeyIn out of the
+    /// cached selection, or out of the mempool if there is none for the tip.
+    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, bool fProofOfStake) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+/// The global block template cache. May be null.
+extern std::unique_ptr<BlockTemplateCache> g_block_template_cache;
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKTEMPLATECACHE_H
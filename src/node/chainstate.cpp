@@ -42,10 +42,12 @@ static ChainstateLoadResult CompleteChainstateInitialization(
     pblocktree.reset();
     pblocktree = std::make_unique<CBlockTreeDB>(DBParams{
         .path = chainman.m_options.datadir / "blocks" / "index",
+        .name = "blockindex",
         .cache_bytes = static_cast<size_t>(cache_sizes.block_tree_db),
         .memory_only = options.block_tree_db_in_memory,
         .wipe_data = options.reindex,
-        .options = chainman.m_options.block_tree_db});
+        .options = chainman.m_options.block_tree_db},
+        chainman.m_options.compact_block_index);
 
     if (options.reindex) {
         pblocktree->WriteReindexing(true);
@@ -37,8 +37,10 @@ std::optional<bilingual_str> ApplyArgsManOptions(const ArgsManager& args, Chains
 
     if (auto value{args.GetIntArg("-maxtipage")}) opts.max_tip_age = std::chrono::seconds{*value};
 
-    ReadDatabaseArgs(args, opts.block_tree_db);
-    ReadDatabaseArgs(args, opts.coins_db);
+    if (auto value{args.GetBoolArg("-blockindexcompact")}) opts.compact_block_index = *value;
+
+    if (auto error{ReadDatabaseArgs(args, opts.block_tree_db, "blockindex")}) return error;
+    if (auto error{ReadDatabaseArgs(args, opts.coins_db, "chainstate")}) return error;
     ReadCoinsViewArgs(args, opts.coins_view);
 
     return std::nullopt;
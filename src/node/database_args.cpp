@@ -5,14 +5,91 @@
 #include <node/database_args.h>
 
 #include <dbwrapper.h>
+#include <tinyformat.h>
+#include <util/strencodings.h>
 #include <util/system.h>
 
+#include <utility>
+#include <vector>
+
 namespace node {
-void ReadDatabaseArgs(const ArgsManager& args, DBOptions& options)
+/** Apply a tuning profile to options. Returns false if there is no such profile. */
+static bool ApplyProfile(const std::string& profile, DBOptions& options)
+{
+    if (profile == "default") {
+        options.bloom_bits = 10;
+        options.max_file_size.reset();
+    } else if (profile == "ssd") {
+        // Random reads are cheap, fewer and larger files cut open files and compaction runs
+        options.bloom_bits = 10;
+        options.max_file_size = 8 << 20;
+    } else if (profile == "hdd") {
+        // Every read that is not needed is a seek, so filter harder, in larger files
+        options.bloom_bits = 14;
+        options.max_file_size = 32 << 20;
+    } else if (profile == "archive") {
+        // Large, mostly read databases, as the indexes of a full history
+        options.bloom_bits = 16;
+        options.max_file_size = 64 << 20;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/** Apply option name=value to options. Returns false if it is unknown or out of range. */
+static bool ApplyOption(const std::string& name, const std::string& value, DBOptions& options)
+{
+    const auto parsed{ToIntegral<int64_t>(value)};
+    if (!parsed) return false;
+    if (name == "writebuffer" && *parsed >= 1 && *parsed <= 1024) {
+        options.write_buffer_size = size_t(*parsed) << 20;
+    } else if (name == "bloombits" && *parsed >= 0 && *parsed <= 32) {
+        options.bloom_bits = *parsed;
+    } else if (name == "maxfilesize" && *parsed >= 1 && *parsed <= 1024) {
+        options.max_file_size = size_t(*parsed) << 20;
+    } else if (name == "compactionrate" && *parsed >= 1 && *parsed <= 10000) {
+        options.compaction_rate = size_t(*parsed) << 20;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/** Split "[<db>:]<setting>" into the database it is for, empty for all, and the setting. */
+static std::pair<std::string, std::string> SplitDatabase(const std::string& arg)
+{
+    const auto colon{arg.find(':')};
+    if (colon == std::string::npos) return {"", arg};
+    return {arg.substr(0, colon), arg.substr(colon + 1)};
+}
+
+std::optional<bilingual_str> ReadDatabaseArgs(const ArgsManager& args, DBOptions& options, const std::string& db_name)
 {
-    // Settings here apply to all databases (chainstate, blocks, and index
-    // databases), but it'd be easy to parse database-specific options by adding
-    // a database_type string or enum parameter to this function.
     if (auto value = args.GetBoolArg("-forcecompactdb")) options.force_compact = *value;
+
+    // The settings for all databases first, so the ones for this one override
+    // them. Settings for other databases are checked all the same.
+    DBOptions other;
+    for (const bool for_db : {false, true}) {
+        for (const std::string& arg : args.GetArgs("-dbprofile")) {
+            const auto [db, profile] = SplitDatabase(arg);
+            if (db.empty() == for_db) continue;
+            if (!ApplyProfile(profile, db.empty() || db == db_name ? options : other)) {
+                return strprintf(_("Unknown database profile: '%s'"), arg);
+            }
+        }
+    }
+    for (const bool for_db : {false, true}) {
+        for (const std::string& arg : args.GetArgs("-dboption")) {
+            const auto [db, setting] = SplitDatabase(arg);
+            if (db.empty() == for_db) continue;
+            const auto equals{setting.find('=')};
+            if (equals == std::string::npos || !ApplyOption(setting.substr(0, equals), setting.substr(equals + 1), db.empty() || db == db_name ? options : other)) {
+                return strprintf(_("Invalid database option: '%s'"), arg);
+            }
+        }
+    }
+    return std::nullopt;
 }
 } // namespace node
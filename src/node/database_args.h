@@ -5,11 +5,24 @@
 #ifndef BITCOIN_NODE_DATABASE_ARGS_H
 #define BITCOIN_NODE_DATABASE_ARGS_H
 
+#include <util/translation.h>
+
+#include <optional>
+#include <string>
+
 class ArgsManager;
 struct DBOptions;
 
 namespace node {
-void ReadDatabaseArgs(const ArgsManager& args, DBOptions& options);
+/**
+ * Read the options of the database named db_name, out of -forcecompactdb,
+ * -dbprofile and -dboption. Entries for the database override the ones for
+ * all databases, and -dboption entries override profiles.
+ *
+ * Databases are named chainstate, blockindex, and after their directory
+ * under indexes/ for indexes, e.g. txindex or blockfilter/basic.
+ */
+[[nodiscard]] std::optional<bilingual_str> ReadDatabaseArgs(const ArgsManager& args, DBOptions& options, const std::string& db_name = "");
 } // namespace node
 
 #endif // BITCOIN_NODE_DATABASE_ARGS_H
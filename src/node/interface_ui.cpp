@@ -24,6 +24,10 @@ struct UISignals {
     boost::signals2::signal<CClientUIInterface::NotifyBlockTipSig> NotifyBlockTip;
     boost::signals2::signal<CClientUIInterface::NotifyHeaderTipSig> NotifyHeaderTip;
     boost::signals2::signal<CClientUIInterface::BannedListChangedSig> BannedListChanged;
+    boost::signals2::signal<CClientUIInterface::NotifyJobFinishedSig> NotifyJobFinished;
+    boost::signals2::signal<CClientUIInterface::NotifyAssetConfirmedSig> NotifyAssetConfirmed;
+    boost::signals2::signal<CClientUIInterface::NotifyAuthListChangedSig> NotifyAuthListChanged;
+    boost::signals2::signal<CClientUIInterface::NotifyStakeAttemptSig> NotifyStakeAttempt;
 };
 static UISignals g_ui_signals;
 
@@ -44,6 +48,10 @@ ADD_SIGNALS_IMPL_WRAPPER(ShowProgress);
 ADD_SIGNALS_IMPL_WRAPPER(NotifyBlockTip);
 ADD_SIGNALS_IMPL_WRAPPER(NotifyHeaderTip);
 ADD_SIGNALS_IMPL_WRAPPER(BannedListChanged);
+ADD_SIGNALS_IMPL_WRAPPER(NotifyJobFinished);
+ADD_SIGNALS_IMPL_WRAPPER(NotifyAssetConfirmed);
+ADD_SIGNALS_IMPL_WRAPPER(NotifyAuthListChanged);
+ADD_SIGNALS_IMPL_WRAPPER(NotifyStakeAttempt);
 
 bool CClientUIInterface::ThreadSafeMessageBox(const bilingual_str& message, const std::string& caption, unsigned int style) { return g_ui_signals.ThreadSafeMessageBox(message, caption, style).value_or(false);}
 bool CClientUIInterface::ThreadSafeQuestion(const bilingual_str& message, const std::string& non_interactive_message, const std::string& caption, unsigned int style) { return g_ui_signals.ThreadSafeQuestion(message, non_interactive_message, caption, style).value_or(false);}
@@ -56,6 +64,10 @@ void CClientUIInterface::ShowProgress(const std::string& title, int nProgress, b
 void CClientUIInterface::NotifyBlockTip(SynchronizationState s, const CBlockIndex* i) { return g_ui_signals.NotifyBlockTip(s, i); }
 void CClientUIInterface::NotifyHeaderTip(SynchronizationState s, int64_t height, int64_t timestamp, bool presync) { return g_ui_signals.NotifyHeaderTip(s, height, timestamp, presync); }
 void CClientUIInterface::BannedListChanged() { return g_ui_signals.BannedListChanged(); }
+void CClientUIInterface::NotifyJobFinished(const node::JobInfo& job) { return g_ui_signals.NotifyJobFinished(job); }
+void CClientUIInterface::NotifyAssetConfirmed(const std::string& uuid, int height) { return g_ui_signals.NotifyAssetConfirmed(uuid, height); }
+void CClientUIInterface::NotifyAuthListChanged(const uint160& member, bool added) { return g_ui_signals.NotifyAuthListChanged(member, added); }
+void CClientUIInterface::NotifyStakeAttempt(const StakeAttempt& attempt) { return g_ui_signals.NotifyStakeAttempt(attempt); }
 
 bool InitError(const bilingual_str& str)
 {
@@ -12,7 +12,13 @@
 
 class CBlockIndex;
 enum class SynchronizationState;
+struct StakeAttempt;
 struct bilingual_str;
+class uint160;
+
+namespace node {
+struct JobInfo;
+} // namespace node
 
 namespace boost {
 namespace signals2 {
@@ -109,6 +115,18 @@ public:
 
     /** Banlist did change. */
     ADD_SIGNALS_DECL_WRAPPER(BannedListChanged, void, void);
+
+    /** A background job has finished, been cancelled or failed. */
+    ADD_SIGNALS_DECL_WRAPPER(NotifyJobFinished, void, const node::JobInfo& job);
+
+    /** Every chunk of a stored asset, header included, has been mined. */
+    ADD_SIGNALS_DECL_WRAPPER(NotifyAssetConfirmed, void, const std::string& uuid, int height);
+
+    /** A member was added to or removed from the storage authlist. */
+    ADD_SIGNALS_DECL_WRAPPER(NotifyAuthListChanged, void, const uint160& member, bool added);
+
+    /** A stake thread finished searching the coins of a wallet. */
+    ADD_SIGNALS_DECL_WRAPPER(NotifyStakeAttempt, void, const StakeAttempt& attempt);
 };
 
 /** Show warning message **/
@@ -26,7 +26,9 @@
 #include <node/coin.h>
 #include <node/context.h>
 #include <node/interface_ui.h>
+#include <node/jobs.h>
 #include <node/transaction.h>
+#include <opfile/src/protocol.h>
 #include <policy/feerate.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
@@ -37,6 +39,8 @@
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <shutdown.h>
+#include <storage/util.h>
+#include <storage/worker.h>
 #include <support/allocators/secure.h>
 #include <sync.h>
 #include <txmempool.h>
@@ -68,6 +72,8 @@ using interfaces::MakeSignalHandler;
 using interfaces::Node;
 using interfaces::WalletLoader;
 
+extern uint160 authUser;
+
 namespace node {
 // All members of the classes in this namespace are intentionally public, as the
 // classes themselves are private.
@@ -330,6 +336,25 @@ public:
     {
         return BroadcastTransaction(*m_context, std::move(tx), err_string, max_tx_fee, /*relay=*/ true, /*wait_callback=*/ false);
     }
+    std::string listStorageAssets(int count, const std::string& cursor) override
+    {
+        return add_list_task(count, cursor, authUser.ToString());
+    }
+    std::string fetchStorageAsset(const std::string& uuid, const std::string& path) override
+    {
+        std::string dir{path};
+        if (uuid.size() != OPENCODING_UUID * 2 || !does_path_exist(dir)) return "";
+        return add_get_task({uuid, path}, JobPriority::NORMAL, authUser.ToString());
+    }
+    std::optional<JobInfo> getJob(const std::string& id) override
+    {
+        if (!g_job_queue) return std::nullopt;
+        return g_job_queue->Get(id);
+    }
+    bool cancelJob(const std::string& id) override
+    {
+        return g_job_queue && g_job_queue->Cancel(id);
+    }
     WalletLoader& walletLoader() override
     {
         return *Assert(m_context->wallet_loader);
@@ -403,7 +428,7 @@ bool FillBlock(const CBlockIndex* index, const FoundBlock& block, UniqueLock<Rec
     if (block.m_max_time) *block.m_max_time = index->GetBlockTimeMax();
     if (block.m_mtp_time) *block.m_mtp_time = index->GetMedianTimePast();
     if (block.m_in_active_chain) *block.m_in_active_chain = active[index->nHeight] == index;
-    if (block.m_locator) { *block.m_locator = GetLocator(index); }
+    if (block.m_locator) { *block.m_locator = active.GetLocator(index); }
     if (block.m_next_block) FillBlock(active[index->nHeight] == index ? active[index->nHeight + 1] : nullptr, *block.m_next_block, lock, active);
     if (block.m_data) {
         REVERSE_LOCK(lock);
@@ -449,7 +474,8 @@ public:
     explicit NotificationsHandlerImpl(std::shared_ptr<Chain::Notifications> notifications)
         : m_proxy(std::make_shared<NotificationsProxy>(std::move(notifications)))
     {
-        RegisterSharedValidationInterface(m_proxy);
+        // On a lane of its own, so that the wallet does not wait for indexes or storage
+        RegisterSharedValidationInterface(m_proxy, /*lane=*/"wallet");
     }
     ~NotificationsHandlerImpl() override { disconnect(); }
     void disconnect() override
@@ -530,7 +556,7 @@ public:
     {
         LOCK(::cs_main);
         const CBlockIndex* index = chainman().m_blockman.LookupBlockIndex(block_hash);
-        return GetLocator(index);
+        return chainman().ActiveChain().GetLocator(index);
     }
     std::optional<int> findLocatorFork(const CBlockLocator& locator) override
     {
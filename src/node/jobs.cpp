@@ -0,0 +1,374 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/jobs.h>
+
+#include <logging.h>
+#include <memusage.h>
+#include <node/interface_ui.h>
+#include <random.h>
+#include <tinyformat.h>
+#include <util/thread.h>
+#include <util/time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <utility>
+
+namespace node {
+std::unique_ptr<JobQueue> g_job_queue;
+
+/** What the thread running a job and the queue share of it */
+struct JobControl {
+    std::atomic<int64_t> progress_done{0};
+    std::atomic<int64_t> progress_total{0};
+    std::atomic<bool> cancel{false};
+    //! What JobYield() needs of the job, set when it is submitted
+    JobQueue* queue{nullptr};
+    JobPriority priority{JobPriority::NORMAL};
+    bool large{false};
+};
+
+//! Control of the job running on this thread
+static thread_local std::shared_ptr<JobControl> g_current_job;
+
+std::string JobStateString(JobState state)
+{
+    switch (state) {
+    case JobState::QUEUED: return "queued";
+    case JobState::RUNNING: return "running";
+    case JobState::DONE: return "done";
+    case JobState::FAILED: return "failed";
+    case JobState::CANCELLED: return "cancelled";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+std::optional<JobPriority> JobPriorityFromString(const std::string& str)
+{
+    if (str == "low") return JobPriority::LOW;
+    if (str == "normal") return JobPriority::NORMAL;
+    if (str == "high") return JobPriority::HIGH;
+    return std::nullopt;
+}
+
+static bool IsFinished(JobState state)
+{
+    return state == JobState::DONE || state == JobState::FAILED || state == JobState::CANCELLED;
+}
+
+JobQueue::JobQueue(std::chrono::seconds ttl, size_t max_jobs)
+    : m_ttl(ttl), m_max_jobs(max_jobs)
+{
+}
+
+JobQueue::~JobQueue()
+{
+    Interrupt();
+    Stop();
+}
+
+void JobQueue::Start(int threads)
+{
+    threads = std::max(1, threads);
+    LogPrintf("Starting %d job threads\n", threads);
+    WITH_LOCK(m_mutex, m_thread_count += threads);
+    for (int i = 0; i < threads; ++i) {
+        m_threads.emplace_back(&util::TraceThread, strprintf("job.%i", i), [this] { Run(); });
+    }
+}
+
+void JobQueue::Interrupt()
+{
+    {
+        LOCK(m_mutex);
+        m_interrupt = true;
+        for (const auto& [id, job] : m_jobs) {
+            job->control->cancel = true;
+        }
+    }
+    m_cond.notify_all();
+}
+
+void JobQueue::Stop()
+{
+    for (std::thread& thread : m_threads) {
+        if (thread.joinable()) thread.join();
+    }
+    m_threads.clear();
+}
+
+void JobQueue::Expire()
+{
+    const int64_t now{GetTime()};
+    size_t kept{m_order.size()};
+    std::deque<std::string> order;
+    for (const std::string& id : m_order) {
+        const JobInfo& info{m_jobs.at(id)->info};
+        if (IsFinished(info.state) && (info.finished + m_ttl.count() <= now || kept > m_max_jobs)) {
+            m_jobs.erase(id);
+            --kept;
+        } else {
+            order.push_back(id);
+        }
+    }
+    m_order.swap(order);
+}
+
+std::optional<std::string> JobQueue::Submit(const std::string& kind, JobFunction fn, const std::string& id, const std::string& group, JobPriority priority,
+                                            const std::string& owner, bool large)
+{
+    LOCK(m_mutex);
+    std::string job_id{id};
+    if (job_id.empty()) {
+        do {
+            job_id = strprintf("%016x", GetThreadRandomContext().rand64());
+        } while (m_jobs.count(job_id));
+    } else if (const auto it{m_jobs.find(job_id)}; it != m_jobs.end()) {
+        if (!IsFinished(it->second->info.state)) return std::nullopt;
+        // A finished job is replaced by the new one of the same id
+        m_order.erase(std::find(m_order.begin(), m_order.end(), job_id));
+    }
+
+    auto job{std::make_shared<Job>()};
+    job->info.id = job_id;
+    job->info.kind = kind;
+    job->info.submitted = GetTime();
+    job->group = group;
+    job->priority = priority;
+    job->owner = owner;
+    job->large = large;
+    job->fn = std::move(fn);
+    job->control = std::make_shared<JobControl>();
+    job->control->queue = this;
+    job->control->priority = priority;
+    job->control->large = large;
+    m_jobs[job_id] = job;
+    m_order.push_back(job_id);
+    m_queue.push_back(job_id);
+    Expire();
+    m_cond.notify_all();
+    return job_id;
+}
+
+std::optional<JobInfo> JobQueue::Get(const std::string& id)
+{
+    LOCK(m_mutex);
+    const auto it{m_jobs.find(id)};
+    if (it == m_jobs.end()) return std::nullopt;
+    const Job& job{*it->second};
+    JobInfo info{job.info};
+    info.progress_done = job.control->progress_done;
+    info.progress_total = job.control->progress_total;
+    return info;
+}
+
+std::vector<JobInfo> JobQueue::List(size_t count)
+{
+    std::vector<JobInfo> jobs;
+    LOCK(m_mutex);
+    Expire();
+    for (size_t i = m_order.size() - std::min(count, m_order.size()); i < m_order.size(); ++i) {
+        const Job& job{*m_jobs.at(m_order[i])};
+        jobs.push_back(job.info);
+        jobs.back().progress_done = job.control->progress_done;
+        jobs.back().progress_total = job.control->progress_total;
+    }
+    return jobs;
+}
+
+bool JobQueue::Cancel(const std::string& id)
+{
+    LOCK(m_mutex);
+    const auto it{m_jobs.find(id)};
+    if (it == m_jobs.end()) return false;
+    Job& job{*it->second};
+    if (job.info.state == JobState::QUEUED) {
+        m_queue.erase(std::find(m_queue.begin(), m_queue.end(), id));
+        job.info.state = JobState::CANCELLED;
+        job.info.finished = GetTime();
+        job.fn = nullptr;
+        // A job of its group may be next
+        m_cond.notify_all();
+        return true;
+    }
+    if (job.info.state != JobState::RUNNING) return false;
+    job.control->cancel = true;
+    return true;
+}
+
+std::map<std::string, JobCounts> JobQueue::Count()
+{
+    std::map<std::string, JobCounts> counts;
+    LOCK(m_mutex);
+    for (const auto& [id, job] : m_jobs) {
+        if (job->info.state == JobState::QUEUED) ++counts[job->info.kind].queued;
+        if (job->info.state == JobState::RUNNING) ++counts[job->info.kind].running;
+    }
+    return counts;
+}
+
+//! Memory held by a value beyond the UniValue itself
+static size_t UniValueDynamicUsage(const UniValue& value)
+{
+    size_t usage{memusage::DynamicUsage(value.getValStr()) + memusage::DynamicUsage(value.getKeys()) + memusage::DynamicUsage(value.getValues())};
+    for (const std::string& key : value.getKeys()) usage += memusage::DynamicUsage(key);
+    for (const UniValue& child : value.getValues()) usage += UniValueDynamicUsage(child);
+    return usage;
+}
+
+size_t JobQueue::DynamicMemoryUsage()
+{
+    LOCK(m_mutex);
+    size_t usage{memusage::DynamicUsage(m_jobs) + memusage::DynamicUsage(m_order) + memusage::DynamicUsage(m_queue) + memusage::DynamicUsage(m_busy_groups) + memusage::DynamicUsage(m_running_owners)};
+    for (const auto& [id, job] : m_jobs) {
+        usage += memusage::DynamicUsage(id) + memusage::DynamicUsage(job) + memusage::DynamicUsage(job->control);
+        usage += memusage::DynamicUsage(job->info.id) + memusage::DynamicUsage(job->info.kind) + memusage::DynamicUsage(job->info.error) + memusage::DynamicUsage(job->group) + memusage::DynamicUsage(job->owner);
+        usage += UniValueDynamicUsage(job->info.result);
+    }
+    for (const std::string& id : m_order) usage += memusage::DynamicUsage(id);
+    for (const std::string& id : m_queue) usage += memusage::DynamicUsage(id);
+    for (const auto& [owner, running] : m_running_owners) usage += memusage::DynamicUsage(owner);
+    return usage;
+}
+
+std::deque<std::string>::iterator JobQueue::Next(const JobControl* current)
+{
+    const auto running{[&](const Job& job) EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        const auto it{m_running_owners.find(job.owner)};
+        return it == m_running_owners.end() ? 0 : it->second;
+    }};
+    // Large jobs keep off the last thread, so that short ones never queue behind them all
+    const bool large_full{m_thread_count > 1 && m_running_large >= m_thread_count - 1};
+    auto next{m_queue.end()};
+    for (auto it{m_queue.begin()}; it != m_queue.end(); ++it) {
+        const Job& candidate{*m_jobs.at(*it)};
+        if (!candidate.group.empty() && m_busy_groups.count(candidate.group)) continue;
+        if (current) {
+            // What runs in the stead of a job must be short, and held up by it
+            if (candidate.large) continue;
+            if (!current->large && candidate.priority <= current->priority) continue;
+        } else if (candidate.large && large_full) {
+            continue;
+        }
+        if (next == m_queue.end()) {
+            next = it;
+            continue;
+        }
+        // Among jobs of one priority, the owner with the fewest jobs running goes first
+        const Job& best{*m_jobs.at(*next)};
+        if (candidate.priority > best.priority || (candidate.priority == best.priority && running(candidate) < running(best))) next = it;
+    }
+    return next;
+}
+
+std::shared_ptr<JobQueue::Job> JobQueue::Take(std::deque<std::string>::iterator it)
+{
+    auto job{m_jobs.at(*it)};
+    m_queue.erase(it);
+    job->info.state = JobState::RUNNING;
+    job->info.started = GetTime();
+    if (!job->group.empty()) m_busy_groups.insert(job->group);
+    ++m_running_owners[job->owner];
+    if (job->large) ++m_running_large;
+    return job;
+}
+
+void JobQueue::Execute(const std::shared_ptr<Job>& job)
+{
+    JobState state{JobState::DONE};
+    UniValue result;
+    std::string error;
+    // A job run by JobYield() stands in for the one that yielded, until it returns
+    const auto outer{std::exchange(g_current_job, job->control)};
+    try {
+        result = job->fn();
+    } catch (const UniValue& e) {
+        // As thrown by JSONRPCError
+        state = JobState::FAILED;
+        const UniValue& message{find_value(e, "message")};
+        error = message.isStr() ? message.get_str() : e.write();
+    } catch (const std::exception& e) {
+        state = JobState::FAILED;
+        error = e.what();
+    }
+    g_current_job = outer;
+    if (job->control->cancel) state = JobState::CANCELLED;
+
+    JobInfo finished;
+    {
+        LOCK(m_mutex);
+        job->info.state = state;
+        job->info.finished = GetTime();
+        if (state == JobState::FAILED) job->info.error = std::move(error);
+        job->fn = nullptr;
+        if (!job->group.empty()) m_busy_groups.erase(job->group);
+        if (--m_running_owners[job->owner] == 0) m_running_owners.erase(job->owner);
+        if (job->large) --m_running_large;
+        // Listeners are told of the outcome, the result is left to getjob
+        finished = job->info;
+        if (state == JobState::DONE) job->info.result = std::move(result);
+    }
+    m_cond.notify_all();
+    uiInterface.NotifyJobFinished(finished);
+}
+
+void JobQueue::Run()
+{
+    while (true) {
+        // Wait for the next job that can run, jobs of a group one at a time
+        std::shared_ptr<Job> job;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            std::deque<std::string>::iterator it;
+            ++m_idle_threads;
+            m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                if (m_interrupt) return true;
+                it = Next(/*current=*/nullptr);
+                return it != m_queue.end();
+            });
+            --m_idle_threads;
+            if (m_interrupt) return;
+            job = Take(it);
+        }
+        Execute(job);
+    }
+}
+
+bool JobQueue::RunWaiting(const JobControl& current)
+{
+    std::shared_ptr<Job> job;
+    {
+        LOCK(m_mutex);
+        // A thread waiting for work takes any job that can run
+        if (m_interrupt || m_idle_threads > 0) return false;
+        const auto it{Next(&current)};
+        if (it == m_queue.end()) return false;
+        job = Take(it);
+    }
+    Execute(job);
+    return true;
+}
+
+void SetJobProgress(int64_t done, int64_t total)
+{
+    if (!g_current_job) return;
+    g_current_job->progress_done = done;
+    g_current_job->progress_total = total;
+}
+
+bool JobCancelRequested()
+{
+    return g_current_job && g_current_job->cancel;
+}
+
+bool JobYield()
+{
+    const auto current{g_current_job};
+    if (!current || !current->queue || current->cancel) return false;
+    return current->queue->RunWaiting(*current);
+}
+} // namespace node
@@ -0,0 +1,183 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_JOBS_H
+#define BITCOIN_NODE_JOBS_H
+
+#include <sync.h>
+#include <univalue.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace node {
+//! Default number of jobs run at once
+static constexpr int DEFAULT_JOB_THREADS{2};
+//! Default time a finished job is kept for its result
+static constexpr std::chrono::seconds DEFAULT_JOB_TTL{std::chrono::hours{1}};
+//! Most jobs kept, finished ones are dropped oldest first past this
+static constexpr size_t MAX_JOBS_KEPT{1000};
+
+enum class JobState {
+    QUEUED,
+    RUNNING,
+    DONE,
+    FAILED,
+    CANCELLED,
+};
+
+std::string JobStateString(JobState state);
+
+/** Which of the jobs waiting runs first, oldest first among those of one priority */
+enum class JobPriority {
+    LOW,
+    NORMAL,
+    //! Short control work, such as starting the stake threads, which should not wait behind scans
+    HIGH,
+};
+
+//! Parse "low", "normal" or "high", as callers name a priority
+std::optional<JobPriority> JobPriorityFromString(const std::string& str);
+
+/** A job as last seen by the queue */
+struct JobInfo {
+    std::string id;
+    std::string kind;
+    JobState state{JobState::QUEUED};
+    int64_t progress_done{0};
+    int64_t progress_total{0};
+    //! What the job returned, once DONE
+    UniValue result;
+    //! Why the job failed, once FAILED
+    std::string error;
+    int64_t submitted{0};
+    int64_t started{0};
+    int64_t finished{0};
+};
+
+/** Jobs of one kind waiting for a thread, and running */
+struct JobCounts {
+    size_t queued{0};
+    size_t running{0};
+};
+
+struct JobControl;
+
+/** Runs a job. It returns its result, and throws to fail with the message of what it threw. */
+using JobFunction = std::function<UniValue()>;
+
+/**
+ * Runs long work, such as chain scans, on a bounded pool of threads shared by
+ * the subsystems of the node, off the threads of the callers that submit it.
+ * Waiting jobs start by priority, then those of the owner with the fewest jobs
+ * running, then in the order submitted. Large jobs, such as big uploads, never
+ * take the last free thread, so short ones never queue behind them all, and
+ * may let a waiting job that should not wait run between their steps with
+ * JobYield(). Each job gets an id its submitter
+ * polls for progress and, once it has finished, its result, which is kept for
+ * a while after. Jobs are cancelled by asking them to stop: a job checks
+ * JobCancelRequested() where it can stop cleanly.
+ */
+class JobQueue
+{
+public:
+    explicit JobQueue(std::chrono::seconds ttl = DEFAULT_JOB_TTL, size_t max_jobs = MAX_JOBS_KEPT);
+    ~JobQueue();
+
+    void Start(int threads);
+    /// Stop starting jobs, and ask those running to stop.
+    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /// Wait for the threads to exit. Jobs still queued are dropped.
+    void Stop();
+
+    /**
+     * Queue fn and return the id it is known by: id if given, a new random one otherwise.
+     * Jobs of the same non-empty group run one at a time, by priority then in the order submitted.
+     * owner, such as the tenant a job is for, shares the threads fairly with the other owners.
+     * large jobs leave a thread to the others, when there is more than one.
+     * Returns nullopt if a job with the given id has not finished yet.
+     */
+    std::optional<std::string> Submit(const std::string& kind, JobFunction fn, const std::string& id = "", const std::string& group = "", JobPriority priority = JobPriority::NORMAL,
+                                      const std::string& owner = "", bool large = false) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    std::optional<JobInfo> Get(const std::string& id) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /// The count most recently submitted jobs, oldest first.
+    std::vector<JobInfo> List(size_t count) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /// Cancel a job, at once if it is still queued. Returns false if there is no such job or it has finished.
+    bool Cancel(const std::string& id) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /// Jobs not finished yet, by kind.
+    std::map<std::string, JobCounts> Count() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /// Memory held by the jobs kept and their results, less what the functions of those queued capture.
+    size_t DynamicMemoryUsage() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Job {
+        JobInfo info;
+        std::string group;
+        JobPriority priority{JobPriority::NORMAL};
+        std::string owner;
+        bool large{false};
+        JobFunction fn;
+        //! Shared with the thread running the job
+        std::shared_ptr<JobControl> control;
+    };
+
+    void Run() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /// The waiting job to start next, of those that should not wait behind current if given, or m_queue.end().
+    std::deque<std::string>::iterator Next(const JobControl* current) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /// Take a waiting job off the queue as started.
+    std::shared_ptr<Job> Take(std::deque<std::string>::iterator it) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /// Run a job taken on this thread, and record how it finished.
+    void Execute(const std::shared_ptr<Job>& job) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /// Run a waiting job that should not wait behind current on this thread, if no thread is free for it.
+    bool RunWaiting(const JobControl& current) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    friend bool JobYield();
+    void Expire() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    const std::chrono::seconds m_ttl;
+    const size_t m_max_jobs;
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_interrupt GUARDED_BY(m_mutex){false};
+    //! Every job kept, and the ids in the order submitted
+    std::map<std::string, std::shared_ptr<Job>> m_jobs GUARDED_BY(m_mutex);
+    std::deque<std::string> m_order GUARDED_BY(m_mutex);
+    //! Ids of the jobs waiting to run, oldest first
+    std::deque<std::string> m_queue GUARDED_BY(m_mutex);
+    //! Groups with a job running
+    std::set<std::string> m_busy_groups GUARDED_BY(m_mutex);
+    //! Jobs running by owner, and large jobs running
+    std::map<std::string, int> m_running_owners GUARDED_BY(m_mutex);
+    int m_running_large GUARDED_BY(m_mutex){0};
+    int m_thread_count GUARDED_BY(m_mutex){0};
+    //! Threads waiting for a job they can start
+    int m_idle_threads GUARDED_BY(m_mutex){0};
+    std::vector<std::thread> m_threads;
+};
+
+/// Report progress of the job running on this thread, if it runs on a JobQueue.
+void SetJobProgress(int64_t done, int64_t total);
+
+/// Whether the job running on this thread has been asked to stop.
+bool JobCancelRequested();
+
+/// Between steps of a large job, run a job of higher priority or a small one waiting for a thread
+/// on this thread, if no other thread is free for it. Returns whether one ran.
+bool JobYield();
+
+extern std::unique_ptr<JobQueue> g_job_queue;
+} // namespace node
+
+#endif // BITCOIN_NODE_JOBS_H
@@ -0,0 +1,139 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/memorybudget.h>
+
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <txdb.h>
+#include <txmempool.h>
+#include <util/strencodings.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace node {
+std::unique_ptr<MemoryBudget> g_memory_budget;
+
+//! Scale the targets are multiplied by on each check over budget, and divided by once under
+static constexpr double SCALE_STEP{0.75};
+//! The caches are not scaled below this share of their targets
+static constexpr double MIN_SCALE{0.25};
+//! Share of the budget the memory in use must be under for the caches to grow back
+static constexpr double GROW_BELOW{0.8};
+//! Share of the budget at which the caches shrink, when there is no pressure reported first
+static constexpr double SHRINK_ABOVE{0.95};
+
+MemoryBudget::MemoryBudget(ChainstateManager& chainman, CTxMemPool& mempool, const CacheLimits& targets, int64_t budget_bytes, int64_t min_mempool_bytes)
+    : m_chainman{chainman}, m_mempool{mempool}, m_budget_bytes{budget_bytes}, m_min_mempool_bytes{min_mempool_bytes}, m_targets{targets}, m_applied{targets}
+{
+}
+
+void MemoryBudget::Apply()
+{
+    CacheLimits limits;
+    // The coins cache is kept at least as large as the smallest -dbcache would make it
+    limits.coins_cache = std::max<int64_t>(m_targets.coins_cache * m_scale, std::min<int64_t>(m_targets.coins_cache, nMinDbCache << 20));
+    limits.max_mempool = std::max<int64_t>(m_targets.max_mempool * m_scale, m_min_mempool_bytes);
+    limits.max_storage_mempool = m_targets.max_storage_mempool * m_scale;
+    limits.block_cache = m_targets.block_cache * m_scale;
+
+    if (limits.coins_cache != m_applied.coins_cache) {
+        LOCK(::cs_main);
+        m_chainman.m_total_coinstip_cache = limits.coins_cache;
+        m_chainman.MaybeRebalanceCaches();
+    }
+    if (limits.max_mempool != m_applied.max_mempool || limits.max_storage_mempool != m_applied.max_storage_mempool) {
+        LOCK2(::cs_main, m_mempool.cs);
+        std::vector<COutPoint> no_spends_remaining;
+        m_mempool.SetMaxSize(limits.max_mempool, limits.max_storage_mempool, &no_spends_remaining);
+        for (const COutPoint& removed : no_spends_remaining) {
+            m_chainman.ActiveChainstate().CoinsTip().Uncache(removed);
+        }
+    }
+    if (limits.block_cache != m_applied.block_cache) {
+        g_block_cache.SetMaxBytes(limits.block_cache);
+    }
+    m_applied = limits;
+}
+
+void MemoryBudget::SetTargets(const CacheLimits& targets)
+{
+    LOCK(m_mutex);
+    m_targets = targets;
+    Apply();
+}
+
+void MemoryBudget::Check()
+{
+    if (m_budget_bytes <= 0) return;
+    const std::optional<int64_t> used{ReadMemoryUsed()};
+    const std::optional<double> pressure{ReadMemoryPressure()};
+
+    LOCK(m_mutex);
+    m_memory_used = used;
+    m_pressure = pressure;
+    const bool over{(used && *used > m_budget_bytes * SHRINK_ABOVE) || (pressure && *pressure >= MEMORY_PRESSURE_SHRINK)};
+    const bool under{(!used || *used < m_budget_bytes * GROW_BELOW) && (!pressure || *pressure < MEMORY_PRESSURE_SHRINK / 2)};
+    const double old_scale{m_scale};
+    if (over) {
+        m_scale = std::max(MIN_SCALE, m_scale * SCALE_STEP);
+    } else if (under) {
+        m_scale = std::min(1.0, m_scale / SCALE_STEP);
+    }
+    if (m_scale == old_scale) return;
+
+    if (m_scale < old_scale) {
+        ++m_shrinks;
+    } else {
+        ++m_grows;
+    }
+    LogPrintf("Memory budget: %s caches to %.0f%% of their targets (%.1f MiB in use of %.1f MiB, pressure %.2f%%)\n",
+              m_scale < old_scale ? "shrinking" : "growing", m_scale * 100,
+              used.value_or(0) * (1.0 / 1024 / 1024), m_budget_bytes * (1.0 / 1024 / 1024), pressure.value_or(0));
+    Apply();
+}
+
+MemoryBudgetStats MemoryBudget::GetStats() const
+{
+    LOCK(m_mutex);
+    return {m_targets, m_applied, m_budget_bytes, m_scale, m_memory_used, m_pressure, m_shrinks, m_grows};
+}
+
+std::optional<int64_t> ReadMemoryUsed()
+{
+#ifdef __linux__
+    // Pages resident, the second field of statm. The page cache of the
+    // cgroup is left out, as the kernel reclaims it before the process.
+    std::ifstream statm{"/proc/self/statm"};
+    int64_t pages{0}, resident{0};
+    if (statm >> pages >> resident) return resident * sysconf(_SC_PAGESIZE);
+#endif
+    return std::nullopt;
+}
+
+std::optional<double> ReadMemoryPressure()
+{
+#ifdef __linux__
+    // The cgroup of the process under cgroup v2, mounted at its root in a container, else the system
+    for (const char* path : {"/sys/fs/cgroup/memory.pressure", "/proc/pressure/memory"}) {
+        std::ifstream file{path};
+        std::string kind, avg10;
+        // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+        int64_t hundredths{0};
+        if (file >> kind >> avg10 && kind == "some" && avg10.rfind("avg10=", 0) == 0 && ParseFixedPoint(avg10.substr(6), 2, &hundredths)) {
+            return hundredths / 100.0;
+        }
+    }
+#endif
+    return std::nullopt;
+}
+} // namespace node
@@ -0,0 +1,111 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_MEMORYBUDGET_H
+#define BITCOIN_NODE_MEMORYBUDGET_H
+
+#include <sync.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+class ChainstateManager;
+class CTxMemPool;
+
+namespace node {
+//! Default for -memorybudget, in MiB, 0 to leave the cache sizes as given
+static constexpr int64_t DEFAULT_MEMORY_BUDGET{0};
+//! How often the memory in use is checked against -memorybudget
+static constexpr std::chrono::seconds MEMORY_BUDGET_INTERVAL{5};
+//! Share of time stalled on memory (the avg10 of memory.pressure, in percent) at which caches shrink
+static constexpr double MEMORY_PRESSURE_SHRINK{10.0};
+
+/** Sizes in bytes of the caches that take most of the memory of a node */
+struct CacheLimits {
+    //! In-memory coins cache of the chainstates, the part of -dbcache not given to databases
+    int64_t coins_cache{0};
+    //! -maxmempool
+    int64_t max_mempool{0};
+    //! -maxstoragemempool
+    int64_t max_storage_mempool{0};
+    //! -blockcachesize
+    int64_t block_cache{0};
+};
+
+struct MemoryBudgetStats {
+    //! The sizes asked for, at startup or by setcachesizes
+    CacheLimits targets;
+    //! The sizes in use, the targets scaled down under memory pressure
+    CacheLimits applied;
+    //! -memorybudget in bytes, 0 when the sizes are not adjusted
+    int64_t budget{0};
+    //! Share of the targets applied
+    double scale{1.0};
+    //! Last readings, when the platform reports them
+    std::optional<int64_t> memory_used;
+    std::optional<double> pressure;
+    uint64_t shrinks{0};
+    uint64_t grows{0};
+};
+
+/**
+ * Sizes of the coins cache, the mempool and the block cache, which may change
+ * while the node runs.
+ *
+ * The targets start out as -dbcache, -maxmempool, -maxstoragemempool and
+ * -blockcachesize gave them, and setcachesizes changes them. With a
+ * -memorybudget, Check() runs periodically and scales all of them down
+ * together as the process nears the budget or the kernel reports memory
+ * pressure, and back up once both subside. Shrinking the coins cache flushes
+ * it, and shrinking the mempool evicts its lowest feerate packages.
+ */
+class MemoryBudget
+{
+private:
+    ChainstateManager& m_chainman;
+    CTxMemPool& m_mempool;
+    const int64_t m_budget_bytes;
+    //! The mempool is not shrunk below this, as -maxmempool must not be either
+    const int64_t m_min_mempool_bytes;
+
+    mutable Mutex m_mutex;
+    CacheLimits m_targets GUARDED_BY(m_mutex);
+    CacheLimits m_applied GUARDED_BY(m_mutex);
+    double m_scale GUARDED_BY(m_mutex){1.0};
+    std::optional<int64_t> m_memory_used GUARDED_BY(m_mutex);
+    std::optional<double> m_pressure GUARDED_BY(m_mutex);
+    uint64_t m_shrinks GUARDED_BY(m_mutex){0};
+    uint64_t m_grows GUARDED_BY(m_mutex){0};
+
+    //! Resize the caches whose scaled target differs from the size applied
+    void Apply() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+public:
+    MemoryBudget(ChainstateManager& chainman, CTxMemPool& mempool, const CacheLimits& targets, int64_t budget_bytes, int64_t min_mempool_bytes);
+
+    int64_t MinMempoolBytes() const { return m_min_mempool_bytes; }
+
+    /** Change the targets and resize the caches to them, as scaled at the moment. */
+    void SetTargets(const CacheLimits& targets) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Compare the memory in use to the budget and scale the caches. Called periodically on the scheduler thread. */
+    void Check() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    MemoryBudgetStats GetStats() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+/** Memory charged to the process: resident set size. Only known on Linux. */
+std::optional<int64_t> ReadMemoryUsed();
+
+/** The avg10 of "some" memory pressure of the cgroup, or of the system, in
+ *  percent of time stalled. Only known on Linux with pressure stall information. */
+std::optional<double> ReadMemoryPressure();
+
+/// The global cache sizes. Null until the chainstate is loaded.
+extern std::unique_ptr<MemoryBudget> g_memory_budget;
+} // namespace node
+
+#endif // BITCOIN_NODE_MEMORYBUDGET_H
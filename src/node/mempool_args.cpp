@@ -35,6 +35,10 @@ void ApplyArgsManOptions(const ArgsManager& argsman, MemPoolLimits& mempool_limi
     mempool_limits.descendant_count = argsman.GetIntArg("-limitdescendantcount", mempool_limits.descendant_count);
 
     if (auto vkb = argsman.GetIntArg("-limitdescendantsize")) mempool_limits.descendant_size_vbytes = *vkb * 1'000;
+
+    mempool_limits.storage_chain_count = argsman.GetIntArg("-limitstoragechaincount", mempool_limits.storage_chain_count);
+
+    if (auto vkb = argsman.GetIntArg("-limitstoragechainsize")) mempool_limits.storage_chain_size_vbytes = *vkb * 1'000;
 }
 }
 
@@ -44,6 +48,8 @@ std::optional<bilingual_str> ApplyArgsManOptions(const ArgsManager& argsman, con
 
     if (auto mb = argsman.GetIntArg("-maxmempool")) mempool_opts.max_size_bytes = *mb * 1'000'000;
 
+    if (auto mb = argsman.GetIntArg("-maxstoragemempool")) mempool_opts.max_storage_size_bytes = *mb * 1'000'000;
+
     if (auto hours = argsman.GetIntArg("-mempoolexpiry")) mempool_opts.expiry = std::chrono::hours{*hours};
 
     // incremental relay fee sets the minimum feerate increase necessary for replacement in the mempool
@@ -0,0 +1,201 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/metrics.h>
+
+#include <blocktime.h>
+#include <httpserver.h>
+#include <net.h>
+#include <node/context.h>
+#include <node/jobs.h>
+#include <pos/minter.h>
+#include <rpc/server.h>
+#include <sync.h>
+#include <tinyformat.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <chrono>
+#include <memory>
+
+namespace node {
+namespace {
+void AddHeader(std::string& out, const std::string& name, const std::string& type, const std::string& help)
+{
+    out += strprintf("# HELP %s %s\n", name, help);
+    out += strprintf("# TYPE %s %s\n", name, type);
+}
+
+double Seconds(std::chrono::nanoseconds d) { return std::chrono::duration<double>(d).count(); }
+
+void AddRPCMetrics(std::string& out)
+{
+    const auto method_stats{GetRPCMethodStats()};
+    AddHeader(out, "lynx_rpc_duration_seconds", "histogram", "Duration of RPC calls, by method.");
+    for (const auto& [method, stats] : method_stats) {
+        uint64_t count{0};
+        for (size_t i = 0; i < RPC_LATENCY_BUCKETS_US.size(); ++i) {
+            count += stats.buckets[i];
+            out += strprintf("lynx_rpc_duration_seconds_bucket{method=\"%s\",le=\"%g\"} %u\n", method, RPC_LATENCY_BUCKETS_US[i] / 1e6, count);
+        }
+        out += strprintf("lynx_rpc_duration_seconds_bucket{method=\"%s\",le=\"+Inf\"} %u\n", method, stats.calls);
+        out += strprintf("lynx_rpc_duration_seconds_sum{method=\"%s\"} %.6f\n", method, stats.total_us / 1e6);
+        out += strprintf("lynx_rpc_duration_seconds_count{method=\"%s\"} %u\n", method, stats.calls);
+    }
+    AddHeader(out, "lynx_rpc_errors_total", "counter", "RPC calls that returned an error, by method.");
+    for (const auto& [method, stats] : method_stats) {
+        out += strprintf("lynx_rpc_errors_total{method=\"%s\"} %u\n", method, stats.errors);
+    }
+    AddHeader(out, "lynx_rpc_response_bytes_total", "counter", "Bytes of RPC replies sent, by method.");
+    for (const auto& [method, stats] : method_stats) {
+        out += strprintf("lynx_rpc_response_bytes_total{method=\"%s\"} %u\n", method, stats.bytes_out);
+    }
+
+    const HTTPServerStats http{GetHTTPServerStats()};
+    AddHeader(out, "lynx_http_workers", "gauge", "Threads servicing HTTP requests.");
+    out += strprintf("lynx_http_workers %u\n", http.workers);
+    AddHeader(out, "lynx_http_queue_depth", "gauge", "HTTP requests waiting for a thread.");
+    out += strprintf("lynx_http_queue_depth %u\n", http.queue_depth);
+    AddHeader(out, "lynx_http_requests_total", "counter", "HTTP requests received.");
+    out += strprintf("lynx_http_requests_total %u\n", http.requests);
+    AddHeader(out, "lynx_http_requests_rejected_total", "counter", "HTTP requests rejected because the work queue was full.");
+    out += strprintf("lynx_http_requests_rejected_total %u\n", http.requests_rejected);
+}
+
+void AddChainMetrics(std::string& out, ChainstateManager& chainman)
+{
+    const auto tip{chainman.GetTipSnapshot()};
+    if (tip) {
+        AddHeader(out, "lynx_chain_height", "gauge", "Height of the active chain.");
+        out += strprintf("lynx_chain_height %d\n", tip->height);
+        AddHeader(out, "lynx_chain_verification_progress", "gauge", "Estimate of the fraction of the chain verified.");
+        out += strprintf("lynx_chain_verification_progress %.6f\n", tip->verification_progress);
+        AddHeader(out, "lynx_network_stake_kernels_per_second", "gauge", "Estimate of the stake kernels the network hashes a second, from the recent proof-of-stake blocks.");
+        out += strprintf("lynx_network_stake_kernels_per_second %.3f\n", tip->pos_kernel_ps);
+    }
+
+    const BlockConnectStats connect{GetBlockConnectStats()};
+    AddHeader(out, "lynx_blocks_connected_total", "counter", "Blocks connected to the active chain.");
+    out += strprintf("lynx_blocks_connected_total %d\n", connect.blocks);
+    AddHeader(out, "lynx_block_connect_seconds_total", "counter", "Time spent connecting blocks to the active chain, by stage.");
+    for (const auto& [stage, time] : {
+             std::pair{"load_block", connect.load_block},
+             {"check", connect.check},
+             {"forks", connect.forks},
+             {"connect", connect.connect},
+             {"verify", connect.verify},
+             {"undo", connect.undo},
+             {"index", connect.index},
+             {"connect_total", connect.connect_total},
+             {"flush", connect.flush},
+             {"chainstate", connect.chainstate},
+             {"post_connect", connect.post_connect},
+             {"total", connect.total},
+         }) {
+        out += strprintf("lynx_block_connect_seconds_total{stage=\"%s\"} %.6f\n", stage, Seconds(time));
+    }
+    AddHeader(out, "lynx_coins_cache_coins", "gauge", "Coins in the cache of the active chainstate.");
+    out += strprintf("lynx_coins_cache_coins %u\n", connect.coins_cache_count);
+    AddHeader(out, "lynx_coins_cache_usage_bytes", "gauge", "Memory used by the coins cache of the active chainstate.");
+    out += strprintf("lynx_coins_cache_usage_bytes %u\n", connect.coins_cache_usage);
+
+    const BlockTimeStats& block_time{chainman.ActiveChainstate().m_block_time_stats};
+    std::array<BlockTimeWindowStats, NUM_BLOCK_TIME_WINDOWS> windows;
+    for (size_t i = 0; i < NUM_BLOCK_TIME_WINDOWS; ++i) {
+        windows[i] = block_time.GetWindowStats(BlockTimeWindow(i));
+    }
+    AddHeader(out, "lynx_block_time_window_blocks", "gauge", "Blocks within each window ending at the tip.");
+    for (size_t i = 0; i < NUM_BLOCK_TIME_WINDOWS; ++i) {
+        out += strprintf("lynx_block_time_window_blocks{window=\"%s\"} %u\n", BlockTimeWindowName(BlockTimeWindow(i)), windows[i].blocks);
+    }
+    AddHeader(out, "lynx_block_interval_seconds", "gauge", "Block intervals within each complete window ending at the tip, by statistic.");
+    for (size_t i = 0; i < NUM_BLOCK_TIME_WINDOWS; ++i) {
+        if (!windows[i].complete) continue;
+        const std::string name{BlockTimeWindowName(BlockTimeWindow(i))};
+        out += strprintf("lynx_block_interval_seconds{window=\"%s\",stat=\"average\"} %.3f\n", name, windows[i].average);
+        out += strprintf("lynx_block_interval_seconds{window=\"%s\",stat=\"p10\"} %d\n", name, windows[i].p10);
+        out += strprintf("lynx_block_interval_seconds{window=\"%s\",stat=\"p50\"} %d\n", name, windows[i].p50);
+        out += strprintf("lynx_block_interval_seconds{window=\"%s\",stat=\"p90\"} %d\n", name, windows[i].p90);
+    }
+}
+
+void AddMempoolMetrics(std::string& out, const CTxMemPool& mempool)
+{
+    uint64_t bytes;
+    {
+        LOCK(mempool.cs);
+        bytes = mempool.GetTotalTxSize();
+    }
+    AddHeader(out, "lynx_mempool_transactions", "gauge", "Transactions in the mempool.");
+    out += strprintf("lynx_mempool_transactions %u\n", mempool.size());
+    AddHeader(out, "lynx_mempool_bytes", "gauge", "Sum of the virtual sizes of the transactions in the mempool.");
+    out += strprintf("lynx_mempool_bytes %u\n", bytes);
+    AddHeader(out, "lynx_mempool_usage_bytes", "gauge", "Memory used by the mempool.");
+    out += strprintf("lynx_mempool_usage_bytes %u\n", mempool.DynamicMemoryUsage());
+}
+
+void AddNetMetrics(std::string& out, const CConnman& connman)
+{
+    AddHeader(out, "lynx_peers", "gauge", "Peers connected, by direction.");
+    out += strprintf("lynx_peers{direction=\"inbound\"} %u\n", connman.GetNodeCount(ConnectionDirection::In));
+    out += strprintf("lynx_peers{direction=\"outbound\"} %u\n", connman.GetNodeCount(ConnectionDirection::Out));
+    AddHeader(out, "lynx_net_bytes_total", "counter", "Bytes exchanged with peers, by direction.");
+    out += strprintf("lynx_net_bytes_total{direction=\"sent\"} %u\n", connman.GetTotalBytesSent());
+    out += strprintf("lynx_net_bytes_total{direction=\"received\"} %u\n", connman.GetTotalBytesRecv());
+
+    mapMsgTypeSize sent, recv;
+    connman.GetBytesPerMsgType(sent, recv);
+    AddHeader(out, "lynx_net_message_bytes_total", "counter", "Bytes of the messages exchanged with peers, by direction and message type.");
+    for (const auto& [type, bytes] : sent) {
+        out += strprintf("lynx_net_message_bytes_total{direction=\"sent\",type=\"%s\"} %u\n", type, bytes);
+    }
+    for (const auto& [type, bytes] : recv) {
+        out += strprintf("lynx_net_message_bytes_total{direction=\"received\",type=\"%s\"} %u\n", type, bytes);
+    }
+}
+
+void AddStakeMetrics(std::string& out)
+{
+    const StakeStats stats{g_stake_telemetry.GetStats()};
+    AddHeader(out, "lynx_staking", "gauge", "Whether the stake threads are searching for kernels.");
+    out += strprintf("lynx_staking %d\n", fIsStaking ? 1 : 0);
+    AddHeader(out, "lynx_stake_cycles_total", "counter", "Cycles of the stake threads.");
+    out += strprintf("lynx_stake_cycles_total %u\n", stats.cycles);
+    AddHeader(out, "lynx_stake_kernel_hashes_total", "counter", "Kernel hashes computed by the stake threads.");
+    out += strprintf("lynx_stake_kernel_hashes_total %u\n", stats.kernel_hashes);
+    AddHeader(out, "lynx_staked_blocks_total", "counter", "Blocks staked.");
+    out += strprintf("lynx_staked_blocks_total %u\n", stats.staked);
+    AddHeader(out, "lynx_stake_stage_seconds_total", "counter", "Time spent by the stake threads, by stage.");
+    for (size_t i = 0; i < NUM_STAKE_STAGES; ++i) {
+        out += strprintf("lynx_stake_stage_seconds_total{stage=\"%s\"} %.6f\n", StakeStageName(StakeStage(i)), Seconds(stats.stage_time[i]));
+    }
+    AddHeader(out, "lynx_stake_sleep_seconds_total", "counter", "Time the stake threads slept, by reason.");
+    for (size_t i = 0; i < NUM_STAKE_SLEEPS; ++i) {
+        out += strprintf("lynx_stake_sleep_seconds_total{reason=\"%s\"} %.3f\n", StakeSleepName(StakeSleep(i)), Seconds(stats.sleep_time[i]));
+    }
+}
+
+void AddJobMetrics(std::string& out)
+{
+    if (!g_job_queue) return;
+    AddHeader(out, "lynx_jobs", "gauge", "Background jobs not finished yet, by kind and state.");
+    for (const auto& [kind, counts] : g_job_queue->Count()) {
+        out += strprintf("lynx_jobs{kind=\"%s\",state=\"queued\"} %u\n", kind, counts.queued);
+        out += strprintf("lynx_jobs{kind=\"%s\",state=\"running\"} %u\n", kind, counts.running);
+    }
+}
+} // namespace
+
+std::string FormatMetrics(const NodeContext& node)
+{
+    std::string out;
+    if (node.chainman) AddChainMetrics(out, *node.chainman);
+    if (node.mempool) AddMempoolMetrics(out, *node.mempool);
+    if (node.connman) AddNetMetrics(out, *node.connman);
+    AddStakeMetrics(out);
+    AddJobMetrics(out);
+    AddRPCMetrics(out);
+    return out;
+}
+} // namespace node
@@ -0,0 +1,22 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_METRICS_H
+#define BITCOIN_NODE_METRICS_H
+
+#include <string>
+
+namespace node {
+struct NodeContext;
+
+/**
+ * Counters and gauges of the node in the Prometheus text format, as served at
+ * /rest/metrics and on -metricsport. Read from what the subsystems publish for
+ * readers without cs_main, which is only taken for the moment it takes to find
+ * the active chainstate.
+ */
+std::string FormatMetrics(const NodeContext& node);
+} // namespace node
+
+#endif // BITCOIN_NODE_METRICS_H
@@ -24,6 +24,10 @@
 #include <validation.h>
 
 #include <algorithm>
+#include <limits>
+#include <queue>
+#include <set>
+#include <unordered_map>
 #include <utility>
 
 namespace node {
@@ -56,7 +60,7 @@ void RegenerateCommitments(CBlock& block, ChainstateManager& chainman)
     block.hashMerkleRoot = BlockMerkleRoot(block);
 }
 
-static BlockAssembler::Options ClampOptions(BlockAssembler::Options options)
+BlockAssembler::Options ClampOptions(BlockAssembler::Options options)
 {
     // Limit weight to between 4K and DEFAULT_BLOCK_MAX_WEIGHT for sanity:
     options.nBlockMaxWeight = std::clamp<size_t>(options.nBlockMaxWeight, 4000, DEFAULT_BLOCK_MAX_WEIGHT);
@@ -91,8 +95,6 @@ BlockAssembler::BlockAssembler(Chainstate& chainstate, const CTxMemPool* mempool
 
 void BlockAssembler::resetBlock()
 {
-    inBlock.clear();
-
     // Reserve space for coinbase tx
     nBlockWeight = 4000;
     nBlockSigOpsCost = 400;
@@ -103,6 +105,16 @@ void BlockAssembler::resetBlock()
 }
 
 std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, bool fProofOfStake)
+{
+    return AssembleBlock(scriptPubKeyIn, fProofOfStake, nullptr);
+}
+
+std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, bool fProofOfStake, const BlockTxSelection& selection)
+{
+    return AssembleBlock(scriptPubKeyIn, fProofOfStake, &selection);
+}
+
+std::unique_ptr<CBlockTemplate> BlockAssembler::AssembleBlock(const CScript& scriptPubKeyIn, bool fProofOfStake, const BlockTxSelection* selection)
 {
     const auto time_start{SteadyClock::now()};
 
@@ -123,6 +135,9 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     LOCK(::cs_main);
     CBlockIndex* pindexPrev = m_chainstate.m_chain.Tip();
     assert(pindexPrev != nullptr);
+    if (selection && selection->tip_hash != pindexPrev->GetBlockHash()) {
+        return nullptr;
+    }
     nHeight = pindexPrev->nHeight + 1;
 
     pblock->nVersion = m_chainstate.m_chainman.m_versionbitscache.ComputeBlockVersion(pindexPrev, chainparams.GetConsensus());
@@ -137,7 +152,17 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 
     int nPackagesSelected = 0;
     int nDescendantsUpdated = 0;
-    if (m_mempool) {
+    if (selection) {
+        for (size_t i = 0; i < selection->txs.size(); ++i) {
+            pblock->vtx.push_back(selection->txs[i]);
+            pblocktemplate->vTxFees.push_back(selection->fees[i]);
+            pblocktemplate->vTxSigOpsCost.push_back(selection->sigops_cost[i]);
+            nBlockWeight += GetTransactionWeight(*selection->txs[i]);
+            ++nBlockTx;
+            nBlockSigOpsCost += selection->sigops_cost[i];
+            nFees += selection->fees[i];
+        }
+    } else if (m_mempool) {
         LOCK(m_mempool->cs);
         addPackageTxs(*m_mempool, nPackagesSelected, nDescendantsUpdated);
     }
@@ -194,16 +219,144 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     return std::move(pblocktemplate);
 }
 
-void BlockAssembler::onlyUnconfirmed(CTxMemPool::setEntries& testSet)
+namespace {
+/** Whether fees_a / size_a is higher than fees_b / size_b */
+bool FeerateHigher(CAmount fees_a, uint64_t size_a, CAmount fees_b, uint64_t size_b)
+{
+    // Avoid division by rewriting (a/b > c/d) as (a*d > c*b).
+    return (double)fees_a * size_b > (double)fees_b * size_a;
+}
+} // namespace
+
+std::vector<std::vector<TxChunk>> LinearizeClusters(const CTxMemPool& mempool, const std::function<bool(const CTxMemPoolEntry&)>& is_eligible,
+                                                    int& descendants_updated)
 {
-    for (CTxMemPool::setEntries::iterator iit = testSet.begin(); iit != testSet.end(); ) {
-        // Only test txs not already in the block
-        if (inBlock.count(*iit)) {
-            testSet.erase(iit++);
-        } else {
-            iit++;
+    AssertLockHeld(mempool.cs);
+
+    std::vector<CTxMemPool::txiter> sorted;
+    sorted.reserve(mempool.mapTx.size());
+    for (auto it = mempool.mapTx.begin(); it != mempool.mapTx.end(); ++it) {
+        sorted.push_back(it);
+    }
+    // Parents before their children
+    std::sort(sorted.begin(), sorted.end(), CompareTxIterByAncestorCount());
+
+    // Number the eligible transactions, joining each one's cluster with its parents'
+    std::vector<CTxMemPool::txiter> txs;
+    std::unordered_map<const CTxMemPoolEntry*, uint32_t> tx_index;
+    std::vector<uint32_t> joined; // union-find forest, a cluster per tree
+    const auto find_root = [&](uint32_t i) {
+        while (joined[i] != i) i = joined[i] = joined[joined[i]];
+        return i;
+    };
+    for (const CTxMemPool::txiter& it : sorted) {
+        const CTxMemPoolEntry::Parents& parents{it->GetMemPoolParentsConst()};
+        if (!is_eligible(*it) || !std::all_of(parents.begin(), parents.end(), [&](const CTxMemPoolEntry& parent) { return tx_index.count(&parent) > 0; })) {
+            continue;
         }
+        const uint32_t i = txs.size();
+        txs.push_back(it);
+        tx_index.emplace(&*it, i);
+        joined.push_back(i);
+        for (const CTxMemPoolEntry& parent : parents) {
+            joined[find_root(tx_index.at(&parent))] = find_root(i);
+        }
+    }
+
+    // Cluster members, in the order numbered
+    std::vector<std::vector<uint32_t>> clusters;
+    std::unordered_map<uint32_t, size_t> cluster_index;
+    for (uint32_t i = 0; i < txs.size(); ++i) {
+        const auto [it, inserted] = cluster_index.try_emplace(find_root(i), clusters.size());
+        if (inserted) clusters.emplace_back();
+        clusters[it->second].push_back(i);
+    }
+
+    // Fees, size and sigops of each transaction with its ancestors not yet linearized
+    std::vector<CAmount> anc_fees(txs.size());
+    std::vector<uint64_t> anc_size(txs.size());
+    std::vector<int64_t> anc_sigops_cost(txs.size());
+    for (uint32_t i = 0; i < txs.size(); ++i) {
+        anc_fees[i] = txs[i]->GetModFeesWithAncestors();
+        anc_size[i] = txs[i]->GetSizeWithAncestors();
+        anc_sigops_cost[i] = txs[i]->GetSigOpCostWithAncestors();
+    }
+    std::vector<bool> linearized(txs.size(), false);
+    // Last transaction linearized when a descendant was last updated, so each is updated once per ancestor
+    std::vector<uint32_t> updated_for(txs.size(), std::numeric_limits<uint32_t>::max());
+
+    const auto better = [&](uint32_t a, uint32_t b) {
+        if (FeerateHigher(anc_fees[a], anc_size[a], anc_fees[b], anc_size[b])) return true;
+        if (FeerateHigher(anc_fees[b], anc_size[b], anc_fees[a], anc_size[a])) return false;
+        return a < b;
+    };
+
+    std::vector<std::vector<TxChunk>> result;
+    result.reserve(clusters.size());
+    for (const std::vector<uint32_t>& cluster : clusters) {
+        std::set<uint32_t, decltype(better)> candidates(cluster.begin(), cluster.end(), better);
+        std::vector<TxChunk> chunks;
+        while (!candidates.empty()) {
+            // The best candidate with its remaining ancestors
+            std::vector<uint32_t> package{*candidates.begin()};
+            candidates.erase(candidates.begin());
+            linearized[package[0]] = true;
+            for (size_t k = 0; k < package.size(); ++k) {
+                for (const CTxMemPoolEntry& parent : txs[package[k]]->GetMemPoolParentsConst()) {
+                    const uint32_t p{tx_index.at(&parent)};
+                    if (linearized[p]) continue;
+                    candidates.erase(p);
+                    linearized[p] = true;
+                    package.push_back(p);
+                }
+            }
+            std::sort(package.begin(), package.end());
+
+            for (const uint32_t i : package) {
+                const CTxMemPoolEntry& entry{*txs[i]};
+
+                // Take it out of the ancestor state of its remaining descendants
+                std::vector<uint32_t> descendants{i};
+                for (size_t k = 0; k < descendants.size(); ++k) {
+                    for (const CTxMemPoolEntry& child : txs[descendants[k]]->GetMemPoolChildrenConst()) {
+                        const auto child_it{tx_index.find(&child)};
+                        if (child_it == tx_index.end()) continue;
+                        const uint32_t c{child_it->second};
+                        if (updated_for[c] == i) continue;
+                        updated_for[c] = i;
+                        descendants.push_back(c);
+                        // Only the rest of the package is linearized already
+                        if (linearized[c]) continue;
+                        candidates.erase(c);
+                        anc_fees[c] -= entry.GetModifiedFee();
+                        anc_size[c] -= entry.GetTxSize();
+                        anc_sigops_cost[c] -= entry.GetSigOpCost();
+                        candidates.insert(c);
+                        ++descendants_updated;
+                    }
+                }
+
+                // Merge it into the chunks before it for as long as it raises their feerate
+                TxChunk chunk;
+                chunk.txs.push_back(txs[i]);
+                chunk.fees = entry.GetModifiedFee();
+                chunk.size = entry.GetTxSize();
+                chunk.sigops_cost = entry.GetSigOpCost();
+                while (!chunks.empty() && FeerateHigher(chunk.fees, chunk.size, chunks.back().fees, chunks.back().size)) {
+                    TxChunk& prev{chunks.back()};
+                    prev.txs.insert(prev.txs.end(), chunk.txs.begin(), chunk.txs.end());
+                    prev.fees += chunk.fees;
+                    prev.size += chunk.size;
+                    prev.sigops_cost += chunk.sigops_cost;
+                    chunk = std::move(prev);
+                    chunks.pop_back();
+                }
+                chunks.push_back(std::move(chunk));
+            }
+        }
+        result.push_back(std::move(chunks));
     }
+    return result;
 }
 
 bool BlockAssembler::TestPackage(uint64_t packageSize, int64_t packageSigOpsCost) const
@@ -218,18 +371,6 @@ bool BlockAssembler::TestPackage(uint64_t packageSize, int64_t packageSigOpsCost
     return true;
 }
 
-// Perform transaction-level checks before adding to block:
-// - transaction finality (locktime)
-bool BlockAssembler::TestPackageTransactions(const CTxMemPool::setEntries& package) const
-{
-    for (CTxMemPool::txiter it : package) {
-        if (!IsFinalTx(it->GetTx(), nHeight, m_lock_time_cutoff)) {
-            return false;
-        }
-    }
-    return true;
-}
-
 void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
 {
     pblocktemplate->block.vtx.emplace_back(iter->GetSharedTx());
@@ -239,7 +380,6 @@ void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
     ++nBlockTx;
     nBlockSigOpsCost += iter->GetSigOpCost();
     nFees += iter->GetFee();
-    inBlock.insert(iter);
 
     bool fPrintPriority = gArgs.GetBoolArg("-printpriority", DEFAULT_PRINTPRIORITY);
     if (fPrintPriority) {
@@ -249,69 +389,36 @@ void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
     }
 }
 
-/** Add descendants of given transactions to mapModifiedTx with ancestor
- * state updated assuming given transactions are inBlock. Returns number
- * of updated descendants. */
-static int UpdatePackagesForAdded(const CTxMemPool& mempool,
-                                  const CTxMemPool::setEntries& alreadyAdded,
-                                  indexed_modified_transaction_set& mapModifiedTx) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs)
-{
-    AssertLockHeld(mempool.cs);
-
-    int nDescendantsUpdated = 0;
-    for (CTxMemPool::txiter it : alreadyAdded) {
-        CTxMemPool::setEntries descendants;
-        mempool.CalculateDescendants(it, descendants);
-        // Insert all descendants (not yet in block) into the modified set
-        for (CTxMemPool::txiter desc : descendants) {
-            if (alreadyAdded.count(desc)) {
-                continue;
-            }
-            ++nDescendantsUpdated;
-            modtxiter mit = mapModifiedTx.find(desc);
-            if (mit == mapModifiedTx.end()) {
-                CTxMemPoolModifiedEntry modEntry(desc);
-                mit = mapModifiedTx.insert(modEntry).first;
-            }
-            mapModifiedTx.modify(mit, update_for_parent_inclusion(it));
-        }
-    }
-    return nDescendantsUpdated;
-}
-
-void BlockAssembler::SortForBlock(const CTxMemPool::setEntries& package, std::vector<CTxMemPool::txiter>& sortedEntries)
-{
-    // Sort package by ancestor count
-    // If a transaction A depends on transaction B, then A's ancestor count
-    // must be greater than B's.  So this is sufficient to validly order the
-    // transactions for block inclusion.
-    sortedEntries.clear();
-    sortedEntries.insert(sortedEntries.begin(), package.begin(), package.end());
-    std::sort(sortedEntries.begin(), sortedEntries.end(), CompareTxIterByAncestorCount());
-}
-
-// This transaction selection algorithm orders the mempool based
-// on feerate of a transaction including all unconfirmed ancestors.
-// Since we don't remove transactions from the mempool as we select them
-// for block inclusion, we need an alternate method of updating the feerate
-// of a transaction with its not-yet-selected ancestors as we go.
-// This is accomplished by walking the in-mempool descendants of selected
-// transactions and storing a temporary modified state in mapModifiedTxs.
-// Each time through the loop, we compare the best transaction in
-// mapModifiedTxs with the next transaction in the mempool to decide what
-// transaction package to work on next.
+// This transaction selection algorithm works on clusters of transactions
+// spending each other rather than on each transaction with its ancestors.
+// Each cluster is linearized once into chunks of non-increasing feerate (see
+// LinearizeClusters()), so a chain of transactions, like a storage upload
+// spending its own change, is walked once instead of once per package taken
+// out of it. The chunks at the front of the clusters are then merged by
+// feerate, a cluster's next chunk becoming available once its previous one is
+// in the block.
 void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSelected, int& nDescendantsUpdated)
 {
     AssertLockHeld(mempool.cs);
 
-    // mapModifiedTx will store sorted packages after they are modified
-    // because some of their txs are already in the block
-    indexed_modified_transaction_set mapModifiedTx;
-    // Keep track of entries that failed inclusion, to avoid duplicate work
-    CTxMemPool::setEntries failedTx;
-
-    CTxMemPool::indexed_transaction_set::index<ancestor_score>::type::iterator mi = mempool.mapTx.get<ancestor_score>().begin();
-    CTxMemPool::txiter iter;
+    // Non-final transactions can't be in the block, nor anything spending them
+    const std::vector<std::vector<TxChunk>> clusters{LinearizeClusters(mempool, [&](const CTxMemPoolEntry& entry) {
+        return IsFinalTx(entry.GetTx(), nHeight, m_lock_time_cutoff);
+    }, nDescendantsUpdated)};
+
+    // Position of the next chunk of a cluster
+    using ChunkPos = std::pair<size_t, size_t>;
+    const auto worse = [&](const ChunkPos& a, const ChunkPos& b) {
+        const TxChunk& chunk_a{clusters[a.first][a.second]};
+        const TxChunk& chunk_b{clusters[b.first][b.second]};
+        if (FeerateHigher(chunk_b.fees, chunk_b.size, chunk_a.fees, chunk_a.size)) return true;
+        if (FeerateHigher(chunk_a.fees, chunk_a.size, chunk_b.fees, chunk_b.size)) return false;
+        return a.first > b.first;
+    };
+    std::priority_queue<ChunkPos, std::vector<ChunkPos>, decltype(worse)> next_chunks(worse);
+    for (size_t i = 0; i < clusters.size(); ++i) {
+        if (!clusters[i].empty()) next_chunks.emplace(i, 0);
+    }
 
     // Limit the number of attempts to add transactions to the block when it is
     // close to full; this is just a simple heuristic to finish quickly if the
@@ -319,82 +426,18 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
     const int64_t MAX_CONSECUTIVE_FAILURES = 1000;
     int64_t nConsecutiveFailed = 0;
 
-    while (mi != mempool.mapTx.get<ancestor_score>().end() || !mapModifiedTx.empty()) {
-        // First try to find a new transaction in mapTx to evaluate.
-        //
-        // Skip entries in mapTx that are already in a block or are present
-        // in mapModifiedTx (which implies that the mapTx ancestor state is
-        // stale due to ancestor inclusion in the block)
-        // Also skip transactions that we've already failed to add. This can happen if
-        // we consider a transaction in mapModifiedTx and it fails: we can then
-        // potentially consider it again while walking mapTx.  It's currently
-        // guaranteed to fail again, but as a belt-and-suspenders check we put it in
-        // failedTx and avoid re-evaluation, since the re-evaluation would be using
-        // cached size/sigops/fee values that are not actually correct.
-        /** Return true if given transaction from mapTx has already been evaluated,
-         * or if the transaction's cached data in mapTx is incorrect. */
-        if (mi != mempool.mapTx.get<ancestor_score>().end()) {
-            auto it = mempool.mapTx.project<0>(mi);
-            assert(it != mempool.mapTx.end());
-            if (mapModifiedTx.count(it) || inBlock.count(it) || failedTx.count(it)) {
-                ++mi;
-                continue;
-            }
-        }
-
-        // Now that mi is not stale, determine which transaction to evaluate:
-        // the next entry from mapTx, or the best from mapModifiedTx?
-        bool fUsingModified = false;
-
-        modtxscoreiter modit = mapModifiedTx.get<ancestor_score>().begin();
-        if (mi == mempool.mapTx.get<ancestor_score>().end()) {
-            // We're out of entries in mapTx; use the entry from mapModifiedTx
-            iter = modit->iter;
-            fUsingModified = true;
-        } else {
-            // Try to compare the mapTx entry to the mapModifiedTx entry
-            iter = mempool.mapTx.project<0>(mi);
-            if (modit != mapModifiedTx.get<ancestor_score>().end() &&
-                    CompareTxMemPoolEntryByAncestorFee()(*modit, CTxMemPoolModifiedEntry(iter))) {
-                // The best entry in mapModifiedTx has higher score
-                // than the one from mapTx.
-                // Switch which transaction (package) to consider
-                iter = modit->iter;
-                fUsingModified = true;
-            } else {
-                // Either no entry in mapModifiedTx, or it's worse than mapTx.
-                // Increment mi for the next loop iteration.
-                ++mi;
-            }
-        }
-
-        // We skip mapTx entries that are inBlock, and mapModifiedTx shouldn't
-        // contain anything that is inBlock.
-        assert(!inBlock.count(iter));
-
-        uint64_t packageSize = iter->GetSizeWithAncestors();
-        CAmount packageFees = iter->GetModFeesWithAncestors();
-        int64_t packageSigOpsCost = iter->GetSigOpCostWithAncestors();
-        if (fUsingModified) {
-            packageSize = modit->nSizeWithAncestors;
-            packageFees = modit->nModFeesWithAncestors;
-            packageSigOpsCost = modit->nSigOpCostWithAncestors;
-        }
+    while (!next_chunks.empty()) {
+        const auto [cluster, pos] = next_chunks.top();
+        const TxChunk& chunk{clusters[cluster][pos]};
 
-        if (packageFees < m_options.blockMinFeeRate.GetFee(packageSize)) {
+        if (chunk.fees < m_options.blockMinFeeRate.GetFee(chunk.size)) {
             // Everything else we might consider has a lower fee rate
             return;
         }
+        next_chunks.pop();
 
-        if (!TestPackage(packageSize, packageSigOpsCost)) {
-            if (fUsingModified) {
-                // Since we always look at the best entry in mapModifiedTx,
-                // we must erase failed entries so that we can consider the
-                // next best entry on the next loop iteration
-                mapModifiedTx.get<ancestor_score>().erase(modit);
-                failedTx.insert(iter);
-            }
-
+        if (!TestPackage(chunk.size, chunk.sigops_cost)) {
+            // The later chunks of the cluster may spend this one, leave them out too
             ++nConsecutiveFailed;
 
             if (nConsecutiveFailed > MAX_CONSECUTIVE_FAILURES && nBlockWeight >
@@ -405,37 +448,17 @@ void BlockAssembler::addPackageTxs(const CTxMemPool& mempool, int& nPackagesSele
             continue;
         }
 
-        auto ancestors{mempool.AssumeCalculateMemPoolAncestors(__func__, *iter, CTxMemPool::Limits::NoLimits(), /*fSearchForParents=*/false)};
-
-        onlyUnconfirmed(ancestors);
-        ancestors.insert(iter);
-
-        // Test if all tx's are Final
-        if (!TestPackageTransactions(ancestors)) {
-            if (fUsingModified) {
-                mapModifiedTx.get<ancestor_score>().erase(modit);
-                failedTx.insert(iter);
-            }
-            continue;
-        }
-
-        // This transaction will make it in; reset the failed counter.
+        // This chunk will make it in; reset the failed counter.
         nConsecutiveFailed = 0;
 
-        // Package can be added. Sort the entries in a valid order.
-        std::vector<CTxMemPool::txiter> sortedEntries;
-        SortForBlock(ancestors, sortedEntries);
-
-        for (size_t i = 0; i < sortedEntries.size(); ++i) {
-            AddToBlock(sortedEntries[i]);
-            // Erase from the modified set, if present
-            mapModifiedTx.erase(sortedEntries[i]);
+        for (const CTxMemPool::txiter& it : chunk.txs) {
+            AddToBlock(it);
         }
-
         ++nPackagesSelected;
 
-        // Update transactions that depend on each of these
-        nDescendantsUpdated += UpdatePackagesForAdded(mempool, ancestors, mapModifiedTx);
+        if (pos + 1 < clusters[cluster].size()) {
+            next_chunks.emplace(cluster, pos + 1);
+        }
     }
 }
 } // namespace node
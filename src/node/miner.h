@@ -10,12 +10,11 @@
 #include <primitives/block.h>
 #include <txmempool.h>
 
+#include <functional>
 #include <memory>
 #include <optional>
 #include <stdint.h>
-
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index_container.hpp>
+#include <vector>
 
 class ArgsManager;
 class ChainstateManager;
@@ -36,47 +35,13 @@ struct CBlockTemplate
     std::vector<unsigned char> vchCoinbaseCommitment;
 };
 
-// Container for tracking updates to ancestor feerate as we include (parent)
-// transactions in a block
-struct CTxMemPoolModifiedEntry {
-    explicit CTxMemPoolModifiedEntry(CTxMemPool::txiter entry)
-    {
-        iter = entry;
-        nSizeWithAncestors = entry->GetSizeWithAncestors();
-        nModFeesWithAncestors = entry->GetModFeesWithAncestors();
-        nSigOpCostWithAncestors = entry->GetSigOpCostWithAncestors();
-    }
-
-    CAmount GetModifiedFee() const { return iter->GetModifiedFee(); }
-    uint64_t GetSizeWithAncestors() const { return nSizeWithAncestors; }
-    CAmount GetModFeesWithAncestors() const { return nModFeesWithAncestors; }
-    size_t GetTxSize() const { return iter->GetTxSize(); }
-    const CTransaction& GetTx() const { return iter->GetTx(); }
-
-    CTxMemPool::txiter iter;
-    uint64_t nSizeWithAncestors;
-    CAmount nModFeesWithAncestors;
-    int64_t nSigOpCostWithAncestors;
-};
-
-/** Comparator for CTxMemPool::txiter objects.
- *  It simply compares the internal memory address of the CTxMemPoolEntry object
- *  pointed to. This means it has no meaning, and is only useful for using them
- *  as key in other indexes.
- */
-struct CompareCTxMemPoolIter {
-    bool operator()(const CTxMemPool::txiter& a, const CTxMemPool::txiter& b) const
-    {
-        return &(*a) < &(*b);
-    }
-};
-
-struct modifiedentry_iter {
-    typedef CTxMemPool::txiter result_type;
-    result_type operator() (const CTxMemPoolModifiedEntry &entry) const
-    {
-        return entry.iter;
-    }
+/** Transactions chosen for a block on top of tip_hash, in block order and without the coinbase */
+struct BlockTxSelection
+{
+    uint256 tip_hash;
+    std::vector<CTransactionRef> txs;
+    std::vector<CAmount> fees;
+    std::vector<int64_t> sigops_cost;
 };
 
 // A comparator that sorts transactions based on number of ancestors.
@@ -92,40 +57,31 @@ struct CompareTxIterByAncestorCount {
     }
 };
 
-typedef boost::multi_index_container<
-    CTxMemPoolModifiedEntry,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<
-            modifiedentry_iter,
-            CompareCTxMemPoolIter
-        >,
-        // sorted by modified ancestor fee rate
-        boost::multi_index::ordered_non_unique<
-            // Reuse same tag from CTxMemPool's similar index
-            boost::multi_index::tag<ancestor_score>,
-            boost::multi_index::identity<CTxMemPoolModifiedEntry>,
-            CompareTxMemPoolEntryByAncestorFee
-        >
-    >
-> indexed_modified_transaction_set;
-
-typedef indexed_modified_transaction_set::nth_index<0>::type::iterator modtxiter;
-typedef indexed_modified_transaction_set::index<ancestor_score>::type::iterator modtxscoreiter;
-
-struct update_for_parent_inclusion
+/** Transactions of a cluster to be added to a block together, after the chunks before them in the cluster */
+struct TxChunk
 {
-    explicit update_for_parent_inclusion(CTxMemPool::txiter it) : iter(it) {}
-
-    void operator() (CTxMemPoolModifiedEntry &e)
-    {
-        e.nModFeesWithAncestors -= iter->GetModifiedFee();
-        e.nSizeWithAncestors -= iter->GetTxSize();
-        e.nSigOpCostWithAncestors -= iter->GetSigOpCost();
-    }
-
-    CTxMemPool::txiter iter;
+    //! In an order valid to appear in a block
+    std::vector<CTxMemPool::txiter> txs;
+    CAmount fees{0};
+    uint64_t size{0};
+    int64_t sigops_cost{0};
 };
 
+/**
+ * Split the mempool transactions for which is_eligible holds, and holds for all
+ * their in-mempool ancestors, into clusters of transactions connected by
+ * spending each other, and linearize each cluster into chunks of non-increasing
+ * feerate (by modified fees).
+ *
+ * A cluster is linearized by repeatedly taking the remaining transaction with
+ * the best feerate including its remaining in-cluster ancestors, together with
+ * them. The linearization is then split into the chunks a miner would take: a
+ * transaction joins the chunk before it whenever it would raise its feerate.
+ * descendants_updated is incremented by the ancestor states updated doing so.
+ */
+std::vector<std::vector<TxChunk>> LinearizeClusters(const CTxMemPool& mempool, const std::function<bool(const CTxMemPoolEntry&)>& is_eligible,
+                                                    int& descendants_updated) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
+
 /** Generate a new block, without valid proof-of-work */
 class BlockAssembler
 {
@@ -138,7 +94,6 @@ private:
     uint64_t nBlockTx;
     uint64_t nBlockSigOpsCost;
     CAmount nFees;
-    CTxMemPool::setEntries inBlock;
 
     // Chain context for the block
     int nHeight;
@@ -162,6 +117,9 @@ public:
 
     /** Construct a new block template with coinbase to scriptPubKeyIn */
     std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, bool fProofOfStake = false);
+    /** Construct a new block template with coinbase to scriptPubKeyIn out of transactions selected
+      * earlier instead of the mempool. Returns nullptr if they were selected for another tip. */
+    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, bool fProofOfStake, const BlockTxSelection& selection);
 
     inline static std::optional<int64_t> m_last_block_num_txs{};
     inline static std::optional<int64_t> m_last_block_weight{};
@@ -170,29 +128,22 @@ private:
     const Options m_options;
 
     // utility functions
+    /** Construct a new block template out of selection if given, out of the mempool otherwise */
+    std::unique_ptr<CBlockTemplate> AssembleBlock(const CScript& scriptPubKeyIn, bool fProofOfStake, const BlockTxSelection* selection);
     /** Clear the block's state and prepare for assembling a new block */
     void resetBlock();
     /** Add a tx to the block */
     void AddToBlock(CTxMemPool::txiter iter);
 
     // Methods for how to add transactions to a block.
-    /** Add transactions based on feerate including unconfirmed ancestors
-      * Increments nPackagesSelected / nDescendantsUpdated with corresponding
-      * statistics from the package selection (for logging statistics). */
+    /** Add transactions by chunk feerate, taking the chunks of each cluster (see
+      * LinearizeClusters()) in order. Increments nPackagesSelected / nDescendantsUpdated
+      * with corresponding statistics from the chunk selection (for logging statistics). */
     void addPackageTxs(const CTxMemPool& mempool, int& nPackagesSelected, int& nDescendantsUpdated) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 
     // helper functions for addPackageTxs()
-    /** Remove confirmed (inBlock) entries from given set */
-    void onlyUnconfirmed(CTxMemPool::setEntries& testSet);
     /** Test if a new package would "fit" in the block */
     bool TestPackage(uint64_t packageSize, int64_t packageSigOpsCost) const;
-    /** Perform checks on each transaction in a package:
-      * locktime, premature-witness, serialized size (if necessary)
-      * These checks should always succeed, and they're here
-      * only as an extra check in case of suboptimal node configuration */
-    bool TestPackageTransactions(const CTxMemPool::setEntries& package) const;
-    /** Sort the package in an order that is valid to appear in a block */
-    void SortForBlock(const CTxMemPool::setEntries& package, std::vector<CTxMemPool::txiter>& sortedEntries);
 };
 
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
@@ -200,6 +151,9 @@ int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParam
 /** Update an old GenerateCoinbaseCommitment from CreateNewBlock after the block txs have changed */
 void RegenerateCommitments(CBlock& block, ChainstateManager& chainman);
 
+/** Limit BlockAssembler options to sane values, as BlockAssembler applies them. */
+BlockAssembler::Options ClampOptions(BlockAssembler::Options options);
+
 /** Apply -blockmintxfee and -blockmaxweight options from ArgsManager to BlockAssembler options. */
 void ApplyArgsManOptions(const ArgsManager& gArgs, BlockAssembler::Options& options);
 } // namespace node
@@ -0,0 +1,397 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
+#include <node/profiler.h>
+
+#include <logging.h>
+#include <tinyformat.h>
+#include <util/fs.h>
+#include <util/strencodings.h>
+#include <util/string.h>
+#include <util/syserror.h>
+#include <util/thread.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <string_view>
+
+#if defined(__linux__) && defined(HAVE_EXECINFO_H)
+#define HAVE_SAMPLING_PROFILER 1
+#include <csignal>
+#include <execinfo.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace node {
+SamplingProfiler g_profiler;
+
+std::string ThreadSubsystem(const std::string& thread_name)
+{
+    std::string_view name{thread_name};
+    // The process level name of the threads we named, see util::ThreadRename
+    if (name.substr(0, 2) == "b-") name.remove_prefix(2);
+    const size_t end{name.find_last_not_of("0123456789")};
+    if (end != std::string_view::npos && end + 1 < name.size()) {
+        name = name.substr(0, name[end] == '.' ? end : end + 1);
+    }
+    return std::string{name};
+}
+
+namespace {
+/** Just enough of protobuf to write a profile.proto message */
+class ProtoWriter
+{
+public:
+    void Varint(int field, uint64_t value)
+    {
+        Key(field, 0);
+        Raw(value);
+    }
+    void Bytes(int field, std::string_view bytes)
+    {
+        Key(field, 2);
+        Raw(bytes.size());
+        m_out += bytes;
+    }
+    void Packed(int field, const std::vector<uint64_t>& values)
+    {
+        ProtoWriter packed;
+        for (uint64_t value : values) packed.Raw(value);
+        Bytes(field, packed.m_out);
+    }
+    const std::string& Data() const { return m_out; }
+
+private:
+    void Key(int field, int wire_type) { Raw((uint64_t(field) << 3) | wire_type); }
+    void Raw(uint64_t value)
+    {
+        while (value >= 0x80) {
+            m_out += char((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        m_out += char(value);
+    }
+
+    std::string m_out;
+};
+
+struct Mapping {
+    uint64_t start;
+    uint64_t limit;
+    uint64_t offset;
+    std::string filename;
+};
+
+/** The executable mappings of the process, the binary itself first */
+std::vector<Mapping> ReadMappings()
+{
+    std::vector<Mapping> mappings;
+    std::ifstream maps{"/proc/self/maps"};
+    std::string line;
+    while (std::getline(maps, line)) {
+        // start-limit perms offset dev inode path
+        const std::vector<std::string> fields{SplitString(line, ' ')};
+        std::vector<std::string> parts;
+        for (const std::string& field : fields) {
+            if (!field.empty()) parts.push_back(field);
+        }
+        if (parts.size() < 6 || parts[1].size() < 3 || parts[1][2] != 'x' || parts[5].front() != '/') continue;
+        const std::vector<std::string> range{SplitString(parts[0], '-')};
+        if (range.size() != 2) continue;
+        mappings.push_back({std::stoull(range[0], nullptr, 16), std::stoull(range[1], nullptr, 16), std::stoull(parts[3], nullptr, 16), parts[5]});
+    }
+    return mappings;
+}
+} // namespace
+
+std::string FormatPprof(const Profile& profile)
+{
+    std::vector<std::string> strings{""};
+    std::map<std::string, uint64_t> string_ids{{"", 0}};
+    const auto string_id = [&](const std::string& str) {
+        const auto [it, inserted] = string_ids.emplace(str, strings.size());
+        if (inserted) strings.push_back(str);
+        return it->second;
+    };
+
+    ProtoWriter out;
+    const auto value_type = [&](int field, const std::string& type, const std::string& unit) {
+        ProtoWriter value;
+        value.Varint(1, string_id(type));
+        value.Varint(2, string_id(unit));
+        out.Bytes(field, value.Data());
+    };
+    value_type(1, "samples", "count");
+    value_type(1, "wall", "nanoseconds");
+
+    const int64_t period{profile.frequency > 0 ? 1'000'000'000 / profile.frequency : 0};
+    std::map<uintptr_t, uint64_t> location_ids;
+    for (const ProfileSample& sample : profile.samples) {
+        std::vector<uint64_t> locations;
+        for (uintptr_t address : sample.stack) {
+            const auto [it, inserted] = location_ids.emplace(address, location_ids.size() + 1);
+            locations.push_back(it->second);
+        }
+        ProtoWriter entry;
+        entry.Packed(1, locations);
+        entry.Packed(2, {sample.count, sample.count * period});
+        for (const auto& [key, value] : {std::pair{"thread", sample.thread}, {"subsystem", ThreadSubsystem(sample.thread)}}) {
+            ProtoWriter label;
+            label.Varint(1, string_id(key));
+            label.Varint(2, string_id(value));
+            entry.Bytes(3, label.Data());
+        }
+        out.Bytes(2, entry.Data());
+    }
+
+    const std::vector<Mapping> mappings{ReadMappings()};
+    for (size_t i = 0; i < mappings.size(); ++i) {
+        ProtoWriter mapping;
+        mapping.Varint(1, i + 1);
+        mapping.Varint(2, mappings[i].start);
+        mapping.Varint(3, mappings[i].limit);
+        mapping.Varint(4, mappings[i].offset);
+        mapping.Varint(5, string_id(mappings[i].filename));
+        out.Bytes(3, mapping.Data());
+    }
+    for (const auto& [address, id] : location_ids) {
+        ProtoWriter location;
+        location.Varint(1, id);
+        const auto mapping{std::find_if(mappings.begin(), mappings.end(), [&](const Mapping& m) { return address >= m.start && address < m.limit; })};
+        if (mapping != mappings.end()) location.Varint(2, mapping - mappings.begin() + 1);
+        location.Varint(3, address);
+        out.Bytes(4, location.Data());
+    }
+
+    // Every string is interned by now
+    for (const std::string& str : strings) out.Bytes(6, str);
+    out.Varint(9, profile.start.count());
+    out.Varint(10, profile.duration.count());
+    value_type(11, "wall", "nanoseconds");
+    out.Varint(12, period);
+    return out.Data();
+}
+
+#ifdef HAVE_SAMPLING_PROFILER
+namespace {
+//! Frames of the handler and the signal trampoline above the interrupted code
+constexpr int SIGNAL_FRAMES{2};
+
+//! The thread the sampling thread signalled last, and whether its handler may still take the sample
+std::atomic<pid_t> g_sample_tid{0};
+std::atomic<bool> g_sample_armed{false};
+std::atomic<bool> g_sample_done{false};
+void* g_sample_stack[MAX_PROFILE_STACK_DEPTH + SIGNAL_FRAMES];
+int g_sample_depth{0};
+struct sigaction g_old_action;
+
+void HandleProfileSignal(int)
+{
+    const int saved_errno{errno};
+    // A late signal of a thread the sampling thread gave up on must not overwrite the next sample
+    if (pid_t(syscall(SYS_gettid)) == g_sample_tid.load() && g_sample_armed.exchange(false)) {
+        g_sample_depth = backtrace(g_sample_stack, MAX_PROFILE_STACK_DEPTH + SIGNAL_FRAMES);
+        g_sample_done.store(true);
+    }
+    errno = saved_errno;
+}
+
+/** The threads of the process by id, with their process level names */
+std::map<pid_t, std::string> ListThreads()
+{
+    std::map<pid_t, std::string> threads;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator{"/proc/self/task", ec}) {
+        const auto tid{ToIntegral<pid_t>(fs::PathToString(entry.path().filename()))};
+        if (!tid) continue;
+        std::ifstream comm{entry.path() / "comm"};
+        std::string name;
+        std::getline(comm, name);
+        threads.emplace(*tid, name);
+    }
+    return threads;
+}
+
+bool InstallProfileHandler(std::string& error)
+{
+    // The first backtrace loads the unwinder, which is not safe within a signal handler
+    void* stack[1];
+    backtrace(stack, 1);
+    struct sigaction action{};
+    action.sa_handler = HandleProfileSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &g_old_action) != 0) {
+        error = strprintf("Could not handle SIGPROF: %s", SysErrorString(errno));
+        return false;
+    }
+    return true;
+}
+
+void RestoreProfileHandler()
+{
+    sigaction(SIGPROF, &g_old_action, nullptr);
+}
+} // namespace
+#endif
+
+SamplingProfiler::~SamplingProfiler()
+{
+    Stop();
+}
+
+bool SamplingProfiler::IsRunning() const
+{
+    LOCK(m_mutex);
+    return m_thread.joinable();
+}
+
+bool SamplingProfiler::Start(int frequency, std::string& error)
+{
+#ifdef HAVE_SAMPLING_PROFILER
+    if (frequency < 1 || frequency > MAX_PROFILER_FREQUENCY) {
+        error = strprintf("Frequency must be between 1 and %d", MAX_PROFILER_FREQUENCY);
+        return false;
+    }
+    LOCK(m_mutex);
+    if (m_thread.joinable()) {
+        error = "The profiler is already running";
+        return false;
+    }
+
+    if (!InstallProfileHandler(error)) return false;
+
+    m_samples.clear();
+    m_missed = 0;
+    m_frequency = frequency;
+    m_start = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch());
+    m_start_steady = SteadyClock::now();
+    m_stop = false;
+    m_thread = std::thread(&util::TraceThread, "profiler", [this, frequency] { Run(frequency); });
+    LogPrintf("Profiler sampling every thread %d times a second\n", frequency);
+    return true;
+#else
+    error = "The profiler is not supported on this platform";
+    return false;
+#endif
+}
+
+std::optional<Profile> SamplingProfiler::Stop()
+{
+    LOCK(m_mutex);
+    if (!m_thread.joinable()) return std::nullopt;
+    m_stop = true;
+    m_thread.join();
+#ifdef HAVE_SAMPLING_PROFILER
+    RestoreProfileHandler();
+#endif
+    return TakeProfile();
+}
+
+std::optional<Profile> SamplingProfiler::SampleOnce(std::string& error)
+{
+#ifdef HAVE_SAMPLING_PROFILER
+    LOCK(m_mutex);
+    if (m_thread.joinable()) {
+        error = "The profiler is already running";
+        return std::nullopt;
+    }
+    if (!InstallProfileHandler(error)) return std::nullopt;
+
+    m_samples.clear();
+    m_missed = 0;
+    m_frequency = 0;
+    m_start = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch());
+    m_start_steady = SteadyClock::now();
+    std::map<pid_t, std::string> threads{ListThreads()};
+    threads.erase(pid_t(syscall(SYS_gettid)));
+    // Long enough for any thread to be scheduled, so only threads exiting or ignoring the signal are missed
+    SampleThreads(threads, std::chrono::seconds{10});
+    RestoreProfileHandler();
+    return TakeProfile();
+#else
+    error = "The profiler is not supported on this platform";
+    return std::nullopt;
+#endif
+}
+
+Profile SamplingProfiler::TakeProfile()
+{
+    Profile profile;
+    profile.frequency = m_frequency;
+    profile.start = m_start;
+    profile.duration = SteadyClock::now() - m_start_steady;
+    profile.missed = m_missed;
+    for (auto& [key, count] : m_samples) {
+        profile.samples.push_back({key.first, key.second, count});
+    }
+    m_samples.clear();
+    return profile;
+}
+
+void SamplingProfiler::SampleThreads(const std::map<int, std::string>& threads, std::chrono::nanoseconds timeout)
+{
+#ifdef HAVE_SAMPLING_PROFILER
+    const pid_t pid{getpid()};
+    for (const auto& [tid, name] : threads) {
+        g_sample_done = false;
+        g_sample_tid = tid;
+        g_sample_armed = true;
+        if (syscall(SYS_tgkill, pid, tid, SIGPROF) != 0) {
+            g_sample_armed = false;
+            ++m_missed;
+            continue;
+        }
+        const auto deadline{SteadyClock::now() + timeout};
+        while (!g_sample_done && SteadyClock::now() < deadline) std::this_thread::yield();
+        // Once disarmed here, a late handler leaves the sample alone; if the handler
+        // disarmed it first, it is taking the sample and about to be done
+        if (!g_sample_done && g_sample_armed.exchange(false)) {
+            ++m_missed;
+            continue;
+        }
+        while (!g_sample_done) std::this_thread::yield();
+        std::vector<uintptr_t> stack;
+        for (int i = SIGNAL_FRAMES; i < g_sample_depth; ++i) {
+            // Return addresses point past the call, so the frame is attributed to the call's line
+            stack.push_back(uintptr_t(g_sample_stack[i]) - (i > SIGNAL_FRAMES ? 1 : 0));
+        }
+        ++m_samples[{name.substr(0, 2) == "b-" ? name.substr(2) : name, std::move(stack)}];
+    }
+#endif
+}
+
+void SamplingProfiler::Run(int frequency)
+{
+#ifdef HAVE_SAMPLING_PROFILER
+    const pid_t self{pid_t(syscall(SYS_gettid))};
+    const auto period{std::chrono::nanoseconds{1'000'000'000 / frequency}};
+    // A thread not taking the signal by then is waiting in a call that ignores it
+    const auto timeout{std::chrono::milliseconds{10}};
+
+    std::map<pid_t, std::string> threads;
+    SteadyClock::time_point threads_listed;
+    auto next{SteadyClock::now()};
+    while (!m_stop) {
+        if (SteadyClock::now() - threads_listed > std::chrono::seconds{1}) {
+            threads = ListThreads();
+            threads.erase(self);
+            threads_listed = SteadyClock::now();
+        }
+        SampleThreads(threads, timeout);
+        next += period;
+        const auto now{SteadyClock::now()};
+        // Skip the ticks missed when sampling falls behind, rather than catching up in a burst
+        if (next < now) next = now;
+        std::this_thread::sleep_until(next);
+    }
+#endif
+}
+} // namespace node
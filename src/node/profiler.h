@@ -0,0 +1,107 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_PROFILER_H
+#define BITCOIN_NODE_PROFILER_H
+
+#include <sync.h>
+#include <util/time.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace node {
+//! Default rate the profiler samples the threads at, per second
+static constexpr int DEFAULT_PROFILER_FREQUENCY{99};
+//! Highest rate the profiler samples the threads at, per second
+static constexpr int MAX_PROFILER_FREQUENCY{1000};
+//! Deepest stack kept of a sample, the outermost frames are dropped past it
+static constexpr size_t MAX_PROFILE_STACK_DEPTH{64};
+
+/** The samples of one stack of one thread */
+struct ProfileSample {
+    //! The thread's name, such as "msghand" or "scriptch.2"
+    std::string thread;
+    //! Addresses of the frames, innermost first
+    std::vector<uintptr_t> stack;
+    uint64_t count{0};
+};
+
+/** What the profiler sampled between its start and stop */
+struct Profile {
+    int frequency{0};
+    //! Wall clock time the profiler started at
+    std::chrono::nanoseconds start{0};
+    std::chrono::nanoseconds duration{0};
+    std::vector<ProfileSample> samples;
+    //! Samples not taken, as the thread exited or did not take the signal in time
+    uint64_t missed{0};
+};
+
+/** The subsystem a thread belongs to, its name without the number of the thread within a pool */
+std::string ThreadSubsystem(const std::string& thread_name);
+
+/**
+ * Serialize a profile in the protobuf format of pprof, labelling each sample
+ * with its thread and subsystem. Addresses are left for pprof to symbolize
+ * against the binaries, which are listed as mappings.
+ */
+std::string FormatPprof(const Profile& profile);
+
+/**
+ * Samples the stacks of every thread of the process at a fixed rate, whether
+ * running or waiting, for where the wall clock time of each subsystem goes.
+ *
+ * Each thread in turn is sent SIGPROF, and takes its stack in the handler.
+ * Waits interrupted by the signal are restarted or return early, as
+ * condition variables may wake spuriously. Only supported on Linux.
+ */
+class SamplingProfiler
+{
+public:
+    ~SamplingProfiler();
+
+    /** Start sampling frequency times a second, false with the reason if it could not start */
+    bool Start(int frequency, std::string& error) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Stop sampling, returning the profile taken, if running */
+    std::optional<Profile> Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool IsRunning() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Sample every other thread once from the calling thread, waiting as long
+     * as it takes each to take the signal, and return that profile. Fails if
+     * running. Lets tests drive the sampling without depending on scheduling.
+     */
+    std::optional<Profile> SampleOnce(std::string& error) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    void Run(int frequency);
+    /** Sample each of threads once, counting those not taking the signal within timeout as missed */
+    void SampleThreads(const std::map<int, std::string>& threads, std::chrono::nanoseconds timeout);
+    /** Move the samples taken so far out into a profile */
+    Profile TakeProfile();
+
+    mutable Mutex m_mutex;
+    std::thread m_thread GUARDED_BY(m_mutex);
+    std::atomic<bool> m_stop{false};
+
+    //! The samples taken so far by thread and stack, only touched by the sampling thread until joined
+    std::map<std::pair<std::string, std::vector<uintptr_t>>, uint64_t> m_samples;
+    uint64_t m_missed{0};
+    int m_frequency{0};
+    std::chrono::nanoseconds m_start{0};
+    SteadyClock::time_point m_start_steady;
+};
+
+extern SamplingProfiler g_profiler;
+} // namespace node
+
+#endif // BITCOIN_NODE_PROFILER_H
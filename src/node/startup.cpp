@@ -0,0 +1,86 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/startup.h>
+
+#include <logging.h>
+#include <sync.h>
+#include <util/threadnames.h>
+#include <util/time.h>
+
+#include <cassert>
+
+namespace node {
+static GlobalMutex g_startup_mutex;
+static std::vector<StartupStepInfo> g_startup_steps GUARDED_BY(g_startup_mutex);
+//! When each step started, for the time taken
+static std::map<std::string, SteadyClock::time_point> g_startup_clocks GUARDED_BY(g_startup_mutex);
+
+std::string StartupStepStateString(StartupStepState state)
+{
+    switch (state) {
+    case StartupStepState::RUNNING: return "running";
+    case StartupStepState::DONE: return "done";
+    case StartupStepState::FAILED: return "failed";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+static void FinishStep(const std::string& name, bool ok)
+{
+    LOCK(g_startup_mutex);
+    for (StartupStepInfo& step : g_startup_steps) {
+        if (step.name != name) continue;
+        step.state = ok ? StartupStepState::DONE : StartupStepState::FAILED;
+        step.elapsed_ms = Ticks<std::chrono::milliseconds>(SteadyClock::now() - g_startup_clocks.at(name));
+        LogPrintf("Startup step %s %s in %dms\n", name, StartupStepStateString(step.state), step.elapsed_ms);
+    }
+}
+
+StartupSteps::~StartupSteps()
+{
+    for (auto& [name, step] : m_steps) {
+        if (step.valid()) step.wait();
+    }
+}
+
+void StartupSteps::Start(const std::string& name, std::function<bool()> fn)
+{
+    assert(!m_steps.count(name));
+    {
+        LOCK(g_startup_mutex);
+        g_startup_steps.push_back({name, StartupStepState::RUNNING, GetTime(), 0});
+        g_startup_clocks[name] = SteadyClock::now();
+    }
+    m_steps[name] = std::async(std::launch::async, [name, fn = std::move(fn)] {
+        util::ThreadRename("init." + name);
+        bool ok{false};
+        try {
+            ok = fn();
+        } catch (...) {
+            FinishStep(name, false);
+            throw;
+        }
+        FinishStep(name, ok);
+        return ok;
+    });
+}
+
+bool StartupSteps::Wait(const std::string& name)
+{
+    return m_steps.at(name).get();
+}
+
+std::vector<StartupStepInfo> GetStartupSteps()
+{
+    LOCK(g_startup_mutex);
+    std::vector<StartupStepInfo> steps{g_startup_steps};
+    for (StartupStepInfo& step : steps) {
+        if (step.state == StartupStepState::RUNNING) {
+            step.elapsed_ms = Ticks<std::chrono::milliseconds>(SteadyClock::now() - g_startup_clocks.at(step.name));
+        }
+    }
+    return steps;
+}
+} // namespace node
@@ -0,0 +1,61 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_STARTUP_H
+#define BITCOIN_NODE_STARTUP_H
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace node {
+enum class StartupStepState {
+    RUNNING,
+    DONE,
+    FAILED,
+};
+
+std::string StartupStepStateString(StartupStepState state);
+
+/** A step of startup run off the init thread, as last seen */
+struct StartupStepInfo {
+    std::string name;
+    StartupStepState state{StartupStepState::RUNNING};
+    int64_t started{0};
+    //! Time it took, or has taken so far
+    int64_t elapsed_ms{0};
+};
+
+/**
+ * Steps of startup that depend on none of those after them, such as loading
+ * the wallets, reading the authList and loading the P2P addresses, each run
+ * on a thread of its own from when what they need is ready, and are waited
+ * for where the first step needing them begins. The init thread goes on
+ * with the steps in between meanwhile.
+ *
+ * Steps still running are waited for when this goes out of scope, so that
+ * a startup failing part way returns only once nothing runs on its behalf.
+ */
+class StartupSteps
+{
+public:
+    ~StartupSteps();
+
+    /// Run fn on a thread of its own. fn returns false, having reported why, if startup cannot go on.
+    void Start(const std::string& name, std::function<bool()> fn);
+    /// Wait for a step started, and return what it returned. Rethrows what it threw.
+    bool Wait(const std::string& name);
+
+private:
+    std::map<std::string, std::future<bool>> m_steps;
+};
+
+/// Every step started off the init thread so far, in the order started, for the warmup progress.
+std::vector<StartupStepInfo> GetStartupSteps();
+} // namespace node
+
+#endif // BITCOIN_NODE_STARTUP_H
@@ -4,10 +4,17 @@
 
 #include <node/txreconciliation.h>
 
+#include <crypto/siphash.h>
+#include <node/minisketchwrapper.h>
 #include <util/check.h>
 #include <util/system.h>
 
+#include <minisketch.h>
+
+#include <cmath>
+#include <set>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 
 
@@ -28,6 +35,11 @@ uint256 ComputeSalt(uint64_t salt1, uint64_t salt2)
     return (HashWriter(RECON_SALT_HASHER) << std::min(salt1, salt2) << std::max(salt1, salt2)).GetSHA256();
 }
 
+/** Bits of the short ids, the field the sketches are over. */
+constexpr uint32_t RECON_FIELD_SIZE{32};
+/** Bits of protection from false positives decoding a sketch, see BIP-330. */
+constexpr uint32_t RECON_FALSE_POSITIVE_COEF{16};
+
 /**
  * Keeps track of txreconciliation-related per-peer state.
  */
@@ -35,9 +47,6 @@ class TxReconciliationState
 {
 public:
     /**
-     * TODO: This field is public to ignore -Wunused-private-field. Make private once used in
-     * the following commits.
-     *
      * Reconciliation protocol assumes using one role consistently: either a reconciliation
      * initiator (requesting sketches), or responder (sending sketches). This defines our role,
      * based on the direction of the p2p connection.
@@ -46,14 +55,44 @@ public:
     bool m_we_initiate;
 
     /**
-     * TODO: These fields are public to ignore -Wunused-private-field. Make private once used in
-     * the following commits.
-     *
      * These values are used to salt short IDs, which is necessary for transaction reconciliations.
      */
     uint64_t m_k0, m_k1;
 
+    /** The transactions to announce to the peer in the next reconciliation. */
+    std::set<uint256> m_local_set;
+
+    /** As responder, the set sketched in answer to a request, until the peer tells the difference. */
+    std::set<uint256> m_local_set_snapshot;
+
+    /** As initiator, whether we requested a reconciliation and wait for the sketch. */
+    bool m_sketch_requested{false};
+
+    /** As initiator, when to request the next reconciliation. */
+    std::chrono::microseconds m_next_request{0};
+
+    /** As responder, the set size and q the peer requested a reconciliation with, until answered. */
+    std::optional<std::pair<uint16_t, uint16_t>> m_pending_request;
+
+    /** As responder, whether we sketched our set and wait for the difference the peer found. */
+    bool m_sketch_sent{false};
+
     TxReconciliationState(bool we_initiate, uint64_t k0, uint64_t k1) : m_we_initiate(we_initiate), m_k0(k0), m_k1(k1) {}
+
+    /** The short id of a transaction in the sketches, 1 + (SipHash(wtxid) mod 2^32 - 1), see BIP-330. */
+    uint32_t ComputeShortID(const uint256& wtxid) const
+    {
+        return 1 + (SipHashUint256(m_k0, m_k1, wtxid) % 0xFFFFFFFF);
+    }
+
+    /** The capacity of a sketch to find the difference of sets of the sizes given, with the peer's q. */
+    static uint32_t EstimateSketchCapacity(size_t local_set_size, uint16_t remote_set_size, uint16_t remote_q)
+    {
+        const uint32_t local_size{uint32_t(std::min<size_t>(local_set_size, std::numeric_limits<uint16_t>::max()))};
+        const uint32_t set_size_diff{local_size > remote_set_size ? local_size - remote_set_size : remote_set_size - local_size};
+        const uint32_t weighted_min_size{uint32_t(remote_q) * std::min<uint32_t>(local_size, remote_set_size) / Q_PRECISION};
+        return Minisketch::ComputeCapacity(RECON_FIELD_SIZE, 1 + weighted_min_size + set_size_diff, RECON_FALSE_POSITIVE_COEF);
+    }
 };
 
 } // namespace
@@ -141,6 +180,170 @@ public:
         return (recon_state != m_states.end() &&
                 std::holds_alternative<TxReconciliationState>(recon_state->second));
     }
+
+    bool AddToSet(NodeId peer_id, const uint256& wtxid) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        TxReconciliationState* recon_state{GetRegisteredPeerState(peer_id)};
+        if (!recon_state || recon_state->m_local_set.size() >= MAX_RECON_SET_SIZE) return false;
+        recon_state->m_local_set.insert(wtxid);
+        return true;
+    }
+
+    bool ShouldFanoutTo(NodeId peer_id, const uint256& wtxid) const EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        const TxReconciliationState* recon_state{GetRegisteredPeerState(peer_id)};
+        if (!recon_state) return true;
+        if (!recon_state->m_we_initiate) return false;
+        // The short ids being salted per peer, each transaction goes to its own share of the peers
+        return recon_state->ComputeShortID(wtxid) % RECON_FANOUT_RATIO == 0;
+    }
+
+    std::optional<std::pair<uint16_t, uint16_t>> InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        TxReconciliationState* recon_state{GetRegisteredPeerState(peer_id)};
+        if (!recon_state || !recon_state->m_we_initiate || recon_state->m_sketch_requested) return std::nullopt;
+        if (now < recon_state->m_next_request) return std::nullopt;
+
+        recon_state->m_sketch_requested = true;
+        recon_state->m_next_request = now + RECON_REQUEST_INTERVAL;
+        const uint16_t set_size{uint16_t(std::min<size_t>(recon_state->m_local_set.size(), std::numeric_limits<uint16_t>::max()))};
+        LogPrintLevel(BCLog::TXRECONCILIATION, BCLog::Level::Debug, "Request reconciliation of %u transactions from peer=%d\n", set_size, peer_id);
+        return std::make_pair(set_size, uint16_t(std::lround(RECON_Q * Q_PRECISION)));
+    }
+
+    bool HandleReconciliationRequest(NodeId peer_id, uint16_t peer_recon_set_size, uint16_t peer_q) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        TxReconciliationState* recon_state{GetRegisteredPeerState(peer_id)};
+        if (!recon_state || recon_state->m_we_initiate) return false;
+        // The peer must wait for the previous reconciliation to finish before requesting another one
+        if (recon_state->m_pending_request || recon_state->m_sketch_sent) return false;
+        if (peer_q > Q_PRECISION) return false;
+
+        recon_state->m_pending_request = std::make_pair(peer_recon_set_size, peer_q);
+        return true;
+    }
+
+    std::optional<std::vector<uint8_t>> RespondToReconciliationRequest(NodeId peer_id) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        TxReconciliationState* recon_state{GetRegisteredPeerState(peer_id)};
+        if (!recon_state || !recon_state->m_pending_request) return std::nullopt;
+
+        const auto [remote_set_size, remote_q]{*recon_state->m_pending_request};
+        recon_state->m_pending_request.reset();
+        recon_state->m_sketch_sent = true;
+        recon_state->m_local_set_snapshot.swap(recon_state->m_local_set);
+        recon_state->m_local_set.clear();
+
+        std::vector<uint8_t> skdata;
+        const uint32_t capacity{TxReconciliationState::EstimateSketchCapacity(recon_state->m_local_set_snapshot.size(), remote_set_size, remote_q)};
+        if (capacity <= MAX_SKETCH_CAPACITY) {
+            Minisketch sketch{node::MakeMinisketch32(capacity)};
+            for (const uint256& wtxid : recon_state->m_local_set_snapshot) {
+                sketch.Add(recon_state->ComputeShortID(wtxid));
+            }
+            skdata = sketch.Serialize();
+        }
+        LogPrintLevel(BCLog::TXRECONCILIATION, BCLog::Level::Debug, "Respond with a sketch of %u transactions (capacity %u) to peer=%d\n",
+                      recon_state->m_local_set_snapshot.size(), capacity, peer_id);
+        return skdata;
+    }
+
+    std::optional<bool> HandleSketch(NodeId peer_id, Span<const uint8_t> skdata,
+                                     std::vector<uint32_t>& txs_to_request, std::vector<uint256>& txs_to_announce) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        TxReconciliationState* recon_state{GetRegisteredPeerState(peer_id)};
+        if (!recon_state || !recon_state->m_we_initiate || !recon_state->m_sketch_requested) return std::nullopt;
+        const size_t capacity{skdata.size() * 8 / RECON_FIELD_SIZE};
+        if (skdata.size() * 8 % RECON_FIELD_SIZE != 0 || capacity > MAX_SKETCH_CAPACITY) return std::nullopt;
+        recon_state->m_sketch_requested = false;
+
+        std::unordered_map<uint32_t, uint256> local_short_ids;
+        local_short_ids.reserve(recon_state->m_local_set.size());
+        for (const uint256& wtxid : recon_state->m_local_set) {
+            local_short_ids.emplace(recon_state->ComputeShortID(wtxid), wtxid);
+        }
+
+        std::optional<std::vector<uint64_t>> differences;
+        if (capacity > 0) {
+            Minisketch remote_sketch{node::MakeMinisketch32(capacity)};
+            Minisketch local_sketch{node::MakeMinisketch32(capacity)};
+            if (remote_sketch && local_sketch) {
+                remote_sketch.Deserialize(skdata);
+                for (const auto& [short_id, _] : local_short_ids) {
+                    local_sketch.Add(short_id);
+                }
+                differences = remote_sketch.Merge(local_sketch).Decode(capacity);
+            }
+        }
+
+        txs_to_request.clear();
+        txs_to_announce.clear();
+        if (differences) {
+            for (const uint64_t short_id : *differences) {
+                const auto local{local_short_ids.find(uint32_t(short_id))};
+                if (local != local_short_ids.end()) {
+                    txs_to_announce.push_back(local->second);
+                } else {
+                    txs_to_request.push_back(uint32_t(short_id));
+                }
+            }
+        } else {
+            txs_to_announce.assign(recon_state->m_local_set.begin(), recon_state->m_local_set.end());
+        }
+        recon_state->m_local_set.clear();
+        LogPrintLevel(BCLog::TXRECONCILIATION, BCLog::Level::Debug, "Reconciliation with peer=%d %s: %u to request, %u to announce\n",
+                      peer_id, differences ? "succeeded" : "failed", txs_to_request.size(), txs_to_announce.size());
+        return differences.has_value();
+    }
+
+    bool HandleReconciliationDifference(NodeId peer_id, bool recon_succeeded, const std::vector<uint32_t>& ask_shortids,
+                                        std::vector<uint256>& txs_to_announce) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        TxReconciliationState* recon_state{GetRegisteredPeerState(peer_id)};
+        if (!recon_state || recon_state->m_we_initiate || !recon_state->m_sketch_sent) return false;
+        recon_state->m_sketch_sent = false;
+
+        txs_to_announce.clear();
+        if (recon_succeeded) {
+            const std::unordered_set<uint32_t> asked(ask_shortids.begin(), ask_shortids.end());
+            for (const uint256& wtxid : recon_state->m_local_set_snapshot) {
+                if (asked.count(recon_state->ComputeShortID(wtxid))) txs_to_announce.push_back(wtxid);
+            }
+        } else {
+            txs_to_announce.assign(recon_state->m_local_set_snapshot.begin(), recon_state->m_local_set_snapshot.end());
+        }
+        recon_state->m_local_set_snapshot.clear();
+        return true;
+    }
+
+private:
+    TxReconciliationState* GetRegisteredPeerState(NodeId peer_id) EXCLUSIVE_LOCKS_REQUIRED(m_txreconciliation_mutex)
+    {
+        auto recon_state = m_states.find(peer_id);
+        if (recon_state == m_states.end()) return nullptr;
+        return std::get_if<TxReconciliationState>(&recon_state->second);
+    }
+
+    const TxReconciliationState* GetRegisteredPeerState(NodeId peer_id) const EXCLUSIVE_LOCKS_REQUIRED(m_txreconciliation_mutex)
+    {
+        auto recon_state = m_states.find(peer_id);
+        if (recon_state == m_states.end()) return nullptr;
+        return std::get_if<TxReconciliationState>(&recon_state->second);
+    }
 };
 
 TxReconciliationTracker::TxReconciliationTracker(uint32_t recon_version) : m_impl{std::make_unique<TxReconciliationTracker::Impl>(recon_version)} {}
@@ -167,3 +370,40 @@ bool TxReconciliationTracker::IsPeerRegistered(NodeId peer_id) const
 {
     return m_impl->IsPeerRegistered(peer_id);
 }
+
+bool TxReconciliationTracker::AddToSet(NodeId peer_id, const uint256& wtxid)
+{
+    return m_impl->AddToSet(peer_id, wtxid);
+}
+
+bool TxReconciliationTracker::ShouldFanoutTo(NodeId peer_id, const uint256& wtxid) const
+{
+    return m_impl->ShouldFanoutTo(peer_id, wtxid);
+}
+
+std::optional<std::pair<uint16_t, uint16_t>> TxReconciliationTracker::InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now)
+{
+    return m_impl->InitiateReconciliationRequest(peer_id, now);
+}
+
+bool TxReconciliationTracker::HandleReconciliationRequest(NodeId peer_id, uint16_t peer_recon_set_size, uint16_t peer_q)
+{
+    return m_impl->HandleReconciliationRequest(peer_id, peer_recon_set_size, peer_q);
+}
+
+std::optional<std::vector<uint8_t>> TxReconciliationTracker::RespondToReconciliationRequest(NodeId peer_id)
+{
+    return m_impl->RespondToReconciliationRequest(peer_id);
+}
+
+std::optional<bool> TxReconciliationTracker::HandleSketch(NodeId peer_id, Span<const uint8_t> skdata,
+                                                          std::vector<uint32_t>& txs_to_request, std::vector<uint256>& txs_to_announce)
+{
+    return m_impl->HandleSketch(peer_id, skdata, txs_to_request, txs_to_announce);
+}
+
+bool TxReconciliationTracker::HandleReconciliationDifference(NodeId peer_id, bool recon_succeeded, const std::vector<uint32_t>& ask_shortids,
+                                                             std::vector<uint256>& txs_to_announce)
+{
+    return m_impl->HandleReconciliationDifference(peer_id, recon_succeeded, ask_shortids, txs_to_announce);
+}
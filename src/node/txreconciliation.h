@@ -6,15 +6,35 @@
 #define BITCOIN_NODE_TXRECONCILIATION_H
 
 #include <net.h>
+#include <span.h>
 #include <sync.h>
+#include <uint256.h>
+#include <util/time.h>
 
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <tuple>
+#include <vector>
 
 /** Whether transaction reconciliation protocol should be enabled by default. */
 static constexpr bool DEFAULT_TXRECONCILIATION_ENABLE{false};
 /** Supported transaction reconciliation protocol version */
 static constexpr uint32_t TXRECONCILIATION_VERSION{1};
+/** How often we request a reconciliation from each of the peers we initiate them with. */
+static constexpr auto RECON_REQUEST_INTERVAL{8s};
+/**
+ * Of the peers we initiate reconciliations with, the share (one in so many) a transaction is
+ * flooded to rather than reconciled, so that it keeps propagating at the speed of flooding.
+ */
+static constexpr uint32_t RECON_FANOUT_RATIO{8};
+/** Transactions in the set of a peer above which further ones are flooded to it instead. */
+static constexpr size_t MAX_RECON_SET_SIZE{3000};
+/** Sketch capacity above which a reconciliation is given up, falling back to announcing the sets. */
+static constexpr uint32_t MAX_SKETCH_CAPACITY{2 << 12};
+/** Coefficient to estimate the set difference from the smaller set, as sent scaled by Q_PRECISION. */
+static constexpr double RECON_Q{0.25};
+static constexpr uint16_t Q_PRECISION{(2 << 14) - 1};
 
 enum class ReconciliationRegisterResult {
     NOT_FOUND,
@@ -86,6 +106,53 @@ public:
      * Check if a peer is registered to reconcile transactions with us.
      */
     bool IsPeerRegistered(NodeId peer_id) const;
+
+    /**
+     * Step 1. Add a transaction to announce to the peer to its reconciliation set. False if the
+     * peer is not registered or its set is full, in which case the transaction is to be flooded.
+     */
+    bool AddToSet(NodeId peer_id, const uint256& wtxid);
+
+    /**
+     * Step 1. Whether to flood the transaction to the peer rather than reconciling it: every
+     * transaction to a few of the peers we initiate reconciliations with, and to unregistered peers.
+     */
+    bool ShouldFanoutTo(NodeId peer_id, const uint256& wtxid) const;
+
+    /**
+     * Step 2. If it is time to request a reconciliation from a peer we initiate them with, the
+     * size of our set and the q coefficient to send in a reqrecon message.
+     */
+    std::optional<std::pair<uint16_t, uint16_t>> InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now);
+
+    /**
+     * Step 2. Record a reconciliation requested by a peer we respond to, to be answered on our
+     * next announcement to it. False if the request is a protocol violation.
+     */
+    bool HandleReconciliationRequest(NodeId peer_id, uint16_t peer_recon_set_size, uint16_t peer_q);
+
+    /**
+     * Step 2. The sketch of our set to answer a pending request of the peer with, if there is one.
+     * The set is put aside until the peer tells the difference it found. An empty sketch tells
+     * the peer the difference is too large to be worth reconciling.
+     */
+    std::optional<std::vector<uint8_t>> RespondToReconciliationRequest(NodeId peer_id);
+
+    /**
+     * Steps 3 and 4. Find the difference of our set to the one sketched by a peer we requested a
+     * reconciliation from. On success, the short ids of the transactions we miss and those of
+     * our set the peer misses are returned, otherwise our whole set is to be announced.
+     * nullopt for a protocol violation, else whether the reconciliation succeeded.
+     */
+    std::optional<bool> HandleSketch(NodeId peer_id, Span<const uint8_t> skdata,
+                                     std::vector<uint32_t>& txs_to_request, std::vector<uint256>& txs_to_announce);
+
+    /**
+     * Step 4. The transactions of the set put aside to announce to a peer we responded to, as
+     * asked for, or all of them if the reconciliation failed. False for a protocol violation.
+     */
+    bool HandleReconciliationDifference(NodeId peer_id, bool recon_succeeded, const std::vector<uint32_t>& ask_shortids,
+                                        std::vector<uint256>& txs_to_announce);
 };
 
 #endif // BITCOIN_NODE_TXRECONCILIATION_H
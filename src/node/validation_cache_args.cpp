@@ -30,5 +30,11 @@ void ApplyArgsManOptions(const ArgsManager& argsman, ValidationCacheSizes& cache
             .script_execution_cache_bytes = clamped_size_each,
         };
     }
+    if (auto budget = argsman.GetIntArg("-sigcachebudget")) {
+        // Split as -maxsigcachesize is
+        size_t clamped_budget_each = std::max<int64_t>(*budget, 0) * (1 << 20) / 2;
+        cache_sizes.signature_cache_max_bytes = clamped_budget_each;
+        cache_sizes.script_execution_cache_max_bytes = clamped_budget_each;
+    }
 }
 } // namespace node
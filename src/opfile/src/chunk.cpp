@@ -1,5 +1,10 @@
+#include <algorithm>
 #include <iomanip>
 
+#include <crypto/sha256.h>
+#include <hash.h>
+
+#include "chunk.h"
 #include "protocol.h"
 #include "util.h"
 
@@ -112,3 +117,226 @@ void get_chunkdata_from_chunk (std::string chunk, std::string& chunkdata, int ch
     // chunkdata = get_hex_from_offset(chunk, offset + (OPENCODING_MAGICLEN*2) + (OPENCODING_VERSIONLEN*2) + (OPENCODING_UUID*2) + (OPENCODING_CHUNKLEN*2) + (OPENCODING_CHECKSUM*2) + (OPENCODING_CHUNKNUM*2) + (OPENCODING_CHUNKTOTAL*2), chunkdata_sz*2);
     chunkdata = chunk.substr (offset + (OPENCODING_MAGICLEN*2) + (OPENCODING_VERSIONLEN*2) + (OPENCODING_UUID*2) + (OPENCODING_CHUNKLEN*2) + (OPENCODING_CHECKSUM*2) + (OPENCODING_CHUNKNUM*2) + (OPENCODING_CHUNKTOTAL*2), chunkdata_sz*2);
 }
+
+// Read big-endian integer of given width
+static uint32_t read_be (Span<const unsigned char> bytes) {
+    uint32_t value = 0;
+    for (unsigned char b : bytes) {
+        value = (value << 8) | b;
+    }
+    return value;
+}
+
+// Version byte is one of OPENCODING_VERSION
+static bool is_known_version (uint8_t version) {
+    static const char hexdigits[] = "0123456789abcdef";
+    for (auto& l : OPENCODING_VERSION) {
+        if (l.size() == 2 && l[0] == hexdigits[version >> 4] && l[1] == hexdigits[version & 0x0f]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Read a canonical compactsize varint, advancing offset
+static bool read_varint (Span<const unsigned char> bytes, size_t& offset, uint64_t& value) {
+    if (offset >= bytes.size()) {
+        return false;
+    }
+    const uint8_t first = bytes[offset++];
+    size_t len = first < 253 ? 0 : first == 253 ? 2 : first == 254 ? 4 : 8;
+    if (len == 0) {
+        value = first;
+        return true;
+    }
+    if (bytes.size() - offset < len) {
+        return false;
+    }
+    // little endian, as CompactSize
+    value = 0;
+    for (size_t i = 0; i < len; i++) {
+        value |= uint64_t(bytes[offset + i]) << (8 * i);
+    }
+    offset += len;
+    // reject non-canonical forms, so every chunk has a single encoding
+    return value >= (len == 2 ? 253 : len == 4 ? 0x10000 : 0x100000000ULL);
+}
+
+uint32_t get_chunkmax_for_version (uint8_t version) {
+    return version == OPENCODING_COMPACT ? OPENCODING_COMPACT_CHUNKMAX : OPENCODING_CHUNKMAX;
+}
+
+// Protocol 02 fields following the uuid
+static bool parse_compact_chunk (chunk_view& view, size_t offset, int& error_level) {
+
+    view.checksum = {};
+    view.flags = view.filelen = view.rawlen = 0;
+    view.merkleroot = view.contenthash = view.encryption = view.extension = {};
+
+    uint64_t chunknum;
+    if (!read_varint(view.payload, offset, chunknum) || chunknum > UINT32_MAX) {
+        error_level = ERR_CHUNKNUM;
+        return false;
+    }
+    view.chunknum = chunknum;
+
+    // data chunk, remainder is the data. chunktotal is only known from the header
+    if (chunknum > 0) {
+        view.data = view.payload.subspan(offset);
+        if (view.data.empty() || view.data.size() > OPENCODING_COMPACT_CHUNKMAX) {
+            error_level = ERR_CHUNKLEN;
+            return false;
+        }
+        view.chunklen = view.data.size();
+        view.chunktotal = 0;
+        view.signature = {};
+        return true;
+    }
+
+    // header chunk, chunklen 0 as for the other versions
+    uint64_t extlen = 0;
+    if (!read_varint(view.payload, offset, view.flags) || !read_varint(view.payload, offset, view.filelen) ||
+        view.filelen > uint64_t(UINT32_MAX - 1) * OPENCODING_COMPACT_CHUNKMAX || view.payload.size() - offset < OPENCODING_MERKLEROOT) {
+        error_level = ERR_CHUNKLEN;
+        return false;
+    }
+    if (view.flags & ~OPENCODING_FLAGS_KNOWN) {
+        error_level = ERR_CHUNKVERSION;
+        return false;
+    }
+    if (view.flags & OPENCODING_FLAG_COMPRESSED) {
+        if (!read_varint(view.payload, offset, view.rawlen) || view.rawlen > OPENCODING_COMPRESSED_MAXLEN ||
+            view.payload.size() - offset < OPENCODING_MERKLEROOT) {
+            error_level = ERR_CHUNKLEN;
+            return false;
+        }
+    }
+    view.merkleroot = view.payload.subspan(offset, OPENCODING_MERKLEROOT);
+    offset += OPENCODING_MERKLEROOT;
+    if (view.flags & OPENCODING_FLAG_CONTENTHASH) {
+        if (view.payload.size() - offset < OPENCODING_CONTENTHASH) {
+            error_level = ERR_CHUNKLEN;
+            return false;
+        }
+        view.contenthash = view.payload.subspan(offset, OPENCODING_CONTENTHASH);
+        offset += OPENCODING_CONTENTHASH;
+    }
+    if (view.flags & OPENCODING_FLAG_ENCRYPTED) {
+        if (view.payload.size() - offset < OPENCODING_ENCRYPTION) {
+            error_level = ERR_CHUNKLEN;
+            return false;
+        }
+        view.encryption = view.payload.subspan(offset, OPENCODING_ENCRYPTION);
+        offset += OPENCODING_ENCRYPTION;
+    }
+    if (!read_varint(view.payload, offset, extlen) || view.payload.size() - offset < extlen) {
+        error_level = ERR_EXTENSION;
+        return false;
+    }
+    view.extension = view.payload.subspan(offset, extlen);
+    offset += extlen;
+
+    view.chunklen = 0;
+    view.chunktotal = (view.filelen + OPENCODING_COMPACT_CHUNKMAX - 1) / OPENCODING_COMPACT_CHUNKMAX;
+    view.signature = view.payload.subspan(offset);
+    view.data = {};
+    return true;
+}
+
+bool get_payload_from_script (Span<const unsigned char> script, Span<const unsigned char>& payload) {
+    if (script.size() < 2) {
+        return false;
+    }
+    // OP_PUSHDATA2 (256-65535)
+    if (script[1] == 0x4d) {
+        if (script.size() < 4) return false;
+        payload = script.subspan(4);
+        return true;
+    }
+    // OP_PUSHDATA1 (80-255)
+    if (script[1] == 0x4c) {
+        if (script.size() < 3) return false;
+        payload = script.subspan(3);
+        return true;
+    }
+    // legacy encoding (0-79?)
+    payload = script.subspan(2);
+    return true;
+}
+
+bool parse_chunk_from_script (Span<const unsigned char> script, chunk_view& view, int& error_level) {
+
+    const size_t prefixlen = OPENCODING_MAGICLEN + OPENCODING_VERSIONLEN + OPENCODING_UUID + OPENCODING_CHUNKLEN;
+    const size_t metalen = OPENCODING_CHECKSUM + OPENCODING_CHUNKNUM + OPENCODING_CHUNKTOTAL;
+
+    if (!get_payload_from_script(script, view.payload) || view.payload.size() < prefixlen) {
+        error_level = ERR_CHUNKMAGIC;
+        return false;
+    }
+
+    // check lynx magic
+    if (!std::equal(std::begin(OPENCODING_MAGIC_BIN), std::end(OPENCODING_MAGIC_BIN), view.payload.begin())) {
+        error_level = ERR_CHUNKMAGIC;
+        return false;
+    }
+
+    // check version byte
+    view.version = view.payload[OPENCODING_MAGICLEN];
+    if (!is_known_version(view.version)) {
+        error_level = ERR_CHUNKVERSION;
+        return false;
+    }
+
+    size_t offset = OPENCODING_MAGICLEN + OPENCODING_VERSIONLEN;
+    view.uuid = view.payload.subspan(offset, OPENCODING_UUID);
+    offset += OPENCODING_UUID;
+
+    if (view.version == OPENCODING_COMPACT) {
+        return parse_compact_chunk(view, offset, error_level);
+    }
+    view.flags = view.filelen = view.rawlen = 0;
+    view.merkleroot = view.contenthash = view.encryption = view.extension = {};
+
+    view.chunklen = read_be(view.payload.subspan(offset, OPENCODING_CHUNKLEN));
+    offset += OPENCODING_CHUNKLEN;
+
+    // header chunk, remainder is the signature
+    if (view.chunklen == 0) {
+        view.signature = view.payload.subspan(offset);
+        view.checksum = view.data = {};
+        view.chunknum = view.chunktotal = 0;
+        return true;
+    }
+
+    // data chunk
+    if (view.payload.size() < offset + metalen) {
+        error_level = ERR_CHUNKLEN;
+        return false;
+    }
+    view.signature = {};
+    view.checksum = view.payload.subspan(offset, OPENCODING_CHECKSUM);
+    offset += OPENCODING_CHECKSUM;
+    view.chunknum = read_be(view.payload.subspan(offset, OPENCODING_CHUNKNUM));
+    offset += OPENCODING_CHUNKNUM;
+    view.chunktotal = read_be(view.payload.subspan(offset, OPENCODING_CHUNKTOTAL));
+    offset += OPENCODING_CHUNKTOTAL;
+    // a short chunk keeps what is there, its checksum will not match
+    view.data = view.payload.subspan(offset, std::min<size_t>(view.chunklen, view.payload.size() - offset));
+
+    return true;
+}
+
+// Hash signed by the header chunk, sha256 of the hex notation of the header prefix
+uint256 get_header_sighash (const chunk_view& view) {
+    // protocol 02 signs the double sha256 of everything ahead of the signature
+    if (view.version == OPENCODING_COMPACT) {
+        return Hash(view.payload.first(view.signature.data() - view.payload.data()));
+    }
+    const size_t prefixlen = OPENCODING_MAGICLEN + OPENCODING_VERSIONLEN + OPENCODING_UUID + OPENCODING_CHUNKLEN;
+    unsigned char digest[CSHA256::OUTPUT_SIZE];
+    sha256_hash_of_hex(view.payload.first(prefixlen), digest);
+    // same as uint256S of the hex digest
+    uint256 authhash;
+    std::reverse_copy(std::begin(digest), std::end(digest), authhash.begin());
+    return authhash;
+}
@@ -1,9 +1,47 @@
 #ifndef CHUNK_H
 #define CHUNK_H
 
+#include <span.h>
+#include <uint256.h>
+
+#include <cstdint>
 #include <string>
 #include <vector>
 
+//! zero-copy view over a chunk carried in an OP_RETURN script
+struct chunk_view {
+    Span<const unsigned char> payload;      //! pushed data, from magic to end of script
+    uint8_t version{0};
+    Span<const unsigned char> uuid;
+    uint16_t chunklen{0};
+    Span<const unsigned char> signature;    //! header chunk only (chunklen 0)
+    Span<const unsigned char> checksum;     //! data chunk only
+    uint32_t chunknum{0};
+    uint32_t chunktotal{0};
+    Span<const unsigned char> data;         //! data chunk only
+
+    // protocol 02 header chunk only, chunktotal then follows from filelen
+    uint64_t flags{0};
+    uint64_t filelen{0};
+    uint64_t rawlen{0};                     //! decompressed length, with OPENCODING_FLAG_COMPRESSED
+    Span<const unsigned char> merkleroot;
+    Span<const unsigned char> contenthash;  //! sha256 of the file, with OPENCODING_FLAG_CONTENTHASH
+    Span<const unsigned char> encryption;   //! nonce and key check, with OPENCODING_FLAG_ENCRYPTED
+    Span<const unsigned char> extension;
+};
+
+//! length of every data chunk but the last, for a protocol version
+uint32_t get_chunkmax_for_version (uint8_t version);
+
+//! locate the pushed payload of an OP_RETURN script (same rules as strip_opreturndata_from_chunk)
+bool get_payload_from_script (Span<const unsigned char> script, Span<const unsigned char>& payload);
+
+//! parse a storage chunk directly from script bytes, without hex conversion
+bool parse_chunk_from_script (Span<const unsigned char> script, chunk_view& view, int& error_level);
+
+//! hash a header chunk signs, from which its signature recovers the tenant key
+uint256 get_header_sighash (const chunk_view& view);
+
 // void get_magic_from_chunk(std::string chunk, std::string& magic);
 void get_magic_from_chunk (std::string chunk, std::string& magic, int offset);
 
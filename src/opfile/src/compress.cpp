@@ -0,0 +1,277 @@
+#include "compress.h"
+
+#include <algorithm>
+#include <cstring>
+
+// lz4 block format limits, a match is at least MINMATCH long, may not start in the
+// last MFLIMIT bytes of the block, and the last LASTLITERALS bytes are always literals
+static const size_t MINMATCH = 4;
+static const size_t MFLIMIT = 12;
+static const size_t LASTLITERALS = 5;
+static const size_t MAXOFFSET = 65535;
+static const int HASHLOG = 12;
+
+static uint32_t read32 (const unsigned char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// length beyond the 4 bit token field, as runs of 255
+static void append_length (std::vector<unsigned char>& out, size_t len) {
+    while (len >= 255) {
+        out.push_back(255);
+        len -= 255;
+    }
+    out.push_back(len);
+}
+
+static void append_sequence (std::vector<unsigned char>& out, const unsigned char* literals, size_t litlen, size_t offset, size_t matchlen) {
+
+    const size_t matchcode = matchlen ? matchlen - MINMATCH : 0;
+    out.push_back((std::min<size_t>(litlen, 15) << 4) | std::min<size_t>(matchcode, 15));
+    if (litlen >= 15) {
+        append_length(out, litlen - 15);
+    }
+    out.insert(out.end(), literals, literals + litlen);
+
+    // final sequence, literals only
+    if (!matchlen) {
+        return;
+    }
+    out.push_back(offset & 0xff);
+    out.push_back(offset >> 8);
+    if (matchcode >= 15) {
+        append_length(out, matchcode - 15);
+    }
+}
+
+void compress_block (const unsigned char* src, size_t len, std::vector<unsigned char>& out) {
+
+    // positions + 1 of the last occurrence of each hashed 4 byte sequence, 0 if none
+    std::vector<uint32_t> table(1 << HASHLOG, 0);
+
+    size_t anchor = 0;
+    size_t ip = 0;
+    const size_t mflimit = len > MFLIMIT ? len - MFLIMIT : 0;
+    const size_t matchlimit = len > LASTLITERALS ? len - LASTLITERALS : 0;
+
+    while (ip < mflimit) {
+
+        const uint32_t sequence = read32(src + ip);
+        uint32_t& entry = table[(sequence * 2654435761U) >> (32 - HASHLOG)];
+        const size_t ref = entry;
+        entry = ip + 1;
+
+        if (ref == 0 || ip - (ref - 1) > MAXOFFSET || read32(src + ref - 1) != sequence) {
+            ip++;
+            continue;
+        }
+
+        const size_t match = ref - 1;
+        size_t matchlen = MINMATCH;
+        while (ip + matchlen < matchlimit && src[match + matchlen] == src[ip + matchlen]) {
+            matchlen++;
+        }
+
+        append_sequence(out, src + anchor, ip - anchor, ip - match, matchlen);
+        ip += matchlen;
+        anchor = ip;
+    }
+
+    append_sequence(out, src + anchor, len - anchor, 0, 0);
+}
+
+// read a length extension at ip, adding it to len
+static bool read_length (const unsigned char* src, size_t srclen, size_t& ip, size_t& len) {
+    unsigned char byte;
+    do {
+        if (ip >= srclen) {
+            return false;
+        }
+        byte = src[ip++];
+        len += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool decompress_block (const unsigned char* src, size_t srclen, unsigned char* dst, size_t dstlen) {
+
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (ip < srclen) {
+
+        const unsigned char token = src[ip++];
+
+        size_t litlen = token >> 4;
+        if (litlen == 15 && !read_length(src, srclen, ip, litlen)) {
+            return false;
+        }
+        if (litlen > srclen - ip || litlen > dstlen - op) {
+            return false;
+        }
+        memcpy(dst + op, src + ip, litlen);
+        ip += litlen;
+        op += litlen;
+
+        // the final sequence ends the block with literals
+        if (ip == srclen) {
+            return op == dstlen;
+        }
+
+        if (srclen - ip < 2) {
+            return false;
+        }
+        const size_t offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            return false;
+        }
+
+        size_t matchlen = token & 0x0f;
+        if (matchlen == 15 && !read_length(src, srclen, ip, matchlen)) {
+            return false;
+        }
+        matchlen += MINMATCH;
+        if (matchlen > dstlen - op) {
+            return false;
+        }
+
+        // byte by byte, a match may overlap what it is copying
+        for (size_t i = 0; i < matchlen; i++, op++) {
+            dst[op] = dst[op - offset];
+        }
+    }
+
+    return false;
+}
+
+static bool read_varint (const unsigned char* src, size_t srclen, size_t& offset, uint64_t& value) {
+    if (offset >= srclen) {
+        return false;
+    }
+    const unsigned char first = src[offset++];
+    if (first < 253) {
+        value = first;
+        return true;
+    }
+    const size_t width = first == 253 ? 2 : first == 254 ? 4 : 8;
+    if (srclen - offset < width) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < width; i++) {
+        value |= uint64_t(src[offset++]) << (8 * i);
+    }
+    return true;
+}
+
+bool read_block_header (const unsigned char* src, size_t srclen, size_t& headerlen, uint64_t& rawlen, uint64_t& complen) {
+    headerlen = 0;
+    return read_varint(src, srclen, headerlen, rawlen) && read_varint(src, srclen, headerlen, complen);
+}
+
+static bool write_varint (FILE* out, uint64_t value, uint64_t& outlen) {
+    unsigned char buf[9];
+    size_t len = 0;
+    if (value < 253) {
+        buf[len++] = value;
+    } else {
+        const int width = value <= 0xffff ? 2 : value <= 0xffffffff ? 4 : 8;
+        buf[len++] = width == 2 ? 253 : width == 4 ? 254 : 255;
+        for (int i = 0; i < width; i++) {
+            buf[len++] = (value >> (8 * i)) & 0xff;
+        }
+    }
+    outlen += len;
+    return fwrite(buf, 1, len, out) == len;
+}
+
+static bool read_varint (FILE* in, uint64_t& value) {
+    const int first = fgetc(in);
+    if (first == EOF) {
+        return false;
+    }
+    if (first < 253) {
+        value = first;
+        return true;
+    }
+    const int width = first == 253 ? 2 : first == 254 ? 4 : 8;
+    value = 0;
+    for (int i = 0; i < width; i++) {
+        const int byte = fgetc(in);
+        if (byte == EOF) {
+            return false;
+        }
+        value |= uint64_t(byte) << (8 * i);
+    }
+    return true;
+}
+
+bool compress_stream (FILE* in, FILE* out, uint64_t& outlen) {
+
+    outlen = 0;
+    std::vector<unsigned char> raw(COMPRESS_BLOCK);
+    std::vector<unsigned char> block;
+
+    while (true) {
+        const size_t rawlen = fread(raw.data(), 1, raw.size(), in);
+        if (rawlen == 0) {
+            return !ferror(in);
+        }
+
+        block.clear();
+        compress_block(raw.data(), rawlen, block);
+
+        // incompressible blocks are kept as they are
+        const unsigned char* data = block.data();
+        if (block.size() >= rawlen) {
+            data = raw.data();
+            block.resize(rawlen);
+        }
+
+        if (!write_varint(out, rawlen, outlen) || !write_varint(out, block.size(), outlen) ||
+            fwrite(data, 1, block.size(), out) != block.size()) {
+            return false;
+        }
+        outlen += block.size();
+    }
+}
+
+bool decompress_stream (FILE* in, FILE* out, uint64_t rawlen) {
+
+    std::vector<unsigned char> raw(COMPRESS_BLOCK);
+    std::vector<unsigned char> block;
+
+    uint64_t written = 0;
+    while (written < rawlen) {
+
+        uint64_t blocklen, complen;
+        if (!read_varint(in, blocklen) || !read_varint(in, complen) ||
+            blocklen == 0 || blocklen > COMPRESS_BLOCK || complen > blocklen || blocklen > rawlen - written) {
+            return false;
+        }
+
+        block.resize(complen);
+        if (fread(block.data(), 1, complen, in) != complen) {
+            return false;
+        }
+
+        const unsigned char* data = block.data();
+        if (complen < blocklen) {
+            if (!decompress_block(block.data(), complen, raw.data(), blocklen)) {
+                return false;
+            }
+            data = raw.data();
+        }
+
+        if (fwrite(data, 1, blocklen, out) != blocklen) {
+            return false;
+        }
+        written += blocklen;
+    }
+
+    // nothing may follow the last block
+    return fgetc(in) == EOF;
+}
@@ -0,0 +1,33 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+//! file bytes compressed as one independent block, so decompressing needs one block in memory
+const size_t COMPRESS_BLOCK = 65536;
+
+//! compressed stream format
+//!
+//! a sequence of blocks, each | varint(rawlen) varint(complen) data
+//!
+//! data is the block in lz4 block format, or the block as is when complen equals rawlen.
+//! every block holds COMPRESS_BLOCK file bytes, but the last
+
+//! compress up to COMPRESS_BLOCK bytes in lz4 block format, appending to out
+void compress_block (const unsigned char* src, size_t len, std::vector<unsigned char>& out);
+
+//! decompress one lz4 block into exactly dstlen bytes. false if the block is malformed
+bool decompress_block (const unsigned char* src, size_t srclen, unsigned char* dst, size_t dstlen);
+
+//! parse the varints leading a block of the compressed stream format. false until src holds all of them
+bool read_block_header (const unsigned char* src, size_t srclen, size_t& headerlen, uint64_t& rawlen, uint64_t& complen);
+
+//! compress the rest of in to out, setting outlen to the bytes written
+bool compress_stream (FILE* in, FILE* out, uint64_t& outlen);
+
+//! decompress the rest of in to out, which must come to exactly rawlen bytes
+bool decompress_stream (FILE* in, FILE* out, uint64_t rawlen);
+
+#endif // COMPRESS_H
@@ -1,15 +1,27 @@
 #include "chunk.h"
+#include "compress.h"
+#include "decode.h"
 #include "protocol.h"
 #include "util.h"
 
+#include <consensus/merkle.h>
+#include <crypto/sha256.h>
+#include <hash.h>
+#include <support/cleanse.h>
+
 #include <storage/auth.h>
 
 #include <logging.h>
+#include <util/threadnames.h>
+#include <util/trace.h>
 
 #include <key_io.h>
 
 #include <time.h>
 
+#include <algorithm>
+#include <cstdio>
+
 // #define TIMING 1
 
 extern ChainstateManager* storage_chainman;
@@ -101,10 +113,10 @@ bool is_valid_authchunk (std::string& chunk, int& error_level, int offset)
     char checkhash[OPENCODING_CHECKSUM*8];
     memset(checkhash, 0, sizeof(checkhash));
 
-//LogPrint (BCLog::ALL, "chunk.c_str() %s\n", chunk.c_str());
-//LogPrint (BCLog::ALL, "opdata.c_str() %s\n", opdata.c_str());
-//LogPrint (BCLog::ALL, "&opdata.c_str()[6] %s\n", &opdata.c_str()[6]);
-//LogPrint (BCLog::ALL, "\n");
+//LogPrint (BCLog::STORAGE, "chunk.c_str() %s\n", chunk.c_str());
+//LogPrint (BCLog::STORAGE, "opdata.c_str() %s\n", opdata.c_str());
+//LogPrint (BCLog::STORAGE, "&opdata.c_str()[6] %s\n", &opdata.c_str()[6]);
+//LogPrint (BCLog::STORAGE, "\n");
 
     //sha256_hash_hex(chunk.c_str(), checkhash, (OPENCODING_MAGICLEN*2) + (OPENCODING_VERSIONLEN*2) + (OPENCODING_UUID*2) + (OPENCODING_CHUNKLEN*2));
     sha256_hash_hex(&chunk.c_str()[offset], checkhash, (OPENCODING_MAGICLEN*2) + (OPENCODING_VERSIONLEN*2) + (OPENCODING_UUID*2) + (OPENCODING_CHUNKLEN*2));
@@ -121,12 +133,12 @@ bool is_valid_authchunk (std::string& chunk, int& error_level, int offset)
     // test pubkey
     uint160 hash160(Hash160(pubkey));
 
-    LogPrint (BCLog::ALL, "pubKey from header chunk signature %s\n", hash160.ToString());
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::STORAGE, "pubKey from header chunk signature %s\n", hash160.ToString());
+    LogPrint (BCLog::STORAGE, "\n");
 
 ghshAuthenticatetenantPubkey = hash160;    
 
-// LogPrint (BCLog::ALL, "initAuthTime %d\n", Params().GetConsensus().initAuthTime);
+// LogPrint (BCLog::STORAGE, "initAuthTime %d\n", Params().GetConsensus().initAuthTime);
 
 // authTime = Params().GetConsensus().initAuthTime;
 
@@ -144,7 +156,8 @@ ghshAuthenticatetenantPubkey = hash160;
     return true;
 }
 
-bool extract_pubkey_from_signature (std::string& chunk, int offset) {
+// Recover the hash160 of the key that signed a header chunk, without touching global state
+bool recover_tenant_from_header (std::string& chunk, int offset, uint160& tenant) {
 
     std::string signature;
     std::vector<unsigned char> vchsig;
@@ -159,49 +172,67 @@ bool extract_pubkey_from_signature (std::string& chunk, int offset) {
     checkhash[OPENCODING_CHECKSUM*4] = 0;
     uint256 authhash = uint256S(std::string(checkhash));
 
-    // extract pubkey
+    // extract pubkey, a failed recovery leaving the hash160 of the invalid key
     CPubKey pubkey;
-    pubkey.RecoverCompact(authhash, vchsig);
+    const bool recovered{pubkey.RecoverCompact(authhash, vchsig)};
+    tenant = Hash160(pubkey);
 
-    ghshAuthenticatetenantPubkey = Hash160(pubkey);
-
-// ghshAuthenticatetenantPubkey = hash160;    
-
-    return true;
+    return recovered;
+}
 
+void get_header_signed_hash (const chunk_view& view, signed_hash& header) {
+    header.hash = get_header_sighash(view);
+    header.signature.assign(view.signature.begin(), view.signature.end());
 }
 
-//bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& error_level, int& total_chunks, std::vector<std::string>& encoded_chunks) {
-bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& error_level, int& total_chunks, std::vector<std::string>& encoded_chunks, int offset) {
+bool recover_tenant_from_header (const chunk_view& view, uint160& tenant) {
+    const std::optional<uint160> signer{recover_signer(get_header_sighash(view), view.signature)};
+    // as the hash160 of the invalid key a failed recovery leaves
+    tenant = signer ? *signer : Hash160(CPubKey{});
+    return signer.has_value();
+}
 
-    clock_t start, end;
+bool is_valid_authchunk (const chunk_view& view, int& error_level, uint160& tenant)
+{
+    if (!recover_tenant_from_header (view, tenant)) {
+        error_level = ERR_CHUNKAUTHSIG;
+        return false;
+    }
 
-    double t_gufc = 0.0;
+    LogPrint (BCLog::STORAGE, "pubKey from header chunk signature %s\n", tenant.ToString());
+    LogPrint (BCLog::STORAGE, "\n");
 
-    double t_gclfc = 0.0;
+    return true;
+}
 
-    double t_gchfc = 0.0;
+bool is_valid_chunkhash (const chunk_view& view)
+{
+    // checksum is the leading bytes of sha256 of the hex notation of the data
+    unsigned char digest[CSHA256::OUTPUT_SIZE];
+    sha256_hash_of_hex(view.data, digest);
+    return view.checksum.size() == OPENCODING_CHECKSUM && std::equal(view.checksum.begin(), view.checksum.end(), digest);
+}
 
-    double t_gcdfc = 0.0;
+bool extract_pubkey_from_signature (std::string& chunk, int offset) {
 
-    double t_shh = 0.0;
+    recover_tenant_from_header (chunk, offset, ghshAuthenticatetenantPubkey);
 
-    double t_gcnfc = 0.0;
+    return true;
 
-    double t_gctfc = 0.0;
+}
 
-    double t_bfh = 0.0;
+//bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& error_level, int& total_chunks, std::vector<std::string>& encoded_chunks) {
+//bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& error_level, int& total_chunks, std::vector<std::string>& encoded_chunks, int offset) {
+bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& error_level, int& total_chunks, std::vector<CScript>& encoded_chunks) {
 
     error_level = NO_ERROR;
 
     bool lastchunk;
-    char checkhash[OPENCODING_CHECKSUM*4];
-    unsigned char buffer[OPENCODING_CHUNKMAX*2];
-    //int protocol, offset, thischunk, chunknum2, chunklen2, chunktotal2, extskip;
-    int protocol, thischunk, chunknum2, chunklen2, chunktotal2, extskip;
-    std::string chunklen, uuid, uuid2, chunkhash, checksum, chunknum, chunktotal, chunkdata, filepath;
+    int protocol, thischunk, extskip;
+    std::string filepath;
+    Span<const unsigned char> uuid, chunkdata;
+    chunk_view view;
 
-    //offset = 0;
     extskip = 0;
     protocol = 0;
     thischunk = 1;
@@ -214,166 +245,78 @@ bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& e
         return false;
     }
 
-    for (auto& chunk : encoded_chunks) {
+    for (size_t i = 0; i < encoded_chunks.size(); i++) {
 
         // note the last chunk
-        if (chunk == encoded_chunks.back()) {
+        if (i == encoded_chunks.size() - 1) {
             lastchunk = true;
         }
 
-//    start = clock ();    
-
-        // perform contextual checks
-        //if (!check_chunk_contextual(chunk, protocol, error_level)) {
-        // if (!check_chunk_contextual (chunk, protocol, error_level, offset)) {
-            //pass error_level back
-            // return false;
-        // }
-
-//    end = clock ();    
-//    t_ccc = t_ccc + (double) (end - start) / CLOCKS_PER_SEC;
-
-#ifdef TIMING
-    start = clock ();    
-#endif
+        // parse chunk straight from the script
+        if (!parse_chunk_from_script (encoded_chunks[i], view, error_level)) {
+            fclose(in);
+            return false;
+        }
 
         // ensure uuid is uniform
-        get_uuid_from_chunk (chunk, uuid, offset);
-        if (uuid2.size() > 0) {
-            if (uuid != uuid2) {
+        if (uuid.size() > 0) {
+            if (!std::equal(uuid.begin(), uuid.end(), view.uuid.begin(), view.uuid.end())) {
                 error_level = ERR_CHUNKUUID;
+                fclose(in);
                 return false;
             }
         } else {
-            uuid2 = uuid;
+            uuid = view.uuid;
         }
 
-#ifdef TIMING
-    end = clock ();    
-    t_gufc = t_gufc + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
         // ensure chunklen is uniform (besides last chunk)
-        //get_chunklen_from_chunk(chunk, chunklen);
-        get_chunklen_from_chunk (chunk, chunklen, offset);
-        chunklen2 = std::stoul(chunklen, nullptr, 16);
-
-        if (chunklen2 == 0) {
+        if (view.chunklen == 0) {
             continue;
         }
 
         // ... if datachunk
-        if (lastchunk == false && (chunklen2 != OPENCODING_CHUNKMAX)) {
+        if (lastchunk == false && (view.chunklen != OPENCODING_CHUNKMAX)) {
             error_level = ERR_CHUNKLEN;
+            fclose(in);
             return false;
         }
 
-#ifdef TIMING
-    end = clock ();    
-    t_gclfc = t_gclfc + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
         // test chunkdata hash to calculated chunkdata hash
-        get_chunkhash_from_chunk (chunk, chunkhash, offset);
-
-#ifdef TIMING
-    end = clock ();    
-    t_gchfc = t_gchfc + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
-        get_chunkdata_from_chunk (chunk, chunkdata, chunklen2, offset);
-
-#ifdef TIMING
-    end = clock ();    
-    t_gcdfc = t_gcdfc + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
-        sha256_hash_hex(chunkdata.c_str(), checkhash, chunklen2*2);
-    
-        checkhash[OPENCODING_CHECKSUM*2] = 0;
-        if (chunkhash != std::string(checkhash)) {
+        if (!is_valid_chunkhash (view)) {
             error_level = ERR_CHUNKHASH;
+            fclose(in);
             return false;
         }
 
-#ifdef TIMING
-    end = clock ();    
-    t_shh = t_shh + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
         // check chunknum is uniform
-        get_chunknum_from_chunk (chunk, chunknum, offset);
-        chunknum2 = std::stoul(chunknum, nullptr, 16);
-        if (thischunk != chunknum2) {
+        if (thischunk != (int)view.chunknum) {
             error_level = ERR_CHUNKNUM;
+            fclose(in);
             return false;
         }
 
-#ifdef TIMING
-    end = clock ();    
-    t_gcnfc = t_gcnfc + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
         // check chunktotal is correct
-        get_chunktotal_from_chunk (chunk, chunktotal, offset);
-        chunktotal2 = std::stoul(chunktotal, nullptr, 16);
-        if (encoded_chunks.size() != chunktotal2) {
+        if (encoded_chunks.size() != view.chunktotal) {
             error_level = ERR_CHUNKTOTAL;
+            fclose(in);
             return false;
         }
 
-#ifdef TIMING
-    end = clock ();    
-    t_gctfc = t_gctfc + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
         // if protocol is 01 and lastchunk is true (extensiondata)
         if (lastchunk == true && protocol == 1) {
             extskip = OPENCODING_EXTENSION;
         }
 
-#ifdef TIMING
-    start = clock ();    
-#endif
-
-        // write to buffer
-        binlify_from_hex(&buffer[0], chunkdata.c_str(), chunkdata.size());
-        if (!write_partial_stream(in, (char*)buffer, (chunkdata.size() / 2) - extskip)) {
+        // write to file
+        chunkdata = view.data;
+        if (!write_partial_stream(in, (char*)chunkdata.data(), chunkdata.size() - extskip)) {
             error_level = ERR_FILEWRITE;
+            fclose(in);
             return false;
         }
 
-#ifdef TIMING
-    end = clock ();    
-    t_bfh = t_bfh + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
         if (debug) {
-            printf("\r%d of %d chunks processed (decoding)", thischunk, chunktotal2);
+            printf("\r%d of %d chunks processed (decoding)", thischunk, view.chunktotal);
         }
 
         ++thischunk;
@@ -381,19 +324,15 @@ bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& e
 
     fclose(in);
 
-    LogPrint (BCLog::ALL, "(build_file_from_chunks)\n");
+    LogPrint (BCLog::STORAGE, "(build_file_from_chunks)\n");
 
     //! if protocol 01, rename file with extension
     if (protocol == 1) {
 
-        std::string extension;
-        int extoffset = (chunkdata.size() / 2) - extskip;
-        for (int extwrite = extoffset; extwrite < extoffset + OPENCODING_EXTENSION; extwrite++) {
-            extension += buffer[extwrite];
-        }
+        std::string extension(chunkdata.end() - extskip, chunkdata.end());
 
-        LogPrint (BCLog::ALL, "Extension found: %s\n", extension);
-        LogPrint (BCLog::ALL, "\n");
+        LogPrint (BCLog::STORAGE, "Extension found: %s\n", extension);
+        LogPrint (BCLog::STORAGE, "\n");
 
         std::string newfilepath = filepath + "." + extension;
 
@@ -402,37 +341,412 @@ bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& e
             return false;
         }
     } else {
-        LogPrint (BCLog::ALL, "No extension found.\n");
-        LogPrint (BCLog::ALL, "\n");
+        LogPrint (BCLog::STORAGE, "No extension found.\n");
+        LogPrint (BCLog::STORAGE, "\n");
     }
 
     if (debug) printf("\n");
 
-#ifdef TIMING
-    LogPrint (BCLog::ALL, "elapsed get_uuid_from_chunk %ld \n", t_gufc);
-    LogPrint (BCLog::ALL, "\n");
+    return true;
+}
 
-    LogPrint (BCLog::ALL, "elapsed get_chunklen_from_chunk %ld \n", t_gclfc);
-    LogPrint (BCLog::ALL, "\n");
+chunk_reassembler::chunk_reassembler (const std::string& filepath, int threads) : m_filepath(filepath), m_threadcount(std::max(1, threads))
+{
+    LOCK(m_file_mutex);
+    m_error = NO_ERROR;
+}
 
-    LogPrint (BCLog::ALL, "elapsed get_chunkhash_from_chunk %ld \n", t_gchfc);
-    LogPrint (BCLog::ALL, "\n");
+chunk_reassembler::~chunk_reassembler ()
+{
+    stop();
 
-    LogPrint (BCLog::ALL, "elapsed get_chunkdata_from_chunk %ld \n", t_gcdfc);
-    LogPrint (BCLog::ALL, "\n");
+    LOCK(m_file_mutex);
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    memory_cleanse(m_secret.data(), m_secret.size());
+}
 
-    LogPrint (BCLog::ALL, "elapsed sha256_hash_hex %ld \n", t_shh);
-    LogPrint (BCLog::ALL, "\n");
+bool chunk_reassembler::open (int& error_level)
+{
+    {
+        LOCK(m_file_mutex);
+        m_file = fopen(m_filepath.c_str(), "wb");
+        if (!m_file) {
+            error_level = ERR_FILEOPEN;
+            return false;
+        }
+    }
 
-    LogPrint (BCLog::ALL, "elapsed get_chunknumber_from_chunk %ld \n", t_gcnfc);
-    LogPrint (BCLog::ALL, "\n");
+    for (int i = 0; i < m_threadcount; i++) {
+        m_threads.emplace_back([this, i] {
+            util::ThreadRename(strprintf("decode.%i", i));
+            verify_chunks();
+        });
+    }
+
+    return true;
+}
 
-    LogPrint (BCLog::ALL, "elapsed get_chunktotal_from_chunk %ld \n", t_gctfc);
-    LogPrint (BCLog::ALL, "\n");
+void chunk_reassembler::set_secret (Span<const unsigned char> secret)
+{
+    LOCK(m_file_mutex);
+    m_secret.assign(secret.begin(), secret.end());
+}
 
-    LogPrint (BCLog::ALL, "elapsed binlify_from_hex %ld \n", t_bfh);
-    LogPrint (BCLog::ALL, "\n");
-#endif
+bool chunk_reassembler::encrypted () const
+{
+    LOCK(m_file_mutex);
+    return m_flags & OPENCODING_FLAG_ENCRYPTED;
+}
+
+void chunk_reassembler::add_chunk (const CScript& script)
+{
+    {
+        // keep memory bounded, wait while the verifiers catch up
+        WAIT_LOCK(m_queue_mutex, lock);
+        m_queue_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_queue_mutex) { return m_stop || m_queue.size() < REASSEMBLY_QUEUE; });
+        if (m_stop) {
+            return;
+        }
+        m_queue.push_back(pending_chunk{script, ++m_seq});
+    }
+    m_queue_cond.notify_all();
+}
+
+void chunk_reassembler::set_error (int error_level, uint32_t chunknum)
+{
+    TRACE3(storage, chunk_error, m_filepath.c_str(), error_level, chunknum);
+
+    // keep the first error
+    if (m_error == NO_ERROR) {
+        m_error = error_level;
+    }
+}
+
+void chunk_reassembler::verify_chunks ()
+{
+    while (true) {
+
+        pending_chunk pending;
+        {
+            WAIT_LOCK(m_queue_mutex, lock);
+            m_queue_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_queue_mutex) { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            pending = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        m_queue_cond.notify_all();
+
+        // parse and check the hash outside of any lock, this is what runs in parallel
+        int error_level = NO_ERROR;
+        chunk_view view;
+        if (!parse_chunk_from_script (pending.script, view, error_level)) {
+            LOCK(m_file_mutex);
+            set_error(error_level);
+            continue;
+        }
+
+        // header chunk carries no data, only the protocol 02 header is of use here
+        if (view.chunklen == 0) {
+            if (view.version == OPENCODING_COMPACT) {
+                LOCK(m_file_mutex);
+                add_compact_header(view);
+            }
+            continue;
+        }
+
+        // protocol 02 chunks are only checked against the merkle root once all are in,
+        // their leaf hash is what runs in parallel
+        const bool compact = view.version == OPENCODING_COMPACT;
+        uint256 leaf;
+        bool validhash = true;
+        if (compact) {
+            leaf = Hash(view.data);
+        } else {
+            validhash = is_valid_chunkhash (view);
+        }
+
+        LOCK(m_file_mutex);
+
+        if (!validhash) {
+            set_error(ERR_CHUNKHASH, view.chunknum);
+            continue;
+        }
+
+        // ensure uuid and protocol are uniform
+        if (!check_uuid(view)) {
+            continue;
+        }
+
+        if (!compact) {
+            // ensure chunktotal is uniform
+            if (m_chunktotal == 0) {
+                m_chunktotal = view.chunktotal;
+            } else if (view.chunktotal != m_chunktotal) {
+                set_error(ERR_CHUNKTOTAL, view.chunknum);
+                continue;
+            }
+
+            if (view.chunknum < 1 || view.chunknum > m_chunktotal) {
+                set_error(ERR_CHUNKNUM, view.chunknum);
+                continue;
+            }
 
+            // ensure chunklen is uniform (besides last chunk)
+            if (view.chunknum != m_chunktotal && view.chunklen != OPENCODING_CHUNKMAX) {
+                set_error(ERR_CHUNKLEN, view.chunknum);
+                continue;
+            }
+        } else if (view.chunknum > REASSEMBLY_COMPACT_MAXCHUNKS || (m_header && view.chunknum > m_chunktotal)) {
+            // without the header yet, only bound how far into the file a chunk can be written
+            set_error(ERR_CHUNKNUM, view.chunknum);
+            continue;
+        }
+
+        // a chunk added later has already been written in its place
+        written_chunk& written = m_written[view.chunknum];
+        if (written.seq > pending.seq) {
+            continue;
+        }
+
+        // positional write, decrypted once the header gave the nonce
+        long offset = (long)(view.chunknum - 1) * get_chunkmax_for_version(view.version);
+        Span<const unsigned char> data = view.data;
+        std::vector<unsigned char> decrypted;
+        if (m_cipher) {
+            decrypted.assign(view.data.begin(), view.data.end());
+            m_cipher->crypt(offset, decrypted.data(), decrypted.size());
+            data = decrypted;
+        }
+        if (fseek(m_file, offset, SEEK_SET) != 0 || fwrite(data.data(), 1, data.size(), m_file) != data.size()) {
+            set_error(ERR_FILEWRITE, view.chunknum);
+            continue;
+        }
+
+        written.seq = pending.seq;
+        written.len = view.data.size();
+        written.leaf = leaf;
+        written.early = compact && !m_header;
+    }
+}
+
+bool chunk_reassembler::check_uuid (const chunk_view& view)
+{
+    if (m_uuid.empty()) {
+        m_uuid.assign(view.uuid.begin(), view.uuid.end());
+        m_version = view.version;
+    } else if (!std::equal(m_uuid.begin(), m_uuid.end(), view.uuid.begin(), view.uuid.end())) {
+        set_error(ERR_CHUNKUUID, view.chunknum);
+        return false;
+    } else if (view.version != m_version) {
+        set_error(ERR_CHUNKVERSION, view.chunknum);
+        return false;
+    }
+    return true;
+}
+
+void chunk_reassembler::add_compact_header (const chunk_view& view)
+{
+    // the first header added is the one the caller authenticated
+    if (m_header || !check_uuid(view)) {
+        return;
+    }
+    m_header = true;
+    m_chunktotal = view.chunktotal;
+    m_flags = view.flags;
+    m_filelen = view.filelen;
+    m_rawlen = view.rawlen;
+    m_merkleroot = uint256(view.merkleroot);
+    if (m_flags & OPENCODING_FLAG_CONTENTHASH) {
+        m_contenthash = uint256(view.contenthash);
+    }
+    if (m_flags & OPENCODING_FLAG_ENCRYPTED) {
+        if (!m_secret.empty()) {
+            m_cipher.emplace(m_secret, view.uuid);
+        }
+        if (!m_cipher || !m_cipher->set_nonce_from_header(view.encryption)) {
+            m_cipher.reset();
+            set_error(ERR_DECRYPT);
+        }
+    }
+}
+
+bool chunk_reassembler::check_compact_chunks ()
+{
+    if (!m_header) {
+        m_error = ERR_CHUNKAUTHNONE;
+        return false;
+    }
+
+    // every chunk up to chunktotal, each full length but the last, hashing up to the signed root
+    std::vector<uint256> leaves;
+    leaves.reserve(m_chunktotal);
+    uint64_t len = 0;
+    for (const auto& [chunknum, written] : m_written) {
+        if (chunknum != leaves.size() + 1 || chunknum > m_chunktotal) {
+            m_error = ERR_CHUNKNUM;
+            return false;
+        }
+        if (chunknum != m_chunktotal && written.len != OPENCODING_COMPACT_CHUNKMAX) {
+            m_error = ERR_CHUNKLEN;
+            return false;
+        }
+        leaves.push_back(written.leaf);
+        len += written.len;
+    }
+    if (leaves.size() != m_chunktotal) {
+        m_error = ERR_NOTALLDATACHUNKS;
+        return false;
+    }
+    if (len != m_filelen) {
+        m_error = ERR_CHUNKLEN;
+        return false;
+    }
+    if (ComputeMerkleRoot(std::move(leaves)) != m_merkleroot) {
+        m_error = ERR_CHUNKHASH;
+        return false;
+    }
+    return true;
+}
+
+bool chunk_reassembler::decrypt_early_chunks ()
+{
+    FILE* file = nullptr;
+    std::vector<unsigned char> data;
+    for (const auto& [chunknum, written] : m_written) {
+        if (!written.early) {
+            continue;
+        }
+        if (!file && !(file = fopen(m_filepath.c_str(), "r+b"))) {
+            m_error = ERR_FILEOPEN;
+            return false;
+        }
+        const long offset = (long)(chunknum - 1) * OPENCODING_COMPACT_CHUNKMAX;
+        data.resize(written.len);
+        if (fseek(file, offset, SEEK_SET) != 0 || fread(data.data(), 1, data.size(), file) != data.size()) {
+            m_error = ERR_FILEREAD;
+            break;
+        }
+        m_cipher->crypt(offset, data.data(), data.size());
+        if (fseek(file, offset, SEEK_SET) != 0 || fwrite(data.data(), 1, data.size(), file) != data.size()) {
+            m_error = ERR_FILEWRITE;
+            break;
+        }
+    }
+    if (file && fclose(file) != 0 && m_error == NO_ERROR) {
+        m_error = ERR_FILEWRITE;
+    }
+    return m_error == NO_ERROR;
+}
+
+bool chunk_reassembler::decompress_file ()
+{
+    // stream the chunks as written into a file next to it, then swap it in
+    const std::string rawpath = m_filepath + ".tmp";
+    FILE* in = fopen(m_filepath.c_str(), "rb");
+    FILE* out = fopen(rawpath.c_str(), "wb");
+    bool ok = in && out;
+    if (!ok) {
+        m_error = ERR_FILEOPEN;
+    } else if (!decompress_stream(in, out, m_rawlen)) {
+        m_error = ERR_CHUNKFAIL;
+        ok = false;
+    }
+    if (in) {
+        fclose(in);
+    }
+    if (out && fclose(out) != 0 && ok) {
+        m_error = ERR_FILEWRITE;
+        ok = false;
+    }
+
+    if (ok && std::rename(rawpath.c_str(), m_filepath.c_str()) != 0) {
+        m_error = ERR_FILEWRITE;
+        ok = false;
+    }
+    if (!ok) {
+        std::remove(rawpath.c_str());
+    }
+    return ok;
+}
+
+bool chunk_reassembler::check_contenthash ()
+{
+    // the file as the tenant stored it, once decompressed
+    uint256 contenthash;
+    if (!sha256_hash_file(m_filepath, contenthash.begin())) {
+        m_error = ERR_FILEREAD;
+        return false;
+    }
+    if (contenthash != m_contenthash) {
+        m_error = ERR_CHUNKHASH;
+        return false;
+    }
     return true;
 }
+
+void chunk_reassembler::stop ()
+{
+    {
+        LOCK(m_queue_mutex);
+        m_stop = true;
+    }
+    m_queue_cond.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+}
+
+bool chunk_reassembler::finish (int& error_level)
+{
+    // verifiers drain the queue before stopping
+    stop();
+
+    LOCK(m_file_mutex);
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+
+    if (m_error == NO_ERROR && m_version == OPENCODING_COMPACT && check_compact_chunks() && (!m_cipher || decrypt_early_chunks())) {
+        if ((m_flags & OPENCODING_FLAG_COMPRESSED) == 0 || decompress_file()) {
+            if (m_flags & OPENCODING_FLAG_CONTENTHASH) check_contenthash();
+        }
+    }
+
+    if (m_error != NO_ERROR) {
+        error_level = m_error;
+    } else if (m_chunktotal == 0 || m_written.size() != m_chunktotal) {
+        error_level = ERR_NOTALLDATACHUNKS;
+    } else {
+        LogPrint (BCLog::STORAGE, "(chunk_reassembler) %d data chunks written to %s\n", m_chunktotal, m_filepath);
+        return true;
+    }
+
+    std::remove(m_filepath.c_str());
+    return false;
+}
+
+void chunk_reassembler::discard ()
+{
+    int error_level;
+    if (finish(error_level)) {
+        std::remove(m_filepath.c_str());
+    }
+}
+
+void chunk_reassembler::get_written (int& chunks, uint64_t& bytes)
+{
+    LOCK(m_file_mutex);
+    chunks = m_written.size();
+    bytes = 0;
+    for (const auto& [chunknum, written] : m_written) {
+        bytes += written.len;
+    }
+}
@@ -1,15 +1,133 @@
 #ifndef DECODE_H
 #define DECODE_H
 
+#include <script/script.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <opfile/src/chunk.h>
+#include <opfile/src/encrypt.h>
+#include <opfile/src/protocol.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
+struct signed_hash;
+
+//! threads verifying chunk checksums during reassembly
+const int REASSEMBLY_THREADS = 4;
+//! chunks waiting for verification before add_chunk blocks
+const size_t REASSEMBLY_QUEUE = 256;
+//! highest protocol 02 chunknum written before the header chunk gives the chunktotal (1 GiB into the file)
+const uint32_t REASSEMBLY_COMPACT_MAXCHUNKS = (1 << 30) / OPENCODING_COMPACT_CHUNKMAX;
+
 // bool check_chunk_contextual(std::string chunk, int& protocol, int& error_level);
 bool check_chunk_contextual (std::string chunk, int& protocol, int& error_level, int offset);
 //bool is_valid_authchunk(std::string& chunk, int& error_level);
 bool extract_pubkey_from_signature (std::string& chunk, int offset);
+bool recover_tenant_from_header (std::string& chunk, int offset, uint160& tenant);
 bool is_valid_authchunk(std::string& chunk, int& error_level, int offset);
 //bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& error_level, int& total_chunks, std::vector<std::string>& encoded_chunks);
-bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& error_level, int& total_chunks, std::vector<std::string>& encoded_chunks, int offset);
+//bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& error_level, int& total_chunks, std::vector<std::string>& encoded_chunks, int offset);
+bool build_file_from_chunks(std::pair<std::string, std::string> get_info, int& error_level, int& total_chunks, std::vector<CScript>& encoded_chunks);
+//! what a header chunk signs and its signature, to recover the tenant from once the chunk is gone
+void get_header_signed_hash (const chunk_view& view, signed_hash& header);
+bool recover_tenant_from_header (const chunk_view& view, uint160& tenant);
+bool is_valid_authchunk (const chunk_view& view, int& error_level, uint160& tenant);
+bool is_valid_chunkhash (const chunk_view& view);
+
+//! reassembles a file from its data chunks in any order, writing each chunk at its
+//! file offset ((chunknum-1)*chunkmax) as soon as its checksum has been verified.
+//! protocol 02 chunks carry no checksum, they are checked against the merkle root
+//! of the header chunk once all are written, and decompressed in place if the header says so.
+//! encrypted ones are decrypted as they are written, once the header gave the nonce
+class chunk_reassembler
+{
+public:
+    explicit chunk_reassembler (const std::string& filepath, int threads = REASSEMBLY_THREADS);
+    ~chunk_reassembler ();
+
+    bool open (int& error_level);
+
+    //! secret a protocol 02 file stored encrypted is decrypted with, see encrypt.h. set before
+    //! adding chunks; without it, or with another one, an encrypted file fails with ERR_DECRYPT
+    void set_secret (Span<const unsigned char> secret);
+
+    //! whether the header added says the file was stored encrypted
+    bool encrypted () const;
+
+    //! queue a data chunk for verification and writing. header chunks are ignored, but
+    //! for protocol 02, where the first one added is taken as authenticated.
+    //! a chunk added later replaces an earlier one with the same chunknum
+    void add_chunk (const CScript& script);
+
+    //! wait for queued chunks, then check every chunk was written. removes the file on failure
+    bool finish (int& error_level);
+
+    //! stop and remove the partial file
+    void discard ();
+
+    //! data chunks written and their bytes, as stored on chain
+    void get_written (int& chunks, uint64_t& bytes);
+
+private:
+    struct pending_chunk {
+        CScript script;
+        uint32_t seq;
+    };
+
+    struct written_chunk {
+        uint32_t seq{0};
+        uint32_t len{0};
+        uint256 leaf;   //! protocol 02 merkle leaf
+        bool early{false};  //! protocol 02 chunk written before the header, as stored
+    };
+
+    void verify_chunks ();
+    void set_error (int error_level, uint32_t chunknum = 0) EXCLUSIVE_LOCKS_REQUIRED(m_file_mutex);
+    bool check_uuid (const chunk_view& view) EXCLUSIVE_LOCKS_REQUIRED(m_file_mutex);
+    void add_compact_header (const chunk_view& view) EXCLUSIVE_LOCKS_REQUIRED(m_file_mutex);
+    bool check_compact_chunks () EXCLUSIVE_LOCKS_REQUIRED(m_file_mutex);
+    bool decrypt_early_chunks () EXCLUSIVE_LOCKS_REQUIRED(m_file_mutex);
+    bool decompress_file () EXCLUSIVE_LOCKS_REQUIRED(m_file_mutex);
+    bool check_contenthash () EXCLUSIVE_LOCKS_REQUIRED(m_file_mutex);
+    void stop ();
+
+    const std::string m_filepath;
+    const int m_threadcount;
+    std::vector<std::thread> m_threads;
+
+    Mutex m_queue_mutex;
+    std::condition_variable m_queue_cond;
+    std::deque<pending_chunk> m_queue GUARDED_BY(m_queue_mutex);
+    uint32_t m_seq GUARDED_BY(m_queue_mutex){0};
+    bool m_stop GUARDED_BY(m_queue_mutex){false};
+
+    mutable Mutex m_file_mutex;
+    FILE* m_file GUARDED_BY(m_file_mutex){nullptr};
+    std::vector<unsigned char> m_uuid GUARDED_BY(m_file_mutex);
+    uint8_t m_version GUARDED_BY(m_file_mutex){0};
+    uint32_t m_chunktotal GUARDED_BY(m_file_mutex){0};
+    //! chunks written so far by chunknum, with the sequence number of the chunk written
+    std::map<uint32_t, written_chunk> m_written GUARDED_BY(m_file_mutex);
+    int m_error GUARDED_BY(m_file_mutex);
+
+    // protocol 02 header chunk
+    bool m_header GUARDED_BY(m_file_mutex){false};
+    uint64_t m_flags GUARDED_BY(m_file_mutex){0};
+    uint64_t m_filelen GUARDED_BY(m_file_mutex){0};
+    uint64_t m_rawlen GUARDED_BY(m_file_mutex){0};
+    uint256 m_merkleroot GUARDED_BY(m_file_mutex);
+    uint256 m_contenthash GUARDED_BY(m_file_mutex);
+    std::vector<unsigned char> m_secret GUARDED_BY(m_file_mutex);
+    //! set by an encrypted header, when the secret is the one it was encrypted with
+    std::optional<asset_cipher> m_cipher GUARDED_BY(m_file_mutex);
+};
 
 #endif // DECODE_H
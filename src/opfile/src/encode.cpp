@@ -1,13 +1,20 @@
+#include <algorithm>
 #include <iomanip>
+#include <optional>
 
+#include <consensus/merkle.h>
+#include <crypto/sha256.h>
+#include <hash.h>
 #include <logging.h>
+#include <script/standard.h>
 
+#include "compress.h"
+#include "encode.h"
+#include "encrypt.h"
 #include "protocol.h"
 #include "util.h"
 
-#include <key_io.h>
-
-extern std::string authUserKey;
+#include <key.h>
 
 bool file_to_hexchunks(std::string filepath, int& protocol, int& error_level, int& total_chunks, std::vector<std::string>& data_chunks) {
 
@@ -81,7 +88,7 @@ bool file_to_hexchunks(std::string filepath, int& protocol, int& error_level, in
 }
 
 //bool build_chunks_auth_header(std::string header, std::vector<std::string>& encoded_chunks) {
-bool build_chunks_auth_header(std::string header, std::vector<std::string>& encoded_chunks, int& error_level) {
+bool build_chunks_auth_header(std::string header, const CKey& key, std::vector<std::string>& encoded_chunks, int& error_level) {
 
     // we use chunknum 0 to store the authdata, signified by chunklen 0
     std::string authheader = header;
@@ -92,7 +99,6 @@ bool build_chunks_auth_header(std::string header, std::vector<std::string>& enco
     sha256_hash_hex(authheader.c_str(), checkhash, authheader.size());
     checkhash[OPENCODING_CHECKSUM*4] = 0;
 
-    CKey key = DecodeSecret(authUserKey);
     if (!key.IsValid()) {
         error_level = ERR_NOAUTHENTICATION;
         return false;
@@ -107,9 +113,9 @@ bool build_chunks_auth_header(std::string header, std::vector<std::string>& enco
 
     authheader += HexStr(signature);
 
-    LogPrint (BCLog::ALL, "HEADER CHUNK\n");
-    LogPrint (BCLog::ALL, "magic protocol uuid chunk_length magic-protocol-uuid-chunk_length-hashed-signed\n");
-    LogPrint (BCLog::ALL, "%s %s %s %s %s\n",
+    LogPrint (BCLog::STORAGE, "HEADER CHUNK\n");
+    LogPrint (BCLog::STORAGE, "magic protocol uuid chunk_length magic-protocol-uuid-chunk_length-hashed-signed\n");
+    LogPrint (BCLog::STORAGE, "%s %s %s %s %s\n",
       authheader.substr( 0, OPENCODING_MAGICLEN*2),
       authheader.substr( OPENCODING_MAGICLEN*2, OPENCODING_VERSIONLEN*2),
       authheader.substr(OPENCODING_MAGICLEN*2+OPENCODING_VERSIONLEN*2, OPENCODING_UUID*2),
@@ -121,7 +127,7 @@ bool build_chunks_auth_header(std::string header, std::vector<std::string>& enco
     return true;
 }
 
-bool build_chunks_with_headers(std::pair<std::string, std::string>& putinfo, int& error_level, int& total_chunks, std::vector<std::string>& encoded_chunks) {
+bool build_chunks_with_headers(std::pair<std::string, std::string>& putinfo, const CKey& key, int& error_level, int& total_chunks, std::vector<std::string>& encoded_chunks) {
 
     int protocol;
     bool validcustom;
@@ -146,7 +152,7 @@ bool build_chunks_with_headers(std::pair<std::string, std::string>& putinfo, int
     header += validcustom ? customuuid : generate_uuid(OPENCODING_UUID);
 
     //if (!build_chunks_auth_header(header, encoded_chunks)) {
-    if (!build_chunks_auth_header(header, encoded_chunks, error_level)) {
+    if (!build_chunks_auth_header(header, key, encoded_chunks, error_level)) {
         return false;
     }
 
@@ -156,7 +162,7 @@ bool build_chunks_with_headers(std::pair<std::string, std::string>& putinfo, int
         int chunklen = data_chunk.size() / 2;
         header2 = get_len_as_hex(chunklen, OPENCODING_CHUNKLEN);
 
-        char checkhash[OPENCODING_CHECKSUM*4];
+        char checkhash[OPENCODING_CHECKSUM*4+1];
         memset(checkhash, 0, sizeof(checkhash));
         sha256_hash_hex(data_chunk.c_str(), checkhash, data_chunk.size());
 
@@ -168,25 +174,25 @@ bool build_chunks_with_headers(std::pair<std::string, std::string>& putinfo, int
 
         header2 += get_len_as_hex(total_chunks, OPENCODING_CHUNKTOTAL);
 
-        LogPrint (BCLog::ALL, "\n");
-        LogPrint (BCLog::ALL, "DATA CHUNK %d\n", chunknum);
-        LogPrint (BCLog::ALL, "magic protocol uuid\n");
-        LogPrint (BCLog::ALL, "%s %s %s\n",
+        LogPrint (BCLog::STORAGE, "\n");
+        LogPrint (BCLog::STORAGE, "DATA CHUNK %d\n", chunknum);
+        LogPrint (BCLog::STORAGE, "magic protocol uuid\n");
+        LogPrint (BCLog::STORAGE, "%s %s %s\n",
           header.substr( 0, OPENCODING_MAGICLEN*2),
           header.substr( OPENCODING_MAGICLEN*2, OPENCODING_VERSIONLEN*2),
           header.substr( OPENCODING_MAGICLEN*2+OPENCODING_VERSIONLEN*2, OPENCODING_UUID*2));
 
-        LogPrint (BCLog::ALL, "\n");
-        LogPrint (BCLog::ALL, "length data_hash chunk_number total_chunks\n");
-        LogPrint (BCLog::ALL, "%s %s %s %s\n",
+        LogPrint (BCLog::STORAGE, "\n");
+        LogPrint (BCLog::STORAGE, "length data_hash chunk_number total_chunks\n");
+        LogPrint (BCLog::STORAGE, "%s %s %s %s\n",
           header2.substr( 0, OPENCODING_CHUNKLEN*2),
           header2.substr( OPENCODING_CHUNKLEN*2, OPENCODING_CHECKSUM*2),
           header2.substr( OPENCODING_CHUNKLEN*2+OPENCODING_CHECKSUM*2, OPENCODING_CHUNKNUM*2),
           header2.substr( OPENCODING_CHUNKLEN*2+OPENCODING_CHECKSUM*2+OPENCODING_CHUNKNUM*2, OPENCODING_CHUNKTOTAL*2));
 
-        LogPrint (BCLog::ALL, "\n");
-        LogPrint (BCLog::ALL, "data\n");
-        LogPrint (BCLog::ALL, "%s\n", data_chunk);
+        LogPrint (BCLog::STORAGE, "\n");
+        LogPrint (BCLog::STORAGE, "data\n");
+        LogPrint (BCLog::STORAGE, "%s\n", data_chunk);
 
         encoded_chunk = header + header2 + data_chunk;
         encoded_chunks.push_back(encoded_chunk);
@@ -203,3 +209,382 @@ bool build_chunks_with_headers(std::pair<std::string, std::string>& putinfo, int
     return true;
 }
 
+
+// append value as a big endian field of len bytes, the binary form of get_len_as_hex
+static void append_len_as_bin(std::vector<unsigned char>& chunk, uint32_t value, int len) {
+
+    for (int i = len - 1; i >= 0; i--) {
+        chunk.push_back((value >> (8 * i)) & 0xff);
+    }
+}
+
+// append value as a compactsize varint, as read back by parse_chunk_from_script
+static void append_varint_as_bin(std::vector<unsigned char>& chunk, uint64_t value) {
+
+    if (value < 253) {
+        chunk.push_back(value);
+        return;
+    }
+    int len = value <= 0xffff ? 2 : value <= 0xffffffff ? 4 : 8;
+    chunk.push_back(len == 2 ? 253 : len == 4 ? 254 : 255);
+    for (int i = 0; i < len; i++) {
+        chunk.push_back((value >> (8 * i)) & 0xff);
+    }
+}
+
+// sign hash with the authenticated key, appending the compact signature. signed_header, if
+// not empty, is the header signed before, put again as is if it is the one this file gives
+static bool append_header_signature(std::vector<unsigned char>& authheader, const uint256& authhash, const CKey& key, std::vector<unsigned char>& signed_header, int& error_level) {
+
+    if (!signed_header.empty()) {
+        if (signed_header.size() != authheader.size() + CPubKey::COMPACT_SIGNATURE_SIZE ||
+            !std::equal(authheader.begin(), authheader.end(), signed_header.begin())) {
+            error_level = ERR_CHUNKHASH;
+            return false;
+        }
+        authheader = signed_header;
+        return true;
+    }
+
+    if (!key.IsValid()) {
+        error_level = ERR_NOAUTHENTICATION;
+        return false;
+    }
+
+    std::vector<unsigned char> signature;
+    if (!key.SignCompact(authhash, signature)) {
+        //error_level = ERR_BADSIG;
+        return false;
+    }
+
+    authheader.insert(authheader.end(), signature.begin(), signature.end());
+    signed_header = authheader;
+
+    return true;
+}
+
+static bool build_binary_auth_header(const std::vector<unsigned char>& header, const CKey& key, std::vector<unsigned char>& authheader, std::vector<unsigned char>& signed_header, int& error_level) {
+
+    // we use chunknum 0 to store the authdata, signified by chunklen 0
+    authheader = header;
+    append_len_as_bin(authheader, 0, OPENCODING_CHUNKLEN);
+
+    // signed hash is sha256 of the hex notation of the header, read as a uint256 hex string
+    std::string hexheader = HexStr(authheader);
+    unsigned char digest[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write((const unsigned char*)hexheader.data(), hexheader.size()).Finalize(digest);
+    uint256 authhash;
+    std::reverse_copy(std::begin(digest), std::end(digest), authhash.begin());
+
+    if (!append_header_signature(authheader, authhash, key, signed_header, error_level)) {
+        return false;
+    }
+
+    LogPrint (BCLog::STORAGE, "HEADER CHUNK\n");
+    LogPrint (BCLog::STORAGE, "magic-protocol-uuid-chunk_length-hashed-signed\n");
+    LogPrint (BCLog::STORAGE, "%s\n", HexStr(authheader));
+
+    return true;
+}
+
+static_assert(OPENCODING_SCRIPTMAX == MAX_OP_RETURN_RELAY, "protocol 02 chunks fill a standard OP_RETURN");
+
+// protocol 02, see protocol.h
+static bool stream_compact_chunks(std::string filepath, const std::vector<unsigned char>& prefix, const CKey& key, int& error_level, int& total_chunks, const chunk_batch_handler& handler, bool compress, bool content_hash, Span<const unsigned char> encrypt_secret, std::vector<unsigned char>& signed_header) {
+
+    std::string extension;
+    extract_file_extension(filepath, extension);
+    extension.erase(std::find(extension.begin(), extension.end(), '\0'), extension.end());
+
+    int filelen = read_file_size(filepath);
+    if (filelen < 0) {
+        error_level = ERR_FILESZ;
+        return false;
+    }
+
+    FILE* in = fopen(filepath.c_str(), "rb");
+    if (!in) {
+        error_level = ERR_FILEOPEN;
+        return false;
+    }
+
+    // the header may name the file as stored by the tenant, to find earlier uploads of it.
+    // Nodes from before the flag reject such headers, so it is only set when asked for
+    uint256 contenthash;
+    if ((content_hash || !encrypt_secret.empty()) && (!sha256_hash_stream(in, contenthash.begin()) || fseek(in, 0, SEEK_SET) != 0)) {
+        error_level = ERR_FILEREAD;
+        fclose(in);
+        return false;
+    }
+
+    // an encrypted file is not named by its hash, which only gives the nonce
+    uint64_t flags = content_hash ? OPENCODING_FLAG_CONTENTHASH : 0;
+    std::optional<asset_cipher> cipher;
+    if (!encrypt_secret.empty()) {
+        cipher.emplace(encrypt_secret, Span{prefix}.last(OPENCODING_UUID));
+        cipher->set_nonce_for_file(contenthash.begin());
+        flags = OPENCODING_FLAG_ENCRYPTED;
+    }
+
+    // compress into a temporary file, which is stored instead only if it came out smaller
+    const uint64_t rawlen = filelen;
+    if (compress && filelen > 0) {
+        FILE* packed = std::tmpfile();
+        uint64_t packedlen = 0;
+        if (packed && compress_stream(in, packed, packedlen) && packedlen < rawlen && fseek(packed, 0, SEEK_SET) == 0) {
+            fclose(in);
+            in = packed;
+            filelen = packedlen;
+            flags |= OPENCODING_FLAG_COMPRESSED;
+        } else {
+            if (packed) {
+                fclose(packed);
+            }
+            if (fseek(in, 0, SEEK_SET) != 0) {
+                error_level = ERR_FILEREAD;
+                fclose(in);
+                return false;
+            }
+        }
+        LogPrint (BCLog::STORAGE, "compressed %d bytes to %d, %s\n", rawlen, packedlen, (flags & OPENCODING_FLAG_COMPRESSED) ? "storing compressed" : "storing as is");
+    }
+    total_chunks = (filelen + (OPENCODING_COMPACT_CHUNKMAX - 1)) / OPENCODING_COMPACT_CHUNKMAX;
+
+    unsigned char window[OPENCODING_COMPACT_CHUNKMAX];
+    auto read_chunk = [&](int chunknum) {
+        int chunklen = std::min(OPENCODING_COMPACT_CHUNKMAX, filelen - (chunknum - 1) * OPENCODING_COMPACT_CHUNKMAX);
+        if (fread(window, 1, chunklen, in) != (size_t)chunklen) {
+            error_level = ERR_FILEREAD;
+            return 0;
+        }
+        // encrypted in the window, as each chunk is read
+        if (cipher) {
+            cipher->crypt(uint64_t(chunknum - 1) * OPENCODING_COMPACT_CHUNKMAX, window, chunklen);
+        }
+        return chunklen;
+    };
+
+    // the header signs the merkle root, so the file is read twice, once to hash it
+    std::vector<uint256> leaves;
+    leaves.reserve(total_chunks);
+    for (int chunknum = 1; chunknum <= total_chunks; chunknum++) {
+        int chunklen = read_chunk(chunknum);
+        if (chunklen == 0) {
+            fclose(in);
+            return false;
+        }
+        leaves.push_back(Hash(Span<const unsigned char>(window, chunklen)));
+    }
+    const uint256 merkleroot = ComputeMerkleRoot(std::move(leaves));
+
+    std::vector<unsigned char> authheader = prefix;
+    append_varint_as_bin(authheader, 0);
+    append_varint_as_bin(authheader, flags);
+    append_varint_as_bin(authheader, filelen);
+    if (flags & OPENCODING_FLAG_COMPRESSED) {
+        append_varint_as_bin(authheader, rawlen);
+    }
+    authheader.insert(authheader.end(), merkleroot.begin(), merkleroot.end());
+    if (flags & OPENCODING_FLAG_CONTENTHASH) {
+        authheader.insert(authheader.end(), contenthash.begin(), contenthash.end());
+    }
+    if (cipher) {
+        unsigned char encryption[OPENCODING_ENCRYPTION];
+        cipher->get_header_field(encryption);
+        authheader.insert(authheader.end(), encryption, encryption + OPENCODING_ENCRYPTION);
+    }
+    append_varint_as_bin(authheader, extension.size());
+    authheader.insert(authheader.end(), extension.begin(), extension.end());
+    if (!append_header_signature(authheader, Hash(authheader), key, signed_header, error_level)) {
+        fclose(in);
+        return false;
+    }
+
+    LogPrint (BCLog::STORAGE, "HEADER CHUNK\n");
+    LogPrint (BCLog::STORAGE, "magic-protocol-uuid-0-flags-filelength-[rawlength]-merkleroot-[contenthash]-[encryption]-extension-signed\n");
+    LogPrint (BCLog::STORAGE, "%s\n", HexStr(authheader));
+
+    std::vector<std::vector<unsigned char>> batch;
+    batch.reserve(OPRETURN_PER_TX);
+    batch.push_back(std::move(authheader));
+
+    if (fseek(in, 0, SEEK_SET) != 0) {
+        error_level = ERR_FILEREAD;
+        fclose(in);
+        return false;
+    }
+
+    for (int chunknum = 1; chunknum <= total_chunks; chunknum++) {
+
+        int chunklen = read_chunk(chunknum);
+        if (chunklen == 0) {
+            fclose(in);
+            return false;
+        }
+
+        std::vector<unsigned char> chunk;
+        chunk.reserve(prefix.size() + 5 + chunklen);
+        chunk.insert(chunk.end(), prefix.begin(), prefix.end());
+        append_varint_as_bin(chunk, chunknum);
+        chunk.insert(chunk.end(), window, window + chunklen);
+
+        LogPrint (BCLog::STORAGE, "DATA CHUNK %d of %d, length %d\n", chunknum, total_chunks, chunklen);
+
+        batch.push_back(std::move(chunk));
+
+        // hand over each full batch, so only one transaction worth of chunks is held
+        if (batch.size() == OPRETURN_PER_TX) {
+            if (!handler(batch)) {
+                fclose(in);
+                return false;
+            }
+            batch.clear();
+        }
+    }
+
+    fclose(in);
+
+    if (batch.size() > 0 && !handler(batch)) {
+        return false;
+    }
+
+    return true;
+}
+
+bool stream_chunks_with_headers(std::pair<std::string, std::string>& putinfo, const CKey& key, int& error_level, int& total_chunks, const chunk_batch_handler& handler, bool compact, bool compress, bool content_hash, Span<const unsigned char> encrypt_secret, std::vector<unsigned char>& signed_header) {
+
+    std::string filepath = putinfo.first;
+    std::string customuuid = putinfo.second;
+    bool validcustom = customuuid.size() == OPENCODING_UUID*2;
+
+    if (compact) {
+        std::vector<unsigned char> prefix = ParseHex(OPENCODING_MAGIC + OPENCODING_VERSION[OPENCODING_COMPACT] + (validcustom ? customuuid : generate_uuid(OPENCODING_UUID)));
+        return stream_compact_chunks(filepath, prefix, key, error_level, total_chunks, handler, compress, content_hash, encrypt_secret, signed_header);
+    }
+
+    //! start off using protocol 00, unless we detect an extension
+    int protocol = 0;
+    std::string extension;
+    if (extract_file_extension(filepath, extension)) {
+        protocol = 1;
+    }
+
+    int filelen = read_file_size(filepath);
+    if (filelen < 0) {
+        error_level = ERR_FILESZ;
+        return false;
+    }
+
+    // protocol 01 appends 4 byte extension to filestream
+    int filelenext = filelen + (protocol == 1 ? OPENCODING_EXTENSION : 0);
+    total_chunks = (filelenext + (OPENCODING_CHUNKMAX - 1)) / OPENCODING_CHUNKMAX;
+
+    FILE* in = fopen(filepath.c_str(), "rb");
+    if (!in) {
+        error_level = ERR_FILEOPEN;
+        return false;
+    }
+
+    // magic, protocol and uuid lead every chunk
+    std::vector<unsigned char> header = ParseHex(OPENCODING_MAGIC + OPENCODING_VERSION[protocol] + (validcustom ? customuuid : generate_uuid(OPENCODING_UUID)));
+
+    std::vector<std::vector<unsigned char>> batch;
+    batch.reserve(OPRETURN_PER_TX);
+
+    std::vector<unsigned char> authheader;
+    if (!build_binary_auth_header(header, key, authheader, signed_header, error_level)) {
+        fclose(in);
+        return false;
+    }
+    batch.push_back(std::move(authheader));
+
+    unsigned char window[OPENCODING_CHUNKMAX];
+    for (int chunknum = 1; chunknum <= total_chunks; chunknum++) {
+
+        int offset = (chunknum - 1) * OPENCODING_CHUNKMAX;
+        int chunklen = std::min(OPENCODING_CHUNKMAX, filelenext - offset);
+        int filebytes = std::clamp(filelen - offset, 0, chunklen);
+
+        if (filebytes > 0 && fread(window, 1, filebytes, in) != (size_t)filebytes) {
+            error_level = ERR_FILEREAD;
+            fclose(in);
+            return false;
+        }
+        for (int i = filebytes; i < chunklen; i++) {
+            window[i] = extension[offset + i - filelen];
+        }
+
+        // checksum is the leading bytes of sha256 of the hex notation of the data
+        std::string hexdata = HexStr(Span<const unsigned char>(window, chunklen));
+        unsigned char digest[CSHA256::OUTPUT_SIZE];
+        CSHA256().Write((const unsigned char*)hexdata.data(), hexdata.size()).Finalize(digest);
+
+        std::vector<unsigned char> chunk;
+        chunk.reserve(header.size() + OPENCODING_CHUNKLEN + OPENCODING_CHECKSUM + OPENCODING_CHUNKNUM + OPENCODING_CHUNKTOTAL + chunklen);
+        chunk.insert(chunk.end(), header.begin(), header.end());
+        append_len_as_bin(chunk, chunklen, OPENCODING_CHUNKLEN);
+        chunk.insert(chunk.end(), digest, digest + OPENCODING_CHECKSUM);
+        append_len_as_bin(chunk, chunknum, OPENCODING_CHUNKNUM);
+        append_len_as_bin(chunk, total_chunks, OPENCODING_CHUNKTOTAL);
+        chunk.insert(chunk.end(), window, window + chunklen);
+
+        LogPrint (BCLog::STORAGE, "DATA CHUNK %d of %d, length %d checksum %s\n", chunknum, total_chunks, chunklen, HexStr(Span<const unsigned char>(digest, OPENCODING_CHECKSUM)));
+
+        batch.push_back(std::move(chunk));
+
+        // hand over each full batch, so only one transaction worth of chunks is held
+        if (batch.size() == OPRETURN_PER_TX) {
+            if (!handler(batch)) {
+                fclose(in);
+                return false;
+            }
+            batch.clear();
+        }
+    }
+
+    fclose(in);
+
+    // when the number of chunks is evenly divisible by the nummber of chunks
+    // per transaction, this final batch is empty
+    if (batch.size() > 0 && !handler(batch)) {
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<std::vector<chunk_run>> plan_chunk_batches(const std::vector<size_t>& chunk_counts, size_t per_tx) {
+
+    std::vector<std::vector<chunk_run>> batches;
+    std::vector<size_t> room;
+
+    // whole transactions of the large assets, and what is left of each asset to pack
+    std::vector<chunk_run> rest;
+    for (size_t asset = 0; asset < chunk_counts.size(); asset++) {
+        size_t first = 0;
+        for (; chunk_counts[asset] - first >= per_tx; first += per_tx) {
+            batches.push_back({{asset, first, per_tx}});
+            room.push_back(0);
+        }
+        if (first < chunk_counts[asset]) {
+            rest.push_back({asset, first, chunk_counts[asset] - first});
+        }
+    }
+
+    // first fit decreasing, ties in the order the assets were given
+    std::stable_sort(rest.begin(), rest.end(), [](const chunk_run& a, const chunk_run& b) { return a.count > b.count; });
+    for (const chunk_run& run : rest) {
+        size_t batch = 0;
+        while (batch < batches.size() && room[batch] < run.count) {
+            batch++;
+        }
+        if (batch == batches.size()) {
+            batches.emplace_back();
+            room.push_back(per_tx);
+        }
+        batches[batch].push_back(run);
+        room[batch] -= run.count;
+    }
+
+    return batches;
+}
@@ -1,9 +1,41 @@
 #ifndef ENCODE_H
 #define ENCODE_H
 
+#include <span.h>
+
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <vector>
 
-bool build_chunks_with_headers(std::pair<std::string, std::string>& putinfo, int& error_level, int& total_chunks, std::vector<std::string>& encoded_chunks);
+class CKey;
+
+//! receives each batch of up to OPRETURN_PER_TX binary chunk payloads, return false to stop encoding
+using chunk_batch_handler = std::function<bool(std::vector<std::vector<unsigned char>>& batch)>;
+
+bool build_chunks_with_headers(std::pair<std::string, std::string>& putinfo, const CKey& key, int& error_level, int& total_chunks, std::vector<std::string>& encoded_chunks);
+
+//! encode a file one chunk window at a time, handing each batch of chunks on as soon as it is full.
+//! compact selects protocol 02, otherwise 00 or 01 depending on the file extension.
+//! compress lets protocol 02 store the file compressed, when that makes it smaller.
+//! content_hash has protocol 02 carry the sha256 of the file in its header, for reuse to find it.
+//! encrypt_secret, unless empty, has protocol 02 store the file encrypted with it, see encrypt.h.
+//! key signs the header chunk, as the tenant putting the file.
+//! signed_header, if not empty, is the header chunk signed for the file before, which is put
+//! without signing again. Otherwise it is set to the header chunk signed
+bool stream_chunks_with_headers(std::pair<std::string, std::string>& putinfo, const CKey& key, int& error_level, int& total_chunks, const chunk_batch_handler& handler, bool compact, bool compress, bool content_hash, Span<const unsigned char> encrypt_secret, std::vector<unsigned char>& signed_header);
+
+//! consecutive chunks of one asset, from its header chunk at 0, laid out in a putfile transaction
+struct chunk_run {
+    size_t asset;
+    size_t first;
+    size_t count;
+};
+
+//! lay out the chunks of several assets, header chunks included, in transactions of up to per_tx chunks.
+//! an asset that fits in one transaction is not split across two. larger ones fill whole transactions,
+//! and what is left of them is packed like a small asset. assets are packed largest first, each into
+//! the first transaction with room for it. returns the runs of chunks of each transaction
+std::vector<std::vector<chunk_run>> plan_chunk_batches(const std::vector<size_t>& chunk_counts, size_t per_tx);
 
 #endif // ENCODE_H
@@ -0,0 +1,55 @@
+#include "encrypt.h"
+
+#include <crypto/common.h>
+#include <crypto/hmac_sha256.h>
+#include <support/cleanse.h>
+
+#include <algorithm>
+#include <cstring>
+
+asset_cipher::asset_cipher (Span<const unsigned char> secret, Span<const unsigned char> uuid) {
+    CHMAC_SHA256(secret.data(), secret.size()).Write(uuid.data(), uuid.size()).Finalize(m_key);
+    m_chacha.SetKey32(m_key);
+    memset(m_iv, 0, sizeof(m_iv));
+}
+
+asset_cipher::~asset_cipher () {
+    memory_cleanse(m_key, sizeof(m_key));
+}
+
+void asset_cipher::set_nonce_for_file (const unsigned char* contenthash) {
+    unsigned char mac[CHMAC_SHA256::OUTPUT_SIZE];
+    CHMAC_SHA256(m_key, sizeof(m_key)).Write(contenthash, 32).Finalize(mac);
+    memcpy(m_iv, mac, ENCRYPT_IVLEN);
+    m_chacha.SetIV(ReadLE64(m_iv));
+}
+
+bool asset_cipher::set_nonce_from_header (Span<const unsigned char> encryption) {
+    if (encryption.size() != ENCRYPT_IVLEN + ENCRYPT_KEYCHECKLEN) {
+        return false;
+    }
+    memcpy(m_iv, encryption.data(), ENCRYPT_IVLEN);
+    m_chacha.SetIV(ReadLE64(m_iv));
+    unsigned char keycheck[ENCRYPT_KEYCHECKLEN];
+    get_keycheck(keycheck);
+    return std::equal(keycheck, keycheck + ENCRYPT_KEYCHECKLEN, encryption.begin() + ENCRYPT_IVLEN);
+}
+
+void asset_cipher::get_keycheck (unsigned char* keycheck) const {
+    unsigned char mac[CHMAC_SHA256::OUTPUT_SIZE];
+    CHMAC_SHA256(m_key, sizeof(m_key)).Write(m_iv, sizeof(m_iv)).Finalize(mac);
+    memcpy(keycheck, mac, ENCRYPT_KEYCHECKLEN);
+}
+
+void asset_cipher::get_header_field (unsigned char* encryption) const {
+    memcpy(encryption, m_iv, ENCRYPT_IVLEN);
+    get_keycheck(encryption + ENCRYPT_IVLEN);
+}
+
+void asset_cipher::crypt (uint64_t offset, unsigned char* data, size_t len) {
+    // the keystream is seeked a 64 byte block at a time, the rest of the offset is skipped
+    unsigned char skip[64];
+    m_chacha.Seek64(offset / 64);
+    m_chacha.Keystream(skip, offset % 64);
+    m_chacha.Crypt(data, data, len);
+}
@@ -0,0 +1,53 @@
+#ifndef ENCRYPT_H
+#define ENCRYPT_H
+
+#include <crypto/chacha20.h>
+#include <span.h>
+
+#include <cstdint>
+
+//! bytes of the secret a tenant encrypts with, the key it authenticates with
+const size_t ENCRYPT_SECRETLEN = 32;
+//! bytes of the nonce and of the key check, carried by a header with OPENCODING_FLAG_ENCRYPTED
+const size_t ENCRYPT_IVLEN = 8;
+const size_t ENCRYPT_KEYCHECKLEN = 8;
+
+//! encryption of a stored file
+//!
+//! the bytes the chunks carry (compressed first, if at all) are xored with the ChaCha20 keystream
+//! of a key of the asset, hmac-sha256(secret, uuid), and a nonce, the first ENCRYPT_IVLEN bytes of
+//! hmac-sha256(key, sha256 of the file). as the keystream is seekable, every chunk is encrypted and
+//! decrypted by itself at its offset in the file, as it is encoded or written in its place.
+//!
+//! the header signs the merkle root of the chunks as encrypted, which authenticates them. it
+//! carries the nonce and a key check, the first ENCRYPT_KEYCHECKLEN bytes of hmac-sha256(key, nonce),
+//! so that a wrong secret is told apart from damaged chunks. its contenthash is left out, as it
+//! would tell which file is stored
+class asset_cipher
+{
+public:
+    //! key of the asset with uuid, for a secret of ENCRYPT_SECRETLEN bytes
+    asset_cipher (Span<const unsigned char> secret, Span<const unsigned char> uuid);
+    ~asset_cipher ();
+
+    //! derive the nonce from the sha256 of the file, as the encoder does
+    void set_nonce_for_file (const unsigned char* contenthash);
+
+    //! take the nonce and key check of a header. false if the key check shows the secret is not the one encrypted with
+    bool set_nonce_from_header (Span<const unsigned char> encryption);
+
+    //! nonce and key check, as the header carries them
+    void get_header_field (unsigned char* encryption) const;
+
+    //! encrypt or decrypt len bytes in place, at offset in the stored file
+    void crypt (uint64_t offset, unsigned char* data, size_t len);
+
+private:
+    void get_keycheck (unsigned char* keycheck) const;
+
+    unsigned char m_key[32];
+    unsigned char m_iv[ENCRYPT_IVLEN];
+    ChaCha20 m_chacha;
+};
+
+#endif // ENCRYPT_H
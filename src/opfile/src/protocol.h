@@ -1,6 +1,8 @@
 #ifndef PROTOCOL_H
 #define PROTOCOL_H
 
+#include <cstdint>
+#include <string>
 #include <vector>
 
 const bool debug = false;
@@ -23,17 +25,56 @@ const int OPENCODING_CHECKSUM = 16;
 const int OPENCODING_CHUNKNUM = 4;
 const int OPENCODING_CHUNKTOTAL = 4;
 const int OPENCODING_EXTENSION = 4;
+const int OPENCODING_MERKLEROOT = 32;
+const int OPENCODING_CONTENTHASH = 32;
+const int OPENCODING_ENCRYPTION = 16;
 
 //! const bytearray present in file
-const std::vector<std::string> OPENCODING_VERSION = { "00", "01" };
+const std::vector<std::string> OPENCODING_VERSION = { "00", "01", "02" };
+
+//! binary form of OPENCODING_VERSION[2]
+const uint8_t OPENCODING_COMPACT = 0x02;
+
+//! largest standard OP_RETURN script (MAX_OP_RETURN_RELAY)
+const int OPENCODING_SCRIPTMAX = 640;
+//! protocol 02 data chunk, filling the script less OP_RETURN, OP_PUSHDATA2 and its length,
+//! magic, version, uuid and the largest chunknum varint
+const int OPENCODING_COMPACT_CHUNKMAX = OPENCODING_SCRIPTMAX - 4 - OPENCODING_MAGICLEN - OPENCODING_VERSIONLEN - OPENCODING_UUID - 5;
+
+//! protocol 02 header flags, a header with any other bit set is rejected
+const uint64_t OPENCODING_FLAG_COMPRESSED = 1;
+const uint64_t OPENCODING_FLAG_CONTENTHASH = 2;
+const uint64_t OPENCODING_FLAG_ENCRYPTED = 4;
+const uint64_t OPENCODING_FLAGS_KNOWN = OPENCODING_FLAG_COMPRESSED | OPENCODING_FLAG_CONTENTHASH | OPENCODING_FLAG_ENCRYPTED;
+//! largest length a compressed file may declare once decompressed
+const uint64_t OPENCODING_COMPRESSED_MAXLEN = uint64_t(1) << 32;
 
 // Store asset magic
 const std::string OPENCODING_MAGIC = "6c796e78";
+const unsigned char OPENCODING_MAGIC_BIN[] = { 0x6c, 0x79, 0x6e, 0x78 };
 
 //! variations of OPENCODING_VERSION
 //!
 //! 00 is standard base with authchunks
 //! 01 is a variation where 4 extra bytes are added to the datachunk (file extension in ascii)
+//! 02 is compact, fields are varints (compactsize) and the data chunks carry no checksum, chunklen
+//!    or chunktotal. the header chunk signs the file length, the extension and the merkle root of
+//!    the data chunks instead:
+//!
+//!    header | magic version uuid varint(0) varint(flags) varint(filelen) [varint(rawlen)] merkleroot [contenthash] [encryption] varint(extlen) ext signature
+//!    data   | magic version uuid varint(chunknum) data
+//!
+//!    every data chunk but the last holds OPENCODING_COMPACT_CHUNKMAX bytes. merkle leaves are the
+//!    double sha256 of each chunk's data, in chunknum order, combined as for the transactions of a block
+//!
+//!    with OPENCODING_FLAG_COMPRESSED the chunks carry the file in the stream format of compress.h,
+//!    filelen is the length stored in the chunks and rawlen the length of the file it decompresses to
+//!
+//!    with OPENCODING_FLAG_CONTENTHASH the header carries the sha256 of the file as the tenant stored
+//!    it, before any compression, so the storage index can find an earlier upload of the same file
+//!
+//!    with OPENCODING_FLAG_ENCRYPTED the chunks carry the file (compressed or not) encrypted as in
+//!    encrypt.h, and the header the nonce and key check it was encrypted with
 
 //! errorlevel enum
 enum {
@@ -68,6 +109,10 @@ enum {
      ERR_CHUNKAUTHUNK,
      //feature
      ERR_EXTENSION,
+     //proof
+     ERR_UNCONFIRMED,
+     //encryption
+     ERR_DECRYPT,
 };
 
 #endif // PROTOCOL_H
@@ -1,8 +1,9 @@
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <random>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -13,16 +14,14 @@
 
 #include "logging.h"
 
-#include <openssl/sha.h>
+#include <crypto/sha256.h>
+#include <random.h>
+#include <span.h>
+#include <util/strencodings.h>
 
 unsigned char binvalue(const char v) {
-    if (v >= '0' && v <= '9') {
-        return v-'0';
-    }
-    if (v >= 'a' && v <= 'f') {
-        return v-'a'+10;
-    }
-    return 0;
+    const signed char value = HexDigit(v);
+    return value < 0 ? 0 : value;
 }
 
 void binlify_from_hex(unsigned char *bin, const char *hex, int len) {
@@ -32,10 +31,7 @@ void binlify_from_hex(unsigned char *bin, const char *hex, int len) {
 }
 
 void hexlify_from_bin(char *hex, const unsigned char *bin, int len) {
-    hex[0] = 0;
-    for(int i=0; i < len; i++) {
-        sprintf(hex+strlen(hex), "%02x", bin[i]);
-    }
+    *WriteHexStr(Span{bin, size_t(std::max(len, 0))}, hex) = 0;
 }
 
 int calculate_chunks_from_filesize(int len) {
@@ -47,13 +43,50 @@ int calculate_chunks_from_filesize(int len) {
 }
 
 void sha256_hash_bin(const char *input, char *output, unsigned int len) {
-    SHA256((const unsigned char*)input, len, (unsigned char*)output);
+    CSHA256().Write((const unsigned char*)input, len).Finalize((unsigned char*)output);
 }
 
 void sha256_hash_hex(const char *input, char *output, unsigned int len) {
-    char output1[32];
-    SHA256((const unsigned char*)input, len, (unsigned char*)output1);
-    hexlify_from_bin(output, (unsigned char *)output1, 32);
+    unsigned char digest[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write((const unsigned char*)input, len).Finalize(digest);
+    hexlify_from_bin(output, digest, sizeof(digest));
+}
+
+void sha256_hash_of_hex(Span<const unsigned char> data, unsigned char *digest) {
+    // hex encoded a piece at a time on the stack, each piece a whole number of sha256 blocks
+    char hex[1024];
+    CSHA256 hasher;
+    while (!data.empty()) {
+        const Span<const unsigned char> piece{data.first(std::min(data.size(), sizeof(hex) / 2))};
+        WriteHexStr(piece, hex);
+        hasher.Write((const unsigned char*)hex, piece.size() * 2);
+        data = data.subspan(piece.size());
+    }
+    hasher.Finalize(digest);
+}
+
+bool sha256_hash_stream(FILE* in, unsigned char *digest) {
+    unsigned char buffer[65536];
+    CSHA256 hasher;
+    size_t len;
+    while ((len = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        hasher.Write(buffer, len);
+    }
+    if (ferror(in)) {
+        return false;
+    }
+    hasher.Finalize(digest);
+    return true;
+}
+
+bool sha256_hash_file(const std::string& filepath, unsigned char *digest) {
+    FILE* in = fopen(filepath.c_str(), "rb");
+    if (!in) {
+        return false;
+    }
+    const bool ok = sha256_hash_stream(in, digest);
+    fclose(in);
+    return ok;
 }
 
 int read_file_size(std::string filepath) {
@@ -97,37 +130,15 @@ std::string get_len_as_hex(int len, int padding) {
     return hex;
 }
 
-std::string get_hex_from_offset(std::string hexstring, int offset, int len) {
-    std::string hexstream;
-    for (int i = offset; i < (len > 0 ? offset + len : hexstring.size()); i++) {
-        hexstream = hexstream + hexstring[i];
+std::string get_hex_from_offset(const std::string& hexstring, int offset, int len) {
+    if (offset < 0 || size_t(offset) >= hexstring.size()) {
+        return {};
     }
-    return hexstream;
-}
-
-static unsigned int random_char() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 255);
-    return dis(gen);
-}
-
-static std::string generate_hex(const unsigned int len) {
-    std::stringstream ss;
-    for (auto i = 0; i < len; i++) {
-        const auto rc = random_char();
-        std::stringstream hexstream;
-        hexstream << std::hex << rc;
-        auto hex = hexstream.str();
-        ss << (hex.length() < 2 ? '0' + hex : hex);
-    }
-    return ss.str();
+    return hexstring.substr(offset, len > 0 ? size_t(len) : std::string::npos);
 }
 
 std::string generate_uuid(int len) {
-    std::stringstream hexstream;
-    hexstream << generate_hex(len);
-    return hexstream.str();
+    return HexStr(GetThreadRandomContext().randbytes(len));
 }
 
 bool generate_random_binary(std::string filepath, int len) {
@@ -1,21 +1,32 @@
 #ifndef UTIL_H
 #define UTIL_H
 
+#include <span.h>
+
+#include <cstdio>
 #include <string>
 #include <vector>
 
+//! value of a hex digit of either case, 0 for anything else
 unsigned char binvalue(const char v);
 void binlify_from_hex(unsigned char *bin, const char *hex, int len);
+//! write the lowercase hex of len bytes of bin to hex, followed by a NUL
 void hexlify_from_bin(char *hex, const unsigned char *bin, int len);
 int calculate_chunks_from_filesize(int len);
 void sha256_hash_bin(const char *input, char *output, unsigned int len);
 void sha256_hash_hex(const char *input, char *output, unsigned int len);
+//! sha256 of the lowercase hex of data into the 32 bytes at digest, without building the hex string
+void sha256_hash_of_hex(Span<const unsigned char> data, unsigned char *digest);
+//! sha256 of the rest of an open file into the 32 bytes at digest
+bool sha256_hash_stream(FILE* in, unsigned char *digest);
+//! sha256 of a file into the 32 bytes at digest
+bool sha256_hash_file(const std::string& filepath, unsigned char *digest);
 int read_file_size(std::string filepath);
 bool read_file_stream(std::string filepath, char* buffer, int buflen);
 bool write_file_stream(std::string filepath, char* buffer, int buflen);
 bool write_partial_stream(FILE* in, char* buffer, int buflen);
 std::string get_len_as_hex(int len, int padding);
-std::string get_hex_from_offset(std::string hexstring, int offset, int len);
+std::string get_hex_from_offset(const std::string& hexstring, int offset, int len);
 std::string generate_uuid(int len);
 bool generate_random_binary(std::string filepath, int len);
 bool compare_two_binary_files(std::string filepath1, std::string filepath2);
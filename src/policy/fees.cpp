@@ -32,6 +32,8 @@
 #include <utility>
 
 static constexpr double INF_FEERATE = 1e99;
+/** Weight of a new data point in TxConfirmStats above which the moving averages are decayed for real */
+static constexpr double MAX_RECORD_WEIGHT = 1e6;
 
 std::string StringForFeeEstimateHorizon(FeeEstimateHorizon horizon)
 {
@@ -99,6 +101,12 @@ private:
 
     double decay;
 
+    // Rather than decaying every moving average on each block, new data points are
+    // recorded with a weight growing by 1/decay per block, and the averages above are
+    // m_record_weight times their actual values. Once the weight gets large, the
+    // decay is applied to all of them at once and the weight returns to 1.
+    double m_record_weight{1};
+
     // Resolution (# of blocks) with which confirmations are tracked
     unsigned int scale;
 
@@ -111,6 +119,9 @@ private:
 
     void resizeInMemoryCounters(size_t newbuckets);
 
+    /** Apply the decay pending in m_record_weight to all moving averages */
+    void ApplyDecay();
+
 public:
     /**
      * Create new TxConfirmStats. This is called by BlockPolicyEstimator's
@@ -161,7 +172,7 @@ public:
     unsigned int GetMaxConfirms() const { return scale * confAvg.size(); }
 
     /** Write state of estimation data to a file*/
-    void Write(AutoFile& fileout) const;
+    void Write(AutoFile& fileout);
 
     /**
      * Read saved state of estimation data from a file and replace all internal data structures and
@@ -217,23 +228,31 @@ void TxConfirmStats::Record(int blocksToConfirm, double feerate)
     int periodsToConfirm = (blocksToConfirm + scale - 1) / scale;
     unsigned int bucketindex = bucketMap.lower_bound(feerate)->second;
     for (size_t i = periodsToConfirm; i <= confAvg.size(); i++) {
-        confAvg[i - 1][bucketindex]++;
+        confAvg[i - 1][bucketindex] += m_record_weight;
     }
-    txCtAvg[bucketindex]++;
-    m_feerate_avg[bucketindex] += feerate;
+    txCtAvg[bucketindex] += m_record_weight;
+    m_feerate_avg[bucketindex] += feerate * m_record_weight;
 }
 
 void TxConfirmStats::UpdateMovingAverages()
+{
+    m_record_weight /= decay;
+    if (m_record_weight > MAX_RECORD_WEIGHT) ApplyDecay();
+}
+
+void TxConfirmStats::ApplyDecay()
 {
     assert(confAvg.size() == failAvg.size());
+    const double pending_decay{1 / m_record_weight};
     for (unsigned int j = 0; j < buckets.size(); j++) {
         for (unsigned int i = 0; i < confAvg.size(); i++) {
-            confAvg[i][j] *= decay;
-            failAvg[i][j] *= decay;
+            confAvg[i][j] *= pending_decay;
+            failAvg[i][j] *= pending_decay;
         }
-        m_feerate_avg[j] *= decay;
-        txCtAvg[j] *= decay;
+        m_feerate_avg[j] *= pending_decay;
+        txCtAvg[j] *= pending_decay;
     }
+    m_record_weight = 1;
 }
 
 // returns -1 on error conditions
@@ -248,6 +267,7 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     double failNum = 0; // Number of tx's that were never confirmed but removed from the mempool after confTarget
     const int periodTarget = (confTarget + scale - 1) / scale;
     const int maxbucketindex = buckets.size() - 1;
+    const double pending_decay{1 / m_record_weight};
 
     // We'll combine buckets until we have enough samples.
     // The near and far variables will define the range we've combined
@@ -273,9 +293,9 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
             newBucketRange = false;
         }
         curFarBucket = bucket;
-        nConf += confAvg[periodTarget - 1][bucket];
-        totalNum += txCtAvg[bucket];
-        failNum += failAvg[periodTarget - 1][bucket];
+        nConf += confAvg[periodTarget - 1][bucket] * pending_decay;
+        totalNum += txCtAvg[bucket] * pending_decay;
+        failNum += failAvg[periodTarget - 1][bucket] * pending_decay;
         for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
             extraNum += unconfTxs[(nBlockHeight - confct) % bins][bucket];
         extraNum += oldUnconfTxs[bucket];
@@ -330,6 +350,7 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     // Find the bucket with the median transaction and then report the average feerate from that bucket
     // This is a compromise between finding the median which we can't since we don't save all tx's
     // and reporting the average which is less accurate
+    // (Both the tx counts and feerate sums carry the pending decay, which cancels out here)
     unsigned int minBucket = std::min(bestNearBucket, bestFarBucket);
     unsigned int maxBucket = std::max(bestNearBucket, bestFarBucket);
     for (unsigned int j = minBucket; j <= maxBucket; j++) {
@@ -390,8 +411,10 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     return median;
 }
 
-void TxConfirmStats::Write(AutoFile& fileout) const
+void TxConfirmStats::Write(AutoFile& fileout)
 {
+    // The file holds the actual moving averages
+    ApplyDecay();
     fileout << Using<EncodedDoubleFormatter>(decay);
     fileout << scale;
     fileout << Using<VectorFormatter<EncodedDoubleFormatter>>(m_feerate_avg);
@@ -451,6 +474,7 @@ void TxConfirmStats::Read(AutoFile& filein, int nFileVersion, size_t numBuckets)
     // Resize the current block variables which aren't stored in the data file
     // to match the number of confirms and buckets
     resizeInMemoryCounters(numBuckets);
+    m_record_weight = 1;
 
     LogPrint(BCLog::ESTIMATEFEE, "Reading estimates: %u buckets counting confirms up to %u blocks\n",
              numBuckets, maxConfirms);
@@ -496,7 +520,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         assert(scale != 0);
         unsigned int periodsAgo = blocksAgo / scale;
         for (size_t i = 0; i < periodsAgo && i < failAvg.size(); i++) {
-            failAvg[i][bucketindex]++;
+            failAvg[i][bucketindex] += m_record_weight;
         }
     }
 }
@@ -517,6 +541,8 @@ bool CBlockPolicyEstimator::_removeTx(const uint256& hash, bool inBlock)
     AssertLockHeld(m_cs_fee_estimator);
     std::map<uint256, TxStatsInfo>::iterator pos = mapMemPoolTxs.find(hash);
     if (pos != mapMemPoolTxs.end()) {
+        // Transactions entered at the best seen height do not count towards estimates yet
+        if (pos->second.blockHeight != nBestSeenHeight) ClearSmartFeeCache();
         feeStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         shortStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         longStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
@@ -644,6 +670,8 @@ void CBlockPolicyEstimator::processBlock(unsigned int nBlockHeight,
     shortStats->ClearCurrent(nBlockHeight);
     longStats->ClearCurrent(nBlockHeight);
 
+    ClearSmartFeeCache();
+
     // Decay all exponential averages
     feeStats->UpdateMovingAverages();
     shortStats->UpdateMovingAverages();
@@ -825,7 +853,34 @@ double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget,
  */
 CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
 {
+    const std::pair<int, bool> key{confTarget, conservative};
+    {
+        LOCK(m_smart_fee_cache_mutex);
+        const auto it{m_smart_fee_cache.find(key)};
+        if (it != m_smart_fee_cache.end()) {
+            if (feeCalc) *feeCalc = it->second.second;
+            return it->second.first;
+        }
+    }
+
     LOCK(m_cs_fee_estimator);
+    FeeCalculation fee_calc;
+    const CFeeRate feerate{_estimateSmartFee(confTarget, &fee_calc, conservative)};
+    WITH_LOCK(m_smart_fee_cache_mutex, m_smart_fee_cache.emplace(key, std::make_pair(feerate, fee_calc)));
+    if (feeCalc) *feeCalc = fee_calc;
+    return feerate;
+}
+
+void CBlockPolicyEstimator::ClearSmartFeeCache() const
+{
+    AssertLockHeld(m_cs_fee_estimator);
+    LOCK(m_smart_fee_cache_mutex);
+    m_smart_fee_cache.clear();
+}
+
+CFeeRate CBlockPolicyEstimator::_estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+{
+    AssertLockHeld(m_cs_fee_estimator);
 
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
@@ -988,6 +1043,7 @@ bool CBlockPolicyEstimator::Read(AutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+            ClearSmartFeeCache();
         }
     }
     catch (const std::exception& e) {
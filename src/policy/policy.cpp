@@ -24,6 +24,25 @@
 #include <cstddef>
 #include <vector>
 
+//! Magic of storage authdata, as OPAUTH_MAGIC_BIN in storage/chunk.h
+static const unsigned char STORAGE_AUTH_MAGIC_BIN[] = {0x6c, 0x79, 0x6e, 0x6b};
+
+bool IsStorageTx(const CTransaction& tx)
+{
+    for (const CTxOut& txout : tx.vout) {
+        if (!txout.scriptPubKey.IsOpReturn()) continue;
+        CScript::const_iterator pc = txout.scriptPubKey.begin() + 1;
+        opcodetype opcode;
+        std::vector<unsigned char> data;
+        if (!txout.scriptPubKey.GetOp(pc, opcode, data) || data.size() < OPENCODING_MAGICLEN) continue;
+        if (std::equal(std::begin(OPENCODING_MAGIC_BIN), std::end(OPENCODING_MAGIC_BIN), data.begin()) ||
+            std::equal(std::begin(STORAGE_AUTH_MAGIC_BIN), std::end(STORAGE_AUTH_MAGIC_BIN), data.begin())) {
+            return true;
+        }
+    }
+    return false;
+}
+
 CAmount GetDustThreshold(const CTxOut& txout, const CFeeRate& dustRelayFeeIn)
 {
     // "Dust" is defined in terms of dustRelayFee,
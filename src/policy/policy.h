@@ -67,6 +67,10 @@ static constexpr unsigned int DEFAULT_DESCENDANT_LIMIT{36};
 /** Default for -limitdescendantsize, maximum kilobytes of in-mempool descendants */
 //static constexpr unsigned int DEFAULT_DESCENDANT_SIZE_LIMIT_KVB{101};
 static constexpr unsigned int DEFAULT_DESCENDANT_SIZE_LIMIT_KVB{5500};
+/** Default for -limitstoragechaincount, max number of in-mempool ancestors or descendants of a storage transaction */
+static constexpr unsigned int DEFAULT_STORAGE_CHAIN_LIMIT{256};
+/** Default for -limitstoragechainsize, maximum kilobytes of a storage transaction with its in-mempool ancestors or descendants */
+static constexpr unsigned int DEFAULT_STORAGE_CHAIN_SIZE_LIMIT_KVB{25000};
 /**
  * An extra transaction can be added to a package, as long as it only has one
  * ancestor and is no larger than this. Not really any reason to make this
@@ -122,6 +126,12 @@ static constexpr decltype(CTransaction::nVersion) TX_MAX_STANDARD_VERSION{2};
 * @return True if all outputs (scriptPubKeys) use only standard transaction forms
 */
 bool IsStandardTx(const CTransaction& tx, const std::optional<unsigned>& max_datacarrier_bytes, bool permit_bare_multisig, const CFeeRate& dust_relay_fee, std::string& reason);
+/**
+ * Check for storage protocol data: an OP_RETURN output pushing a chunk ('lynx'
+ * magic) or authdata ('lynk' magic). The mempool keeps such transactions apart
+ * from ordinary payments, with their own memory cap and eviction.
+ */
+bool IsStorageTx(const CTransaction& tx);
 /**
 * Check for standard transaction types
 * @param[in] mapInputs       Map of previous transactions that have outputs we're spending
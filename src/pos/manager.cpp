@@ -4,56 +4,75 @@
 
 #include <pos/manager.h>
 
-bool fStakerRunning{false};
-bool fStakerRequestStart{false};
-bool fStakerRequestStop{false};
+#include <node/jobs.h>
+#include <sync.h>
+
+std::atomic<bool> fStakerRunning{false};
+
+//! Kind, and group, of the jobs starting and stopping the stake threads
+static const std::string STAKEMAN_KIND{"staking"};
+
+static GlobalMutex g_stakeman_mutex;
+static wallet::WalletContext* g_stakeman_wallet_context GUARDED_BY(g_stakeman_mutex){nullptr};
+static ChainstateManager* g_stakeman_chainman GUARDED_BY(g_stakeman_mutex){nullptr};
+static CConnman* g_stakeman_connman GUARDED_BY(g_stakeman_mutex){nullptr};
+
+// start or stop the stake threads
+static void stakeman_set_running(bool running)
+{
+    LOCK(g_stakeman_mutex);
+    if (!g_stakeman_wallet_context || fStakerRunning == running) {
+        return;
+    }
+    if (running) {
+        StartThreadStakeMiner(*g_stakeman_wallet_context, *g_stakeman_chainman, g_stakeman_connman);
+        LogPrint(BCLog::POS, "Started staking thread\n");
+    } else {
+        StopThreadStakeMiner();
+        LogPrint(BCLog::POS, "Stopped staking thread\n");
+    }
+    fStakerRunning = running;
+}
+
+// run a start or stop request on the job threads, in the order requested
+static void stakeman_request(bool running)
+{
+    if (!node::g_job_queue) {
+        stakeman_set_running(running);
+        return;
+    }
+    node::g_job_queue->Submit(STAKEMAN_KIND, [running]() -> UniValue {
+        stakeman_set_running(running);
+        return running;
+    }, /*id=*/"", /*group=*/STAKEMAN_KIND, node::JobPriority::HIGH);
+}
 
 // signal stake thread start
-// Bens comment
 void stakeman_request_start() {
-    fStakerRequestStart = true;
+    stakeman_request(true);
 }
 
 // signal stake thread stop
 void stakeman_request_stop() {
-    fStakerRequestStop = true;
+    stakeman_request(false);
 }
 
-// stake thread handler
-void *stakeman_handler(wallet::WalletContext& wallet_context, ChainstateManager& chainman, CConnman* connman)
+void stakeman_init(wallet::WalletContext& wallet_context, ChainstateManager& chainman, CConnman* connman)
 {
-    fStakerRequestStart = true;
-
-    while (!ShutdownRequested())
     {
-        while (fStakerRunning)
-        {
-            fStakerRequestStart = false;
-            if (fStakerRequestStop)
-            {
-                StopThreadStakeMiner();
-                fStakerRunning = false;
-                fStakerRequestStop = false;
-                LogPrint(BCLog::POS, "Stopped staking thread\n");
-            }
-            UninterruptibleSleep(std::chrono::milliseconds{250});
-        }
-
-        while (!fStakerRunning)
-        {
-            fStakerRequestStop = false;
-            if (fStakerRequestStart)
-            {
-                StartThreadStakeMiner(wallet_context, chainman, connman);
-                fStakerRunning = true;
-                fStakerRequestStart = false;
-                LogPrint(BCLog::POS, "Started staking thread\n");
-            }
-            UninterruptibleSleep(std::chrono::milliseconds{250});
-        }
-
-        UninterruptibleSleep(std::chrono::milliseconds{250});
+        LOCK(g_stakeman_mutex);
+        g_stakeman_wallet_context = &wallet_context;
+        g_stakeman_chainman = &chainman;
+        g_stakeman_connman = connman;
     }
+    stakeman_request_start();
+}
 
-    return (void*)0;
+void stakeman_shutdown()
+{
+    stakeman_set_running(false);
+    LOCK(g_stakeman_mutex);
+    g_stakeman_wallet_context = nullptr;
+    g_stakeman_chainman = nullptr;
+    g_stakeman_connman = nullptr;
 }
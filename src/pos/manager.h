@@ -10,14 +10,21 @@
 #include <shutdown.h>
 #include <util/time.h>
 
+#include <atomic>
+
 namespace wallet {
 struct WalletContext;
 class CWallet;
 } // namespace wallet
 
-extern bool fStakerRunning;
+//! Whether the stake threads are running
+extern std::atomic<bool> fStakerRunning;
+/** Start or stop the stake threads, from a job on the node's job threads. */
 void stakeman_request_start();
 void stakeman_request_stop();
-void* stakeman_handler(wallet::WalletContext& wallet_context, ChainstateManager& chainman, CConnman* connman);
+/** Start the stake threads, and let requests start and stop them from then on. */
+void stakeman_init(wallet::WalletContext& wallet_context, ChainstateManager& chainman, CConnman* connman);
+/** Stop the stake threads, and ignore requests from then on. */
+void stakeman_shutdown();
 
 #endif // POS_STAKEMAN_H
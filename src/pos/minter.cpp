@@ -6,6 +6,7 @@
 
 #include <chainparams.h>
 #include <consensus/consensus.h>
+#include <node/blocktemplatecache.h>
 #include <node/miner.h>
 #include <pos/manager.h>
 #include <pos/pos.h>
@@ -16,14 +17,17 @@
 #include <util/moneystr.h>
 #include <util/syserror.h>
 #include <util/thread.h>
+#include <util/trace.h>
 
 #include <consensus/merkle.h>
 #include <consensus/validation.h>
 #include <net.h>
 #include <node/blockstorage.h>
+#include <node/interface_ui.h>
 #include <sync.h>
 #include <timedata.h>
 #include <validation.h>
+#include <validationinterface.h>
 
 #include <wallet/coinselection.h>
 #include <wallet/receive.h>
@@ -45,8 +49,261 @@ std::atomic<bool> fIsStaking(false);
 
 int nMinStakeInterval = 0; // Minimum stake interval in seconds
 int nMinerSleep = 500; // In milliseconds
+int nStakeLookahead = DEFAULT_STAKE_LOOKAHEAD; // In coinstake timestamps
+int nStakeWorkers = DEFAULT_STAKE_WORKERS;
 std::atomic<int64_t> nTimeLastStake(0);
 
+StakeTelemetry g_stake_telemetry;
+StakeScheduler g_stake_scheduler;
+
+std::string StakeStageName(StakeStage stage)
+{
+    switch (stage) {
+    case StakeStage::COIN_SELECTION: return "coinselection";
+    case StakeStage::KERNEL_SEARCH: return "kernelsearch";
+    case StakeStage::BLOCK_TEMPLATE: return "blocktemplate";
+    case StakeStage::SIGNING: return "signing";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+std::string StakeSleepName(StakeSleep reason)
+{
+    switch (reason) {
+    case StakeSleep::REINDEX: return "reindex";
+    case StakeSleep::NOT_RUNNING: return "notrunning";
+    case StakeSleep::MINING_THREAD: return "miningthread";
+    case StakeSleep::SYNC: return "sync";
+    case StakeSleep::RATE_LIMITED: return "ratelimited";
+    case StakeSleep::BLOCK_TIME: return "blocktime";
+    case StakeSleep::IDLE: return "idle";
+    case StakeSleep::NEXT_TIMESTAMP: return "nexttimestamp";
+    case StakeSleep::NEXT_KERNEL: return "nextkernel";
+    case StakeSleep::STAKE_LIMIT: return "stakelimit";
+    case StakeSleep::BALANCE: return "balance";
+    case StakeSleep::DEPTH: return "depth";
+    case StakeSleep::BLOCK_TEMPLATE: return "blocktemplate";
+    case StakeSleep::STAKED: return "staked";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+void StakeTelemetry::AddCycle()
+{
+    LOCK(m_mutex);
+    ++m_stats.cycles;
+}
+
+void StakeTelemetry::AddStageTime(StakeStage stage, std::chrono::microseconds time)
+{
+    LOCK(m_mutex);
+    ++m_stats.stage_count[(size_t)stage];
+    m_stats.stage_time[(size_t)stage] += time;
+}
+
+void StakeTelemetry::AddSleep(StakeSleep reason, std::chrono::milliseconds time)
+{
+    LOCK(m_mutex);
+    ++m_stats.sleep_count[(size_t)reason];
+    m_stats.sleep_time[(size_t)reason] += time;
+}
+
+void StakeTelemetry::AddAttempt(StakeAttempt attempt)
+{
+    TRACE5(stake, attempt,
+        attempt.wallet.c_str(),
+        attempt.height,
+        attempt.candidates,
+        attempt.kernel_hashes,
+        attempt.result.c_str());
+    uiInterface.NotifyStakeAttempt(attempt);
+
+    LOCK(m_mutex);
+    m_stats.kernel_hashes += attempt.kernel_hashes;
+    if (attempt.result == "staked") {
+        ++m_stats.staked;
+    }
+    m_stats.attempts.push_back(std::move(attempt));
+    if (m_stats.attempts.size() > STAKE_ATTEMPTS_KEPT) {
+        m_stats.attempts.pop_front();
+    }
+}
+
+StakeStats StakeTelemetry::GetStats() const
+{
+    LOCK(m_mutex);
+    return m_stats;
+}
+
+void StakeTelemetry::LogSummary(int64_t now)
+{
+    if (!LogAcceptCategory(BCLog::POS, BCLog::Level::Debug)) return;
+
+    LOCK(m_mutex);
+    if (now < m_last_summary + STAKE_SUMMARY_INTERVAL) return;
+    m_last_summary = now;
+
+    std::string stages, sleeps;
+    for (size_t i = 0; i < NUM_STAKE_STAGES; ++i) {
+        stages += strprintf(" %s=%dms/%d", StakeStageName((StakeStage)i), count_milliseconds(std::chrono::duration_cast<std::chrono::milliseconds>(m_stats.stage_time[i])), m_stats.stage_count[i]);
+    }
+    for (size_t i = 0; i < NUM_STAKE_SLEEPS; ++i) {
+        if (m_stats.sleep_count[i] == 0) continue;
+        sleeps += strprintf(" %s=%ds/%d", StakeSleepName((StakeSleep)i), count_seconds(std::chrono::duration_cast<std::chrono::seconds>(m_stats.sleep_time[i])), m_stats.sleep_count[i]);
+    }
+    const auto search_time{m_stats.stage_time[(size_t)StakeStage::KERNEL_SEARCH]};
+    const double hash_rate = search_time.count() > 0 ? m_stats.kernel_hashes * 1e6 / search_time.count() : 0;
+    LogPrint(BCLog::POS, "Stake telemetry: %d cycles, %d staked, %.0f kernel hashes/s, stages%s, sleeps%s\n",
+             m_stats.cycles, m_stats.staked, hash_rate, stages, sleeps);
+}
+
+void StakeScheduler::Clear()
+{
+    LOCK(m_mutex);
+    m_tasks.clear();
+    m_tip.SetNull();
+}
+
+size_t StakeScheduler::Add(const std::string& wallet)
+{
+    LOCK(m_mutex);
+    Task task;
+    task.stats.wallet = wallet;
+    task.due = SteadyClock::now();
+    m_tasks.push_back(std::move(task));
+    return m_tasks.size() - 1;
+}
+
+std::optional<size_t> StakeScheduler::Next(SteadyClock::time_point now, int thread)
+{
+    LOCK(m_mutex);
+    std::optional<size_t> next;
+    for (size_t i = 0; i < m_tasks.size(); ++i) {
+        const Task& task{m_tasks[i]};
+        if (task.stats.running || task.due > now) continue;
+        if (next) {
+            const Task& best{m_tasks[*next]};
+            if (task.stats.weight < best.stats.weight) continue;
+            if (task.stats.weight == best.stats.weight && task.due >= best.due) continue;
+        }
+        next = i;
+    }
+    if (!next) return std::nullopt;
+
+    Task& task{m_tasks[*next]};
+    task.stats.running = true;
+    task.stats.thread = thread;
+    task.stats.delay += std::chrono::duration_cast<std::chrono::microseconds>(now - task.due);
+    task.started = now;
+    return next;
+}
+
+void StakeScheduler::Done(size_t task, SteadyClock::time_point now, SteadyClock::time_point due, StakeSleep reason, std::optional<CAmount> weight, bool staked)
+{
+    LOCK(m_mutex);
+    Task& done{m_tasks.at(task)};
+    done.stats.running = false;
+    if (weight) done.stats.weight = *weight;
+    done.stats.reason = reason;
+    ++done.stats.attempts;
+    if (staked) ++done.stats.staked;
+    done.stats.busy_time += std::chrono::duration_cast<std::chrono::microseconds>(now - done.started);
+    // A wake while the task ran makes it due again at once
+    done.due = done.woken ? now : due;
+    done.woken = false;
+}
+
+std::optional<std::pair<SteadyClock::time_point, StakeSleep>> StakeScheduler::NextDue() const
+{
+    LOCK(m_mutex);
+    std::optional<std::pair<SteadyClock::time_point, StakeSleep>> next;
+    for (const Task& task : m_tasks) {
+        if (task.stats.running) continue;
+        if (!next || task.due < next->first) next = std::make_pair(task.due, task.stats.reason);
+    }
+    return next;
+}
+
+bool StakeScheduler::Wake(const std::string& wallet)
+{
+    LOCK(m_mutex);
+    const auto now{SteadyClock::now()};
+    for (Task& task : m_tasks) {
+        if (task.stats.wallet != wallet) continue;
+        task.due = std::min(task.due, now);
+        task.woken = task.stats.running;
+        return true;
+    }
+    return false;
+}
+
+void StakeScheduler::WakeAll()
+{
+    LOCK(m_mutex);
+    const auto now{SteadyClock::now()};
+    for (Task& task : m_tasks) {
+        task.due = std::min(task.due, now);
+        task.woken = task.stats.running;
+    }
+}
+
+bool StakeScheduler::SetTip(const uint256& hash)
+{
+    {
+        LOCK(m_mutex);
+        if (hash == m_tip) return false;
+        m_tip = hash;
+    }
+    WakeAll();
+    return true;
+}
+
+std::vector<StakeTaskStats> StakeScheduler::GetStats(SteadyClock::time_point now) const
+{
+    LOCK(m_mutex);
+    std::vector<StakeTaskStats> stats;
+    for (const Task& task : m_tasks) {
+        stats.push_back(task.stats);
+        stats.back().due_in = std::chrono::duration_cast<std::chrono::milliseconds>(task.due - now);
+    }
+    return stats;
+}
+
+namespace {
+/** Adds the time it was alive to a stage of the stake cycle */
+class StakeStageTimer
+{
+public:
+    explicit StakeStageTimer(StakeStage stage) : m_stage{stage}, m_start{SteadyClock::now()} {}
+    ~StakeStageTimer()
+    {
+        g_stake_telemetry.AddStageTime(m_stage, std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - m_start));
+    }
+
+private:
+    const StakeStage m_stage;
+    const SteadyClock::time_point m_start;
+};
+} // namespace
+
+namespace {
+/** Wakes the stake threads on a new tip, as kernels only hold for the tip they were searched on */
+class StakeThreadNotifications final : public CValidationInterface
+{
+protected:
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override
+    {
+        if (!fInitialDownload) {
+            WakeAllThreadStakeMiner();
+        }
+    }
+};
+
+std::shared_ptr<StakeThreadNotifications> g_stake_notifications;
+//! Connections of WakeThreadStakeMiner() to the wallets staked
+std::vector<boost::signals2::scoped_connection> g_stake_wallet_connections;
+} // namespace
+
 bool CheckStake(ChainstateManager& chainman, const CBlock* pblock)
 {
     uint256 proofHash, hashTarget;
@@ -114,6 +371,8 @@ void StartThreadStakeMiner(wallet::WalletContext& wallet_context, ChainstateMana
 {
     nMinStakeInterval = gArgs.GetIntArg("-minstakeinterval", 0);
     nMinerSleep = gArgs.GetIntArg("-minersleep", 500);
+    nStakeLookahead = std::max((int)gArgs.GetIntArg("-stakelookahead", DEFAULT_STAKE_LOOKAHEAD), 0);
+    nStakeWorkers = std::max((int)gArgs.GetIntArg("-stakeworkers", DEFAULT_STAKE_WORKERS), 1);
 
     if (!gArgs.GetBoolArg("-staking", true)) {
         LogPrintf("Staking disabled\n");
@@ -124,17 +383,24 @@ void StartThreadStakeMiner(wallet::WalletContext& wallet_context, ChainstateMana
         if (nWallets < 1) {
             return;
         }
-        size_t nThreads = std::min(nWallets, (size_t)gArgs.GetIntArg("-stakingthreads", 1));
+        size_t nThreads = std::min(nWallets, (size_t)std::max(gArgs.GetIntArg("-stakingthreads", DEFAULT_STAKING_THREADS), (int64_t)1));
 
-        size_t nPerThread = nWallets / nThreads;
+        // The threads share all the wallets, taking whichever is due next
+        g_stake_scheduler.Clear();
+        for (const auto& pwallet : vpwallets) {
+            g_stake_scheduler.Add(pwallet->GetName());
+        }
         for (size_t i = 0; i < nThreads; ++i) {
-            size_t nStart = nPerThread * i;
-            size_t nEnd = (i == nThreads - 1) ? nWallets : nPerThread * (i + 1);
             StakeThread* t = new StakeThread();
             vStakeThreads.push_back(t);
-            vpwallets[i].get()->nStakeThread = i;
-            t->sName = strprintf("miner%d", i);
-            t->thread = std::thread(&util::TraceThread, t->sName.c_str(), std::function<void()>(std::bind(&ThreadStakeMiner, i, vpwallets, nStart, nEnd, &chainman, connman)));
+            t->sName = strprintf("stake.%d", i);
+            t->thread = std::thread(&util::TraceThread, t->sName.c_str(), std::function<void()>(std::bind(&ThreadStakeMiner, i, vpwallets, &chainman, connman)));
+        }
+
+        g_stake_notifications = std::make_shared<StakeThreadNotifications>();
+        RegisterSharedValidationInterface(g_stake_notifications);
+        for (const auto& pwallet : vpwallets) {
+            g_stake_wallet_connections.emplace_back(pwallet->NotifyCanStake.connect(WakeThreadStakeMiner));
         }
     }
 
@@ -150,6 +416,12 @@ void StopThreadStakeMiner()
     LogPrint(BCLog::POS, "StopThreadStakeMiner\n");
     fStopMinerProc = true;
 
+    if (g_stake_notifications) {
+        UnregisterSharedValidationInterface(g_stake_notifications);
+        g_stake_notifications.reset();
+    }
+    g_stake_wallet_connections.clear();
+
     for (auto t : vStakeThreads) {
         t->m_thread_interrupt();
         t->thread.join();
@@ -160,23 +432,24 @@ void StopThreadStakeMiner()
 
 void WakeThreadStakeMiner(wallet::CWallet* pwallet)
 {
-    size_t nStakeThread = 0;
-    {
-        LOCK(pwallet->cs_wallet);
-        nStakeThread = pwallet->nStakeThread;
-        if (nStakeThread >= vStakeThreads.size() || pwallet->IsScanning()) {
-            return;
-        }
-        pwallet->nLastCoinStakeSearchTime = 0;
-        LogPrint(BCLog::POS, "WakeThreadStakeMiner: wallet %s, thread %d\n", pwallet->GetName(), nStakeThread);
+    if (vStakeThreads.empty() || pwallet->IsScanning()) {
+        return;
+    }
+    pwallet->nLastCoinStakeSearchTime = 0;
+    if (!g_stake_scheduler.Wake(pwallet->GetName())) {
+        return;
+    }
+    LogPrint(BCLog::POS, "WakeThreadStakeMiner: wallet %s\n", pwallet->GetName());
+    // Any thread may take the wallet
+    for (auto t : vStakeThreads) {
+        t->m_thread_interrupt();
     }
-    StakeThread* t = vStakeThreads[nStakeThread];
-    t->m_thread_interrupt();
 }
 
 void WakeAllThreadStakeMiner()
 {
     LogPrint(BCLog::POS, "WakeAllThreadStakeMiner\n");
+    g_stake_scheduler.WakeAll();
     for (auto t : vStakeThreads) {
         t->m_thread_interrupt();
     }
@@ -187,12 +460,19 @@ bool ThreadStakeMinerStopped()
     return fStopMinerProc;
 }
 
-static inline void condWaitFor(size_t nThreadID, int ms)
+/**
+ * Sleep for up to ms, or until the thread is woken
+ * The interrupt is only reset once awake, so a wake arriving while the thread
+ * is busy cuts its next sleep short instead of being lost
+ */
+static inline void condWaitFor(size_t nThreadID, int64_t ms, StakeSleep reason)
 {
     assert(vStakeThreads.size() > nThreadID);
     StakeThread* t = vStakeThreads[nThreadID];
-    t->m_thread_interrupt.reset();
+    const auto start{SteadyClock::now()};
     t->m_thread_interrupt.sleep_for(std::chrono::milliseconds(ms));
+    t->m_thread_interrupt.reset();
+    g_stake_telemetry.AddSleep(reason, std::chrono::duration_cast<std::chrono::milliseconds>(SteadyClock::now() - start));
 }
 
 bool SignBlockWithKey(CBlock& block, const CKey& key)
@@ -258,17 +538,219 @@ bool SignBlock(CBlock& block, CBlockIndex* pindexPrev, wallet::CWallet* wallet,
     return false;
 }
 
-void ThreadStakeMiner(size_t nThreadID, std::vector<std::shared_ptr<wallet::CWallet>>& vpwallets, size_t nStart, size_t nEnd, ChainstateManager* chainman, CConnman* connman)
+/**
+ * Find the earliest of nSlots coinstake timestamps from nSearchTime at which
+ * one of the coins the wallet would stake with finds a kernel on pindexPrev
+ */
+static bool FindStakeTime(wallet::CWallet* wallet, CBlockIndex* pindexPrev, int64_t nSearchTime, int nSlots, Chainstate& chain_state, int64_t& nTimeRet, StakeAttempt& attempt)
+{
+    CAmount nValueIn = 0;
+    std::set<std::pair<const wallet::CWalletTx*, unsigned int>> setCoins;
+    {
+        StakeStageTimer timer{StakeStage::COIN_SELECTION};
+        if (!SelectCoinsForStaking(wallet, GetSpendableBalance(*wallet) - wallet->nReserveBalance, setCoins, nValueIn)) {
+            return false;
+        }
+    }
+
+    std::vector<COutPoint> prevouts;
+    for (const auto& [wtx, n] : setCoins) {
+        prevouts.emplace_back(wtx->GetHash(), n);
+    }
+    attempt.candidates = prevouts.size();
+
+    COutPoint prevout;
+    unsigned int nBits = GetNextWorkRequiredPoS(pindexPrev, Params().GetConsensus());
+    bool fFound;
+    {
+        StakeStageTimer timer{StakeStage::KERNEL_SEARCH};
+        fFound = FindStakeKernel(chain_state, pindexPrev, nBits, nSearchTime, nSlots, prevouts, prevout, nTimeRet, nStakeWorkers);
+    }
+    const int64_t nSearched = fFound ? (nTimeRet - nSearchTime) / (nStakeTimestampMask + 1) + 1 : nSlots;
+    attempt.kernel_hashes = prevouts.size() * nSearched;
+    if (!fFound) {
+        return false;
+    }
+
+    LogPrint(BCLog::POS, "%s: %s, kernel %s at %d.\n", __func__, wallet->GetName(), prevout.ToString(), nTimeRet);
+    TRACE5(stake, kernel_found,
+        wallet->GetName().c_str(),
+        pindexPrev->nHeight + 1,
+        prevout.hash.data(),
+        prevout.n,
+        nTimeRet);
+    return true;
+}
+
+namespace {
+/** When a stake attempt of one wallet asks to be tried again */
+struct StakeOutcome {
+    //! Milliseconds until the next attempt, and why
+    int64_t wait_ms;
+    StakeSleep reason{StakeSleep::IDLE};
+    //! Spendable balance, if the attempt got as far as it
+    std::optional<CAmount> weight;
+    bool staked{false};
+
+    explicit StakeOutcome(int64_t ms) : wait_ms{ms} {}
+
+    //! Try again no later than ms, for reason if that is sooner
+    void WaitAtMost(int64_t ms, StakeSleep sleep_reason)
+    {
+        if (ms < wait_ms) {
+            wait_ms = ms;
+            reason = sleep_reason;
+        }
+    }
+};
+} // namespace
+
+/** Try to stake a block with the coins of one wallet, at nSearchTime or soon after */
+static StakeOutcome StakeWallet(wallet::CWallet* pwallet, ChainstateManager* chainman, int nBestHeight, int64_t nTime, int64_t nSearchTime, int64_t cond_delay_ms, std::unique_ptr<node::CBlockTemplate>& pblocktemplate)
+{
+    StakeOutcome outcome{cond_delay_ms};
+    const int64_t nMask = nStakeTimestampMask;
+
+    if (!pwallet->fStakingEnabled) {
+        pwallet->m_is_staking = wallet::CWallet::NOT_STAKING_DISABLED;
+        return outcome;
+    }
+
+    const int64_t nLastSearchTime = pwallet->nLastCoinStakeSearchTime;
+    if (nSearchTime <= nLastSearchTime) {
+        // Sleep until the next timestamp left to search
+        int64_t nNextSearch = nLastSearchTime + 1;
+        outcome.WaitAtMost(std::max((int64_t)nMinerSleep, (nNextSearch - nTime) * 1000), StakeSleep::NEXT_KERNEL);
+        return outcome;
+    }
+
+    const int nStakeLimitHeight = pwallet->nStakeLimitHeight;
+    if (nStakeLimitHeight && nBestHeight >= nStakeLimitHeight) {
+        pwallet->m_is_staking = wallet::CWallet::NOT_STAKING_LIMITED;
+        outcome.WaitAtMost(30000, StakeSleep::STAKE_LIMIT);
+        return outcome;
+    }
+
+    if (pwallet->IsLocked()) {
+        // Unlocking wakes the thread
+        pwallet->m_is_staking = wallet::CWallet::NOT_STAKING_LOCKED;
+        return outcome;
+    }
+
+    CAmount balance = GetSpendableBalance(*pwallet);
+    outcome.weight = balance;
+
+    if (balance <= pwallet->nReserveBalance) {
+        pwallet->m_is_staking = wallet::CWallet::NOT_STAKING_BALANCE;
+        outcome.WaitAtMost(60000, StakeSleep::BALANCE);
+        pwallet->nLastCoinStakeSearchTime = nSearchTime + cond_delay_ms / 1000;
+        LogPrint(BCLog::POS, "%s: %s, low balance.\n", __func__, pwallet->GetName());
+        return outcome;
+    }
+
+    pwallet->m_is_staking = wallet::CWallet::IS_STAKING;
+    fIsStaking = true;
+
+    // Search this timestamp and the lookahead for a kernel before assembling a block,
+    // a new tip wakes the thread and resets the search
+    CBlockIndex* pindexPrev = chainman->ActiveChain().Tip();
+    StakeAttempt attempt{pwallet->GetName(), nBestHeight + 1, nSearchTime};
+    int64_t nKernelTime;
+    int64_t nNextStake = nSearchTime + (int64_t)(nStakeLookahead + 1) * (nMask + 1);
+    bool fKernel = FindStakeTime(pwallet, pindexPrev, nSearchTime, nStakeLookahead + 1, chainman->ActiveChainstate(), nKernelTime, attempt);
+    if (fKernel && nKernelTime == nSearchTime) {
+        // A template of an earlier attempt is only good on the tip it was made on
+        if (pblocktemplate && pblocktemplate->block.hashPrevBlock != pindexPrev->GetBlockHash()) {
+            pblocktemplate.reset();
+        }
+        if (!pblocktemplate.get()) {
+            StakeStageTimer timer{StakeStage::BLOCK_TEMPLATE};
+            CScript dummyScript;
+            if (node::g_block_template_cache) {
+                pblocktemplate = node::g_block_template_cache->CreateNewBlock(dummyScript, true);
+            } else {
+                pblocktemplate = node::BlockAssembler { chainman->ActiveChainstate(), chainman->ActiveChainstate().GetMempool() }.CreateNewBlock(dummyScript, true);
+            }
+            if (!pblocktemplate.get()) {
+                fIsStaking = false;
+                outcome.WaitAtMost(nMinerSleep, StakeSleep::BLOCK_TEMPLATE);
+                LogPrint(BCLog::POS, "%s: Couldn't create new block.\n", __func__);
+                attempt.result = "no block template";
+                g_stake_telemetry.AddAttempt(std::move(attempt));
+                return outcome;
+            }
+        }
+
+        CBlock* pblock = &pblocktemplate->block;
+        bool fSigned;
+        {
+            StakeStageTimer timer{StakeStage::SIGNING};
+            fSigned = SignBlock(*pblock, pindexPrev, pwallet, nBestHeight + 1, nSearchTime, chainman->ActiveChainstate());
+        }
+        if (fSigned) {
+            outcome.WaitAtMost(nMinerSleep, StakeSleep::STAKED);
+            if (CheckStake(*chainman, pblock)) {
+                nTimeLastStake = GetTime();
+                outcome.staked = true;
+                attempt.result = "staked";
+            } else {
+                attempt.result = "rejected";
+            }
+            g_stake_telemetry.AddAttempt(std::move(attempt));
+            // The signed template is spent either way
+            pblocktemplate.reset();
+            return outcome;
+        }
+        // The kernel's coin could not be staked, try again from the next timestamp
+        nNextStake = nSearchTime + nMask + 1;
+        attempt.result = "no coinstake";
+    } else if (fKernel) {
+        nNextStake = nKernelTime;
+        attempt.result = strprintf("kernel at %d", nKernelTime);
+    } else {
+        attempt.result = "no kernel";
+
+        int nRequiredDepth = std::min((int)COINBASE_MATURITY, (int)(nBestHeight / 2));
+
+        if (pwallet->m_greatest_txn_depth < nRequiredDepth - 4) {
+            // Wait for the blocks deepening the coins, which wake the thread, or for a coin coming of age
+            pwallet->m_is_staking = wallet::CWallet::NOT_STAKING_DEPTH;
+            int64_t nNextSearch = nSearchTime + cond_delay_ms / 1000;
+            if (const int64_t nNextCandidate = pwallet->m_stake_next_candidate_time) {
+                nNextSearch = std::min(nNextSearch, nNextCandidate);
+            }
+            pwallet->nLastCoinStakeSearchTime = std::max(nSearchTime, nNextSearch - 1);
+            outcome.WaitAtMost(std::max((int64_t)nMinerSleep, (nNextSearch - nTime) * 1000), StakeSleep::DEPTH);
+            LogPrint(BCLog::POS, "%s: %s, no outputs with required depth. Sleeping for %ds.\n", __func__, pwallet->GetName(), outcome.wait_ms / 1000);
+            attempt.result = "no outputs with required depth";
+            g_stake_telemetry.AddAttempt(std::move(attempt));
+            return outcome;
+        }
+    }
+
+    // Skip the timestamps without a kernel
+    if (const int64_t nNextCandidate = pwallet->m_stake_next_candidate_time) {
+        // A coin coming of age may find a kernel sooner
+        nNextStake = std::max(std::min(nNextStake, (nNextCandidate + nMask) & ~nMask), nSearchTime + nMask + 1);
+    }
+    pwallet->nLastCoinStakeSearchTime = nNextStake - 1;
+    outcome.WaitAtMost(std::max((int64_t)nMinerSleep, (nNextStake - nTime) * 1000), StakeSleep::NEXT_KERNEL);
+    g_stake_telemetry.AddAttempt(std::move(attempt));
+    return outcome;
+}
+
+void ThreadStakeMiner(size_t nThreadID, std::vector<std::shared_ptr<wallet::CWallet>>& vpwallets, ChainstateManager* chainman, CConnman* connman)
 {
     while (GetTime() - GetStartupTime() < 15) {
         UninterruptibleSleep(std::chrono::milliseconds { 150 });
         if (ShutdownRequested()) return;
     }
 
-    LogPrintf("Starting staking thread %d, %d wallet%s.\n", nThreadID, nEnd - nStart, (nEnd - nStart) > 1 ? "s" : "");
+    LogPrintf("Starting staking thread %d, sharing %d wallet%s.\n", nThreadID, vpwallets.size(), vpwallets.size() > 1 ? "s" : "");
 
-    int nBestHeight; // TODO: set from new block signal?
+    int nBestHeight;
     int64_t nBestTime;
+    uint256 hashBestTip;
 
     if (!gArgs.GetBoolArg("-staking", true)) {
         LogPrint(BCLog::POS, "%s: -staking is false.\n", __func__);
@@ -281,15 +763,17 @@ void ThreadStakeMiner(size_t nThreadID, std::vector<std::shared_ptr<wallet::CWal
     LogPrint(BCLog::POS, "Stake thread is %s peers.\n", stake_thread_ignore_peers ? "ignoring" : "not ignoring");
 
     while (!fStopMinerProc) {
+        g_stake_telemetry.LogSummary(GetTime());
+
         if (node::fReindex) {
             fIsStaking = false;
             LogPrint(BCLog::POS, "%s: Block import/reindex.\n", __func__);
-            condWaitFor(nThreadID, 30000);
+            condWaitFor(nThreadID, 30000, StakeSleep::REINDEX);
             continue;
         }
 
         if (!fStakerRunning) {
-            condWaitFor(nThreadID, 5000);
+            condWaitFor(nThreadID, 5000, StakeSleep::NOT_RUNNING);
             continue;
         }
 
@@ -298,13 +782,21 @@ void ThreadStakeMiner(size_t nThreadID, std::vector<std::shared_ptr<wallet::CWal
             LOCK(cs_main);
             nBestHeight = chainman->ActiveChain().Height();
             nBestTime = chainman->ActiveChain().Tip()->nTime;
+            hashBestTip = chainman->ActiveChain().Tip()->GetBlockHash();
             num_nodes = connman->GetNodeCount(ConnectionDirection::Both);
         }
 
+        // Timestamps skipped on the previous tip have to be searched again on this one
+        if (g_stake_scheduler.SetTip(hashBestTip)) {
+            for (const auto& pwallet : vpwallets) {
+                pwallet->nLastCoinStakeSearchTime = 0;
+            }
+        }
+
         if (is_mining_thread_active()) {
             fIsStaking = false;
             LogPrint(BCLog::POS, "%s: WaitingForMiningThread\n", __func__);
-            condWaitFor(nThreadID, 2000);
+            condWaitFor(nThreadID, 2000, StakeSleep::MINING_THREAD);
             continue;
         }
 
@@ -313,7 +805,7 @@ void ThreadStakeMiner(size_t nThreadID, std::vector<std::shared_ptr<wallet::CWal
             if (num_nodes < 3 || chainman->ActiveChainstate().IsInitialBlockDownload()) {
                 fIsStaking = false;
                 LogPrint(BCLog::POS, "%s: TryToSync\n", __func__);
-                condWaitFor(nThreadID, 30000);
+                condWaitFor(nThreadID, 30000, StakeSleep::SYNC);
                 continue;
             }
         }
@@ -322,13 +814,13 @@ void ThreadStakeMiner(size_t nThreadID, std::vector<std::shared_ptr<wallet::CWal
             fIsStaking = false;
             fTryToSync = true;
             LogPrint(BCLog::POS, "%s: IsInitialBlockDownload\n", __func__);
-            condWaitFor(nThreadID, 2000);
+            condWaitFor(nThreadID, 2000, StakeSleep::SYNC);
             continue;
         }
 
         if (nMinStakeInterval > 0 && nTimeLastStake + (int64_t)nMinStakeInterval > GetTime()) {
             LogPrint(BCLog::POS, "%s: Rate limited to 1 / %d seconds.\n", __func__, nMinStakeInterval);
-            condWaitFor(nThreadID, nMinStakeInterval * 500); // nMinStakeInterval / 2 seconds
+            condWaitFor(nThreadID, (nTimeLastStake + nMinStakeInterval - GetTime()) * 1000, StakeSleep::RATE_LIMITED);
             continue;
         }
 
@@ -338,98 +830,41 @@ void ThreadStakeMiner(size_t nThreadID, std::vector<std::shared_ptr<wallet::CWal
         if (nSearchTime <= nBestTime) {
             if (nTime < nBestTime) {
                 LogPrint(BCLog::POS, "%s: Can't stake before last block time.\n", __func__);
-                condWaitFor(nThreadID, std::min(1000 + (nBestTime - nTime) * 1000, (int64_t)30000));
+                condWaitFor(nThreadID, std::min(1000 + (nBestTime - nTime) * 1000, (int64_t)30000), StakeSleep::BLOCK_TIME);
                 continue;
             }
 
             int64_t nNextSearch = nSearchTime + nMask;
-            condWaitFor(nThreadID, std::min(nMinerSleep + (nNextSearch - nTime) * 1000, (int64_t)10000));
+            condWaitFor(nThreadID, std::min(nMinerSleep + (nNextSearch - nTime) * 1000, (int64_t)10000), StakeSleep::NEXT_TIMESTAMP);
             continue;
         }
 
         std::unique_ptr<node::CBlockTemplate> pblocktemplate;
+        g_stake_telemetry.AddCycle();
+
+        // Take the wallets due, until none is or the tip moves on
+        while (!fStopMinerProc) {
+            const auto start{SteadyClock::now()};
+            const std::optional<size_t> task{g_stake_scheduler.Next(start, nThreadID)};
+            if (!task) break;
+
+            const StakeOutcome outcome{StakeWallet(vpwallets.at(*task).get(), chainman, nBestHeight, nTime, nSearchTime, stake_thread_cond_delay_ms, pblocktemplate)};
+            const auto now{SteadyClock::now()};
+            g_stake_scheduler.Done(*task, now, now + std::chrono::milliseconds{outcome.wait_ms}, outcome.reason, outcome.weight, outcome.staked);
+            if (outcome.staked || WITH_LOCK(cs_main, return chainman->ActiveChain().Tip()->GetBlockHash()) != hashBestTip) break;
+        }
 
-        size_t nWaitFor = stake_thread_cond_delay_ms;
-        CAmount reserve_balance;
-
-        for (size_t i = nStart; i < nEnd; ++i) {
-            auto pwallet = vpwallets[i];
-
-            if (!pwallet->fStakingEnabled) {
-                pwallet->m_is_staking = wallet::CWallet::NOT_STAKING_DISABLED;
-                continue;
-            }
-
-            {
-                LOCK(pwallet->cs_wallet);
-                if (nSearchTime <= pwallet->nLastCoinStakeSearchTime) {
-                    nWaitFor = std::min(nWaitFor, (size_t)nMinerSleep);
-                    continue;
-                }
-
-                if (pwallet->nStakeLimitHeight && nBestHeight >= pwallet->nStakeLimitHeight) {
-                    pwallet->m_is_staking = wallet::CWallet::NOT_STAKING_LIMITED;
-                    nWaitFor = std::min(nWaitFor, (size_t)30000);
-                    continue;
-                }
-
-                if (pwallet->IsLocked()) {
-                    pwallet->m_is_staking = wallet::CWallet::NOT_STAKING_LOCKED;
-                    nWaitFor = std::min(nWaitFor, (size_t)30000);
-                    continue;
-                }
-                reserve_balance = pwallet->nReserveBalance;
-            }
-
-            CAmount balance = GetSpendableBalance(*pwallet);
-
-            if (balance <= reserve_balance) {
-                LOCK(pwallet->cs_wallet);
-                pwallet->m_is_staking = wallet::CWallet::NOT_STAKING_BALANCE;
-                nWaitFor = std::min(nWaitFor, (size_t)60000);
-                pwallet->nLastCoinStakeSearchTime = nSearchTime + stake_thread_cond_delay_ms / 1000;
-                LogPrint(BCLog::POS, "%s: %s, low balance.\n", __func__, pwallet->GetName());
-                continue;
-            }
-
-            if (!pblocktemplate.get()) {
-                CScript dummyScript;
-                pblocktemplate = node::BlockAssembler { chainman->ActiveChainstate(), chainman->ActiveChainstate().GetMempool() }.CreateNewBlock(dummyScript, true);
-                if (!pblocktemplate.get()) {
-                    fIsStaking = false;
-                    nWaitFor = std::min(nWaitFor, (size_t)nMinerSleep);
-                    LogPrint(BCLog::POS, "%s: Couldn't create new block.\n", __func__);
-                    continue;
-                }
-            }
-
-            pwallet->m_is_staking = wallet::CWallet::IS_STAKING;
-
-            nWaitFor = nMinerSleep;
-            fIsStaking = true;
-            CBlock* pblock = &pblocktemplate->block;
-
-            if (SignBlock(*pblock, chainman->ActiveChain().Tip(), pwallet.get(), nBestHeight + 1, nSearchTime, chainman->ActiveChainstate())) {
-                if (CheckStake(*chainman, pblock)) {
-                    nTimeLastStake = GetTime();
-                    break;
-                }
-            } else {
-                int nRequiredDepth = std::min((int)COINBASE_MATURITY, (int)(nBestHeight / 2));
-
-                LOCK(pwallet->cs_wallet);
-                if (pwallet->m_greatest_txn_depth < nRequiredDepth - 4) {
-                    pwallet->m_is_staking = wallet::CWallet::NOT_STAKING_DEPTH;
-                    size_t nSleep = (nRequiredDepth - pwallet->m_greatest_txn_depth) / 4;
-                    nWaitFor = std::min(nWaitFor, (size_t)(nSleep * 1000));
-                    pwallet->nLastCoinStakeSearchTime = nSearchTime + nSleep;
-                    LogPrint(BCLog::POS, "%s: %s, no outputs with required depth. Sleeping for %ds.\n", __func__, pwallet->GetName(), nSleep);
-                    continue;
-                }
+        // Sleep until the next wallet is due
+        int64_t nWaitFor = stake_thread_cond_delay_ms;
+        StakeSleep sleep_reason = StakeSleep::IDLE;
+        if (const auto next{g_stake_scheduler.NextDue()}) {
+            const int64_t due_ms{Ticks<std::chrono::milliseconds>(next->first - SteadyClock::now())};
+            if (due_ms < nWaitFor) {
+                nWaitFor = std::max(due_ms, (int64_t)0);
+                sleep_reason = next->second;
             }
         }
-
-        condWaitFor(nThreadID, nWaitFor);
+        condWaitFor(nThreadID, nWaitFor, sleep_reason);
     }
 }
 
@@ -439,67 +874,43 @@ bool SelectCoinsForStaking(wallet::CWallet* wallet, CAmount nTargetValue, std::s
 
     // fetch suitable coins
     std::vector<wallet::COutput> vCoins;
-    {
-        LOCK(wallet->cs_wallet);
-        auto res = wallet::AvailableCoins(*wallet);
-        for (auto entry : res.All()) {
-            vCoins.push_back(entry);
-        }
+    int64_t nNextCandidateTime = 0;
+    WITH_LOCK(wallet->cs_wallet, vCoins = wallet::AvailableStakeCoins(*wallet, GetTime(), params.nStakeMinAge, params.nStakeMaxAge, &nNextCandidateTime));
+    int nGreatestDepth = 0;
+    for (const auto& output : vCoins) {
+        nGreatestDepth = std::max(nGreatestDepth, output.depth);
     }
+    wallet->m_stake_next_candidate_time = nNextCandidateTime;
+    wallet->m_greatest_txn_depth = nGreatestDepth;
 
     setCoinsRet.clear();
     nValueRet = 0;
 
     for (const auto& output : vCoins) {
         const auto& txout = output.txout;
-        int input_age = GetTime() - output.time;
-        if (input_age < params.nStakeMinAge || input_age > params.nStakeMaxAge) {
-
-LogPrint (BCLog::ALL, "\n");
-LogPrint (BCLog::ALL, "GetTime() %ld \n", GetTime());
-LogPrint (BCLog::ALL, "output.time %ld \n", output.time);
-LogPrint (BCLog::ALL, "input_age %ld \n", input_age);
-LogPrint (BCLog::ALL, "params.nStakeMinAge %ld \n", params.nStakeMinAge);
-LogPrint (BCLog::ALL, "params.nStakeMaxAge %ld \n", params.nStakeMaxAge);
-LogPrint (BCLog::ALL, "\n");
-
-            LogPrint(BCLog::POS, "not using %s: age params not met\n", txout.ToString());
-            continue;
-        } else {
-
-LogPrint (BCLog::ALL, "\n");
-LogPrint (BCLog::ALL, "DKDK FJFJ DKDK\n");
-LogPrint (BCLog::ALL, "\n");
 
+        // Stop if we've chosen enough inputs
+        if (nValueRet >= nTargetValue) {
+            break;
         }
 
+        CAmount n = output.txout.nValue;
+        std::pair<int64_t, std::pair<const wallet::CWalletTx*, unsigned int>> coin;
         {
+            // Once per coin, so that the wallet's notifications get in between
             LOCK(wallet->cs_wallet);
             COutPoint kernel(output.outpoint);
             if (!CheckStakeUnused(kernel) || wallet->IsLockedCoin(kernel)) {
-                LogPrint(BCLog::POS, "not using %s: already used or coin is locked\n", txout.ToString());
+                LogPrintEvery(BCLog::POS, LOG_EVERY_DEFAULT, "not using %s: already used or coin is locked\n", txout.ToString());
                 continue;
             }
-        }
 
-        {
-            LOCK(wallet->cs_wallet);
             wallet::isminetype mine = wallet->IsMine(txout);
             if (!(mine & wallet::ISMINE_SPENDABLE)) {
-                LogPrint(BCLog::POS, "not using %s: isnt mine/not spendable\n", txout.ToString());
+                LogPrintEvery(BCLog::POS, LOG_EVERY_DEFAULT, "not using %s: isnt mine/not spendable\n", txout.ToString());
                 continue;
             }
-        }
-
-        // Stop if we've chosen enough inputs
-        if (nValueRet >= nTargetValue) {
-            break;
-        }
 
-        CAmount n = output.txout.nValue;
-        std::pair<int64_t, std::pair<const wallet::CWalletTx*, unsigned int>> coin;
-        {
-            LOCK(wallet->cs_wallet);
             const wallet::CWalletTx* wtx = wallet->GetWalletTx(output.outpoint.hash);
             coin = std::make_pair(n, std::make_pair(wtx, output.outpoint.n));
         }
@@ -533,6 +944,7 @@ bool CreateCoinStake (  wallet::CWallet* wallet,
 
     arith_uint256 bnTargetPerCoinDay;
     bnTargetPerCoinDay.SetCompact(nBits);
+    const wallet::StakeOutputPolicy policy{WITH_LOCK(wallet->cs_wallet, return wallet->m_stake_policy)};
     CAmount nBalance = GetSpendableBalance(*wallet);
     if (nBalance <= wallet->nReserveBalance) {
         return false;
@@ -552,12 +964,10 @@ bool CreateCoinStake (  wallet::CWallet* wallet,
     std::vector<const wallet::CWalletTx*> vwtxPrev;
     std::set<std::pair<const wallet::CWalletTx*, unsigned int>> setCoins;
     if (!SelectCoinsForStaking(wallet, nBalance - wallet->nReserveBalance, setCoins, nValueIn)) {
-        UninterruptibleSleep(std::chrono::milliseconds { 150 });
         return false;
     }
 
     if (setCoins.empty()) {
-        UninterruptibleSleep(std::chrono::milliseconds { 150 });
         return false;
     }
 
@@ -593,15 +1003,17 @@ bool CreateCoinStake (  wallet::CWallet* wallet,
 
             LogPrint(BCLog::POS, "%s: parsed kernel type=%s\n", __func__, GetTxnOutputType(whichType));
 
+            // The keys of whichever ScriptPubKeyMan watches the kernel, legacy or descriptor
+            const std::unique_ptr<SigningProvider> provider{wallet->GetSigningProvider(scriptPubKeyKernel)};
+            if (!provider) {
+                LogPrint(BCLog::POS, "%s: failed to get signing provider for kernel type=%s\n", __func__, GetTxnOutputType(whichType));
+                return false;
+            }
+
             if (whichType == TxoutType::PUBKEYHASH || whichType == TxoutType::WITNESS_V0_KEYHASH)
             {
                 uint160 hash160(vSolutions[0]);
-                auto spk_man = wallet->GetLegacyScriptPubKeyMan();
-                if (!spk_man) {
-                    LogPrint(BCLog::POS, "%s: failed to get legacyscriptpubkeyman\n", __func__);
-                    return false;
-                }
-                if (!spk_man->GetKey(CKeyID(hash160), key)) {
+                if (!provider->GetKey(CKeyID(hash160), key)) {
                     LogPrint(BCLog::POS, "%s: failed to get key for kernel type=%d\n", __func__, GetTxnOutputType(whichType));
                     return false;
                 }
@@ -612,18 +1024,13 @@ bool CreateCoinStake (  wallet::CWallet* wallet,
             else if (whichType == TxoutType::SCRIPTHASH)
             {
                 uint160 hash160(vSolutions[0]);
-                auto spk_man = wallet->GetLegacyScriptPubKeyMan();
-                if (!spk_man) {
-                    LogPrint(BCLog::POS, "%s: failed to get legacyscriptpubkeyman\n", __func__);
-                    return false;
-                }
                 CKeyID keyID;
                 CScript script;
                 CTxDestination inner_dest;
                 CScriptID scriptID(hash160);
-                if (spk_man->GetCScript(scriptID, script) && ExtractDestination(script, inner_dest)) {
-                    keyID = GetKeyForDestination(*spk_man, inner_dest);
-                    if (!spk_man->GetKey(keyID, key)) {
+                if (provider->GetCScript(scriptID, script) && ExtractDestination(script, inner_dest)) {
+                    keyID = GetKeyForDestination(*provider, inner_dest);
+                    if (!provider->GetKey(keyID, key)) {
                         LogPrint(BCLog::POS, "%s: failed to get key for kernel type=%d\n", __func__, GetTxnOutputType(whichType));
                         return false;
                     }
@@ -634,12 +1041,7 @@ bool CreateCoinStake (  wallet::CWallet* wallet,
                 valtype& vchPubKey = vSolutions[0];
                 CPubKey pubKey(vchPubKey);
                 uint160 hash160(Hash160(vchPubKey));
-                auto spk_man = wallet->GetLegacyScriptPubKeyMan();
-                if (!spk_man) {
-                    LogPrint(BCLog::POS, "%s: failed to get legacyscriptpubkeyman\n", __func__);
-                    return false;
-                }
-                if (!spk_man->GetKey(CKeyID(hash160), key)) {
+                if (!provider->GetKey(CKeyID(hash160), key)) {
                     LogPrint(BCLog::POS, "%s: failed to get key for kernel type=%d\n", __func__, GetTxnOutputType(whichType));
                     return false;
                 }
@@ -659,6 +1061,12 @@ bool CreateCoinStake (  wallet::CWallet* wallet,
                 return false;
             }
 
+            // The coinstake pays to the kernel's key, which the wallet must watch to be credited with it
+            if (wallet->IsMine(scriptPubKeyOut) != wallet::ISMINE_SPENDABLE) {
+                LogPrint(BCLog::POS, "%s: wallet does not watch pay-to-pubkey of the kernel key, skipping\n", __func__);
+                continue;
+            }
+
 
             txNew.vin.push_back(CTxIn(pcoin.first->GetHash(), pcoin.second));
             nCredit += pcoin.first->tx->vout[pcoin.second].nValue;
@@ -682,7 +1090,7 @@ bool CreateCoinStake (  wallet::CWallet* wallet,
     size_t nStakesCombined = 0;
     it = setCoins.begin();
     while (it != setCoins.end()) {
-        if (nStakesCombined >= wallet->nMaxStakeCombine) {
+        if (nStakesCombined >= policy.max_combine) {
             break;
         }
 
@@ -691,8 +1099,8 @@ bool CreateCoinStake (  wallet::CWallet* wallet,
             break;
         }
 
-        // Stop adding more inputs if value is already pretty significant
-        if (nCredit >= wallet->nStakeCombineThreshold) {
+        // Stop adding more inputs once the output reaches the size aimed for
+        if (nCredit >= policy.target_size) {
             break;
         }
 
@@ -711,7 +1119,7 @@ bool CreateCoinStake (  wallet::CWallet* wallet,
         }
 
         // Do not add additional significant input
-        if (prevOut.nValue >= wallet->nStakeCombineThreshold) {
+        if (prevOut.nValue >= policy.combine_threshold) {
             continue;
         }
 
@@ -733,21 +1141,12 @@ bool CreateCoinStake (  wallet::CWallet* wallet,
     }
 
     nCredit += nReward;
-    {
-
-        if (nCredit >= wallet->nStakeSplitThreshold) {
-            txNew.vout.push_back(CTxOut(0, txNew.vout[1].scriptPubKey));
-        }
-
-        // Set output amount
-        if (txNew.vout.size() == 3) {
-            txNew.vout[1].nValue = (nCredit / 2 / CENT) * CENT;
-            txNew.vout[2].nValue = nCredit - txNew.vout[1].nValue;
 
-        } else {
-            txNew.vout[1].nValue = nCredit;
-
-        }
+    // Set output amounts, splitting outputs well over the target size
+    const std::vector<CAmount> amounts{policy.SplitCredit(nCredit)};
+    txNew.vout[1].nValue = amounts[0];
+    for (size_t i = 1; i < amounts.size(); ++i) {
+        txNew.vout.push_back(CTxOut(amounts[i], txNew.vout[1].scriptPubKey));
     }
 
     // Sign
@@ -759,7 +1158,8 @@ bool CreateCoinStake (  wallet::CWallet* wallet,
         CScript& scriptPubKeyOut = prevOut.scriptPubKey;
 
         SignatureData sigdata;
-        if (!ProduceSignature(*wallet->GetLegacyScriptPubKeyMan(), MutableTransactionSignatureCreator(txNew, nIn, amount, SIGHASH_ALL), scriptPubKeyOut, sigdata)) {
+        const std::unique_ptr<SigningProvider> provider{WITH_LOCK(wallet->cs_wallet, return wallet->GetSigningProvider(scriptPubKeyOut))};
+        if (!provider || !ProduceSignature(*provider, MutableTransactionSignatureCreator(txNew, nIn, amount, SIGHASH_ALL), scriptPubKeyOut, sigdata)) {
             return error("%s: ProduceSignature failed.", __func__);
         }
 
@@ -6,16 +6,26 @@
 #define PARTICL_POS_MINER_H
 
 #include <primitives/transaction.h>
+#include <sync.h>
+#include <uint256.h>
 #include <util/threadinterrupt.h>
+#include <util/time.h>
 #include <thread>
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace wallet {
 struct WalletContext;
 class CWallet;
+class CWalletTx;
 } // namespace wallet
 
 class Chainstate;
@@ -43,6 +53,170 @@ extern std::atomic<bool> fTryToSync;
 
 extern int nMinStakeInterval;
 extern int nMinerSleep;
+extern int nStakeLookahead;
+extern int nStakeWorkers;
+
+//! Default for -stakingthreads, never more than the wallets
+static const int DEFAULT_STAKING_THREADS = 1;
+//! Default for -stakelookahead, coinstake timestamps searched ahead once no kernel is found
+static const int DEFAULT_STAKE_LOOKAHEAD = 16;
+//! Default for -stakeworkers, threads a stake thread shares the kernel search of a large wallet with
+static const int DEFAULT_STAKE_WORKERS = 4;
+
+//! Stake attempts kept for getstakinginfo
+static const size_t STAKE_ATTEMPTS_KEPT = 20;
+//! Seconds between the -debug=pos summaries of the stake telemetry
+static const int64_t STAKE_SUMMARY_INTERVAL = 10 * 60;
+
+/** Stages of a stake cycle timed by the stake telemetry */
+enum class StakeStage {
+    COIN_SELECTION,
+    KERNEL_SEARCH,
+    BLOCK_TEMPLATE,
+    SIGNING,
+};
+static constexpr size_t NUM_STAKE_STAGES = 4;
+
+/** Reasons for the stake threads to sleep */
+enum class StakeSleep {
+    REINDEX,
+    NOT_RUNNING,
+    MINING_THREAD,
+    SYNC,
+    RATE_LIMITED,
+    BLOCK_TIME,
+    IDLE,
+    NEXT_TIMESTAMP,
+    NEXT_KERNEL,
+    STAKE_LIMIT,
+    BALANCE,
+    DEPTH,
+    BLOCK_TEMPLATE,
+    STAKED,
+};
+static constexpr size_t NUM_STAKE_SLEEPS = 14;
+
+std::string StakeStageName(StakeStage stage);
+std::string StakeSleepName(StakeSleep reason);
+
+/** Search of the coins of one wallet for a kernel by a stake thread */
+struct StakeAttempt {
+    std::string wallet;
+    //! Height of the block that would be staked
+    int height{0};
+    //! First coinstake timestamp searched
+    int64_t search_time{0};
+    //! Coins searched
+    size_t candidates{0};
+    //! Kernel hashes of the search, at most, as the coins times the timestamps searched
+    uint64_t kernel_hashes{0};
+    //! Outcome, set once the attempt ends
+    std::string result{};
+};
+
+/** Totals of the stake threads since startup */
+struct StakeStats {
+    uint64_t cycles{0};
+    std::array<uint64_t, NUM_STAKE_STAGES> stage_count{};
+    std::array<std::chrono::microseconds, NUM_STAKE_STAGES> stage_time{};
+    uint64_t kernel_hashes{0};
+    uint64_t staked{0};
+    std::array<uint64_t, NUM_STAKE_SLEEPS> sleep_count{};
+    std::array<std::chrono::milliseconds, NUM_STAKE_SLEEPS> sleep_time{};
+    //! Most recent attempts, the latest last
+    std::deque<StakeAttempt> attempts;
+};
+
+/**
+ * Instrumentation of the stake threads, shown by getstakinginfo
+ * and summarised periodically with -debug=pos
+ */
+class StakeTelemetry
+{
+public:
+    void AddCycle() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void AddStageTime(StakeStage stage, std::chrono::microseconds time) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void AddSleep(StakeSleep reason, std::chrono::milliseconds time) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void AddAttempt(StakeAttempt attempt) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    StakeStats GetStats() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Log a summary with -debug=pos, at most once per STAKE_SUMMARY_INTERVAL */
+    void LogSummary(int64_t now) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    mutable Mutex m_mutex;
+    StakeStats m_stats GUARDED_BY(m_mutex);
+    int64_t m_last_summary GUARDED_BY(m_mutex){0};
+};
+
+extern StakeTelemetry g_stake_telemetry;
+
+/** Scheduling of the stake attempts of one wallet, shown by getstakinginfo */
+struct StakeTaskStats {
+    std::string wallet;
+    //! Spendable balance at the last attempt, which orders the wallets due together
+    CAmount weight{0};
+    //! Time until the wallet is due, negative once it is overdue
+    std::chrono::milliseconds due_in{0};
+    //! Why the wallet waits until then
+    StakeSleep reason{StakeSleep::IDLE};
+    bool running{false};
+    uint64_t attempts{0};
+    uint64_t staked{0};
+    //! Total time of the attempts
+    std::chrono::microseconds busy_time{0};
+    //! Total time the attempts started behind their due time
+    std::chrono::microseconds delay{0};
+    //! Stake thread of the last attempt, -1 before the first
+    int thread{-1};
+};
+
+/**
+ * Shares the wallets out among the stake threads. Each wallet's attempt to
+ * stake is a task, due at the time its last attempt asked to be tried again,
+ * and a thread free to run one takes the due wallet of the greatest weight.
+ * A slow wallet so only holds up the thread running it, the others take the
+ * wallets due meanwhile.
+ */
+class StakeScheduler
+{
+public:
+    /** Forget the wallets, before the stake threads start */
+    void Clear() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Add a wallet, due at once. Returns its task */
+    size_t Add(const std::string& wallet) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Take the task due by now of the greatest weight, the earliest due of those first */
+    std::optional<size_t> Next(SteadyClock::time_point now, int thread) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Hand back a task taken by Next, due again at due. The weight is kept if not given */
+    void Done(size_t task, SteadyClock::time_point now, SteadyClock::time_point due, StakeSleep reason, std::optional<CAmount> weight, bool staked) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** The earliest due time of the tasks not running and why, if there is one */
+    std::optional<std::pair<SteadyClock::time_point, StakeSleep>> NextDue() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Make a wallet due at once. Returns false if it is not staking */
+    bool Wake(const std::string& wallet) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void WakeAll() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Note the tip searched. Returns true, making every wallet due, once per new tip */
+    bool SetTip(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    std::vector<StakeTaskStats> GetStats(SteadyClock::time_point now) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Task {
+        StakeTaskStats stats;
+        SteadyClock::time_point due;
+        SteadyClock::time_point started;
+        //! Woken while running
+        bool woken{false};
+    };
+
+    mutable Mutex m_mutex;
+    std::vector<Task> m_tasks GUARDED_BY(m_mutex);
+    uint256 m_tip GUARDED_BY(m_mutex);
+};
+
+extern StakeScheduler g_stake_scheduler;
 
 void set_mining_thread_active();
 void set_mining_thread_inactive();
@@ -59,7 +233,10 @@ void WakeThreadStakeMiner(wallet::CWallet* pwallet);
 void WakeAllThreadStakeMiner();
 bool ThreadStakeMinerStopped();
 
-void ThreadStakeMiner(size_t nThreadID, std::vector<std::shared_ptr<wallet::CWallet>>& vpwallets, size_t nStart, size_t nEnd, ChainstateManager* chainman, CConnman* connman);
+void ThreadStakeMiner(size_t nThreadID, std::vector<std::shared_ptr<wallet::CWallet>>& vpwallets, ChainstateManager* chainman, CConnman* connman);
+bool SelectCoinsForStaking(wallet::CWallet* wallet, CAmount nTargetValue, std::set<std::pair<const wallet::CWalletTx*, unsigned int>>& setCoinsRet, CAmount& nValueRet);
 bool CreateCoinStake(wallet::CWallet* wallet, CBlockIndex* pindexPrev, unsigned int nBits, int64_t nTime, int nBlockHeight, int64_t nFees, CMutableTransaction& txNew, CKey& key, Chainstate& chain_state);
+/** Sign the hash of a block staked with the key of its coinstake */
+bool SignBlockWithKey(CBlock& block, const CKey& key);
 
 #endif // PARTICL_POS_MINER_H
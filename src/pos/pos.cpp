@@ -9,19 +9,49 @@
 #include <chainparams.h>
 #include <coins.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
+#include <cuckoocache.h>
 #include <hash.h>
+#include <memusage.h>
 #include <node/transaction.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <script/interpreter.h>
 #include <script/script.h>
 #include <serialize.h>
 #include <streams.h>
 #include <txmempool.h>
+#include <util/hasher.h>
 #include <util/system.h>
 #include <validation.h>
 
-std::list<COutPoint> listStakeSeen;
-std::map<COutPoint, uint256> mapStakeSeen;
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <optional>
+
+StakeSeenSet g_stake_seen{MAX_STAKE_SEEN};
+
+//! Coinstakes whose kernel input script was verified, by prevblock, coinstake, nTime and nBits
+static CuckooCache::cache<uint256, SignatureCacheHasher> g_stake_kernel_cache GUARDED_BY(cs_main);
+static CSHA256 g_stake_kernel_cache_hasher;
+
+bool InitStakeKernelCache(size_t max_size_bytes)
+{
+    LOCK(cs_main);
+    // Salted like the script execution cache, with 64 bytes of nonce
+    uint256 nonce = GetRandHash();
+    g_stake_kernel_cache_hasher.Write(nonce.begin(), 32);
+    g_stake_kernel_cache_hasher.Write(nonce.begin(), 32);
+
+    auto setup_results = g_stake_kernel_cache.setup_bytes(max_size_bytes);
+    if (!setup_results) return false;
+
+    const auto [num_elems, approx_size_bytes] = *setup_results;
+    LogPrintf("Using %zu KiB out of %zu KiB requested for stake kernel cache, able to store %zu elements\n",
+              approx_size_bytes >> 10, max_size_bytes >> 10, num_elems);
+    return true;
+}
 
 /* Calculate the difficulty for a given block index.
  * Duplicated from rpc/blockchain.cpp for linking
@@ -45,19 +75,14 @@ static double GetDifficulty(const CBlockIndex* blockindex)
     return dDiff;
 }
 
-double GetPoSKernelPS(CBlockIndex* pindex)
+double GetPoSKernelPS(const CBlockIndex* pindex)
 {
-    LOCK(cs_main);
-
-    CBlockIndex* pindexPrevStake = nullptr;
+    const CBlockIndex* pindexPrevStake = nullptr;
 
-    int nBestHeight = pindex->nHeight;
-
-    int nPoSInterval = 72; // blocks sampled
     double dStakeKernelsTriedAvg = 0;
     int nStakesHandled = 0, nStakesTime = 0;
 
-    while (pindex && nStakesHandled < nPoSInterval) {
+    while (pindex && nStakesHandled < POS_KERNEL_PS_INTERVAL) {
         if (pindex->IsProofOfStake()) {
             if (pindexPrevStake) {
                 dStakeKernelsTriedAvg += GetDifficulty(pindexPrevStake) * 4294967296.0;
@@ -80,6 +105,60 @@ double GetPoSKernelPS(CBlockIndex* pindex)
     return result;
 }
 
+void StakeKernelRate::SetTip(const CBlockIndex* tip)
+{
+    if (tip == m_tip) return;
+    if (!tip || !m_tip) {
+        Reset(tip);
+    } else if (tip->pprev == m_tip) {
+        // Connected
+        if (tip->IsProofOfStake()) {
+            m_stakes.push_back(tip);
+            if (m_stakes.size() > POS_KERNEL_PS_INTERVAL + 1) m_stakes.pop_front();
+        }
+    } else if (m_tip->pprev == tip) {
+        // Disconnected, the stake before the window coming back in as the last one drops out,
+        // if the window did not already reach back to the first stake
+        if (m_tip->IsProofOfStake()) {
+            const bool full{m_stakes.size() == POS_KERNEL_PS_INTERVAL + 1};
+            m_stakes.pop_back();
+            if (full) {
+                const CBlockIndex* pindex = m_stakes.front()->pprev;
+                while (pindex && !pindex->IsProofOfStake()) pindex = pindex->pprev;
+                if (pindex) m_stakes.push_front(pindex);
+            }
+        }
+    } else {
+        Reset(tip);
+        return;
+    }
+    m_tip = tip;
+    Update();
+}
+
+void StakeKernelRate::Reset(const CBlockIndex* tip)
+{
+    m_tip = tip;
+    m_stakes.clear();
+    for (const CBlockIndex* pindex = tip; pindex && m_stakes.size() < POS_KERNEL_PS_INTERVAL + 1; pindex = pindex->pprev) {
+        if (pindex->IsProofOfStake()) m_stakes.push_front(pindex);
+    }
+    Update();
+}
+
+void StakeKernelRate::Update()
+{
+    // Summed afresh each time, rather than kept as running sums that drift as
+    // stakes are added and taken away
+    double kernels = 0;
+    int64_t time = 0;
+    for (size_t i = 1; i < m_stakes.size(); ++i) {
+        kernels += GetDifficulty(m_stakes[i]) * 4294967296.0;
+        time += int64_t{m_stakes[i]->nTime} - m_stakes[i - 1]->nTime;
+    }
+    m_kernels_per_second = time ? kernels / time * (nStakeTimestampMask + 1) : 0;
+}
+
 /**
  * Stake Modifier (hash modifier of proof-of-stake):
  * The purpose of stake modifier is to prevent a txout (coin) owner from
@@ -97,6 +176,54 @@ uint256 ComputeStakeModifier(const CBlockIndex* pindexPrev, const uint256& kerne
     return Hash(ss);
 }
 
+bool GetWeightedStakeTarget(uint32_t nBits, CAmount prevOutAmount, arith_uint256& bnTarget)
+{
+    bool fNegative;
+    bool fOverflow;
+    bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
+    if (fNegative || fOverflow || bnTarget == 0) {
+        return false;
+    }
+    // The target is multiplied by the stake weight (coin amount)
+    bnTarget *= arith_uint256(prevOutAmount);
+    return true;
+}
+
+/**
+ * The kernel hash is the double SHA256 of
+ *     nStakeModifier + nBlockFromTime + prevout.hash + prevout.n + nTime
+ * serialized as CDataStream does, so every field but nTime goes in the midstate
+ */
+StakeKernel::StakeKernel(const uint256& nStakeModifier, uint32_t nBlockFromTime, const COutPoint& prevout, const arith_uint256& bnTarget)
+    : m_target(bnTarget)
+{
+    unsigned char buf[4];
+    m_prefix.Write(nStakeModifier.begin(), nStakeModifier.size());
+    WriteLE32(buf, nBlockFromTime);
+    m_prefix.Write(buf, sizeof(buf));
+    m_prefix.Write(prevout.hash.begin(), prevout.hash.size());
+    WriteLE32(buf, prevout.n);
+    m_prefix.Write(buf, sizeof(buf));
+}
+
+uint256 StakeKernel::GetHash(uint32_t nTime) const
+{
+    unsigned char buf[CSHA256::OUTPUT_SIZE];
+    WriteLE32(buf, nTime);
+    CSHA256 sha(m_prefix);
+    sha.Write(buf, 4).Finalize(buf);
+
+    uint256 hash;
+    CSHA256().Write(buf, sizeof(buf)).Finalize(hash.begin());
+    return hash;
+}
+
+bool StakeKernel::Check(uint32_t nTime, uint256& hashProofOfStake) const
+{
+    hashProofOfStake = GetHash(nTime);
+    return UintToArith256(hashProofOfStake) <= m_target;
+}
+
 /**
  * BlackCoin Proof-of-Stake Kernel Validation
  * 
@@ -144,48 +271,27 @@ bool CheckStakeKernelHash(
         return error("%s: nTime violation", __func__);
     }
 
-    // 2. Calculate target difficulty
+    // 2. Calculate target difficulty, weighted by stake amount
+    // Larger stakes = larger target = higher chance of successful stake
     arith_uint256 bnTarget;
-    bool fNegative;
-    bool fOverflow;
-
-    // Convert compact bits representation to full 256-bit target
-    bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
-    if (fNegative || fOverflow || bnTarget == 0) {
+    if (!GetWeightedStakeTarget(nBits, prevOutAmount, bnTarget)) {
         // Ensure target is valid (positive, not overflowed, non-zero)
         return error("%s: SetCompact failed.", __func__);
     }
 
-    // 3. Weight target by stake amount
-    int64_t nValueIn = prevOutAmount;
-    arith_uint256 bnWeight = arith_uint256(nValueIn);
-    // The target is multiplied by the stake weight (coin amount)
-    // This implements the core proof-of-stake principle:
-    // - Larger stakes = larger target = higher chance of successful stake
-    // - Probability is directly proportional to stake size
-    bnTarget *= bnWeight;
-
     // Store weighted target for output
     targetProofOfStake = ArithToUint256(bnTarget);
 
-    // 4. Get stake modifier from previous block
+    // 3. Get stake modifier from previous block
     const uint256& nStakeModifier = pindexPrev->nStakeModifier;
     int nStakeModifierHeight = pindexPrev->nHeight;
     int64_t nStakeModifierTime = pindexPrev->nTime;
 
-    // 5. Build data stream for hash calculation
-    CDataStream ss(SER_GETHASH, 0);
-    // Combine inputs to create a unique, unpredictable stake hash
-    // Order matters! This matches the protocol specification:
-    ss << nStakeModifier;              // Changes each block - prevents precomputation
-    ss << nBlockFromTime               // Previous block time - time ordering
-       << prevout.hash                 // Unique transaction ID - prevents duplicates
-       << prevout.n                    // Output index - adds uniqueness
-       << nTime;                       // Current time - ensures freshness
-    // Final hash must be below weighted target to be valid
-    hashProofOfStake = Hash(ss);
-
-    // 6. Debug logging if enabled
+    // 4. Hash the kernel, must be below weighted target to be valid
+    const StakeKernel kernel(nStakeModifier, nBlockFromTime, prevout, bnTarget);
+    const bool fValid = kernel.Check(nTime, hashProofOfStake);
+
+    // 5. Debug logging if enabled
     if (fPrintProofOfStake) {
         // Log stake modifier details and hash computation inputs
         LogPrintf("%s: using modifier=%s at height=%d timestamp=%s\n",
@@ -197,18 +303,13 @@ bool CheckStakeKernelHash(
             hashProofOfStake.ToString());
     }
 
-    // 7. Final proof-of-stake validation
-    // Convert hash to integer and compare against weighted target
-    // This check implements the core staking formula:
-    // hash < target * weight
-    // The larger your stake (weight), the larger the target,
-    // making it more likely for a hash to be valid
-    if (UintToArith256(hashProofOfStake) > bnTarget) {
+    // 6. Final proof-of-stake validation
+    if (!fValid) {
         LogPrint (BCLog::POS, "Hash exceeds target - stake attempt invalid \n");
         return false;  // Hash exceeds target - stake attempt invalid
     }
 
-    // 8. Additional debug logging
+    // 7. Additional debug logging
     if (LogAcceptCategory(BCLog::POS, BCLog::Level::Debug) && !fPrintProofOfStake) {
         // Log successful validation details
         LogPrintf("%s: using modifier=%s at height=%d timestamp=%s\n",
@@ -247,7 +348,8 @@ bool CheckProofOfStake(
     int64_t nTime,                    // Timestamp of the new block being validated
     unsigned int nBits,               // Target difficulty for the block
     uint256& hashProofOfStake,        // Output parameter: Will contain the computed stake hash
-    uint256& targetProofOfStake)      // Output parameter: Will contain the target threshold
+    uint256& targetProofOfStake,      // Output parameter: Will contain the target threshold
+    std::vector<CStakeSignatureCheck>* pvChecks) // Optional: Receives the signature check instead of running it
 {
     // pindexPrev points to the latest block in our chain
     // nTime represents when the new block was created
@@ -272,7 +374,6 @@ bool CheckProofOfStake(
     // Variables to store information about the staking coin
     uint32_t nBlockFromTime;    // Timestamp of block containing the staked coin
     int nDepth;                 // How many blocks deep is the staked coin
-    CScript kernelPubKey;       // Public key script that controls the stake
     CAmount amount;             // Amount of coins being staked
 
     // Try to find the coin being staked in the UTXO (unspent transaction output) set
@@ -296,20 +397,31 @@ bool CheckProofOfStake(
     }
 
     // Store the staking coin's details for validation
-    kernelPubKey = coin.out.scriptPubKey;      // Script controlling the coins
     amount = coin.out.nValue;                   // Amount being staked
     nBlockFromTime = pindex->GetBlockTime();    // When the coin's block was mined
 
-    // Get the spending transaction's signature details
-    const CScript& scriptSig = txin.scriptSig;
-    const CScriptWitness* witness = &txin.scriptWitness;
-    ScriptError serror = SCRIPT_ERR_OK;
-    std::vector<uint8_t> vchAmount(8);
-
-    // Verify the transaction signature is valid and the spender owns the coins
-    if (!VerifyScript(scriptSig, kernelPubKey, witness, STANDARD_SCRIPT_VERIFY_FLAGS, TransactionSignatureChecker(&tx, 0, amount, MissingDataBehavior::FAIL), &serror)) {
-        LogPrintf("ERROR: %s: verify-script-failed, txn %s, reason %s\n", __func__, tx.GetHash().ToString(), ScriptErrorString(serror));
-        return false;
+    // The same stake is checked again for a block already checked by the staker or TestBlockValidity,
+    // and for competing blocks on the same parent, so remember the stakes that passed
+    uint256 cache_key;
+    unsigned char buf[8];
+    CSHA256 hasher = g_stake_kernel_cache_hasher;
+    hasher.Write(pindexPrev->GetBlockHash().begin(), 32).Write(tx.GetWitnessHash().begin(), 32);
+    WriteLE64(buf, nTime);
+    hasher.Write(buf, 8);
+    WriteLE32(buf, nBits);
+    hasher.Write(buf, 4).Finalize(cache_key.begin());
+    const bool fCached = g_stake_kernel_cache.contains(cache_key, /*erase=*/false);
+
+    // Verify the transaction signature is valid and the spender owns the coins,
+    // or leave that to the caller's check queue
+    if (!fCached) {
+        CStakeSignatureCheck check(coin.out, tx);
+        if (pvChecks) {
+            pvChecks->push_back(std::move(check));
+        } else if (!check()) {
+            LogPrintf("ERROR: %s: verify-script-failed, txn %s, reason %s\n", __func__, tx.GetHash().ToString(), ScriptErrorString(check.GetScriptError()));
+            return false;
+        }
     }
 
     // Finally, verify the proof-of-stake kernel hash meets required target
@@ -320,99 +432,323 @@ bool CheckProofOfStake(
         return false;
     }
 
+    if (!fCached && !pvChecks) {
+        g_stake_kernel_cache.insert(cache_key);
+    }
+
     // All validation checks passed - this is a valid stake
     return true;
 }
 
+bool CStakeSignatureCheck::operator()()
+{
+    const CTxIn& txin = m_tx->vin[0];
+    return VerifyScript(txin.scriptSig, m_kernel_out.scriptPubKey, &txin.scriptWitness, STANDARD_SCRIPT_VERIFY_FLAGS, TransactionSignatureChecker(m_tx, 0, m_kernel_out.nValue, MissingDataBehavior::FAIL), &m_error);
+}
+
 // Check whether the coinstake timestamp meets protocol
 bool CheckCoinStakeTimestamp(int64_t nTimeBlock)
 {
     return (nTimeBlock & nStakeTimestampMask) == 0;
 }
 
-// Used only when staking, not during validation
-bool CheckKernel(Chainstate& chain_state, const CBlockIndex* pindexPrev, unsigned int nBits, int64_t nTime, const COutPoint& prevout, int64_t* pBlockTime)
+namespace {
+/** Kernel of a stakeable prevout, or none if it can't stake on the tip */
+struct CachedStakeKernel {
+    std::optional<StakeKernel> kernel;
+    int64_t nBlockTime{0};
+};
+
+Mutex g_stake_kernels_mutex;
+uint256 g_stake_kernels_tip GUARDED_BY(g_stake_kernels_mutex);
+uint32_t g_stake_kernels_bits GUARDED_BY(g_stake_kernels_mutex){0};
+std::map<COutPoint, CachedStakeKernel> g_stake_kernels GUARDED_BY(g_stake_kernels_mutex);
+
+CachedStakeKernel LookupStakeKernel(Chainstate& chain_state, const CBlockIndex* pindexPrev, unsigned int nBits, const COutPoint& prevout) EXCLUSIVE_LOCKS_REQUIRED(::cs_main)
 {
-    uint256 hashProofOfStake, targetProofOfStake;
+    AssertLockHeld(::cs_main);
+    CachedStakeKernel entry;
 
     Coin coin;
-    {
-        LOCK(::cs_main);
-        if (!chain_state.CoinsTip().GetCoin(prevout, coin)) {
-            return error("%s: prevout not found", __func__);
-        }
+    if (!chain_state.CoinsTip().GetCoin(prevout, coin)) {
+        error("%s: prevout not found", __func__);
+        return entry;
     }
     if (coin.IsSpent()) {
-        return error("%s: prevout is spent", __func__);
+        error("%s: prevout is spent", __func__);
+        return entry;
     }
 
     CBlockIndex* pindex = chain_state.m_chain[coin.nHeight];
     if (!pindex) {
-        return false;
+        return entry;
     }
 
     int nRequiredDepth = std::min((int)COINBASE_MATURITY, (int)(pindexPrev->nHeight / 2));
     int nDepth = pindexPrev->nHeight - coin.nHeight;
 
     if (nRequiredDepth > nDepth) {
+        return entry;
+    }
+
+    arith_uint256 bnTarget;
+    if (!GetWeightedStakeTarget(nBits, coin.out.nValue, bnTarget)) {
+        error("%s: SetCompact failed.", __func__);
+        return entry;
+    }
+    entry.nBlockTime = pindex->GetBlockTime();
+    entry.kernel.emplace(pindexPrev->nStakeModifier, entry.nBlockTime, prevout, bnTarget);
+    return entry;
+}
+
+void ResetStakeKernels(const CBlockIndex* pindexPrev, unsigned int nBits) EXCLUSIVE_LOCKS_REQUIRED(g_stake_kernels_mutex)
+{
+    AssertLockHeld(g_stake_kernels_mutex);
+    // The coins, their depth and the modifier only change with the tip
+    if (g_stake_kernels_tip != pindexPrev->GetBlockHash() || g_stake_kernels_bits != nBits) {
+        g_stake_kernels.clear();
+        g_stake_kernels_tip = pindexPrev->GetBlockHash();
+        g_stake_kernels_bits = nBits;
+    }
+}
+
+const CachedStakeKernel& GetStakeKernel(Chainstate& chain_state, const CBlockIndex* pindexPrev, unsigned int nBits, const COutPoint& prevout) EXCLUSIVE_LOCKS_REQUIRED(g_stake_kernels_mutex)
+{
+    AssertLockHeld(g_stake_kernels_mutex);
+    ResetStakeKernels(pindexPrev, nBits);
+    auto it = g_stake_kernels.find(prevout);
+    if (it == g_stake_kernels.end()) {
+        LOCK(::cs_main);
+        it = g_stake_kernels.emplace(prevout, LookupStakeKernel(chain_state, pindexPrev, nBits, prevout)).first;
+    }
+    return it->second;
+}
+
+/**
+ * Search kernels [begin, end) slot by slot for the earliest meeting its target,
+ * giving up on slots past best_slot, the earliest any shard has found yet
+ */
+bool SearchStakeKernels(const std::vector<std::pair<COutPoint, StakeKernel>>& kernels, size_t begin, size_t end,
+    int64_t nTime, int nSlots, std::atomic<int>& best_slot, int& slotRet, size_t& indexRet)
+{
+    uint256 hashProofOfStake;
+    for (int slot = 0; slot < nSlots && slot <= best_slot.load(std::memory_order_relaxed); ++slot, nTime += nStakeTimestampMask + 1) {
+        for (size_t i = begin; i < end; ++i) {
+            if (kernels[i].second.Check(nTime, hashProofOfStake)) {
+                slotRet = slot;
+                indexRet = i;
+                int best = best_slot.load(std::memory_order_relaxed);
+                while (slot < best && !best_slot.compare_exchange_weak(best, slot, std::memory_order_relaxed)) {}
+                return true;
+            }
+        }
+    }
+    return false;
+}
+} // namespace
+
+// Used only when staking, not during validation
+bool CheckKernel(Chainstate& chain_state, const CBlockIndex* pindexPrev, unsigned int nBits, int64_t nTime, const COutPoint& prevout, int64_t* pBlockTime)
+{
+    CachedStakeKernel entry;
+    {
+        LOCK(g_stake_kernels_mutex);
+        entry = GetStakeKernel(chain_state, pindexPrev, nBits, prevout);
+    }
+    if (!entry.kernel) {
         return false;
     }
     if (pBlockTime) {
-        *pBlockTime = pindex->GetBlockTime();
+        *pBlockTime = entry.nBlockTime;
+    }
+    if (nTime < entry.nBlockTime) {
+        return error("%s: nTime violation", __func__);
     }
 
-    CAmount amount = coin.out.nValue;
-    return CheckStakeKernelHash(pindexPrev, nBits, *pBlockTime,
-        amount, prevout, nTime, hashProofOfStake, targetProofOfStake);
+    uint256 hashProofOfStake;
+    if (!entry.kernel->Check(nTime, hashProofOfStake)) {
+        return false;
+    }
+    LogPrint(BCLog::POS, "%s: pass modifier=%s nTimeKernel=%u nPrevout=%u nTime=%u hashProof=%s\n",
+        __func__, pindexPrev->nStakeModifier.ToString(),
+        entry.nBlockTime, prevout.n, nTime, hashProofOfStake.ToString());
+    return true;
 }
 
-bool AddToMapStakeSeen(const COutPoint& kernel, const uint256& blockHash)
+bool FindStakeKernel(Chainstate& chain_state, const CBlockIndex* pindexPrev, unsigned int nBits, int64_t nSearchTime, int nSlots, const std::vector<COutPoint>& prevouts, COutPoint& prevoutRet, int64_t& nTimeRet, int nWorkers)
 {
-    // Overwrites existing values
+    // Copy the kernels out of the cache, so the search itself takes no lock
+    std::vector<std::pair<COutPoint, StakeKernel>> kernels;
+    {
+        LOCK(g_stake_kernels_mutex);
+        ResetStakeKernels(pindexPrev, nBits);
+
+        // Look up the coins new to the cache all under one cs_main
+        std::vector<const COutPoint*> missing;
+        for (const COutPoint& prevout : prevouts) {
+            if (!g_stake_kernels.count(prevout)) {
+                missing.push_back(&prevout);
+            }
+        }
+        if (!missing.empty()) {
+            LOCK(::cs_main);
+            for (const COutPoint* prevout : missing) {
+                g_stake_kernels.emplace(*prevout, LookupStakeKernel(chain_state, pindexPrev, nBits, *prevout));
+            }
+        }
 
-    std::pair<std::map<COutPoint, uint256>::iterator, bool> ret;
-    ret = mapStakeSeen.insert(std::pair<COutPoint, uint256>(kernel, blockHash));
-    if (ret.second == false) { // existing element
-        ret.first->second = blockHash;
-    } else {
-        listStakeSeen.push_back(kernel);
+        kernels.reserve(prevouts.size());
+        for (const COutPoint& prevout : prevouts) {
+            const CachedStakeKernel& entry = g_stake_kernels.at(prevout);
+            if (entry.kernel) {
+                kernels.emplace_back(prevout, *entry.kernel);
+            }
+        }
+    }
+
+    int64_t nTime = nSearchTime & ~(int64_t)nStakeTimestampMask;
+    if (nTime < nSearchTime) {
+        nTime += nStakeTimestampMask + 1;
+    }
+
+    // Earliest time first, then the kernel listed first, whichever way the search is sharded
+    std::atomic<int> best_slot{nSlots};
+    size_t nShards = std::max<size_t>(1, std::min<size_t>(nWorkers, kernels.size() / MIN_STAKE_KERNELS_PER_WORKER));
+    size_t nPerShard = (kernels.size() + nShards - 1) / std::max<size_t>(nShards, 1);
+    std::vector<std::future<std::pair<int, size_t>>> shards;
+    for (size_t begin = nPerShard; begin < kernels.size(); begin += nPerShard) {
+        shards.push_back(std::async(std::launch::async, [&, begin] {
+            int slot{nSlots};
+            size_t index{0};
+            SearchStakeKernels(kernels, begin, std::min(begin + nPerShard, kernels.size()), nTime, nSlots, best_slot, slot, index);
+            return std::make_pair(slot, index);
+        }));
+    }
+    std::pair<int, size_t> best{nSlots, 0};
+    SearchStakeKernels(kernels, 0, std::min(nPerShard, kernels.size()), nTime, nSlots, best_slot, best.first, best.second);
+    for (auto& shard : shards) {
+        best = std::min(best, shard.get());
+    }
+    if (best.first >= nSlots) {
+        return false;
     }
 
+    prevoutRet = kernels[best.second].first;
+    nTimeRet = nTime + (int64_t)best.first * (nStakeTimestampMask + 1);
     return true;
-};
+}
 
-bool CheckStakeUnused(const COutPoint& kernel)
+//! Mask of the smallest power of two number of slots keeping the load factor at most one half
+static size_t StakeSeenMask(size_t capacity)
 {
-    std::map<COutPoint, uint256>::const_iterator mi = mapStakeSeen.find(kernel);
-    return (mi == mapStakeSeen.end());
+    size_t slots = 1;
+    while (slots < 2 * capacity) {
+        slots <<= 1;
+    }
+    return slots - 1;
 }
 
-bool CheckStakeUnique(const CBlock& block, bool fUpdate)
+StakeSeenSet::StakeSeenSet(size_t capacity)
+    : m_capacity{std::max<size_t>(capacity, 1)},
+      m_mask{StakeSeenMask(m_capacity)},
+      m_slots(m_mask + 1),
+      m_order(m_capacity)
 {
-    LOCK(cs_main);
+}
 
-    uint256 blockHash = block.GetHash();
-    const COutPoint& kernel = block.vtx[0]->vin[0].prevout;
+size_t StakeSeenSet::FindSlot(const COutPoint& kernel) const
+{
+    AssertLockHeld(m_mutex);
+    size_t slot = Home(kernel);
+    while (m_slots[slot].used && m_slots[slot].kernel != kernel) {
+        slot = (slot + 1) & m_mask;
+    }
+    return slot;
+}
 
-    std::map<COutPoint, uint256>::const_iterator mi = mapStakeSeen.find(kernel);
-    if (mi != mapStakeSeen.end()) {
-        if (mi->second == blockHash) {
-            return true;
+void StakeSeenSet::EraseSlot(size_t slot)
+{
+    AssertLockHeld(m_mutex);
+    size_t next = slot;
+    while (true) {
+        m_slots[slot].used = false;
+        while (true) {
+            next = (next + 1) & m_mask;
+            if (!m_slots[next].used) {
+                return;
+            }
+            // Entries whose home lies cyclically in (slot, next] are still reachable
+            const size_t home = Home(m_slots[next].kernel);
+            if (slot <= next ? (slot < home && home <= next) : (slot < home || home <= next)) {
+                continue;
+            }
+            break;
         }
-        return error("%s: Stake kernel for %s first seen on %s.", __func__, blockHash.ToString(), mi->second.ToString());
+        m_slots[slot] = m_slots[next];
+        slot = next;
+    }
+}
+
+std::optional<uint256> StakeSeenSet::Find(const COutPoint& kernel) const
+{
+    LOCK(m_mutex);
+    const Entry& entry = m_slots[FindSlot(kernel)];
+    if (!entry.used) {
+        return std::nullopt;
     }
+    ++m_hits;
+    return entry.block_hash;
+}
 
-    if (!fUpdate) {
-        return true;
+std::optional<uint256> StakeSeenSet::Insert(const COutPoint& kernel, const uint256& blockHash)
+{
+    LOCK(m_mutex);
+    size_t slot = FindSlot(kernel);
+    if (m_slots[slot].used) {
+        ++m_hits;
+        return m_slots[slot].block_hash;
     }
 
-    while (listStakeSeen.size() > 1024) {
-        const COutPoint& oldest = listStakeSeen.front();
-        if (1 != mapStakeSeen.erase(oldest)) {
-            LogPrintf("%s: Warning: mapStakeSeen did not erase %s %n\n", __func__, oldest.hash.ToString(), oldest.n);
-        }
-        listStakeSeen.pop_front();
+    if (m_size == m_capacity) {
+        EraseSlot(FindSlot(m_order[m_oldest]));
+        m_oldest = (m_oldest + 1) % m_capacity;
+        --m_size;
+        ++m_evictions;
+        // The eviction may have shifted an entry back into the probe sequence of kernel
+        slot = FindSlot(kernel);
     }
 
-    return AddToMapStakeSeen(kernel, blockHash);
-};
+    m_slots[slot] = Entry{kernel, blockHash, true};
+    m_order[(m_oldest + m_size) % m_capacity] = kernel;
+    ++m_size;
+    return std::nullopt;
+}
+
+size_t StakeSeenSet::Size() const
+{
+    LOCK(m_mutex);
+    return m_size;
+}
+
+size_t StakeSeenSet::DynamicMemoryUsage() const
+{
+    LOCK(m_mutex);
+    return memusage::DynamicUsage(m_slots) + memusage::DynamicUsage(m_order);
+}
+
+bool CheckStakeUnused(const COutPoint& kernel)
+{
+    return !g_stake_seen.Find(kernel);
+}
+
+bool CheckStakeUnique(const CBlock& block, bool fUpdate)
+{
+    uint256 blockHash = block.GetHash();
+    const COutPoint& kernel = block.vtx[0]->vin[0].prevout;
+
+    const std::optional<uint256> seen = fUpdate ? g_stake_seen.Insert(kernel, blockHash) : g_stake_seen.Find(kernel);
+    if (seen && *seen != blockHash) {
+        return error("%s: Stake kernel for %s first seen on %s.", __func__, blockHash.ToString(), seen->ToString());
+    }
+    return true;
+}
@@ -7,29 +7,98 @@
 #ifndef PARTICL_POS_KERNEL_H
 #define PARTICL_POS_KERNEL_H
 
+#include <arith_uint256.h>
 #include <consensus/amount.h>
+#include <crypto/sha256.h>
+#include <primitives/transaction.h>
+#include <script/script_error.h>
 #include <sync.h>
+#include <uint256.h>
+#include <util/hasher.h>
+
+#include <atomic>
+#include <deque>
+#include <optional>
+#include <vector>
 
 extern RecursiveMutex cs_main;
 
 class CBlock;
 class CScript;
-class uint256;
-class COutPoint;
 class CBlockIndex;
 class Chainstate;
-class CTransaction;
 class BlockValidationState;
 
 static const int MAX_REORG_DEPTH = 1024;
 
-double GetPoSKernelPS(CBlockIndex* pindex);
+//! Number of stake intervals GetPoSKernelPS() samples
+static const int POS_KERNEL_PS_INTERVAL = 72;
+
+/**
+ * Kernel hashes per second the network's stakes took, over the intervals between
+ * the last POS_KERNEL_PS_INTERVAL + 1 proof-of-stake blocks at or before pindex
+ * Walks back from pindex; the fields it reads of connected blocks don't change
+ */
+double GetPoSKernelPS(const CBlockIndex* pindex);
+
+/**
+ * The stakes GetPoSKernelPS() samples, kept as the tip moves a block at a time,
+ * so the rate is known at each tip without walking back
+ * Falls back to walking back from the tip after a jump, such as a reorganization
+ * published at once
+ */
+class StakeKernelRate
+{
+public:
+    /** Follow the chain to tip, from the tip last seen */
+    void SetTip(const CBlockIndex* tip);
+    const CBlockIndex* GetTip() const { return m_tip; }
+    double KernelsPerSecond() const { return m_kernels_per_second; }
+
+private:
+    void Reset(const CBlockIndex* tip);
+    void Update();
+
+    const CBlockIndex* m_tip{nullptr};
+    //! Proof-of-stake blocks at or before m_tip, oldest first
+    std::deque<const CBlockIndex*> m_stakes;
+    double m_kernels_per_second{0};
+};
 
 /**
  * Compute the hash modifier for proof-of-stake
  */
 uint256 ComputeStakeModifier(const CBlockIndex* pindexPrev, const uint256& kernel);
 
+/**
+ * Weight the compact target nBits by the amount staked
+ * Returns false if nBits is not a valid target
+ */
+bool GetWeightedStakeTarget(uint32_t nBits, CAmount prevOutAmount, arith_uint256& bnTarget);
+
+/**
+ * Stake kernel of one coin against the stake modifier of one block
+ * Everything hashed but the block time is kept as a SHA256 midstate,
+ * so trying a block time only hashes its 4 bytes
+ */
+class StakeKernel
+{
+public:
+    StakeKernel(const uint256& nStakeModifier, uint32_t nBlockFromTime, const COutPoint& prevout, const arith_uint256& bnTarget);
+
+    /** Kernel hash for block time nTime */
+    uint256 GetHash(uint32_t nTime) const;
+
+    /** Check whether the kernel hash for block time nTime meets the weighted target */
+    bool Check(uint32_t nTime, uint256& hashProofOfStake) const;
+
+    const arith_uint256& GetTarget() const { return m_target; }
+
+private:
+    CSHA256 m_prefix;
+    arith_uint256 m_target;
+};
+
 /**
  * Check whether stake kernel meets hash target
  * Sets hashProofOfStake on success return
@@ -40,11 +109,48 @@ bool CheckStakeKernelHash(const CBlockIndex* pindexPrev,
     uint256& hashProofOfStake, uint256& targetProofOfStake,
     bool fPrintProofOfStake = false);
 
+//! Default size of the stake kernel cache, in bytes
+static const size_t DEFAULT_STAKE_KERNEL_CACHE_BYTES = 1 << 20;
+
+/**
+ * Set up the cache of coinstakes that passed CheckProofOfStake()
+ * Must be called once before blocks are validated
+ */
+[[nodiscard]] bool InitStakeKernelCache(size_t max_size_bytes);
+
+/**
+ * Signature of the kernel input of a coinstake, as CheckProofOfStake() verifies it
+ * Holds everything it needs once the kernel is looked up, so it can run on the check queue
+ */
+class CStakeSignatureCheck
+{
+private:
+    CTxOut m_kernel_out;
+    const CTransaction* m_tx;
+    ScriptError m_error{SCRIPT_ERR_UNKNOWN_ERROR};
+
+public:
+    CStakeSignatureCheck(const CTxOut& kernel_out, const CTransaction& tx) : m_kernel_out(kernel_out), m_tx(&tx) {}
+
+    CStakeSignatureCheck(const CStakeSignatureCheck&) = delete;
+    CStakeSignatureCheck& operator=(const CStakeSignatureCheck&) = delete;
+    CStakeSignatureCheck(CStakeSignatureCheck&&) = default;
+    CStakeSignatureCheck& operator=(CStakeSignatureCheck&&) = default;
+
+    bool operator()();
+
+    ScriptError GetScriptError() const { return m_error; }
+};
+
 /**
  * Check kernel hash target and coinstake signature
+ * A coinstake that passed before on the same parent block, with the same nTime and nBits,
+ * skips its signature check; the coin lookup and kernel hash are still done for their results
+ * If pvChecks is not nullptr, the signature check is pushed onto it instead of being performed
+ * inline, and it is up to the caller to run it; the coinstake is then not added to the cache
  * Sets hashProofOfStake on success return
  */
-bool CheckProofOfStake(Chainstate& chain_state, BlockValidationState& state, const CBlockIndex* pindexPrev, const CTransaction& tx, int64_t nTime, unsigned int nBits, uint256& hashProofOfStake, uint256& targetProofOfStake) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+bool CheckProofOfStake(Chainstate& chain_state, BlockValidationState& state, const CBlockIndex* pindexPrev, const CTransaction& tx, int64_t nTime, unsigned int nBits, uint256& hashProofOfStake, uint256& targetProofOfStake, std::vector<CStakeSignatureCheck>* pvChecks = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
 /**
  * Check whether the coinstake timestamp meets protocol
@@ -54,11 +160,83 @@ bool CheckCoinStakeTimestamp(int64_t nTimeBlock);
 /**
  * Wrapper around CheckStakeKernelHash()
  * Also checks existence of kernel input and min age
- * Convenient for searching a kernel
+ * Convenient for searching a kernel, as the kernel of each prevout is kept
+ * until pindexPrev or nBits change, leaving only the hash of nTime to try
  */
 bool CheckKernel(Chainstate& chain_state, const CBlockIndex* pindexPrev, unsigned int nBits, int64_t nTime, const COutPoint& prevout, int64_t* pBlockTime = nullptr);
 
-bool AddToMapStakeSeen(const COutPoint& kernel, const uint256& blockHash);
+//! Fewest kernels worth handing to a worker of their own in FindStakeKernel()
+static const size_t MIN_STAKE_KERNELS_PER_WORKER = 4096;
+
+/**
+ * Search the next nSlots coinstake timestamps from nSearchTime for the earliest
+ * at which one of prevouts stakes on pindexPrev, checking every prevout per timestamp
+ * Large sets of prevouts are sharded across up to nWorkers threads
+ * Returns false if none of them does within the lookahead
+ */
+bool FindStakeKernel(Chainstate& chain_state, const CBlockIndex* pindexPrev, unsigned int nBits, int64_t nSearchTime, int nSlots, const std::vector<COutPoint>& prevouts, COutPoint& prevoutRet, int64_t& nTimeRet, int nWorkers = 1);
+
+//! Number of most recent stake kernels remembered by CheckStakeUnique()
+static const size_t MAX_STAKE_SEEN = 1024;
+
+/**
+ * Kernels of the most recently seen coinstakes, with the block each was first seen in
+ * Open addressed with linear probing at a load factor of at most one half,
+ * the oldest kernel is evicted once capacity kernels are held
+ * Has its own lock, so duplicate stake checks don't need cs_main
+ */
+class StakeSeenSet
+{
+public:
+    explicit StakeSeenSet(size_t capacity);
+
+    /** Block kernel was first seen in, if it is held */
+    std::optional<uint256> Find(const COutPoint& kernel) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Record kernel as first seen in blockHash, evicting the oldest kernel if full
+     * Returns the block already recorded for kernel, leaving it unchanged, if it is held
+     */
+    std::optional<uint256> Insert(const COutPoint& kernel, const uint256& blockHash) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    size_t Size() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Lookups that found their kernel held
+    uint64_t GetHits() const { return m_hits; }
+    //! Kernels evicted to make room for newer ones
+    uint64_t GetEvictions() const { return m_evictions; }
+
+private:
+    struct Entry {
+        COutPoint kernel;
+        uint256 block_hash;
+        bool used{false};
+    };
+
+    size_t Home(const COutPoint& kernel) const { return m_hasher(kernel) & m_mask; }
+    /** Slot holding kernel, or the empty slot ending its probe sequence */
+    size_t FindSlot(const COutPoint& kernel) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /** Empty slot, shifting back entries of its probe sequence to keep them reachable */
+    void EraseSlot(size_t slot) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    const SaltedOutpointHasher m_hasher;
+    const size_t m_capacity;
+    const size_t m_mask;
+
+    mutable Mutex m_mutex;
+    std::vector<Entry> m_slots GUARDED_BY(m_mutex);
+    //! Kernels held, in the order inserted from m_oldest
+    std::vector<COutPoint> m_order GUARDED_BY(m_mutex);
+    size_t m_oldest GUARDED_BY(m_mutex){0};
+    size_t m_size GUARDED_BY(m_mutex){0};
+
+    mutable std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_evictions{0};
+};
+
+extern StakeSeenSet g_stake_seen;
+
 bool CheckStakeUnused(const COutPoint& kernel);
 bool CheckStakeUnique(const CBlock& block, bool fUpdate);
 
@@ -13,12 +13,14 @@
 
 const CBlockIndex* GetLastPoSBlockIndex(const CBlockIndex* pindex)
 {
-    while (pindex && pindex->pprev && pindex->IsProofOfWork())
+    while (pindex && pindex->pprev && pindex->IsProofOfWork()) {
+        if (pindex->pindexLastPoS) return pindex->pindexLastPoS;
         pindex = pindex->pprev;
+    }
     return pindex;
 }
 
-unsigned int GetNextWorkRequiredPoS(const CBlockIndex* pindexLast, const Consensus::Params& params)
+static unsigned int ComputeNextWorkRequiredPoS(const CBlockIndex* pindexLast, const Consensus::Params& params)
 {
     const int64_t T = params.nPosTargetSpacing;
     const int64_t N = 24;
@@ -54,6 +56,17 @@ unsigned int GetNextWorkRequiredPoS(const CBlockIndex* pindexLast, const Consens
     return nextTarget.GetCompact();
 }
 
+unsigned int GetNextWorkRequiredPoS(const CBlockIndex* pindexLast, const Consensus::Params& params)
+{
+    if (pindexLast->nNextPoSBits != 0) return pindexLast->nNextPoSBits;
+    return ComputeNextWorkRequiredPoS(pindexLast, params);
+}
+
+void CacheNextWorkRequiredPoS(CBlockIndex& index, const Consensus::Params& params)
+{
+    index.nNextPoSBits = ComputeNextWorkRequiredPoS(&index, params);
+}
+
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params& params)
 {
     assert(pindexLast != nullptr);
@@ -221,6 +234,10 @@ unsigned int GetNextWorkRequiredDigiShield(const CBlockIndex* pindexLast, const
 	return nProofOfWorkLimit;
     }
 
+    if (params.fPowNoRetargeting) {
+	return pindexLast->nBits;
+    }
+
     // Only change once per interval
     if ((pindexLast->nHeight+1) % retargetInterval != 0){
 	return pindexLast->nBits;
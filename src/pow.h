@@ -16,6 +16,12 @@ class uint256;
 
 const CBlockIndex* GetLastPoSBlockIndex(const CBlockIndex* pindex);
 unsigned int GetNextWorkRequiredPoS(const CBlockIndex* pindexLast, const Consensus::Params& params);
+/**
+ * Cache in index the nBits of a proof-of-stake block on top of it, so the staker
+ * and the checks of the headers on it don't walk its ancestors again. Called
+ * under cs_main when a block is indexed, before other threads can reach it.
+ */
+void CacheNextWorkRequiredPoS(CBlockIndex& index, const Consensus::Params& params);
 unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHeader *pblock, const Consensus::Params&);
 int64_t GetTargetSpacing(int nBestHeight, const Consensus::Params& params);
 int64_t GetInterval(int nBestHeight, const Consensus::Params& params);
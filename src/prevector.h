@@ -168,6 +168,8 @@ private:
     T* indirect_ptr(difference_type pos) { return reinterpret_cast<T*>(_union.indirect_contents.indirect) + pos; }
     const T* indirect_ptr(difference_type pos) const { return reinterpret_cast<const T*>(_union.indirect_contents.indirect) + pos; }
     bool is_direct() const { return _size <= N; }
+    //! Indirect elements this prevector does not own have no capacity
+    bool is_borrowed() const { return !is_direct() && _union.indirect_contents.capacity == 0; }
 
     void change_capacity(size_type new_capacity) {
         if (new_capacity <= N) {
@@ -176,11 +178,17 @@ private:
                 T* src = indirect;
                 T* dst = direct_ptr(0);
                 memcpy(dst, src, size() * sizeof(T));
-                free(indirect);
+                if (!is_borrowed()) free(indirect);
                 _size -= N + 1;
             }
         } else {
-            if (!is_direct()) {
+            if (is_borrowed()) {
+                char* new_indirect = static_cast<char*>(malloc(((size_t)sizeof(T)) * new_capacity));
+                assert(new_indirect);
+                memcpy(new_indirect, _union.indirect_contents.indirect, size() * sizeof(T));
+                _union.indirect_contents.indirect = new_indirect;
+                _union.indirect_contents.capacity = new_capacity;
+            } else if (!is_direct()) {
                 /* FIXME: Because malloc/realloc here won't call new_handler if allocation fails, assert
                     success. These should instead use an allocator or new/delete so that handlers
                     are called as necessary, but performance would be slightly degraded by doing so. */
@@ -458,8 +466,29 @@ public:
         std::swap(_size, other._size);
     }
 
+    /**
+     * Refer to the n elements at data instead of copying them when they do
+     * not fit in place. data must outlive this prevector and anything it is
+     * moved into, and is never written to: the elements are copied the
+     * first time the capacity changes, and copies of this prevector own
+     * theirs. Anything else that writes to the elements must not be used.
+     */
+    void borrow(const T* data, size_type n) {
+        if (!is_direct() && !is_borrowed()) {
+            free(_union.indirect_contents.indirect);
+        }
+        if (n <= N) {
+            memcpy(direct_ptr(0), data, n * sizeof(T));
+            _size = n;
+        } else {
+            _union.indirect_contents.indirect = reinterpret_cast<char*>(const_cast<T*>(data));
+            _union.indirect_contents.capacity = 0;
+            _size = n + N + 1;
+        }
+    }
+
     ~prevector() {
-        if (!is_direct()) {
+        if (!is_direct() && !is_borrowed()) {
             free(_union.indirect_contents.indirect);
             _union.indirect_contents.indirect = nullptr;
         }
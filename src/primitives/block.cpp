@@ -5,9 +5,12 @@
 
 #include <primitives/block.h>
 
+#include <crypto/scrypt.h>
 #include <hash.h>
 #include <tinyformat.h>
 
+#include <cstring>
+
 uint256 CBlockHeader::GetHash() const
 {
     return SerializeHash(*this);
@@ -18,6 +21,17 @@ uint256 CBlockHeader::GetPoWHash() const
     return scrypt_1024_1_1_256(*this);
 }
 
+std::vector<uint256> GetPoWHashes(const std::vector<const CBlockHeader*>& headers)
+{
+    std::vector<char> input(80 * headers.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        memcpy(input.data() + 80 * i, headers[i], 80);
+    }
+    std::vector<uint256> hashes(headers.size());
+    scrypt_1024_1_1_256_batch(input.data(), reinterpret_cast<char*>(hashes.data()), headers.size());
+    return hashes;
+}
+
 std::string CBlock::ToString() const
 {
     std::stringstream s;
@@ -77,6 +77,12 @@ public:
     }
 };
 
+/**
+ * Proof-of-work hashes of headers, each the same as its GetPoWHash()
+ * Several are hashed at once where the CPU allows
+ */
+std::vector<uint256> GetPoWHashes(const std::vector<const CBlockHeader*>& headers);
+
 
 class CBlock : public CBlockHeader
 {
@@ -9,12 +9,16 @@
 #include <hash.h>
 #include <script/script.h>
 #include <serialize.h>
+#include <streams.h>
 #include <tinyformat.h>
 #include <uint256.h>
 #include <util/strencodings.h>
 #include <version.h>
 
+#include <atomic>
 #include <cassert>
+#include <cstring>
+#include <ios>
 #include <stdexcept>
 
 std::string COutPoint::ToString() const
@@ -70,21 +74,158 @@ uint256 CMutableTransaction::GetHash() const
     return SerializeHash(*this, SER_GETHASH, SERIALIZE_TRANSACTION_NO_WITNESS);
 }
 
-uint256 CTransaction::ComputeHash() const
+//! Serialized bytes kept by all transactions together
+static std::atomic<size_t> g_tx_serialization_cache_bytes{0};
+
+/** Keep the serialization of a large transaction while MAX_TX_SERIALIZATION_CACHE_BYTES allows */
+static std::shared_ptr<const std::vector<unsigned char>> KeepSerialization(std::vector<unsigned char>& serialized)
 {
-    return SerializeHash(*this, SER_GETHASH, SERIALIZE_TRANSACTION_NO_WITNESS);
+    if (serialized.size() < MIN_CACHED_TX_SERIALIZED_SIZE) return nullptr;
+    serialized.shrink_to_fit();
+    const size_t usage{serialized.capacity()};
+    if (g_tx_serialization_cache_bytes.fetch_add(usage) + usage > MAX_TX_SERIALIZATION_CACHE_BYTES) {
+        g_tx_serialization_cache_bytes -= usage;
+        return nullptr;
+    }
+    return std::shared_ptr<const std::vector<unsigned char>>{
+        new std::vector<unsigned char>(std::move(serialized)),
+        [usage](const std::vector<unsigned char>* kept) {
+            g_tx_serialization_cache_bytes -= usage;
+            delete kept;
+        }};
 }
 
-uint256 CTransaction::ComputeWitnessHash() const
+namespace {
+/** Reads a transaction out of its kept bytes, its scripts referring to them */
+class InPlaceReader
 {
-    if (!HasWitness()) {
-        return hash;
+private:
+    const int m_type;
+    const int m_version;
+    Span<const unsigned char> m_data;
+
+public:
+    InPlaceReader(int type, int version, Span<const unsigned char> data) : m_type{type}, m_version{version}, m_data{data} {}
+
+    template <typename T>
+    InPlaceReader& operator>>(T&& obj)
+    {
+        ::Unserialize(*this, obj);
+        return *this;
+    }
+
+    int GetVersion() const { return m_version; }
+    int GetType() const { return m_type; }
+    bool empty() const { return m_data.empty(); }
+
+    Span<const unsigned char> Take(size_t size)
+    {
+        if (size > m_data.size()) {
+            throw std::ios_base::failure("InPlaceReader: end of data");
+        }
+        const Span<const unsigned char> taken{m_data.first(size)};
+        m_data = m_data.subspan(size);
+        return taken;
     }
-    return SerializeHash(*this, SER_GETHASH, 0);
+
+    void read(Span<std::byte> dst)
+    {
+        const Span<const unsigned char> src{Take(dst.size())};
+        if (!src.empty()) std::memcpy(dst.data(), src.data(), src.size());
+    }
+
+    void ignore(size_t size) { Take(size); }
+};
+
+/** Found by argument dependent lookup from the prevector deserialization of scripts, in place of the copying one */
+template <unsigned int N>
+void Unserialize_impl(InPlaceReader& s, prevector<N, unsigned char>& script, const unsigned char&)
+{
+    const Span<const unsigned char> bytes{s.Take(ReadCompactSize(s))};
+    script.borrow(bytes.data(), bytes.size());
+}
+} // namespace
+
+CTransaction::Serialized CTransaction::SerializeWithWitness(const CMutableTransaction& tx)
+{
+    Serialized serialized;
+    CVectorWriter{SER_NETWORK, PROTOCOL_VERSION | (tx.HasWitness() ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS), serialized.bytes, 0, tx};
+    serialized.kept = KeepSerialization(serialized.bytes);
+    return serialized;
+}
+
+std::optional<CTransaction::ReadResult> CTransaction::ReadInPlace(Span<const unsigned char> data, int type, int version)
+{
+    // Without witnesses allowed a transaction may read differently than it serializes
+    if (version & SERIALIZE_TRANSACTION_NO_WITNESS) return std::nullopt;
+    Span<const unsigned char> rest{data};
+    try {
+        CTransactionView{rest};
+    } catch (const std::ios_base::failure&) {
+        // Deserializing it fails the usual way
+        return std::nullopt;
+    }
+    std::vector<unsigned char> bytes{data.begin(), data.end() - rest.size()};
+    ReadResult read;
+    read.second.kept = KeepSerialization(bytes);
+    if (!read.second.kept) return std::nullopt;
+    // With witnesses allowed the transaction serializes again to the bytes it was read from, so they
+    // are kept as its serialization
+    InPlaceReader reader{type, version, *read.second.kept};
+    UnserializeTransaction(read.first, reader);
+    assert(reader.empty());
+    return read;
+}
+
+/** Outputs as copies of outputs, with scripts referring to the kept serialization of their transaction */
+static std::vector<CTxOut> CopyOutputs(const std::vector<CTxOut>& outputs, const std::vector<unsigned char>* kept)
+{
+    if (!kept) return outputs;
+    Span<const unsigned char> data{*kept};
+    const CTransactionView view{data};
+    std::vector<CTxOut> copies(outputs.size());
+    auto copy{copies.begin()};
+    for (const CTxOutView& output : view.Outputs()) {
+        copy->nValue = output.nValue;
+        copy->scriptPubKey.borrow(output.scriptPubKey.data(), output.scriptPubKey.size());
+        ++copy;
+    }
+    return copies;
+}
+
+void CTransaction::Encode(Span<const unsigned char> serialized)
+{
+    // Storage transactions are large, and hashing them, checking their size
+    // and relaying them each serializing them again adds up
+    m_witness_hash = Hash(serialized);
+    m_total_size = serialized.size();
+    if (HasWitness()) {
+        std::vector<unsigned char> stripped;
+        CVectorWriter{SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS, stripped, 0, *this};
+        hash = Hash(stripped);
+        m_stripped_size = stripped.size();
+    } else {
+        hash = m_witness_hash;
+        m_stripped_size = m_total_size;
+    }
+}
+
+CTransaction::CTransaction(const CMutableTransaction& tx) : CTransaction(tx, SerializeWithWitness(tx)) {}
+CTransaction::CTransaction(CMutableTransaction&& tx) : CTransaction(std::move(tx), SerializeWithWitness(tx)) {}
+CTransaction::CTransaction(ReadResult&& read)
+    : CTransaction(std::move(read.first), read.second.kept ? std::move(read.second) : SerializeWithWitness(read.first)) {}
+
+CTransaction::CTransaction(const CMutableTransaction& tx, Serialized&& serialized)
+    : vin(tx.vin), vout(CopyOutputs(tx.vout, serialized.kept.get())), nVersion(tx.nVersion), nLockTime(tx.nLockTime), m_serialized(std::move(serialized.kept))
+{
+    Encode(m_serialized ? *m_serialized : serialized.bytes);
 }
 
-CTransaction::CTransaction(const CMutableTransaction& tx) : vin(tx.vin), vout(tx.vout), nVersion(tx.nVersion), nLockTime(tx.nLockTime), hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()} {}
-CTransaction::CTransaction(CMutableTransaction&& tx) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion), nLockTime(tx.nLockTime), hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()} {}
+CTransaction::CTransaction(CMutableTransaction&& tx, Serialized&& serialized)
+    : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion), nLockTime(tx.nLockTime), m_serialized(std::move(serialized.kept))
+{
+    Encode(m_serialized ? *m_serialized : serialized.bytes);
+}
 
 CAmount CTransaction::GetValueOut() const
 {
@@ -98,11 +239,6 @@ CAmount CTransaction::GetValueOut() const
     return nValueOut;
 }
 
-unsigned int CTransaction::GetTotalSize() const
-{
-    return ::GetSerializeSize(*this, PROTOCOL_VERSION);
-}
-
 std::string CTransaction::ToString() const
 {
     std::string str;
@@ -120,3 +256,98 @@ std::string CTransaction::ToString() const
         str += "    " + tx_out.ToString() + "\n";
     return str;
 }
+
+namespace {
+/** Reads from the front of a span, which it leaves past what was read */
+class SpanConsumer
+{
+private:
+    Span<const unsigned char>& m_data;
+
+public:
+    explicit SpanConsumer(Span<const unsigned char>& data) : m_data{data} {}
+
+    Span<const unsigned char> Take(uint64_t size)
+    {
+        if (size > m_data.size()) {
+            throw std::ios_base::failure("CTransactionView: end of data");
+        }
+        const Span<const unsigned char> taken{m_data.first(size)};
+        m_data = m_data.subspan(size);
+        return taken;
+    }
+
+    void read(Span<std::byte> dst)
+    {
+        const Span<const unsigned char> src{Take(dst.size())};
+        if (!src.empty()) std::memcpy(dst.data(), src.data(), src.size());
+    }
+
+    void ignore(uint64_t size) { Take(size); }
+};
+
+void ReadTxOutView(SpanConsumer& s, CTxOutView& out)
+{
+    out.nValue = ser_readdata64(s);
+    out.scriptPubKey = s.Take(ReadCompactSize(s));
+}
+} // namespace
+
+void CTransactionView::OutputIterator::Read()
+{
+    SpanConsumer s{m_data};
+    ReadTxOutView(s, m_out);
+}
+
+CTransactionView::CTransactionView(Span<const unsigned char>& data)
+{
+    SpanConsumer s{data};
+    const auto read_inputs = [&] {
+        for (uint64_t i = 0; i < m_input_count; ++i) {
+            COutPoint prevout;
+            prevout.Unserialize(s);
+            if (i == 0) m_first_prevout_null = prevout.IsNull();
+            s.ignore(ReadCompactSize(s)); // scriptSig
+            s.ignore(sizeof(uint32_t)); // nSequence
+        }
+    };
+    const auto read_outputs = [&] {
+        m_output_count = ReadCompactSize(s);
+        const Span<const unsigned char> start{data};
+        for (uint64_t i = 0; i < m_output_count; ++i) {
+            CTxOutView out;
+            ReadTxOutView(s, out);
+            if (i == 0) m_first_output_empty = out.IsEmpty();
+        }
+        m_outputs = start.first(start.size() - data.size());
+    };
+
+    // As UnserializeTransaction, witnesses allowed
+    s.ignore(sizeof(int32_t)); // nVersion
+    unsigned char flags{0};
+    m_input_count = ReadCompactSize(s);
+    if (m_input_count == 0) {
+        flags = ser_readdata8(s);
+        if (flags != 0) {
+            m_input_count = ReadCompactSize(s);
+            read_inputs();
+            read_outputs();
+        }
+    } else {
+        read_inputs();
+        read_outputs();
+    }
+    if (flags & 1) {
+        flags ^= 1;
+        for (uint64_t i = 0; i < m_input_count; ++i) {
+            const uint64_t stack_size{ReadCompactSize(s)};
+            for (uint64_t n = 0; n < stack_size; ++n) {
+                s.ignore(ReadCompactSize(s));
+            }
+        }
+    }
+    if (flags) {
+        throw std::ios_base::failure("Unknown transaction optional data");
+    }
+    s.ignore(sizeof(uint32_t)); // nLockTime
+}
@@ -10,6 +10,7 @@
 #include <prevector.h>
 #include <script/script.h>
 #include <serialize.h>
+#include <span.h>
 #include <uint256.h>
 
 #include <cstddef>
@@ -18,8 +19,10 @@
 #include <limits>
 #include <memory>
 #include <numeric>
+#include <optional>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -31,6 +34,9 @@
  */
 static const int SERIALIZE_TRANSACTION_NO_WITNESS = 0x40000000;
 
+class DataStream;
+class SpanReader;
+
 /** An outpoint - a combination of a transaction hash and an index n into its vout */
 class COutPoint
 {
@@ -299,6 +305,11 @@ inline CAmount CalculateOutputValue(const TxType& tx)
 }
 
 
+//! Transactions serializing to fewer bytes than this are serialized again when needed
+static constexpr size_t MIN_CACHED_TX_SERIALIZED_SIZE{4096};
+//! Limit on the serialized bytes all transactions keep together
+static constexpr size_t MAX_TX_SERIALIZATION_CACHE_BYTES{128 << 20};
+
 /** The basic transaction that is broadcasted on the network and contained in
  * blocks.  A transaction can contain multiple inputs and outputs.
  */
@@ -319,12 +330,36 @@ public:
     const uint32_t nLockTime;
 
 private:
-    /** Memory only. */
-    const uint256 hash;
-    const uint256 m_witness_hash;
+    /** Memory only, set on construction by Encode(). */
+    uint256 hash;
+    uint256 m_witness_hash;
+    //! Serialized sizes without and with witness data
+    uint32_t m_stripped_size{0};
+    uint32_t m_total_size{0};
+    //! Serialization with witness data, kept for large transactions while MAX_TX_SERIALIZATION_CACHE_BYTES allows.
+    //! The scripts too long to be stored in place refer to their bytes in it rather than to copies.
+    std::shared_ptr<const std::vector<unsigned char>> m_serialized;
+
+    /** Serialization with witness data of a transaction about to be built, and the part of it kept */
+    struct Serialized {
+        std::vector<unsigned char> bytes;
+        std::shared_ptr<const std::vector<unsigned char>> kept;
+    };
+    using ReadResult = std::pair<CMutableTransaction, Serialized>;
+
+    static Serialized SerializeWithWitness(const CMutableTransaction& tx);
+    /** Read a large transaction at the front of data, its scripts referring to a kept copy of its bytes. */
+    static std::optional<ReadResult> ReadInPlace(Span<const unsigned char> data, int type, int version);
+
+    template <typename Stream>
+    static ReadResult Read(Stream& s);
+
+    CTransaction(const CMutableTransaction& tx, Serialized&& serialized);
+    CTransaction(CMutableTransaction&& tx, Serialized&& serialized);
+    explicit CTransaction(ReadResult&& read);
 
-    uint256 ComputeHash() const;
-    uint256 ComputeWitnessHash() const;
+    /** Compute the hashes and sizes from the serialization with witness data. */
+    void Encode(Span<const unsigned char> serialized);
 
 public:
     /** Convert a CMutableTransaction into a CTransaction. */
@@ -333,13 +368,22 @@ public:
 
     template <typename Stream>
     inline void Serialize(Stream& s) const {
+        // The kept serialization is the one without witness data too if there is none
+        if (m_serialized && (!(s.GetVersion() & SERIALIZE_TRANSACTION_NO_WITNESS) || hash == m_witness_hash)) {
+            s.write(MakeByteSpan(*m_serialized));
+            return;
+        }
         SerializeTransaction(*this, s);
     }
 
+    inline void Serialize(CSizeComputer& s) const {
+        s.seek(s.GetVersion() & SERIALIZE_TRANSACTION_NO_WITNESS ? m_stripped_size : m_total_size);
+    }
+
     /** This deserializing constructor is provided instead of an Unserialize method.
      *  Unserialize is not possible, since it would require overwriting const fields. */
     template <typename Stream>
-    CTransaction(deserialize_type, Stream& s) : CTransaction(CMutableTransaction(deserialize, s)) {}
+    CTransaction(deserialize_type, Stream& s) : CTransaction(Read(s)) {}
 
     bool IsNull() const {
         return vin.empty() && vout.empty();
@@ -356,7 +400,10 @@ public:
      * "Total Size" defined in BIP141 and BIP144.
      * @return Total transaction size in bytes
      */
-    unsigned int GetTotalSize() const;
+    unsigned int GetTotalSize() const { return m_total_size; }
+
+    /** Memory held by the kept serialization, if any. */
+    size_t SerializationCacheUsage() const { return m_serialized ? m_serialized->capacity() : 0; }
 
     bool IsCoinBase() const
     {
@@ -434,6 +481,102 @@ struct CMutableTransaction
     }
 };
 
+template <typename Stream>
+CTransaction::ReadResult CTransaction::Read(Stream& s)
+{
+    // Streams in memory let a large transaction be copied whole, rather than script by script
+    if constexpr (std::is_base_of_v<DataStream, Stream> || std::is_same_v<Stream, SpanReader>) {
+        if (auto read{ReadInPlace({UCharCast(s.data()), s.size()}, s.GetType(), s.GetVersion())}) {
+            s.ignore(read->second.kept->size());
+            return std::move(*read);
+        }
+    }
+    // Serialized again once built
+    return {CMutableTransaction(deserialize, s), {}};
+}
+
+/** An output of a CTransactionView, its script pointing into the serialization */
+struct CTxOutView
+{
+    CAmount nValue{0};
+    Span<const unsigned char> scriptPubKey;
+
+    bool IsEmpty() const { return nValue == 0 && scriptPubKey.empty(); }
+    bool IsOpReturn() const { return !scriptPubKey.empty() && scriptPubKey[0] == OP_RETURN; }
+};
+
+/**
+ * A transaction looked at in place in its serialization, for transient reads
+ * that only need its outputs, such as chain scans. Nothing is copied or
+ * allocated: output scripts point into the serialization, which has to outlive
+ * the view. Inputs and witnesses are skipped and no hash is computed.
+ */
+class CTransactionView
+{
+public:
+    class OutputIterator
+    {
+    private:
+        //! Serialized outputs after the current one
+        Span<const unsigned char> m_data;
+        //! Outputs left, the current one included
+        uint64_t m_left;
+        CTxOutView m_out;
+
+        void Read();
+
+    public:
+        OutputIterator(Span<const unsigned char> data, uint64_t count) : m_data{data}, m_left{count}
+        {
+            if (m_left) Read();
+        }
+        const CTxOutView& operator*() const { return m_out; }
+        const CTxOutView* operator->() const { return &m_out; }
+        OutputIterator& operator++()
+        {
+            if (--m_left) Read();
+            return *this;
+        }
+        bool operator!=(const OutputIterator& other) const { return m_left != other.m_left; }
+    };
+
+    struct OutputRange {
+        Span<const unsigned char> data;
+        uint64_t count;
+        OutputIterator begin() const { return {data, count}; }
+        OutputIterator end() const { return {{}, 0}; }
+    };
+
+private:
+    uint64_t m_input_count{0};
+    bool m_first_prevout_null{false};
+    //! Serialized outputs, without their count
+    Span<const unsigned char> m_outputs;
+    uint64_t m_output_count{0};
+    bool m_first_output_empty{false};
+
+public:
+    /**
+     * Read the transaction at the front of data, leaving data past it.
+     * Throws std::ios_base::failure if it is malformed, as deserializing it does.
+     */
+    explicit CTransactionView(Span<const unsigned char>& data);
+
+    size_t InputCount() const { return m_input_count; }
+    size_t OutputCount() const { return m_output_count; }
+    OutputRange Outputs() const { return {m_outputs, m_output_count}; }
+
+    bool IsCoinBase() const
+    {
+        return m_input_count == 1 && m_first_prevout_null;
+    }
+
+    bool IsCoinStake() const
+    {
+        return m_input_count > 0 && !m_first_prevout_null && m_output_count >= 2 && m_first_output_empty;
+    }
+};
+
 typedef std::shared_ptr<const CTransaction> CTransactionRef;
 template <typename Tx> static inline CTransactionRef MakeTransactionRef(Tx&& txIn) { return std::make_shared<const CTransaction>(std::forward<Tx>(txIn)); }
 
@@ -264,6 +264,46 @@ extern const char* WTXIDRELAY;
  * txreconciliation, as described by BIP 330.
  */
 extern const char* SENDTXRCNCL;
+/**
+ * Contains a 2-byte set size and a 2-byte q coefficient, requesting a sketch
+ * of the transactions the receiver would announce, as described by BIP 330.
+ */
+extern const char* REQRECON;
+/**
+ * Contains a sketch of the short ids of the transactions the sender would
+ * announce, answering a reqrecon, as described by BIP 330.
+ */
+extern const char* SKETCH;
+/**
+ * Contains whether the reconciliation succeeded and the short ids of the
+ * transactions the sender misses, as described by BIP 330.
+ */
+extern const char* RECONCILDIFF;
+/**
+ * getassetchunks requests the header chunk and a range of the data chunks of
+ * a stored asset, by uuid.
+ * Only available with service bit NODE_STORAGE.
+ */
+extern const char* GETASSETCHUNKS;
+/**
+ * assetchunks is a response to a getassetchunks request, carrying the chunks
+ * asked for as the scripts of the outputs holding them, or none if the sender
+ * does not hold them all.
+ */
+extern const char* ASSETCHUNKS;
+/**
+ * Contains an 8-byte LE version number of the compressed headers encoding.
+ * Indicates that a node is able to receive headers as "cheaders" messages,
+ * and that it prefers them to "headers" messages.
+ */
+extern const char* SENDCHEADERS;
+/**
+ * Contains a CompressedHeaders, the headers a "headers" message would carry,
+ * without their hashPrevBlock and with nTime, nVersion and nBits encoded
+ * against the headers before.
+ * Only sent to peers that sent "sendcheaders".
+ */
+extern const char* CHEADERS;
 }; // namespace NetMsgType
 
 /* Get a vector of all valid message types (see above) */
@@ -291,6 +331,10 @@ enum ServiceFlags : uint64_t {
     // serving the last 288 (2 day) blocks
     // See BIP159 for details on how this is implemented.
     NODE_NETWORK_LIMITED = (1 << 10),
+    // NODE_STORAGE means the node keeps the storage index and serves the chunks
+    // of stored assets with getassetchunks, so peers without the blocks holding
+    // an asset can fetch it.
+    NODE_STORAGE = (1 << 12),
 
     // Bits 24-31 are reserved for temporary experiments. Just pick a bit that
     // isn't getting used, or one not being used much, and notify the
@@ -17,6 +17,7 @@
 #include <qt/optionsmodel.h>
 #include <qt/platformstyle.h>
 #include <qt/rpcconsole.h>
+#include <qt/storagepage.h>
 #include <qt/utilitydialog.h>
 
 #ifdef ENABLE_WALLET
@@ -105,6 +106,10 @@ BitcoinGUI::BitcoinGUI(interfaces::Node& node, const PlatformStyle *_platformSty
     updateWindowTitle();
 
     rpcConsole = new RPCConsole(node, _platformStyle, nullptr);
+    storagePage = new StoragePage(node, nullptr);
+    connect(storagePage, &StoragePage::message, [this](const QString& title, const QString& message, unsigned int style) {
+        this->message(title, message, style);
+    });
     helpMessageDialog = new HelpMessageDialog(this, false);
 #ifdef ENABLE_WALLET
     if(enableWallet)
@@ -253,6 +258,7 @@ BitcoinGUI::~BitcoinGUI()
     MacDockIconHandler::cleanup();
 #endif
 
+    delete storagePage;
     delete rpcConsole;
 }
 
@@ -342,6 +348,9 @@ void BitcoinGUI::createActions()
     // initially disable the debug window menu item
     openRPCConsoleAction->setEnabled(false);
     openRPCConsoleAction->setObjectName("openRPCConsoleAction");
+    openStorageAction = new QAction(tr("&Storage"), this);
+    openStorageAction->setStatusTip(tr("Browse the assets stored on chain and fetch them"));
+    openStorageAction->setEnabled(false);
 
     usedSendingAddressesAction = new QAction(tr("&Sending addresses"), this);
     usedSendingAddressesAction->setStatusTip(tr("Show the list of used sending addresses and labels"));
@@ -389,6 +398,8 @@ void BitcoinGUI::createActions()
     connect(openRPCConsoleAction, &QAction::triggered, this, &BitcoinGUI::showDebugWindow);
     // prevents an open debug window from becoming stuck/unusable on client shutdown
     connect(quitAction, &QAction::triggered, rpcConsole, &QWidget::hide);
+    connect(openStorageAction, &QAction::triggered, [this] { GUIUtil::bringToFront(storagePage); });
+    connect(quitAction, &QAction::triggered, storagePage, &QWidget::hide);
 
 #ifdef ENABLE_WALLET
     if(walletFrame)
@@ -571,6 +582,8 @@ void BitcoinGUI::createMenuBar()
             showDebugWindow();
         });
     }
+    window_menu->addSeparator();
+    window_menu->addAction(openStorageAction);
 
     QMenu *help = appMenuBar->addMenu(tr("&Help"));
     help->addAction(showHelpMessageAction);
@@ -1312,6 +1325,7 @@ void BitcoinGUI::closeEvent(QCloseEvent *event)
         {
             // close rpcConsole in case it was open to make some space for the shutdown window
             rpcConsole->close();
+            storagePage->close();
 
             Q_EMIT quitRequested();
         }
@@ -1330,6 +1344,7 @@ void BitcoinGUI::showEvent(QShowEvent *event)
 {
     // enable the debug window when the main window shows up
     openRPCConsoleAction->setEnabled(true);
+    openStorageAction->setEnabled(true);
     aboutAction->setEnabled(true);
     optionsAction->setEnabled(true);
 }
@@ -1530,6 +1545,7 @@ void BitcoinGUI::detectShutdown()
     {
         if(rpcConsole)
             rpcConsole->hide();
+        if (storagePage) storagePage->hide();
         Q_EMIT quitRequested();
     }
 }
@@ -20,22 +20,25 @@
 #include <util/time.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <stdint.h>
+#include <utility>
 
 #include <QDebug>
 #include <QMetaObject>
 #include <QThread>
 #include <QTimer>
 
-static SteadyClock::time_point g_last_header_tip_update_notification{};
-static SteadyClock::time_point g_last_block_tip_update_notification{};
-
 ClientModel::ClientModel(interfaces::Node& node, OptionsModel *_optionsModel, QObject *parent) :
     QObject(parent),
     m_node(node),
     optionsModel(_optionsModel),
-    m_thread(new QThread(this))
+    m_thread(new QThread(this)),
+    m_tip_timer(new QTimer(this))
 {
+    m_tip_timer->setSingleShot(true);
+    connect(m_tip_timer, &QTimer::timeout, this, &ClientModel::showPendingTips);
+
     cachedBestHeaderHeight = -1;
     cachedBestHeaderTime = -1;
 
@@ -219,16 +222,45 @@ void ClientModel::TipChanged(SynchronizationState sync_state, interfaces::BlockT
         WITH_LOCK(m_cached_tip_mutex, m_cached_tip_blocks = tip.block_hash;);
     }
 
-    // Throttle GUI notifications about (a) blocks during initial sync, and (b) both blocks and headers during reindex.
-    const bool throttle = (sync_state != SynchronizationState::POST_INIT && synctype == SyncType::BLOCK_SYNC) || sync_state == SynchronizationState::INIT_REINDEX;
-    const auto now{throttle ? SteadyClock::now() : SteadyClock::time_point{}};
-    auto& nLastUpdateNotification = synctype != SyncType::BLOCK_SYNC ? g_last_header_tip_update_notification : g_last_block_tip_update_notification;
-    if (throttle && now < nLastUpdateNotification + MODEL_UPDATE_DELAY) {
-        return;
+    // Coalesce GUI notifications about blocks and headers: during initial sync and reindex,
+    // and after them for the bursts of staked and storage blocks. The latest tip of a burst
+    // is shown once MODEL_UPDATE_DELAY passed since the last one.
+    const PendingTip shown{tip.block_height, QDateTime::fromSecsSinceEpoch(tip.block_time), verification_progress, synctype, sync_state};
+    const auto now{SteadyClock::now()};
+    {
+        LOCK(m_tips_mutex);
+        auto& last_notification{synctype != SyncType::BLOCK_SYNC ? m_last_header_tip_notification : m_last_block_tip_notification};
+        auto& pending{synctype != SyncType::BLOCK_SYNC ? m_pending_header_tip : m_pending_block_tip};
+        if (pending || now < last_notification + MODEL_UPDATE_DELAY) {
+            const bool scheduled{m_pending_header_tip || m_pending_block_tip};
+            pending = shown;
+            if (!scheduled) {
+                const int delay_ms = std::max<int64_t>(0, Ticks<std::chrono::milliseconds>(last_notification + MODEL_UPDATE_DELAY - now));
+                bool invoked = QMetaObject::invokeMethod(m_tip_timer, "start", Qt::QueuedConnection, Q_ARG(int, delay_ms));
+                assert(invoked);
+            }
+            return;
+        }
+        last_notification = now;
     }
 
-    Q_EMIT numBlocksChanged(tip.block_height, QDateTime::fromSecsSinceEpoch(tip.block_time), verification_progress, synctype, sync_state);
-    nLastUpdateNotification = now;
+    Q_EMIT numBlocksChanged(shown.height, shown.time, shown.verification_progress, shown.synctype, shown.sync_state);
+}
+
+void ClientModel::showPendingTips()
+{
+    std::optional<PendingTip> header_tip, block_tip;
+    {
+        LOCK(m_tips_mutex);
+        const auto now{SteadyClock::now()};
+        if (m_pending_header_tip) m_last_header_tip_notification = now;
+        if (m_pending_block_tip) m_last_block_tip_notification = now;
+        header_tip = std::exchange(m_pending_header_tip, std::nullopt);
+        block_tip = std::exchange(m_pending_block_tip, std::nullopt);
+    }
+    for (const auto& tip : {header_tip, block_tip}) {
+        if (tip) Q_EMIT numBlocksChanged(tip->height, tip->time, tip->verification_progress, tip->synctype, tip->sync_state);
+    }
 }
 
 void ClientModel::subscribeToCoreSignals()
@@ -10,8 +10,10 @@
 
 #include <atomic>
 #include <memory>
+#include <optional>
 #include <sync.h>
 #include <uint256.h>
+#include <util/time.h>
 
 class BanTableModel;
 class CBlockIndex;
@@ -110,7 +112,25 @@ private:
     //! A thread to interact with m_node asynchronously
     QThread* const m_thread;
 
-    void TipChanged(SynchronizationState sync_state, interfaces::BlockTip tip, double verification_progress, SyncType synctype) EXCLUSIVE_LOCKS_REQUIRED(!m_cached_tip_mutex);
+    //! A tip as numBlocksChanged() shows it
+    struct PendingTip {
+        int height;
+        QDateTime time;
+        double verification_progress;
+        SyncType synctype;
+        SynchronizationState sync_state;
+    };
+    //! Tips coming within MODEL_UPDATE_DELAY of the last one shown of their kind wait, and only
+    //! the latest is shown when the timer fires
+    Mutex m_tips_mutex;
+    SteadyClock::time_point m_last_header_tip_notification GUARDED_BY(m_tips_mutex){};
+    SteadyClock::time_point m_last_block_tip_notification GUARDED_BY(m_tips_mutex){};
+    std::optional<PendingTip> m_pending_header_tip GUARDED_BY(m_tips_mutex);
+    std::optional<PendingTip> m_pending_block_tip GUARDED_BY(m_tips_mutex);
+    QTimer* const m_tip_timer;
+
+    void TipChanged(SynchronizationState sync_state, interfaces::BlockTip tip, double verification_progress, SyncType synctype) EXCLUSIVE_LOCKS_REQUIRED(!m_cached_tip_mutex, !m_tips_mutex);
+    void showPendingTips() EXCLUSIVE_LOCKS_REQUIRED(!m_tips_mutex);
     void subscribeToCoreSignals();
     void unsubscribeFromCoreSignals();
 
@@ -0,0 +1,129 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <qt/storagepage.h>
+
+#include <qt/guiutil.h>
+#include <qt/storagetablemodel.h>
+
+#include <node/interface_ui.h>
+
+#include <QApplication>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPainter>
+#include <QPushButton>
+#include <QStyleOption>
+#include <QStyledItemDelegate>
+#include <QTableView>
+#include <QVBoxLayout>
+
+namespace {
+/** Draws the fetches running as progress bars, and the others as their state */
+class FetchProgressDelegate : public QStyledItemDelegate
+{
+public:
+    using QStyledItemDelegate::QStyledItemDelegate;
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override
+    {
+        const QVariant progress = index.data(StorageTableModel::ProgressRole);
+        if (!progress.isValid()) {
+            QStyledItemDelegate::paint(painter, option, index);
+            return;
+        }
+        QStyleOptionProgressBar bar;
+        bar.rect = option.rect;
+        bar.minimum = 0;
+        bar.maximum = 100;
+        bar.progress = progress.toInt();
+        bar.text = QStringLiteral("%1%").arg(bar.progress);
+        bar.textVisible = true;
+        QApplication::style()->drawControl(QStyle::CE_ProgressBar, &bar, painter);
+    }
+};
+} // namespace
+
+StoragePage::StoragePage(interfaces::Node& node, QWidget* parent)
+    : QWidget(parent, Qt::Window),
+      m_node(node)
+{
+    setWindowTitle(tr("Storage"));
+    resize(800, 500);
+
+    m_view = new QTableView(this);
+    m_view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_view->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_view->setAlternatingRowColors(true);
+    m_view->verticalHeader()->hide();
+    m_view->horizontalHeader()->setStretchLastSection(true);
+    m_view->setItemDelegateForColumn(StorageTableModel::Progress, new FetchProgressDelegate(m_view));
+
+    m_status = new QLabel(this);
+    m_fetch_button = new QPushButton(tr("&Fetch…"), this);
+    m_fetch_button->setToolTip(tr("Fetch the selected asset into a directory"));
+    m_cancel_button = new QPushButton(tr("&Cancel fetch"), this);
+    m_refresh_button = new QPushButton(tr("&Refresh"), this);
+    m_refresh_button->setToolTip(tr("List the assets again from the newest"));
+
+    QHBoxLayout* buttons = new QHBoxLayout();
+    buttons->addWidget(m_status, 1);
+    buttons->addWidget(m_refresh_button);
+    buttons->addWidget(m_cancel_button);
+    buttons->addWidget(m_fetch_button);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(m_view);
+    layout->addLayout(buttons);
+
+    connect(m_fetch_button, &QPushButton::clicked, this, &StoragePage::fetchClicked);
+    connect(m_cancel_button, &QPushButton::clicked, this, &StoragePage::cancelClicked);
+    updateButtons();
+}
+
+void StoragePage::showEvent(QShowEvent* event)
+{
+    QWidget::showEvent(event);
+    if (m_model) return;
+
+    m_model = new StorageTableModel(m_node, this);
+    connect(m_model, &StorageTableModel::message, this, &StoragePage::message);
+    connect(m_model, &StorageTableModel::listingChanged, this, [this](bool listing) {
+        m_status->setText(listing ? tr("Listing assets…") : QString());
+    });
+    connect(m_refresh_button, &QPushButton::clicked, m_model, &StorageTableModel::refresh);
+    m_view->setModel(m_model);
+    m_view->setColumnWidth(StorageTableModel::Uuid, GUIUtil::TextWidth(m_view->fontMetrics(), QString(64, 'f')));
+    connect(m_view->selectionModel(), &QItemSelectionModel::selectionChanged, this, &StoragePage::updateButtons);
+    connect(m_model, &QAbstractItemModel::modelReset, this, &StoragePage::updateButtons);
+    // The view asks for more pages as it scrolls, this is the first
+    m_model->fetchMore(QModelIndex());
+}
+
+void StoragePage::fetchClicked()
+{
+    const QModelIndexList selection = m_view->selectionModel()->selectedRows();
+    if (selection.isEmpty()) return;
+    const QString dir = QFileDialog::getExistingDirectory(this, tr("Fetch the asset into"));
+    if (dir.isEmpty()) return;
+    if (!m_model->fetchAsset(selection.first(), dir)) {
+        Q_EMIT message(tr("Storage"), tr("Could not fetch the asset into %1.").arg(dir), CClientUIInterface::MSG_ERROR);
+    }
+}
+
+void StoragePage::cancelClicked()
+{
+    const QModelIndexList selection = m_view->selectionModel()->selectedRows();
+    if (selection.isEmpty()) return;
+    m_model->cancelFetch(selection.first());
+}
+
+void StoragePage::updateButtons()
+{
+    const bool selected{m_view->selectionModel() && m_view->selectionModel()->hasSelection()};
+    m_fetch_button->setEnabled(selected);
+    m_cancel_button->setEnabled(selected);
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_QT_STORAGEPAGE_H
+#define BITCOIN_QT_STORAGEPAGE_H
+
+#include <QWidget>
+
+class StorageTableModel;
+
+namespace interfaces {
+class Node;
+}
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+class QPushButton;
+class QShowEvent;
+class QTableView;
+QT_END_NAMESPACE
+
+/** Window browsing the assets stored on chain and fetching them to disk */
+class StoragePage : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit StoragePage(interfaces::Node& node, QWidget* parent = nullptr);
+
+Q_SIGNALS:
+    void message(const QString& title, const QString& message, unsigned int style);
+
+protected:
+    /** The assets are listed the first time the window shows, once the node runs */
+    void showEvent(QShowEvent* event) override;
+
+private Q_SLOTS:
+    void fetchClicked();
+    void cancelClicked();
+    void updateButtons();
+
+private:
+    interfaces::Node& m_node;
+    StorageTableModel* m_model{nullptr};
+    QTableView* m_view;
+    QLabel* m_status;
+    QPushButton* m_fetch_button;
+    QPushButton* m_cancel_button;
+    QPushButton* m_refresh_button;
+};
+
+#endif // BITCOIN_QT_STORAGEPAGE_H
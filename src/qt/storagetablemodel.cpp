@@ -0,0 +1,239 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <qt/storagetablemodel.h>
+
+#include <qt/guiconstants.h>
+#include <qt/guiutil.h>
+
+#include <interfaces/node.h>
+#include <node/interface_ui.h>
+#include <univalue.h>
+
+#include <QTimer>
+
+//! Assets listed by a job, a page of the view scrolled through
+static constexpr int STORAGE_PAGE_SIZE{100};
+
+StorageTableModel::StorageTableModel(interfaces::Node& node, QObject* parent)
+    : QAbstractTableModel(parent),
+      m_node(node)
+{
+    m_columns << tr("UUID") << tr("Size") << tr("Height") << tr("Date") << tr("Fetch");
+
+    m_poll_timer = new QTimer(this);
+    m_poll_timer->setInterval(MODEL_UPDATE_DELAY);
+    connect(m_poll_timer, &QTimer::timeout, this, &StorageTableModel::pollJobs);
+}
+
+StorageTableModel::~StorageTableModel()
+{
+    if (!m_list_job.empty()) m_node.cancelJob(m_list_job);
+}
+
+int StorageTableModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_assets.size();
+}
+
+int StorageTableModel::columnCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_columns.length();
+}
+
+QVariant StorageTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_assets.size()) return QVariant();
+    const StorageAssetRecord& asset = m_assets[index.row()];
+
+    if (role == Qt::DisplayRole) {
+        switch (static_cast<ColumnIndex>(index.column())) {
+        case Uuid:
+            return asset.uuid;
+        case Size:
+            return GUIUtil::formatBytes(asset.length);
+        case Height:
+            return asset.height < 0 ? tr("Unconfirmed") : QString::number(asset.height);
+        case Date:
+            return asset.time ? GUIUtil::dateTimeStr(asset.time) : QString();
+        case Progress: {
+            const auto it = m_fetches.find(asset.uuid);
+            if (it == m_fetches.end()) return QString();
+            switch (it->second.state) {
+            case node::JobState::QUEUED: return tr("Queued");
+            case node::JobState::RUNNING: return tr("Fetching");
+            case node::JobState::DONE: return tr("Fetched");
+            case node::JobState::FAILED: return tr("Failed");
+            case node::JobState::CANCELLED: return tr("Cancelled");
+            } // no default case, so the compiler can warn about missing cases
+            assert(false);
+        }
+        } // no default case, so the compiler can warn about missing cases
+        assert(false);
+    } else if (role == ProgressRole && index.column() == Progress) {
+        const auto it = m_fetches.find(asset.uuid);
+        if (it == m_fetches.end() || it->second.state != node::JobState::RUNNING) return QVariant();
+        return it->second.total > 0 ? int(it->second.done * 100 / it->second.total) : 0;
+    } else if (role == Qt::ToolTipRole && index.column() == Progress) {
+        const auto it = m_fetches.find(asset.uuid);
+        if (it != m_fetches.end() && !it->second.error.isEmpty()) return it->second.error;
+    } else if (role == Qt::TextAlignmentRole) {
+        if (index.column() == Size || index.column() == Height) {
+            return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+        }
+    }
+    return QVariant();
+}
+
+QVariant StorageTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section < m_columns.size()) {
+        return m_columns[section];
+    }
+    return QVariant();
+}
+
+bool StorageTableModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && !m_at_end && m_list_job.empty();
+}
+
+void StorageTableModel::fetchMore(const QModelIndex& parent)
+{
+    if (!canFetchMore(parent)) return;
+    m_list_job = m_node.listStorageAssets(STORAGE_PAGE_SIZE, m_next_cursor);
+    if (m_list_job.empty()) {
+        m_at_end = true;
+        Q_EMIT message(tr("Storage"), tr("Could not list the stored assets."), CClientUIInterface::MSG_ERROR);
+        return;
+    }
+    Q_EMIT listingChanged(true);
+    updatePolling();
+}
+
+bool StorageTableModel::fetchAsset(const QModelIndex& index, const QString& dir)
+{
+    if (!index.isValid() || index.row() >= m_assets.size()) return false;
+    const QString& uuid = m_assets[index.row()].uuid;
+    const auto it = m_fetches.find(uuid);
+    if (it != m_fetches.end() && (it->second.state == node::JobState::QUEUED || it->second.state == node::JobState::RUNNING)) {
+        return false;
+    }
+    const std::string job_id = m_node.fetchStorageAsset(uuid.toStdString(), dir.toStdString());
+    if (job_id.empty()) return false;
+    StorageFetchRecord fetch;
+    fetch.job_id = job_id;
+    m_fetches[uuid] = fetch;
+    Q_EMIT dataChanged(this->index(index.row(), Progress), this->index(index.row(), Progress));
+    updatePolling();
+    return true;
+}
+
+bool StorageTableModel::cancelFetch(const QModelIndex& index)
+{
+    if (!index.isValid() || index.row() >= m_assets.size()) return false;
+    const auto it = m_fetches.find(m_assets[index.row()].uuid);
+    return it != m_fetches.end() && m_node.cancelJob(it->second.job_id);
+}
+
+void StorageTableModel::refresh()
+{
+    if (!m_list_job.empty()) {
+        m_node.cancelJob(m_list_job);
+        m_list_job.clear();
+        Q_EMIT listingChanged(false);
+    }
+    beginResetModel();
+    m_assets.clear();
+    m_next_cursor.clear();
+    m_at_end = false;
+    endResetModel();
+    updatePolling();
+}
+
+void StorageTableModel::pollJobs()
+{
+    pollList();
+    pollFetches();
+    updatePolling();
+}
+
+void StorageTableModel::pollList()
+{
+    if (m_list_job.empty()) return;
+    const std::optional<node::JobInfo> job = m_node.getJob(m_list_job);
+    if (job && (job->state == node::JobState::QUEUED || job->state == node::JobState::RUNNING)) return;
+    m_list_job.clear();
+    Q_EMIT listingChanged(false);
+
+    if (!job || job->state != node::JobState::DONE || !job->result.isObject()) {
+        m_at_end = true;
+        if (job && job->state == node::JobState::FAILED) {
+            Q_EMIT message(tr("Storage"), tr("Listing the stored assets failed: %1").arg(QString::fromStdString(job->error)), CClientUIInterface::MSG_ERROR);
+        }
+        return;
+    }
+
+    const UniValue& assets = find_value(job->result, "assets");
+    const UniValue& next_cursor = find_value(job->result, "next_cursor");
+    if (assets.isArray() && !assets.empty()) {
+        beginInsertRows(QModelIndex(), m_assets.size(), m_assets.size() + assets.size() - 1);
+        for (const UniValue& entry : assets.getValues()) {
+            StorageAssetRecord asset;
+            asset.uuid = QString::fromStdString(find_value(entry, "uuid").get_str());
+            asset.length = find_value(entry, "length").getInt<int64_t>();
+            asset.height = find_value(entry, "height").getInt<int>();
+            asset.time = find_value(entry, "time").getInt<int64_t>();
+            m_assets.append(asset);
+        }
+        endInsertRows();
+    }
+    if (next_cursor.isStr()) {
+        m_next_cursor = next_cursor.get_str();
+    } else {
+        m_at_end = true;
+    }
+}
+
+void StorageTableModel::pollFetches()
+{
+    bool changed{false};
+    for (auto& [uuid, fetch] : m_fetches) {
+        if (fetch.state != node::JobState::QUEUED && fetch.state != node::JobState::RUNNING) continue;
+        const std::optional<node::JobInfo> job = m_node.getJob(fetch.job_id);
+        if (!job) {
+            // Forgotten by the queue, which keeps finished jobs for a while only
+            fetch.state = node::JobState::FAILED;
+        } else {
+            fetch.state = job->state;
+            fetch.done = job->progress_done;
+            fetch.total = job->progress_total;
+            fetch.error = QString::fromStdString(job->error);
+        }
+        changed = true;
+    }
+    if (changed && !m_assets.isEmpty()) {
+        // Rows of the fetches may be anywhere, so update the column at once
+        Q_EMIT dataChanged(index(0, Progress), index(m_assets.size() - 1, Progress));
+    }
+}
+
+void StorageTableModel::updatePolling()
+{
+    bool busy{!m_list_job.empty()};
+    for (const auto& [uuid, fetch] : m_fetches) {
+        busy = busy || fetch.state == node::JobState::QUEUED || fetch.state == node::JobState::RUNNING;
+    }
+    if (busy && !m_poll_timer->isActive()) {
+        m_poll_timer->start();
+    } else if (!busy) {
+        m_poll_timer->stop();
+    }
+}
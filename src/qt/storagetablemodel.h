@@ -0,0 +1,117 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_QT_STORAGETABLEMODEL_H
+#define BITCOIN_QT_STORAGETABLEMODEL_H
+
+#include <node/jobs.h>
+
+#include <map>
+#include <string>
+
+#include <QAbstractTableModel>
+#include <QList>
+#include <QStringList>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+namespace interfaces {
+class Node;
+}
+
+/** An asset stored on chain, as a page of the list job gives it */
+struct StorageAssetRecord {
+    QString uuid;
+    qint64 length{0};
+    //! -1 for an asset still in the mempool
+    int height{-1};
+    qint64 time{0};
+};
+
+/** A fetch of an asset queued from the page, as last seen on the job queue */
+struct StorageFetchRecord {
+    std::string job_id;
+    node::JobState state{node::JobState::QUEUED};
+    qint64 done{0};
+    qint64 total{0};
+    QString error;
+};
+
+/**
+   Qt model of the assets of the tenant authenticated, newest first. Rows come
+   a page at a time as the view scrolls to them, each page a list job on the
+   job queue so the GUI thread never waits on the storage index or a scan of
+   the chain. Fetches are jobs too, whose progress the model polls.
+ */
+class StorageTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit StorageTableModel(interfaces::Node& node, QObject* parent = nullptr);
+    ~StorageTableModel();
+
+    enum ColumnIndex {
+        Uuid = 0,
+        Size = 1,
+        Height = 2,
+        Date = 3,
+        Progress = 4,
+    };
+
+    enum RoleIndex {
+        /** Percent of a fetch running, for the progress bar of its row */
+        ProgressRole = Qt::UserRole,
+    };
+
+    /** @name Methods overridden from QAbstractTableModel
+        @{*/
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+    /*@}*/
+
+    /** Queue a fetch of the asset of row into the directory dir */
+    bool fetchAsset(const QModelIndex& index, const QString& dir);
+    /** Cancel the fetch of the asset of row, if it is not finished */
+    bool cancelFetch(const QModelIndex& index);
+    /** Whether a list job is waiting for its page */
+    bool isListing() const { return !m_list_job.empty(); }
+
+public Q_SLOTS:
+    /** Drop the rows and list again from the newest. Fetches keep running. */
+    void refresh();
+
+Q_SIGNALS:
+    void listingChanged(bool listing);
+    void message(const QString& title, const QString& message, unsigned int style);
+
+private Q_SLOTS:
+    void pollJobs();
+
+private:
+    void pollList();
+    void pollFetches();
+    void updatePolling();
+
+    interfaces::Node& m_node;
+    QStringList m_columns;
+    QList<StorageAssetRecord> m_assets;
+    //! Fetches by uuid, kept through refreshes so their rows find them again
+    std::map<QString, StorageFetchRecord> m_fetches;
+    //! The list job waiting for its page, empty if none
+    std::string m_list_job;
+    //! Where the next page starts, empty for the newest
+    std::string m_next_cursor;
+    //! Whether the last page was listed, or listing failed
+    bool m_at_end{false};
+    QTimer* m_poll_timer;
+};
+
+#endif // BITCOIN_QT_STORAGETABLEMODEL_H
@@ -17,10 +17,14 @@
 
 #include <core_io.h>
 #include <interfaces/handler.h>
+#include <pos/pos.h>
+#include <sync.h>
 #include <uint256.h>
 
 #include <algorithm>
 #include <functional>
+#include <set>
+#include <utility>
 
 #include <QColor>
 #include <QDateTime>
@@ -29,6 +33,7 @@
 #include <QLatin1Char>
 #include <QLatin1String>
 #include <QList>
+#include <QTimer>
 
 
 // Amount column is right-aligned it contains numbers
@@ -58,7 +63,11 @@ struct TxLessThan
     }
 };
 
-// queue notifications to show a non freezing progress dialog e.g. for rescan
+//! New transactions of a batch of notifications shown in balloons, the latest ones
+static constexpr size_t MAX_BALLOONS_PER_BATCH{10};
+
+// queue notifications to show a non freezing progress dialog e.g. for rescan,
+// and to apply them to the model in batches
 struct TransactionNotification
 {
 public:
@@ -66,17 +75,6 @@ public:
     TransactionNotification(uint256 _hash, ChangeType _status, bool _showTransaction):
         hash(_hash), status(_status), showTransaction(_showTransaction) {}
 
-    void invoke(QObject *ttm)
-    {
-        QString strHash = QString::fromStdString(hash.GetHex());
-        qDebug() << "NotifyTransactionChanged: " + strHash + " status= " + QString::number(status);
-        bool invoked = QMetaObject::invokeMethod(ttm, "updateTransaction", Qt::QueuedConnection,
-                                  Q_ARG(QString, strHash),
-                                  Q_ARG(int, status),
-                                  Q_ARG(bool, showTransaction));
-        assert(invoked);
-    }
-private:
     uint256 hash;
     ChangeType status;
     bool showTransaction;
@@ -101,9 +99,35 @@ public:
     /** True when transactions are being notified, for instance when scanning */
     bool m_loading = false;
     std::vector< TransactionNotification > vQueueNotifications;
+    /** Notifications not applied yet. Those coming within MODEL_UPDATE_DELAY of the
+        first are applied together, so bursts of coinstakes and storage transactions
+        update the model once. */
+    Mutex m_pending_mutex;
+    std::vector<TransactionNotification> m_pending GUARDED_BY(m_pending_mutex);
 
     void NotifyTransactionChanged(const uint256 &hash, ChangeType status);
     void DispatchNotifications();
+    void QueueNotifications(std::vector<TransactionNotification>&& notifications) EXCLUSIVE_LOCKS_REQUIRED(!m_pending_mutex);
+
+    /* Apply a batch of notifications, in order. A transaction notified several times
+       takes its last status, and only the latest MAX_BALLOONS_PER_BATCH new ones are
+       shown in balloons.
+     */
+    void updateWallet(interfaces::Wallet& wallet, const std::vector<TransactionNotification>& notifications)
+    {
+        std::set<uint256> seen;
+        std::vector<const TransactionNotification*> latest;
+        for (auto it = notifications.rbegin(); it != notifications.rend(); ++it) {
+            if (seen.insert(it->hash).second) latest.push_back(&*it);
+        }
+        size_t new_count = std::count_if(latest.begin(), latest.end(), [](const auto* n) { return n->status == CT_NEW; });
+        for (auto it = latest.rbegin(); it != latest.rend(); ++it) {
+            const TransactionNotification& notification{**it};
+            parent->setProcessingQueuedTransactions(notification.status == CT_NEW && new_count-- > MAX_BALLOONS_PER_BATCH);
+            updateWallet(wallet, notification.hash, notification.status, notification.showTransaction);
+        }
+        parent->setProcessingQueuedTransactions(false);
+    }
 
     /* Query entire wallet anew from core.
      */
@@ -211,6 +235,16 @@ public:
         return cachedWallet.size();
     }
 
+    /* Whether new blocks leave the row as it is, deeper than a reorganization reaches
+       and so confirmed for good. The status of a row is brought up to date when Qt asks
+       for its data. */
+    bool isSettled(const int idx) const
+    {
+        const TransactionStatus& status = cachedWallet[idx].status;
+        return status.status == TransactionStatus::Confirmed && !status.needsUpdate &&
+               status.depth >= MAX_REORG_DEPTH + TransactionRecord::RecommendedNumConfirmations;
+    }
+
     TransactionRecord* index(interfaces::Wallet& wallet, const uint256& cur_block_hash, const int idx)
     {
         if (idx >= 0 && idx < cachedWallet.size()) {
@@ -250,8 +284,12 @@ TransactionTableModel::TransactionTableModel(const PlatformStyle *_platformStyle
         QAbstractTableModel(parent),
         walletModel(parent),
         priv(new TransactionTablePriv(this)),
-        platformStyle(_platformStyle)
+        platformStyle(_platformStyle),
+        m_notification_timer(new QTimer(this))
 {
+    m_notification_timer->setSingleShot(true);
+    m_notification_timer->setInterval(MODEL_UPDATE_DELAY);
+    connect(m_notification_timer, &QTimer::timeout, this, &TransactionTableModel::processQueuedNotifications);
     subscribeToCoreSignals();
 
     columns << QString() << QString() << tr("Date") << tr("Type") << tr("Label") << BitcoinUnits::getAmountColumnTitle(walletModel->getOptionsModel()->getDisplayUnit());
@@ -281,14 +319,30 @@ void TransactionTableModel::updateTransaction(const QString &hash, int status, b
     priv->updateWallet(walletModel->wallet(), updated, status, showTransaction);
 }
 
+void TransactionTableModel::processQueuedNotifications()
+{
+    const std::vector<TransactionNotification> notifications{WITH_LOCK(priv->m_pending_mutex, return std::exchange(priv->m_pending, {}))};
+    priv->updateWallet(walletModel->wallet(), notifications);
+}
+
 void TransactionTableModel::updateConfirmations()
 {
     // Blocks came in since last poll.
     // Invalidate status (number of confirmations) and (possibly) description
-    //  for all rows. Qt is smart enough to only actually request the data for the
-    //  visible rows.
-    Q_EMIT dataChanged(index(0, Status), index(priv->size()-1, Status));
-    Q_EMIT dataChanged(index(0, ToAddress), index(priv->size()-1, ToAddress));
+    //  for the rows a block can change. Those confirmed deeper than a reorganization
+    //  reaches stay confirmed, so with a large wallet the sorting proxy goes
+    //  through the recent rows only. Qt is smart enough to only actually request
+    //  the data for the visible rows.
+    int first = -1;
+    for (int i = 0; i <= priv->size(); ++i) {
+        const bool settled = i == priv->size() || priv->isSettled(i);
+        if (!settled && first < 0) {
+            first = i;
+        } else if (settled && first >= 0) {
+            Q_EMIT dataChanged(index(first, Status), index(i - 1, ToAddress));
+            first = -1;
+        }
+    }
 }
 
 int TransactionTableModel::rowCount(const QModelIndex &parent) const
@@ -718,33 +772,35 @@ void TransactionTablePriv::NotifyTransactionChanged(const uint256 &hash, ChangeT
     bool showTransaction = TransactionRecord::showTransaction();
 
     TransactionNotification notification(hash, status, showTransaction);
+    qDebug() << "NotifyTransactionChanged: " + QString::fromStdString(hash.GetHex()) + " status= " + QString::number(status);
 
     if (!m_loaded || m_loading)
     {
         vQueueNotifications.push_back(notification);
         return;
     }
-    notification.invoke(parent);
+    QueueNotifications({notification});
 }
 
 void TransactionTablePriv::DispatchNotifications()
 {
     if (!m_loaded || m_loading) return;
 
-    if (vQueueNotifications.size() > 10) { // prevent balloon spam, show maximum 10 balloons
-        bool invoked = QMetaObject::invokeMethod(parent, "setProcessingQueuedTransactions", Qt::QueuedConnection, Q_ARG(bool, true));
-        assert(invoked);
-    }
-    for (unsigned int i = 0; i < vQueueNotifications.size(); ++i)
-    {
-        if (vQueueNotifications.size() - i <= 10) {
-            bool invoked = QMetaObject::invokeMethod(parent, "setProcessingQueuedTransactions", Qt::QueuedConnection, Q_ARG(bool, false));
-            assert(invoked);
-        }
+    QueueNotifications(std::exchange(vQueueNotifications, {}));
+}
 
-        vQueueNotifications[i].invoke(parent);
-    }
-    vQueueNotifications.clear();
+void TransactionTablePriv::QueueNotifications(std::vector<TransactionNotification>&& notifications)
+{
+    if (notifications.empty()) return;
+    {
+        LOCK(m_pending_mutex);
+        const bool scheduled{!m_pending.empty()};
+        m_pending.insert(m_pending.end(), notifications.begin(), notifications.end());
+        if (scheduled) return;
+    }
+    // The first notification of a batch starts the timer applying it
+    bool invoked = QMetaObject::invokeMethod(parent->m_notification_timer, "start", Qt::QueuedConnection);
+    assert(invoked);
 }
 
 void TransactionTableModel::subscribeToCoreSignals()
@@ -17,6 +17,7 @@ class Handler;
 }
 
 class PlatformStyle;
+class QTimer;
 class TransactionRecord;
 class TransactionTablePriv;
 class WalletModel;
@@ -91,6 +92,8 @@ private:
     TransactionTablePriv *priv;
     bool fProcessingQueuedTransactions{false};
     const PlatformStyle *platformStyle;
+    //! Started by the first notification of a batch, applies the batch when it fires
+    QTimer* m_notification_timer;
 
     void subscribeToCoreSignals();
     void unsubscribeFromCoreSignals();
@@ -116,6 +119,8 @@ public Q_SLOTS:
     void updateAmountColumnTitle();
     /* Needed to update fProcessingQueuedTransactions through a QueuedConnection */
     void setProcessingQueuedTransactions(bool value) { fProcessingQueuedTransactions = value; }
+    /* Apply the notifications queued since the timer started */
+    void processQueuedNotifications();
 
     friend class TransactionTablePriv;
 };
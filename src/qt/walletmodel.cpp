@@ -133,6 +133,7 @@ interfaces::WalletBalances WalletModel::getCachedBalance() const
 
 void WalletModel::updateTransaction()
 {
+    m_transaction_update_queued = false;
     // Balance and number of transactions might have changed
     fForceCheckBalanceChanged = true;
 }
@@ -392,14 +393,6 @@ static void NotifyAddressBookChanged(WalletModel *walletmodel,
     assert(invoked);
 }
 
-static void NotifyTransactionChanged(WalletModel *walletmodel, const uint256 &hash, ChangeType status)
-{
-    Q_UNUSED(hash);
-    Q_UNUSED(status);
-    bool invoked = QMetaObject::invokeMethod(walletmodel, "updateTransaction", Qt::QueuedConnection);
-    assert(invoked);
-}
-
 static void ShowProgress(WalletModel *walletmodel, const std::string &title, int nProgress)
 {
     // emits signal "showProgress"
@@ -428,7 +421,12 @@ void WalletModel::subscribeToCoreSignals()
     m_handler_unload = m_wallet->handleUnload(std::bind(&NotifyUnload, this));
     m_handler_status_changed = m_wallet->handleStatusChanged(std::bind(&NotifyKeyStoreStatusChanged, this));
     m_handler_address_book_changed = m_wallet->handleAddressBookChanged(std::bind(NotifyAddressBookChanged, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5));
-    m_handler_transaction_changed = m_wallet->handleTransactionChanged(std::bind(NotifyTransactionChanged, this, std::placeholders::_1, std::placeholders::_2));
+    m_handler_transaction_changed = m_wallet->handleTransactionChanged([this](const uint256&, ChangeType) {
+        // A burst of transactions, as a store makes, forces a single balance check
+        if (m_transaction_update_queued.exchange(true)) return;
+        bool invoked = QMetaObject::invokeMethod(this, "updateTransaction", Qt::QueuedConnection);
+        assert(invoked);
+    });
     m_handler_show_progress = m_wallet->handleShowProgress(std::bind(ShowProgress, this, std::placeholders::_1, std::placeholders::_2));
     m_handler_watch_only_changed = m_wallet->handleWatchOnlyChanged(std::bind(NotifyWatchonlyChanged, this, std::placeholders::_1));
     m_handler_can_get_addrs_changed = m_wallet->handleCanGetAddressesChanged(std::bind(NotifyCanGetAddressesChanged, this));
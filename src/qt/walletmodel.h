@@ -17,6 +17,7 @@
 #include <interfaces/wallet.h>
 #include <support/allocators/secure.h>
 
+#include <atomic>
 #include <vector>
 
 #include <QObject>
@@ -174,6 +175,8 @@ private:
 
     bool fHaveWatchOnly;
     bool fForceCheckBalanceChanged{false};
+    //! Whether an updateTransaction() call is queued, which the notifications coming before it share
+    std::atomic<bool> m_transaction_update_queued{false};
 
     // Wallet has an options model for wallet-specific options
     // (transaction fee, for example)
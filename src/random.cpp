@@ -691,6 +691,17 @@ FastRandomContext& FastRandomContext::operator=(FastRandomContext&& from) noexce
     return *this;
 }
 
+FastRandomContext& GetThreadRandomContext() noexcept
+{
+    static thread_local FastRandomContext rng;
+    static thread_local uint64_t uses{0};
+    if (++uses % THREAD_RANDOM_RESEED_USES == 0) {
+        // A moved-to context is seeded again when next used
+        rng = FastRandomContext{};
+    }
+    return rng;
+}
+
 void RandomInit()
 {
     // Invoke RNG code to trigger initialization (if not already performed)
@@ -269,6 +269,16 @@ void Shuffle(I first, I last, R&& rng)
     }
 }
 
+//! Uses of the thread's FastRandomContext after which it is seeded again from the global RNG
+static constexpr uint64_t THREAD_RANDOM_RESEED_USES{1 << 16};
+
+/** The calling thread's FastRandomContext, seeded from the global RNG on first use
+ * and again every THREAD_RANDOM_RESEED_USES calls. For identifiers and nonces made
+ * often, such as storage UUIDs and job ids, without taking the global RNG's lock
+ * each time. Not for key material: use GetStrongRandBytes for that.
+ */
+FastRandomContext& GetThreadRandomContext() noexcept;
+
 /* Number of random bytes returned by GetOSRand.
  * When changing this constant make sure to change all call sites, and make
  * sure that the underlying OS APIs for all platforms support the number.
@@ -11,9 +11,11 @@
 #include <core_io.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
+#include <index/storageindex.h>
 #include <index/txindex.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
+#include <node/metrics.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
@@ -21,15 +23,19 @@
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
+#include <storage/blockchunks.h>
+#include <storage/storage.h>
 #include <streams.h>
 #include <sync.h>
 #include <txmempool.h>
 #include <util/check.h>
+#include <util/string.h>
 #include <util/system.h>
 #include <validation.h>
 #include <version.h>
 
 #include <any>
+#include <map>
 #include <string>
 
 #include <univalue.h>
@@ -39,7 +45,45 @@ using node::NodeContext;
 using node::ReadBlockFromDisk;
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+//! Most outpoints of a binary getutxos request body, which are looked up as one batch
+static constexpr size_t MAX_GETUTXOS_BULK_OUTPOINTS = 10000;
 static constexpr unsigned int MAX_REST_HEADERS_RESULTS = 2000;
+//! Most headers of a binary headers response, which costs 80 bytes a header
+static constexpr unsigned int MAX_REST_HEADERS_BIN_RESULTS = 10000;
+//! Bytes of a streamed asset gathered into each chunk of the reply
+static constexpr size_t STORAGE_STREAM_PIECE = 64 << 10;
+
+//! Content types of the extensions assets are commonly stored with
+static const std::map<std::string, std::string> STORAGE_CONTENT_TYPES{
+    {"bmp", "image/bmp"},
+    {"css", "text/css"},
+    {"csv", "text/csv"},
+    {"gif", "image/gif"},
+    {"gz", "application/gzip"},
+    {"htm", "text/html"},
+    {"html", "text/html"},
+    {"ico", "image/x-icon"},
+    {"jpeg", "image/jpeg"},
+    {"jpg", "image/jpeg"},
+    {"js", "text/javascript"},
+    {"json", "application/json"},
+    {"m4a", "audio/mp4"},
+    {"mov", "video/quicktime"},
+    {"mp3", "audio/mpeg"},
+    {"mp4", "video/mp4"},
+    {"ogg", "audio/ogg"},
+    {"pdf", "application/pdf"},
+    {"png", "image/png"},
+    {"svg", "image/svg+xml"},
+    {"tif", "image/tiff"},
+    {"tiff", "image/tiff"},
+    {"txt", "text/plain"},
+    {"wav", "audio/wav"},
+    {"webm", "video/webm"},
+    {"webp", "image/webp"},
+    {"xml", "application/xml"},
+    {"zip", "application/zip"},
+};
 
 static const struct {
     RESTResponseFormat rf;
@@ -209,9 +253,10 @@ static bool rest_headers(const std::any& context,
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/headers/<hash>.<ext>?count=<count>");
     }
 
+    const unsigned int max_count{rf == RESTResponseFormat::BINARY ? MAX_REST_HEADERS_BIN_RESULTS : MAX_REST_HEADERS_RESULTS};
     const auto parsed_count{ToIntegral<size_t>(raw_count)};
-    if (!parsed_count.has_value() || *parsed_count < 1 || *parsed_count > MAX_REST_HEADERS_RESULTS) {
-        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Header count is invalid or out of acceptable range (1-%u): %s", MAX_REST_HEADERS_RESULTS, raw_count));
+    if (!parsed_count.has_value() || *parsed_count < 1 || *parsed_count > max_count) {
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Header count is invalid or out of acceptable range (1-%u): %s", max_count, raw_count));
     }
 
     uint256 hash;
@@ -241,13 +286,13 @@ static bool rest_headers(const std::any& context,
     switch (rf) {
     case RESTResponseFormat::BINARY: {
         DataStream ssHeader{};
+        ssHeader.reserve(headers.size() * ::GetSerializeSize(CBlockHeader{}, PROTOCOL_VERSION));
         for (const CBlockIndex *pindex : headers) {
             ssHeader << pindex->GetBlockHeader();
         }
 
-        std::string binaryHeader = ssHeader.str();
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryHeader);
+        req->WriteReply(HTTP_OK, ssHeader.str());
         return true;
     }
 
@@ -278,6 +323,20 @@ static bool rest_headers(const std::any& context,
     }
 }
 
+/** Whether the If-None-Match header of a request names etag, so the client's copy is current */
+static bool ClientHasETag(HTTPRequest* req, const std::string& etag)
+{
+    const auto [present, header] = req->GetHeader("If-None-Match");
+    if (!present) return false;
+    for (const std::string& tag : SplitString(header, ',')) {
+        std::string_view value{TrimStringView(tag)};
+        // Compared weakly, as RFC 9110 has it for If-None-Match
+        if (value.substr(0, 2) == "W/") value.remove_prefix(2);
+        if (value == "*" || value == etag) return true;
+    }
+    return false;
+}
+
 static bool rest_block(const std::any& context,
                        HTTPRequest* req,
                        const std::string& strURIPart,
@@ -295,6 +354,7 @@ static bool rest_block(const std::any& context,
     CBlock block;
     const CBlockIndex* pblockindex = nullptr;
     const CBlockIndex* tip = nullptr;
+    bool cacheable;
     ChainstateManager* maybe_chainman = GetChainman(context, req);
     if (!maybe_chainman) return false;
     ChainstateManager& chainman = *maybe_chainman;
@@ -309,6 +369,44 @@ static bool rest_block(const std::any& context,
         if (chainman.m_blockman.IsBlockPruned(pblockindex))
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
+        cacheable = IsBlockRenderCacheable(chainman.ActiveChain(), pblockindex);
+    }
+
+    // The block itself never changes, its JSON description does with the tip
+    std::string etag;
+    switch (rf) {
+    case RESTResponseFormat::BINARY: etag = strprintf("\"%s-bin\"", hash.GetHex()); break;
+    case RESTResponseFormat::HEX: etag = strprintf("\"%s-hex\"", hash.GetHex()); break;
+    case RESTResponseFormat::JSON: etag = strprintf("\"%s-json%d-%s\"", hash.GetHex(), static_cast<int>(tx_verbosity), tip->GetBlockHash().GetHex()); break;
+    default: break;
+    }
+    if (!etag.empty()) {
+        req->WriteHeader("ETag", etag);
+        if (ClientHasETag(req, etag)) {
+            req->WriteReply(HTTP_NOT_MODIFIED);
+            return true;
+        }
+    }
+
+    if (cacheable && rf == RESTResponseFormat::HEX) {
+        const auto hex{CachedBlockHex(pblockindex)};
+        if (!hex) return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, *hex + "\n");
+        return true;
+    }
+    if (cacheable && rf == RESTResponseFormat::JSON) {
+        const auto body{CachedBlockJSONBody(chainman.m_blockman, pblockindex, tx_verbosity)};
+        if (!body) return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        // The header rendered afresh, with the cached members following its own
+        std::string strJSON = blockheaderToJSON(tip, pblockindex).write();
+        strJSON.pop_back();
+        strJSON += ",";
+        strJSON += *body;
+        strJSON += "}\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
     }
 
     if (!ReadBlockFromDisk(block, pblockindex, chainman.GetParams().GetConsensus())) {
@@ -824,8 +922,8 @@ static bool rest_getutxos(const std::any& context, HTTPRequest* req, const std::
                 if (fInputParsed) //don't allow sending input over URI and HTTP RAW DATA
                     return RESTERR(req, HTTP_BAD_REQUEST, "Combination of URI scheme inputs and raw post data is not allowed");
 
-                DataStream oss{};
-                oss << strRequestMutable;
+                // The body is read as is, a length prefix would be taken for the flag
+                DataStream oss{MakeUCharSpan(strRequestMutable)};
                 oss >> fCheckMemPool;
                 oss >> vOutPoints;
             }
@@ -846,9 +944,10 @@ static bool rest_getutxos(const std::any& context, HTTPRequest* req, const std::
     }
     }
 
-    // limit max outpoints
-    if (vOutPoints.size() > MAX_GETUTXOS_OUTPOINTS)
-        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max outpoints exceeded (max: %d, tried: %d)", MAX_GETUTXOS_OUTPOINTS, vOutPoints.size()));
+    // limit max outpoints, binary request bodies being meant for bulk lookups
+    const size_t max_outpoints{fInputParsed ? MAX_GETUTXOS_OUTPOINTS : MAX_GETUTXOS_BULK_OUTPOINTS};
+    if (vOutPoints.size() > max_outpoints)
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max outpoints exceeded (max: %d, tried: %d)", max_outpoints, vOutPoints.size()));
 
     // check spentness and form a bitmap (as well as a JSON capable human-readable string representation)
     std::vector<unsigned char> bitmap;
@@ -856,6 +955,7 @@ static bool rest_getutxos(const std::any& context, HTTPRequest* req, const std::
     std::string bitmapStringRepresentation;
     std::vector<bool> hits;
     bitmap.resize((vOutPoints.size() + 7) / 8);
+    hits.reserve(vOutPoints.size());
     ChainstateManager* maybe_chainman = GetChainman(context, req);
     if (!maybe_chainman) return false;
     ChainstateManager& chainman = *maybe_chainman;
@@ -863,11 +963,13 @@ static bool rest_getutxos(const std::any& context, HTTPRequest* req, const std::
     uint256 active_hash;
     {
         auto process_utxos = [&vOutPoints, &outs, &hits, &active_height, &active_hash, &chainman](const CCoinsView& view, const CTxMemPool* mempool) EXCLUSIVE_LOCKS_REQUIRED(chainman.GetMutex()) {
-            for (const COutPoint& vOutPoint : vOutPoints) {
-                Coin coin;
-                bool hit = (!mempool || !mempool->isSpent(vOutPoint)) && view.GetCoin(vOutPoint, coin);
+            // Look the coins up as one batch, which reads neighbouring outpoints together
+            std::vector<std::optional<Coin>> coins;
+            view.GetCoins(vOutPoints, coins);
+            for (size_t i = 0; i < vOutPoints.size(); ++i) {
+                bool hit = (!mempool || !mempool->isSpent(vOutPoints[i])) && coins[i];
                 hits.push_back(hit);
-                if (hit) outs.emplace_back(std::move(coin));
+                if (hit) outs.emplace_back(std::move(*coins[i]));
             }
             active_height = chainman.ActiveHeight();
             active_hash = chainman.ActiveTip()->GetBlockHash();
@@ -1001,6 +1103,253 @@ static bool rest_blockhash_by_height(const std::any& context, HTTPRequest* req,
     }
 }
 
+static bool rest_storage_range(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+    std::string uuid;
+    const RESTResponseFormat rf = ParseDataFormat(uuid, str_uri_part);
+
+    if (!g_storage_index) {
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Storage index is not enabled (-storageindex)");
+    }
+    if (uuid.size() != OPENCODING_UUID * 2 || !IsHex(uuid)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid uuid: " + SanitizeString(uuid));
+    }
+
+    std::optional<uint64_t> offset, length;
+    try {
+        offset = ToIntegral<uint64_t>(req->GetQueryParameter("offset").value_or("0"));
+        length = ToIntegral<uint64_t>(req->GetQueryParameter("length").value_or(ToString(MAX_FETCHRANGE_LENGTH)));
+    } catch (const std::runtime_error& e) {
+        return RESTERR(req, HTTP_BAD_REQUEST, e.what());
+    }
+    if (!offset || !length || *length > MAX_FETCHRANGE_LENGTH) {
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Invalid range, expected ?offset=<offset>&length=<length> with a length of at most %u", MAX_FETCHRANGE_LENGTH));
+    }
+
+    int error_level = NO_ERROR;
+    uint64_t filelen;
+    std::vector<unsigned char> data;
+    if (!fetch_asset_range(uuid, *offset, *length, data, filelen, error_level)) {
+        if (error_level == ERR_CHUNKAUTHNONE) return RESTERR(req, HTTP_NOT_FOUND, uuid + " not found");
+        if (error_level == ERR_FILELENGTH) return RESTERR(req, HTTP_BAD_REQUEST, "Offset past the end of the file");
+        return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, strprintf("Unable to read %s, error %d", uuid, error_level));
+    }
+
+    switch (rf) {
+    case RESTResponseFormat::BINARY: {
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, std::string(data.begin(), data.end()));
+        return true;
+    }
+    case RESTResponseFormat::HEX: {
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(data) + "\n");
+        return true;
+    }
+    case RESTResponseFormat::JSON: {
+        UniValue resp(UniValue::VOBJ);
+        resp.pushKV("uuid", uuid);
+        resp.pushKV("offset", *offset);
+        resp.pushKV("length", (uint64_t)data.size());
+        resp.pushKV("filelength", filelen);
+        resp.pushKV("data", HexStr(data));
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, resp.write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+/**
+ * Parse the value of a Range header into the offset and length of the bytes it asks
+ * for out of a file of filelen bytes. Anything but a single byte range gives std::nullopt,
+ * so the whole file is sent, as does a range past the end, which also sets unsatisfiable.
+ */
+static std::optional<std::pair<uint64_t, uint64_t>> ParseByteRange(const std::string& range, uint64_t filelen, bool& unsatisfiable)
+{
+    unsatisfiable = false;
+    if (range.compare(0, 6, "bytes=") != 0) return std::nullopt;
+    const std::vector<std::string> bounds{SplitString(range.substr(6), '-')};
+    if (bounds.size() != 2) return std::nullopt;
+
+    // Suffix range, the last bytes of the file
+    if (bounds[0].empty()) {
+        const auto suffix{ToIntegral<uint64_t>(bounds[1])};
+        if (!suffix) return std::nullopt;
+        if (*suffix == 0 || filelen == 0) {
+            unsatisfiable = true;
+            return std::nullopt;
+        }
+        const uint64_t length{std::min(*suffix, filelen)};
+        return std::make_pair(filelen - length, length);
+    }
+
+    const auto first{ToIntegral<uint64_t>(bounds[0])};
+    const auto last{bounds[1].empty() ? std::optional<uint64_t>{filelen - 1} : ToIntegral<uint64_t>(bounds[1])};
+    if (!first || !last || *last < *first) return std::nullopt;
+    if (*first >= filelen) {
+        unsatisfiable = true;
+        return std::nullopt;
+    }
+    return std::make_pair(*first, std::min(*last, filelen - 1) - *first + 1);
+}
+
+static std::string StorageContentType(const std::string& extension)
+{
+    const auto it{STORAGE_CONTENT_TYPES.find(ToLower(extension))};
+    return it == STORAGE_CONTENT_TYPES.end() ? "application/octet-stream" : it->second;
+}
+
+static bool rest_storage(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+    const std::string uuid{str_uri_part.substr(0, str_uri_part.find('?'))};
+
+    if (!g_storage_index) {
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, "Storage index is not enabled (-storageindex)");
+    }
+    if (uuid.size() != OPENCODING_UUID * 2 || !IsHex(uuid)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid uuid: " + SanitizeString(uuid));
+    }
+
+    int error_level = NO_ERROR;
+    asset_range_reader reader(uuid);
+    if (!reader.open(error_level)) {
+        if (error_level == ERR_CHUNKAUTHNONE) return RESTERR(req, HTTP_NOT_FOUND, uuid + " not found");
+        return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, strprintf("Unable to read %s, error %d", uuid, error_level));
+    }
+    const uint64_t filelen{reader.filelen()};
+
+    uint64_t offset{0};
+    uint64_t length{filelen};
+    HTTPStatusCode status{HTTP_OK};
+    if (const auto [present, range] = req->GetHeader("Range"); present) {
+        bool unsatisfiable;
+        const auto byte_range{ParseByteRange(range, filelen, unsatisfiable)};
+        if (unsatisfiable) {
+            req->WriteHeader("Content-Range", strprintf("bytes */%u", filelen));
+            return RESTERR(req, HTTP_RANGE_NOT_SATISFIABLE, "Range not satisfiable");
+        }
+        if (byte_range) {
+            std::tie(offset, length) = *byte_range;
+            status = HTTP_PARTIAL_CONTENT;
+            req->WriteHeader("Content-Range", strprintf("bytes %u-%u/%u", offset, offset + length - 1, filelen));
+        }
+    }
+
+    // No Content-Length, so the reply goes out with chunked transfer encoding as the file is read
+    req->WriteHeader("Content-Type", StorageContentType(reader.extension()));
+    req->WriteHeader("X-Content-Type-Options", "nosniff");
+    req->WriteHeader("Accept-Ranges", "bytes");
+    req->WriteReplyStart(status);
+    if (req->GetRequestMethod() == HTTPRequest::HEAD) {
+        req->WriteReplyEnd();
+        return true;
+    }
+
+    // Gather the chunks read into larger pieces of the reply. Once the reply has started an error
+    // can only drop the connection, which the client sees as a body cut short
+    std::vector<unsigned char> piece;
+    piece.reserve(STORAGE_STREAM_PIECE);
+    bool complete = reader.read(offset, length, error_level, [&](Span<const unsigned char> bytes) {
+        piece.insert(piece.end(), bytes.begin(), bytes.end());
+        if (piece.size() < STORAGE_STREAM_PIECE) return true;
+        const bool sent{req->WriteReplyChunk(piece)};
+        piece.clear();
+        return sent;
+    });
+    complete = complete && req->WriteReplyChunk(piece);
+    if (!complete) {
+        LogPrint(BCLog::HTTP, "Reply for %s cut short, error %d\n", uuid, error_level);
+    }
+    req->WriteReplyEnd(complete);
+    return complete;
+}
+
+static bool rest_storage_chunks(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+    std::string hash_str;
+    const RESTResponseFormat rf = ParseDataFormat(hash_str, str_uri_part);
+
+    uint256 hash;
+    if (!ParseHashStr(hash_str, hash)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hash_str);
+    }
+
+    ChainstateManager* maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) return false;
+    ChainstateManager& chainman = *maybe_chainman;
+    const CBlockIndex* pblockindex;
+    {
+        LOCK(cs_main);
+        pblockindex = chainman.m_blockman.LookupBlockIndex(hash);
+        if (!pblockindex) {
+            return RESTERR(req, HTTP_NOT_FOUND, hash_str + " not found");
+        }
+        if (chainman.m_blockman.IsBlockPruned(pblockindex)) {
+            return RESTERR(req, HTTP_NOT_FOUND, hash_str + " not available (pruned data)");
+        }
+    }
+
+    // The payloads of a block never change, in any format
+    const std::string etag{strprintf("\"%s-storage%d\"", hash.GetHex(), static_cast<int>(rf))};
+    req->WriteHeader("ETag", etag);
+    if (ClientHasETag(req, etag)) {
+        req->WriteReply(HTTP_NOT_MODIFIED);
+        return true;
+    }
+
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pblockindex, chainman.GetParams().GetConsensus())) {
+        return RESTERR(req, HTTP_NOT_FOUND, hash_str + " not found");
+    }
+    const std::vector<StorageTxPayloads> txs{ExtractBlockStoragePayloads(block)};
+
+    switch (rf) {
+    case RESTResponseFormat::BINARY: {
+        DataStream ss{};
+        ss << txs;
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ss.str());
+        return true;
+    }
+    case RESTResponseFormat::HEX: {
+        DataStream ss{};
+        ss << txs;
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(ss) + "\n");
+        return true;
+    }
+    case RESTResponseFormat::JSON: {
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, StoragePayloadsToJSON(hash, pblockindex->nHeight, txs).write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+/** Node metrics in the Prometheus text format */
+static bool rest_metrics(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!str_uri_part.empty()) {
+        return RESTERR(req, HTTP_NOT_FOUND, "Invalid URI format. Expected /rest/metrics");
+    }
+    const NodeContext* const node = GetNodeContext(context, req);
+    if (!node) return false;
+
+    req->WriteHeader("Content-Type", "text/plain; version=0.0.4");
+    req->WriteReply(HTTP_OK, node::FormatMetrics(*node));
+    return true;
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(const std::any& context, HTTPRequest* req, const std::string& strReq);
@@ -1017,6 +1366,10 @@ static const struct {
       {"/rest/deploymentinfo/", rest_deploymentinfo},
       {"/rest/deploymentinfo", rest_deploymentinfo},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/storagerange/", rest_storage_range},
+      {"/rest/storagechunks/", rest_storage_chunks},
+      {"/rest/storage/", rest_storage},
+      {"/rest/metrics", rest_metrics},
 };
 
 void StartREST(const std::any& context)
@@ -1037,3 +1390,18 @@ void StopREST()
         UnregisterHTTPHandler(up.prefix, false);
     }
 }
+
+void StartMetrics(const std::any& context)
+{
+    auto handler = [context](HTTPRequest* req, const std::string& prefix) { return rest_metrics(context, req, prefix); };
+    RegisterHTTPHandler("/metrics", true, handler, /*metrics=*/true);
+}
+
+void InterruptMetrics()
+{
+}
+
+void StopMetrics()
+{
+    UnregisterHTTPHandler("/metrics", true, /*metrics=*/true);
+}
@@ -16,22 +16,28 @@
 #include <deploymentinfo.h>
 #include <deploymentstatus.h>
 #include <hash.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/stakeindex.h>
+#include <key_io.h>
 #include <kernel/coinstats.h>
 #include <logging/timer.h>
 #include <net.h>
 #include <net_processing.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
+#include <node/jobs.h>
 #include <node/transaction.h>
 #include <node/utxo_snapshot.h>
 #include <primitives/transaction.h>
 #include <pow.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
 #include <script/descriptor.h>
+#include <script/standard.h>
 #include <streams.h>
 #include <sync.h>
 #include <txdb.h>
@@ -53,6 +59,7 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <thread>
 
 using kernel::CCoinsStats;
 using kernel::CoinStatsHashType;
@@ -167,19 +174,22 @@ UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex
     return result;
 }
 
-UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, TxVerbosity verbosity)
+/** Push the sizes and weight of a block, the members of its description between the header's and "tx" */
+static void blockSizesToJSON(const CBlock& block, UniValue& result)
 {
-    UniValue result = blockheaderToJSON(tip, blockindex);
-
     result.pushKV("strippedsize", (int)::GetSerializeSize(block, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS));
     result.pushKV("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION));
     result.pushKV("weight", (int)::GetBlockWeight(block));
-    UniValue txs(UniValue::VARR);
+}
 
+/** Pass the description of each transaction of a block, in order, to fn */
+template <typename F>
+static void ForEachBlockTxToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex* blockindex, TxVerbosity verbosity, F fn)
+{
     switch (verbosity) {
         case TxVerbosity::SHOW_TXID:
             for (const CTransactionRef& tx : block.vtx) {
-                txs.push_back(tx->GetHash().GetHex());
+                fn(UniValue{tx->GetHash().GetHex()});
             }
             break;
 
@@ -195,16 +205,133 @@ UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIn
                 const CTxUndo* txundo = (have_undo && i > 0) ? &blockUndo.vtxundo.at(i - 1) : nullptr;
                 UniValue objTx(UniValue::VOBJ);
                 TxToUniv(*tx, /*block_hash=*/uint256(), /*entry=*/objTx, /*include_hex=*/true, RPCSerializationFlags(), txundo, verbosity);
-                txs.push_back(objTx);
+                fn(std::move(objTx));
             }
             break;
     }
+}
 
+UniValue blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, TxVerbosity verbosity)
+{
+    UniValue result = blockheaderToJSON(tip, blockindex);
+    blockSizesToJSON(block, result);
+
+    UniValue txs(UniValue::VARR);
+    ForEachBlockTxToJSON(blockman, block, blockindex, verbosity, [&](UniValue&& tx) {
+        txs.push_back(std::move(tx));
+    });
     result.pushKV("tx", txs);
 
     return result;
 }
 
+/** Write the members of a block's description after the header's into the open object */
+static void blockBodyToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex* blockindex, TxVerbosity verbosity, JSONWriter& writer)
+{
+    UniValue sizes(UniValue::VOBJ);
+    blockSizesToJSON(block, sizes);
+    writer.Members(sizes);
+    writer.Key("tx");
+    writer.BeginArray();
+    ForEachBlockTxToJSON(blockman, block, blockindex, verbosity, [&](UniValue&& tx) {
+        writer.Value(tx);
+    });
+    writer.EndArray();
+}
+
+void blockToJSON(BlockManager& blockman, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, TxVerbosity verbosity, JSONWriter& writer)
+{
+    writer.BeginObject();
+    writer.Members(blockheaderToJSON(tip, blockindex));
+    blockBodyToJSON(blockman, block, blockindex, verbosity, writer);
+    writer.EndObject();
+}
+
+BlockRenderCache g_block_render_cache;
+
+//! Bookkeeping a cached rendering costs besides its text
+static constexpr size_t BLOCK_RENDER_ENTRY_OVERHEAD{128};
+
+void BlockRenderCache::Trim()
+{
+    while (m_size > m_max_size && !m_entries.empty()) {
+        m_size -= m_entries.back().second->size() + BLOCK_RENDER_ENTRY_OVERHEAD;
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+}
+
+void BlockRenderCache::SetMaxSize(size_t max_size)
+{
+    LOCK(m_mutex);
+    m_max_size = max_size;
+    Trim();
+}
+
+std::shared_ptr<const std::string> BlockRenderCache::Get(const Key& key)
+{
+    LOCK(m_mutex);
+    const auto it{m_index.find(key)};
+    if (it == m_index.end()) return nullptr;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->second;
+}
+
+void BlockRenderCache::Add(const Key& key, std::shared_ptr<const std::string> rendering)
+{
+    LOCK(m_mutex);
+    // A rendering that would not fit is not worth evicting everything else for
+    if (m_index.count(key) || rendering->size() + BLOCK_RENDER_ENTRY_OVERHEAD > m_max_size / 2) return;
+    m_size += rendering->size() + BLOCK_RENDER_ENTRY_OVERHEAD;
+    m_entries.emplace_front(key, std::move(rendering));
+    m_index.emplace(key, m_entries.begin());
+    Trim();
+}
+
+bool IsBlockRenderCacheable(const CChain& chain, const CBlockIndex* blockindex)
+{
+    AssertLockHeld(::cs_main);
+    // Deep in the active chain, the block's undo data, and so the fees and
+    // prevouts of its transactions, are there to stay
+    return chain.Contains(blockindex) && chain.Height() - blockindex->nHeight + 1 >= BLOCK_RENDER_CACHE_MIN_DEPTH;
+}
+
+std::shared_ptr<const std::string> CachedBlockHex(const CBlockIndex* blockindex)
+{
+    const BlockRenderCache::Key key{blockindex->GetBlockHash(), std::nullopt};
+    if (auto rendering{g_block_render_cache.Get(key)}) return rendering;
+
+    CBlock block;
+    if (!ReadBlockFromDisk(block, blockindex, Params().GetConsensus())) return nullptr;
+    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
+    ssBlock << block;
+    auto rendering{std::make_shared<const std::string>(HexStr(ssBlock))};
+    g_block_render_cache.Add(key, rendering);
+    return rendering;
+}
+
+std::shared_ptr<const std::string> CachedBlockJSONBody(BlockManager& blockman, const CBlockIndex* blockindex, TxVerbosity verbosity)
+{
+    const BlockRenderCache::Key key{blockindex->GetBlockHash(), verbosity};
+    if (auto rendering{g_block_render_cache.Get(key)}) return rendering;
+
+    CBlock block;
+    if (!ReadBlockFromDisk(block, blockindex, Params().GetConsensus())) return nullptr;
+    std::string body;
+    JSONWriter writer{[&](Span<const unsigned char> piece) {
+        body.append(piece.begin(), piece.end());
+        return true;
+    }};
+    writer.BeginObject();
+    blockBodyToJSON(blockman, block, blockindex, verbosity, writer);
+    writer.EndObject();
+    writer.Flush();
+    // The members, without the braces around them
+    auto rendering{std::make_shared<const std::string>(body, 1, body.size() - 2)};
+    g_block_render_cache.Add(key, rendering);
+    return rendering;
+}
+
 static RPCHelpMan getblockcount()
 {
     return RPCHelpMan{"getblockcount",
@@ -220,8 +347,7 @@ static RPCHelpMan getblockcount()
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
     ChainstateManager& chainman = EnsureAnyChainman(request.context);
-    LOCK(cs_main);
-    return chainman.ActiveChain().Height();
+    return EnsureTipSnapshot(chainman)->height;
 },
     };
 }
@@ -240,8 +366,7 @@ static RPCHelpMan getbestblockhash()
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
     ChainstateManager& chainman = EnsureAnyChainman(request.context);
-    LOCK(cs_main);
-    return chainman.ActiveChain().Tip()->GetBlockHash().GetHex();
+    return EnsureTipSnapshot(chainman)->hash.GetHex();
 },
     };
 }
@@ -426,10 +551,10 @@ static RPCHelpMan getdifficulty()
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
     ChainstateManager& chainman = EnsureAnyChainman(request.context);
-    LOCK(cs_main);
+    const auto snapshot{EnsureTipSnapshot(chainman)};
     UniValue obj(UniValue::VOBJ);
-    obj.pushKV("proof-of-work", GetDifficulty(chainman.ActiveChain().Tip()));
-    obj.pushKV("proof-of-stake", GetDifficulty(GetLastPoSBlockIndex(chainman.ActiveChain().Tip())));
+    obj.pushKV("proof-of-work", GetDifficulty(snapshot->tip));
+    obj.pushKV("proof-of-stake", GetDifficulty(snapshot->last_pos));
     return obj;
 },
     };
@@ -562,14 +687,9 @@ static RPCHelpMan getblockheader()
     if (!request.params[1].isNull())
         fVerbose = request.params[1].get_bool();
 
-    const CBlockIndex* pblockindex;
-    const CBlockIndex* tip;
-    {
-        ChainstateManager& chainman = EnsureAnyChainman(request.context);
-        LOCK(cs_main);
-        pblockindex = chainman.m_blockman.LookupBlockIndex(hash);
-        tip = chainman.ActiveChain().Tip();
-    }
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    const CBlockIndex* tip{EnsureTipSnapshot(chainman)->tip};
+    const CBlockIndex* pblockindex{WITH_LOCK(cs_main, return chainman.m_blockman.LookupBlockIndex(hash))};
 
     if (!pblockindex) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
@@ -740,6 +860,7 @@ static RPCHelpMan getblock()
 
     const CBlockIndex* pblockindex;
     const CBlockIndex* tip;
+    bool cacheable;
     ChainstateManager& chainman = EnsureAnyChainman(request.context);
     {
         LOCK(cs_main);
@@ -749,12 +870,20 @@ static RPCHelpMan getblock()
         if (!pblockindex) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
         }
+        if (chainman.m_blockman.IsBlockPruned(pblockindex)) {
+            throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+        }
+        cacheable = IsBlockRenderCacheable(chainman.ActiveChain(), pblockindex);
     }
 
-    const CBlock block{GetBlockChecked(chainman.m_blockman, pblockindex)};
-
     if (verbosity <= 0)
     {
+        if (cacheable) {
+            const auto hex{CachedBlockHex(pblockindex)};
+            if (!hex) throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+            return *hex;
+        }
+        const CBlock block{GetBlockChecked(chainman.m_blockman, pblockindex)};
         CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
         ssBlock << block;
         std::string strHex = HexStr(ssBlock);
@@ -770,6 +899,23 @@ static RPCHelpMan getblock()
         tx_verbosity = TxVerbosity::SHOW_DETAILS_AND_PREVOUT;
     }
 
+    // The transactions in full are the bulk of the result, stream it if the transport can
+    if (tx_verbosity != TxVerbosity::SHOW_TXID && request.result_stream && cacheable) {
+        const auto body{CachedBlockJSONBody(chainman.m_blockman, pblockindex, tx_verbosity)};
+        if (!body) throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+        JSONWriter& writer{*request.StreamResult()};
+        writer.BeginObject();
+        writer.Members(blockheaderToJSON(tip, pblockindex));
+        writer.RawMembers(*body);
+        writer.EndObject();
+        return NullUniValue;
+    }
+
+    const CBlock block{GetBlockChecked(chainman.m_blockman, pblockindex)};
+    if (JSONWriter* writer{tx_verbosity != TxVerbosity::SHOW_TXID ? request.StreamResult() : nullptr}) {
+        blockToJSON(chainman.m_blockman, block, tip, pblockindex, tx_verbosity, *writer);
+        return NullUniValue;
+    }
     return blockToJSON(chainman.m_blockman, block, tip, pblockindex, tx_verbosity);
 },
     };
@@ -1258,6 +1404,15 @@ RPCHelpMan getblockchaininfo()
                 {RPCResult::Type::NUM, "pruneheight", /*optional=*/true, "height of the last block pruned, plus one (only present if pruning is enabled)"},
                 {RPCResult::Type::BOOL, "automatic_pruning", /*optional=*/true, "whether automatic pruning is enabled (only present if pruning is enabled)"},
                 {RPCResult::Type::NUM, "prune_target_size", /*optional=*/true, "the target size used by pruning (only present if automatic pruning is enabled)"},
+                {RPCResult::Type::NUM, "stored_pow_skipped", "proof-of-work checks skipped reading back blocks already connected, since startup"},
+                {RPCResult::Type::OBJ, "blockcache", "blocks read from disk repeatedly, kept in memory (see -blockcachesize)",
+                {
+                    {RPCResult::Type::NUM, "hits", "reads served from the cache since startup"},
+                    {RPCResult::Type::NUM, "misses", "reads from disk since startup"},
+                    {RPCResult::Type::NUM, "blocks", "the number of blocks cached"},
+                    {RPCResult::Type::NUM, "usage", "the memory the cached blocks take, in bytes"},
+                    {RPCResult::Type::NUM, "max_usage", "the memory the cached blocks may take, in bytes"},
+                }},
                 {RPCResult::Type::STR, "warnings", "any network and blockchain warnings"},
             }},
         RPCExamples{
@@ -1267,29 +1422,38 @@ RPCHelpMan getblockchaininfo()
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
     ChainstateManager& chainman = EnsureAnyChainman(request.context);
-    LOCK(cs_main);
     Chainstate& active_chainstate = chainman.ActiveChainstate();
 
-    const CBlockIndex& tip{*CHECK_NONFATAL(active_chainstate.m_chain.Tip())};
-    const int height{tip.nHeight};
+    // Only what the tip snapshot does not hold is read under cs_main
+    const auto snapshot{EnsureTipSnapshot(chainman)};
+    const CBlockIndex& tip{*snapshot->tip};
+    int headers;
+    std::optional<int> prune_height;
+    {
+        LOCK(cs_main);
+        headers = chainman.m_best_header ? chainman.m_best_header->nHeight : -1;
+        if (chainman.m_blockman.IsPruneMode()) {
+            prune_height = chainman.m_blockman.GetFirstStoredBlock(tip)->nHeight;
+        }
+    }
     UniValue obj(UniValue::VOBJ);
     obj.pushKV("chain", chainman.GetParams().NetworkIDString());
-    obj.pushKV("blocks", height);
-    obj.pushKV("headers", chainman.m_best_header ? chainman.m_best_header->nHeight : -1);
-    obj.pushKV("bestblockhash", tip.GetBlockHash().GetHex());
+    obj.pushKV("blocks", snapshot->height);
+    obj.pushKV("headers", headers);
+    obj.pushKV("bestblockhash", snapshot->hash.GetHex());
     UniValue obj2(UniValue::VOBJ);
     obj2.pushKV("proof-of-work", GetDifficulty(&tip));
-    obj2.pushKV("proof-of-stake", GetDifficulty(GetLastPoSBlockIndex(&tip)));
+    obj2.pushKV("proof-of-stake", GetDifficulty(snapshot->last_pos));
     obj.pushKV("difficulty", obj2);
-    obj.pushKV("time", tip.GetBlockTime());
-    obj.pushKV("mediantime", tip.GetMedianTimePast());
-    obj.pushKV("verificationprogress", GuessVerificationProgress(chainman.GetParams().TxData(), &tip));
+    obj.pushKV("time", snapshot->time);
+    obj.pushKV("mediantime", snapshot->median_time);
+    obj.pushKV("verificationprogress", snapshot->verification_progress);
     obj.pushKV("initialblockdownload", active_chainstate.IsInitialBlockDownload());
-    obj.pushKV("chainwork", tip.nChainWork.GetHex());
+    obj.pushKV("chainwork", snapshot->chain_work.GetHex());
     obj.pushKV("size_on_disk", chainman.m_blockman.CalculateCurrentUsage());
     obj.pushKV("pruned", chainman.m_blockman.IsPruneMode());
-    if (chainman.m_blockman.IsPruneMode()) {
-        obj.pushKV("pruneheight", chainman.m_blockman.GetFirstStoredBlock(tip)->nHeight);
+    if (prune_height) {
+        obj.pushKV("pruneheight", *prune_height);
 
         const bool automatic_pruning{chainman.m_blockman.GetPruneTarget() != BlockManager::PRUNE_TARGET_MANUAL};
         obj.pushKV("automatic_pruning",  automatic_pruning);
@@ -1298,6 +1462,15 @@ RPCHelpMan getblockchaininfo()
         }
     }
 
+    obj.pushKV("stored_pow_skipped", node::g_stored_pow_skipped.load());
+    const node::BlockCacheStats block_cache{node::g_block_cache.GetStats()};
+    UniValue block_cache_obj(UniValue::VOBJ);
+    block_cache_obj.pushKV("hits", block_cache.hits);
+    block_cache_obj.pushKV("misses", block_cache.misses);
+    block_cache_obj.pushKV("blocks", uint64_t{block_cache.blocks});
+    block_cache_obj.pushKV("usage", uint64_t{block_cache.bytes});
+    block_cache_obj.pushKV("max_usage", uint64_t{block_cache.max_bytes});
+    obj.pushKV("blockcache", std::move(block_cache_obj));
     obj.pushKV("warnings", GetWarnings(false).original);
     return obj;
 },
@@ -1652,8 +1825,7 @@ static RPCHelpMan getchaintxstats()
     int blockcount = 30 * 24 * 60 * 60 / chainman.GetParams().GetConsensus().nPowTargetSpacing; // By default: 1 month
 
     if (request.params[1].isNull()) {
-        LOCK(cs_main);
-        pindex = chainman.ActiveChain().Tip();
+        pindex = EnsureTipSnapshot(chainman)->tip;
     } else {
         uint256 hash(ParseHashV(request.params[1], "blockhash"));
         LOCK(cs_main);
@@ -2038,6 +2210,7 @@ bool FindScriptPubKey(std::atomic<int>& scan_progress, const std::atomic<bool>&
             // update progress reference every 256 item
             uint32_t high = 0x100 * *key.hash.begin() + *(key.hash.begin() + 1);
             scan_progress = (int)(high * 100.0 / 65536.0 + 0.5);
+            node::SetJobProgress(scan_progress, 100);
         }
         if (needles.count(coin.out.scriptPubKey)) {
             out_results.emplace(key, coin);
@@ -2045,6 +2218,7 @@ bool FindScriptPubKey(std::atomic<int>& scan_progress, const std::atomic<bool>&
         cursor->Next();
     }
     scan_progress = 100;
+    node::SetJobProgress(scan_progress, 100);
     return true;
 }
 } // namespace
@@ -2394,6 +2568,10 @@ static RPCHelpMan scanblocks()
         if (!BlockFilterTypeByName(filtertype_name, filtertype)) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown filtertype");
         }
+        // The storage filter holds uuids and tenants, not output scripts
+        if (filtertype == BlockFilterType::STORAGE) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "scanblocks does not scan the storage filter");
+        }
 
         UniValue options{request.params[5].isNull() ? UniValue::VOBJ : request.params[5]};
         bool filter_false_positives{options.exists("filter_false_positives") ? options["filter_false_positives"].get_bool() : false};
@@ -2586,6 +2764,299 @@ static RPCHelpMan getblockfilter()
     };
 }
 
+static AddressIndex& EnsureAddressIndex()
+{
+    if (!g_address_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "The address index is not enabled, start with -addressindex");
+    }
+    if (!g_address_index->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("The address index is still syncing, at height %d", g_address_index->GetSummary().best_block_height));
+    }
+    return *g_address_index;
+}
+
+static RPCHelpMan getaddressoutputs()
+{
+    return RPCHelpMan{"getaddressoutputs",
+                "\nList the outputs in the chain paying to an address or script, in order of height, with the inputs spending them.\n"
+                "Requires -addressindex.\n",
+                {
+                    {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The address, or the hex-encoded scriptPubKey"},
+                    {"start_height", RPCArg::Type::NUM, RPCArg::Default{0}, "The height of the first block to list outputs of"},
+                    {"end_height", RPCArg::Type::NUM, RPCArg::DefaultHint{"the tip"}, "The height of the last block to list outputs of"},
+                    {"count", RPCArg::Type::NUM, RPCArg::Default{0}, "The most outputs to list, 0 for all. Page through more by starting at the height of the last one listed, which may be listed again"},
+                    {"unspent_only", RPCArg::Type::BOOL, RPCArg::Default{false}, "Only list the outputs not spent in the chain"},
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "", "",
+                        {
+                            {RPCResult::Type::NUM, "height", "The height of the block the output was created in"},
+                            {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                            {RPCResult::Type::NUM, "vout", "The output number"},
+                            {RPCResult::Type::STR_AMOUNT, "amount", "The value of the output in " + CURRENCY_UNIT},
+                            {RPCResult::Type::OBJ, "spent", /*optional=*/true, "The input spending the output, if it is spent",
+                            {
+                                {RPCResult::Type::STR_HEX, "txid", "The spending transaction id"},
+                                {RPCResult::Type::NUM, "vin", "The input number"},
+                                {RPCResult::Type::NUM, "height", "The height of the block the output was spent in"},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getaddressoutputs", "\"" + EXAMPLE_ADDRESS[0] + "\"") +
+                    HelpExampleCli("getaddressoutputs", "\"" + EXAMPLE_ADDRESS[0] + "\" 1000 2000 100 true") +
+                    HelpExampleRpc("getaddressoutputs", "\"" + EXAMPLE_ADDRESS[0] + "\", 1000")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const std::string& address{request.params[0].get_str()};
+    CScript script;
+    const CTxDestination dest{DecodeDestination(address)};
+    if (IsValidDestination(dest)) {
+        script = GetScriptForDestination(dest);
+    } else if (IsHex(address)) {
+        const std::vector<unsigned char> data{ParseHex(address)};
+        script = CScript(data.begin(), data.end());
+    } else {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address or script");
+    }
+
+    AddressQuery query;
+    if (!request.params[1].isNull()) query.start_height = request.params[1].getInt<int>();
+    if (!request.params[2].isNull()) query.end_height = request.params[2].getInt<int>();
+    if (query.start_height < 0 || query.end_height < query.start_height) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+    }
+    if (!request.params[3].isNull()) {
+        const int count{request.params[3].getInt<int>()};
+        if (count < 0) throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative count");
+        query.count = count;
+    }
+    if (!request.params[4].isNull()) query.unspent_only = request.params[4].get_bool();
+
+    std::vector<AddressOutput> outputs;
+    if (!EnsureAddressIndex().FindOutputs(script, query, outputs)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read the address index");
+    }
+
+    UniValue ret(UniValue::VARR);
+    for (const AddressOutput& output : outputs) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("height", output.height);
+        entry.pushKV("txid", output.outpoint.hash.GetHex());
+        entry.pushKV("vout", output.outpoint.n);
+        entry.pushKV("amount", ValueFromAmount(output.value));
+        if (output.spent) {
+            UniValue spent(UniValue::VOBJ);
+            spent.pushKV("txid", output.spent->txid.GetHex());
+            spent.pushKV("vin", output.spent->input);
+            spent.pushKV("height", output.spent->height);
+            entry.pushKV("spent", std::move(spent));
+        }
+        ret.push_back(std::move(entry));
+    }
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan getspentinfo()
+{
+    return RPCHelpMan{"getspentinfo",
+                "\nReturn the input in the chain spending an output.\n"
+                "Requires -addressindex.\n",
+                {
+                    {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The transaction id"},
+                    {"vout", RPCArg::Type::NUM, RPCArg::Optional::NO, "The output number"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR_HEX, "txid", "The spending transaction id"},
+                        {RPCResult::Type::NUM, "vin", "The input number"},
+                        {RPCResult::Type::NUM, "height", "The height of the block the output was spent in"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getspentinfo", "\"mytxid\" 1") +
+                    HelpExampleRpc("getspentinfo", "\"mytxid\", 1")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const COutPoint outpoint{ParseHashV(request.params[0], "txid"), request.params[1].getInt<uint32_t>()};
+    AddressSpend spend;
+    if (!EnsureAddressIndex().FindSpend(outpoint, spend)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No spend of the output in the chain");
+    }
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("txid", spend.txid.GetHex());
+    ret.pushKV("vin", spend.input);
+    ret.pushKV("height", spend.height);
+    return ret;
+},
+    };
+}
+
+static StakeIndex& EnsureStakeIndex()
+{
+    if (!g_stake_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "The stake index is not enabled, start with -stakeindex");
+    }
+    if (!g_stake_index->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("The stake index is still syncing, at height %d", g_stake_index->GetSummary().best_block_height));
+    }
+    return *g_stake_index;
+}
+
+static UniValue StakeToJSON(const StakeRecord& stake)
+{
+    UniValue entry(UniValue::VOBJ);
+    entry.pushKV("height", stake.height);
+    entry.pushKV("blockhash", stake.block_hash.GetHex());
+    entry.pushKV("time", int64_t{stake.time});
+    entry.pushKV("kernel_txid", stake.kernel.hash.GetHex());
+    entry.pushKV("kernel_vout", stake.kernel.n);
+    entry.pushKV("stake_amount", ValueFromAmount(stake.stake_amount));
+    entry.pushKV("reward", ValueFromAmount(stake.reward));
+    entry.pushKV("hashproof", stake.hash_proof.GetHex());
+    return entry;
+}
+
+static RPCHelpMan getstakinghistory()
+{
+    return RPCHelpMan{"getstakinghistory",
+                "\nList the proof-of-stake blocks staked by an address or script, in order of height, with the totals staked and earned.\n"
+                "Requires -stakeindex.\n",
+                {
+                    {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The address, or the hex-encoded scriptPubKey, of the coinstake's first output"},
+                    {"start_height", RPCArg::Type::NUM, RPCArg::Default{0}, "The height of the first block to list"},
+                    {"end_height", RPCArg::Type::NUM, RPCArg::DefaultHint{"the tip"}, "The height of the last block to list"},
+                    {"count", RPCArg::Type::NUM, RPCArg::Default{0}, "The most blocks to list, 0 for all. Page through more by starting above the height of the last one listed"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "blocks", "The number of blocks listed"},
+                        {RPCResult::Type::STR_AMOUNT, "stake_amount", "The value of the kernel coins of the blocks listed, in " + CURRENCY_UNIT},
+                        {RPCResult::Type::STR_AMOUNT, "reward", "The rewards of the blocks listed, in " + CURRENCY_UNIT},
+                        {RPCResult::Type::ARR, "stakes", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::NUM, "height", "The block height"},
+                                {RPCResult::Type::STR_HEX, "blockhash", "The block hash"},
+                                {RPCResult::Type::NUM_TIME, "time", "The block time, expressed in " + UNIX_EPOCH_TIME},
+                                {RPCResult::Type::STR_HEX, "kernel_txid", "The transaction id of the kernel coin"},
+                                {RPCResult::Type::NUM, "kernel_vout", "The output number of the kernel coin"},
+                                {RPCResult::Type::STR_AMOUNT, "stake_amount", "The value of the kernel coin in " + CURRENCY_UNIT},
+                                {RPCResult::Type::STR_AMOUNT, "reward", "The value of the coinstake outputs less that of its inputs, in " + CURRENCY_UNIT},
+                                {RPCResult::Type::STR_HEX, "hashproof", "The proof-of-stake hash"},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getstakinghistory", "\"" + EXAMPLE_ADDRESS[0] + "\"") +
+                    HelpExampleCli("getstakinghistory", "\"" + EXAMPLE_ADDRESS[0] + "\" 1000 2000 100") +
+                    HelpExampleRpc("getstakinghistory", "\"" + EXAMPLE_ADDRESS[0] + "\", 1000")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const std::string& address{request.params[0].get_str()};
+    CScript script;
+    const CTxDestination dest{DecodeDestination(address)};
+    if (IsValidDestination(dest)) {
+        script = GetScriptForDestination(dest);
+    } else if (IsHex(address)) {
+        const std::vector<unsigned char> data{ParseHex(address)};
+        script = CScript(data.begin(), data.end());
+    } else {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address or script");
+    }
+
+    const int start_height{request.params[1].isNull() ? 0 : request.params[1].getInt<int>()};
+    const int end_height{request.params[2].isNull() ? std::numeric_limits<int>::max() : request.params[2].getInt<int>()};
+    if (start_height < 0 || end_height < start_height) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+    }
+    const int count{request.params[3].isNull() ? 0 : request.params[3].getInt<int>()};
+    if (count < 0) throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative count");
+
+    std::vector<StakeRecord> stakes;
+    if (!EnsureStakeIndex().FindStakes(script, start_height, end_height, count, stakes)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read the stake index");
+    }
+
+    CAmount stake_amount{0};
+    CAmount reward{0};
+    UniValue entries(UniValue::VARR);
+    for (const StakeRecord& stake : stakes) {
+        stake_amount += stake.stake_amount;
+        reward += stake.reward;
+        entries.push_back(StakeToJSON(stake));
+    }
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("blocks", uint64_t{stakes.size()});
+    ret.pushKV("stake_amount", ValueFromAmount(stake_amount));
+    ret.pushKV("reward", ValueFromAmount(reward));
+    ret.pushKV("stakes", std::move(entries));
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan getstakingstats()
+{
+    return RPCHelpMan{"getstakingstats",
+                "\nReturn network-wide staking statistics over a range of heights.\n"
+                "Requires -stakeindex.\n",
+                {
+                    {"start_height", RPCArg::Type::NUM, RPCArg::DefaultHint{"72 blocks below end_height"}, "The height of the first block of the range"},
+                    {"end_height", RPCArg::Type::NUM, RPCArg::DefaultHint{"the tip"}, "The height of the last block of the range"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "start_height", "The height of the first block of the range"},
+                        {RPCResult::Type::NUM, "end_height", "The height of the last block of the range"},
+                        {RPCResult::Type::NUM, "blocks", "The number of blocks in the range"},
+                        {RPCResult::Type::NUM, "pos_blocks", "The number of proof-of-stake blocks in the range"},
+                        {RPCResult::Type::STR_AMOUNT, "stake_amount", "The value of the kernel coins of the range's stakes, in " + CURRENCY_UNIT},
+                        {RPCResult::Type::STR_AMOUNT, "reward", "The rewards of the range's stakes, in " + CURRENCY_UNIT},
+                        {RPCResult::Type::NUM, "kernelsps", "The kernel hashes per second the range's stakes took, an estimate of the network stake weight"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getstakingstats", "") +
+                    HelpExampleCli("getstakingstats", "1000 2000") +
+                    HelpExampleRpc("getstakingstats", "1000, 2000")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    StakeIndex& index{EnsureStakeIndex()};
+    const int tip_height{index.GetSummary().best_block_height};
+    const int end_height{request.params[1].isNull() ? tip_height : request.params[1].getInt<int>()};
+    const int start_height{request.params[0].isNull() ? std::max(0, end_height - 71) : request.params[0].getInt<int>()};
+    if (start_height < 0 || end_height < start_height || end_height > tip_height) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+    }
+
+    StakeRangeStats stats;
+    if (!index.GetStats(start_height, end_height, stats)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read the stake index");
+    }
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("start_height", stats.start_height);
+    ret.pushKV("end_height", stats.end_height);
+    ret.pushKV("blocks", stats.end_height - stats.start_height + 1);
+    ret.pushKV("pos_blocks", stats.pos_blocks);
+    ret.pushKV("stake_amount", ValueFromAmount(stats.stake_amount));
+    ret.pushKV("reward", ValueFromAmount(stats.reward));
+    ret.pushKV("kernelsps", stats.kernels_per_second);
+    return ret;
+},
+    };
+}
+
 /**
  * Serialize the UTXO set to a file for loading elsewhere.
  *
@@ -2608,6 +3079,7 @@ static RPCHelpMan dumptxoutset()
                     {RPCResult::Type::STR, "path", "the absolute path that the snapshot was written to"},
                     {RPCResult::Type::STR_HEX, "txoutset_hash", "the hash of the UTXO set contents"},
                     {RPCResult::Type::NUM, "nchaintx", "the number of transactions in the chain up to and including the base block"},
+                    {RPCResult::Type::STR_HEX, "stake_modifier", "the stake modifier of the base block"},
                 }
         },
         RPCExamples{
@@ -2718,7 +3190,238 @@ UniValue CreateUTXOSnapshot(
     // Cast required because univalue doesn't have serialization specified for
     // `unsigned int`, nChainTx's type.
     result.pushKV("nchaintx", uint64_t{tip->nChainTx});
+    result.pushKV("stake_modifier", tip->nStakeModifier.ToString());
+    return result;
+}
+
+/**
+ * Load a UTXO set written by dumptxoutset into a snapshot chainstate.
+ *
+ * @see SnapshotMetadata
+ */
+static RPCHelpMan loadtxoutset()
+{
+    return RPCHelpMan{
+        "loadtxoutset",
+        "Load the serialized UTXO set from disk.\n"
+        "The snapshot is loaded into a second chainstate which syncs to the network's tip right away, "
+        "and is ready to stake once it has, while the original chainstate keeps validating the blocks "
+        "up to the snapshot base.\n"
+        "Only snapshots whose base block, UTXO set hash and stake modifier are listed in the chain "
+        "parameters are accepted. Wallets loaded on top of a snapshot can't rescan the blocks beneath it.",
+        {
+            {"path", RPCArg::Type::STR, RPCArg::Optional::NO, "Path to the snapshot file. If relative, will be prefixed by datadir."},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+                {
+                    {RPCResult::Type::NUM, "coins_loaded", "the number of coins loaded from the snapshot"},
+                    {RPCResult::Type::STR_HEX, "tip_hash", "the hash of the base of the snapshot"},
+                    {RPCResult::Type::NUM, "base_height", "the height of the base of the snapshot"},
+                    {RPCResult::Type::STR, "path", "the absolute path that the snapshot was loaded from"},
+                }
+        },
+        RPCExamples{
+            HelpExampleCli("loadtxoutset", "utxo.dat")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    ChainstateManager& chainman = EnsureChainman(node);
+    const ArgsManager& args{EnsureArgsman(node)};
+    const fs::path path = fsbridge::AbsPathJoin(args.GetDataDirNet(), fs::u8path(request.params[0].get_str()));
+
+    FILE* file{fsbridge::fopen(path, "rb")};
+    AutoFile afile{file};
+    if (afile.IsNull()) {
+        throw JSONRPCError(
+            RPC_INVALID_PARAMETER,
+            "Couldn't open file " + path.u8string() + " for reading.");
+    }
+
+    SnapshotMetadata metadata;
+    afile >> metadata;
+
+    // The snapshot can only be activated on top of the header of its base block,
+    // which a freshly started node may still be downloading.
+    const uint256& base_blockhash = metadata.m_base_blockhash;
+    const CBlockIndex* snapshot_start_block{nullptr};
+    for (int secs_waited{0}; secs_waited < 60 * 10; ++secs_waited) {
+        snapshot_start_block = WITH_LOCK(::cs_main, return chainman.m_blockman.LookupBlockIndex(base_blockhash));
+        if (snapshot_start_block) break;
+        if (!IsRPCRunning()) {
+            throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED, "Shutting down");
+        }
+        std::this_thread::sleep_for(std::chrono::seconds{1});
+    }
+    if (!snapshot_start_block) {
+        throw JSONRPCError(
+            RPC_INTERNAL_ERROR,
+            "Timed out waiting for base block header " + base_blockhash.ToString() + " to appear in headers chain");
+    }
+
+    if (!chainman.ActivateSnapshot(afile, metadata, /*in_memory=*/false)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to load UTXO snapshot " + path.u8string());
+    }
+    const CBlockIndex* new_tip{WITH_LOCK(::cs_main, return chainman.ActiveTip())};
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("coins_loaded", metadata.m_coins_count);
+    result.pushKV("tip_hash", new_tip->GetBlockHash().ToString());
+    result.pushKV("base_height", new_tip->nHeight);
+    result.pushKV("path", path.u8string());
     return result;
+},
+    };
+}
+
+static RPCHelpMan getblocktimestats()
+{
+    return RPCHelpMan{"getblocktimestats",
+                "\nReturns the spacing of the blocks within rolling windows of an hour, day, week, fortnight and month ending at the tip.\n"
+                "A window holds the blocks back from the tip whose time is less than its length before the tip's,\n"
+                "each counted with the interval from its parent.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "height", "the height of the tip the windows end at"},
+                        {RPCResult::Type::OBJ_DYN, "windows", "the statistics of each window, by window (hour, day, week, fortnight, month)", {
+                            {RPCResult::Type::OBJ, "window", "", {
+                                {RPCResult::Type::NUM, "span", "the length of the window in seconds"},
+                                {RPCResult::Type::NUM, "blocks", "the number of blocks within the window"},
+                                {RPCResult::Type::BOOL, "complete", "false if the window reaches back to the genesis block, leaving out the statistics below"},
+                                {RPCResult::Type::NUM, "average", /*optional=*/true, "the mean block interval in seconds"},
+                                {RPCResult::Type::NUM, "p10", /*optional=*/true, "the 10th percentile block interval in seconds"},
+                                {RPCResult::Type::NUM, "p50", /*optional=*/true, "the median block interval in seconds"},
+                                {RPCResult::Type::NUM, "p90", /*optional=*/true, "the 90th percentile block interval in seconds"},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getblocktimestats", "")
+            + HelpExampleRpc("getblocktimestats", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    const BlockTimeStats* stats;
+    int height;
+    {
+        LOCK(cs_main);
+        Chainstate& chainstate = chainman.ActiveChainstate();
+        const CBlockIndex* tip = CHECK_NONFATAL(chainstate.m_chain.Tip());
+        // The windows are only filled once the tip moves after startup
+        if (chainstate.m_block_time_stats.GetTip() != tip) {
+            chainstate.m_block_time_stats.SetTip(tip);
+        }
+        stats = &chainstate.m_block_time_stats;
+        height = tip->nHeight;
+    }
+
+    UniValue windows(UniValue::VOBJ);
+    for (size_t w = 0; w < NUM_BLOCK_TIME_WINDOWS; ++w) {
+        const BlockTimeWindow window = (BlockTimeWindow)w;
+        const BlockTimeWindowStats window_stats = stats->GetWindowStats(window);
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("span", BlockTimeWindowSpan(window));
+        entry.pushKV("blocks", (uint64_t)window_stats.blocks);
+        entry.pushKV("complete", window_stats.complete);
+        if (window_stats.complete) {
+            entry.pushKV("average", window_stats.average);
+            entry.pushKV("p10", window_stats.p10);
+            entry.pushKV("p50", window_stats.p50);
+            entry.pushKV("p90", window_stats.p90);
+        }
+        windows.pushKV(BlockTimeWindowName(window), entry);
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("height", height);
+    obj.pushKV("windows", windows);
+    return obj;
+},
+    };
+}
+
+static RPCHelpMan getblockvalidationstats()
+{
+    return RPCHelpMan{"getblockvalidationstats",
+                strprintf("\nReturns the time spent validating each of the latest blocks connected to the active chain, the latest first.\n"
+                "The times of the last %d blocks are kept. They are in milliseconds.\n", BLOCK_VALIDATION_TIMES_KEPT),
+                {
+                    {"count", RPCArg::Type::NUM, RPCArg::Default{10}, strprintf("the number of blocks to return, at most %d", BLOCK_VALIDATION_TIMES_KEPT)},
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "", "", {
+                            {RPCResult::Type::STR_HEX, "hash", "the block hash"},
+                            {RPCResult::Type::NUM, "height", "the block height"},
+                            {RPCResult::Type::BOOL, "proof_of_stake", "whether the block is proof of stake"},
+                            {RPCResult::Type::NUM, "size", "the block size in bytes"},
+                            {RPCResult::Type::NUM, "txs", "the number of transactions"},
+                            {RPCResult::Type::NUM, "inputs", "the number of transaction inputs"},
+                            {RPCResult::Type::NUM, "storage_txs", "the number of storage transactions"},
+                            {RPCResult::Type::NUM, "load_block", "reading the block from disk, if not received whole"},
+                            {RPCResult::Type::NUM, "check", "checking the block, including the stake"},
+                            {RPCResult::Type::NUM, "stake", "checking the proof of stake, part of check; the coinstake signature counts under verify when checked in parallel"},
+                            {RPCResult::Type::NUM, "forks", "checking the soft forks in force"},
+                            {RPCResult::Type::NUM, "connect", "spending and adding the coins"},
+                            {RPCResult::Type::NUM, "verify", "connecting and verifying the scripts, including connect"},
+                            {RPCResult::Type::NUM, "undo", "writing the undo data"},
+                            {RPCResult::Type::NUM, "index", "writing the block index"},
+                            {RPCResult::Type::NUM, "flush", "flushing the coins to the chainstate cache"},
+                            {RPCResult::Type::NUM, "chainstate", "flushing the chainstate to disk, if due"},
+                            {RPCResult::Type::NUM, "post_connect", "updating the mempool and the tip"},
+                            {RPCResult::Type::NUM, "total", "connecting the block as a whole"},
+                            {RPCResult::Type::NUM, "auth", /*optional=*/true, "applying the authList changes of the block, once done in the background"},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getblockvalidationstats", "")
+            + HelpExampleCli("getblockvalidationstats", "100")
+            + HelpExampleRpc("getblockvalidationstats", "100")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const int count{request.params[0].isNull() ? 10 : request.params[0].getInt<int>()};
+    if (count < 0 || (size_t)count > BLOCK_VALIDATION_TIMES_KEPT) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("count must be between 0 and %d", BLOCK_VALIDATION_TIMES_KEPT));
+    }
+
+    UniValue ret(UniValue::VARR);
+    for (const BlockValidationTimes& times : GetBlockValidationTimes(count)) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("hash", times.hash.GetHex());
+        entry.pushKV("height", times.height);
+        entry.pushKV("proof_of_stake", times.proof_of_stake);
+        entry.pushKV("size", (uint64_t)times.size);
+        entry.pushKV("txs", (uint64_t)times.txs);
+        entry.pushKV("inputs", (uint64_t)times.inputs);
+        entry.pushKV("storage_txs", (uint64_t)times.storage_txs);
+        for (const auto& [name, time] : {
+                 std::pair{"load_block", times.load_block},
+                 {"check", times.check},
+                 {"stake", times.stake},
+                 {"forks", times.forks},
+                 {"connect", times.connect},
+                 {"verify", times.verify},
+                 {"undo", times.undo},
+                 {"index", times.index},
+                 {"flush", times.flush},
+                 {"chainstate", times.chainstate},
+                 {"post_connect", times.post_connect},
+                 {"total", times.total},
+             }) {
+            entry.pushKV(name, Ticks<MillisecondsDouble>(time));
+        }
+        if (times.auth) entry.pushKV("auth", Ticks<MillisecondsDouble>(*times.auth));
+        ret.push_back(entry);
+    }
+    return ret;
+},
+    };
 }
 
 void RegisterBlockchainRPCCommands(CRPCTable& t)
@@ -2727,6 +3430,8 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &getblockchaininfo},
         {"blockchain", &getchaintxstats},
         {"blockchain", &getblockstats},
+        {"blockchain", &getblocktimestats},
+        {"blockchain", &getblockvalidationstats},
         {"blockchain", &getbestblockhash},
         {"blockchain", &getblockcount},
         {"blockchain", &getblock},
@@ -2744,6 +3449,10 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &scantxoutset},
         {"blockchain", &scanblocks},
         {"blockchain", &getblockfilter},
+        {"blockchain", &getaddressoutputs},
+        {"blockchain", &getspentinfo},
+        {"blockchain", &getstakinghistory},
+        {"blockchain", &getstakingstats},
         {"hidden", &invalidateblock},
         {"hidden", &reconsiderblock},
         {"hidden", &waitfornewblock},
@@ -2751,6 +3460,7 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"hidden", &waitforblockheight},
         {"hidden", &syncwithvalidationinterfacequeue},
         {"hidden", &dumptxoutset},
+        {"hidden", &loadtxoutset},
     };
     for (const auto& c : commands) {
         t.appendCommand(c.name, &c);
@@ -13,12 +13,20 @@
 #include <validation.h>
 
 #include <any>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
 #include <stdint.h>
+#include <string>
+#include <utility>
 #include <vector>
 
 class CBlock;
 class CBlockIndex;
+class CChain;
 class Chainstate;
+class JSONWriter;
 class UniValue;
 namespace node {
 struct NodeContext;
@@ -26,6 +34,11 @@ struct NodeContext;
 
 static constexpr int NUM_GETBLOCKSTATS_PERCENTILES = 5;
 
+//! Default for -blockrendercache, in MiB
+static constexpr int64_t DEFAULT_BLOCK_RENDER_CACHE_MB{32};
+//! Confirmations a block needs before its renderings are cached
+static constexpr int BLOCK_RENDER_CACHE_MIN_DEPTH{6};
+
 /**
  * Get the difficulty of the net wrt to the given block index.
  *
@@ -40,6 +53,58 @@ void RPCNotifyBlockChange(const CBlockIndex*);
 /** Block description to JSON */
 UniValue blockToJSON(node::BlockManager& blockman, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, TxVerbosity verbosity) LOCKS_EXCLUDED(cs_main);
 
+/** Block description to JSON, written to writer as it is produced */
+void blockToJSON(node::BlockManager& blockman, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, TxVerbosity verbosity, JSONWriter& writer) LOCKS_EXCLUDED(cs_main);
+
+/**
+ * Renderings of blocks deep in the active chain, so the blocks explorers keep
+ * asking for are not read, deserialized and rendered again for every request.
+ *
+ * A block is kept rendered as hex, or as the members of its JSON description
+ * that follow the header's at a verbosity (sizes, weight and transactions).
+ * The header members are always rendered afresh, as its confirmations and
+ * next block change with the tip.
+ */
+class BlockRenderCache
+{
+public:
+    //! A block, and the verbosity of its JSON or none for its hex
+    using Key = std::pair<uint256, std::optional<TxVerbosity>>;
+
+private:
+    using Entry = std::pair<Key, std::shared_ptr<const std::string>>;
+
+    mutable Mutex m_mutex;
+    //! Most recently used first
+    std::list<Entry> m_entries GUARDED_BY(m_mutex);
+    std::map<Key, std::list<Entry>::iterator> m_index GUARDED_BY(m_mutex);
+    size_t m_size GUARDED_BY(m_mutex){0};
+    size_t m_max_size GUARDED_BY(m_mutex){0};
+
+    void Trim() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+public:
+    void SetMaxSize(size_t max_size) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    std::shared_ptr<const std::string> Get(const Key& key) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    void Add(const Key& key, std::shared_ptr<const std::string> rendering) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+extern BlockRenderCache g_block_render_cache;
+
+/** Whether the renderings of a block are cached: it is at least BLOCK_RENDER_CACHE_MIN_DEPTH deep in the active chain. */
+bool IsBlockRenderCacheable(const CChain& chain, const CBlockIndex* blockindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/** Hex of a block, from g_block_render_cache or read and added. Returns nullptr if the block cannot be read. */
+std::shared_ptr<const std::string> CachedBlockHex(const CBlockIndex* blockindex) LOCKS_EXCLUDED(cs_main);
+
+/**
+ * The members of a block's JSON description after the header's, without braces,
+ * from g_block_render_cache or read and added. Returns nullptr if the block cannot be read.
+ */
+std::shared_ptr<const std::string> CachedBlockJSONBody(node::BlockManager& blockman, const CBlockIndex* blockindex, TxVerbosity verbosity) LOCKS_EXCLUDED(cs_main);
+
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex) LOCKS_EXCLUDED(cs_main);
 
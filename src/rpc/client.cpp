@@ -70,15 +70,25 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "waitforblockheight", 1, "timeout" },
     { "waitforblock", 1, "timeout" },
     { "waitfornewblock", 0, "timeout" },
+    { "store", 2, "reuse" },
+    { "storebatch", 0, "filepaths" },
+    { "fetchbatch", 0, "uuids" },
+    { "fetchrange", 1, "offset" },
+    { "fetchrange", 2, "length" },
+    { "list", 2, "start_time" },
+    { "list", 3, "end_time" },
+    { "tenants", 0, "height" },
     { "listtransactions", 1, "count" },
     { "listtransactions", 2, "skip" },
     { "listtransactions", 3, "include_watchonly" },
+    { "listtransactions", 4, "options" },
     { "walletpassphrase", 1, "timeout" },
     { "getblocktemplate", 0, "template_request" },
     { "listsinceblock", 1, "target_confirmations" },
     { "listsinceblock", 2, "include_watchonly" },
     { "listsinceblock", 3, "include_removed" },
     { "listsinceblock", 4, "include_change" },
+    { "listsinceblock", 6, "options" },
     { "sendmany", 1, "amounts" },
     { "sendmany", 2, "minconf" },
     { "sendmany", 4, "subtractfeefrom" },
@@ -142,6 +152,16 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "finalizepsbt", 1, "extract"},
     { "converttopsbt", 1, "permitsigdata"},
     { "converttopsbt", 2, "iswitness"},
+    { "getaddressoutputs", 1, "start_height" },
+    { "getaddressoutputs", 2, "end_height" },
+    { "getaddressoutputs", 3, "count" },
+    { "getaddressoutputs", 4, "unspent_only" },
+    { "getspentinfo", 1, "vout" },
+    { "getstakinghistory", 1, "start_height" },
+    { "getstakinghistory", 2, "end_height" },
+    { "getstakinghistory", 3, "count" },
+    { "getstakingstats", 0, "start_height" },
+    { "getstakingstats", 1, "end_height" },
     { "gettxout", 1, "n" },
     { "gettxout", 2, "include_mempool" },
     { "gettxoutproof", 0, "txids" },
@@ -172,6 +192,9 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "verifychain", 1, "nblocks" },
     { "getblockstats", 0, "hash_or_height" },
     { "getblockstats", 1, "stats" },
+    { "getblockstoragechunks", 1, "verbose" },
+    { "getblockvalidationstats", 0, "count" },
+    { "startprofiler", 0, "frequency" },
     { "pruneblockchain", 0, "height" },
     { "keypoolrefill", 0, "newsize" },
     { "getrawmempool", 0, "verbose" },
@@ -181,9 +204,14 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "estimaterawfee", 1, "threshold" },
     { "prioritisetransaction", 1, "dummy" },
     { "prioritisetransaction", 2, "fee_delta" },
+    { "setcachesizes", 0, "coinscache" },
+    { "setcachesizes", 1, "maxmempool" },
+    { "setcachesizes", 2, "maxstoragemempool" },
+    { "setcachesizes", 3, "blockcache" },
     { "setban", 2, "bantime" },
     { "setban", 3, "absolute" },
     { "setstaking", 0, "state" },
+    { "setstakepolicy", 0, "options" },
     { "setnetworkactive", 0, "state" },
     { "setwalletflag", 1, "value" },
     { "getmempoolancestors", 1, "verbose" },
@@ -191,6 +219,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "gettxspendingprevout", 0, "outputs" },
     { "bumpfee", 1, "options" },
     { "psbtbumpfee", 1, "options" },
+    { "getlockstats", 0, "count" },
+    { "getlockstats", 1, "reset" },
     { "logging", 0, "include" },
     { "logging", 1, "exclude" },
     { "disconnectnode", 1, "nodeid" },
@@ -0,0 +1,193 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <httprpc.h>
+#include <node/jobs.h>
+#include <rpc/protocol.h>
+#include <rpc/request.h>
+#include <rpc/server.h>
+#include <rpc/util.h>
+#include <univalue.h>
+#include <util/vector.h>
+
+#include <algorithm>
+#include <string>
+
+using node::g_job_queue;
+using node::JobInfo;
+
+static node::JobQueue& EnsureJobQueue()
+{
+    if (!g_job_queue) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Job queue not started");
+    }
+    return *g_job_queue;
+}
+
+static const std::vector<RPCResult> JOB_RESULT_FIELDS{
+    {RPCResult::Type::STR, "id", "The job id"},
+    {RPCResult::Type::STR, "kind", "What the job runs, the RPC method for jobs of submitjob"},
+    {RPCResult::Type::STR, "state", "queued, running, done, failed or cancelled"},
+    {RPCResult::Type::NUM, "progress_done", "Work done, in units of the job's own"},
+    {RPCResult::Type::NUM, "progress_total", "Work to do in all, 0 if not known"},
+    {RPCResult::Type::NUM_TIME, "submitted", "The time the job was submitted, expressed in " + UNIX_EPOCH_TIME},
+    {RPCResult::Type::NUM_TIME, "started", /*optional=*/true, "The time the job started running, expressed in " + UNIX_EPOCH_TIME},
+    {RPCResult::Type::NUM_TIME, "finished", /*optional=*/true, "The time the job finished, expressed in " + UNIX_EPOCH_TIME},
+    {RPCResult::Type::STR, "error", /*optional=*/true, "Why the job failed"},
+};
+
+static UniValue JobToJSON(const JobInfo& job, bool include_result)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("id", job.id);
+    obj.pushKV("kind", job.kind);
+    obj.pushKV("state", node::JobStateString(job.state));
+    obj.pushKV("progress_done", job.progress_done);
+    obj.pushKV("progress_total", job.progress_total);
+    obj.pushKV("submitted", job.submitted);
+    if (job.started) obj.pushKV("started", job.started);
+    if (job.finished) obj.pushKV("finished", job.finished);
+    if (job.state == node::JobState::FAILED) obj.pushKV("error", job.error);
+    if (include_result && job.state == node::JobState::DONE) obj.pushKV("result", job.result);
+    return obj;
+}
+
+static RPCHelpMan submitjob()
+{
+    return RPCHelpMan{"submitjob",
+        "\nRun an RPC method as a background job, and return the job id at once.\n"
+        "Poll the job with getjob for its progress and result. Results are kept for an hour after the job finishes.\n"
+        "Meant for methods that run for long, such as gettxoutsetinfo, scantxoutset, rescanblockchain or list.\n",
+        {
+            {"method", RPCArg::Type::STR, RPCArg::Optional::NO, "The RPC method to run"},
+            {"params", RPCArg::Type::ARR, RPCArg::Default{UniValue::VARR}, "The positional parameters of the method",
+                {
+                    {"param", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "A parameter of the method, of whatever type the method takes"},
+                },
+            },
+        },
+        RPCResult{RPCResult::Type::STR, "", "The job id"},
+        RPCExamples{
+            HelpExampleCli("submitjob", "gettxoutsetinfo")
+            + HelpExampleCli("submitjob", "scantxoutset '[\"start\", [\"addr(mtyZ2HgGpgNYrqBuPLhRBdMjjLpp6bRiMC)\"]]'")
+            + HelpExampleRpc("submitjob", "\"gettxoutsetinfo\", [\"muhash\"]")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    node::JobQueue& queue{EnsureJobQueue()};
+
+    JSONRPCRequest job_request;
+    job_request.strMethod = request.params[0].get_str();
+    job_request.params = request.params[1].isNull() ? UniValue{UniValue::VARR} : request.params[1];
+    job_request.URI = request.URI;
+    job_request.authUser = request.authUser;
+    job_request.peerAddr = request.peerAddr;
+    job_request.context = request.context;
+
+    const std::vector<std::string> methods{tableRPC.listCommands()};
+    if (std::find(methods.begin(), methods.end(), job_request.strMethod) == methods.end()) {
+        throw JSONRPCError(RPC_METHOD_NOT_FOUND, "Method not found");
+    }
+    if (job_request.strMethod == self.m_name) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "A job cannot submit jobs");
+    }
+    // A job must not get round the methods -rpcwhitelist allows
+    if (!RPCMethodAllowed(request.authUser, job_request.strMethod)) {
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("User %s is not allowed to call %s", request.authUser, job_request.strMethod));
+    }
+
+    return *queue.Submit(job_request.strMethod, [job_request] {
+        return tableRPC.execute(job_request);
+    });
+},
+    };
+}
+
+static RPCHelpMan getjob()
+{
+    return RPCHelpMan{"getjob",
+        "\nReturn the state and progress of a background job, and its result once it is done.\n",
+        {
+            {"id", RPCArg::Type::STR, RPCArg::Optional::NO, "The job id"},
+        },
+        RPCResult{RPCResult::Type::OBJ, "", "",
+            Cat<std::vector<RPCResult>>(JOB_RESULT_FIELDS, {
+                {RPCResult::Type::ANY, "result", /*optional=*/true, "What the job returned, once done"},
+            })},
+        RPCExamples{
+            HelpExampleCli("getjob", "\"0123456789abcdef\"")
+            + HelpExampleRpc("getjob", "\"0123456789abcdef\"")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const auto job{EnsureJobQueue().Get(request.params[0].get_str())};
+    if (!job) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "No such job, or its result has expired");
+    }
+    return JobToJSON(*job, /*include_result=*/true);
+},
+    };
+}
+
+static RPCHelpMan listjobs()
+{
+    return RPCHelpMan{"listjobs",
+        "\nList the most recently submitted background jobs, without their results, oldest first.\n",
+        {
+            {"count", RPCArg::Type::NUM, RPCArg::Default{15}, "The number of jobs to list"},
+        },
+        RPCResult{RPCResult::Type::ARR, "", "",
+            {
+                {RPCResult::Type::OBJ, "", "", JOB_RESULT_FIELDS},
+            }},
+        RPCExamples{
+            HelpExampleCli("listjobs", "")
+            + HelpExampleRpc("listjobs", "")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const int count{request.params[0].isNull() ? 15 : request.params[0].getInt<int>()};
+    if (count < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative count");
+    }
+    UniValue ret(UniValue::VARR);
+    for (const JobInfo& job : EnsureJobQueue().List(count)) {
+        ret.push_back(JobToJSON(job, /*include_result=*/false));
+    }
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan canceljob()
+{
+    return RPCHelpMan{"canceljob",
+        "\nCancel a background job. A queued job is dropped at once, a running one stops where it next can.\n",
+        {
+            {"id", RPCArg::Type::STR, RPCArg::Optional::NO, "The job id"},
+        },
+        RPCResult{RPCResult::Type::BOOL, "", "Whether the job was still to finish"},
+        RPCExamples{
+            HelpExampleCli("canceljob", "\"0123456789abcdef\"")
+            + HelpExampleRpc("canceljob", "\"0123456789abcdef\"")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    return EnsureJobQueue().Cancel(request.params[0].get_str());
+},
+    };
+}
+
+void RegisterJobRPCCommands(CRPCTable& t)
+{
+    static const CRPCCommand commands[]{
+        {"control", &submitjob},
+        {"control", &getjob},
+        {"control", &listjobs},
+        {"control", &canceljob},
+    };
+    for (const auto& c : commands) {
+        t.appendCommand(c.name, &c);
+    }
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsonwriter.h>
+
+#include <univalue.h>
+#include <util/check.h>
+
+JSONWriter::JSONWriter(Sink sink, size_t piece_size)
+    : m_sink(std::move(sink)), m_piece_size(piece_size)
+{
+    m_piece.reserve(m_piece_size);
+}
+
+void JSONWriter::Separate()
+{
+    if (m_after_key) {
+        m_after_key = false;
+        return;
+    }
+    if (m_empty.empty()) return;
+    if (!m_empty.back()) m_piece += ',';
+    m_empty.back() = false;
+}
+
+void JSONWriter::Append(const std::string& str)
+{
+    m_piece += str;
+    if (m_piece.size() >= m_piece_size) Flush();
+}
+
+void JSONWriter::BeginObject()
+{
+    Separate();
+    m_piece += '{';
+    m_empty.push_back(true);
+}
+
+void JSONWriter::EndObject()
+{
+    Assume(!m_empty.empty() && !m_after_key);
+    m_empty.pop_back();
+    Append("}");
+}
+
+void JSONWriter::BeginArray()
+{
+    Separate();
+    m_piece += '[';
+    m_empty.push_back(true);
+}
+
+void JSONWriter::EndArray()
+{
+    Assume(!m_empty.empty() && !m_after_key);
+    m_empty.pop_back();
+    Append("]");
+}
+
+void JSONWriter::Key(const std::string& key)
+{
+    Assume(!m_empty.empty() && !m_after_key);
+    Separate();
+    m_piece += UniValue{key}.write();
+    m_piece += ':';
+    m_after_key = true;
+}
+
+void JSONWriter::Value(const UniValue& value)
+{
+    Separate();
+    Append(value.write());
+}
+
+void JSONWriter::Members(const UniValue& obj)
+{
+    const std::vector<std::string>& keys{obj.getKeys()};
+    const std::vector<UniValue>& values{obj.getValues()};
+    for (size_t i = 0; i < keys.size(); ++i) {
+        Key(keys[i]);
+        Value(values[i]);
+    }
+}
+
+void JSONWriter::RawMembers(const std::string& json)
+{
+    Assume(!m_empty.empty() && !m_after_key);
+    if (json.empty()) return;
+    Separate();
+    Append(json);
+}
+
+void JSONWriter::Flush()
+{
+    if (m_piece.empty()) return;
+    const bool taken{m_sink(MakeUCharSpan(m_piece))};
+    m_piece.clear();
+    if (!taken) throw JSONWriterClosed{};
+}
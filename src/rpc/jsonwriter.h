@@ -0,0 +1,75 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONWRITER_H
+#define BITCOIN_RPC_JSONWRITER_H
+
+#include <span.h>
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class UniValue;
+
+//! Bytes of JSON a JSONWriter gathers before handing them to its sink
+static constexpr size_t JSON_WRITER_PIECE{256 * 1024};
+
+/** Thrown by a JSONWriter whose sink no longer takes output, such as a closed connection. */
+class JSONWriterClosed : public std::runtime_error
+{
+public:
+    explicit JSONWriterClosed() : std::runtime_error("JSON output closed") {}
+};
+
+/**
+ * Writes a JSON document a piece at a time, so a large document can be sent
+ * as it is produced rather than built whole as a UniValue and then as a string.
+ *
+ * Objects and arrays are opened and closed explicitly, while anything small
+ * enough is written as a UniValue. The output is the compact form UniValue::write()
+ * gives the same document.
+ */
+class JSONWriter
+{
+public:
+    //! Takes the next piece of output, returns false once it takes no more
+    using Sink = std::function<bool(Span<const unsigned char>)>;
+
+    explicit JSONWriter(Sink sink, size_t piece_size = JSON_WRITER_PIECE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    /// Write the key of the next member of the open object.
+    void Key(const std::string& key);
+
+    /// Write a value, a member's after Key(), an element otherwise.
+    void Value(const UniValue& value);
+
+    /// Write the members of obj into the open object.
+    void Members(const UniValue& obj);
+
+    /// Write members already rendered, as UniValue::write() gives an object without its braces.
+    void RawMembers(const std::string& json);
+
+    /// Hand what is gathered to the sink. Throws JSONWriterClosed if it takes no more.
+    void Flush();
+
+private:
+    void Separate();
+    void Append(const std::string& str);
+
+    const Sink m_sink;
+    const size_t m_piece_size;
+    std::string m_piece;
+    //! Per open object or array, whether it has no members or elements yet
+    std::vector<bool> m_empty;
+    bool m_after_key{false};
+};
+
+#endif // BITCOIN_RPC_JSONWRITER_H
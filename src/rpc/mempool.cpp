@@ -14,6 +14,8 @@
 #include <policy/rbf.h>
 #include <policy/settings.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonwriter.h>
+#include <rpc/mempool.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
@@ -378,6 +380,41 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
     }
 }
 
+void MempoolToJSON(const CTxMemPool& pool, JSONWriter& writer)
+{
+    std::vector<uint256> txids;
+    {
+        LOCK(pool.cs);
+        txids.reserve(pool.mapTx.size());
+        for (const CTxMemPoolEntry& e : pool.mapTx) {
+            txids.push_back(e.GetTx().GetHash());
+        }
+    }
+
+    // Describe the entries a batch at a time, so the mempool is never locked
+    // while the writer waits on the client. Entries gone by then are left out.
+    writer.BeginObject();
+    std::vector<std::pair<uint256, UniValue>> batch;
+    for (size_t start = 0; start < txids.size(); start += MEMPOOL_JSON_BATCH) {
+        {
+            LOCK(pool.cs);
+            for (size_t i = start; i < std::min(txids.size(), start + MEMPOOL_JSON_BATCH); ++i) {
+                const auto it{pool.GetIter(txids[i])};
+                if (!it) continue;
+                UniValue info(UniValue::VOBJ);
+                entryToJSON(pool, info, **it);
+                batch.emplace_back(txids[i], std::move(info));
+            }
+        }
+        for (const auto& [txid, info] : batch) {
+            writer.Key(txid.ToString());
+            writer.Value(info);
+        }
+        batch.clear();
+    }
+    writer.EndObject();
+}
+
 static RPCHelpMan getrawmempool()
 {
     return RPCHelpMan{"getrawmempool",
@@ -423,6 +460,12 @@ static RPCHelpMan getrawmempool()
         include_mempool_sequence = request.params[1].get_bool();
     }
 
+    if (fVerbose && !include_mempool_sequence) {
+        if (JSONWriter* writer{request.StreamResult()}) {
+            MempoolToJSON(EnsureAnyMemPool(request.context), *writer);
+            return NullUniValue;
+        }
+    }
     return MempoolToJSON(EnsureAnyMemPool(request.context), fVerbose, include_mempool_sequence);
 },
     };
@@ -679,9 +722,12 @@ UniValue MempoolInfoToJSON(const CTxMemPool& pool)
     ret.pushKV("bytes", (int64_t)pool.GetTotalTxSize());
     ret.pushKV("usage", (int64_t)pool.DynamicMemoryUsage());
     ret.pushKV("total_fee", ValueFromAmount(pool.GetTotalFee()));
-    ret.pushKV("maxmempool", pool.m_max_size_bytes);
+    ret.pushKV("maxmempool", pool.m_max_size_bytes.load());
     ret.pushKV("mempoolminfee", ValueFromAmount(std::max(pool.GetMinFee(), pool.m_min_relay_feerate).GetFeePerK()));
     ret.pushKV("minrelaytxfee", ValueFromAmount(pool.m_min_relay_feerate.GetFeePerK()));
+    ret.pushKV("storageusage", pool.StorageUsage());
+    ret.pushKV("maxstoragemempool", pool.m_max_storage_size_bytes.load());
+    ret.pushKV("storagemempoolminfee", ValueFromAmount(std::max(pool.GetStorageMinFee(), pool.m_min_relay_feerate).GetFeePerK()));
     ret.pushKV("incrementalrelayfee", ValueFromAmount(pool.m_incremental_relay_feerate.GetFeePerK()));
     ret.pushKV("unbroadcastcount", uint64_t{pool.GetUnbroadcastTxs().size()});
     ret.pushKV("fullrbf", pool.m_full_rbf);
@@ -704,6 +750,9 @@ static RPCHelpMan getmempoolinfo()
                 {RPCResult::Type::NUM, "maxmempool", "Maximum memory usage for the mempool"},
                 {RPCResult::Type::STR_AMOUNT, "mempoolminfee", "Minimum fee rate in " + CURRENCY_UNIT + "/kvB for tx to be accepted. Is the maximum of minrelaytxfee and minimum mempool fee"},
                 {RPCResult::Type::STR_AMOUNT, "minrelaytxfee", "Current minimum relay fee for transactions"},
+                {RPCResult::Type::NUM, "storageusage", "Memory usage of the storage transactions in the mempool"},
+                {RPCResult::Type::NUM, "maxstoragemempool", "Maximum memory usage of the storage transactions in the mempool"},
+                {RPCResult::Type::STR_AMOUNT, "storagemempoolminfee", "Minimum fee rate in " + CURRENCY_UNIT + "/kvB for a storage tx to be accepted. Is at least mempoolminfee"},
                 {RPCResult::Type::NUM, "incrementalrelayfee", "minimum fee rate increment for mempool limiting or replacement in " + CURRENCY_UNIT + "/kvB"},
                 {RPCResult::Type::NUM, "unbroadcastcount", "Current number of transactions that haven't passed initial broadcast yet"},
                 {RPCResult::Type::BOOL, "fullrbf", "True if the mempool accepts RBF without replaceability signaling inspection"},
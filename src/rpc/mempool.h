@@ -5,13 +5,22 @@
 #ifndef BITCOIN_RPC_MEMPOOL_H
 #define BITCOIN_RPC_MEMPOOL_H
 
+#include <cstddef>
+
 class CTxMemPool;
+class JSONWriter;
 class UniValue;
 
+//! Entries of the mempool described per lock of the mempool when streaming it
+static constexpr size_t MEMPOOL_JSON_BATCH{1000};
+
 /** Mempool information to JSON */
 UniValue MempoolInfoToJSON(const CTxMemPool& pool);
 
 /** Mempool to JSON */
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose = false, bool include_mempool_sequence = false);
 
+/** Verbose mempool to JSON, written to writer as it is produced */
+void MempoolToJSON(const CTxMemPool& pool, JSONWriter& writer);
+
 #endif // BITCOIN_RPC_MEMPOOL_H
@@ -15,10 +15,12 @@
 #include <deploymentstatus.h>
 #include <key_io.h>
 #include <net.h>
+#include <node/blocktemplatecache.h>
 #include <node/context.h>
 #include <node/miner.h>
 #include <pos/manager.h>
 #include <pos/minter.h>
+#include <pos/pos.h>
 #include <pow.h>
 #include <rpc/blockchain.h>
 #include <rpc/mining.h>
@@ -428,6 +430,12 @@ static RPCHelpMan getmininginfo()
                              {RPCResult::Type::NUM, "proof-of-stake", "the difficulty as a multiple of the minimum difficulty of proof of stake blocks"},
                         }},
                         {RPCResult::Type::NUM, "networkhashps", "The network hashes per second"},
+                        {RPCResult::Type::NUM, "networkkernelps", strprintf("The kernel hashes per second of the network's stakers, estimated from the last %d stakes", POS_KERNEL_PS_INTERVAL + 1)},
+                        {RPCResult::Type::OBJ, "stakeseen", "the stake kernels recently seen in blocks", {
+                             {RPCResult::Type::NUM, "size", "the number of kernels held"},
+                             {RPCResult::Type::NUM, "hits", "the number of lookups that found their kernel held"},
+                             {RPCResult::Type::NUM, "evictions", "the number of kernels evicted to make room for newer ones"},
+                        }},
                         {RPCResult::Type::NUM, "pooledtx", "The size of the mempool"},
                         {RPCResult::Type::STR, "chain", "current network name (main, test, signet, regtest)"},
                         {RPCResult::Type::STR, "warnings", "any network and blockchain warnings"},
@@ -441,18 +449,23 @@ static RPCHelpMan getmininginfo()
     NodeContext& node = EnsureAnyNodeContext(request.context);
     const CTxMemPool& mempool = EnsureMemPool(node);
     ChainstateManager& chainman = EnsureChainman(node);
-    LOCK(cs_main);
-    const CChain& active_chain = chainman.ActiveChain();
+    const auto snapshot{EnsureTipSnapshot(chainman)};
 
     UniValue obj(UniValue::VOBJ);
-    obj.pushKV("blocks",           active_chain.Height());
+    obj.pushKV("blocks",           snapshot->height);
     if (BlockAssembler::m_last_block_weight) obj.pushKV("currentblockweight", *BlockAssembler::m_last_block_weight);
     if (BlockAssembler::m_last_block_num_txs) obj.pushKV("currentblocktx", *BlockAssembler::m_last_block_num_txs);
     UniValue obj2(UniValue::VOBJ);
-    obj2.pushKV("proof-of-work", GetDifficulty(active_chain.Tip()));
-    obj2.pushKV("proof-of-stake", GetDifficulty(GetLastPoSBlockIndex(active_chain.Tip())));
+    obj2.pushKV("proof-of-work", GetDifficulty(snapshot->tip));
+    obj2.pushKV("proof-of-stake", GetDifficulty(snapshot->last_pos));
     obj.pushKV("difficulty", obj2);
     obj.pushKV("networkhashps",    getnetworkhashps().HandleRequest(request));
+    obj.pushKV("networkkernelps",  snapshot->pos_kernel_ps);
+    UniValue stake_seen(UniValue::VOBJ);
+    stake_seen.pushKV("size", (uint64_t)g_stake_seen.Size());
+    stake_seen.pushKV("hits", g_stake_seen.GetHits());
+    stake_seen.pushKV("evictions", g_stake_seen.GetEvictions());
+    obj.pushKV("stakeseen", stake_seen);
     obj.pushKV("pooledtx",         (uint64_t)mempool.size());
     obj.pushKV("chain", chainman.GetParams().NetworkIDString());
     obj.pushKV("warnings",         GetWarnings(false).original);
@@ -773,7 +786,11 @@ static RPCHelpMan getblocktemplate()
 
         // Create new block
         CScript scriptDummy = CScript() << OP_TRUE;
-        pblocktemplate = BlockAssembler{active_chainstate, &mempool}.CreateNewBlock(scriptDummy);
+        if (node::g_block_template_cache) {
+            pblocktemplate = node::g_block_template_cache->CreateNewBlock(scriptDummy, /*fProofOfStake=*/false);
+        } else {
+            pblocktemplate = BlockAssembler{active_chainstate, &mempool}.CreateNewBlock(scriptDummy);
+        }
         if (!pblocktemplate)
             throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
 
@@ -1088,6 +1105,120 @@ static RPCHelpMan setstaking()
     };
 }
 
+static RPCHelpMan getstakinginfo()
+{
+    return RPCHelpMan{"getstakinginfo",
+                "\nReturns timings, counts and recent attempts of the stake threads since startup.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::BOOL, "staking", "whether a stake thread is searching for a kernel"},
+                        {RPCResult::Type::NUM, "cycles", "the number of times the stake threads went through their wallets"},
+                        {RPCResult::Type::NUM, "staked", "the number of blocks staked"},
+                        {RPCResult::Type::OBJ_DYN, "stages", "time spent in each stage of a cycle, by stage (coinselection, kernelsearch, blocktemplate, signing)", {
+                            {RPCResult::Type::OBJ, "stage", "", {
+                                {RPCResult::Type::NUM, "count", "the number of times the stage ran"},
+                                {RPCResult::Type::NUM, "time_ms", "the total time spent in the stage, in milliseconds"},
+                            }},
+                        }},
+                        {RPCResult::Type::NUM, "kernelhashes", "the number of kernel hashes computed, at most"},
+                        {RPCResult::Type::NUM, "kernelhashps", "the kernel hashes per second of kernel search"},
+                        {RPCResult::Type::OBJ_DYN, "sleeps", "sleeps of the stake threads, by reason", {
+                            {RPCResult::Type::OBJ, "reason", "", {
+                                {RPCResult::Type::NUM, "count", "the number of sleeps"},
+                                {RPCResult::Type::NUM, "time_ms", "the total time slept, in milliseconds"},
+                            }},
+                        }},
+                        {RPCResult::Type::ARR, "wallets", "the scheduling of each wallet's stake attempts among the stake threads", {
+                            {RPCResult::Type::OBJ, "", "", {
+                                {RPCResult::Type::STR, "wallet", "the wallet name"},
+                                {RPCResult::Type::STR_AMOUNT, "weight", "the spendable balance at the last attempt, which orders the wallets due together"},
+                                {RPCResult::Type::NUM, "due_ms", "the milliseconds until the next attempt, negative once it is overdue"},
+                                {RPCResult::Type::STR, "reason", "why the wallet waits until then"},
+                                {RPCResult::Type::BOOL, "running", "whether a stake thread is running an attempt"},
+                                {RPCResult::Type::NUM, "attempts", "the number of attempts"},
+                                {RPCResult::Type::NUM, "staked", "the number of blocks staked"},
+                                {RPCResult::Type::NUM, "busy_ms", "the total time of the attempts, in milliseconds"},
+                                {RPCResult::Type::NUM, "delay_ms", "the total time the attempts started behind their due time, in milliseconds"},
+                                {RPCResult::Type::NUM, "thread", "the stake thread of the last attempt, -1 before the first"},
+                            }},
+                        }},
+                        {RPCResult::Type::ARR, "attempts", "the most recent searches for a kernel, the latest last", {
+                            {RPCResult::Type::OBJ, "", "", {
+                                {RPCResult::Type::STR, "wallet", "the wallet searched"},
+                                {RPCResult::Type::NUM, "height", "the height of the block that would be staked"},
+                                {RPCResult::Type::NUM_TIME, "searchtime", "the first coinstake timestamp searched, expressed in " + UNIX_EPOCH_TIME},
+                                {RPCResult::Type::NUM, "candidates", "the number of coins searched"},
+                                {RPCResult::Type::NUM, "kernelhashes", "the number of kernel hashes computed, at most"},
+                                {RPCResult::Type::STR, "result", "the outcome of the search"},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getstakinginfo", "")
+            + HelpExampleRpc("getstakinginfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const StakeStats stats{g_stake_telemetry.GetStats()};
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("staking", fIsStaking.load());
+    obj.pushKV("cycles", stats.cycles);
+    obj.pushKV("staked", stats.staked);
+    UniValue stages(UniValue::VOBJ);
+    for (size_t i = 0; i < NUM_STAKE_STAGES; ++i) {
+        UniValue stage(UniValue::VOBJ);
+        stage.pushKV("count", stats.stage_count[i]);
+        stage.pushKV("time_ms", Ticks<std::chrono::milliseconds>(stats.stage_time[i]));
+        stages.pushKV(StakeStageName((StakeStage)i), stage);
+    }
+    obj.pushKV("stages", stages);
+    obj.pushKV("kernelhashes", stats.kernel_hashes);
+    const auto search_time{stats.stage_time[(size_t)StakeStage::KERNEL_SEARCH]};
+    obj.pushKV("kernelhashps", search_time.count() > 0 ? stats.kernel_hashes * 1e6 / search_time.count() : 0);
+    UniValue sleeps(UniValue::VOBJ);
+    for (size_t i = 0; i < NUM_STAKE_SLEEPS; ++i) {
+        UniValue sleep(UniValue::VOBJ);
+        sleep.pushKV("count", stats.sleep_count[i]);
+        sleep.pushKV("time_ms", Ticks<std::chrono::milliseconds>(stats.sleep_time[i]));
+        sleeps.pushKV(StakeSleepName((StakeSleep)i), sleep);
+    }
+    obj.pushKV("sleeps", sleeps);
+    UniValue wallets(UniValue::VARR);
+    for (const StakeTaskStats& task : g_stake_scheduler.GetStats(SteadyClock::now())) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("wallet", task.wallet);
+        entry.pushKV("weight", ValueFromAmount(task.weight));
+        entry.pushKV("due_ms", Ticks<std::chrono::milliseconds>(task.due_in));
+        entry.pushKV("reason", StakeSleepName(task.reason));
+        entry.pushKV("running", task.running);
+        entry.pushKV("attempts", task.attempts);
+        entry.pushKV("staked", task.staked);
+        entry.pushKV("busy_ms", Ticks<std::chrono::milliseconds>(task.busy_time));
+        entry.pushKV("delay_ms", Ticks<std::chrono::milliseconds>(task.delay));
+        entry.pushKV("thread", task.thread);
+        wallets.push_back(entry);
+    }
+    obj.pushKV("wallets", wallets);
+    UniValue attempts(UniValue::VARR);
+    for (const StakeAttempt& attempt : stats.attempts) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("wallet", attempt.wallet);
+        entry.pushKV("height", attempt.height);
+        entry.pushKV("searchtime", attempt.search_time);
+        entry.pushKV("candidates", (uint64_t)attempt.candidates);
+        entry.pushKV("kernelhashes", attempt.kernel_hashes);
+        entry.pushKV("result", attempt.result);
+        attempts.push_back(entry);
+    }
+    obj.pushKV("attempts", attempts);
+    return obj;
+},
+    };
+}
+
 void RegisterMiningRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
@@ -1098,6 +1229,7 @@ void RegisterMiningRPCCommands(CRPCTable& t)
         {"mining", &submitblock},
         {"mining", &submitheader},
         {"mining", &setstaking},
+        {"mining", &getstakinginfo},
 
         {"hidden", &generatetoaddress},
         {"hidden", &generatetodescriptor},
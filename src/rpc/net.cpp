@@ -142,6 +142,14 @@ static RPCHelpMan getpeerinfo()
                     {RPCResult::Type::BOOL, "addr_relay_enabled", "Whether we participate in address relay with this peer"},
                     {RPCResult::Type::NUM, "addr_processed", "The total number of addresses processed, excluding those dropped due to rate limiting"},
                     {RPCResult::Type::NUM, "addr_rate_limited", "The total number of addresses dropped due to rate limiting"},
+                    {RPCResult::Type::NUM, "cmpctblocks_reconstructed", "The total number of compact blocks from this peer rebuilt without requesting any transactions"},
+                    {RPCResult::Type::NUM, "cmpctblocks_txn_requested", "The total number of compact blocks from this peer rebuilt after requesting the missing transactions"},
+                    {RPCResult::Type::NUM, "cmpctblocks_failed", "The total number of compact blocks from this peer that could not be rebuilt, so the full block was requested"},
+                    {RPCResult::Type::NUM, "txs_flooded", "The total number of transactions announced to this peer by flooding"},
+                    {RPCResult::Type::NUM, "txs_reconciled", "The total number of transactions added to the set to reconcile with this peer instead (see -txreconciliation)"},
+                    {RPCResult::Type::NUM, "recon_txs_announced", "The total number of transactions announced to this peer as found missing by reconciliations"},
+                    {RPCResult::Type::NUM, "recon_rounds", "The total number of reconciliations finished with this peer. The bytes they took are under the reqrecon, sketch and reconcildiff message types"},
+                    {RPCResult::Type::NUM, "recon_failed", "The total number of reconciliations with this peer that failed to find the difference, announcing the whole sets"},
                     {RPCResult::Type::ARR, "permissions", "Any special permissions that have been granted to this peer",
                     {
                         {RPCResult::Type::STR, "permission_type", Join(NET_PERMISSIONS_DOC, ",\n") + ".\n"},
@@ -160,6 +168,16 @@ static RPCHelpMan getpeerinfo()
                                                       "Only known message types can appear as keys in the object and all bytes received\n"
                                                       "of unknown message types are listed under '"+NET_MESSAGE_TYPE_OTHER+"'."}
                     }},
+                    {RPCResult::Type::OBJ_DYN, "msgtime_per_msg", "Time spent on received messages aggregated by message type, keyed like bytesrecv_per_msg",
+                    {
+                        {RPCResult::Type::OBJ, "msg", "",
+                        {
+                            {RPCResult::Type::NUM, "count", "Number of messages processed"},
+                            {RPCResult::Type::NUM, "deserialize_us", "Total microseconds spent in the transport deserializer"},
+                            {RPCResult::Type::NUM, "handler_us", "Total microseconds spent in the message handler"},
+                            {RPCResult::Type::NUM, "cs_main_wait_us", "Total microseconds the message handler waited for cs_main"},
+                        }},
+                    }},
                     {RPCResult::Type::STR, "connection_type", "Type of connection: \n" + Join(CONNECTION_TYPE_DOC, ",\n") + ".\n"
                                                               "Please note this output is unlikely to be stable in upcoming releases as we iterate to\n"
                                                               "best capture connection behaviors."},
@@ -246,6 +264,14 @@ static RPCHelpMan getpeerinfo()
         obj.pushKV("addr_relay_enabled", statestats.m_addr_relay_enabled);
         obj.pushKV("addr_processed", statestats.m_addr_processed);
         obj.pushKV("addr_rate_limited", statestats.m_addr_rate_limited);
+        obj.pushKV("cmpctblocks_reconstructed", statestats.m_cmpctblocks_reconstructed);
+        obj.pushKV("cmpctblocks_txn_requested", statestats.m_cmpctblocks_txn_requested);
+        obj.pushKV("cmpctblocks_failed", statestats.m_cmpctblocks_failed);
+        obj.pushKV("txs_flooded", statestats.m_txs_flooded);
+        obj.pushKV("txs_reconciled", statestats.m_txs_reconciled);
+        obj.pushKV("recon_txs_announced", statestats.m_recon_txs_announced);
+        obj.pushKV("recon_rounds", statestats.m_recon_rounds);
+        obj.pushKV("recon_failed", statestats.m_recon_failed);
         UniValue permissions(UniValue::VARR);
         for (const auto& permission : NetPermissions::ToStrings(stats.m_permission_flags)) {
             permissions.push_back(permission);
@@ -266,6 +292,18 @@ static RPCHelpMan getpeerinfo()
                 recvPerMsgType.pushKV(i.first, i.second);
         }
         obj.pushKV("bytesrecv_per_msg", recvPerMsgType);
+
+        UniValue timePerMsgType(UniValue::VOBJ);
+        for (const auto& [msg_type, time] : stats.m_msg_time_per_msg_type) {
+            if (time.count == 0) continue;
+            UniValue msg_time(UniValue::VOBJ);
+            msg_time.pushKV("count", time.count);
+            msg_time.pushKV("deserialize_us", count_microseconds(time.deserialize));
+            msg_time.pushKV("handler_us", count_microseconds(time.handler));
+            msg_time.pushKV("cs_main_wait_us", count_microseconds(time.cs_main_wait));
+            timePerMsgType.pushKV(msg_type, msg_time);
+        }
+        obj.pushKV("msgtime_per_msg", timePerMsgType);
         obj.pushKV("connection_type", ConnectionTypeAsString(stats.m_conn_type));
 
         ret.push_back(obj);
@@ -559,6 +597,66 @@ static RPCHelpMan getnettotals()
     };
 }
 
+static UniValue DurationHistogramToUniv(const DurationHistogram& histogram)
+{
+    UniValue buckets(UniValue::VARR);
+    for (const uint64_t count : histogram.buckets) {
+        buckets.push_back(count);
+    }
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("total_us", count_microseconds(histogram.total));
+    obj.pushKV("histogram", buckets);
+    return obj;
+}
+
+static RPCHelpMan getnetmsgstats()
+{
+    const std::vector<RPCResult> duration_doc{
+        {RPCResult::Type::NUM, "total_us", "Total microseconds"},
+        {RPCResult::Type::ARR, "histogram", "Number of messages by duration: the first entry counts durations below 1us, entry i those in [2^(i-1), 2^i) us, the last entry all longer ones",
+        {
+            {RPCResult::Type::NUM, "", "Number of messages"},
+        }},
+    };
+    return RPCHelpMan{"getnetmsgstats",
+                "\nReturns the time received messages took to process since startup, across all peers and aggregated by message type.\n"
+                "Only known message types appear as keys; all other messages are listed under '" + NET_MESSAGE_TYPE_OTHER + "'.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ_DYN, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "msg", "",
+                        {
+                            {RPCResult::Type::NUM, "count", "Number of messages processed"},
+                            {RPCResult::Type::OBJ, "deserialize", "Time spent in the transport deserializer", duration_doc},
+                            {RPCResult::Type::OBJ, "handler", "Time spent in the message handler", duration_doc},
+                            {RPCResult::Type::OBJ, "cs_main_wait", "Time the message handler waited for cs_main", duration_doc},
+                        }},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getnetmsgstats", "")
+            + HelpExampleRpc("getnetmsgstats", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    const CConnman& connman = EnsureConnman(node);
+
+    UniValue ret(UniValue::VOBJ);
+    for (const auto& [msg_type, histograms] : connman.GetMsgProcessingHistograms()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("count", histograms.count);
+        obj.pushKV("deserialize", DurationHistogramToUniv(histograms.deserialize));
+        obj.pushKV("handler", DurationHistogramToUniv(histograms.handler));
+        obj.pushKV("cs_main_wait", DurationHistogramToUniv(histograms.cs_main_wait));
+        ret.pushKV(msg_type, obj);
+    }
+    return ret;
+},
+    };
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -976,6 +1074,7 @@ void RegisterNetRPCCommands(CRPCTable& t)
         {"network", &disconnectnode},
         {"network", &getaddednodeinfo},
         {"network", &getnettotals},
+        {"network", &getnetmsgstats},
         {"network", &getnetworkinfo},
         {"network", &setban},
         {"network", &listbanned},
@@ -3,30 +3,59 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <addrman.h>
 #include <chainparams.h>
+#include <dbwrapper.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/stakeindex.h>
+#include <index/storageindex.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
 #include <interfaces/echo.h>
 #include <interfaces/init.h>
 #include <interfaces/ipc.h>
+#include <interfaces/wallet.h>
 #include <kernel/cs_main.h>
 #include <node/context.h>
+#include <node/jobs.h>
+#include <node/memorybudget.h>
+#include <node/profiler.h>
+#include <node/startup.h>
+#include <pos/pos.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
 #include <scheduler.h>
+#include <script/sigcache.h>
+#include <storage/auth.h>
+#include <storage/cache.h>
+#include <sync.h>
+#include <txdb.h>
+#include <txmempool.h>
 #include <univalue.h>
 #include <util/check.h>
+#include <util/fs.h>
 #include <util/syscall_sandbox.h>
 #include <util/system.h>
+#include <util/threadaffinity.h>
+#include <validation.h>
+#include <validationinterface.h>
 
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <optional>
 #include <stdint.h>
 #ifdef HAVE_MALLOC_INFO
 #include <malloc.h>
 #endif
+#ifdef __linux__
+#include <unistd.h>
+#endif
 
 using node::NodeContext;
 
@@ -153,6 +182,49 @@ static std::string RPCMallocInfo()
 }
 #endif
 
+static UniValue RPCMemoryUsage(const NodeContext& node)
+{
+    UniValue obj(UniValue::VOBJ);
+    size_t total{0};
+    const auto add = [&](const std::string& name, size_t bytes) {
+        obj.pushKV(name, bytes);
+        total += bytes;
+    };
+
+    size_t coins_cache{0}, block_index{0};
+    if (node.chainman) {
+        LOCK(cs_main);
+        coins_cache = node.chainman->ActiveChainstate().CoinsTip().DynamicMemoryUsage();
+        block_index = node.chainman->m_blockman.DynamicMemoryUsage();
+    }
+    add("coins_cache", coins_cache);
+    add("mempool", node.mempool ? node.mempool->DynamicMemoryUsage() : 0);
+    add("block_index", block_index);
+    add("addrman", node.addrman ? node.addrman->DynamicMemoryUsage() : 0);
+    if (node.wallet_loader) {
+        UniValue wallets(UniValue::VOBJ);
+        for (const auto& wallet : node.wallet_loader->getWallets()) {
+            const size_t bytes{wallet->getMemoryUsage()};
+            wallets.pushKV(wallet->getWalletName(), bytes);
+            total += bytes;
+        }
+        obj.pushKV("wallets", wallets);
+    }
+    add("jobs", node::g_job_queue ? node::g_job_queue->DynamicMemoryUsage() : 0);
+    add("storage_cache", g_storage_cache ? g_storage_cache->DynamicMemoryUsage() : 0);
+    add("auth_list", auth_list_dynamic_usage());
+    add("auth_signers", signer_cache_dynamic_usage());
+    add("stake_seen", g_stake_seen.DynamicMemoryUsage());
+    obj.pushKV("total", total);
+#ifdef __linux__
+    // Pages resident, the second field of statm
+    std::ifstream statm{"/proc/self/statm"};
+    uint64_t pages{0}, resident{0};
+    if (statm >> pages >> resident) obj.pushKV("resident", resident * sysconf(_SC_PAGESIZE));
+#endif
+    return obj;
+}
+
 static RPCHelpMan getmemoryinfo()
 {
     /* Please, avoid using the word "pool" here in the RPC interface or help,
@@ -178,6 +250,24 @@ static RPCHelpMan getmemoryinfo()
                                 {RPCResult::Type::NUM, "chunks_used", "Number allocated chunks"},
                                 {RPCResult::Type::NUM, "chunks_free", "Number unused chunks"},
                             }},
+                            {RPCResult::Type::OBJ, "usage", "Estimated bytes of heap held by each subsystem",
+                            {
+                                {RPCResult::Type::NUM, "coins_cache", "The coins cache of the active chainstate"},
+                                {RPCResult::Type::NUM, "mempool", "The mempool, its transactions and their indexes"},
+                                {RPCResult::Type::NUM, "block_index", "The block index, including the proof of stake fields of each entry"},
+                                {RPCResult::Type::NUM, "addrman", "The address manager and its tables"},
+                                {RPCResult::Type::OBJ_DYN, "wallets", /*optional=*/true, "The transactions and address book of each wallet loaded, by name",
+                                {
+                                    {RPCResult::Type::NUM, "name", "Bytes held by the wallet"},
+                                }},
+                                {RPCResult::Type::NUM, "jobs", "The background jobs kept, with their results, such as the store and fetch work queued"},
+                                {RPCResult::Type::NUM, "storage_cache", "The entries of the cache of fetched files"},
+                                {RPCResult::Type::NUM, "auth_list", "The authList"},
+                                {RPCResult::Type::NUM, "auth_signers", "The signers of auth and storage chunks remembered"},
+                                {RPCResult::Type::NUM, "stake_seen", "The kernels of the latest coinstakes, for duplicate stake checks"},
+                                {RPCResult::Type::NUM, "total", "The sum of the above"},
+                                {RPCResult::Type::NUM, "resident", /*optional=*/true, "The resident set size of the process, for how much the above leaves out"},
+                            }},
                         }
                     },
                     RPCResult{"mode \"mallocinfo\"",
@@ -194,6 +284,7 @@ static RPCHelpMan getmemoryinfo()
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("usage", RPCMemoryUsage(EnsureAnyNodeContext(request.context)));
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -208,6 +299,446 @@ static RPCHelpMan getmemoryinfo()
     };
 }
 
+static UniValue ValidationCacheStatsToJSON(const ValidationCacheStats& stats)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("hits", stats.hits);
+    obj.pushKV("misses", stats.misses);
+    obj.pushKV("inserts", stats.inserts);
+    obj.pushKV("evictions", stats.evictions);
+    obj.pushKV("resizes", stats.resizes);
+    obj.pushKV("size", stats.size_bytes);
+    obj.pushKV("maxsize", stats.max_size_bytes);
+    return obj;
+}
+
+static RPCHelpMan getvalidationcacheinfo()
+{
+    const std::vector<RPCResult> cache_result{
+        {RPCResult::Type::NUM, "hits", "Number of lookups that found an entry"},
+        {RPCResult::Type::NUM, "misses", "Number of lookups that found none"},
+        {RPCResult::Type::NUM, "inserts", "Number of entries inserted"},
+        {RPCResult::Type::NUM, "evictions", "Number of entries dropped to make room for others before they were used"},
+        {RPCResult::Type::NUM, "resizes", "Number of times the cache grew under eviction pressure (see -sigcachebudget)"},
+        {RPCResult::Type::NUM, "size", "Current size of the cache in bytes"},
+        {RPCResult::Type::NUM, "maxsize", "Size in bytes the cache may grow to"},
+    };
+    return RPCHelpMan{"getvalidationcacheinfo",
+                "Returns the lookup and eviction counters of the signature cache and the script execution cache.\n"
+                "Signatures and scripts verified when a transaction entered the mempool are found in them when it is included in a block.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "signature", "The signature cache", cache_result},
+                        {RPCResult::Type::OBJ, "script_execution", "The script execution cache", cache_result},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getvalidationcacheinfo", "")
+            + HelpExampleRpc("getvalidationcacheinfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("signature", ValidationCacheStatsToJSON(GetSignatureCacheStats()));
+    obj.pushKV("script_execution", ValidationCacheStatsToJSON(GetScriptExecutionCacheStats()));
+    return obj;
+},
+    };
+}
+
+static RPCHelpMan getvalidationqueueinfo()
+{
+    return RPCHelpMan{"getvalidationqueueinfo",
+                "Returns the backlog of validation notifications, such as connected blocks and mempool transactions, waiting to be delivered.\n"
+                "The wallets, indexes, ZMQ and storage authentication sync get theirs on lanes of their own, the other subscribers from a shared queue.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "pending", "Notifications queued for the slowest of the shared queue and the lanes"},
+                        {RPCResult::Type::ARR, "lanes", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR, "name", "The subscriber of the lane"},
+                                {RPCResult::Type::NUM, "pending", "Notifications queued on the lane, including the one being delivered"},
+                                {RPCResult::Type::NUM, "delivered", "Notifications delivered since the subscriber registered"},
+                            }},
+                        }},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getvalidationqueueinfo", "")
+                  + HelpExampleRpc("getvalidationqueueinfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    UniValue lanes(UniValue::VARR);
+    for (const ValidationLaneInfo& info : GetMainSignals().GetLaneInfo()) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("name", info.name);
+        entry.pushKV("pending", (uint64_t)info.pending);
+        entry.pushKV("delivered", info.delivered);
+        lanes.push_back(entry);
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("pending", (uint64_t)GetMainSignals().CallbacksPending());
+    obj.pushKV("lanes", lanes);
+    return obj;
+},
+    };
+}
+
+static RPCHelpMan getstartupinfo()
+{
+    return RPCHelpMan{"getstartupinfo",
+                "Returns how far startup has come. Callable while the other RPCs wait for startup to finish.\n"
+                "Loading the wallets, reading the authList and loading the P2P addresses run alongside the other steps of startup.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::BOOL, "warmup", "Whether startup is still going on"},
+                        {RPCResult::Type::STR, "status", "What startup last reported doing"},
+                        {RPCResult::Type::ARR, "steps", "The steps run alongside the others, in the order started",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR, "name", "The step"},
+                                {RPCResult::Type::STR, "state", "running, done or failed"},
+                                {RPCResult::Type::NUM_TIME, "started", "The time the step started, expressed in " + UNIX_EPOCH_TIME},
+                                {RPCResult::Type::NUM, "elapsed", "Time the step took, or has taken so far, in milliseconds"},
+                            }},
+                        }},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getstartupinfo", "")
+                  + HelpExampleRpc("getstartupinfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    std::string status;
+    const bool warmup{RPCIsInWarmup(&status)};
+
+    UniValue steps(UniValue::VARR);
+    for (const node::StartupStepInfo& step : node::GetStartupSteps()) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("name", step.name);
+        entry.pushKV("state", node::StartupStepStateString(step.state));
+        entry.pushKV("started", step.started);
+        entry.pushKV("elapsed", step.elapsed_ms);
+        steps.push_back(entry);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("warmup", warmup);
+    ret.pushKV("status", warmup ? status : "Done loading");
+    ret.pushKV("steps", steps);
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan getschedulerinfo()
+{
+    return RPCHelpMan{"getschedulerinfo",
+                "Returns the runs of the scheduled background tasks, such as the address and ban list dumps, the stale tip check or the wallet rebroadcasts, those taking the most time first.\n" +
+                strprintf("A task running longer than %dms is logged, as it holds up the tasks due meanwhile; -schedulerthreads sets how many threads run the tasks.\n", Ticks<std::chrono::milliseconds>(SCHEDULER_TASK_WARN_TIME)),
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "pending", "Tasks scheduled and not yet run"},
+                        {RPCResult::Type::ARR, "tasks", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR, "name", "The task, \"other\" for those without a name"},
+                                {RPCResult::Type::NUM, "runs", "Times the task ran"},
+                                {RPCResult::Type::NUM, "total_time", "Time spent running the task, in microseconds"},
+                                {RPCResult::Type::NUM, "max_time", "Longest run of the task, in microseconds"},
+                                {RPCResult::Type::NUM, "max_delay", "Longest a run started after it was due, in microseconds"},
+                            }},
+                        }},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getschedulerinfo", "")
+                  + HelpExampleRpc("getschedulerinfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const CScheduler& scheduler{*CHECK_NONFATAL(EnsureAnyNodeContext(request.context).scheduler)};
+    std::chrono::steady_clock::time_point first, last;
+
+    UniValue tasks(UniValue::VARR);
+    for (const SchedulerTaskStats& stats : scheduler.GetTaskStats()) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("name", stats.name);
+        entry.pushKV("runs", stats.runs);
+        entry.pushKV("total_time", Ticks<std::chrono::microseconds>(stats.total_time));
+        entry.pushKV("max_time", Ticks<std::chrono::microseconds>(stats.max_time));
+        entry.pushKV("max_delay", Ticks<std::chrono::microseconds>(stats.max_delay));
+        tasks.push_back(entry);
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("pending", (uint64_t)scheduler.getQueueInfo(first, last));
+    obj.pushKV("tasks", tasks);
+    return obj;
+},
+    };
+}
+
+static RPCHelpMan getlockstats()
+{
+    return RPCHelpMan{"getlockstats",
+                "Returns how long each lock site, such as those of cs_main, mempool.cs or cs_wallet, waited for and held its mutex, most waited for first.\n"
+                "Lock sites are only profiled with -lockprofile.\n",
+                {
+                    {"count", RPCArg::Type::NUM, RPCArg::Default{20}, "The number of lock sites to return, 0 for all"},
+                    {"reset", RPCArg::Type::BOOL, RPCArg::Default{false}, "Clear the counters once returned"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::BOOL, "enabled", "Whether lock sites are being profiled"},
+                        {RPCResult::Type::ARR, "sites", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR, "lock", "The mutex as named at the site"},
+                                {RPCResult::Type::STR, "site", "The source file and line of the site"},
+                                {RPCResult::Type::NUM, "acquires", "Number of times the site took the lock"},
+                                {RPCResult::Type::NUM, "contended", "Number of times it found the mutex held and waited for it"},
+                                {RPCResult::Type::NUM, "wait_us", "Total time waited, in microseconds"},
+                                {RPCResult::Type::NUM, "max_wait_us", "Longest wait, in microseconds"},
+                                {RPCResult::Type::NUM, "hold_us", "Total time held, in microseconds"},
+                                {RPCResult::Type::NUM, "max_hold_us", "Longest hold, in microseconds"},
+                            }},
+                        }},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getlockstats", "")
+                  + HelpExampleCli("getlockstats", "0 true")
+                  + HelpExampleRpc("getlockstats", "10")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const int count{request.params[0].isNull() ? 20 : request.params[0].getInt<int>()};
+    if (count < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative count");
+    }
+    const bool reset{!request.params[1].isNull() && request.params[1].get_bool()};
+
+    UniValue sites(UniValue::VARR);
+    for (const LockSiteStats& stats : GetLockSiteStats()) {
+        if (count > 0 && sites.size() >= size_t(count)) break;
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("lock", stats.name);
+        entry.pushKV("site", strprintf("%s:%d", stats.file, stats.line));
+        entry.pushKV("acquires", stats.acquires);
+        entry.pushKV("contended", stats.contended);
+        entry.pushKV("wait_us", count_microseconds(stats.wait));
+        entry.pushKV("max_wait_us", count_microseconds(stats.max_wait));
+        entry.pushKV("hold_us", count_microseconds(stats.hold));
+        entry.pushKV("max_hold_us", count_microseconds(stats.max_hold));
+        sites.push_back(entry);
+    }
+    if (reset) ResetLockSiteStats();
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("enabled", g_lock_profiling.load());
+    obj.pushKV("sites", sites);
+    return obj;
+},
+    };
+}
+
+static RPCHelpMan startprofiler()
+{
+    return RPCHelpMan{"startprofiler",
+                "Start sampling the stacks of every thread of the node, whether running or waiting, to see where the time of each subsystem goes.\n"
+                "Each sample is labelled with its thread and the subsystem the thread belongs to. Call stopprofiler to write the profile.\n"
+                "Waits are interrupted by the sampling, which they may take for spurious wakeups. Only supported on Linux.\n",
+                {
+                    {"frequency", RPCArg::Type::NUM, RPCArg::Default{node::DEFAULT_PROFILER_FREQUENCY}, strprintf("The number of times a second each thread is sampled, at most %d", node::MAX_PROFILER_FREQUENCY)},
+                },
+                RPCResult{RPCResult::Type::NONE, "", ""},
+                RPCExamples{
+                    HelpExampleCli("startprofiler", "")
+                  + HelpExampleRpc("startprofiler", "49")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const int frequency{request.params[0].isNull() ? node::DEFAULT_PROFILER_FREQUENCY : request.params[0].getInt<int>()};
+    std::string error;
+    if (!node::g_profiler.Start(frequency, error)) {
+        throw JSONRPCError(RPC_MISC_ERROR, error);
+    }
+    return UniValue::VNULL;
+},
+    };
+}
+
+static RPCHelpMan stopprofiler()
+{
+    return RPCHelpMan{"stopprofiler",
+                "Stop the profiler started by startprofiler, and write the samples taken in the protobuf format of pprof.\n"
+                "The addresses are symbolized by pprof against the binaries, e.g. go tool pprof -http=: lynxd profile.pb\n"
+                "The samples of a subsystem are picked with -tagfocus=subsystem=msghand.\n",
+                {
+                    {"path", RPCArg::Type::STR, RPCArg::Optional::NO, "Path to the output file. If relative, will be prefixed by datadir."},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR, "path", "The absolute path the profile was written to"},
+                        {RPCResult::Type::NUM, "duration", "How long the profiler ran, in seconds"},
+                        {RPCResult::Type::NUM, "samples", "The number of samples taken"},
+                        {RPCResult::Type::NUM, "missed", "The number of samples not taken, as the thread exited or did not take the signal in time"},
+                        {RPCResult::Type::OBJ_DYN, "subsystems", "The number of samples of each subsystem", {
+                            {RPCResult::Type::NUM, "subsystem", ""},
+                        }},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("stopprofiler", "profile.pb")
+                  + HelpExampleRpc("stopprofiler", "\"profile.pb\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const ArgsManager& args{EnsureAnyArgsman(request.context)};
+    const fs::path path{fsbridge::AbsPathJoin(args.GetDataDirNet(), fs::u8path(request.params[0].get_str()))};
+    if (fs::exists(path)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, path.u8string() + " already exists");
+    }
+    const std::optional<node::Profile> profile{node::g_profiler.Stop()};
+    if (!profile) {
+        throw JSONRPCError(RPC_MISC_ERROR, "The profiler is not running");
+    }
+
+    std::ofstream file{path, std::ios::binary};
+    file << node::FormatPprof(*profile);
+    file.close();
+    if (file.fail()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Couldn't write " + path.u8string());
+    }
+
+    uint64_t samples{0};
+    std::map<std::string, uint64_t> subsystems;
+    for (const node::ProfileSample& sample : profile->samples) {
+        samples += sample.count;
+        subsystems[node::ThreadSubsystem(sample.thread)] += sample.count;
+    }
+    UniValue subsystems_obj(UniValue::VOBJ);
+    for (const auto& [subsystem, count] : subsystems) {
+        subsystems_obj.pushKV(subsystem, count);
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("path", path.u8string());
+    obj.pushKV("duration", Ticks<SecondsDouble>(profile->duration));
+    obj.pushKV("samples", samples);
+    obj.pushKV("missed", profile->missed);
+    obj.pushKV("subsystems", subsystems_obj);
+    return obj;
+},
+    };
+}
+
+static UniValue CpusToJSON(const std::vector<int>& cpus)
+{
+    UniValue arr(UniValue::VARR);
+    for (const int cpu : cpus) {
+        arr.push_back(cpu);
+    }
+    return arr;
+}
+
+static RPCHelpMan getthreadplacement()
+{
+    return RPCHelpMan{"getthreadplacement",
+                "Returns the NUMA nodes of the machine, the groups of threads -threadaffinity places, and the threads pinned to the cores of their group.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::ARR, "numa_nodes", "The NUMA nodes and their CPUs, as the system tells, only on Linux", {
+                            {RPCResult::Type::OBJ, "", "", {
+                                {RPCResult::Type::NUM, "node", "The node number"},
+                                {RPCResult::Type::ARR, "cpus", "", {{RPCResult::Type::NUM, "", "A CPU number"}}},
+                            }},
+                        }},
+                        {RPCResult::Type::ARR, "groups", "", {
+                            {RPCResult::Type::OBJ, "", "", {
+                                {RPCResult::Type::STR, "group", "The name of the group"},
+                                {RPCResult::Type::ARR, "threads", "The names of its threads, without the number within a pool", {{RPCResult::Type::STR, "", ""}}},
+                                {RPCResult::Type::ARR, "cpus", /*optional=*/true, "The CPUs its threads are pinned to, if placed", {{RPCResult::Type::NUM, "", "A CPU number"}}},
+                            }},
+                        }},
+                        {RPCResult::Type::ARR, "threads", "The threads pinned", {
+                            {RPCResult::Type::OBJ, "", "", {
+                                {RPCResult::Type::STR, "name", "The name of the thread"},
+                                {RPCResult::Type::STR, "group", "Its group"},
+                                {RPCResult::Type::ARR, "cpus", "The CPUs it is pinned to", {{RPCResult::Type::NUM, "", "A CPU number"}}},
+                            }},
+                        }},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getthreadplacement", "")
+                  + HelpExampleRpc("getthreadplacement", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    UniValue nodes(UniValue::VARR);
+    for (const auto& [node, cpus] : util::ReadNumaNodes()) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("node", node);
+        entry.pushKV("cpus", CpusToJSON(cpus));
+        nodes.push_back(entry);
+    }
+
+    const std::vector<util::ThreadPlacement> placements{util::GetThreadPlacements()};
+    UniValue groups(UniValue::VARR);
+    for (const auto& [group, threads] : util::ThreadGroups()) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("group", group);
+        UniValue names(UniValue::VARR);
+        for (const std::string& thread : threads) {
+            names.push_back(thread);
+        }
+        entry.pushKV("threads", names);
+        for (const util::ThreadPlacement& placement : placements) {
+            if (placement.group == group) entry.pushKV("cpus", CpusToJSON(placement.cpus));
+        }
+        groups.push_back(entry);
+    }
+
+    UniValue threads(UniValue::VARR);
+    for (const util::PlacedThread& thread : util::GetPlacedThreads()) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("name", thread.name);
+        entry.pushKV("group", thread.group);
+        entry.pushKV("cpus", CpusToJSON(thread.cpus));
+        threads.push_back(entry);
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("numa_nodes", nodes);
+    obj.pushKV("groups", groups);
+    obj.pushKV("threads", threads);
+    return obj;
+},
+    };
+}
+
 static void EnableOrDisableLogCategories(UniValue cats, bool enable) {
     cats = cats.get_array();
     for (unsigned int i = 0; i < cats.size(); ++i) {
@@ -404,10 +935,22 @@ static RPCHelpMan getindexinfo()
         result.pushKVs(SummaryToJSON(g_txindex->GetSummary(), index_name));
     }
 
+    if (g_address_index) {
+        result.pushKVs(SummaryToJSON(g_address_index->GetSummary(), index_name));
+    }
+
     if (g_coin_stats_index) {
         result.pushKVs(SummaryToJSON(g_coin_stats_index->GetSummary(), index_name));
     }
 
+    if (g_stake_index) {
+        result.pushKVs(SummaryToJSON(g_stake_index->GetSummary(), index_name));
+    }
+
+    if (g_storage_index) {
+        result.pushKVs(SummaryToJSON(g_storage_index->GetSummary(), index_name));
+    }
+
     ForEachBlockFilterIndex([&result, &index_name](const BlockFilterIndex& index) {
         result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
     });
@@ -417,12 +960,227 @@ static RPCHelpMan getindexinfo()
     };
 }
 
+static const std::vector<RPCResult> DB_STATS_FIELDS{
+    {RPCResult::Type::STR, "name", "The name of the database"},
+    {RPCResult::Type::STR, "path", /*optional=*/true, "The directory of the database, if it is not in memory"},
+    {RPCResult::Type::NUM, "write_buffer_size", "Size of the write buffer in bytes"},
+    {RPCResult::Type::NUM, "bloom_bits", "Bits per key of the bloom filters"},
+    {RPCResult::Type::NUM, "max_file_size", "Size in bytes table files are written up to"},
+    {RPCResult::Type::ARR, "files_per_level", "Number of table files at each level",
+    {
+        {RPCResult::Type::NUM, "", "Number of files"},
+    }},
+    {RPCResult::Type::NUM, "memory_usage", "Estimated memory usage of the write buffers and tables in bytes"},
+    {RPCResult::Type::NUM, "approximate_size", "Approximate size of the database on disk in bytes"},
+    {RPCResult::Type::OBJ, "compaction", "The background compactions since the database opened, flushes of the write buffer included",
+    {
+        {RPCResult::Type::NUM, "rate_limit", "Bytes per second compactions write at most, 0 if unlimited"},
+        {RPCResult::Type::NUM, "runs", "Number of compactions"},
+        {RPCResult::Type::NUM, "seconds", "Time spent compacting"},
+        {RPCResult::Type::NUM, "bytes_written", "Bytes of table files written"},
+        {RPCResult::Type::NUM, "deferred_seconds", "Time compactions waited for blocks to connect"},
+        {RPCResult::Type::NUM, "throttled_seconds", "Time compactions slept to keep to rate_limit"},
+    }},
+    {RPCResult::Type::STR, "leveldb_stats", "LevelDB's report of its levels and compactions"},
+};
+
+static UniValue DBStatsToJSON(const DBStats& stats)
+{
+    UniValue entry(UniValue::VOBJ);
+    entry.pushKV("name", stats.name);
+    if (stats.path) entry.pushKV("path", fs::PathToString(*stats.path));
+    entry.pushKV("write_buffer_size", (uint64_t)stats.write_buffer_size);
+    entry.pushKV("bloom_bits", stats.bloom_bits);
+    entry.pushKV("max_file_size", (uint64_t)stats.max_file_size);
+    UniValue levels(UniValue::VARR);
+    for (const int files : stats.files_per_level) {
+        levels.push_back(files);
+    }
+    entry.pushKV("files_per_level", levels);
+    entry.pushKV("memory_usage", (uint64_t)stats.memory_usage);
+    entry.pushKV("approximate_size", stats.approximate_size);
+    UniValue compaction(UniValue::VOBJ);
+    compaction.pushKV("rate_limit", (uint64_t)stats.compaction_rate);
+    compaction.pushKV("runs", stats.compactions);
+    compaction.pushKV("seconds", stats.compaction_micros / 1e6);
+    compaction.pushKV("bytes_written", stats.compaction_bytes_written);
+    compaction.pushKV("deferred_seconds", stats.compaction_deferred_micros / 1e6);
+    compaction.pushKV("throttled_seconds", stats.compaction_throttled_micros / 1e6);
+    entry.pushKV("compaction", compaction);
+    entry.pushKV("leveldb_stats", stats.leveldb_stats);
+    return entry;
+}
+
+static RPCHelpMan getdbstats()
+{
+    return RPCHelpMan{"getdbstats",
+                "\nReturns the settings and LevelDB statistics of one or all databases open in the node.\n"
+                "Databases are tuned with -dbprofile and -dboption.\n",
+                {
+                    {"db_name", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Filter results for a database with a specific name, such as chainstate, blockindex or txindex."},
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "", "", DB_STATS_FIELDS},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getdbstats", "")
+                  + HelpExampleRpc("getdbstats", "")
+                  + HelpExampleCli("getdbstats", "chainstate")
+                  + HelpExampleRpc("getdbstats", "chainstate")
+                },
+                [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const std::string db_name = request.params[0].isNull() ? "" : request.params[0].get_str();
+
+    UniValue result(UniValue::VARR);
+    for (const DBStats& stats : GetDatabaseStats()) {
+        if (!db_name.empty() && db_name != stats.name) continue;
+        result.push_back(DBStatsToJSON(stats));
+    }
+    return result;
+},
+    };
+}
+
+static RPCHelpMan compactdb()
+{
+    return RPCHelpMan{"compactdb",
+                "\nCompact the whole of a database open in the node, and return its statistics after.\n"
+                "This takes as long as the compaction, minutes for the chainstate, so it is best run with submitjob.\n"
+                "The compaction is throttled to the compactionrate of -dboption, and waits for blocks to connect, as background ones do.\n",
+                {
+                    {"db_name", RPCArg::Type::STR, RPCArg::Optional::NO, "The name of the database, such as chainstate, blockindex or txindex."},
+                },
+                RPCResult{RPCResult::Type::OBJ, "", "", DB_STATS_FIELDS},
+                RPCExamples{
+                    HelpExampleCli("compactdb", "chainstate")
+                  + HelpExampleCli("submitjob", "compactdb '[\"chainstate\"]'")
+                  + HelpExampleRpc("compactdb", "\"chainstate\"")
+                },
+                [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const std::optional<DBStats> stats{CompactDatabase(request.params[0].get_str())};
+    if (!stats) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("No database %s open", request.params[0].get_str()));
+    }
+    return DBStatsToJSON(*stats);
+},
+    };
+}
+
+static UniValue CacheLimitsToJSON(const node::CacheLimits& limits)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("coinscache", limits.coins_cache);
+    obj.pushKV("maxmempool", limits.max_mempool);
+    obj.pushKV("maxstoragemempool", limits.max_storage_mempool);
+    obj.pushKV("blockcache", limits.block_cache);
+    return obj;
+}
+
+static RPCHelpMan setcachesizes()
+{
+    const std::vector<RPCResult> limits_result{
+        {RPCResult::Type::NUM, "coinscache", "Bytes of the in-memory coins cache"},
+        {RPCResult::Type::NUM, "maxmempool", "Bytes the mempool is kept below"},
+        {RPCResult::Type::NUM, "maxstoragemempool", "Bytes the storage transactions in the mempool are kept below"},
+        {RPCResult::Type::NUM, "blockcache", "Bytes of blocks read repeatedly kept in memory"},
+    };
+    return RPCHelpMan{"setcachesizes",
+                "\nChange the sizes of the coins cache, the mempool and the block cache while the node runs, and return them.\n"
+                "The sizes not given are left as they are, so without arguments they are only returned.\n"
+                "With -memorybudget the sizes given are targets, scaled down together under memory pressure.\n"
+                "Shrinking the coins cache flushes it to disk, and shrinking the mempool evicts its lowest feerate transactions.\n",
+                {
+                    {"coinscache", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "MiB of the in-memory coins cache, the part of -dbcache not given to databases."},
+                    {"maxmempool", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Megabytes the mempool is kept below, as -maxmempool."},
+                    {"maxstoragemempool", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Megabytes the storage transactions in the mempool are kept below, as -maxstoragemempool."},
+                    {"blockcache", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "MiB of blocks read repeatedly kept in memory, as -blockcachesize."},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "targets", "The sizes asked for", limits_result},
+                        {RPCResult::Type::OBJ, "applied", "The sizes in use", limits_result},
+                        {RPCResult::Type::NUM, "budget", "-memorybudget in bytes, 0 when the sizes are not scaled"},
+                        {RPCResult::Type::NUM, "scale", "Share of the targets applied"},
+                        {RPCResult::Type::NUM, "memory_used", /*optional=*/true, "Resident bytes of the process at the last check"},
+                        {RPCResult::Type::NUM, "pressure", /*optional=*/true, "Percent of the last 10 seconds stalled on memory at the last check"},
+                        {RPCResult::Type::NUM, "shrinks", "Number of times the caches were scaled down"},
+                        {RPCResult::Type::NUM, "grows", "Number of times the caches were scaled back up"},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("setcachesizes", "")
+                  + HelpExampleCli("-named setcachesizes", "coinscache=1000 maxmempool=500")
+                  + HelpExampleRpc("setcachesizes", "1000, 500")
+                },
+                [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if (!node::g_memory_budget) {
+        throw JSONRPCError(RPC_MISC_ERROR, "The chainstate is not loaded");
+    }
+    node::MemoryBudgetStats stats{node::g_memory_budget->GetStats()};
+    node::CacheLimits targets{stats.targets};
+    const auto get_bytes = [&](size_t i, const std::string& name, int64_t unit) -> std::optional<int64_t> {
+        if (request.params[i].isNull()) return std::nullopt;
+        const int64_t n{request.params[i].getInt<int64_t>()};
+        if (n < 0 || n > std::numeric_limits<int64_t>::max() / unit) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("%s out of range", name));
+        }
+        return n * unit;
+    };
+    if (const auto bytes{get_bytes(0, "coinscache", 1 << 20)}) {
+        if (*bytes < (1 << 20) || *bytes > (nMaxDbCache << 20)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("coinscache must be between 1 and %d MiB", nMaxDbCache));
+        }
+        targets.coins_cache = *bytes;
+    }
+    if (const auto bytes{get_bytes(1, "maxmempool", 1'000'000)}) {
+        if (*bytes < node::g_memory_budget->MinMempoolBytes()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("maxmempool must be at least %d MB", std::ceil(node::g_memory_budget->MinMempoolBytes() / 1'000'000.0)));
+        }
+        targets.max_mempool = *bytes;
+    }
+    if (const auto bytes{get_bytes(2, "maxstoragemempool", 1'000'000)}) targets.max_storage_mempool = *bytes;
+    if (const auto bytes{get_bytes(3, "blockcache", 1 << 20)}) targets.block_cache = *bytes;
+    node::g_memory_budget->SetTargets(targets);
+
+    stats = node::g_memory_budget->GetStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("targets", CacheLimitsToJSON(stats.targets));
+    obj.pushKV("applied", CacheLimitsToJSON(stats.applied));
+    obj.pushKV("budget", stats.budget);
+    obj.pushKV("scale", stats.scale);
+    if (stats.memory_used) obj.pushKV("memory_used", *stats.memory_used);
+    if (stats.pressure) obj.pushKV("pressure", *stats.pressure);
+    obj.pushKV("shrinks", stats.shrinks);
+    obj.pushKV("grows", stats.grows);
+    return obj;
+},
+    };
+}
+
 void RegisterNodeRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
         {"control", &getmemoryinfo},
+        {"control", &getvalidationcacheinfo},
+        {"control", &setcachesizes},
+        {"control", &getlockstats},
+        {"control", &getvalidationqueueinfo},
+        {"control", &getschedulerinfo},
+        {"control", &getstartupinfo},
+        {"control", &startprofiler},
+        {"control", &stopprofiler},
+        {"control", &getthreadplacement},
         {"control", &logging},
         {"util", &getindexinfo},
+        {"util", &getdbstats},
+        {"util", &compactdb},
         {"hidden", &setmocktime},
         {"hidden", &mockscheduler},
         {"hidden", &echo},
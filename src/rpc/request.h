@@ -11,6 +11,8 @@
 
 #include <univalue.h>
 
+class JSONWriter;
+
 UniValue JSONRPCRequestObj(const std::string& strMethod, const UniValue& params, const UniValue& id);
 UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const UniValue& id);
 std::string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id);
@@ -25,6 +27,22 @@ void DeleteAuthCookie();
 /** Parse JSON-RPC batch reply into a vector */
 std::vector<UniValue> JSONRPCProcessBatchReply(const UniValue& in);
 
+/**
+ * Lets a method write a large result as it goes instead of returning it,
+ * offered by transports that can send a reply before it is complete.
+ */
+class RPCResultStream
+{
+public:
+    virtual ~RPCResultStream() = default;
+
+    /// Start the reply and return the writer of the result, which must then be written whole.
+    virtual JSONWriter& Start() = 0;
+
+    /// Whether Start() was called, so the method's return value is not the result.
+    virtual bool Started() const = 0;
+};
+
 class JSONRPCRequest
 {
 public:
@@ -36,8 +54,17 @@ public:
     std::string authUser;
     std::string peerAddr;
     std::any context;
+    //! Set by a transport able to stream the result, see StreamResult()
+    RPCResultStream* result_stream{nullptr};
 
     void parse(const UniValue& valRequest);
+
+    /**
+     * Start writing the result, if the transport streams results. A method
+     * calling this writes its result to the writer returned and returns a
+     * null value. Returns nullptr if the result is to be returned as usual.
+     */
+    JSONWriter* StreamResult() const { return result_stream ? &result_stream->Start() : nullptr; }
 };
 
 #endif // BITCOIN_RPC_REQUEST_H
@@ -5,6 +5,9 @@
 
 #include <rpc/server.h>
 
+#include <httpserver.h>
+#include <node/jobs.h>
+
 #include <rpc/util.h>
 #include <shutdown.h>
 #include <sync.h>
@@ -19,10 +22,12 @@
 #include <boost/signals2/signal.hpp>
 
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <unordered_map>
 
 extern uint160 authUser;
@@ -30,6 +35,8 @@ extern uint160 authUser;
 static GlobalMutex g_rpc_warmup_mutex;
 static std::atomic<bool> g_rpc_running{false};
 static bool fRPCInWarmup GUARDED_BY(g_rpc_warmup_mutex) = true;
+//! Methods callable in warmup, which read only what startup has set up as it goes
+static const std::set<std::string> RPC_WARMUP_METHODS{"getstartupinfo", "uptime"};
 static std::string rpcWarmupStatus GUARDED_BY(g_rpc_warmup_mutex) = "RPC server started";
 /* Timer-creating functions */
 static RPCTimerInterface* timerInterface = nullptr;
@@ -48,10 +55,79 @@ struct RPCServerInfo
 {
     Mutex mutex;
     std::list<RPCCommandExecutionInfo> active_commands GUARDED_BY(mutex);
+    std::map<std::string, RPCMethodStats> method_stats GUARDED_BY(mutex);
 };
 
 static RPCServerInfo g_rpc_server_info;
 
+static std::atomic<int64_t> g_rpc_slow_log_ms{DEFAULT_RPC_SLOW_LOG};
+//! Most characters of the parameters a slow call is logged with
+static constexpr size_t MAX_SLOW_LOG_PARAMS{1000};
+//! Methods whose parameters hold keys or passphrases, which are never logged
+static const std::set<std::string> SENSITIVE_RPC_METHODS{
+    "auth", "createwallet", "encryptwallet", "importdescriptors", "importmulti", "importprivkey", "sethdseed",
+    "signmessagewithprivkey", "signrawtransactionwithkey", "walletpassphrase", "walletpassphrasechange",
+};
+
+void RPCMethodStats::AddCall(int64_t duration_us, bool error)
+{
+    ++calls;
+    if (error) ++errors;
+    total_us += duration_us;
+    max_us = std::max(max_us, duration_us);
+    const auto bucket{std::lower_bound(RPC_LATENCY_BUCKETS_US.begin(), RPC_LATENCY_BUCKETS_US.end(), duration_us)};
+    ++buckets[bucket - RPC_LATENCY_BUCKETS_US.begin()];
+}
+
+int64_t RPCMethodStats::Quantile(double p) const
+{
+    if (calls == 0) return 0;
+    const uint64_t rank{std::max<uint64_t>(1, uint64_t(p * calls + 0.5))};
+    uint64_t count{0};
+    for (size_t i = 0; i < RPC_LATENCY_BUCKETS_US.size(); ++i) {
+        count += buckets[i];
+        if (count >= rank) return std::min(RPC_LATENCY_BUCKETS_US[i], max_us);
+    }
+    return max_us;
+}
+
+std::map<std::string, RPCMethodStats> GetRPCMethodStats()
+{
+    LOCK(g_rpc_server_info.mutex);
+    return g_rpc_server_info.method_stats;
+}
+
+void RecordRPCBytesOut(const std::string& method, size_t bytes)
+{
+    LOCK(g_rpc_server_info.mutex);
+    const auto it{g_rpc_server_info.method_stats.find(method)};
+    if (it != g_rpc_server_info.method_stats.end()) it->second.bytes_out += bytes;
+}
+
+static std::string RPCParamsForLog(const JSONRPCRequest& request)
+{
+    const UniValue& first{request.params.isArray() && !request.params.empty() ? request.params[0] : NullUniValue};
+    if (SENSITIVE_RPC_METHODS.count(request.strMethod) ||
+        (request.strMethod == "submitjob" && first.isStr() && SENSITIVE_RPC_METHODS.count(first.get_str()))) {
+        return "<redacted>";
+    }
+    std::string params{request.params.write()};
+    if (params.size() > MAX_SLOW_LOG_PARAMS) params = params.substr(0, MAX_SLOW_LOG_PARAMS) + "...";
+    return params;
+}
+
+/** Account for a call of a known method, and log it if it was slow */
+static void FinishRPCCall(const JSONRPCRequest& request, SteadyClock::time_point start, bool error)
+{
+    const int64_t duration_us{Ticks<std::chrono::microseconds>(SteadyClock::now() - start)};
+    WITH_LOCK(g_rpc_server_info.mutex, g_rpc_server_info.method_stats[request.strMethod].AddCall(duration_us, error));
+
+    const int64_t slow_log_ms{g_rpc_slow_log_ms};
+    if (slow_log_ms > 0 && duration_us >= slow_log_ms * 1000) {
+        LogPrintf("Slow RPC call %s%s took %dms, params: %s\n", request.strMethod, error ? " failed and" : "", duration_us / 1000, RPCParamsForLog(request));
+    }
+}
+
 struct RPCCommandExecution
 {
     std::list<RPCCommandExecutionInfo>::iterator it;
@@ -87,6 +163,8 @@ std::string CRPCTable::help(const std::string& strCommand, const JSONRPCRequest&
 {
     std::string strRet;
     std::string category;
+    //! Flags of the category being listed, only set when listing all commands
+    uint32_t category_flags{0};
     std::set<intptr_t> setDone;
     std::vector<std::pair<std::string, const CRPCCommand*> > vCommands;
     vCommands.reserve(mapCommands.size());
@@ -99,11 +177,15 @@ std::string CRPCTable::help(const std::string& strCommand, const JSONRPCRequest&
     jreq.mode = JSONRPCRequest::GET_HELP;
     jreq.params = UniValue();
 
+    // Who may see the storage commands does not change while help is written
+    const bool auth_member{is_auth_member(authUser)};
+    const bool init_auth_user{authUser == Params().GetConsensus().initAuthUser};
+
     for (const std::pair<std::string, const CRPCCommand*>& command : vCommands)
     {
         const CRPCCommand *pcmd = command.second;
         std::string strMethod = pcmd->name;
-        if ((strCommand != "" || pcmd->category == "hidden") && strMethod != strCommand)
+        if ((strCommand != "" || (pcmd->flags & CRPCCommand::HIDDEN)) && strMethod != strCommand)
             continue;
         jreq.strMethod = strMethod;
         try
@@ -112,7 +194,6 @@ std::string CRPCTable::help(const std::string& strCommand, const JSONRPCRequest&
             if (setDone.insert(pcmd->unique_id).second)
                 pcmd->actor(jreq, unused_result, /*last_handler=*/true);
         }
-        
         catch (const std::exception& e)
         {
             // Help text is returned in an exception
@@ -125,42 +206,24 @@ std::string CRPCTable::help(const std::string& strCommand, const JSONRPCRequest&
                 if (category != pcmd->category)
                 {
                     if (!category.empty()) {
-                        //if ((Capitalize(category)!="Lynx") || (is_auth_member(authUser))) {
-                            strRet += "\n";
-                                    }    
-                        //}
+                        strRet += "\n";
+                    }
                     category = pcmd->category;
-                    //if ((Capitalize(category)!="Lynx") || (is_auth_member(authUser))) {
-                        strRet += "== " + Capitalize(category) + " ==\n";
-                    //}
+                    category_flags = pcmd->flags;
+                    strRet += "== " + Capitalize(category) + " ==\n";
                 }
             }
-            if ((Capitalize(category)!="Storage") || (is_auth_member(authUser))) {
-
-                if (Capitalize(category) == "Storage") {
-                    // if (authUser.ToString() != "2eba8c3d9038b739d4b2a85fa40eb91648ee2366") {
-                    // if (authUser.ToString() != "ee78c09ab25ea0f5df7112968ce6592019dd9401") {
-                    // if (authUser.ToString() != "1c04e67bf21dc44abe42e84a5ef3bce31b77aa6d") {
-                    if (authUser.ToString() != Params().GetConsensus().initAuthUser.ToString()) {
-
-                        if (strHelp.substr(0,4) != "auth" && strHelp.substr(0,5) != "allow" && strHelp.substr(0,4) != "deny" && strHelp.substr(0,7) != "tenants") {
-                            strRet += strHelp + "\n";
-                        }
-                    } else {
-                        strRet += strHelp + "\n";
-                    }
-                } else {
+            if (!(category_flags & CRPCCommand::STORAGE)) {
+                strRet += strHelp + "\n";
+            } else if (auth_member) {
+                // The initial auth user administers the auth list, tenants only store and fetch
+                if (init_auth_user || (strHelp.substr(0,4) != "auth" && strHelp.substr(0,5) != "allow" && strHelp.substr(0,4) != "deny" && strHelp.substr(0,7) != "tenants")) {
                     strRet += strHelp + "\n";
                 }
-
-            } else { 
-                if (Capitalize(category) == "Storage") {
-                    if ((strHelp.substr(0,5) == "fetch") || (strHelp.substr(0,6) == "status")) {
-                        strRet += strHelp + "\n";
-                    }
-                }
+            } else if ((strHelp.substr(0,5) == "fetch") || (strHelp.substr(0,6) == "status")) {
+                strRet += strHelp + "\n";
             }
-        }   
+        }
     }
     if (strRet == "")
         strRet = strprintf("help: unknown command: %s\n", strCommand);
@@ -258,6 +321,31 @@ static RPCHelpMan getrpcinfo()
                             }},
                         }},
                         {RPCResult::Type::STR, "logpath", "The complete file path to the debug log"},
+                        {RPCResult::Type::OBJ, "http", "Load of the HTTP server since it started",
+                        {
+                            {RPCResult::Type::NUM, "workers", "The number of threads servicing requests"},
+                            {RPCResult::Type::NUM, "max_workers", "The number of threads the pool may grow to (-rpcmaxthreads)"},
+                            {RPCResult::Type::NUM, "queue_depth", "The number of requests waiting for a thread"},
+                            {RPCResult::Type::NUM, "requests", "The number of requests received"},
+                            {RPCResult::Type::NUM, "requests_reused", "The number of requests on a connection kept alive from an earlier request"},
+                            {RPCResult::Type::NUM, "requests_rejected", "The number of requests rejected because the work queue was full"},
+                            {RPCResult::Type::NUM, "connections", "The number of connections that sent a request"},
+                            {RPCResult::Type::NUM, "connections_open", "The number of those connections still open"},
+                        }},
+                        {RPCResult::Type::OBJ_DYN, "methods", "Calls of each method called since startup",
+                        {
+                            {RPCResult::Type::OBJ, "method", "The calls of the method",
+                            {
+                                {RPCResult::Type::NUM, "calls", "The number of calls"},
+                                {RPCResult::Type::NUM, "errors", "The number of calls that returned an error"},
+                                {RPCResult::Type::NUM, "bytes_out", "The bytes of the replies sent"},
+                                {RPCResult::Type::NUM, "mean", "The mean duration of a call in microseconds"},
+                                {RPCResult::Type::NUM, "p50", "The median duration of a call in microseconds, estimated as the bound of its histogram bucket"},
+                                {RPCResult::Type::NUM, "p95", "The 95th percentile of the durations in microseconds, estimated likewise"},
+                                {RPCResult::Type::NUM, "p99", "The 99th percentile of the durations in microseconds, estimated likewise"},
+                                {RPCResult::Type::NUM, "max", "The longest duration of a call in microseconds"},
+                            }},
+                        }},
                     }
                 },
                 RPCExamples{
@@ -281,6 +369,33 @@ static RPCHelpMan getrpcinfo()
     UniValue log_path(UniValue::VSTR, path);
     result.pushKV("logpath", log_path);
 
+    const HTTPServerStats stats{GetHTTPServerStats()};
+    UniValue http(UniValue::VOBJ);
+    http.pushKV("workers", (uint64_t)stats.workers);
+    http.pushKV("max_workers", (uint64_t)stats.max_workers);
+    http.pushKV("queue_depth", (uint64_t)stats.queue_depth);
+    http.pushKV("requests", stats.requests);
+    http.pushKV("requests_reused", stats.requests_reused);
+    http.pushKV("requests_rejected", stats.requests_rejected);
+    http.pushKV("connections", stats.connections);
+    http.pushKV("connections_open", (uint64_t)stats.connections_open);
+    result.pushKV("http", http);
+
+    UniValue methods(UniValue::VOBJ);
+    for (const auto& [method, method_stats] : g_rpc_server_info.method_stats) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("calls", method_stats.calls);
+        entry.pushKV("errors", method_stats.errors);
+        entry.pushKV("bytes_out", method_stats.bytes_out);
+        entry.pushKV("mean", method_stats.total_us / int64_t(method_stats.calls));
+        entry.pushKV("p50", method_stats.Quantile(0.5));
+        entry.pushKV("p95", method_stats.Quantile(0.95));
+        entry.pushKV("p99", method_stats.Quantile(0.99));
+        entry.pushKV("max", method_stats.max_us);
+        methods.pushKV(method, entry);
+    }
+    result.pushKV("methods", methods);
+
     return result;
 }
     };
@@ -324,6 +439,7 @@ bool CRPCTable::removeCommand(const std::string& name, const CRPCCommand* pcmd)
 void StartRPC()
 {
     LogPrint(BCLog::RPC, "Starting RPC\n");
+    g_rpc_slow_log_ms = gArgs.GetIntArg("-rpcslowlog", DEFAULT_RPC_SLOW_LOG);
     g_rpc_running = true;
     g_rpcSignals.Started();
 }
@@ -360,6 +476,7 @@ bool IsRPCRunning()
 void RpcInterruptionPoint()
 {
     if (!IsRPCRunning()) throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED, "Shutting down");
+    if (node::JobCancelRequested()) throw JSONRPCError(RPC_MISC_ERROR, "Job cancelled");
 }
 
 void SetRPCWarmupStatus(const std::string& newStatus)
@@ -413,13 +530,40 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+/** Whether a batch calls a wallet method, whose calls commonly depend on the ones before them */
+static bool BatchCallsWallet(const UniValue& vReq)
 {
-    UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++) {
+        if (!vReq[reqIdx].isObject()) continue;
+        const UniValue& method{find_value(vReq[reqIdx].get_obj(), "method")};
+        if (method.isStr() && (tableRPC.flags(method.get_str()) & CRPCCommand::WALLET)) return true;
+    }
+    return false;
+}
 
-    return ret.write() + "\n";
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const RPCParallelFor& parallel_for)
+{
+    std::vector<UniValue> results(vReq.size());
+    const auto exec_one{[&](size_t reqIdx) { results[reqIdx] = JSONRPCExecOne(jreq, vReq[reqIdx]); }};
+    if (parallel_for && vReq.size() > 1 && !BatchCallsWallet(vReq)) {
+        parallel_for(vReq.size(), exec_one);
+    } else {
+        for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
+            exec_one(reqIdx);
+    }
+
+    // Written reply by reply, as UniValue writes an array, so the bytes of each are counted to its method
+    std::string ret{"["};
+    for (size_t reqIdx = 0; reqIdx < results.size(); ++reqIdx) {
+        if (reqIdx > 0) ret += ",";
+        const std::string reply{results[reqIdx].write()};
+        if (vReq[reqIdx].isObject()) {
+            const UniValue& method{find_value(vReq[reqIdx].get_obj(), "method")};
+            if (method.isStr()) RecordRPCBytesOut(method.get_str(), reply.size());
+        }
+        ret += reply;
+    }
+    return ret + "]\n";
 }
 
 /**
@@ -512,18 +656,27 @@ static bool ExecuteCommands(const std::vector<const CRPCCommand*>& commands, con
 
 UniValue CRPCTable::execute(const JSONRPCRequest &request) const
 {
-    // Return immediately if in warmup
+    // Return immediately if in warmup, unless asked how far it has come
     {
         LOCK(g_rpc_warmup_mutex);
-        if (fRPCInWarmup)
+        if (fRPCInWarmup && !RPC_WARMUP_METHODS.count(request.strMethod))
             throw JSONRPCError(RPC_IN_WARMUP, rpcWarmupStatus);
     }
 
     // Find method
     auto it = mapCommands.find(request.strMethod);
     if (it != mapCommands.end()) {
+        const auto start{SteadyClock::now()};
         UniValue result;
-        if (ExecuteCommands(it->second, request, result)) {
+        bool found;
+        try {
+            found = ExecuteCommands(it->second, request, result);
+        } catch (...) {
+            FinishRPCCall(request, start, /*error=*/true);
+            throw;
+        }
+        FinishRPCCall(request, start, /*error=*/false);
+        if (found) {
             return result;
         }
     }
@@ -547,6 +700,20 @@ static bool ExecuteCommand(const CRPCCommand& command, const JSONRPCRequest& req
     }
 }
 
+std::string CRPCTable::category(const std::string& name) const
+{
+    const auto it{mapCommands.find(name)};
+    if (it == mapCommands.end() || it->second.empty()) return "";
+    return it->second.front()->category;
+}
+
+uint32_t CRPCTable::flags(const std::string& name) const
+{
+    const auto it{mapCommands.find(name)};
+    if (it == mapCommands.end() || it->second.empty()) return 0;
+    return it->second.front()->flags;
+}
+
 std::vector<std::string> CRPCTable::listCommands() const
 {
     std::vector<std::string> commandList;
@@ -8,7 +8,9 @@
 
 #include <rpc/request.h>
 #include <rpc/util.h>
+#include <util/strencodings.h>
 
+#include <array>
 #include <functional>
 #include <map>
 #include <stdint.h>
@@ -17,6 +19,30 @@
 #include <univalue.h>
 
 static const unsigned int DEFAULT_RPC_SERIALIZE_VERSION = 1;
+//! Log calls taking longer than this many milliseconds, 0 to log none
+static const int64_t DEFAULT_RPC_SLOW_LOG = 0;
+
+//! Upper bounds in microseconds of the buckets of the RPC latency histograms
+static constexpr std::array<int64_t, 18> RPC_LATENCY_BUCKETS_US{
+    100, 250, 500, 1'000, 2'500, 5'000, 10'000, 25'000, 50'000, 100'000, 250'000, 500'000,
+    1'000'000, 2'500'000, 5'000'000, 10'000'000, 30'000'000, 60'000'000};
+
+/** Calls of one RPC method since startup */
+struct RPCMethodStats {
+    uint64_t calls{0};
+    //! Calls that returned an error
+    uint64_t errors{0};
+    //! Bytes of the replies sent
+    uint64_t bytes_out{0};
+    int64_t total_us{0};
+    int64_t max_us{0};
+    //! Calls by duration: bucket i counts those up to RPC_LATENCY_BUCKETS_US[i], the last bucket those slower
+    std::array<uint64_t, RPC_LATENCY_BUCKETS_US.size() + 1> buckets{};
+
+    void AddCall(int64_t duration_us, bool error);
+    /// Estimate of the p quantile of the durations (0 < p <= 1), as the upper bound of its bucket, in microseconds
+    int64_t Quantile(double p) const;
+};
 
 class CRPCCommand;
 
@@ -33,8 +59,8 @@ bool IsRPCRunning();
 void RpcInterruptionPoint();
 
 /**
- * Set the RPC warmup status.  When this is done, all RPC calls will error out
- * immediately with RPC_IN_WARMUP.
+ * Set the RPC warmup status.  When this is done, all RPC calls but getstartupinfo
+ * and uptime will error out immediately with RPC_IN_WARMUP.
  */
 void SetRPCWarmupStatus(const std::string& newStatus);
 /* Mark warmup as done.  RPC calls will be processed from now on.  */
@@ -94,10 +120,28 @@ public:
     //! subsequent handlers.
     using Actor = std::function<bool(const JSONRPCRequest& request, UniValue& result, bool last_handler)>;
 
+    //! Category flags, worked out once from the category so dispatch and help need not compare strings
+    enum Flags : uint32_t {
+        HIDDEN = 1 << 0,
+        WALLET = 1 << 1,
+        //! Storage methods, listed in help only for members of the auth list
+        STORAGE = 1 << 2,
+    };
+
+    //! Inline, as the wallet library builds commands without linking the RPC server
+    static uint32_t CategoryFlags(const std::string& category)
+    {
+        uint32_t flags{0};
+        if (category == "hidden") flags |= HIDDEN;
+        if (category == "wallet") flags |= WALLET;
+        if (Capitalize(category) == "Storage") flags |= STORAGE;
+        return flags;
+    }
+
     //! Constructor taking Actor callback supporting multiple handlers.
     CRPCCommand(std::string category, std::string name, Actor actor, std::vector<std::string> args, intptr_t unique_id)
         : category(std::move(category)), name(std::move(name)), actor(std::move(actor)), argNames(std::move(args)),
-          unique_id(unique_id)
+          unique_id(unique_id), flags(CategoryFlags(this->category))
     {
     }
 
@@ -117,6 +161,7 @@ public:
     Actor actor;
     std::vector<std::string> argNames;
     intptr_t unique_id;
+    uint32_t flags;
 };
 
 /**
@@ -144,6 +189,12 @@ public:
     */
     std::vector<std::string> listCommands() const;
 
+    /** Category of a method, empty if it is not registered. */
+    std::string category(const std::string& name) const;
+
+    /** CRPCCommand::Flags of a method, 0 if it is not registered. */
+    uint32_t flags(const std::string& name) const;
+
     /**
      * Return all named arguments that need to be converted by the client from string to another JSON type
      */
@@ -172,9 +223,21 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
+/** Runs fn(i) for every i in [0, count), possibly concurrently, returning once all have run */
+using RPCParallelFor = std::function<void(size_t count, const std::function<void(size_t)>& fn)>;
+/**
+ * Execute a batch of requests, returning their replies in order. With
+ * parallel_for the requests are executed through it, unless the batch calls a
+ * wallet method, in which case they are executed in order as without it.
+ */
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const RPCParallelFor& parallel_for = {});
 
 // Retrieves any serialization flags requested in command line argument
 int RPCSerializationFlags();
 
+/** The calls of every method called since startup, by method */
+std::map<std::string, RPCMethodStats> GetRPCMethodStats();
+/** Count bytes of a reply to a call of method */
+void RecordRPCBytesOut(const std::string& method, size_t bytes);
+
 #endif // BITCOIN_RPC_SERVER_H
@@ -79,6 +79,15 @@ ChainstateManager& EnsureAnyChainman(const std::any& context)
     return EnsureChainman(EnsureAnyNodeContext(context));
 }
 
+std::shared_ptr<const TipSnapshot> EnsureTipSnapshot(const ChainstateManager& chainman)
+{
+    auto snapshot{chainman.GetTipSnapshot()};
+    if (!snapshot) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Chain tip not loaded");
+    }
+    return snapshot;
+}
+
 CBlockPolicyEstimator& EnsureFeeEstimator(const NodeContext& node)
 {
     if (!node.fee_estimator) {
@@ -6,6 +6,7 @@
 #define BITCOIN_RPC_SERVER_UTIL_H
 
 #include <any>
+#include <memory>
 
 class ArgsManager;
 class CBlockPolicyEstimator;
@@ -14,6 +15,7 @@ class CTxMemPool;
 class ChainstateManager;
 class PeerManager;
 class BanMan;
+struct TipSnapshot;
 namespace node {
 struct NodeContext;
 } // namespace node
@@ -27,6 +29,8 @@ ArgsManager& EnsureArgsman(const node::NodeContext& node);
 ArgsManager& EnsureAnyArgsman(const std::any& context);
 ChainstateManager& EnsureChainman(const node::NodeContext& node);
 ChainstateManager& EnsureAnyChainman(const std::any& context);
+//! The tip of the active chain as last published, to read without cs_main
+std::shared_ptr<const TipSnapshot> EnsureTipSnapshot(const ChainstateManager& chainman);
 CBlockPolicyEstimator& EnsureFeeEstimator(const node::NodeContext& node);
 CBlockPolicyEstimator& EnsureAnyFeeEstimator(const std::any& context);
 CConnman& EnsureConnman(const node::NodeContext& node);
@@ -568,6 +568,8 @@ UniValue RPCHelpMan::HandleRequest(const JSONRPCRequest& request) const
         throw JSONRPCError(RPC_TYPE_ERROR, strprintf("Wrong type passed:\n%s", arg_mismatch.write(4)));
     }
     UniValue ret = m_fun(*this, request);
+    // A streamed result went out as it was written, leaving nothing to check
+    if (request.result_stream && request.result_stream->Started()) return ret;
     if (gArgs.GetBoolArg("-rpcdoccheck", DEFAULT_RPC_DOC_CHECK)) {
         UniValue mismatch{UniValue::VARR};
         for (const auto& res : m_results.m_results) {
@@ -4,10 +4,12 @@
 
 #include <scheduler.h>
 
+#include <logging.h>
 #include <sync.h>
 #include <util/syscall_sandbox.h>
 #include <util/time.h>
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include <utility>
@@ -52,15 +54,18 @@ void CScheduler::serviceQueue()
             if (shouldStop() || taskQueue.empty())
                 continue;
 
-            Function f = taskQueue.begin()->second;
+            const std::chrono::steady_clock::time_point due{taskQueue.begin()->first};
+            Task task{std::move(taskQueue.begin()->second)};
             taskQueue.erase(taskQueue.begin());
 
+            const auto start{std::chrono::steady_clock::now()};
             {
                 // Unlock before calling f, so it can reschedule itself or another task
                 // without deadlocking:
                 REVERSE_LOCK(lock);
-                f();
+                task.f();
             }
+            RecordRun(task.name, due, start, std::chrono::steady_clock::now());
         } catch (...) {
             --nThreadsServicingQueue;
             throw;
@@ -70,11 +75,29 @@ void CScheduler::serviceQueue()
     newTaskScheduled.notify_one();
 }
 
-void CScheduler::schedule(CScheduler::Function f, std::chrono::steady_clock::time_point t)
+void CScheduler::RecordRun(const std::string& name, std::chrono::steady_clock::time_point due, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    using std::chrono::duration_cast, std::chrono::microseconds;
+    const std::string& key{name.empty() ? "other" : name};
+    SchedulerTaskStats& stats{m_task_stats[key]};
+    stats.name = key;
+    ++stats.runs;
+    const auto time{duration_cast<microseconds>(end - start)};
+    stats.total_time += time;
+    stats.max_time = std::max(stats.max_time, time);
+    stats.max_delay = std::max(stats.max_delay, duration_cast<microseconds>(start - due));
+
+    if (time > SCHEDULER_TASK_WARN_TIME) {
+        const auto held_up{std::distance(taskQueue.begin(), taskQueue.upper_bound(end))};
+        LogPrintf("Scheduler task %s ran for %dms, %d other tasks came due meanwhile\n", key, Ticks<std::chrono::milliseconds>(time), held_up);
+    }
+}
+
+void CScheduler::schedule(CScheduler::Function f, std::chrono::steady_clock::time_point t, const std::string& name)
 {
     {
         LOCK(newTaskMutex);
-        taskQueue.insert(std::make_pair(t, f));
+        taskQueue.insert(std::make_pair(t, Task{std::move(f), name}));
     }
     newTaskScheduled.notify_one();
 }
@@ -87,7 +110,7 @@ void CScheduler::MockForward(std::chrono::seconds delta_seconds)
         LOCK(newTaskMutex);
 
         // use temp_queue to maintain updated schedule
-        std::multimap<std::chrono::steady_clock::time_point, Function> temp_queue;
+        std::multimap<std::chrono::steady_clock::time_point, Task> temp_queue;
 
         for (const auto& element : taskQueue) {
             temp_queue.emplace_hint(temp_queue.cend(), element.first - delta_seconds, element.second);
@@ -101,15 +124,15 @@ void CScheduler::MockForward(std::chrono::seconds delta_seconds)
     newTaskScheduled.notify_one();
 }
 
-static void Repeat(CScheduler& s, CScheduler::Function f, std::chrono::milliseconds delta)
+static void Repeat(CScheduler& s, CScheduler::Function f, std::chrono::milliseconds delta, const std::string& name)
 {
     f();
-    s.scheduleFromNow([=, &s] { Repeat(s, f, delta); }, delta);
+    s.scheduleFromNow([=, &s] { Repeat(s, f, delta, name); }, delta, name);
 }
 
-void CScheduler::scheduleEvery(CScheduler::Function f, std::chrono::milliseconds delta)
+void CScheduler::scheduleEvery(CScheduler::Function f, std::chrono::milliseconds delta, const std::string& name)
 {
-    scheduleFromNow([this, f, delta] { Repeat(*this, f, delta); }, delta);
+    scheduleFromNow([this, f, delta, name] { Repeat(*this, f, delta, name); }, delta, name);
 }
 
 size_t CScheduler::getQueueInfo(std::chrono::steady_clock::time_point& first,
@@ -130,6 +153,21 @@ bool CScheduler::AreThreadsServicingQueue() const
     return nThreadsServicingQueue;
 }
 
+std::vector<SchedulerTaskStats> CScheduler::GetTaskStats() const
+{
+    std::vector<SchedulerTaskStats> stats;
+    {
+        LOCK(newTaskMutex);
+        for (const auto& [name, task] : m_task_stats) {
+            stats.push_back(task);
+        }
+    }
+    std::sort(stats.begin(), stats.end(), [](const SchedulerTaskStats& a, const SchedulerTaskStats& b) {
+        return a.total_time > b.total_time;
+    });
+    return stats;
+}
+
 
 void SingleThreadedSchedulerClient::MaybeScheduleProcessQueue()
 {
@@ -141,7 +179,7 @@ void SingleThreadedSchedulerClient::MaybeScheduleProcessQueue()
         if (m_are_callbacks_running) return;
         if (m_callbacks_pending.empty()) return;
     }
-    m_scheduler.schedule([this] { this->ProcessQueue(); }, std::chrono::steady_clock::now());
+    m_scheduler.schedule([this] { this->ProcessQueue(); }, std::chrono::steady_clock::now(), "validationinterface");
 }
 
 void SingleThreadedSchedulerClient::ProcessQueue()
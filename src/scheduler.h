@@ -13,10 +13,28 @@
 #include <condition_variable>
 #include <cstddef>
 #include <functional>
+#include <cstdint>
 #include <list>
 #include <map>
+#include <string>
 #include <thread>
 #include <utility>
+#include <vector>
+
+//! Default for -schedulerthreads
+static constexpr int DEFAULT_SCHEDULER_THREADS{2};
+//! Tasks running longer than this are logged, as they hold up the tasks due meanwhile
+static constexpr std::chrono::milliseconds SCHEDULER_TASK_WARN_TIME{1000};
+
+/** Runs of the scheduler tasks of one name, see CScheduler::GetTaskStats */
+struct SchedulerTaskStats {
+    std::string name;
+    uint64_t runs{0};
+    std::chrono::microseconds total_time{0};
+    std::chrono::microseconds max_time{0};
+    //! Longest a run started after it was due, as the threads were busy
+    std::chrono::microseconds max_delay{0};
+};
 
 /**
  * Simple class for background tasks that should be run
@@ -42,16 +60,18 @@ public:
     ~CScheduler();
 
     std::thread m_service_thread;
+    //! Further threads running serviceQueue, so that a long task does not hold up the others
+    std::vector<std::thread> m_extra_service_threads;
 
     typedef std::function<void()> Function;
 
-    /** Call func at/after time t */
-    void schedule(Function f, std::chrono::steady_clock::time_point t) EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
+    /** Call func at/after time t. Runs are counted and timed under the task's name, see GetTaskStats. */
+    void schedule(Function f, std::chrono::steady_clock::time_point t, const std::string& name = "") EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
 
     /** Call f once after the delta has passed */
-    void scheduleFromNow(Function f, std::chrono::milliseconds delta) EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex)
+    void scheduleFromNow(Function f, std::chrono::milliseconds delta, const std::string& name = "") EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex)
     {
-        schedule(std::move(f), std::chrono::steady_clock::now() + delta);
+        schedule(std::move(f), std::chrono::steady_clock::now() + delta, name);
     }
 
     /**
@@ -60,7 +80,7 @@ public:
      * The timing is not exact: Every time f is finished, it is rescheduled to run again after delta. If you need more
      * accurate scheduling, don't use this method.
      */
-    void scheduleEvery(Function f, std::chrono::milliseconds delta) EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
+    void scheduleEvery(Function f, std::chrono::milliseconds delta, const std::string& name = "") EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
 
     /**
      * Mock the scheduler to fast forward in time.
@@ -79,14 +99,14 @@ public:
     {
         WITH_LOCK(newTaskMutex, stopRequested = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) m_service_thread.join();
+        JoinServiceThreads();
     }
     /** Tell any threads running serviceQueue to stop when there is no work left to be done */
     void StopWhenDrained() EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex)
     {
         WITH_LOCK(newTaskMutex, stopWhenEmpty = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) m_service_thread.join();
+        JoinServiceThreads();
     }
 
     /**
@@ -100,14 +120,34 @@ public:
     /** Returns true if there are threads actively running in serviceQueue() */
     bool AreThreadsServicingQueue() const EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
 
+    /** Runs and run times of the tasks by name, those taking the most time first. Unnamed tasks are counted as "other". */
+    std::vector<SchedulerTaskStats> GetTaskStats() const EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex);
+
 private:
+    struct Task {
+        Function f;
+        std::string name;
+    };
+
     mutable Mutex newTaskMutex;
     std::condition_variable newTaskScheduled;
-    std::multimap<std::chrono::steady_clock::time_point, Function> taskQueue GUARDED_BY(newTaskMutex);
+    std::multimap<std::chrono::steady_clock::time_point, Task> taskQueue GUARDED_BY(newTaskMutex);
+    std::map<std::string, SchedulerTaskStats> m_task_stats GUARDED_BY(newTaskMutex);
     int nThreadsServicingQueue GUARDED_BY(newTaskMutex){0};
     bool stopRequested GUARDED_BY(newTaskMutex){false};
     bool stopWhenEmpty GUARDED_BY(newTaskMutex){false};
     bool shouldStop() const EXCLUSIVE_LOCKS_REQUIRED(newTaskMutex) { return stopRequested || (stopWhenEmpty && taskQueue.empty()); }
+
+    void RecordRun(const std::string& name, std::chrono::steady_clock::time_point due, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) EXCLUSIVE_LOCKS_REQUIRED(newTaskMutex);
+
+    void JoinServiceThreads()
+    {
+        if (m_service_thread.joinable()) m_service_thread.join();
+        for (std::thread& thread : m_extra_service_threads) {
+            if (thread.joinable()) thread.join();
+        }
+        m_extra_service_threads.clear();
+    }
 };
 
 /**
@@ -7,6 +7,7 @@
 
 #include <pubkey.h>
 #include <random.h>
+#include <logging.h>
 #include <uint256.h>
 #include <util/system.h>
 
@@ -35,6 +36,8 @@ private:
     std::shared_mutex cs_sigcache;
 
 public:
+    ValidationCacheCounters m_counters;
+
     CSignatureCache()
     {
         uint256 nonce = GetRandHash();
@@ -68,13 +71,20 @@ public:
     Get(const uint256& entry, const bool erase)
     {
         std::shared_lock<std::shared_mutex> lock(cs_sigcache);
-        return setValid.contains(entry, erase);
+        const bool hit{setValid.contains(entry, erase)};
+        m_counters.Lookup(hit);
+        return hit;
     }
 
     void Set(const uint256& entry)
     {
         std::unique_lock<std::shared_mutex> lock(cs_sigcache);
-        setValid.insert(entry);
+        if (const auto grow_bytes{m_counters.Insert(setValid.insert(entry))}) {
+            if (const auto resized{setValid.resize_bytes(*grow_bytes)}) {
+                m_counters.Resized(resized->first, resized->second);
+                LogPrint(BCLog::VALIDATION, "Signature cache grown to %zu MiB under eviction pressure\n", resized->second >> 20);
+            }
+        }
     }
     std::optional<std::pair<uint32_t, size_t>> setup_bytes(size_t n)
     {
@@ -93,17 +103,63 @@ static CSignatureCache signatureCache;
 
 // To be called once in AppInitMain/BasicTestingSetup to initialize the
 // signatureCache.
-bool InitSignatureCache(size_t max_size_bytes)
+bool InitSignatureCache(size_t max_size_bytes, size_t max_grow_bytes)
 {
     auto setup_results = signatureCache.setup_bytes(max_size_bytes);
     if (!setup_results) return false;
 
     const auto [num_elems, approx_size_bytes] = *setup_results;
+    signatureCache.m_counters.Setup(num_elems, approx_size_bytes, std::max(max_size_bytes, max_grow_bytes));
     LogPrintf("Using %zu MiB out of %zu MiB requested for signature cache, able to store %zu elements\n",
               approx_size_bytes >> 20, max_size_bytes >> 20, num_elems);
     return true;
 }
 
+ValidationCacheStats GetSignatureCacheStats()
+{
+    return signatureCache.m_counters.GetStats();
+}
+
+void ValidationCacheCounters::Setup(uint32_t num_elems, size_t size_bytes, size_t max_size_bytes)
+{
+    m_num_elems = num_elems;
+    m_size_bytes = size_bytes;
+    m_max_size_bytes = max_size_bytes;
+    m_evictions_since_resize = 0;
+}
+
+void ValidationCacheCounters::Resized(uint32_t num_elems, size_t size_bytes)
+{
+    ++m_resizes;
+    m_num_elems = num_elems;
+    m_size_bytes = size_bytes;
+    m_evictions_since_resize = 0;
+}
+
+std::optional<size_t> ValidationCacheCounters::Insert(uint32_t evicted)
+{
+    m_inserts.fetch_add(1, std::memory_order_relaxed);
+    if (evicted == 0) return std::nullopt;
+    m_evictions.fetch_add(evicted, std::memory_order_relaxed);
+    if ((m_evictions_since_resize += evicted) < m_num_elems / 8) return std::nullopt;
+    const size_t grow_bytes{m_size_bytes * 2};
+    if (grow_bytes > m_max_size_bytes) return std::nullopt;
+    return grow_bytes;
+}
+
+ValidationCacheStats ValidationCacheCounters::GetStats() const
+{
+    return ValidationCacheStats{
+        .hits = m_hits.load(std::memory_order_relaxed),
+        .misses = m_misses.load(std::memory_order_relaxed),
+        .inserts = m_inserts.load(std::memory_order_relaxed),
+        .evictions = m_evictions.load(std::memory_order_relaxed),
+        .resizes = m_resizes.load(),
+        .size_bytes = m_size_bytes.load(),
+        .max_size_bytes = m_max_size_bytes.load(),
+    };
+}
+
 bool CachingTransactionSignatureChecker::VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
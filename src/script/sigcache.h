@@ -10,6 +10,8 @@
 #include <span.h>
 #include <util/hasher.h>
 
+#include <atomic>
+#include <cstdint>
 #include <optional>
 #include <vector>
 
@@ -17,6 +19,59 @@
 // systems). Due to how we count cache size, actual memory usage is slightly
 // more (~32.25 MiB)
 static constexpr size_t DEFAULT_MAX_SIG_CACHE_BYTES{32 << 20};
+//! Default for -sigcachebudget, in MiB: 0 keeps the caches at -maxsigcachesize
+static constexpr int64_t DEFAULT_SIG_CACHE_BUDGET{0};
+
+/** Counters and size of the signature cache or the script execution cache */
+struct ValidationCacheStats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t inserts{0};
+    //! Entries dropped to make room for newer ones before they were used
+    uint64_t evictions{0};
+    uint32_t resizes{0};
+    size_t size_bytes{0};
+    size_t max_size_bytes{0};
+};
+
+/**
+ * Counts the lookups and evictions of a validation cache, and tells when to
+ * grow it. A burst of transactions, such as storage batches, can evict the
+ * entries of transactions still waiting for a block, which then has all of
+ * their scripts verified again. So once as many entries were evicted since
+ * the cache was last sized as an eighth of its capacity, it is doubled, as
+ * long as it stays within its maximum size.
+ */
+class ValidationCacheCounters
+{
+private:
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_inserts{0};
+    std::atomic<uint64_t> m_evictions{0};
+    std::atomic<uint64_t> m_evictions_since_resize{0};
+    std::atomic<uint32_t> m_resizes{0};
+    std::atomic<uint32_t> m_num_elems{0};
+    std::atomic<size_t> m_size_bytes{0};
+    std::atomic<size_t> m_max_size_bytes{0};
+
+public:
+    /** Record the size the cache was set up to, and the size it may grow to. */
+    void Setup(uint32_t num_elems, size_t size_bytes, size_t max_size_bytes);
+
+    /** Record the size the cache was grown to. */
+    void Resized(uint32_t num_elems, size_t size_bytes);
+
+    void Lookup(bool hit) { (hit ? m_hits : m_misses).fetch_add(1, std::memory_order_relaxed); }
+
+    /** Count an insert, which evicted the given number of entries. Returns the size to grow the cache to, if it should. */
+    std::optional<size_t> Insert(uint32_t evicted);
+
+    ValidationCacheStats GetStats() const;
+};
+
+/** Lookup and eviction counters of the signature cache. */
+ValidationCacheStats GetSignatureCacheStats();
 
 class CPubKey;
 
@@ -32,6 +87,10 @@ public:
     bool VerifySchnorrSignature(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash) const override;
 };
 
-[[nodiscard]] bool InitSignatureCache(size_t max_size_bytes);
+/**
+ * Set up the signature cache at max_size_bytes, letting it grow under eviction
+ * pressure to max_grow_bytes if larger.
+ */
+[[nodiscard]] bool InitSignatureCache(size_t max_size_bytes, size_t max_grow_bytes = 0);
 
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
@@ -7,12 +7,23 @@
 // Test
 
 
+#include <memusage.h>
+#include <node/blockreader.h>
+#include <node/interface_ui.h>
 #include <storage/auth.h>
 #include <storage/chunk.h>
 #include <storage/util.h>
+#include <util/hasher.h>
+#include <util/system.h>
+#include <util/trace.h>
 #include <wallet/fees.h>
 
+#include <algorithm>
+#include <future>
+#include <memory>
 #include <time.h>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace node;
 
@@ -20,52 +31,80 @@ uint160 authUser;
 uint32_t authTime{0};
 std::string authUserKey;
 
-RecursiveMutex authListLock;
-std::vector<uint160> authList;
+// Immutable authList, replaced whole on every change so that readers never take a lock
+struct auth_list_snapshot {
+    //! members in the order they were added
+    std::vector<uint160> members;
+    std::unordered_set<uint160, SaltedUint160Hasher> lookup;
+
+    explicit auth_list_snapshot(const std::vector<uint160>& list) : members(list), lookup(list.begin(), list.end()) {}
+};
+
+// Serializes writers, each of which publishes a new snapshot
+Mutex authListLock;
+std::shared_ptr<const auth_list_snapshot> authList;
+
+static std::shared_ptr<const auth_list_snapshot> load_auth_list()
+{
+    return std::atomic_load(&authList);
+}
+
+static void store_auth_list(const std::vector<uint160>& tempList) EXCLUSIVE_LOCKS_REQUIRED(authListLock)
+{
+    std::atomic_store(&authList, std::shared_ptr<const auth_list_snapshot>(std::make_shared<const auth_list_snapshot>(tempList)));
+}
+
+static std::vector<uint160> copy_auth_members() EXCLUSIVE_LOCKS_REQUIRED(authListLock)
+{
+    const auto snapshot = load_auth_list();
+    return snapshot ? snapshot->members : std::vector<uint160>{};
+}
 
 void add_auth_member(uint160 pubkeyhash)
 {
-    LOCK(authListLock);
-    for (auto& l : authList) {
-        if (l == pubkeyhash) {
+    {
+        LOCK(authListLock);
+        if (is_auth_member(pubkeyhash)) {
             return;
         }
+        std::vector<uint160> tempList = copy_auth_members();
+        tempList.push_back(pubkeyhash);
+        TRACE3(auth, member_changed, pubkeyhash.data(), true, tempList.size());
+        store_auth_list(tempList);
     }
-    authList.push_back(pubkeyhash);
+    uiInterface.NotifyAuthListChanged(pubkeyhash, /*added=*/true);
 }
 
 void remove_auth_member(uint160 pubkeyhash)
 {
-    LOCK(authListLock);
-    std::vector<uint160> tempList;
-    for (auto& l : authList) {
-        if (l != pubkeyhash) {
-            tempList.push_back(l);
+    {
+        LOCK(authListLock);
+        if (!is_auth_member(pubkeyhash)) {
+            return;
         }
+        std::vector<uint160> tempList = copy_auth_members();
+        tempList.erase(std::remove(tempList.begin(), tempList.end(), pubkeyhash), tempList.end());
+        TRACE3(auth, member_changed, pubkeyhash.data(), false, tempList.size());
+        store_auth_list(tempList);
     }
-    authList = tempList;
+    uiInterface.NotifyAuthListChanged(pubkeyhash, /*added=*/false);
 }
 
 // Check for file storage authorization
 bool is_auth_member(uint160 pubkeyhash)
 {
-    LOCK(authListLock);
-    for (auto& l : authList) {
-        if (l == pubkeyhash) {
-            return true;
-        }
-    }
-    return false;
+    const auto snapshot = load_auth_list();
+    return snapshot && snapshot->lookup.count(pubkeyhash) > 0;
 }
 
 bool set_auth_user(std::string& privatewif)
 {
     CKey key = DecodeSecret(privatewif);
     if (!key.IsValid()) {
-        LogPrint (BCLog::ALL, "\n");
-        LogPrint (BCLog::ALL, "The private key provided via 'lynx-cli setauth' has NOT passed validation.\n");        
-        LogPrint (BCLog::ALL, "setauth set_auth_user privkey privatewif %s \n", privatewif);
-        LogPrint (BCLog::ALL, "\n");
+        LogPrint (BCLog::AUTH, "\n");
+        LogPrint (BCLog::AUTH, "The private key provided via 'lynx-cli setauth' has NOT passed validation.\n");        
+        LogPrint (BCLog::AUTH, "setauth set_auth_user privkey privatewif %s \n", privatewif);
+        LogPrint (BCLog::AUTH, "\n");
       return false;
     }
 
@@ -74,48 +113,178 @@ bool set_auth_user(std::string& privatewif)
     authUser = hash160;
 
     // Dump authUser to log
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "The private key provided via 'lynx-cli setauth' has passed validation.\n");        
-    LogPrint (BCLog::ALL, "setauth set_auth_user privkey privatewif %s \n", privatewif);
-    LogPrint (BCLog::ALL, "setauth set_auth_user pubkey authUser %s\n", authUser.ToString());
-
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "NOTE THE FOLLOWING PROJECT PROTOCOL FOR ENABLING USER PUTFILE FUNCTIONALITY (set_auth_user)\n");
-    LogPrint (BCLog::ALL, "1) The super-user will lynx-cli setauth with the private motherkey.\n");
-    LogPrint (BCLog::ALL, "The above will succeed because the public motherkey is added to global variable authList at daemon startup.\n");
-    LogPrint (BCLog::ALL, "2) The super-user will lynx-cli setauth with the user privatekey.\n");
-    LogPrint (BCLog::ALL, "The above will fail because the user publickey does not exist in authList.\n");
-    LogPrint (BCLog::ALL, "However, the user publickey associated with the user privatekey will be sent to the log.\n");
-    LogPrint (BCLog::ALL, "3) The super-user will lynx-cli addauth with the user publickey from the log.\n");
-    LogPrint (BCLog::ALL, "Now the user publickey exists in authList\n");
-    LogPrint (BCLog::ALL, "4) The user will lynx-cli setauth with the user privatekey.\n");
-    LogPrint (BCLog::ALL, "The above will succeed because the user publickey exists in authList\n");
-    LogPrint (BCLog::ALL, "Now, the user is authenticated and putfile functionality is enabled for that user.\n");
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::AUTH, "\n");
+    LogPrint (BCLog::AUTH, "The private key provided via 'lynx-cli setauth' has passed validation.\n");        
+    LogPrint (BCLog::AUTH, "setauth set_auth_user privkey privatewif %s \n", privatewif);
+    LogPrint (BCLog::AUTH, "setauth set_auth_user pubkey authUser %s\n", authUser.ToString());
+
+    LogPrint (BCLog::AUTH, "\n");
+    LogPrint (BCLog::AUTH, "NOTE THE FOLLOWING PROJECT PROTOCOL FOR ENABLING USER PUTFILE FUNCTIONALITY (set_auth_user)\n");
+    LogPrint (BCLog::AUTH, "1) The super-user will lynx-cli setauth with the private motherkey.\n");
+    LogPrint (BCLog::AUTH, "The above will succeed because the public motherkey is added to global variable authList at daemon startup.\n");
+    LogPrint (BCLog::AUTH, "2) The super-user will lynx-cli setauth with the user privatekey.\n");
+    LogPrint (BCLog::AUTH, "The above will fail because the user publickey does not exist in authList.\n");
+    LogPrint (BCLog::AUTH, "However, the user publickey associated with the user privatekey will be sent to the log.\n");
+    LogPrint (BCLog::AUTH, "3) The super-user will lynx-cli addauth with the user publickey from the log.\n");
+    LogPrint (BCLog::AUTH, "Now the user publickey exists in authList\n");
+    LogPrint (BCLog::AUTH, "4) The user will lynx-cli setauth with the user privatekey.\n");
+    LogPrint (BCLog::AUTH, "The above will succeed because the user publickey exists in authList\n");
+    LogPrint (BCLog::AUTH, "Now, the user is authenticated and putfile functionality is enabled for that user.\n");
+    LogPrint (BCLog::AUTH, "\n");
     
     authUserKey = privatewif;
 
-    LogPrint (BCLog::ALL, "setauth set_auth_user privkey authUserKey %s \n", authUserKey);
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::AUTH, "setauth set_auth_user privkey authUserKey %s \n", authUserKey);
+    LogPrint (BCLog::AUTH, "\n");
 
     return true;
 }
 
+void set_tenant_secret(chunk_reassembler& file)
+{
+    // An invalid or unset key gives no secret, and encrypted assets fail with ERR_DECRYPT
+    const CKey key = DecodeSecret(authUserKey);
+    file.set_secret({key.begin(), key.size()});
+}
+
 void build_auth_list(const Consensus::Params& params)
 {
     LOCK(authListLock);
-    if (authList.size() > 0) {
+    if (!copy_auth_members().empty()) {
         return;
     }
 
-    authList.push_back(params.initAuthUser);
+    store_auth_list({params.initAuthUser});
     authTime = params.initAuthTime;
+    TRACE2(auth, list_replaced, uint64_t{1}, authTime);
 }
 
 void copy_auth_list(std::vector<uint160>& tempList)
+{
+    const auto snapshot = load_auth_list();
+    tempList = snapshot ? snapshot->members : std::vector<uint160>{};
+}
+
+// Discard all authdata seen so far, leaving only the initial auth user
+void reset_auth_list(const Consensus::Params& params)
 {
     LOCK(authListLock);
-    tempList = authList;
+    store_auth_list({params.initAuthUser});
+    authTime = params.initAuthTime;
+    TRACE2(auth, list_replaced, uint64_t{1}, authTime);
+}
+
+void get_auth_state(std::vector<uint160>& tempList, uint32_t& tempTime)
+{
+    LOCK(authListLock);
+    tempList = copy_auth_members();
+    tempTime = authTime;
+}
+
+void set_auth_state(const std::vector<uint160>& tempList, uint32_t tempTime)
+{
+    LOCK(authListLock);
+    store_auth_list(tempList);
+    authTime = tempTime;
+    TRACE2(auth, list_replaced, tempList.size(), authTime);
+}
+
+size_t auth_list_dynamic_usage()
+{
+    const auto snapshot = load_auth_list();
+    if (!snapshot) return 0;
+    return memusage::DynamicUsage(snapshot) + memusage::DynamicUsage(snapshot->members) + memusage::DynamicUsage(snapshot->lookup);
+}
+
+// Signers recovered so far, by the hash of the signed hash and the signature
+static Mutex signerCacheLock;
+static std::unordered_map<uint256, std::optional<uint160>, SaltedTxidHasher> signerCache GUARDED_BY(signerCacheLock);
+
+static uint256 signer_cache_key (const uint256& hash, Span<const unsigned char> signature)
+{
+    return (HashWriter{} << hash << signature).GetSHA256();
+}
+
+size_t signer_cache_dynamic_usage()
+{
+    LOCK(signerCacheLock);
+    return memusage::DynamicUsage(signerCache);
+}
+
+static std::optional<uint160> recover_signer_uncached (const uint256& hash, Span<const unsigned char> signature)
+{
+    CPubKey pubkey;
+    if (!pubkey.RecoverCompact(hash, std::vector<unsigned char>(signature.begin(), signature.end()))) {
+        return std::nullopt;
+    }
+    return Hash160(pubkey);
+}
+
+static void remember_signer (const uint256& key, const std::optional<uint160>& signer) EXCLUSIVE_LOCKS_REQUIRED(signerCacheLock)
+{
+    if (signerCache.size() >= MAX_SIGNER_CACHE_ENTRIES) {
+        signerCache.clear();
+    }
+    signerCache.emplace(key, signer);
+}
+
+std::optional<uint160> recover_signer (const uint256& hash, Span<const unsigned char> signature)
+{
+    const uint256 key{signer_cache_key(hash, signature)};
+    {
+        LOCK(signerCacheLock);
+        const auto it = signerCache.find(key);
+        if (it != signerCache.end()) {
+            return it->second;
+        }
+    }
+    const std::optional<uint160> signer{recover_signer_uncached(hash, signature)};
+    LOCK(signerCacheLock);
+    remember_signer(key, signer);
+    return signer;
+}
+
+void recover_signers (const std::vector<signed_hash>& signed_hashes, std::vector<std::optional<uint160>>& signers)
+{
+    signers.assign(signed_hashes.size(), std::nullopt);
+
+    // Take what is remembered, note what is not
+    std::vector<uint256> keys(signed_hashes.size());
+    std::vector<size_t> missing;
+    {
+        LOCK(signerCacheLock);
+        for (size_t i = 0; i < signed_hashes.size(); ++i) {
+            keys[i] = signer_cache_key(signed_hashes[i].hash, signed_hashes[i].signature);
+            const auto it = signerCache.find(keys[i]);
+            if (it != signerCache.end()) {
+                signers[i] = it->second;
+            } else {
+                missing.push_back(i);
+            }
+        }
+    }
+
+    // Each thread recovers a range of the missing ones, this one the first
+    const auto recover_range = [&](size_t begin, size_t end) {
+        for (size_t j = begin; j < end; ++j) {
+            signers[missing[j]] = recover_signer_uncached(signed_hashes[missing[j]].hash, signed_hashes[missing[j]].signature);
+        }
+    };
+    const size_t threads{std::clamp<size_t>(missing.size() / MIN_SIGNERS_PER_THREAD, 1, std::max(GetNumCores(), 1))};
+    const size_t per_thread{(missing.size() + threads - 1) / threads};
+    std::vector<std::future<void>> others;
+    for (size_t begin = per_thread; begin < missing.size(); begin += per_thread) {
+        others.push_back(std::async(std::launch::async, recover_range, begin, std::min(begin + per_thread, missing.size())));
+    }
+    recover_range(0, std::min(per_thread, missing.size()));
+    for (auto& other : others) {
+        other.get();
+    }
+
+    LOCK(signerCacheLock);
+    for (size_t i : missing) {
+        remember_signer(keys[i], signers[i]);
+    }
 }
 
 bool is_signature_valid_raw(std::vector<unsigned char>& signature, uint256& hash)
@@ -124,13 +293,12 @@ bool is_signature_valid_raw(std::vector<unsigned char>& signature, uint256& hash
         return false;
     }
 
-    CPubKey pubkey;
-    if (!pubkey.RecoverCompact(hash, signature)) {
+    const std::optional<uint160> signer{recover_signer(hash, signature)};
+    if (!signer) {
         return false;
     }
 
-    uint160 hash160(Hash160(pubkey));
-    if (!is_auth_member(hash160)) {
+    if (!is_auth_member(*signer)) {
         return false;
     }
 
@@ -332,11 +500,11 @@ bool process_auth_chunk (std::string& chunk, int& , int pintOffset)
     get_hash_from_auth (chunk, pubkey, pintOffset);
     get_signature_from_auth (chunk, signature, pintOffset);
 
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "AUTHORIZE TENANT DATA STRUCTURE (%s)\n", __func__);
-    LogPrint (BCLog::ALL, "magic type time pubkey signature\n");
-    LogPrint (BCLog::ALL, "%s %s %s %s %s\n", magic, type, time, pubkey, signature);
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::AUTH, "\n");
+    LogPrint (BCLog::AUTH, "AUTHORIZE TENANT DATA STRUCTURE (%s)\n", __func__);
+    LogPrint (BCLog::AUTH, "magic type time pubkey signature\n");
+    LogPrint (BCLog::AUTH, "%s %s %s %s %s\n", magic, type, time, pubkey, signature);
+    LogPrint (BCLog::AUTH, "\n");
 
     // addauth or delauth
     if (operation == OPAUTH_ADDUSER) {
@@ -358,6 +526,70 @@ bool process_auth_chunk (std::string& chunk, int& , int pintOffset)
     return true;
 }
 
+// The signature covers the hex notation of the authdata fields before it
+static bool is_signature_valid_auth (const auth_view& view)
+{
+    uint256 checkhash;
+    sha256_hash_of_hex(view.payload.first(view.payload.size() - view.signature.size()), checkhash.begin());
+
+    std::vector<unsigned char> vchsig(view.signature.begin(), view.signature.end());
+    return is_signature_valid_raw(vchsig, checkhash);
+}
+
+// Check time, on authdata parsed straight from the script
+bool check_contextual_auth (const auth_view& view, int& error_level)
+{
+    // set authTime to genesis if not init
+    if (authTime == 0) {
+        authTime = Params().GetConsensus().initAuthTime;
+    }
+
+    if (view.time < authTime) {
+        // each auth message timestamp must be greater
+        // than that of the previous timestamp
+        return false;
+    }
+    authTime = view.time;
+
+    return true;
+}
+
+// Authorize or de-authorize tenant, on authdata parsed straight from the script
+bool process_auth_chunk (const auth_view& view, int& error_level)
+{
+    // delauth or addauth
+    if (view.operation != OPAUTH_ADDUSER_BIN && view.operation != OPAUTH_DELUSER_BIN) {
+        return false;
+    }
+
+    // Validate signature
+    if (!is_signature_valid_auth (view)) {
+        return false;
+    }
+
+    const uint160 hash160 = get_hash160_from_auth (view);
+
+    LogPrint (BCLog::AUTH, "\n");
+    LogPrint (BCLog::AUTH, "AUTHORIZE TENANT DATA STRUCTURE (%s)\n", __func__);
+    LogPrint (BCLog::AUTH, "magic type time pubkey signature\n");
+    LogPrint (BCLog::AUTH, "%s %02x %08x %s %s\n", OPAUTH_MAGIC, view.operation, view.time, HexStr(view.hash), HexStr(view.signature));
+    LogPrint (BCLog::AUTH, "\n");
+
+    // addauth or delauth
+    if (view.operation == OPAUTH_ADDUSER_BIN) {
+        add_auth_member(hash160);
+    } else {
+        remove_auth_member(hash160);
+    }
+
+    // Detect skeleton pubkey delauth, and put it back
+    if ((view.operation == OPAUTH_DELUSER_BIN) && (hash160 == Params().GetConsensus().initAuthUser)) {
+        add_auth_member(hash160);
+    }
+
+    return true;
+}
+
 bool compare_pubkey2 (std::string& chunk, int& , int pintOffset, uint160 hash160)
 {
     std::string hash, operation;
@@ -392,32 +624,10 @@ bool compare_pubkey2 (std::string& chunk, int& , int pintOffset, uint160 hash160
 }
 
 // Detect authdata, rather than store asset data
-bool is_opreturn_an_authdata(const CScript& script_data, int& error_level)
+bool is_opreturn_an_authdata(Span<const unsigned char> script_data, int& error_level)
 {
-    int type;
-    std::string opdata, chunk;
-    opdata = HexStr(script_data);
-
-    int intOffset;
-
-    // if (!strip_opreturndata_from_chunk(opdata, chunk)) {
-
-    // Return offset, rather than strip non-payload data
-    if (!strip_opreturndata_from_chunk (opdata, chunk, intOffset)) {
-        //LogPrintf("%s - failed at strip_opreturndata_from_chunk\n", __func__);
-        return false;
-    }
-
-    // is_valid_chunk(chunk, type);
-
-    // Chech for auth data magic
-    is_valid_chunk (opdata, type, intOffset);
-    if (type != 2) {
-        //LogPrintf("%s - unknown chunk type\n", __func__);
-        return false;
-    }
-
-    return true;
+    // Check for auth data magic on the script bytes, without hex conversion
+    return is_auth_magic_in_script (script_data);
 }
 
 /*
@@ -458,26 +668,8 @@ bool found_opreturn_in_authdata(const CScript& script_data, int& error_level, bo
 
 bool found_opreturn_in_authdata (const CScript& script_data, int& error_level, bool test_accept)
 {
-    int type;
-    std::string opdata, chunk;
-    opdata = HexStr(script_data);
-
-    int intOffset; 
-
-    // if (!strip_opreturndata_from_chunk(opdata, chunk)) {
-
-    // Return offset rather than strip non-payload data
-    if (!strip_opreturndata_from_chunk (opdata, chunk, intOffset)) {
-        //LogPrintf("%s - failed at strip_opreturndata_from_chunk\n", __func__);
-        return false;
-    }
-
-    // is_valid_chunk(chunk, type)
-
-    // Validate magic
-    is_valid_chunk (opdata, type, intOffset);
-    if (type != 2) {
-        //LogPrintf("%s - unknown chunk type\n", __func__);
+    // Cheap binary prefilter, most OP_RETURNs are not authdata
+    if (!is_auth_magic_in_script (script_data)) {
         return false;
     }
 
@@ -486,27 +678,32 @@ bool found_opreturn_in_authdata (const CScript& script_data, int& error_level, b
         return true;
     }
 
-    // if (!check_contextual_auth(chunk, error_level)) {
-
-    // Check magic and time
-    if (!check_contextual_auth (opdata, error_level, intOffset)) {
-        //LogPrintf("%s - failed at check_contextual_auth\n", __func__);
+    // Parse fields straight from the script bytes, rather than from its hex
+    auth_view view;
+    if (!parse_auth_from_script (script_data, view)) {
         return false;
     }
 
-    // if (!process_auth_chunk(chunk, error_level)) {
+    // Check time
+    if (!check_contextual_auth (view, error_level)) {
+        return false;
+    }
 
     // Authorize tenant or de-authorize tenant
-    if (!process_auth_chunk (opdata, error_level, intOffset)) {
-        //LogPrintf("%s - failed at process_auth_chunk\n", __func__);
+    if (!process_auth_chunk (view, error_level)) {
         return false;
     }
 
     return true;
 }
 
-bool compare_pubkey (const CScript& script_data, int& error_level, uint160 hash160)
+bool compare_pubkey (Span<const unsigned char> script_data, int& error_level, uint160 hash160)
 {
+    // Cheap binary prefilter, most OP_RETURNs are not authdata
+    if (!is_auth_magic_in_script (script_data)) {
+        return false;
+    }
+
     int type;
     std::string opdata, chunk;
     opdata = HexStr(script_data);
@@ -578,130 +775,108 @@ bool check_mempool_for_authdata(const CTxMemPool& mempool)
 
 // noop
 
-bool scan_blocks_for_authdata(ChainstateManager& chainman)
+// Authdata is only looked for in transactions with few outputs, store asset transactions have many
+static bool is_authdata_candidate(const CTransaction& tx)
 {
-    const CChain& active_chain = chainman.ActiveChain();
-    const int tip_height = active_chain.Height();
-
-    // Timing
-    clock_t start, end;
-    clock_t start_t, end_t;
-    double time_taken;
-    double t_rbfd = 0.0;
-    double t_ioaa = 0.0;
-    double t_foia = 0.0;
-
-    CBlock block{};
-    CBlockIndex* pindex = nullptr;
+    return !tx.IsCoinBase() && !tx.IsCoinStake() && tx.vout.size() < 5;
+}
 
-    start_t = clock ();    
+bool does_block_have_authdata(const CBlock& block)
+{
+    for (const auto& tx : block.vtx) {
+        if (!is_authdata_candidate(*tx)) {
+            continue;
+        }
+        for (const auto& out : tx->vout) {
+            if (out.scriptPubKey.IsOpReturn() && is_auth_magic_in_script(out.scriptPubKey)) {
+                return true;
+            }
+        }
+    }
 
-LogPrint (BCLog::ALL, "tip_height %d \n", tip_height);    
+    return false;
+}
 
-    // Begin scanning with POS blocks
-    //for (int height = 6000; height < tip_height; height++) {
-    for (int height = Params().GetConsensus().nUUIDBlockStart; height < tip_height; height++) {
+// Validate the authdata in a block, and popoulate authList
+int process_block_authdata(const CBlock& block)
+{
+    int intAuthCount = 0;
 
-#ifdef TIMING
-    start = clock ();    
-#endif
+    // Loop on block transactions
+    for (unsigned int vtx = 0; vtx < block.vtx.size(); vtx++) {
 
-        pindex = active_chain[height];
-        if (!ReadBlockFromDisk(block, pindex, chainman.GetConsensus())) {
-            return false;
+        if (!is_authdata_candidate(*block.vtx[vtx])) {
+            continue;
         }
 
-#ifdef TIMING
-    end = clock ();    
-    t_rbfd = t_rbfd + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
+        // Loop on transaction outputs
+        for (unsigned int vout = 0; vout < block.vtx[vtx]->vout.size(); vout++) {
 
-        // Loop on block transactions
-        for (unsigned int vtx = 0; vtx < block.vtx.size(); vtx++) {
-
-            if (block.vtx[vtx]->IsCoinBase() || block.vtx[vtx]->IsCoinStake()) {
-                continue;
-            }
+            const CScript& opreturn_out = block.vtx[vtx]->vout[vout].scriptPubKey;
 
-if (block.vtx[vtx]->vout.size() < 5) {            
+            // If OP_RETURN
+            if (opreturn_out.IsOpReturn()) {
+                int error_level;
 
-            // Loop on transaction outputs
-            for (unsigned int vout = 0; vout < block.vtx[vtx]->vout.size(); vout++) {
-
-                const CScript opreturn_out = block.vtx[vtx]->vout[vout].scriptPubKey;
-
-                // If OP_RETURN
-                if (opreturn_out.IsOpReturn()) {
-                    int error_level;
+                // If auth chunk, rather than data chunk
+                if (!is_opreturn_an_authdata (opreturn_out, error_level)) {
+                    continue;
+                }
 
-#ifdef TIMING
-    start = clock ();    
-#endif
+                intAuthCount++;
 
-                    // If auth chunk, rather than data chunk
-                    if (!is_opreturn_an_authdata (opreturn_out, error_level)) {
+                // Validate authdata, and popoulate authList
+                if (!found_opreturn_in_authdata (opreturn_out, error_level)) {
+                    LogPrint (BCLog::AUTH, "\n");
+                    LogPrint (BCLog::AUTH, "An invalid Tenant public key was found in TX %s (vout %d).\n", block.vtx[vtx]->GetHash().ToString(), vout);
+                } else {
+                    LogPrint (BCLog::AUTH, "A valid Tenant public key was found in TX %s (vout %d).\n", block.vtx[vtx]->GetHash().ToString(), vout);
+                }
+            }
+        }
+    }
 
-#ifdef TIMING
-    end = clock ();    
-    t_ioaa = t_ioaa + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
+    return intAuthCount;
+}
 
-                        continue;
-                    }
+// Apply the authdata of the blocks after pindexFrom (or from nUUIDBlockStart if null) up to and including pindexTo
+bool scan_blocks_for_authdata(ChainstateManager& chainman, const CBlockIndex* pindexFrom, const CBlockIndex* pindexTo)
+{
+    // Timing
+    clock_t start_t, end_t;
+    double time_taken;
 
-#ifdef TIMING
-    end = clock ();    
-    t_ioaa = t_ioaa + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
-                     // Validate authdata, and popoulate authList
-                    if (!found_opreturn_in_authdata (opreturn_out, error_level)) {
-                        LogPrint (BCLog::ALL, "\n");
-                        LogPrint (BCLog::ALL, "An invalid Tenant public key was found in TX %s (vout %d).\n", block.vtx[vtx]->GetHash().ToString(), vout);
-                    } else {
-                        //LogPrint (BCLog::ALL, "\n");
-                        //LogPrint (BCLog::ALL, "A valid Tenant public key was found in TX %s (vout %d).\n", block.vtx[vtx]->GetHash().ToString(), vout);
-                    }
+    start_t = clock ();    
 
-#ifdef TIMING
-    end = clock ();    
-    t_foia = t_foia + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
+    const int intStartHeight = std::max<int>(pindexFrom ? pindexFrom->nHeight + 1 : 0, Params().GetConsensus().nUUIDBlockStart);
 
-                }
-            }
+    LogPrint (BCLog::AUTH, "scan_blocks_for_authdata from %d to %d \n", intStartHeight, pindexTo ? pindexTo->nHeight : -1);    
 
-}
+    // Collect the blocks in height order, by walking back from the last one
+    std::vector<const CBlockIndex*> vctBlocks;
+    for (const CBlockIndex* pindex = pindexTo; pindex && pindex->nHeight >= intStartHeight; pindex = pindex->pprev) {
+        vctBlocks.push_back(pindex);
+    }
+    std::reverse(vctBlocks.begin(), vctBlocks.end());
 
-        }
+    // Blocks are read ahead on the block reader threads, and processed here in height order
+    if (!ReadBlocksInOrder(vctBlocks, chainman.GetConsensus(), [&](const CBlockIndex&, const CBlock& block) {
+        process_block_authdata (block);
+        return true;
+    })) {
+        return false;
     }
 
     // stop clock
     end_t = clock ();    
     time_taken = (double) (end_t - start_t) / CLOCKS_PER_SEC;
 
-#ifdef TIMING
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "elapsed ReadBlockFromDisk %ld \n", t_rbfd);
-
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "elapsed is_opreturn_an_authdata %ld \n", t_ioaa);
-
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "elapsed found_opreturn_in_authdata %ld \n", t_foia);
-#endif
-
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "The elapsed time to complete the scan_blocks_for_authdata() function was %ld seconds.\n", time_taken);
+    LogPrint (BCLog::AUTH, "\n");
+    LogPrint (BCLog::AUTH, "The elapsed time to complete the scan_blocks_for_authdata() function was %ld seconds.\n", time_taken);
 
     return true;
 }
 
-// Check for existance of authorizetenant transaction in blockchain matching given pubkey
 bool scan_blocks_for_specific_authdata (ChainstateManager& chainman, uint160 hash160)
 {
     const CChain& active_chain = chainman.ActiveChain();
@@ -714,40 +889,35 @@ bool scan_blocks_for_specific_authdata (ChainstateManager& chainman, uint160 has
 
     double t_ioaa = 0.0;
 
-    double t_rbfd = 0.0;
-
-    CBlock block{};
-    CBlockIndex* pindex = nullptr;
+    // 1 - authorizetenant transaction found
+    int intFound = 0;
 
     // Skip POW blocks
     // for (int height = 6000; height < tip_height; height++) {
 
+    std::vector<const CBlockIndex*> vctBlocks;
     for (int height = (tip_height - 1); height > 6000; height--) {
+        vctBlocks.push_back(active_chain[height]);
+    }
 
-    //start = clock ();    
-
-        pindex = active_chain[height];
-        if (!ReadBlockFromDisk(block, pindex, chainman.GetConsensus())) {
-            return false;
-        }
-
-    //end = clock ();    
-    //t_rbfd = t_rbfd + (double) (end - start) / CLOCKS_PER_SEC;
+    // Blocks are read ahead on the block reader threads, and processed here in reverse height order.
+    // Transactions are only looked at in place in the raw blocks, not deserialized
+    if (!ReadBlockViewsInOrder(vctBlocks, chainman.GetParams().MessageStart(), [&](const CBlockIndex&, const CBlockHeader&, const std::vector<CTransactionView>& txs) {
 
         // Traverse transactions
-        for (unsigned int vtx = 0; vtx < block.vtx.size(); vtx++) {
+        for (const CTransactionView& tx : txs) {
 
-            if (block.vtx[vtx]->IsCoinBase() || block.vtx[vtx]->IsCoinStake()) {
+            if (tx.IsCoinBase() || tx.IsCoinStake()) {
                 continue;
             }
 
             // Traverse outputs
-            for (unsigned int vout = 0; vout < block.vtx[vtx]->vout.size(); vout++) {
+            for (const CTxOutView& out : tx.Outputs()) {
 
-                const CScript opreturn_out = block.vtx[vtx]->vout[vout].scriptPubKey;
+                const Span<const unsigned char> opreturn_out{out.scriptPubKey};
 
                 // If OP_RETURN
-                if (opreturn_out.IsOpReturn()) {
+                if (out.IsOpReturn()) {
                     int error_level;
 
     //start = clock ();    
@@ -768,16 +938,15 @@ bool scan_blocks_for_specific_authdata (ChainstateManager& chainman, uint160 has
     //end = clock ();    
     //t_cp = t_cp + (double) (end - start) / CLOCKS_PER_SEC;
 
-    //LogPrint (BCLog::ALL, "\n");
-    //LogPrint (BCLog::ALL, "elapsed time sbfsa ReadBlockFromDisk  %ld \n", t_rbfd);
+    //LogPrint (BCLog::AUTH, "\n");
+    //LogPrint (BCLog::AUTH, "elapsed time sbfsa is_opreturn_an_authdata  %ld \n", t_ioaa);
 
-    //LogPrint (BCLog::ALL, "\n");
-    //LogPrint (BCLog::ALL, "elapsed time sbfsa is_opreturn_an_authdata  %ld \n", t_ioaa);
+    //LogPrint (BCLog::AUTH, "\n");
+    //LogPrint (BCLog::AUTH, "elapsed time sbfsa compare_pubkey  %ld \n", t_cp);
 
-    //LogPrint (BCLog::ALL, "\n");
-    //LogPrint (BCLog::ALL, "elapsed time sbfsa compare_pubkey  %ld \n", t_cp);
-
-                        return true;
+                        // Found, stop reading blocks
+                        intFound = 1;
+                        return false;
                     }
 
     //end = clock ();    
@@ -786,9 +955,13 @@ bool scan_blocks_for_specific_authdata (ChainstateManager& chainman, uint160 has
                 }
             }
         }
+
+        return true;
+    })) {
+        return false;
     }
 
-    return false;
+    return intFound == 1;
 }
 
 bool generate_auth_payload(std::string& payload, int& type, uint32_t& time, std::string& hash)
@@ -815,16 +988,16 @@ bool generate_auth_payload(std::string& payload, int& type, uint32_t& time, std:
 
     payload += HexStr(signature);
 
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "ADDAUTH DATA STRUCTURE (generate_auth_payload)\n");
-    LogPrint (BCLog::ALL, "magic type time pubkey magic-type-time-pubkey-hashed-signed \n");
-    LogPrint (BCLog::ALL, "%s %s %s %s %s\n",
+    LogPrint (BCLog::AUTH, "\n");
+    LogPrint (BCLog::AUTH, "ADDAUTH DATA STRUCTURE (generate_auth_payload)\n");
+    LogPrint (BCLog::AUTH, "magic type time pubkey magic-type-time-pubkey-hashed-signed \n");
+    LogPrint (BCLog::AUTH, "%s %s %s %s %s\n",
       payload.substr( 0, OPENCODING_MAGICLEN*2),
       payload.substr( OPENCODING_MAGICLEN*2, OPAUTH_OPERATIONLEN*2),
       payload.substr( OPENCODING_MAGICLEN*2+OPAUTH_OPERATIONLEN*2, OPAUTH_TIMELEN*2),
       payload.substr( OPENCODING_MAGICLEN*2+OPAUTH_OPERATIONLEN*2+OPAUTH_TIMELEN*2, OPAUTH_HASHLEN*2),
       payload.substr( 0, payload.length()-(OPENCODING_MAGICLEN*2+OPAUTH_OPERATIONLEN*2+OPAUTH_TIMELEN*2+OPAUTH_HASHLEN*2)));
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::AUTH, "\n");
 
 
 
@@ -835,14 +1008,14 @@ bool generate_auth_payload(std::string& payload, int& type, uint32_t& time, std:
 bool generate_auth_transaction(WalletContext& wallet_context, CMutableTransaction& tx, std::string& opPayload)
 {
 
-    LogPrint (BCLog::ALL, "BUILD ADDAUTH TRANSACTION (generate_auth_transaction)\n");
-    LogPrint (BCLog::ALL, "The addauth transaction contains:\n");
-    LogPrint (BCLog::ALL, "1) An input transaction from which to pay for the addauth transaction.\n");
-    LogPrint (BCLog::ALL, "2) An output for making change. \n");
-    LogPrint (BCLog::ALL, "3) An output containing the addauth payload, prepended with 106 as a single byte.\n");
-    LogPrint (BCLog::ALL, "On daemon startup, a blockchain scan for addauth transactions is done.\n");
-    LogPrint (BCLog::ALL, "For each addauth transaction encountered, a public key is added to global variable authList.\n");
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::AUTH, "BUILD ADDAUTH TRANSACTION (generate_auth_transaction)\n");
+    LogPrint (BCLog::AUTH, "The addauth transaction contains:\n");
+    LogPrint (BCLog::AUTH, "1) An input transaction from which to pay for the addauth transaction.\n");
+    LogPrint (BCLog::AUTH, "2) An output for making change. \n");
+    LogPrint (BCLog::AUTH, "3) An output containing the addauth payload, prepended with 106 as a single byte.\n");
+    LogPrint (BCLog::AUTH, "On daemon startup, a blockchain scan for addauth transactions is done.\n");
+    LogPrint (BCLog::AUTH, "For each addauth transaction encountered, a public key is added to global variable authList.\n");
+    LogPrint (BCLog::AUTH, "\n");
 
     auto vpwallets = GetWallets(wallet_context);
     size_t nWallets = vpwallets.size();
@@ -871,10 +1044,10 @@ bool generate_auth_transaction(WalletContext& wallet_context, CMutableTransactio
     CTxOut txOut(setValue, receiver);
 
 
-    LogPrint (BCLog::ALL, "Input size %d\n", setCoins.size());
-    LogPrint (BCLog::ALL, "Input hash %s\n", it->first->tx->GetHash().ToString());
-    LogPrint (BCLog::ALL, "Input index %d\n", it->second);
-    LogPrint (BCLog::ALL, "Output scriptPubKey %s\n", HexStr(receiver).substr(0, 30));
+    LogPrint (BCLog::AUTH, "Input size %d\n", setCoins.size());
+    LogPrint (BCLog::AUTH, "Input hash %s\n", it->first->tx->GetHash().ToString());
+    LogPrint (BCLog::AUTH, "Input index %d\n", it->second);
+    LogPrint (BCLog::AUTH, "Output scriptPubKey %s\n", HexStr(receiver).substr(0, 30));
 
     // Flag error and exit gracefully if attempt is made to create transaction with empty scriptPubKey
     if (receiver.size() == 0) {
@@ -903,12 +1076,12 @@ bool generate_auth_transaction(WalletContext& wallet_context, CMutableTransactio
         CAmount nFee = GetRequiredFee(*vpwallets[0].get(), nBytes);
         tx.vout[0].nValue -= nFee;
 
-        LogPrint (BCLog::ALL, "\n");
-        LogPrint (BCLog::ALL, "Input value in satoshis:  %llu\n", setValue);
-        LogPrint (BCLog::ALL, "Transaction bytes: %d\n", nBytes);
-        LogPrint (BCLog::ALL, "Transaction fee in satoshis: %llu\n", nFee);
-        LogPrint (BCLog::ALL, "Change in satoshis: %llu\n", tx.vout[0].nValue);
-        LogPrint (BCLog::ALL, "\n");
+        LogPrint (BCLog::AUTH, "\n");
+        LogPrint (BCLog::AUTH, "Input value in satoshis:  %llu\n", setValue);
+        LogPrint (BCLog::AUTH, "Transaction bytes: %d\n", nBytes);
+        LogPrint (BCLog::AUTH, "Transaction fee in satoshis: %llu\n", nFee);
+        LogPrint (BCLog::AUTH, "Change in satoshis: %llu\n", tx.vout[0].nValue);
+        LogPrint (BCLog::AUTH, "\n");
 
         //! sign tx again with correct fee in place
         if (!vpwallets[0]->SignTransaction(tx)) {
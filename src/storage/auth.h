@@ -12,32 +12,65 @@
 #include <opfile/src/encode.h>
 #include <opfile/src/protocol.h>
 #include <opfile/src/util.h>
+#include <storage/chunk.h>
 #include <storage/storage.h>
 #include <storage/worker.h>
 
+#include <optional>
+#include <vector>
+
+//! Fewest signatures worth a thread of their own when recovering signers
+static constexpr size_t MIN_SIGNERS_PER_THREAD{64};
+//! Most signers remembered before the cache starts over
+static constexpr size_t MAX_SIGNER_CACHE_ENTRIES{1 << 16};
+
+//! A compact signature over a hash, as header and auth chunks carry
+struct signed_hash {
+    uint256 hash;
+    std::vector<unsigned char> signature;
+};
+
 void add_auth_member(uint160 pubkeyhash);
 void remove_auth_member(uint160 pubkeyhash);
 void build_auth_list(const Consensus::Params& params);
 bool is_auth_member(uint160 pubkeyhash);
 bool set_auth_user(std::string& privatewif);
+//! Give file the key of the authenticated tenant, the secret the assets it stored encrypted decrypt with
+void set_tenant_secret(chunk_reassembler& file);
 void copy_auth_list(std::vector<uint160>& tempList);
+void reset_auth_list(const Consensus::Params& params);
+void get_auth_state(std::vector<uint160>& tempList, uint32_t& tempTime);
+void set_auth_state(const std::vector<uint160>& tempList, uint32_t tempTime);
+//! Memory held by the authList, its members and their lookup
+size_t auth_list_dynamic_usage();
+//! Memory held by the signers remembered by recover_signer()
+size_t signer_cache_dynamic_usage();
 // bool is_signature_valid_chunk(std::string chunk);
 bool is_signature_valid_chunk (std::string chunk, int pintOffset);
 bool is_signature_valid_raw(std::vector<unsigned char>& signature, uint256& hash);
+//! hash160 of the key that made signature over hash, or nothing if no key can be recovered from it.
+//! Signers are remembered, so that scans meeting the same signature again do not recover it again
+std::optional<uint160> recover_signer (const uint256& hash, Span<const unsigned char> signature);
+//! recover_signer for many signatures at once, those not remembered recovered across threads
+void recover_signers (const std::vector<signed_hash>& signed_hashes, std::vector<std::optional<uint160>>& signers);
 // bool check_contextual_auth(std::string& chunk, int& error_level);
 bool check_contextual_auth (std::string& chunk, int& error_level, int pintOffset);
 bool check_contextual_auth2 (std::string& chunk, int& error_level, int pintOffset);
 // bool process_auth_chunk(std::string& chunk, int& error_level);
 bool process_auth_chunk (std::string& chunk, int& error_level, int pintOffset);
+bool check_contextual_auth (const auth_view& view, int& error_level);
+bool process_auth_chunk (const auth_view& view, int& error_level);
 bool compare_pubkey2 (std::string& chunk, int& error_level, int pintOffset, uint160 hash160);
-bool is_opreturn_an_authdata(const CScript& script_data, int& error_level);
+bool is_opreturn_an_authdata(Span<const unsigned char> script_data, int& error_level);
 // bool is_opreturn_an_authdata2 (const CScript& script_data, int& error_level, int pintFlag);
 // bool is_opreturn_an_authdata2 (const CScript& script_data, int& error_level);
 bool found_opreturn_in_authdata(const CScript& script_data, int& error_level, bool test_accept = false);
-bool compare_pubkey(const CScript& script_data, int& error_level, uint160 hash160);
+bool compare_pubkey(Span<const unsigned char> script_data, int& error_level, uint160 hash160);
 //bool found_opreturn_in_authdata2 (const CScript& script_data, int& error_level, bool test_accept = false);
 bool does_tx_have_authdata(const CTransaction& tx);
-bool scan_blocks_for_authdata(ChainstateManager& chainman);
+bool does_block_have_authdata(const CBlock& block);
+int process_block_authdata(const CBlock& block);
+bool scan_blocks_for_authdata(ChainstateManager& chainman, const CBlockIndex* pindexFrom, const CBlockIndex* pindexTo);
 bool scan_blocks_for_specific_authdata(ChainstateManager& chainman, uint160 hash160);
 bool check_mempool_for_authdata(const CTxMemPool& mempool);
 bool generate_auth_payload(std::string& payload, int& type, uint32_t& time, std::string& hash);
@@ -0,0 +1,386 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <storage/authsync.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <clientversion.h>
+#include <logging.h>
+#include <node/blockreader.h>
+#include <primitives/block.h>
+#include <storage/auth.h>
+#include <storage/chunk.h>
+#include <streams.h>
+#include <util/fs_helpers.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+using node::ReadBlocksInOrder;
+
+std::unique_ptr<AuthListSync> g_auth_list_sync;
+
+void AuthHistory::Set(const uint160& tenant, bool member, int height)
+{
+    std::vector<AuthInterval>& intervals = m_intervals[tenant];
+    const bool open{!intervals.empty() && intervals.back().removed == std::numeric_limits<int>::max()};
+    if (member && !open) {
+        intervals.push_back({height, std::numeric_limits<int>::max()});
+    } else if (!member && open) {
+        intervals.back().removed = height;
+    }
+    if (intervals.empty()) m_intervals.erase(tenant);
+}
+
+void AuthHistory::Rewind(int height)
+{
+    for (auto it = m_intervals.begin(); it != m_intervals.end();) {
+        std::vector<AuthInterval>& intervals = it->second;
+        while (!intervals.empty() && intervals.back().added >= height) {
+            intervals.pop_back();
+        }
+        if (!intervals.empty() && intervals.back().removed >= height) {
+            intervals.back().removed = std::numeric_limits<int>::max();
+        }
+        it = intervals.empty() ? m_intervals.erase(it) : std::next(it);
+    }
+}
+
+bool AuthHistory::IsMember(const uint160& tenant, int height) const
+{
+    const auto found = m_intervals.find(tenant);
+    if (found == m_intervals.end()) return false;
+    // The last interval added at or below height
+    const auto it = std::upper_bound(found->second.begin(), found->second.end(), height, [](int h, const AuthInterval& interval) {
+        return h < interval.added;
+    });
+    return it != found->second.begin() && height < std::prev(it)->removed;
+}
+
+std::vector<uint160> AuthHistory::Members(int height) const
+{
+    std::vector<uint160> members;
+    for (const auto& [tenant, intervals] : m_intervals) {
+        if (IsMember(tenant, height)) members.push_back(tenant);
+    }
+    return members;
+}
+
+// Tenants the authdata of a block names, whether or not it changed their membership
+static std::vector<uint160> auth_tenants_in_block(const CBlock& block)
+{
+    std::vector<uint160> tenants;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase() || tx->IsCoinStake()) continue;
+        for (const auto& out : tx->vout) {
+            auth_view view;
+            if (out.scriptPubKey.IsOpReturn() && is_auth_magic_in_script(out.scriptPubKey) && parse_auth_from_script(out.scriptPubKey, view)) {
+                tenants.push_back(get_hash160_from_auth(view));
+            }
+        }
+    }
+    return tenants;
+}
+
+bool AuthListSync::Read(uint256& best_block)
+{
+    AutoFile file{fsbridge::fopen(m_path, "rb")};
+    if (file.IsNull()) {
+        LogPrintf("%s: %s not found\n", __func__, fs::PathToString(m_path));
+        return false;
+    }
+
+    try {
+        uint64_t version;
+        file >> version;
+        if (version != AUTHLIST_DUMP_VERSION) {
+            LogPrintf("%s: unsupported %s version %d\n", __func__, fs::PathToString(m_path), version);
+            return false;
+        }
+
+        int best_height;
+        uint32_t auth_time;
+        std::vector<uint160> auth_list;
+        int undo_height;
+        std::vector<AuthListUndo> undo;
+        AuthHistory history;
+        file >> best_block >> best_height >> auth_time >> auth_list >> undo_height >> undo >> history;
+
+        m_undo_height = undo_height;
+        m_undo = std::move(undo);
+        m_history = std::move(history);
+        set_auth_state(auth_list, auth_time);
+
+        LogPrintf("Loaded authList from disk, valid for block %s (height %d)\n", best_block.ToString(), best_height);
+    } catch (const std::exception& e) {
+        LogPrintf("%s: failed to deserialize %s: %s\n", __func__, fs::PathToString(m_path), e.what());
+        return false;
+    }
+
+    return true;
+}
+
+bool AuthListSync::Write() const
+{
+    if (!m_best_index) return false;
+
+    std::vector<uint160> auth_list;
+    uint32_t auth_time;
+    get_auth_state(auth_list, auth_time);
+
+    const fs::path temp_path{m_path + ".new"};
+    try {
+        AutoFile file{fsbridge::fopen(temp_path, "wb")};
+        if (file.IsNull()) {
+            return false;
+        }
+
+        file << AUTHLIST_DUMP_VERSION;
+        file << m_best_index->GetBlockHash() << m_best_index->nHeight << auth_time << auth_list << m_undo_height << m_undo << m_history;
+
+        if (!FileCommit(file.Get())) {
+            throw std::runtime_error("FileCommit failed");
+        }
+        file.fclose();
+        if (!RenameOver(temp_path, m_path)) {
+            throw std::runtime_error("Rename failed");
+        }
+    } catch (const std::exception& e) {
+        LogPrintf("%s: failed to write %s: %s\n", __func__, fs::PathToString(m_path), e.what());
+        return false;
+    }
+
+    return true;
+}
+
+bool AuthListSync::Rescan(const CBlockIndex* pindex)
+{
+    LogPrintf("Rescanning authdata up to block %s\n", pindex->GetBlockHash().ToString());
+
+    const Consensus::Params& consensus{m_chainman->GetConsensus()};
+    reset_auth_list(consensus);
+    m_undo.clear();
+    m_history.Clear();
+    m_history.Set(consensus.initAuthUser, true, 0);
+    m_best_index = nullptr;
+
+    // Block by block, so that the history records the height of every change
+    const int start_height{int(consensus.nUUIDBlockStart)};
+    std::vector<const CBlockIndex*> blocks;
+    for (const CBlockIndex* block = pindex; block && block->nHeight >= start_height; block = block->pprev) {
+        blocks.push_back(block);
+    }
+    std::reverse(blocks.begin(), blocks.end());
+    m_undo_height = start_height;
+    if (!ReadBlocksInOrder(blocks, consensus, [&](const CBlockIndex& index, const CBlock& block) {
+        Apply(block, &index);
+        return true;
+    })) {
+        m_best_index = nullptr;
+        return false;
+    }
+
+    m_best_index = pindex;
+    return true;
+}
+
+void AuthListSync::Apply(const CBlock& block, const CBlockIndex* pindex)
+{
+    // Most blocks carry no authdata, and need neither processing nor an undo record
+    if (does_block_have_authdata(block)) {
+        AuthListUndo undo;
+        undo.block_hash = pindex->GetBlockHash();
+        undo.height = pindex->nHeight;
+
+        std::vector<uint160> before, after;
+        uint32_t time;
+        get_auth_state(before, undo.prev_time);
+        process_block_authdata(block);
+        get_auth_state(after, time);
+
+        for (const uint160& hash : after) {
+            if (std::find(before.begin(), before.end(), hash) == before.end()) undo.added.push_back(hash);
+        }
+        for (const uint160& hash : before) {
+            if (std::find(after.begin(), after.end(), hash) == after.end()) undo.removed.push_back(hash);
+        }
+        m_undo.push_back(std::move(undo));
+
+        // From the list after the block rather than the changes, which leave out members added ahead by allow
+        for (const uint160& tenant : auth_tenants_in_block(block)) {
+            m_history.Set(tenant, std::find(after.begin(), after.end(), tenant) != after.end(), pindex->nHeight);
+        }
+    }
+
+    m_best_index = pindex;
+
+    // Forget changes too deep to be reorganized away
+    m_undo.erase(std::remove_if(m_undo.begin(), m_undo.end(), [&](const AuthListUndo& undo) {
+        return undo.height <= pindex->nHeight - AUTHLIST_UNDO_DEPTH;
+    }), m_undo.end());
+    m_undo_height = std::max(m_undo_height, pindex->nHeight - AUTHLIST_UNDO_DEPTH + 1);
+}
+
+void AuthListSync::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    LOCK(m_mutex);
+
+    // Already applied, e.g. connected while catching up at startup
+    if (m_best_index && m_best_index->GetAncestor(pindex->nHeight) == pindex) {
+        return;
+    }
+
+    // Not connecting onto the block authList is valid for, start over
+    if (!m_best_index || pindex->pprev != m_best_index) {
+        Rescan(pindex);
+        return;
+    }
+
+    const auto start{SteadyClock::now()};
+    Apply(*block, pindex);
+    RecordBlockAuthTime(pindex->GetBlockHash(), SteadyClock::now() - start);
+}
+
+void AuthListSync::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    LOCK(m_mutex);
+
+    if (pindex != m_best_index || !pindex->pprev) {
+        // Never applied, e.g. disconnected before catching up at startup
+        if (!m_best_index || m_best_index->GetAncestor(pindex->nHeight) != pindex) {
+            return;
+        }
+        Rescan(pindex->pprev);
+        return;
+    }
+
+    if (!m_undo.empty() && m_undo.back().block_hash == pindex->GetBlockHash()) {
+        const AuthListUndo& undo = m_undo.back();
+
+        std::vector<uint160> auth_list;
+        uint32_t auth_time;
+        get_auth_state(auth_list, auth_time);
+        for (const uint160& hash : undo.added) {
+            auth_list.erase(std::remove(auth_list.begin(), auth_list.end(), hash), auth_list.end());
+        }
+        for (const uint160& hash : undo.removed) {
+            auth_list.push_back(hash);
+        }
+        set_auth_state(auth_list, undo.prev_time);
+
+        m_undo.pop_back();
+    } else if (pindex->nHeight < m_undo_height && does_block_have_authdata(*block)) {
+        // The changes of this block were not recorded
+        Rescan(pindex->pprev);
+        return;
+    }
+
+    if (does_block_have_authdata(*block)) {
+        m_history.Rewind(pindex->nHeight);
+    }
+    m_best_index = pindex->pprev;
+}
+
+void AuthListSync::ChainStateFlushed(const CBlockLocator& locator)
+{
+    LOCK(m_mutex);
+    Write();
+}
+
+bool AuthListSync::Start(ChainstateManager& chainman)
+{
+    LOCK(m_mutex);
+    m_chainman = &chainman;
+
+    const CBlockIndex* pindex{nullptr};
+    uint256 best_block;
+    if (Read(best_block)) {
+        LOCK(cs_main);
+        pindex = chainman.m_blockman.LookupBlockIndex(best_block);
+        if (!pindex || !chainman.ActiveChain().Contains(pindex)) {
+            LogPrintf("%s: authList on disk is not for the active chain, rescanning\n", __func__);
+            pindex = nullptr;
+        }
+    }
+
+    if (!pindex) {
+        const CBlockIndex* tip{WITH_LOCK(cs_main, return chainman.ActiveChain().Tip())};
+        if (!tip) {
+            return false;
+        }
+        if (!Rescan(tip)) {
+            return false;
+        }
+        pindex = tip;
+    }
+    m_best_index = pindex;
+
+    // Catch up with blocks connected since, then follow the chain. Registering under
+    // cs_main ensures no block is connected in between.
+    while (true) {
+        std::vector<const CBlockIndex*> blocks;
+        const CBlockIndex* reorg_tip{nullptr};
+        {
+            LOCK(cs_main);
+            const CChain& active_chain = chainman.ActiveChain();
+            if (!active_chain.Contains(pindex)) {
+                reorg_tip = active_chain.Tip();
+            }
+            for (const CBlockIndex* next = reorg_tip ? nullptr : active_chain.Next(pindex); next; next = active_chain.Next(next)) {
+                blocks.push_back(next);
+            }
+            if (!reorg_tip && blocks.empty()) {
+                RegisterValidationInterface(this, /*lane=*/"authsync");
+                break;
+            }
+        }
+
+        // Reorganized away from the block we caught up to
+        if (reorg_tip) {
+            if (!Rescan(reorg_tip)) {
+                return false;
+            }
+            pindex = reorg_tip;
+            continue;
+        }
+
+        if (!ReadBlocksInOrder(blocks, chainman.GetConsensus(), [&](const CBlockIndex& index, const CBlock& block) {
+            Apply(block, &index);
+            return true;
+        })) {
+            return false;
+        }
+        pindex = blocks.back();
+    }
+
+    LogPrintf("authList is valid for block %s (height %d), %d undo records\n", m_best_index->GetBlockHash().ToString(), m_best_index->nHeight, m_undo.size());
+    return true;
+}
+
+void AuthListSync::Stop()
+{
+    UnregisterValidationInterface(this);
+
+    LOCK(m_mutex);
+    Write();
+}
+
+bool AuthListSync::FindMembership(const uint160& tenant, int height, bool& member) const
+{
+    LOCK(m_mutex);
+    if (!m_best_index || height > m_best_index->nHeight) return false;
+    member = m_history.IsMember(tenant, height);
+    return true;
+}
+
+bool AuthListSync::FindMembers(int height, std::vector<uint160>& members) const
+{
+    LOCK(m_mutex);
+    if (!m_best_index || height > m_best_index->nHeight) return false;
+    members = m_history.Members(height);
+    return true;
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_STORAGE_AUTHSYNC_H
+#define BITCOIN_STORAGE_AUTHSYNC_H
+
+#include <util/fs.h>
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <limits>
+#include <map>
+#include <memory>
+#include <vector>
+
+class ChainstateManager;
+
+//! Version of the authlist.dat file format
+static constexpr uint64_t AUTHLIST_DUMP_VERSION{2};
+//! Number of blocks below the tip for which authlist changes can be undone without a rescan
+static constexpr int AUTHLIST_UNDO_DEPTH{144};
+
+/** Changes a single block made to authList, so that they can be undone on disconnect. */
+struct AuthListUndo {
+    uint256 block_hash;
+    int height{0};
+    uint32_t prev_time{0};
+    std::vector<uint160> added;
+    std::vector<uint160> removed;
+
+    SERIALIZE_METHODS(AuthListUndo, obj)
+    {
+        READWRITE(obj.block_hash, obj.height, obj.prev_time, obj.added, obj.removed);
+    }
+};
+
+/** Heights over which a tenant was on authList: from the block at added, until the one at removed */
+struct AuthInterval {
+    int added{0};
+    int removed{std::numeric_limits<int>::max()};
+
+    SERIALIZE_METHODS(AuthInterval, obj)
+    {
+        READWRITE(obj.added, obj.removed);
+    }
+};
+
+/**
+ * Membership of authList along the chain, as the intervals each tenant was on
+ * it, so that whether a tenant was authorized at a height is a lookup rather
+ * than a scan of the blocks up to that height.
+ */
+class AuthHistory
+{
+private:
+    //! Intervals of each tenant in height order, the last one open while it is a member
+    std::map<uint160, std::vector<AuthInterval>> m_intervals;
+
+public:
+    void Clear() { m_intervals.clear(); }
+
+    /** Record whether tenant is a member from the block at height on. */
+    void Set(const uint160& tenant, bool member, int height);
+
+    /** Forget the changes of the blocks at height and above, as they are disconnected. */
+    void Rewind(int height);
+
+    /** Whether tenant was a member once the block at height was connected. */
+    bool IsMember(const uint160& tenant, int height) const;
+
+    /** The tenants that were members once the block at height was connected. */
+    std::vector<uint160> Members(int height) const;
+
+    SERIALIZE_METHODS(AuthHistory, obj)
+    {
+        READWRITE(obj.m_intervals);
+    }
+};
+
+/**
+ * Keeps authList in step with the active chain. The list is persisted to
+ * authlist.dat together with the block it is valid for, so that startup only
+ * replays the blocks connected since, rather than every authdata OP_RETURN
+ * from nUUIDBlockStart. Connected and disconnected blocks are then applied
+ * through the validation interface.
+ *
+ * Alongside, the AuthHistory of every tenant is built from the same blocks and
+ * persisted with the list, so that membership at a past height is answered
+ * without reading blocks.
+ */
+class AuthListSync final : public CValidationInterface
+{
+private:
+    const fs::path m_path;
+    ChainstateManager* m_chainman{nullptr};
+
+    mutable Mutex m_mutex;
+    //! Last block applied to authList
+    const CBlockIndex* m_best_index GUARDED_BY(m_mutex){nullptr};
+    //! Lowest height from which every change to authList is recorded in m_undo
+    int m_undo_height GUARDED_BY(m_mutex){0};
+    std::vector<AuthListUndo> m_undo GUARDED_BY(m_mutex);
+    AuthHistory m_history GUARDED_BY(m_mutex);
+
+    void Apply(const CBlock& block, const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    bool Read(uint256& best_block) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    bool Write() const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    bool Rescan(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+protected:
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+    void ChainStateFlushed(const CBlockLocator& locator) override;
+
+public:
+    explicit AuthListSync(const fs::path& path) : m_path(path) {}
+
+    /// Load the snapshot (or rescan the chain if it is missing or from
+    /// another chain), catch up with the active chain and start following
+    /// it through the validation interface.
+    bool Start(ChainstateManager& chainman);
+
+    /// Stop following the chain and write the snapshot.
+    void Stop();
+
+    /// Look up whether tenant was on authList once the block at height was
+    /// connected. Returns false if the list has not reached that height.
+    bool FindMembership(const uint160& tenant, int height, bool& member) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Look up the tenants on authList once the block at height was connected.
+    /// Returns false if the list has not reached that height.
+    bool FindMembers(int height, std::vector<uint160>& members) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+/// The global authList follower. May be null.
+extern std::unique_ptr<AuthListSync> g_auth_list_sync;
+
+#endif // BITCOIN_STORAGE_AUTHSYNC_H
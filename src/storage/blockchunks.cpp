@@ -0,0 +1,40 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <storage/blockchunks.h>
+
+#include <opfile/src/chunk.h>
+#include <primitives/block.h>
+#include <script/script.h>
+#include <storage/chunk.h>
+
+std::vector<StorageTxPayloads> ExtractBlockStoragePayloads(const CBlock& block)
+{
+    std::vector<StorageTxPayloads> txs;
+    for (uint32_t index = 0; index < block.vtx.size(); ++index) {
+        const CTransaction& tx{*block.vtx[index]};
+        if (tx.IsCoinBase() || tx.IsCoinStake()) continue;
+
+        StorageTxPayloads entry;
+        for (uint32_t vout = 0; vout < tx.vout.size(); ++vout) {
+            const CScript& script{tx.vout[vout].scriptPubKey};
+            if (!script.IsOpReturn()) continue;
+
+            auth_view auth;
+            chunk_view view;
+            int error_level;
+            if (parse_auth_from_script(script, auth)) {
+                entry.payloads.push_back({vout, StoragePayloadType::AUTH, {auth.payload.begin(), auth.payload.end()}});
+            } else if (parse_chunk_from_script(script, view, error_level)) {
+                const StoragePayloadType type{view.chunklen == 0 ? StoragePayloadType::HEADER : StoragePayloadType::DATA};
+                entry.payloads.push_back({vout, type, {view.payload.begin(), view.payload.end()}});
+            }
+        }
+        if (entry.payloads.empty()) continue;
+        entry.txid = tx.GetHash();
+        entry.index = index;
+        txs.push_back(std::move(entry));
+    }
+    return txs;
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_STORAGE_BLOCKCHUNKS_H
+#define BITCOIN_STORAGE_BLOCKCHUNKS_H
+
+#include <serialize.h>
+#include <uint256.h>
+#include <univalue.h>
+
+#include <cstdint>
+#include <vector>
+
+class CBlock;
+
+//! What an OP_RETURN output of a block carries
+enum class StoragePayloadType : uint8_t {
+    AUTH = 0,   //!< authdata, changing the authList
+    HEADER = 1, //!< header chunk of an asset, signed by its tenant
+    DATA = 2,   //!< data chunk of an asset
+};
+
+/** The payload pushed by an OP_RETURN output carrying storage or authdata */
+struct StoragePayload {
+    uint32_t vout{0};
+    StoragePayloadType type{StoragePayloadType::DATA};
+    //! From the magic to the end of the script
+    std::vector<unsigned char> payload;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << COMPACTSIZE(vout) << uint8_t(type) << payload;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        uint8_t type_byte;
+        s >> COMPACTSIZE(vout) >> type_byte >> payload;
+        type = StoragePayloadType{type_byte};
+    }
+};
+
+/** The storage payloads of a transaction, for the transactions of a block carrying any */
+struct StorageTxPayloads {
+    uint256 txid;
+    //! Position of the transaction in the block
+    uint32_t index{0};
+    std::vector<StoragePayload> payloads;
+
+    SERIALIZE_METHODS(StorageTxPayloads, obj)
+    {
+        READWRITE(obj.txid, COMPACTSIZE(obj.index), obj.payloads);
+    }
+};
+
+/** Parse the storage and authdata outputs of a block once, with the binary chunk parser.
+    Part of libbitcoinkernel, so that services reading blk*.dat parse blocks as the node does. */
+std::vector<StorageTxPayloads> ExtractBlockStoragePayloads(const CBlock& block);
+
+/** The payloads of the transactions of a block, decoded, as getblockstoragechunks and
+    /rest/storagechunks show them. The binary form is the vector serialized. Defined in
+    blockchunks_json.cpp, as recovering the tenants takes the signer cache of the node. */
+UniValue StoragePayloadsToJSON(const uint256& block_hash, int height, const std::vector<StorageTxPayloads>& txs);
+
+#endif // BITCOIN_STORAGE_BLOCKCHUNKS_H
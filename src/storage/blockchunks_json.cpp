@@ -0,0 +1,80 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <storage/blockchunks.h>
+
+#include <opfile/src/chunk.h>
+#include <opfile/src/decode.h>
+#include <opfile/src/protocol.h>
+#include <script/script.h>
+#include <storage/chunk.h>
+#include <util/strencodings.h>
+
+#include <algorithm>
+
+static UniValue StoragePayloadToJSON(const StoragePayload& payload)
+{
+    UniValue entry(UniValue::VOBJ);
+    entry.pushKV("vout", (uint64_t)payload.vout);
+
+    // The parsers read scripts, which the payload is pushed by again
+    const CScript script{CScript() << OP_RETURN << payload.payload};
+    if (payload.type == StoragePayloadType::AUTH) {
+        auth_view auth;
+        if (!parse_auth_from_script(script, auth)) return entry;
+        entry.pushKV("type", "auth");
+        entry.pushKV("operation", auth.operation == OPAUTH_ADDUSER_BIN ? "add" : auth.operation == OPAUTH_DELUSER_BIN ? "remove" : "unknown");
+        entry.pushKV("time", (uint64_t)auth.time);
+        entry.pushKV("user", get_hash160_from_auth(auth).ToString());
+        entry.pushKV("signature", HexStr(auth.signature));
+        return entry;
+    }
+
+    chunk_view view;
+    int error_level;
+    if (!parse_chunk_from_script(script, view, error_level)) return entry;
+    entry.pushKV("type", payload.type == StoragePayloadType::HEADER ? "header" : "data");
+    entry.pushKV("uuid", HexStr(view.uuid));
+    entry.pushKV("protocol", (uint64_t)view.version);
+    if (payload.type == StoragePayloadType::HEADER) {
+        uint160 tenant;
+        if (recover_tenant_from_header(view, tenant)) entry.pushKV("tenant", tenant.ToString());
+        entry.pushKV("signature", HexStr(view.signature));
+        if (view.version == OPENCODING_COMPACT) {
+            entry.pushKV("flags", view.flags);
+            entry.pushKV("filelength", view.filelen);
+            entry.pushKV("chunktotal", (uint64_t)view.chunktotal);
+            if (view.flags & OPENCODING_FLAG_CONTENTHASH) entry.pushKV("contenthash", HexStr(view.contenthash));
+            std::string extension{view.extension.begin(), view.extension.end()};
+            extension.erase(std::find(extension.begin(), extension.end(), '\0'), extension.end());
+            if (!extension.empty()) entry.pushKV("extension", SanitizeString(extension));
+        }
+        return entry;
+    }
+    entry.pushKV("chunknum", (uint64_t)view.chunknum);
+    if (view.version != OPENCODING_COMPACT) entry.pushKV("chunktotal", (uint64_t)view.chunktotal);
+    entry.pushKV("data", HexStr(view.data));
+    return entry;
+}
+
+UniValue StoragePayloadsToJSON(const uint256& block_hash, int height, const std::vector<StorageTxPayloads>& txs)
+{
+    UniValue txs_json(UniValue::VARR);
+    for (const StorageTxPayloads& tx : txs) {
+        UniValue payloads(UniValue::VARR);
+        for (const StoragePayload& payload : tx.payloads) {
+            payloads.push_back(StoragePayloadToJSON(payload));
+        }
+        UniValue tx_json(UniValue::VOBJ);
+        tx_json.pushKV("txid", tx.txid.GetHex());
+        tx_json.pushKV("index", (uint64_t)tx.index);
+        tx_json.pushKV("payloads", payloads);
+        txs_json.push_back(tx_json);
+    }
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("hash", block_hash.GetHex());
+    result.pushKV("height", height);
+    result.pushKV("transactions", txs_json);
+    return result;
+}
@@ -0,0 +1,251 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <storage/cache.h>
+
+#include <chain.h>
+#include <logging.h>
+#include <memusage.h>
+#include <util/fs_helpers.h>
+#include <util/strencodings.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+std::unique_ptr<StorageCache> g_storage_cache;
+
+//! Canonical lowercase form of uuid, or empty if it is not hex
+static std::string cache_key(const std::string& uuid)
+{
+    if (uuid.empty() || !IsHex(uuid)) {
+        return "";
+    }
+    return HexStr(ParseHex(uuid));
+}
+
+fs::path StorageCache::EntryPath(const std::string& uuid, const uint256& block_hash) const
+{
+    return m_dir / fs::u8path(uuid + "-" + block_hash.GetHex());
+}
+
+void StorageCache::Add(const std::string& uuid, const Entry& entry)
+{
+    Entry& added = m_entries[uuid] = entry;
+    m_lru.push_front(uuid);
+    added.lru = m_lru.begin();
+    m_size += added.size;
+
+    while (m_size > m_max_size && !m_lru.empty()) {
+        Evict(m_lru.back());
+    }
+}
+
+void StorageCache::Evict(const std::string& uuid)
+{
+    auto it = m_entries.find(uuid);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    std::error_code ec;
+    fs::remove(EntryPath(uuid, it->second.block_hash), ec);
+
+    m_size -= it->second.size;
+    m_lru.erase(it->second.lru);
+    m_entries.erase(it);
+}
+
+bool StorageCache::Start(ChainstateManager& chainman)
+{
+    m_chainman = &chainman;
+
+    try {
+        TryCreateDirectories(m_dir);
+    } catch (const fs::filesystem_error& e) {
+        LogPrintf("%s: unable to create %s: %s\n", __func__, fs::PathToString(m_dir), fsbridge::get_filesystem_error_message(e));
+        return false;
+    }
+
+    std::error_code ec;
+
+    // Collect the entries left by a previous run, dropping any that were reorganized away
+    std::vector<std::tuple<fs::file_time_type, std::string, Entry>> found;
+    for (const auto& dir_entry : fs::directory_iterator(m_dir, ec)) {
+        const std::string name = fs::PathToString(dir_entry.path().filename());
+        const size_t sep = name.find('-');
+
+        Entry entry;
+        std::string uuid;
+        if (sep != std::string::npos && dir_entry.is_regular_file(ec)) {
+            uuid = cache_key(name.substr(0, sep));
+            const std::string hash = name.substr(sep + 1);
+            if (!uuid.empty() && hash.size() == 64 && IsHex(hash)) {
+                entry.block_hash = uint256S(hash);
+            } else {
+                uuid.clear();
+            }
+        }
+
+        const CBlockIndex* pindex{nullptr};
+        if (!uuid.empty()) {
+            LOCK(cs_main);
+            pindex = chainman.m_blockman.LookupBlockIndex(entry.block_hash);
+            if (pindex && !chainman.ActiveChain().Contains(pindex)) {
+                pindex = nullptr;
+            }
+        }
+
+        if (!pindex) {
+            fs::remove(dir_entry.path(), ec);
+            continue;
+        }
+
+        entry.height = pindex->nHeight;
+        entry.size = dir_entry.file_size(ec);
+        found.emplace_back(dir_entry.last_write_time(ec), uuid, entry);
+    }
+
+    // Oldest first, so that the most recently used end up at the front
+    std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return std::get<0>(a) < std::get<0>(b); });
+
+    {
+        LOCK(m_mutex);
+        for (const auto& [time, uuid, entry] : found) {
+            Add(uuid, entry);
+        }
+        LogPrintf("Storage cache holds %d assets (%d bytes of %d)\n", m_entries.size(), m_size, m_max_size);
+    }
+
+    RegisterValidationInterface(this);
+    return true;
+}
+
+void StorageCache::Stop()
+{
+    UnregisterValidationInterface(this);
+}
+
+bool StorageCache::Fetch(const std::string& uuid, const fs::path& dest)
+{
+    const std::string key = cache_key(uuid);
+    if (key.empty()) {
+        return false;
+    }
+
+    fs::path path;
+    {
+        LOCK(m_mutex);
+        auto it = m_entries.find(key);
+        if (it == m_entries.end()) {
+            ++m_misses;
+            return false;
+        }
+        ++m_hits;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        path = EntryPath(key, it->second.block_hash);
+    }
+
+    // Copy outside the lock, an entry evicted meanwhile simply fails to copy and is fetched from the chain
+    try {
+        fs::copy_file(path, dest, fs::copy_options::overwrite_existing);
+    } catch (const fs::filesystem_error& e) {
+        LogPrint(BCLog::STORAGE, "storage cache: unable to copy %s: %s\n", uuid, fsbridge::get_filesystem_error_message(e));
+        return false;
+    }
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+    LogPrint(BCLog::STORAGE, "storage cache: hit for %s\n", uuid);
+    return true;
+}
+
+void StorageCache::Insert(const std::string& uuid, const fs::path& src, int height)
+{
+    static std::atomic<uint64_t> temp_count{0};
+
+    const std::string key = cache_key(uuid);
+    if (key.empty() || !m_chainman) {
+        return;
+    }
+
+    std::error_code ec;
+    Entry entry;
+    entry.height = height;
+    entry.size = fs::file_size(src, ec);
+    if (ec || entry.size > m_max_size) {
+        return;
+    }
+
+    // Only assets buried deep enough, a shallower reorg could still change them
+    {
+        LOCK(cs_main);
+        const CChain& active_chain = m_chainman->ActiveChain();
+        if (height < 0 || active_chain.Height() - height + 1 < STORAGE_CACHE_MIN_DEPTH) {
+            return;
+        }
+        entry.block_hash = active_chain[height]->GetBlockHash();
+    }
+
+    if (WITH_LOCK(m_mutex, return m_entries.count(key) > 0)) {
+        return;
+    }
+
+    const fs::path temp_path = m_dir / fs::u8path(strprintf("%s.%d.tmp", key, ++temp_count));
+    try {
+        fs::copy_file(src, temp_path, fs::copy_options::overwrite_existing);
+    } catch (const fs::filesystem_error& e) {
+        LogPrint(BCLog::STORAGE, "storage cache: unable to copy %s: %s\n", uuid, fsbridge::get_filesystem_error_message(e));
+        fs::remove(temp_path, ec);
+        return;
+    }
+
+    LOCK(m_mutex);
+    if (m_entries.count(key)) {
+        fs::remove(temp_path, ec);
+        return;
+    }
+    fs::rename(temp_path, EntryPath(key, entry.block_hash), ec);
+    if (ec) {
+        fs::remove(temp_path, ec);
+        return;
+    }
+    Add(key, entry);
+
+    LogPrint(BCLog::STORAGE, "storage cache: added %s (%d bytes)\n", uuid, entry.size);
+}
+
+void StorageCache::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    LOCK(m_mutex);
+
+    std::vector<std::string> stale;
+    for (const auto& [uuid, entry] : m_entries) {
+        if (entry.height >= pindex->nHeight) {
+            stale.push_back(uuid);
+        }
+    }
+    for (const std::string& uuid : stale) {
+        LogPrint(BCLog::STORAGE, "storage cache: dropping %s, block %d disconnected\n", uuid, pindex->nHeight);
+        Evict(uuid);
+    }
+}
+
+StorageCache::Stats StorageCache::GetStats()
+{
+    LOCK(m_mutex);
+    return {m_entries.size(), m_size, m_max_size, m_hits, m_misses};
+}
+
+size_t StorageCache::DynamicMemoryUsage()
+{
+    LOCK(m_mutex);
+    size_t usage{memusage::DynamicUsage(m_lru) + memusage::DynamicUsage(m_entries)};
+    for (const std::string& uuid : m_lru) usage += memusage::DynamicUsage(uuid);
+    for (const auto& [uuid, entry] : m_entries) usage += memusage::DynamicUsage(uuid);
+    return usage;
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_STORAGE_CACHE_H
+#define BITCOIN_STORAGE_CACHE_H
+
+#include <sync.h>
+#include <uint256.h>
+#include <util/fs.h>
+#include <validationinterface.h>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+class ChainstateManager;
+
+//! Default size of the fetched asset cache in MiB, 0 disables it
+static constexpr int64_t DEFAULT_STORAGE_CACHE_SIZE{0};
+//! Confirmations the newest chunk of an asset needs before the asset is cached
+static constexpr int STORAGE_CACHE_MIN_DEPTH{6};
+
+/**
+ * On-disk LRU cache of fetched assets, keyed by uuid. An asset can not change
+ * once its chunks are buried deep enough, so a repeated fetch is served by
+ * copying the cached file instead of scanning and decoding the chain again.
+ *
+ * Each file is named <uuid>-<block hash>, where the block is the one holding
+ * the newest chunk of the asset. Entries are dropped when that block is
+ * disconnected, or is no longer in the active chain at startup.
+ */
+class StorageCache final : public CValidationInterface
+{
+private:
+    struct Entry {
+        uint256 block_hash;
+        int height{0};
+        uint64_t size{0};
+        std::list<std::string>::iterator lru;
+    };
+
+    const fs::path m_dir;
+    const uint64_t m_max_size;
+    ChainstateManager* m_chainman{nullptr};
+
+    Mutex m_mutex;
+    //! Cached uuids, most recently used first
+    std::list<std::string> m_lru GUARDED_BY(m_mutex);
+    std::map<std::string, Entry> m_entries GUARDED_BY(m_mutex);
+    uint64_t m_size GUARDED_BY(m_mutex){0};
+    //! Fetches served from the cache, and not
+    uint64_t m_hits GUARDED_BY(m_mutex){0};
+    uint64_t m_misses GUARDED_BY(m_mutex){0};
+
+    fs::path EntryPath(const std::string& uuid, const uint256& block_hash) const;
+    void Add(const std::string& uuid, const Entry& entry) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void Evict(const std::string& uuid) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+protected:
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+
+public:
+    /** Size and lookups of the cache */
+    struct Stats {
+        size_t entries{0};
+        uint64_t size{0};
+        uint64_t max_size{0};
+        uint64_t hits{0};
+        uint64_t misses{0};
+    };
+
+    StorageCache(const fs::path& dir, uint64_t max_size) : m_dir(dir), m_max_size(max_size) {}
+
+    /// Load the entries on disk, dropping those not in the active chain,
+    /// and start following the chain through the validation interface.
+    bool Start(ChainstateManager& chainman);
+
+    /// Stop following the chain.
+    void Stop();
+
+    /// Copy the cached asset to dest. Returns false on a miss.
+    bool Fetch(const std::string& uuid, const fs::path& dest);
+
+    /// Cache the fetched asset at src, if the newest chunk at height is deep enough.
+    void Insert(const std::string& uuid, const fs::path& src, int height);
+
+    Stats GetStats();
+
+    /// Memory held by the entries, not the files they stand for.
+    size_t DynamicMemoryUsage();
+};
+
+/// The global fetched asset cache. May be null.
+extern std::unique_ptr<StorageCache> g_storage_cache;
+
+#endif // BITCOIN_STORAGE_CACHE_H
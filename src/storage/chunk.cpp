@@ -1,3 +1,6 @@
+#include <algorithm>
+
+#include <opfile/src/chunk.h>
 #include <opfile/src/util.h>
 #include <storage/chunk.h>
 
@@ -50,3 +53,40 @@ void get_signature_from_auth(std::string chunk, std::string& sig) {
 void get_signature_from_auth (std::string chunk, std::string& sig, int pintOffset) {
     sig = get_hex_from_offset(chunk, pintOffset + (OPAUTH_MAGICLEN*2) + (OPAUTH_OPERATIONLEN*2) + (OPAUTH_TIMELEN*2) + (OPAUTH_HASHLEN*2), 0);
 }
+
+bool is_auth_magic_in_script (Span<const unsigned char> script) {
+    Span<const unsigned char> payload;
+    if (!get_payload_from_script (script, payload) || payload.size() < OPAUTH_MAGICLEN) {
+        return false;
+    }
+    return std::equal(std::begin(OPAUTH_MAGIC_BIN), std::end(OPAUTH_MAGIC_BIN), payload.begin());
+}
+
+bool parse_auth_from_script (Span<const unsigned char> script, auth_view& view) {
+    const size_t prefixlen = OPAUTH_MAGICLEN + OPAUTH_OPERATIONLEN + OPAUTH_TIMELEN + OPAUTH_HASHLEN;
+    if (!get_payload_from_script (script, view.payload) || view.payload.size() < prefixlen) {
+        return false;
+    }
+    if (!std::equal(std::begin(OPAUTH_MAGIC_BIN), std::end(OPAUTH_MAGIC_BIN), view.payload.begin())) {
+        return false;
+    }
+    size_t offset = OPAUTH_MAGICLEN;
+    view.operation = view.payload[offset];
+    offset += OPAUTH_OPERATIONLEN;
+    view.time = 0;
+    for (int i = 0; i < OPAUTH_TIMELEN; i++) {
+        view.time = (view.time << 8) | view.payload[offset + i];
+    }
+    offset += OPAUTH_TIMELEN;
+    view.hash = view.payload.subspan(offset, OPAUTH_HASHLEN);
+    offset += OPAUTH_HASHLEN;
+    view.signature = view.payload.subspan(offset);
+    return true;
+}
+
+uint160 get_hash160_from_auth (const auth_view& view) {
+    // hex notation is most significant byte first, uint160 stores least significant first
+    uint160 hash160;
+    std::reverse_copy(view.hash.begin(), view.hash.end(), hash160.begin());
+    return hash160;
+}
@@ -29,6 +29,29 @@ const std::string OPAUTH_DELUSER = "01";
 
 // Auth data
 const std::string OPAUTH_MAGIC = "6c796e6b";
+const unsigned char OPAUTH_MAGIC_BIN[] = { 0x6c, 0x79, 0x6e, 0x6b };
+
+// Binary operation bytes
+const uint8_t OPAUTH_ADDUSER_BIN = 0x00;
+const uint8_t OPAUTH_DELUSER_BIN = 0x01;
+
+// Zero-copy view over authdata carried in an OP_RETURN script
+struct auth_view {
+    Span<const unsigned char> payload;
+    uint8_t operation{0};
+    uint32_t time{0};
+    Span<const unsigned char> hash;
+    Span<const unsigned char> signature;
+};
+
+// Cheap prefilter, true if the script pushes authdata magic
+bool is_auth_magic_in_script (Span<const unsigned char> script);
+
+// Parse authdata directly from script bytes, without hex conversion
+bool parse_auth_from_script (Span<const unsigned char> script, auth_view& view);
+
+// Operand hash160, as uint160S(hex of hash) would give
+uint160 get_hash160_from_auth (const auth_view& view);
 
 //void get_magic_from_auth(std::string chunk, std::string& magic);
 void get_magic_from_auth (std::string chunk, std::string& magic, int pintOffset);
@@ -0,0 +1,131 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <storage/funding.h>
+
+#include <consensus/consensus.h>
+#include <logging.h>
+#include <script/standard.h>
+#include <util/result.h>
+#include <util/translation.h>
+#include <wallet/coincontrol.h>
+#include <wallet/spend.h>
+#include <wallet/wallet.h>
+
+#include <algorithm>
+#include <optional>
+
+std::unique_ptr<StorageFunding> g_storage_funding;
+
+void StorageFunding::Update(wallet::CWallet& wallet)
+{
+    AssertLockHeld(wallet.cs_wallet);
+    if (!m_loaded) {
+        // Outputs of the pool's size are taken to be the pool's, as after a restart
+        wallet::CoinFilterParams params;
+        params.min_amount = m_size;
+        params.max_amount = m_size;
+        for (const wallet::COutput& output : wallet::AvailableCoins(wallet, /*coinControl=*/nullptr, /*feerate=*/std::nullopt, params).All()) {
+            m_outputs.insert(output.outpoint);
+            wallet.LockCoin(output.outpoint);
+        }
+        m_loaded = true;
+    }
+
+    for (auto it = m_outputs.begin(); it != m_outputs.end();) {
+        const wallet::CWalletTx* wtx{wallet.GetWalletTx(it->hash)};
+        if (!wtx || wallet.IsSpent(*it) || wallet.GetTxDepthInMainChain(*wtx) < 0) {
+            wallet.UnlockCoin(*it);
+            it = m_outputs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool StorageFunding::IsReady(wallet::CWallet& wallet, const COutPoint& outpoint) const
+{
+    AssertLockHeld(wallet.cs_wallet);
+    const wallet::CWalletTx* wtx{wallet.GetWalletTx(outpoint.hash)};
+    // As deep as any input of a putfile transaction is to be
+    return wtx && wallet.GetTxDepthInMainChain(*wtx) >= COINBASE_MATURITY;
+}
+
+int StorageFunding::Ready(wallet::CWallet& wallet)
+{
+    LOCK2(wallet.cs_wallet, m_mutex);
+    Update(wallet);
+    return std::count_if(m_outputs.begin(), m_outputs.end(), [&](const COutPoint& outpoint) {
+        return IsReady(wallet, outpoint);
+    });
+}
+
+std::vector<COutPoint> StorageFunding::Take(wallet::CWallet& wallet, int count)
+{
+    std::vector<COutPoint> taken;
+    LOCK2(wallet.cs_wallet, m_mutex);
+    Update(wallet);
+    for (auto it = m_outputs.begin(); it != m_outputs.end() && (int)taken.size() < count;) {
+        if (IsReady(wallet, *it)) {
+            taken.push_back(*it);
+            it = m_outputs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return taken;
+}
+
+bool StorageFunding::Return(wallet::CWallet& wallet, const COutPoint& outpoint)
+{
+    LOCK2(wallet.cs_wallet, m_mutex);
+    const wallet::CWalletTx* wtx{wallet.GetWalletTx(outpoint.hash)};
+    if (!wtx || outpoint.n >= wtx->tx->vout.size() || wtx->tx->vout[outpoint.n].nValue != m_size || wallet.IsSpent(outpoint)) {
+        return false;
+    }
+    m_outputs.insert(outpoint);
+    wallet.LockCoin(outpoint);
+    return true;
+}
+
+int StorageFunding::Refill(wallet::CWallet& wallet)
+{
+    int missing;
+    {
+        LOCK2(wallet.cs_wallet, m_mutex);
+        Update(wallet);
+        missing = std::min<int>(m_target - (int)m_outputs.size(), MAX_STORAGE_FUNDING_REFILL);
+    }
+    if (missing <= 0) {
+        return 0;
+    }
+
+    std::vector<wallet::CRecipient> recipients;
+    const OutputType type{wallet.m_default_change_type.value_or(wallet.m_default_address_type)};
+    for (int i = 0; i < missing; ++i) {
+        const util::Result<CTxDestination> dest{wallet.GetNewChangeDestination(type)};
+        if (!dest) {
+            LogPrintf("Storage funding: no address to refill the pool to: %s\n", util::ErrorString(dest).original);
+            return 0;
+        }
+        recipients.push_back({GetScriptForDestination(*dest), m_size, /*fSubtractFeeFromAmount=*/false});
+    }
+
+    const auto created{wallet::CreateTransaction(wallet, recipients, /*change_pos=*/-1, wallet::CCoinControl{})};
+    if (!created) {
+        LogPrintf("Storage funding: unable to refill the pool: %s\n", util::ErrorString(created).original);
+        return 0;
+    }
+    wallet.CommitTransaction(created->tx, {}, {});
+
+    LOCK2(wallet.cs_wallet, m_mutex);
+    for (uint32_t n = 0; n < created->tx->vout.size(); ++n) {
+        if ((int)n == created->change_pos) continue;
+        const COutPoint outpoint{created->tx->GetHash(), n};
+        m_outputs.insert(outpoint);
+        wallet.LockCoin(outpoint);
+    }
+    LogPrintf("Storage funding: refilled the pool with %d outputs in %s\n", missing, created->tx->GetHash().ToString());
+    return missing;
+}
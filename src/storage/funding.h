@@ -0,0 +1,73 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_STORAGE_FUNDING_H
+#define BITCOIN_STORAGE_FUNDING_H
+
+#include <consensus/amount.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace wallet {
+class CWallet;
+} // namespace wallet
+
+//! Default number of outputs kept ready to pay for putfile transactions, 0 disables the pool
+static constexpr int DEFAULT_STORAGE_FUNDING_OUTPUTS{0};
+//! Default value of each of them
+static constexpr CAmount DEFAULT_STORAGE_FUNDING_SIZE{10 * COIN};
+//! Most outputs one refill transaction creates
+static constexpr int MAX_STORAGE_FUNDING_REFILL{100};
+
+/**
+ * Wallet outputs of one size, split off ahead of time to pay for putfile
+ * transactions. Uploads take their inputs from the pool without scanning the
+ * wallet: the pool knows its outputs, and only looks at those to see which
+ * are spent or mature. Outputs are locked while in the pool, so that neither
+ * other spends nor staking take them, and the pool is refilled in the
+ * background once uploads have taken from it.
+ *
+ * The pool picks up outputs of its size once, on first use, as after a restart.
+ * Lock order is the wallet's cs_wallet, then the pool's own mutex.
+ */
+class StorageFunding
+{
+private:
+    const int m_target;
+    const CAmount m_size;
+
+    Mutex m_mutex;
+    bool m_loaded GUARDED_BY(m_mutex){false};
+    //! Outputs of the pool, spendable now or once they mature
+    std::set<COutPoint> m_outputs GUARDED_BY(m_mutex);
+
+    /// Pick up the outputs of the pool's size, and drop those spent or gone since.
+    void Update(wallet::CWallet& wallet) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    bool IsReady(wallet::CWallet& wallet, const COutPoint& outpoint) const;
+
+public:
+    StorageFunding(int target, CAmount size) : m_target(target), m_size(size) {}
+
+    /// Outputs of the pool that can pay for a putfile transaction now.
+    int Ready(wallet::CWallet& wallet) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Take up to count ready outputs out of the pool. They are left locked.
+    std::vector<COutPoint> Take(wallet::CWallet& wallet, int count) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Take back an output taken and left unspent, which stays locked.
+    /// Returns false, leaving it be, if it is not of the pool's size.
+    bool Return(wallet::CWallet& wallet, const COutPoint& outpoint) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Send the wallet a transaction creating the outputs the pool lacks. Returns how many it created.
+    int Refill(wallet::CWallet& wallet) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+/// The global storage funding pool. May be null.
+extern std::unique_ptr<StorageFunding> g_storage_funding;
+
+#endif // BITCOIN_STORAGE_FUNDING_H
@@ -0,0 +1,292 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <storage/peerfetch.h>
+
+#include <logging.h>
+#include <opfile/src/chunk.h>
+#include <opfile/src/decode.h>
+#include <opfile/src/protocol.h>
+#include <storage/auth.h>
+#include <storage/storage.h>
+#include <storage/worker.h>
+#include <util/strencodings.h>
+
+#include <algorithm>
+#include <deque>
+#include <set>
+
+std::unique_ptr<AssetChunkFetcher> g_asset_chunk_fetcher;
+
+uint256 asset_uuid_from_hex(const std::string& uuid)
+{
+    const std::vector<unsigned char> bytes{ParseHex(uuid)};
+    if (bytes.size() != uint256::size()) {
+        return uint256{};
+    }
+    return uint256{bytes};
+}
+
+std::string asset_uuid_to_hex(const uint256& uuid)
+{
+    return HexStr(uuid);
+}
+
+AssetChunks serve_asset_chunks(const AssetChunksRequest& request)
+{
+    AssetChunks answer;
+    answer.uuid = request.uuid;
+    answer.first = request.first;
+    if (!read_asset_chunks(asset_uuid_to_hex(request.uuid), request.first, request.count, answer.header, answer.chunk_total, answer.chunks)) {
+        answer.chunk_total = 0;
+        answer.header.clear();
+        answer.chunks.clear();
+    }
+    return answer;
+}
+
+namespace {
+//! Longest wait for an answer before checking whether the job was cancelled
+constexpr auto FETCH_POLL_INTERVAL{std::chrono::seconds{1}};
+
+/** What the header chunk fixes about the data chunks of an asset */
+struct AssetLayout {
+    std::string uuid;
+    uint8_t version{0};
+    uint32_t chunk_total{0};
+    uint32_t chunkmax{0};
+};
+
+//! Whether the header chunk answered is that of uuid, signed by a tenant on the authList
+bool check_header(const AssetChunks& answer, const std::string& uuid, AssetLayout& layout)
+{
+    chunk_view view;
+    int error_level = NO_ERROR;
+    uint160 tenant;
+    if (answer.chunk_total == 0 || !parse_chunk_from_script(answer.header, view, error_level) ||
+        view.chunklen != 0 || HexStr(view.uuid) != uuid || !is_valid_authchunk(view, error_level, tenant)) {
+        return false;
+    }
+    if (!is_auth_member(tenant)) {
+        LogPrint(BCLog::STORAGE, "Header chunk of uuid %s signed by %s, not on the authList\n", uuid, tenant.ToString());
+        return false;
+    }
+    // Protocol 02 headers give the chunktotal themselves
+    if (view.version == OPENCODING_COMPACT && view.chunktotal != answer.chunk_total) {
+        return false;
+    }
+    layout = {uuid, view.version, answer.chunk_total, get_chunkmax_for_version(view.version)};
+    return true;
+}
+
+//! Whether the data chunks answered are those asked for, of the asset the header describes
+bool check_chunks(const AssetChunks& answer, const AssetChunksRequest& request, const AssetLayout& layout)
+{
+    if (answer.chunk_total != layout.chunk_total || answer.chunks.size() != request.count) {
+        return false;
+    }
+    int error_level = NO_ERROR;
+    for (size_t i = 0; i < answer.chunks.size(); ++i) {
+        chunk_view view;
+        const uint32_t chunknum = request.first + i;
+        if (!parse_chunk_from_script(answer.chunks[i], view, error_level) ||
+            view.version != layout.version || HexStr(view.uuid) != layout.uuid ||
+            view.chunklen == 0 || view.chunknum != chunknum) {
+            return false;
+        }
+        if (chunknum != layout.chunk_total && view.data.size() != layout.chunkmax) {
+            return false;
+        }
+        // Protocol 02 chunks carry no checksum, the reassembler checks them against the merkle root
+        if (view.version != OPENCODING_COMPACT && (view.chunktotal != layout.chunk_total || !is_valid_chunkhash(view))) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+std::optional<uint64_t> AssetChunkFetcher::Send(NodeId peer, const AssetChunksRequest& request)
+{
+    uint64_t id;
+    {
+        LOCK(m_mutex);
+        id = m_next_id++;
+        m_requests.emplace(id, Request{peer, request, std::chrono::steady_clock::now(), /*answered=*/false, /*answer=*/{}});
+    }
+    // Registered first, as the answer may come before the send returns
+    if (!m_send_request(peer, request)) {
+        Forget(id);
+        return std::nullopt;
+    }
+    return id;
+}
+
+void AssetChunkFetcher::Forget(uint64_t id)
+{
+    LOCK(m_mutex);
+    m_requests.erase(id);
+}
+
+bool AssetChunkFetcher::ProcessAnswer(NodeId peer, AssetChunks&& answer)
+{
+    {
+        LOCK(m_mutex);
+        // The oldest request of the peer it answers, as peers answer in order
+        auto it{std::find_if(m_requests.begin(), m_requests.end(), [&](const auto& entry) {
+            const Request& request{entry.second};
+            return request.peer == peer && !request.answered &&
+                   request.request.uuid == answer.uuid && request.request.first == answer.first;
+        })};
+        if (it == m_requests.end()) return false;
+        it->second.answered = true;
+        it->second.answer = std::move(answer);
+    }
+    m_cond.notify_all();
+    return true;
+}
+
+void AssetChunkFetcher::PeerDisconnected(NodeId peer)
+{
+    {
+        LOCK(m_mutex);
+        for (auto& [id, request] : m_requests) {
+            // Failed, as an empty answer would
+            if (request.peer == peer && !request.answered) request.answered = true;
+        }
+    }
+    m_cond.notify_all();
+}
+
+std::vector<std::pair<uint64_t, AssetChunks>> AssetChunkFetcher::WaitAny(const std::set<uint64_t>& ids)
+{
+    std::vector<std::pair<uint64_t, AssetChunks>> finished;
+    WAIT_LOCK(m_mutex, lock);
+    const auto take_finished = [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        const auto now{std::chrono::steady_clock::now()};
+        for (const uint64_t id : ids) {
+            auto it{m_requests.find(id)};
+            if (it == m_requests.end()) continue;
+            // Timed out, as an empty answer
+            if (it->second.answered || now - it->second.sent > ASSET_CHUNKS_TIMEOUT) {
+                finished.emplace_back(id, std::move(it->second.answer));
+                m_requests.erase(it);
+            }
+        }
+        return !finished.empty();
+    };
+    m_cond.wait_for(lock, FETCH_POLL_INTERVAL, take_finished);
+    return finished;
+}
+
+bool AssetChunkFetcher::Fetch(const std::string& uuid_arg, chunk_reassembler& file, int& error_level)
+{
+    const std::string uuid{ToLower(uuid_arg)};
+    const AssetChunksRequest header_request{asset_uuid_from_hex(uuid), 0, 0};
+    std::deque<NodeId> peers;
+    for (const NodeId peer : m_list_peers()) peers.push_back(peer);
+    if (peers.empty()) {
+        LogPrint(BCLog::STORAGE, "No peer serves stored assets to fetch uuid %s from\n", uuid);
+        error_level = ERR_CHUNKAUTHNONE;
+        return false;
+    }
+
+    // The header chunk from the first peer holding it
+    AssetLayout layout;
+    AssetChunks header;
+    while (!peers.empty() && layout.chunk_total == 0) {
+        const NodeId peer{peers.front()};
+        peers.pop_front();
+        const auto id{Send(peer, header_request)};
+        if (!id) continue;
+        while (true) {
+            if (job_cancel_requested()) {
+                Forget(*id);
+                return false;
+            }
+            auto finished{WaitAny({*id})};
+            if (finished.empty()) continue;
+            header = std::move(finished.front().second);
+            break;
+        }
+        if (check_header(header, uuid, layout)) {
+            // Asked for the data chunks first
+            peers.push_front(peer);
+        } else {
+            LogPrint(BCLog::STORAGE, "Peer %d did not send a valid header chunk of uuid %s\n", peer, uuid);
+        }
+    }
+    if (layout.chunk_total == 0) {
+        LogPrint(BCLog::STORAGE, "No peer sent the header chunk of uuid %s\n", uuid);
+        error_level = ERR_CHUNKAUTHNONE;
+        return false;
+    }
+    // Protocol 02 data chunks are checked against the header chunk
+    file.add_chunk(header.header);
+
+    // The data chunks in ranges, asked of every peer in parallel
+    std::deque<AssetChunksRequest> ranges;
+    for (uint64_t first = 1; first <= layout.chunk_total; first += ASSET_CHUNKS_PER_REQUEST) {
+        const uint32_t count = std::min<uint64_t>(ASSET_CHUNKS_PER_REQUEST, layout.chunk_total - first + 1);
+        ranges.push_back({header_request.uuid, uint32_t(first), count});
+    }
+    std::map<uint64_t, std::pair<NodeId, AssetChunksRequest>> in_flight;
+    std::map<NodeId, int> load;
+    uint32_t written = 0;
+    const auto forget_in_flight = [&] {
+        for (const auto& [id, sent] : in_flight) Forget(id);
+    };
+    while (!ranges.empty() || !in_flight.empty()) {
+        if (job_cancel_requested()) {
+            forget_in_flight();
+            return false;
+        }
+
+        // Ranges to the peers with the fewest requests outstanding, the range
+        // of a peer failing to send goes to the next one
+        for (int round = 0; round < ASSET_CHUNKS_REQUESTS_PER_PEER && !ranges.empty(); ++round) {
+            for (auto it = peers.begin(); it != peers.end() && !ranges.empty();) {
+                if (load[*it] > round) {
+                    ++it;
+                    continue;
+                }
+                const auto id{Send(*it, ranges.front())};
+                if (!id) {
+                    it = peers.erase(it);
+                    continue;
+                }
+                in_flight.emplace(*id, std::make_pair(*it, ranges.front()));
+                ranges.pop_front();
+                ++load[*it];
+                ++it;
+            }
+        }
+        if (in_flight.empty()) {
+            LogPrint(BCLog::STORAGE, "No peer left to fetch %u data chunks of uuid %s from\n", ranges.size() * ASSET_CHUNKS_PER_REQUEST, uuid);
+            error_level = ERR_NOTALLDATACHUNKS;
+            return false;
+        }
+
+        std::set<uint64_t> ids;
+        for (const auto& [id, sent] : in_flight) ids.insert(id);
+        for (auto& [id, answer] : WaitAny(ids)) {
+            const auto [peer, request] = in_flight.at(id);
+            in_flight.erase(id);
+            --load[peer];
+            if (!check_chunks(answer, request, layout)) {
+                // Not asked again, its ranges go to the other peers as they fail
+                LogPrint(BCLog::STORAGE, "Peer %d did not send data chunks %u to %u of uuid %s\n", peer, request.first, request.first + request.count - 1, uuid);
+                peers.erase(std::remove(peers.begin(), peers.end(), peer), peers.end());
+                ranges.push_back(request);
+                continue;
+            }
+            for (const CScript& chunk : answer.chunks) {
+                file.add_chunk(chunk);
+            }
+            written += request.count;
+            set_job_progress(written, layout.chunk_total);
+        }
+    }
+    return true;
+}
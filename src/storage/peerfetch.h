@@ -0,0 +1,141 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_STORAGE_PEERFETCH_H
+#define BITCOIN_STORAGE_PEERFETCH_H
+
+#include <net.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+class chunk_reassembler;
+
+//! Serve the chunks of stored assets to peers, with the storage index
+static constexpr bool DEFAULT_PEERSTORAGE{false};
+//! Fetch assets not found locally from peers serving stored assets
+static constexpr bool DEFAULT_STORAGEPEERFETCH{true};
+//! Most data chunks asked for in one getassetchunks
+static constexpr uint32_t MAX_ASSET_CHUNKS_PER_MSG{1024};
+//! Data chunks asked of a peer at a time, in one getassetchunks
+static constexpr uint32_t ASSET_CHUNKS_PER_REQUEST{256};
+//! Requests a peer has outstanding at once
+static constexpr int ASSET_CHUNKS_REQUESTS_PER_PEER{2};
+//! Time a peer has to answer a request before it is asked of another peer
+static constexpr auto ASSET_CHUNKS_TIMEOUT{std::chrono::seconds{30}};
+
+/** A getassetchunks message: data chunks first to first + count - 1 of an asset, count 0 for only its header. */
+struct AssetChunksRequest {
+    uint256 uuid;
+    uint32_t first{0};
+    uint32_t count{0};
+
+    SERIALIZE_METHODS(AssetChunksRequest, obj)
+    {
+        READWRITE(obj.uuid, obj.first, obj.count);
+    }
+};
+
+/**
+ * An assetchunks message, answering a getassetchunks. The header chunk comes
+ * with every answer, so each is checked on its own. A peer not holding all the
+ * chunks asked for answers with none, and a chunk_total of 0.
+ */
+struct AssetChunks {
+    uint256 uuid;
+    uint32_t first{0};
+    uint32_t chunk_total{0};
+    CScript header;
+    std::vector<CScript> chunks;
+
+    SERIALIZE_METHODS(AssetChunks, obj)
+    {
+        READWRITE(obj.uuid, obj.first, obj.chunk_total, obj.header, obj.chunks);
+    }
+};
+
+/** The uuid of an asset as the messages carry it, in the byte order of its hex form. */
+uint256 asset_uuid_from_hex(const std::string& uuid);
+std::string asset_uuid_to_hex(const uint256& uuid);
+
+/** The answer to a getassetchunks, from the storage index. Empty unless it holds every chunk asked for. */
+AssetChunks serve_asset_chunks(const AssetChunksRequest& request);
+
+/**
+ * Fetches assets from the peers advertising NODE_STORAGE, for nodes that do not
+ * hold the blocks of an asset, such as pruned nodes or edges in front of a few
+ * archive nodes.
+ *
+ * The header chunk is taken from the first peer holding it, once its signature
+ * recovers a tenant on the authList. The data chunks are then split in ranges
+ * asked of every peer in parallel. Each chunk is checked against the header
+ * and, for protocol 01, its checksum before it is written; protocol 02 files
+ * are checked against the merkle root of the header once written. A peer that
+ * answers with chunks that fail the checks, does not hold them or does not
+ * answer in time is not asked again, and its ranges go to the other peers.
+ *
+ * Requests are sent and peers listed through the functions given, answers are
+ * handed in by net processing.
+ */
+class AssetChunkFetcher
+{
+public:
+    using ListPeers = std::function<std::vector<NodeId>()>;
+    using SendRequest = std::function<bool(NodeId, const AssetChunksRequest&)>;
+
+private:
+    struct Request {
+        NodeId peer;
+        AssetChunksRequest request;
+        std::chrono::steady_clock::time_point sent;
+        bool answered{false};
+        AssetChunks answer;
+    };
+
+    const ListPeers m_list_peers;
+    const SendRequest m_send_request;
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    uint64_t m_next_id GUARDED_BY(m_mutex){0};
+    //! Requests of the fetches in progress, by id
+    std::map<uint64_t, Request> m_requests GUARDED_BY(m_mutex);
+
+    std::optional<uint64_t> Send(NodeId peer, const AssetChunksRequest& request) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void Forget(uint64_t id) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    //! Wait for any of the requests ids to be answered, fail or time out, those timing out with an
+    //! empty answer. Returns them, none if a poll interval passed first
+    std::vector<std::pair<uint64_t, AssetChunks>> WaitAny(const std::set<uint64_t>& ids) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+public:
+    AssetChunkFetcher(ListPeers list_peers, SendRequest send_request)
+        : m_list_peers(std::move(list_peers)), m_send_request(std::move(send_request)) {}
+
+    /// Hand in the answer of a peer. Returns false if it was not asked for.
+    bool ProcessAnswer(NodeId peer, AssetChunks&& answer) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Fail the requests of a peer that disconnected, so they are asked elsewhere.
+    void PeerDisconnected(NodeId peer) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Fetch the asset into file from the peers. Returns false with error_level
+    /// set if no peer held the whole asset, or the job was cancelled.
+    bool Fetch(const std::string& uuid, chunk_reassembler& file, int& error_level) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+/// The global peer fetcher, used by the storage worker. May be null.
+extern std::unique_ptr<AssetChunkFetcher> g_asset_chunk_fetcher;
+
+#endif // BITCOIN_STORAGE_PEERFETCH_H
@@ -4,21 +4,32 @@
 
 #include <time.h>
 
+#include <core_io.h>
+#include <index/blockfilterindex.h>
+#include <index/storageindex.h>
 #include <key_io.h>
+#include <node/jobs.h>
 #include <opfile/src/protocol.h>
 #include <opfile/src/util.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/register.h>
 #include <rpc/request.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
 #include <storage/auth.h>
+#include <storage/authsync.h>
+#include <storage/blockchunks.h>
+#include <storage/cache.h>
 #include <storage/chunk.h>
+#include <storage/stats.h>
 #include <storage/storage.h>
+#include <storage/uploads.h>
 #include <storage/util.h>
 #include <storage/worker.h>
 #include <sync.h>
 #include <timedata.h>
+#include <util/strencodings.h>
 #include <validation.h>
 
 #include <wallet/rpc/util.h>
@@ -38,13 +49,6 @@ using node::ReadBlockFromDisk;
 extern uint160 authUser;
 extern WalletContext* storage_context;
 extern ChainstateManager* storage_chainman;
-extern std::vector<std::pair<std::string, std::string>> workQueueResult;
-
-extern std::map<std::string, int> gmapFileLength;
-
-extern std::map<std::string, int> gmapBlockHeight;
-
-extern std::map<std::string, int> gmapTimeStamp;
 
 static RPCHelpMan store()
 {
@@ -52,7 +56,9 @@ static RPCHelpMan store()
         "\nStore a file on the Lynx blockchain.\n",
          {
              {"filepath", RPCArg::Type::STR, RPCArg::Optional::NO, "Full path of file to be uploaded"},
-             {"uuid", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Custom unique identifier (32 characters, hexadecimal format, must be unique across all files)"},
+             {"uuid", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Custom unique identifier (32 characters, hexadecimal format, must be unique across all files). The unique identifier of an unfinished store of the same file resumes it."},
+             {"reuse", RPCArg::Type::BOOL, RPCArg::Default{false}, "Return the unique identifier of a file with the same content the tenant already stored, instead of storing it again. Requires -storageindex, ignored with a custom unique identifier. Only files stored with -storagecontenthash are found, and none with -storageencrypt, as an encrypted file does not give away its content hash."},
+             {"priority", RPCArg::Type::STR, RPCArg::Default{"normal"}, "low, normal or high: which of the jobs waiting for a thread starts first. Among jobs of one priority, those of tenants with fewer jobs running start first."},
          },
          RPCResult{
             RPCResult::Type::STR, "", "success or failure"},
@@ -60,6 +66,10 @@ static RPCHelpMan store()
             "\nStore /home/username/documents/research.pdf on the Lynx blockchain.\n"
             + HelpExampleCli("store", "/home/username/documents/research.pdf")
         + HelpExampleRpc("store", "/home/username/documents/research.pdf")
+            + "\nStore it unless it was stored before.\n"
+            + HelpExampleCli("store", "/home/username/documents/research.pdf \"\" true")
+            + "\nStore it ahead of the jobs waiting.\n"
+            + HelpExampleCli("store", "/home/username/documents/research.pdf \"\" false high")
                 },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
@@ -76,6 +86,12 @@ static RPCHelpMan store()
 
     std::string put_filename = request.params[0].get_str();
     std::string put_uuid = "";
+    bool resume = false;
+
+    const auto priority = node::JobPriorityFromString(request.params[3].isNull() ? "normal" : request.params[3].get_str());
+    if (!priority) {
+        return std::string("invalid-priority");
+    }
 
     // if tenant entered custom uuid
     if(!request.params[1].isNull()) {
@@ -87,8 +103,14 @@ static RPCHelpMan store()
 
         int invalidity_type;
 
+        // an unfinished put of the same file goes on where it stopped, its header may be mined already
+        UploadProgress progress;
+        resume = g_storage_uploads && g_storage_uploads->Get(put_uuid, progress) && progress.path == put_filename;
+
         // if custom uuid valid (length, hex notation)
-        if (is_valid_uuid(put_uuid, invalidity_type)) {
+        if (resume) {
+            LogPrint (BCLog::STORAGE, "resuming put of uuid %s after %d batches\n", put_uuid, progress.txids.size());
+        } else if (is_valid_uuid(put_uuid, invalidity_type)) {
             std::vector<std::string> uuid_found;
             // scan_blocks_for_uuids(*storage_chainman, uuid_found);
 
@@ -111,6 +133,38 @@ static RPCHelpMan store()
         }
     }
 
+    // if no custom uuid, a file the tenant stored before may stand in, unless it is to be stored
+    // encrypted, as the plain one found would be
+    const bool encrypt = gArgs.GetBoolArg("-storageencrypt", DEFAULT_STORAGE_ENCRYPT);
+    if (put_uuid == "" && !request.params[2].isNull() && request.params[2].get_bool() && !encrypt) {
+        if (!g_storage_index) {
+            return std::string("storageindex-required");
+        }
+        uint256 content_hash;
+        if (!sha256_hash_file(put_filename, content_hash.begin())) {
+            return std::string("failure");
+        }
+        g_storage_index->BlockUntilSyncedToCurrentChain();
+        std::string existing_uuid;
+        if (g_storage_index->FindContent(content_hash, authUser, existing_uuid)) {
+            LogPrint (BCLog::STORAGE, "file %s already stored as uuid %s\n", put_filename, existing_uuid);
+            return existing_uuid;
+        }
+    }
+
+    // a tenant past its quota stores nothing more, going by the confirmed chain
+    const int64_t quota = gArgs.GetIntArg("-storagequota", DEFAULT_STORAGE_QUOTA);
+    if (quota > 0 && !resume) {
+        if (!g_storage_index) {
+            return std::string("storageindex-required");
+        }
+        StorageUsage usage;
+        g_storage_index->FindTenantUsage(authUser, usage);
+        if (usage.bytes + std::max(read_file_size(put_filename), 0) > uint64_t(quota) << 20) {
+            return std::string("quota-exceeded");
+        }
+    }
+
     // if no custom uuid
     if (put_uuid == "") {
         // int uuid_not_found_to_not_exist = 1;
@@ -132,9 +186,11 @@ static RPCHelpMan store()
     }
 
     if (read_file_size(put_filename) > 0) {
-        add_put_task(put_filename, put_uuid);
+        if (add_put_task(put_filename, put_uuid, *priority, authUser.ToString()).empty()) {
+            return std::string("A duplicate unique identifier was discovered.");
+        }
 
-LogPrint (BCLog::ALL, "uuid %s\n", put_uuid);
+LogPrint (BCLog::STORAGE, "uuid %s\n", put_uuid);
 
         // return get_result_hash();
         return put_uuid;
@@ -145,6 +201,109 @@ LogPrint (BCLog::ALL, "uuid %s\n", put_uuid);
     };
 }
 
+static RPCHelpMan storebatch()
+{
+    return RPCHelpMan{"storebatch",
+        "\nStore several small files on the Lynx blockchain at once.\n"
+        "Each file is stored as its own asset, with its own unique identifier, and fetched as one stored alone.\n"
+        "Their chunks are packed together into as few transactions as they fit in, paid for from a single input,\n"
+        "instead of each file taking at least one transaction of its own.\n",
+         {
+             {"filepaths", RPCArg::Type::ARR, RPCArg::Optional::NO, strprintf("Full paths of the files to be uploaded, at most %d, of at most %d bytes together", MAX_STORAGE_BATCH_FILES, MAX_STORAGE_BATCH_BYTES),
+                 {
+                     {"filepath", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Full path of a file"},
+                 },
+             },
+             {"priority", RPCArg::Type::STR, RPCArg::Default{"normal"}, "low, normal or high: which of the jobs waiting for a thread starts first."},
+         },
+         {
+             RPCResult{"on success",
+                 RPCResult::Type::OBJ, "", "",
+                 {
+                     {RPCResult::Type::STR, "job", "The job storing the files"},
+                     {RPCResult::Type::ARR, "assets", "One entry per file, in the order given",
+                         {
+                             {RPCResult::Type::OBJ, "", "",
+                                 {
+                                     {RPCResult::Type::STR, "filepath", "Full path of the file"},
+                                     {RPCResult::Type::STR, "uuid", "The unique identifier of the file"},
+                                 }},
+                         }},
+                 }},
+             RPCResult{"on failure",
+                 RPCResult::Type::STR, "", "failure"},
+         },
+         RPCExamples{
+            "\nStore two documents together.\n"
+            + HelpExampleCli("storebatch", "'[\"/home/username/documents/a.txt\",\"/home/username/documents/b.txt\"]'")
+        + HelpExampleRpc("storebatch", "[\"/home/username/documents/a.txt\",\"/home/username/documents/b.txt\"]")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if (!is_auth_member(authUser)) {
+        return std::string("Please authenticate to use this command.");
+    }
+    if (authUser.ToString() == Params().GetConsensus().initAuthUser.ToString()) {
+        return std::string("not-authenticated as tenant");
+    }
+
+    const auto priority = node::JobPriorityFromString(request.params[1].isNull() ? "normal" : request.params[1].get_str());
+    if (!priority) {
+        return std::string("invalid-priority");
+    }
+
+    const UniValue& filepaths = request.params[0].get_array();
+    if (filepaths.empty() || filepaths.size() > MAX_STORAGE_BATCH_FILES) {
+        return std::string("invalid-count");
+    }
+    std::vector<std::pair<std::string, std::string>> files;
+    int64_t total_bytes = 0;
+    for (const UniValue& filepath : filepaths.getValues()) {
+        const int filelen = read_file_size(filepath.get_str());
+        if (filelen <= 0) {
+            return std::string("failure");
+        }
+        total_bytes += filelen;
+        files.emplace_back(filepath.get_str(), generate_uuid(OPENCODING_UUID));
+    }
+    if (total_bytes > MAX_STORAGE_BATCH_BYTES) {
+        return std::string("batch-too-large");
+    }
+
+    // a tenant past its quota stores nothing more, going by the confirmed chain
+    const int64_t quota = gArgs.GetIntArg("-storagequota", DEFAULT_STORAGE_QUOTA);
+    if (quota > 0) {
+        if (!g_storage_index) {
+            return std::string("storageindex-required");
+        }
+        StorageUsage usage;
+        g_storage_index->FindTenantUsage(authUser, usage);
+        if (usage.bytes + total_bytes > uint64_t(quota) << 20) {
+            return std::string("quota-exceeded");
+        }
+    }
+
+    const std::string job_id = add_put_batch_task(files, *priority, authUser.ToString());
+    if (job_id.empty()) {
+        return std::string("failure");
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("job", job_id);
+    UniValue assets(UniValue::VARR);
+    for (const auto& [filepath, uuid] : files) {
+        LogPrint (BCLog::STORAGE, "uuid %s for %s\n", uuid, filepath);
+        UniValue asset(UniValue::VOBJ);
+        asset.pushKV("filepath", filepath);
+        asset.pushKV("uuid", uuid);
+        assets.push_back(std::move(asset));
+    }
+    result.pushKV("assets", std::move(assets));
+    return result;
+},
+    };
+}
+
 static RPCHelpMan fetch()
 {
     return RPCHelpMan{"fetch",
@@ -152,6 +311,7 @@ static RPCHelpMan fetch()
          {
              {"uuid", RPCArg::Type::STR, RPCArg::Optional::NO, "The unique identifier of the file."},
              {"path", RPCArg::Type::STR, RPCArg::Optional::NO, "The full path where you want to download the file."},
+             {"priority", RPCArg::Type::STR, RPCArg::Default{"normal"}, "low, normal or high: which of the jobs waiting for a thread starts first."},
          },
          RPCResult{
             RPCResult::Type::STR, "", "success or failure"},
@@ -167,9 +327,12 @@ static RPCHelpMan fetch()
     if (!does_path_exist(path)) {
         return std::string("invalid-path");
     }
+    const auto priority = node::JobPriorityFromString(request.params[2].isNull() ? "normal" : request.params[2].get_str());
+    if (!priority) {
+        return std::string("invalid-priority");
+    }
     if (uuid.size() == OPENCODING_UUID*2) {
-        add_get_task(std::make_pair(uuid, path));
-        return get_result_hash();
+        return add_get_task(std::make_pair(uuid, path), *priority, authUser.ToString());
     } else {
         return std::string("invalid-length");
     } 
@@ -179,17 +342,289 @@ static RPCHelpMan fetch()
     };
 }
 
+static RPCHelpMan fetchbatch()
+{
+    return RPCHelpMan{"fetchbatch",
+        "\nRetrieve several files stored on the Lynx blockchain at once.\n"
+        "Without -storageindex, the files are gathered in a single pass over the blockchain, rather than one pass each.\n"
+        "The job returns an object with, for each unique identifier, success or the error retrieving it.\n",
+         {
+             {"uuids", RPCArg::Type::ARR, RPCArg::Optional::NO, strprintf("The unique identifiers of the files, at most %d", MAX_STORAGE_FETCH_BATCH),
+                 {
+                     {"uuid", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "The unique identifier of a file"},
+                 },
+             },
+             {"path", RPCArg::Type::STR, RPCArg::Optional::NO, "The full path where you want to download the files."},
+             {"priority", RPCArg::Type::STR, RPCArg::Default{"normal"}, "low, normal or high: which of the jobs waiting for a thread starts first."},
+         },
+         RPCResult{
+            RPCResult::Type::STR, "", "the job retrieving the files, or failure"},
+         RPCExamples{
+            "\nRetrieve two files and store them in /home/username/downloads.\n"
+            + HelpExampleCli("fetchbatch", "'[\"00112233445566778899aabbccddeeff00112233445566778899aabbccddeeff\",\"ffeeddccbbaa99887766554433221100ffeeddccbbaa99887766554433221100\"]' /home/username/downloads")
+        + HelpExampleRpc("fetchbatch", "[\"00112233445566778899aabbccddeeff00112233445566778899aabbccddeeff\"], \"/home/username/downloads\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    std::string path = request.params[1].get_str();
+    if (!does_path_exist(path)) {
+        return std::string("invalid-path");
+    }
+    const auto priority = node::JobPriorityFromString(request.params[2].isNull() ? "normal" : request.params[2].get_str());
+    if (!priority) {
+        return std::string("invalid-priority");
+    }
+    const UniValue& uuids = request.params[0].get_array();
+    if (uuids.empty() || uuids.size() > MAX_STORAGE_FETCH_BATCH) {
+        return std::string("invalid-count");
+    }
+    std::vector<std::string> batch;
+    std::set<std::string> seen;
+    for (const UniValue& uuid : uuids.getValues()) {
+        if (uuid.get_str().size() != OPENCODING_UUID*2 || !IsHex(uuid.get_str())) {
+            return std::string("invalid-length");
+        }
+        // Each asset is written once, to the file named after it
+        if (seen.insert(uuid.get_str()).second) {
+            batch.push_back(uuid.get_str());
+        }
+    }
+    return add_get_batch_task(std::move(batch), path, *priority, authUser.ToString());
+},
+    };
+}
+
+static RPCHelpMan fetchrange()
+{
+    return RPCHelpMan{"fetchrange",
+        "\nRetrieve a byte range of a file stored on the Lynx blockchain, reading only the chunks holding it.\n"
+        "Requires -storageindex. Unlike fetch, protocol 02 chunks are not checked against the file's merkle root.\n"
+        "A file stored encrypted is decrypted with the key of the authenticated tenant.\n",
+         {
+             {"uuid", RPCArg::Type::STR, RPCArg::Optional::NO, "The unique identifier of the file."},
+             {"offset", RPCArg::Type::NUM, RPCArg::Optional::NO, "Position in the file of the first byte."},
+             {"length", RPCArg::Type::NUM, RPCArg::Optional::NO, strprintf("Number of bytes, at most %d. Cut short at the end of the file.", MAX_FETCHRANGE_LENGTH)},
+         },
+         {
+            RPCResult{"on success",
+                RPCResult::Type::OBJ, "", "", {
+                {RPCResult::Type::STR, "uuid", "Unique identifier of the file"},
+                {RPCResult::Type::NUM, "offset", "Position in the file of the first byte"},
+                {RPCResult::Type::NUM, "length", "Number of bytes returned"},
+                {RPCResult::Type::NUM, "filelength", "File size in bytes"},
+                {RPCResult::Type::STR_HEX, "data", "The bytes of the range"},
+            }},
+            RPCResult{"on failure",
+                RPCResult::Type::STR, "", "failure reason"},
+         },
+         RPCExamples{
+            "\nRetrieve the first 1 MiB of file 00112233445566778899aabbccddeeff.\n"
+            + HelpExampleCli("fetchrange", "00112233445566778899aabbccddeeff 0 1048576")
+        + HelpExampleRpc("fetchrange", "00112233445566778899aabbccddeeff, 0, 1048576")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    std::string uuid = request.params[0].get_str();
+    const int64_t offset = request.params[1].getInt<int64_t>();
+    const int64_t length = request.params[2].getInt<int64_t>();
+
+    if (!g_storage_index) {
+        return std::string("storageindex-required");
+    }
+    if (uuid.size() != OPENCODING_UUID*2 || !IsHex(uuid)) {
+        return std::string("invalid-length");
+    }
+    if (offset < 0 || length < 0 || uint64_t(length) > MAX_FETCHRANGE_LENGTH) {
+        return std::string("invalid-range");
+    }
+
+    int error_level = NO_ERROR;
+    uint64_t filelen;
+    std::vector<unsigned char> data;
+    if (!fetch_asset_range(uuid, offset, length, data, filelen, error_level)) {
+        if (error_level == ERR_CHUNKAUTHNONE) return std::string("not-found");
+        if (error_level == ERR_FILELENGTH) return std::string("invalid-offset");
+        if (error_level == ERR_NOTALLDATACHUNKS) return std::string("incomplete");
+        if (error_level == ERR_DECRYPT) return std::string("not-decryptable");
+        return std::string("failure");
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("uuid", uuid);
+    ret.pushKV("offset", offset);
+    ret.pushKV("length", (uint64_t)data.size());
+    ret.pushKV("filelength", filelen);
+    ret.pushKV("data", HexStr(data));
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan fetchproof()
+{
+    return RPCHelpMan{"fetchproof",
+        "\nProve that a file is stored on the Lynx blockchain, against block headers only.\n"
+        "Returns the transactions holding its header chunk and data chunks, with one merkle proof per block\n"
+        "holding any of them, as gettxoutproof returns, which verifytxoutproof checks. Requires -storageindex\n"
+        "and the blocks holding the file, so it fails for pruned blocks.\n",
+         {
+             {"uuid", RPCArg::Type::STR, RPCArg::Optional::NO, "The unique identifier of the file."},
+         },
+         {
+            RPCResult{"on success",
+                RPCResult::Type::OBJ, "", "", {
+                {RPCResult::Type::STR, "uuid", "Unique identifier of the file"},
+                {RPCResult::Type::NUM, "chunktotal", "Number of data chunks"},
+                {RPCResult::Type::ARR, "blocks", "The blocks holding chunks of the file, by height", {
+                    {RPCResult::Type::OBJ, "", "", {
+                        {RPCResult::Type::STR_HEX, "blockhash", "The block hash"},
+                        {RPCResult::Type::NUM, "height", "The block height"},
+                        {RPCResult::Type::STR_HEX, "proof", "The serialized, hex-encoded merkle proof of the transactions"},
+                        {RPCResult::Type::ARR, "transactions", "The transactions holding chunks, in block order", {
+                            {RPCResult::Type::STR_HEX, "", "The serialized, hex-encoded transaction"},
+                        }},
+                    }},
+                }},
+            }},
+            RPCResult{"on failure",
+                RPCResult::Type::STR, "", "failure reason"},
+         },
+         RPCExamples{
+            "\nProve file 00112233445566778899aabbccddeeff is stored.\n"
+            + HelpExampleCli("fetchproof", "00112233445566778899aabbccddeeff")
+        + HelpExampleRpc("fetchproof", "00112233445566778899aabbccddeeff")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const std::string uuid{ToLower(request.params[0].get_str())};
+
+    if (!g_storage_index) {
+        return std::string("storageindex-required");
+    }
+    if (uuid.size() != OPENCODING_UUID*2 || !IsHex(uuid)) {
+        return std::string("invalid-length");
+    }
+
+    int error_level = NO_ERROR;
+    uint32_t chunktotal;
+    std::vector<asset_block_proof> proofs;
+    if (!build_asset_proof(EnsureAnyChainman(request.context), uuid, chunktotal, proofs, error_level)) {
+        if (error_level == ERR_CHUNKAUTHNONE) return std::string("not-found");
+        if (error_level == ERR_NOTALLDATACHUNKS) return std::string("incomplete");
+        if (error_level == ERR_UNCONFIRMED) return std::string("unconfirmed");
+        if (error_level == ERR_FILEREAD) return std::string("block-unavailable");
+        return std::string("failure");
+    }
+
+    UniValue blocks(UniValue::VARR);
+    for (const auto& proof : proofs) {
+        DataStream ssMB{};
+        ssMB << proof.merkleblock;
+        UniValue txs(UniValue::VARR);
+        for (const auto& tx : proof.txs) {
+            txs.push_back(EncodeHexTx(*tx));
+        }
+        UniValue block(UniValue::VOBJ);
+        block.pushKV("blockhash", proof.index->GetBlockHash().GetHex());
+        block.pushKV("height", proof.index->nHeight);
+        block.pushKV("proof", HexStr(ssMB));
+        block.pushKV("transactions", txs);
+        blocks.push_back(block);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("uuid", uuid);
+    ret.pushKV("chunktotal", (uint64_t)chunktotal);
+    ret.pushKV("blocks", blocks);
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan getblockstoragechunks()
+{
+    return RPCHelpMan{"getblockstoragechunks",
+        "\nReturn the storage chunks and authdata carried by a block, parsed once, without the rest of the block.\n"
+        "An indexer gets every payload of a block for a fraction of the data getblock returns.\n",
+         {
+             {"blockhash", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The block hash"},
+             {"verbose", RPCArg::Type::BOOL, RPCArg::Default{true}, "true for the payloads decoded, false for their hex-encoded binary form"},
+         },
+         {
+            RPCResult{"for verbose = false",
+                RPCResult::Type::STR_HEX, "", "The serialized transactions carrying payloads: each txid, index in the block, and payloads of vout, type (0 auth, 1 header, 2 data) and the data pushed"},
+            RPCResult{"for verbose = true",
+                RPCResult::Type::OBJ, "", "", {
+                {RPCResult::Type::STR_HEX, "hash", "The block hash"},
+                {RPCResult::Type::NUM, "height", "The block height"},
+                {RPCResult::Type::ARR, "transactions", "The transactions carrying payloads, in block order", {
+                    {RPCResult::Type::OBJ, "", "", {
+                        {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                        {RPCResult::Type::NUM, "index", "The position of the transaction in the block"},
+                        {RPCResult::Type::ARR, "payloads", "", {
+                            {RPCResult::Type::OBJ, "", "", {
+                                {RPCResult::Type::NUM, "vout", "The output carrying the payload"},
+                                {RPCResult::Type::STR, "type", "auth, header or data"},
+                                {RPCResult::Type::ELISION, "", "The fields of the authdata or chunk"},
+                            }},
+                        }},
+                    }},
+                }},
+            }},
+         },
+         RPCExamples{
+            HelpExampleCli("getblockstoragechunks", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\"")
+        + HelpExampleRpc("getblockstoragechunks", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const uint256 hash{ParseHashV(request.params[0], "blockhash")};
+    const bool verbose{request.params[1].isNull() || request.params[1].get_bool()};
+
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    const CBlockIndex* pindex;
+    {
+        LOCK(cs_main);
+        pindex = chainman.m_blockman.LookupBlockIndex(hash);
+        if (!pindex) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        }
+        if (chainman.m_blockman.IsBlockPruned(pindex)) {
+            throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+        }
+    }
+
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, chainman.GetParams().GetConsensus())) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    }
+    const std::vector<StorageTxPayloads> txs{ExtractBlockStoragePayloads(block)};
+
+    if (!verbose) {
+        DataStream ss{};
+        ss << txs;
+        return HexStr(ss);
+    }
+    return StoragePayloadsToJSON(hash, pindex->nHeight, txs);
+},
+    };
+}
+
 static RPCHelpMan list()
 {
     return RPCHelpMan{"list",
-                "\nLists metadata for tenant's blockchain files in chronological order (newest first).\n",
+                "\nLists metadata for tenant's blockchain files in chronological order (newest first).\n"
+                "Results are paged by count, the cursor returned with a page starts the following one.\n",
                 {
                     // Optional number of uuid's to return, defaults to all.
                     {"count", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Number of results to display. If omitted, shows all results."},
+                    {"cursor", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "The next_cursor returned with the previous page. If omitted, starts with the newest file."},
+                    {"start_time", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Only files whose storage began at or after this UNIX epoch time."},
+                    {"end_time", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "Only files whose storage began at or before this UNIX epoch time."},
                 }, {
 
                     RPCResult{
-                        RPCResult::Type::ARR, "", "", {{
+                        RPCResult::Type::ARR, "", "The page of files, followed by an object holding next_cursor if more files remain", {{
                             RPCResult::Type::ARR, "", "", {{
                                 RPCResult::Type::OBJ, "", "", {
                                 {RPCResult::Type::STR, "uuid", "Unique identifier of the file"},
@@ -204,6 +639,8 @@ static RPCHelpMan list()
             },
             RPCExamples{
                 HelpExampleCli("list", "")
+                + HelpExampleCli("list", "\"10\"")
+                + HelpExampleCli("list", "\"10\" \"<next_cursor>\"")
                 + HelpExampleRpc("list", "")
             },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
@@ -218,26 +655,36 @@ static RPCHelpMan list()
     // End if not authenticated
     }
 
-    // Initialize number of uuids asked for (0 means all)
-    std::string strCount = "0";
-
-    // Integer number of uuids asked for
-    int intCount;
+    // Page asked for
+    StorageListQuery query;
 
-    // If optional parameter (number of uuids asked for)
+    // If optional parameter (number of uuids asked for, 0 means all)
     if (!request.params[0].isNull()) {
 
-        // Get n umber of uuids asked for
-        strCount = request.params[0].get_str();
+        // Get number of uuids asked for
+        query.count = stoi (request.params[0].get_str());
 
     // End if optional parameter (number of uuids asked for)
     }
 
-    // Convert to integer     
-    intCount = stoi (strCount);
+    // If optional parameter (cursor of the page asked for)
+    if (!request.params[1].isNull() && !request.params[1].get_str().empty()) {
+
+        query.cursor = StorageListCursor::FromString(request.params[1].get_str());
+        if (!query.cursor) {
+            return std::string("invalid-cursor");
+        }
+
+    // End if optional parameter (cursor of the page asked for)
+    }
 
-    // Vector of uuids found
-    std::vector<std::string> vctUUIDs;
+    // If optional parameters (time range asked for)
+    if (!request.params[2].isNull()) {
+        query.start_time = std::max<int64_t>(0, request.params[2].getInt<int64_t>());
+    }
+    if (!request.params[3].isNull()) {
+        query.end_time = request.params[3].getInt<int64_t>();
+    }
 
     // Clock start
     clock_t clkStart;
@@ -251,8 +698,10 @@ static RPCHelpMan list()
     // Start timer
     clkStart = clock ();
 
-    // Get list of uuids
-    scan_blocks_for_uuids(*storage_chainman, vctUUIDs, intCount);
+    // Get page of assets
+    std::vector<StorageAssetInfo> vctAssets;
+    std::optional<StorageListCursor> optNext;
+    scan_blocks_for_assets(*storage_chainman, query, vctAssets, optNext);
 
     // End timer
     clkEnd = clock ();
@@ -261,74 +710,15 @@ static RPCHelpMan list()
     dblElapsedTime = (double) (clkEnd - clkStart) / CLOCKS_PER_SEC;
 
     // Output elapsed time to debug
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "Elapsed time for getuuids %ld \n", dblElapsedTime);
-    LogPrint (BCLog::ALL, "\n");
-
-    // Output data structures
-    UniValue unvResult0(UniValue::VOBJ);
-    UniValue unvResult1(UniValue::VARR);
-    UniValue unvResult2(UniValue::VARR);
-
-    // Asset filelength
-    int intFileLength;
-
-    // Asset blockheight
-    int intBlockHeight;
-
-    // Asset timestamp (seconds since epoch (first second of 1970))
-    int intTimeStamp;
-
-    // Traverse returned uuids
-    for (auto& strUUID : vctUUIDs) {
+    LogPrint (BCLog::STORAGE, "\n");
+    LogPrint (BCLog::STORAGE, "Elapsed time for getuuids %ld \n", dblElapsedTime);
+    LogPrint (BCLog::STORAGE, "\n");
 
-        // Traverse filelength map
-        for (const auto& m : gmapFileLength) {
-
-            // If match
-            if (m.first == strUUID) {
-
-                // Get filkelength
-                intFileLength = m.second;
-
-            // End if match
-            }
-
-        // End traverse filelength map
-        }
-
-        // Traverse blockheight map
-        for (const auto& m : gmapBlockHeight) {
-
-            // If match
-            if (m.first == strUUID) {
-
-                // Get blockheight
-                intBlockHeight = m.second;
-
-            // End if map
-            }
-
-        // End traverse blockheight map
-        }
-
-        // Traverse timestamp map
-        for (const auto& m : gmapTimeStamp) {
-
-            // If match
-            if (m.first == strUUID) {
-
-                // Get timestamp
-                intTimeStamp = m.second;
-
-            // End if match
-            }
-
-        // End traverse timestamp map
-        }
+    // Describe an asset
+    const auto asset_to_json = [](const StorageAssetInfo& asset) {
 
         // Convert to time_t
-        time_t tmtEpochTime = intTimeStamp;
+        time_t tmtEpochTime = asset.header.time;
 
         // Convert to local time
         tm* timLocalTime = localtime(&tmtEpochTime);
@@ -342,20 +732,54 @@ static RPCHelpMan list()
         // Convert to string
         std::string strFormattedLocalTime(chrFormattedLocalTime);
 
-        // Pack results
-        unvResult0.pushKV("uuid", strUUID);
-        unvResult0.pushKV("length", intFileLength);
-        unvResult0.pushKV("height", intBlockHeight);
+        // Pack results, assets still in the mempool list at height -1
+        UniValue unvResult0(UniValue::VOBJ);
+        unvResult0.pushKV("uuid", asset.uuid);
+        unvResult0.pushKV("length", asset.GetFileLength());
+        unvResult0.pushKV("height", asset.header.height == STORAGE_MEMPOOL_HEIGHT ? -1 : asset.header.height);
         unvResult0.pushKV("timestamp", strFormattedLocalTime);
+        return unvResult0;
+    };
+
+    // Cursor of the following page, if more assets remain
+    UniValue unvNext(UniValue::VOBJ);
+    if (optNext) {
+        unvNext.pushKV("next_cursor", optNext->ToString());
+    }
+
+    // An unpaged listing can be long, stream it if the transport can
+    if (JSONWriter* writer{query.count <= 0 ? request.StreamResult() : nullptr}) {
+        writer->BeginArray();
+        writer->BeginArray();
+        for (const auto& asset : vctAssets) {
+            writer->Value(asset_to_json(asset));
+        }
+        writer->EndArray();
+        if (optNext) writer->Value(unvNext);
+        writer->EndArray();
+        return NullUniValue;
+    }
+
+    // Output data structures
+    UniValue unvResult1(UniValue::VARR);
+    UniValue unvResult2(UniValue::VARR);
+
+    // Traverse returned assets
+    for (const auto& asset : vctAssets) {
 
         // Pack results
-        unvResult1.push_back (unvResult0);
+        unvResult1.push_back (asset_to_json(asset));
 
     }
 
     // Pack results
     unvResult2.push_back (unvResult1);
 
+    // If more assets remain, pack the cursor of the following page
+    if (optNext) {
+        unvResult2.push_back (unvNext);
+    }
+
     // Return results
     return unvResult2;
 
@@ -393,12 +817,10 @@ static RPCHelpMan status()
         ret.push_back(std::string("WORKER_ERROR"));
     }
 
-    // job list
-    int total_jobs = workQueueResult.size();
-    int start_jobs = total_jobs - 15;
-    if (start_jobs < 0) start_jobs = 0;
-    for (int i=start_jobs; i<total_jobs; i++) {
-        std::string job_result = workQueueResult[i].first + ", " + workQueueResult[i].second;
+    // job list, with progress of running jobs
+    std::vector<std::string> jobs;
+    get_storage_job_status(jobs, 15);
+    for (const auto& job_result : jobs) {
         ret.push_back(job_result);
     }
 
@@ -411,14 +833,19 @@ static RPCHelpMan tenants()
 {
     return RPCHelpMan{"tenants",
                 "\nDisplay the users present in the authlist (the user's hash160).\n",
-                {},
                 {
-                    RPCResult{
+                    {"height", RPCArg::Type::NUM, RPCArg::DefaultHint{"the current authlist"}, "Display the users present once the block at this height was connected, from the authlist history."},
+                },
+                {
+                    RPCResult{"on success",
                         RPCResult::Type::ARR, "", "",
                         {{RPCResult::Type::STR_HEX, "", "The hash160 of the users authentication key."}}},
+                    RPCResult{"on failure",
+                        RPCResult::Type::STR, "", "failure reason"},
                 },
                 RPCExamples{
                     HelpExampleCli("tenants", "")
+            + HelpExampleCli("tenants", "10000")
             + HelpExampleRpc("tenants", "")
                 },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
@@ -426,7 +853,14 @@ static RPCHelpMan tenants()
     UniValue ret(UniValue::VARR);
 
     std::vector<uint160> tempList;
-    copy_auth_list(tempList);
+    if (!request.params[0].isNull()) {
+        const int height{request.params[0].getInt<int>()};
+        if (height < 0 || !g_auth_list_sync || !g_auth_list_sync->FindMembers(height, tempList)) {
+            return std::string("height-out-of-range");
+        }
+    } else {
+        copy_auth_list(tempList);
+    }
     for (auto& l : tempList) {
         ret.push_back(l.ToString());
     }
@@ -436,6 +870,215 @@ static RPCHelpMan tenants()
     };
 }
 
+static RPCHelpMan tenantusage()
+{
+    return RPCHelpMan{"tenantusage",
+                "\nDisplay what the confirmed files of a tenant take up. Requires -storageindex.\n",
+                {
+                    {"tenant", RPCArg::Type::STR_HEX, RPCArg::DefaultHint{"the authenticated tenant"}, "The hash160 of the tenant's authentication key."},
+                },
+                {
+                    RPCResult{"on success",
+                        RPCResult::Type::OBJ, "", "", {
+                        {RPCResult::Type::STR_HEX, "tenant", "The hash160 of the tenant's authentication key"},
+                        {RPCResult::Type::NUM, "assets", "Number of files whose header chunk is confirmed"},
+                        {RPCResult::Type::NUM, "bytes", "Bytes of the confirmed data chunks, as stored (compressed files count compressed)"},
+                        {RPCResult::Type::STR_AMOUNT, "fees", "Fees paid by the confirmed transactions holding the chunks, in " + CURRENCY_UNIT},
+                    }},
+                    RPCResult{"on failure",
+                        RPCResult::Type::STR, "", "failure reason"},
+                },
+                RPCExamples{
+                    HelpExampleCli("tenantusage", "00112233445566778899aabbccddeeff00112233")
+            + HelpExampleRpc("tenantusage", "00112233445566778899aabbccddeeff00112233")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if (!g_storage_index) {
+        return std::string("storageindex-required");
+    }
+
+    uint160 tenant = authUser;
+    if (!request.params[0].isNull()) {
+        std::string hash160 = request.params[0].get_str();
+        if (hash160.size() != OPAUTH_HASHLEN*2 || !IsHex(hash160)) {
+            return std::string("hash160-wrong-size");
+        }
+        tenant = uint160S(hash160);
+    } else if (tenant.IsNull()) {
+        return std::string("Please authenticate to use this command.");
+    }
+
+    g_storage_index->BlockUntilSyncedToCurrentChain();
+    StorageUsage usage;
+    g_storage_index->FindTenantUsage(tenant, usage);
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("tenant", tenant.ToString());
+    ret.pushKV("assets", usage.assets);
+    ret.pushKV("bytes", usage.bytes);
+    ret.pushKV("fees", ValueFromAmount(usage.fees));
+    return ret;
+},
+    };
+}
+
+static UniValue TimingStatsToJSON(const StorageTimingStats& stats)
+{
+    UniValue windows(UniValue::VARR);
+    for (const StorageTimingWindow& window : stats.windows) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("span", count_seconds(window.span));
+        entry.pushKV("count", uint64_t(window.count));
+        entry.pushKV("average_ms", window.average_ms);
+        entry.pushKV("max_ms", window.max_ms);
+        windows.push_back(std::move(entry));
+    }
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("total", stats.total);
+    ret.pushKV("windows", std::move(windows));
+    return ret;
+}
+
+static UniValue IndexRangeToJSON(const BaseIndex& index, int start_height)
+{
+    const IndexSummary summary{index.GetSummary()};
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("synced", summary.synced);
+    ret.pushKV("start_height", start_height);
+    ret.pushKV("best_block_height", summary.best_block_height);
+    ret.pushKV("disk_size", uint64_t(index.EstimateDiskSize()));
+    return ret;
+}
+
+static RPCHelpMan getstoragestats()
+{
+    const std::vector<RPCResult> timing_result{
+        {RPCResult::Type::NUM, "total", "Number recorded since startup"},
+        {RPCResult::Type::ARR, "windows", "The most recent ones kept, over the last 5 minutes, hour and day", {
+            {RPCResult::Type::OBJ, "", "", {
+                {RPCResult::Type::NUM, "span", "Seconds the window reaches back"},
+                {RPCResult::Type::NUM, "count", "Number within the window"},
+                {RPCResult::Type::NUM, "average_ms", "Average duration in milliseconds"},
+                {RPCResult::Type::NUM, "max_ms", "Longest duration in milliseconds"},
+            }},
+        }},
+    };
+    const std::vector<RPCResult> index_result{
+        {RPCResult::Type::BOOL, "synced", "Whether the index follows the tip"},
+        {RPCResult::Type::NUM, "start_height", "Height of the first block the index holds storage data of"},
+        {RPCResult::Type::NUM, "best_block_height", "Height of the last block indexed"},
+        {RPCResult::Type::NUM, "disk_size", "Estimated bytes of its database on disk"},
+    };
+    return RPCHelpMan{"getstoragestats",
+                "\nReport how much the storage subsystem holds and how fast it serves, to plan capacity.\n"
+                "Counting the assets and chunks walks the storage index.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "", {
+                    {RPCResult::Type::NUM, "assets", /*optional=*/true, "Confirmed files, with -storageindex"},
+                    {RPCResult::Type::NUM, "chunks", /*optional=*/true, "Confirmed data chunks, with -storageindex"},
+                    {RPCResult::Type::NUM, "tenants", /*optional=*/true, "Tenants with confirmed files, with -storageindex"},
+                    {RPCResult::Type::NUM, "bytes", /*optional=*/true, "Bytes of the confirmed files of those tenants, as stored, with -storageindex"},
+                    {RPCResult::Type::STR_AMOUNT, "fees", /*optional=*/true, "Fees paid for them, in " + CURRENCY_UNIT + ", with -storageindex"},
+                    {RPCResult::Type::OBJ, "indexes", "The indexes storage operations use, of those enabled", {
+                        {RPCResult::Type::OBJ, "storageindex", /*optional=*/true, "", index_result},
+                        {RPCResult::Type::OBJ, "storagefilterindex", /*optional=*/true, "", index_result},
+                    }},
+                    {RPCResult::Type::OBJ, "latency", "Time taken by operations, waits for a thread excluded", {
+                        {RPCResult::Type::OBJ, "list", "Pages of assets listed, by the list command and list jobs", timing_result},
+                        {RPCResult::Type::OBJ, "fetch", "Fetch jobs, a batch counting as one", timing_result},
+                        {RPCResult::Type::OBJ, "store", "Store jobs, a batch counting as one", timing_result},
+                    }},
+                    {RPCResult::Type::OBJ, "worker", "Storage jobs on the job queue", {
+                        {RPCResult::Type::NUM, "queued", "Jobs waiting for a thread"},
+                        {RPCResult::Type::NUM, "running", "Jobs running"},
+                        {RPCResult::Type::OBJ, "wait", "Time jobs waited for a thread", timing_result},
+                    }},
+                    {RPCResult::Type::OBJ, "cache", "", {
+                        {RPCResult::Type::OBJ, "fetch", /*optional=*/true, "The fetched asset cache, with -storagecache", {
+                            {RPCResult::Type::NUM, "entries", "Assets cached"},
+                            {RPCResult::Type::NUM, "size", "Bytes of the cached files"},
+                            {RPCResult::Type::NUM, "max_size", "Bytes the cache may hold"},
+                            {RPCResult::Type::NUM, "hits", "Fetches served from the cache"},
+                            {RPCResult::Type::NUM, "misses", "Fetches that were not"},
+                            {RPCResult::Type::NUM, "hit_rate", "Share of fetches served from the cache"},
+                        }},
+                        {RPCResult::Type::OBJ, "list", "Listings scanned from the chain, without -storageindex", {
+                            {RPCResult::Type::NUM, "extended", "Scans of the blocks connected since a tenant's listing was cached"},
+                            {RPCResult::Type::NUM, "rescanned", "Scans of every block"},
+                            {RPCResult::Type::NUM, "tenants", "Listings cached"},
+                        }},
+                    }},
+                }},
+                RPCExamples{
+                    HelpExampleCli("getstoragestats", "")
+            + HelpExampleRpc("getstoragestats", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    UniValue ret(UniValue::VOBJ);
+    UniValue indexes(UniValue::VOBJ);
+    const int start_height{int(Params().GetConsensus().nUUIDBlockStart) + 1};
+
+    if (g_storage_index) {
+        g_storage_index->BlockUntilSyncedToCurrentChain();
+        StorageIndexTotals totals;
+        if (g_storage_index->GetTotals(totals)) {
+            ret.pushKV("assets", totals.assets);
+            ret.pushKV("chunks", totals.chunks);
+            ret.pushKV("tenants", totals.tenants);
+            ret.pushKV("bytes", totals.bytes);
+            ret.pushKV("fees", ValueFromAmount(totals.fees));
+        }
+        indexes.pushKV("storageindex", IndexRangeToJSON(*g_storage_index, start_height));
+    }
+    if (const BlockFilterIndex* filter_index{GetBlockFilterIndex(BlockFilterType::STORAGE)}) {
+        indexes.pushKV("storagefilterindex", IndexRangeToJSON(*filter_index, start_height));
+    }
+    ret.pushKV("indexes", std::move(indexes));
+
+    UniValue latency(UniValue::VOBJ);
+    for (const StorageOp op : {StorageOp::LIST, StorageOp::FETCH, StorageOp::STORE}) {
+        latency.pushKV(StorageOpName(op), TimingStatsToJSON(GetStorageOpStats(op)));
+    }
+    ret.pushKV("latency", std::move(latency));
+
+    size_t queued, running;
+    get_storage_job_counts(queued, running);
+    UniValue worker(UniValue::VOBJ);
+    worker.pushKV("queued", uint64_t(queued));
+    worker.pushKV("running", uint64_t(running));
+    worker.pushKV("wait", TimingStatsToJSON(GetStorageJobWaitStats()));
+    ret.pushKV("worker", std::move(worker));
+
+    UniValue cache(UniValue::VOBJ);
+    if (g_storage_cache) {
+        const StorageCache::Stats stats{g_storage_cache->GetStats()};
+        UniValue fetch(UniValue::VOBJ);
+        fetch.pushKV("entries", uint64_t(stats.entries));
+        fetch.pushKV("size", stats.size);
+        fetch.pushKV("max_size", stats.max_size);
+        fetch.pushKV("hits", stats.hits);
+        fetch.pushKV("misses", stats.misses);
+        fetch.pushKV("hit_rate", stats.hits + stats.misses > 0 ? double(stats.hits) / (stats.hits + stats.misses) : 0.0);
+        cache.pushKV("fetch", std::move(fetch));
+    }
+    uint64_t extended, rescanned;
+    size_t tenants;
+    get_list_cache_stats(extended, rescanned, tenants);
+    UniValue list(UniValue::VOBJ);
+    list.pushKV("extended", extended);
+    list.pushKV("rescanned", rescanned);
+    list.pushKV("tenants", uint64_t(tenants));
+    cache.pushKV("list", std::move(list));
+    ret.pushKV("cache", std::move(cache));
+
+    return ret;
+},
+    };
+}
+
 static RPCHelpMan auth()
 {
     return RPCHelpMan{"auth",
@@ -529,8 +1172,8 @@ static RPCHelpMan allow()
         type = 0;
         time = TicksSinceEpoch<std::chrono::seconds>(GetAdjustedTime());
 
-        LogPrint (BCLog::ALL, "\n");
-        LogPrint (BCLog::ALL, "time in seconds since the first second of 1970 (3600*24*365*54 ..): %d\n", time);
+        LogPrint (BCLog::STORAGE, "\n");
+        LogPrint (BCLog::STORAGE, "time in seconds since the first second of 1970 (3600*24*365*54 ..): %d\n", time);
 
         if (!generate_auth_payload(opreturn_payload, type, time, hash160)) {
             return std::string("error-generating-authpayload");
@@ -615,10 +1258,17 @@ void RegisterStorageRPCCommands(CRPCTable& t)
 {
     static const CRPCCommand commands[]{
         {"storage", &store},
+        {"storage", &storebatch},
         {"storage", &fetch},
+        {"storage", &fetchbatch},
+        {"storage", &fetchrange},
+        {"storage", &fetchproof},
+        {"storage", &getblockstoragechunks},
         {"storage", &list},
         {"storage", &status},
         {"storage", &tenants},
+        {"storage", &tenantusage},
+        {"storage", &getstoragestats},
         {"storage", &auth},
         {"storage", &allow},
         {"storage", &deny},
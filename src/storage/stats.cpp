@@ -0,0 +1,87 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <storage/stats.h>
+
+#include <sync.h>
+#include <util/time.h>
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+
+namespace {
+/** The most recent durations of one kind, each with when it was recorded */
+struct TimingSamples {
+    std::deque<std::pair<SteadyClock::time_point, SteadyClock::duration>> samples;
+    uint64_t total{0};
+
+    void Add(SteadyClock::duration time)
+    {
+        samples.emplace_back(SteadyClock::now(), time);
+        if (samples.size() > MAX_STORAGE_STATS_SAMPLES) samples.pop_front();
+        ++total;
+    }
+
+    StorageTimingStats Get() const
+    {
+        StorageTimingStats stats;
+        stats.total = total;
+        const auto now{SteadyClock::now()};
+        for (const auto span : STORAGE_STATS_WINDOWS) {
+            StorageTimingWindow window;
+            window.span = span;
+            double sum_ms{0};
+            // Newest last, so the window ends at the first sample older than its span
+            for (auto it = samples.rbegin(); it != samples.rend() && now - it->first <= span; ++it) {
+                const double ms{Ticks<MillisecondsDouble>(it->second)};
+                sum_ms += ms;
+                window.max_ms = std::max(window.max_ms, ms);
+                ++window.count;
+            }
+            if (window.count > 0) window.average_ms = sum_ms / window.count;
+            stats.windows.push_back(window);
+        }
+        return stats;
+    }
+};
+} // namespace
+
+static GlobalMutex g_storage_stats_mutex;
+static std::array<TimingSamples, NUM_STORAGE_OPS> g_storage_op_times GUARDED_BY(g_storage_stats_mutex);
+static TimingSamples g_storage_job_waits GUARDED_BY(g_storage_stats_mutex);
+
+std::string StorageOpName(StorageOp op)
+{
+    switch (op) {
+    case StorageOp::LIST: return "list";
+    case StorageOp::FETCH: return "fetch";
+    case StorageOp::STORE: return "store";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+void RecordStorageOp(StorageOp op, SteadyClock::duration time)
+{
+    LOCK(g_storage_stats_mutex);
+    g_storage_op_times.at(size_t(op)).Add(time);
+}
+
+void RecordStorageJobWait(SteadyClock::duration wait)
+{
+    LOCK(g_storage_stats_mutex);
+    g_storage_job_waits.Add(wait);
+}
+
+StorageTimingStats GetStorageOpStats(StorageOp op)
+{
+    LOCK(g_storage_stats_mutex);
+    return g_storage_op_times.at(size_t(op)).Get();
+}
+
+StorageTimingStats GetStorageJobWaitStats()
+{
+    LOCK(g_storage_stats_mutex);
+    return g_storage_job_waits.Get();
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_STORAGE_STATS_H
+#define BITCOIN_STORAGE_STATS_H
+
+#include <util/time.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** Storage operations whose latency getstoragestats reports */
+enum class StorageOp {
+    LIST,
+    FETCH,
+    STORE,
+};
+static constexpr size_t NUM_STORAGE_OPS{3};
+
+std::string StorageOpName(StorageOp op);
+
+//! Most recent samples kept of each operation, and of the waits of storage jobs
+static constexpr size_t MAX_STORAGE_STATS_SAMPLES{1000};
+//! Spans back from now the samples are summed up over
+static constexpr std::array<std::chrono::seconds, 3> STORAGE_STATS_WINDOWS{std::chrono::minutes{5}, std::chrono::hours{1}, std::chrono::hours{24}};
+
+/** Durations sampled within one window */
+struct StorageTimingWindow {
+    std::chrono::seconds span{0};
+    //! Samples within the window, of the most recent ones kept
+    size_t count{0};
+    double average_ms{0};
+    double max_ms{0};
+};
+
+/** Durations of one kind, over each of STORAGE_STATS_WINDOWS */
+struct StorageTimingStats {
+    //! Recorded since startup, including those no longer kept
+    uint64_t total{0};
+    std::vector<StorageTimingWindow> windows;
+};
+
+/** Record how long a list scan, a fetch job or a store job took, waits for a thread excluded */
+void RecordStorageOp(StorageOp op, SteadyClock::duration time);
+
+/** Record how long a storage job waited for a thread of the job queue */
+void RecordStorageJobWait(SteadyClock::duration wait);
+
+StorageTimingStats GetStorageOpStats(StorageOp op);
+StorageTimingStats GetStorageJobWaitStats();
+
+#endif // BITCOIN_STORAGE_STATS_H
@@ -4,15 +4,24 @@
 
 // #define TIMING 1
 
+#include <algorithm>
 #include <map>
+#include <optional>
 
 #include <time.h>
 
 #include "util.h"
 
+#include <consensus/merkle.h>
+#include <hash.h>
+#include <index/blockfilterindex.h>
+#include <index/storageindex.h>
 #include <logging.h>
+#include <node/blockreader.h>
+#include <node/blockstorage.h>
 #include <key_io.h>
 #include <opfile/src/chunk.h>
+#include <opfile/src/compress.h>
 #include <opfile/src/decode.h>
 #include <opfile/src/protocol.h>
 #include <pos/minter.h>
@@ -21,8 +30,13 @@
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
+#include <storage/auth.h>
+#include <storage/authsync.h>
 #include <storage/util.h>
 #include <sync.h>
+#include <util/hasher.h>
+#include <util/strencodings.h>
+#include <util/trace.h>
 #include <validation.h>
 
 #include <wallet/rpc/util.h>
@@ -36,6 +50,10 @@
 #include <wallet/transaction.h>
 #include <wallet/wallet.h>
 #include <storage/chunk.h>
+#include <storage/funding.h>
+#include <storage/stats.h>
+#include <storage/storage.h>
+#include <storage/worker.h>
 
 #include <vector>
 
@@ -47,326 +65,358 @@ uint160 ghshAuthenticatetenantPubkey;
 
 // Currently authenticated user
 extern uint160 authUser;
+extern std::string authUserKey;
 
-// Asset filelength
-std::map<std::string, int> gmapFileLength;
-
-// Asset blockheight 
-std::map<std::string, int> gmapBlockHeight;
-
-// Asset timestamp (seconds since 1970)
-std::map<std::string, int> gmapTimeStamp;
-
-// Scan blockchain for unique uuids
-bool scan_blocks_for_uuids(ChainstateManager& chainman, std::vector<std::string>& pvctUUIDs, int pintCount) {
-
-    // Current chunklength
-    std::string strChunkLength;
-
-    int intChunkLength;
-
-    // Total number of asset chunks
-    std::string strChunkTotal;
-
-    int intChunkTotal;
-
-    // Current chunknumber
-    std::string strChunkNumber;
-
-    // 0 - authenticated user is manager, 1 - authenticated user is tenant
-    int intIsTenant = 0;
-
-    // OP_RETURN output
-    std::string strOpreturnOutput;
-
-    // Unused
-    std::string chunk;
-
-    // Current asset uuid
-    std::string strUUID;
-
-    // If authenticatedc user is not manager
-    // if (authUser.ToString() != "2eba8c3d9038b739d4b2a85fa40eb91648ee2366") {
-    // if (authUser.ToString() != "ee78c09ab25ea0f5df7112968ce6592019dd9401") {
-    // if (authUser.ToString() != "1c04e67bf21dc44abe42e84a5ef3bce31b77aa6d") {
-    if (authUser.ToString() != Params().GetConsensus().initAuthUser.ToString()) {
-
-        // Set is tenant
-        intIsTenant = 1;
+// Blocks below the tip down to the storage start, newest first. Walked from the
+// published tip snapshot, so the scan neither takes cs_main nor races a reorg
+static std::vector<const CBlockIndex*> blocks_to_scan(const ChainstateManager& chainman)
+{
+    std::vector<const CBlockIndex*> vctBlocks;
+    const auto snapshot{chainman.GetTipSnapshot()};
+    if (!snapshot) return vctBlocks;
 
-    // End if authenticatedc user is not manager
+    const long lngCutoff = Params().GetConsensus().nUUIDBlockStart;
+    for (const CBlockIndex* pindex = snapshot->tip->pprev; pindex && pindex->nHeight > lngCutoff; pindex = pindex->pprev) {
+        vctBlocks.push_back(pindex);
     }
+    return vctBlocks;
+}
 
-    // Total number of unique uuids found so far
-    int intUUIDCount = 0;
-
-    // clock_t start, end;
-    // double time_taken = 0.0;
-
-    // Empty vector of uuids
-    pvctUUIDs.clear();
-
-    // Active blockchain
-    const CChain& active_chain = chainman.ActiveChain();
-
-    // Get tipheight
-    const int tip_height = active_chain.Height();
-
-    // Current block
-    CBlock block{};
-
-    // Initialize index
-    CBlockIndex* pindex = nullptr;
-
-    long lngCutoff = Params().GetConsensus().nUUIDBlockStart;
+// Blocks among those to scan, newest first, whose storage filter may hold one of the elements.
+// Returns false, leaving them all, without a storage filter index caught up with them
+static bool filter_blocks(std::vector<const CBlockIndex*>& vctBlocks, const GCSFilter::ElementSet& elements)
+{
+    const BlockFilterIndex* index{GetBlockFilterIndex(BlockFilterType::STORAGE)};
+    if (!index) return false;
+
+    // Filters are read a batch of heights at a time, oldest first
+    static constexpr size_t FILTER_BATCH{1000};
+    std::vector<const CBlockIndex*> vctMatches;
+    std::vector<BlockFilter> filters;
+    for (size_t begin = 0; begin < vctBlocks.size(); begin += FILTER_BATCH) {
+        const size_t end{std::min(vctBlocks.size(), begin + FILTER_BATCH)};
+        if (!index->LookupFilterRange(vctBlocks[end - 1]->nHeight, vctBlocks[begin], filters) || filters.size() != end - begin) {
+            return false;
+        }
+        for (size_t i = begin; i < end; ++i) {
+            if (filters[end - 1 - i].GetFilter().MatchAny(elements)) vctMatches.push_back(vctBlocks[i]);
+        }
+    }
+    vctBlocks = std::move(vctMatches);
+    return true;
+}
 
-    // Skip POW blocks in reverse
-    // for (int height = (tip_height - 1); height > 6000; height--) {
-    for (int height = (tip_height - 1); height > lngCutoff; height--) {
-    
-        // Convert block number to index
-        pindex = active_chain[height];
+// Whether tenant was on the authlist at height, from the authlist history rather than the blocks.
+// Nothing while the history has not reached that height
+static std::optional<bool> tenant_authorized_at(const uint160& tenant, int height)
+{
+    bool member;
+    if (!g_auth_list_sync || !g_auth_list_sync->FindMembership(tenant, height, member)) return std::nullopt;
+    return member;
+}
 
-        // Get block
-        if (!ReadBlockFromDisk(block, pindex, chainman.GetConsensus())) {
+// Only the header chunk contains the authenticated tenant at storeasset time, and only the final
+// data chunk contains the filelength (indirectly). There is no guarantee about where in the
+// blockchain one is in relation to the other, so both are collected from the blocks, newest first,
+// for the headers of tenant (or of all tenants) and the lengths of every asset, to be paired up
+// afterwards. The oldest header and length of an asset win
+static bool scan_blocks_for_asset_records(ChainstateManager& chainman, const std::vector<const CBlockIndex*>& vctBlocks, const std::optional<uint160>& tenant,
+                                          std::map<uint256, StorageHeaderRecord>& mapHeaders, std::map<uint256, StorageLengthRecord>& mapLengths)
+{
+    // Header chunks in scan order, waiting for their tenant
+    struct pending_header {
+        uint256 key;
+        StorageHeaderRecord header;
+        signed_hash signed_header;
+        std::optional<StorageLengthRecord> length;
+    };
+    std::vector<pending_header> vctPending;
+
+    // Blocks are read ahead on the block reader threads, and processed here in reverse height order.
+    // Transactions are only looked at in place in the raw blocks, not deserialized
+    if (!ReadBlockViewsInOrder(vctBlocks, chainman.GetParams().MessageStart(), [&](const CBlockIndex& index, const CBlockHeader& block, const std::vector<CTransactionView>& txs) {
+
+        // Stop early when run as a job that is cancelled
+        if (job_cancel_requested()) {
             return false;
         }
 
         // Traverse transactions
-        for (unsigned int vtx = 0; vtx < block.vtx.size(); vtx++) {
+        for (const CTransactionView& tx : txs) {
 
             // Skip irrelevant transactions
-            if (block.vtx[vtx]->IsCoinBase() || block.vtx[vtx]->IsCoinStake()) {
+            if (tx.IsCoinBase() || tx.IsCoinStake()) {
                 continue;
             }
 
             // Traverse outputs
-            for (unsigned int vout = 0; vout < block.vtx[vtx]->vout.size(); vout++) {
-
-                // If OP_RETURN
-                if (block.vtx[vtx]->vout[vout].scriptPubKey.IsOpReturn()) {
-
-                    // Convert OP_RETURN output to hex string
-                    strOpreturnOutput = HexStr(block.vtx[vtx]->vout[vout].scriptPubKey);
-
-                    // Start timer
-                    // start = clock ();    
-
-                    int intOffset;
-
-                    // Return offset, rather then strip OP_RETURN + metadata
-                    if (!strip_opreturndata_from_chunk (strOpreturnOutput, chunk, intOffset)) {
-
-                        // End timer
-                        // end = clock ();    
-                        // time_taken = time_taken + (double) (end - start) / CLOCKS_PER_SEC;
+            for (const CTxOutView& out : tx.Outputs()) {
 
-                        continue;
-                    }
-
-                    // End timer
-                    // end = clock ();    
-                    // time_taken = time_taken + (double) (end - start) / CLOCKS_PER_SEC;
-
-                    // Error
-                    int intError;
+                // If not OP_RETURN
+                if (!out.IsOpReturn()) {
+                    continue;
+                }
 
-                    // 0 - no extension, 1 - extension
-                    int intExtension;
+                // Error
+                int intError;
 
-                    // Check for chunk data, valid extension flag
-                    if (!check_chunk_contextual (strOpreturnOutput, intExtension, intError, intOffset)) {
+                // Check for chunk data, parse straight from the script without hex conversion
+                chunk_view view;
+                if (!parse_chunk_from_script (out.scriptPubKey, view, intError)) {
+                    continue;
+                }
 
-                        //LogPrintf("%s - failed at check_chunk_contextual\n", __func__);
-                        continue;
+                // Uuid as key
+                const uint256 key{view.uuid};
+
+                // If header chunk
+                if (view.chunklen == 0) {
+
+                    // The tenant is recovered from the signature after the scan, all headers at once
+                    pending_header pending;
+                    pending.key = key;
+                    pending.header.protocol = view.version;
+                    pending.header.height = index.nHeight;
+                    pending.header.time = block.nTime;
+                    get_header_signed_hash (view, pending.signed_header);
+
+                    // Protocol 02 header chunk carries the filelength itself
+                    if (view.chunktotal > 0) {
+                        StorageLengthRecord length;
+                        length.height = index.nHeight;
+                        length.chunk_total = view.chunktotal;
+                        length.final_chunk_len = view.filelen - uint64_t(view.chunktotal - 1) * OPENCODING_COMPACT_CHUNKMAX;
+                        pending.length = length;
                     }
+                    vctPending.push_back(std::move(pending));
 
-                    // Get uuid
-                    get_uuid_from_chunk (strOpreturnOutput, strUUID, intOffset);
-
-                    // Get chunklength
-                    get_chunklen_from_chunk (strOpreturnOutput, strChunkLength, intOffset);
-
-                    // Convert to integer
-                    intChunkLength = std::stoul(strChunkLength, nullptr, 16);
-
-                    // WAhen the header proccessing is complete for entire blockchain, pvctUUIDs will contain 
-                    // the number asked for of uuids associated with authenticated user.
-
-                    // If header chunk
-                    if (intChunkLength == 0) {
-
-                        // Extract authenticated tenant at storeasset time from header chunk
-                        extract_pubkey_from_signature (strOpreturnOutput, intOffset); 
-
-                        // If authenticated user is manager
-                        if (intIsTenant == 0) {
-
-                            // If not all uuids asked for
-                           if (pintCount > 0) {
-
-                                // If less uuids found than asked for
-                                if (intUUIDCount < pintCount) {
-
-                                    // Add blockheight to global map for processing later
-                                    // Key on uuid
-                                    gmapBlockHeight[strUUID] = height;
+                // Else if final data chunk
+                } else if (view.chunknum == view.chunktotal) {
 
-                                    // Add seconds since epoch (first second in 1970) to global map for processing later
-                                    // Key on uuid
-                                    gmapTimeStamp[strUUID] = block.nTime;
+                    // Filelength is (totalchunks - 1) * 512 + finalchunklength
+                    StorageLengthRecord length;
+                    length.height = index.nHeight;
+                    length.chunk_total = view.chunktotal;
+                    length.final_chunk_len = view.chunklen;
+                    mapLengths[key] = length;
 
-                                    // Add uuid to vector of uuids
-                                    pvctUUIDs.push_back(strUUID);
-
-                                    // Increment number of uuids found
-                                    intUUIDCount = intUUIDCount + 1;
-
-                                    // Record uuid to log
-                                    LogPrint (BCLog::ALL, "UUID %s\n", strUUID);
-
-                                // End if less uuids found than asked for
-                                }
-
-                            // Else not not all uuids asked for (all asked for)
-                            } else {
-
-                                // Add blockheight to global map for processing later
-                                // Key on uuid
-                                gmapBlockHeight[strUUID] = height;
-
-                                // Add seconds since epoch (first second in 1970) to global map for processing later
-                                // Key on uuid
-                                gmapTimeStamp[strUUID] = block.nTime;
+                // End if header chunk
+                }
 
-                                // Add uuid to vector of uuids
-                                pvctUUIDs.push_back(strUUID);
+            // End traverse outputs
+            }
 
-                                // Increment number of uuids found
-                                intUUIDCount = intUUIDCount + 1;
+        // End traverse transactions 
+        }
 
-                                // Record uuid to log
-                                LogPrint (BCLog::ALL, "UUID %s\n", strUUID);
+        return true;
 
-                            // End if not all uuids asked for
-                            }
+    // End Skip POW blocks in reverse
+    })) {
+        return false;
+    }
 
-                        // Else not authenticated user is manager
-                        } else {
+    // Extract authenticated tenant at storeasset time from every header chunk in one batch
+    std::vector<signed_hash> vctSigned;
+    vctSigned.reserve(vctPending.size());
+    for (const pending_header& pending : vctPending) {
+        vctSigned.push_back(pending.signed_header);
+    }
+    std::vector<std::optional<uint160>> vctSigners;
+    recover_signers (vctSigned, vctSigners);
 
-                            // If currently authenticated tenant is authenticated tenant at storeasset time
-                            if (authUser.ToString() == ghshAuthenticatetenantPubkey.ToString()) {
-  
-                                // If not all uuids asked for
-                                if (pintCount > 0) {
+    for (size_t i = 0; i < vctPending.size(); ++i) {
 
-                                    // If less uuids found than asked for
-                                    if (intUUIDCount < pintCount) {
+        pending_header& pending = vctPending[i];
 
-                                        // Add blockheight to global map for processing later
-                                        // Key on uuid
-                                        gmapBlockHeight[strUUID] = height;
+        // As the hash160 of the invalid key a failed recovery leaves
+        pending.header.tenant = vctSigners[i] ? *vctSigners[i] : Hash160(CPubKey{});
 
-                                        // Add seconds since epoch (first second in 1970) to global map for processing later
-                                        // Key on uuid
-                                        gmapTimeStamp[strUUID] = block.nTime;
+        // Skip other tenants' assets
+        if (tenant && pending.header.tenant != *tenant) {
+            continue;
+        }
 
-                                        // Add uuid to vector of uuids
-                                        pvctUUIDs.push_back(strUUID);
+        // Scanning in reverse, so the oldest header chunk wins, as in the storage index
+        mapHeaders[pending.key] = pending.header;
 
-                                        // Increment number of uuids found
-                                        intUUIDCount = intUUIDCount + 1;
+        // Unless a final data chunk of an older block already gave the filelength
+        if (pending.length) {
+            auto it = mapLengths.find(pending.key);
+            if (it == mapLengths.end() || it->second.height >= pending.length->height) {
+                mapLengths[pending.key] = *pending.length;
+            }
+        }
+    }
 
-                                        // Record uuid to log
-                                        LogPrint (BCLog::ALL, "UUID %s\n", strUUID);
+    return true;
+}
 
-                                    // End if less uuids found than asked for 
-                                    }
+//! Most tenants whose listing is kept between calls to list, the least recently used making way
+static constexpr size_t MAX_LIST_CACHE_TENANTS{16};
+
+// What the scans for the listing of a tenant found, up to the newest block scanned. As long as that
+// block stays in the active chain, the next call only scans the blocks connected since, and merges
+// what they hold in. The key is the tenant, or zero for the manager, who lists all tenants
+struct list_cache_entry {
+    const CBlockIndex* top{nullptr};
+    std::map<uint256, StorageHeaderRecord> headers;
+    std::map<uint256, StorageLengthRecord> lengths;
+    uint64_t last_used{0};
+};
+static Mutex g_list_cache_mutex;
+static std::map<uint160, list_cache_entry> g_list_cache GUARDED_BY(g_list_cache_mutex);
+static uint64_t g_list_cache_uses GUARDED_BY(g_list_cache_mutex){0};
+//! Scans that extended a cached listing, and those that scanned everything
+static uint64_t g_list_cache_extended GUARDED_BY(g_list_cache_mutex){0};
+static uint64_t g_list_cache_rescanned GUARDED_BY(g_list_cache_mutex){0};
+
+void get_list_cache_stats(uint64_t& extended, uint64_t& rescanned, size_t& tenants)
+{
+    LOCK(g_list_cache_mutex);
+    extended = g_list_cache_extended;
+    rescanned = g_list_cache_rescanned;
+    tenants = g_list_cache.size();
+}
 
-                                // Else not not all uuids asked for (all asked for)
-                                } else {
+static bool scan_blocks_for_assets_page(ChainstateManager& chainman, StorageListQuery query, std::vector<StorageAssetInfo>& assets, std::optional<StorageListCursor>& next);
 
-                                    // Add blockheight to global map for processing later
-                                    // Key on uuid
-                                    gmapBlockHeight[strUUID] = height;
+// Scan blockchain for a page of the authenticated user's assets, timed for getstoragestats
+bool scan_blocks_for_assets(ChainstateManager& chainman, StorageListQuery query, std::vector<StorageAssetInfo>& assets, std::optional<StorageListCursor>& next) {
 
-                                    // Add seconds since epoch (first second in 1970) to global map for processing later
-                                    // Key on uuid
-                                    gmapTimeStamp[strUUID] = block.nTime;
+    const auto start{SteadyClock::now()};
+    const bool found{scan_blocks_for_assets_page(chainman, std::move(query), assets, next)};
+    RecordStorageOp(StorageOp::LIST, SteadyClock::now() - start);
+    return found;
+}
 
-                                    // Add uuid to vector of uuids
-                                    pvctUUIDs.push_back(strUUID);
+static bool scan_blocks_for_assets_page(ChainstateManager& chainman, StorageListQuery query, std::vector<StorageAssetInfo>& assets, std::optional<StorageListCursor>& next) {
 
-                                    // Increment number of uuids found
-                                    intUUIDCount = intUUIDCount + 1;
+    // Nothing found yet
+    assets.clear();
+    next.reset();
 
-                                    // Record uuid to log
-                                    LogPrint (BCLog::ALL, "UUID %s\n", strUUID);
+    // Manager sees every asset, tenant only their own
+    query.tenant.reset();
+    if (authUser.ToString() != Params().GetConsensus().initAuthUser.ToString()) {
+        query.tenant = authUser;
+    }
 
-                                // End if not all uuids asked for 
-                                }
+    // If storage index enabled, answer from the index rather than scanning the blockchain
+    if (g_storage_index) {
 
-                            // End if currently authenticated tenant is authenticated tenant at storeasset time
-                            }
+        g_storage_index->BlockUntilSyncedToCurrentChain();
 
-                        // End if authenticated user is manager
-                        }
+        if (g_storage_index->ListAssets(assets, query, next)) {
+            return true;
+        }
 
-                    // Else not header chunk
-                    } else {
+        // Fall back to scanning the blockchain
+        assets.clear();
+        next.reset();
+    }
 
-                        // When following final chunk filelength processing is complete for entire blockchain, 
-                        // gmapFileLength will contain the filelength of every asset in blockchain.  Later, 
-                        // calling routine will use pvctUUIDs to select filelengths from gmapFileLength, the 
-                        // number of assets asked for, associated with currently authenticated tenent.
+    // Skip POW blocks in reverse
+    std::vector<const CBlockIndex*> vctBlocks{blocks_to_scan(chainman)};
+    const CBlockIndex* pindexTop{vctBlocks.empty() ? nullptr : vctBlocks.front()};
+
+    // Calls for the same listing wait for the one scanning, and then scan nothing more
+    LOCK(g_list_cache_mutex);
+    list_cache_entry& cached = g_list_cache[query.tenant.value_or(uint160{})];
+    cached.last_used = ++g_list_cache_uses;
+
+    // Blocks connected since the listing was cached, newest first. After a reorg off the newest
+    // block scanned, everything is scanned again
+    const bool incremental{cached.top && pindexTop && pindexTop->GetAncestor(cached.top->nHeight) == cached.top};
+    if (incremental) {
+        vctBlocks.erase(std::find(vctBlocks.begin(), vctBlocks.end(), cached.top), vctBlocks.end());
+        ++g_list_cache_extended;
+    } else {
+        ++g_list_cache_rescanned;
+    }
+    LogPrint (BCLog::STORAGE, "list scans %d blocks%s\n", vctBlocks.size(), incremental ? ", the rest of the listing is cached" : "");
 
-                        // The processing rolls this way because only the header chunk contains the 
-                        // authenticated tenant at storeasset time, therefore the header chunk is where 
-                        // we constrain the uuids returned to the uuids associated with the 
-                        // currently authenticated user.  The final data chunk is where the filelength 
-                        // lives (indirectly), and there is no guarantee about where in the blockchain the 
-                        // header chunk is in relation to the final data chunk for a given asset. 
+    std::map<uint256, StorageHeaderRecord> mapNewHeaders;
+    std::map<uint256, StorageLengthRecord> mapNewLengths;
+    if (!scan_blocks_for_asset_records(chainman, vctBlocks, query.tenant, mapNewHeaders, mapNewLengths)) {
+        g_list_cache.erase(query.tenant.value_or(uint160{}));
+        return false;
+    }
 
-                        // Get current data chunk number
-                        get_chunknum_from_chunk (strOpreturnOutput, strChunkNumber, intOffset);
+    // Records of the blocks cached are older, and win over the new ones
+    if (!incremental) {
+        cached.headers.clear();
+        cached.lengths.clear();
+    }
+    cached.headers.merge(mapNewHeaders);
+    cached.lengths.merge(mapNewLengths);
+    cached.top = pindexTop;
+    const std::map<uint256, StorageHeaderRecord>& mapHeaders = cached.headers;
+    const std::map<uint256, StorageLengthRecord>& mapLengths = cached.lengths;
+
+    if (g_list_cache.size() > MAX_LIST_CACHE_TENANTS) {
+        g_list_cache.erase(std::min_element(g_list_cache.begin(), g_list_cache.end(), [](const auto& a, const auto& b) {
+            return a.second.last_used < b.second.last_used;
+        }));
+    }
 
-                        // Get total number of data chunks
-                        get_chunktotal_from_chunk (strOpreturnOutput, strChunkTotal, intOffset);
+    // Pair up headers with final chunks, restricted to the time range and to what follows the cursor
+    for (const auto& [key, header] : mapHeaders) {
 
-                        // If final data chunk
-                        if (strChunkNumber == strChunkTotal) {
+        if (header.time < query.start_time || header.time > query.end_time) {
+            continue;
+        }
+        if (query.cursor && (header.height > query.cursor->height || (header.height == query.cursor->height && key < query.cursor->uuid))) {
+            continue;
+        }
 
-                            // Convert total number of chunks to integer
-                            intChunkTotal = std::stoul(strChunkTotal, nullptr, 16);
+        StorageAssetInfo info;
+        info.uuid = HexStr(key);
+        info.header = header;
+        auto it = mapLengths.find(key);
+        if (it != mapLengths.end()) {
+            info.length = it->second;
+        }
+        assets.push_back(std::move(info));
+    }
 
-                            // Filelength is (totalchunks - 1) * 512 + finalchunklength
-                            int intFileLengthInBytes = (intChunkTotal - 1) * 512 + intChunkLength;
+    // Newest first, then by uuid, as the storage index orders them
+    std::sort(assets.begin(), assets.end(), [](const StorageAssetInfo& a, const StorageAssetInfo& b) {
+        if (a.header.height != b.header.height) {
+            return a.header.height > b.header.height;
+        }
+        return a.uuid < b.uuid;
+    });
 
-                            // Record filelength in global map for processing in calling routine
-                            gmapFileLength[strUUID] = intFileLengthInBytes;
+    // Cut the page, the first asset left out starts the following one
+    if (query.count > 0 && assets.size() > size_t(query.count)) {
+        next = StorageListCursor{assets[query.count].header.height, uint256{ParseHex(assets[query.count].uuid)}};
+        assets.resize(query.count);
+    }
 
-                        // End if final data chunk
-                        }
+    return true;
 
-                    // End if header chunk
-                    }
+// End Scan blockchain for a page of the authenticated user's assets
+}
 
-                    // Unused
-                    if (std::find(pvctUUIDs.begin(), pvctUUIDs.end(), strUUID) != pvctUUIDs.end()) {
-                        continue;
-                    } else {
-                    }
+// Scan blockchain for unique uuids
+bool scan_blocks_for_uuids(ChainstateManager& chainman, std::vector<std::string>& pvctUUIDs, int pintCount) {
 
-                // End if OP_RETURN    
-                }
+    // Empty vector of uuids
+    pvctUUIDs.clear();
 
-            // End traverse outputs
-            }
+    // Number of uuids asked for (0 means all)
+    StorageListQuery query;
+    query.count = pintCount;
 
-        // End traverse transactions 
-        }
+    std::vector<StorageAssetInfo> vctAssets;
+    std::optional<StorageListCursor> optNext;
+    if (!scan_blocks_for_assets(chainman, query, vctAssets, optNext)) {
+        return false;
+    }
 
-    // End Skip POW blocks in reverse
+    for (const auto& asset : vctAssets) {
+        pvctUUIDs.push_back(asset.uuid);
     }
 
     return true;
@@ -375,214 +425,143 @@ bool scan_blocks_for_uuids(ChainstateManager& chainman, std::vector<std::string>
 }
 
 // Extract asset
-bool scan_blocks_for_specific_uuid (ChainstateManager& chainman, std::string& uuid, int& error_level, std::vector<std::string>& chunks, int& pintOffset)
+bool scan_blocks_for_specific_uuid (ChainstateManager& chainman, std::string& uuid, int& error_level, chunk_reassembler& file, int& height)
 {
 
     clock_t start, end;
 
-    double t_hs = 0.0;
-
-    double t_rbfd = 0.0;
-
-    double t_sofc = 0.0;
-
-    double t_ccc = 0.0;
+    double t_pcfs = 0.0;
 
     double t_iva = 0.0;
 
-    double t_gctfc = 0.0;
-
-    double t_gcnfc = 0.0;
-
-    double t_gufc = 0.0;
-
-    double t_gclfc = 0.0;
-
     bool hasauth;
-    chunks.clear();
-    const CChain& active_chain = chainman.ActiveChain();
-    const int tip_height = active_chain.Height();
-
     hasauth = false;
 
     int chunktotal2 = 0;
 
-    int offset;
-
     int count = 0;
 
-    CBlock block{};
-    CBlockIndex* pindex = nullptr;
+    // Highest block holding a chunk of the asset
+    height = -1;
 
-    std::string magic;
-    std::string strProtocol;
-    std::string uuid2;
-    std::string signature;
-    std::string chunklen;
+    // Binary form of the fetchasset uuid, compared against the chunk bytes
+    std::vector<unsigned char> vchUUID = ParseHex(uuid);
 
     int intAllDataChunksFound = 0;
 
     int intAuthenticateTenantPubkeyFound = 0;
 
-    std::string strAuthenticatetenantPubkeyCandidate;
-                        
-    long lngCutoff = Params().GetConsensus().nUUIDBlockStart;
+    // Whether the tenant was on the authlist at the last data chunk, when the authlist history tells
+    std::optional<bool> optTenantAuthorized;
+
+    // Authenticatetenant pubkey at storeasset time, kept per fetch so fetches can run concurrently
+    uint160 hshTenant;
+
+    // Blocks processed, for job progress
+    int intBlocksDone = 0;
 
     // In reverse, skip POW blocks
-    // for (int height = (tip_height - 1); height > 6000; height--) {
-    for (int height = (tip_height - 1); height > lngCutoff; height--) {
+    const std::vector<const CBlockIndex*> vctAllBlocks{blocks_to_scan(chainman)};
+
+    // With the storage filter index, only the blocks that may hold the uuid are read, then
+    // those older than the last data chunk that may add the tenant
+    std::vector<const CBlockIndex*> vctBlocks{vctAllBlocks};
+    bool fFiltered{filter_blocks(vctBlocks, {GCSFilter::Element(vchUUID.begin(), vchUUID.end())})};
+    int intBlocksTotal = vctBlocks.size();
+    if (fFiltered) {
+        LogPrint(BCLog::STORAGE, "Storage filter leaves %d of %d blocks to scan for uuid %s\n", vctBlocks.size(), vctAllBlocks.size(), uuid);
+    }
 
-        pindex = active_chain[height];
+    // Block the last data chunk was found in
+    int intAllDataChunksHeight = -1;
 
-#ifdef TIMING
-    start = clock ();    
-#endif
+    // Blocks are read ahead on the block reader threads, and processed here in reverse height order.
+    // Transactions are only looked at in place in the raw blocks, not deserialized
+    const auto scan_block = [&](const CBlockIndex& index, const CBlockHeader&, const std::vector<CTransactionView>& txs) {
 
-        if (!ReadBlockFromDisk(block, pindex, chainman.GetConsensus())) {
-            return false;
-        }
+        ++intBlocksDone;
+        TRACE4(storage, scan_block,
+            uuid.c_str(),
+            index.nHeight,
+            intBlocksDone,
+            intBlocksTotal);
 
-#ifdef TIMING
-    end = clock ();    
-    t_rbfd = t_rbfd + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
+        if (intBlocksDone % 100 == 0) {
+            set_job_progress(intBlocksDone, intBlocksTotal);
+            if (job_cancel_requested()) {
+                return false;
+            }
+        }
 
         // Traverse transactions
-        for (unsigned int vtx = 0; vtx < block.vtx.size(); vtx++) {
+        for (const CTransactionView& tx : txs) {
 
-            if (block.vtx[vtx]->IsCoinBase() || block.vtx[vtx]->IsCoinStake()) {
+            if (tx.IsCoinBase() || tx.IsCoinStake()) {
                 continue;
             }
 
             // Traverse outputs
-            for (unsigned int vout = 0; vout < block.vtx[vtx]->vout.size(); vout++) {
-
-                // If OP_RETURN
-                if (block.vtx[vtx]->vout[vout].scriptPubKey.IsOpReturn()) {
-
-                    std::string opdata, chunk, this_uuid;
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
-                    opdata = HexStr(block.vtx[vtx]->vout[vout].scriptPubKey);
+            for (const CTxOutView& out : tx.Outputs()) {
 
-#ifdef TIMING
-    end = clock ();    
-    t_hs = t_hs + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
-                    // Return offset, rather then strip OP_RETURN + metadata
-                    if (!strip_opreturndata_from_chunk (opdata, chunk, offset)) {
-                        // LogPrintf ("%s - failed at strip_opreturndata_from_chunk\n", __func__);
-                        continue;
-                    }    
-
-#ifdef TIMING
-    end = clock ();    
-    t_sofc = t_sofc + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
-                    int protocol;
-                    
-#ifdef TIMING
-    start = clock ();    
-#endif
-
-if (intAllDataChunksFound == 1) {
-
-    get_magic_from_chunk (opdata, magic, offset);
-
-    if (magic == OPAUTH_MAGIC) {
-
-        // LogPrint (BCLog::ALL, "MAGIC\n");
-
-        // LogPrint (BCLog::ALL, "ghshAuthenticatetenantPubkey %s \n", ghshAuthenticatetenantPubkey.ToString());
-
-        get_hash_from_auth (opdata, strAuthenticatetenantPubkeyCandidate, offset);
-
-        // LogPrint (BCLog::ALL, "strAuthenticatetenantPubkeyCandidate %s \n", strAuthenticatetenantPubkeyCandidate);
+                const Span<const unsigned char> script{out.scriptPubKey};
 
-        std::string operation;
-
-        get_operation_from_auth (opdata, operation, offset);
-
-        if (operation == OPAUTH_ADDUSER) {
+                // If OP_RETURN
+                if (out.IsOpReturn()) {
 
-            if (ghshAuthenticatetenantPubkey.ToString() == strAuthenticatetenantPubkeyCandidate) {
+                    // Once all data chunks are found, only authdata is of interest
+                    if (intAllDataChunksFound == 1) {
 
-                intAuthenticateTenantPubkeyFound = 1;
-                // height = 6000;
-                height = lngCutoff;
-                LogPrint (BCLog::ALL, "authenticatetenant pubkey found \n");
+                        auth_view auth;
 
-            }
+                        if (!parse_auth_from_script (script, auth)) {
+                            continue;
+                        }
 
-        }    
+                        if (auth.operation == OPAUTH_ADDUSER_BIN) {
 
-    } else {
+                            if (hshTenant == get_hash160_from_auth (auth)) {
 
-        continue;
+                                // Stop reading blocks once this block is done
+                                intAuthenticateTenantPubkeyFound = 1;
+                                LogPrintEvery(BCLog::STORAGE, LOG_EVERY_DEFAULT, "authenticatetenant pubkey found \n");
 
-    }
+                            }
 
-}    
+                        }
 
-                    // Check for chunk data, check for valid protocal, return protocol
-                    if (!check_chunk_contextual (opdata, protocol, error_level, offset)) {
-                        // LogPrintf ("%s - failed at check_chunk_contextual. error_level %d\n", __func__, error_level);
                         continue;
-                    }
 
-#ifdef TIMING
-    end = clock ();    
-    t_ccc = t_ccc + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
+                    }
 
 #ifdef TIMING
     start = clock ();    
 #endif
 
-                    // Extract UUID
-                    get_uuid_from_chunk (opdata, this_uuid, offset);
+                    // Check for chunk data, check for valid protocol, parse straight from the script
+                    chunk_view view;
+                    if (!parse_chunk_from_script (script, view, error_level)) {
+                        continue;
+                    }
 
 #ifdef TIMING
     end = clock ();    
-    t_gufc = t_gufc + (double) (end - start) / CLOCKS_PER_SEC;
+    t_pcfs = t_pcfs + (double) (end - start) / CLOCKS_PER_SEC;
 #endif
 
                     // If chunk UUID equals fetchasset UUID
-                    if (uuid == this_uuid) {
-
-                        int chunklen2;
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
-                        get_chunklen_from_chunk (opdata, chunklen, offset);
-
-                        chunklen2 = std::stoul(chunklen, nullptr, 16);
+                    if (std::equal(vchUUID.begin(), vchUUID.end(), view.uuid.begin(), view.uuid.end())) {
 
-#ifdef TIMING
-    end = clock ();    
-    t_gclfc = t_gclfc + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
+                        height = std::max(height, index.nHeight);
 
-                        if (chunklen2 == 0) {
+                        if (view.chunklen == 0) {
 
 #ifdef TIMING
     start = clock ();    
 #endif
 
-                            if (!is_valid_authchunk (opdata, error_level, offset)) {
+                            if (!is_valid_authchunk (view, error_level, hshTenant)) {
 
-                                LogPrint (BCLog::ALL, "error_level from is_valid_authchunk %d\n", error_level);
+                                LogPrintEvery(BCLog::STORAGE, LOG_EVERY_DEFAULT, "error_level from is_valid_authchunk %d\n", error_level);
                                 continue;
                             }
 
@@ -591,139 +570,811 @@ if (intAllDataChunksFound == 1) {
     t_iva = t_iva + (double) (end - start) / CLOCKS_PER_SEC;
 #endif
 
-                            get_magic_from_chunk (opdata, magic, offset);
-                            get_version_from_chunk (opdata, strProtocol, offset);
-                            get_uuid_from_chunk (opdata, uuid2, offset);
-                            get_chunklen_from_chunk (opdata, chunklen, offset);
-                            get_signature_from_chunk (opdata, signature, offset);
-
-                            LogPrint (BCLog::ALL, "Found valid header chunk for UUID: %s\n", this_uuid);
-                            LogPrint (BCLog::ALL, "\n");
-                            LogPrint (BCLog::ALL, "Header Chunk Magic: %s\n", magic);
-                            LogPrint (BCLog::ALL, "Header Chunk Protocol: %s\n", strProtocol);
-                            LogPrint (BCLog::ALL, "Header Chunk UUID: %s\n", uuid2);
-                            LogPrint (BCLog::ALL, "Header Chunk Length: %s\n", chunklen);
-                            LogPrint (BCLog::ALL, "Header Chunk Signature: %s\n", signature);
-                            LogPrint (BCLog::ALL, "\n");
+                            LogPrint (BCLog::STORAGE, "Found valid header chunk for UUID: %s\n", uuid);
+                            LogPrint (BCLog::STORAGE, "\n");
+                            LogPrint (BCLog::STORAGE, "Header Chunk Magic: %s\n", OPENCODING_MAGIC);
+                            LogPrint (BCLog::STORAGE, "Header Chunk Protocol: %02x\n", view.version);
+                            LogPrint (BCLog::STORAGE, "Header Chunk UUID: %s\n", HexStr(view.uuid));
+                            LogPrint (BCLog::STORAGE, "Header Chunk Length: %04x\n", view.chunklen);
+                            LogPrint (BCLog::STORAGE, "Header Chunk Signature: %s\n", HexStr(view.signature));
+                            LogPrint (BCLog::STORAGE, "\n");
 
                             hasauth = true;
-                            continue;
                         } else {
                             count++;
                         }
 
-                        pintOffset = offset;
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
-                        std::string chunktotal;
-                        get_chunktotal_from_chunk (opdata, chunktotal, offset);
-                        chunktotal2 = std::stoul(chunktotal, nullptr, 16);
-
-                        chunks.resize(chunktotal2);
-
-#ifdef TIMING
-    end = clock ();    
-    t_gctfc = t_gctfc + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
-
-#ifdef TIMING
-    start = clock ();    
-#endif
-
-                        int chunknum2;
-                        std::string chunknum;
-                        get_chunknum_from_chunk (opdata, chunknum, offset);
-                        chunknum2 = std::stoul(chunknum, nullptr, 16);
-
-                        if (count == chunktotal2) {
+                        // Protocol 02 data chunks leave the chunktotal to the header chunk
+                        if (view.chunktotal > 0) {
+                            chunktotal2 = view.chunktotal;
+                        }
 
-intAllDataChunksFound = 1;
+                        if (chunktotal2 > 0 && count == chunktotal2) {
 
-                            // height = 6000;
-                            // LogPrint (BCLog::ALL, "The last chunk was found (%s).\n", chunknum2);
+                            intAllDataChunksFound = 1;
+                            intAllDataChunksHeight = index.nHeight;
 
-// LogPrint (BCLog::ALL, "ghshAuthenticatetenantPubkey %s \n", ghshAuthenticatetenantPubkey.ToString());
+                            // No block needs reading for the tenant if the authlist history reaches this far
+                            if (hasauth) {
+                                optTenantAuthorized = tenant_authorized_at(hshTenant, index.nHeight);
+                            }
 
                         }
 
-                        // put chunk in correct position
-                        chunks[chunknum2-1] = opdata;
-
-#ifdef TIMING
-    end = clock ();    
-    t_gcnfc = t_gcnfc + (double) (end - start) / CLOCKS_PER_SEC;
-#endif
+                        // verify and write chunk at its position in the file, while scanning continues.
+                        // the header goes along, a protocol 02 one is checked against the data chunks
+                        file.add_chunk(CScript(script.begin(), script.end()));
 
                     }
                 }
             }
         }
+
+        // Blocks left after the filtered ones holding the uuid are only read for the tenant
+        return intAuthenticateTenantPubkeyFound == 0 && !optTenantAuthorized && !(fFiltered && intAllDataChunksFound == 1);
+    };
+    if (!ReadBlockViewsInOrder(vctBlocks, chainman.GetParams().MessageStart(), scan_block)) {
+        return false;
+    }
+
+    if (fFiltered && intAllDataChunksFound == 1 && intAuthenticateTenantPubkeyFound == 0 && !optTenantAuthorized && !job_cancel_requested()) {
+        std::vector<const CBlockIndex*> vctAuthBlocks;
+        for (const CBlockIndex* pindex : vctAllBlocks) {
+            if (pindex->nHeight < intAllDataChunksHeight) vctAuthBlocks.push_back(pindex);
+        }
+        // All of them, should the index have gone in the meantime
+        filter_blocks(vctAuthBlocks, {GCSFilter::Element(hshTenant.begin(), hshTenant.end())});
+        fFiltered = false;
+        intBlocksTotal = intBlocksDone + vctAuthBlocks.size();
+        if (!ReadBlockViewsInOrder(vctAuthBlocks, chainman.GetParams().MessageStart(), scan_block)) {
+            return false;
+        }
     }
 
     // If header chunk not found
     if (!hasauth) {
-        LogPrintf("Header chunk not found for uuid %s\n", uuid);
+        LogPrint(BCLog::STORAGE, "Header chunk not found for uuid %s\n", uuid);
         error_level = ERR_CHUNKAUTHNONE;
         return false;
     }
 
-// count = 0;
-
     // If not all data chunks
     if (count != chunktotal2) {
-        LogPrint (BCLog::ALL, "Not all data chunks found for uuid %s\n", uuid);
+        LogPrint (BCLog::STORAGE, "Not all data chunks found for uuid %s\n", uuid);
         error_level = ERR_NOTALLDATACHUNKS;
         return false;
     }
 
     // If authenticatetenant pubkey not found
-    if (intAuthenticateTenantPubkeyFound == 0) {
-        LogPrint (BCLog::ALL, "authenticatetenant pubkey not found for uuid %s\n", uuid);
+    if (!optTenantAuthorized.value_or(intAuthenticateTenantPubkeyFound == 1)) {
+        LogPrint (BCLog::STORAGE, "authenticatetenant pubkey not found for uuid %s\n", uuid);
         error_level = ERR_CHUNKAUTHUNK;
         return false;
     }
 
 #ifdef TIMING
-    LogPrint (BCLog::ALL, "%d data chunks found.\n", chunktotal2);
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::STORAGE, "%d data chunks found.\n", chunktotal2);
+    LogPrint (BCLog::STORAGE, "\n");
 
-    LogPrint (BCLog::ALL, "elapsed time ReadBlockFromDisk %ld \n", t_rbfd);
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::STORAGE, "elapsed time parse_chunk_from_script %ld \n", t_pcfs);
+    LogPrint (BCLog::STORAGE, "\n");
 
-    LogPrint (BCLog::ALL, "elapsed time HexStr %ld \n", t_hs);
-    LogPrint (BCLog::ALL, "\n");
-
-    LogPrint (BCLog::ALL, "elapsed time strip_opreturn_from_chunk %ld \n", t_sofc);
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::STORAGE, "elapsed time is_valid_authchunk %ld \n", t_iva);
+    LogPrint (BCLog::STORAGE, "\n");
+#endif
 
-    LogPrint (BCLog::ALL, "elapsed time check_chunk_contextual %ld \n", t_ccc);
-    LogPrint (BCLog::ALL, "\n");
+    return true;
+}
 
-    LogPrint (BCLog::ALL, "elapsed time get_chunklen_from_chunk %ld \n", t_gclfc);
-    LogPrint (BCLog::ALL, "\n");
+// Extract several assets in one pass, with the same checks as scan_blocks_for_specific_uuid for each
+bool scan_blocks_for_specific_uuids (ChainstateManager& chainman, std::vector<batch_fetch_asset>& assets)
+{
 
-    LogPrint (BCLog::ALL, "elapsed time get_uuid_from_chunk %ld \n", t_gufc);
-    LogPrint (BCLog::ALL, "\n");
+    // Assets still gathering chunks, by binary uuid
+    std::unordered_map<uint256, size_t, SaltedTxidHasher> mapGathering;
+    GCSFilter::ElementSet setUUIDs;
+    for (size_t i = 0; i < assets.size(); ++i) {
+        const std::vector<unsigned char> vchUUID = ParseHex(assets[i].uuid);
+        if (vchUUID.size() != OPENCODING_UUID) {
+            assets[i].error_level = ERR_CHUNKUUID;
+            continue;
+        }
+        mapGathering.emplace(uint256{vchUUID}, i);
+        setUUIDs.emplace(vchUUID.begin(), vchUUID.end());
+    }
 
-    LogPrint (BCLog::ALL, "elapsed time is_valid_authchunk %ld \n", t_iva);
-    LogPrint (BCLog::ALL, "\n");
+    // Assets with all their chunks, waiting for the authenticatetenant of their tenant
+    std::multimap<uint160, size_t> mapWaiting;
 
-    LogPrint (BCLog::ALL, "elapsed time get_chunktotal_from_chunk %ld \n", t_gctfc);
-    LogPrint (BCLog::ALL, "\n");
+    // Blocks processed, for job progress
+    int intBlocksDone = 0;
 
-    LogPrint (BCLog::ALL, "elapsed time get_chunknumber_from_chunk %ld \n", t_gcnfc);
-    LogPrint (BCLog::ALL, "\n");
-#endif
+    const std::vector<const CBlockIndex*> vctAllBlocks{blocks_to_scan(chainman)};
+    std::vector<const CBlockIndex*> vctBlocks{vctAllBlocks};
+    bool fFiltered{filter_blocks(vctBlocks, setUUIDs)};
+    int intBlocksTotal = vctBlocks.size();
+    if (fFiltered) {
+        LogPrint(BCLog::STORAGE, "Storage filter leaves %d of %d blocks to scan for %d uuids\n", vctBlocks.size(), vctAllBlocks.size(), assets.size());
+    }
 
-    return true;
-}
+    const auto scan_block = [&](const CBlockIndex& index, const CBlockHeader&, const std::vector<CTransactionView>& txs) {
 
-void estimate_coins_for_opreturn(CWallet* wallet, int& suitable_inputs)
-{
-    suitable_inputs = 0;
+        ++intBlocksDone;
+
+        if (intBlocksDone % 100 == 0) {
+            set_job_progress(intBlocksDone, intBlocksTotal);
+            if (job_cancel_requested()) {
+                return false;
+            }
+        }
+
+        for (const CTransactionView& tx : txs) {
+
+            if (tx.IsCoinBase() || tx.IsCoinStake()) {
+                continue;
+            }
+
+            for (const CTxOutView& out : tx.Outputs()) {
+
+                if (!out.IsOpReturn()) {
+                    continue;
+                }
+                const Span<const unsigned char> script{out.scriptPubKey};
+
+                // Authdata only matters to assets with all their chunks
+                if (is_auth_magic_in_script (script)) {
+                    auth_view auth;
+                    if (mapWaiting.empty() || !parse_auth_from_script (script, auth) || auth.operation != OPAUTH_ADDUSER_BIN) {
+                        continue;
+                    }
+                    const auto range = mapWaiting.equal_range(get_hash160_from_auth (auth));
+                    for (auto it = range.first; it != range.second;) {
+                        // Not a block above the one holding the last data chunk, as for a single asset
+                        if (index.nHeight <= assets[it->second].complete_height) {
+                            assets[it->second].tenant_found = true;
+                            it = mapWaiting.erase(it);
+                        } else {
+                            ++it;
+                        }
+                    }
+                    continue;
+                }
+
+                if (mapGathering.empty()) {
+                    continue;
+                }
+
+                chunk_view view;
+                int error_level;
+                if (!parse_chunk_from_script (script, view, error_level) || view.uuid.size() != OPENCODING_UUID) {
+                    continue;
+                }
+
+                const auto found = mapGathering.find(uint256{view.uuid});
+                if (found == mapGathering.end()) {
+                    continue;
+                }
+                batch_fetch_asset& asset = assets[found->second];
+                asset.height = std::max(asset.height, index.nHeight);
+
+                if (view.chunklen == 0) {
+                    if (!is_valid_authchunk (view, error_level, asset.tenant)) {
+                        LogPrintEvery(BCLog::STORAGE, LOG_EVERY_DEFAULT, "error_level from is_valid_authchunk %d\n", error_level);
+                        continue;
+                    }
+                    LogPrint (BCLog::STORAGE, "Found valid header chunk for UUID: %s\n", asset.uuid);
+                    asset.hasauth = true;
+                } else {
+                    asset.count++;
+                }
+
+                // Protocol 02 data chunks leave the chunktotal to the header chunk
+                if (view.chunktotal > 0) {
+                    asset.chunktotal = view.chunktotal;
+                }
+
+                // Files are opened as their first chunk is found, so only the assets
+                // whose chunks the blocks interleave are being written at once
+                if (!asset.file) {
+                    asset.file = std::make_unique<chunk_reassembler>(asset.filepath, 1);
+                    set_tenant_secret(*asset.file);
+                    if (!asset.file->open(asset.error_level)) {
+                        asset.file.reset();
+                        mapGathering.erase(found);
+                        continue;
+                    }
+                }
+                asset.file->add_chunk(CScript(script.begin(), script.end()));
+
+                // All chunks found, the file is finished while the scan goes on for its tenant
+                if (asset.hasauth && asset.chunktotal > 0 && asset.count == asset.chunktotal) {
+                    asset.complete_height = index.nHeight;
+                    if (asset.file->finish(asset.error_level)) {
+                        asset.file->get_written(asset.chunks, asset.bytes);
+                        asset.encrypted = asset.file->encrypted();
+                        // The authlist history answers for the tenant, when it reaches this far
+                        if (const std::optional<bool> authorized{tenant_authorized_at(asset.tenant, index.nHeight)}) {
+                            asset.tenant_found = *authorized;
+                        } else {
+                            mapWaiting.emplace(asset.tenant, found->second);
+                        }
+                    }
+                    asset.file.reset();
+                    mapGathering.erase(found);
+                }
+            }
+        }
+
+        // Blocks left after the filtered ones holding the uuids are only read for the tenants
+        return !mapGathering.empty() || (!fFiltered && !mapWaiting.empty());
+    };
+    if (!ReadBlockViewsInOrder(vctBlocks, chainman.GetParams().MessageStart(), scan_block)) {
+        return false;
+    }
+
+    if (fFiltered && !mapWaiting.empty() && !job_cancel_requested()) {
+        int intCompleteHeight = -1;
+        GCSFilter::ElementSet setTenants;
+        for (const auto& [tenant, i] : mapWaiting) {
+            intCompleteHeight = std::max(intCompleteHeight, assets[i].complete_height);
+            setTenants.emplace(tenant.begin(), tenant.end());
+        }
+        std::vector<const CBlockIndex*> vctAuthBlocks;
+        for (const CBlockIndex* pindex : vctAllBlocks) {
+            if (pindex->nHeight < intCompleteHeight) vctAuthBlocks.push_back(pindex);
+        }
+        // All of them, should the index have gone in the meantime
+        filter_blocks(vctAuthBlocks, setTenants);
+        fFiltered = false;
+        intBlocksTotal = intBlocksDone + vctAuthBlocks.size();
+        if (!ReadBlockViewsInOrder(vctAuthBlocks, chainman.GetParams().MessageStart(), scan_block)) {
+            return false;
+        }
+    }
+
+    if (job_cancel_requested()) {
+        return false;
+    }
+
+    for (batch_fetch_asset& asset : assets) {
+        if (asset.file) {
+            asset.file->discard();
+            asset.file.reset();
+        }
+        if (asset.error_level != NO_ERROR) {
+            continue;
+        }
+        if (!asset.hasauth) {
+            LogPrint (BCLog::STORAGE, "Header chunk not found for uuid %s\n", asset.uuid);
+            asset.error_level = ERR_CHUNKAUTHNONE;
+        } else if (asset.count != asset.chunktotal) {
+            LogPrint (BCLog::STORAGE, "Not all data chunks found for uuid %s\n", asset.uuid);
+            asset.error_level = ERR_NOTALLDATACHUNKS;
+        } else if (!asset.tenant_found) {
+            LogPrint (BCLog::STORAGE, "authenticatetenant pubkey not found for uuid %s\n", asset.uuid);
+            asset.error_level = ERR_CHUNKAUTHUNK;
+            // Written already, as its chunks were all found
+            std::error_code ec;
+            fs::remove(fs::u8path(asset.filepath), ec);
+        }
+    }
+
+    return true;
+}
+
+// Script of the output holding an indexed chunk, from the payload kept by a pruning index, the
+// unconfirmed transaction or the block files; tx is reused when it is already the one at posLast
+template <typename Record>
+static bool read_chunk_script (const Record& record, CTransactionRef& tx, CDiskTxPos& posLast, const CScript*& script)
+{
+    if (!record.payload.empty()) {
+        script = &record.payload;
+        return true;
+    }
+
+    if (record.tx) {
+        // Unconfirmed, held by the index
+        tx = record.tx;
+        posLast = CDiskTxPos();
+    } else if (!tx || record.pos.nFile != posLast.nFile || record.pos.nPos != posLast.nPos || record.pos.nTxOffset != posLast.nTxOffset) {
+        if (!StorageIndex::ReadTransaction(record.pos, tx)) {
+            return false;
+        }
+        posLast = record.pos;
+    }
+
+    if (record.vout >= tx->vout.size()) {
+        return false;
+    }
+    script = &tx->vout[record.vout].scriptPubKey;
+    return true;
+}
+
+// Extract asset using the storage index, reading only the transactions that hold its chunks
+bool scan_index_for_specific_uuid (std::string& uuid, int& error_level, chunk_reassembler& file, int& height)
+{
+
+    g_storage_index->BlockUntilSyncedToCurrentChain();
+
+    // Get header chunk location
+    StorageAssetInfo info;
+    if (!g_storage_index->FindAsset(uuid, info)) {
+        LogPrint(BCLog::STORAGE, "Header chunk not found for uuid %s\n", uuid);
+        error_level = ERR_CHUNKAUTHNONE;
+        return false;
+    }
+
+    // Read and validate header chunk, recovering authenticated tenant at storeasset time
+    CTransactionRef tx;
+    CDiskTxPos posLast;
+    const CScript* script;
+    if (!read_chunk_script (info.header, tx, posLast, script)) {
+        return false;
+    }
+
+    uint160 hshTenant;
+    chunk_view view;
+    if (!parse_chunk_from_script (*script, view, error_level) || !is_valid_authchunk (view, error_level, hshTenant)) {
+        LogPrint (BCLog::STORAGE, "error_level from is_valid_authchunk %d\n", error_level);
+        LogPrint(BCLog::STORAGE, "Header chunk not found for uuid %s\n", uuid);
+        error_level = ERR_CHUNKAUTHNONE;
+        return false;
+    }
+
+    // Protocol 02 data chunks are checked against the header chunk
+    file.add_chunk(*script);
+
+    // Get data chunk locations
+    std::vector<StorageChunkRecord> records;
+    if (!info.length || !g_storage_index->FindChunks(uuid, info.length->chunk_total, records)) {
+        LogPrint (BCLog::STORAGE, "Not all data chunks found for uuid %s\n", uuid);
+        error_level = ERR_NOTALLDATACHUNKS;
+        return false;
+    }
+
+    // Lowest and highest blockheight holding a chunk
+    int intLowestHeight = info.length->height;
+    height = std::max(info.header.height, info.length->height);
+
+    // Read data chunks in order, reusing the transaction when consecutive chunks share one
+    size_t count = 0;
+    for (const auto& record : records) {
+
+        if (job_cancel_requested()) {
+            return false;
+        }
+
+        if (!read_chunk_script (record, tx, posLast, script)) {
+            return false;
+        }
+
+        file.add_chunk(*script);
+        set_job_progress(++count, records.size());
+
+        intLowestHeight = std::min(intLowestHeight, record.height);
+        height = std::max(height, record.height);
+    }
+
+    // Authenticatetenant pubkey must have been on the authlist at the data chunks, or, beyond the
+    // authlist history, added to it no later than them
+    int intAuthHeight;
+    const std::optional<bool> optAuthorized{tenant_authorized_at(hshTenant, intLowestHeight)};
+    if (optAuthorized ? !*optAuthorized : (!g_storage_index->FindAuthHeight(hshTenant, intAuthHeight) || intAuthHeight > intLowestHeight)) {
+        LogPrint (BCLog::STORAGE, "authenticatetenant pubkey not found for uuid %s\n", uuid);
+        error_level = ERR_CHUNKAUTHUNK;
+        return false;
+    }
+
+    return true;
+}
+
+bool read_asset_chunks (const std::string& uuid, uint32_t first, uint32_t count, CScript& header, uint32_t& chunktotal, std::vector<CScript>& chunks)
+{
+    // Not waiting for the index to catch up, as peers are served from the message handler
+    StorageAssetInfo info;
+    if (!g_storage_index || !g_storage_index->FindAsset(uuid, info) || !info.length) {
+        return false;
+    }
+    chunktotal = info.length->chunk_total;
+
+    CTransactionRef tx;
+    CDiskTxPos posLast;
+    const CScript* script;
+    if (!read_chunk_script (info.header, tx, posLast, script)) {
+        return false;
+    }
+    header = *script;
+
+    chunks.clear();
+    if (count == 0) {
+        return true;
+    }
+    if (first == 0 || uint64_t(first) + count - 1 > chunktotal) {
+        return false;
+    }
+    std::vector<StorageChunkRecord> records;
+    if (!g_storage_index->FindChunks(uuid, first, first + count - 1, records)) {
+        return false;
+    }
+    chunks.reserve(records.size());
+    for (const auto& record : records) {
+        if (!read_chunk_script (record, tx, posLast, script)) {
+            return false;
+        }
+        chunks.push_back(*script);
+    }
+    return true;
+}
+
+bool build_asset_proof (ChainstateManager& chainman, const std::string& uuid, uint32_t& chunktotal, std::vector<asset_block_proof>& proofs, int& error_level)
+{
+    g_storage_index->BlockUntilSyncedToCurrentChain();
+
+    StorageAssetInfo info;
+    if (!g_storage_index->FindAsset(uuid, info)) {
+        error_level = ERR_CHUNKAUTHNONE;
+        return false;
+    }
+    std::vector<StorageChunkRecord> records;
+    if (!info.length || !g_storage_index->FindChunks(uuid, info.length->chunk_total, records)) {
+        error_level = ERR_NOTALLDATACHUNKS;
+        return false;
+    }
+    chunktotal = info.length->chunk_total;
+
+    // Offsets of the transactions holding the chunks within their block, by height; chunks share transactions
+    std::map<int, std::pair<FlatFilePos, std::set<unsigned int>>> blocks;
+    const auto add_record = [&](const auto& record) {
+        auto& [block_pos, offsets] = blocks[record.height];
+        block_pos = FlatFilePos(record.pos.nFile, record.pos.nPos);
+        offsets.insert(record.pos.nTxOffset);
+        return record.height != STORAGE_MEMPOOL_HEIGHT;
+    };
+    bool confirmed = add_record(info.header);
+    for (const auto& record : records) {
+        confirmed &= add_record(record);
+    }
+    if (!confirmed) {
+        error_level = ERR_UNCONFIRMED;
+        return false;
+    }
+
+    proofs.clear();
+    for (const auto& [height, located] : blocks) {
+        const auto& [block_pos, offsets] = located;
+        const CBlockIndex* pindex;
+        {
+            LOCK(cs_main);
+            pindex = chainman.ActiveChain()[height];
+            if (!pindex || pindex->GetBlockPos() != block_pos) {
+                error_level = ERR_FILEREAD;
+                return false;
+            }
+        }
+
+        // Pruned blocks can not be proven, even when the index keeps the payloads
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, chainman.GetConsensus())) {
+            error_level = ERR_FILEREAD;
+            return false;
+        }
+
+        std::set<uint256> txids;
+        std::vector<CTransactionRef> txs;
+        unsigned int offset = GetSizeOfCompactSize(block.vtx.size());
+        for (const auto& tx : block.vtx) {
+            if (offsets.count(offset)) {
+                txids.insert(tx->GetHash());
+                txs.push_back(tx);
+            }
+            offset += ::GetSerializeSize(*tx, CLIENT_VERSION);
+        }
+        if (txs.size() != offsets.size()) {
+            error_level = ERR_FILEREAD;
+            return false;
+        }
+        proofs.push_back({pindex, CMerkleBlock(block, txids), std::move(txs)});
+    }
+    return true;
+}
+
+asset_range_reader::asset_range_reader (const std::string& uuid) : m_uuid(ToLower(uuid))
+{
+}
+
+bool asset_range_reader::open (int& error_level)
+{
+    g_storage_index->BlockUntilSyncedToCurrentChain();
+
+    if (!g_storage_index->FindAsset(m_uuid, m_info)) {
+        LogPrint (BCLog::STORAGE, "Header chunk not found for uuid %s\n", m_uuid);
+        error_level = ERR_CHUNKAUTHNONE;
+        return false;
+    }
+
+    // Read and validate header chunk, recovering authenticated tenant at storeasset time
+    CTransactionRef tx;
+    CDiskTxPos posHeader;
+    const CScript* script;
+    if (!read_chunk_script (m_info.header, tx, posHeader, script)) {
+        error_level = ERR_FILEREAD;
+        return false;
+    }
+
+    uint160 hshTenant;
+    chunk_view header;
+    if (!parse_chunk_from_script (*script, header, error_level) || !is_valid_authchunk (header, error_level, hshTenant)) {
+        LogPrint (BCLog::STORAGE, "Header chunk not valid for uuid %s\n", m_uuid);
+        error_level = ERR_CHUNKAUTHNONE;
+        return false;
+    }
+
+    if (!m_info.length) {
+        error_level = ERR_NOTALLDATACHUNKS;
+        return false;
+    }
+
+    // Authenticatetenant pubkey must have been added to the authlist no later than the data chunks
+    if (!g_storage_index->FindAuthHeight(hshTenant, m_authheight) || m_authheight > m_info.length->height) {
+        LogPrint (BCLog::STORAGE, "authenticatetenant pubkey not found for uuid %s\n", m_uuid);
+        error_level = ERR_CHUNKAUTHUNK;
+        return false;
+    }
+
+    // The file as fetched, but for the extension trailing protocol 01 chunk data
+    m_chunkmax = get_chunkmax_for_version(m_info.header.protocol);
+    const uint64_t storedlen = m_info.GetFileLength();
+    const uint64_t trailer = m_info.header.protocol == 1 ? OPENCODING_EXTENSION : 0;
+    if (storedlen < trailer) {
+        error_level = ERR_FILELENGTH;
+        return false;
+    }
+    m_compressed = header.version == OPENCODING_COMPACT && (header.flags & OPENCODING_FLAG_COMPRESSED);
+
+    // Encrypted assets are read decrypted with the key of the authenticated tenant, as fetched
+    if (header.version == OPENCODING_COMPACT && (header.flags & OPENCODING_FLAG_ENCRYPTED)) {
+        const CKey key = DecodeSecret(authUserKey);
+        if (key.IsValid()) {
+            m_cipher.emplace(Span<const unsigned char>{key.begin(), key.size()}, header.uuid);
+        }
+        if (!m_cipher || !m_cipher->set_nonce_from_header(header.encryption)) {
+            LogPrint (BCLog::STORAGE, "Asset %s is encrypted with another key than the tenant's\n", m_uuid);
+            m_cipher.reset();
+            error_level = ERR_DECRYPT;
+            return false;
+        }
+    }
+    m_filelen = m_compressed ? header.rawlen : storedlen - trailer;
+
+    if (header.version == OPENCODING_COMPACT) {
+        m_merkleroot = uint256(header.merkleroot);
+        m_extension.assign(header.extension.begin(), header.extension.end());
+    } else if (trailer > 0) {
+        if (!read_stored(storedlen - trailer, trailer, error_level, [&](Span<const unsigned char> bytes) {
+            m_extension.append(bytes.begin(), bytes.end());
+            return true;
+        })) {
+            return false;
+        }
+    }
+    m_extension.erase(std::find(m_extension.begin(), m_extension.end(), '\0'), m_extension.end());
+
+    return true;
+}
+
+bool asset_range_reader::read_chunks (uint32_t first, uint32_t last, int& error_level, const sink_t& sink)
+{
+    std::vector<StorageChunkRecord> records;
+    if (!g_storage_index->FindChunks(m_uuid, first, last, records)) {
+        LogPrint (BCLog::STORAGE, "Data chunks %d to %d not found for uuid %s\n", first, last, m_uuid);
+        error_level = ERR_NOTALLDATACHUNKS;
+        return false;
+    }
+
+    const uint32_t chunktotal = m_info.length->chunk_total;
+
+    // Reuse the transaction when consecutive chunks share one
+    CTransactionRef tx;
+    CDiskTxPos posLast;
+    const CScript* script;
+    uint32_t chunknum = first;
+    for (const auto& record : records) {
+
+        if (record.height < m_authheight) {
+            LogPrint (BCLog::STORAGE, "authenticatetenant pubkey not found for uuid %s\n", m_uuid);
+            error_level = ERR_CHUNKAUTHUNK;
+            return false;
+        }
+
+        if (!read_chunk_script (record, tx, posLast, script)) {
+            error_level = ERR_FILEREAD;
+            return false;
+        }
+
+        chunk_view view;
+        if (!parse_chunk_from_script (*script, view, error_level)) {
+            return false;
+        }
+        if (view.version != m_info.header.protocol || HexStr(view.uuid) != m_uuid) {
+            error_level = ERR_CHUNKUUID;
+            return false;
+        }
+        if (view.chunklen == 0 || view.chunknum != chunknum) {
+            error_level = ERR_CHUNKNUM;
+            return false;
+        }
+        if (chunknum != chunktotal && view.data.size() != m_chunkmax) {
+            error_level = ERR_CHUNKLEN;
+            return false;
+        }
+
+        // Protocol 02 chunks carry no checksum, they are only checked against the merkle root once
+        // every chunk has been read in order from the first
+        if (view.version == OPENCODING_COMPACT) {
+            if (chunknum == m_leaves.size() + 1) {
+                m_leaves.push_back(Hash(view.data));
+            }
+        } else {
+            if (view.chunktotal != chunktotal) {
+                error_level = ERR_CHUNKTOTAL;
+                return false;
+            }
+            if (!is_valid_chunkhash (view)) {
+                error_level = ERR_CHUNKHASH;
+                return false;
+            }
+        }
+
+        if (m_cipher) {
+            m_plain.assign(view.data.begin(), view.data.end());
+            m_cipher->crypt(uint64_t(chunknum - 1) * m_chunkmax, m_plain.data(), m_plain.size());
+            if (!sink(m_plain)) {
+                return false;
+            }
+        } else if (!sink(view.data)) {
+            return false;
+        }
+
+        chunknum++;
+    }
+
+    return true;
+}
+
+bool asset_range_reader::read_stored (uint64_t offset, uint64_t length, int& error_level, const sink_t& sink)
+{
+    // Only the chunks holding the range
+    const uint32_t first = offset / m_chunkmax + 1;
+    const uint32_t last = (offset + length - 1) / m_chunkmax + 1;
+    uint64_t pos = uint64_t(first - 1) * m_chunkmax;
+    return read_chunks(first, last, error_level, [&](Span<const unsigned char> chunk) {
+        const uint64_t begin = std::max(offset, pos);
+        const uint64_t end = std::min(offset + length, pos + chunk.size());
+        const uint64_t chunkpos = pos;
+        pos += chunk.size();
+        return begin >= end || sink(chunk.subspan(begin - chunkpos, end - begin));
+    });
+}
+
+bool asset_range_reader::read (uint64_t offset, uint64_t length, int& error_level, const sink_t& sink)
+{
+    if (offset > m_filelen) {
+        error_level = ERR_FILELENGTH;
+        return false;
+    }
+    length = std::min(length, m_filelen - offset);
+    m_leaves.clear();
+    if (length == 0) {
+        return true;
+    }
+
+    if (!m_compressed) {
+        if (!read_stored(offset, length, error_level, sink)) {
+            return false;
+        }
+    } else {
+
+        // Where a block of the compressed stream starts is only known by reading the stream from the
+        // start, but blocks ending before the range are skipped rather than decompressed
+        std::vector<unsigned char> stream;
+        std::vector<unsigned char> raw(COMPRESS_BLOCK);
+        uint64_t rawpos = 0;
+        auto add_stream = [&](Span<const unsigned char> chunk) {
+            stream.insert(stream.end(), chunk.begin(), chunk.end());
+
+            size_t used = 0;
+            size_t headerlen;
+            uint64_t blocklen, complen;
+            while (rawpos < offset + length && read_block_header(stream.data() + used, stream.size() - used, headerlen, blocklen, complen)) {
+                if (blocklen == 0 || blocklen > COMPRESS_BLOCK || complen > blocklen || blocklen > m_filelen - rawpos) {
+                    error_level = ERR_CHUNKFAIL;
+                    return false;
+                }
+                if (stream.size() - used - headerlen < complen) {
+                    break;
+                }
+
+                const unsigned char* block = stream.data() + used + headerlen;
+                if (rawpos + blocklen > offset) {
+                    if (complen < blocklen) {
+                        if (!decompress_block(block, complen, raw.data(), blocklen)) {
+                            error_level = ERR_CHUNKFAIL;
+                            return false;
+                        }
+                        block = raw.data();
+                    }
+                    const uint64_t begin = std::max(offset, rawpos);
+                    const uint64_t end = std::min(offset + length, rawpos + blocklen);
+                    if (!sink(Span<const unsigned char>(block + (begin - rawpos), end - begin))) {
+                        return false;
+                    }
+                }
+                rawpos += blocklen;
+                used += headerlen + complen;
+            }
+            stream.erase(stream.begin(), stream.begin() + used);
+            return true;
+        };
+
+        // A transaction worth of chunks at a time, until the range is decompressed
+        const uint32_t chunktotal = m_info.length->chunk_total;
+        for (uint32_t first = 1; first <= chunktotal && rawpos < offset + length; first += OPRETURN_PER_TX) {
+            const uint32_t last = std::min<uint64_t>(chunktotal, uint64_t(first) + OPRETURN_PER_TX - 1);
+            if (!read_chunks(first, last, error_level, add_stream)) {
+                return false;
+            }
+        }
+        if (rawpos < offset + length) {
+            error_level = ERR_CHUNKFAIL;
+            return false;
+        }
+    }
+
+    // Reading up to the end of a protocol 02 file has gone through every chunk
+    if (m_info.header.protocol == OPENCODING_COMPACT && m_leaves.size() == m_info.length->chunk_total) {
+        if (ComputeMerkleRoot(std::move(m_leaves)) != m_merkleroot) {
+            error_level = ERR_CHUNKHASH;
+            return false;
+        }
+    }
+    m_leaves.clear();
+
+    return true;
+}
+
+bool fetch_asset_range (std::string uuid, uint64_t offset, uint64_t length, std::vector<unsigned char>& data, uint64_t& filelen, int& error_level)
+{
+    data.clear();
+    filelen = 0;
+
+    asset_range_reader reader(uuid);
+    if (!reader.open(error_level)) {
+        return false;
+    }
+    filelen = reader.filelen();
+
+    length = std::min(length, MAX_FETCHRANGE_LENGTH);
+    if (offset <= filelen) {
+        data.reserve(std::min(length, filelen - offset));
+    }
+    return reader.read(offset, length, error_level, [&](Span<const unsigned char> bytes) {
+        data.insert(data.end(), bytes.begin(), bytes.end());
+        return true;
+    });
+}
+
+void estimate_coins_for_opreturn(CWallet* wallet, int& suitable_inputs)
+{
+    suitable_inputs = 0;
+
+    // Uploads the funding pool can pay for need not look at the rest of the wallet
+    if (g_storage_funding) {
+        suitable_inputs = g_storage_funding->Ready(*wallet);
+        if (suitable_inputs > 0) {
+            LogPrint (BCLog::STORAGE, "Suitable inputs in the funding pool: %d\n", suitable_inputs);
+            return;
+        }
+    }
 
     std::vector<COutput> vCoins;
     {
@@ -734,19 +1385,19 @@ void estimate_coins_for_opreturn(CWallet* wallet, int& suitable_inputs)
         }
     }
 
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "DETERMINE NUMBER OF TRANSACTIONS IN ACTIVE WALLET SUITABLE FOR PUTFILE TRANSACTIONS (estimate_coins_for_opreturn)\n");
-    LogPrint (BCLog::ALL, "For a given putfile operation, each group of 256 chunks requires a separate transaction from the active wallet.\n");
-    LogPrint (BCLog::ALL, "A given suitable transaction will be associated with lynx coins to be used to pay for the chunk storage.\n");
-    LogPrint (BCLog::ALL, "A count of the transactions in the active wallet follow.\n");
-    LogPrint (BCLog::ALL, "After that, the number of satoshis associated with each transaction are given, regardless of suitability.\n");
-    LogPrint (BCLog::ALL, "Several things can make a transaction unsuitable (for instance, less than 100,000,000 satoshis).\n");
-    LogPrint (BCLog::ALL, "Next, the number of suitable transactions is given.\n");
-    LogPrint (BCLog::ALL, "Because a given transaction may become the input for a putfile transaction, suitable input is used interchangeably with suitable transaction.\n");
-    LogPrint (BCLog::ALL, "Finally, the number of groups of 256 chunks is given\n");
+    LogPrint (BCLog::STORAGE, "\n");
+    LogPrint (BCLog::STORAGE, "DETERMINE NUMBER OF TRANSACTIONS IN ACTIVE WALLET SUITABLE FOR PUTFILE TRANSACTIONS (estimate_coins_for_opreturn)\n");
+    LogPrint (BCLog::STORAGE, "For a given putfile operation, each group of 256 chunks requires a separate transaction from the active wallet.\n");
+    LogPrint (BCLog::STORAGE, "A given suitable transaction will be associated with lynx coins to be used to pay for the chunk storage.\n");
+    LogPrint (BCLog::STORAGE, "A count of the transactions in the active wallet follow.\n");
+    LogPrint (BCLog::STORAGE, "After that, the number of satoshis associated with each transaction are given, regardless of suitability.\n");
+    LogPrint (BCLog::STORAGE, "Several things can make a transaction unsuitable (for instance, less than 100,000,000 satoshis).\n");
+    LogPrint (BCLog::STORAGE, "Next, the number of suitable transactions is given.\n");
+    LogPrint (BCLog::STORAGE, "Because a given transaction may become the input for a putfile transaction, suitable input is used interchangeably with suitable transaction.\n");
+    LogPrint (BCLog::STORAGE, "Finally, the number of groups of 256 chunks is given\n");
     
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "Number of UTXO's (Unspent Transaction Outputs): %d\n", vCoins.size());    
+    LogPrint (BCLog::STORAGE, "\n");
+    LogPrint (BCLog::STORAGE, "Number of UTXO's (Unspent Transaction Outputs): %d\n", vCoins.size());    
 
 int intNumberOfImmatureCoins = 0;    
 
@@ -754,7 +1405,7 @@ int intNumberOfImmatureCoins = 0;
         const auto& txout = output.txout;
         {
 
-            LogPrint (BCLog::ALL, "Satoshis: %d\n", output.txout.nValue);
+            LogPrintEvery(BCLog::STORAGE, LOG_EVERY_DEFAULT, "Satoshis: %d\n", output.txout.nValue);
 
             LOCK(wallet->cs_wallet);
 
@@ -772,8 +1423,8 @@ int intNumberOfImmatureCoins = 0;
             int depth = wallet->GetTxDepthInMainChain(*wtx);
             if (depth < COINBASE_MATURITY) {
 
-LogPrint (BCLog::ALL, "depth %d COINBASE_MATURITY %d \n", depth, COINBASE_MATURITY);
-LogPrint (BCLog::ALL, "\n");
+LogPrintEvery(BCLog::STORAGE, LOG_EVERY_DEFAULT, "depth %d COINBASE_MATURITY %d \n", depth, COINBASE_MATURITY);
+LogPrint (BCLog::STORAGE, "\n");
 
 intNumberOfImmatureCoins++;
 
@@ -787,14 +1438,28 @@ intNumberOfImmatureCoins++;
         }
     }
 
-    LogPrint (BCLog::ALL, "Suitable inputs: %d\n", suitable_inputs);    
-    LogPrint (BCLog::ALL, "Number of immature UTXO's: %d\n", intNumberOfImmatureCoins);    
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::STORAGE, "Suitable inputs: %d\n", suitable_inputs);    
+    LogPrint (BCLog::STORAGE, "Number of immature UTXO's: %d\n", intNumberOfImmatureCoins);    
+    LogPrint (BCLog::STORAGE, "\n");
 
 }
 
 bool select_coins_for_opreturn(CWallet* wallet, std::set<std::pair<const CWalletTx*, unsigned int>>& setCoinsRet, CAmount& valueRet)
 {
+    setCoinsRet.clear();
+
+    // The coin is spent as soon as it is selected, so it need not stay locked
+    if (g_storage_funding) {
+        for (const COutPoint& outpoint : g_storage_funding->Take(*wallet, 1)) {
+            LOCK(wallet->cs_wallet);
+            wallet->UnlockCoin(outpoint);
+            const CWalletTx* wtx = wallet->GetWalletTx(outpoint.hash);
+            setCoinsRet.insert(std::make_pair(wtx, outpoint.n));
+            valueRet = wtx->tx->vout[outpoint.n].nValue;
+            return true;
+        }
+    }
+
     std::vector<COutput> vCoins;
     {
         LOCK(wallet->cs_wallet);
@@ -804,8 +1469,6 @@ bool select_coins_for_opreturn(CWallet* wallet, std::set<std::pair<const CWallet
         }
     }
 
-    setCoinsRet.clear();
-
     for (const auto& output : vCoins) {
 
         const auto& txout = output.txout;
@@ -844,39 +1507,126 @@ bool select_coins_for_opreturn(CWallet* wallet, std::set<std::pair<const CWallet
     return false;
 }
 
-bool generate_selfsend_transaction(WalletContext& wallet_context, CMutableTransaction& tx, std::vector<std::string>& opPayload)
+// Coin as needed to sign a transaction spending it, caller holds cs_wallet
+static bool get_opreturn_input(CWallet* wallet, const COutPoint& outpoint, opreturn_input& input) EXCLUSIVE_LOCKS_REQUIRED(wallet->cs_wallet)
 {
+    const CWalletTx* wtx = wallet->GetWalletTx(outpoint.hash);
+    if (!wtx || outpoint.n >= wtx->tx->vout.size()) {
+        return false;
+    }
 
-    LogPrint (BCLog::ALL, "(generate_selfsend_transaction)\n");
+    int prev_height = wtx->state<TxStateConfirmed>() ? wtx->state<TxStateConfirmed>()->confirmed_block_height : 0;
+    input.outpoint = outpoint;
+    input.coin = Coin(wtx->tx->vout[outpoint.n], prev_height, wtx->IsCoinBase(), wtx->IsCoinStake());
+    return true;
+}
 
-    auto vpwallets = GetWallets(wallet_context);
-    size_t nWallets = vpwallets.size();
-    if (nWallets < 1) {
-        return false;
+bool reserve_coins_for_opreturn(CWallet* wallet, int count, std::vector<opreturn_input>& inputs)
+{
+    inputs.clear();
+
+    LOCK(wallet->cs_wallet);
+
+    // Inputs from the funding pool first, scanning the wallet only for those it lacks
+    size_t pooled = 0;
+    if (g_storage_funding) {
+        for (const COutPoint& outpoint : g_storage_funding->Take(*wallet, count)) {
+            opreturn_input input;
+            if (get_opreturn_input(wallet, outpoint, input)) {
+                inputs.push_back(input);
+            }
+        }
+        pooled = inputs.size();
+        if ((int)pooled == count) {
+            return true;
+        }
     }
 
-    CAmount setValue;
-    std::set<std::pair<const CWalletTx*, unsigned int>> setCoins;
-    if (!select_coins_for_opreturn(vpwallets.front().get(), setCoins, setValue)) {
-        return false;
+    // One pass over the wallet under a single lock, rather than a coin selection per transaction
+    auto res = AvailableCoins(*wallet);
+    for (const auto& output : res.All()) {
+
+        if ((int)inputs.size() == count) {
+            break;
+        }
+
+        if (wallet->IsLockedCoin(output.outpoint)) {
+            continue;
+        }
+
+        isminetype mine = wallet->IsMine(output.txout);
+        if (!(mine & ISMINE_SPENDABLE)) {
+            continue;
+        }
+
+        const CWalletTx* wtx = wallet->GetWalletTx(output.outpoint.hash);
+        if (wallet->GetTxDepthInMainChain(*wtx) < COINBASE_MATURITY) {
+            continue;
+        }
+
+        if (output.txout.nValue < 1 * COIN) {
+            continue;
+        }
+
+        opreturn_input input;
+        if (!get_opreturn_input(wallet, output.outpoint, input)) {
+            continue;
+        }
+        inputs.push_back(input);
     }
 
-    if (setCoins.size() == 0) {
+    if ((int)inputs.size() < count) {
+        for (size_t i = 0; i < pooled; ++i) {
+            g_storage_funding->Return(*wallet, inputs[i].outpoint);
+        }
+        inputs.clear();
         return false;
     }
 
-    // get vin/vout
-    std::set<std::pair<const CWalletTx*, unsigned int>>::iterator it = setCoins.begin();
-    COutPoint out{it->first->tx->GetHash(), it->second};
+    // Keep the reserved coins from being selected elsewhere until they are spent
+    for (const auto& input : inputs) {
+        wallet->LockCoin(input.outpoint);
+    }
+
+    return true;
+}
+
+void release_coins_for_opreturn(CWallet* wallet, const std::vector<opreturn_input>& inputs)
+{
+    LOCK(wallet->cs_wallet);
+    for (const auto& input : inputs) {
+        // Funding outputs left unspent go back to the pool, locked
+        if (!g_storage_funding || !g_storage_funding->Return(*wallet, input.outpoint)) {
+            wallet->UnlockCoin(input.outpoint);
+        }
+    }
+}
 
-    LogPrint (BCLog::ALL, "Input value in satoshis: %llu\n", setValue);
+/**
+ * Sign the input of a putfile transaction with only the script pubkey managers
+ * of its script. Each manager tried hashes the outputs again for the sighash,
+ * which for hundreds of chunk outputs costs far more than the signature.
+ */
+static bool sign_opreturn_input(CWallet* wallet, const opreturn_input& input, CMutableTransaction& tx)
+{
+    const std::map<COutPoint, Coin> coins{{input.outpoint, input.coin}};
+    std::map<int, bilingual_str> input_errors;
+    for (ScriptPubKeyMan* spk_man : wallet->GetScriptPubKeyMans(input.coin.out.scriptPubKey)) {
+        if (spk_man->SignTransaction(tx, coins, SIGHASH_DEFAULT, input_errors)) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    CTxIn txIn(out);
+// Builds and signs, does not need cs_wallet so that several can be built at once
+bool build_selfsend_transaction(CWallet* wallet, const opreturn_input& input, std::vector<std::vector<unsigned char>>& opPayload, CMutableTransaction& tx)
+{
+    LogPrint (BCLog::STORAGE, "Input value in satoshis: %llu\n", input.coin.out.nValue);
 
-    //CScript receiver = it->first->tx->vout[0].scriptPubKey;
-    CScript receiver = it->first->tx->vout[it->second].scriptPubKey;
+    CTxIn txIn(input.outpoint);
 
-    CTxOut txOut(setValue, receiver);
+    CTxOut txOut(input.coin.out.nValue, input.coin.out.scriptPubKey);
 
     // build tx
     tx.nVersion = CTransaction::CURRENT_VERSION;
@@ -890,42 +1640,93 @@ bool generate_selfsend_transaction(WalletContext& wallet_context, CMutableTransa
         tx.vout.push_back(txOpOut);
     }
 
-    {
-        //! sign tx once to get complete size
-        LOCK(vpwallets[0]->cs_wallet);
-        if (!vpwallets[0]->SignTransaction(tx)) {
-            return false;
-        }
+    //! size tx with dummy signatures, as signing hashes every output
+    if (!wallet->DummySignTx(tx, {input.coin.out})) {
+        return false;
+    }
+
+    // calculate and adjust fee (with 32byte fudge)
+    unsigned int nBytes = GetSerializeSize(tx) + 32;
+    CAmount nFee = GetRequiredFee(*wallet, nBytes);
+
+    LogPrint (BCLog::STORAGE, "Transaction bytes: %d\n", nBytes);
+    LogPrint (BCLog::STORAGE, "Transaction fee in satoshis: %llu\n", nFee);
+
+    tx.vout[0].nValue -= nFee;
+    if (tx.vout[0].nValue <= 0) {
+        // the input can't pay for it, as with change chained down too far
+        return false;
+    }
+
+    LogPrint (BCLog::STORAGE, "Change in satoshis: %llu\n", tx.vout[0].nValue);
+    LogPrint (BCLog::STORAGE, "\n");
+
+    //! sign tx once, with the fee in place; the dummy signatures would be taken for real ones
+    tx.vin[0].scriptSig.clear();
+    tx.vin[0].scriptWitness.SetNull();
+    return sign_opreturn_input(wallet, input, tx);
+}
+
+// Binary payloads, as built by stream_chunks_with_headers
+bool generate_selfsend_transaction(WalletContext& wallet_context, CMutableTransaction& tx, std::vector<std::vector<unsigned char>>& opPayload)
+{
+
+    LogPrint (BCLog::STORAGE, "(generate_selfsend_transaction)\n");
+
+    auto vpwallets = GetWallets(wallet_context);
+    size_t nWallets = vpwallets.size();
+    if (nWallets < 1) {
+        return false;
+    }
 
-        // calculate and adjust fee (with 32byte fudge)
-        unsigned int nBytes = GetSerializeSize(tx) + 32;
-        CAmount nFee = GetRequiredFee(*vpwallets[0].get(), nBytes);
+    CAmount setValue;
+    std::set<std::pair<const CWalletTx*, unsigned int>> setCoins;
+    if (!select_coins_for_opreturn(vpwallets.front().get(), setCoins, setValue)) {
+        return false;
+    }
 
-        LogPrint (BCLog::ALL, "Transaction bytes: %d\n", nBytes);
-        LogPrint (BCLog::ALL, "Transaction fee in satoshis: %llu\n", nFee);
+    if (setCoins.size() == 0) {
+        return false;
+    }
 
-        tx.vout[0].nValue -= nFee;
+    // get vin
+    std::set<std::pair<const CWalletTx*, unsigned int>>::iterator it = setCoins.begin();
+    COutPoint out{it->first->tx->GetHash(), it->second};
 
-        LogPrint (BCLog::ALL, "Change in satoshis: %llu\n", tx.vout[0].nValue);
-        LogPrint (BCLog::ALL, "\n");
-        
-        //! sign tx again with correct fee in place
-        if (!vpwallets[0]->SignTransaction(tx)) {
+    opreturn_input input;
+    {
+        LOCK(vpwallets[0]->cs_wallet);
+        if (!get_opreturn_input(vpwallets[0].get(), out, input)) {
             return false;
         }
+    }
+
+    if (!build_selfsend_transaction(vpwallets[0].get(), input, opPayload, tx)) {
+        return false;
+    }
 
 //
 // Harness: uncomment the following three lines to bail from 
 // putfile before committing to wallet and blockchain - MH
 //
-// LogPrint (BCLog::ALL, "bail from generate_selfsend_transaction\n");
-// LogPrint (BCLog::ALL, "\n");
+// LogPrint (BCLog::STORAGE, "bail from generate_selfsend_transaction\n");
+// LogPrint (BCLog::STORAGE, "\n");
 // return false;    
 
-        //! commit to wallet and relay to network
-        CTransactionRef txRef = MakeTransactionRef(tx);
-        vpwallets[0]->CommitTransaction(txRef, {}, {});
-    }
+    //! commit to wallet and relay to network
+    CTransactionRef txRef = MakeTransactionRef(tx);
+    vpwallets[0]->CommitTransaction(txRef, {}, {});
+    refill_storage_funding();
 
     return true;
 }
+
+bool generate_selfsend_transaction(WalletContext& wallet_context, CMutableTransaction& tx, std::vector<std::string>& opPayload)
+{
+    std::vector<std::vector<unsigned char>> vchPayload;
+    for (auto& l : opPayload) {
+        vchPayload.push_back(ParseHex(l));
+    }
+
+    return generate_selfsend_transaction(wallet_context, tx, vchPayload);
+}
@@ -6,21 +6,139 @@
 #define BITCOIN_STORAGE_STORAGE_H
 
 #include <string.h>
+#include <merkleblock.h>
 #include <validation.h>
 
+#include <index/storageindex.h>
+
+#include <opfile/src/decode.h>
+#include <opfile/src/encrypt.h>
+
 #include <wallet/wallet.h>
 
+#include <functional>
+#include <memory>
+#include <optional>
+
 using namespace wallet;
 
+bool scan_blocks_for_assets(ChainstateManager& chainman, StorageListQuery query, std::vector<StorageAssetInfo>& assets, std::optional<StorageListCursor>& next);
+//! Scans of list without the index that extended the cached listing of a tenant, that scanned everything, and the tenants cached
+void get_list_cache_stats(uint64_t& extended, uint64_t& rescanned, size_t& tenants);
 bool scan_blocks_for_uuids(ChainstateManager& chainman, std::vector<std::string>& uuid_found, int intCount);
 
 // bool scan_blocks_for_uuids(ChainstateManager& chainman, std::vector<std::string>& uuid_found);
 //bool scan_blocks_for_specific_uuid(ChainstateManager& chainman, std::string& uuid, int& error_level, std::vector<std::string>& chunks,;
 //bool scan_blocks_for_specific_uuid(ChainstateManager& chainman, std::string& uuid, int& error_level, std::vector<std::string>& chunks, int& pintOffset);
 //bool scan_blocks_for_specific_uuid(ChainstateManager& chainman, std::string& uuid, int& error_level, std::vector<std::string>& chunks, int& pintOffset, int pintFlag);
-bool scan_blocks_for_specific_uuid(ChainstateManager& chainman, std::string& uuid, int& error_level, std::vector<std::string>& chunks, int& pintOffset);
+//bool scan_blocks_for_specific_uuid(ChainstateManager& chainman, std::string& uuid, int& error_level, std::vector<std::string>& chunks, int& pintOffset);
+bool scan_blocks_for_specific_uuid(ChainstateManager& chainman, std::string& uuid, int& error_level, chunk_reassembler& file, int& height);
+bool scan_index_for_specific_uuid(std::string& uuid, int& error_level, chunk_reassembler& file, int& height);
+
+//! An asset fetched by scan_blocks_for_specific_uuids, and how far the scan got with it
+struct batch_fetch_asset {
+    std::string uuid;
+    std::string filepath;
+    //! NO_ERROR once the asset is written to filepath
+    int error_level{NO_ERROR};
+    //! Highest block holding a chunk of the asset, -1 if none
+    int height{-1};
+    //! Data chunks and their bytes written
+    int chunks{0};
+    uint64_t bytes{0};
+    //! Written decrypted, from an asset stored encrypted
+    bool encrypted{false};
+
+    // Scan state
+    std::unique_ptr<chunk_reassembler> file;
+    bool hasauth{false};
+    int count{0};
+    int chunktotal{0};
+    int complete_height{-1};
+    uint160 tenant;
+    bool tenant_found{false};
+
+    batch_fetch_asset(std::string uuid_in, std::string filepath_in) : uuid{std::move(uuid_in)}, filepath{std::move(filepath_in)} {}
+};
+
+//! Fetch several assets in one pass over the blocks, rather than one pass each. Each asset is written
+//! to its file as its chunks are found, and left out of the scan once all of them are, its tenant
+//! then being looked for alone. Returns false if the blocks could not be read or the job was cancelled
+bool scan_blocks_for_specific_uuids(ChainstateManager& chainman, std::vector<batch_fetch_asset>& assets);
+//! Read the header chunk and data chunks first to first + count - 1 of an asset from the storage index, without
+//! checking them, to serve to a peer. False if the index does not hold them all
+bool read_asset_chunks(const std::string& uuid, uint32_t first, uint32_t count, CScript& header, uint32_t& chunktotal, std::vector<CScript>& chunks);
+
+//! Largest range fetch_asset_range returns at once
+static const uint64_t MAX_FETCHRANGE_LENGTH = 8 << 20;
+
+//! Reads byte ranges of an asset through the storage index, reading only the chunks holding them
+class asset_range_reader
+{
+public:
+    //! takes the bytes read, in file order. returning false stops the read
+    using sink_t = std::function<bool(Span<const unsigned char>)>;
+
+    explicit asset_range_reader (const std::string& uuid);
+
+    //! look up and authenticate the header chunk. must succeed before anything else is called
+    bool open (int& error_level);
+
+    //! length of the file, without the protocol 01 extension
+    uint64_t filelen () const { return m_filelen; }
+
+    //! extension the file was stored with, empty if none
+    const std::string& extension () const { return m_extension; }
+
+    //! hand up to length bytes of the file from offset to sink. protocol 02 chunks are checked
+    //! against the merkle root of the file only when the range reaches its end
+    bool read (uint64_t offset, uint64_t length, int& error_level, const sink_t& sink);
+
+private:
+    bool read_chunks (uint32_t first, uint32_t last, int& error_level, const sink_t& sink);
+    bool read_stored (uint64_t offset, uint64_t length, int& error_level, const sink_t& sink);
+
+    const std::string m_uuid;
+    StorageAssetInfo m_info;
+    int m_authheight{0};
+    uint32_t m_chunkmax{0};
+    bool m_compressed{false};
+    //! set for an asset stored encrypted, whose chunks are decrypted as read
+    std::optional<asset_cipher> m_cipher;
+    std::vector<unsigned char> m_plain;
+    uint64_t m_filelen{0};
+    std::string m_extension;
+    uint256 m_merkleroot;
+    //! protocol 02 merkle leaves of the chunks read so far, from the first
+    std::vector<uint256> m_leaves;
+};
+
+//! Read up to length (at most MAX_FETCHRANGE_LENGTH) bytes of an asset from offset, through the storage
+//! index, reading only the chunks holding them. filelen is set to the length of the whole file
+bool fetch_asset_range(std::string uuid, uint64_t offset, uint64_t length, std::vector<unsigned char>& data, uint64_t& filelen, int& error_level);
+//! The transactions of a block holding chunks of an asset, with the merkle branches proving them
+struct asset_block_proof {
+    const CBlockIndex* index;
+    CMerkleBlock merkleblock;
+    std::vector<CTransactionRef> txs;
+};
+
+//! Build the proof that every chunk of an asset is in the active chain, through the storage index: the
+//! transactions holding its header chunk and data chunks, one merkle block per block holding any of them
+bool build_asset_proof(ChainstateManager& chainman, const std::string& uuid, uint32_t& chunktotal, std::vector<asset_block_proof>& proofs, int& error_level);
 void estimate_coins_for_opreturn(CWallet* wallet, int& suitable_inputs);
 bool select_coins_for_opreturn(CWallet* wallet, std::set<std::pair<const CWalletTx*, unsigned int>>& setCoinsRet, CAmount& valueRet);
+
+//! A wallet coin reserved to pay for one putfile transaction
+struct opreturn_input {
+    COutPoint outpoint;
+    Coin coin;
+};
+
+bool reserve_coins_for_opreturn(CWallet* wallet, int count, std::vector<opreturn_input>& inputs);
+void release_coins_for_opreturn(CWallet* wallet, const std::vector<opreturn_input>& inputs);
+bool build_selfsend_transaction(CWallet* wallet, const opreturn_input& input, std::vector<std::vector<unsigned char>>& opPayload, CMutableTransaction& tx);
 bool generate_selfsend_transaction(WalletContext& wallet_context, CMutableTransaction& tx, std::vector<std::string>& opPayload);
+bool generate_selfsend_transaction(WalletContext& wallet_context, CMutableTransaction& tx, std::vector<std::vector<unsigned char>>& opPayload);
 
 #endif // BITCOIN_STORAGE_STORAGE_H
@@ -0,0 +1,110 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <storage/uploads.h>
+
+#include <logging.h>
+#include <streams.h>
+#include <util/fs_helpers.h>
+
+#include <stdexcept>
+
+std::unique_ptr<StorageUploads> g_storage_uploads;
+
+bool StorageUploads::Load()
+{
+    LOCK(m_mutex);
+    m_uploads.clear();
+    AutoFile file{fsbridge::fopen(m_path, "rb")};
+    if (file.IsNull()) {
+        return false;
+    }
+
+    try {
+        uint64_t version;
+        file >> version;
+        if (version != STORAGE_UPLOADS_VERSION) {
+            LogPrintf("%s: unsupported %s version %d\n", __func__, fs::PathToString(m_path), version);
+            return false;
+        }
+
+        std::vector<UploadProgress> uploads;
+        file >> uploads;
+        for (auto& progress : uploads) {
+            const std::string uuid{progress.uuid};
+            m_uploads.emplace(uuid, std::move(progress));
+        }
+    } catch (const std::exception& e) {
+        LogPrintf("%s: failed to deserialize %s: %s\n", __func__, fs::PathToString(m_path), e.what());
+        m_uploads.clear();
+        return false;
+    }
+
+    LogPrint(BCLog::STORAGE, "Loaded %d unfinished puts from disk\n", m_uploads.size());
+    return true;
+}
+
+bool StorageUploads::Write() const
+{
+    std::vector<UploadProgress> uploads;
+    uploads.reserve(m_uploads.size());
+    for (const auto& [uuid, progress] : m_uploads) {
+        uploads.push_back(progress);
+    }
+
+    const fs::path temp_path{m_path + ".new"};
+    try {
+        AutoFile file{fsbridge::fopen(temp_path, "wb")};
+        if (file.IsNull()) {
+            return false;
+        }
+
+        file << STORAGE_UPLOADS_VERSION << uploads;
+
+        if (!FileCommit(file.Get())) {
+            throw std::runtime_error("FileCommit failed");
+        }
+        file.fclose();
+        if (!RenameOver(temp_path, m_path)) {
+            throw std::runtime_error("Rename failed");
+        }
+    } catch (const std::exception& e) {
+        LogPrintf("%s: failed to write %s: %s\n", __func__, fs::PathToString(m_path), e.what());
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<UploadProgress> StorageUploads::Pending() const
+{
+    LOCK(m_mutex);
+    std::vector<UploadProgress> uploads;
+    for (const auto& [uuid, progress] : m_uploads) {
+        uploads.push_back(progress);
+    }
+    return uploads;
+}
+
+bool StorageUploads::Get(const std::string& uuid, UploadProgress& progress) const
+{
+    LOCK(m_mutex);
+    auto it{m_uploads.find(uuid)};
+    if (it == m_uploads.end()) return false;
+    progress = it->second;
+    return true;
+}
+
+bool StorageUploads::Update(const UploadProgress& progress)
+{
+    LOCK(m_mutex);
+    m_uploads[progress.uuid] = progress;
+    return Write();
+}
+
+void StorageUploads::Remove(const std::string& uuid)
+{
+    LOCK(m_mutex);
+    if (m_uploads.erase(uuid)) Write();
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_STORAGE_UPLOADS_H
+#define BITCOIN_STORAGE_UPLOADS_H
+
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+#include <util/fs.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+//! Version of the storageuploads.dat file format
+static constexpr uint64_t STORAGE_UPLOADS_VERSION{2};
+
+/** How far a put got, as the batches it committed to the wallet */
+struct UploadProgress {
+    std::string uuid;
+    std::string path;
+    bool compact{false};
+    bool compress{false};
+    bool encrypt{false};
+    //! The signed header chunk, so that a resumed put needs no authentication
+    std::vector<unsigned char> header;
+    //! Transaction of each batch committed, in the order of the batches
+    std::vector<uint256> txids;
+
+    SERIALIZE_METHODS(UploadProgress, obj)
+    {
+        READWRITE(obj.uuid, obj.path, obj.compact, obj.compress, obj.encrypt, obj.header, obj.txids);
+    }
+};
+
+/**
+ * Puts that have committed batches of their asset to the wallet but not
+ * finished, persisted to storageuploads.dat as each batch is committed. A put
+ * cut short by a shutdown or crash is queued again at startup under its uuid,
+ * and encodes the file again, skipping the batches the wallet still holds.
+ */
+class StorageUploads
+{
+private:
+    const fs::path m_path;
+
+    mutable Mutex m_mutex;
+    std::map<std::string, UploadProgress> m_uploads GUARDED_BY(m_mutex);
+
+    bool Write() const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+public:
+    explicit StorageUploads(const fs::path& path) : m_path(path) {}
+
+    /// Read the puts left unfinished. Returns false, with none, if the file is missing or unreadable.
+    bool Load() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// The puts left unfinished.
+    std::vector<UploadProgress> Pending() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// The progress of the put of uuid. Returns false if there is none.
+    bool Get(const std::string& uuid, UploadProgress& progress) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Record the progress of a put, writing it to disk.
+    bool Update(const UploadProgress& progress) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /// Forget the put of uuid, once it has finished.
+    void Remove(const std::string& uuid) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+/// The global record of unfinished puts. May be null.
+extern std::unique_ptr<StorageUploads> g_storage_uploads;
+
+#endif // BITCOIN_STORAGE_UPLOADS_H
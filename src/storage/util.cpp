@@ -93,14 +93,19 @@ bool strip_opreturndata_from_chunk (std::string& opdata, std::string& chunk, int
     return true;
 }
 
-CTxOut build_opreturn_txout(std::string& payload)
+CTxOut build_opreturn_txout(const std::vector<unsigned char>& payload)
 {
     CScript scriptOp;
-    scriptOp << OP_RETURN << ParseHex(payload);
+    scriptOp << OP_RETURN << payload;
     CTxOut opreturn_out(0, scriptOp);
     return opreturn_out;
 }
 
+CTxOut build_opreturn_txout(std::string& payload)
+{
+    return build_opreturn_txout(ParseHex(payload));
+}
+
 /*
 void is_valid_chunk(std::string& chunk, int& type)
 {
@@ -194,12 +199,12 @@ bool is_valid_uuid(std::string& uuid, int& invalidity_type)
 {
     invalidity_type = 0;
     if (uuid.size() != OPENCODING_UUID*2) {
-        //LogPrint (BCLog::ALL, "Invalid uuid length: %s\n", uuid);
+        //LogPrint (BCLog::STORAGE, "Invalid uuid length: %s\n", uuid);
         invalidity_type = 1;
         return false;
     }    
     if (!is_hex_notation(uuid)) {
-        //LogPrint (BCLog::ALL, "Invalid uuid hex notation: %s\n", uuid);
+        //LogPrint (BCLog::STORAGE, "Invalid uuid hex notation: %s\n", uuid);
         invalidity_type = 2;
         return false;
     }  
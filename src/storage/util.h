@@ -15,6 +15,7 @@ void set_chainman_context(ChainstateManager& chainman_context);
 //bool strip_opreturndata_from_chunk(std::string& opdata, std::string& chunk);
 bool strip_opreturndata_from_chunk (std::string& opdata, std::string& chunk, int& pintOffset);
 CTxOut build_opreturn_txout(std::string& payload);
+CTxOut build_opreturn_txout(const std::vector<unsigned char>& payload);
 // void is_valid_chunk(std::string& chunk, int& type);
 void is_valid_chunk (std::string& chunk, int& type, int pintOffset);
 std::string unixtime_to_hexstring(uint32_t& time);
@@ -4,68 +4,363 @@
 
 #include <time.h>
 
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <thread>
+
+#include <index/storageindex.h>
+#include <key_io.h>
+#include <node/jobs.h>
 #include <opfile/src/decode.h>
 #include <opfile/src/encode.h>
 #include <opfile/src/protocol.h>
 #include <opfile/src/util.h>
+#include <shutdown.h>
+#include <storage/auth.h>
+#include <storage/cache.h>
+#include <storage/funding.h>
+#include <storage/peerfetch.h>
+#include <storage/stats.h>
 #include <storage/storage.h>
+#include <storage/uploads.h>
 #include <storage/worker.h>
+#include <sync.h>
+#include <txmempool.h>
+#include <util/system.h>
+#include <util/time.h>
+#include <util/trace.h>
+
+//! Kinds of the storage jobs on the job queue
+static const std::string STORAGE_PUT_KIND{"store"};
+static const std::string STORAGE_PUT_BATCH_KIND{"storebatch"};
+static const std::string STORAGE_GET_KIND{"fetch"};
+static const std::string STORAGE_GET_BATCH_KIND{"fetchbatch"};
+static const std::string STORAGE_LIST_KIND{"list"};
+//! Puts spend from the wallet, so run one at a time
+static const std::string STORAGE_PUT_GROUP{"storage-put"};
+//! Kind, and id, of the job refilling the funding pool
+static const std::string STORAGE_FUNDING_KIND{"storage-funding"};
+
+extern std::string authUserKey;
+extern ChainstateManager* storage_chainman;
+extern wallet::WalletContext* storage_context;
 
-int workerStatus;
-RecursiveMutex workQueueLock, workResultLock;
+void perform_put_task(std::pair<std::string, std::string>& put_info, int& error_level, uint64_t& bytes, int& chunks);
+void perform_put_batch_task(std::vector<std::pair<std::string, std::string>>& files, int& error_level, uint64_t& bytes, int& chunks);
+void perform_get_task(std::pair<std::string, std::string> get_info, int& error_level, uint64_t& bytes, int& chunks);
+void perform_get_batch_task(const std::vector<std::string>& uuids, const std::string& path, std::vector<int>& error_levels, uint64_t& bytes, int& chunks);
 
-std::vector<std::pair<std::string, std::string>> workQueuePut;
-std::vector<std::pair<std::string, std::string>> workQueueGet;
-std::vector<std::pair<std::string, std::string>> workQueueResult;
+static const char* error_level_string(int error_level);
 
-extern ChainstateManager* storage_chainman;
-extern wallet::WalletContext* storage_context;
+// Put jobs are keyed on the uuid being stored, returns empty if that uuid is already queued
+std::string add_put_task(std::string put_info, std::string put_uuid, node::JobPriority priority, const std::string& tenant)
+{
+    if (!node::g_job_queue) return "";
+    auto info = std::make_pair(put_info, put_uuid);
+    const auto submitted{SteadyClock::now()};
+    return node::g_job_queue->Submit(STORAGE_PUT_KIND, [info, submitted]() mutable -> UniValue {
+        RecordStorageJobWait(SteadyClock::now() - submitted);
+        if (!storage_context) {
+            throw std::runtime_error(strprintf("putTask %s had error_level %s", info.first, error_level_string(ERR_NOWALLET)));
+        }
+        int error_level = NO_ERROR;
+        uint64_t bytes = 0;
+        int chunks = 0;
+        TRACE2(storage, job_start, STORAGE_PUT_KIND.c_str(), info.second.c_str());
+        const auto start{SteadyClock::now()};
+        perform_put_task(info, error_level, bytes, chunks);
+        RecordStorageOp(StorageOp::STORE, SteadyClock::now() - start);
+        TRACE6(storage, job_end,
+            STORAGE_PUT_KIND.c_str(),
+            info.second.c_str(),
+            error_level,
+            bytes,
+            chunks,
+            Ticks<std::chrono::microseconds>(SteadyClock::now() - start));
+        // Puts cut short by a shutdown or by the wallet are resumed from the batches they committed
+        if (g_storage_uploads && !ShutdownRequested() &&
+            error_level != ERR_LOWINPUTS && error_level != ERR_TXGENERATE) {
+            g_storage_uploads->Remove(info.second);
+        }
+        if (error_level != NO_ERROR) {
+            throw std::runtime_error(strprintf("putTask %s had error_level %s", info.first, error_level_string(error_level)));
+        }
+        return strprintf("putTask %s completed successfully", info.first);
+    }, put_uuid, STORAGE_PUT_GROUP, priority, tenant, read_file_size(put_info) > STORAGE_LARGE_JOB_SIZE).value_or("");
+}
+
+// Batches of puts are keyed on a new job hash, and run one at a time along with the puts
+std::string add_put_batch_task(std::vector<std::pair<std::string, std::string>> files, node::JobPriority priority, const std::string& tenant)
+{
+    if (!node::g_job_queue) return "";
+    int64_t total_bytes = 0;
+    for (const auto& file : files) {
+        total_bytes += std::max(read_file_size(file.first), 0);
+    }
+    const auto submitted{SteadyClock::now()};
+    return node::g_job_queue->Submit(STORAGE_PUT_BATCH_KIND, [files, submitted]() mutable -> UniValue {
+        RecordStorageJobWait(SteadyClock::now() - submitted);
+        if (!storage_context) {
+            throw std::runtime_error(strprintf("putBatchTask of %d files had error_level %s", files.size(), error_level_string(ERR_NOWALLET)));
+        }
+        int error_level = NO_ERROR;
+        uint64_t bytes = 0;
+        int chunks = 0;
+        TRACE2(storage, job_start, STORAGE_PUT_BATCH_KIND.c_str(), files.front().second.c_str());
+        const auto start{SteadyClock::now()};
+        perform_put_batch_task(files, error_level, bytes, chunks);
+        RecordStorageOp(StorageOp::STORE, SteadyClock::now() - start);
+        TRACE6(storage, job_end,
+            STORAGE_PUT_BATCH_KIND.c_str(),
+            files.front().second.c_str(),
+            error_level,
+            bytes,
+            chunks,
+            Ticks<std::chrono::microseconds>(SteadyClock::now() - start));
+        if (error_level != NO_ERROR) {
+            throw std::runtime_error(strprintf("putBatchTask of %d files had error_level %s", files.size(), error_level_string(error_level)));
+        }
+        return strprintf("putBatchTask of %d files completed successfully", files.size());
+    }, /*id=*/"", STORAGE_PUT_GROUP, priority, tenant, total_bytes > STORAGE_LARGE_JOB_SIZE).value_or("");
+}
+
+// Queue again the puts a shutdown or crash left unfinished
+void resume_storage_uploads()
+{
+    if (!g_storage_uploads) return;
+    for (const auto& progress : g_storage_uploads->Pending()) {
+        LogPrintf("Resuming put of %s as uuid %s, %d batches committed\n", progress.path, progress.uuid, progress.txids.size());
+        add_put_task(progress.path, progress.uuid);
+    }
+}
+
+// Refills spend from the wallet like puts do, and are keyed on their kind so that one is queued at a time.
+// They run after the puts waiting, which are what the pool is there for
+void refill_storage_funding()
+{
+    if (!node::g_job_queue || !g_storage_funding) return;
+    node::g_job_queue->Submit(STORAGE_FUNDING_KIND, []() -> UniValue {
+        if (!storage_context) return 0;
+        auto vpwallets = GetWallets(*storage_context);
+        if (vpwallets.empty()) return 0;
+        return g_storage_funding->Refill(*vpwallets.front());
+    }, STORAGE_FUNDING_KIND, STORAGE_PUT_GROUP, node::JobPriority::LOW);
+}
+
+// Get jobs are keyed on a new job hash. Without the index, or its length, a get scans the chain, which takes long
+static bool is_large_get(const std::string& uuid)
+{
+    StorageAssetInfo info;
+    if (!g_storage_index || !g_storage_index->FindAsset(uuid, info) || !info.length) return true;
+    return info.GetFileLength() > STORAGE_LARGE_JOB_SIZE;
+}
+
+std::string add_get_task(std::pair<std::string, std::string> get_info, node::JobPriority priority, const std::string& tenant)
+{
+    if (!node::g_job_queue) return "";
+    const bool large = is_large_get(get_info.first);
+    const auto submitted{SteadyClock::now()};
+    return *node::g_job_queue->Submit(STORAGE_GET_KIND, [get_info, submitted]() -> UniValue {
+        RecordStorageJobWait(SteadyClock::now() - submitted);
+        if (!storage_chainman) {
+            throw std::runtime_error(strprintf("getTask %s, %s had error_level %s", get_info.first, get_info.second, error_level_string(ERR_NOWALLET)));
+        }
+        int error_level = NO_ERROR;
+        uint64_t bytes = 0;
+        int chunks = 0;
+        TRACE2(storage, job_start, STORAGE_GET_KIND.c_str(), get_info.first.c_str());
+        const auto start{SteadyClock::now()};
+        perform_get_task(get_info, error_level, bytes, chunks);
+        RecordStorageOp(StorageOp::FETCH, SteadyClock::now() - start);
+        TRACE6(storage, job_end,
+            STORAGE_GET_KIND.c_str(),
+            get_info.first.c_str(),
+            error_level,
+            bytes,
+            chunks,
+            Ticks<std::chrono::microseconds>(SteadyClock::now() - start));
+        if (error_level != NO_ERROR) {
+            throw std::runtime_error(strprintf("getTask %s, %s had error_level %s", get_info.first, get_info.second, error_level_string(error_level)));
+        }
+        return strprintf("getTask %s, %s completed successfully", get_info.first, get_info.second);
+    }, /*id=*/"", /*group=*/"", priority, tenant, large);
+}
+
+// Batches of gets are keyed on a new job hash, and return {uuid: "success" or the error_level of the uuid}
+std::string add_get_batch_task(std::vector<std::string> uuids, std::string path, node::JobPriority priority, const std::string& tenant)
+{
+    if (!node::g_job_queue) return "";
+    const bool large = g_storage_index == nullptr || std::any_of(uuids.begin(), uuids.end(), is_large_get);
+    const auto submitted{SteadyClock::now()};
+    return *node::g_job_queue->Submit(STORAGE_GET_BATCH_KIND, [uuids, path, submitted]() -> UniValue {
+        RecordStorageJobWait(SteadyClock::now() - submitted);
+        if (!storage_chainman) {
+            throw std::runtime_error(strprintf("getBatchTask of %d uuids, %s had error_level %s", uuids.size(), path, error_level_string(ERR_NOWALLET)));
+        }
+        std::vector<int> error_levels;
+        uint64_t bytes = 0;
+        int chunks = 0;
+        TRACE2(storage, job_start, STORAGE_GET_BATCH_KIND.c_str(), path.c_str());
+        const auto start{SteadyClock::now()};
+        perform_get_batch_task(uuids, path, error_levels, bytes, chunks);
+        RecordStorageOp(StorageOp::FETCH, SteadyClock::now() - start);
+        TRACE6(storage, job_end,
+            STORAGE_GET_BATCH_KIND.c_str(),
+            path.c_str(),
+            NO_ERROR,
+            bytes,
+            chunks,
+            Ticks<std::chrono::microseconds>(SteadyClock::now() - start));
+        if (job_cancel_requested()) {
+            throw std::runtime_error(strprintf("getBatchTask of %d uuids, %s was cancelled", uuids.size(), path));
+        }
+        UniValue results(UniValue::VOBJ);
+        for (size_t i = 0; i < uuids.size(); ++i) {
+            results.pushKV(uuids[i], error_levels[i] == NO_ERROR ? "success" : error_level_string(error_levels[i]));
+        }
+        return results;
+    }, /*id=*/"", /*group=*/"", priority, tenant, large);
+}
+
+// List jobs return {"assets": [{uuid, length, height, time}...], "next_cursor"}, height -1 for assets in the
+// mempool. Without the index a page scans the chain
+std::string add_list_task(int count, const std::string& cursor, const std::string& tenant)
+{
+    if (!node::g_job_queue) return "";
+    StorageListQuery query;
+    query.count = count;
+    if (!cursor.empty()) {
+        query.cursor = StorageListCursor::FromString(cursor);
+        if (!query.cursor) return "";
+    }
+    const auto submitted{SteadyClock::now()};
+    return *node::g_job_queue->Submit(STORAGE_LIST_KIND, [query, submitted]() -> UniValue {
+        RecordStorageJobWait(SteadyClock::now() - submitted);
+        if (!storage_chainman) {
+            throw std::runtime_error("listTask had no chain");
+        }
+        std::vector<StorageAssetInfo> assets;
+        std::optional<StorageListCursor> next;
+        scan_blocks_for_assets(*storage_chainman, query, assets, next);
+        UniValue page(UniValue::VOBJ);
+        UniValue list(UniValue::VARR);
+        for (const auto& asset : assets) {
+            UniValue entry(UniValue::VOBJ);
+            entry.pushKV("uuid", asset.uuid);
+            entry.pushKV("length", asset.GetFileLength());
+            entry.pushKV("height", asset.header.height == STORAGE_MEMPOOL_HEIGHT ? -1 : asset.header.height);
+            entry.pushKV("time", asset.header.time);
+            list.push_back(std::move(entry));
+        }
+        page.pushKV("assets", std::move(list));
+        if (next) page.pushKV("next_cursor", next->ToString());
+        return page;
+    }, /*id=*/"", /*group=*/"", node::JobPriority::NORMAL, tenant, /*large=*/!g_storage_index);
+}
 
-void add_put_task(std::string put_info, std::string put_uuid)
+// Report progress of the job running on this thread
+void set_job_progress(int done, int total)
 {
-    LOCK(workQueueLock);
-    add_result_entry();
-    workQueuePut.push_back(std::make_pair(put_info, put_uuid));
+    node::SetJobProgress(done, total);
 }
 
-void add_get_task(std::pair<std::string, std::string> get_info)
+// Whether the job running on this thread should stop
+bool job_cancel_requested()
 {
-    LOCK(workQueueLock);
-    add_result_entry();
-    workQueueGet.push_back(get_info);
+    return node::JobCancelRequested();
 }
 
-void add_result_entry()
+// Let a small or more urgent job waiting for a thread run on this one
+bool job_yield()
 {
-    LOCK(workResultLock);
-    workQueueResult.push_back(std::pair(generate_uuid(8), std::string("")));
+    return node::JobYield();
 }
 
-std::string get_result_hash()
+static std::vector<node::JobInfo> storage_jobs(size_t count)
 {
-    LOCK(workResultLock);
-    return workQueueResult.back().first;
+    std::vector<node::JobInfo> jobs;
+    if (!node::g_job_queue) return jobs;
+    for (auto& job : node::g_job_queue->List(node::MAX_JOBS_KEPT)) {
+        if (job.kind == STORAGE_PUT_KIND || job.kind == STORAGE_PUT_BATCH_KIND || job.kind == STORAGE_GET_KIND || job.kind == STORAGE_GET_BATCH_KIND) {
+            jobs.push_back(std::move(job));
+        }
+    }
+    if (jobs.size() > count) {
+        jobs.erase(jobs.begin(), jobs.end() - count);
+    }
+    return jobs;
 }
 
-void add_result_text(std::string& result)
+void get_storage_job_counts(size_t& queued, size_t& running)
 {
-    LOCK(workResultLock);
-    workQueueResult.back().second = result;
+    queued = running = 0;
+    if (!node::g_job_queue) return;
+    for (const auto& [kind, counts] : node::g_job_queue->Count()) {
+        if (kind == STORAGE_PUT_KIND || kind == STORAGE_PUT_BATCH_KIND || kind == STORAGE_GET_KIND || kind == STORAGE_GET_BATCH_KIND ||
+            kind == STORAGE_LIST_KIND || kind == STORAGE_FUNDING_KIND) {
+            queued += counts.queued;
+            running += counts.running;
+        }
+    }
 }
 
 void get_storage_worker_status(int& status)
 {
-    LOCK(workQueueLock);
-    status = workerStatus;
+    status = WORKER_IDLE;
+    for (const auto& job : storage_jobs(node::MAX_JOBS_KEPT)) {
+        if (job.state == node::JobState::RUNNING) status = WORKER_BUSY;
+    }
 }
 
-void set_storage_worker_status(int status)
+// Status of the count most recent jobs, oldest first
+void get_storage_job_status(std::vector<std::string>& jobs, int count)
 {
-    LOCK(workQueueLock);
-    workerStatus = status;
+    jobs.clear();
+
+    // Stored uuids, with the position of their status line
+    std::vector<std::pair<std::string, size_t>> stored;
+    for (const auto& job : storage_jobs(std::max(0, count))) {
+        if (job.state == node::JobState::QUEUED) {
+            jobs.push_back(job.id + ", queued");
+        } else if (job.state == node::JobState::RUNNING) {
+            jobs.push_back(strprintf("%s, running %d/%d", job.id, job.progress_done, job.progress_total));
+        } else if (job.state == node::JobState::DONE) {
+            if (job.kind == STORAGE_PUT_KIND) {
+                stored.emplace_back(job.id, jobs.size());
+            }
+            jobs.push_back(job.id + ", " + job.result.get_str());
+        } else if (job.state == node::JobState::FAILED) {
+            jobs.push_back(job.id + ", " + job.error);
+        } else {
+            jobs.push_back(job.id + ", cancelled");
+        }
+    }
+
+    // Confirmation progress of stored assets, looked up outside the lock
+    if (!g_storage_index) {
+        return;
+    }
+    for (const auto& [uuid, line] : stored) {
+        uint32_t confirmed, total;
+        if (g_storage_index->FindConfirmations(uuid, confirmed, total) && total > 0) {
+            jobs[line] += strprintf(", confirmed %d/%d", confirmed, total);
+        }
+    }
+}
+
+// bytes and chunks are those of the file stored, as far as the put got
+// The tenant key is the secret its assets are encrypted with, so whichever node it authenticates on reads them
+static Span<const unsigned char> encrypt_secret(const CKey& key, bool encrypt)
+{
+    return encrypt ? Span<const unsigned char>{key.begin(), key.size()} : Span<const unsigned char>{};
 }
 
-void perform_put_task(std::pair<std::string, std::string>& put_info, int& error_level)
+void perform_put_task(std::pair<std::string, std::string>& put_info, int& error_level, uint64_t& bytes, int& chunks)
 {
     // get wallet handle
     auto vpwallets = GetWallets(*storage_context);
@@ -78,38 +373,68 @@ void perform_put_task(std::pair<std::string, std::string>& put_info, int& error_
     // see if there are enough inputs
     int usable_inputs;
     int filelen = read_file_size(put_info.first);
+    bytes = std::max(filelen, 0);
 
     // check file length
     int maxfilelength = 23 * 1024 * 1024;
     if (filelen > maxfilelength) {
-        LogPrint (BCLog::ALL, "File length exceeds max file length. filelen: %d maxfilelength: %d\n", filelen, maxfilelength);
+        LogPrint (BCLog::STORAGE, "File length exceeds max file length. filelen: %d maxfilelength: %d\n", filelen, maxfilelength);
         error_level = ERR_FILELENGTH;
         return;
     }
 
+    CWallet* wallet = vpwallets.front().get();
+
+    // a put resumed keeps the protocol and header it started with, and skips
+    // the batches the wallet still holds, up to the first it dropped
+    UploadProgress progress;
+    const bool resumed = g_storage_uploads && g_storage_uploads->Get(put_info.second, progress) && progress.path == put_info.first;
+    if (!resumed) {
+        progress = UploadProgress{};
+        progress.uuid = put_info.second;
+        progress.path = put_info.first;
+        progress.compact = gArgs.GetBoolArg("-storagecompact", DEFAULT_STORAGE_COMPACT);
+        progress.compress = gArgs.GetBoolArg("-storagecompress", DEFAULT_STORAGE_COMPRESS);
+        progress.encrypt = gArgs.GetBoolArg("-storageencrypt", DEFAULT_STORAGE_ENCRYPT);
+    }
+    size_t skip_batches = 0;
+    if (resumed) {
+        LOCK(wallet->cs_wallet);
+        while (skip_batches < progress.txids.size()) {
+            const CWalletTx* wtx = wallet->GetWalletTx(progress.txids[skip_batches]);
+            if (!wtx || wtx->isAbandoned() || wallet->GetTxDepthInMainChain(*wtx) < 0) {
+                break;
+            }
+            ++skip_batches;
+        }
+        progress.txids.resize(skip_batches);
+        LogPrint (BCLog::STORAGE, "Resuming put of uuid %s after %d batches\n", put_info.second, skip_batches);
+    }
+
     int est_chunks = calculate_chunks_from_filesize(filelen);
-    estimate_coins_for_opreturn(vpwallets.front().get(), usable_inputs);
+    estimate_coins_for_opreturn(wallet, usable_inputs);
 
-    LogPrint (BCLog::ALL, "File length: %d\n", filelen);
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::STORAGE, "File length: %d\n", filelen);
+    LogPrint (BCLog::STORAGE, "\n");
 
-    LogPrint (BCLog::ALL, "Number of chunks per transactuion: %d\n", OPRETURN_PER_TX);
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::STORAGE, "Number of chunks per transactuion: %d\n", OPRETURN_PER_TX);
+    LogPrint (BCLog::STORAGE, "\n");
 
-    LogPrint (BCLog::ALL, "Number of groups of %d chunks %d\n", OPRETURN_PER_TX, (est_chunks+(OPRETURN_PER_TX-1))/OPRETURN_PER_TX);
-    LogPrint (BCLog::ALL, "\n");
+    LogPrint (BCLog::STORAGE, "Number of groups of %d chunks %d\n", OPRETURN_PER_TX, (est_chunks+(OPRETURN_PER_TX-1))/OPRETURN_PER_TX);
+    LogPrint (BCLog::STORAGE, "\n");
 
-    // one usable input per batch of 256 chunks
-    if (usable_inputs < ((est_chunks+(OPRETURN_PER_TX-1))/OPRETURN_PER_TX)) {
+    // ideally one usable input per batch of 256 chunks, batches beyond them are chained
+    if (usable_inputs < 1) {
         error_level = ERR_LOWINPUTS;
         return;
     }
 
-    // build chunks from file
-    int total_chunks;
-    std::vector<std::string> encoded_chunks;
-    if (!build_chunks_with_headers(put_info, error_level, total_chunks, encoded_chunks)) {
-        //pass error_level back
+    // reserve every input up front, allowing for the header chunk and for the file
+    // extension spilling into one more chunk. Inputs left over are released at the end
+    const int est_txes = std::max<int>(1, (est_chunks + 2 + (OPRETURN_PER_TX - 1)) / OPRETURN_PER_TX - skip_batches);
+    std::vector<opreturn_input> inputs;
+    if (!reserve_coins_for_opreturn(wallet, std::min(est_txes, usable_inputs), inputs)) {
+        error_level = ERR_LOWINPUTS;
         return;
     }
 
@@ -117,112 +442,363 @@ void perform_put_task(std::pair<std::string, std::string>& put_info, int& error_
 //error_level = ERR_LOWINPUTS;
 //return;    
 
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "CREATE AND SUBMIT CHUNK TRANSACTIONS (perform_put_task)\n");
-    LogPrint (BCLog::ALL, "For each group of 256 chunks, there will be one putfile transaction\n");
-    LogPrint (BCLog::ALL, "For each putfile transaction, there will be one input, used to pay for the transaction.\n");
-    LogPrint (BCLog::ALL, "For each putfile transaction, the first output will be the change from the input.\n");
-    LogPrint (BCLog::ALL, "The change from the input is the value of the input minus the cost of chunk storage.\n");
-    LogPrint (BCLog::ALL, "The cost of chunk storage is one satoshi per byte of transaction.\n");
-    LogPrint (BCLog::ALL, "For each putfile transaction, there will be one output per chunk.\n");
-    LogPrint (BCLog::ALL, "A chunk output output-script is the chunk prepended with 106 as a single byte.\n");
-    LogPrint (BCLog::ALL, "Chunk outputs have a value of zero satoshis\n");
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "For each putfile transaction, the value of the input is given.\n");
-    LogPrint (BCLog::ALL, "Next, the number of transaction bytes is given.\n");
-    LogPrint (BCLog::ALL, "Next, the number of satoshis used to pay for the storage is given.\n");
-    LogPrint (BCLog::ALL, "Finally, the amount of change from the input is given.\n");
-    LogPrint (BCLog::ALL, "\n");
-
-    // create tx, sign and submit for each chunk
-    CMutableTransaction txChunk;
-    std::vector<std::string> batch_chunks;
-    if (encoded_chunks.size() <= OPRETURN_PER_TX) {
-        batch_chunks = encoded_chunks;
-        if (!generate_selfsend_transaction(*storage_context, txChunk, batch_chunks)) {
+    LogPrint (BCLog::STORAGE, "\n");
+    LogPrint (BCLog::STORAGE, "CREATE AND SUBMIT CHUNK TRANSACTIONS (perform_put_task)\n");
+    LogPrint (BCLog::STORAGE, "For each group of 256 chunks, there will be one putfile transaction\n");
+    LogPrint (BCLog::STORAGE, "For each putfile transaction, there will be one input, used to pay for the transaction.\n");
+    LogPrint (BCLog::STORAGE, "For each putfile transaction, the first output will be the change from the input.\n");
+    LogPrint (BCLog::STORAGE, "The change from the input is the value of the input minus the cost of chunk storage.\n");
+    LogPrint (BCLog::STORAGE, "The cost of chunk storage is one satoshi per byte of transaction.\n");
+    LogPrint (BCLog::STORAGE, "For each putfile transaction, there will be one output per chunk.\n");
+    LogPrint (BCLog::STORAGE, "A chunk output output-script is the chunk prepended with 106 as a single byte.\n");
+    LogPrint (BCLog::STORAGE, "Chunk outputs have a value of zero satoshis\n");
+    LogPrint (BCLog::STORAGE, "\n");
+    LogPrint (BCLog::STORAGE, "For each putfile transaction, the value of the input is given.\n");
+    LogPrint (BCLog::STORAGE, "Next, the number of transaction bytes is given.\n");
+    LogPrint (BCLog::STORAGE, "Next, the number of satoshis used to pay for the storage is given.\n");
+    LogPrint (BCLog::STORAGE, "Finally, the amount of change from the input is given.\n");
+    LogPrint (BCLog::STORAGE, "\n");
+
+    // encode the file a chunk window at a time, and build and sign the transaction for each
+    // batch of chunks as soon as it is encoded, several at once. Signed transactions are
+    // committed to the wallet and mempool in order, reporting progress in transactions.
+    // With fewer inputs than batches, the inputs are used in turn, each batch after the
+    // first round spending the change of the batch before it on the same input. The
+    // mempool takes such chains of storage transactions up to -limitstoragechaincount.
+    // Each batch committed is recorded, for a restart to resume from
+    int total_chunks = 0;
+    int sent_txes = skip_batches;
+    size_t next_batch = 0;
+    size_t encoded_batches = 0;
+    std::deque<std::shared_future<std::optional<CMutableTransaction>>> pending;
+    std::vector<std::shared_future<std::optional<CMutableTransaction>>> last_on_input(inputs.size());
+
+    auto commit_oldest = [&]() {
+        std::optional<CMutableTransaction> txChunk = pending.front().get();
+        pending.pop_front();
+        if (!txChunk) {
             error_level = ERR_TXGENERATE;
+            return false;
+        }
+        const CTransactionRef tx = MakeTransactionRef(std::move(*txChunk));
+        wallet->CommitTransaction(tx, {}, {});
+        progress.txids.push_back(tx->GetHash());
+        if (g_storage_uploads) {
+            g_storage_uploads->Update(progress);
+        }
+        // header chunk is sent along with the data chunks
+        set_job_progress(++sent_txes, (total_chunks + 1 + (OPRETURN_PER_TX - 1)) / OPRETURN_PER_TX);
+        return true;
+    };
+
+    auto submit_batch = [&](std::vector<std::vector<unsigned char>>& batch_chunks) {
+        if (job_cancel_requested()) {
+            return false;
+        }
+        if (encoded_batches++ < skip_batches) {
+            return true;
+        }
+        // fetches need not wait behind a large put for a thread, they run between its batches
+        job_yield();
+        const size_t lane = next_batch++ % inputs.size();
+        const opreturn_input* reserved = last_on_input[lane].valid() ? nullptr : &inputs[lane];
+        std::shared_future<std::optional<CMutableTransaction>> parent = last_on_input[lane];
+        last_on_input[lane] = std::async(std::launch::async, [wallet, reserved, parent, batch = std::move(batch_chunks)]() mutable {
+            opreturn_input input;
+            if (reserved) {
+                input = *reserved;
+            } else {
+                const std::optional<CMutableTransaction>& parent_tx = parent.get();
+                if (!parent_tx) {
+                    return std::optional<CMutableTransaction>{};
+                }
+                input.outpoint = COutPoint(parent_tx->GetHash(), 0);
+                input.coin = Coin(parent_tx->vout[0], MEMPOOL_HEIGHT, false, false);
+            }
+            CMutableTransaction txChunk;
+            if (!build_selfsend_transaction(wallet, input, batch, txChunk)) {
+                return std::optional<CMutableTransaction>{};
+            }
+            return std::optional<CMutableTransaction>{std::move(txChunk)};
+        }).share();
+        pending.push_back(last_on_input[lane]);
+        // bound the batches held in memory
+        if ((int)pending.size() >= PUT_PIPELINE_DEPTH) {
+            return commit_oldest();
+        }
+        return true;
+    };
+
+    const CKey key = DecodeSecret(authUserKey);
+    bool ok = stream_chunks_with_headers(put_info, key, error_level, total_chunks, submit_batch, progress.compact, progress.compress, gArgs.GetBoolArg("-storagecontenthash", DEFAULT_STORAGE_CONTENTHASH), encrypt_secret(key, progress.encrypt), progress.header);
+    chunks = total_chunks;
+    while (ok && !pending.empty()) {
+        ok = commit_oldest();
+    }
+
+    // wait for transactions still being built, and return the inputs left unspent
+    while (!pending.empty()) {
+        pending.front().wait();
+        pending.pop_front();
+    }
+    release_coins_for_opreturn(wallet, inputs);
+    refill_storage_funding();
+
+    //pass error_level back
+}
+
+// bytes and chunks are those of all the files stored, chunks counting data chunks only as for a put
+void perform_put_batch_task(std::vector<std::pair<std::string, std::string>>& files, int& error_level, uint64_t& bytes, int& chunks)
+{
+    auto vpwallets = GetWallets(*storage_context);
+    if (vpwallets.empty()) {
+        error_level = ERR_NOWALLET;
+        return;
+    }
+    CWallet* wallet = vpwallets.front().get();
+
+    const bool compact = gArgs.GetBoolArg("-storagecompact", DEFAULT_STORAGE_COMPACT);
+    const bool compress = gArgs.GetBoolArg("-storagecompress", DEFAULT_STORAGE_COMPRESS);
+    const bool content_hash = gArgs.GetBoolArg("-storagecontenthash", DEFAULT_STORAGE_CONTENTHASH);
+    const bool encrypt = gArgs.GetBoolArg("-storageencrypt", DEFAULT_STORAGE_ENCRYPT);
+    const CKey key = DecodeSecret(authUserKey);
+
+    // encode every file in full, each asset with its own uuid and header chunk as a put stores it.
+    // the batch is bounded by MAX_STORAGE_BATCH_BYTES, so its chunks are held in memory
+    std::vector<std::vector<std::vector<unsigned char>>> assets(files.size());
+    std::vector<size_t> chunk_counts;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (job_cancel_requested()) {
+            return;
+        }
+        bytes += std::max(read_file_size(files[i].first), 0);
+        int total_chunks = 0;
+        std::vector<unsigned char> signed_header;
+        auto collect = [&asset = assets[i]](std::vector<std::vector<unsigned char>>& batch) {
+            std::move(batch.begin(), batch.end(), std::back_inserter(asset));
+            return true;
+        };
+        if (!stream_chunks_with_headers(files[i], key, error_level, total_chunks, collect, compact, compress, content_hash, encrypt_secret(key, encrypt), signed_header)) {
             return;
         }
+        chunks += total_chunks;
+        chunk_counts.push_back(assets[i].size());
+    }
+
+    const std::vector<std::vector<chunk_run>> plan = plan_chunk_batches(chunk_counts, OPRETURN_PER_TX);
+    LogPrint (BCLog::STORAGE, "Batch of %d files, %d chunks with their headers, packed into %d transactions\n",
+              files.size(), std::accumulate(chunk_counts.begin(), chunk_counts.end(), size_t{0}), plan.size());
+
+    // the transactions chain on a single input, each spending the change of the one before
+    std::vector<opreturn_input> inputs;
+    if (!reserve_coins_for_opreturn(wallet, 1, inputs)) {
+        error_level = ERR_LOWINPUTS;
         return;
-    } else {
-        for (auto &l : encoded_chunks) {
-             batch_chunks.push_back(l);
-             if (batch_chunks.size() == OPRETURN_PER_TX) {
-                 if (!generate_selfsend_transaction(*storage_context, txChunk, batch_chunks)) {
-                     error_level = ERR_TXGENERATE;
-                     return;
-                 }
-                 batch_chunks.clear();
-                 txChunk = CMutableTransaction();
-             }
-        }
-
-        // when the number of chunks is evenly divisible by the nummber of chunks 
-        // per transaction, this final transaction is unnecessary
-        if (batch_chunks.size() > 0) {
-            txChunk = CMutableTransaction();
-            if (!generate_selfsend_transaction(*storage_context, txChunk, batch_chunks)) {
-                error_level = ERR_TXGENERATE;
-                return;
-            }
-            batch_chunks.clear();
-        }    
     }
+
+    // every transaction is built and signed before any is committed, so a
+    // batch the input can not pay for leaves nothing half stored
+    std::vector<CTransactionRef> txs;
+    txs.reserve(plan.size());
+    opreturn_input input = inputs.front();
+    for (const auto& runs : plan) {
+        if (job_cancel_requested()) {
+            break;
+        }
+        std::vector<std::vector<unsigned char>> batch_chunks;
+        for (const chunk_run& run : runs) {
+            auto& asset = assets[run.asset];
+            std::move(asset.begin() + run.first, asset.begin() + run.first + run.count, std::back_inserter(batch_chunks));
+        }
+        CMutableTransaction txChunk;
+        if (!build_selfsend_transaction(wallet, input, batch_chunks, txChunk)) {
+            error_level = ERR_TXGENERATE;
+            break;
+        }
+        txs.push_back(MakeTransactionRef(std::move(txChunk)));
+        input.outpoint = COutPoint(txs.back()->GetHash(), 0);
+        input.coin = Coin(txs.back()->vout[0], MEMPOOL_HEIGHT, false, false);
+    }
+
+    if (error_level == NO_ERROR && txs.size() == plan.size()) {
+        int sent_txes = 0;
+        for (const CTransactionRef& tx : txs) {
+            wallet->CommitTransaction(tx, {}, {});
+            set_job_progress(++sent_txes, plan.size());
+        }
+    }
+
+    release_coins_for_opreturn(wallet, inputs);
+    refill_storage_funding();
 }
 
-void perform_get_task(std::pair<std::string, std::string> get_info, int& error_level)
+// Whether an asset not found in the blocks here may be fetched from peers, as when they are pruned
+static bool is_peer_fetchable(int error_level)
 {
+    return g_asset_chunk_fetcher && !job_cancel_requested() &&
+           (error_level == ERR_CHUNKAUTHNONE || error_level == ERR_NOTALLDATACHUNKS || error_level == ERR_FILEREAD);
+}
 
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "FETCHASSET (perform_get_task)\n");
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "fetchasset does two things:\n");
-    LogPrint (BCLog::ALL, "1) Scan blockchain for chunks given uuid.\n");
-    LogPrint (BCLog::ALL, "The chunks are placed in order, regardless of blockchain chunk order.\n");
-    LogPrint (BCLog::ALL, "(scan_blocks_for_specific_uuid)\n");
-    LogPrint (BCLog::ALL, "2) Store file on disc.\n");
-    LogPrint (BCLog::ALL, "The filename will be the uuid, and will be created in the given path.\n");
-    LogPrint (BCLog::ALL, "(build_file_from_chunks)\n");
-    LogPrint (BCLog::ALL, "\n");
-    LogPrint (BCLog::ALL, "uuid: %s\n", get_info.first);
-    LogPrint (BCLog::ALL, "path: %s\n", get_info.second);
-    LogPrint (BCLog::ALL, "\n");
-    //LogPrint (BCLog::ALL, "\n");
-    //LogPrint (BCLog::ALL, "\n");
+// Fetch an asset from the peers serving it, writing it to filepath
+static bool fetch_from_peers(const std::string& uuid, const std::string& filepath, int& error_level, uint64_t& bytes, int& chunks)
+{
+    LogPrint (BCLog::STORAGE, "uuid %s not held locally, fetching it from peers\n", uuid);
+    chunk_reassembler file(filepath);
+    set_tenant_secret(file);
+    error_level = NO_ERROR;
+    if (!file.open(error_level)) {
+        return false;
+    }
+    if (!g_asset_chunk_fetcher->Fetch(uuid, file, error_level)) {
+        file.discard();
+        return false;
+    }
+    if (!file.finish(error_level)) {
+        return false;
+    }
+    file.get_written(chunks, bytes);
+    return true;
+}
+
+// bytes and chunks are those of the file written, chunks being zero when it came from the cache
+void perform_get_task(std::pair<std::string, std::string> get_info, int& error_level, uint64_t& bytes, int& chunks)
+{
+
+    LogPrint (BCLog::STORAGE, "\n");
+    LogPrint (BCLog::STORAGE, "FETCHASSET (perform_get_task)\n");
+    LogPrint (BCLog::STORAGE, "\n");
+    LogPrint (BCLog::STORAGE, "fetchasset scans the blockchain for chunks given uuid (scan_blocks_for_specific_uuid),\n");
+    LogPrint (BCLog::STORAGE, "and writes each chunk to its place in the file as soon as it is found (chunk_reassembler),\n");
+    LogPrint (BCLog::STORAGE, "regardless of blockchain chunk order.\n");
+    LogPrint (BCLog::STORAGE, "The filename will be the uuid, and will be created in the given path.\n");
+    LogPrint (BCLog::STORAGE, "\n");
+    LogPrint (BCLog::STORAGE, "uuid: %s\n", get_info.first);
+    LogPrint (BCLog::STORAGE, "path: %s\n", get_info.second);
+    LogPrint (BCLog::STORAGE, "\n");
 
     clock_t start, end;
-    double build_time_taken, scan_time_taken;
+    double time_taken;
 
     start = clock ();    
 
-    int offset;
+    const std::string filepath = strip_trailing_slash(get_info.second) + "/" + get_info.first;
 
-    std::vector<std::string> chunks;
-    if (!scan_blocks_for_specific_uuid(*storage_chainman, get_info.first, error_level, chunks, offset)) {
+    // Assets fetched before are copied straight from the cache
+    if (g_storage_cache && g_storage_cache->Fetch(get_info.first, fs::u8path(filepath))) {
+        std::error_code ec;
+        bytes = fs::file_size(fs::u8path(filepath), ec);
+        if (ec) bytes = 0;
         return;
     }
 
-    end = clock ();    
-    scan_time_taken = (double) (end - start) / CLOCKS_PER_SEC;
+    auto file = std::make_unique<chunk_reassembler>(filepath);
+    set_tenant_secret(*file);
+    if (!file->open(error_level)) {
+        return;
+    }
 
-    start = clock ();    
+    // If storage index enabled, seek directly to the transactions holding the chunks
+    bool found;
+    int height;
+    if (g_storage_index) {
+        found = scan_index_for_specific_uuid(get_info.first, error_level, *file, height);
+    } else {
+        found = scan_blocks_for_specific_uuid(*storage_chainman, get_info.first, error_level, *file, height);
+    }
 
-    int total_chunks = chunks.size();
-    if (!build_file_from_chunks (get_info, error_level, total_chunks, chunks, offset)) {
+    // Assets whose blocks are not held here, such as on a pruned node, from the peers serving them
+    if (!found && is_peer_fetchable(error_level)) {
+        file->discard();
+        fetch_from_peers(get_info.first, filepath, error_level, bytes, chunks);
         return;
     }
 
+    if (!found) {
+        file->discard();
+        return;
+    }
+
+    if (!file->finish(error_level)) {
+        return;
+    }
+    file->get_written(chunks, bytes);
+
+    // Assets from peers are not cached, peers do not say which blocks hold them, to tell when they are buried deep enough.
+    // Nor are encrypted ones, which the cache would hand over decrypted whatever the tenant fetching
+    if (g_storage_cache && !file->encrypted()) {
+        g_storage_cache->Insert(get_info.first, fs::u8path(filepath), height);
+    }
+
     end = clock ();    
-    build_time_taken = (double) (end - start) / CLOCKS_PER_SEC;
+    time_taken = (double) (end - start) / CLOCKS_PER_SEC;
 
-    LogPrint (BCLog::ALL, "elapsed time perform_get_task scan %ld build %ld\n", scan_time_taken, build_time_taken);
+    LogPrint (BCLog::STORAGE, "elapsed time perform_get_task %ld\n", time_taken);
 
 }
 
-void thread_storage_worker()
+// error_levels are those of each uuid. With the storage index each asset is read directly, as by
+// perform_get_task. Without it, the assets not in the cache are gathered in a single pass over the
+// blocks, and those it does not find here are fetched from peers
+void perform_get_batch_task(const std::vector<std::string>& uuids, const std::string& path, std::vector<int>& error_levels, uint64_t& bytes, int& chunks)
 {
-    
-    const char* error_level_string[] = {
+    error_levels.assign(uuids.size(), NO_ERROR);
+    std::string dir = path;
+    dir = strip_trailing_slash(dir);
+
+    std::vector<batch_fetch_asset> scan;
+    std::vector<size_t> scan_positions;
+    for (size_t i = 0; i < uuids.size(); ++i) {
+        if (job_cancel_requested()) {
+            return;
+        }
+        uint64_t asset_bytes = 0;
+        int asset_chunks = 0;
+        const std::string filepath = dir + "/" + uuids[i];
+        if (g_storage_index) {
+            set_job_progress(i, uuids.size());
+            perform_get_task(std::make_pair(uuids[i], path), error_levels[i], asset_bytes, asset_chunks);
+        } else if (g_storage_cache && g_storage_cache->Fetch(uuids[i], fs::u8path(filepath))) {
+            std::error_code ec;
+            asset_bytes = fs::file_size(fs::u8path(filepath), ec);
+            if (ec) asset_bytes = 0;
+        } else {
+            scan.emplace_back(uuids[i], filepath);
+            scan_positions.push_back(i);
+            continue;
+        }
+        bytes += asset_bytes;
+        chunks += asset_chunks;
+    }
+    if (scan.empty()) {
+        return;
+    }
+
+    LogPrint (BCLog::STORAGE, "Scanning the blocks once for %d of %d uuids\n", scan.size(), uuids.size());
+    if (!scan_blocks_for_specific_uuids(*storage_chainman, scan)) {
+        for (size_t i : scan_positions) {
+            error_levels[i] = ERR_FILEREAD;
+        }
+        return;
+    }
+
+    for (size_t n = 0; n < scan.size(); ++n) {
+        batch_fetch_asset& asset = scan[n];
+        if (asset.error_level == NO_ERROR) {
+            if (g_storage_cache && !asset.encrypted) {
+                g_storage_cache->Insert(asset.uuid, fs::u8path(asset.filepath), asset.height);
+            }
+        } else if (is_peer_fetchable(asset.error_level)) {
+            fetch_from_peers(asset.uuid, asset.filepath, asset.error_level, asset.bytes, asset.chunks);
+        }
+        error_levels[scan_positions[n]] = asset.error_level;
+        bytes += asset.bytes;
+        chunks += asset.chunks;
+    }
+}
+
+static const char* error_level_string(int error_level)
+{
+    static const char* names[] = {
     
      "NO_ERROR",
      //internal
@@ -254,84 +830,16 @@ void thread_storage_worker()
      "ERR_CHUNKAUTHSIG",
      "ERR_CHUNKAUTHUNK",
      //feature
-     "ERR_EXTENSION"
+     "ERR_EXTENSION",
+     //proof
+     "ERR_UNCONFIRMED",
+     //encryption
+     "ERR_DECRYPT"
     
     };
 
-    int error_level;
-    set_storage_worker_status(WORKER_IDLE);
-
-    while (!ShutdownRequested()) {
-
-        UninterruptibleSleep(500ms);
-
-        // check queues under lock
-        int putqueue_sz, getqueue_sz;
-        {
-            LOCK(workQueueLock);
-            putqueue_sz = workQueuePut.size();
-            getqueue_sz = workQueueGet.size();
-        }
-
-        // buffer for sprintf result
-        char buffer[128];
-        memset(buffer, 0, sizeof(buffer));
-
-        // perform putqueue tasks
-        if (putqueue_sz > 0) {
-            std::pair<std::string, std::string> putTask;
-            error_level = NO_ERROR;
-            set_storage_worker_status(WORKER_BUSY);
-            {
-                LOCK(workQueueLock);
-                putTask = workQueuePut.back();
-            }
-            perform_put_task(putTask, error_level);
-            if (error_level != NO_ERROR) {
-                //sprintf(buffer, "putTask %s had error_level %d", putTask.first.c_str(), error_level);
-                sprintf(buffer, "putTask %s had error_level %s", putTask.first.c_str(), error_level_string[error_level]);
-                std::string stringbuf = std::string(buffer);
-                add_result_text(stringbuf);
-            } else {
-                sprintf(buffer, "putTask %s completed successfully", putTask.first.c_str());
-                std::string stringbuf = std::string(buffer);
-                add_result_text(stringbuf);
-            }
-            {
-                LOCK(workQueueLock);
-                workQueuePut.pop_back();
-            }
-            set_storage_worker_status(WORKER_IDLE);
-        }
-
-        // perform getqueue tasks
-        if (getqueue_sz > 0) {
-            std::pair<std::string, std::string> getTask;
-            error_level = NO_ERROR;
-            set_storage_worker_status(WORKER_BUSY);
-            {
-                LOCK(workQueueLock);
-                getTask = workQueueGet.back();
-            }
-            perform_get_task(getTask, error_level);
-            if (error_level != NO_ERROR) {
-                sprintf(buffer, "getTask %s, %s had error_level %s", getTask.first.c_str(), getTask.second.c_str(), error_level_string[error_level]);
-                std::string stringbuf = std::string(buffer);
-                add_result_text(stringbuf);
-            } else {
-                sprintf(buffer, "getTask %s, %s completed successfully", getTask.first.c_str(), getTask.second.c_str());
-                std::string stringbuf = std::string(buffer);
-                add_result_text(stringbuf);
-            }
-            {
-                LOCK(workQueueLock);
-                workQueueGet.pop_back();
-            }
-            set_storage_worker_status(WORKER_IDLE);
-        }
-
-        if (ShutdownRequested()) {
-            return;
-        }
+    if (error_level < 0 || error_level >= (int)std::size(names)) {
+        return "ERR_UNKNOWN";
     }
+    return names[error_level];
 }
@@ -5,20 +5,64 @@
 #ifndef BITCOIN_STORAGE_WORKER_H
 #define BITCOIN_STORAGE_WORKER_H
 
+#include <node/jobs.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
 enum {
     WORKER_IDLE,
     WORKER_BUSY,
     WORKER_ERROR
 };
 
-void thread_storage_worker();
+//! Number of putfile transactions built and signed concurrently
+static const int PUT_PIPELINE_DEPTH = 8;
+//! Store with the compact chunk protocol (02), off until the nodes that can not fetch it have upgraded
+static const bool DEFAULT_STORAGE_COMPACT = false;
+//! Let the compact protocol store assets compressed, where that makes them smaller, off as nodes
+//! from before compression can not read such assets
+static const bool DEFAULT_STORAGE_COMPRESS = false;
+//! Let the compact protocol name assets by the sha256 of the file, for store's reuse to find them,
+//! off as nodes from before the content hash reject such assets
+static const bool DEFAULT_STORAGE_CONTENTHASH = false;
+//! Let the compact protocol store assets encrypted with the tenant key, so only the tenant reads them
+static const bool DEFAULT_STORAGE_ENCRYPT = false;
+//! MiB of confirmed usage past which a tenant stores nothing more, 0 for no quota
+static const int64_t DEFAULT_STORAGE_QUOTA = 0;
+
+//! Bytes past which a put or get is a large job, which leaves a job thread to the small ones
+static const int64_t STORAGE_LARGE_JOB_SIZE = 1 << 20;
+
+//! Most files one storebatch takes
+static const size_t MAX_STORAGE_BATCH_FILES = 1000;
+//! Most bytes of the files one storebatch takes, as their chunks are all held in memory
+static const int64_t MAX_STORAGE_BATCH_BYTES = 8 << 20;
 
-void add_result_entry();
-std::string get_result_hash();
-void add_result_text(std::string& result);
+//! Most assets one fetchbatch takes
+static const size_t MAX_STORAGE_FETCH_BATCH = 1000;
 
-void add_put_task(std::string put_info, std::string put_uuid = "");
-void add_get_task(std::pair<std::string, std::string> get_info);
+//! tenant is who the job is for, sharing the job threads fairly with the other tenants
+std::string add_put_task(std::string put_info, std::string put_uuid = "", node::JobPriority priority = node::JobPriority::NORMAL, const std::string& tenant = "");
+std::string add_get_task(std::pair<std::string, std::string> get_info, node::JobPriority priority = node::JobPriority::NORMAL, const std::string& tenant = "");
+//! Store several files, each as (filepath, uuid), with their chunks packed together into shared transactions
+std::string add_put_batch_task(std::vector<std::pair<std::string, std::string>> files, node::JobPriority priority = node::JobPriority::NORMAL, const std::string& tenant = "");
+//! Fetch several assets to path, gathering those not in the storage index in one pass over the blocks
+std::string add_get_batch_task(std::vector<std::string> uuids, std::string path, node::JobPriority priority = node::JobPriority::NORMAL, const std::string& tenant = "");
+//! A page of the assets of the tenant authenticated, as the list RPC gives them, for callers that must not wait for it
+std::string add_list_task(int count, const std::string& cursor, const std::string& tenant = "");
+//! Queue again the puts left unfinished by a shutdown or crash
+void resume_storage_uploads();
+//! Top up the funding pool of the wallet in the background, if there is one
+void refill_storage_funding();
+void set_job_progress(int done, int total);
+bool job_cancel_requested();
+bool job_yield();
 void get_storage_worker_status(int& status);
+//! Storage jobs waiting for a thread of the job queue, and running
+void get_storage_job_counts(size_t& queued, size_t& running);
+void get_storage_job_status(std::vector<std::string>& jobs, int count);
 
 #endif // BITCOIN_STORAGE_WORKER_H
@@ -13,11 +13,13 @@
 #include <util/strencodings.h>
 #include <util/threadnames.h>
 
+#include <algorithm>
 #include <map>
 #include <mutex>
 #include <set>
 #include <system_error>
 #include <thread>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -324,3 +326,69 @@ bool LockStackEmpty()
 bool g_debug_lockorder_abort = true;
 
 #endif /* DEBUG_LOCKORDER */
+
+std::atomic<bool> g_lock_profiling{DEFAULT_LOCK_PROFILING};
+
+namespace {
+struct LockSiteCounters {
+    const char* name;
+    uint64_t acquires{0};
+    uint64_t contended{0};
+    std::chrono::steady_clock::duration wait{0};
+    std::chrono::steady_clock::duration max_wait{0};
+    std::chrono::steady_clock::duration hold{0};
+    std::chrono::steady_clock::duration max_hold{0};
+};
+
+// A plain std::mutex, as a Mutex would be profiled itself. It is never held
+// while taking another lock.
+std::mutex g_lock_sites_mutex;
+// By the __FILE__ literal and line of each site
+std::map<std::pair<const char*, int>, LockSiteCounters> g_lock_sites;
+} // namespace
+
+void RecordLockSample(const LockSample& sample)
+{
+    const auto released{std::chrono::steady_clock::now()};
+    const auto wait{sample.acquired - sample.wait_start};
+    const auto hold{released - sample.acquired};
+    std::lock_guard<std::mutex> lock(g_lock_sites_mutex);
+    LockSiteCounters& site{g_lock_sites.try_emplace({sample.file, sample.line}, LockSiteCounters{sample.name}).first->second};
+    ++site.acquires;
+    if (sample.contended) ++site.contended;
+    site.wait += wait;
+    site.max_wait = std::max(site.max_wait, wait);
+    site.hold += hold;
+    site.max_hold = std::max(site.max_hold, hold);
+}
+
+std::vector<LockSiteStats> GetLockSiteStats()
+{
+    using std::chrono::duration_cast, std::chrono::microseconds;
+    std::vector<LockSiteStats> stats;
+    {
+        std::lock_guard<std::mutex> lock(g_lock_sites_mutex);
+        for (const auto& [site, counters] : g_lock_sites) {
+            LockSiteStats& entry{stats.emplace_back()};
+            entry.name = counters.name;
+            entry.file = site.first;
+            entry.line = site.second;
+            entry.acquires = counters.acquires;
+            entry.contended = counters.contended;
+            entry.wait = duration_cast<microseconds>(counters.wait);
+            entry.max_wait = duration_cast<microseconds>(counters.max_wait);
+            entry.hold = duration_cast<microseconds>(counters.hold);
+            entry.max_hold = duration_cast<microseconds>(counters.max_hold);
+        }
+    }
+    std::sort(stats.begin(), stats.end(), [](const LockSiteStats& a, const LockSiteStats& b) {
+        return std::tie(b.wait, b.hold, a.file, a.line) < std::tie(a.wait, a.hold, b.file, b.line);
+    });
+    return stats;
+}
+
+void ResetLockSiteStats()
+{
+    std::lock_guard<std::mutex> lock(g_lock_sites_mutex);
+    g_lock_sites.clear();
+}
@@ -14,9 +14,13 @@
 #include <threadsafety.h> // IWYU pragma: export
 #include <util/macros.h>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <string>
+#include <vector>
 #include <thread>
 
 ////////////////////////////////////////////////
@@ -147,6 +151,82 @@ inline void AssertLockNotHeldInline(const char* name, const char* file, int line
 inline void AssertLockNotHeldInline(const char* name, const char* file, int line, GlobalMutex* cs) LOCKS_EXCLUDED(cs) { AssertLockNotHeldInternal(name, file, line, cs); }
 #define AssertLockNotHeld(cs) AssertLockNotHeldInline(#cs, __FILE__, __LINE__, &cs)
 
+/**
+ * While alive, adds up the time the current thread spends blocked in LOCK() on one
+ * mutex, e.g. to tell how much of a message handler's time was waiting for cs_main.
+ * Accounts nest; only the innermost one of a thread is charged.
+ */
+class LockWaitAccount
+{
+public:
+    template <typename MutexType>
+    explicit LockWaitAccount(MutexType& mutex)
+        : m_mutex{static_cast<const typename MutexType::unique_lock::mutex_type*>(&mutex)}, m_outer{g_current}
+    {
+        g_current = this;
+    }
+    ~LockWaitAccount() { g_current = m_outer; }
+
+    LockWaitAccount(const LockWaitAccount&) = delete;
+    LockWaitAccount& operator=(const LockWaitAccount&) = delete;
+
+    std::chrono::microseconds Waited() const { return std::chrono::duration_cast<std::chrono::microseconds>(m_waited); }
+
+    //! The current thread's account for mutex, if it has one.
+    static LockWaitAccount* For(const void* mutex)
+    {
+        return g_current && g_current->m_mutex == mutex ? g_current : nullptr;
+    }
+
+    void Add(std::chrono::steady_clock::duration waited) { m_waited += waited; }
+
+private:
+    const void* const m_mutex;
+    LockWaitAccount* const m_outer;
+    std::chrono::steady_clock::duration m_waited{0};
+    static inline thread_local LockWaitAccount* g_current{nullptr};
+};
+
+//! Default for -lockprofile
+static constexpr bool DEFAULT_LOCK_PROFILING{false};
+
+//! Whether LOCK() sites record how long they wait and hold their mutex, see -lockprofile
+extern std::atomic<bool> g_lock_profiling;
+
+/** One acquisition of a mutex at a LOCK() site, taken while lock sites are profiled */
+struct LockSample {
+    const char* name{nullptr};
+    const char* file{nullptr};
+    int line{0};
+    bool contended{false};
+    std::chrono::steady_clock::time_point wait_start;
+    std::chrono::steady_clock::time_point acquired;
+};
+
+/**
+ * What the acquisitions at one LOCK() site added up to since profiling began or
+ * was reset. The hold time runs until the lock goes out of scope, so it includes
+ * condition variable waits and REVERSE_LOCK() sections.
+ */
+struct LockSiteStats {
+    std::string name;
+    std::string file;
+    int line{0};
+    uint64_t acquires{0};
+    //! Acquisitions which found the mutex held, and waited for it
+    uint64_t contended{0};
+    std::chrono::microseconds wait{0};
+    std::chrono::microseconds max_wait{0};
+    std::chrono::microseconds hold{0};
+    std::chrono::microseconds max_hold{0};
+};
+
+/** Add a sample to the counters of its site, as the lock is released. */
+void RecordLockSample(const LockSample& sample);
+/** The counters of all sites which took a lock while profiled, most waited for first. */
+std::vector<LockSiteStats> GetLockSiteStats();
+void ResetLockSiteStats();
+
 /** Wrapper around std::unique_lock style lock for MutexType. */
 template <typename MutexType>
 class SCOPED_LOCKABLE UniqueLock : public MutexType::unique_lock
@@ -154,13 +234,37 @@ class SCOPED_LOCKABLE UniqueLock : public MutexType::unique_lock
 private:
     using Base = typename MutexType::unique_lock;
 
+    //! Set while lock sites are profiled, recorded on release
+    LockSample m_sample;
+
+    void Sample(const char* pszName, const char* pszFile, int nLine, bool contended, std::chrono::steady_clock::time_point wait_start, std::chrono::steady_clock::time_point acquired)
+    {
+        m_sample = {pszName, pszFile, nLine, contended, wait_start, acquired};
+    }
+
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, Base::mutex());
+        const bool profile{g_lock_profiling.load(std::memory_order_relaxed)};
+        if (Base::try_lock()) {
+            if (profile) {
+                const auto now{std::chrono::steady_clock::now()};
+                Sample(pszName, pszFile, nLine, /*contended=*/false, now, now);
+            }
+            return;
+        }
 #ifdef DEBUG_LOCKCONTENTION
-        if (Base::try_lock()) return;
         LOG_TIME_MICROS_WITH_CATEGORY(strprintf("lock contention %s, %s:%d", pszName, pszFile, nLine), BCLog::LOCK);
 #endif
+        LockWaitAccount* account{LockWaitAccount::For(Base::mutex())};
+        if (account || profile) {
+            const auto wait_start{std::chrono::steady_clock::now()};
+            Base::lock();
+            const auto acquired{std::chrono::steady_clock::now()};
+            if (account) account->Add(acquired - wait_start);
+            if (profile) Sample(pszName, pszFile, nLine, /*contended=*/true, wait_start, acquired);
+            return;
+        }
         Base::lock();
     }
 
@@ -168,6 +272,10 @@ private:
     {
         EnterCritical(pszName, pszFile, nLine, Base::mutex(), true);
         if (Base::try_lock()) {
+            if (g_lock_profiling.load(std::memory_order_relaxed)) {
+                const auto now{std::chrono::steady_clock::now()};
+                Sample(pszName, pszFile, nLine, /*contended=*/false, now, now);
+            }
             return true;
         }
         LeaveCritical();
@@ -196,8 +304,10 @@ public:
 
     ~UniqueLock() UNLOCK_FUNCTION()
     {
-        if (Base::owns_lock())
+        if (Base::owns_lock()) {
             LeaveCritical();
+            if (m_sample.name) RecordLockSample(m_sample);
+        }
     }
 
     operator bool()
@@ -0,0 +1,99 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+#include <interfaces/chain.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addressindex_tests)
+
+static void IndexWaitSynced(BaseIndex& index)
+{
+    constexpr auto timeout{10s};
+    const auto time_start{SteadyClock::now()};
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout > SteadyClock::now());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_outputs_and_spends, TestChain100Setup)
+{
+    AddressIndex address_index(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(address_index.Start());
+    IndexWaitSynced(address_index);
+
+    // All of the coinbases pay to the coinbase key, the genesis one excluded
+    const CScript coinbase_script{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    std::vector<AddressOutput> outputs;
+    BOOST_REQUIRE(address_index.FindOutputs(coinbase_script, {}, outputs));
+    BOOST_CHECK_EQUAL(outputs.size(), m_coinbase_txns.size());
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        BOOST_CHECK_EQUAL(outputs[i].height, int(i) + 1);
+        BOOST_CHECK(outputs[i].outpoint == COutPoint(m_coinbase_txns[i]->GetHash(), 0));
+        BOOST_CHECK_EQUAL(outputs[i].value, m_coinbase_txns[i]->vout[0].nValue);
+        BOOST_CHECK(!outputs[i].spent);
+    }
+
+    // A range of heights, a page of it
+    outputs.clear();
+    BOOST_REQUIRE(address_index.FindOutputs(coinbase_script, {.start_height = 10, .end_height = 20, .count = 5}, outputs));
+    BOOST_REQUIRE_EQUAL(outputs.size(), 5U);
+    BOOST_CHECK_EQUAL(outputs.front().height, 10);
+    BOOST_CHECK_EQUAL(outputs.back().height, 14);
+
+    // Spend the first coinbase to another script
+    const CScript dest_script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CMutableTransaction spend{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, dest_script, 1 * COIN, /*submit=*/false)};
+    const CBlock block{CreateAndProcessBlock({spend}, coinbase_script)};
+    const int height{WITH_LOCK(::cs_main, return m_node.chainman->ActiveHeight())};
+    BOOST_CHECK(address_index.BlockUntilSyncedToCurrentChain());
+
+    AddressSpend found;
+    BOOST_REQUIRE(address_index.FindSpend(COutPoint(m_coinbase_txns[0]->GetHash(), 0), found));
+    BOOST_CHECK_EQUAL(found.txid, spend.GetHash());
+    BOOST_CHECK_EQUAL(found.input, 0U);
+    BOOST_CHECK_EQUAL(found.height, height);
+    BOOST_CHECK(!address_index.FindSpend(COutPoint(m_coinbase_txns[1]->GetHash(), 0), found));
+
+    outputs.clear();
+    BOOST_REQUIRE(address_index.FindOutputs(coinbase_script, {.end_height = 1}, outputs));
+    BOOST_REQUIRE_EQUAL(outputs.size(), 1U);
+    BOOST_CHECK(outputs[0].spent && outputs[0].spent->txid == spend.GetHash());
+
+    outputs.clear();
+    BOOST_REQUIRE(address_index.FindOutputs(coinbase_script, {.unspent_only = true}, outputs));
+    BOOST_CHECK_EQUAL(outputs.size(), m_coinbase_txns.size());
+    BOOST_CHECK_EQUAL(outputs.front().height, 2);
+
+    outputs.clear();
+    BOOST_REQUIRE(address_index.FindOutputs(dest_script, {}, outputs));
+    BOOST_REQUIRE_EQUAL(outputs.size(), 1U);
+    BOOST_CHECK(outputs[0].outpoint == COutPoint(spend.GetHash(), 0));
+    BOOST_CHECK_EQUAL(outputs[0].height, height);
+    BOOST_CHECK_EQUAL(outputs[0].value, 1 * COIN);
+
+    // Disconnecting the block takes its outputs and spends out of the index
+    {
+        BlockValidationState state;
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())));
+    }
+    SyncWithValidationInterfaceQueue();
+    CreateAndProcessBlock({}, coinbase_script);
+    BOOST_CHECK(address_index.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(!address_index.FindSpend(COutPoint(m_coinbase_txns[0]->GetHash(), 0), found));
+    outputs.clear();
+    BOOST_REQUIRE(address_index.FindOutputs(dest_script, {}, outputs));
+    BOOST_CHECK(outputs.empty());
+
+    SyncWithValidationInterfaceQueue();
+    address_index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
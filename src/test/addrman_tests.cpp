@@ -957,6 +957,60 @@ BOOST_AUTO_TEST_CASE(load_addrman_corrupted)
     BOOST_CHECK_THROW(ReadFromStream(addrman2, ssPeers2), std::ios_base::failure);
 }
 
+BOOST_AUTO_TEST_CASE(addrman_journal)
+{
+    AddrMan addrman{EMPTY_NETGROUPMAN, DETERMINISTIC, GetCheckRatio(m_node)};
+    const CNetAddr source{ResolveIP("252.2.2.2")};
+    const auto addr_at{[](int i) { return CAddress{ResolveService("250.1.1." + ToString(i)), NODE_NONE}; }};
+
+    // 250.1.1.1 - 250.1.1.22 do not collide with deterministic key = 1
+    for (int i = 1; i <= 22; ++i) {
+        BOOST_CHECK(addrman.Add({addr_at(i)}, source));
+    }
+    CDataStream ss_snapshot(SER_DISK, CLIENT_VERSION);
+    addrman.SerializeSnapshot(ss_snapshot);
+
+    CDataStream ss_empty(SER_DISK, CLIENT_VERSION);
+    BOOST_CHECK_EQUAL(addrman.SerializeChanges(ss_empty).value(), 0U);
+
+    // 250.1.1.23 takes the new table position of one of the others, deleting it.
+    BOOST_CHECK(addrman.Add({addr_at(23)}, source));
+    BOOST_CHECK_EQUAL(addrman.Size(), 22U);
+    std::vector<int> kept;
+    for (int i = 1; i <= 22; ++i) {
+        if (addrman.FindAddressEntry(addr_at(i))) kept.push_back(i);
+    }
+    BOOST_REQUIRE_EQUAL(kept.size(), 21U);
+    BOOST_CHECK(addrman.Good(addr_at(kept[0])));
+    addrman.Attempt(addr_at(kept[1]), /*fCountFailure=*/true);
+    CDataStream ss_changes1(SER_DISK, CLIENT_VERSION);
+    BOOST_CHECK_EQUAL(addrman.SerializeChanges(ss_changes1).value(), 4U);
+
+    BOOST_CHECK(addrman.Add({addr_at(24)}, source));
+    addrman.Good(addr_at(23));
+    CDataStream ss_changes2(SER_DISK, CLIENT_VERSION);
+    BOOST_CHECK_EQUAL(addrman.SerializeChanges(ss_changes2).value(), 2U);
+
+    // Loading the snapshot and applying the segments in order restores the table.
+    AddrMan addrman_replayed{EMPTY_NETGROUPMAN, DETERMINISTIC, GetCheckRatio(m_node)};
+    ss_snapshot >> addrman_replayed;
+    addrman_replayed.UnserializeChanges(ss_changes1);
+    addrman_replayed.UnserializeChanges(ss_changes2);
+
+    BOOST_CHECK_EQUAL(addrman_replayed.Size(), addrman.Size());
+    BOOST_CHECK_EQUAL(addrman_replayed.Size(std::nullopt, /*in_new=*/false), addrman.Size(std::nullopt, /*in_new=*/false));
+    for (int i = 1; i <= 24; ++i) {
+        auto entry{addrman.FindAddressEntry(addr_at(i))};
+        auto entry_replayed{addrman_replayed.FindAddressEntry(addr_at(i))};
+        BOOST_CHECK_EQUAL(entry.has_value(), entry_replayed.has_value());
+        if (entry && entry_replayed) BOOST_CHECK(*entry == *entry_replayed);
+    }
+
+    // A table that was just loaded from the journal has nothing to append to it.
+    CDataStream ss_replayed(SER_DISK, CLIENT_VERSION);
+    BOOST_CHECK_EQUAL(addrman_replayed.SerializeChanges(ss_replayed).value(), 0U);
+}
+
 BOOST_AUTO_TEST_CASE(addrman_update_address)
 {
     // Tests updating nTime via Connected() and nServices via SetServices()
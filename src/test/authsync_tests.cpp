@@ -0,0 +1,145 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/consensus.h>
+#include <consensus/validation.h>
+#include <hash.h>
+#include <key.h>
+#include <opfile/src/util.h>
+#include <storage/auth.h>
+#include <storage/authsync.h>
+#include <storage/chunk.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+
+namespace {
+
+struct AuthSyncSetup : public TestChain100Setup {
+    //! The regtest authList starts from the key of secret 2, given as its hash160 in uint160 notation.
+    //! The coinbase key, of secret 1, is not on it
+    AuthSyncSetup() : TestChain100Setup{CBaseChainParams::REGTEST, {"-regtestauthuser=cc7ea34412241fa12a12ac94ef22fdcd6bd4af06"}}
+    {
+        std::vector<unsigned char> secret(32, 0x00);
+        secret.back() = 0x02;
+        auth_key.Set(secret.begin(), secret.end(), true);
+    }
+
+    CKey auth_key;
+    const CScript coinbase_script{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    uint32_t auth_time{1};
+
+    //! Connect a block carrying authdata that adds or removes tenant, signed by the auth user
+    void ConnectAuthBlock(uint8_t operation, const uint160& tenant)
+    {
+        std::vector<unsigned char> payload(std::begin(OPAUTH_MAGIC_BIN), std::end(OPAUTH_MAGIC_BIN));
+        payload.push_back(operation);
+        for (int i = OPAUTH_TIMELEN - 1; i >= 0; i--) {
+            payload.push_back(auth_time >> (8 * i));
+        }
+        auth_time++;
+        // most significant byte first, as the hex notation reads
+        payload.insert(payload.end(), tenant.begin(), tenant.end());
+        std::reverse(payload.end() - OPAUTH_HASHLEN, payload.end());
+
+        uint256 hash;
+        sha256_hash_of_hex(payload, hash.begin());
+        std::vector<unsigned char> signature;
+        BOOST_REQUIRE(auth_key.SignCompact(hash, signature));
+        payload.insert(payload.end(), signature.begin(), signature.end());
+
+        // The newest coinbase mature at the next height
+        const int spend{Height() - COINBASE_MATURITY};
+        const CMutableTransaction tx{CreateValidMempoolTransaction(m_coinbase_txns[spend], 0, spend + 1, coinbaseKey, CScript() << OP_RETURN << payload, /*output_amount=*/0, /*submit=*/false)};
+        CreateAndProcessBlock({tx}, coinbase_script);
+        SyncWithValidationInterfaceQueue();
+    }
+
+    void DisconnectTip()
+    {
+        BlockValidationState state;
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())));
+        SyncWithValidationInterfaceQueue();
+    }
+
+    int Height() const
+    {
+        return WITH_LOCK(::cs_main, return m_node.chainman->ActiveHeight());
+    }
+};
+
+bool IsMember(const AuthListSync& sync, const uint160& tenant, int height)
+{
+    bool member{false};
+    BOOST_REQUIRE(sync.FindMembership(tenant, height, member));
+    return member;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(authsync_tests, AuthSyncSetup)
+
+BOOST_AUTO_TEST_CASE(authsync_undo)
+{
+    const uint160 auth_user{Hash160(auth_key.GetPubKey())};
+    BOOST_REQUIRE(Params().GetConsensus().initAuthUser == auth_user);
+
+    AuthListSync sync{m_args.GetDataDirNet() / "authlist.dat"};
+    BOOST_REQUIRE(sync.Start(*m_node.chainman));
+    const int start{Height()};
+    BOOST_CHECK(IsMember(sync, auth_user, start));
+
+    const uint160 tenant{Hash160(std::vector<unsigned char>{'a'})};
+    BOOST_CHECK(!is_auth_member(tenant));
+    BOOST_CHECK(!IsMember(sync, tenant, start));
+
+    // Added, then the block adding it disconnected
+    ConnectAuthBlock(OPAUTH_ADDUSER_BIN, tenant);
+    BOOST_CHECK(is_auth_member(tenant));
+    BOOST_CHECK(IsMember(sync, tenant, start + 1));
+    BOOST_CHECK(!IsMember(sync, tenant, start));
+
+    DisconnectTip();
+    BOOST_CHECK(!is_auth_member(tenant));
+    bool member;
+    BOOST_CHECK(!sync.FindMembership(tenant, start + 1, member));
+    BOOST_CHECK(!IsMember(sync, tenant, start));
+
+    // A block without authdata in its place leaves the tenant out
+    CreateAndProcessBlock({}, coinbase_script);
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK(!is_auth_member(tenant));
+    BOOST_CHECK(!IsMember(sync, tenant, start + 1));
+
+    // Added and removed, then the block removing it disconnected
+    ConnectAuthBlock(OPAUTH_ADDUSER_BIN, tenant);
+    ConnectAuthBlock(OPAUTH_DELUSER_BIN, tenant);
+    BOOST_CHECK(!is_auth_member(tenant));
+    BOOST_CHECK(IsMember(sync, tenant, start + 2));
+    BOOST_CHECK(!IsMember(sync, tenant, start + 3));
+
+    DisconnectTip();
+    BOOST_CHECK(is_auth_member(tenant));
+    BOOST_CHECK(IsMember(sync, tenant, start + 2));
+    BOOST_CHECK(!sync.FindMembership(tenant, start + 3, member));
+
+    // Authdata signed by a key off the list changes nothing
+    const uint160 other{Hash160(std::vector<unsigned char>{'b'})};
+    auth_key = coinbaseKey;
+    ConnectAuthBlock(OPAUTH_ADDUSER_BIN, other);
+    BOOST_CHECK(!is_auth_member(other));
+    BOOST_CHECK(!IsMember(sync, other, start + 3));
+    DisconnectTip();
+    BOOST_CHECK(is_auth_member(tenant));
+    BOOST_CHECK(!is_auth_member(other));
+
+    sync.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
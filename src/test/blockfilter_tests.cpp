@@ -179,14 +179,41 @@ BOOST_AUTO_TEST_CASE(blockfilters_json_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(blockfilter_storage_elements)
+{
+    const uint256 block_hash{uint256::ONE};
+    const GCSFilter::Element uuid(32, 0x11);
+    const GCSFilter::Element tenant(20, 0x22);
+    BlockFilter filter(BlockFilterType::STORAGE, block_hash, {uuid, tenant});
+    BOOST_CHECK(filter.GetFilterType() == BlockFilterType::STORAGE);
+    BOOST_CHECK_EQUAL(filter.GetBlockHash(), block_hash);
+    BOOST_CHECK(filter.GetFilter().Match(uuid));
+    BOOST_CHECK(filter.GetFilter().Match(tenant));
+    BOOST_CHECK(!filter.GetFilter().Match(GCSFilter::Element(32, 0x33)));
+
+    // Round trips as a cfilter payload
+    DataStream stream{};
+    stream << filter;
+    BlockFilter read;
+    stream >> read;
+    BOOST_CHECK(read.GetFilterType() == BlockFilterType::STORAGE);
+    BOOST_CHECK(read.GetFilter().Match(uuid));
+
+    // Not built from the scripts of a block
+    BOOST_CHECK_THROW(BlockFilter(BlockFilterType::STORAGE, CBlock{}, CBlockUndo{}), std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_CASE(blockfilter_type_names)
 {
     BOOST_CHECK_EQUAL(BlockFilterTypeName(BlockFilterType::BASIC), "basic");
+    BOOST_CHECK_EQUAL(BlockFilterTypeName(BlockFilterType::STORAGE), "storage");
     BOOST_CHECK_EQUAL(BlockFilterTypeName(static_cast<BlockFilterType>(255)), "");
 
     BlockFilterType filter_type;
     BOOST_CHECK(BlockFilterTypeByName("basic", filter_type));
     BOOST_CHECK_EQUAL(filter_type, BlockFilterType::BASIC);
+    BOOST_CHECK(BlockFilterTypeByName("storage", filter_type));
+    BOOST_CHECK_EQUAL(filter_type, BlockFilterType::STORAGE);
 
     BOOST_CHECK(!BlockFilterTypeByName("unknown", filter_type));
 }
@@ -5,15 +5,28 @@
 #include <chainparams.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
+#include <streams.h>
+#include <txdb.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
 #include <test/util/setup_common.h>
 
+#include <map>
+
+using node::BlockCache;
 using node::BlockManager;
+using node::BLOCK_RECORD_COMPRESSED;
 using node::BLOCK_SERIALIZATION_HEADER_SIZE;
+using node::CompressBlock;
+using node::DecompressBlock;
 using node::MAX_BLOCKFILE_SIZE;
 using node::OpenBlockFile;
+using node::RawBlockHasWitness;
+using node::ReadBlockFromDisk;
+using node::ReadRawBlockFromDisk;
+using node::ReadTransactionFromDisk;
+using node::UndoReadFromDisk;
 
 // use BasicTestingSetup here for the data directory configuration, setup, and cleanup
 BOOST_FIXTURE_TEST_SUITE(blockmanager_tests, BasicTestingSetup)
@@ -82,4 +95,288 @@ BOOST_FIXTURE_TEST_CASE(blockmanager_scan_unlink_already_pruned_files, TestChain
     BOOST_CHECK(!AutoFile(OpenBlockFile(new_pos, true)).IsNull());
 }
 
+BOOST_FIXTURE_TEST_CASE(blockmanager_compact_block_index, TestChain100Setup)
+{
+    LOCK(::cs_main);
+    const CChain& chain{m_node.chainman->ActiveChain()};
+    const DBParams db_params{
+        .path = m_args.GetDataDirNet() / "compact_index",
+        .cache_bytes = 1 << 20};
+    constexpr uint8_t DB_BLOCK_INDEX{'b'};
+    const int legacy_height{chain.Height() / 2};
+
+    // Load the index, and check it matches the chain
+    const auto check_load = [&](CBlockTreeDB& db) {
+        std::map<uint256, CBlockIndex> loaded;
+        BOOST_CHECK(db.LoadBlockIndexGuts(Params().GetConsensus(), [&](const uint256& hash) -> CBlockIndex* {
+            if (hash.IsNull()) return nullptr;
+            auto [it, inserted] = loaded.try_emplace(hash);
+            it->second.phashBlock = &it->first;
+            return &it->second;
+        }));
+        BOOST_CHECK_EQUAL(loaded.size(), size_t(chain.Height() + 1));
+        for (int height = 0; height <= chain.Height(); ++height) {
+            const CBlockIndex& index{*chain[height]};
+            const CBlockIndex& loaded_index{loaded.at(index.GetBlockHash())};
+            BOOST_CHECK_EQUAL(loaded_index.nHeight, index.nHeight);
+            BOOST_CHECK_EQUAL(loaded_index.nTime, index.nTime);
+            BOOST_CHECK_EQUAL(loaded_index.nBits, index.nBits);
+            BOOST_CHECK_EQUAL(loaded_index.nVersion, index.nVersion);
+            BOOST_CHECK_EQUAL(loaded_index.nStatus, index.nStatus);
+            BOOST_CHECK_EQUAL(loaded_index.nDataPos, index.nDataPos);
+            BOOST_CHECK_EQUAL(loaded_index.nUndoPos, index.nUndoPos);
+            BOOST_CHECK_EQUAL(loaded_index.nStakeModifier, index.nStakeModifier);
+            BOOST_CHECK(loaded_index.pprev == (index.pprev ? &loaded.at(index.pprev->GetBlockHash()) : nullptr));
+        }
+    };
+
+    {
+        // The lower half of the chain is stored in legacy records, the upper half in compact ones
+        CBlockTreeDB db{db_params, /*compact_records=*/true};
+        std::vector<const CBlockIndex*> compact;
+        for (int height = 0; height <= chain.Height(); ++height) {
+            const CBlockIndex* pindex{chain[height]};
+            if (height <= legacy_height) {
+                BOOST_CHECK(db.Write(std::make_pair(DB_BLOCK_INDEX, pindex->GetBlockHash()), CDiskBlockIndex{pindex}));
+            } else {
+                compact.push_back(pindex);
+            }
+        }
+        BOOST_CHECK(db.WriteBatchSync({}, 0, compact));
+
+        // Compact records leave the null proof-of-stake fields and what follows from the parent out
+        const CDiskBlockIndex tip_record{chain.Tip(), /*compact=*/true, /*stake_modifier_from_parent=*/true};
+        BOOST_CHECK_EQUAL(tip_record.nRecordFields, RECORD_PARENT_MASK);
+        CDataStream compact_stream{SER_DISK, CLIENT_VERSION};
+        CDataStream legacy_stream{SER_DISK, CLIENT_VERSION};
+        compact_stream << tip_record;
+        legacy_stream << CDiskBlockIndex{chain.Tip()};
+        BOOST_CHECK(compact_stream.size() * 2 < legacy_stream.size());
+
+        check_load(db);
+
+        // Loading rewrote the legacy records compactly
+        CDiskBlockIndex record;
+        BOOST_CHECK(db.Read(std::make_pair(DB_BLOCK_INDEX, chain[legacy_height]->GetBlockHash()), record));
+        BOOST_CHECK(record.HasParentFields());
+    }
+
+    // Without the compact form, loading rewrites the records in the legacy one again,
+    // which versions before it read
+    CBlockTreeDB db{db_params};
+    check_load(db);
+    CDiskBlockIndex record;
+    BOOST_CHECK(db.Read(std::make_pair(DB_BLOCK_INDEX, chain.Tip()->GetBlockHash()), record));
+    BOOST_CHECK_EQUAL(record.nRecordFields, RECORD_LEGACY);
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_raw_block_witness, TestChain100Setup)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(2);
+    tx.vin[1].scriptSig = CScript() << OP_TRUE;
+    tx.vout.resize(3);
+    tx.vout[2].scriptPubKey = CScript() << OP_RETURN << std::vector<unsigned char>(100);
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(tx));
+    block.vtx.push_back(MakeTransactionRef(tx));
+
+    const auto serialize = [](const CBlock& block, int flags) {
+        std::vector<uint8_t> data;
+        CVectorWriter{SER_NETWORK, PROTOCOL_VERSION | flags, data, 0, block};
+        return data;
+    };
+    BOOST_CHECK(!RawBlockHasWitness(serialize(block, 0)));
+
+    tx.vin[0].scriptWitness.stack.push_back({1});
+    block.vtx.push_back(MakeTransactionRef(tx));
+    BOOST_CHECK(RawBlockHasWitness(serialize(block, 0)));
+    BOOST_CHECK(!RawBlockHasWitness(serialize(block, SERIALIZE_TRANSACTION_NO_WITNESS)));
+
+    // Cut short, a block is rejected rather than read beyond
+    std::vector<uint8_t> truncated{serialize(block, SERIALIZE_TRANSACTION_NO_WITNESS)};
+    truncated.resize(truncated.size() - 1);
+    BOOST_CHECK_THROW(RawBlockHasWitness(truncated), std::ios_base::failure);
+
+    // The blocks stored agree with their decoded transactions
+    LOCK(::cs_main);
+    const CChain& chain{m_node.chainman->ActiveChain()};
+    for (const CBlockIndex* pindex : {chain.Genesis(), chain.Tip()}) {
+        std::vector<uint8_t> raw;
+        BOOST_REQUIRE(ReadRawBlockFromDisk(raw, pindex->GetBlockPos(), Params().MessageStart()));
+        CBlock stored;
+        BOOST_REQUIRE(ReadBlockFromDisk(stored, pindex, Params().GetConsensus()));
+        const bool has_witness{std::any_of(stored.vtx.begin(), stored.vtx.end(), [](const CTransactionRef& tx) { return tx->HasWitness(); })};
+        BOOST_CHECK_EQUAL(RawBlockHasWitness(raw), has_witness);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_block_cache)
+{
+    const CBlock& genesis{Params().GenesisBlock()};
+    const uint256 hash{genesis.GetHash()};
+    BlockCache cache{1 << 20};
+
+    // Cached on the second read only
+    BOOST_CHECK(!cache.Get(hash));
+    cache.Offer(hash, genesis);
+    BOOST_CHECK(!cache.Get(hash));
+    cache.Offer(hash, genesis);
+    const auto cached{cache.Get(hash)};
+    BOOST_REQUIRE(cached);
+    BOOST_CHECK_EQUAL(cached->GetHash(), hash);
+    BOOST_CHECK(cached->vtx[0] == genesis.vtx[0]);
+
+    auto stats{cache.GetStats()};
+    BOOST_CHECK_EQUAL(stats.hits, 1U);
+    BOOST_CHECK_EQUAL(stats.misses, 2U);
+    BOOST_CHECK_EQUAL(stats.blocks, 1U);
+    BOOST_CHECK(stats.bytes > 0);
+
+    // Evicted when the budget shrinks, still held by readers
+    cache.SetMaxBytes(stats.bytes - 1);
+    BOOST_CHECK(!cache.Get(hash));
+    BOOST_CHECK_EQUAL(cache.GetStats().blocks, 0U);
+    BOOST_CHECK_EQUAL(cache.GetStats().bytes, 0U);
+    BOOST_CHECK_EQUAL(cached->GetHash(), hash);
+
+    // Disabled
+    cache.SetMaxBytes(0);
+    cache.Offer(hash, genesis);
+    cache.Offer(hash, genesis);
+    BOOST_CHECK(!cache.Get(hash));
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_read_cached_block, TestChain100Setup)
+{
+    const CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())};
+    const auto before{node::g_block_cache.GetStats()};
+    for (int i = 0; i < 3; ++i) {
+        CBlock block;
+        BOOST_REQUIRE(ReadBlockFromDisk(block, tip, Params().GetConsensus()));
+        BOOST_CHECK_EQUAL(block.GetHash(), tip->GetBlockHash());
+    }
+    // Other tests may have read the same block already
+    const auto after{node::g_block_cache.GetStats()};
+    BOOST_CHECK_EQUAL((after.hits - before.hits) + (after.misses - before.misses), 3U);
+    BOOST_CHECK(after.hits > before.hits);
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_batched_undo, TestChain100Setup)
+{
+    // The undo records held back while blocks are connected are on disk once ActivateBestChain() returns
+    const CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())};
+    for (const CBlockIndex* pindex = tip; pindex->pprev; pindex = pindex->pprev) {
+        CBlockUndo undo;
+        BOOST_REQUIRE(UndoReadFromDisk(undo, pindex));
+        const FlatFilePos pos{WITH_LOCK(::cs_main, return pindex->GetUndoPos())};
+        CBlockUndo undo_at_pos;
+        BOOST_REQUIRE(UndoReadFromDisk(undo_at_pos, pos, pindex->pprev->GetBlockHash()));
+        BOOST_CHECK_EQUAL(undo.vtxundo.size(), undo_at_pos.vtxundo.size());
+    }
+
+    // Undo data written just before is read back to disconnect blocks
+    for (int i = 0; i < 3; ++i) CreateAndProcessBlock({}, CScript() << OP_TRUE);
+    CBlockIndex* fork{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain()[tip->nHeight + 1])};
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    BlockValidationState state;
+    BOOST_REQUIRE(chainstate.InvalidateBlock(state, fork));
+    BOOST_CHECK_EQUAL(WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip()), tip);
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_compressed_blocks)
+{
+    const auto params{CreateChainParams(ArgsManager{}, CBaseChainParams::MAIN)};
+    BlockManager blockman{{.compress_blocks = true}};
+    CChain chain{};
+
+    // A block carrying a repetitive payload, spanning several compressed pieces
+    CBlock block{params->GenesisBlock()};
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vout.emplace_back(0, CScript() << OP_RETURN << std::vector<uint8_t>(150000, 0x42));
+    block.vtx.push_back(MakeTransactionRef(mtx));
+    std::vector<uint8_t> serialized;
+    CVectorWriter{SER_DISK, CLIENT_VERSION, serialized, 0} << block;
+
+    std::vector<uint8_t> record;
+    CompressBlock(serialized, record);
+    BOOST_CHECK(record.size() * 10 < serialized.size());
+    std::vector<uint8_t> decompressed;
+    BOOST_CHECK(DecompressBlock(record, decompressed));
+    BOOST_CHECK(decompressed == serialized);
+    BOOST_CHECK(!DecompressBlock(Span{record}.first(record.size() - 1), decompressed));
+
+    // Written as a flagged record, accounted for at its compressed size
+    const FlatFilePos pos{blockman.SaveBlockToDisk(block, 0, chain, *params, nullptr)};
+    BOOST_CHECK_EQUAL(pos.nPos, BLOCK_SERIALIZATION_HEADER_SIZE);
+    BOOST_CHECK_EQUAL(blockman.GetBlockFileInfo(0)->nSize, BLOCK_SERIALIZATION_HEADER_SIZE + record.size());
+    {
+        AutoFile file{OpenBlockFile({0, 0}, true)};
+        CMessageHeader::MessageStartChars start;
+        uint32_t size;
+        file >> start >> size;
+        BOOST_CHECK_EQUAL(size, record.size() | BLOCK_RECORD_COMPRESSED);
+    }
+
+    // Read back through the file and the mapping, decompressed or out of the decompressed cache
+    for (const size_t maps : {0, 16}) {
+        node::g_block_file_maps.SetMaxFiles(maps);
+        for (int read = 0; read < 2; ++read) {
+            CBlock stored;
+            BOOST_CHECK(ReadBlockFromDisk(stored, pos, params->GetConsensus(), /*check_pow=*/false));
+            BOOST_CHECK_EQUAL(stored.GetHash(), block.GetHash());
+            BOOST_CHECK_EQUAL(stored.vtx.size(), 2U);
+            std::vector<uint8_t> raw;
+            BOOST_CHECK(ReadRawBlockFromDisk(raw, pos, params->MessageStart()));
+            BOOST_CHECK(raw == serialized);
+            CBlockHeader header;
+            CTransactionRef tx;
+            const unsigned int tx_offset{unsigned(GetSizeOfCompactSize(block.vtx.size()) + ::GetSerializeSize(*block.vtx[0], CLIENT_VERSION))};
+            BOOST_CHECK(ReadTransactionFromDisk(pos, tx_offset, header, tx));
+            BOOST_CHECK_EQUAL(header.GetHash(), block.GetHash());
+            BOOST_CHECK_EQUAL(tx->GetHash(), block.vtx[1]->GetHash());
+        }
+        node::g_decompressed_blocks.EraseFile(pos.nFile);
+    }
+    node::g_block_file_maps.SetMaxFiles(node::DEFAULT_BLOCK_FILE_MAPS);
+
+    // Found by a -reindex, and accounted for at its stored size again
+    const std::vector<ExternalBlock> blocks{ParseBlockFile(OpenBlockFile({0, 0}, true), 0, *params)};
+    BOOST_REQUIRE_EQUAL(blocks.size(), 1U);
+    BOOST_CHECK_EQUAL(blocks[0].hash, block.GetHash());
+    BOOST_CHECK(blocks[0].pos == pos);
+    BlockManager reindexing{{}};
+    BOOST_CHECK(reindexing.SaveBlockToDisk(block, 0, chain, *params, &blocks[0].pos) == pos);
+    BOOST_CHECK_EQUAL(reindexing.GetBlockFileInfo(0)->nSize, BLOCK_SERIALIZATION_HEADER_SIZE + record.size());
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_parse_block_file, TestChain100Setup)
+{
+    // Parse the blocks as a -reindex does, ahead of accepting them
+    const std::vector<ExternalBlock> blocks{ParseBlockFile(node::OpenBlockFile(FlatFilePos{0, 0}, true), 0, Params())};
+    LOCK(::cs_main);
+    BOOST_CHECK_EQUAL(blocks.size(), m_node.chainman->ActiveHeight() + 1U);
+    for (const ExternalBlock& external : blocks) {
+        BOOST_CHECK_EQUAL(external.hash, external.block->GetHash());
+        BOOST_CHECK(external.block->fChecked);
+        const CBlockIndex* pindex{m_node.chainman->m_blockman.LookupBlockIndex(external.hash)};
+        BOOST_REQUIRE(pindex);
+        BOOST_CHECK(pindex->GetBlockPos() == external.pos);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_reindex_progress, TestChain100Setup)
+{
+    LOCK(::cs_main);
+    CBlockTreeDB& block_tree_db{*m_node.chainman->m_blockman.m_block_tree_db};
+    BOOST_CHECK_EQUAL(block_tree_db.ReadReindexProgress(), 0);
+    BOOST_CHECK(block_tree_db.WriteReindexing(true));
+    BOOST_CHECK(block_tree_db.WriteReindexProgress(3));
+    BOOST_CHECK_EQUAL(block_tree_db.ReadReindexProgress(), 3);
+    // A finished reindex leaves nothing to resume
+    BOOST_CHECK(block_tree_db.WriteReindexing(false));
+    BOOST_CHECK_EQUAL(block_tree_db.ReadReindexProgress(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
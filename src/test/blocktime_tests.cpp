@@ -0,0 +1,77 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blocktime.h>
+#include <chain.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(blocktime_tests, BasicTestingSetup)
+
+//! Walk back from pindex as the windows are defined, the way the statistics were computed before
+static BlockTimeWindowStats WalkWindow(const CBlockIndex* pindex, BlockTimeWindow window)
+{
+    BlockTimeWindowStats stats;
+    const int64_t tip_time = pindex->GetBlockTime();
+    while (pindex && tip_time - pindex->GetBlockTime() < BlockTimeWindowSpan(window)) {
+        ++stats.blocks;
+        pindex = pindex->pprev;
+    }
+    stats.complete = pindex != nullptr;
+    if (stats.complete) {
+        stats.average = double(tip_time - pindex->GetBlockTime()) / stats.blocks;
+    }
+    return stats;
+}
+
+static void CheckWindows(const BlockTimeStats& stats, const CBlockIndex* tip)
+{
+    for (size_t w = 0; w < NUM_BLOCK_TIME_WINDOWS; ++w) {
+        const BlockTimeWindow window = (BlockTimeWindow)w;
+        const BlockTimeWindowStats expected = WalkWindow(tip, window);
+        const BlockTimeWindowStats actual = stats.GetWindowStats(window);
+        BOOST_CHECK_EQUAL(actual.blocks, expected.blocks);
+        BOOST_CHECK_EQUAL(actual.complete, expected.complete);
+        BOOST_CHECK_EQUAL(actual.average, expected.average);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_time_windows)
+{
+    // Blocks of 2 to 10 minutes, so the month window reaches back to genesis at first
+    std::vector<CBlockIndex> blocks(12000);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i].nHeight = i;
+        blocks[i].pprev = i > 0 ? &blocks[i - 1] : nullptr;
+        blocks[i].nTime = i > 0 ? blocks[i - 1].nTime + 120 + InsecureRandRange(481) : 1600000000;
+    }
+
+    BlockTimeStats stats;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        stats.SetTip(&blocks[i]);
+        if (i % 97 == 0) CheckWindows(stats, &blocks[i]);
+    }
+    CheckWindows(stats, &blocks.back());
+
+    // Disconnecting blocks moves the windows back
+    for (size_t i = blocks.size() - 1; i > blocks.size() - 500; --i) {
+        stats.SetTip(&blocks[i - 1]);
+    }
+    BOOST_CHECK_EQUAL(stats.GetTip(), &blocks[blocks.size() - 500]);
+    CheckWindows(stats, stats.GetTip());
+
+    // A tip that is neither a child nor the parent of the last rebuilds the windows
+    stats.SetTip(&blocks[6000]);
+    CheckWindows(stats, &blocks[6000]);
+
+    const BlockTimeWindowStats hour = stats.GetWindowStats(BlockTimeWindow::HOUR);
+    BOOST_CHECK(hour.p10 <= hour.p50 && hour.p50 <= hour.p90);
+    BOOST_CHECK(hour.p10 >= 120 && hour.p90 <= 600);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
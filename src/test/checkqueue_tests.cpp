@@ -14,6 +14,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <set>
 #include <thread>
 #include <unordered_set>
 #include <utility>
@@ -134,6 +135,46 @@ struct FrozenCleanupCheck {
     }
 };
 
+struct CountingCheck {
+    static std::atomic<size_t> n_calls;
+    bool fails{false};
+    bool operator()() const
+    {
+        n_calls.fetch_add(1, std::memory_order_relaxed);
+        return !fails;
+    }
+};
+
+// Fails unless `target` checks of its kind are running at once before a timeout
+struct ConcurrentCheck {
+    static Mutex m;
+    static std::condition_variable cv;
+    static size_t started GUARDED_BY(m);
+    static size_t target GUARDED_BY(m);
+    static std::set<std::thread::id> threads GUARDED_BY(m);
+    //! Only take longer than a batch is aimed to, for the queue to measure
+    bool slow{false};
+    bool operator()() const
+    {
+        if (slow) {
+            UninterruptibleSleep(std::chrono::milliseconds{2});
+            return true;
+        }
+        WAIT_LOCK(m, lock);
+        threads.insert(std::this_thread::get_id());
+        ++started;
+        cv.notify_all();
+        return cv.wait_for(lock, std::chrono::seconds{10}, [&]() EXCLUSIVE_LOCKS_REQUIRED(m) { return started >= target; });
+    }
+    static void Reset(size_t target_in)
+    {
+        LOCK(m);
+        started = 0;
+        target = target_in;
+        threads.clear();
+    }
+};
+
 // Static Allocations
 std::mutex FrozenCleanupCheck::m{};
 std::atomic<uint64_t> FrozenCleanupCheck::nFrozen{0};
@@ -142,6 +183,12 @@ Mutex UniqueCheck::m;
 std::unordered_multiset<size_t> UniqueCheck::results;
 std::atomic<size_t> FakeCheckCheckCompletion::n_calls{0};
 std::atomic<size_t> MemoryCheck::fake_allocated_memory{0};
+std::atomic<size_t> CountingCheck::n_calls{0};
+Mutex ConcurrentCheck::m;
+std::condition_variable ConcurrentCheck::cv;
+size_t ConcurrentCheck::started{0};
+size_t ConcurrentCheck::target{0};
+std::set<std::thread::id> ConcurrentCheck::threads;
 
 // Queue Typedefs
 typedef CCheckQueue<FakeCheckCheckCompletion> Correct_Queue;
@@ -150,6 +197,8 @@ typedef CCheckQueue<FailingCheck> Failing_Queue;
 typedef CCheckQueue<UniqueCheck> Unique_Queue;
 typedef CCheckQueue<MemoryCheck> Memory_Queue;
 typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
+typedef CCheckQueue<CountingCheck> Counting_Queue;
+typedef CCheckQueue<ConcurrentCheck> Concurrent_Queue;
 
 
 /** This test case checks that the CCheckQueue works properly
@@ -365,6 +414,73 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_FrozenCleanup)
 
 
 /** Test that CCheckQueueControl is threadsafe */
+// Test that the checks Add put in the queue of one worker are stolen by
+// another thread when that worker is busy
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Steals)
+{
+    for (int i = 0; i < 10; ++i) {
+        // A queue yet to measure the cost of its checks puts fewer than a batch in one worker's queue
+        auto queue = std::make_unique<Concurrent_Queue>(QUEUE_BATCH_SIZE);
+        queue->StartWorkerThreads(SCRIPT_CHECK_THREADS);
+        ConcurrentCheck::Reset(2);
+        {
+            CCheckQueueControl<ConcurrentCheck> control(queue.get());
+            control.Add(std::vector<ConcurrentCheck>(2));
+            BOOST_REQUIRE(control.Wait());
+        }
+        BOOST_CHECK_EQUAL(WITH_LOCK(ConcurrentCheck::m, return ConcurrentCheck::threads.size()), 2U);
+        queue->StopWorkerThreads();
+    }
+}
+
+// Test that once the checks are measured to take longer than a batch is aimed
+// to, Add spreads even a few of them over the workers and wakes each
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Adapts_Batch_Size)
+{
+    auto queue = std::make_unique<Concurrent_Queue>(QUEUE_BATCH_SIZE);
+    queue->StartWorkerThreads(SCRIPT_CHECK_THREADS);
+    {
+        CCheckQueueControl<ConcurrentCheck> control(queue.get());
+        control.Add(std::vector<ConcurrentCheck>(20, ConcurrentCheck{.slow = true}));
+        BOOST_REQUIRE(control.Wait());
+    }
+    // As many checks as workers only all run at once if Add spread them and woke every worker
+    ConcurrentCheck::Reset(SCRIPT_CHECK_THREADS);
+    {
+        CCheckQueueControl<ConcurrentCheck> control(queue.get());
+        control.Add(std::vector<ConcurrentCheck>(SCRIPT_CHECK_THREADS));
+        BOOST_REQUIRE(control.Wait());
+    }
+    BOOST_CHECK_EQUAL(WITH_LOCK(ConcurrentCheck::m, return ConcurrentCheck::threads.size()), size_t(SCRIPT_CHECK_THREADS));
+    queue->StopWorkerThreads();
+}
+
+// Test that once a check fails, the batches taken after it are not run
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Stops_On_Failure)
+{
+    // Without workers, the master takes the checks from the back of its queue
+    auto queue = std::make_unique<Counting_Queue>(QUEUE_BATCH_SIZE);
+    CountingCheck::n_calls = 0;
+    {
+        CCheckQueueControl<CountingCheck> control(queue.get());
+        std::vector<CountingCheck> checks(1000);
+        checks.back().fails = true;
+        control.Add(std::move(checks));
+        BOOST_CHECK(!control.Wait());
+    }
+    BOOST_CHECK_GE(CountingCheck::n_calls, 1U);
+    BOOST_CHECK_LE(CountingCheck::n_calls, QUEUE_BATCH_SIZE);
+
+    // The next checks run in full
+    CountingCheck::n_calls = 0;
+    {
+        CCheckQueueControl<CountingCheck> control(queue.get());
+        control.Add(std::vector<CountingCheck>(1000));
+        BOOST_CHECK(control.Wait());
+    }
+    BOOST_CHECK_EQUAL(CountingCheck::n_calls, 1000U);
+}
+
 BOOST_AUTO_TEST_CASE(test_CheckQueueControl_Locks)
 {
     auto queue = std::make_unique<Standard_Queue>(QUEUE_BATCH_SIZE);
@@ -612,7 +612,8 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags, const C
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMap map;
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
     InsertCoinsMapEntry(map, value, flags);
     BOOST_CHECK(view.BatchWrite(map, {}));
 }
@@ -682,6 +683,80 @@ BOOST_AUTO_TEST_CASE(ccoins_access)
     CheckAccessCoin(VALUE1, VALUE2, VALUE2, DIRTY|FRESH, DIRTY|FRESH);
 }
 
+static void CheckFetchedCoin(CAmount base_value, CAmount cache_value, char cache_flags)
+{
+    // Caching a coin read from the base must leave the entry a lookup through the cache would
+    SingleEntryCacheTest fetched(base_value, cache_value, cache_flags);
+    Coin coin;
+    if (fetched.base.GetCoin(OUTPOINT, coin)) fetched.cache.AddFetchedCoin(OUTPOINT, std::move(coin));
+    fetched.cache.SelfTest();
+
+    SingleEntryCacheTest accessed(base_value, cache_value, cache_flags);
+    accessed.cache.AccessCoin(OUTPOINT);
+
+    CAmount fetched_value, accessed_value;
+    char fetched_flags, accessed_flags;
+    GetCoinsMapEntry(fetched.cache.map(), fetched_value, fetched_flags);
+    GetCoinsMapEntry(accessed.cache.map(), accessed_value, accessed_flags);
+    BOOST_CHECK_EQUAL(fetched_value, accessed_value);
+    BOOST_CHECK_EQUAL(fetched_flags, accessed_flags);
+    BOOST_CHECK_EQUAL(fetched.cache.DynamicMemoryUsage(), accessed.cache.DynamicMemoryUsage());
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_fetched)
+{
+    for (const CAmount base_value : {ABSENT, SPENT, VALUE1}) {
+        CheckFetchedCoin(base_value, ABSENT, NO_ENTRY);
+        for (const CAmount cache_value : {SPENT, VALUE2}) {
+            for (const char cache_flags : FLAGS) {
+                CheckFetchedCoin(base_value, cache_value, cache_flags);
+            }
+        }
+    }
+}
+
+static void CheckGetCoins(CAmount base_value, CAmount cache_value, char cache_flags)
+{
+    // Looking up a coin among others must find it and leave the entry a lookup of it alone would
+    SingleEntryCacheTest batched(base_value, cache_value, cache_flags);
+    const COutPoint other{InsecureRand256(), 0};
+    std::vector<std::optional<Coin>> coins;
+    const size_t found{batched.cache.GetCoins({other, OUTPOINT, OUTPOINT}, coins)};
+    batched.cache.SelfTest();
+
+    SingleEntryCacheTest single(base_value, cache_value, cache_flags);
+    Coin coin;
+    const bool have{single.cache.GetCoin(OUTPOINT, coin)};
+
+    BOOST_REQUIRE_EQUAL(coins.size(), 3U);
+    BOOST_CHECK(!coins[0]);
+    BOOST_CHECK_EQUAL(found, have ? 2U : 0U);
+    for (size_t i = 1; i < coins.size(); ++i) {
+        BOOST_CHECK_EQUAL(coins[i].has_value(), have);
+        if (have && coins[i]) BOOST_CHECK_EQUAL(coins[i]->out.nValue, coin.out.nValue);
+    }
+
+    CAmount batched_value, single_value;
+    char batched_flags, single_flags;
+    GetCoinsMapEntry(batched.cache.map(), batched_value, batched_flags);
+    GetCoinsMapEntry(single.cache.map(), single_value, single_flags);
+    BOOST_CHECK_EQUAL(batched_value, single_value);
+    BOOST_CHECK_EQUAL(batched_flags, single_flags);
+    BOOST_CHECK_EQUAL(batched.cache.DynamicMemoryUsage(), single.cache.DynamicMemoryUsage());
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_get_many)
+{
+    for (const CAmount base_value : {ABSENT, SPENT, VALUE1}) {
+        CheckGetCoins(base_value, ABSENT, NO_ENTRY);
+        for (const CAmount cache_value : {SPENT, VALUE2}) {
+            for (const char cache_flags : FLAGS) {
+                CheckGetCoins(base_value, cache_value, cache_flags);
+            }
+        }
+    }
+}
+
 static void CheckSpendCoins(CAmount base_value, CAmount cache_value, CAmount expected_value, char cache_flags, char expected_flags)
 {
     SingleEntryCacheTest test(base_value, cache_value, cache_flags);
@@ -1076,4 +1151,87 @@ BOOST_AUTO_TEST_CASE(ccoins_flush_behavior)
     }
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_db_get_many)
+{
+    CCoinsViewDB db{{.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewCache cache{&db};
+
+    // Transactions of several outputs, of which every third is absent
+    std::vector<COutPoint> outpoints;
+    std::map<COutPoint, CAmount> values;
+    for (int tx = 0; tx < 50; ++tx) {
+        const uint256 txid{InsecureRand256()};
+        for (uint32_t n = 0; n < 150; n += 1 + InsecureRandRange(3)) {
+            outpoints.emplace_back(txid, n);
+            if (outpoints.size() % 3 == 0) continue;
+            Coin coin;
+            coin.out.nValue = InsecureRand32();
+            coin.nHeight = 1;
+            values.emplace(outpoints.back(), coin.out.nValue);
+            cache.AddCoin(outpoints.back(), std::move(coin), /*possible_overwrite=*/false);
+        }
+    }
+    cache.SetBestBlock(InsecureRand256());
+    BOOST_CHECK(cache.Flush());
+    Shuffle(outpoints.begin(), outpoints.end(), g_insecure_rand_ctx);
+
+    for (const size_t workers : {1, 2, 7}) {
+        std::vector<std::optional<Coin>> coins;
+        BOOST_CHECK_EQUAL(db.GetCoins(outpoints, coins, workers), values.size());
+        BOOST_REQUIRE_EQUAL(coins.size(), outpoints.size());
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            const auto it{values.find(outpoints[i])};
+            BOOST_REQUIRE_EQUAL(coins[i].has_value(), it != values.end());
+            if (coins[i]) BOOST_CHECK_EQUAL(coins[i]->out.nValue, it->second);
+        }
+    }
+
+    std::vector<std::optional<Coin>> coins;
+    BOOST_CHECK_EQUAL(db.GetCoins({}, coins, /*workers=*/4), 0U);
+    BOOST_CHECK(coins.empty());
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_background_flush)
+{
+    CCoinsView root;
+    CCoinsViewCache base{&root};
+    CCoinsViewBackgroundFlush flush{&base, /*background=*/true};
+    CCoinsViewCache tip{&flush};
+
+    Coin coin;
+    coin.out.nValue = 1;
+    const COutPoint spent{InsecureRand256(), 0};
+    tip.AddCoin(spent, Coin{coin}, /*possible_overwrite=*/false);
+    tip.SetBestBlock(InsecureRand256());
+    BOOST_CHECK(tip.Flush());
+    BOOST_CHECK(base.HaveCoin(spent));
+
+    std::vector<COutPoint> added;
+    for (uint32_t i = 0; i < 100; ++i) {
+        added.emplace_back(InsecureRand256(), i);
+        tip.AddCoin(added.back(), Coin{coin}, /*possible_overwrite=*/false);
+    }
+    BOOST_CHECK(tip.SpendCoin(spent));
+    const uint256 best_block{InsecureRand256()};
+    tip.SetBestBlock(best_block);
+
+    // The coins read the same whether or not they are written yet
+    flush.DeferNextWrite();
+    BOOST_CHECK(tip.Flush());
+    BOOST_CHECK_EQUAL(tip.GetCacheSize(), 0U);
+    BOOST_CHECK(flush.GetBestBlock() == best_block);
+    BOOST_CHECK(!tip.HaveCoin(spent));
+    for (const COutPoint& outpoint : added) {
+        BOOST_CHECK(tip.HaveCoin(outpoint));
+    }
+
+    BOOST_CHECK(flush.Wait());
+    BOOST_CHECK_EQUAL(flush.DynamicMemoryUsage(), 0U);
+    BOOST_CHECK(base.GetBestBlock() == best_block);
+    BOOST_CHECK(!base.HaveCoin(spent));
+    for (const COutPoint& outpoint : added) {
+        BOOST_CHECK(base.HaveCoinInCache(outpoint));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -112,6 +112,8 @@ BOOST_FIXTURE_TEST_CASE(coinstatsindex_unclean_shutdown, TestChain100Setup)
             BOOST_CHECK(chainstate.AcceptBlock(new_block, state, &new_block_index, true, nullptr, nullptr, true));
             CCoinsViewCache view(&chainstate.CoinsTip());
             BOOST_CHECK(chainstate.ConnectBlock(block, state, new_block_index, view));
+            // As ActivateBestChain() does once it connected blocks
+            BOOST_CHECK(chainstate.m_blockman.WritePendingUndo());
         }
         // Send block connected notification, then stop the index without
         // sending a chainstate flushed notification. Prior to #24138, this
@@ -128,4 +130,38 @@ BOOST_FIXTURE_TEST_CASE(coinstatsindex_unclean_shutdown, TestChain100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(coinstats_parallel_walk, TestChain100Setup)
+{
+    Chainstate& chainstate{m_node.chainman->ActiveChainstate()};
+    LOCK(cs_main);
+    chainstate.ForceFlushStateToDisk();
+    CCoinsView* view{&chainstate.CoinsDB()};
+    node::BlockManager& blockman{m_node.chainman->m_blockman};
+
+    // Reading the ranges of the coins on threads gives the statistics and hashes of a single walk
+    for (const auto hash_type : {kernel::CoinStatsHashType::HASH_SERIALIZED, kernel::CoinStatsHashType::MUHASH, kernel::CoinStatsHashType::NONE}) {
+        const auto serial{kernel::ComputeUTXOStats(hash_type, view, blockman, [] {}, 1)};
+        BOOST_REQUIRE(serial);
+        BOOST_CHECK(serial->coins_count > 0);
+        for (const size_t workers : {2, 3, 16}) {
+            const auto parallel{kernel::ComputeUTXOStats(hash_type, view, blockman, [] {}, workers)};
+            BOOST_REQUIRE(parallel);
+            BOOST_CHECK_EQUAL(parallel->hashSerialized, serial->hashSerialized);
+            BOOST_CHECK_EQUAL(parallel->nTransactions, serial->nTransactions);
+            BOOST_CHECK_EQUAL(parallel->nTransactionOutputs, serial->nTransactionOutputs);
+            BOOST_CHECK_EQUAL(parallel->nBogoSize, serial->nBogoSize);
+            BOOST_CHECK_EQUAL(parallel->coins_count, serial->coins_count);
+            BOOST_CHECK(parallel->total_amount == serial->total_amount);
+        }
+    }
+
+    // The ranges cover every coin once
+    const auto stats{kernel::ComputeUTXOStats(kernel::CoinStatsHashType::NONE, view, blockman, [] {}, 1)};
+    uint64_t coins{0};
+    for (const auto& cursor : view->RangeCursors(256)) {
+        for (; cursor->Valid(); cursor->Next()) ++coins;
+    }
+    BOOST_CHECK_EQUAL(coins, stats->coins_count);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
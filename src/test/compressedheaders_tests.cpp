@@ -0,0 +1,93 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <compressedheaders.h>
+#include <streams.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <version.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(compressedheaders_tests, BasicTestingSetup)
+
+//! Consecutive headers alternating between proof of work and proof of stake, as a Lynx chain does
+static std::vector<CBlock> MakeChain(size_t count)
+{
+    std::vector<CBlock> chain;
+    CBlockHeader header;
+    header.nTime = 1'600'000'000;
+    for (size_t i = 0; i < count; ++i) {
+        header.hashPrevBlock = chain.empty() ? InsecureRand256() : chain.back().GetHash();
+        header.hashMerkleRoot = InsecureRand256();
+        const bool pos{InsecureRandBool()};
+        header.nVersion = InsecureRandRange(10) == 0 ? 0x20000004 : 0x20000000;
+        header.nBits = pos ? 0x1e0fffff : 0x1d00ffff + (i / 100);
+        header.nNonce = pos ? 0 : InsecureRand32();
+        // Timestamps may go back a little
+        header.nTime = header.nTime + InsecureRandRange(600) - 120;
+        chain.emplace_back(header);
+    }
+    return chain;
+}
+
+BOOST_AUTO_TEST_CASE(roundtrip)
+{
+    for (const size_t count : {0, 1, 2, 2000}) {
+        const std::vector<CBlock> chain{MakeChain(count)};
+        DataStream stream{};
+        stream << CompressedHeaders{std::vector<CBlockHeader>(chain.begin(), chain.end())};
+
+        CompressedHeaders decoded;
+        stream >> decoded;
+        BOOST_CHECK(stream.empty());
+        BOOST_REQUIRE_EQUAL(decoded.headers.size(), count);
+        for (size_t i = 0; i < count; ++i) {
+            BOOST_CHECK_EQUAL(decoded.headers[i].GetHash(), chain[i].GetHash());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(size)
+{
+    const std::vector<CBlock> chain{MakeChain(2000)};
+    CDataStream headers{SER_NETWORK, PROTOCOL_VERSION};
+    headers << chain;
+    DataStream compressed{};
+    compressed << CompressedHeaders{std::vector<CBlockHeader>(chain.begin(), chain.end())};
+    // 81 bytes a header in "headers", against flags, 2 bytes of time, the merkle root and nonce
+    BOOST_CHECK_LT(compressed.size() * 2, headers.size());
+}
+
+BOOST_AUTO_TEST_CASE(malformed)
+{
+    const std::vector<CBlock> chain{MakeChain(2)};
+    DataStream stream{};
+    stream << CompressedHeaders{std::vector<CBlockHeader>(chain.begin(), chain.end())};
+    // Count, first header, then the flags of the second
+    const size_t flags_pos{1 + 80};
+    CompressedHeaders decoded;
+
+    // A position among the recent values beyond those seen
+    DataStream unknown_value{stream};
+    unknown_value[flags_pos] = std::byte{0x03};
+    BOOST_CHECK_THROW(unknown_value >> decoded, std::ios_base::failure);
+
+    DataStream unknown_flags{stream};
+    unknown_flags[flags_pos] = std::byte(uint8_t(unknown_flags[flags_pos]) | 0x10);
+    BOOST_CHECK_THROW(unknown_flags >> decoded, std::ios_base::failure);
+
+    // More headers than the message holds
+    DataStream truncated{stream};
+    truncated[0] = std::byte{0xfc};
+    BOOST_CHECK_THROW(truncated >> decoded, std::ios_base::failure);
+
+    // More headers than a message may hold, turned away before any is decoded
+    DataStream too_many{};
+    WriteCompactSize(too_many, MAX_COMPRESSED_HEADERS + 1);
+    too_many << static_cast<const CBlockHeader&>(chain[0]);
+    BOOST_CHECK_THROW(too_many >> decoded, std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
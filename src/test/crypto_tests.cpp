@@ -10,6 +10,7 @@
 #include <crypto/hmac_sha512.h>
 #include <crypto/poly1305.h>
 #include <crypto/ripemd160.h>
+#include <crypto/scrypt.h>
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
 #include <crypto/sha3.h>
@@ -600,6 +601,27 @@ BOOST_AUTO_TEST_CASE(chacha20_midblock)
     BOOST_CHECK_EQUAL(0, memcmp(b3, block + 12, 52));
 }
 
+BOOST_AUTO_TEST_CASE(chacha20_wide)
+{
+    // Runs of eight or more blocks may be computed eight at once, single blocks never are
+    const auto key = InsecureRand256();
+    const uint64_t iv = InsecureRandBits(64);
+    const uint64_t start = 0xFFFFFFFFULL - InsecureRandRange(20);
+    std::vector<unsigned char> in(64 * 21);
+    for (auto& b : in) b = InsecureRandBits(8);
+
+    std::vector<unsigned char> wide(in.size()), single(in.size());
+    ChaCha20 c20{key.begin()};
+    c20.SetIV(iv);
+    c20.Seek64(start);
+    c20.Crypt(in.data(), wide.data(), in.size());
+    for (size_t i = 0; i < in.size(); i += CHACHA20_ROUND_OUTPUT) {
+        c20.Seek64(start + i / CHACHA20_ROUND_OUTPUT);
+        c20.Crypt(in.data() + i, single.data() + i, CHACHA20_ROUND_OUTPUT);
+    }
+    BOOST_CHECK(wide == single);
+}
+
 BOOST_AUTO_TEST_CASE(poly1305_testvector)
 {
     // RFC 7539, section 2.5.2.
@@ -875,6 +897,25 @@ static void TestSHA3_256(const std::string& input, const std::string& output)
     BOOST_CHECK(std::equal(std::begin(out_bytes), std::end(out_bytes), out));
 }
 
+BOOST_AUTO_TEST_CASE(scrypt_batch)
+{
+    const std::vector<unsigned char> header{ParseHex("020000004c1271c211717198227392b029a64a7971931d351b387bb80db027f270411e398a07046f7d4a08dd815412a8712f874a7ebf0507e3878bd24e20a3b73fd750a667d2f451eac7471b00de6659")};
+    uint256 hash;
+    scrypt_1024_1_1_256((const char*)header.data(), (char*)hash.begin());
+    BOOST_CHECK_EQUAL(hash.GetHex(), "00000000002bef4107f882f6115e0b01f348d21195dacd3582aa2dabd7985806");
+
+    // Every count covers a different mix of the 8 way, 4 way and generic implementations
+    for (size_t count = 0; count <= 2 * SCRYPT_BATCH_MAX + 3; ++count) {
+        const std::vector<unsigned char> input{g_insecure_rand_ctx.randbytes(80 * count)};
+        std::vector<uint256> expected(count), hashes(count);
+        for (size_t i = 0; i < count; ++i) {
+            scrypt_1024_1_1_256((const char*)input.data() + 80 * i, (char*)expected[i].begin());
+        }
+        scrypt_1024_1_1_256_batch((const char*)input.data(), (char*)hashes.data(), count);
+        BOOST_CHECK(hashes == expected);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(keccak_tests)
 {
     // Start with the zero state.
@@ -370,4 +370,43 @@ BOOST_AUTO_TEST_CASE(cuckoocache_generations)
     test_cache_generations<CuckooCache::cache<uint256, SignatureCacheHasher>>();
 }
 
+/** Check that resize_bytes keeps the elements not erased, and that insert
+ * reports the evictions of overfilling the cache.
+ */
+BOOST_AUTO_TEST_CASE(cuckoocache_resize)
+{
+    SeedInsecureRand(SeedRand::ZEROS);
+    CuckooCache::cache<uint256, SignatureCacheHasher> cc{};
+    const uint32_t num_elems{1 << 10};
+    BOOST_CHECK_EQUAL(cc.setup_bytes(num_elems * sizeof(uint256))->first, num_elems);
+
+    std::vector<uint256> hashes;
+    for (uint32_t i = 0; i < num_elems / 2; ++i) {
+        hashes.push_back(InsecureRand256());
+        cc.insert(hashes.back());
+    }
+    // Erase the first quarter of them
+    for (uint32_t i = 0; i < num_elems / 8; ++i) {
+        BOOST_CHECK(cc.contains(hashes[i], true));
+    }
+
+    const auto resized{cc.resize_bytes(4 * num_elems * sizeof(uint256))};
+    BOOST_REQUIRE(resized);
+    BOOST_CHECK_EQUAL(resized->first, 4 * num_elems);
+    BOOST_CHECK_EQUAL(resized->second, 4 * num_elems * sizeof(uint256));
+    for (uint32_t i = 0; i < num_elems / 8; ++i) {
+        BOOST_CHECK(!cc.contains(hashes[i], false));
+    }
+    for (uint32_t i = num_elems / 8; i < num_elems / 2; ++i) {
+        BOOST_CHECK(cc.contains(hashes[i], false));
+    }
+
+    // Twice as many elements as fit can't all be kept
+    size_t evictions{0};
+    for (uint32_t i = 0; i < 8 * num_elems; ++i) {
+        evictions += cc.insert(InsecureRand256());
+    }
+    BOOST_CHECK(evictions > 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
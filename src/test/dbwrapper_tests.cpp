@@ -3,12 +3,17 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <dbwrapper.h>
+#include <node/database_args.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <uint256.h>
 #include <util/string.h>
+#include <util/system.h>
 
+#include <algorithm>
+#include <future>
 #include <memory>
+#include <optional>
 
 #include <boost/test/unit_test.hpp>
 
@@ -384,6 +389,154 @@ BOOST_AUTO_TEST_CASE(iterator_string_ordering)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_read_many)
+{
+    for (const bool obfuscate : {false, true}) {
+        CDBWrapper dbw({.path = m_args.GetDataDirBase() / "dbwrapper_read_many", .cache_bytes = 1 << 20, .memory_only = true, .obfuscate = obfuscate});
+        // Every other key, so lookups alternate between found and missing
+        for (uint32_t key = 0; key < 1000; key += 2) {
+            BOOST_CHECK(dbw.Write(key, uint64_t{key} * 3));
+        }
+
+        std::vector<uint32_t> keys{2000, 4, 3, 998, 4, 0, 1001};
+        for (int i = 0; i < 200; ++i) {
+            keys.push_back(InsecureRandRange(1200));
+        }
+        for (const size_t workers : {1, 3, 1000}) {
+            std::vector<std::optional<uint64_t>> values;
+            const size_t found{dbw.ReadMany(keys, values, workers)};
+            BOOST_REQUIRE_EQUAL(values.size(), keys.size());
+            size_t expected{0};
+            for (size_t i = 0; i < keys.size(); ++i) {
+                uint64_t value;
+                const bool have{dbw.Read(keys[i], value)};
+                BOOST_REQUIRE_EQUAL(values[i].has_value(), have);
+                if (have) {
+                    BOOST_CHECK_EQUAL(*values[i], value);
+                    ++expected;
+                }
+            }
+            BOOST_CHECK_EQUAL(found, expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_options_stats)
+{
+    DBOptions options;
+    options.write_buffer_size = 1 << 20;
+    options.bloom_bits = 14;
+    options.max_file_size = 4 << 20;
+    {
+        CDBWrapper dbw({.path = m_args.GetDataDirBase() / "dbwrapper_stats", .name = "statsdb", .cache_bytes = 1 << 20, .options = options});
+        for (uint8_t key = 0; key < 100; ++key) {
+            BOOST_CHECK(dbw.Write(key, InsecureRand256()));
+        }
+
+        const DBStats stats{dbw.GetStats()};
+        BOOST_CHECK_EQUAL(stats.name, "statsdb");
+        BOOST_CHECK(stats.path == m_args.GetDataDirBase() / "dbwrapper_stats");
+        BOOST_CHECK_EQUAL(stats.write_buffer_size, 1U << 20);
+        BOOST_CHECK_EQUAL(stats.bloom_bits, 14);
+        BOOST_CHECK_EQUAL(stats.max_file_size, 4U << 20);
+        BOOST_CHECK_EQUAL(stats.files_per_level.size(), 7U);
+        BOOST_CHECK(stats.memory_usage > 0);
+        BOOST_CHECK(!stats.leveldb_stats.empty());
+
+        const auto all{GetDatabaseStats()};
+        BOOST_CHECK_EQUAL(std::count_if(all.begin(), all.end(), [](const DBStats& s) { return s.name == "statsdb"; }), 1);
+
+        // A manual compaction writes the keys into table files, counted in the stats
+        BOOST_CHECK_EQUAL(stats.compaction_rate, 0U);
+        const std::optional<DBStats> compacted{CompactDatabase("statsdb")};
+        BOOST_REQUIRE(compacted);
+        BOOST_CHECK(compacted->compactions > 0);
+        BOOST_CHECK(compacted->compaction_bytes_written > 0);
+        BOOST_CHECK_EQUAL(compacted->compaction_throttled_micros, 0);
+        BOOST_CHECK(!CompactDatabase("nosuchdb"));
+        for (uint8_t key = 0; key < 100; ++key) {
+            uint256 value;
+            BOOST_CHECK(dbw.Read(key, value));
+        }
+    }
+    // Closed databases are no longer listed
+    const auto all{GetDatabaseStats()};
+    BOOST_CHECK_EQUAL(std::count_if(all.begin(), all.end(), [](const DBStats& s) { return s.name == "statsdb"; }), 0);
+
+    // Without a name, a database goes by the last part of its path
+    CDBWrapper dbw({.path = m_args.GetDataDirBase() / "dbwrapper_unnamed", .cache_bytes = 1 << 20, .memory_only = true});
+    BOOST_CHECK_EQUAL(dbw.GetStats().name, "dbwrapper_unnamed");
+    BOOST_CHECK(!dbw.GetStats().path);
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_compaction_control)
+{
+    DBOptions options;
+    options.compaction_rate = 1 << 20;
+    CDBWrapper dbw({.path = m_args.GetDataDirBase() / "dbwrapper_compaction", .name = "compactiondb", .cache_bytes = 1 << 20, .options = options});
+    BOOST_CHECK_EQUAL(dbw.GetStats().compaction_rate, 1U << 20);
+    for (uint16_t key = 0; key < 1000; ++key) {
+        BOOST_CHECK(dbw.Write(key, InsecureRand256()));
+    }
+
+    // A compaction deferred starts once no block connects, or after MAX_COMPACTION_DEFERRAL
+    std::optional<DeferCompactions> defer{std::in_place};
+    auto compacting{std::async(std::launch::async, [] { return CompactDatabase("compactiondb"); })};
+    BOOST_CHECK(compacting.wait_for(100ms) == std::future_status::timeout);
+    defer.reset();
+    const std::optional<DBStats> stats{compacting.get()};
+    BOOST_REQUIRE(stats);
+    BOOST_CHECK(stats->compaction_deferred_micros > 0);
+    BOOST_CHECK(stats->compaction_bytes_written > 0);
+    for (uint16_t key = 0; key < 1000; ++key) {
+        BOOST_CHECK(dbw.Exists(key));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(database_args)
+{
+    const auto read = [](const std::vector<std::string>& profiles, const std::vector<std::string>& db_options, const std::string& db_name, DBOptions& options) {
+        ArgsManager args;
+        args.AddArg("-dbprofile", "", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+        args.AddArg("-dboption", "", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+        std::vector<std::string> arg_strs{"ignored"};
+        for (const std::string& profile : profiles) arg_strs.push_back("-dbprofile=" + profile);
+        for (const std::string& option : db_options) arg_strs.push_back("-dboption=" + option);
+        std::vector<const char*> argv;
+        for (const std::string& arg : arg_strs) argv.push_back(arg.c_str());
+        std::string error;
+        BOOST_REQUIRE(args.ParseParameters(argv.size(), argv.data(), error));
+        return node::ReadDatabaseArgs(args, options, db_name);
+    };
+
+    DBOptions options;
+    BOOST_CHECK(!read({"hdd"}, {}, "chainstate", options));
+    BOOST_CHECK_EQUAL(options.bloom_bits, 14);
+    BOOST_CHECK_EQUAL(*options.max_file_size, 32U << 20);
+
+    // Settings for a database override those for all, whichever comes first,
+    // and options override profiles
+    options = {};
+    BOOST_CHECK(!read({"chainstate:archive"}, {"chainstate:bloombits=12", "writebuffer=64"}, "chainstate", options));
+    BOOST_CHECK_EQUAL(options.bloom_bits, 12);
+    BOOST_CHECK_EQUAL(*options.max_file_size, 64U << 20);
+    BOOST_CHECK_EQUAL(*options.write_buffer_size, 64U << 20);
+    BOOST_CHECK(!options.compaction_rate);
+    BOOST_CHECK(!read({}, {"compactionrate=20"}, "chainstate", options));
+    BOOST_CHECK_EQUAL(*options.compaction_rate, 20U << 20);
+    BOOST_CHECK(read({}, {"compactionrate=0"}, "chainstate", options));
+
+    // Settings for other databases are left out, but still checked
+    options = {};
+    BOOST_CHECK(!read({"txindex:hdd"}, {"txindex:maxfilesize=16"}, "chainstate", options));
+    BOOST_CHECK_EQUAL(options.bloom_bits, 10);
+    BOOST_CHECK(!options.max_file_size);
+    BOOST_CHECK(read({"txindex:flash"}, {}, "chainstate", options));
+    BOOST_CHECK(read({}, {"txindex:bloombits=100"}, "chainstate", options));
+    BOOST_CHECK(read({}, {"cachesize=4"}, "chainstate", options));
+    BOOST_CHECK(read({}, {"writebuffer"}, "chainstate", options));
+}
+
 BOOST_AUTO_TEST_CASE(unicodepath)
 {
     // Attempt to create a database with a UTF8 character in the path.
@@ -126,4 +126,58 @@ BOOST_AUTO_TEST_CASE(flatfile_flush)
     BOOST_CHECK_EQUAL(fs::file_size(seq.FileName(FlatFilePos(0, 1))), 1U);
 }
 
+BOOST_AUTO_TEST_CASE(flatfile_map)
+{
+    const auto data_dir = m_args.GetDataDirBase();
+    FlatFileSeq seq(data_dir, "m", 16 * 1024);
+    FlatFileMapCache maps(/*max_files=*/2);
+
+    const std::string data1("A purely peer-to-peer version of electronic cash");
+    const std::string data2(" would allow online payments");
+    {
+        AutoFile file{seq.Open(FlatFilePos(0, 0))};
+        file.write(MakeByteSpan(data1));
+    }
+
+    // Nothing to map
+    BOOST_CHECK(!maps.Get(seq, FlatFilePos(1, 0), 1));
+    BOOST_CHECK(!maps.Get(seq, FlatFilePos{}, 1));
+
+#ifndef WIN32
+    const auto mapping1{maps.Get(seq, FlatFilePos(0, 2), data1.size() - 2)};
+    BOOST_REQUIRE(mapping1);
+    BOOST_CHECK_EQUAL(mapping1->Data().size(), data1.size());
+    BOOST_CHECK(std::equal(data1.begin(), data1.end(), UCharCast(mapping1->Data().data())));
+    BOOST_CHECK_EQUAL(maps.Get(seq, FlatFilePos(0, 0), 1), mapping1);
+    // Past the end of the file
+    BOOST_CHECK(!maps.Get(seq, FlatFilePos(0, 2), data1.size()));
+
+    // A file growing is mapped again, the old mapping stays readable
+    {
+        AutoFile file{seq.Open(FlatFilePos(0, data1.size()))};
+        file.write(MakeByteSpan(data2));
+    }
+    const auto mapping2{maps.Get(seq, FlatFilePos(0, data1.size()), data2.size())};
+    BOOST_REQUIRE(mapping2);
+    BOOST_CHECK(mapping2 != mapping1);
+    BOOST_CHECK(std::equal(data2.begin(), data2.end(), UCharCast(mapping2->Data().data()) + data1.size()));
+    BOOST_CHECK(std::equal(data1.begin(), data1.end(), UCharCast(mapping1->Data().data())));
+
+    // Evicted beyond max_files, least recently read first
+    for (int n = 1; n <= 2; ++n) {
+        AutoFile file{seq.Open(FlatFilePos(n, 0))};
+        file.write(MakeByteSpan(data1));
+    }
+    BOOST_CHECK(maps.Get(seq, FlatFilePos(1, 0), 1));
+    BOOST_CHECK_EQUAL(maps.Get(seq, FlatFilePos(0, 0), 1), mapping2);
+    BOOST_CHECK(maps.Get(seq, FlatFilePos(2, 0), 1));
+    BOOST_CHECK_EQUAL(maps.Get(seq, FlatFilePos(0, 0), 1), mapping2);
+    maps.Erase(seq.FileName(FlatFilePos(0, 0)));
+    BOOST_CHECK(maps.Get(seq, FlatFilePos(0, 0), 1) != mapping2);
+#endif
+
+    maps.SetMaxFiles(0);
+    BOOST_CHECK(!maps.Get(seq, FlatFilePos(0, 0), 1));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,7 @@
 #include <blockfilter.h>
 #include <chain.h>
 #include <coins.h>
+#include <compressedheaders.h>
 #include <compressor.h>
 #include <consensus/merkle.h>
 #include <key.h>
@@ -208,6 +209,10 @@ FUZZ_TARGET_DESERIALIZE(blockheader_deserialize, {
     CBlockHeader bh;
     DeserializeFromFuzzingInput(buffer, bh);
 })
+FUZZ_TARGET_DESERIALIZE(compressed_headers_deserialize, {
+    CompressedHeaders compressed_headers;
+    DeserializeFromFuzzingInput(buffer, compressed_headers);
+})
 FUZZ_TARGET_DESERIALIZE(txundo_deserialize, {
     CTxUndo tu;
     DeserializeFromFuzzingInput(buffer, tu);
@@ -58,7 +58,7 @@ void initialize_process_message()
 
     static const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(
             /*chain_name=*/CBaseChainParams::REGTEST,
-            /*extra_args=*/{"-txreconciliation"});
+            /*extra_args=*/{"-txreconciliation", "-messageworkers=0"});
     g_setup = testing_setup.get();
     for (int i = 0; i < 2 * COINBASE_MATURITY; i++) {
         MineBlock(g_setup->m_node, CScript() << OP_TRUE);
@@ -133,6 +133,9 @@ FUZZ_TARGET_MSG(sendaddrv2);
 FUZZ_TARGET_MSG(sendcmpct);
 FUZZ_TARGET_MSG(sendheaders);
 FUZZ_TARGET_MSG(sendtxrcncl);
+FUZZ_TARGET_MSG(reqrecon);
+FUZZ_TARGET_MSG(sketch);
+FUZZ_TARGET_MSG(reconcildiff);
 FUZZ_TARGET_MSG(tx);
 FUZZ_TARGET_MSG(verack);
 FUZZ_TARGET_MSG(version);
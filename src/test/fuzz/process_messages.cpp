@@ -25,7 +25,7 @@ void initialize_process_messages()
 {
     static const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(
             /*chain_name=*/CBaseChainParams::REGTEST,
-            /*extra_args=*/{"-txreconciliation"});
+            /*extra_args=*/{"-txreconciliation", "-messageworkers=0"});
     g_setup = testing_setup.get();
     for (int i = 0; i < 2 * COINBASE_MATURITY; i++) {
         MineBlock(g_setup->m_node, CScript() << OP_TRUE);
@@ -78,11 +78,14 @@ const std::vector<std::string> RPC_COMMANDS_NOT_SAFE_FOR_FUZZING{
     "generatetodescriptor", // avoid prohibitively slow execution (when `nblocks` is large)
     "gettxoutproof",        // avoid prohibitively slow execution
     "importwallet", // avoid reading from disk
+    "loadtxoutset", // avoid reading from disk
     "loadwallet",   // avoid reading from disk
     "prioritisetransaction", // avoid signed integer overflow in CTxMemPool::PrioritiseTransaction(uint256 const&, long const&) (https://github.com/bitcoin/bitcoin/issues/20626)
     "savemempool",           // disabled as a precautionary measure: may take a file path argument in the future
     "setban",                // avoid DNS lookups
+    "startprofiler",         // avoid signalling the fuzzer's threads
     "stop",                  // avoid shutdown state
+    "stopprofiler",          // avoid writing to disk
 };
 
 // RPC commands which are safe for fuzzing.
@@ -90,6 +93,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "clearbanned",
     "combinepsbt",
     "combinerawtransaction",
+    "compactdb",
     "converttopsbt",
     "createmultisig",
     "createpsbt",
@@ -107,6 +111,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "generate",
     "generateblock",
     "getaddednodeinfo",
+    "getaddressoutputs",
     "getbestblockhash",
     "getblock",
     "getblockchaininfo",
@@ -116,14 +121,19 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getblockheader",
     "getblockfrompeer", // when no peers are connected, no p2p message is sent
     "getblockstats",
+    "getblockstoragechunks",
+    "getblocktimestats",
+    "getblockvalidationstats",
     "getblocktemplate",
     "getchaintips",
     "getchaintxstats",
     "getconnectioncount",
+    "getdbstats",
     "getdeploymentinfo",
     "getdescriptorinfo",
     "getdifficulty",
     "getindexinfo",
+    "getlockstats",
     "getmemoryinfo",
     "getmempoolancestors",
     "getmempooldescendants",
@@ -131,6 +141,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "gettxspendingprevout",
     "getmempoolinfo",
     "getmininginfo",
+    "getnetmsgstats",
     "getnettotals",
     "getnetworkhashps",
     "getnetworkinfo",
@@ -139,8 +150,18 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "getrawmempool",
     "getrawtransaction",
     "getrpcinfo",
+    "getschedulerinfo",
+    "getspentinfo",
+    "getstartupinfo",
+    "getstakinghistory",
+    "getstakinginfo",
+    "getstakingstats",
+    "getstoragestats",
+    "getthreadplacement",
     "gettxout",
     "gettxoutsetinfo",
+    "getvalidationcacheinfo",
+    "getvalidationqueueinfo",
     "help",
     "invalidateblock",
     "joinpsbts",
@@ -154,6 +175,7 @@ const std::vector<std::string> RPC_COMMANDS_SAFE_FOR_FUZZING{
     "scanblocks",
     "scantxoutset",
     "sendrawtransaction",
+    "setcachesizes",
     "setmocktime",
     "setnetworkactive",
     "signmessagewithprivkey",
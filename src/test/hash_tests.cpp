@@ -7,10 +7,13 @@
 #include <hash.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
+#include <util/hasher.h>
 #include <util/strencodings.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE(hash_tests)
 
 BOOST_AUTO_TEST_CASE(murmurhash3)
@@ -148,4 +151,43 @@ BOOST_AUTO_TEST_CASE(siphash)
     }
 }
 
+BOOST_AUTO_TEST_CASE(siphash_batch)
+{
+    // Batches of every length around the four hashed at once, with the rest one by one
+    FastRandomContext ctx;
+    for (size_t count = 0; count < 11; ++count) {
+        const uint64_t k1 = ctx.rand64();
+        const uint64_t k2 = ctx.rand64();
+        std::vector<uint256> vals;
+        std::vector<const uint256*> ptrs;
+        std::vector<uint32_t> extras;
+        for (size_t i = 0; i < count; ++i) {
+            vals.push_back(InsecureRand256());
+            extras.push_back(ctx.rand32());
+        }
+        for (const uint256& val : vals) ptrs.push_back(&val);
+
+        std::vector<uint64_t> out(count);
+        SipHashUint256Batch(k1, k2, ptrs, out);
+        for (size_t i = 0; i < count; ++i) {
+            BOOST_CHECK_EQUAL(out[i], SipHashUint256(k1, k2, vals[i]));
+        }
+        SipHashUint256ExtraBatch(k1, k2, ptrs, extras, out);
+        for (size_t i = 0; i < count; ++i) {
+            BOOST_CHECK_EQUAL(out[i], SipHashUint256Extra(k1, k2, vals[i], extras[i]));
+        }
+    }
+
+    const SaltedOutpointHasher hasher;
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < 9; ++i) {
+        outpoints.emplace_back(InsecureRand256(), ctx.rand32());
+    }
+    std::vector<uint64_t> out(outpoints.size());
+    hasher.HashBatch(outpoints, out);
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        BOOST_CHECK_EQUAL(out[i], hasher(outpoints[i]));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,247 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/jobs.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using node::JobInfo;
+using node::JobQueue;
+using node::JobState;
+
+namespace {
+//! Wait for a job to leave the states given, and return it
+JobInfo WaitForJob(JobQueue& queue, const std::string& id, std::initializer_list<JobState> states = {JobState::QUEUED, JobState::RUNNING})
+{
+    while (true) {
+        const auto job{queue.Get(id)};
+        BOOST_REQUIRE(job);
+        if (std::find(states.begin(), states.end(), job->state) == states.end()) return *job;
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(jobqueue_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(job_results)
+{
+    JobQueue queue;
+    queue.Start(2);
+
+    const auto done{queue.Submit("test", [] { return UniValue{42}; })};
+    BOOST_REQUIRE(done);
+    BOOST_CHECK_EQUAL(done->size(), 16U);
+    const JobInfo done_job{WaitForJob(queue, *done)};
+    BOOST_CHECK(done_job.state == JobState::DONE);
+    BOOST_CHECK_EQUAL(done_job.kind, "test");
+    BOOST_CHECK_EQUAL(done_job.result.getInt<int>(), 42);
+
+    const auto failed{queue.Submit("test", []() -> UniValue { throw std::runtime_error("no luck"); })};
+    const JobInfo failed_job{WaitForJob(queue, *failed)};
+    BOOST_CHECK(failed_job.state == JobState::FAILED);
+    BOOST_CHECK_EQUAL(failed_job.error, "no luck");
+
+    // An id is taken until its job has finished
+    std::atomic<bool> release{false};
+    BOOST_CHECK(queue.Submit("test", [&] { while (!release) std::this_thread::yield(); return UniValue{1}; }, "fixed"));
+    BOOST_CHECK(!queue.Submit("test", [] { return UniValue{2}; }, "fixed"));
+    release = true;
+    WaitForJob(queue, "fixed");
+    BOOST_CHECK(queue.Submit("test", [] { return UniValue{2}; }, "fixed"));
+    BOOST_CHECK_EQUAL(WaitForJob(queue, "fixed").result.getInt<int>(), 2);
+
+    BOOST_CHECK_EQUAL(queue.List(2).size(), 2U);
+    BOOST_CHECK_EQUAL(queue.List(2).back().id, "fixed");
+    BOOST_CHECK_EQUAL(queue.List(100).size(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(job_groups_and_cancel)
+{
+    JobQueue queue;
+    queue.Start(3);
+
+    // Jobs of a group run one at a time, in order
+    std::atomic<bool> release{false};
+    std::atomic<int> running{0};
+    std::atomic<int> most_running{0};
+    const auto grouped{[&] {
+        most_running = std::max(most_running.load(), ++running);
+        while (!release) std::this_thread::yield();
+        --running;
+        return UniValue{};
+    }};
+    const auto first{queue.Submit("test", grouped, "", "group")};
+    const auto second{queue.Submit("test", grouped, "", "group")};
+    WaitForJob(queue, *first, {JobState::QUEUED});
+    BOOST_CHECK(queue.Get(*second)->state == JobState::QUEUED);
+
+    // A queued job is cancelled at once
+    BOOST_CHECK(queue.Cancel(*second));
+    BOOST_CHECK(queue.Get(*second)->state == JobState::CANCELLED);
+    BOOST_CHECK(!queue.Cancel(*second));
+    BOOST_CHECK(!queue.Cancel("unknown"));
+
+    // A running job is asked to stop, and reports progress until it does
+    const auto cancelled{queue.Submit("test", [] {
+        int64_t done{0};
+        while (!node::JobCancelRequested()) node::SetJobProgress(++done, 0);
+        return UniValue{};
+    })};
+    while (queue.Get(*cancelled)->progress_done == 0) std::this_thread::yield();
+    BOOST_CHECK(queue.Cancel(*cancelled));
+    BOOST_CHECK(WaitForJob(queue, *cancelled).state == JobState::CANCELLED);
+
+    release = true;
+    BOOST_CHECK(WaitForJob(queue, *first).state == JobState::DONE);
+    BOOST_CHECK_EQUAL(most_running, 1);
+}
+
+BOOST_AUTO_TEST_CASE(job_priorities)
+{
+    JobQueue queue;
+    queue.Start(1);
+
+    // While the only thread is busy, jobs wait, and then start by priority
+    std::atomic<bool> release{false};
+    const auto busy{queue.Submit("test", [&] { while (!release) std::this_thread::yield(); return UniValue{}; })};
+    WaitForJob(queue, *busy, {JobState::QUEUED});
+
+    Mutex order_mutex;
+    std::vector<std::string> order;
+    const auto record{[&](const std::string& name) {
+        return [&, name] { WITH_LOCK(order_mutex, order.push_back(name)); return UniValue{}; };
+    }};
+    queue.Submit("test", record("low"), "", "", node::JobPriority::LOW);
+    queue.Submit("test", record("normal"), "", "", node::JobPriority::NORMAL);
+    const auto last{queue.Submit("test", record("high"), "", "", node::JobPriority::HIGH)};
+    queue.Submit("test", record("high2"), "", "", node::JobPriority::HIGH);
+
+    release = true;
+    WaitForJob(queue, *last);
+    while (WITH_LOCK(order_mutex, return order.size()) < 4) std::this_thread::yield();
+    LOCK(order_mutex);
+    BOOST_CHECK((order == std::vector<std::string>{"high", "high2", "normal", "low"}));
+}
+
+BOOST_AUTO_TEST_CASE(job_lanes_and_owners)
+{
+    JobQueue queue;
+    queue.Start(2);
+
+    // Large jobs leave a thread to the small ones
+    std::atomic<bool> release_large{false};
+    const auto large{[&] { while (!release_large) std::this_thread::yield(); return UniValue{}; }};
+    const auto first{queue.Submit("test", large, "", "", node::JobPriority::NORMAL, "a", /*large=*/true)};
+    WaitForJob(queue, *first, {JobState::QUEUED});
+    const auto second{queue.Submit("test", large, "", "", node::JobPriority::NORMAL, "a", /*large=*/true)};
+    const auto small{queue.Submit("test", [] { return UniValue{}; }, "", "", node::JobPriority::NORMAL, "a")};
+    BOOST_CHECK(WaitForJob(queue, *small).state == JobState::DONE);
+    BOOST_CHECK(queue.Get(*second)->state == JobState::QUEUED);
+
+    // Among jobs of one priority, the owner with fewer jobs running goes first
+    std::atomic<bool> release_other{false};
+    const auto other{queue.Submit("test", [&] { while (!release_other) std::this_thread::yield(); return UniValue{}; }, "", "", node::JobPriority::NORMAL, "x")};
+    WaitForJob(queue, *other, {JobState::QUEUED});
+    Mutex order_mutex;
+    std::vector<std::string> order;
+    const auto record{[&](const std::string& name) {
+        return [&, name] { WITH_LOCK(order_mutex, order.push_back(name)); return UniValue{}; };
+    }};
+    queue.Submit("test", record("a"), "", "", node::JobPriority::NORMAL, "a");
+    const auto last{queue.Submit("test", record("b"), "", "", node::JobPriority::NORMAL, "b")};
+    release_other = true;
+    WaitForJob(queue, *last);
+    while (WITH_LOCK(order_mutex, return order.size()) < 2) std::this_thread::yield();
+    WITH_LOCK(order_mutex, BOOST_CHECK((order == std::vector<std::string>{"b", "a"})));
+
+    release_large = true;
+    BOOST_CHECK(WaitForJob(queue, *second).state == JobState::DONE);
+}
+
+BOOST_AUTO_TEST_CASE(job_yield)
+{
+    JobQueue queue;
+    queue.Start(1);
+    BOOST_CHECK(!node::JobYield());
+
+    // A large job lets the small job waiting behind it run between its steps, on its thread
+    std::atomic<bool> go{false};
+    std::atomic<bool> yielded{false};
+    const auto large{queue.Submit("test", [&] {
+        while (!go) std::this_thread::yield();
+        yielded = node::JobYield();
+        // Nothing else waiting may run in its stead
+        return UniValue{node::JobYield()};
+    }, "", "", node::JobPriority::NORMAL, "", /*large=*/true)};
+    WaitForJob(queue, *large, {JobState::QUEUED});
+    const auto other_large{queue.Submit("test", [] { return UniValue{}; }, "", "", node::JobPriority::HIGH, "", /*large=*/true)};
+    const auto small{queue.Submit("test", [] { return UniValue{}; }, "", "", node::JobPriority::LOW)};
+    go = true;
+
+    BOOST_CHECK(WaitForJob(queue, *small).state == JobState::DONE);
+    const JobInfo large_job{WaitForJob(queue, *large)};
+    BOOST_CHECK(yielded);
+    BOOST_CHECK(!large_job.result.get_bool());
+    BOOST_CHECK(WaitForJob(queue, *other_large).state == JobState::DONE);
+}
+
+BOOST_AUTO_TEST_CASE(job_counts)
+{
+    JobQueue queue;
+    queue.Start(1);
+
+    std::atomic<bool> release{false};
+    const auto busy{queue.Submit("busy", [&] { while (!release) std::this_thread::yield(); return UniValue{}; })};
+    WaitForJob(queue, *busy, {JobState::QUEUED});
+    queue.Submit("wait", [] { return UniValue{}; });
+    const auto last{queue.Submit("wait", [] { return UniValue{}; })};
+
+    auto counts{queue.Count()};
+    BOOST_CHECK_EQUAL(counts.size(), 2U);
+    BOOST_CHECK_EQUAL(counts["busy"].running, 1U);
+    BOOST_CHECK_EQUAL(counts["busy"].queued, 0U);
+    BOOST_CHECK_EQUAL(counts["wait"].running, 0U);
+    BOOST_CHECK_EQUAL(counts["wait"].queued, 2U);
+
+    // Finished jobs are not counted
+    release = true;
+    WaitForJob(queue, *last);
+    BOOST_CHECK(queue.Count().empty());
+}
+
+BOOST_AUTO_TEST_CASE(job_expiry)
+{
+    SetMockTime(1000);
+    JobQueue queue{/*ttl=*/std::chrono::seconds{60}, /*max_jobs=*/2};
+    queue.Start(1);
+
+    const auto first{queue.Submit("test", [] { return UniValue{}; })};
+    WaitForJob(queue, *first);
+    const auto second{queue.Submit("test", [] { return UniValue{}; })};
+    WaitForJob(queue, *second);
+
+    // Past the most kept, the oldest finished job goes
+    const auto third{queue.Submit("test", [] { return UniValue{}; })};
+    WaitForJob(queue, *third);
+    BOOST_CHECK(!queue.Get(*first));
+    BOOST_CHECK(queue.Get(*second));
+
+    // Past their time to live, finished jobs go
+    SetMockTime(1000 + 60);
+    BOOST_CHECK(queue.List(10).empty());
+    BOOST_CHECK(!queue.Get(*third));
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -101,6 +101,28 @@ BOOST_FIXTURE_TEST_CASE(logging_LogPrintf_, LogSetup)
     BOOST_CHECK_EQUAL_COLLECTIONS(log_lines.begin(), log_lines.end(), expected.begin(), expected.end());
 }
 
+BOOST_FIXTURE_TEST_CASE(logging_async, LogSetup)
+{
+    LogInstance().StartAsync();
+    BOOST_CHECK(LogInstance().Enabled());
+    std::vector<std::string> expected;
+    for (int i = 0; i < 100; ++i) {
+        LogPrintf("async %d\n", i);
+        expected.push_back(strprintf("async %d", i));
+    }
+    // Those queued are written before any logged once stopped
+    LogInstance().StopAsync();
+    LogPrintf("sync\n");
+    expected.push_back("sync");
+
+    std::ifstream file{tmp_log_path};
+    std::vector<std::string> log_lines;
+    for (std::string log; std::getline(file, log);) {
+        log_lines.push_back(log);
+    }
+    BOOST_CHECK_EQUAL_COLLECTIONS(log_lines.begin(), log_lines.end(), expected.begin(), expected.end());
+}
+
 BOOST_FIXTURE_TEST_CASE(logging_LogPrintMacros, LogSetup)
 {
     LogPrintf("foo5: %s\n", "bar5");
@@ -157,6 +179,31 @@ BOOST_FIXTURE_TEST_CASE(logging_LogPrintMacros_CategoryName, LogSetup)
     BOOST_CHECK_EQUAL_COLLECTIONS(log_lines.begin(), log_lines.end(), expected.begin(), expected.end());
 }
 
+BOOST_FIXTURE_TEST_CASE(logging_LogPrintEvery, LogSetup)
+{
+    LogInstance().EnableCategory(BCLog::LogFlags::STORAGE);
+    LogInstance().DisableCategory(BCLog::LogFlags::AUTH);
+    for (int i = 0; i < 7; ++i) {
+        LogPrintEvery(BCLog::STORAGE, 3, "chunk %d\n", i);
+        LogPrintEvery(BCLog::AUTH, 3, "auth %d\n", i);
+    }
+    LogInstance().EnableCategory(BCLog::LogFlags::AUTH);
+
+    std::ifstream file{tmp_log_path};
+    std::vector<std::string> log_lines;
+    for (std::string log; std::getline(file, log);) {
+        log_lines.push_back(log);
+    }
+    std::vector<std::string> expected = {
+        "[storage] chunk 0",
+        "[storage] chunk 3",
+        "[storage] (2 similar messages suppressed)",
+        "[storage] chunk 6",
+        "[storage] (2 similar messages suppressed)",
+    };
+    BOOST_CHECK_EQUAL_COLLECTIONS(log_lines.begin(), log_lines.end(), expected.begin(), expected.end());
+}
+
 BOOST_FIXTURE_TEST_CASE(logging_SeverityLevels, LogSetup)
 {
     LogInstance().EnableCategory(BCLog::LogFlags::ALL);
@@ -579,6 +579,77 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
     // ... unless it has gone all the way to 0 (after getting past 1000/2)
 }
 
+BOOST_AUTO_TEST_CASE(MempoolStorageLimitTest)
+{
+    TestMemPoolEntryHelper entry;
+    const auto make_storage_tx = [](unsigned char n) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].scriptSig = CScript() << n;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_RETURN << std::vector<unsigned char>{0x6c, 0x79, 0x6e, 0x78, n};
+        return tx;
+    };
+    CMutableTransaction tx_payment;
+    tx_payment.vin.resize(1);
+    tx_payment.vin[0].scriptSig = CScript() << OP_1;
+    tx_payment.vout.resize(1);
+    tx_payment.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+    tx_payment.vout[0].nValue = 10 * COIN;
+    const CMutableTransaction tx_storage1{make_storage_tx(1)};
+    const CMutableTransaction tx_storage2{make_storage_tx(2)};
+    const CMutableTransaction tx_storage3{make_storage_tx(3)};
+    BOOST_CHECK(!IsStorageTx(CTransaction{tx_payment}));
+    BOOST_CHECK(IsStorageTx(CTransaction{tx_storage1}));
+
+    // Room for two of the three storage transactions
+    uint64_t storage_usage;
+    {
+        CTxMemPool pool{MemPoolOptionsForTest(m_node)};
+        LOCK2(cs_main, pool.cs);
+        pool.addUnchecked(entry.FromTx(tx_storage1));
+        storage_usage = pool.StorageUsage();
+    }
+    auto opts{MemPoolOptionsForTest(m_node)};
+    opts.max_storage_size_bytes = 2 * storage_usage;
+    CTxMemPool pool{opts};
+    LOCK2(cs_main, pool.cs);
+
+    pool.addUnchecked(entry.Fee(1000LL).FromTx(tx_payment));
+    pool.addUnchecked(entry.Fee(5000LL).FromTx(tx_storage1));
+    pool.addUnchecked(entry.Fee(10000LL).FromTx(tx_storage2));
+    BOOST_CHECK_EQUAL(pool.StorageUsage(), 2 * storage_usage);
+    pool.TrimToSize(pool.DynamicMemoryUsage()); // should do nothing
+    BOOST_CHECK_EQUAL(pool.size(), 3U);
+
+    // Storage transactions are evicted among themselves, leaving the lower-feerate payment alone
+    pool.addUnchecked(entry.Fee(20000LL).FromTx(tx_storage3));
+    pool.TrimToSize(pool.DynamicMemoryUsage());
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx_payment.GetHash())));
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx_storage1.GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx_storage2.GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx_storage3.GetHash())));
+    BOOST_CHECK_EQUAL(pool.StorageUsage(), 2 * storage_usage);
+
+    // ... bumping the storage minimum fee only
+    CFeeRate storage_fee_removed(5000, GetVirtualTransactionSize(CTransaction{tx_storage1}));
+    BOOST_CHECK_EQUAL(pool.GetStorageMinFee().GetFeePerK(), storage_fee_removed.GetFeePerK() + 1000);
+    BOOST_CHECK_EQUAL(pool.GetMinFee().GetFeePerK(), 0);
+
+    // The storage index orders storage transactions first, by descendant score
+    const auto& storage_index{pool.mapTx.get<storage_score>()};
+    std::vector<uint256> order;
+    for (const auto& it : storage_index) order.push_back(it.GetTx().GetHash());
+    BOOST_CHECK(order == std::vector<uint256>({tx_storage2.GetHash(), tx_storage3.GetHash(), tx_payment.GetHash()}));
+
+    // Lowering the limits while the pool runs trims it to them
+    pool.SetMaxSize(pool.DynamicMemoryUsage(), storage_usage);
+    BOOST_CHECK_EQUAL(pool.m_max_storage_size_bytes.load(), int64_t(storage_usage));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx_payment.GetHash())));
+    BOOST_CHECK(!pool.exists(GenTxid::Txid(tx_storage2.GetHash())));
+    BOOST_CHECK(pool.exists(GenTxid::Txid(tx_storage3.GetHash())));
+}
+
 inline CTransactionRef make_tx(std::vector<CAmount>&& output_values, std::vector<CTransactionRef>&& inputs=std::vector<CTransactionRef>(), std::vector<uint32_t>&& input_indices=std::vector<uint32_t>())
 {
     CMutableTransaction tx = CMutableTransaction();
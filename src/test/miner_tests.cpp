@@ -6,6 +6,7 @@
 #include <consensus/consensus.h>
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
+#include <node/blocktemplatecache.h>
 #include <node/miner.h>
 #include <policy/policy.h>
 #include <script/standard.h>
@@ -18,6 +19,7 @@
 #include <util/system.h>
 #include <util/time.h>
 #include <validation.h>
+#include <validationinterface.h>
 #include <versionbits.h>
 
 #include <test/util/setup_common.h>
@@ -28,6 +30,7 @@
 
 using node::BlockAssembler;
 using node::CBlockTemplate;
+using node::LinearizeClusters;
 
 namespace miner_tests {
 struct MinerTestingSetup : public TestingSetup {
@@ -655,4 +658,110 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     TestPrioritisedMining(scriptPubKey, txFirst);
 }
 
+BOOST_AUTO_TEST_CASE(LinearizeClusters_chunks)
+{
+    CTxMemPool& tx_mempool{MakeMempool()};
+    LOCK2(cs_main, tx_mempool.cs);
+    TestMemPoolEntryHelper entry;
+
+    const auto make_tx = [](const uint256& prev_hash, unsigned char n) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint{prev_hash, 0};
+        tx.vin[0].scriptSig = CScript() << n;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+        tx.vout[0].nValue = COIN;
+        return tx;
+    };
+    // A chain, as a storage upload spending its own change makes: a high fee
+    // parent, then a free transaction its child pays for
+    const CMutableTransaction tx_a{make_tx(uint256::ONE, 1)};
+    const CMutableTransaction tx_b{make_tx(tx_a.GetHash(), 2)};
+    const CMutableTransaction tx_c{make_tx(tx_b.GetHash(), 3)};
+    tx_mempool.addUnchecked(entry.Fee(20000).FromTx(tx_a));
+    tx_mempool.addUnchecked(entry.Fee(0).FromTx(tx_b));
+    tx_mempool.addUnchecked(entry.Fee(1000).FromTx(tx_c));
+    // An unrelated transaction, and an ineligible one with a child
+    const CMutableTransaction tx_d{make_tx(uint256::ONE, 4)};
+    const CMutableTransaction tx_e{make_tx(uint256::ONE, 5)};
+    const CMutableTransaction tx_f{make_tx(tx_e.GetHash(), 6)};
+    tx_mempool.addUnchecked(entry.Fee(5000).FromTx(tx_d));
+    tx_mempool.addUnchecked(entry.Fee(50000).FromTx(tx_e));
+    tx_mempool.addUnchecked(entry.Fee(50000).FromTx(tx_f));
+
+    int descendants_updated{0};
+    const auto clusters{LinearizeClusters(tx_mempool, [&](const CTxMemPoolEntry& e) {
+        return e.GetTx().GetHash() != tx_e.GetHash();
+    }, descendants_updated)};
+    BOOST_REQUIRE_EQUAL(clusters.size(), 2U);
+    const auto& chain{clusters[0].size() == 2 ? clusters[0] : clusters[1]};
+    const auto& single{clusters[0].size() == 2 ? clusters[1] : clusters[0]};
+
+    BOOST_REQUIRE_EQUAL(chain.size(), 2U);
+    BOOST_REQUIRE_EQUAL(chain[0].txs.size(), 1U);
+    BOOST_CHECK(chain[0].txs[0]->GetTx().GetHash() == tx_a.GetHash());
+    BOOST_CHECK_EQUAL(chain[0].fees, 20000);
+    BOOST_REQUIRE_EQUAL(chain[1].txs.size(), 2U);
+    BOOST_CHECK(chain[1].txs[0]->GetTx().GetHash() == tx_b.GetHash());
+    BOOST_CHECK(chain[1].txs[1]->GetTx().GetHash() == tx_c.GetHash());
+    BOOST_CHECK_EQUAL(chain[1].fees, 1000);
+    BOOST_CHECK_EQUAL(chain[1].size, chain[1].txs[0]->GetTxSize() + chain[1].txs[1]->GetTxSize());
+
+    BOOST_REQUIRE_EQUAL(single.size(), 1U);
+    BOOST_REQUIRE_EQUAL(single[0].txs.size(), 1U);
+    BOOST_CHECK(single[0].txs[0]->GetTx().GetHash() == tx_d.GetHash());
+
+    // Taking tx_a out of the ancestor state of tx_b and tx_c
+    BOOST_CHECK_EQUAL(descendants_updated, 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(block_template_cache, TestChain100Setup)
+{
+    CTxMemPool& mempool{*m_node.mempool};
+    node::BlockTemplateCache cache{m_node.chainman->ActiveChainstate(), mempool, BlockAssembler::Options{}};
+    cache.Start();
+    SyncWithValidationInterfaceQueue();
+
+    const CScript script{GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()))};
+    const CScript coinbase_script{CScript() << OP_TRUE};
+    const auto tx_hashes{[](const CBlock& block) {
+        std::vector<uint256> hashes;
+        for (size_t i = 1; i < block.vtx.size(); ++i) hashes.push_back(block.vtx[i]->GetHash());
+        return hashes;
+    }};
+
+    // Transactions entering the mempool are appended, children after their parents
+    const CAmount value{m_coinbase_txns[0]->vout[0].nValue};
+    const CTransactionRef parent{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, script, value - 10000))};
+    const CTransactionRef child{MakeTransactionRef(CreateValidMempoolTransaction(parent, 0, 101, coinbaseKey, script, value - 20000))};
+    SyncWithValidationInterfaceQueue();
+    std::unique_ptr<CBlockTemplate> block_template{cache.CreateNewBlock(coinbase_script, /*fProofOfStake=*/true)};
+    BOOST_REQUIRE(block_template);
+    BOOST_CHECK(tx_hashes(block_template->block) == std::vector<uint256>({parent->GetHash(), child->GetHash()}));
+    BOOST_CHECK_EQUAL(block_template->vTxFees[1], 10000);
+    BOOST_CHECK_EQUAL(block_template->vTxFees[2], 10000);
+
+    // Dropping a transaction drops its descendants too, even before their own removals come in
+    {
+        LOCK(mempool.cs);
+        mempool.removeRecursive(*parent, MemPoolRemovalReason::SIZELIMIT);
+    }
+    SyncWithValidationInterfaceQueue();
+    block_template = cache.CreateNewBlock(coinbase_script, /*fProofOfStake=*/true);
+    BOOST_REQUIRE(block_template);
+    BOOST_CHECK(tx_hashes(block_template->block).empty());
+
+    // A new tip selects afresh from what is in the mempool. The only mature coinbase is free to spend again
+    const CTransactionRef other{MakeTransactionRef(CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 0, coinbaseKey, script, value - 30000))};
+    CreateAndProcessBlock({}, script);
+    SyncWithValidationInterfaceQueue();
+    block_template = cache.CreateNewBlock(coinbase_script, /*fProofOfStake=*/true);
+    BOOST_REQUIRE(block_template);
+    BOOST_CHECK_EQUAL(block_template->block.hashPrevBlock, WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Tip()->GetBlockHash()));
+    BOOST_CHECK(tx_hashes(block_template->block) == std::vector<uint256>({other->GetHash()}));
+
+    cache.Stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -905,4 +905,59 @@ BOOST_AUTO_TEST_CASE(initial_advertise_from_version_message)
     TestOnlyResetTimeData();
 }
 
+BOOST_AUTO_TEST_CASE(recv_buffer_pool)
+{
+    RecvBufferPool pool{16 << 20};
+    V1TransportSerializer serializer;
+    V1TransportDeserializer deserializer{Params(), NodeId{0}, SER_NETWORK, INIT_PROTO_VERSION, &pool};
+
+    // Receive a message the way a socket hands it over, in pieces of 64 KiB
+    const auto receive = [&](const std::vector<unsigned char>& payload) {
+        CSerializedNetMsg msg{CNetMsgMaker{INIT_PROTO_VERSION}.Make(NetMsgType::BLOCK, payload)};
+        std::vector<unsigned char> wire;
+        serializer.prepareForTransport(msg, wire);
+        wire.insert(wire.end(), msg.data.begin(), msg.data.end());
+        for (size_t pos = 0; pos < wire.size(); pos += 64 * 1024) {
+            Span<const uint8_t> piece{Span{wire}.subspan(pos, std::min<size_t>(wire.size() - pos, 64 * 1024))};
+            while (!piece.empty()) {
+                BOOST_REQUIRE(deserializer.Read(piece) >= 0);
+            }
+        }
+        BOOST_REQUIRE(deserializer.Complete());
+        bool reject_message{false};
+        CNetMessage received{deserializer.GetMessage(std::chrono::microseconds{0}, reject_message)};
+        BOOST_CHECK(!reject_message);
+        return received;
+    };
+
+    const std::vector<unsigned char> large{g_insecure_rand_ctx.randbytes(3 << 20)};
+    {
+        CNetMessage received{receive(large)};
+        std::vector<unsigned char> payload;
+        received.m_recv >> payload;
+        BOOST_CHECK(payload == large);
+        // The buffers it outgrew were pooled along the way
+        BOOST_CHECK_GT(pool.PooledBytes(), 0U);
+    }
+    // Its own buffer went back once it was processed, and the next message of its size is read straight into it
+    const size_t pooled{pool.PooledBytes()};
+    BOOST_CHECK_GE(pooled, large.size());
+    {
+        CNetMessage received{receive(large)};
+        BOOST_CHECK_EQUAL(pool.PooledBytes(), pooled - received.m_recv.capacity());
+    }
+    BOOST_CHECK_EQUAL(pool.PooledBytes(), pooled);
+
+    // Small messages are not pooled
+    {
+        CNetMessage received{receive(std::vector<unsigned char>(1000))};
+    }
+    BOOST_CHECK_EQUAL(pool.PooledBytes(), pooled);
+
+    // Nor buffers past the bound of the pool
+    RecvBufferPool small_pool{RecvBufferPool::MIN_POOLED_SIZE};
+    small_pool.Return(small_pool.Take(RecvBufferPool::MIN_POOLED_SIZE * 2, RecvBufferPool::MIN_POOLED_SIZE * 2, SER_NETWORK, INIT_PROTO_VERSION));
+    BOOST_CHECK_EQUAL(small_pool.PooledBytes(), 0U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
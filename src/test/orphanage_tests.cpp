@@ -11,6 +11,7 @@
 #include <test/util/setup_common.h>
 #include <txorphanage.h>
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 
@@ -27,6 +28,14 @@ public:
         return m_orphans.size();
     }
 
+    size_t CountUnchained() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        return std::count_if(m_orphans.begin(), m_orphans.end(), [&](const auto& orphan) EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return !IsChained(*orphan.second.tx);
+        });
+    }
+
     CTransactionRef RandomOrphan() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
         LOCK(m_mutex);
@@ -137,4 +146,38 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
     BOOST_CHECK(orphanage.CountOrphans() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(orphan_chains)
+{
+    TxOrphanageTest orphanage;
+    const auto make_tx{[](const uint256& parent) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(parent, 0);
+        tx.vout.resize(1);
+        tx.vout[0].nValue = 1 * CENT;
+        return MakeTransactionRef(tx);
+    }};
+
+    // 20 orphans on their own, and a chain of 30 received out of order, last first
+    for (int i = 0; i < 20; i++) {
+        BOOST_CHECK(orphanage.AddTx(make_tx(InsecureRand256()), 0));
+    }
+    std::vector<CTransactionRef> chain{make_tx(InsecureRand256())};
+    while (chain.size() < 30) chain.push_back(make_tx(chain.back()->GetHash()));
+    for (auto it{chain.rbegin()}; it != chain.rend(); ++it) {
+        BOOST_CHECK(orphanage.AddTx(*it, 1));
+    }
+    BOOST_CHECK_EQUAL(orphanage.CountUnchained(), 21U);
+
+    // The orphans of the chain may go past the limit of the others
+    orphanage.LimitOrphans(10, 30);
+    BOOST_CHECK(orphanage.CountUnchained() <= 10);
+    BOOST_CHECK(orphanage.CountOrphans() > 20);
+    BOOST_CHECK(orphanage.CountOrphans() <= 40);
+    orphanage.LimitOrphans(10, 5);
+    BOOST_CHECK(orphanage.CountOrphans() <= 15);
+    orphanage.LimitOrphans(10);
+    BOOST_CHECK(orphanage.CountOrphans() <= 10);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,9 +4,11 @@
 
 #include <policy/fees.h>
 #include <policy/policy.h>
+#include <streams.h>
 #include <test/util/txmempool.h>
 #include <txmempool.h>
 #include <uint256.h>
+#include <util/fs.h>
 #include <util/time.h>
 
 #include <test/util/setup_common.h>
@@ -180,6 +182,27 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     for (int i = 2; i < 9; i++) { // At 9, the original estimate was already at the bottom (b/c scale = 2)
         BOOST_CHECK(feeEst.estimateFee(i).GetFeePerK() < origFeeEst[i-1] - deltaFee);
     }
+
+    // A smart fee estimate made again before the data changes is the same
+    FeeCalculation fee_calc, fee_calc_again;
+    const CFeeRate smart_fee{feeEst.estimateSmartFee(4, &fee_calc, /*conservative=*/false)};
+    BOOST_CHECK(smart_fee != CFeeRate(0));
+    BOOST_CHECK(feeEst.estimateSmartFee(4, &fee_calc_again, /*conservative=*/false) == smart_fee);
+    BOOST_CHECK_EQUAL(fee_calc_again.returnedTarget, fee_calc.returnedTarget);
+
+    // The written estimates, decayed over 665 blocks, read back the same
+    feeEst.FlushUnconfirmed();
+    const fs::path est_path{m_path_root / "fee_estimates_test.dat"};
+    {
+        AutoFile est_file{fsbridge::fopen(est_path, "wb")};
+        BOOST_REQUIRE(feeEst.Write(est_file));
+    }
+    const CBlockPolicyEstimator feeEstRead{est_path};
+    for (const auto horizon : ALL_FEE_ESTIMATE_HORIZONS) {
+        for (unsigned int i = 1; i <= feeEst.HighestTargetTracked(horizon); i++) {
+            BOOST_CHECK(feeEstRead.estimateRawFee(i, 0.85, horizon) == feeEst.estimateRawFee(i, 0.85, horizon));
+        }
+    }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
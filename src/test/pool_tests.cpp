@@ -0,0 +1,173 @@
+// Copyright (c) 2022 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <memusage.h>
+#include <support/allocators/pool.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(pool_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(basic_allocating)
+{
+    auto resource = PoolResource<8, 8>();
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+
+    // first chunk is already allocated
+    void* block = resource.Allocate(8, 8);
+    BOOST_CHECK(block != nullptr);
+
+    // a freed block is handed out again
+    resource.Deallocate(block, 8, 8);
+    void* b = resource.Allocate(8, 8);
+    BOOST_CHECK_EQUAL(b, block);
+
+    // blocks too large or too aligned for the pool do not come from the chunks
+    void* large = resource.Allocate(16, 8);
+    void* aligned = resource.Allocate(8, 16);
+    BOOST_CHECK(large != nullptr && aligned != nullptr);
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(aligned) % 16, 0U);
+    resource.Deallocate(large, 16, 8);
+    resource.Deallocate(aligned, 8, 16);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+
+    resource.Deallocate(b, 8, 8);
+}
+
+BOOST_AUTO_TEST_CASE(allocate_new_chunks)
+{
+    auto resource = PoolResource<16, 8>(16 * 4);
+    std::vector<void*> blocks;
+    for (int i = 0; i < 9; ++i) {
+        blocks.push_back(resource.Allocate(8, 8));
+    }
+    // 9 blocks of 8 bytes don't fit into 64 byte chunks
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 2U);
+    BOOST_CHECK_EQUAL(resource.ChunkSizeBytes(), 64U);
+    for (void* block : blocks) {
+        resource.Deallocate(block, 8, 8);
+    }
+
+    // Once deallocated, the blocks are reused instead of allocating another chunk
+    for (int i = 0; i < 9; ++i) {
+        blocks[i] = resource.Allocate(8, 8);
+    }
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 2U);
+    for (void* block : blocks) {
+        resource.Deallocate(block, 8, 8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(random_allocations)
+{
+    struct PtrSizeAlignment {
+        void* ptr;
+        size_t bytes;
+        size_t alignment;
+    };
+
+    // makes a bunch of random allocations and gives all of them back in random order.
+    auto resource = PoolResource<128, 8>(65536);
+    std::vector<PtrSizeAlignment> ptr_size_alignment{};
+    for (size_t i = 0; i < 1000; ++i) {
+        // make it a bit more likely to allocate than deallocate
+        if (ptr_size_alignment.empty() || 0 != InsecureRandRange(4)) {
+            // allocate a random item
+            std::size_t alignment = std::size_t{1} << InsecureRandRange(8);          // 1, 2, ..., 128
+            std::size_t size = (InsecureRandRange(200) / alignment + 1) * alignment; // multiple of alignment
+            void* ptr = resource.Allocate(size, alignment);
+            BOOST_CHECK(ptr != nullptr);
+            BOOST_CHECK_EQUAL((reinterpret_cast<uintptr_t>(ptr) & (alignment - 1)), 0);
+            ptr_size_alignment.push_back({ptr, size, alignment});
+        } else {
+            // deallocate a random item
+            auto& x = ptr_size_alignment[InsecureRandRange(ptr_size_alignment.size())];
+            resource.Deallocate(x.ptr, x.bytes, x.alignment);
+            x = ptr_size_alignment.back();
+            ptr_size_alignment.pop_back();
+        }
+    }
+
+    // deallocate all the rest
+    for (auto const& x : ptr_size_alignment) {
+        resource.Deallocate(x.ptr, x.bytes, x.alignment);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(memusage_test)
+{
+    auto std_map = std::unordered_map<int64_t, int64_t>{};
+
+    using Map = std::unordered_map<int64_t,
+                                   int64_t,
+                                   std::hash<int64_t>,
+                                   std::equal_to<int64_t>,
+                                   PoolAllocator<std::pair<const int64_t, int64_t>,
+                                                 sizeof(std::pair<const int64_t, int64_t>) + sizeof(void*) * 4>>;
+    auto resource = Map::allocator_type::ResourceType(1024);
+
+    {
+        auto resource_map = Map{0, std::hash<int64_t>{}, std::equal_to<int64_t>{}, &resource};
+
+        // can't have the same resource usage
+        BOOST_CHECK(memusage::DynamicUsage(std_map) != memusage::DynamicUsage(resource_map));
+
+        for (size_t i = 0; i < 10000; ++i) {
+            std_map[i];
+            resource_map[i];
+        }
+
+        // Eventually the resource_map should have a much lower memory usage because it has less malloc overhead
+        BOOST_TEST(memusage::DynamicUsage(resource_map) <= memusage::DynamicUsage(std_map) * 90 / 100);
+
+        // Make sure the pool is actually used by the nodes
+        auto max_nodes_per_chunk = resource.ChunkSizeBytes() / sizeof(Map::value_type);
+        auto min_num_allocated_chunks = resource_map.size() / max_nodes_per_chunk + 1;
+        BOOST_TEST(resource.NumAllocatedChunks() >= min_num_allocated_chunks);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(coins_map_memusage)
+{
+    // The coins cache accounts for the chunks of its pool rather than its nodes
+    CCoinsView base;
+    CCoinsViewCache base_cache{&base};
+    CCoinsViewCache cache{&base_cache};
+    const size_t empty_usage{cache.DynamicMemoryUsage()};
+    BOOST_CHECK(empty_usage >= memusage::MallocUsage(CCoinsMapMemoryResource{}.ChunkSizeBytes()));
+
+    auto add_coins = [&] {
+        for (uint32_t i = 0; i < 100; ++i) {
+            Coin coin;
+            coin.out.nValue = 1;
+            cache.AddCoin(COutPoint{InsecureRand256(), i}, std::move(coin), /*possible_overwrite=*/false);
+        }
+    };
+    add_coins();
+    // A hundred nodes fit into the first chunk, leaving only the buckets to grow
+    const size_t full_usage{cache.DynamicMemoryUsage()};
+    BOOST_CHECK(full_usage > empty_usage);
+    BOOST_CHECK(full_usage < 2 * empty_usage);
+
+    // Flushing hands the chunks back along with the buckets
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK_EQUAL(base_cache.GetCacheSize(), 100U);
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), empty_usage);
+    add_coins();
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), full_usage);
+
+    // Syncing keeps them, for the unspent coins stay cached
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), full_usage);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
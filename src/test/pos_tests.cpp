@@ -0,0 +1,242 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <consensus/validation.h>
+#include <hash.h>
+#include <pos/minter.h>
+#include <pos/pos.h>
+#include <primitives/transaction.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
+#include <streams.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <util/translation.h>
+#include <validation.h>
+
+#include <map>
+#include <memory>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pos_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(stake_kernel_hash)
+{
+    for (int i = 0; i < 100; ++i) {
+        const uint256 modifier{InsecureRand256()};
+        const uint32_t block_from_time{InsecureRand32()};
+        const COutPoint prevout{InsecureRand256(), InsecureRand32()};
+        const uint32_t time{InsecureRand32()};
+
+        CDataStream ss(SER_GETHASH, 0);
+        ss << modifier << block_from_time << prevout.hash << prevout.n << time;
+
+        const StakeKernel kernel(modifier, block_from_time, prevout, arith_uint256{});
+        BOOST_CHECK_EQUAL(kernel.GetHash(time), Hash(ss));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(stake_kernel_check)
+{
+    CBlockIndex prev;
+    prev.nStakeModifier = InsecureRand256();
+    const uint32_t bits{0x1e0fffff};
+    const COutPoint prevout{InsecureRand256(), 1};
+
+    arith_uint256 target;
+    BOOST_CHECK(!GetWeightedStakeTarget(0, COIN, target));
+    BOOST_REQUIRE(GetWeightedStakeTarget(bits, COIN, target));
+    BOOST_CHECK(target == arith_uint256{}.SetCompact(bits) * arith_uint256(COIN));
+
+    const StakeKernel kernel(prev.nStakeModifier, 1000, prevout, target);
+    for (uint32_t time = 1000; time < 1100; ++time) {
+        uint256 hash, hash_expected, target_expected;
+        const bool valid_expected{CheckStakeKernelHash(&prev, bits, 1000, COIN, prevout, time, hash_expected, target_expected)};
+        BOOST_CHECK_EQUAL(kernel.Check(time, hash), valid_expected);
+        BOOST_CHECK_EQUAL(hash, hash_expected);
+        BOOST_CHECK_EQUAL(target_expected, ArithToUint256(target));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(stake_seen_set)
+{
+    constexpr size_t capacity{64};
+    StakeSeenSet seen(capacity);
+
+    std::vector<std::pair<COutPoint, uint256>> kernels;
+    for (size_t i = 0; i < 4 * capacity; ++i) {
+        kernels.emplace_back(COutPoint{InsecureRand256(), InsecureRand32()}, InsecureRand256());
+    }
+
+    for (size_t i = 0; i < kernels.size(); ++i) {
+        const auto& [kernel, block_hash] = kernels[i];
+        BOOST_CHECK(!seen.Insert(kernel, block_hash));
+        // Inserting again keeps the block it was first seen in
+        BOOST_CHECK_EQUAL(*seen.Insert(kernel, InsecureRand256()), block_hash);
+        BOOST_CHECK_EQUAL(seen.Size(), std::min(i + 1, capacity));
+
+        // Only the most recent capacity kernels are held
+        for (size_t j = 0; j <= i; ++j) {
+            const std::optional<uint256> found{seen.Find(kernels[j].first)};
+            if (j + capacity > i) {
+                BOOST_CHECK(found && *found == kernels[j].second);
+            } else {
+                BOOST_CHECK(!found);
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(seen.GetEvictions(), kernels.size() - capacity);
+}
+
+BOOST_AUTO_TEST_CASE(stake_kernel_rate)
+{
+    // Mostly proof-of-stake blocks, with runs of proof of work between them,
+    // long enough for the window to fill and slide
+    std::vector<std::unique_ptr<CBlockIndex>> blocks;
+    const auto extend = [&](const CBlockIndex* prev) {
+        auto block{std::make_unique<CBlockIndex>()};
+        block->pprev = const_cast<CBlockIndex*>(prev);
+        block->nHeight = prev ? prev->nHeight + 1 : 0;
+        block->nTime = prev ? prev->nTime + 1 + InsecureRandRange(120) : 1'600'000'000;
+        block->nBits = 0x1d00ffff - InsecureRandRange(0x10000);
+        block->nNonce = InsecureRandBool() || InsecureRandBool() ? 0 : 1 + InsecureRand32() / 2;
+        blocks.push_back(std::move(block));
+        return blocks.back().get();
+    };
+
+    StakeKernelRate rate;
+    BOOST_CHECK_EQUAL(rate.KernelsPerSecond(), 0);
+    const CBlockIndex* tip{nullptr};
+    for (int i = 0; i < 4 * POS_KERNEL_PS_INTERVAL; ++i) {
+        tip = extend(tip);
+        rate.SetTip(tip);
+        BOOST_CHECK(rate.GetTip() == tip);
+        BOOST_CHECK_CLOSE(rate.KernelsPerSecond(), GetPoSKernelPS(tip), 1e-9);
+    }
+
+    // Disconnecting back past the window and connecting a fork
+    for (int i = 0; i < 2 * POS_KERNEL_PS_INTERVAL; ++i) {
+        tip = tip->pprev;
+        rate.SetTip(tip);
+        BOOST_CHECK_CLOSE(rate.KernelsPerSecond(), GetPoSKernelPS(tip), 1e-9);
+    }
+    for (int i = 0; i < POS_KERNEL_PS_INTERVAL; ++i) {
+        tip = extend(tip);
+        rate.SetTip(tip);
+        BOOST_CHECK_CLOSE(rate.KernelsPerSecond(), GetPoSKernelPS(tip), 1e-9);
+    }
+
+    // Jumping to a block elsewhere in the chain, and away from any chain
+    const CBlockIndex* jump{blocks[POS_KERNEL_PS_INTERVAL].get()};
+    rate.SetTip(jump);
+    BOOST_CHECK(rate.GetTip() == jump);
+    BOOST_CHECK_CLOSE(rate.KernelsPerSecond(), GetPoSKernelPS(jump), 1e-9);
+    rate.SetTip(nullptr);
+    BOOST_CHECK(!rate.GetTip());
+    BOOST_CHECK_EQUAL(rate.KernelsPerSecond(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(stake_scheduler)
+{
+    using namespace std::chrono_literals;
+    StakeScheduler scheduler;
+    const size_t light{scheduler.Add("light")};
+    const size_t heavy{scheduler.Add("heavy")};
+    const size_t later{scheduler.Add("later")};
+    const auto now{SteadyClock::now()};
+
+    // Of the wallets due together, the earliest added goes first until their weights are known
+    BOOST_CHECK_EQUAL(*scheduler.Next(now, 0), light);
+    BOOST_CHECK_EQUAL(*scheduler.Next(now, 1), heavy);
+    BOOST_CHECK_EQUAL(*scheduler.Next(now, 0), later);
+    BOOST_CHECK(!scheduler.Next(now, 0));
+    scheduler.Done(light, now, now + 1s, StakeSleep::NEXT_KERNEL, 1 * COIN, false);
+    scheduler.Done(heavy, now, now + 1s, StakeSleep::NEXT_KERNEL, 5 * COIN, false);
+    scheduler.Done(later, now, now + 10s, StakeSleep::DEPTH, 9 * COIN, false);
+
+    // Then the heaviest due goes first, and those not due wait
+    BOOST_CHECK(!scheduler.Next(now, 0));
+    BOOST_CHECK_EQUAL(*scheduler.Next(now + 2s, 0), heavy);
+    BOOST_CHECK_EQUAL(*scheduler.Next(now + 2s, 1), light);
+    BOOST_CHECK(!scheduler.Next(now + 2s, 2));
+    BOOST_CHECK(scheduler.NextDue()->first == now + 10s);
+    BOOST_CHECK(scheduler.NextDue()->second == StakeSleep::DEPTH);
+
+    // A wallet running when woken is due again as soon as it is done, without its weight changing
+    BOOST_CHECK(scheduler.Wake("heavy"));
+    BOOST_CHECK(!scheduler.Wake("unknown"));
+    scheduler.Done(heavy, now + 3s, now + 60s, StakeSleep::NEXT_KERNEL, std::nullopt, true);
+    scheduler.Done(light, now + 3s, now + 60s, StakeSleep::NEXT_KERNEL, std::nullopt, false);
+    BOOST_CHECK(scheduler.NextDue()->first == now + 3s);
+    BOOST_CHECK_EQUAL(*scheduler.Next(now + 3s, 2), heavy);
+
+    // A new tip makes every wallet due, once
+    BOOST_CHECK(scheduler.SetTip(uint256::ONE));
+    BOOST_CHECK(!scheduler.SetTip(uint256::ONE));
+    BOOST_CHECK_EQUAL(*scheduler.Next(SteadyClock::now(), 0), later);
+    BOOST_CHECK_EQUAL(*scheduler.Next(SteadyClock::now(), 1), light);
+
+    const std::vector<StakeTaskStats> stats{scheduler.GetStats(now + 3s)};
+    BOOST_REQUIRE_EQUAL(stats.size(), 3U);
+    BOOST_CHECK_EQUAL(stats[heavy].wallet, "heavy");
+    BOOST_CHECK_EQUAL(stats[heavy].weight, 5 * COIN);
+    BOOST_CHECK_EQUAL(stats[heavy].attempts, 2U);
+    BOOST_CHECK_EQUAL(stats[heavy].staked, 1U);
+    BOOST_CHECK_EQUAL(stats[heavy].thread, 2);
+    BOOST_CHECK(stats[heavy].running);
+    BOOST_CHECK(stats[heavy].busy_time == 1s);
+    BOOST_CHECK(stats[heavy].delay >= 1s);
+    BOOST_CHECK_EQUAL(stats[light].weight, 1 * COIN);
+}
+
+BOOST_FIXTURE_TEST_CASE(stake_signature_check_deferred, TestChain100Setup)
+{
+    // Coinstake spending the first coinbase back to its own script
+    const CTransactionRef& prev = m_coinbase_txns.at(0);
+    CMutableTransaction tx;
+    tx.vin.emplace_back(COutPoint(prev->GetHash(), 0));
+    tx.vout.emplace_back(0, CScript());
+    tx.vout.emplace_back(prev->vout[0].nValue, prev->vout[0].scriptPubKey);
+    FillableSigningProvider keystore;
+    keystore.AddKey(coinbaseKey);
+    std::map<COutPoint, Coin> coins;
+    Chainstate& chainstate = m_node.chainman->ActiveChainstate();
+    LOCK(cs_main);
+    BOOST_REQUIRE(chainstate.CoinsTip().GetCoin(tx.vin[0].prevout, coins[tx.vin[0].prevout]));
+    std::map<int, bilingual_str> input_errors;
+    BOOST_REQUIRE(SignTransaction(tx, &keystore, coins, SIGHASH_ALL, input_errors));
+    const CTransaction coinstake{tx};
+    tx.vin[0].scriptSig = CScript() << OP_0;
+    const CTransaction unsigned_coinstake{tx};
+
+    // A timestamp at which the coin stakes
+    const uint32_t bits{0x1c00ffff};
+    const CBlockIndex* tip = chainstate.m_chain.Tip();
+    int64_t time{tip->GetBlockTime()};
+    uint256 hash_proof, target_proof;
+    BlockValidationState state;
+    std::vector<CStakeSignatureCheck> checks;
+    do {
+        time += nStakeTimestampMask + 1;
+        checks.clear();
+    } while (!CheckProofOfStake(chainstate, state, tip, coinstake, time, bits, hash_proof, target_proof, &checks));
+
+    // Deferred, the signature is left to the caller, and not cached
+    BOOST_REQUIRE_EQUAL(checks.size(), 1U);
+    BOOST_CHECK(checks[0]());
+    checks.clear();
+    BOOST_CHECK(CheckProofOfStake(chainstate, state, tip, unsigned_coinstake, time, bits, hash_proof, target_proof, &checks));
+    BOOST_REQUIRE_EQUAL(checks.size(), 1U);
+    BOOST_CHECK(!checks[0]());
+    BOOST_CHECK(checks[0].GetScriptError() != SCRIPT_ERR_OK);
+
+    // Inline, a bad signature fails the stake
+    BOOST_CHECK(!CheckProofOfStake(chainstate, state, tip, unsigned_coinstake, time, bits, hash_proof, target_proof));
+    BOOST_CHECK(CheckProofOfStake(chainstate, state, tip, coinstake, time, bits, hash_proof, target_proof));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
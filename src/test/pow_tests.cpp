@@ -155,6 +155,36 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+/* The ancestry cached in the block index gives the results of walking the chain */
+BOOST_AUTO_TEST_CASE(pos_ancestry_cache)
+{
+    const auto chainParams = CreateChainParams(*m_node.args, CBaseChainParams::REGTEST);
+    const Consensus::Params& params{chainParams->GetConsensus()};
+    std::vector<CBlockIndex> blocks(params.lastPoWBlock + 200);
+    std::vector<unsigned int> uncached_bits;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        blocks[i].pprev = i ? &blocks[i - 1] : nullptr;
+        blocks[i].nHeight = i;
+        blocks[i].nTime = 1269211443 + i * params.nPosTargetSpacing + InsecureRandRange(params.nPosTargetSpacing);
+        blocks[i].nBits = 0x1e0fffff - InsecureRandRange(0x1000);
+        // Proof-of-stake blocks, with nNonce 0, after the last proof-of-work block, with some proof-of-work ones among them
+        blocks[i].nNonce = int(i) > params.lastPoWBlock && InsecureRandRange(4) ? 0 : 1;
+        blocks[i].BuildSkip();
+        uncached_bits.push_back(GetNextWorkRequiredPoS(&blocks[i], params));
+        blocks[i].pindexLastPoS = GetLastPoSBlockIndex(&blocks[i]);
+        CacheNextWorkRequiredPoS(blocks[i], params);
+    }
+
+    for (const CBlockIndex& block : blocks) {
+        BOOST_CHECK_EQUAL(block.nNextPoSBits, uncached_bits[block.nHeight]);
+        BOOST_CHECK_EQUAL(GetNextWorkRequiredPoS(&block, params), uncached_bits[block.nHeight]);
+        const CBlockIndex* last_pos{&block};
+        while (last_pos->pprev && last_pos->IsProofOfWork()) last_pos = last_pos->pprev;
+        BOOST_CHECK_EQUAL(block.pindexLastPoS, last_pos);
+        BOOST_CHECK_EQUAL(GetLastPoSBlockIndex(&block), last_pos);
+    }
+}
+
 void sanity_check_chainparams(const ArgsManager& args, std::string chainName)
 {
     const auto chainParams = CreateChainParams(args, chainName);
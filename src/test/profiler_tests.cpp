@@ -0,0 +1,105 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/profiler.h>
+#include <test/util/setup_common.h>
+#include <util/threadnames.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <future>
+#include <string>
+#include <thread>
+
+using node::Profile;
+using node::SamplingProfiler;
+using node::ThreadSubsystem;
+
+BOOST_FIXTURE_TEST_SUITE(profiler_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(thread_subsystem)
+{
+    BOOST_CHECK_EQUAL(ThreadSubsystem("b-msghand"), "msghand");
+    BOOST_CHECK_EQUAL(ThreadSubsystem("b-scriptch.12"), "scriptch");
+    BOOST_CHECK_EQUAL(ThreadSubsystem("b-stake.0"), "stake");
+    BOOST_CHECK_EQUAL(ThreadSubsystem("decode.3"), "decode");
+    BOOST_CHECK_EQUAL(ThreadSubsystem("val.storage"), "val.storage");
+    BOOST_CHECK_EQUAL(ThreadSubsystem("miner2"), "miner");
+    BOOST_CHECK_EQUAL(ThreadSubsystem("12"), "12");
+    BOOST_CHECK_EQUAL(ThreadSubsystem(""), "");
+}
+
+BOOST_AUTO_TEST_CASE(start_stop)
+{
+    SamplingProfiler profiler;
+    std::string error;
+    BOOST_CHECK(!profiler.Start(0, error));
+    BOOST_CHECK(!profiler.Stop());
+    if (!profiler.Start(200, error)) {
+        BOOST_TEST_MESSAGE("Profiler not supported: " << error);
+        return;
+    }
+    BOOST_CHECK(profiler.IsRunning());
+    BOOST_CHECK(!profiler.Start(200, error));
+    BOOST_CHECK(!profiler.SampleOnce(error));
+
+    const std::optional<Profile> profile{profiler.Stop()};
+    BOOST_REQUIRE(profile);
+    BOOST_CHECK(!profiler.IsRunning());
+    BOOST_CHECK_EQUAL(profile->frequency, 200);
+    for (const auto& sample : profile->samples) {
+        BOOST_CHECK(sample.stack.size() <= node::MAX_PROFILE_STACK_DEPTH);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sample_threads)
+{
+    // A thread named, then waiting until sampled
+    std::promise<void> named;
+    std::promise<void> stop;
+    std::thread waiting{[&] {
+        util::ThreadRename("waiting.1");
+        named.set_value();
+        stop.get_future().wait();
+    }};
+    named.get_future().wait();
+
+    SamplingProfiler profiler;
+    std::string error;
+    const std::optional<Profile> profile{profiler.SampleOnce(error)};
+    stop.set_value();
+    waiting.join();
+    if (!profile) {
+        BOOST_TEST_MESSAGE("Profiler not supported: " << error);
+        return;
+    }
+
+    // Each thread is sampled exactly once, with a stack
+    uint64_t waiting_samples{0};
+    for (const auto& sample : profile->samples) {
+        BOOST_CHECK(sample.stack.size() <= node::MAX_PROFILE_STACK_DEPTH);
+        if (sample.thread == "waiting.1") {
+            waiting_samples += sample.count;
+            BOOST_CHECK(!sample.stack.empty());
+        }
+    }
+    BOOST_CHECK_EQUAL(waiting_samples, 1U);
+    BOOST_CHECK(!profiler.IsRunning());
+}
+
+BOOST_AUTO_TEST_CASE(format_pprof)
+{
+    Profile profile;
+    profile.frequency = 100;
+    profile.duration = std::chrono::seconds{1};
+    profile.samples.push_back({"msghand", {0x1000, 0x2000}, 3});
+    profile.samples.push_back({"scriptch.2", {0x1000}, 1});
+
+    const std::string pprof{node::FormatPprof(profile)};
+    for (const char* str : {"samples", "wall", "thread", "subsystem", "msghand", "scriptch.2", "scriptch"}) {
+        BOOST_CHECK_MESSAGE(pprof.find(str) != std::string::npos, str);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
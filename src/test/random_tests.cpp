@@ -10,6 +10,8 @@
 
 #include <algorithm>
 #include <random>
+#include <set>
+#include <thread>
 
 BOOST_FIXTURE_TEST_SUITE(random_tests, BasicTestingSetup)
 
@@ -153,4 +155,28 @@ BOOST_AUTO_TEST_CASE(shuffle_stat_test)
     BOOST_CHECK_EQUAL(sum, 12000U);
 }
 
+BOOST_AUTO_TEST_CASE(thread_random_context)
+{
+    FastRandomContext* ctx{&GetThreadRandomContext()};
+    BOOST_CHECK_EQUAL(&GetThreadRandomContext(), ctx);
+
+    // Each thread has a context of its own, seeded apart from the others
+    FastRandomContext* other_ctx{nullptr};
+    uint256 other_output;
+    std::thread other{[&] {
+        other_ctx = &GetThreadRandomContext();
+        other_output = other_ctx->rand256();
+    }};
+    other.join();
+    BOOST_CHECK(other_ctx != ctx);
+    BOOST_CHECK(GetThreadRandomContext().rand256() != other_output);
+
+    // Outputs stay distinct across a reseed
+    std::set<uint64_t> outputs;
+    for (uint64_t i = 0; i < THREAD_RANDOM_RESEED_USES + 10; ++i) {
+        outputs.insert(GetThreadRandomContext().rand64());
+    }
+    BOOST_CHECK_EQUAL(outputs.size(), THREAD_RANDOM_RESEED_USES + 10);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
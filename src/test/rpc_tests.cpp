@@ -7,6 +7,7 @@
 #include <node/context.h>
 #include <rpc/blockchain.h>
 #include <rpc/client.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <test/util/setup_common.h>
@@ -144,6 +145,63 @@ BOOST_AUTO_TEST_CASE(rpc_rawparams)
     BOOST_CHECK_THROW(CallRPC(std::string("sendrawtransaction ")+rawtx+" extra"), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_method_stats)
+{
+    const auto before{GetRPCMethodStats()};
+    const auto calls_before{[&](const std::string& method) {
+        const auto it{before.find(method)};
+        return it == before.end() ? RPCMethodStats{} : it->second;
+    }};
+    BOOST_CHECK_NO_THROW(CallRPC("createrawtransaction [] {}"));
+    BOOST_CHECK_NO_THROW(CallRPC("createrawtransaction [] {}"));
+    BOOST_CHECK_THROW(CallRPC("decoderawtransaction DEADBEEF"), std::runtime_error);
+    BOOST_CHECK_THROW(CallRPC("nosuchmethod"), std::runtime_error);
+
+    auto after{GetRPCMethodStats()};
+    BOOST_CHECK_EQUAL(after["createrawtransaction"].calls, calls_before("createrawtransaction").calls + 2);
+    BOOST_CHECK_EQUAL(after["createrawtransaction"].errors, calls_before("createrawtransaction").errors);
+    BOOST_CHECK_EQUAL(after["decoderawtransaction"].calls, calls_before("decoderawtransaction").calls + 1);
+    BOOST_CHECK_EQUAL(after["decoderawtransaction"].errors, calls_before("decoderawtransaction").errors + 1);
+    // Unknown methods are not counted, so callers cannot grow the stats without bound
+    BOOST_CHECK(!after.count("nosuchmethod"));
+
+    RecordRPCBytesOut("createrawtransaction", 100);
+    BOOST_CHECK_EQUAL(GetRPCMethodStats()["createrawtransaction"].bytes_out, after["createrawtransaction"].bytes_out + 100);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_method_stats_quantiles)
+{
+    RPCMethodStats stats;
+    BOOST_CHECK_EQUAL(stats.Quantile(0.5), 0);
+
+    // 90 fast calls, 9 slower and one slowest
+    for (int i = 0; i < 90; ++i) stats.AddCall(/*duration_us=*/80, /*error=*/false);
+    for (int i = 0; i < 9; ++i) stats.AddCall(/*duration_us=*/20'000, /*error=*/false);
+    stats.AddCall(/*duration_us=*/90'000'000, /*error=*/true);
+    BOOST_CHECK_EQUAL(stats.calls, 100U);
+    BOOST_CHECK_EQUAL(stats.errors, 1U);
+    BOOST_CHECK_EQUAL(stats.buckets.front(), 90U);
+    BOOST_CHECK_EQUAL(stats.buckets.back(), 1U);
+    BOOST_CHECK_EQUAL(stats.Quantile(0.5), 100);
+    BOOST_CHECK_EQUAL(stats.Quantile(0.95), 25'000);
+    BOOST_CHECK_EQUAL(stats.Quantile(0.99), 25'000);
+    BOOST_CHECK_EQUAL(stats.Quantile(1), 90'000'000);
+    BOOST_CHECK_EQUAL(stats.max_us, 90'000'000);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_command_flags)
+{
+    BOOST_CHECK_EQUAL(CRPCCommand::CategoryFlags("hidden"), uint32_t{CRPCCommand::HIDDEN});
+    BOOST_CHECK_EQUAL(CRPCCommand::CategoryFlags("wallet"), uint32_t{CRPCCommand::WALLET});
+    BOOST_CHECK_EQUAL(CRPCCommand::CategoryFlags("storage"), uint32_t{CRPCCommand::STORAGE});
+    BOOST_CHECK_EQUAL(CRPCCommand::CategoryFlags("Storage"), uint32_t{CRPCCommand::STORAGE});
+    BOOST_CHECK_EQUAL(CRPCCommand::CategoryFlags("blockchain"), 0U);
+
+    BOOST_CHECK_EQUAL(tableRPC.flags("getblockcount"), 0U);
+    BOOST_CHECK_EQUAL(tableRPC.flags("echo"), uint32_t{CRPCCommand::HIDDEN});
+    BOOST_CHECK_EQUAL(tableRPC.flags("nosuchmethod"), 0U);
+}
+
 BOOST_AUTO_TEST_CASE(rpc_togglenetwork)
 {
     UniValue r;
@@ -315,6 +373,79 @@ BOOST_AUTO_TEST_CASE(json_parse_errors)
     BOOST_CHECK_THROW(ParseNonRFCJSONValue("3J98t1WpEZ73CNmQviecrnyiWrnqRhWNL"), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(json_writer)
+{
+    UniValue tx(UniValue::VOBJ);
+    tx.pushKV("txid", "ab\"cd");
+    tx.pushKV("vout", UniValue(UniValue::VARR));
+    UniValue head(UniValue::VOBJ);
+    head.pushKV("hash", "00ff");
+    head.pushKV("height", 7);
+
+    UniValue expected(head);
+    UniValue txs(UniValue::VARR);
+    for (int i = 0; i < 50; ++i) txs.push_back(tx);
+    expected.pushKV("tx", txs);
+    expected.pushKV("empty", UniValue(UniValue::VOBJ));
+
+    // Pieces far smaller than the document, so it is handed out in many
+    std::string out;
+    size_t pieces{0};
+    JSONWriter writer{[&](Span<const unsigned char> piece) {
+        out.append(piece.begin(), piece.end());
+        ++pieces;
+        return true;
+    }, /*piece_size=*/64};
+    writer.BeginObject();
+    writer.Members(head);
+    writer.Key("tx");
+    writer.BeginArray();
+    for (int i = 0; i < 50; ++i) writer.Value(tx);
+    writer.EndArray();
+    writer.Key("empty");
+    writer.BeginObject();
+    writer.EndObject();
+    writer.EndObject();
+    writer.Flush();
+    BOOST_CHECK_EQUAL(out, expected.write());
+    BOOST_CHECK_GT(pieces, 1U);
+
+    // A sink that takes no more stops the writer
+    JSONWriter closed{[](Span<const unsigned char>) { return false; }, /*piece_size=*/8};
+    closed.BeginArray();
+    BOOST_CHECK_THROW(closed.Value(tx), JSONWriterClosed);
+}
+
+BOOST_AUTO_TEST_CASE(block_render_cache)
+{
+    BlockRenderCache cache;
+    cache.SetMaxSize(10000);
+    const auto key = [](uint8_t n, std::optional<TxVerbosity> verbosity = std::nullopt) {
+        return BlockRenderCache::Key{uint256{n}, verbosity};
+    };
+    const auto rendering{std::make_shared<const std::string>(2000, 'a')};
+
+    // Four fit, the fifth evicts the least recently used
+    for (uint8_t n = 1; n <= 4; ++n) cache.Add(key(n), rendering);
+    BOOST_CHECK(cache.Get(key(1)));
+    cache.Add(key(5), rendering);
+    BOOST_CHECK(cache.Get(key(1)));
+    BOOST_CHECK(!cache.Get(key(2)));
+    BOOST_CHECK(cache.Get(key(5)));
+
+    // Renderings of a block are kept apart
+    BOOST_CHECK(!cache.Get(key(1, TxVerbosity::SHOW_DETAILS)));
+    cache.Add(key(1, TxVerbosity::SHOW_DETAILS), std::make_shared<const std::string>("json"));
+    BOOST_CHECK_EQUAL(*cache.Get(key(1, TxVerbosity::SHOW_DETAILS)), "json");
+    BOOST_CHECK_EQUAL(cache.Get(key(1))->size(), 2000U);
+
+    // A rendering too large for the cache is not kept, and shrinking it evicts
+    cache.Add(key(6), std::make_shared<const std::string>(6000, 'a'));
+    BOOST_CHECK(!cache.Get(key(6)));
+    cache.SetMaxSize(0);
+    BOOST_CHECK(!cache.Get(key(1)));
+}
+
 BOOST_AUTO_TEST_CASE(rpc_ban)
 {
     BOOST_CHECK_NO_THROW(CallRPC(std::string("clearbanned")));
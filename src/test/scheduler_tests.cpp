@@ -9,7 +9,10 @@
 #include <boost/test/unit_test.hpp>
 
 #include <functional>
+#include <future>
 #include <mutex>
+#include <set>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -212,4 +215,37 @@ BOOST_AUTO_TEST_CASE(mockforward)
     BOOST_CHECK(delta > 2*60 && delta < 3*60);
 }
 
+BOOST_AUTO_TEST_CASE(task_stats)
+{
+    CScheduler scheduler;
+
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    std::promise<void> short_done;
+    scheduler.scheduleFromNow([released] { released.wait(); }, std::chrono::milliseconds{0}, "long");
+    scheduler.scheduleFromNow([&short_done] { short_done.set_value(); }, std::chrono::milliseconds{1}, "short");
+    scheduler.scheduleFromNow([] {}, std::chrono::milliseconds{1});
+
+    scheduler.m_service_thread = std::thread([&] { scheduler.serviceQueue(); });
+    scheduler.m_extra_service_threads.emplace_back([&] { scheduler.serviceQueue(); });
+
+    // The short task runs on the other thread while the long one waits
+    BOOST_CHECK(short_done.get_future().wait_for(std::chrono::seconds{60}) == std::future_status::ready);
+    release.set_value();
+    scheduler.StopWhenDrained();
+    BOOST_CHECK(scheduler.m_extra_service_threads.empty());
+
+    const std::vector<SchedulerTaskStats> stats{scheduler.GetTaskStats()};
+    BOOST_REQUIRE_EQUAL(stats.size(), 3U);
+    // The long task took the most time
+    BOOST_CHECK_EQUAL(stats[0].name, "long");
+    std::set<std::string> names;
+    for (const SchedulerTaskStats& task : stats) {
+        names.insert(task.name);
+        BOOST_CHECK_EQUAL(task.runs, 1U);
+        BOOST_CHECK(task.max_time <= task.total_time);
+    }
+    BOOST_CHECK(names == (std::set<std::string>{"long", "short", "other"}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -80,6 +80,8 @@ BOOST_AUTO_TEST_CASE(getlocator_test)
         int r = InsecureRandRange(150000);
         CBlockIndex* tip = (r < 100000) ? &vBlocksMain[r] : &vBlocksSide[r - 100000];
         CBlockLocator locator = GetLocator(tip);
+        // Reading the entries in the chain from it gives the same locator
+        BOOST_CHECK(chain.GetLocator(tip).vHave == locator.vHave);
 
         // The first result must be the block itself, the last one must be genesis.
         BOOST_CHECK(locator.vHave.front() == tip->GetBlockHash());
@@ -99,6 +101,46 @@ BOOST_AUTO_TEST_CASE(getlocator_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(chain_find_test)
+{
+    // A main chain 2000 blocks long, and a branch of it from block 999, 1500 blocks long.
+    // Hashes of a height share their first bytes, so lookups compare them whole.
+    std::vector<uint256> hashes_main(2000), hashes_side(1500);
+    std::vector<CBlockIndex> blocks_main(2000), blocks_side(1500);
+    for (unsigned int i = 0; i < blocks_main.size(); i++) {
+        hashes_main[i] = ArithToUint256(i);
+        blocks_main[i].nHeight = i;
+        blocks_main[i].pprev = i ? &blocks_main[i - 1] : nullptr;
+        blocks_main[i].phashBlock = &hashes_main[i];
+        blocks_main[i].BuildSkip();
+    }
+    for (unsigned int i = 0; i < blocks_side.size(); i++) {
+        hashes_side[i] = ArithToUint256(i + 1000 + (arith_uint256(1) << 128));
+        blocks_side[i].nHeight = i + 1000;
+        blocks_side[i].pprev = i ? &blocks_side[i - 1] : &blocks_main[999];
+        blocks_side[i].phashBlock = &hashes_side[i];
+        blocks_side[i].BuildSkip();
+    }
+
+    CChain chain;
+    BOOST_CHECK(chain.Find(hashes_main[0]) == nullptr);
+    const auto check = [&](const CBlockIndex& tip) {
+        chain.SetTip(const_cast<CBlockIndex&>(tip));
+        for (const auto* blocks : {&blocks_main, &blocks_side}) {
+            for (const CBlockIndex& block : *blocks) {
+                const bool in_chain{tip.GetAncestor(block.nHeight) == &block};
+                BOOST_CHECK_EQUAL(chain.Find(block.GetBlockHash()), in_chain ? &block : nullptr);
+            }
+        }
+    };
+    check(blocks_main.back());
+    // Reorganize to the branch, then back to a block of the main chain below its tip
+    check(blocks_side.back());
+    check(blocks_main[1800]);
+    check(blocks_main[500]);
+    check(blocks_side[200]);
+}
+
 BOOST_AUTO_TEST_CASE(findearliestatleast_test)
 {
     std::vector<uint256> vHashMain(100000);
@@ -146,9 +188,12 @@ BOOST_AUTO_TEST_CASE(findearliestatleast_test)
 BOOST_AUTO_TEST_CASE(findearliestatleast_edge_test)
 {
     std::list<CBlockIndex> blocks;
+    std::list<uint256> hashes;
     for (const unsigned int timeMax : {100, 100, 100, 200, 200, 200, 300, 300, 300}) {
         CBlockIndex* prev = blocks.empty() ? nullptr : &blocks.back();
         blocks.emplace_back();
+        hashes.push_back(ArithToUint256(blocks.size()));
+        blocks.back().phashBlock = &hashes.back();
         blocks.back().nHeight = prev ? prev->nHeight + 1 : 0;
         blocks.back().pprev = prev;
         blocks.back().BuildSkip();
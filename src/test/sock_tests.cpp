@@ -10,8 +10,13 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <array>
 #include <cassert>
+#include <limits>
+#include <map>
+#include <string>
 #include <thread>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -113,6 +118,24 @@ BOOST_AUTO_TEST_CASE(send_and_receive)
     BOOST_CHECK(SocketIsClosed(s[1]));
 }
 
+BOOST_AUTO_TEST_CASE(send_many)
+{
+    int s[2];
+    CreateSocketPair(s);
+    const Sock sender(s[0]);
+    const Sock receiver(s[1]);
+
+    // The buffers arrive in order, as if sent in one piece
+    const std::vector<unsigned char> header{'h', 'd', 'r'};
+    const std::vector<unsigned char> payload{'p', 'a', 'y', 'l', 'o', 'a', 'd'};
+    const std::array<Span<const unsigned char>, 3> buffers{Span{header}, Span{payload}.subspan(3), Span<const unsigned char>{}};
+    BOOST_CHECK_EQUAL(sender.SendMany(buffers, 0), 7);
+    BOOST_CHECK_EQUAL(sender.SendMany({}, 0), 0);
+    char recv_buf[10];
+    BOOST_CHECK_EQUAL(receiver.Recv(recv_buf, sizeof(recv_buf), 0), 7);
+    BOOST_CHECK_EQUAL(std::string(recv_buf, 7), "hdrload");
+}
+
 BOOST_AUTO_TEST_CASE(wait)
 {
     int s[2];
@@ -128,6 +151,48 @@ BOOST_AUTO_TEST_CASE(wait)
     waiter.join();
 }
 
+BOOST_AUTO_TEST_CASE(sock_events)
+{
+    for (const SocketEventsMode mode : {SocketEventsMode::EPOLL, SocketEventsMode::KQUEUE}) {
+        if (!SocketEventsModeAvailable(mode)) {
+            BOOST_CHECK(!SockEvents::Make(mode));
+            continue;
+        }
+        const auto events{SockEvents::Make(mode)};
+        BOOST_REQUIRE(events);
+
+        int s[2];
+        CreateSocketPair(s);
+        const Sock edge(s[0]);
+        const Sock level(s[1]);
+        BOOST_REQUIRE(events->Add(edge, 7, /*edge_triggered=*/true));
+        BOOST_REQUIRE(events->Add(level, std::numeric_limits<uint64_t>::max(), /*edge_triggered=*/false));
+
+        // Events of the same socket may be reported apart
+        const auto wait = [&events](std::chrono::milliseconds timeout) {
+            std::vector<std::pair<uint64_t, Sock::Event>> occurred;
+            BOOST_REQUIRE(events->Wait(timeout, occurred));
+            std::map<uint64_t, Sock::Event> per_key;
+            for (const auto& [key, event] : occurred) per_key[key] |= event;
+            return per_key;
+        };
+
+        // The edge-triggered socket becomes writable once
+        BOOST_CHECK(wait(0ms) == (std::map<uint64_t, Sock::Event>{{7, Sock::SEND}}));
+        BOOST_CHECK(wait(0ms).empty());
+
+        // It becomes readable once, even if nothing is read
+        BOOST_REQUIRE_EQUAL(level.Send("a", 1, 0), 1);
+        BOOST_CHECK(wait(1min).at(7) & Sock::RECV);
+        BOOST_CHECK(wait(0ms).empty());
+
+        // The level-triggered socket is reported for as long as it is readable
+        BOOST_REQUIRE_EQUAL(edge.Send("b", 1, 0), 1);
+        BOOST_CHECK(wait(1min) == (std::map<uint64_t, Sock::Event>{{std::numeric_limits<uint64_t>::max(), Sock::RECV}}));
+        BOOST_CHECK(wait(0ms) == (std::map<uint64_t, Sock::Event>{{std::numeric_limits<uint64_t>::max(), Sock::RECV}}));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(recv_until_terminator_limit)
 {
     constexpr auto timeout = 1min; // High enough so that it is never hit.
@@ -0,0 +1,103 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/stakeindex.h>
+#include <interfaces/chain.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(stakeindex_tests)
+
+BOOST_AUTO_TEST_CASE(stakeindex_read_record)
+{
+    const CScript staker{CScript() << OP_TRUE};
+    const COutPoint kernel{uint256::ONE, 3};
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    CMutableTransaction coinstake;
+    coinstake.vin.emplace_back(kernel);
+    coinstake.vin.emplace_back(COutPoint{uint256::ONE, 4});
+    coinstake.vout.emplace_back(0, CScript());
+    coinstake.vout.emplace_back(150 * COIN, staker);
+    coinstake.vout.emplace_back(60 * COIN, staker);
+
+    CBlock block;
+    block.nNonce = 0;
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    block.vtx.push_back(MakeTransactionRef(coinstake));
+
+    CBlockUndo block_undo;
+    block_undo.vtxundo.resize(1);
+    block_undo.vtxundo[0].vprevout.emplace_back(CTxOut(100 * COIN, staker), 1, false, false);
+    block_undo.vtxundo[0].vprevout.emplace_back(CTxOut(100 * COIN, staker), 2, false, false);
+
+    StakeRecord record;
+    BOOST_REQUIRE(ReadStakeRecord(block, block_undo, record));
+    BOOST_CHECK(record.staker_script == staker);
+    BOOST_CHECK(record.kernel == kernel);
+    BOOST_CHECK_EQUAL(record.stake_amount, 100 * COIN);
+    BOOST_CHECK_EQUAL(record.reward, 10 * COIN);
+
+    // Undo data not matching the coinstake
+    block_undo.vtxundo[0].vprevout.pop_back();
+    BOOST_CHECK(!ReadStakeRecord(block, block_undo, record));
+
+    // A proof-of-work block has no stake
+    block.nNonce = 1;
+    BOOST_CHECK(!ReadStakeRecord(block, block_undo, record));
+}
+
+BOOST_FIXTURE_TEST_CASE(stakeindex_totals, TestChain100Setup)
+{
+    StakeIndex stake_index(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(stake_index.Start());
+
+    constexpr auto timeout{10s};
+    const auto time_start{SteadyClock::now()};
+    while (!stake_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout > SteadyClock::now());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+
+    // The test chain is all proof-of-work
+    const CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())};
+    StakeRangeStats stats;
+    BOOST_REQUIRE(stake_index.GetStats(0, tip->nHeight, stats));
+    BOOST_CHECK_EQUAL(stats.pos_blocks, 0U);
+    BOOST_CHECK_EQUAL(stats.reward, 0);
+    BOOST_CHECK_EQUAL(stats.kernels_per_second, 0);
+    StakeRecord stake;
+    BOOST_CHECK(!stake_index.FindStake(tip->nHeight, stake));
+    std::vector<StakeRecord> stakes;
+    BOOST_REQUIRE(stake_index.FindStakes(CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG, 0, tip->nHeight, 0, stakes));
+    BOOST_CHECK(stakes.empty());
+
+    // Not indexed yet
+    BOOST_CHECK(!stake_index.GetStats(0, tip->nHeight + 1, stats));
+
+    // Totals follow a reorg
+    {
+        BlockValidationState state;
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())));
+    }
+    SyncWithValidationInterfaceQueue();
+    CreateAndProcessBlock({}, CScript() << OP_TRUE);
+    CreateAndProcessBlock({}, CScript() << OP_TRUE);
+    BOOST_CHECK(stake_index.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK_EQUAL(stake_index.GetSummary().best_block_height, tip->nHeight + 1);
+    BOOST_REQUIRE(stake_index.GetStats(0, tip->nHeight + 1, stats));
+    BOOST_CHECK_EQUAL(stats.pos_blocks, 0U);
+
+    SyncWithValidationInterfaceQueue();
+    stake_index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,389 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <hash.h>
+#include <opfile/src/chunk.h>
+#include <opfile/src/protocol.h>
+#include <script/script.h>
+#include <storage/chunk.h>
+#include <test/util/setup_common.h>
+#include <util/strencodings.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace {
+
+//! magic, version and uuid of a chunk
+std::vector<unsigned char> ChunkPrefix(uint8_t version)
+{
+    std::vector<unsigned char> payload(std::begin(OPENCODING_MAGIC_BIN), std::end(OPENCODING_MAGIC_BIN));
+    payload.push_back(version);
+    for (int i = 0; i < OPENCODING_UUID; i++) {
+        payload.push_back(0xa0 + i);
+    }
+    return payload;
+}
+
+void AppendBE(std::vector<unsigned char>& payload, uint32_t value, int len)
+{
+    for (int i = len - 1; i >= 0; i--) {
+        payload.push_back(value >> (8 * i));
+    }
+}
+
+//! data chunk of protocol 00 or 01
+std::vector<unsigned char> DataChunk(uint8_t version, uint16_t chunklen, uint32_t chunknum, uint32_t chunktotal, const std::vector<unsigned char>& data)
+{
+    std::vector<unsigned char> payload{ChunkPrefix(version)};
+    AppendBE(payload, chunklen, OPENCODING_CHUNKLEN);
+    payload.insert(payload.end(), OPENCODING_CHECKSUM, 0x11);
+    AppendBE(payload, chunknum, OPENCODING_CHUNKNUM);
+    AppendBE(payload, chunktotal, OPENCODING_CHUNKTOTAL);
+    payload.insert(payload.end(), data.begin(), data.end());
+    return payload;
+}
+
+//! compactsize varint, as protocol 02 encodes its fields
+void AppendVarInt(std::vector<unsigned char>& payload, uint64_t value)
+{
+    if (value < 253) {
+        payload.push_back(value);
+        return;
+    }
+    const int len = value <= 0xffff ? 2 : value <= 0xffffffff ? 4 : 8;
+    payload.push_back(len == 2 ? 253 : len == 4 ? 254 : 255);
+    for (int i = 0; i < len; i++) {
+        payload.push_back(value >> (8 * i));
+    }
+}
+
+//! protocol 02 header chunk up to its signature
+std::vector<unsigned char> CompactHeader(uint64_t flags, uint64_t filelen, const std::vector<unsigned char>& ext)
+{
+    std::vector<unsigned char> payload{ChunkPrefix(OPENCODING_COMPACT)};
+    AppendVarInt(payload, 0);
+    AppendVarInt(payload, flags);
+    AppendVarInt(payload, filelen);
+    payload.insert(payload.end(), OPENCODING_MERKLEROOT, 0x33);
+    if (flags & OPENCODING_FLAG_CONTENTHASH) {
+        payload.insert(payload.end(), OPENCODING_CONTENTHASH, 0x44);
+    }
+    AppendVarInt(payload, ext.size());
+    payload.insert(payload.end(), ext.begin(), ext.end());
+    return payload;
+}
+
+//! OP_RETURN script pushing payload, with the smallest push as the wallet builds it
+CScript ChunkScript(const std::vector<unsigned char>& payload)
+{
+    return CScript() << OP_RETURN << payload;
+}
+
+bool Parse(const CScript& script, chunk_view& view, int& error_level)
+{
+    error_level = NO_ERROR;
+    return parse_chunk_from_script(script, view, error_level);
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(storage_chunk_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(parse_header_chunk)
+{
+    std::vector<unsigned char> payload{ChunkPrefix(0x00)};
+    AppendBE(payload, 0, OPENCODING_CHUNKLEN);
+    const std::vector<unsigned char> signature(65, 0x5a);
+    payload.insert(payload.end(), signature.begin(), signature.end());
+
+    // the view points into the script, which has to outlive it
+    const CScript script{ChunkScript(payload)};
+    chunk_view view;
+    int error_level;
+    BOOST_REQUIRE(Parse(script, view, error_level));
+    BOOST_CHECK_EQUAL(error_level, NO_ERROR);
+    BOOST_CHECK_EQUAL(int{view.version}, 0x00);
+    BOOST_CHECK_EQUAL(view.chunklen, 0);
+    BOOST_CHECK_EQUAL(view.payload.size(), payload.size());
+    BOOST_CHECK(std::equal(view.uuid.begin(), view.uuid.end(), payload.begin() + OPENCODING_MAGICLEN + OPENCODING_VERSIONLEN));
+    BOOST_CHECK(std::equal(view.signature.begin(), view.signature.end(), signature.begin(), signature.end()));
+    BOOST_CHECK(view.checksum.empty());
+    BOOST_CHECK(view.data.empty());
+    BOOST_CHECK_EQUAL(view.chunknum, 0U);
+    BOOST_CHECK_EQUAL(view.chunktotal, 0U);
+
+    // the header signs its prefix only, so the signature cannot sign itself
+    std::vector<unsigned char> resigned{payload};
+    resigned.back() ^= 0xff;
+    const CScript resigned_script{ChunkScript(resigned)};
+    chunk_view view2;
+    BOOST_REQUIRE(Parse(resigned_script, view2, error_level));
+    BOOST_CHECK(get_header_sighash(view) == get_header_sighash(view2));
+    std::vector<unsigned char> other_uuid{payload};
+    other_uuid[OPENCODING_MAGICLEN + OPENCODING_VERSIONLEN] ^= 0xff;
+    const CScript other_uuid_script{ChunkScript(other_uuid)};
+    BOOST_REQUIRE(Parse(other_uuid_script, view2, error_level));
+    BOOST_CHECK(get_header_sighash(view) != get_header_sighash(view2));
+}
+
+BOOST_AUTO_TEST_CASE(parse_data_chunk)
+{
+    for (const uint8_t version : {0x00, 0x01}) {
+        // short enough for a direct push, then PUSHDATA1 and PUSHDATA2
+        for (const size_t len : {10, 100, OPENCODING_CHUNKMAX}) {
+            const std::vector<unsigned char> data(len, 0x42);
+            const CScript script{ChunkScript(DataChunk(version, len, 3, 7, data))};
+
+            chunk_view view;
+            int error_level;
+            BOOST_REQUIRE(Parse(script, view, error_level));
+            BOOST_CHECK_EQUAL(int{view.version}, int{version});
+            BOOST_CHECK_EQUAL(view.chunklen, len);
+            BOOST_CHECK_EQUAL(view.checksum.size(), size_t(OPENCODING_CHECKSUM));
+            BOOST_CHECK_EQUAL(view.chunknum, 3U);
+            BOOST_CHECK_EQUAL(view.chunktotal, 7U);
+            BOOST_CHECK(std::equal(view.data.begin(), view.data.end(), data.begin(), data.end()));
+            BOOST_CHECK(view.signature.empty());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parse_truncated_chunk)
+{
+    chunk_view view;
+    int error_level;
+
+    // every prefix shorter than magic, version, uuid and chunklen
+    std::vector<unsigned char> header{ChunkPrefix(0x00)};
+    AppendBE(header, 0, OPENCODING_CHUNKLEN);
+    for (size_t len = 0; len < header.size(); len++) {
+        BOOST_CHECK(!Parse(ChunkScript({header.begin(), header.begin() + len}), view, error_level));
+        BOOST_CHECK_EQUAL(error_level, ERR_CHUNKMAGIC);
+    }
+
+    // a data chunk cut within checksum, chunknum or chunktotal
+    const std::vector<unsigned char> data(32, 0x42);
+    const std::vector<unsigned char> payload{DataChunk(0x00, data.size(), 1, 1, data)};
+    const size_t metaend = payload.size() - data.size();
+    for (size_t len = header.size(); len < metaend; len++) {
+        BOOST_CHECK(!Parse(ChunkScript({payload.begin(), payload.begin() + len}), view, error_level));
+        BOOST_CHECK_EQUAL(error_level, ERR_CHUNKLEN);
+    }
+
+    // a data chunk cut within its data keeps what is there, for the checksum to reject
+    const CScript cut_data{ChunkScript({payload.begin(), payload.end() - 5})};
+    BOOST_REQUIRE(Parse(cut_data, view, error_level));
+    BOOST_CHECK_EQUAL(view.chunklen, data.size());
+    BOOST_CHECK_EQUAL(view.data.size(), data.size() - 5);
+    const CScript no_data{ChunkScript({payload.begin(), payload.begin() + metaend})};
+    BOOST_REQUIRE(Parse(no_data, view, error_level));
+    BOOST_CHECK(view.data.empty());
+}
+
+BOOST_AUTO_TEST_CASE(parse_malformed_chunk)
+{
+    const std::vector<unsigned char> data(32, 0x42);
+    const std::vector<unsigned char> payload{DataChunk(0x00, data.size(), 1, 1, data)};
+    chunk_view view;
+    int error_level;
+
+    // scripts too short to push anything
+    BOOST_CHECK(!Parse(CScript(), view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_CHUNKMAGIC);
+    BOOST_CHECK(!Parse(CScript() << OP_RETURN, view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_CHUNKMAGIC);
+
+    // authdata magic, or any other, is not a chunk
+    std::vector<unsigned char> bad_magic{payload};
+    std::copy(std::begin(OPAUTH_MAGIC_BIN), std::end(OPAUTH_MAGIC_BIN), bad_magic.begin());
+    BOOST_CHECK(!Parse(ChunkScript(bad_magic), view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_CHUNKMAGIC);
+
+    for (const uint8_t version : {0x03, 0x10, 0xff}) {
+        std::vector<unsigned char> bad_version{payload};
+        bad_version[OPENCODING_MAGICLEN] = version;
+        BOOST_CHECK(!Parse(ChunkScript(bad_version), view, error_level));
+        BOOST_CHECK_EQUAL(error_level, ERR_CHUNKVERSION);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parse_compact_header_chunk)
+{
+    const std::vector<unsigned char> ext{'p', 'n', 'g'};
+    const std::vector<unsigned char> signature(65, 0x5a);
+    chunk_view view;
+    int error_level;
+
+    for (const uint64_t filelen : {uint64_t{1}, uint64_t(OPENCODING_COMPACT_CHUNKMAX), uint64_t(OPENCODING_COMPACT_CHUNKMAX) + 1, uint64_t{1000000}}) {
+        const std::vector<unsigned char> prefix{CompactHeader(0, filelen, ext)};
+        std::vector<unsigned char> payload{prefix};
+        payload.insert(payload.end(), signature.begin(), signature.end());
+
+        const CScript script{ChunkScript(payload)};
+        BOOST_REQUIRE(Parse(script, view, error_level));
+        BOOST_CHECK_EQUAL(int{view.version}, int{OPENCODING_COMPACT});
+        BOOST_CHECK_EQUAL(view.chunklen, 0);
+        BOOST_CHECK_EQUAL(view.chunknum, 0U);
+        BOOST_CHECK_EQUAL(view.flags, 0U);
+        BOOST_CHECK_EQUAL(view.filelen, filelen);
+        BOOST_CHECK_EQUAL(view.chunktotal, (filelen + OPENCODING_COMPACT_CHUNKMAX - 1) / OPENCODING_COMPACT_CHUNKMAX);
+        BOOST_CHECK_EQUAL(view.merkleroot.size(), size_t(OPENCODING_MERKLEROOT));
+        BOOST_CHECK(view.contenthash.empty());
+        BOOST_CHECK(std::equal(view.extension.begin(), view.extension.end(), ext.begin(), ext.end()));
+        BOOST_CHECK(std::equal(view.signature.begin(), view.signature.end(), signature.begin(), signature.end()));
+
+        // signs everything ahead of the signature
+        BOOST_CHECK(get_header_sighash(view) == Hash(prefix));
+    }
+
+    std::vector<unsigned char> payload{CompactHeader(OPENCODING_FLAG_CONTENTHASH, 100, {})};
+    payload.insert(payload.end(), signature.begin(), signature.end());
+    const CScript script{ChunkScript(payload)};
+    BOOST_REQUIRE(Parse(script, view, error_level));
+    BOOST_CHECK_EQUAL(view.flags, OPENCODING_FLAG_CONTENTHASH);
+    BOOST_CHECK_EQUAL(view.contenthash.size(), size_t(OPENCODING_CONTENTHASH));
+    BOOST_CHECK_EQUAL(int{view.contenthash[0]}, 0x44);
+    BOOST_CHECK(view.extension.empty());
+    BOOST_CHECK_EQUAL(view.signature.size(), signature.size());
+}
+
+BOOST_AUTO_TEST_CASE(parse_compact_data_chunk)
+{
+    chunk_view view;
+    int error_level;
+
+    for (const uint32_t chunknum : {uint32_t{1}, uint32_t{300}, uint32_t{70000}, std::numeric_limits<uint32_t>::max()}) {
+        for (const size_t len : {1, 100, OPENCODING_COMPACT_CHUNKMAX}) {
+            const std::vector<unsigned char> data(len, 0x42);
+            std::vector<unsigned char> payload{ChunkPrefix(OPENCODING_COMPACT)};
+            AppendVarInt(payload, chunknum);
+            payload.insert(payload.end(), data.begin(), data.end());
+
+            const CScript script{ChunkScript(payload)};
+            BOOST_REQUIRE(Parse(script, view, error_level));
+            BOOST_CHECK_EQUAL(view.chunknum, chunknum);
+            BOOST_CHECK_EQUAL(view.chunklen, len);
+            // only known from the header
+            BOOST_CHECK_EQUAL(view.chunktotal, 0U);
+            BOOST_CHECK(view.checksum.empty());
+            BOOST_CHECK(view.signature.empty());
+            BOOST_CHECK(std::equal(view.data.begin(), view.data.end(), data.begin(), data.end()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parse_compact_malformed_chunk)
+{
+    const std::vector<unsigned char> signature(65, 0x5a);
+    chunk_view view;
+    int error_level;
+
+    // a flag this version does not know
+    std::vector<unsigned char> payload{CompactHeader(OPENCODING_FLAGS_KNOWN + 1, 100, {})};
+    payload.insert(payload.end(), signature.begin(), signature.end());
+    BOOST_CHECK(!Parse(ChunkScript(payload), view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_CHUNKVERSION);
+
+    // filelen 100 in three bytes instead of one
+    payload = ChunkPrefix(OPENCODING_COMPACT);
+    AppendVarInt(payload, 0);
+    AppendVarInt(payload, 0);
+    payload.insert(payload.end(), {253, 100, 0});
+    payload.insert(payload.end(), OPENCODING_MERKLEROOT, 0x33);
+    AppendVarInt(payload, 0);
+    payload.insert(payload.end(), signature.begin(), signature.end());
+    BOOST_CHECK(!Parse(ChunkScript(payload), view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_CHUNKLEN);
+
+    // chunknum 1 in five bytes
+    payload = ChunkPrefix(OPENCODING_COMPACT);
+    payload.insert(payload.end(), {254, 1, 0, 0, 0, 0x42});
+    BOOST_CHECK(!Parse(ChunkScript(payload), view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_CHUNKNUM);
+
+    // chunknum past what a data chunk may carry
+    payload = ChunkPrefix(OPENCODING_COMPACT);
+    AppendVarInt(payload, uint64_t{std::numeric_limits<uint32_t>::max()} + 1);
+    payload.push_back(0x42);
+    BOOST_CHECK(!Parse(ChunkScript(payload), view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_CHUNKNUM);
+
+    // a data chunk with more than a chunk holds
+    payload = ChunkPrefix(OPENCODING_COMPACT);
+    AppendVarInt(payload, 1);
+    payload.insert(payload.end(), OPENCODING_COMPACT_CHUNKMAX + 1, 0x42);
+    BOOST_CHECK(!Parse(ChunkScript(payload), view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_CHUNKLEN);
+    // or without data, shorter than the prefix of every version
+    payload.resize(OPENCODING_MAGICLEN + OPENCODING_VERSIONLEN + OPENCODING_UUID + 1);
+    BOOST_CHECK(!Parse(ChunkScript(payload), view, error_level));
+
+    // a header cut within its merkle root
+    payload = ChunkPrefix(OPENCODING_COMPACT);
+    AppendVarInt(payload, 0);
+    AppendVarInt(payload, 0);
+    AppendVarInt(payload, 100);
+    payload.insert(payload.end(), OPENCODING_MERKLEROOT - 1, 0x33);
+    BOOST_CHECK(!Parse(ChunkScript(payload), view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_CHUNKLEN);
+
+    // a header with the contenthash flag and no room for it
+    payload = ChunkPrefix(OPENCODING_COMPACT);
+    AppendVarInt(payload, 0);
+    AppendVarInt(payload, OPENCODING_FLAG_CONTENTHASH);
+    AppendVarInt(payload, 100);
+    payload.insert(payload.end(), OPENCODING_MERKLEROOT + OPENCODING_CONTENTHASH - 1, 0x33);
+    BOOST_CHECK(!Parse(ChunkScript(payload), view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_CHUNKLEN);
+
+    // an extension running past the end of the chunk
+    payload = CompactHeader(0, 100, {});
+    payload.pop_back();
+    AppendVarInt(payload, 10);
+    payload.insert(payload.end(), 9, 'x');
+    BOOST_CHECK(!Parse(ChunkScript(payload), view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_EXTENSION);
+    // or without its length at all
+    payload = CompactHeader(0, 100, {});
+    payload.pop_back();
+    BOOST_CHECK(!Parse(ChunkScript(payload), view, error_level));
+    BOOST_CHECK_EQUAL(error_level, ERR_EXTENSION);
+}
+
+BOOST_AUTO_TEST_CASE(parse_auth)
+{
+    std::vector<unsigned char> payload(std::begin(OPAUTH_MAGIC_BIN), std::end(OPAUTH_MAGIC_BIN));
+    payload.push_back(OPAUTH_DELUSER_BIN);
+    AppendBE(payload, 0x64a0b1c2, OPAUTH_TIMELEN);
+    std::vector<unsigned char> hash(OPAUTH_HASHLEN);
+    for (int i = 0; i < OPAUTH_HASHLEN; i++) {
+        hash[i] = i + 1;
+    }
+    payload.insert(payload.end(), hash.begin(), hash.end());
+    payload.insert(payload.end(), 65, 0x5a);
+
+    const CScript script{ChunkScript(payload)};
+    BOOST_CHECK(is_auth_magic_in_script(script));
+    auth_view view;
+    BOOST_REQUIRE(parse_auth_from_script(script, view));
+    BOOST_CHECK_EQUAL(int{view.operation}, int{OPAUTH_DELUSER_BIN});
+    BOOST_CHECK_EQUAL(view.time, 0x64a0b1c2U);
+    BOOST_CHECK_EQUAL(view.signature.size(), 65U);
+    // most significant byte first, as the hex notation reads
+    BOOST_CHECK_EQUAL(get_hash160_from_auth(view).GetHex(), HexStr(hash));
+
+    // truncated before the end of the operand hash
+    BOOST_CHECK(!parse_auth_from_script(ChunkScript({payload.begin(), payload.begin() + OPAUTH_MAGICLEN + OPAUTH_OPERATIONLEN + OPAUTH_TIMELEN + OPAUTH_HASHLEN - 1}), view));
+
+    // chunk magic is not authdata
+    const std::vector<unsigned char> chunk{DataChunk(0x00, 32, 1, 1, std::vector<unsigned char>(32))};
+    BOOST_CHECK(!is_auth_magic_in_script(ChunkScript(chunk)));
+    BOOST_CHECK(!parse_auth_from_script(ChunkScript(chunk), view));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
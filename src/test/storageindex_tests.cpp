@@ -0,0 +1,187 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coins.h>
+#include <consensus/validation.h>
+#include <hash.h>
+#include <index/storageindex.h>
+#include <interfaces/chain.h>
+#include <opfile/src/chunk.h>
+#include <opfile/src/protocol.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
+#include <storage/chunk.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <util/strencodings.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+
+BOOST_AUTO_TEST_SUITE(storageindex_tests)
+
+struct StorageIndexSetup : public TestChain100Setup {
+    const CScript coinbase_script{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+
+    //! Spend the first coinbase to outputs, paying fee
+    CMutableTransaction CreateStorageTransaction(const std::vector<CScript>& scripts, CAmount fee);
+};
+
+CMutableTransaction StorageIndexSetup::CreateStorageTransaction(const std::vector<CScript>& scripts, CAmount fee)
+{
+    const CTransactionRef& input_tx{m_coinbase_txns[0]};
+    CMutableTransaction tx;
+    tx.vin.emplace_back(COutPoint(input_tx->GetHash(), 0));
+    for (const CScript& script : scripts) {
+        tx.vout.emplace_back(0, script);
+    }
+    tx.vout.emplace_back(input_tx->vout[0].nValue - fee, coinbase_script);
+
+    FillableSigningProvider keystore;
+    keystore.AddKey(coinbaseKey);
+    std::map<COutPoint, Coin> input_coins;
+    input_coins.emplace(tx.vin[0].prevout, Coin(input_tx->vout[0], /*nHeightIn=*/1, /*fCoinBaseIn=*/true, /*fCoinStakeIn=*/false));
+    std::map<int, bilingual_str> input_errors;
+    BOOST_REQUIRE(SignTransaction(tx, &keystore, input_coins, SIGHASH_ALL, input_errors));
+    return tx;
+}
+
+static void IndexWaitSynced(const BaseIndex& index)
+{
+    constexpr auto timeout{10s};
+    const auto time_start{SteadyClock::now()};
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout > SteadyClock::now());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+}
+
+static std::vector<unsigned char> ChunkPrefix(const uint256& uuid, uint16_t chunklen)
+{
+    std::vector<unsigned char> payload(std::begin(OPENCODING_MAGIC_BIN), std::end(OPENCODING_MAGIC_BIN));
+    payload.push_back(0x00);
+    payload.insert(payload.end(), uuid.begin(), uuid.end());
+    payload.push_back(chunklen >> 8);
+    payload.push_back(chunklen & 0xff);
+    return payload;
+}
+
+BOOST_FIXTURE_TEST_CASE(storageindex_reorg, StorageIndexSetup)
+{
+    StorageIndex storage_index(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(storage_index.Start());
+    IndexWaitSynced(storage_index);
+
+    // Header chunk signed by the coinbase key, a single data chunk, and the key added to the authlist
+    const uint256 uuid{InsecureRand256()};
+    const std::string uuid_hex{HexStr(uuid)};
+    const uint160 tenant{coinbaseKey.GetPubKey().GetID()};
+
+    std::vector<unsigned char> header{ChunkPrefix(uuid, 0)};
+    const CScript header_script{CScript() << OP_RETURN << header};
+    chunk_view view;
+    int error_level;
+    BOOST_REQUIRE(parse_chunk_from_script(header_script, view, error_level));
+    std::vector<unsigned char> signature;
+    BOOST_REQUIRE(coinbaseKey.SignCompact(get_header_sighash(view), signature));
+    header.insert(header.end(), signature.begin(), signature.end());
+
+    const std::vector<unsigned char> data(100, 0x42);
+    std::vector<unsigned char> chunk{ChunkPrefix(uuid, data.size())};
+    chunk.insert(chunk.end(), OPENCODING_CHECKSUM, 0x00);
+    chunk.insert(chunk.end(), {0, 0, 0, 1, 0, 0, 0, 1});
+    chunk.insert(chunk.end(), data.begin(), data.end());
+
+    std::vector<unsigned char> auth(std::begin(OPAUTH_MAGIC_BIN), std::end(OPAUTH_MAGIC_BIN));
+    auth.push_back(OPAUTH_ADDUSER_BIN);
+    auth.insert(auth.end(), OPAUTH_TIMELEN, 0x00);
+    // The operand hash is carried most significant byte first
+    const uint160 member{Hash160(uuid)};
+    auth.insert(auth.end(), member.begin(), member.end());
+    std::reverse(auth.end() - OPAUTH_HASHLEN, auth.end());
+
+    constexpr CAmount fee{CENT};
+    const CMutableTransaction store{CreateStorageTransaction({CScript() << OP_RETURN << header, CScript() << OP_RETURN << chunk, CScript() << OP_RETURN << auth}, fee)};
+    CreateAndProcessBlock({store}, coinbase_script);
+    const CBlockIndex* store_block{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())};
+    BOOST_CHECK(storage_index.BlockUntilSyncedToCurrentChain());
+
+    const auto check_stored{[&] {
+        StorageAssetInfo info;
+        BOOST_REQUIRE(storage_index.FindAsset(uuid_hex, info));
+        BOOST_CHECK(info.header.tenant == tenant);
+        BOOST_CHECK_EQUAL(info.header.height, store_block->nHeight);
+        BOOST_CHECK_EQUAL(info.header.vout, 0U);
+        BOOST_REQUIRE(info.length);
+        BOOST_CHECK_EQUAL(info.length->chunk_total, 1U);
+        BOOST_CHECK_EQUAL(info.GetFileLength(), int64_t(data.size()));
+
+        std::vector<StorageChunkRecord> chunks;
+        BOOST_REQUIRE(storage_index.FindChunks(uuid_hex, 1, chunks));
+        BOOST_CHECK_EQUAL(chunks[0].height, store_block->nHeight);
+        BOOST_CHECK_EQUAL(chunks[0].vout, 1U);
+        CTransactionRef tx;
+        BOOST_REQUIRE(StorageIndex::ReadTransaction(chunks[0], tx));
+        BOOST_CHECK_EQUAL(tx->GetHash(), store.GetHash());
+
+        uint32_t confirmed, total;
+        BOOST_REQUIRE(storage_index.FindConfirmations(uuid_hex, confirmed, total));
+        BOOST_CHECK_EQUAL(confirmed, 2U);
+        BOOST_CHECK_EQUAL(total, 2U);
+
+        StorageUsage usage;
+        BOOST_REQUIRE(storage_index.FindTenantUsage(tenant, usage));
+        BOOST_CHECK_EQUAL(usage.assets, 1U);
+        BOOST_CHECK_EQUAL(usage.bytes, data.size());
+        BOOST_CHECK_EQUAL(usage.fees, fee);
+
+        int height;
+        BOOST_REQUIRE(storage_index.FindAuthHeight(member, height));
+        BOOST_CHECK_EQUAL(height, store_block->nHeight);
+    }};
+    check_stored();
+
+    // A block spending the same coin elsewhere replaces the one storing the asset, which leaves nothing behind
+    {
+        BlockValidationState state;
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())));
+    }
+    SyncWithValidationInterfaceQueue();
+    CreateAndProcessBlock({CreateStorageTransaction({}, fee)}, coinbase_script);
+    BOOST_CHECK(storage_index.BlockUntilSyncedToCurrentChain());
+
+    StorageAssetInfo info;
+    BOOST_CHECK(!storage_index.FindAsset(uuid_hex, info));
+    std::vector<StorageChunkRecord> chunks;
+    BOOST_CHECK(!storage_index.FindChunks(uuid_hex, 1, chunks));
+    uint32_t confirmed, total;
+    BOOST_CHECK(!storage_index.FindConfirmations(uuid_hex, confirmed, total));
+    StorageUsage usage;
+    BOOST_CHECK(!storage_index.FindTenantUsage(tenant, usage));
+    int height;
+    BOOST_CHECK(!storage_index.FindAuthHeight(member, height));
+    StorageIndexTotals totals;
+    BOOST_REQUIRE(storage_index.GetTotals(totals));
+    BOOST_CHECK_EQUAL(totals.assets, 0U);
+    BOOST_CHECK_EQUAL(totals.chunks, 0U);
+
+    // Back to the block storing the asset, which is indexed again
+    {
+        BlockValidationState state;
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().InvalidateBlock(state, WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())));
+        WITH_LOCK(::cs_main, m_node.chainman->ActiveChainstate().ResetBlockFailureFlags(m_node.chainman->m_blockman.LookupBlockIndex(store_block->GetBlockHash())));
+        BOOST_REQUIRE(m_node.chainman->ActiveChainstate().ActivateBestChain(state));
+    }
+    BOOST_REQUIRE_EQUAL(WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip()), store_block);
+    BOOST_CHECK(storage_index.BlockUntilSyncedToCurrentChain());
+    check_stored();
+
+    SyncWithValidationInterfaceQueue();
+    storage_index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
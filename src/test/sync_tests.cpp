@@ -7,8 +7,11 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <future>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
 
 namespace {
 template <typename MutexType>
@@ -140,4 +143,46 @@ BOOST_AUTO_TEST_CASE(inconsistent_lock_order_detected)
 #endif // DEBUG_LOCKORDER
 }
 
+BOOST_AUTO_TEST_CASE(lock_profiling)
+{
+    const bool prev{g_lock_profiling.exchange(true)};
+    ResetLockSiteStats();
+
+    Mutex profiled_mutex;
+    std::promise<void> locked;
+    std::thread holder{[&] {
+        LOCK(profiled_mutex);
+        locked.set_value();
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    }};
+    locked.get_future().wait();
+    {
+        // Waits for the holder to release the mutex
+        LOCK(profiled_mutex);
+    }
+    holder.join();
+    g_lock_profiling = prev;
+
+    // The waiting site usually finds the mutex held, unless the holder was done first
+    int sites{0};
+    std::chrono::microseconds max_hold{0};
+    for (const LockSiteStats& stats : GetLockSiteStats()) {
+        if (stats.name != "profiled_mutex") continue;
+        ++sites;
+        BOOST_CHECK_EQUAL(stats.acquires, 1U);
+        if (stats.contended) {
+            BOOST_CHECK_EQUAL(stats.contended, 1U);
+            BOOST_CHECK(stats.max_wait == stats.wait);
+        } else {
+            BOOST_CHECK(stats.wait == std::chrono::microseconds{0});
+        }
+        max_hold = std::max(max_hold, stats.max_hold);
+    }
+    BOOST_CHECK_EQUAL(sites, 2);
+    BOOST_CHECK(max_hold >= std::chrono::milliseconds{20});
+
+    ResetLockSiteStats();
+    BOOST_CHECK(GetLockSiteStats().empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
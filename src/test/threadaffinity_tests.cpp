@@ -0,0 +1,110 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/util/setup_common.h>
+#include <util/threadaffinity.h>
+#include <util/threadnames.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using util::NumaNodes;
+using util::ParseCpuList;
+using util::ParseThreadAffinity;
+using util::ThreadGroup;
+using util::ThreadPlacement;
+
+BOOST_FIXTURE_TEST_SUITE(threadaffinity_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(thread_group)
+{
+    BOOST_CHECK_EQUAL(ThreadGroup("scriptch.12"), "validation");
+    BOOST_CHECK_EQUAL(ThreadGroup("loadblk"), "validation");
+    BOOST_CHECK_EQUAL(ThreadGroup("val.storage"), "validation");
+    BOOST_CHECK_EQUAL(ThreadGroup("stake.0"), "stake");
+    BOOST_CHECK_EQUAL(ThreadGroup("msghand"), "net");
+    BOOST_CHECK_EQUAL(ThreadGroup("msgwork.3"), "net");
+    BOOST_CHECK_EQUAL(ThreadGroup("net"), "net");
+    BOOST_CHECK_EQUAL(ThreadGroup("netx"), "");
+    BOOST_CHECK_EQUAL(ThreadGroup("scheduler"), "");
+    BOOST_CHECK_EQUAL(ThreadGroup(""), "");
+}
+
+BOOST_AUTO_TEST_CASE(cpu_list)
+{
+    BOOST_CHECK(ParseCpuList("0-3,8") == std::vector<int>({0, 1, 2, 3, 8}));
+    BOOST_CHECK(ParseCpuList("5,2-3,3\n") == std::vector<int>({2, 3, 5}));
+    BOOST_CHECK(ParseCpuList("7") == std::vector<int>({7}));
+    for (const char* bad : {"", "3-1", "-1", "1-", "a", "0,,1", "0-2000", "+1"}) {
+        BOOST_CHECK_MESSAGE(!ParseCpuList(bad), bad);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parse_affinity)
+{
+    const NumaNodes two_nodes{{0, {0, 1, 2, 3}}, {1, {4, 5, 6, 7}}};
+    std::vector<ThreadPlacement> placements;
+    std::string error;
+
+    BOOST_CHECK(ParseThreadAffinity({"numa"}, two_nodes, placements, error));
+    BOOST_REQUIRE_EQUAL(placements.size(), 3U);
+    BOOST_CHECK_EQUAL(placements[0].group, "validation");
+    BOOST_CHECK(placements[0].cpus == two_nodes.at(0));
+    for (size_t i = 1; i < placements.size(); ++i) {
+        BOOST_CHECK(placements[i].cpus == two_nodes.at(1));
+    }
+
+    // A later value replaces the placement of a group
+    BOOST_CHECK(ParseThreadAffinity({"numa", "net=6-7", "stake=node0,node1"}, two_nodes, placements, error));
+    BOOST_REQUIRE_EQUAL(placements.size(), 3U);
+    BOOST_CHECK(placements[1].cpus == std::vector<int>({6, 7}));
+    BOOST_CHECK(placements[2].cpus == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7}));
+
+    BOOST_CHECK(ParseThreadAffinity({"numa", "none", "validation=0"}, two_nodes, placements, error));
+    BOOST_REQUIRE_EQUAL(placements.size(), 1U);
+    BOOST_CHECK(placements[0].cpus == std::vector<int>({0}));
+
+    // One node leaves nothing to place
+    BOOST_CHECK(ParseThreadAffinity({"numa"}, {{0, {0, 1}}}, placements, error));
+    BOOST_CHECK(placements.empty());
+
+    for (const char* bad : {"fast", "wallet=0", "net", "net=", "net=node2", "net=nodex", "net=x"}) {
+        BOOST_CHECK_MESSAGE(!ParseThreadAffinity({bad}, two_nodes, placements, error), bad);
+        BOOST_CHECK(!error.empty());
+        error.clear();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(place_thread)
+{
+    // A CPU this process may run on, which a container may not give all of
+    int cpu{0};
+#ifdef __linux__
+    cpu_set_t allowed;
+    BOOST_REQUIRE_EQUAL(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+    while (!CPU_ISSET(cpu, &allowed)) ++cpu;
+#endif
+    util::SetThreadPlacements({{"stake", {cpu}}});
+    std::thread{[] { util::ThreadRename("stake.9"); }}.join();
+    std::thread{[] { util::ThreadRename("msghand"); }}.join();
+    const std::vector<util::PlacedThread> placed{util::GetPlacedThreads()};
+    util::SetThreadPlacements({});
+#ifdef __linux__
+    BOOST_REQUIRE_EQUAL(placed.size(), 1U);
+    BOOST_CHECK_EQUAL(placed[0].name, "stake.9");
+    BOOST_CHECK_EQUAL(placed[0].group, "stake");
+    BOOST_CHECK(placed[0].cpus == std::vector<int>({cpu}));
+#else
+    BOOST_CHECK(placed.empty());
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -996,4 +996,134 @@ BOOST_AUTO_TEST_CASE(test_IsStandard)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_transaction_view)
+{
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(COutPoint{InsecureRand256(), 1}, CScript() << OP_TRUE);
+    mtx.vin.emplace_back(COutPoint{InsecureRand256(), 2});
+    mtx.vin[1].scriptWitness.stack.push_back(std::vector<unsigned char>(100, 0x01));
+    mtx.vout.emplace_back(0, CScript());
+    mtx.vout.emplace_back(5 * COIN, GetScriptForDestination(WitnessV0KeyHash{}));
+    mtx.vout.emplace_back(0, CScript() << OP_RETURN << std::vector<unsigned char>(300, 0x02));
+    const CTransaction tx{mtx};
+
+    // Transactions back to back, the first with witnesses and the second without
+    CDataStream stream{SER_DISK, CLIENT_VERSION};
+    stream << tx;
+    const size_t witness_size{stream.size()};
+    CMutableTransaction mtx_coinbase;
+    mtx_coinbase.vin.emplace_back(COutPoint{});
+    mtx_coinbase.vout.emplace_back(COIN, CScript() << OP_TRUE);
+    stream << CTransaction{mtx_coinbase};
+    const std::vector<unsigned char> data{UCharCast(stream.data()), UCharCast(stream.data() + stream.size())};
+
+    Span<const unsigned char> rest{data};
+    const CTransactionView view{rest};
+    BOOST_CHECK_EQUAL(data.size() - rest.size(), witness_size);
+    BOOST_CHECK_EQUAL(view.InputCount(), tx.vin.size());
+    BOOST_CHECK_EQUAL(view.OutputCount(), tx.vout.size());
+    BOOST_CHECK(!view.IsCoinBase());
+    BOOST_CHECK(view.IsCoinStake());
+    size_t n{0};
+    for (const CTxOutView& out : view.Outputs()) {
+        BOOST_CHECK_EQUAL(out.nValue, tx.vout[n].nValue);
+        BOOST_CHECK(std::equal(out.scriptPubKey.begin(), out.scriptPubKey.end(), tx.vout[n].scriptPubKey.begin(), tx.vout[n].scriptPubKey.end()));
+        BOOST_CHECK_EQUAL(out.IsOpReturn(), tx.vout[n].scriptPubKey.IsOpReturn());
+        ++n;
+    }
+    BOOST_CHECK_EQUAL(n, tx.vout.size());
+
+    const CTransactionView view_coinbase{rest};
+    BOOST_CHECK(rest.empty());
+    BOOST_CHECK(view_coinbase.IsCoinBase());
+    BOOST_CHECK(!view_coinbase.IsCoinStake());
+
+    // Malformed as for deserializing
+    Span<const unsigned char> truncated{Span{data}.first(witness_size - 1)};
+    BOOST_CHECK_THROW(CTransactionView{truncated}, std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_CASE(test_transaction_serialization_cache)
+{
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(COutPoint{InsecureRand256(), 0});
+    for (int i = 0; i < 32; ++i) {
+        mtx.vout.emplace_back(0, CScript() << OP_RETURN << std::vector<unsigned char>(300, i));
+    }
+    for (const bool witness : {false, true}) {
+        if (witness) mtx.vin[0].scriptWitness.stack.push_back(std::vector<unsigned char>(72, 0x01));
+        const CTransaction tx{mtx};
+        // Large enough for its serialization to be kept
+        BOOST_CHECK(tx.SerializationCacheUsage() >= MIN_CACHED_TX_SERIALIZED_SIZE);
+        BOOST_CHECK_EQUAL(tx.GetHash(), mtx.GetHash());
+        BOOST_CHECK_EQUAL(tx.HasWitness(), witness);
+        BOOST_CHECK_EQUAL(tx.GetWitnessHash() == tx.GetHash(), !witness);
+        for (const int version : {PROTOCOL_VERSION, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS}) {
+            CDataStream kept{SER_NETWORK, version};
+            kept << tx;
+            CDataStream fresh{SER_NETWORK, version};
+            fresh << mtx;
+            BOOST_CHECK(kept.str() == fresh.str());
+            BOOST_CHECK_EQUAL(GetSerializeSize(tx, version), fresh.size());
+        }
+        BOOST_CHECK_EQUAL(tx.GetTotalSize(), GetSerializeSize(mtx, PROTOCOL_VERSION));
+        BOOST_CHECK_EQUAL(tx.GetWitnessHash(), SerializeHash(mtx, SER_GETHASH, 0));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_transaction_scripts_in_place)
+{
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(COutPoint{InsecureRand256(), 0}, CScript() << std::vector<unsigned char>(72, 0x02));
+    for (int i = 0; i < 32; ++i) {
+        mtx.vout.emplace_back(i, CScript() << OP_RETURN << std::vector<unsigned char>(300, i));
+    }
+    mtx.vout.emplace_back(1, CScript() << OP_TRUE);
+    const auto check_in_place{[&](const CTransaction& tx, bool in_place) {
+        BOOST_CHECK_EQUAL(tx.GetHash(), mtx.GetHash());
+        BOOST_CHECK_EQUAL(tx.GetWitnessHash(), SerializeHash(mtx, SER_GETHASH, 0));
+        BOOST_CHECK(tx.vout == mtx.vout);
+        // Scripts too long to be stored in place refer to the kept serialization rather than to copies
+        for (const CTxOut& out : tx.vout) {
+            BOOST_CHECK_EQUAL(out.scriptPubKey.allocated_memory() == 0, in_place || out.scriptPubKey.size() <= 28);
+        }
+        BOOST_CHECK_EQUAL(tx.vin[0].scriptSig.allocated_memory() == 0, in_place);
+    }};
+    for (const bool witness : {false, true}) {
+        if (witness) mtx.vin[0].scriptWitness.stack.push_back(std::vector<unsigned char>(72, 0x01));
+
+        // Read out of streams in memory, past whatever follows
+        CDataStream stream{SER_NETWORK, PROTOCOL_VERSION};
+        stream << mtx << mtx << uint8_t{0x42};
+        const CTransaction read_stream{deserialize, stream};
+        check_in_place(read_stream, true);
+        const std::vector<unsigned char> bytes{UCharCast(stream.data()), UCharCast(stream.data() + stream.size())};
+        SpanReader reader{SER_NETWORK, PROTOCOL_VERSION, bytes};
+        const CTransaction read_span{deserialize, reader};
+        check_in_place(read_span, true);
+        BOOST_CHECK_EQUAL(reader.size(), 1U);
+        stream.ignore(stream.size() - 1);
+        BOOST_CHECK_EQUAL(ser_readdata8(stream), 0x42);
+
+        // Copied from a mutable transaction, only the outputs refer to the serialization
+        const CTransaction copied{mtx};
+        BOOST_CHECK(copied.vout == mtx.vout);
+        for (const CTxOut& out : copied.vout) BOOST_CHECK_EQUAL(out.scriptPubKey.allocated_memory(), 0U);
+
+        // Copies own their scripts, and changing them leaves the transaction as it is
+        CMutableTransaction changed{read_stream};
+        changed.vout[0].scriptPubKey << OP_TRUE;
+        changed.vout[1].scriptPubKey.clear();
+        BOOST_CHECK(changed.vout[0].scriptPubKey.allocated_memory() > 0);
+        check_in_place(read_stream, true);
+
+        // Without witnesses allowed, transactions are read script by script
+        if (!witness) {
+            CDataStream no_witness{SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS};
+            no_witness << mtx;
+            check_in_place(CTransaction{deserialize, no_witness}, false);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
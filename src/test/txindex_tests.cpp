@@ -3,8 +3,13 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <dbwrapper.h>
+#include <index/coinstatsindex.h>
+#include <index/disktxpos.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
+#include <kernel/coinstats.h>
+#include <node/blockstorage.h>
 #include <script/standard.h>
 #include <test/util/setup_common.h>
 #include <util/time.h>
@@ -81,4 +86,75 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
     txindex.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(txindex_shared_initial_sync, TestChain100Setup)
+{
+    // Indexes sharing the blocks of their initial sync, further apart than IndexSyncBlocks::WINDOW
+    const auto sync_blocks{std::make_shared<IndexSyncBlocks>()};
+    TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20, true);
+    CoinStatsIndex coin_stats_index(interfaces::MakeChain(m_node), 1 << 20, true);
+    txindex.SetSyncBlocks(sync_blocks);
+    coin_stats_index.SetSyncBlocks(sync_blocks);
+    BOOST_REQUIRE(txindex.Start());
+    BOOST_REQUIRE(coin_stats_index.Start());
+
+    constexpr auto timeout{10s};
+    const auto time_start{SteadyClock::now()};
+    while (!txindex.BlockUntilSyncedToCurrentChain() || !coin_stats_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout > SteadyClock::now());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    for (const auto& txn : m_coinbase_txns) {
+        BOOST_CHECK(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+    const CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain().Tip())};
+    BOOST_CHECK(coin_stats_index.LookUpStats(*tip));
+
+    SyncWithValidationInterfaceQueue();
+    txindex.Stop();
+    coin_stats_index.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(txindex_migrate_legacy_entries, TestChain100Setup)
+{
+    // Write entries keyed by the full txid, as the index did before its compact format,
+    // and one more under a txid that starts like that of the first coinbase, at the position of the second
+    uint256 colliding;
+    {
+        CDBWrapper db{DBParams{.path = gArgs.GetDataDirNet() / "indexes" / "txindex", .cache_bytes = 1 << 20}};
+        CDBBatch batch{db};
+        std::vector<CDiskTxPos> positions;
+        for (int height = 1; height <= 2; ++height) {
+            const CBlockIndex* pindex{WITH_LOCK(::cs_main, return m_node.chainman->ActiveChain()[height])};
+            CBlock block;
+            BOOST_REQUIRE(node::ReadBlockFromDisk(block, pindex, Params().GetConsensus()));
+            positions.emplace_back(WITH_LOCK(::cs_main, return pindex->GetBlockPos()), GetSizeOfCompactSize(block.vtx.size()));
+            batch.Write(std::make_pair(uint8_t{'t'}, block.vtx[0]->GetHash()), positions.back());
+        }
+        colliding = m_coinbase_txns[0]->GetHash();
+        *(colliding.end() - 1) ^= 1;
+        batch.Write(std::make_pair(uint8_t{'t'}, colliding), positions[1]);
+        BOOST_REQUIRE(db.WriteBatch(batch));
+    }
+
+    TxIndex txindex(interfaces::MakeChain(m_node), 1 << 20);
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    auto check_lookups = [&] {
+        for (size_t i = 0; i < 2; ++i) {
+            BOOST_CHECK(txindex.FindTx(m_coinbase_txns[i]->GetHash(), block_hash, tx_disk));
+            BOOST_CHECK_EQUAL(tx_disk->GetHash(), m_coinbase_txns[i]->GetHash());
+        }
+        BOOST_CHECK(!txindex.FindTx(colliding, block_hash, tx_disk));
+    };
+
+    BOOST_CHECK(txindex.HasLegacyEntries());
+    check_lookups();
+    BOOST_CHECK(txindex.MigrateLegacyEntries());
+    BOOST_CHECK(!txindex.HasLegacyEntries());
+    check_lookups();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
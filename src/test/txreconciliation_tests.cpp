@@ -4,10 +4,13 @@
 
 #include <node/txreconciliation.h>
 
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+
 BOOST_FIXTURE_TEST_SUITE(txreconciliation_tests, BasicTestingSetup)
 
 BOOST_AUTO_TEST_CASE(RegisterPeerTest)
@@ -81,4 +84,92 @@ BOOST_AUTO_TEST_CASE(IsPeerRegisteredTest)
     BOOST_CHECK(!tracker.IsPeerRegistered(peer_id0));
 }
 
+BOOST_AUTO_TEST_CASE(ReconciliationRoundTest)
+{
+    // The first node initiates reconciliations over its outbound connection to the second
+    TxReconciliationTracker initiator(TXRECONCILIATION_VERSION);
+    TxReconciliationTracker responder(TXRECONCILIATION_VERSION);
+    const NodeId to_responder{0}, to_initiator{1};
+    const uint64_t initiator_salt{initiator.PreRegisterPeer(to_responder)};
+    const uint64_t responder_salt{responder.PreRegisterPeer(to_initiator)};
+    BOOST_REQUIRE_EQUAL(initiator.RegisterPeer(to_responder, /*is_peer_inbound=*/false, 1, responder_salt), ReconciliationRegisterResult::SUCCESS);
+    BOOST_REQUIRE_EQUAL(responder.RegisterPeer(to_initiator, /*is_peer_inbound=*/true, 1, initiator_salt), ReconciliationRegisterResult::SUCCESS);
+
+    // Transactions are flooded to unregistered peers and a share of those we initiate with
+    int fanout{0};
+    for (int i = 0; i < 1000; ++i) {
+        const uint256 wtxid{InsecureRand256()};
+        BOOST_CHECK(initiator.ShouldFanoutTo(/*peer_id=*/2, wtxid));
+        BOOST_CHECK(!responder.ShouldFanoutTo(to_initiator, wtxid));
+        fanout += initiator.ShouldFanoutTo(to_responder, wtxid);
+    }
+    BOOST_CHECK(fanout > 1000 / int{RECON_FANOUT_RATIO} / 2 && fanout < 1000 / int{RECON_FANOUT_RATIO} * 2);
+    BOOST_CHECK(!initiator.AddToSet(/*peer_id=*/2, InsecureRand256()));
+
+    // Both sets share most transactions, each having a few the other lacks
+    std::vector<uint256> initiator_only, responder_only;
+    for (int i = 0; i < 100; ++i) {
+        const uint256 wtxid{InsecureRand256()};
+        BOOST_CHECK(initiator.AddToSet(to_responder, wtxid));
+        BOOST_CHECK(responder.AddToSet(to_initiator, wtxid));
+    }
+    for (int i = 0; i < 5; ++i) {
+        initiator_only.push_back(InsecureRand256());
+        BOOST_CHECK(initiator.AddToSet(to_responder, initiator_only.back()));
+    }
+    for (int i = 0; i < 3; ++i) {
+        responder_only.push_back(InsecureRand256());
+        BOOST_CHECK(responder.AddToSet(to_initiator, responder_only.back()));
+    }
+
+    // Each keeps to its role
+    BOOST_CHECK(!responder.RespondToReconciliationRequest(to_initiator));
+    BOOST_CHECK(!initiator.HandleReconciliationRequest(to_responder, 0, 0));
+    BOOST_CHECK(!responder.InitiateReconciliationRequest(to_initiator, 1000s));
+
+    const std::chrono::microseconds now{1000s};
+    const auto request{initiator.InitiateReconciliationRequest(to_responder, now)};
+    BOOST_REQUIRE(request);
+    BOOST_CHECK_EQUAL(request->first, 105);
+    BOOST_CHECK(!initiator.InitiateReconciliationRequest(to_responder, now + RECON_REQUEST_INTERVAL));
+
+    BOOST_REQUIRE(responder.HandleReconciliationRequest(to_initiator, request->first, request->second));
+    BOOST_CHECK(!responder.HandleReconciliationRequest(to_initiator, request->first, request->second));
+    const auto skdata{responder.RespondToReconciliationRequest(to_initiator)};
+    BOOST_REQUIRE(skdata && !skdata->empty());
+    // Transactions added meanwhile are left to the next round
+    const uint256 later{InsecureRand256()};
+    BOOST_CHECK(responder.AddToSet(to_initiator, later));
+
+    std::vector<uint32_t> txs_to_request;
+    std::vector<uint256> initiator_announces, responder_announces;
+    BOOST_CHECK(initiator.HandleSketch(to_responder, *skdata, txs_to_request, initiator_announces) == std::optional<bool>{true});
+    BOOST_CHECK_EQUAL(txs_to_request.size(), responder_only.size());
+    std::sort(initiator_announces.begin(), initiator_announces.end());
+    std::sort(initiator_only.begin(), initiator_only.end());
+    BOOST_CHECK(initiator_announces == initiator_only);
+
+    BOOST_CHECK(responder.HandleReconciliationDifference(to_initiator, /*recon_succeeded=*/true, txs_to_request, responder_announces));
+    std::sort(responder_announces.begin(), responder_announces.end());
+    std::sort(responder_only.begin(), responder_only.end());
+    BOOST_CHECK(responder_announces == responder_only);
+    BOOST_CHECK(!responder.HandleReconciliationDifference(to_initiator, true, txs_to_request, responder_announces));
+    BOOST_CHECK(!initiator.HandleSketch(to_responder, *skdata, txs_to_request, initiator_announces));
+
+    // An empty sketch fails the round, and both announce their whole sets
+    const uint256 initiator_later{InsecureRand256()};
+    BOOST_CHECK(initiator.AddToSet(to_responder, initiator_later));
+    const auto next_request{initiator.InitiateReconciliationRequest(to_responder, now + RECON_REQUEST_INTERVAL)};
+    BOOST_REQUIRE(next_request);
+    BOOST_CHECK_EQUAL(next_request->first, 1);
+    BOOST_REQUIRE(responder.HandleReconciliationRequest(to_initiator, next_request->first, next_request->second));
+    BOOST_REQUIRE(responder.RespondToReconciliationRequest(to_initiator));
+    BOOST_CHECK(!initiator.HandleSketch(to_responder, std::vector<uint8_t>(3), txs_to_request, initiator_announces));
+    BOOST_CHECK(initiator.HandleSketch(to_responder, std::vector<uint8_t>{}, txs_to_request, initiator_announces) == std::optional<bool>{false});
+    BOOST_CHECK(txs_to_request.empty());
+    BOOST_CHECK(initiator_announces == std::vector<uint256>{initiator_later});
+    BOOST_CHECK(responder.HandleReconciliationDifference(to_initiator, /*recon_succeeded=*/false, {}, responder_announces));
+    BOOST_CHECK(responder_announces == std::vector<uint256>{later});
+}
+
 BOOST_AUTO_TEST_SUITE_END()
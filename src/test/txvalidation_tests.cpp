@@ -8,6 +8,8 @@
 #include <policy/policy.h>
 #include <primitives/transaction.h>
 #include <script/script.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
 #include <script/standard.h>
 #include <test/util/setup_common.h>
 #include <validation.h>
@@ -49,4 +51,49 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_reject_coinbase, TestChain100Setup)
     BOOST_CHECK_EQUAL(result.m_state.GetRejectReason(), "coinbase");
     BOOST_CHECK(result.m_state.GetResult() == TxValidationResult::TX_CONSENSUS);
 }
+
+/**
+ * Ensure that storage transactions, which a large upload chains off each
+ * other's change, are held to the storage chain limits instead.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_storage_chain_limits, TestChain100Setup)
+{
+    const CScript script{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+    FillableSigningProvider keystore;
+    keystore.AddKey(coinbaseKey);
+
+    // Spend the first output of prev, paying 10000 back to script, optionally with a chunk payload
+    const auto spend = [&](const CTransactionRef& prev, bool storage) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(COutPoint{prev->GetHash(), 0});
+        tx.vout.emplace_back(prev->vout[0].nValue - 10000, script);
+        if (storage) {
+            tx.vout.emplace_back(0, CScript() << OP_RETURN << std::vector<unsigned char>{0x6c, 0x79, 0x6e, 0x78, 0x00});
+        }
+        const std::map<COutPoint, Coin> coins{{tx.vin[0].prevout, Coin{prev->vout[0], 0, prev->IsCoinBase(), false}}};
+        std::map<int, bilingual_str> input_errors;
+        BOOST_REQUIRE(SignTransaction(tx, &keystore, coins, SIGHASH_ALL, input_errors));
+        return MakeTransactionRef(tx);
+    };
+    const auto chain = [&](const CTransactionRef& coinbase, bool storage) {
+        LOCK(cs_main);
+        CTransactionRef prev{coinbase};
+        for (unsigned int i = 0; i < DEFAULT_ANCESTOR_LIMIT; ++i) {
+            prev = spend(prev, storage);
+            BOOST_REQUIRE_EQUAL(IsStorageTx(*prev), storage);
+            BOOST_REQUIRE(m_node.chainman->ProcessTransaction(prev).m_result_type == MempoolAcceptResult::ResultType::VALID);
+        }
+        return m_node.chainman->ProcessTransaction(spend(prev, storage));
+    };
+
+    // Mature the second coinbase too
+    CreateAndProcessBlock({}, script);
+
+    const MempoolAcceptResult result_storage{chain(m_coinbase_txns[0], /*storage=*/true)};
+    BOOST_CHECK(result_storage.m_result_type == MempoolAcceptResult::ResultType::VALID);
+
+    const MempoolAcceptResult result_other{chain(m_coinbase_txns[1], /*storage=*/false)};
+    BOOST_CHECK(result_other.m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK_EQUAL(result_other.m_state.GetRejectReason(), "too-long-mempool-chain");
+}
 BOOST_AUTO_TEST_SUITE_END()
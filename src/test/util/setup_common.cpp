@@ -29,6 +29,7 @@
 #include <noui.h>
 #include <policy/fees.h>
 #include <policy/fees_args.h>
+#include <pos/pos.h>
 #include <pow.h>
 #include <rpc/blockchain.h>
 #include <rpc/register.h>
@@ -143,8 +144,9 @@ BasicTestingSetup::BasicTestingSetup(const std::string& chainName, const std::ve
 
     ValidationCacheSizes validation_cache_sizes{};
     ApplyArgsManOptions(*m_node.args, validation_cache_sizes);
-    Assert(InitSignatureCache(validation_cache_sizes.signature_cache_bytes));
-    Assert(InitScriptExecutionCache(validation_cache_sizes.script_execution_cache_bytes));
+    Assert(InitSignatureCache(validation_cache_sizes.signature_cache_bytes, validation_cache_sizes.signature_cache_max_bytes));
+    Assert(InitScriptExecutionCache(validation_cache_sizes.script_execution_cache_bytes, validation_cache_sizes.script_execution_cache_max_bytes));
+    Assert(InitStakeKernelCache(DEFAULT_STAKE_KERNEL_CACHE_BYTES));
 
     m_node.chain = interfaces::MakeChain(m_node);
     static bool noui_connected = false;
@@ -285,7 +287,7 @@ TestChain100Setup::TestChain100Setup(
         LOCK(::cs_main);
         assert(
             m_node.chainman->ActiveChain().Tip()->GetBlockHash().ToString() ==
-            "571d80a9967ae599cec0448b0b0ba1cfb606f584d8069bd7166b86854ba7a191");
+            "07bfa6803e991d3e6e67b31b53f70d9bef03f43f2ea6a56eb54c262c0375b5d7");
     }
 }
 
@@ -313,7 +315,7 @@ CBlock TestChain100Setup::CreateBlock(
     }
     RegenerateCommitments(block, *Assert(m_node.chainman));
 
-    while (!CheckProofOfWork(block.GetHash(), block.nBits, m_node.chainman->GetConsensus())) ++block.nNonce;
+    while (!CheckProofOfWork(block.GetPoWHash(), block.nBits, m_node.chainman->GetConsensus())) ++block.nNonce;
 
     return block;
 }
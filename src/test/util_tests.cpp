@@ -21,6 +21,7 @@
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/time.h>
+#include <util/tune.h>
 #include <util/vector.h>
 
 #include <array>
@@ -232,6 +233,13 @@ BOOST_AUTO_TEST_CASE(util_HexStr)
             BOOST_TEST_REQUIRE(i == upper*16 + lower);
         }
     }
+
+    {
+        char out[11] = "xxxxxxxxxx";
+        const Span<const uint8_t> in{MakeUCharSpan(ParseHex_expected).first(4)};
+        BOOST_CHECK(WriteHexStr(in, out) == out + 8);
+        BOOST_CHECK_EQUAL(std::string(out), "04678afdxx");
+    }
 }
 
 BOOST_AUTO_TEST_CASE(span_write_bytes)
@@ -1791,4 +1799,48 @@ BOOST_AUTO_TEST_CASE(util_WriteBinaryFile)
     BOOST_CHECK(valid);
     BOOST_CHECK_EQUAL(actual_text, expected_text);
 }
+BOOST_AUTO_TEST_CASE(util_TunedSettings)
+{
+    const auto setting{[](const std::vector<std::pair<std::string, std::string>>& settings, const std::string& name) -> std::optional<std::string> {
+        for (const auto& [setting_name, value] : settings) {
+            if (setting_name == name) return value;
+        }
+        return std::nullopt;
+    }};
+
+    // Nothing known but the cores: the settings sized by memory or disk keep their defaults
+    HardwareProfile hardware;
+    hardware.cores = 2;
+    auto settings{TunedSettings(hardware)};
+    BOOST_CHECK(!setting(settings, "dbcache"));
+    BOOST_CHECK(!setting(settings, "storagecachesize"));
+    BOOST_CHECK_EQUAL(*setting(settings, "par"), "2");
+    BOOST_CHECK_EQUAL(*setting(settings, "rpcthreads"), "4");
+    BOOST_CHECK_EQUAL(*setting(settings, "jobthreads"), "2");
+
+    hardware.cores = 32;
+    hardware.ram_mib = 16384;
+    hardware.rotational = false;
+    hardware.disk_mib_per_s = 500;
+    settings = TunedSettings(hardware);
+    BOOST_CHECK_EQUAL(*setting(settings, "dbcache"), "4096");
+    BOOST_CHECK_EQUAL(*setting(settings, "maxmempool"), "500");
+    BOOST_CHECK_EQUAL(*setting(settings, "par"), "15");
+    BOOST_CHECK_EQUAL(*setting(settings, "rpcthreads"), "16");
+    BOOST_CHECK_EQUAL(*setting(settings, "jobthreads"), "8");
+    BOOST_CHECK_EQUAL(*setting(settings, "stakingthreads"), "2");
+    BOOST_CHECK_EQUAL(*setting(settings, "storagecachesize"), "1024");
+
+    // A slow disk gets more of memory for the cache
+    hardware.disk_mib_per_s = 40;
+    settings = TunedSettings(hardware);
+    BOOST_CHECK_EQUAL(*setting(settings, "dbcache"), "5461");
+    BOOST_CHECK_EQUAL(*setting(settings, "storagecachesize"), "2048");
+
+    // The probe finds at least a core, and the disk of an existing directory
+    const HardwareProfile probed{ProbeHardware(m_args.GetDataDirBase())};
+    BOOST_CHECK(probed.cores >= 1);
+    BOOST_CHECK(probed.disk_mib_per_s > 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include <chainparams.h>
 #include <consensus/amount.h>
 #include <net.h>
+#include <pow.h>
 #include <signet.h>
 #include <uint256.h>
 #include <validation.h>
@@ -62,6 +63,33 @@ BOOST_AUTO_TEST_CASE(subsidy_limit_test)
     BOOST_CHECK_EQUAL(nSum, CAmount{2099999997690000});
 }
 
+BOOST_AUTO_TEST_CASE(headers_pow_test)
+{
+    const auto params{CreateChainParams(*m_node.args, CBaseChainParams::REGTEST)};
+    const Consensus::Params& consensus{params->GetConsensus()};
+
+    // Enough proof-of-work headers for their batches to be spread over the check queue workers
+    std::vector<CBlockHeader> headers(100);
+    for (CBlockHeader& header : headers) {
+        header.nBits = UintToArith256(consensus.powLimit).GetCompact();
+        header.nNonce = 1;
+        while (!CheckProofOfWork(header.GetPoWHash(), header.nBits, consensus)) ++header.nNonce;
+    }
+    BOOST_CHECK(HasValidProofOfWork(headers, consensus));
+    BOOST_CHECK(HasValidProofOfWork(Span{headers}.first(3), consensus));
+
+    // A proof-of-stake header has no proof of work to check
+    headers[10].nNonce = 0;
+    BOOST_CHECK(HasValidProofOfWork(headers, consensus));
+
+    // An invalid header is found in any of the batches
+    for (const size_t i : {0, 42, 99}) {
+        std::vector<CBlockHeader> invalid{headers};
+        while (CheckProofOfWork(invalid[i].GetPoWHash(), invalid[i].nBits, consensus)) ++invalid[i].nNonce;
+        BOOST_CHECK(!HasValidProofOfWork(invalid, consensus));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(signet_parse_tests)
 {
     ArgsManager signet_argsman;
@@ -140,10 +168,12 @@ BOOST_AUTO_TEST_CASE(test_assumeutxo)
     const auto out110 = *ExpectedAssumeutxo(110, *params);
     BOOST_CHECK_EQUAL(out110.hash_serialized.ToString(), "1ebbf5850204c0bdb15bf030f47c7fe91d45c44c712697e4509ba67adb01c618");
     BOOST_CHECK_EQUAL(out110.nChainTx, 110U);
+    BOOST_CHECK_EQUAL(out110.stake_modifier.ToString(), "cfe2e7741b422dbbd889e6ae43a192358d506f8806dab2d677584b0d85aa9d6c");
 
     const auto out210 = *ExpectedAssumeutxo(200, *params);
     BOOST_CHECK_EQUAL(out210.hash_serialized.ToString(), "51c8d11d8b5c1de51543c579736e786aa2736206d1e11e627568029ce092cf62");
     BOOST_CHECK_EQUAL(out210.nChainTx, 200U);
+    BOOST_CHECK_EQUAL(out210.stake_modifier.ToString(), "032a11dc35fe2e7096aa19070645ae41dd5fc47f6447e08f88467d67b6a00741");
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <boost/test/unit_test.hpp>
+#include <chain.h>
 #include <consensus/validation.h>
 #include <primitives/block.h>
 #include <scheduler.h>
@@ -10,6 +11,9 @@
 #include <util/check.h>
 #include <validationinterface.h>
 
+#include <algorithm>
+#include <future>
+
 BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, TestingSetup)
 
 struct TestSubscriberNoop final : public CValidationInterface {
@@ -91,4 +95,54 @@ BOOST_AUTO_TEST_CASE(unregister_all_during_call)
     BOOST_CHECK(destroyed);
 }
 
+struct TestFlushSubscriber final : public CValidationInterface {
+    std::function<void()> m_on_flush;
+    std::atomic<int> m_flushes{0};
+    void ChainStateFlushed(const CBlockLocator&) override
+    {
+        if (m_on_flush) m_on_flush();
+        ++m_flushes;
+    }
+};
+
+static std::optional<ValidationLaneInfo> FindLane(const std::string& name)
+{
+    const auto lanes{GetMainSignals().GetLaneInfo()};
+    const auto it{std::find_if(lanes.begin(), lanes.end(), [&](const ValidationLaneInfo& lane) { return lane.name == name; })};
+    if (it == lanes.end()) return std::nullopt;
+    return *it;
+}
+
+BOOST_AUTO_TEST_CASE(notification_lanes)
+{
+    // A subscriber stuck on a lane of its own does not hold up the shared queue
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future()};
+    auto slow{std::make_shared<TestFlushSubscriber>()};
+    slow->m_on_flush = [released] { released.wait(); };
+    auto fast{std::make_shared<TestFlushSubscriber>()};
+    RegisterSharedValidationInterface(slow, "slow");
+    RegisterSharedValidationInterface(fast);
+
+    GetMainSignals().ChainStateFlushed(CBlockLocator{});
+    GetMainSignals().ChainStateFlushed(CBlockLocator{});
+    while (fast->m_flushes < 2) std::this_thread::yield();
+    BOOST_CHECK_EQUAL(slow->m_flushes, 0);
+    BOOST_REQUIRE(FindLane("slow"));
+    BOOST_CHECK_EQUAL(FindLane("slow")->pending, 2U);
+    BOOST_CHECK_EQUAL(FindLane("slow")->delivered, 0U);
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 2U);
+
+    // Syncing with the queue waits for the lanes too
+    release.set_value();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(slow->m_flushes, 2);
+    BOOST_CHECK_EQUAL(FindLane("slow")->pending, 0U);
+    BOOST_CHECK_EQUAL(FindLane("slow")->delivered, 2U);
+
+    UnregisterSharedValidationInterface(slow);
+    UnregisterSharedValidationInterface(fast);
+    BOOST_CHECK(!FindLane("slow"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 #define BITCOIN_THREADSAFETY_H
 
 #include <mutex>
+#include <shared_mutex>
 
 #ifdef __clang__
 // TL;DR Add GUARDED_BY(mutex) to member variables. The others are
@@ -74,4 +75,30 @@ public:
     ~StdLockGuard() UNLOCK_FUNCTION() {}
 };
 
+// SharedMutex provides an annotated version of std::shared_mutex for data that
+// is read far more often than it is written. Like StdMutex it is not tracked by
+// DEBUG_LOCKORDER, so it should only guard leaf critical sections.
+class LOCKABLE SharedMutex : public std::shared_mutex
+{
+public:
+#ifdef __clang__
+    const SharedMutex& operator!() const { return *this; }
+#endif // __clang__
+};
+
+// ReadLock takes a SharedMutex in shared mode, WriteLock in exclusive mode.
+class SCOPED_LOCKABLE ReadLock : public std::shared_lock<std::shared_mutex>
+{
+public:
+    explicit ReadLock(SharedMutex& cs) SHARED_LOCK_FUNCTION(cs) : std::shared_lock<std::shared_mutex>(cs) {}
+    ~ReadLock() UNLOCK_FUNCTION() {}
+};
+
+class SCOPED_LOCKABLE WriteLock : public std::unique_lock<std::shared_mutex>
+{
+public:
+    explicit WriteLock(SharedMutex& cs) EXCLUSIVE_LOCK_FUNCTION(cs) : std::unique_lock<std::shared_mutex>(cs) {}
+    ~WriteLock() UNLOCK_FUNCTION() {}
+};
+
 #endif // BITCOIN_THREADSAFETY_H
@@ -7,15 +7,22 @@
 
 #include <chain.h>
 #include <logging.h>
+#include <pos/pos.h>
 #include <pow.h>
 #include <random.h>
 #include <shutdown.h>
 #include <uint256.h>
+#include <util/thread.h>
+#include <util/time.h>
 #include <util/translation.h>
 #include <util/vector.h>
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <tuple>
+#include <unordered_map>
+
 static constexpr uint8_t DB_COIN{'C'};
 static constexpr uint8_t DB_BLOCK_FILES{'f'};
 static constexpr uint8_t DB_BLOCK_INDEX{'b'};
@@ -24,6 +31,7 @@ static constexpr uint8_t DB_BEST_BLOCK{'B'};
 static constexpr uint8_t DB_HEAD_BLOCKS{'H'};
 static constexpr uint8_t DB_FLAG{'F'};
 static constexpr uint8_t DB_REINDEX_FLAG{'R'};
+static constexpr uint8_t DB_REINDEX_PROGRESS{'r'};
 static constexpr uint8_t DB_LAST_BLOCK{'l'};
 
 // Keys used in previous version that might still be found in the DB:
@@ -97,6 +105,15 @@ bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
     return m_db->Exists(CoinEntry(&outpoint));
 }
 
+size_t CCoinsViewDB::GetCoins(const std::vector<COutPoint>& outpoints, std::vector<std::optional<Coin>>& coins, size_t workers) const {
+    std::vector<CoinEntry> keys;
+    keys.reserve(outpoints.size());
+    for (const COutPoint& outpoint : outpoints) {
+        keys.emplace_back(&outpoint);
+    }
+    return m_db->ReadMany(keys, coins, workers);
+}
+
 uint256 CCoinsViewDB::GetBestBlock() const {
     uint256 hashBestChain;
     if (!m_db->Read(DB_BEST_BLOCK, hashBestChain))
@@ -175,6 +192,144 @@ size_t CCoinsViewDB::EstimateSize() const
     return m_db->EstimateSize(DB_COIN, uint8_t(DB_COIN + 1));
 }
 
+CCoinsViewBackgroundFlush::CCoinsViewBackgroundFlush(CCoinsView* view, bool background)
+    : CCoinsViewBacked(view), m_background(background) {}
+
+CCoinsViewBackgroundFlush::~CCoinsViewBackgroundFlush()
+{
+    Wait();
+}
+
+bool CCoinsViewBackgroundFlush::GetCoin(const COutPoint& outpoint, Coin& coin) const
+{
+    {
+        LOCK(m_mutex);
+        if (m_pending) {
+            auto it = m_pending->coins.find(outpoint);
+            if (it != m_pending->coins.end()) {
+                if (it->second.coin.IsSpent()) return false;
+                coin = it->second.coin;
+                return true;
+            }
+        }
+    }
+    // Coins not being written are left alone in the database by the write
+    return base->GetCoin(outpoint, coin);
+}
+
+size_t CCoinsViewBackgroundFlush::GetCoins(const std::vector<COutPoint>& outpoints, std::vector<std::optional<Coin>>& coins, size_t workers) const
+{
+    coins.assign(outpoints.size(), std::nullopt);
+    size_t found{0};
+    std::vector<COutPoint> unwritten;
+    std::vector<size_t> unwritten_pos;
+    {
+        LOCK(m_mutex);
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            if (m_pending) {
+                auto it = m_pending->coins.find(outpoints[i]);
+                if (it != m_pending->coins.end()) {
+                    if (!it->second.coin.IsSpent()) {
+                        coins[i] = it->second.coin;
+                        ++found;
+                    }
+                    continue;
+                }
+            }
+            unwritten.push_back(outpoints[i]);
+            unwritten_pos.push_back(i);
+        }
+    }
+    if (unwritten.size() == outpoints.size()) return base->GetCoins(outpoints, coins, workers);
+
+    std::vector<std::optional<Coin>> fetched;
+    found += base->GetCoins(unwritten, fetched, workers);
+    for (size_t i = 0; i < unwritten.size(); ++i) {
+        coins[unwritten_pos[i]] = std::move(fetched[i]);
+    }
+    return found;
+}
+
+bool CCoinsViewBackgroundFlush::HaveCoin(const COutPoint& outpoint) const
+{
+    {
+        LOCK(m_mutex);
+        if (m_pending) {
+            auto it = m_pending->coins.find(outpoint);
+            if (it != m_pending->coins.end()) return !it->second.coin.IsSpent();
+        }
+    }
+    return base->HaveCoin(outpoint);
+}
+
+uint256 CCoinsViewBackgroundFlush::GetBestBlock() const
+{
+    {
+        LOCK(m_mutex);
+        // The database has no best block while being written
+        if (m_pending) return m_pending->hash_block;
+    }
+    return base->GetBestBlock();
+}
+
+bool CCoinsViewBackgroundFlush::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase)
+{
+    if (!Wait()) return false;
+    if (!std::exchange(m_defer_next, false)) return base->BatchWrite(mapCoins, hashBlock, erase);
+
+    // Keep the dirty coins only, the rest being in the database already
+    auto pending{std::make_unique<PendingWrite>()};
+    pending->hash_block = hashBlock;
+    for (auto it = mapCoins.begin(); it != mapCoins.end(); it = erase ? mapCoins.erase(it) : std::next(it)) {
+        if (!(it->second.flags & CCoinsCacheEntry::DIRTY)) continue;
+        Coin coin{erase ? std::move(it->second.coin) : it->second.coin};
+        pending->coins_usage += coin.DynamicMemoryUsage();
+        pending->coins.emplace(std::piecewise_construct, std::forward_as_tuple(it->first),
+                               std::forward_as_tuple(std::move(coin), CCoinsCacheEntry::DIRTY));
+    }
+    LogPrint(BCLog::COINDB, "Writing %u changed transaction outputs in the background\n", pending->coins.size());
+
+    PendingWrite& write{*pending};
+    WITH_LOCK(m_mutex, m_pending = std::move(pending));
+    m_thread = std::thread(&util::TraceThread, "coinsflush", [this, &write] { Write(write); });
+    return true;
+}
+
+void CCoinsViewBackgroundFlush::Write(PendingWrite& pending)
+{
+    const auto time_start{SteadyClock::now()};
+    bool ok{false};
+    try {
+        // Not erasing, the coins stay readable while they are written
+        ok = base->BatchWrite(pending.coins, pending.hash_block, /*erase=*/false);
+    } catch (const std::exception& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+    }
+    if (!ok) {
+        // Keep serving the coins, the database being partly written until the node is restarted
+        LogPrintf("Error: Failed to write to coin database in the background\n");
+        m_failed = true;
+        return;
+    }
+    LogPrint(BCLog::COINDB, "Wrote coins in the background in %.2fms\n", Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
+
+    // Free the coins outside of the lock
+    std::unique_ptr<PendingWrite> written{WITH_LOCK(m_mutex, return std::move(m_pending))};
+}
+
+bool CCoinsViewBackgroundFlush::Wait()
+{
+    if (m_thread.joinable()) m_thread.join();
+    return !m_failed;
+}
+
+size_t CCoinsViewBackgroundFlush::DynamicMemoryUsage() const
+{
+    LOCK(m_mutex);
+    if (!m_pending) return 0;
+    return memusage::DynamicUsage(m_pending->coins) + m_pending->coins_usage;
+}
+
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
     return Read(std::make_pair(DB_BLOCK_FILES, nFile), info);
 }
@@ -182,14 +337,26 @@ bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
 bool CBlockTreeDB::WriteReindexing(bool fReindexing) {
     if (fReindexing)
         return Write(DB_REINDEX_FLAG, uint8_t{'1'});
-    else
-        return Erase(DB_REINDEX_FLAG);
+    CDBBatch batch(*this);
+    batch.Erase(DB_REINDEX_FLAG);
+    batch.Erase(DB_REINDEX_PROGRESS);
+    return WriteBatch(batch);
 }
 
 void CBlockTreeDB::ReadReindexing(bool &fReindexing) {
     fReindexing = Exists(DB_REINDEX_FLAG);
 }
 
+bool CBlockTreeDB::WriteReindexProgress(int nFile) {
+    return Write(DB_REINDEX_PROGRESS, nFile, /*fSync=*/true);
+}
+
+int CBlockTreeDB::ReadReindexProgress() {
+    int nFile{0};
+    Read(DB_REINDEX_PROGRESS, nFile);
+    return nFile;
+}
+
 bool CBlockTreeDB::ReadLastBlockFile(int &nFile) {
     return Read(DB_LAST_BLOCK, nFile);
 }
@@ -213,6 +380,11 @@ public:
 private:
     std::unique_ptr<CDBIterator> pcursor;
     std::pair<char, COutPoint> keyTmp;
+    //! The cursor ends before the first txid starting with this byte, 256 for the end of the coins
+    int m_end_byte{256};
+
+    //! Cache the key pcursor is at, or invalidate the cursor past its last record
+    void ReadKey();
 
     friend class CCoinsViewDB;
 };
@@ -226,14 +398,37 @@ std::unique_ptr<CCoinsViewCursor> CCoinsViewDB::Cursor() const
        that restriction.  */
     i->pcursor->Seek(DB_COIN);
     // Cache key of first record
-    if (i->pcursor->Valid()) {
-        CoinEntry entry(&i->keyTmp.second);
-        i->pcursor->GetKey(entry);
-        i->keyTmp.first = entry.key;
+    i->ReadKey();
+    return i;
+}
+
+std::vector<std::unique_ptr<CCoinsViewCursor>> CCoinsViewDB::RangeCursors(size_t count) const
+{
+    count = std::clamp<size_t>(count, 1, 256);
+    const uint256 best_block{GetBestBlock()};
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    std::vector<std::unique_ptr<CDBIterator>> iterators{m_db->NewIterators(count)};
+    for (size_t range = 0; range < count; ++range) {
+        auto i = std::make_unique<CCoinsViewDBCursor>(iterators[range].release(), best_block);
+        // Txids are uniformly distributed, so ranges of their first byte hold about as many coins
+        COutPoint start{uint256::ZERO, 0};
+        *start.hash.begin() = 256 * range / count;
+        i->m_end_byte = 256 * (range + 1) / count;
+        i->pcursor->Seek(CoinEntry(&start));
+        i->ReadKey();
+        cursors.push_back(std::move(i));
+    }
+    return cursors;
+}
+
+void CCoinsViewDBCursor::ReadKey()
+{
+    CoinEntry entry(&keyTmp.second);
+    if (!pcursor->Valid() || !pcursor->GetKey(entry) || (entry.key == DB_COIN && *keyTmp.second.hash.begin() >= m_end_byte)) {
+        keyTmp.first = 0; // Make sure Valid() and GetKey() return false
     } else {
-        i->keyTmp.first = 0; // Make sure Valid() and GetKey() return false
+        keyTmp.first = entry.key;
     }
-    return i;
 }
 
 bool CCoinsViewDBCursor::GetKey(COutPoint &key) const
@@ -259,12 +454,21 @@ bool CCoinsViewDBCursor::Valid() const
 void CCoinsViewDBCursor::Next()
 {
     pcursor->Next();
-    CoinEntry entry(&keyTmp.second);
-    if (!pcursor->Valid() || !pcursor->GetKey(entry)) {
-        keyTmp.first = 0; // Invalidate cached key after last record so that Valid() and GetKey() return false
-    } else {
-        keyTmp.first = entry.key;
-    }
+    // Invalidate cached key after last record so that Valid() and GetKey() return false
+    ReadKey();
+}
+
+//! Whether the stake modifier of a block follows from its parent's, so that its record can leave it out
+static bool StakeModifierFromParent(const CBlockIndex& index)
+{
+    return index.pprev && index.nStakeModifier == ComputeStakeModifier(index.pprev, index.prevoutStake.hash);
+}
+
+//! The record of a block, in the compact form if compact is set, or else the legacy one
+static CDiskBlockIndex DiskRecord(const CBlockIndex& index, bool compact)
+{
+    if (!compact) return CDiskBlockIndex{&index};
+    return CDiskBlockIndex{&index, /*compact=*/true, StakeModifierFromParent(index)};
 }
 
 bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo) {
@@ -274,7 +478,7 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
     }
     batch.Write(DB_LAST_BLOCK, nLastFile);
     for (std::vector<const CBlockIndex*>::const_iterator it=blockinfo.begin(); it != blockinfo.end(); it++) {
-        batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), CDiskBlockIndex(*it));
+        batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), DiskRecord(**it, m_compact_records));
     }
     return WriteBatch(batch, true);
 }
@@ -297,6 +501,11 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
 
+    // Compact records leaving fields to their parent's, along with what they leave
+    std::unordered_map<CBlockIndex*, std::pair<uint8_t, uint32_t>> parent_relative;
+    // Records in the other form than m_compact_records selects, which are rewritten in it
+    std::vector<const CBlockIndex*> rewrite;
+
     // Load m_block_index
     while (pcursor->Valid()) {
         if (ShutdownRequested()) return false;
@@ -304,8 +513,9 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
         if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
             CDiskBlockIndex diskindex;
             if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
-                CBlockIndex* pindexNew = insertBlockIndex(diskindex.ConstructBlockHash());
+                // Construct block index object. The hash of a record that leaves header fields
+                // to its parent's is only checked once those are known.
+                CBlockIndex* pindexNew = insertBlockIndex(diskindex.HasParentFields() ? key.second : diskindex.ConstructBlockHash());
                 pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
                 pindexNew->nHeight        = diskindex.nHeight;
                 pindexNew->nFile          = diskindex.nFile;
@@ -325,6 +535,13 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->prevoutStake   = diskindex.prevoutStake;
                 pindexNew->hashProof      = diskindex.hashProof;
 
+                if (diskindex.HasParentFields()) {
+                    parent_relative.emplace(pindexNew, std::make_pair(diskindex.nRecordFields, diskindex.nTimeFromParent));
+                }
+                if ((diskindex.nRecordFields != RECORD_LEGACY) != m_compact_records) {
+                    rewrite.push_back(pindexNew);
+                }
+
                 // if (!CheckProofOfWork(pindexNew->GetBlockPoWHash(), pindexNew->nBits, consensusParams)) {
                 //     return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
                 // }
@@ -338,5 +555,54 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
         }
     }
 
+    // Records are ordered by hash, so fill in the fields left to the parent's record once
+    // all are loaded, walking up to the closest resolved ancestor first
+    std::vector<CBlockIndex*> unresolved;
+    while (!parent_relative.empty()) {
+        for (CBlockIndex* pindex = parent_relative.begin()->first; pindex && parent_relative.count(pindex) && unresolved.size() <= parent_relative.size(); pindex = pindex->pprev) {
+            unresolved.push_back(pindex);
+        }
+        for (auto it = unresolved.rbegin(); it != unresolved.rend(); ++it) {
+            CBlockIndex& index = **it;
+            const auto [fields, time_from_parent] = parent_relative.at(&index);
+            if (!index.pprev) {
+                return error("%s: block index record %s refers to a missing parent", __func__, index.GetBlockHash().ToString());
+            }
+            const CBlockIndex& parent = *index.pprev;
+            if (fields & RECORD_PARENT_HEADER) {
+                index.nHeight = parent.nHeight + 1;
+                index.nTime = parent.nTime + time_from_parent;
+            }
+            if (fields & RECORD_PARENT_VERSION) index.nVersion = parent.nVersion;
+            if (fields & RECORD_PARENT_BITS) index.nBits = parent.nBits;
+            if (fields & RECORD_PARENT_STAKE_MODIFIER) {
+                index.nStakeModifier = ComputeStakeModifier(&parent, index.prevoutStake.hash);
+            }
+            if (index.GetBlockHeader().GetHash() != index.GetBlockHash()) {
+                return error("%s: block index record %s does not match its hash", __func__, index.GetBlockHash().ToString());
+            }
+            parent_relative.erase(&index);
+        }
+        unresolved.clear();
+    }
+
+    if (!rewrite.empty()) {
+        if (m_compact_records) {
+            LogPrintf("Rewriting %u block index records in the compact format. Versions before it can't read them: "
+                      "restart with -blockindexcompact=0 before downgrading, or run a full -reindex then.\n", rewrite.size());
+        } else {
+            LogPrintf("Rewriting %u block index records in the legacy format\n", rewrite.size());
+        }
+        CDBBatch batch(*this);
+        for (const CBlockIndex* pindex : rewrite) {
+            batch.Write(std::make_pair(DB_BLOCK_INDEX, pindex->GetBlockHash()), DiskRecord(*pindex, m_compact_records));
+            if (batch.SizeEstimate() > nDefaultDbBatchSize) {
+                WriteBatch(batch);
+                batch.Clear();
+            }
+        }
+        WriteBatch(batch, true);
+    }
+
     return true;
 }
@@ -12,9 +12,11 @@
 #include <sync.h>
 #include <util/fs.h>
 
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -30,6 +32,10 @@ struct bilingual_str;
 static const int64_t nDefaultDbCache = 450;
 //! -dbbatchsize default (bytes)
 static const int64_t nDefaultDbBatchSize = 16 << 20;
+//! -backgroundflush default
+static const bool DEFAULT_BACKGROUND_FLUSH = false;
+//! -blockindexcompact default, off as versions before it can't read compact records
+static const bool DEFAULT_BLOCK_INDEX_COMPACT = false;
 //! max. -dbcache (MiB)
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 16384 : 1024;
 //! min. -dbcache (MiB)
@@ -52,6 +58,9 @@ struct CoinsViewOptions {
     //! If non-zero, randomly exit when the database is flushed with (1/ratio)
     //! probability.
     int simulate_crash_ratio = 0;
+    //! Write the coins cache to the database on a background thread when
+    //! it is flushed periodically or for its size.
+    bool background_flush = DEFAULT_BACKGROUND_FLUSH;
 };
 
 /** CCoinsView backed by the coin database (chainstate/) */
@@ -66,10 +75,13 @@ public:
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
+    size_t GetCoins(const std::vector<COutPoint>& outpoints, std::vector<std::optional<Coin>>& coins, size_t workers = 1) const override;
     uint256 GetBestBlock() const override;
     std::vector<uint256> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock, bool erase = true) override;
     std::unique_ptr<CCoinsViewCursor> Cursor() const override;
+    //! Splits the txids by their first byte, so at most 256 cursors are returned.
+    std::vector<std::unique_ptr<CCoinsViewCursor>> RangeCursors(size_t count) const override;
 
     //! Whether an unsupported database format is used.
     bool NeedsUpgrade();
@@ -82,18 +94,81 @@ public:
     std::optional<fs::path> StoragePath() { return m_db->StoragePath(); }
 };
 
+/**
+ * CCoinsView that can write the coins flushed into it to the view below on a
+ * background thread, serving them from memory until they are written, so
+ * block connection doesn't wait on the database.
+ *
+ * At most one write is in flight, and a write waits for the one before it.
+ * Any write goes through CCoinsViewDB::BatchWrite, whose head blocks markers
+ * leave the database replayable from its last best block if it's cut short.
+ * Not thread-safe for writing: callers of BatchWrite() and Wait() hold
+ * cs_main. Reading is, for the coins being written never change.
+ */
+class CCoinsViewBackgroundFlush final : public CCoinsViewBacked
+{
+public:
+    CCoinsViewBackgroundFlush(CCoinsView* view, bool background);
+    ~CCoinsViewBackgroundFlush() override;
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool HaveCoin(const COutPoint& outpoint) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    size_t GetCoins(const std::vector<COutPoint>& outpoints, std::vector<std::optional<Coin>>& coins, size_t workers = 1) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    uint256 GetBestBlock() const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase = true) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Write the next batch on the background thread, if enabled, instead of before BatchWrite() returns.
+    void DeferNextWrite() { m_defer_next = m_background; }
+
+    //! Wait for the write in flight, if any. False once a write has failed.
+    bool Wait();
+
+    //! Memory held by the coins being written
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct PendingWrite {
+        CCoinsMapMemoryResource resource{};
+        CCoinsMap coins{0, SaltedOutpointHasher{}, CCoinsMap::key_equal{}, &resource};
+        uint256 hash_block;
+        size_t coins_usage{0};
+    };
+
+    void Write(PendingWrite& pending) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    const bool m_background;
+    bool m_defer_next{false};
+    std::thread m_thread;
+    std::atomic_bool m_failed{false};
+
+    mutable Mutex m_mutex;
+    //! The coins being written, read in their place until they are
+    std::unique_ptr<PendingWrite> m_pending GUARDED_BY(m_mutex);
+};
+
 /** Access to the block database (blocks/index/) */
 class CBlockTreeDB : public CDBWrapper
 {
+private:
+    //! Whether block index records are written in the compact form
+    const bool m_compact_records;
+
 public:
-    using CDBWrapper::CDBWrapper;
+    explicit CBlockTreeDB(const DBParams& params, bool compact_records = DEFAULT_BLOCK_INDEX_COMPACT)
+        : CDBWrapper(params), m_compact_records(compact_records) {}
+
     bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo);
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo &info);
     bool ReadLastBlockFile(int &nFile);
     bool WriteReindexing(bool fReindexing);
     void ReadReindexing(bool &fReindexing);
+    //! Record that the block files before nFile are reindexed, so an interrupted reindex resumes at nFile.
+    bool WriteReindexProgress(int nFile);
+    //! The block file to resume a reindex at, 0 if none is recorded.
+    int ReadReindexProgress();
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    //! Load the block index. Records not in the form m_compact_records selects are rewritten in it.
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 };
@@ -388,6 +388,7 @@ CTxMemPool::CTxMemPool(const Options& opts)
     : m_check_ratio{opts.check_ratio},
       minerPolicyEstimator{opts.estimator},
       m_max_size_bytes{opts.max_size_bytes},
+      m_max_storage_size_bytes{opts.max_storage_size_bytes},
       m_expiry{opts.expiry},
       m_incremental_relay_feerate{opts.incremental_relay_feerate},
       m_min_relay_feerate{opts.min_relay_feerate},
@@ -436,6 +437,10 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     // (When we update the entry for in-mempool parents, memory usage will be
     // further updated.)
     cachedInnerUsage += entry.DynamicMemoryUsage();
+    if (entry.IsStorage()) {
+        ++m_storage_count;
+        m_storage_inner_usage += entry.DynamicMemoryUsage();
+    }
 
     const CTransaction& tx = newit->GetTx();
     std::set<uint256> setParentTransactions;
@@ -514,6 +519,10 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     m_total_fee -= it->GetFee();
     cachedInnerUsage -= it->DynamicMemoryUsage();
     cachedInnerUsage -= memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+    if (it->IsStorage()) {
+        --m_storage_count;
+        m_storage_inner_usage -= it->DynamicMemoryUsage();
+    }
     mapTx.erase(it);
     nTransactionsUpdated++;
     if (minerPolicyEstimator) {minerPolicyEstimator->removeTx(hash, false);}
@@ -646,6 +655,8 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
     }
     lastRollingFeeUpdate = GetTime();
     blockSinceLastRollingFeeBump = true;
+    lastRollingStorageFeeUpdate = lastRollingFeeUpdate;
+    blockSinceLastRollingStorageFeeBump = true;
 }
 
 void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendheight) const
@@ -661,6 +672,8 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
     uint64_t checkTotal = 0;
     CAmount check_total_fee{0};
     uint64_t innerUsage = 0;
+    uint64_t storage_count{0};
+    uint64_t storage_inner_usage{0};
     uint64_t prev_ancestor_count{0};
 
     const Consensus::Params& params = Params().GetConsensus();
@@ -671,6 +684,10 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
         checkTotal += it->GetTxSize();
         check_total_fee += it->GetFee();
         innerUsage += it->DynamicMemoryUsage();
+        if (it->IsStorage()) {
+            ++storage_count;
+            storage_inner_usage += it->DynamicMemoryUsage();
+        }
         const CTransaction& tx = it->GetTx();
         innerUsage += memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
         CTxMemPoolEntry::Parents setParentCheck;
@@ -753,6 +770,8 @@ void CTxMemPool::check(const CCoinsViewCache& active_coins_tip, int64_t spendhei
     assert(totalTxSize == checkTotal);
     assert(m_total_fee == check_total_fee);
     assert(innerUsage == cachedInnerUsage);
+    assert(storage_count == m_storage_count);
+    assert(storage_inner_usage == m_storage_inner_usage);
 }
 
 bool CTxMemPool::CompareDepthAndScore(const uint256& hasha, const uint256& hashb, bool wtxid)
@@ -953,6 +972,37 @@ bool CCoinsViewMemPool::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return base->GetCoin(outpoint, coin);
 }
 
+size_t CCoinsViewMemPool::GetCoins(const std::vector<COutPoint>& outpoints, std::vector<std::optional<Coin>>& coins, size_t workers) const {
+    coins.assign(outpoints.size(), std::nullopt);
+    size_t found{0};
+    // Coins of the package and the mempool as GetCoin() finds them, the rest from the base at once
+    std::vector<COutPoint> confirmed;
+    std::vector<size_t> confirmed_pos;
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        const COutPoint& outpoint{outpoints[i]};
+        if (auto it = m_temp_added.find(outpoint); it != m_temp_added.end()) {
+            coins[i] = it->second;
+            ++found;
+        } else if (CTransactionRef ptx = mempool.get(outpoint.hash)) {
+            if (outpoint.n < ptx->vout.size()) {
+                coins[i] = Coin(ptx->vout[outpoint.n], MEMPOOL_HEIGHT, false, false);
+                ++found;
+            }
+        } else {
+            confirmed.push_back(outpoint);
+            confirmed_pos.push_back(i);
+        }
+    }
+    if (confirmed.empty()) return found;
+
+    std::vector<std::optional<Coin>> fetched;
+    found += base->GetCoins(confirmed, fetched, workers);
+    for (size_t i = 0; i < confirmed.size(); ++i) {
+        coins[confirmed_pos[i]] = std::move(fetched[i]);
+    }
+    return found;
+}
+
 void CCoinsViewMemPool::PackageAddTransaction(const CTransactionRef& tx)
 {
     for (unsigned int n = 0; n < tx->vout.size(); ++n) {
@@ -962,8 +1012,13 @@ void CCoinsViewMemPool::PackageAddTransaction(const CTransactionRef& tx)
 
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
-    // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+    // Estimate the overhead of mapTx to be 18 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 18 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+}
+
+uint64_t CTxMemPool::StorageUsage() const {
+    AssertLockHeld(cs);
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 18 * sizeof(void*)) * m_storage_count + m_storage_inner_usage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked) {
@@ -1028,28 +1083,40 @@ void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
     }
 }
 
-CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
-    LOCK(cs);
-    if (!blockSinceLastRollingFeeBump || rollingMinimumFeeRate == 0)
-        return CFeeRate(llround(rollingMinimumFeeRate));
+/** Decay a rolling minimum fee rate (per kvB) of a pool using usage out of sizelimit, see GetMinFee() */
+static CFeeRate DecayRollingFee(double& rate, int64_t& last_update, bool block_since_bump, size_t usage, size_t sizelimit, const CFeeRate& incremental_relay_feerate)
+{
+    if (!block_since_bump || rate == 0)
+        return CFeeRate(llround(rate));
 
     int64_t time = GetTime();
-    if (time > lastRollingFeeUpdate + 10) {
-        double halflife = ROLLING_FEE_HALFLIFE;
-        if (DynamicMemoryUsage() < sizelimit / 4)
+    if (time > last_update + 10) {
+        double halflife = CTxMemPool::ROLLING_FEE_HALFLIFE;
+        if (usage < sizelimit / 4)
             halflife /= 4;
-        else if (DynamicMemoryUsage() < sizelimit / 2)
+        else if (usage < sizelimit / 2)
             halflife /= 2;
 
-        rollingMinimumFeeRate = rollingMinimumFeeRate / pow(2.0, (time - lastRollingFeeUpdate) / halflife);
-        lastRollingFeeUpdate = time;
+        rate = rate / pow(2.0, (time - last_update) / halflife);
+        last_update = time;
 
-        if (rollingMinimumFeeRate < (double)m_incremental_relay_feerate.GetFeePerK() / 2) {
-            rollingMinimumFeeRate = 0;
+        if (rate < (double)incremental_relay_feerate.GetFeePerK() / 2) {
+            rate = 0;
             return CFeeRate(0);
         }
     }
-    return std::max(CFeeRate(llround(rollingMinimumFeeRate)), m_incremental_relay_feerate);
+    return std::max(CFeeRate(llround(rate)), incremental_relay_feerate);
+}
+
+CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
+    LOCK(cs);
+    return DecayRollingFee(rollingMinimumFeeRate, lastRollingFeeUpdate, blockSinceLastRollingFeeBump, DynamicMemoryUsage(), sizelimit, m_incremental_relay_feerate);
+}
+
+CFeeRate CTxMemPool::GetStorageMinFee() const {
+    LOCK(cs);
+    return std::max(GetMinFee(),
+                    DecayRollingFee(rollingStorageMinimumFeeRate, lastRollingStorageFeeUpdate, blockSinceLastRollingStorageFeeBump, StorageUsage(), m_max_storage_size_bytes, m_incremental_relay_feerate));
 }
 
 void CTxMemPool::trackPackageRemoved(const CFeeRate& rate) {
@@ -1060,25 +1127,21 @@ void CTxMemPool::trackPackageRemoved(const CFeeRate& rate) {
     }
 }
 
+void CTxMemPool::trackStoragePackageRemoved(const CFeeRate& rate) {
+    AssertLockHeld(cs);
+    if (rate.GetFeePerK() > rollingStorageMinimumFeeRate) {
+        rollingStorageMinimumFeeRate = rate.GetFeePerK();
+        blockSinceLastRollingStorageFeeBump = false;
+    }
+}
+
 void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpendsRemaining) {
     AssertLockHeld(cs);
 
     unsigned nTxnRemoved = 0;
-    CFeeRate maxFeeRateRemoved(0);
-    while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
-        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
-
-        // We set the new mempool min fee to the feerate of the removed set, plus the
-        // "minimum reasonable fee rate" (ie some value under which we consider txn
-        // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
-        // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
-        removed += m_incremental_relay_feerate;
-        trackPackageRemoved(removed);
-        maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
-
+    const auto remove_with_descendants = [&](txiter it) EXCLUSIVE_LOCKS_REQUIRED(cs) {
         setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
+        CalculateDescendants(it, stage);
         nTxnRemoved += stage.size();
 
         std::vector<CTransaction> txn;
@@ -1096,6 +1159,42 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
                 }
             }
         }
+    };
+
+    // Storage transactions are evicted among themselves first, so a burst of
+    // them does not push out ordinary payments nor raise their minimum fee.
+    CFeeRate maxStorageFeeRateRemoved(0);
+    while (m_storage_count > 0 && StorageUsage() > (uint64_t)m_max_storage_size_bytes) {
+        indexed_transaction_set::index<storage_score>::type::iterator it = mapTx.get<storage_score>().begin();
+        assert(it->IsStorage());
+
+        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+        removed += m_incremental_relay_feerate;
+        trackStoragePackageRemoved(removed);
+        maxStorageFeeRateRemoved = std::max(maxStorageFeeRateRemoved, removed);
+
+        remove_with_descendants(mapTx.project<0>(it));
+    }
+
+    if (maxStorageFeeRateRemoved > CFeeRate(0)) {
+        LogPrint(BCLog::MEMPOOL, "Removed %u txn, rolling minimum storage fee bumped to %s\n", nTxnRemoved, maxStorageFeeRateRemoved.ToString());
+        nTxnRemoved = 0;
+    }
+
+    CFeeRate maxFeeRateRemoved(0);
+    while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
+        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
+
+        // We set the new mempool min fee to the feerate of the removed set, plus the
+        // "minimum reasonable fee rate" (ie some value under which we consider txn
+        // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
+        // equal to txn which were removed with no block in between.
+        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+        removed += m_incremental_relay_feerate;
+        trackPackageRemoved(removed);
+        maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
+
+        remove_with_descendants(mapTx.project<0>(it));
     }
 
     if (maxFeeRateRemoved > CFeeRate(0)) {
@@ -1103,6 +1202,14 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
     }
 }
 
+void CTxMemPool::SetMaxSize(int64_t max_size_bytes, int64_t max_storage_size_bytes, std::vector<COutPoint>* pvNoSpendsRemaining)
+{
+    AssertLockHeld(cs);
+    m_max_size_bytes = max_size_bytes;
+    m_max_storage_size_bytes = max_storage_size_bytes;
+    TrimToSize(max_size_bytes, pvNoSpendsRemaining);
+}
+
 uint64_t CTxMemPool::CalculateDescendantMaximum(txiter entry) const {
     // find parent with highest descendant count
     std::vector<txiter> candidates;
@@ -122,6 +122,23 @@ public:
     }
 };
 
+/** \class CompareTxMemPoolEntryByStorageScore
+ *
+ *  Sort storage transactions (see IsStorageTx()) ahead of the rest, each by
+ *  descendant score, so the storage transaction to evict next comes first.
+ */
+class CompareTxMemPoolEntryByStorageScore
+{
+public:
+    bool operator()(const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) const
+    {
+        if (a.IsStorage() != b.IsStorage()) {
+            return a.IsStorage();
+        }
+        return CompareTxMemPoolEntryByDescendantScore()(a, b);
+    }
+};
+
 /** \class CompareTxMemPoolEntryByScore
  *
  *  Sort by feerate of entry (fee/size) in descending order
@@ -201,6 +218,7 @@ struct descendant_score {};
 struct entry_time {};
 struct ancestor_score {};
 struct index_by_wtxid {};
+struct storage_score {};
 
 class CBlockPolicyEstimator;
 
@@ -326,6 +344,11 @@ protected:
     mutable int64_t lastRollingFeeUpdate GUARDED_BY(cs){GetTime()};
     mutable bool blockSinceLastRollingFeeBump GUARDED_BY(cs){false};
     mutable double rollingMinimumFeeRate GUARDED_BY(cs){0}; //!< minimum fee to get into the pool, decreases exponentially
+    uint64_t m_storage_count GUARDED_BY(cs){0};             //!< number of storage transactions (see IsStorageTx())
+    uint64_t m_storage_inner_usage GUARDED_BY(cs){0};       //!< ... and sum of their dynamic memory usage, as in cachedInnerUsage
+    mutable int64_t lastRollingStorageFeeUpdate GUARDED_BY(cs){GetTime()};
+    mutable bool blockSinceLastRollingStorageFeeBump GUARDED_BY(cs){false};
+    mutable double rollingStorageMinimumFeeRate GUARDED_BY(cs){0}; //!< minimum fee for storage transactions on top of rollingMinimumFeeRate, decreases exponentially
     mutable Epoch m_epoch GUARDED_BY(cs){};
 
     // In-memory counter for external mempool tracking purposes.
@@ -334,6 +357,7 @@ protected:
     mutable uint64_t m_sequence_number GUARDED_BY(cs){1};
 
     void trackPackageRemoved(const CFeeRate& rate) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void trackStoragePackageRemoved(const CFeeRate& rate) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     bool m_load_tried GUARDED_BY(cs){false};
 
@@ -371,6 +395,12 @@ public:
                 boost::multi_index::tag<ancestor_score>,
                 boost::multi_index::identity<CTxMemPoolEntry>,
                 CompareTxMemPoolEntryByAncestorFee
+            >,
+            // storage transactions first, sorted by fee rate
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::tag<storage_score>,
+                boost::multi_index::identity<CTxMemPoolEntry>,
+                CompareTxMemPoolEntryByStorageScore
             >
         >
     > indexed_transaction_set;
@@ -451,7 +481,9 @@ public:
 
     using Options = kernel::MemPoolOptions;
 
-    const int64_t m_max_size_bytes;
+    //! Size limits, which SetMaxSize() changes at runtime
+    std::atomic<int64_t> m_max_size_bytes;
+    std::atomic<int64_t> m_max_storage_size_bytes;
     const std::chrono::seconds m_expiry;
     const CFeeRate m_incremental_relay_feerate;
     const CFeeRate m_min_relay_feerate;
@@ -616,12 +648,27 @@ public:
         return GetMinFee(m_max_size_bytes);
     }
 
-    /** Remove transactions from the mempool until its dynamic size is <= sizelimit.
+    /** The minimum fee for a storage transaction (see IsStorageTx()) to get into the
+     *  mempool: GetMinFee(), raised by evictions to keep storage transactions within
+     *  m_max_storage_size_bytes.
+     */
+    CFeeRate GetStorageMinFee() const;
+
+    /** Dynamic memory usage of the storage transactions, as DynamicMemoryUsage() counts it. */
+    uint64_t StorageUsage() const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    /** Remove storage transactions until their dynamic usage is <= m_max_storage_size_bytes,
+      *  then any transactions from the mempool until its dynamic size is <= sizelimit.
       *  pvNoSpendsRemaining, if set, will be populated with the list of outpoints
       *  which are not in mempool which no longer have any spends in this mempool.
       */
     void TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpendsRemaining = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    /** Change m_max_size_bytes and m_max_storage_size_bytes, trimming the mempool
+     *  to the new limits as TrimToSize() does.
+     */
+    void SetMaxSize(int64_t max_size_bytes, int64_t max_storage_size_bytes, std::vector<COutPoint>* pvNoSpendsRemaining = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     /** Expire all transaction (and their dependencies) in the mempool older than time. Return the number of removed transactions. */
     int Expire(std::chrono::seconds time) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -816,6 +863,7 @@ protected:
 public:
     CCoinsViewMemPool(CCoinsView* baseIn, const CTxMemPool& mempoolIn);
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    size_t GetCoins(const std::vector<COutPoint>& outpoints, std::vector<std::optional<Coin>>& coins, size_t workers = 1) const override;
     /** Add the coins created by this transaction. These coins are only temporarily stored in
      * m_temp_added and cannot be flushed to the back end. Only used for package validation. */
     void PackageAddTransaction(const CTransactionRef& tx);
@@ -109,7 +109,16 @@ void TxOrphanage::EraseForPeer(NodeId peer)
     if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx from peer=%d\n", nErased, peer);
 }
 
-void TxOrphanage::LimitOrphans(unsigned int max_orphans)
+bool TxOrphanage::IsChained(const CTransaction& tx) const
+{
+    AssertLockHeld(m_mutex);
+    for (const CTxIn& txin : tx.vin) {
+        if (m_orphans.count(txin.prevout.hash)) return true;
+    }
+    return false;
+}
+
+void TxOrphanage::LimitOrphans(unsigned int max_orphans, unsigned int max_chained)
 {
     LOCK(m_mutex);
 
@@ -137,9 +146,22 @@ void TxOrphanage::LimitOrphans(unsigned int max_orphans)
     FastRandomContext rng;
     while (m_orphans.size() > max_orphans)
     {
-        // Evict a random orphan:
-        size_t randompos = rng.randrange(m_orphan_list.size());
-        _EraseTx(m_orphan_list[randompos]->first);
+        // Orphans spending no other orphan are held to max_orphans on their own. Those
+        // of chains, which resolve together once the first parent arrives, may add max_chained
+        std::vector<uint256> unchained;
+        if (max_chained > 0) {
+            for (const auto& it : m_orphan_list) {
+                if (!IsChained(*it->second.tx)) unchained.push_back(it->first);
+            }
+            if (unchained.size() <= max_orphans && m_orphans.size() <= size_t{max_orphans} + max_chained) break;
+        }
+        if (unchained.size() > max_orphans) {
+            _EraseTx(unchained[rng.randrange(unchained.size())]);
+        } else {
+            // Evict a random orphan:
+            size_t randompos = rng.randrange(m_orphan_list.size());
+            _EraseTx(m_orphan_list[randompos]->first);
+        }
         ++nEvicted;
     }
     if (nEvicted > 0) LogPrint(BCLog::MEMPOOL, "orphanage overflow, removed %u tx\n", nEvicted);
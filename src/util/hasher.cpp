@@ -7,13 +7,35 @@
 #include <span.h>
 #include <util/hasher.h>
 
+#include <vector>
+
 SaltedTxidHasher::SaltedTxidHasher() : k0(GetRand<uint64_t>()), k1(GetRand<uint64_t>()) {}
 
+void SaltedTxidHasher::HashBatch(Span<const uint256* const> txids, Span<uint64_t> out) const
+{
+    SipHashUint256Batch(k0, k1, txids, out);
+}
+
 SaltedOutpointHasher::SaltedOutpointHasher(bool deterministic) :
     k0(deterministic ? 0x8e819f2607a18de6 : GetRand<uint64_t>()),
     k1(deterministic ? 0xf4020d2e3983b0eb : GetRand<uint64_t>())
 {}
 
+void SaltedOutpointHasher::HashBatch(Span<const COutPoint> ids, Span<uint64_t> out) const
+{
+    std::vector<const uint256*> hashes;
+    std::vector<uint32_t> ns;
+    hashes.reserve(ids.size());
+    ns.reserve(ids.size());
+    for (const COutPoint& id : ids) {
+        hashes.push_back(&id.hash);
+        ns.push_back(id.n);
+    }
+    SipHashUint256ExtraBatch(k0, k1, hashes, ns, out);
+}
+
+SaltedUint160Hasher::SaltedUint160Hasher() : k0(GetRand<uint64_t>()), k1(GetRand<uint64_t>()) {}
+
 SaltedSipHasher::SaltedSipHasher() : m_k0(GetRand<uint64_t>()), m_k1(GetRand<uint64_t>()) {}
 
 size_t SaltedSipHasher::operator()(const Span<const unsigned char>& script) const
@@ -27,6 +27,9 @@ public:
     size_t operator()(const uint256& txid) const {
         return SipHashUint256(k0, k1, txid);
     }
+
+    /** The hashes of several txids at once, as operator() gives each, for bulk operations. */
+    void HashBatch(Span<const uint256* const> txids, Span<uint64_t> out) const;
 };
 
 class SaltedOutpointHasher
@@ -50,6 +53,23 @@ public:
     size_t operator()(const COutPoint& id) const noexcept {
         return SipHashUint256Extra(k0, k1, id.hash, id.n);
     }
+
+    /** The hashes of several outpoints at once, as operator() gives each, for bulk operations. */
+    void HashBatch(Span<const COutPoint> ids, Span<uint64_t> out) const;
+};
+
+class SaltedUint160Hasher
+{
+private:
+    /** Salt */
+    const uint64_t k0, k1;
+
+public:
+    SaltedUint160Hasher();
+
+    size_t operator()(const uint160& hash) const noexcept {
+        return CSipHasher(k0, k1).Write(hash.begin(), hash.size()).Finalize();
+    }
 };
 
 struct FilterHeaderHasher
@@ -11,9 +11,12 @@
 #include <util/threadinterrupt.h>
 #include <util/time.h>
 
+#include <array>
+#include <cassert>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #ifdef WIN32
 #include <codecvt>
@@ -24,6 +27,14 @@
 #include <poll.h>
 #endif
 
+#if defined(__linux__)
+#define USE_EPOLL
+#include <sys/epoll.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+#define USE_KQUEUE
+#include <sys/event.h>
+#endif
+
 static inline bool IOErrorIsPermanent(int err)
 {
     return err != WSAEAGAIN && err != WSAEINTR && err != WSAEWOULDBLOCK && err != WSAEINPROGRESS;
@@ -56,6 +67,24 @@ ssize_t Sock::Send(const void* data, size_t len, int flags) const
     return send(m_socket, static_cast<const char*>(data), len, flags);
 }
 
+ssize_t Sock::SendMany(Span<const Span<const unsigned char>> buffers, int flags) const
+{
+    if (buffers.empty()) return 0;
+#ifdef WIN32
+    return Send(buffers[0].data(), buffers[0].size(), flags);
+#else
+    std::vector<iovec> iov(buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        iov[i].iov_base = const_cast<unsigned char*>(buffers[i].data());
+        iov[i].iov_len = buffers[i].size();
+    }
+    msghdr msg{};
+    msg.msg_iov = iov.data();
+    msg.msg_iovlen = iov.size();
+    return sendmsg(m_socket, &msg, flags);
+#endif
+}
+
 ssize_t Sock::Recv(void* buf, size_t len, int flags) const
 {
     return recv(m_socket, static_cast<char*>(buf), len, flags);
@@ -416,6 +445,160 @@ void Sock::Close()
     m_socket = INVALID_SOCKET;
 }
 
+std::optional<SocketEventsMode> SocketEventsModeFromString(const std::string& str)
+{
+    if (str == "poll") return SocketEventsMode::POLL;
+    if (str == "epoll") return SocketEventsMode::EPOLL;
+    if (str == "kqueue") return SocketEventsMode::KQUEUE;
+    return std::nullopt;
+}
+
+bool SocketEventsModeAvailable(SocketEventsMode mode)
+{
+    switch (mode) {
+    case SocketEventsMode::POLL:
+        return true;
+    case SocketEventsMode::EPOLL:
+#ifdef USE_EPOLL
+        return true;
+#else
+        return false;
+#endif
+    case SocketEventsMode::KQUEUE:
+#ifdef USE_KQUEUE
+        return true;
+#else
+        return false;
+#endif
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+namespace {
+/** Most events returned from one call into the kernel, more are returned by the next. */
+constexpr int MAX_EVENTS_PER_WAIT{1024};
+
+#ifdef USE_EPOLL
+class EpollSockEvents final : public SockEvents
+{
+public:
+    explicit EpollSockEvents(int fd) : m_fd{fd} {}
+    ~EpollSockEvents() override { close(m_fd); }
+
+    bool Add(const Sock& sock, uint64_t key, bool edge_triggered) override
+    {
+        epoll_event ev{};
+        ev.events = edge_triggered ? (EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET) : EPOLLIN;
+        ev.data.u64 = key;
+        return epoll_ctl(m_fd, EPOLL_CTL_ADD, sock.Get(), &ev) == 0;
+    }
+
+    bool Wait(std::chrono::milliseconds timeout,
+              std::vector<std::pair<uint64_t, Sock::Event>>& occurred) override
+    {
+        occurred.clear();
+        std::array<epoll_event, MAX_EVENTS_PER_WAIT> evs;
+        const int n{epoll_wait(m_fd, evs.data(), evs.size(), static_cast<int>(count_milliseconds(timeout)))};
+        if (n < 0) {
+            return errno == EINTR;
+        }
+        for (int i = 0; i < n; ++i) {
+            Sock::Event event{0};
+            if (evs[i].events & (EPOLLIN | EPOLLRDHUP)) event |= Sock::RECV;
+            if (evs[i].events & EPOLLOUT) event |= Sock::SEND;
+            if (evs[i].events & (EPOLLERR | EPOLLHUP)) event |= Sock::ERR;
+            occurred.emplace_back(uint64_t{evs[i].data.u64}, event);
+        }
+        return true;
+    }
+
+private:
+    const int m_fd;
+};
+#endif // USE_EPOLL
+
+#ifdef USE_KQUEUE
+class KqueueSockEvents final : public SockEvents
+{
+public:
+    explicit KqueueSockEvents(int fd) : m_fd{fd} {}
+    ~KqueueSockEvents() override { close(m_fd); }
+
+    bool Add(const Sock& sock, uint64_t key, bool edge_triggered) override
+    {
+        std::array<struct kevent, 2> changes;
+        int count{0};
+        const uint16_t flags = EV_ADD | (edge_triggered ? EV_CLEAR : 0);
+        using udata_t = decltype(changes[0].udata);
+        EV_SET(&changes[count++], sock.Get(), EVFILT_READ, flags, 0, 0, reinterpret_cast<udata_t>(static_cast<uintptr_t>(key)));
+        if (edge_triggered) {
+            EV_SET(&changes[count++], sock.Get(), EVFILT_WRITE, flags, 0, 0, reinterpret_cast<udata_t>(static_cast<uintptr_t>(key)));
+        }
+        return kevent(m_fd, changes.data(), count, nullptr, 0, nullptr) == 0;
+    }
+
+    bool Wait(std::chrono::milliseconds timeout,
+              std::vector<std::pair<uint64_t, Sock::Event>>& occurred) override
+    {
+        occurred.clear();
+        std::array<struct kevent, MAX_EVENTS_PER_WAIT> evs;
+        const timespec ts{
+            static_cast<time_t>(timeout.count() / 1000),
+            static_cast<long>((timeout.count() % 1000) * 1000000),
+        };
+        const int n{kevent(m_fd, nullptr, 0, evs.data(), evs.size(), &ts)};
+        if (n < 0) {
+            return errno == EINTR;
+        }
+        for (int i = 0; i < n; ++i) {
+            Sock::Event event{0};
+            if (evs[i].filter == EVFILT_READ) event |= Sock::RECV;
+            if (evs[i].filter == EVFILT_WRITE) event |= Sock::SEND;
+            if (evs[i].flags & (EV_EOF | EV_ERROR)) event |= Sock::ERR;
+            occurred.emplace_back(reinterpret_cast<uintptr_t>(evs[i].udata), event);
+        }
+        return true;
+    }
+
+private:
+    const int m_fd;
+};
+#endif // USE_KQUEUE
+} // namespace
+
+std::unique_ptr<SockEvents> SockEvents::Make(SocketEventsMode mode)
+{
+    switch (mode) {
+    case SocketEventsMode::POLL:
+        return nullptr;
+    case SocketEventsMode::EPOLL: {
+#ifdef USE_EPOLL
+        const int fd{epoll_create1(EPOLL_CLOEXEC)};
+        if (fd < 0) {
+            LogPrintf("Error creating epoll instance: %s\n", SysErrorString(errno));
+            return nullptr;
+        }
+        return std::make_unique<EpollSockEvents>(fd);
+#else
+        return nullptr;
+#endif
+    }
+    case SocketEventsMode::KQUEUE: {
+#ifdef USE_KQUEUE
+        const int fd{kqueue()};
+        if (fd < 0) {
+            LogPrintf("Error creating kqueue instance: %s\n", SysErrorString(errno));
+            return nullptr;
+        }
+        return std::make_unique<KqueueSockEvents>(fd);
+#else
+        return nullptr;
+#endif
+    }
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
 #ifdef WIN32
 std::string NetworkErrorString(int err)
 {
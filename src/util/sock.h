@@ -6,13 +6,17 @@
 #define BITCOIN_UTIL_SOCK_H
 
 #include <compat/compat.h>
+#include <span.h>
 #include <util/threadinterrupt.h>
 #include <util/time.h>
 
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 /**
  * Maximum time to wait for I/O readiness.
@@ -74,6 +78,14 @@ public:
      */
     [[nodiscard]] virtual ssize_t Send(const void* data, size_t len, int flags) const;
 
+    /**
+     * sendmsg(2) wrapper gathering the buffers into one call. Where that is not available, only
+     * the first buffer is sent, as a short send. Returns what send(2) would for their total.
+     * Code that uses this wrapper can be unit tested if this method is overridden by a mock
+     * Sock implementation.
+     */
+    [[nodiscard]] virtual ssize_t SendMany(Span<const Span<const unsigned char>> buffers, int flags) const;
+
     /**
      * recv(2) wrapper. Equivalent to `recv(this->Get(), buf, len, flags);`. Code that uses this
      * wrapper can be unit tested if this method is overridden by a mock Sock implementation.
@@ -279,6 +291,61 @@ private:
     void Close();
 };
 
+/** How the sockets of the connections are checked for readiness, see `-socketevents`. */
+enum class SocketEventsMode {
+    /** Rebuild the set of sockets and `poll(2)` (or `select(2)`) them on each iteration */
+    POLL,
+    /** Keep the sockets registered with an epoll(7) instance (Linux) */
+    EPOLL,
+    /** Keep the sockets registered with a kqueue(2) instance (BSD and macOS) */
+    KQUEUE,
+};
+
+/** Parse a `-socketevents` value, std::nullopt if unknown. */
+std::optional<SocketEventsMode> SocketEventsModeFromString(const std::string& str);
+
+/** Whether the mode is supported on this platform. */
+bool SocketEventsModeAvailable(SocketEventsMode mode);
+
+/**
+ * Persistent registrations of many sockets with the kernel, so that waiting for them does not
+ * cost a pass over all of them as `Sock::WaitMany()` does. A socket is deregistered when it is
+ * closed.
+ */
+class SockEvents
+{
+public:
+    virtual ~SockEvents() = default;
+
+    /**
+     * Create the backend for the mode.
+     * @return nullptr for `SocketEventsMode::POLL`, if the mode is not available on this
+     * platform, or if the kernel object could not be created
+     */
+    static std::unique_ptr<SockEvents> Make(SocketEventsMode mode);
+
+    /**
+     * Register a socket.
+     * @param[in] sock The socket, it must outlive its registration or be closed before.
+     * @param[in] key Returned with the events of this socket by `Wait()`.
+     * @param[in] edge_triggered If true, then `RECV` and `SEND` are reported once each time the
+     * socket becomes readable or writable, the caller has to keep track of the readiness until
+     * a call would block. Otherwise only `RECV` is reported, for as long as the socket is readable.
+     * @return true on success
+     */
+    [[nodiscard]] virtual bool Add(const Sock& sock, uint64_t key, bool edge_triggered) = 0;
+
+    /**
+     * Wait for events on the registered sockets.
+     * @param[in] timeout Wait this long for at least one event to occur.
+     * @param[out] occurred The keys of the sockets and their events (a bitwise-or of
+     * `Sock::RECV`, `Sock::SEND` and `Sock::ERR`), empty on timeout.
+     * @return true on success (or timeout), false otherwise
+     */
+    [[nodiscard]] virtual bool Wait(std::chrono::milliseconds timeout,
+                                    std::vector<std::pair<uint64_t, Sock::Event>>& occurred) = 0;
+};
+
 /** Return readable error string for a network error code */
 std::string NetworkErrorString(int err);
 
@@ -480,18 +480,22 @@ constexpr std::array<ByteAsHex, 256> CreateByteToHexMap()
 
 } // namespace
 
-std::string HexStr(const Span<const uint8_t> s)
+char* WriteHexStr(const Span<const uint8_t> s, char* out)
 {
-    std::string rv(s.size() * 2, '\0');
     static constexpr auto byte_to_hex = CreateByteToHexMap();
     static_assert(sizeof(byte_to_hex) == 512);
 
-    char* it = rv.data();
     for (uint8_t v : s) {
-        std::memcpy(it, byte_to_hex[v].data(), 2);
-        it += 2;
+        std::memcpy(out, byte_to_hex[v].data(), 2);
+        out += 2;
     }
+    return out;
+}
 
+std::string HexStr(const Span<const uint8_t> s)
+{
+    std::string rv(s.size() * 2, '\0');
+    char* it = WriteHexStr(s, rv.data());
     assert(it == rv.data() + rv.size());
     return rv;
 }
@@ -238,6 +238,13 @@ std::string HexStr(const Span<const uint8_t> s);
 inline std::string HexStr(const Span<const char> s) { return HexStr(MakeUCharSpan(s)); }
 inline std::string HexStr(const Span<const std::byte> s) { return HexStr(MakeUCharSpan(s)); }
 
+/**
+ * Write the lower-case hexadecimal form of a span of bytes to out, which must have room
+ * for 2 * s.size() chars. No terminating NUL is written.
+ * @returns the end of the chars written.
+ */
+char* WriteHexStr(const Span<const uint8_t> s, char* out);
+
 /**
  * Format a paragraph of text to a fixed width, adding spaces for
  * indentation to any added line.
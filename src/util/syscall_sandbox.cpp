@@ -733,7 +733,8 @@ public:
 
     void AllowScheduling()
     {
-        allowed_syscalls.insert(__NR_sched_getaffinity);  // set a thread's CPU affinity mask
+        allowed_syscalls.insert(__NR_sched_getaffinity);  // get a thread's CPU affinity mask
+        allowed_syscalls.insert(__NR_sched_setaffinity);  // set a thread's CPU affinity mask
         allowed_syscalls.insert(__NR_sched_getparam);     // get scheduling parameters
         allowed_syscalls.insert(__NR_sched_getscheduler); // get scheduling policy/parameters
         allowed_syscalls.insert(__NR_sched_setscheduler); // set scheduling policy/parameters
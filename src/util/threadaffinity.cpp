@@ -0,0 +1,197 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/threadaffinity.h>
+
+#include <logging.h>
+#include <sync.h>
+#include <tinyformat.h>
+#include <util/fs.h>
+#include <util/strencodings.h>
+#include <util/string.h>
+#include <util/syserror.h>
+
+#include <algorithm>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace util {
+//! Most CPUs a list may name, as a cpu_set_t holds
+static constexpr int MAX_CPUS{1024};
+
+static GlobalMutex g_placement_mutex;
+static std::vector<ThreadPlacement> g_placements GUARDED_BY(g_placement_mutex);
+static std::vector<PlacedThread> g_placed GUARDED_BY(g_placement_mutex);
+
+const std::vector<std::pair<std::string, std::vector<std::string>>>& ThreadGroups()
+{
+    static const std::vector<std::pair<std::string, std::vector<std::string>>> groups{
+        {"validation", {"scriptch", "loadblk", "val"}},
+        {"stake", {"stake"}},
+        {"net", {"net", "msghand", "msgwork", "opencon", "addcon", "i2paccept"}},
+    };
+    return groups;
+}
+
+std::string ThreadGroup(std::string_view thread_name)
+{
+    for (const auto& [group, threads] : ThreadGroups()) {
+        for (const std::string& thread : threads) {
+            // A pool's threads and the lanes of the validation interface follow the name with a dot
+            if (thread_name == thread || (thread_name.size() > thread.size() && thread_name.substr(0, thread.size()) == thread && thread_name[thread.size()] == '.')) {
+                return group;
+            }
+        }
+    }
+    return {};
+}
+
+std::optional<std::vector<int>> ParseCpuList(std::string_view list)
+{
+    std::vector<int> cpus;
+    for (const std::string& range : SplitString(TrimStringView(list), ',')) {
+        const size_t dash{range.find('-')};
+        const std::optional<int> first{ToIntegral<int>(std::string_view{range}.substr(0, dash))};
+        const std::optional<int> last{dash == std::string::npos ? first : ToIntegral<int>(std::string_view{range}.substr(dash + 1))};
+        if (!first || !last || *first < 0 || *last < *first || *last >= MAX_CPUS) return std::nullopt;
+        for (int cpu = *first; cpu <= *last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    if (cpus.empty()) return std::nullopt;
+    return cpus;
+}
+
+NumaNodes ReadNumaNodes()
+{
+    NumaNodes nodes;
+#ifdef __linux__
+    std::error_code ec;
+    for (fs::directory_iterator it{fs::path{"/sys/devices/system/node"}, ec}; !ec && it != fs::directory_iterator{}; it.increment(ec)) {
+        const std::string name{fs::PathToString(it->path().filename())};
+        const std::optional<int> node{name.rfind("node", 0) == 0 ? ToIntegral<int>(std::string_view{name}.substr(4)) : std::nullopt};
+        std::ifstream file{it->path() / "cpulist"};
+        std::string list;
+        if (!node || !std::getline(file, list)) continue;
+        // A node of memory only has no CPUs
+        if (std::optional<std::vector<int>> cpus{ParseCpuList(list)}) {
+            nodes.emplace(*node, std::move(*cpus));
+        }
+    }
+#endif
+    return nodes;
+}
+
+static void SetPlacement(std::vector<ThreadPlacement>& placements, const std::string& group, std::vector<int> cpus)
+{
+    const auto it{std::find_if(placements.begin(), placements.end(), [&](const ThreadPlacement& p) { return p.group == group; })};
+    if (it != placements.end()) {
+        it->cpus = std::move(cpus);
+    } else {
+        placements.push_back({group, std::move(cpus)});
+    }
+}
+
+bool ParseThreadAffinity(const std::vector<std::string>& values, const NumaNodes& numa_nodes, std::vector<ThreadPlacement>& placements, std::string& error)
+{
+    placements.clear();
+    for (const std::string& value : values) {
+        if (value == "none") {
+            placements.clear();
+            continue;
+        }
+        if (value == "numa") {
+            // On a single node there is no traffic across sockets to save
+            if (numa_nodes.size() < 2) continue;
+            SetPlacement(placements, "validation", numa_nodes.begin()->second);
+            SetPlacement(placements, "net", numa_nodes.rbegin()->second);
+            SetPlacement(placements, "stake", numa_nodes.rbegin()->second);
+            continue;
+        }
+
+        const size_t eq{value.find('=')};
+        const std::string group{value.substr(0, eq)};
+        const auto& groups{ThreadGroups()};
+        if (eq == std::string::npos || std::none_of(groups.begin(), groups.end(), [&](const auto& g) { return g.first == group; })) {
+            error = strprintf("Invalid -threadaffinity value '%s', expected none, numa or <group>=<cpus> with a group of validation, stake or net", value);
+            return false;
+        }
+        const std::string list{value.substr(eq + 1)};
+        std::vector<int> cpus;
+        if (list.rfind("node", 0) == 0) {
+            for (const std::string& node_name : SplitString(list, ',')) {
+                const std::optional<int> node{node_name.rfind("node", 0) == 0 ? ToIntegral<int>(std::string_view{node_name}.substr(4)) : std::nullopt};
+                const auto found{node ? numa_nodes.find(*node) : numa_nodes.end()};
+                if (found == numa_nodes.end()) {
+                    error = strprintf("Invalid -threadaffinity value '%s', %s is not a NUMA node with CPUs of this machine", value, node_name);
+                    return false;
+                }
+                cpus.insert(cpus.end(), found->second.begin(), found->second.end());
+            }
+        } else if (std::optional<std::vector<int>> parsed{ParseCpuList(list)}) {
+            cpus = std::move(*parsed);
+        } else {
+            error = strprintf("Invalid -threadaffinity value '%s', expected a list of CPUs such as 0-3,8", value);
+            return false;
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        SetPlacement(placements, group, std::move(cpus));
+    }
+    return true;
+}
+
+void SetThreadPlacements(std::vector<ThreadPlacement> placements)
+{
+    LOCK(g_placement_mutex);
+    g_placements = std::move(placements);
+}
+
+std::vector<ThreadPlacement> GetThreadPlacements()
+{
+    LOCK(g_placement_mutex);
+    return g_placements;
+}
+
+std::vector<PlacedThread> GetPlacedThreads()
+{
+    LOCK(g_placement_mutex);
+    return g_placed;
+}
+
+void PlaceThread(const std::string& name)
+{
+    const std::string group{ThreadGroup(name)};
+    if (group.empty()) return;
+
+    LOCK(g_placement_mutex);
+    const auto placement{std::find_if(g_placements.begin(), g_placements.end(), [&](const ThreadPlacement& p) { return p.group == group; })};
+    if (placement == g_placements.end()) return;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu : placement->cpus) {
+        CPU_SET(cpu, &set);
+    }
+    if (const int err{pthread_setaffinity_np(pthread_self(), sizeof(set), &set)}) {
+        LogPrintf("Could not pin thread %s to the cores of %s: %s\n", name, group, SysErrorString(err));
+        return;
+    }
+    const auto placed{std::find_if(g_placed.begin(), g_placed.end(), [&](const PlacedThread& t) { return t.name == name; })};
+    if (placed != g_placed.end()) {
+        placed->cpus = placement->cpus;
+    } else {
+        g_placed.push_back({name, group, placement->cpus});
+    }
+#endif
+}
+} // namespace util
@@ -0,0 +1,78 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_THREADAFFINITY_H
+#define BITCOIN_UTIL_THREADAFFINITY_H
+
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util {
+/** The cores the threads of a group are pinned to */
+struct ThreadPlacement {
+    std::string group;
+    std::vector<int> cpus;
+};
+
+/** A thread pinned as it was named */
+struct PlacedThread {
+    std::string name;
+    std::string group;
+    std::vector<int> cpus;
+};
+
+/** CPUs of each NUMA node, by node number. Only Linux tells, elsewhere there are none */
+using NumaNodes = std::map<int, std::vector<int>>;
+
+/**
+ * The groups threads are placed by, each with the names of its threads,
+ * without the number of a thread within a pool:
+ * - validation: script checks, block loading and the validation interface lanes;
+ * - stake: the staking threads;
+ * - net: the socket and message handlers, their workers, and the connection threads.
+ */
+const std::vector<std::pair<std::string, std::vector<std::string>>>& ThreadGroups();
+
+/** The group of a thread by its name, such as "scriptch.3", empty if it has none */
+std::string ThreadGroup(std::string_view thread_name);
+
+/** The NUMA nodes of the machine, from /sys/devices/system/node */
+NumaNodes ReadNumaNodes();
+
+/** Parse a list of CPUs as the kernel writes them, such as "0-3,8". Nothing if malformed */
+std::optional<std::vector<int>> ParseCpuList(std::string_view list);
+
+/**
+ * Parse the -threadaffinity values, in order, each one of:
+ * - "none", to pin nothing;
+ * - "numa", to pin validation to the first NUMA node and the network and stake
+ *   threads to the last, on a machine with more than one;
+ * - "<group>=<cpus>", to pin a group to a list of CPUs, or of NUMA nodes as
+ *   "node1" or "node0,node1".
+ * A later value replaces what an earlier one gave a group.
+ */
+bool ParseThreadAffinity(const std::vector<std::string>& values, const NumaNodes& numa_nodes, std::vector<ThreadPlacement>& placements, std::string& error);
+
+/** Pin the threads named from now on by the placements of their groups */
+void SetThreadPlacements(std::vector<ThreadPlacement> placements);
+
+/** The placements given by SetThreadPlacements */
+std::vector<ThreadPlacement> GetThreadPlacements();
+
+/** The threads pinned so far, a thread named again replacing its entry */
+std::vector<PlacedThread> GetPlacedThreads();
+
+/**
+ * Pin the calling thread to the cores of its group, if placed. Called by
+ * ThreadRename, as every thread of a group is named when it starts. The
+ * memory the thread then touches first comes from its node, its malloc arena
+ * included. Only supported on Linux.
+ */
+void PlaceThread(const std::string& name);
+} // namespace util
+
+#endif // BITCOIN_UTIL_THREADAFFINITY_H
@@ -15,6 +15,7 @@
 #include <pthread_np.h>
 #endif
 
+#include <util/threadaffinity.h>
 #include <util/threadnames.h>
 
 #ifdef HAVE_SYS_PRCTL_H
@@ -59,6 +60,7 @@ static void SetInternalName(std::string name) { }
 void util::ThreadRename(std::string&& name)
 {
     SetThreadName(("b-" + name).c_str());
+    util::PlaceThread(name);
     SetInternalName(std::move(name));
 }
 
@@ -12,6 +12,7 @@ namespace util {
 //! as its system thread name.
 //! @note Do not call this for the main thread, as this will interfere with
 //! UNIX utilities such as top and killall. Use ThreadSetInternalName instead.
+//! The thread is pinned to the cores of its group, see util::PlaceThread.
 void ThreadRename(std::string&&);
 
 //! Set the internal (in-memory) name of the current thread only.
@@ -0,0 +1,141 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
+#include <util/tune.h>
+
+#include <compat/compat.h>
+#include <tinyformat.h>
+#include <util/fs_helpers.h>
+#include <util/getuniquepath.h>
+#include <util/time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#endif
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+//! Written to the data directory to measure the speed of its disk
+static constexpr size_t DISK_PROBE_BYTES{32 << 20};
+static constexpr size_t DISK_PROBE_BLOCK{1 << 20};
+//! Below this, a disk is tuned for as a spinning one whatever the system says
+static constexpr double SLOW_DISK_MIB_PER_S{80};
+
+static uint64_t ProbeRamMiB()
+{
+#ifdef WIN32
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) return status.ullTotalPhys >> 20;
+#elif defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+    const long pages{sysconf(_SC_PHYS_PAGES)};
+    const long page_size{sysconf(_SC_PAGESIZE)};
+    if (pages > 0 && page_size > 0) return (uint64_t(pages) * uint64_t(page_size)) >> 20;
+#endif
+    return 0;
+}
+
+static std::optional<bool> ProbeRotational(const fs::path& datadir)
+{
+#ifdef __linux__
+    // The block device holding datadir, or the disk of the partition holding it
+    struct stat st;
+    if (stat(fs::PathToString(datadir).c_str(), &st) != 0) return std::nullopt;
+    const std::string device{strprintf("/sys/dev/block/%u:%u", major(st.st_dev), minor(st.st_dev))};
+    for (const std::string& path : {device + "/queue/rotational", device + "/../queue/rotational"}) {
+        std::ifstream file{path};
+        int rotational;
+        if (file >> rotational) return rotational != 0;
+    }
+#endif
+    return std::nullopt;
+}
+
+static double ProbeDiskMiBPerSecond(const fs::path& datadir)
+{
+    const fs::path path{GetUniquePath(datadir)};
+    FILE* file{fsbridge::fopen(path, "wb")};
+    if (!file) return 0;
+    const std::vector<char> block(DISK_PROBE_BLOCK, 0x5a);
+    const auto start{SteadyClock::now()};
+    bool ok{true};
+    for (size_t written = 0; ok && written < DISK_PROBE_BYTES; written += block.size()) {
+        ok = fwrite(block.data(), 1, block.size(), file) == block.size();
+    }
+    ok = ok && FileCommit(file);
+    const auto elapsed{SteadyClock::now() - start};
+    fclose(file);
+    fs::remove(path);
+    const double seconds{Ticks<std::chrono::microseconds>(elapsed) / 1e6};
+    if (!ok || seconds <= 0) return 0;
+    return (DISK_PROBE_BYTES >> 20) / seconds;
+}
+
+HardwareProfile ProbeHardware(const fs::path& datadir)
+{
+    HardwareProfile hardware;
+    hardware.cores = std::max(1, int(std::thread::hardware_concurrency()));
+    hardware.ram_mib = ProbeRamMiB();
+    if (fs::is_directory(datadir)) {
+        hardware.rotational = ProbeRotational(datadir);
+        hardware.disk_mib_per_s = ProbeDiskMiBPerSecond(datadir);
+    }
+    return hardware;
+}
+
+std::string HardwareSummary(const HardwareProfile& hardware)
+{
+    std::string summary{strprintf("%d cores", hardware.cores)};
+    if (hardware.ram_mib) summary += strprintf(", %d MiB of memory", hardware.ram_mib);
+    if (hardware.rotational) summary += *hardware.rotational ? ", spinning disk" : ", solid state disk";
+    if (hardware.disk_mib_per_s > 0) summary += strprintf(", disk writes at %.0f MiB/s", hardware.disk_mib_per_s);
+    return summary;
+}
+
+std::vector<std::pair<std::string, std::string>> TunedSettings(const HardwareProfile& hardware)
+{
+    std::vector<std::pair<std::string, std::string>> settings;
+    const auto add{[&](const std::string& name, int64_t value) { settings.emplace_back(name, strprintf("%d", value)); }};
+    const int cores{std::max(1, hardware.cores)};
+    const bool slow_disk{hardware.rotational.value_or(false) ||
+                         (hardware.disk_mib_per_s > 0 && hardware.disk_mib_per_s < SLOW_DISK_MIB_PER_S)};
+
+    if (hardware.ram_mib) {
+        // A quarter of memory for the UTXO cache, a third on slow disks where each miss is a seek,
+        // within -dbcache's range on 64 bit
+        const uint64_t dbcache{hardware.ram_mib / (slow_disk ? 3 : 4)};
+        add("dbcache", std::clamp<uint64_t>(dbcache, 100, 16384));
+        add("maxmempool", hardware.ram_mib < 2048 ? 100 : hardware.ram_mib < 8192 ? 300 : 500);
+        // Peers relay the storage transactions, each connection takes some memory
+        add("maxconnections", hardware.ram_mib < 1024 ? 40 : hardware.ram_mib < 4096 ? 125 : 200);
+    }
+
+    // Script checks use every core, up to -par's most
+    add("par", std::min(cores, 15));
+    add("rpcthreads", std::clamp(cores, 4, 16));
+    // Halve the cores between the thread pools that are busy at once: messages from peers,
+    // storage jobs, and the kernel search of staking. Stake threads only help with more than one wallet
+    add("messageworkers", std::clamp(cores / 2, 1, 16));
+    add("jobthreads", std::clamp(cores / 2, 2, 8));
+    add("stakeworkers", std::clamp(cores / 2, 1, 8));
+    add("stakingthreads", cores >= 8 ? 2 : 1);
+    if (hardware.rotational || hardware.disk_mib_per_s > 0) {
+        // Fetches again of an asset are copied from the cache, not read block by block from the chain
+        add("storagecachesize", slow_disk ? 2048 : 1024);
+    }
+    return settings;
+}
@@ -0,0 +1,41 @@
+// Copyright (c) 2023 Lynx Core Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_TUNE_H
+#define BITCOIN_UTIL_TUNE_H
+
+#include <util/fs.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** The machine a node runs on, as far as its settings are tuned for it. */
+struct HardwareProfile {
+    int cores{1};
+    //! Physical memory, 0 if not found
+    uint64_t ram_mib{0};
+    //! Whether the data directory is on a spinning disk, if the system tells
+    std::optional<bool> rotational;
+    //! Sequential write speed to the data directory, 0 if not measured
+    double disk_mib_per_s{0};
+};
+
+/** Probe the cores and memory of the machine, and the disk of datadir if it exists. */
+HardwareProfile ProbeHardware(const fs::path& datadir);
+
+/** The hardware in a line, for the comment above the settings tuned for it. */
+std::string HardwareSummary(const HardwareProfile& hardware);
+
+/**
+ * Settings, as name and value, of a node running on hardware: the database
+ * cache, script and RPC threads, connections, mempool, and the threads of
+ * staking, storage jobs and message processing. Settings that depend on what
+ * was not found are left out, so they keep their defaults.
+ */
+std::vector<std::pair<std::string, std::string>> TunedSettings(const HardwareProfile& hardware);
+
+#endif // BITCOIN_UTIL_TUNE_H
@@ -18,7 +18,9 @@
 #include <consensus/tx_check.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <crypto/scrypt.h>
 #include <cuckoocache.h>
+#include <dbwrapper.h>
 #include <flatfile.h>
 #include <hash.h>
 #include <kernel/chainparams.h>
@@ -41,7 +43,6 @@
 #include <script/sigcache.h>
 #include <shutdown.h>
 #include <signet.h>
-#include <storage/auth.h>
 #include <tinyformat.h>
 #include <txdb.h>
 #include <txmempool.h>
@@ -52,6 +53,7 @@
 #include <util/fs_helpers.h>
 #include <util/hasher.h>
 #include <util/moneystr.h>
+#include <util/overloaded.h>
 #include <util/rbf.h>
 #include <util/strencodings.h>
 #include <util/system.h>
@@ -81,6 +83,8 @@ using node::BlockManager;
 using node::BlockMap;
 using node::CBlockIndexHeightOnlyComparator;
 using node::CBlockIndexWorkComparator;
+using node::BLOCK_RECORD_COMPRESSED;
+using node::DecompressBlock;
 using node::fReindex;
 using node::ReadBlockFromDisk;
 using node::SnapshotMetadata;
@@ -116,8 +120,6 @@ GlobalMutex g_best_block_mutex;
 std::condition_variable g_best_block_cv;
 uint256 g_best_block;
 
-void ShowAverageSpans(const CBlockIndex* pindex);
-
 const CBlockIndex* Chainstate::FindForkInGlobalIndex(const CBlockLocator& locator) const
 {
     AssertLockHeld(cs_main);
@@ -125,14 +127,13 @@ const CBlockIndex* Chainstate::FindForkInGlobalIndex(const CBlockLocator& locato
     // Find the latest block common to locator and chain - we expect that
     // locator.vHave is sorted descending by height.
     for (const uint256& hash : locator.vHave) {
+        // Most entries are in the chain, found through its own index rather than the block index
+        if (const CBlockIndex* pindex{m_chain.Find(hash)}) {
+            return pindex;
+        }
         const CBlockIndex* pindex{m_blockman.LookupBlockIndex(hash)};
-        if (pindex) {
-            if (m_chain.Contains(pindex)) {
-                return pindex;
-            }
-            if (pindex->GetAncestor(m_chain.Height()) == m_chain.Tip()) {
-                return m_chain.Tip();
-            }
+        if (pindex && pindex->GetAncestor(m_chain.Height()) == m_chain.Tip()) {
+            return m_chain.Tip();
         }
     }
     return m_chain.Genesis();
@@ -141,7 +142,7 @@ const CBlockIndex* Chainstate::FindForkInGlobalIndex(const CBlockLocator& locato
 bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
                        const CCoinsViewCache& inputs, unsigned int flags, bool cacheSigStore,
                        bool cacheFullScriptStore, PrecomputedTransactionData& txdata,
-                       std::vector<CScriptCheck>* pvChecks = nullptr)
+                       std::vector<CBlockCheck>* pvChecks = nullptr)
                        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
 bool CheckFinalTxAtTip(const CBlockIndex& active_chain_tip, const CTransaction& tx)
@@ -656,12 +657,13 @@ private:
                        std::map<const uint256, const MempoolAcceptResult>& results)
          EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
-    // Compare a package's feerate against minimum allowed.
-    bool CheckFeeRate(size_t package_size, CAmount package_fee, TxValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, m_pool.cs)
+    // Compare a package's feerate against minimum allowed. Packages with storage transactions are held
+    // to the storage minimum fee.
+    bool CheckFeeRate(size_t package_size, CAmount package_fee, bool storage, TxValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, m_pool.cs)
     {
         AssertLockHeld(::cs_main);
         AssertLockHeld(m_pool.cs);
-        CAmount mempoolRejectFee = m_pool.GetMinFee().GetFee(package_size);
+        CAmount mempoolRejectFee = (storage ? m_pool.GetStorageMinFee() : m_pool.GetMinFee()).GetFee(package_size);
         if (mempoolRejectFee > 0 && package_fee < mempoolRejectFee) {
             return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "mempool min fee not met", strprintf("%d < %d", package_fee, mempoolRejectFee));
         }
@@ -754,12 +756,26 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     m_view.SetBackend(m_viewmempool);
 
     const CCoinsViewCache& coins_cache = m_active_chainstate.CoinsTip();
-    // do all inputs exist?
     for (const CTxIn& txin : tx.vin) {
         if (!coins_cache.HaveCoinInCache(txin.prevout)) {
             coins_to_uncache.push_back(txin.prevout);
         }
+    }
+    // Fetch the coins of all inputs at once, rather than one database read at a
+    // time below. Like HaveCoin(), this adds them to the coins cache; they are
+    // among coins_to_uncache if they were not there yet.
+    if (tx.vin.size() > 1) {
+        std::vector<COutPoint> prevouts;
+        prevouts.reserve(tx.vin.size());
+        for (const CTxIn& txin : tx.vin) {
+            prevouts.push_back(txin.prevout);
+        }
+        std::vector<std::optional<Coin>> coins;
+        m_view.GetCoins(prevouts, coins);
+    }
 
+    // do all inputs exist?
+    for (const CTxIn& txin : tx.vin) {
         // Note: this call may add txin.prevout to the coins cache
         // (coins_cache.cacheCoins) by way of FetchCoin(). It should be removed
         // later (via coins_to_uncache) if this tx turns out to be invalid.
@@ -839,7 +855,7 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     // No individual transactions are allowed below the min relay feerate and mempool min feerate except from
     // disconnected blocks and transactions in a package. Package transactions will be checked using
     // package feerate later.
-    if (!bypass_limits && !args.m_package_feerates && !CheckFeeRate(ws.m_vsize, ws.m_modified_fees, state)) return false;
+    if (!bypass_limits && !args.m_package_feerates && !CheckFeeRate(ws.m_vsize, ws.m_modified_fees, entry->IsStorage(), state)) return false;
 
     ws.m_iters_conflicting = m_pool.GetIterSet(ws.m_conflicts);
     // Calculate in-mempool ancestors, up to a limit.
@@ -878,7 +894,7 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
         m_limits.descendant_size_vbytes += conflict->GetSizeWithDescendants();
     }
 
-    auto ancestors{m_pool.CalculateMemPoolAncestors(*entry, m_limits)};
+    auto ancestors{m_pool.CalculateMemPoolAncestors(*entry, entry->IsStorage() ? m_limits.ForStorage() : m_limits)};
     if (!ancestors) {
         // If CalculateMemPoolAncestors fails second time, we want the original error string.
         // Contracting/payment channels CPFP carve-out:
@@ -978,8 +994,9 @@ bool MemPoolAccept::PackageMempoolChecks(const std::vector<CTransactionRef>& txn
     assert(std::all_of(txns.cbegin(), txns.cend(), [this](const auto& tx)
                        { return !m_pool.exists(GenTxid::Txid(tx->GetHash()));}));
 
+    const bool storage = std::any_of(txns.cbegin(), txns.cend(), [](const auto& tx) { return IsStorageTx(*tx); });
     std::string err_string;
-    if (!m_pool.CheckPackageLimits(txns, m_limits, err_string)) {
+    if (!m_pool.CheckPackageLimits(txns, storage ? m_limits.ForStorage() : m_limits, err_string)) {
         // This is a package-wide error, separate from an individual transaction error.
         return package_state.Invalid(PackageValidationResult::PCKG_POLICY, "package-mempool-limits", err_string);
     }
@@ -1132,7 +1149,7 @@ bool MemPoolAccept::SubmitPackage(const ATMPArgs& args, std::vector<Workspace>&
         // Re-calculate mempool ancestors to call addUnchecked(). They may have changed since the
         // last calculation done in PreChecks, since package ancestors have already been submitted.
         {
-            auto ancestors{m_pool.CalculateMemPoolAncestors(*ws.m_entry, m_limits)};
+            auto ancestors{m_pool.CalculateMemPoolAncestors(*ws.m_entry, ws.m_entry->IsStorage() ? m_limits.ForStorage() : m_limits)};
             if(!ancestors) {
                 results.emplace(ws.m_ptx->GetWitnessHash(), MempoolAcceptResult::Failure(ws.m_state));
                 // Since PreChecks() and PackageMempoolChecks() both enforce limits, this should never fail.
@@ -1261,9 +1278,11 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
     const auto m_total_modified_fees = std::accumulate(workspaces.cbegin(), workspaces.cend(), CAmount{0},
         [](CAmount sum, auto& ws) { return sum + ws.m_modified_fees; });
     const CFeeRate package_feerate(m_total_modified_fees, m_total_vsize);
+    const bool package_storage = std::any_of(workspaces.cbegin(), workspaces.cend(),
+        [](const auto& ws) { return ws.m_entry->IsStorage(); });
     TxValidationState placeholder_state;
     if (args.m_package_feerates &&
-        !CheckFeeRate(m_total_vsize, m_total_modified_fees, placeholder_state)) {
+        !CheckFeeRate(m_total_vsize, m_total_modified_fees, package_storage, placeholder_state)) {
         package_state.Invalid(PackageValidationResult::PCKG_POLICY, "package-fee-too-low");
         return PackageMempoolAcceptResult(package_state, {});
     }
@@ -1709,13 +1728,14 @@ CAmount GetProofOfStakeReward(int nHeight, const Consensus::Params& params)
 }
 
 CoinsViews::CoinsViews(DBParams db_params, CoinsViewOptions options)
-    : m_dbview{std::move(db_params), std::move(options)},
-      m_catcherview(&m_dbview) {}
+    : m_dbview{std::move(db_params), options},
+      m_catcherview(&m_dbview),
+      m_flushview(&m_catcherview, options.background_flush) {}
 
 void CoinsViews::InitCache()
 {
     AssertLockHeld(::cs_main);
-    m_cacheview = std::make_unique<CCoinsViewCache>(&m_catcherview);
+    m_cacheview = std::make_unique<CCoinsViewCache>(&m_flushview);
 }
 
 Chainstate::Chainstate(
@@ -1884,8 +1904,9 @@ bool CScriptCheck::operator()() {
 
 static CuckooCache::cache<uint256, SignatureCacheHasher> g_scriptExecutionCache;
 static CSHA256 g_scriptExecutionCacheHasher;
+static ValidationCacheCounters g_scriptExecutionCacheCounters;
 
-bool InitScriptExecutionCache(size_t max_size_bytes)
+bool InitScriptExecutionCache(size_t max_size_bytes, size_t max_grow_bytes)
 {
     // Setup the salted hasher
     uint256 nonce = GetRandHash();
@@ -1899,11 +1920,17 @@ bool InitScriptExecutionCache(size_t max_size_bytes)
     if (!setup_results) return false;
 
     const auto [num_elems, approx_size_bytes] = *setup_results;
+    g_scriptExecutionCacheCounters.Setup(num_elems, approx_size_bytes, std::max(max_size_bytes, max_grow_bytes));
     LogPrintf("Using %zu MiB out of %zu MiB requested for script execution cache, able to store %zu elements\n",
               approx_size_bytes >> 20, max_size_bytes >> 20, num_elems);
     return true;
 }
 
+ValidationCacheStats GetScriptExecutionCacheStats()
+{
+    return g_scriptExecutionCacheCounters.GetStats();
+}
+
 /**
  * Check whether all of this transaction's input scripts succeed.
  *
@@ -1926,7 +1953,7 @@ bool InitScriptExecutionCache(size_t max_size_bytes)
 bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
                        const CCoinsViewCache& inputs, unsigned int flags, bool cacheSigStore,
                        bool cacheFullScriptStore, PrecomputedTransactionData& txdata,
-                       std::vector<CScriptCheck>* pvChecks)
+                       std::vector<CBlockCheck>* pvChecks)
 {
     if (tx.IsCoinBase()) return true;
 
@@ -1943,7 +1970,9 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
     CSHA256 hasher = g_scriptExecutionCacheHasher;
     hasher.Write(tx.GetWitnessHash().begin(), 32).Write((unsigned char*)&flags, sizeof(flags)).Finalize(hashCacheEntry.begin());
     AssertLockHeld(cs_main); //TODO: Remove this requirement by making CuckooCache not require external locks
-    if (g_scriptExecutionCache.contains(hashCacheEntry, !cacheFullScriptStore)) {
+    const bool cached{g_scriptExecutionCache.contains(hashCacheEntry, !cacheFullScriptStore)};
+    g_scriptExecutionCacheCounters.Lookup(cached);
+    if (cached) {
         return true;
     }
 
@@ -2004,7 +2033,12 @@ bool CheckInputScripts(const CTransaction& tx, TxValidationState& state,
     if (cacheFullScriptStore && !pvChecks) {
         // We executed all of the provided scripts, and were told to
         // cache the result. Do so now.
-        g_scriptExecutionCache.insert(hashCacheEntry);
+        if (const auto grow_bytes{g_scriptExecutionCacheCounters.Insert(g_scriptExecutionCache.insert(hashCacheEntry))}) {
+            if (const auto resized{g_scriptExecutionCache.resize_bytes(*grow_bytes)}) {
+                g_scriptExecutionCacheCounters.Resized(resized->first, resized->second);
+                LogPrint(BCLog::VALIDATION, "Script execution cache grown to %zu MiB under eviction pressure\n", resized->second >> 20);
+            }
+        }
     }
 
     return true;
@@ -2052,15 +2086,40 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
+void Chainstate::PrefetchUndo(const CBlockIndex* pindexFork)
+{
+    AssertLockHeld(cs_main);
+    m_undo_prefetch.clear();
+    for (const CBlockIndex* pindex = m_chain.Tip(); pindex && pindex != pindexFork && pindex->pprev && m_undo_prefetch.size() < node::UNDO_PREFETCH_BLOCKS; pindex = pindex->pprev) {
+        m_undo_prefetch.emplace(pindex, std::async(std::launch::async, [pos = pindex->GetUndoPos(), hash_prev = pindex->pprev->GetBlockHash()] {
+            std::optional<CBlockUndo> undo{CBlockUndo{}};
+            if (!UndoReadFromDisk(*undo, pos, hash_prev)) undo.reset();
+            return undo;
+        }));
+    }
+}
+
+bool Chainstate::TakePrefetchedUndo(const CBlockIndex* pindex, CBlockUndo& blockundo)
+{
+    AssertLockHeld(cs_main);
+    const auto it{m_undo_prefetch.find(pindex)};
+    if (it == m_undo_prefetch.end()) return false;
+    std::optional<CBlockUndo> undo{it->second.get()};
+    m_undo_prefetch.erase(it);
+    if (!undo) return false;
+    blockundo = std::move(*undo);
+    return true;
+}
+
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
  *  When FAILED is returned, view is left in an indeterminate state. */
-DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
+DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, CBlockUndo* undo_out)
 {
     AssertLockHeld(::cs_main);
     bool fClean = true;
 
     CBlockUndo blockUndo;
-    if (!UndoReadFromDisk(blockUndo, pindex)) {
+    if (!TakePrefetchedUndo(pindex, blockUndo) && !UndoReadFromDisk(blockUndo, pindex)) {
         error("DisconnectBlock(): failure reading undo data");
         return DISCONNECT_FAILED;
     }
@@ -2069,6 +2128,8 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
         error("DisconnectBlock(): block and undo data inconsistent");
         return DISCONNECT_FAILED;
     }
+    // Copied before the coins are moved out of it below
+    if (undo_out) *undo_out = blockUndo;
 
     // Ignore blocks that contain transactions which are 'overwritten' by later transactions,
     // unless those are already completely spent.
@@ -2126,7 +2187,7 @@ DisconnectResult Chainstate::DisconnectBlock(const CBlock& block, const CBlockIn
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+static CCheckQueue<CBlockCheck> scriptcheckqueue(128);
 
 void StartScriptCheckWorkerThreads(int threads_num)
 {
@@ -2138,6 +2199,43 @@ void StopScriptCheckWorkerThreads()
     scriptcheckqueue.StopWorkerThreads();
 }
 
+void PrecheckTransactionScripts(Chainstate& active_chainstate, const CTxMemPool& pool, const std::vector<CTransactionRef>& txs)
+{
+    if (!scriptcheckqueue.HasThreads()) return;
+
+    // Gather the coins spent while holding the locks, verify without them
+    std::vector<PrecomputedTransactionData> txdata(txs.size());
+    std::vector<CBlockCheck> checks;
+    {
+        LOCK2(::cs_main, pool.cs);
+        CCoinsViewMemPool view{&active_chainstate.CoinsTip(), pool};
+        for (size_t i = 0; i < txs.size(); ++i) {
+            const CTransaction& tx{*txs[i]};
+            std::vector<CTxOut> spent_outputs;
+            spent_outputs.reserve(tx.vin.size());
+            for (const CTxIn& txin : tx.vin) {
+                Coin coin;
+                if (!view.GetCoin(txin.prevout, coin)) break;
+                spent_outputs.push_back(std::move(coin.out));
+            }
+            view.PackageAddTransaction(txs[i]);
+            // Spends something missing, accepting it fails anyway
+            if (spent_outputs.size() != tx.vin.size()) continue;
+
+            txdata[i].Init(tx, std::vector<CTxOut>{spent_outputs});
+            for (unsigned int n = 0; n < tx.vin.size(); ++n) {
+                checks.emplace_back(CScriptCheck{spent_outputs[n], tx, n, STANDARD_SCRIPT_VERIFY_FLAGS, /*cacheIn=*/true, &txdata[i]});
+            }
+        }
+    }
+
+    // Failing checks are left for accepting to report, though the queue
+    // skips the remaining checks after the first failure
+    CCheckQueueControl<CBlockCheck> control(&scriptcheckqueue);
+    control.Add(std::move(checks));
+    control.Wait();
+}
+
 /**
  * Threshold condition checker that triggers when unknown versionbits are seen on the network.
  */
@@ -2216,6 +2314,68 @@ static SteadyClock::duration time_undo{};
 static SteadyClock::duration time_index{};
 static SteadyClock::duration time_total{};
 static int64_t num_blocks_total = 0;
+static SteadyClock::duration time_read_from_disk_total{};
+static SteadyClock::duration time_connect_total{};
+static SteadyClock::duration time_flush{};
+static SteadyClock::duration time_chainstate{};
+static SteadyClock::duration time_post_connect{};
+
+static GlobalMutex g_block_connect_stats_mutex;
+static BlockConnectStats g_block_connect_stats GUARDED_BY(g_block_connect_stats_mutex);
+
+/** Publish the block connection times and the state of the coins cache for GetBlockConnectStats() */
+static void PublishBlockConnectStats(CCoinsViewCache& coins_tip) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    BlockConnectStats stats;
+    stats.blocks = num_blocks_total;
+    stats.load_block = time_read_from_disk_total;
+    stats.check = time_check;
+    stats.forks = time_forks;
+    stats.connect = time_connect;
+    stats.verify = time_verify;
+    stats.undo = time_undo;
+    stats.index = time_index;
+    stats.connect_total = time_connect_total;
+    stats.flush = time_flush;
+    stats.chainstate = time_chainstate;
+    stats.post_connect = time_post_connect;
+    stats.total = time_total;
+    stats.coins_cache_count = coins_tip.GetCacheSize();
+    stats.coins_cache_usage = coins_tip.DynamicMemoryUsage();
+    LOCK(g_block_connect_stats_mutex);
+    g_block_connect_stats = stats;
+}
+
+BlockConnectStats GetBlockConnectStats()
+{
+    LOCK(g_block_connect_stats_mutex);
+    return g_block_connect_stats;
+}
+
+static GlobalMutex g_block_validation_times_mutex;
+//! The latest blocks connected to the active chain, the latest last
+static std::deque<BlockValidationTimes> g_block_validation_times GUARDED_BY(g_block_validation_times_mutex);
+//! Times of the block ConnectTip() is connecting, partly filled in by ConnectBlock()
+static BlockValidationTimes g_connecting_block_times GUARDED_BY(cs_main);
+
+std::vector<BlockValidationTimes> GetBlockValidationTimes(size_t count)
+{
+    LOCK(g_block_validation_times_mutex);
+    count = std::min(count, g_block_validation_times.size());
+    return {g_block_validation_times.rbegin(), g_block_validation_times.rbegin() + count};
+}
+
+void RecordBlockAuthTime(const uint256& block_hash, SteadyClock::duration time)
+{
+    LOCK(g_block_validation_times_mutex);
+    // The authList follows the tip, so the block is almost always the latest
+    for (auto it = g_block_validation_times.rbegin(); it != g_block_validation_times.rend(); ++it) {
+        if (it->hash == block_hash) {
+            it->auth = time;
+            return;
+        }
+    }
+}
 
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
@@ -2228,7 +2388,8 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     uint256 block_hash{block.GetHash()};
     assert(*pindex->phashBlock == block_hash);
-    const bool parallel_script_checks{scriptcheckqueue.HasThreads()};
+    // The few signatures of a block of only the coinbase and coinstake are verified inline
+    const bool parallel_script_checks{scriptcheckqueue.HasThreads() && !IsCoinStakeOnlyBlock(block)};
 
     const auto time_start{SteadyClock::now()};
     const CChainParams& params{m_chainman.GetParams()};
@@ -2246,7 +2407,12 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // is enforced in ContextualCheckBlockHeader(); we wouldn't want to
     // re-enforce that rule here (at least until we make it impossible for
     // m_adjusted_time_callback() to go backward).
-    if (!CheckBlock(block, state, params.GetConsensus(), !fJustCheck, !fJustCheck)) {
+    // With worker threads, the signatures of a proof-of-stake block are left to the
+    // check queue, to be verified alongside the input scripts. Blocks only being
+    // checked keep verifying them inline, which fills the stake kernel cache.
+    const bool parallel_pos_checks{parallel_script_checks && !fJustCheck};
+    std::vector<CBlockCheck> vPoSChecks;
+    if (!CheckBlock(block, state, params.GetConsensus(), !fJustCheck, !fJustCheck, parallel_pos_checks ? &vPoSChecks : nullptr)) {
         if (state.GetResult() == BlockValidationResult::BLOCK_MUTATED) {
             // We don't write down blocks to disk if they may have been
             // corrupted, so this should be impossible unless we're having hardware
@@ -2269,9 +2435,13 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
         m_blockman.m_dirty_blockindex.insert(pindex);
 
         uint256 targetProofOfStake;
-        if (!CheckProofOfStake(*this, state, pindex->pprev, *block.vtx[1], block.nTime, block.nBits, pindex->hashProof, targetProofOfStake)) {
+        std::vector<CStakeSignatureCheck> vStakeChecks;
+        const auto time_stake{SteadyClock::now()};
+        if (!CheckProofOfStake(*this, state, pindex->pprev, *block.vtx[1], block.nTime, block.nBits, pindex->hashProof, targetProofOfStake, parallel_pos_checks ? &vStakeChecks : nullptr)) {
             return error("%s: Check proof of stake failed.", __func__);
         }
+        g_connecting_block_times.stake = SteadyClock::now() - time_stake;
+        std::move(vStakeChecks.begin(), vStakeChecks.end(), std::back_inserter(vPoSChecks));
     }
 
     // verify that the view's current state corresponds to the previous block
@@ -2321,6 +2491,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     const auto time_1{SteadyClock::now()};
     time_check += time_1 - time_start;
+    g_connecting_block_times.check = time_1 - time_start;
     LogPrint(BCLog::BENCH, "    - Sanity checks: %.2fms [%.2fs (%.2fms/blk)]\n",
              Ticks<MillisecondsDouble>(time_1 - time_start),
              Ticks<SecondsDouble>(time_check),
@@ -2423,6 +2594,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     const auto time_2{SteadyClock::now()};
     time_forks += time_2 - time_1;
+    g_connecting_block_times.forks = time_2 - time_1;
     LogPrint(BCLog::BENCH, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n",
              Ticks<MillisecondsDouble>(time_2 - time_1),
              Ticks<SecondsDouble>(time_forks),
@@ -2435,8 +2607,15 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // in multiple threads). Preallocate the vector size so a new allocation
     // doesn't invalidate pointers into the vector, and keep txsdata in scope
     // for as long as `control`.
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && parallel_script_checks ? &scriptcheckqueue : nullptr);
+    BlockCheckFailure check_failure;
+    CCheckQueueControl<CBlockCheck> control((fScriptChecks || !vPoSChecks.empty()) && parallel_script_checks ? &scriptcheckqueue : nullptr);
     std::vector<PrecomputedTransactionData> txsdata(block.vtx.size());
+    for (CBlockCheck& check : vPoSChecks) {
+        check.ReportTo(check_failure);
+    }
+    control.Add(std::move(vPoSChecks));
+    // Holds the script checks of one transaction at a time, until the queue takes them
+    std::vector<CBlockCheck> vChecks;
 
     std::vector<int> prevheights;
     CAmount nFees = 0;
@@ -2452,23 +2631,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     {
         const CTransaction &tx = *(block.vtx[i]);
 
-        // process authdata in op_return here
-        if (!tx.IsCoinBase() && !tx.IsCoinStake()) {
-            for (unsigned int vout = 0; vout < tx.vout.size(); vout++) {
-                const CScript opreturn_out = tx.vout[vout].scriptPubKey;
-                if (opreturn_out.IsOpReturn()) {
-                    int error_level;
-                    if (!is_opreturn_an_authdata(opreturn_out, error_level)) {
-                        continue;
-                    }
-                    if (!found_opreturn_in_authdata(opreturn_out, error_level)) {
-                        LogPrintf("invalid authdata message in tx %s vout %d\n", tx.GetHash().ToString(), vout);
-                    } else {
-                        LogPrintf("valid authdata message in tx %s vout %d\n", tx.GetHash().ToString(), vout);
-                    }
-                }
-            }
-        }
+        // authdata in op_return is processed by AuthListSync once the block is connected
 
         nInputs += tx.vin.size();
 
@@ -2520,7 +2683,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
         if (!tx.IsCoinBase())
         {
-            std::vector<CScriptCheck> vChecks;
+            vChecks.clear();
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
             TxValidationState tx_state;
             if (fScriptChecks && !CheckInputScripts(tx, tx_state, view, flags, fCacheResults, fCacheResults, txsdata[i], parallel_script_checks ? &vChecks : nullptr)) {
@@ -2541,6 +2704,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
     }
     const auto time_3{SteadyClock::now()};
     time_connect += time_3 - time_2;
+    g_connecting_block_times.connect = time_3 - time_2;
     LogPrint(BCLog::BENCH, "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs (%.2fms/blk)]\n", (unsigned)block.vtx.size(),
              Ticks<MillisecondsDouble>(time_3 - time_2), Ticks<MillisecondsDouble>(time_3 - time_2) / block.vtx.size(),
              nInputs <= 1 ? 0 : Ticks<MillisecondsDouble>(time_3 - time_2) / (nInputs - 1),
@@ -2568,10 +2732,11 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     if (!control.Wait()) {
         LogPrintf("ERROR: %s: CheckQueue failed\n", __func__);
-        return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "block-validation-failed");
+        return check_failure.Invalid(state);
     }
     const auto time_4{SteadyClock::now()};
     time_verify += time_4 - time_2;
+    g_connecting_block_times.verify = time_4 - time_2;
     LogPrint(BCLog::BENCH, "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n", nInputs - 1,
              Ticks<MillisecondsDouble>(time_4 - time_2),
              nInputs <= 1 ? 0 : Ticks<MillisecondsDouble>(time_4 - time_2) / (nInputs - 1),
@@ -2587,6 +2752,7 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     const auto time_5{SteadyClock::now()};
     time_undo += time_5 - time_4;
+    g_connecting_block_times.undo = time_5 - time_4;
     LogPrint(BCLog::BENCH, "    - Write undo data: %.2fms [%.2fs (%.2fms/blk)]\n",
              Ticks<MillisecondsDouble>(time_5 - time_4),
              Ticks<SecondsDouble>(time_undo),
@@ -2602,6 +2768,14 @@ bool Chainstate::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     const auto time_6{SteadyClock::now()};
     time_index += time_6 - time_5;
+    g_connecting_block_times.index = time_6 - time_5;
+    g_connecting_block_times.hash = block_hash;
+    g_connecting_block_times.height = pindex->nHeight;
+    g_connecting_block_times.proof_of_stake = block.IsProofOfStake();
+    g_connecting_block_times.size = ::GetSerializeSize(block, PROTOCOL_VERSION);
+    g_connecting_block_times.txs = block.vtx.size();
+    g_connecting_block_times.inputs = nInputs;
+    g_connecting_block_times.storage_txs = std::count_if(block.vtx.begin(), block.vtx.end(), [](const auto& tx) { return IsStorageTx(*tx); });
     LogPrint(BCLog::BENCH, "    - Index writing: %.2fms [%.2fs (%.2fms/blk)]\n",
              Ticks<MillisecondsDouble>(time_6 - time_5),
              Ticks<SecondsDouble>(time_index),
@@ -2624,7 +2798,7 @@ CoinsCacheSizeState Chainstate::GetCoinsCacheSizeState()
     AssertLockHeld(::cs_main);
     return this->GetCoinsCacheSizeState(
         m_coinstip_cache_size_bytes,
-        m_mempool ? m_mempool->m_max_size_bytes : 0);
+        m_mempool ? m_mempool->m_max_size_bytes.load() : 0);
 }
 
 CoinsCacheSizeState Chainstate::GetCoinsCacheSizeState(
@@ -2770,7 +2944,11 @@ bool Chainstate::FlushStateToDisk(
                 return AbortNode(state, "Disk space is too low!", _("Disk space is too low!"));
             }
             // Flush the chainstate (which may refer to block index entries).
-            if (!CoinsTip().Flush())
+            // Unless it must be on disk when we return, or pruned blocks might
+            // be needed to replay an interrupted write, write it in the background.
+            const bool wait{mode == FlushStateMode::ALWAYS || fFlushForPrune};
+            if (!wait) m_coins_views->m_flushview.DeferNextWrite();
+            if (!CoinsTip().Flush() || (wait && !m_coins_views->m_flushview.Wait()))
                 return AbortNode(state, "Failed to write to coin database");
             m_last_flush = nNow;
             full_flush_completed = true;
@@ -2785,6 +2963,7 @@ bool Chainstate::FlushStateToDisk(
     if (full_flush_completed) {
         // Update best block in wallet (so we can detect restored wallets).
         GetMainSignals().ChainStateFlushed(m_chain.GetLocator());
+        if (this == &m_chainman.ActiveChainstate()) PublishBlockConnectStats(CoinsTip());
     }
     } catch (const std::runtime_error& e) {
         return AbortNode(state, std::string("System error while flushing: ") + e.what());
@@ -2870,6 +3049,9 @@ void Chainstate::UpdateTip(const CBlockIndex* pindexNew)
         m_mempool->AddTransactionsUpdated(1);
     }
 
+    m_block_time_stats.SetTip(pindexNew);
+    m_chainman.PublishTip(pindexNew);
+
     {
         LOCK(g_best_block_mutex);
         g_best_block = pindexNew->GetBlockHash();
@@ -2899,7 +3081,7 @@ void Chainstate::UpdateTip(const CBlockIndex* pindexNew)
     // so we are reducing the amount of output to the debug log.
     if (!this->IsInitialBlockDownload()){
         if (this->spansShown % 25 == 0) {
-            ShowAverageSpans(pindexNew);
+            ShowAverageSpans(m_block_time_stats);
         }
         this->spansShown++;
     }
@@ -2931,10 +3113,13 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
     }
     // Apply the block atomically to the chain state.
     const auto time_start{SteadyClock::now()};
+    // Kept for the indexes that want it, which rewind past the block once notified
+    std::shared_ptr<CBlockUndo> block_undo;
+    if (GetMainSignals().WantsDisconnectedUndo()) block_undo = std::make_shared<CBlockUndo>();
     {
         CCoinsViewCache view(&CoinsTip());
         assert(view.GetBestBlock() == pindexDelete->GetBlockHash());
-        if (DisconnectBlock(block, pindexDelete, view) != DISCONNECT_OK)
+        if (DisconnectBlock(block, pindexDelete, view, block_undo.get()) != DISCONNECT_OK)
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         bool flushed = view.Flush();
         assert(flushed);
@@ -2976,16 +3161,11 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
     UpdateTip(pindexDelete->pprev);
     // Let wallets know transactions went from 1-confirmed to
     // 0-confirmed or conflicted:
+    GetMainSignals().BlockDisconnectedWithUndo(std::make_shared<const DisconnectedBlock>(DisconnectedBlock{pindexDelete, pblock, std::move(block_undo)}));
     GetMainSignals().BlockDisconnected(pblock, pindexDelete);
     return true;
 }
 
-static SteadyClock::duration time_read_from_disk_total{};
-static SteadyClock::duration time_connect_total{};
-static SteadyClock::duration time_flush{};
-static SteadyClock::duration time_chainstate{};
-static SteadyClock::duration time_post_connect{};
-
 struct PerBlockConnectTrace {
     CBlockIndex* pindex = nullptr;
     std::shared_ptr<const CBlock> pblock;
@@ -3026,6 +3206,44 @@ public:
     }
 };
 
+void Chainstate::PrefetchBlockInputs(const CBlock& block)
+{
+    AssertLockHeld(cs_main);
+
+    // Inputs spending outputs of the block itself are never in the database
+    std::set<uint256> block_txids;
+    for (const auto& tx : block.vtx) {
+        block_txids.insert(tx->GetHash());
+    }
+    std::vector<COutPoint> outpoints;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        for (const CTxIn& txin : tx->vin) {
+            if (block_txids.count(txin.prevout.hash) || CoinsTip().HaveCoinInCache(txin.prevout)) continue;
+            outpoints.push_back(txin.prevout);
+        }
+    }
+    if (outpoints.size() < MIN_PREFETCH_INPUTS_PER_WORKER) return;
+    const size_t workers{std::min(MAX_PREFETCH_WORKERS, outpoints.size() / MIN_PREFETCH_INPUTS_PER_WORKER)};
+
+    // The coins below the cache only change when it is flushed, which takes cs_main, so
+    // the coins read are current until cached below. They are read through the view
+    // serving the coins of a background flush, which the database may not have yet.
+    const auto time_start{SteadyClock::now()};
+    const CCoinsView& db{m_coins_views->m_flushview};
+    std::vector<std::optional<Coin>> coins;
+    db.GetCoins(outpoints, coins, workers);
+
+    size_t fetched{0};
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (!coins[i]) continue;
+        CoinsTip().AddFetchedCoin(outpoints[i], std::move(*coins[i]));
+        ++fetched;
+    }
+    LogPrint(BCLog::BENCH, "  - Prefetch %u of %u inputs with %u threads: %.2fms\n", fetched, outpoints.size(), workers,
+             Ticks<MillisecondsDouble>(SteadyClock::now() - time_start));
+}
+
 /**
  * Connect a new block to m_chain. pblock is either nullptr or a pointer to a CBlock
  * corresponding to pindexNew, to bypass loading it again from disk.
@@ -3040,6 +3258,7 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
     assert(pindexNew->pprev == m_chain.Tip());
     // Read block from disk.
     const auto time_1{SteadyClock::now()};
+    g_connecting_block_times = {};
     std::shared_ptr<const CBlock> pthisBlock;
     if (!pblock) {
         std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
@@ -3060,7 +3279,12 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
              Ticks<MillisecondsDouble>(time_2 - time_1),
              Ticks<SecondsDouble>(time_read_from_disk_total),
              Ticks<MillisecondsDouble>(time_read_from_disk_total) / num_blocks_total);
+    PrefetchBlockInputs(blockConnecting);
     {
+        // Out of initial block download, where blocks connect one after the other, keep
+        // the compactions of the databases off the disk while this one connects
+        std::optional<DeferCompactions> defer_compactions;
+        if (!IsInitialBlockDownload()) defer_compactions.emplace();
         CCoinsViewCache view(&CoinsTip());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view);
         GetMainSignals().BlockChecked(blockConnecting, state);
@@ -3116,6 +3340,20 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
              Ticks<SecondsDouble>(time_total),
              Ticks<MillisecondsDouble>(time_total) / num_blocks_total);
 
+    if (this == &m_chainman.ActiveChainstate()) {
+        PublishBlockConnectStats(CoinsTip());
+
+        BlockValidationTimes& times{g_connecting_block_times};
+        times.load_block = time_2 - time_1;
+        times.flush = time_4 - time_3;
+        times.chainstate = time_5 - time_4;
+        times.post_connect = time_6 - time_5;
+        times.total = time_6 - time_1;
+        LOCK(g_block_validation_times_mutex);
+        if (g_block_validation_times.size() == BLOCK_VALIDATION_TIMES_KEPT) g_block_validation_times.pop_front();
+        g_block_validation_times.push_back(times);
+    }
+
     // If we are the background validation chainstate, check to see if we are done
     // validating the snapshot (i.e. our tip has reached the snapshot's base block).
     if (this != &m_chainman.ActiveChainstate()) {
@@ -3219,6 +3457,7 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
     // Disconnect active blocks which are no longer in the best chain.
     bool fBlocksDisconnected = false;
     DisconnectedBlockTransactions disconnectpool;
+    if (pindexFork && m_chain.Height() - pindexFork->nHeight > 1) PrefetchUndo(pindexFork);
     while (m_chain.Tip() && m_chain.Tip() != pindexFork) {
         if (!DisconnectTip(state, &disconnectpool)) {
             // This is likely a fatal error, but keep the mempool consistent,
@@ -3228,11 +3467,13 @@ bool Chainstate::ActivateBestChainStep(BlockValidationState& state, CBlockIndex*
             // If we're unable to disconnect a block during normal operation,
             // then that is a failure of our local system -- we should abort
             // rather than stay on a less work chain.
+            m_undo_prefetch.clear();
             AbortNode(state, "Failed to disconnect block; see debug.log for details");
             return false;
         }
         fBlocksDisconnected = true;
     }
+    m_undo_prefetch.clear();
 
     // Build list of new blocks to connect (in descending height order).
     std::vector<CBlockIndex*> vpindexToConnect;
@@ -3388,7 +3629,12 @@ bool Chainstate::ActivateBestChain(BlockValidationState& state, std::shared_ptr<
 
                 bool fInvalidFound = false;
                 std::shared_ptr<const CBlock> nullBlockPtr;
-                if (!ActivateBestChainStep(state, pindexMostWork, pblock && pblock->GetHash() == pindexMostWork->GetBlockHash() ? pblock : nullBlockPtr, fInvalidFound, connectTrace)) {
+                const bool step_ok{ActivateBestChainStep(state, pindexMostWork, pblock && pblock->GetHash() == pindexMostWork->GetBlockHash() ? pblock : nullBlockPtr, fInvalidFound, connectTrace)};
+                // The undo data of the blocks connected is written before anything can read it
+                if (!m_blockman.WritePendingUndo()) {
+                    return AbortNode(state, "Failed to write undo data");
+                }
+                if (!step_ok) {
                     // A system error occurred
                     return false;
                 }
@@ -3743,7 +3989,12 @@ bool CheckBlockSignature(const CBlock& block)
     return false;
 }
 
-bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW, bool fCheckMerkleRoot)
+bool IsCoinStakeOnlyBlock(const CBlock& block)
+{
+    return block.vtx.size() == 2 && block.vtx[1]->IsCoinStake() && block.vtx[1]->vin.size() <= MAX_INLINE_COINSTAKE_INPUTS;
+}
+
+bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW, bool fCheckMerkleRoot, std::vector<CBlockCheck>* pvChecks)
 {
     // These are checks that are independent of context.
 
@@ -3801,7 +4052,9 @@ bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensu
 	        return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-cs-missing", "coinstake in wrong position");
         }
 
-        if (!CheckBlockSignature(block)) {
+        if (pvChecks) {
+            pvChecks->emplace_back(CBlockSignatureCheck(block));
+        } else if (!CheckBlockSignature(block)) {
             return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-block-signature", "bad block signature");
         }
 
@@ -3830,7 +4083,7 @@ bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensu
     if (nSigOps * WITNESS_SCALE_FACTOR > MAX_BLOCK_SIGOPS_COST)
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-blk-sigops", "out-of-bounds SigOpCount");
 
-    if (fCheckPOW && fCheckMerkleRoot)
+    if (fCheckPOW && fCheckMerkleRoot && !pvChecks)
         block.fChecked = true;
 
     return true;
@@ -3875,13 +4128,73 @@ std::vector<unsigned char> ChainstateManager::GenerateCoinbaseCommitment(CBlock&
     return commitment;
 }
 
-bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams)
+void BlockCheckFailure::Set(const std::string& reject_reason, const std::string& debug_message)
+{
+    LOCK(m_mutex);
+    if (!m_reject_reason.empty()) return;
+    m_reject_reason = reject_reason;
+    m_debug_message = debug_message;
+}
+
+bool BlockCheckFailure::Invalid(BlockValidationState& state)
 {
-    return std::all_of(headers.cbegin(), headers.cend(),
-            [&](const auto& header) {
-                bool isPoS = !header.nNonce;
-                return isPoS ? true : CheckProofOfWork(header.GetPoWHash(), header.nBits, consensusParams);
-            });
+    LOCK(m_mutex);
+    if (m_reject_reason.empty()) {
+        return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "block-validation-failed");
+    }
+    return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, m_reject_reason, m_debug_message);
+}
+
+bool CBlockCheck::operator()()
+{
+    if (std::visit([](auto& check) { return check(); }, m_check)) return true;
+    if (m_failure) {
+        std::visit(util::Overloaded{
+            [&](const CStakeSignatureCheck& check) {
+                m_failure->Set("bad-cs-signature", strprintf("coinstake signature failed (%s)", ScriptErrorString(check.GetScriptError())));
+            },
+            [&](const CBlockSignatureCheck&) { m_failure->Set("bad-block-signature", "bad block signature"); },
+            [](const auto&) {},
+        }, m_check);
+    }
+    return false;
+}
+
+bool CHeadersPoWCheck::operator()()
+{
+    const std::vector<uint256> hashes{GetPoWHashes(m_headers)};
+    for (size_t i = 0; i < m_headers.size(); ++i) {
+        if (!CheckProofOfWork(hashes[i], m_headers[i]->nBits, *m_params)) return false;
+    }
+    return true;
+}
+
+bool HasValidProofOfWork(Span<const CBlockHeader> headers, const Consensus::Params& consensusParams)
+{
+    // Scrypt the proof-of-work headers SCRYPT_BATCH_MAX at a time, which can be
+    // hashed at once
+    std::vector<CBlockCheck> checks;
+    std::vector<const CBlockHeader*> batch;
+    for (auto it = headers.begin(); it != headers.end(); ++it) {
+        if (!it->IsProofOfStake()) batch.push_back(&*it);
+        if (batch.size() < SCRYPT_BATCH_MAX && std::next(it) != headers.end()) continue;
+        if (batch.empty()) continue;
+        checks.emplace_back(CHeadersPoWCheck{std::move(batch), consensusParams});
+        batch.clear();
+    }
+
+    if (checks.size() < 2 || !scriptcheckqueue.HasThreads()) {
+        // Give up after the first batch holding an invalid one
+        for (CBlockCheck& check : checks) {
+            if (!check()) return false;
+        }
+        return true;
+    }
+
+    // Spread the batches of a HEADERS message (up to 2000 headers) over the workers
+    CCheckQueueControl<CBlockCheck> control(&scriptcheckqueue);
+    control.Add(std::move(checks));
+    return control.Wait();
 }
 
 arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader>& headers)
@@ -4029,7 +4342,7 @@ static bool ContextualCheckBlock(const CBlock& block, BlockValidationState& stat
     return true;
 }
 
-bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationState& state, CBlockIndex** ppindex, bool min_pow_checked)
+bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationState& state, CBlockIndex** ppindex, bool min_pow_checked, bool check_pow)
 {
     AssertLockHeld(cs_main);
 
@@ -4049,7 +4362,7 @@ bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValida
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, GetConsensus())) {
+        if (!CheckBlockHeader(block, state, GetConsensus(), check_pow)) {
             LogPrint(BCLog::VALIDATION, "%s: Consensus::CheckBlockHeader: %s, %s\n", __func__, hash.ToString(), state.ToString());
             return false;
         }
@@ -4115,6 +4428,7 @@ bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValida
         return state.Invalid(BlockValidationResult::BLOCK_HEADER_LOW_WORK, "too-little-chainwork");
     }
     CBlockIndex* pindex{m_blockman.AddToBlockIndex(block, m_best_header)};
+    CacheNextWorkRequiredPoS(*pindex, GetConsensus());
 
     if (ppindex)
         *ppindex = pindex;
@@ -4141,14 +4455,27 @@ bool ChainstateManager::AcceptBlockHeader(const CBlockHeader& block, BlockValida
 }
 
 // Exposed wrapper for AcceptBlockHeader
-bool ChainstateManager::ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, bool min_pow_checked, BlockValidationState& state, const CBlockIndex** ppindex)
+bool ChainstateManager::ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, bool min_pow_checked, BlockValidationState& state, const CBlockIndex** ppindex, bool pow_checked)
 {
     AssertLockNotHeld(cs_main);
+
+    // Unless the caller has, check the proof of work of the headers not seen yet in parallel,
+    // outside of cs_main, so that accepting them below does not scrypt them one by one. Should
+    // any be invalid, they are checked one by one after all, for the state to name the first one.
+    if (!pow_checked && headers.size() > 1) {
+        size_t known{0};
+        {
+            LOCK(cs_main);
+            while (known < headers.size() && m_blockman.LookupBlockIndex(headers[known].GetHash())) ++known;
+        }
+        pow_checked = HasValidProofOfWork(Span{headers}.subspan(known), GetConsensus());
+    }
+
     {
         LOCK(cs_main);
         for (const CBlockHeader& header : headers) {
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            bool accepted{AcceptBlockHeader(header, state, &pindex, min_pow_checked)};
+            bool accepted{AcceptBlockHeader(header, state, &pindex, min_pow_checked, /*check_pow=*/!pow_checked)};
             ActiveChainstate().CheckBlockIndex();
 
             if (!accepted) {
@@ -4195,6 +4522,21 @@ void ChainstateManager::ReportHeadersPresync(const arith_uint256& work, int64_t
     }
 }
 
+bool Chainstate::FastRelayStakeValid(const CBlock& block, const CBlockIndex* pindex)
+{
+    AssertLockHeld(cs_main);
+    if (!block.IsProofOfStake()) return true;
+    // The stake that passes is remembered in the stake kernel cache, so
+    // ConnectBlock() doesn't verify its signature again
+    BlockValidationState state;
+    uint256 hash_proof, target_proof;
+    if (!CheckProofOfStake(*this, state, pindex->pprev, *block.vtx[1], block.nTime, block.nBits, hash_proof, target_proof)) {
+        LogPrint(BCLog::VALIDATION, "Not fast-announcing block %s, its stake doesn't check out\n", block.GetHash().ToString());
+        return false;
+    }
+    return true;
+}
+
 /** Store block on disk. If dbp is non-nullptr, the file is known to already reside on disk */
 bool Chainstate::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, BlockValidationState& state, CBlockIndex** ppindex, bool fRequested, const FlatFilePos* dbp, bool* fNewBlock, bool min_pow_checked)
 {
@@ -4258,8 +4600,9 @@ bool Chainstate::AcceptBlock(const std::shared_ptr<const CBlock>& pblock, BlockV
 
     // Header is valid/has work, merkle tree and segwit merkle tree are good...RELAY NOW
     // (but if it does not build on our best tip, let the SendMessages loop relay it)
-    if (!IsInitialBlockDownload() && m_chain.Tip() == pindex->pprev)
+    if (!IsInitialBlockDownload() && m_chain.Tip() == pindex->pprev && FastRelayStakeValid(block, pindex)) {
         GetMainSignals().NewPoWValidBlock(pindex, pblock);
+    }
 
     // Write block to history file
     if (fNewBlock) *fNewBlock = true;
@@ -4392,6 +4735,7 @@ bool Chainstate::LoadChainTip()
     const CBlockIndex* tip = m_chain.Tip();
 
     if (tip && tip->GetBlockHash() == coins_cache.GetBestBlock()) {
+        if (this == &m_chainman.ActiveChainstate()) m_chainman.PublishTip(tip);
         return true;
     }
 
@@ -4409,6 +4753,7 @@ bool Chainstate::LoadChainTip()
               m_chain.Height(),
               FormatISO8601DateTime(tip->GetBlockTime()),
               GuessVerificationProgress(m_chainman.GetParams().TxData(), tip));
+    if (this == &m_chainman.ActiveChainstate()) m_chainman.PublishTip(tip);
     return true;
 }
 
@@ -4674,6 +5019,7 @@ void Chainstate::UnloadBlockIndex()
     AssertLockHeld(::cs_main);
     nBlockSequenceId = 1;
     setBlockIndexCandidates.clear();
+    m_block_time_stats.Clear();
 }
 
 bool ChainstateManager::LoadBlockIndex()
@@ -4791,6 +5137,7 @@ bool Chainstate::LoadGenesisBlock()
             return error("%s: writing genesis block to disk failed", __func__);
         }
         CBlockIndex* pindex = m_blockman.AddToBlockIndex(block, m_chainman.m_best_header);
+        CacheNextWorkRequiredPoS(*pindex, m_chainman.GetConsensus());
         ReceivedBlockTransactions(block, pindex, blockPos);
     } catch (const std::runtime_error& e) {
         return error("%s: failed to write genesis block: %s", __func__, e.what());
@@ -4799,6 +5146,18 @@ bool Chainstate::LoadGenesisBlock()
     return true;
 }
 
+/** Read the block of a compressed block record of size bytes, at the position of blkdat. */
+static void ReadCompressedBlock(CBufferedFile& blkdat, unsigned int size, CBlock& block)
+{
+    std::vector<uint8_t> record(size);
+    blkdat.read(MakeWritableByteSpan(record));
+    std::vector<uint8_t> serialized;
+    if (!DecompressBlock(record, serialized)) {
+        throw std::ios_base::failure("Malformed compressed block");
+    }
+    SpanReader{SER_DISK, CLIENT_VERSION, serialized} >> block;
+}
+
 void Chainstate::LoadExternalBlockFile(
     FILE* fileIn,
     FlatFilePos* dbp,
@@ -4826,6 +5185,7 @@ void Chainstate::LoadExternalBlockFile(
             nRewind++; // start one byte further next time, in case of failure
             blkdat.SetLimit(); // remove former limit
             unsigned int nSize = 0;
+            bool compressed = false;
             try {
                 // locate a header
                 unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
@@ -4835,8 +5195,10 @@ void Chainstate::LoadExternalBlockFile(
                 if (memcmp(buf, params.MessageStart(), CMessageHeader::MESSAGE_START_SIZE)) {
                     continue;
                 }
-                // read size
+                // read size, flagged if the block is stored compressed
                 blkdat >> nSize;
+                compressed = nSize & BLOCK_RECORD_COMPRESSED;
+                nSize &= ~BLOCK_RECORD_COMPRESSED;
                 if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
                     continue;
             } catch (const std::exception&) {
@@ -4850,8 +5212,16 @@ void Chainstate::LoadExternalBlockFile(
                 if (dbp)
                     dbp->nPos = nBlockPos;
                 blkdat.SetLimit(nBlockPos + nSize);
+                // A compressed block is read whole, as its header can't be read alone
+                std::shared_ptr<CBlock> pblock;
                 CBlockHeader header;
-                blkdat >> header;
+                if (compressed) {
+                    pblock = std::make_shared<CBlock>();
+                    ReadCompressedBlock(blkdat, nSize, *pblock);
+                    header = pblock->GetBlockHeader();
+                } else {
+                    blkdat >> header;
+                }
                 const uint256 hash{header.GetHash()};
                 // Skip the rest of this block (this may read from disk into memory); position to the marker before the
                 // next block, but it's still possible to rewind to the start of the current block (without a disk read).
@@ -4873,10 +5243,12 @@ void Chainstate::LoadExternalBlockFile(
                     const CBlockIndex* pindex = m_blockman.LookupBlockIndex(hash);
                     if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
                         // This block can be processed immediately; rewind to its start, read and deserialize it.
-                        blkdat.SetPos(nBlockPos);
-                        std::shared_ptr<CBlock> pblock{std::make_shared<CBlock>()};
-                        blkdat >> *pblock;
-                        nRewind = blkdat.GetPos();
+                        if (!pblock) {
+                            blkdat.SetPos(nBlockPos);
+                            pblock = std::make_shared<CBlock>();
+                            blkdat >> *pblock;
+                            nRewind = blkdat.GetPos();
+                        }
 
                         BlockValidationState state;
                         if (AcceptBlock(pblock, state, nullptr, true, dbp, nullptr, true)) {
@@ -4902,31 +5274,7 @@ void Chainstate::LoadExternalBlockFile(
 
                 if (!blocks_with_unknown_parent) continue;
 
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    auto range = blocks_with_unknown_parent->equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, FlatFilePos>::iterator it = range.first;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (ReadBlockFromDisk(*pblockrecursive, it->second, params.GetConsensus())) {
-                            LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
-                                    head.ToString());
-                            LOCK(cs_main);
-                            BlockValidationState dummy;
-                            if (AcceptBlock(pblockrecursive, dummy, nullptr, true, &it->second, nullptr, true)) {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        blocks_with_unknown_parent->erase(it);
-                        NotifyHeaderTip(*this);
-                    }
-                }
+                nLoaded += LoadUnknownParentChildren(hash, *blocks_with_unknown_parent);
             } catch (const std::exception& e) {
                 // historical bugs added extra data to the block files that does not deserialize cleanly.
                 // commonly this data is between readable blocks, but it does not really matter. such data is not fatal to the import process.
@@ -4948,6 +5296,157 @@ void Chainstate::LoadExternalBlockFile(
     LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
 }
 
+int Chainstate::LoadUnknownParentChildren(const uint256& hash, std::multimap<uint256, FlatFilePos>& blocks_with_unknown_parent)
+{
+    const CChainParams& params{m_chainman.GetParams()};
+    int nLoaded = 0;
+
+    // Recursively process earlier encountered successors of this block
+    std::deque<uint256> queue;
+    queue.push_back(hash);
+    while (!queue.empty()) {
+        uint256 head = queue.front();
+        queue.pop_front();
+        auto range = blocks_with_unknown_parent.equal_range(head);
+        while (range.first != range.second) {
+            std::multimap<uint256, FlatFilePos>::iterator it = range.first;
+            std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
+            if (ReadBlockFromDisk(*pblockrecursive, it->second, params.GetConsensus())) {
+                LogPrint(BCLog::REINDEX, "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
+                        head.ToString());
+                LOCK(cs_main);
+                BlockValidationState dummy;
+                if (AcceptBlock(pblockrecursive, dummy, nullptr, true, &it->second, nullptr, true)) {
+                    nLoaded++;
+                    queue.push_back(pblockrecursive->GetHash());
+                }
+            }
+            range.first++;
+            blocks_with_unknown_parent.erase(it);
+            NotifyHeaderTip(*this);
+        }
+    }
+    return nLoaded;
+}
+
+std::vector<ExternalBlock> ParseBlockFile(FILE* fileIn, int file_num, const CChainParams& params)
+{
+    std::vector<ExternalBlock> blocks;
+    try {
+        // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
+        CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE+8, SER_DISK, CLIENT_VERSION);
+        // As in LoadExternalBlockFile(), nRewind is where to resume scanning if a
+        // block fails to deserialize
+        uint64_t nRewind = blkdat.GetPos();
+        while (!blkdat.eof()) {
+            if (ShutdownRequested()) break;
+
+            blkdat.SetPos(nRewind);
+            nRewind++;
+            blkdat.SetLimit();
+            unsigned int nSize = 0;
+            bool compressed = false;
+            try {
+                unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
+                blkdat.FindByte(params.MessageStart()[0]);
+                nRewind = blkdat.GetPos() + 1;
+                blkdat >> buf;
+                if (memcmp(buf, params.MessageStart(), CMessageHeader::MESSAGE_START_SIZE)) {
+                    continue;
+                }
+                blkdat >> nSize;
+                compressed = nSize & BLOCK_RECORD_COMPRESSED;
+                nSize &= ~BLOCK_RECORD_COMPRESSED;
+                if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
+                    continue;
+            } catch (const std::exception&) {
+                // no valid block header found, as at the end of every blk.dat file
+                break;
+            }
+            try {
+                const uint64_t nBlockPos{blkdat.GetPos()};
+                blkdat.SetLimit(nBlockPos + nSize);
+                std::shared_ptr<CBlock> pblock{std::make_shared<CBlock>()};
+                if (compressed) {
+                    ReadCompressedBlock(blkdat, nSize, *pblock);
+                } else {
+                    blkdat >> *pblock;
+                }
+                nRewind = blkdat.GetPos();
+
+                // Marks the block checked if it passes, so AcceptBlock() skips it
+                BlockValidationState state;
+                CheckBlock(*pblock, state, params.GetConsensus());
+                const uint256 hash{pblock->GetHash()};
+                blocks.push_back({FlatFilePos{file_num, static_cast<unsigned int>(nBlockPos)}, hash, std::move(pblock)});
+            } catch (const std::exception& e) {
+                LogPrint(BCLog::REINDEX, "%s: unexpected data at offset 0x%x of blk%05u.dat - %s. continuing\n", __func__, (nRewind - 1), file_num, e.what());
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        AbortNode(std::string("System error: ") + e.what());
+    }
+    return blocks;
+}
+
+void Chainstate::LoadExternalBlocks(
+    const std::vector<ExternalBlock>& blocks,
+    std::multimap<uint256, FlatFilePos>& blocks_with_unknown_parent)
+{
+    AssertLockNotHeld(m_chainstate_mutex);
+
+    const auto start{SteadyClock::now()};
+    const CChainParams& params{m_chainman.GetParams()};
+
+    int nLoaded = 0;
+    try {
+        for (const ExternalBlock& external : blocks) {
+            if (ShutdownRequested()) return;
+
+            FlatFilePos pos{external.pos};
+            {
+                LOCK(cs_main);
+                // detect out of order blocks, and store them for later
+                if (external.hash != params.GetConsensus().hashGenesisBlock && !m_blockman.LookupBlockIndex(external.block->hashPrevBlock)) {
+                    LogPrint(BCLog::REINDEX, "%s: Out of order block %s, parent %s not known\n", __func__, external.hash.ToString(),
+                             external.block->hashPrevBlock.ToString());
+                    blocks_with_unknown_parent.emplace(external.block->hashPrevBlock, pos);
+                    continue;
+                }
+
+                // process in case the block isn't known yet
+                const CBlockIndex* pindex = m_blockman.LookupBlockIndex(external.hash);
+                if (!pindex || (pindex->nStatus & BLOCK_HAVE_DATA) == 0) {
+                    BlockValidationState state;
+                    if (AcceptBlock(external.block, state, nullptr, true, &pos, nullptr, true)) {
+                        nLoaded++;
+                    }
+                    if (state.IsError()) {
+                        break;
+                    }
+                } else if (external.hash != params.GetConsensus().hashGenesisBlock && pindex->nHeight % 1000 == 0) {
+                    LogPrint(BCLog::REINDEX, "Block Import: already had block %s at height %d\n", external.hash.ToString(), pindex->nHeight);
+                }
+            }
+
+            // Activate the genesis block so normal node progress can continue
+            if (external.hash == params.GetConsensus().hashGenesisBlock) {
+                BlockValidationState state;
+                if (!ActivateBestChain(state, nullptr)) {
+                    break;
+                }
+            }
+
+            NotifyHeaderTip(*this);
+
+            nLoaded += LoadUnknownParentChildren(external.hash, blocks_with_unknown_parent);
+        }
+    } catch (const std::runtime_error& e) {
+        AbortNode(std::string("System error: ") + e.what());
+    }
+    LogPrintf("Loaded %i blocks from block file in %dms\n", nLoaded, Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
+}
+
 void Chainstate::CheckBlockIndex()
 {
     if (!m_chainman.ShouldCheckBlockIndex()) {
@@ -5189,11 +5688,15 @@ bool Chainstate::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size)
     }
     size_t old_coinstip_size = m_coinstip_cache_size_bytes;
     m_coinstip_cache_size_bytes = coinstip_size;
-    m_coinsdb_cache_size_bytes = coinsdb_size;
-    CoinsDB().ResizeCache(coinsdb_size);
+    if (coinsdb_size != m_coinsdb_cache_size_bytes) {
+        m_coinsdb_cache_size_bytes = coinsdb_size;
+        // The database is reopened for the new size
+        m_coins_views->m_flushview.Wait();
+        CoinsDB().ResizeCache(coinsdb_size);
 
-    LogPrintf("[%s] resized coinsdb cache to %.1f MiB\n",
-        this->ToString(), coinsdb_size * (1.0 / 1024 / 1024));
+        LogPrintf("[%s] resized coinsdb cache to %.1f MiB\n",
+            this->ToString(), coinsdb_size * (1.0 / 1024 / 1024));
+    }
     LogPrintf("[%s] resized coinstip cache to %.1f MiB\n",
         this->ToString(), coinstip_size * (1.0 / 1024 / 1024));
 
@@ -5411,6 +5914,7 @@ bool ChainstateManager::ActivateSnapshot(
         assert(chaintip_loaded);
 
         m_active_chainstate = m_snapshot_chainstate.get();
+        PublishTip(m_active_chainstate->m_chain.Tip());
 
         LogPrintf("[snapshot] successfully activated snapshot %s\n", base_blockhash.ToString());
         LogPrintf("[snapshot] (%.2f MB)\n",
@@ -5640,6 +6144,10 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
     assert(index);
     index->nChainTx = au_data.nChainTx;
+    // Stakes on top of the snapshot are checked against the base block's stake modifier,
+    // which can't be derived without the blocks beneath it.
+    index->nStakeModifier = au_data.stake_modifier;
+    m_blockman.m_dirty_blockindex.insert(index);
     snapshot_chainstate.setBlockIndexCandidates.insert(snapshot_start_block);
 
     LogPrintf("[snapshot] validated snapshot (%.2f MB)\n",
@@ -5705,6 +6213,7 @@ SnapshotCompletionResult ChainstateManager::MaybeCompleteSnapshotValidation(
         LogPrintf("[snapshot] deleting snapshot, reverting to validated chain, and stopping node\n");
 
         m_active_chainstate = m_ibd_chainstate.get();
+        PublishTip(m_active_chainstate->m_chain.Tip());
         m_snapshot_chainstate->m_disabled = true;
         assert(!this->IsUsable(m_snapshot_chainstate.get()));
         assert(this->IsUsable(m_ibd_chainstate.get()));
@@ -5781,6 +6290,16 @@ SnapshotCompletionResult ChainstateManager::MaybeCompleteSnapshotValidation(
         return SnapshotCompletionResult::HASH_MISMATCH;
     }
 
+    // The stake modifier the snapshot chainstate has been staking against must match the
+    // one the background chainstate derived for the same block.
+    if (index_new.nStakeModifier != au_data.stake_modifier) {
+        LogPrintf("[snapshot] stake modifier mismatch: actual=%s, expected=%s\n",
+            index_new.nStakeModifier.ToString(),
+            au_data.stake_modifier.ToString());
+        handle_invalid_snapshot();
+        return SnapshotCompletionResult::STAKE_MODIFIER_MISMATCH;
+    }
+
     LogPrintf("[snapshot] snapshot beginning at %s has been fully validated\n",
         snapshot_blockhash.ToString());
 
@@ -5790,6 +6309,35 @@ SnapshotCompletionResult ChainstateManager::MaybeCompleteSnapshotValidation(
     return SnapshotCompletionResult::SUCCESS;
 }
 
+void ChainstateManager::PublishTip(const CBlockIndex* tip)
+{
+    AssertLockHeld(::cs_main);
+    m_stake_kernel_rate.SetTip(tip);
+    if (!tip) {
+        std::atomic_store(&m_tip_snapshot, std::shared_ptr<const TipSnapshot>{});
+        return;
+    }
+    const auto previous{GetTipSnapshot()};
+    auto snapshot{std::make_shared<TipSnapshot>()};
+    snapshot->tip = tip;
+    // Connecting a proof-of-work block keeps the last stake, so the walk back
+    // to it is only taken after a reorganization
+    if (tip->IsProofOfWork() && previous && previous->tip == tip->pprev) {
+        snapshot->last_pos = previous->last_pos;
+    } else {
+        snapshot->last_pos = GetLastPoSBlockIndex(tip);
+    }
+    snapshot->height = tip->nHeight;
+    snapshot->hash = tip->GetBlockHash();
+    snapshot->time = tip->GetBlockTime();
+    snapshot->median_time = tip->GetMedianTimePast();
+    snapshot->chain_work = tip->nChainWork;
+    snapshot->chain_tx = tip->nChainTx;
+    snapshot->verification_progress = GuessVerificationProgress(GetParams().TxData(), tip);
+    snapshot->pos_kernel_ps = m_stake_kernel_rate.KernelsPerSecond();
+    std::atomic_store(&m_tip_snapshot, std::shared_ptr<const TipSnapshot>{std::move(snapshot)});
+}
+
 Chainstate& ChainstateManager::ActiveChainstate() const
 {
     LOCK(::cs_main);
@@ -5844,6 +6392,7 @@ void ChainstateManager::ResetChainstates()
     m_ibd_chainstate.reset();
     m_snapshot_chainstate.reset();
     m_active_chainstate = nullptr;
+    std::atomic_store(&m_tip_snapshot, std::shared_ptr<const TipSnapshot>{});
 }
 
 /**
@@ -12,6 +12,7 @@
 
 #include <arith_uint256.h>
 #include <attributes.h>
+#include <blocktime.h>
 #include <chain.h>
 #include <consensus/amount.h>
 #include <deploymentstatus.h>
@@ -22,12 +23,14 @@
 #include <policy/feerate.h>
 #include <policy/packages.h>
 #include <policy/policy.h>
+#include <pos/pos.h>
 #include <script/script_error.h>
 #include <shutdown.h>
 #include <sync.h>
 #include <txdb.h>
 #include <txmempool.h> // For CTxMemPool::cs
 #include <uint256.h>
+#include <undo.h>
 #include <util/check.h>
 #include <util/fs.h>
 #include <util/hasher.h>
@@ -35,6 +38,7 @@
 #include <versionbits.h>
 
 #include <atomic>
+#include <future>
 #include <map>
 #include <memory>
 #include <optional>
@@ -43,6 +47,7 @@
 #include <string>
 #include <thread>
 #include <utility>
+#include <variant>
 #include <vector>
 
 class Chainstate;
@@ -52,6 +57,7 @@ class ChainstateManager;
 struct ChainTxData;
 struct DisconnectedBlockTransactions;
 struct PrecomputedTransactionData;
+struct ValidationCacheStats;
 struct LockPoints;
 struct AssumeutxoData;
 namespace node {
@@ -65,6 +71,10 @@ struct Params;
 static const int MAX_SCRIPTCHECK_THREADS = 15;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Most threads reading the coins a block spends from the database in parallel, before connecting it */
+static constexpr size_t MAX_PREFETCH_WORKERS{8};
+/** Fewest coins missing from the cache worth a prefetch thread of their own */
+static constexpr size_t MIN_PREFETCH_INPUTS_PER_WORKER{32};
 /** Default for -stopatheight */
 static const int DEFAULT_STOPATHEIGHT = 0;
 /** Block files containing a block-height within MIN_BLOCKS_TO_KEEP of ActiveChain().Tip() will not be pruned. */
@@ -249,6 +259,15 @@ MempoolAcceptResult AcceptToMemoryPool(Chainstate& active_chainstate, const CTra
                                        int64_t accept_time, bool bypass_limits, bool test_accept)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * Verify the scripts of txs, spending coins of the chainstate tip, the mempool or the txs
+ * before them, on the script check threads and cache the signatures they verify, so
+ * accepting them to the mempool after does not verify those signatures again. This checks
+ * nothing: txs still have to be accepted. Does nothing without script check threads.
+ */
+void PrecheckTransactionScripts(Chainstate& active_chainstate, const CTxMemPool& pool, const std::vector<CTransactionRef>& txs)
+    LOCKS_EXCLUDED(cs_main);
+
 /**
 * Validate (and maybe submit) a package to the mempool. See doc/policy/packages.md for full details
 * on package validation rules.
@@ -332,13 +351,117 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
-/** Initializes the script-execution cache */
-[[nodiscard]] bool InitScriptExecutionCache(size_t max_size_bytes);
+/** Check that a proof-of-stake block is signed by the key its coinstake pays */
+bool CheckBlockSignature(const CBlock& block);
+
+/** Closure representing the block signature check of CheckBlock() */
+class CBlockSignatureCheck
+{
+private:
+    const CBlock* m_block;
+
+public:
+    explicit CBlockSignatureCheck(const CBlock& block) : m_block(&block) {}
+
+    bool operator()() { return CheckBlockSignature(*m_block); }
+};
+
+/** Closure representing the proof-of-work check of headers which are scrypted at once */
+class CHeadersPoWCheck
+{
+private:
+    std::vector<const CBlockHeader*> m_headers;
+    const Consensus::Params* m_params;
+
+public:
+    CHeadersPoWCheck(std::vector<const CBlockHeader*>&& headers, const Consensus::Params& params) : m_headers(std::move(headers)), m_params(&params) {}
+
+    bool operator()();
+};
+
+/** Reject reason of the first proof-of-stake check of a block to fail on the check queue */
+class BlockCheckFailure
+{
+private:
+    Mutex m_mutex;
+    std::string m_reject_reason GUARDED_BY(m_mutex);
+    std::string m_debug_message GUARDED_BY(m_mutex);
+
+public:
+    //! Record why a check failed, unless an earlier failure is recorded
+    void Set(const std::string& reject_reason, const std::string& debug_message) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Mark state invalid with the recorded reason, or the generic one of the script checks
+    bool Invalid(BlockValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+/**
+ * Verification run by the block check queue: an input script, or one of the
+ * proof-of-stake checks of the block, which then overlap with the scripts
+ */
+class CBlockCheck
+{
+private:
+    std::variant<CScriptCheck, CStakeSignatureCheck, CBlockSignatureCheck, CHeadersPoWCheck> m_check;
+    BlockCheckFailure* m_failure{nullptr};
+
+public:
+    CBlockCheck(CScriptCheck&& check) : m_check(std::move(check)) {}
+    CBlockCheck(CStakeSignatureCheck&& check) : m_check(std::move(check)) {}
+    CBlockCheck(CBlockSignatureCheck&& check) : m_check(std::move(check)) {}
+    CBlockCheck(CHeadersPoWCheck&& check) : m_check(std::move(check)) {}
+
+    //! Have a failed proof-of-stake check record its reject reason in failure
+    void ReportTo(BlockCheckFailure& failure) { m_failure = &failure; }
+
+    bool operator()();
+};
+
+/** Initializes the script-execution cache, which may grow under eviction pressure to max_grow_bytes if larger */
+[[nodiscard]] bool InitScriptExecutionCache(size_t max_size_bytes, size_t max_grow_bytes = 0);
+
+/** Lookup and eviction counters of the script-execution cache */
+ValidationCacheStats GetScriptExecutionCacheStats();
 
 /** Functions for validating blocks and updating the block tree */
 
-/** Context-independent validity checks */
-bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
+/**
+ * Context-independent validity checks
+ * If pvChecks is not nullptr, the block signature check is pushed onto it instead of
+ * being performed inline, and the block is not marked as checked
+ */
+bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true, std::vector<CBlockCheck>* pvChecks = nullptr);
+
+/** Most inputs the coinstake of a block may spend for its checks to be run inline, see IsCoinStakeOnlyBlock() */
+static constexpr size_t MAX_INLINE_COINSTAKE_INPUTS{4};
+
+/**
+ * Whether a block holds only the coinbase and a coinstake of a few inputs, as
+ * most proof-of-stake blocks do. ConnectBlock() verifies the signatures of
+ * such a block inline, as waking the script check threads for them costs more
+ * than it saves.
+ */
+bool IsCoinStakeOnlyBlock(const CBlock& block);
+
+/** A block parsed out of a block file, see ParseBlockFile() */
+struct ExternalBlock {
+    FlatFilePos pos;
+    uint256 hash;
+    std::shared_ptr<const CBlock> block;
+};
+
+/**
+ * Parse the blocks of a block file as LoadExternalBlockFile() finds them, and run
+ * CheckBlock() on them, so accepting them doesn't wait for either. Blocks failing
+ * the check are kept, to be rejected when they are accepted.
+ *
+ * Independent of the chainstate, so several files can be parsed at once during
+ * -reindex while the blocks of another are accepted. Takes over fileIn and closes it.
+ *
+ * @param[in]     fileIn    FILE handle to the block file
+ * @param[in]     file_num  Number of the block file, for the positions of its blocks
+ */
+std::vector<ExternalBlock> ParseBlockFile(FILE* fileIn, int file_num, const CChainParams& params);
 
 /** Check a block is completely valid from start to finish (only works on top of our current best block) */
 bool TestBlockValidity(BlockValidationState& state,
@@ -350,8 +473,11 @@ bool TestBlockValidity(BlockValidationState& state,
                        bool fCheckPOW = true,
                        bool fCheckMerkleRoot = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
-/** Check with the proof of work on each blockheader matches the value in nBits */
-bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams);
+/**
+ * Check with the proof of work on each blockheader matches the value in nBits
+ * Many headers are checked in parallel on the block check queue workers
+ */
+bool HasValidProofOfWork(Span<const CBlockHeader> headers, const Consensus::Params& consensusParams);
 
 /** Return the sum of the work on a given set of headers */
 arith_uint256 CalculateHeadersWork(const std::vector<CBlockHeader>& headers);
@@ -413,6 +539,9 @@ public:
     //! This view wraps access to the leveldb instance and handles read errors gracefully.
     CCoinsViewErrorCatcher m_catcherview GUARDED_BY(cs_main);
 
+    //! This view writes flushes of the cache in the background, with -backgroundflush.
+    CCoinsViewBackgroundFlush m_flushview GUARDED_BY(cs_main);
+
     //! This is the top layer of the cache hierarchy - it keeps as many coins in memory as
     //! can fit per the dbcache setting.
     std::unique_ptr<CCoinsViewCache> m_cacheview GUARDED_BY(cs_main);
@@ -548,6 +677,9 @@ public:
     //! @see CChain, CBlockIndex.
     CChain m_chain;
 
+    //! Block intervals over rolling windows ending at the tip, for ShowAverageSpans() and getblocktimestats
+    BlockTimeStats m_block_time_stats;
+
     /**
      * The blockhash which is the base of the snapshot this chainstate was created from.
      *
@@ -645,6 +777,19 @@ public:
         std::multimap<uint256, FlatFilePos>* blocks_with_unknown_parent = nullptr)
         EXCLUSIVE_LOCKS_REQUIRED(!m_chainstate_mutex);
 
+    /**
+     * Accept the blocks ParseBlockFile() parsed out of a block file during -reindex, as
+     * LoadExternalBlockFile() would accept them reading the file itself.
+     *
+     * @param[in]     blocks                        Blocks of the file, in the order they are stored
+     * @param[in,out] blocks_with_unknown_parent    Map of disk positions for blocks with
+     *                                              unknown parent, key is parent block hash
+     */
+    void LoadExternalBlocks(
+        const std::vector<ExternalBlock>& blocks,
+        std::multimap<uint256, FlatFilePos>& blocks_with_unknown_parent)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_chainstate_mutex);
+
     /**
      * Update the on-disk chain state.
      * The caches and indexes are flushed depending on the mode we're called with
@@ -697,8 +842,16 @@ public:
 
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, BlockValidationState& state, CBlockIndex** ppindex, bool fRequested, const FlatFilePos* dbp, bool* fNewBlock, bool min_pow_checked) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Whether a block on the tip may be announced before it is connected: a
+     * proof-of-stake block only once its coinstake passes CheckProofOfStake(),
+     * so peers aren't sent blocks whose stake is invalid.
+     */
+    bool FastRelayStakeValid(const CBlock& block, const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     // Block (dis)connection on a given view:
-    DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
+    //! With undo_out, the undo data read for the block is left there
+    DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, CBlockUndo* undo_out = nullptr)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     bool ConnectBlock(const CBlock& block, BlockValidationState& state, CBlockIndex* pindex,
                       CCoinsViewCache& view, bool fJustCheck = false) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -773,7 +926,30 @@ public:
 
 private:
     bool ActivateBestChainStep(BlockValidationState& state, CBlockIndex* pindexMostWork, const std::shared_ptr<const CBlock>& pblock, bool& fInvalidFound, ConnectTrace& connectTrace) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
+
+    //! Undo data of blocks about to be disconnected, being read ahead, see PrefetchUndo()
+    std::map<const CBlockIndex*, std::future<std::optional<CBlockUndo>>> m_undo_prefetch GUARDED_BY(::cs_main);
+    /**
+     * Start reading the undo data of the blocks from the tip back to pindexFork,
+     * at most UNDO_PREFETCH_BLOCKS of them, each on a thread of its own, for a
+     * reorganization to disconnect them without waiting for the disk one at a time.
+     */
+    void PrefetchUndo(const CBlockIndex* pindexFork) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    //! Take the undo data of pindex read by PrefetchUndo(), if it was and could be read
+    bool TakePrefetchedUndo(const CBlockIndex* pindex, CBlockUndo& blockundo) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew, const std::shared_ptr<const CBlock>& pblock, ConnectTrace& connectTrace, DisconnectedBlockTransactions& disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
+    /**
+     * Read the coins spent by block that are missing from the coins cache from the
+     * database in one batch, on several threads, and cache them, so connecting it
+     * doesn't wait for each in turn
+     */
+    void PrefetchBlockInputs(const CBlock& block) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Accept the blocks of blocks_with_unknown_parent descending from the block hash,
+     * now that it is known, during -reindex. Returns the number of blocks accepted.
+     */
+    int LoadUnknownParentChildren(const uint256& hash, std::multimap<uint256, FlatFilePos>& blocks_with_unknown_parent);
 
     void InvalidBlockFound(CBlockIndex* pindex, const BlockValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     CBlockIndex* FindMostWorkChain() EXCLUSIVE_LOCKS_REQUIRED(cs_main);
@@ -837,8 +1013,93 @@ enum class SnapshotCompletionResult {
     // The blockhash of the current tip of the background validation chainstate does
     // not match the one expected by the snapshot chainstate.
     BASE_BLOCKHASH_MISMATCH,
+
+    // The stake modifier of the background validation chainstate's tip does not
+    // match the one expected by assumeutxo chainparams.
+    STAKE_MODIFIER_MISMATCH,
+};
+
+/**
+ * The tip of the active chain as it was when last published, so that RPCs and
+ * monitoring that only look at the tip need not take cs_main, and contend with
+ * block validation for it.
+ *
+ * The block index entries may be read without cs_main: the fields of a block
+ * connected to the chain, and those of its ancestors, do not change, other
+ * than its status and position on disk.
+ */
+struct TipSnapshot {
+    const CBlockIndex* tip{nullptr};
+    //! The last proof-of-stake block at or before the tip, the genesis block if there is none
+    const CBlockIndex* last_pos{nullptr};
+    int height{-1};
+    uint256 hash;
+    int64_t time{0};
+    int64_t median_time{0};
+    arith_uint256 chain_work;
+    uint64_t chain_tx{0};
+    double verification_progress{0};
+    //! Kernel hashes per second of the network's stakers, as GetPoSKernelPS() estimates it at the tip
+    double pos_kernel_ps{0};
 };
 
+/** Time spent connecting blocks to the active chain since startup, by stage, and the coins cache
+ *  as of the last block connected or cache flush. Published for readers that do not take cs_main */
+struct BlockConnectStats {
+    int64_t blocks{0};
+    SteadyClock::duration load_block{};
+    SteadyClock::duration check{};
+    SteadyClock::duration forks{};
+    SteadyClock::duration connect{};
+    SteadyClock::duration verify{};
+    SteadyClock::duration undo{};
+    SteadyClock::duration index{};
+    SteadyClock::duration connect_total{};
+    SteadyClock::duration flush{};
+    SteadyClock::duration chainstate{};
+    SteadyClock::duration post_connect{};
+    SteadyClock::duration total{};
+    size_t coins_cache_count{0};
+    size_t coins_cache_usage{0};
+};
+
+BlockConnectStats GetBlockConnectStats();
+
+//! Number of the latest blocks connected whose validation times are kept
+static constexpr size_t BLOCK_VALIDATION_TIMES_KEPT{1000};
+
+/** Time taken by each stage of connecting one block to the active chain, with what the block holds */
+struct BlockValidationTimes {
+    uint256 hash;
+    int height{0};
+    bool proof_of_stake{false};
+    size_t size{0};
+    size_t txs{0};
+    size_t inputs{0};
+    //! Transactions carrying storage chunks
+    size_t storage_txs{0};
+    SteadyClock::duration load_block{};
+    SteadyClock::duration check{};
+    //! Kernel lookup and hash of the coinstake, and its signature unless left to the script check threads
+    SteadyClock::duration stake{};
+    SteadyClock::duration forks{};
+    SteadyClock::duration connect{};
+    SteadyClock::duration verify{};
+    SteadyClock::duration undo{};
+    SteadyClock::duration index{};
+    SteadyClock::duration flush{};
+    SteadyClock::duration chainstate{};
+    SteadyClock::duration post_connect{};
+    SteadyClock::duration total{};
+    //! Applying the authdata of the block to the authList, once the validation interface has done it
+    std::optional<SteadyClock::duration> auth;
+};
+
+/** Validation times of up to count of the latest blocks connected to the active chain, the latest first */
+std::vector<BlockValidationTimes> GetBlockValidationTimes(size_t count);
+/** Record the time the authList took to apply a block connected, if its times are still kept */
+void RecordBlockAuthTime(const uint256& block_hash, SteadyClock::duration time);
+
 /**
  * Provides an interface for creating and interacting with one or two
  * chainstates: an IBD chainstate generated by downloading blocks, and
@@ -922,12 +1183,14 @@ private:
      * Caller must set min_pow_checked=true in order to add a new header to the
      * block index (permanent memory storage), indicating that the header is
      * known to be part of a sufficiently high-work chain (anti-dos check).
+     * Caller may set check_pow=false if the header's proof of work was checked already.
      */
     bool AcceptBlockHeader(
         const CBlockHeader& block,
         BlockValidationState& state,
         CBlockIndex** ppindex,
-        bool min_pow_checked) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+        bool min_pow_checked,
+        bool check_pow = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     friend Chainstate;
 
     /** Most recent headers presync progress update, for rate-limiting. */
@@ -1003,6 +1266,14 @@ public:
     /** Best header we've seen so far (used for getheaders queries' starting points). */
     CBlockIndex* m_best_header GUARDED_BY(::cs_main){nullptr};
 
+private:
+    //! Published under cs_main, read without it by GetTipSnapshot()
+    std::shared_ptr<const TipSnapshot> m_tip_snapshot;
+    //! The stakes of the network as of the tip last published
+    StakeKernelRate m_stake_kernel_rate GUARDED_BY(::cs_main);
+
+public:
+
     //! The total number of bytes available for us to use across all in-memory
     //! coins caches. This will be split somehow across chainstates.
     int64_t m_total_coinstip_cache{0};
@@ -1048,6 +1319,12 @@ public:
             [](bilingual_str msg) { AbortNode(msg.original, msg); })
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
+    //! The tip of the active chain as last published, nullptr before the chain is loaded.
+    std::shared_ptr<const TipSnapshot> GetTipSnapshot() const { return std::atomic_load(&m_tip_snapshot); }
+
+    //! Publish the tip of the active chain for GetTipSnapshot().
+    void PublishTip(const CBlockIndex* tip) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     //! The most-work chain.
     Chainstate& ActiveChainstate() const;
     CChain& ActiveChain() const EXCLUSIVE_LOCKS_REQUIRED(GetMutex()) { return ActiveChainstate().m_chain; }
@@ -1113,8 +1390,9 @@ public:
      * @param[in]  min_pow_checked  True if proof-of-work anti-DoS checks have been done by caller for headers chain
      * @param[out] state This may be set to an Error state if any error occurred processing them
      * @param[out] ppindex If set, the pointer will be set to point to the last new block index object for the given headers
+     * @param[in]  pow_checked  True if the caller has already checked the proof of work of every header, see HasValidProofOfWork()
      */
-    bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, bool min_pow_checked, BlockValidationState& state, const CBlockIndex** ppindex = nullptr) LOCKS_EXCLUDED(cs_main);
+    bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, bool min_pow_checked, BlockValidationState& state, const CBlockIndex** ppindex = nullptr, bool pow_checked = false) LOCKS_EXCLUDED(cs_main);
 
     /**
      * Try to add a transaction to the memory pool.
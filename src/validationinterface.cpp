@@ -12,13 +12,115 @@
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <scheduler.h>
+#include <util/thread.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <future>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 
 std::string RemovalReasonToString(const MemPoolRemovalReason& r) noexcept;
 
+/**
+ * Queue and thread delivering the queued notifications of one subscriber, in
+ * the order they were signalled, so that it neither waits for nor holds up the
+ * other subscribers.
+ */
+class NotificationLane
+{
+private:
+    struct Item {
+        std::function<void()> fn;
+        //! Run even once the lane is stopped, as someone waits for it
+        bool barrier;
+    };
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Item> m_queue GUARDED_BY(m_mutex);
+    bool m_busy GUARDED_BY(m_mutex){false};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::atomic<uint64_t> m_delivered{0};
+    std::thread m_thread;
+
+    void Run(std::shared_ptr<NotificationLane> self) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        while (true) {
+            m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || !m_queue.empty(); });
+            if (m_stop) return;
+            Item item{std::move(m_queue.front())};
+            m_queue.pop_front();
+            m_busy = true;
+            {
+                REVERSE_LOCK(lock);
+                item.fn();
+                if (!item.barrier) ++m_delivered;
+            }
+            m_busy = false;
+        }
+    }
+
+public:
+    const std::string m_name;
+
+    explicit NotificationLane(std::string name) : m_name{std::move(name)} {}
+
+    NotificationLane(const NotificationLane&) = delete;
+    NotificationLane& operator=(const NotificationLane&) = delete;
+
+    //! The thread holds on to the lane until it exits
+    static std::shared_ptr<NotificationLane> Start(const std::string& name)
+    {
+        auto lane{std::make_shared<NotificationLane>(name)};
+        lane->m_thread = std::thread(&util::TraceThread, "val." + name, [lane] { lane->Run(lane); });
+        return lane;
+    }
+
+    void Add(std::function<void()> fn, bool barrier = false) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        {
+            LOCK(m_mutex);
+            if (!m_stop) {
+                m_queue.push_back({std::move(fn), barrier});
+                m_cond.notify_one();
+                return;
+            }
+        }
+        if (barrier) fn();
+    }
+
+    /** Drop the notifications not delivered yet, and wait for the one being delivered. */
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        std::deque<Item> dropped;
+        {
+            LOCK(m_mutex);
+            m_stop = true;
+            dropped.swap(m_queue);
+        }
+        m_cond.notify_all();
+        // A subscriber may unregister itself from one of its own notifications
+        if (m_thread.get_id() == std::this_thread::get_id()) {
+            m_thread.detach();
+        } else if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        for (Item& item : dropped) {
+            if (item.barrier) item.fn();
+        }
+    }
+
+    ValidationLaneInfo GetInfo() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        return {m_name, m_queue.size() + (m_busy ? 1 : 0), m_delivered.load()};
+    }
+};
+
 /**
  * MainSignalsImpl manages a list of shared_ptr<CValidationInterface> callbacks.
  *
@@ -35,11 +137,26 @@ private:
     //! count is equal to the number of current executions of that entry, plus 1
     //! if it's registered. It cannot be 0 because that would imply it is
     //! unregistered and also not being executed (so shouldn't exist).
-    struct ListEntry { std::shared_ptr<CValidationInterface> callbacks; int count = 1; };
+    //! Subscribers with a lane get their queued notifications on it, rather
+    //! than from the shared queue.
+    struct ListEntry { std::shared_ptr<CValidationInterface> callbacks; int count = 1; std::shared_ptr<NotificationLane> lane; };
     std::list<ListEntry> m_list GUARDED_BY(m_mutex);
     std::unordered_map<CValidationInterface*, std::list<ListEntry>::iterator> m_map GUARDED_BY(m_mutex);
 
+    std::vector<std::shared_ptr<NotificationLane>> Lanes() EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        std::vector<std::shared_ptr<NotificationLane>> lanes;
+        for (const auto& entry : m_map) {
+            if (entry.second->lane) lanes.push_back(entry.second->lane);
+        }
+        return lanes;
+    }
+
 public:
+    //! Registered subscribers that want the undo data of disconnected blocks, read without m_mutex
+    //! by DisconnectTip
+    std::atomic<size_t> m_undo_subscribers{0};
+
     // We are not allowed to assume the scheduler only runs in one thread,
     // but must ensure all callbacks happen in-order, so we end up creating
     // our own queue here :(
@@ -47,22 +164,33 @@ public:
 
     explicit MainSignalsImpl(CScheduler& scheduler LIFETIMEBOUND) : m_schedulerClient(scheduler) {}
 
-    void Register(std::shared_ptr<CValidationInterface> callbacks) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    ~MainSignalsImpl() { Clear(); }
+
+    void Register(std::shared_ptr<CValidationInterface> callbacks, const std::string& lane_name) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
         LOCK(m_mutex);
         auto inserted = m_map.emplace(callbacks.get(), m_list.end());
         if (inserted.second) inserted.first->second = m_list.emplace(m_list.end());
+        if (inserted.second && callbacks->WantsDisconnectedUndo()) ++m_undo_subscribers;
         inserted.first->second->callbacks = std::move(callbacks);
+        if (inserted.second && !lane_name.empty()) inserted.first->second->lane = NotificationLane::Start(lane_name);
     }
 
     void Unregister(CValidationInterface* callbacks) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        LOCK(m_mutex);
-        auto it = m_map.find(callbacks);
-        if (it != m_map.end()) {
-            if (!--it->second->count) m_list.erase(it->second);
-            m_map.erase(it);
+        std::shared_ptr<NotificationLane> lane;
+        {
+            LOCK(m_mutex);
+            auto it = m_map.find(callbacks);
+            if (it != m_map.end()) {
+                if (it->second->callbacks->WantsDisconnectedUndo()) --m_undo_subscribers;
+                lane = std::move(it->second->lane);
+                if (!--it->second->count) m_list.erase(it->second);
+                m_map.erase(it);
+            }
         }
+        // Outside of m_mutex, as a notification being delivered may register or unregister
+        if (lane) lane->Stop();
     }
 
     //! Clear unregisters every previously registered callback, erasing every
@@ -71,17 +199,32 @@ public:
     //! executing.
     void Clear() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
-        LOCK(m_mutex);
-        for (const auto& entry : m_map) {
-            if (!--entry.second->count) m_list.erase(entry.second);
+        std::vector<std::shared_ptr<NotificationLane>> lanes;
+        {
+            LOCK(m_mutex);
+            lanes = Lanes();
+            for (const auto& entry : m_map) {
+                entry.second->lane.reset();
+                if (!--entry.second->count) m_list.erase(entry.second);
+            }
+            m_map.clear();
+            m_undo_subscribers = 0;
+        }
+        for (const auto& lane : lanes) {
+            lane->Stop();
         }
-        m_map.clear();
     }
 
-    template<typename F> void Iterate(F&& f) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    //! Call f for each subscriber, or with queued set, for each of those
+    //! without a lane of their own.
+    template<typename F> void Iterate(F&& f, bool queued = false) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
         WAIT_LOCK(m_mutex, lock);
         for (auto it = m_list.begin(); it != m_list.end();) {
+            if (queued && it->lane) {
+                ++it;
+                continue;
+            }
             ++it->count;
             {
                 REVERSE_LOCK(lock);
@@ -90,6 +233,53 @@ public:
             it = --it->count ? std::next(it) : m_list.erase(it);
         }
     }
+
+    //! Queue a notification on the lane of each subscriber that has one.
+    void EnqueueOnLanes(const std::function<void(CValidationInterface&)>& event) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        LOCK(m_mutex);
+        for (const auto& entry : m_map) {
+            if (!entry.second->lane) continue;
+            entry.second->lane->Add([callbacks = entry.second->callbacks, event] { event(*callbacks); });
+        }
+    }
+
+    //! Call func once everything queued so far, on the shared queue and the lanes, has been delivered.
+    void CallAfterQueued(std::function<void()> func) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        const auto lanes{WITH_LOCK(m_mutex, return Lanes())};
+        if (lanes.empty()) {
+            m_schedulerClient.AddToProcessQueue(std::move(func));
+            return;
+        }
+        auto remaining{std::make_shared<std::atomic<size_t>>(lanes.size() + 1)};
+        auto arrive{[remaining, func = std::make_shared<std::function<void()>>(std::move(func))] {
+            if (--*remaining == 0) (*func)();
+        }};
+        m_schedulerClient.AddToProcessQueue(arrive);
+        for (const auto& lane : lanes) {
+            lane->Add(arrive, /*barrier=*/true);
+        }
+    }
+
+    //! Wait for the lanes to deliver what was queued on them.
+    void DrainLanes() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        for (const auto& lane : WITH_LOCK(m_mutex, return Lanes())) {
+            std::promise<void> drained;
+            lane->Add([&drained] { drained.set_value(); }, /*barrier=*/true);
+            drained.get_future().wait();
+        }
+    }
+
+    std::vector<ValidationLaneInfo> GetLaneInfo() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        std::vector<ValidationLaneInfo> info;
+        for (const auto& lane : WITH_LOCK(m_mutex, return Lanes())) {
+            info.push_back(lane->GetInfo());
+        }
+        return info;
+    }
 };
 
 static CMainSignals g_signals;
@@ -109,13 +299,29 @@ void CMainSignals::FlushBackgroundCallbacks()
 {
     if (m_internals) {
         m_internals->m_schedulerClient.EmptyQueue();
+        m_internals->DrainLanes();
     }
 }
 
 size_t CMainSignals::CallbacksPending()
 {
     if (!m_internals) return 0;
-    return m_internals->m_schedulerClient.CallbacksPending();
+    size_t pending{m_internals->m_schedulerClient.CallbacksPending()};
+    for (const ValidationLaneInfo& lane : m_internals->GetLaneInfo()) {
+        pending = std::max(pending, lane.pending);
+    }
+    return pending;
+}
+
+std::vector<ValidationLaneInfo> CMainSignals::GetLaneInfo()
+{
+    if (!m_internals) return {};
+    return m_internals->GetLaneInfo();
+}
+
+bool CMainSignals::WantsDisconnectedUndo() const
+{
+    return m_internals && m_internals->m_undo_subscribers > 0;
 }
 
 CMainSignals& GetMainSignals()
@@ -123,18 +329,18 @@ CMainSignals& GetMainSignals()
     return g_signals;
 }
 
-void RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks)
+void RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks, const std::string& lane)
 {
     // Each connection captures the shared_ptr to ensure that each callback is
     // executed before the subscriber is destroyed. For more details see #18338.
-    g_signals.m_internals->Register(std::move(callbacks));
+    g_signals.m_internals->Register(std::move(callbacks), lane);
 }
 
-void RegisterValidationInterface(CValidationInterface* callbacks)
+void RegisterValidationInterface(CValidationInterface* callbacks, const std::string& lane)
 {
     // Create a shared_ptr with a no-op deleter - CValidationInterface lifecycle
     // is managed by the caller.
-    RegisterSharedValidationInterface({callbacks, [](CValidationInterface*){}});
+    RegisterSharedValidationInterface({callbacks, [](CValidationInterface*){}}, lane);
 }
 
 void UnregisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks)
@@ -159,7 +365,7 @@ void UnregisterAllValidationInterfaces()
 
 void CallFunctionInValidationInterfaceQueue(std::function<void()> func)
 {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    g_signals.m_internals->CallAfterQueued(std::move(func));
 }
 
 void SyncWithValidationInterfaceQueue()
@@ -177,14 +383,17 @@ void SyncWithValidationInterfaceQueue()
 // evaluating arguments when logging is not enabled.
 //
 // NOTE: The lambda captures all local variables by value.
+// event is called for each subscriber: from the shared queue for those
+// without a lane, and from their own lane for the others.
 #define ENQUEUE_AND_LOG_EVENT(event, fmt, name, ...)           \
     do {                                                       \
         auto local_name = (name);                              \
         LOG_EVENT("Enqueuing " fmt, local_name, __VA_ARGS__);  \
         m_internals->m_schedulerClient.AddToProcessQueue([=] { \
             LOG_EVENT(fmt, local_name, __VA_ARGS__);           \
-            event();                                           \
+            m_internals->Iterate(event, /*queued=*/true);      \
         });                                                    \
+        m_internals->EnqueueOnLanes(event);                    \
     } while (0)
 
 #define LOG_EVENT(fmt, ...) \
@@ -195,8 +404,8 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
     // the chain actually updates. One way to ensure this is for the caller to invoke this signal
     // in the same critical section where the chain is updated
 
-    auto event = [pindexNew, pindexFork, fInitialDownload, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload); });
+    auto event = [pindexNew, pindexFork, fInitialDownload](CValidationInterface& callbacks) {
+        callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: new block hash=%s fork block hash=%s (in IBD=%s)", __func__,
                           pindexNew->GetBlockHash().ToString(),
@@ -205,8 +414,8 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
 }
 
 void CMainSignals::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence) {
-    auto event = [tx, mempool_sequence, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.TransactionAddedToMempool(tx, mempool_sequence); });
+    auto event = [tx, mempool_sequence](CValidationInterface& callbacks) {
+        callbacks.TransactionAddedToMempool(tx, mempool_sequence);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s wtxid=%s", __func__,
                           tx->GetHash().ToString(),
@@ -214,8 +423,8 @@ void CMainSignals::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t
 }
 
 void CMainSignals::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) {
-    auto event = [tx, reason, mempool_sequence, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.TransactionRemovedFromMempool(tx, reason, mempool_sequence); });
+    auto event = [tx, reason, mempool_sequence](CValidationInterface& callbacks) {
+        callbacks.TransactionRemovedFromMempool(tx, reason, mempool_sequence);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s wtxid=%s reason=%s", __func__,
                           tx->GetHash().ToString(),
@@ -224,8 +433,8 @@ void CMainSignals::TransactionRemovedFromMempool(const CTransactionRef& tx, MemP
 }
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex) {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.BlockConnected(pblock, pindex); });
+    auto event = [pblock, pindex](CValidationInterface& callbacks) {
+        callbacks.BlockConnected(pblock, pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s block height=%d", __func__,
                           pblock->GetHash().ToString(),
@@ -234,17 +443,27 @@ void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, c
 
 void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex)
 {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.BlockDisconnected(pblock, pindex); });
+    auto event = [pblock, pindex](CValidationInterface& callbacks) {
+        callbacks.BlockDisconnected(pblock, pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s block height=%d", __func__,
                           pblock->GetHash().ToString(),
                           pindex->nHeight);
 }
 
+void CMainSignals::BlockDisconnectedWithUndo(const std::shared_ptr<const DisconnectedBlock>& disconnected)
+{
+    auto event = [disconnected](CValidationInterface& callbacks) {
+        callbacks.BlockDisconnectedWithUndo(disconnected);
+    };
+    ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s block height=%d", __func__,
+                          disconnected->pindex->GetBlockHash().ToString(),
+                          disconnected->pindex->nHeight);
+}
+
 void CMainSignals::ChainStateFlushed(const CBlockLocator &locator) {
-    auto event = [locator, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.ChainStateFlushed(locator); });
+    auto event = [locator](CValidationInterface& callbacks) {
+        callbacks.ChainStateFlushed(locator);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s", __func__,
                           locator.IsNull() ? "null" : locator.vHave.front().ToString());
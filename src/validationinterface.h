@@ -10,19 +10,48 @@
 #include <primitives/transaction.h> // CTransaction(Ref)
 #include <sync.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 class BlockValidationState;
 class CBlock;
 class CBlockIndex;
+class CBlockUndo;
 struct CBlockLocator;
 class CValidationInterface;
 class CScheduler;
 enum class MemPoolRemovalReason;
 
-/** Register subscriber */
-void RegisterValidationInterface(CValidationInterface* callbacks);
+/**
+ * A block disconnected from the active chain, with the undo data read to
+ * disconnect it. One payload is shared by every subscriber.
+ */
+struct DisconnectedBlock {
+    const CBlockIndex* pindex;
+    std::shared_ptr<const CBlock> block;
+    //! Null unless a subscriber wants the undo data, see CValidationInterface::WantsDisconnectedUndo
+    std::shared_ptr<const CBlockUndo> undo;
+};
+
+/** What a subscriber with a notification lane of its own has delivered and has yet to */
+struct ValidationLaneInfo {
+    std::string name;
+    //! Notifications queued on the lane, including the one being delivered
+    size_t pending{0};
+    uint64_t delivered{0};
+};
+
+/**
+ * Register subscriber. With a lane name, its queued notifications (all but
+ * BlockChecked and NewPoWValidBlock) are delivered in order on a thread of its
+ * own, named after the lane, rather than from the queue shared by the others,
+ * so that a slow subscriber neither waits for nor holds up the rest.
+ */
+void RegisterValidationInterface(CValidationInterface* callbacks, const std::string& lane = "");
 /** Unregister subscriber. DEPRECATED. This is not safe to use when the RPC server or main message handler thread is running. */
 void UnregisterValidationInterface(CValidationInterface* callbacks);
 /** Unregister all subscribers */
@@ -32,14 +61,16 @@ void UnregisterAllValidationInterfaces();
 // notification is sent. These are useful for race-free cleanup, since
 // unregistration is nonblocking and can return before the last notification is
 // processed.
-/** Register subscriber */
-void RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks);
+/** Register subscriber, see RegisterValidationInterface */
+void RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks, const std::string& lane = "");
 /** Unregister subscriber */
 void UnregisterSharedValidationInterface(std::shared_ptr<CValidationInterface> callbacks);
 
 /**
  * Pushes a function to callback onto the notification queue, guaranteeing any
  * callbacks generated prior to now are finished when the function is called.
+ * With subscribers on lanes of their own, it is called from whichever of the
+ * shared queue and the lanes gets to it last.
  *
  * Be very careful blocking on func to be called if any locks are held -
  * validation interface clients may not be able to make progress as they often
@@ -74,6 +105,14 @@ void SyncWithValidationInterfaceQueue() LOCKS_EXCLUDED(cs_main);
  * ValidationInterface() subscribers.
  */
 class CValidationInterface {
+public:
+    /**
+     * Whether BlockDisconnectedWithUndo is to carry the undo data of the
+     * block, which DisconnectTip otherwise does not keep. Asked once, as the
+     * subscriber registers.
+     */
+    virtual bool WantsDisconnectedUndo() const { return false; }
+
 protected:
     /**
      * Protected destructor so that instances can only be deleted by derived classes.
@@ -143,6 +182,14 @@ protected:
      * Called on a background thread.
      */
     virtual void BlockDisconnected(const std::shared_ptr<const CBlock> &block, const CBlockIndex* pindex) {}
+    /**
+     * Notifies listeners of a block being disconnected with its undo data,
+     * right before BlockDisconnected, so that indexes rewinding past it need
+     * not read either from disk again.
+     *
+     * Called on a background thread.
+     */
+    virtual void BlockDisconnectedWithUndo(const std::shared_ptr<const DisconnectedBlock>& disconnected) {}
     /**
      * Notifies listeners of the new active block chain on-disk.
      *
@@ -180,7 +227,7 @@ class CMainSignals {
 private:
     std::unique_ptr<MainSignalsImpl> m_internals;
 
-    friend void ::RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface>);
+    friend void ::RegisterSharedValidationInterface(std::shared_ptr<CValidationInterface>, const std::string&);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
     friend void ::CallFunctionInValidationInterfaceQueue(std::function<void ()> func);
@@ -193,7 +240,12 @@ public:
     /** Call any remaining callbacks on the calling thread */
     void FlushBackgroundCallbacks();
 
+    /** Notifications queued for the slowest of the shared queue and the lanes */
     size_t CallbacksPending();
+    /** Backlog of each subscriber with a lane of its own */
+    std::vector<ValidationLaneInfo> GetLaneInfo();
+    /** Whether a subscriber registered wants the undo data of disconnected blocks */
+    bool WantsDisconnectedUndo() const;
 
 
     void UpdatedBlockTip(const CBlockIndex *, const CBlockIndex *, bool fInitialDownload);
@@ -201,6 +253,7 @@ public:
     void TransactionRemovedFromMempool(const CTransactionRef&, MemPoolRemovalReason, uint64_t mempool_sequence);
     void BlockConnected(const std::shared_ptr<const CBlock> &, const CBlockIndex *pindex);
     void BlockDisconnected(const std::shared_ptr<const CBlock> &, const CBlockIndex* pindex);
+    void BlockDisconnectedWithUndo(const std::shared_ptr<const DisconnectedBlock>&);
     void ChainStateFlushed(const CBlockLocator &);
     void BlockChecked(const CBlock&, const BlockValidationState&);
     void NewPoWValidBlock(const CBlockIndex *, const std::shared_ptr<const CBlock>&);
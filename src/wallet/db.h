@@ -164,6 +164,9 @@ public:
 
     virtual std::string Format() = 0;
 
+    /** Whether a transaction begun on one batch takes in the writes of the other batches of the database */
+    virtual bool BatchesShareTxn() const { return false; }
+
     std::atomic<unsigned int> nUpdateCounter;
     unsigned int nLastSeen{0};
     unsigned int nLastFlushed{0};
@@ -232,6 +235,7 @@ struct DatabaseOptions {
     // Specialized options. Not every option is supported by every backend.
     bool verify = true;             //!< Check data integrity on load.
     bool use_unsafe_sync = false;   //!< Disable file sync for faster performance.
+    bool use_wal = false;           //!< Journal to a write-ahead log, syncing it only at checkpoints.
     bool use_shared_memory = false; //!< Let other processes access the database.
     int64_t max_log_mb = 100;       //!< Max log size to allow before consolidating.
 };
@@ -66,12 +66,18 @@ void WalletInit::AddWalletOptions(ArgsManager& argsman) const
                                                             CURRENCY_UNIT, FormatMoney(DEFAULT_TRANSACTION_MINFEE)), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
     argsman.AddArg("-paytxfee=<amt>", strprintf("Fee rate (in %s/kvB) to add to transactions you send (default: %s)",
                                                             CURRENCY_UNIT, FormatMoney(CFeeRate{DEFAULT_PAY_TX_FEE}.GetFeePerK())), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
+    argsman.AddArg("-rescanthreads=<n>", strprintf("Number of threads looking up blocks ahead of the one a rescan is at, checking their block filters if -blockfilterindex is on and reading those that may hold wallet transactions, which are then scanned in order (0 to %d, 0 = look up each block as it is scanned, default: %d)", MAX_RESCAN_THREADS, DEFAULT_RESCAN_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
 #ifdef ENABLE_EXTERNAL_SIGNER
     argsman.AddArg("-signer=<cmd>", "External signing tool, see doc/external-signer.md", ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
 #endif
+    argsman.AddArg("-stakecombinethreshold=<amt>", "Combine stake outputs smaller than this into the coinstakes the wallet stakes (default: the stake target size)", ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
+    argsman.AddArg("-stakemaxcombine=<n>", strprintf("Most outputs combined into a coinstake besides its kernel (default: %u)", DEFAULT_STAKE_MAX_COMBINE), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
+    argsman.AddArg("-stakemaxsplit=<n>", strprintf("Most outputs a coinstake is split into (default: %u)", DEFAULT_STAKE_MAX_SPLIT), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
+    argsman.AddArg("-staketargetsize=<amt>", strprintf("Size of stake output (in %s) the wallet aims for: smaller outputs are combined up to it when staking, and a coinstake is split into outputs of at least this (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_STAKE_TARGET_SIZE)), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
     argsman.AddArg("-spendzeroconfchange", strprintf("Spend unconfirmed change when sending transactions (default: %u)", DEFAULT_SPEND_ZEROCONF_CHANGE), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
     argsman.AddArg("-txconfirmtarget=<n>", strprintf("If paytxfee is not set, include enough fee so transactions begin confirmation on average within n blocks (default: %u)", DEFAULT_TX_CONFIRM_TARGET), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
     argsman.AddArg("-wallet=<path>", "Specify wallet path to load at startup. Can be used multiple times to load multiple wallets. Path is to a directory containing wallet data and log files. If the path is not absolute, it is interpreted relative to <walletdir>. This only loads existing wallets and does not create new ones. For backwards compatibility this also accepts names of existing top-level data files in <walletdir>.", ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::WALLET);
+    argsman.AddArg("-walletarchivedepth=<n>", strprintf("Archive wallet transactions at least this deep, whose outputs are all spent by transactions as deep, out of memory and onto disk, checking every %d blocks. Archived transactions are left out of listtransactions and the GUI, gettransaction reads them from disk (0 = keep all in memory, otherwise at least %d, default: %d)", WALLET_ARCHIVE_INTERVAL, MIN_WALLET_ARCHIVE_DEPTH, DEFAULT_WALLET_ARCHIVE_DEPTH), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
     argsman.AddArg("-walletbroadcast",  strprintf("Make the wallet broadcast transactions (default: %u)", DEFAULT_WALLETBROADCAST), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
     argsman.AddArg("-walletdir=<dir>", "Specify directory to hold wallets (default: <datadir>/wallets if it exists, otherwise <datadir>)", ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::WALLET);
 #if HAVE_SYSTEM
@@ -89,8 +95,9 @@ void WalletInit::AddWalletOptions(ArgsManager& argsman) const
 
 #ifdef USE_SQLITE
     argsman.AddArg("-unsafesqlitesync", "Set SQLite synchronous=OFF to disable waiting for the database to sync to disk. This is unsafe and can cause data loss and corruption. This option is only used by tests to improve their performance (default: false)", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::WALLET_DEBUG_TEST);
+    argsman.AddArg("-walletsqlitewal", strprintf("Journal descriptor wallets to a write-ahead log, syncing to disk at checkpoints rather than on every write. Faster for staking wallets, though the last writes before a power loss may be lost (default: %u)", DatabaseOptions().use_wal), ArgsManager::ALLOW_ANY, OptionsCategory::WALLET);
 #else
-    argsman.AddHiddenArgs({"-unsafesqlitesync"});
+    argsman.AddHiddenArgs({"-unsafesqlitesync", "-walletsqlitewal"});
 #endif
 
     argsman.AddArg("-walletrejectlongchains", strprintf("Wallet will not create transactions that violate mempool chain limits (default: %u)", DEFAULT_WALLET_REJECT_LONG_CHAINS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::WALLET_DEBUG_TEST);
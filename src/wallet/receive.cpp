@@ -16,6 +16,9 @@ isminetype InputIsMine(const CWallet& wallet, const CTxIn& txin)
     if (prev && txin.prevout.n < prev->tx->vout.size()) {
         return wallet.IsMine(prev->tx->vout[txin.prevout.n]);
     }
+    if (const ArchivedOutput* archived = wallet.GetArchivedOutput(txin.prevout)) {
+        return static_cast<isminetype>(archived->mine);
+    }
     return ISMINE_NO;
 }
 
@@ -296,6 +299,7 @@ Balance GetBalance(const CWallet& wallet, const int min_depth, bool avoid_reuse)
     isminefilter reuse_filter = avoid_reuse ? ISMINE_NO : ISMINE_USED;
     {
         LOCK(wallet.cs_wallet);
+        if (const Balance* cached{wallet.GetCachedBalance(min_depth, avoid_reuse)}) return *cached;
         std::set<uint256> trusted_parents;
         for (const auto& entry : wallet.mapWallet)
         {
@@ -315,6 +319,7 @@ Balance GetBalance(const CWallet& wallet, const int min_depth, bool avoid_reuse)
             ret.m_mine_immature += CachedTxGetImmatureCredit(wallet, wtx, ISMINE_SPENDABLE);
             ret.m_watchonly_immature += CachedTxGetImmatureCredit(wallet, wtx, ISMINE_WATCH_ONLY);
         }
+        wallet.SetCachedBalance(min_depth, avoid_reuse, ret);
     }
     return ret;
 }
@@ -493,8 +493,36 @@ RPCHelpMan getbalances()
     };
 }
 
+//! Unspent outputs listunspent looks at for a page, when a cursor is given without page_size
+static constexpr int64_t DEFAULT_UNSPENT_PAGE_SIZE{1000};
+
 RPCHelpMan listunspent()
 {
+    const RPCResult utxo{RPCResult::Type::OBJ, "", "",
+        {
+            {RPCResult::Type::STR_HEX, "txid", "the transaction id"},
+            {RPCResult::Type::NUM, "vout", "the vout value"},
+            {RPCResult::Type::STR, "address", /*optional=*/true, "the lynx address"},
+            {RPCResult::Type::STR, "label", /*optional=*/true, "The associated label, or \"\" for the default label"},
+            {RPCResult::Type::STR, "scriptPubKey", "the script key"},
+            {RPCResult::Type::STR_AMOUNT, "amount", "the transaction output amount in " + CURRENCY_UNIT},
+            {RPCResult::Type::NUM, "confirmations", "The number of confirmations"},
+            {RPCResult::Type::NUM, "ancestorcount", /*optional=*/true, "The number of in-mempool ancestor transactions, including this one (if transaction is in the mempool)"},
+            {RPCResult::Type::NUM, "ancestorsize", /*optional=*/true, "The virtual transaction size of in-mempool ancestors, including this one (if transaction is in the mempool)"},
+            {RPCResult::Type::STR_AMOUNT, "ancestorfees", /*optional=*/true, "The total fees of in-mempool ancestors (including this one) with fee deltas used for mining priority in " + CURRENCY_ATOM + " (if transaction is in the mempool)"},
+            {RPCResult::Type::STR_HEX, "redeemScript", /*optional=*/true, "The redeemScript if scriptPubKey is P2SH"},
+            {RPCResult::Type::STR, "witnessScript", /*optional=*/true, "witnessScript if the scriptPubKey is P2WSH or P2SH-P2WSH"},
+            {RPCResult::Type::BOOL, "spendable", "Whether we have the private keys to spend this output"},
+            {RPCResult::Type::BOOL, "solvable", "Whether we know how to spend this output, ignoring the lack of keys"},
+            {RPCResult::Type::BOOL, "reused", /*optional=*/true, "(only present if avoid_reuse is set) Whether this output is reused/dirty (sent to an address that was previously spent from)"},
+            {RPCResult::Type::STR, "desc", /*optional=*/true, "(only when solvable) A descriptor for spending this output"},
+            {RPCResult::Type::ARR, "parent_descs", /*optional=*/false, "List of parent descriptors for the scriptPubKey of this coin.", {
+                {RPCResult::Type::STR, "desc", "The descriptor string."},
+            }},
+            {RPCResult::Type::BOOL, "safe", "Whether this output is considered safe to spend. Unconfirmed transactions\n"
+                                            "from outside keys and unconfirmed replacement transactions are considered unsafe\n"
+                                            "and are not eligible for spending by fundrawtransaction and sendtoaddress."},
+        }};
     return RPCHelpMan{
                 "listunspent",
                 "\nReturns array of unspent transaction outputs\n"
@@ -516,39 +544,20 @@ RPCHelpMan listunspent()
                             {"maximumAmount", RPCArg::Type::AMOUNT, RPCArg::DefaultHint{"unlimited"}, "Maximum value of each UTXO in " + CURRENCY_UNIT + ""},
                             {"maximumCount", RPCArg::Type::NUM, RPCArg::DefaultHint{"unlimited"}, "Maximum number of UTXOs"},
                             {"minimumSumAmount", RPCArg::Type::AMOUNT, RPCArg::DefaultHint{"unlimited"}, "Minimum sum value of all UTXOs in " + CURRENCY_UNIT + ""},
-                            {"include_immature_coinbase", RPCArg::Type::BOOL, RPCArg::Default{false}, "Include immature coinbase UTXOs"}
+                            {"include_immature_coinbase", RPCArg::Type::BOOL, RPCArg::Default{false}, "Include immature coinbase UTXOs"},
+                            {"page_size", RPCArg::Type::NUM, RPCArg::DefaultHint{"1000 with a cursor, else no pages"}, "Page through the UTXOs by txid: look at the transactions holding about this many unspent outputs,\n"
+                                "taking as long as those however many the wallet holds. Pages may hold fewer UTXOs, as the other filters leave some out"},
+                            {"cursor", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "The cursor of the previous page, to list the UTXOs after it"},
                         },
                         RPCArgOptions{.oneline_description="query_options"}},
                 },
-                RPCResult{
-                    RPCResult::Type::ARR, "", "",
+                {
+                    RPCResult{"without page_size or cursor", RPCResult::Type::ARR, "", "", {utxo}},
+                    RPCResult{"with page_size or cursor", RPCResult::Type::OBJ, "", "",
                     {
-                        {RPCResult::Type::OBJ, "", "",
-                        {
-                            {RPCResult::Type::STR_HEX, "txid", "the transaction id"},
-                            {RPCResult::Type::NUM, "vout", "the vout value"},
-                            {RPCResult::Type::STR, "address", /*optional=*/true, "the lynx address"},
-                            {RPCResult::Type::STR, "label", /*optional=*/true, "The associated label, or \"\" for the default label"},
-                            {RPCResult::Type::STR, "scriptPubKey", "the script key"},
-                            {RPCResult::Type::STR_AMOUNT, "amount", "the transaction output amount in " + CURRENCY_UNIT},
-                            {RPCResult::Type::NUM, "confirmations", "The number of confirmations"},
-                            {RPCResult::Type::NUM, "ancestorcount", /*optional=*/true, "The number of in-mempool ancestor transactions, including this one (if transaction is in the mempool)"},
-                            {RPCResult::Type::NUM, "ancestorsize", /*optional=*/true, "The virtual transaction size of in-mempool ancestors, including this one (if transaction is in the mempool)"},
-                            {RPCResult::Type::STR_AMOUNT, "ancestorfees", /*optional=*/true, "The total fees of in-mempool ancestors (including this one) with fee deltas used for mining priority in " + CURRENCY_ATOM + " (if transaction is in the mempool)"},
-                            {RPCResult::Type::STR_HEX, "redeemScript", /*optional=*/true, "The redeemScript if scriptPubKey is P2SH"},
-                            {RPCResult::Type::STR, "witnessScript", /*optional=*/true, "witnessScript if the scriptPubKey is P2WSH or P2SH-P2WSH"},
-                            {RPCResult::Type::BOOL, "spendable", "Whether we have the private keys to spend this output"},
-                            {RPCResult::Type::BOOL, "solvable", "Whether we know how to spend this output, ignoring the lack of keys"},
-                            {RPCResult::Type::BOOL, "reused", /*optional=*/true, "(only present if avoid_reuse is set) Whether this output is reused/dirty (sent to an address that was previously spent from)"},
-                            {RPCResult::Type::STR, "desc", /*optional=*/true, "(only when solvable) A descriptor for spending this output"},
-                            {RPCResult::Type::ARR, "parent_descs", /*optional=*/false, "List of parent descriptors for the scriptPubKey of this coin.", {
-                                {RPCResult::Type::STR, "desc", "The descriptor string."},
-                            }},
-                            {RPCResult::Type::BOOL, "safe", "Whether this output is considered safe to spend. Unconfirmed transactions\n"
-                                                            "from outside keys and unconfirmed replacement transactions are considered unsafe\n"
-                                                            "and are not eligible for spending by fundrawtransaction and sendtoaddress."},
-                        }},
-                    }
+                        {RPCResult::Type::ARR, "unspents", "The UTXOs of the page", {utxo}},
+                        {RPCResult::Type::STR_HEX, "cursor", /*optional=*/true, "Pass as the cursor option to get the next page, absent on the last one"},
+                    }},
                 },
                 RPCExamples{
                     HelpExampleCli("listunspent", "")
@@ -594,6 +603,9 @@ RPCHelpMan listunspent()
 
     CoinFilterParams filter_coins;
     filter_coins.min_amount = 0;
+    std::optional<int64_t> page_size;
+    std::optional<uint256> cursor;
+    std::optional<uint256> next;
 
     if (!request.params[4].isNull()) {
         const UniValue& options = request.params[4].get_obj();
@@ -604,7 +616,9 @@ RPCHelpMan listunspent()
                 {"maximumAmount", UniValueType()},
                 {"minimumSumAmount", UniValueType()},
                 {"maximumCount", UniValueType(UniValue::VNUM)},
-                {"include_immature_coinbase", UniValueType(UniValue::VBOOL)}
+                {"include_immature_coinbase", UniValueType(UniValue::VBOOL)},
+                {"page_size", UniValueType(UniValue::VNUM)},
+                {"cursor", UniValueType(UniValue::VSTR)},
             },
             true, true);
 
@@ -623,6 +637,16 @@ RPCHelpMan listunspent()
         if (options.exists("include_immature_coinbase")) {
             filter_coins.include_immature_coinbase = options["include_immature_coinbase"].get_bool();
         }
+
+        if (options.exists("page_size") || options.exists("cursor")) {
+            page_size = options.exists("page_size") ? options["page_size"].getInt<int64_t>() : DEFAULT_UNSPENT_PAGE_SIZE;
+            if (*page_size < 1) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "page_size must be at least 1");
+            }
+        }
+        if (options.exists("cursor")) {
+            cursor = ParseHashO(options, "cursor");
+        }
     }
 
     // Make sure the results are valid at least up to the most recent block
@@ -638,6 +662,22 @@ RPCHelpMan listunspent()
         cctl.m_max_depth = nMaxDepth;
         cctl.m_include_unsafe_inputs = include_unsafe;
         LOCK(pwallet->cs_wallet);
+        std::vector<const CWalletTx*> page_txs;
+        if (page_size) {
+            int64_t unspent_outputs{0};
+            std::optional<uint256> last;
+            pwallet->ForEachTxWithUnspent(cursor, [&](const CWalletTx& wtx, size_t unspent) {
+                if (unspent_outputs >= *page_size) {
+                    next = last;
+                    return false;
+                }
+                page_txs.push_back(&wtx);
+                unspent_outputs += unspent;
+                last = wtx.GetHash();
+                return true;
+            });
+            filter_coins.only_txs = &page_txs;
+        }
         vecOutputs = AvailableCoinsListUnspent(*pwallet, &cctl, filter_coins).All();
     }
 
@@ -726,6 +766,12 @@ RPCHelpMan listunspent()
         results.push_back(entry);
     }
 
+    if (page_size) {
+        UniValue page{UniValue::VOBJ};
+        page.pushKV("unspents", results);
+        if (next) page.pushKV("cursor", next->GetHex());
+        return page;
+    }
     return results;
 },
     };
@@ -397,6 +397,37 @@ static void ListTransactions(const CWallet& wallet, const CWalletTx& wtx, int nM
 }
 
 
+//! The cursor a page of transactions returns: the height and order position of its last transaction
+static std::string TxListCursorToString(const TxListCursor& cursor)
+{
+    return strprintf("%d:%d", cursor.height, cursor.order_pos);
+}
+
+static TxListCursor ParseTxListCursor(const UniValue& value)
+{
+    const std::string& str{value.get_str()};
+    const size_t separator{str.find(':')};
+    if (separator != std::string::npos) {
+        const auto height{ToIntegral<int>(str.substr(0, separator))};
+        const auto order_pos{ToIntegral<int64_t>(str.substr(separator + 1))};
+        if (height && order_pos) return {*height, *order_pos};
+    }
+    throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor: " + str);
+}
+
+//! The exclude_coinstakes, min_height and max_height options of the listings that page through the wallet
+static TxListFilter ParseTxListFilter(const UniValue& options)
+{
+    TxListFilter filter;
+    if (options.exists("exclude_coinstakes")) filter.exclude_coinstakes = options["exclude_coinstakes"].get_bool();
+    if (options.exists("min_height")) filter.min_height = options["min_height"].getInt<int>();
+    if (options.exists("max_height")) filter.max_height = options["max_height"].getInt<int>();
+    if (filter.min_height < 0 || filter.max_height < filter.min_height) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+    }
+    return filter;
+}
+
 static std::vector<RPCResult> TransactionDescriptionString()
 {
     return{{RPCResult::Type::NUM, "confirmations", "The number of confirmations for the transaction. Negative confirmations means the\n"
@@ -430,42 +461,56 @@ static std::vector<RPCResult> TransactionDescriptionString()
 
 RPCHelpMan listtransactions()
 {
+    const RPCResult entry{RPCResult::Type::OBJ, "", "", Cat(Cat<std::vector<RPCResult>>(
+        {
+            {RPCResult::Type::BOOL, "involvesWatchonly", /*optional=*/true, "Only returns true if imported addresses were involved in transaction."},
+            {RPCResult::Type::STR, "address",  /*optional=*/true, "The lynx address of the transaction (not returned if the output does not have an address, e.g. OP_RETURN null data)."},
+            {RPCResult::Type::STR, "category", "The transaction category.\n"
+                "\"send\"                  Transactions sent.\n"
+                "\"receive\"               Non-coinbase transactions received.\n"
+                "\"generate\"              Coinbase transactions received with more than 100 confirmations.\n"
+                "\"immature\"              Coinbase transactions received with 100 or fewer confirmations.\n"
+                "\"orphan\"                Orphaned coinbase transactions received."},
+            {RPCResult::Type::STR_AMOUNT, "amount", "The amount in " + CURRENCY_UNIT + ". This is negative for the 'send' category, and is positive\n"
+                "for all other categories"},
+            {RPCResult::Type::STR, "label", /*optional=*/true, "A comment for the address/transaction, if any"},
+            {RPCResult::Type::NUM, "vout", "the vout value"},
+            {RPCResult::Type::STR_AMOUNT, "fee", /*optional=*/true, "The amount of the fee in " + CURRENCY_UNIT + ". This is negative and only available for the\n"
+                 "'send' category of transactions."},
+        },
+        TransactionDescriptionString()),
+        {
+            {RPCResult::Type::BOOL, "abandoned", /*optional=*/true, "'true' if the transaction has been abandoned (inputs are respendable). Only available for the \n"
+                 "'send' category of transactions."},
+        })};
     return RPCHelpMan{"listtransactions",
                 "\nIf a label name is provided, this will return only incoming transactions paying to addresses with the specified label.\n"
-                "\nReturns up to 'count' most recent transactions skipping the first 'from' transactions.\n",
+                "\nReturns up to 'count' most recent transactions skipping the first 'from' transactions.\n"
+                "\nWith options, returns a page of the transactions before the cursor given instead, taking as long as the\n"
+                "transactions the page looks at however many the wallet holds, and the cursor to the next page.\n",
                 {
                     {"label|dummy", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "If set, should be a valid label name to return only incoming transactions\n"
                           "with the specified label, or \"*\" to disable filtering and return all transactions."},
-                    {"count", RPCArg::Type::NUM, RPCArg::Default{10}, "The number of transactions to return"},
-                    {"skip", RPCArg::Type::NUM, RPCArg::Default{0}, "The number of transactions to skip"},
+                    {"count", RPCArg::Type::NUM, RPCArg::Default{10}, "The number of transactions to return. A page ends with the transaction that reaches it"},
+                    {"skip", RPCArg::Type::NUM, RPCArg::Default{0}, "The number of transactions to skip, not with options"},
                     {"include_watchonly", RPCArg::Type::BOOL, RPCArg::DefaultHint{"true for watch-only wallets, otherwise false"}, "Include transactions to watch-only addresses (see 'importaddress')"},
-                },
-                RPCResult{
-                    RPCResult::Type::ARR, "", "",
-                    {
-                        {RPCResult::Type::OBJ, "", "", Cat(Cat<std::vector<RPCResult>>(
+                    {"options", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "Page through the transactions",
                         {
-                            {RPCResult::Type::BOOL, "involvesWatchonly", /*optional=*/true, "Only returns true if imported addresses were involved in transaction."},
-                            {RPCResult::Type::STR, "address",  /*optional=*/true, "The lynx address of the transaction (not returned if the output does not have an address, e.g. OP_RETURN null data)."},
-                            {RPCResult::Type::STR, "category", "The transaction category.\n"
-                                "\"send\"                  Transactions sent.\n"
-                                "\"receive\"               Non-coinbase transactions received.\n"
-                                "\"generate\"              Coinbase transactions received with more than 100 confirmations.\n"
-                                "\"immature\"              Coinbase transactions received with 100 or fewer confirmations.\n"
-                                "\"orphan\"                Orphaned coinbase transactions received."},
-                            {RPCResult::Type::STR_AMOUNT, "amount", "The amount in " + CURRENCY_UNIT + ". This is negative for the 'send' category, and is positive\n"
-                                "for all other categories"},
-                            {RPCResult::Type::STR, "label", /*optional=*/true, "A comment for the address/transaction, if any"},
-                            {RPCResult::Type::NUM, "vout", "the vout value"},
-                            {RPCResult::Type::STR_AMOUNT, "fee", /*optional=*/true, "The amount of the fee in " + CURRENCY_UNIT + ". This is negative and only available for the\n"
-                                 "'send' category of transactions."},
+                            {"cursor", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "The cursor of the previous page, to list the transactions before it"},
+                            {"exclude_coinstakes", RPCArg::Type::BOOL, RPCArg::Default{false}, "Leave out coinstakes"},
+                            {"min_height", RPCArg::Type::NUM, RPCArg::Default{0}, "Only transactions confirmed at this height or above"},
+                            {"max_height", RPCArg::Type::NUM, RPCArg::DefaultHint{"unlimited, with unconfirmed transactions"}, "Only transactions confirmed at this height or below.\n"
+                                "With a height range, transactions are listed by height rather than in the order the wallet added them"},
                         },
-                        TransactionDescriptionString()),
-                        {
-                            {RPCResult::Type::BOOL, "abandoned", /*optional=*/true, "'true' if the transaction has been abandoned (inputs are respendable). Only available for the \n"
-                                 "'send' category of transactions."},
-                        })},
-                    }
+                        RPCArgOptions{.oneline_description="options"}},
+                },
+                {
+                    RPCResult{"without options", RPCResult::Type::ARR, "", "", {entry}},
+                    RPCResult{"with options", RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::ARR, "transactions", "The page, oldest first", {entry}},
+                        {RPCResult::Type::STR, "cursor", /*optional=*/true, "Pass as the cursor option to get the next page, absent on the last one"},
+                    }},
                 },
                 RPCExamples{
             "\nList the most recent 10 transactions in the systems\n"
@@ -473,7 +518,10 @@ RPCHelpMan listtransactions()
             "\nList transactions 100 to 120\n"
             + HelpExampleCli("listtransactions", "\"*\" 20 100") +
             "\nAs a JSON-RPC call\n"
-            + HelpExampleRpc("listtransactions", "\"*\", 20, 100")
+            + HelpExampleRpc("listtransactions", "\"*\", 20, 100") +
+            "\nList the 100 most recent transactions other than coinstakes, then the 100 before them\n"
+            + HelpExampleCli("listtransactions", "\"*\" 100 0 false '{\"exclude_coinstakes\": true}'")
+            + HelpExampleCli("listtransactions", "\"*\" 100 0 false '{\"exclude_coinstakes\": true, \"cursor\": \"cursor\"}'")
                 },
         [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
 {
@@ -508,6 +556,49 @@ RPCHelpMan listtransactions()
     if (nFrom < 0)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative from");
 
+    if (!request.params[4].isNull()) {
+        if (nFrom > 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "skip cannot be used with options, pass the cursor of the previous page instead");
+        }
+        const UniValue& options = request.params[4].get_obj();
+        RPCTypeCheckObj(options,
+            {
+                {"cursor", UniValueType(UniValue::VSTR)},
+                {"exclude_coinstakes", UniValueType(UniValue::VBOOL)},
+                {"min_height", UniValueType(UniValue::VNUM)},
+                {"max_height", UniValueType(UniValue::VNUM)},
+            },
+            true, true);
+        TxListFilter list_filter{ParseTxListFilter(options)};
+        list_filter.label = filter_label;
+        std::optional<TxListCursor> cursor;
+        if (options.exists("cursor")) cursor = ParseTxListCursor(options["cursor"]);
+
+        std::vector<UniValue> ret;
+        std::optional<TxListCursor> next;
+        {
+            LOCK(pwallet->cs_wallet);
+            std::optional<TxListCursor> last;
+            pwallet->ForEachListedTx(list_filter, cursor, [&](const CWalletTx& wtx, const TxListCursor& position) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet) {
+                if ((int)ret.size() >= nCount) {
+                    next = last;
+                    return false;
+                }
+                ListTransactions(*pwallet, wtx, 0, true, ret, filter, filter_label);
+                last = position;
+                return true;
+            });
+        }
+
+        // ret is newest to oldest
+        UniValue transactions{UniValue::VARR};
+        transactions.push_backV(std::make_move_iterator(ret.rbegin()), std::make_move_iterator(ret.rend()));
+        UniValue result{UniValue::VOBJ};
+        result.pushKV("transactions", transactions);
+        if (next) result.pushKV("cursor", TxListCursorToString(*next));
+        return result;
+    }
+
     std::vector<UniValue> ret;
     {
         LOCK(pwallet->cs_wallet);
@@ -552,6 +643,13 @@ RPCHelpMan listsinceblock()
                                                                        "(not guaranteed to work on pruned nodes)"},
                     {"include_change", RPCArg::Type::BOOL, RPCArg::Default{false}, "Also add entries for change outputs.\n"},
                     {"label", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Return only incoming transactions paying to addresses with the specified label.\n"},
+                    {"options", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "Page through the transactions, newest first, each page taking as long as the transactions it looks at",
+                        {
+                            {"page_size", RPCArg::Type::NUM, RPCArg::Default{1000}, "The number of transactions to return. A page ends with the transaction that reaches it"},
+                            {"cursor", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "The cursor of the previous page, to list the transactions before it. \"removed\" is only returned on the first page"},
+                            {"exclude_coinstakes", RPCArg::Type::BOOL, RPCArg::Default{false}, "Leave out coinstakes"},
+                        },
+                        RPCArgOptions{.oneline_description="options"}},
                 },
                 RPCResult{
                     RPCResult::Type::OBJ, "", "",
@@ -585,6 +683,7 @@ RPCHelpMan listsinceblock()
                             "Note: transactions that were re-added in the active chain will appear as-is in this array, and may thus have a positive confirmation count."
                         , {{RPCResult::Type::ELISION, "", ""},}},
                         {RPCResult::Type::STR_HEX, "lastblock", "The hash of the block (target_confirmations-1) from the best block on the main chain, or the genesis hash if the referenced block does not exist yet. This is typically used to feed back into listsinceblock the next time you call it. So you would generally use a target_confirmations of say 6, so you will be continually re-notified of transactions until they've reached 6 confirmations plus any new ones"},
+                        {RPCResult::Type::STR, "cursor", /*optional=*/true, "With options, pass as the cursor option to get the next page, absent on the last one"},
                     }
                 },
                 RPCExamples{
@@ -641,12 +740,48 @@ RPCHelpMan listsinceblock()
     int depth = height ? wallet.GetLastBlockHeight() + 1 - *height : -1;
 
     UniValue transactions(UniValue::VARR);
+    std::optional<TxListCursor> cursor;
+    std::optional<TxListCursor> next;
 
-    for (const std::pair<const uint256, CWalletTx>& pairWtx : wallet.mapWallet) {
-        const CWalletTx& tx = pairWtx.second;
+    if (!request.params[6].isNull()) {
+        const UniValue& options = request.params[6].get_obj();
+        RPCTypeCheckObj(options,
+            {
+                {"page_size", UniValueType(UniValue::VNUM)},
+                {"cursor", UniValueType(UniValue::VSTR)},
+                {"exclude_coinstakes", UniValueType(UniValue::VBOOL)},
+            },
+            true, true);
+        const int page_size{options.exists("page_size") ? options["page_size"].getInt<int>() : 1000};
+        if (page_size < 1) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "page_size must be at least 1");
+        }
+        if (options.exists("cursor")) cursor = ParseTxListCursor(options["cursor"]);
+        TxListFilter list_filter{ParseTxListFilter(options)};
+        // Transactions confirmed after the block, then those not confirmed, which the depth check below sorts out
+        if (height) list_filter.min_height = *height + 1;
+
+        std::optional<TxListCursor> last;
+        wallet.ForEachListedTx(list_filter, cursor, [&](const CWalletTx& tx, const TxListCursor& position) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet) {
+            if ((int)transactions.size() >= page_size) {
+                next = last;
+                return false;
+            }
+            if (depth == -1 || abs(wallet.GetTxDepthInMainChain(tx)) < depth) {
+                ListTransactions(wallet, tx, 0, true, transactions, filter, filter_label, include_change);
+            }
+            last = position;
+            return true;
+        });
+        // Listed on the first page only
+        if (cursor) include_removed = false;
+    } else {
+        for (const std::pair<const uint256, CWalletTx>& pairWtx : wallet.mapWallet) {
+            const CWalletTx& tx = pairWtx.second;
 
-        if (depth == -1 || abs(wallet.GetTxDepthInMainChain(tx)) < depth) {
-            ListTransactions(wallet, tx, 0, true, transactions, filter, filter_label, include_change);
+            if (depth == -1 || abs(wallet.GetTxDepthInMainChain(tx)) < depth) {
+                ListTransactions(wallet, tx, 0, true, transactions, filter, filter_label, include_change);
+            }
         }
     }
 
@@ -678,6 +813,7 @@ RPCHelpMan listsinceblock()
     ret.pushKV("transactions", transactions);
     if (include_removed) ret.pushKV("removed", removed);
     ret.pushKV("lastblock", lastblock.GetHex());
+    if (next) ret.pushKV("cursor", TxListCursorToString(*next));
 
     return ret;
 },
@@ -763,11 +899,13 @@ RPCHelpMan gettransaction()
     bool verbose = request.params[2].isNull() ? false : request.params[2].get_bool();
 
     UniValue entry(UniValue::VOBJ);
+    // Archived transactions are read back from disk
+    std::unique_ptr<CWalletTx> archived;
     auto it = pwallet->mapWallet.find(hash);
-    if (it == pwallet->mapWallet.end()) {
+    if (it == pwallet->mapWallet.end() && !(archived = pwallet->ReadArchivedTx(hash))) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid or non-wallet transaction id");
     }
-    const CWalletTx& wtx = it->second;
+    const CWalletTx& wtx = archived ? *archived : it->second;
 
     CAmount nCredit = CachedTxGetCredit(*pwallet, wtx, filter);
     CAmount nDebit = CachedTxGetDebit(*pwallet, wtx, filter);
@@ -8,13 +8,16 @@
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <util/translation.h>
+#include <util/vector.h>
 #include <wallet/context.h>
 #include <wallet/receive.h>
 #include <wallet/rpc/wallet.h>
 #include <wallet/rpc/util.h>
+#include <wallet/spend.h>
 #include <wallet/wallet.h>
 #include <wallet/walletutil.h>
 
+#include <algorithm>
 #include <optional>
 
 #include <univalue.h>
@@ -53,6 +56,7 @@ static RPCHelpMan getwalletinfo()
                         {RPCResult::Type::STR_AMOUNT, "unconfirmed_balance", "DEPRECATED. Identical to getbalances().mine.untrusted_pending"},
                         {RPCResult::Type::STR_AMOUNT, "immature_balance", "DEPRECATED. Identical to getbalances().mine.immature"},
                         {RPCResult::Type::NUM, "txcount", "the total number of transactions in the wallet"},
+                        {RPCResult::Type::NUM, "archivedtxcount", "the number of transactions archived out of memory, see -walletarchivedepth"},
                         {RPCResult::Type::NUM_TIME, "keypoololdest", /*optional=*/true, "the " + UNIX_EPOCH_TIME + " of the oldest pre-generated key in the key pool. Legacy wallets only."},
                         {RPCResult::Type::NUM, "keypoolsize", "how many new keys are pre-generated (only counts external keys)"},
                         {RPCResult::Type::NUM, "keypoolsize_hd_internal", /*optional=*/true, "how many new keys are pre-generated for internal use (used for change outputs, only appears if the wallet is using this feature, otherwise external keys are used)"},
@@ -96,6 +100,7 @@ static RPCHelpMan getwalletinfo()
     obj.pushKV("unconfirmed_balance", ValueFromAmount(bal.m_mine_untrusted_pending));
     obj.pushKV("immature_balance", ValueFromAmount(bal.m_mine_immature));
     obj.pushKV("txcount",       (int)pwallet->mapWallet.size());
+    obj.pushKV("archivedtxcount", (int)pwallet->GetArchivedTxCount());
     const auto kp_oldest = pwallet->GetOldestKeyPoolTime();
     if (kp_oldest.has_value()) {
         obj.pushKV("keypoololdest", kp_oldest.value());
@@ -330,6 +335,136 @@ static RPCHelpMan setwalletflag()
     };
 }
 
+static const std::vector<RPCResult> STAKE_POLICY_RESULT_FIELDS{
+    {RPCResult::Type::STR_AMOUNT, "target_size", "The size of stake output aimed for, in " + CURRENCY_UNIT},
+    {RPCResult::Type::STR_AMOUNT, "combine_threshold", "Outputs smaller than this are combined into coinstakes, in " + CURRENCY_UNIT},
+    {RPCResult::Type::NUM, "max_combine", "The most outputs combined into a coinstake besides its kernel"},
+    {RPCResult::Type::NUM, "max_split", "The most outputs a coinstake is split into"},
+};
+
+static UniValue StakePolicyToJSON(const StakeOutputPolicy& policy)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("target_size", ValueFromAmount(policy.target_size));
+    obj.pushKV("combine_threshold", ValueFromAmount(policy.combine_threshold));
+    obj.pushKV("max_combine", (uint64_t)policy.max_combine);
+    obj.pushKV("max_split", (uint64_t)policy.max_split);
+    return obj;
+}
+
+static RPCHelpMan getstakepolicy()
+{
+    return RPCHelpMan{"getstakepolicy",
+                "\nReturns how the wallet shapes the outputs it stakes with, and the shape of its spendable outputs.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    Cat<std::vector<RPCResult>>(STAKE_POLICY_RESULT_FIELDS, {
+                        {RPCResult::Type::OBJ, "outputs", "The spendable outputs of the wallet",
+                        {
+                            {RPCResult::Type::NUM, "count", "The number of outputs"},
+                            {RPCResult::Type::NUM, "below_combine_threshold", "The number of outputs coinstakes would combine"},
+                            {RPCResult::Type::NUM, "above_split_size", "The number of outputs a coinstake would split, those of twice the target size or more"},
+                            {RPCResult::Type::STR_AMOUNT, "median", "The median output value, in " + CURRENCY_UNIT},
+                        }},
+                    })
+                },
+                RPCExamples{
+                    HelpExampleCli("getstakepolicy", "")
+                  + HelpExampleRpc("getstakepolicy", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    std::shared_ptr<CWallet> const pwallet = GetWalletForJSONRPCRequest(request);
+    if (!pwallet) return UniValue::VNULL;
+
+    LOCK(pwallet->cs_wallet);
+    const StakeOutputPolicy& policy{pwallet->m_stake_policy};
+    std::vector<CAmount> values;
+    for (const COutput& output : AvailableCoins(*pwallet).All()) {
+        values.push_back(output.txout.nValue);
+    }
+    std::sort(values.begin(), values.end());
+
+    UniValue outputs(UniValue::VOBJ);
+    outputs.pushKV("count", (uint64_t)values.size());
+    outputs.pushKV("below_combine_threshold", (uint64_t)std::count_if(values.begin(), values.end(), [&](CAmount value) { return value < policy.combine_threshold; }));
+    outputs.pushKV("above_split_size", (uint64_t)std::count_if(values.begin(), values.end(), [&](CAmount value) { return policy.SplitCredit(value).size() > 1; }));
+    outputs.pushKV("median", ValueFromAmount(values.empty() ? 0 : values[values.size() / 2]));
+
+    UniValue obj{StakePolicyToJSON(policy)};
+    obj.pushKV("outputs", outputs);
+    return obj;
+},
+    };
+}
+
+static RPCHelpMan setstakepolicy()
+{
+    return RPCHelpMan{"setstakepolicy",
+                "\nChange how the wallet shapes the outputs it stakes with, until it is unloaded. Overrides -staketargetsize,\n"
+                "-stakecombinethreshold, -stakemaxcombine and -stakemaxsplit. Options not given are left as they are.\n",
+                {
+                    {"options", RPCArg::Type::OBJ, RPCArg::Optional::NO, "",
+                        {
+                            {"target_size", RPCArg::Type::AMOUNT, RPCArg::Optional::OMITTED, "The size of stake output to aim for, in " + CURRENCY_UNIT + ". Coinstakes are split into outputs of at least this."},
+                            {"combine_threshold", RPCArg::Type::AMOUNT, RPCArg::Optional::OMITTED, "Combine outputs smaller than this into coinstakes, in " + CURRENCY_UNIT + ", up to the target size"},
+                            {"max_combine", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "The most outputs combined into a coinstake besides its kernel"},
+                            {"max_split", RPCArg::Type::NUM, RPCArg::Optional::OMITTED, "The most outputs a coinstake is split into, at least 1"},
+                        },
+                    },
+                },
+                RPCResult{RPCResult::Type::OBJ, "", "The policy now in force", STAKE_POLICY_RESULT_FIELDS},
+                RPCExamples{
+                    HelpExampleCli("setstakepolicy", "'{\"target_size\": 500, \"max_split\": 4}'")
+                  + HelpExampleRpc("setstakepolicy", "{\"target_size\": 500, \"max_split\": 4}")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    std::shared_ptr<CWallet> const pwallet = GetWalletForJSONRPCRequest(request);
+    if (!pwallet) return UniValue::VNULL;
+
+    const UniValue& options = request.params[0].get_obj();
+    RPCTypeCheckObj(options,
+        {
+            {"target_size", UniValueType()},
+            {"combine_threshold", UniValueType()},
+            {"max_combine", UniValueType(UniValue::VNUM)},
+            {"max_split", UniValueType(UniValue::VNUM)},
+        },
+        true, true);
+
+    LOCK(pwallet->cs_wallet);
+    StakeOutputPolicy policy{pwallet->m_stake_policy};
+    if (options.exists("target_size")) {
+        policy.target_size = AmountFromValue(options["target_size"]);
+        if (policy.target_size <= 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "target_size must be positive");
+        }
+    }
+    if (options.exists("combine_threshold")) {
+        policy.combine_threshold = AmountFromValue(options["combine_threshold"]);
+    }
+    if (options.exists("max_combine")) {
+        const int max_combine{options["max_combine"].getInt<int>()};
+        if (max_combine < 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "max_combine cannot be negative");
+        }
+        policy.max_combine = max_combine;
+    }
+    if (options.exists("max_split")) {
+        const int max_split{options["max_split"].getInt<int>()};
+        if (max_split < 1) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "max_split must be at least 1");
+        }
+        policy.max_split = max_split;
+    }
+    pwallet->m_stake_policy = policy;
+    return StakePolicyToJSON(policy);
+},
+    };
+}
+
 static RPCHelpMan createwallet()
 {
     return RPCHelpMan{
@@ -907,6 +1042,7 @@ Span<const CRPCCommand> GetWalletRPCCommands()
         {"wallet", &getunconfirmedbalance},
         {"wallet", &getbalances},
         {"wallet", &getwalletinfo},
+        {"wallet", &getstakepolicy},
         {"wallet", &importaddress},
         {"wallet", &importdescriptors},
         {"wallet", &importmulti},
@@ -937,6 +1073,7 @@ Span<const CRPCCommand> GetWalletRPCCommands()
         {"wallet", &sendtoaddress},
         {"wallet", &sethdseed},
         {"wallet", &setlabel},
+        {"wallet", &setstakepolicy},
         {"wallet", &settxfee},
         {"wallet", &setwalletflag},
         {"wallet", &signmessage},
@@ -218,22 +218,21 @@ CoinsResult AvailableCoins(const CWallet& wallet,
     const bool can_grind_r = wallet.CanGrindR();
 
     std::set<uint256> trusted_parents;
-    for (const auto& entry : wallet.mapWallet)
-    {
-        const uint256& wtxid = entry.first;
-        const CWalletTx& wtx = entry.second;
+    // Add the outputs of wtx, returning whether the result is complete
+    const auto add_outputs = [&](const CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet) {
+        const uint256& wtxid = wtx.GetHash();
 
         if (wallet.IsTxImmatureCoinBase(wtx) && !params.include_immature_coinbase)
-            continue;
+            return false;
 
         int nDepth = wallet.GetTxDepthInMainChain(wtx);
         if (nDepth < 0)
-            continue;
+            return false;
 
         // We should not consider coins which aren't at least in our mempool
         // It's possible for these to be conflicted via ancestors which we may never be able to detect
         if (nDepth == 0 && !wtx.InMempool())
-            continue;
+            return false;
 
         bool safeTx = CachedTxIsTrusted(wallet, wtx, trusted_parents);
 
@@ -269,11 +268,11 @@ CoinsResult AvailableCoins(const CWallet& wallet,
         }
 
         if (only_safe && !safeTx) {
-            continue;
+            return false;
         }
 
         if (nDepth < min_depth || nDepth > max_depth) {
-            continue;
+            return false;
         }
 
         bool tx_from_me = CachedTxIsFromMe(wallet, wtx, ISMINE_ALL);
@@ -335,15 +334,26 @@ CoinsResult AvailableCoins(const CWallet& wallet,
             // Checks the sum amount of all UTXO's.
             if (params.min_sum_amount != MAX_MONEY) {
                 if (result.GetTotalAmount() >= params.min_sum_amount) {
-                    return result;
+                    return true;
                 }
             }
 
             // Checks the maximum number of UTXO's.
             if (params.max_count > 0 && result.Size() >= params.max_count) {
-                return result;
+                return true;
             }
         }
+        return false;
+    };
+
+    if (params.only_txs) {
+        for (const CWalletTx* wtx : *params.only_txs) {
+            if (add_outputs(*wtx)) break;
+        }
+    } else {
+        for (const auto& entry : wallet.mapWallet) {
+            if (add_outputs(entry.second)) break;
+        }
     }
 
     return result;
@@ -355,6 +365,45 @@ CoinsResult AvailableCoinsListUnspent(const CWallet& wallet, const CCoinControl*
     return AvailableCoins(wallet, coinControl, /*feerate=*/ std::nullopt, params);
 }
 
+std::vector<COutput> AvailableStakeCoins(CWallet& wallet, int64_t time, int64_t min_age, int64_t max_age, int64_t* next_time)
+{
+    AssertLockHeld(wallet.cs_wallet);
+
+    if (!wallet.m_stake_candidates_loaded) {
+        wallet.m_stake_candidates_loaded = true;
+        for (const auto& entry : wallet.mapWallet) {
+            wallet.AddStakeCandidates(entry.second);
+        }
+    }
+
+    auto& candidates = wallet.m_stake_candidates;
+    const COutPoint null_outpoint{uint256::ZERO, 0};
+    candidates.erase(candidates.begin(), candidates.lower_bound({time - max_age, null_outpoint}));
+
+    std::vector<COutput> result;
+    auto it = candidates.begin();
+    for (; it != candidates.end() && it->first <= time - min_age;) {
+        const auto& [tx_time, outpoint] = *it;
+        const CWalletTx* wtx = wallet.GetWalletTx(outpoint.hash);
+        if (!wtx) {
+            it = candidates.erase(it);
+            continue;
+        }
+        ++it;
+
+        // A kernel has to be in the UTXO set of the chain
+        int depth = wallet.GetTxDepthInMainChain(*wtx);
+        if (depth < 1 || wallet.IsTxImmatureCoinBase(*wtx) || wallet.IsSpent(outpoint)) {
+            continue;
+        }
+        result.emplace_back(outpoint, wtx->tx->vout[outpoint.n], depth, /*input_bytes=*/-1, /*spendable=*/true, /*solvable=*/true, /*safe=*/true, tx_time, /*from_me=*/false);
+    }
+    if (next_time) {
+        *next_time = it != candidates.end() ? it->first + min_age : 0;
+    }
+    return result;
+}
+
 const CTxOut& FindNonChangeParentOutput(const CWallet& wallet, const COutPoint& outpoint)
 {
     AssertLockHeld(wallet.cs_wallet);
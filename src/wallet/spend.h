@@ -78,6 +78,8 @@ struct CoinFilterParams {
     bool include_immature_coinbase{false};
     // By default, skip locked UTXOs
     bool skip_locked{true};
+    // Only look at the outputs of these transactions, rather than at those of the whole wallet
+    const std::vector<const CWalletTx*>* only_txs{nullptr};
 };
 
 /**
@@ -94,6 +96,14 @@ CoinsResult AvailableCoins(const CWallet& wallet,
  */
 CoinsResult AvailableCoinsListUnspent(const CWallet& wallet, const CCoinControl* coinControl = nullptr, CoinFilterParams params = {}) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet);
 
+/**
+ * Confirmed, unspent and spendable outputs aged between min_age and max_age seconds at time,
+ * from the stake candidates the wallet keeps up to date, instead of walking every wallet transaction.
+ * Candidates too old to ever stake again are dropped. If next_time is given, it is set to the time
+ * the next candidate comes of age, or 0 if none is too young.
+ */
+std::vector<COutput> AvailableStakeCoins(CWallet& wallet, int64_t time, int64_t min_age, int64_t max_age, int64_t* next_time = nullptr) EXCLUSIVE_LOCKS_REQUIRED(wallet.cs_wallet);
+
 /**
  * Find non-change parent output.
  */
@@ -80,11 +80,14 @@ static void SetPragma(sqlite3* db, const std::string& key, const std::string& va
     }
 }
 
+//! Most sets of prepared statements kept for reuse by the batches of a database
+static constexpr size_t MAX_POOLED_STATEMENTS{8};
+
 Mutex SQLiteDatabase::g_sqlite_mutex;
 int SQLiteDatabase::g_sqlite_count = 0;
 
 SQLiteDatabase::SQLiteDatabase(const fs::path& dir_path, const fs::path& file_path, const DatabaseOptions& options, bool mock)
-    : WalletDatabase(), m_mock(mock), m_dir_path(fs::PathToString(dir_path)), m_file_path(fs::PathToString(file_path)), m_use_unsafe_sync(options.use_unsafe_sync)
+    : WalletDatabase(), m_mock(mock), m_dir_path(fs::PathToString(dir_path)), m_file_path(fs::PathToString(file_path)), m_use_unsafe_sync(options.use_unsafe_sync), m_use_wal(options.use_wal)
 {
     {
         LOCK(g_sqlite_mutex);
@@ -120,6 +123,20 @@ SQLiteDatabase::SQLiteDatabase(const fs::path& dir_path, const fs::path& file_pa
 
 void SQLiteBatch::SetupSQLStatements()
 {
+    // Take the statements a closed batch left, if any
+    {
+        LOCK(m_database.m_statements_mutex);
+        if (!m_database.m_statements.empty()) {
+            const auto& statements{m_database.m_statements.back()};
+            m_read_stmt = statements[0];
+            m_insert_stmt = statements[1];
+            m_overwrite_stmt = statements[2];
+            m_delete_stmt = statements[3];
+            m_database.m_statements.pop_back();
+            return;
+        }
+    }
+
     const std::vector<std::pair<sqlite3_stmt**, const char*>> statements{
         {&m_read_stmt, "SELECT value FROM main WHERE key = ?"},
         {&m_insert_stmt, "INSERT INTO main VALUES(?, ?)"},
@@ -262,6 +279,16 @@ void SQLiteDatabase::Open()
         SetPragma(m_db, "synchronous", "OFF", "Failed to set synchronous mode to OFF");
     }
 
+    if (m_use_wal) {
+        // Append to a write-ahead log, so a commit costs one sequential write and
+        // only checkpoints sync the database file. With the exclusive lock held
+        // the log needs no shared memory index.
+        SetPragma(m_db, "journal_mode", "WAL", "Failed to enable the write-ahead log");
+        if (!m_use_unsafe_sync) {
+            SetPragma(m_db, "synchronous", "NORMAL", "Failed to set synchronous mode to NORMAL");
+        }
+    }
+
     // Make the table for our key-value pairs
     // First check that the main table exists
     sqlite3_stmt* check_main_stmt{nullptr};
@@ -336,6 +363,15 @@ bool SQLiteDatabase::Backup(const std::string& dest) const
 
 void SQLiteDatabase::Close()
 {
+    {
+        LOCK(m_statements_mutex);
+        for (const auto& statements : m_statements) {
+            for (sqlite3_stmt* stmt : statements) {
+                sqlite3_finalize(stmt);
+            }
+        }
+        m_statements.clear();
+    }
     int res = sqlite3_close(m_db);
     if (res != SQLITE_OK) {
         throw std::runtime_error(strprintf("SQLiteDatabase: Failed to close database: %s\n", sqlite3_errstr(res)));
@@ -360,8 +396,8 @@ SQLiteBatch::SQLiteBatch(SQLiteDatabase& database)
 
 void SQLiteBatch::Close()
 {
-    // If m_db is in a transaction (i.e. not in autocommit mode), then abort the transaction in progress
-    if (m_database.m_db && sqlite3_get_autocommit(m_database.m_db) == 0) {
+    // If this batch began a transaction, then abort the transaction in progress
+    if (m_txn) {
         if (TxnAbort()) {
             LogPrintf("SQLiteBatch: Batch closed unexpectedly without the transaction being explicitly committed or aborted\n");
         } else {
@@ -369,6 +405,16 @@ void SQLiteBatch::Close()
         }
     }
 
+    // Keep the prepared statements for the next batch, up to a few
+    if (m_database.m_db && m_read_stmt && m_insert_stmt && m_overwrite_stmt && m_delete_stmt) {
+        LOCK(m_database.m_statements_mutex);
+        if (m_database.m_statements.size() < MAX_POOLED_STATEMENTS) {
+            m_database.m_statements.push_back({m_read_stmt, m_insert_stmt, m_overwrite_stmt, m_delete_stmt});
+            m_read_stmt = m_insert_stmt = m_overwrite_stmt = m_delete_stmt = nullptr;
+            return;
+        }
+    }
+
     // Free all of the prepared statements
     const std::vector<std::pair<sqlite3_stmt**, const char*>> statements{
         {&m_read_stmt, "read"},
@@ -525,13 +571,15 @@ bool SQLiteBatch::TxnBegin()
     if (res != SQLITE_OK) {
         LogPrintf("SQLiteBatch: Failed to begin the transaction\n");
     }
-    return res == SQLITE_OK;
+    m_txn = res == SQLITE_OK;
+    return m_txn;
 }
 
 bool SQLiteBatch::TxnCommit()
 {
-    if (!m_database.m_db || sqlite3_get_autocommit(m_database.m_db) != 0) return false;
+    if (!m_database.m_db || !m_txn || sqlite3_get_autocommit(m_database.m_db) != 0) return false;
     int res = sqlite3_exec(m_database.m_db, "COMMIT TRANSACTION", nullptr, nullptr, nullptr);
+    m_txn = false;
     if (res != SQLITE_OK) {
         LogPrintf("SQLiteBatch: Failed to commit the transaction\n");
     }
@@ -540,8 +588,9 @@ bool SQLiteBatch::TxnCommit()
 
 bool SQLiteBatch::TxnAbort()
 {
-    if (!m_database.m_db || sqlite3_get_autocommit(m_database.m_db) != 0) return false;
+    if (!m_database.m_db || !m_txn || sqlite3_get_autocommit(m_database.m_db) != 0) return false;
     int res = sqlite3_exec(m_database.m_db, "ROLLBACK TRANSACTION", nullptr, nullptr, nullptr);
+    m_txn = false;
     if (res != SQLITE_OK) {
         LogPrintf("SQLiteBatch: Failed to abort the transaction\n");
     }
@@ -10,6 +10,9 @@
 
 #include <sqlite3.h>
 
+#include <array>
+#include <vector>
+
 struct bilingual_str;
 
 namespace wallet {
@@ -37,6 +40,9 @@ private:
     sqlite3_stmt* m_overwrite_stmt{nullptr};
     sqlite3_stmt* m_delete_stmt{nullptr};
 
+    //! Whether this batch began the transaction in progress, which only it may end
+    bool m_txn{false};
+
     void SetupSQLStatements();
 
     bool ReadKey(DataStream&& key, DataStream& value) override;
@@ -81,6 +87,15 @@ private:
 
     void Cleanup() noexcept EXCLUSIVE_LOCKS_REQUIRED(!g_sqlite_mutex);
 
+    /**
+     * Prepared statements of closed batches (read, insert, overwrite and delete),
+     * reset and kept for the next batches rather than prepared anew each time.
+     */
+    Mutex m_statements_mutex;
+    std::vector<std::array<sqlite3_stmt*, 4>> m_statements GUARDED_BY(m_statements_mutex);
+
+    friend class SQLiteBatch;
+
 public:
     SQLiteDatabase() = delete;
 
@@ -125,11 +140,15 @@ public:
     std::string Filename() override { return m_file_path; }
     std::string Format() override { return "sqlite"; }
 
+    /** All batches use the one connection, so a transaction takes in the writes of every batch */
+    bool BatchesShareTxn() const override { return true; }
+
     /** Make a SQLiteBatch connected to this database */
     std::unique_ptr<DatabaseBatch> MakeBatch(bool flush_on_close = true) override;
 
     sqlite3* m_db{nullptr};
     bool m_use_unsafe_sync;
+    bool m_use_wal;
 };
 
 std::unique_ptr<SQLiteDatabase> MakeSQLiteDatabase(const fs::path& path, const DatabaseOptions& options, DatabaseStatus& status, bilingual_str& error);
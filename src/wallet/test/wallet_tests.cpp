@@ -6,6 +6,7 @@
 
 #include <future>
 #include <memory>
+#include <numeric>
 #include <stdint.h>
 #include <vector>
 
@@ -211,6 +212,34 @@ BOOST_FIXTURE_TEST_CASE(scan_for_wallet_transactions, TestChain100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(scan_for_wallet_transactions_read_ahead, TestChain100Setup)
+{
+    // Reading blocks ahead on threads finds what scanning them one by one does
+    const int tip_height{WITH_LOCK(cs_main, return m_node.chainman->ActiveChain().Height())};
+    std::vector<size_t> found;
+    for (const int threads : {0, 1, 4}) {
+        CWallet wallet(m_node.chain.get(), "", CreateMockWalletDatabase());
+        wallet.m_rescan_threads = threads;
+        {
+            LOCK(wallet.cs_wallet);
+            LOCK(Assert(m_node.chainman)->GetMutex());
+            wallet.SetWalletFlag(WALLET_FLAG_DESCRIPTORS);
+            wallet.SetLastBlockProcessed(m_node.chainman->ActiveChain().Height(), m_node.chainman->ActiveChain().Tip()->GetBlockHash());
+        }
+        AddKey(wallet, coinbaseKey);
+        WalletRescanReserver reserver(wallet);
+        reserver.reserve();
+
+        const CWallet::ScanResult result{wallet.ScanForWalletTransactions(Params().GenesisBlock().GetHash(), /*start_height=*/0, /*max_height=*/{}, reserver, /*fUpdate=*/false, /*save_progress=*/false)};
+        BOOST_CHECK_EQUAL(result.status, CWallet::ScanResult::SUCCESS);
+        BOOST_CHECK_EQUAL(*result.last_scanned_height, tip_height);
+        found.push_back(WITH_LOCK(wallet.cs_wallet, return wallet.mapWallet.size()));
+    }
+    BOOST_CHECK(found[0] > 0);
+    BOOST_CHECK_EQUAL(found[1], found[0]);
+    BOOST_CHECK_EQUAL(found[2], found[0]);
+}
+
 BOOST_FIXTURE_TEST_CASE(importmulti_rescan, TestChain100Setup)
 {
     // Cap last block file size, and mine new block in a new block file.
@@ -622,6 +651,92 @@ BOOST_FIXTURE_TEST_CASE(ListCoinsTest, ListCoinsTestingSetup)
     BOOST_CHECK_EQUAL(list.begin()->second.size(), 2U);
 }
 
+BOOST_AUTO_TEST_CASE(stake_policy_split)
+{
+    StakeOutputPolicy policy;
+    policy.target_size = 100 * COIN;
+    policy.max_split = 4;
+
+    // Under twice the target, the output is left whole
+    BOOST_CHECK(policy.SplitCredit(50 * COIN) == std::vector<CAmount>{50 * COIN});
+    BOOST_CHECK(policy.SplitCredit(199 * COIN) == std::vector<CAmount>{199 * COIN});
+
+    // Over it, into outputs of at least the target, the remainder on the last
+    BOOST_CHECK((policy.SplitCredit(250 * COIN + 1) == std::vector<CAmount>{125 * COIN, 125 * COIN + 1}));
+    BOOST_CHECK((policy.SplitCredit(300 * COIN) == std::vector<CAmount>{100 * COIN, 100 * COIN, 100 * COIN}));
+
+    // No more outputs than allowed, however large the credit
+    const std::vector<CAmount> large{policy.SplitCredit(10000 * COIN)};
+    BOOST_CHECK_EQUAL(large.size(), 4U);
+    BOOST_CHECK_EQUAL(std::accumulate(large.begin(), large.end(), CAmount{0}), 10000 * COIN);
+
+    policy.max_split = 1;
+    BOOST_CHECK_EQUAL(policy.SplitCredit(10000 * COIN).size(), 1U);
+}
+
+BOOST_FIXTURE_TEST_CASE(balance_cache, ListCoinsTestingSetup)
+{
+    // One mature coinbase, and the balance is the same when asked again
+    BOOST_CHECK_EQUAL(GetBalance(*wallet).m_mine_trusted, 50 * COIN);
+    BOOST_CHECK_EQUAL(GetBalance(*wallet).m_mine_trusted, 50 * COIN);
+    BOOST_CHECK_EQUAL(GetBalance(*wallet, /*min_depth=*/1).m_mine_trusted, 50 * COIN);
+
+    // Spending at the same tip changes the balance at once
+    CCoinControl dummy;
+    auto res = CreateTransaction(*wallet, {CRecipient{GetScriptForRawPubKey({}), 1 * COIN, /*subtract_fee=*/false}}, /*change_pos=*/-1, dummy);
+    BOOST_REQUIRE(res);
+    wallet->CommitTransaction(res->tx, {}, {});
+    const Balance spent{GetBalance(*wallet)};
+    BOOST_CHECK(spent.m_mine_trusted <= 49 * COIN - res->fee);
+    BOOST_CHECK_EQUAL(GetBalance(*wallet, /*min_depth=*/1).m_mine_trusted, 0);
+
+    // What is cached is what a walk of every transaction finds
+    wallet->MarkDirty();
+    BOOST_CHECK_EQUAL(GetBalance(*wallet).m_mine_trusted, spent.m_mine_trusted);
+
+    // A new tip changes depths, so what was cached for the old one is not used
+    LOCK(wallet->cs_wallet);
+    BOOST_CHECK(wallet->GetCachedBalance(/*min_depth=*/0, /*avoid_reuse=*/true));
+    wallet->SetLastBlockProcessed(wallet->GetLastBlockHeight() + 1, GetRandHash());
+    BOOST_CHECK(!wallet->GetCachedBalance(/*min_depth=*/0, /*avoid_reuse=*/true));
+}
+
+BOOST_FIXTURE_TEST_CASE(archive_spent_transactions, ListCoinsTestingSetup)
+{
+    const CWalletTx& spender{AddTx(CRecipient{GetScriptForRawPubKey({}), 1 * COIN, /*subtract_fee=*/false})};
+    const CTransactionRef spender_tx{spender.tx};
+    std::set<uint256> parents;
+    for (const CTxIn& txin : spender_tx->vin) parents.insert(txin.prevout.hash);
+    const CAmount debit{wallet->GetDebit(*spender_tx, ISMINE_ALL)};
+
+    LOCK(wallet->cs_wallet);
+    wallet->m_archive_depth = MIN_WALLET_ARCHIVE_DEPTH;
+    // Nothing is archived while the spender is shallow
+    BOOST_CHECK_EQUAL(wallet->ArchiveSpentTransactions(), 0U);
+
+    // The spent coinbases go once it is deep, the spender with its change stays
+    wallet->SetLastBlockProcessed(wallet->GetLastBlockHeight() + MIN_WALLET_ARCHIVE_DEPTH, GetRandHash());
+    const CAmount balance{GetBalance(*wallet).m_mine_trusted};
+    const size_t size{wallet->mapWallet.size()};
+    BOOST_CHECK_EQUAL(wallet->ArchiveSpentTransactions(), parents.size());
+    BOOST_CHECK_EQUAL(wallet->GetArchivedTxCount(), parents.size());
+    BOOST_CHECK_EQUAL(wallet->mapWallet.size(), size - parents.size());
+    BOOST_CHECK(wallet->mapWallet.count(spender_tx->GetHash()));
+    BOOST_CHECK_EQUAL(wallet->ArchiveSpentTransactions(), 0U);
+
+    // What was spent is still known, and the whole transaction is on disk
+    BOOST_CHECK_EQUAL(wallet->GetDebit(*spender_tx, ISMINE_ALL), debit);
+    BOOST_CHECK_EQUAL(GetBalance(*wallet).m_mine_trusted, balance);
+    for (const uint256& hash : parents) {
+        BOOST_CHECK(!wallet->mapWallet.count(hash));
+        const std::unique_ptr<CWalletTx> archived{wallet->ReadArchivedTx(hash)};
+        BOOST_REQUIRE(archived);
+        BOOST_CHECK_EQUAL(archived->GetHash(), hash);
+        BOOST_CHECK(archived->isConfirmed());
+    }
+    BOOST_CHECK(!wallet->ReadArchivedTx(spender_tx->GetHash()));
+}
+
 void TestCoinsResult(ListCoinsTest& context, OutputType out_type, CAmount amount,
                      std::map<OutputType, size_t>& expected_coins_sizes)
 {
@@ -746,6 +861,37 @@ BOOST_FIXTURE_TEST_CASE(wallet_descriptor_test, BasicTestingSetup)
     BOOST_CHECK_EXCEPTION(vr >> w_desc, std::ios_base::failure, malformed_descriptor);
 }
 
+BOOST_AUTO_TEST_CASE(descriptor_ismine_cache)
+{
+    CWallet wallet(m_node.chain.get(), "", CreateMockWalletDatabase());
+    LOCK(wallet.cs_wallet);
+    wallet.SetWalletFlag(WALLET_FLAG_DESCRIPTORS);
+    wallet.SetupDescriptorScriptPubKeyMans();
+
+    // Scripts the active descriptors were topped up with are found
+    const CScript mine{GetScriptForDestination(getNewDestination(wallet, OutputType::BECH32))};
+    BOOST_CHECK_EQUAL(wallet.IsMine(mine), ISMINE_SPENDABLE);
+    BOOST_CHECK_EQUAL(wallet.GetScriptPubKeyMans(mine).size(), 1U);
+    BOOST_CHECK_EQUAL(wallet.IsMine(GetScriptForDestination(WitnessV0KeyHash{uint160{}})), ISMINE_NO);
+    BOOST_CHECK_EQUAL(wallet.IsMine(CScript{} << OP_RETURN << std::vector<unsigned char>(mine.begin(), mine.end())), ISMINE_NO);
+
+    // As are those of a descriptor added later, with the keys to sign for them
+    CKey key;
+    key.MakeNewKey(/*fCompressed=*/true);
+    FlatSigningProvider keys;
+    std::string error;
+    WalletDescriptor w_desc{Parse("combo(" + EncodeSecret(key) + ")", keys, error, /*require_checksum=*/false), /*creation_time=*/0, /*range_start=*/0, /*range_end=*/0, /*next_index=*/0};
+    BOOST_REQUIRE(wallet.AddWalletDescriptor(w_desc, keys, /*label=*/"", /*internal=*/false));
+    const CScript p2pk{GetScriptForRawPubKey(key.GetPubKey())};
+    BOOST_CHECK_EQUAL(wallet.IsMine(p2pk), ISMINE_SPENDABLE);
+    const std::unique_ptr<SigningProvider> provider{wallet.GetSigningProvider(p2pk)};
+    BOOST_REQUIRE(provider);
+    CKey found;
+    BOOST_CHECK(provider->GetKey(key.GetPubKey().GetID(), found));
+    BOOST_CHECK(found == key);
+    BOOST_CHECK(!wallet.GetSigningProvider(GetScriptForDestination(WitnessV0KeyHash{uint160{}})));
+}
+
 //! Test CWallet::Create() and its behavior handling potential race
 //! conditions if it's called the same time an incoming transaction shows up in
 //! the mempool or a new block.
@@ -6,6 +6,7 @@
 #include <clientversion.h>
 #include <streams.h>
 #include <uint256.h>
+#include <wallet/walletdb.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -27,5 +28,38 @@ BOOST_AUTO_TEST_CASE(walletdb_readkeyvalue)
     BOOST_CHECK_THROW(ssValue >> dummy, std::ios_base::failure);
 }
 
+#ifdef USE_SQLITE
+BOOST_AUTO_TEST_CASE(walletdb_write_group)
+{
+    DatabaseOptions options;
+    options.require_format = DatabaseFormat::SQLITE;
+    std::unique_ptr<WalletDatabase> database{CreateMockWalletDatabase(options)};
+    BOOST_CHECK(database->BatchesShareTxn());
+
+    {
+        WalletWriteGroup group{*database};
+        auto batch{database->MakeBatch()};
+        BOOST_CHECK(batch->Write(std::string{"first"}, 1));
+        // A batch cannot begin a transaction of its own within the group, and
+        // closing it leaves the group's transaction be
+        BOOST_CHECK(!batch->TxnBegin());
+        batch.reset();
+        BOOST_CHECK(database->MakeBatch()->Write(std::string{"second"}, 2));
+    }
+
+    // The writes of the group are committed, and batches reuse their statements
+    for (int i = 0; i < 20; ++i) {
+        auto batch{database->MakeBatch()};
+        int value{0};
+        BOOST_CHECK(batch->Read(std::string{"first"}, value) && value == 1);
+        BOOST_CHECK(batch->Read(std::string{"second"}, value) && value == 2);
+        BOOST_CHECK(batch->TxnBegin());
+        BOOST_CHECK(batch->Write(std::string{"third"}, i));
+        BOOST_CHECK(batch->TxnAbort());
+        BOOST_CHECK(!batch->Exists(std::string{"third"}));
+    }
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
 } // namespace wallet
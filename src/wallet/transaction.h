@@ -18,6 +18,7 @@
 #include <util/string.h>
 
 #include <list>
+#include <optional>
 #include <variant>
 #include <vector>
 
@@ -207,6 +208,8 @@ public:
     bool fFromMe;
     int64_t nOrderPos; //!< position in ordered transaction list
     std::multimap<int64_t, CWalletTx*>::const_iterator m_it_wtxOrdered;
+    //! Height the transaction is at in CWallet::m_txs_by_height, once indexed there
+    std::optional<int> m_listed_height;
 
     // memory only
     enum AmountType { DEBIT, CREDIT, IMMATURE_CREDIT, AVAILABLE_CREDIT, AMOUNTTYPE_ENUM_ELEMENTS };
@@ -331,6 +334,27 @@ public:
     void operator=(CWalletTx const &x) = delete;
 };
 
+/** An output of an archived transaction that belongs to the wallet */
+struct ArchivedOutput {
+    uint32_t n{0};
+    CAmount value{0};
+    //! isminetype of the output when archived
+    uint8_t mine{0};
+
+    SERIALIZE_METHODS(ArchivedOutput, obj) { READWRITE(obj.n, obj.value, obj.mine); }
+};
+
+/**
+ * What stays in memory of a transaction archived out of mapWallet: only the
+ * outputs of the wallet, which transactions still in mapWallet may spend.
+ * The whole transaction is left on disk, see CWallet::ReadArchivedTx.
+ */
+struct ArchivedTx {
+    std::vector<ArchivedOutput> outputs;
+
+    SERIALIZE_METHODS(ArchivedTx, obj) { READWRITE(obj.outputs); }
+};
+
 struct WalletTxOrderComparator {
     bool operator()(const CWalletTx* a, const CWalletTx* b) const
     {
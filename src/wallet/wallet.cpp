@@ -10,6 +10,7 @@
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
+#include <core_memusage.h>
 #include <external_signer.h>
 #include <interfaces/chain.h>
 #include <interfaces/wallet.h>
@@ -47,7 +48,12 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <deque>
+#include <future>
+#include <limits>
+#include <memory>
 #include <optional>
+#include <unordered_set>
 
 using interfaces::FoundBlock;
 
@@ -268,36 +274,45 @@ public:
         assert(!m_wallet.IsLegacy());
 
         // create initial filter with scripts from all ScriptPubKeyMans
+        auto filter_set{std::make_shared<GCSFilter::ElementSet>()};
         for (auto spkm : m_wallet.GetAllScriptPubKeyMans()) {
             auto desc_spkm{dynamic_cast<DescriptorScriptPubKeyMan*>(spkm)};
             assert(desc_spkm != nullptr);
-            AddScriptPubKeys(desc_spkm);
+            AddScriptPubKeys(*filter_set, desc_spkm);
             // save each range descriptor's end for possible future filter updates
             if (desc_spkm->IsHDEnabled()) {
                 m_last_range_ends.emplace(desc_spkm->GetID(), desc_spkm->GetEndRange());
             }
         }
+        m_filter_set = std::move(filter_set);
     }
 
     void UpdateIfNeeded()
     {
         // repopulate filter with new scripts if top-up has happened since last iteration
+        std::shared_ptr<GCSFilter::ElementSet> filter_set;
         for (const auto& [desc_spkm_id, last_range_end] : m_last_range_ends) {
             auto desc_spkm{dynamic_cast<DescriptorScriptPubKeyMan*>(m_wallet.GetScriptPubKeyMan(desc_spkm_id))};
             assert(desc_spkm != nullptr);
             int32_t current_range_end{desc_spkm->GetEndRange()};
             if (current_range_end > last_range_end) {
-                AddScriptPubKeys(desc_spkm, last_range_end);
+                // the set may be in use by blocks being looked up ahead, so update a copy
+                if (!filter_set) filter_set = std::make_shared<GCSFilter::ElementSet>(*m_filter_set);
+                AddScriptPubKeys(*filter_set, desc_spkm, last_range_end);
                 m_last_range_ends.at(desc_spkm->GetID()) = current_range_end;
             }
         }
+        if (filter_set) m_filter_set = std::move(filter_set);
     }
 
     std::optional<bool> MatchesBlock(const uint256& block_hash) const
     {
-        return m_wallet.chain().blockFilterMatchesAny(BlockFilterType::BASIC, block_hash, m_filter_set);
+        return m_wallet.chain().blockFilterMatchesAny(BlockFilterType::BASIC, block_hash, *m_filter_set);
     }
 
+    //! The scripts matched against, as they are now. Updates leave a set given out as it is.
+    std::shared_ptr<const GCSFilter::ElementSet> FilterSet() const { return m_filter_set; }
+
 private:
     const CWallet& m_wallet;
     /** Map for keeping track of each range descriptor's last seen end range.
@@ -307,15 +322,45 @@ private:
       * take possible keypool top-ups into account.
       */
     std::map<uint256, int32_t> m_last_range_ends;
-    GCSFilter::ElementSet m_filter_set;
+    std::shared_ptr<const GCSFilter::ElementSet> m_filter_set;
 
-    void AddScriptPubKeys(const DescriptorScriptPubKeyMan* desc_spkm, int32_t last_range_end = 0)
+    static void AddScriptPubKeys(GCSFilter::ElementSet& filter_set, const DescriptorScriptPubKeyMan* desc_spkm, int32_t last_range_end = 0)
     {
         for (const auto& script_pub_key : desc_spkm->GetScriptPubKeys(last_range_end)) {
-            m_filter_set.emplace(script_pub_key.begin(), script_pub_key.end());
+            filter_set.emplace(script_pub_key.begin(), script_pub_key.end());
         }
     }
 };
+
+//! Blocks each rescan thread looks up at a time
+static constexpr int RESCAN_READ_AHEAD_BLOCKS{16};
+
+/** A block of a rescan, looked up on a thread of its own ahead of the block being scanned */
+struct RescanBlock {
+    //! Null if there was no block at the height on the chain looked up
+    uint256 hash;
+    //! Whether the block filter matched filter_set, if there was a filter to look up
+    std::optional<bool> matches;
+    std::shared_ptr<const GCSFilter::ElementSet> filter_set;
+    //! Read unless the filter ruled the block out
+    CBlock block;
+};
+
+/** Look up count blocks from height from on the chain ending in tip_hash, filtering them on filter_set if given */
+static std::vector<RescanBlock> ReadRescanBlocks(interfaces::Chain& chain, const uint256& tip_hash, int from, int count, const std::shared_ptr<const GCSFilter::ElementSet>& filter_set)
+{
+    std::vector<RescanBlock> blocks(count);
+    for (int i = 0; i < count; ++i) {
+        RescanBlock& block{blocks[i]};
+        if (!chain.findAncestorByHeight(tip_hash, from + i, FoundBlock().hash(block.hash))) break;
+        if (filter_set) {
+            block.filter_set = filter_set;
+            block.matches = chain.blockFilterMatchesAny(BlockFilterType::BASIC, block.hash, *filter_set);
+        }
+        if (block.matches.value_or(true)) chain.findBlock(block.hash, FoundBlock().data(block.block));
+    }
+    return blocks;
+}
 } // namespace
 
 std::shared_ptr<CWallet> LoadWallet(WalletContext& context, const std::string& name, std::optional<bool> load_on_start, const DatabaseOptions& options, DatabaseStatus& status, bilingual_str& error, std::vector<bilingual_str>& warnings)
@@ -538,6 +583,7 @@ bool CWallet::Unlock(const SecureString& strWalletPassphrase, bool accept_no_key
                 UpgradeKeyMetadata();
                 // Now that we've unlocked, upgrade the descriptor cache
                 UpgradeDescriptorCache();
+                NotifyCanStake(this);
                 return true;
             }
         }
@@ -751,6 +797,176 @@ void CWallet::AddToSpends(const CWalletTx& wtx, WalletBatch* batch)
         AddToSpends(txin.prevout, wtx.GetHash(), batch);
 }
 
+void CWallet::AddStakeCandidates(const CWalletTx& wtx)
+{
+    AssertLockHeld(cs_wallet);
+    if (!m_stake_candidates_loaded) {
+        return;
+    }
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+        if (IsMine(wtx.tx->vout[i]) & ISMINE_SPENDABLE) {
+            m_stake_candidates.emplace(wtx.GetTxTime(), COutPoint(wtx.GetHash(), i));
+        }
+    }
+}
+
+//! Height a transaction is listed at: that of its block once confirmed, after every block until then
+static int ListedHeight(const CWalletTx& wtx)
+{
+    if (auto* conf = wtx.state<TxStateConfirmed>()) return conf->confirmed_block_height;
+    return std::numeric_limits<int>::max();
+}
+
+void CWallet::IndexListedTx(CWalletTx& wtx)
+{
+    AssertLockHeld(cs_wallet);
+    if (!m_list_indexes_loaded) {
+        return;
+    }
+    const int height{ListedHeight(wtx)};
+    if (wtx.m_listed_height != height) {
+        if (wtx.m_listed_height) m_txs_by_height.erase({*wtx.m_listed_height, wtx.nOrderPos});
+        m_txs_by_height.emplace(std::make_pair(height, wtx.nOrderPos), &wtx);
+        wtx.m_listed_height = height;
+    }
+    if (!wtx.IsCoinStake()) {
+        m_txs_no_coinstake.emplace(wtx.nOrderPos, &wtx);
+    }
+    // On every update, as an import may have made more of its outputs the wallet's
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+        CTxDestination dest;
+        if (IsMine(wtx.tx->vout[i]) != ISMINE_NO && ExtractDestination(wtx.tx->vout[i].scriptPubKey, dest)) {
+            m_txs_by_destination[dest].emplace(wtx.nOrderPos, &wtx);
+        }
+        UpdateUnspentOutput(COutPoint(wtx.GetHash(), i));
+    }
+    // Whether the outputs it spends count as spent changes with its state
+    for (const CTxIn& txin : wtx.tx->vin) {
+        UpdateUnspentOutput(txin.prevout);
+    }
+}
+
+void CWallet::UnindexListedTx(CWalletTx& wtx)
+{
+    AssertLockHeld(cs_wallet);
+    if (!m_list_indexes_loaded) {
+        return;
+    }
+    if (wtx.m_listed_height) m_txs_by_height.erase({*wtx.m_listed_height, wtx.nOrderPos});
+    wtx.m_listed_height.reset();
+    m_txs_no_coinstake.erase(wtx.nOrderPos);
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+        CTxDestination dest;
+        if (ExtractDestination(wtx.tx->vout[i].scriptPubKey, dest)) {
+            const auto it{m_txs_by_destination.find(dest)};
+            if (it != m_txs_by_destination.end() && it->second.erase(wtx.nOrderPos) && it->second.empty()) {
+                m_txs_by_destination.erase(it);
+            }
+        }
+        m_unspent_outputs.erase(COutPoint(wtx.GetHash(), i));
+    }
+}
+
+void CWallet::UpdateUnspentOutput(const COutPoint& outpoint)
+{
+    AssertLockHeld(cs_wallet);
+    const auto it{mapWallet.find(outpoint.hash)};
+    if (it != mapWallet.end() && outpoint.n < it->second.tx->vout.size() &&
+        IsMine(it->second.tx->vout[outpoint.n]) != ISMINE_NO && !IsSpent(outpoint)) {
+        m_unspent_outputs.insert(outpoint);
+    } else {
+        m_unspent_outputs.erase(outpoint);
+    }
+}
+
+void CWallet::ForEachListedTx(const TxListFilter& filter, const std::optional<TxListCursor>& after,
+                              const std::function<bool(const CWalletTx&, const TxListCursor&)>& visit) const
+{
+    AssertLockHeld(cs_wallet);
+    std::set<CTxDestination> label_destinations;
+    if (filter.label) {
+        for (const auto& [dest, data] : m_address_book) {
+            if (!data.IsChange() && data.GetLabel() == *filter.label) label_destinations.insert(dest);
+        }
+    }
+    const auto take = [&](const CWalletTx& wtx) {
+        if (filter.exclude_coinstakes && wtx.IsCoinStake()) return false;
+        if (!filter.label) return true;
+        return std::any_of(wtx.tx->vout.begin(), wtx.tx->vout.end(), [&](const CTxOut& txout) {
+            CTxDestination dest;
+            return ExtractDestination(txout.scriptPubKey, dest) && label_destinations.count(dest);
+        });
+    };
+
+    if (filter.HasHeightRange()) {
+        // Inclusive, the cursor itself being left out
+        std::pair<int, int64_t> last{filter.max_height, std::numeric_limits<int64_t>::max()};
+        if (after) last = std::min(last, std::make_pair(after->height, after->order_pos - 1));
+        for (auto it = m_txs_by_height.upper_bound(last); it != m_txs_by_height.begin();) {
+            --it;
+            const auto& [key, wtx] = *it;
+            if (key.first < filter.min_height) break;
+            if (take(*wtx) && !visit(*wtx, {key.first, key.second})) break;
+        }
+        return;
+    }
+
+    const int64_t end{after ? after->order_pos : std::numeric_limits<int64_t>::max()};
+    if (filter.label) {
+        // Merge the transactions of the destinations of the label, each newest first
+        using TxIt = std::map<int64_t, CWalletTx*>::const_iterator;
+        std::vector<std::pair<TxIt, TxIt>> ranges;
+        for (const CTxDestination& dest : label_destinations) {
+            const auto it{m_txs_by_destination.find(dest)};
+            if (it != m_txs_by_destination.end()) ranges.emplace_back(it->second.begin(), it->second.lower_bound(end));
+        }
+        int64_t last_pos{end};
+        while (true) {
+            std::pair<TxIt, TxIt>* newest{nullptr};
+            for (auto& range : ranges) {
+                if (range.first != range.second && (!newest || std::prev(range.second)->first > std::prev(newest->second)->first)) {
+                    newest = &range;
+                }
+            }
+            if (!newest) break;
+            const auto& [pos, wtx] = *--newest->second;
+            // Paying to more than one address of the label
+            if (pos == last_pos) continue;
+            last_pos = pos;
+            if (filter.exclude_coinstakes && wtx->IsCoinStake()) continue;
+            if (!visit(*wtx, {ListedHeight(*wtx), pos})) break;
+        }
+        return;
+    }
+
+    const auto walk = [&](const auto& index) {
+        for (auto it = index.lower_bound(end); it != index.begin();) {
+            --it;
+            if (take(*it->second) && !visit(*it->second, {ListedHeight(*it->second), it->first})) break;
+        }
+    };
+    if (filter.exclude_coinstakes) {
+        walk(m_txs_no_coinstake);
+    } else {
+        walk(wtxOrdered);
+    }
+}
+
+void CWallet::ForEachTxWithUnspent(const std::optional<uint256>& after, const std::function<bool(const CWalletTx&, size_t)>& visit) const
+{
+    AssertLockHeld(cs_wallet);
+    auto it{after ? m_unspent_outputs.upper_bound(COutPoint(*after, COutPoint::NULL_INDEX)) : m_unspent_outputs.begin()};
+    while (it != m_unspent_outputs.end()) {
+        const uint256 txid{it->hash};
+        size_t unspent{0};
+        for (; it != m_unspent_outputs.end() && it->hash == txid; ++it) {
+            ++unspent;
+        }
+        const auto wit{mapWallet.find(txid)};
+        if (wit != mapWallet.end() && !visit(wit->second, unspent)) break;
+    }
+}
+
 bool CWallet::EncryptWallet(const SecureString& strWalletPassphrase)
 {
     if (IsCrypted())
@@ -923,13 +1139,40 @@ int64_t CWallet::IncOrderPosNext(WalletBatch* batch)
     return nRet;
 }
 
+std::vector<CAmount> StakeOutputPolicy::SplitCredit(CAmount credit) const
+{
+    const CAmount outputs{std::clamp<CAmount>(target_size > 0 ? credit / target_size : 1, 1, std::max(1U, max_split))};
+    std::vector<CAmount> amounts(outputs, (credit / outputs / CENT) * CENT);
+    amounts.back() = credit - amounts.front() * (outputs - 1);
+    return amounts;
+}
+
 void CWallet::MarkDirty()
 {
     {
         LOCK(cs_wallet);
         for (std::pair<const uint256, CWalletTx>& item : mapWallet)
             item.second.MarkDirty();
+        MarkBalanceDirty();
+    }
+}
+
+const Balance* CWallet::GetCachedBalance(int min_depth, bool avoid_reuse) const
+{
+    AssertLockHeld(cs_wallet);
+    if (m_balance_cache_block != m_last_block_processed) return nullptr;
+    const auto it{m_balance_cache.find({min_depth, avoid_reuse})};
+    return it == m_balance_cache.end() ? nullptr : &it->second;
+}
+
+void CWallet::SetCachedBalance(int min_depth, bool avoid_reuse, const Balance& balance) const
+{
+    AssertLockHeld(cs_wallet);
+    if (m_balance_cache_block != m_last_block_processed) {
+        m_balance_cache.clear();
+        m_balance_cache_block = m_last_block_processed;
     }
+    m_balance_cache[{min_depth, avoid_reuse}] = balance;
 }
 
 bool CWallet::MarkReplaced(const uint256& originalHash, const uint256& newHash)
@@ -950,6 +1193,7 @@ bool CWallet::MarkReplaced(const uint256& originalHash, const uint256& newHash)
 
     // Refresh mempool status without waiting for transactionRemovedFromMempool or transactionAddedToMempool
     RefreshMempoolStatus(wtx, chain());
+    MarkBalanceDirty();
 
     WalletBatch batch(GetDatabase());
 
@@ -1045,6 +1289,8 @@ CWalletTx* CWallet::AddToWallet(CTransactionRef tx, const TxState& state, const
         wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
         wtx.nTimeSmart = ComputeTimeSmart(wtx, rescanning_old_block);
         AddToSpends(wtx, &batch);
+        // Seen again, as by a rescan: it is back in memory until archived anew
+        if (m_archived_txs.erase(hash)) batch.EraseArchivedTx(hash);
     }
 
     if (!fInsertedNew)
@@ -1080,6 +1326,7 @@ CWalletTx* CWallet::AddToWallet(CTransactionRef tx, const TxState& state, const
             // Break caches since we have changed the state
             desc_tx->MarkDirty();
             batch.WriteTx(*desc_tx);
+            IndexListedTx(*desc_tx);
             MarkInputsDirty(desc_tx->tx);
             for (unsigned int i = 0; i < desc_tx->tx->vout.size(); ++i) {
                 COutPoint outpoint(desc_tx->GetHash(), i);
@@ -1094,6 +1341,14 @@ CWalletTx* CWallet::AddToWallet(CTransactionRef tx, const TxState& state, const
         }
     }
 
+    // Also covers outputs that became ours through an import and rescan
+    AddStakeCandidates(wtx);
+    IndexListedTx(wtx);
+    // A transaction of a block connected is left to the new tip, which wakes every wallet
+    if (fInsertedNew && m_is_staking == NOT_STAKING_BALANCE && !wtx.isConfirmed()) {
+        NotifyCanStake(this);
+    }
+
     //// debug print
     WalletLogPrintf("AddToWallet %s  %s%s\n", hash.ToString(), (fInsertedNew ? "new" : ""), (fUpdated ? "update" : ""));
 
@@ -1104,6 +1359,7 @@ CWalletTx* CWallet::AddToWallet(CTransactionRef tx, const TxState& state, const
 
     // Break debit/credit balance caches:
     wtx.MarkDirty();
+    MarkBalanceDirty();
 
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(hash, fInsertedNew ? CT_NEW : CT_UPDATED);
@@ -1171,6 +1427,7 @@ bool CWallet::LoadToWallet(const uint256& hash, const UpdateWalletTxFn& fill_wtx
         wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
     }
     AddToSpends(wtx);
+    MarkBalanceDirty();
     for (const CTxIn& txin : wtx.tx->vin) {
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
@@ -1183,6 +1440,13 @@ bool CWallet::LoadToWallet(const uint256& hash, const UpdateWalletTxFn& fill_wtx
     return true;
 }
 
+void CWallet::LoadArchivedTx(const uint256& hash, ArchivedTx archived)
+{
+    // Left behind if archiving stopped between writing the record and erasing the transaction
+    if (mapWallet.count(hash)) return;
+    m_archived_txs.emplace(hash, std::move(archived));
+}
+
 bool CWallet::AddToWalletIfInvolvingMe(const CTransactionRef& ptx, const SyncTxState& state, bool fUpdate, bool rescanning_old_block)
 {
     const CTransaction& tx = *ptx;
@@ -1264,6 +1528,7 @@ void CWallet::MarkInputsDirty(const CTransactionRef& tx)
             it->second.MarkDirty();
         }
     }
+    MarkBalanceDirty();
 }
 
 bool CWallet::AbandonTransaction(const uint256& hashTx)
@@ -1301,7 +1566,9 @@ bool CWallet::AbandonTransaction(const uint256& hashTx)
             assert(!wtx.InMempool());
             wtx.m_state = TxStateInactive{/*abandoned=*/true};
             wtx.MarkDirty();
+            MarkBalanceDirty();
             batch.WriteTx(wtx);
+            IndexListedTx(wtx);
             NotifyTransactionChanged(wtx.GetHash(), CT_UPDATED);
             // Iterate over all its outputs, and mark transactions in the wallet that spend them abandoned too.
             // States are not permanent, so these transactions can become unabandoned if they are re-added to the
@@ -1358,7 +1625,9 @@ void CWallet::MarkConflicted(const uint256& hashBlock, int conflicting_height, c
             // Mark transaction as conflicted with this block.
             wtx.m_state = TxStateConflicted{hashBlock, conflicting_height};
             wtx.MarkDirty();
+            MarkBalanceDirty();
             batch.WriteTx(wtx);
+            IndexListedTx(wtx);
             // Iterate over all its outputs, and mark transactions in the wallet that spend them conflicted too
             for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
                 std::pair<TxSpends::const_iterator, TxSpends::const_iterator> range = mapTxSpends.equal_range(COutPoint(now, i));
@@ -1393,6 +1662,7 @@ void CWallet::transactionAddedToMempool(const CTransactionRef& tx) {
     auto it = mapWallet.find(tx->GetHash());
     if (it != mapWallet.end()) {
         RefreshMempoolStatus(it->second, chain());
+        MarkBalanceDirty();
     }
 }
 
@@ -1401,6 +1671,7 @@ void CWallet::transactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRe
     auto it = mapWallet.find(tx->GetHash());
     if (it != mapWallet.end()) {
         RefreshMempoolStatus(it->second, chain());
+        MarkBalanceDirty();
     }
     // Handle transactions that were removed from the mempool because they
     // conflict with transactions in a newly connected block.
@@ -1437,6 +1708,7 @@ void CWallet::blockConnected(const interfaces::BlockInfo& block)
 {
     assert(block.data);
     LOCK(cs_wallet);
+    WalletWriteGroup write_group{GetDatabase()};
 
     m_last_block_processed_height = block.height;
     m_last_block_processed = block.hash;
@@ -1444,6 +1716,9 @@ void CWallet::blockConnected(const interfaces::BlockInfo& block)
         SyncTransaction(block.data->vtx[index], TxStateConfirmed{block.hash, block.height, static_cast<int>(index)});
         transactionRemovedFromMempool(block.data->vtx[index], MemPoolRemovalReason::BLOCK);
     }
+    if (m_archive_depth > 0 && block.height % WALLET_ARCHIVE_INTERVAL == 0) {
+        ArchiveSpentTransactions();
+    }
 }
 
 void CWallet::blockDisconnected(const interfaces::BlockInfo& block)
@@ -1455,6 +1730,7 @@ void CWallet::blockDisconnected(const interfaces::BlockInfo& block)
     // be unconfirmed, whether or not the transaction is added back to the mempool.
     // User may have to call abandontransaction again. It may be addressed in the
     // future with a stickier abandoned state or even removing abandontransaction call.
+    WalletWriteGroup write_group{GetDatabase()};
     m_last_block_processed_height = block.height - 1;
     m_last_block_processed = *Assert(block.prev_hash);
     for (const CTransactionRef& ptx : Assert(block.data)->vtx) {
@@ -1491,6 +1767,11 @@ CAmount CWallet::GetDebit(const CTxIn &txin, const isminefilter& filter) const
                 if (IsMine(prev.tx->vout[txin.prevout.n]) & filter)
                     return prev.tx->vout[txin.prevout.n].nValue;
         }
+        else if (const ArchivedOutput* archived = GetArchivedOutput(txin.prevout))
+        {
+            if (archived->mine & filter)
+                return archived->value;
+        }
     }
     return 0;
 }
@@ -1510,9 +1791,19 @@ isminetype CWallet::IsMine(const CTxDestination& dest) const
 isminetype CWallet::IsMine(const CScript& script) const
 {
     AssertLockHeld(cs_wallet);
+    // Outputs that can never be spent, as the chunks of storage transactions, are nobody's
+    if (script.IsUnspendable()) return ISMINE_NO;
+
     isminetype result = ISMINE_NO;
-    for (const auto& spk_man_pair : m_spk_managers) {
-        result = std::max(result, spk_man_pair.second->IsMine(script));
+    const auto it = m_cached_spks.find(script);
+    if (it != m_cached_spks.end()) {
+        for (const ScriptPubKeyMan* spk_man : it->second) {
+            result = std::max(result, spk_man->IsMine(script));
+        }
+    }
+    // What a legacy wallet watches is not a set of scripts, so it is asked every time
+    if (const LegacyScriptPubKeyMan* spk_man = GetLegacyScriptPubKeyMan()) {
+        result = std::max(result, spk_man->IsMine(script));
     }
     return result;
 }
@@ -1849,8 +2140,8 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
     std::unique_ptr<FastWalletRescanFilter> fast_rescan_filter;
     if (!IsLegacy() && chain().hasBlockFilterIndex(BlockFilterType::BASIC)) fast_rescan_filter = std::make_unique<FastWalletRescanFilter>(*this);
 
-    WalletLogPrintf("Rescan started from block %s... (%s)\n", start_block.ToString(),
-                    fast_rescan_filter ? "fast variant using block filters" : "slow variant inspecting all blocks");
+    WalletLogPrintf("Rescan started from block %s... (%s, %d threads reading ahead)\n", start_block.ToString(),
+                    fast_rescan_filter ? "fast variant using block filters" : "slow variant inspecting all blocks", m_rescan_threads);
 
     fAbortRescan = false;
     ShowProgress(strprintf("%s " + _("Rescanning…").translated, GetDisplayName()), 0); // show rescan progress in GUI as dialog or on splashscreen, if rescan required on startup (e.g. due to corruption)
@@ -1861,6 +2152,13 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
     double progress_end = chain().guessVerificationProgress(end_hash);
     double progress_current = progress_begin;
     int block_height = start_height;
+    // Blocks looked up on threads of their own ahead of the one being scanned,
+    // in chunks of consecutive heights: those of the chunk being scanned, and
+    // those still being looked up, in order
+    std::vector<RescanBlock> read_blocks;
+    int read_blocks_height{start_height - RESCAN_READ_AHEAD_BLOCKS};
+    std::deque<std::future<std::vector<RescanBlock>>> reading;
+    int next_read_height{start_height};
     while (!fAbortRescan && !chain().shutdownRequested()) {
         if (progress_end - progress_begin > 0.0) {
             m_scanning_progress = (progress_current - progress_begin) / (progress_end - progress_begin);
@@ -1877,10 +2175,37 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
             WalletLogPrintf("Still rescanning. At block %d. Progress=%f\n", block_height, progress_current);
         }
 
+        if (fast_rescan_filter) fast_rescan_filter->UpdateIfNeeded();
+
+        RescanBlock* read_block{nullptr};
+        if (m_rescan_threads > 0) {
+            while (reading.size() < size_t(m_rescan_threads) && (!max_height || next_read_height <= *max_height)) {
+                reading.push_back(std::async(std::launch::async, [this, tip_hash, from = next_read_height, filter_set = fast_rescan_filter ? fast_rescan_filter->FilterSet() : nullptr] {
+                    return ReadRescanBlocks(chain(), tip_hash, from, RESCAN_READ_AHEAD_BLOCKS, filter_set);
+                }));
+                next_read_height += RESCAN_READ_AHEAD_BLOCKS;
+            }
+            if (block_height >= read_blocks_height + RESCAN_READ_AHEAD_BLOCKS && !reading.empty()) {
+                read_blocks = reading.front().get();
+                reading.pop_front();
+                read_blocks_height += RESCAN_READ_AHEAD_BLOCKS;
+            }
+            // Blocks read ahead of a reorg are of the old chain, and scanned here instead
+            const int index{block_height - read_blocks_height};
+            if (index >= 0 && size_t(index) < read_blocks.size() && read_blocks[index].hash == block_hash) {
+                read_block = &read_blocks[index];
+            }
+        }
+
         bool fetch_block{true};
         if (fast_rescan_filter) {
-            fast_rescan_filter->UpdateIfNeeded();
-            auto matches_block{fast_rescan_filter->MatchesBlock(block_hash)};
+            // A match holds as more scripts are added, a miss only for the scripts it was checked against
+            std::optional<bool> matches_block;
+            if (read_block && read_block->matches && (*read_block->matches || read_block->filter_set == fast_rescan_filter->FilterSet())) {
+                matches_block = read_block->matches;
+            } else {
+                matches_block = fast_rescan_filter->MatchesBlock(block_hash);
+            }
             if (matches_block.has_value()) {
                 if (*matches_block) {
                     LogPrint(BCLog::SCAN, "Fast rescan: inspect block %d [%s] (filter matched)\n", block_height, block_hash.ToString());
@@ -1902,9 +2227,13 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
         chain().findBlock(block_hash, FoundBlock().inActiveChain(block_still_active).nextBlock(FoundBlock().inActiveChain(next_block).hash(next_block_hash)));
 
         if (fetch_block) {
-            // Read block data
+            // Read block data, unless it was read ahead
             CBlock block;
-            chain().findBlock(block_hash, FoundBlock().data(block));
+            if (read_block && !read_block->block.IsNull()) {
+                block = std::move(read_block->block);
+            } else {
+                chain().findBlock(block_hash, FoundBlock().data(block));
+            }
 
             if (!block.IsNull()) {
                 LOCK(cs_wallet);
@@ -1915,8 +2244,12 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
                     result.status = ScanResult::FAILURE;
                     break;
                 }
-                for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
-                    SyncTransaction(block.vtx[posInBlock], TxStateConfirmed{block_hash, block_height, static_cast<int>(posInBlock)}, fUpdate, /*rescanning_old_block=*/true);
+                {
+                    // One commit for the records of the block
+                    WalletWriteGroup write_group{GetDatabase()};
+                    for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
+                        SyncTransaction(block.vtx[posInBlock], TxStateConfirmed{block_hash, block_height, static_cast<int>(posInBlock)}, fUpdate, /*rescanning_old_block=*/true);
+                    }
                 }
                 // scan succeeded, record block as most recent successfully scanned
                 result.last_scanned_block = block_hash;
@@ -2004,7 +2337,10 @@ bool CWallet::SubmitTxMemoryPoolAndRelay(CWalletTx& wtx, std::string& err_string
     // If transaction was previously in the mempool, it should be updated when
     // TransactionRemovedFromMempool fires.
     bool ret = chain().broadcastTransaction(wtx.tx, m_default_max_tx_fee, relay, err_string);
-    if (ret) wtx.m_state = TxStateInMempool{};
+    if (ret) {
+        wtx.m_state = TxStateInMempool{};
+        MarkBalanceDirty();
+    }
     return ret;
 }
 
@@ -2365,6 +2701,12 @@ DBErrors CWallet::LoadWallet()
         assert(m_internal_spk_managers.empty());
     }
 
+    // In one pass once every transaction is loaded, and each has its final order position
+    m_list_indexes_loaded = true;
+    for (auto& [_, wtx] : mapWallet) {
+        IndexListedTx(wtx);
+    }
+
     return nLoadWalletRet;
 }
 
@@ -2374,12 +2716,18 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
     DBErrors nZapSelectTxRet = WalletBatch(GetDatabase()).ZapSelectTx(vHashIn, vHashOut);
     for (const uint256& hash : vHashOut) {
         const auto& it = mapWallet.find(hash);
+        UnindexListedTx(it->second);
         wtxOrdered.erase(it->second.m_it_wtxOrdered);
+        const CTransactionRef tx{it->second.tx};
         for (const auto& txin : it->second.tx->vin)
             mapTxSpends.erase(txin.prevout);
         mapWallet.erase(it);
+        for (const auto& txin : tx->vin) {
+            UpdateUnspentOutput(txin.prevout);
+        }
         NotifyTransactionChanged(hash, CT_DELETED);
     }
+    MarkBalanceDirty();
 
     if (nZapSelectTxRet == DBErrors::NEED_REWRITE)
     {
@@ -2399,6 +2747,137 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
     return DBErrors::LOAD_OK;
 }
 
+size_t CWallet::DynamicMemoryUsage() const
+{
+    LOCK(cs_wallet);
+    size_t usage{memusage::DynamicUsage(mapWallet) + memusage::DynamicUsage(wtxOrdered) + memusage::DynamicUsage(mapTxSpends) +
+                 memusage::DynamicUsage(m_archived_txs) + memusage::DynamicUsage(m_address_book) +
+                 memusage::DynamicUsage(m_txs_no_coinstake) + memusage::DynamicUsage(m_txs_by_height) +
+                 memusage::DynamicUsage(m_txs_by_destination) + memusage::DynamicUsage(m_unspent_outputs)};
+    for (const auto& [dest, txs] : m_txs_by_destination) {
+        usage += memusage::DynamicUsage(txs);
+    }
+    for (const auto& [hash, wtx] : mapWallet) {
+        // Counted in full, though the mempool may share the transaction
+        usage += RecursiveDynamicUsage(wtx.tx) + memusage::DynamicUsage(wtx.mapValue) + memusage::DynamicUsage(wtx.vOrderForm);
+    }
+    for (const auto& [hash, archived] : m_archived_txs) {
+        usage += memusage::DynamicUsage(archived.outputs);
+    }
+    return usage;
+}
+
+size_t CWallet::ArchiveSpentTransactions()
+{
+    AssertLockHeld(cs_wallet);
+    if (m_archive_depth <= 0 || !HaveChain()) return 0;
+
+    const auto is_deep = [&](const CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) {
+        return wtx.isConfirmed() && GetTxDepthInMainChain(wtx) >= m_archive_depth;
+    };
+    // Calls fn with each output of wtx spent by a transaction in mapWallet, and that transaction
+    const auto for_each_spender = [&](const CWalletTx& wtx, const auto& fn) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) {
+        for (uint32_t n = 0; n < wtx.tx->vout.size(); ++n) {
+            const auto range = mapTxSpends.equal_range(COutPoint{wtx.GetHash(), n});
+            for (auto it = range.first; it != range.second; ++it) {
+                const auto spender = mapWallet.find(it->second);
+                if (spender != mapWallet.end()) fn(n, spender->second);
+            }
+        }
+    };
+
+    // Deep transactions whose outputs of the wallet are all spent by deep transactions
+    std::unordered_set<uint256, SaltedTxidHasher> archived;
+    for (const auto& [hash, wtx] : mapWallet) {
+        if (!is_deep(wtx)) continue;
+        std::vector<bool> spent(wtx.tx->vout.size());
+        for_each_spender(wtx, [&](uint32_t n, const CWalletTx& spender) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) {
+            if (is_deep(spender)) spent[n] = true;
+        });
+        bool all_spent{true};
+        for (uint32_t n = 0; n < wtx.tx->vout.size() && all_spent; ++n) {
+            all_spent = spent[n] || IsMine(wtx.tx->vout[n]) == ISMINE_NO;
+        }
+        if (all_spent) archived.insert(hash);
+    }
+
+    // Those spending from a transaction kept in memory are kept, and so in turn are their spenders
+    std::vector<const CWalletTx*> kept;
+    for (const uint256& hash : archived) {
+        const CWalletTx& wtx{mapWallet.at(hash)};
+        for (const CTxIn& txin : wtx.tx->vin) {
+            if (mapWallet.count(txin.prevout.hash) && !archived.count(txin.prevout.hash)) {
+                kept.push_back(&wtx);
+                break;
+            }
+        }
+    }
+    while (!kept.empty()) {
+        const CWalletTx& wtx{*kept.back()};
+        kept.pop_back();
+        if (!archived.erase(wtx.GetHash())) continue;
+        for_each_spender(wtx, [&](uint32_t, const CWalletTx& spender) {
+            if (archived.count(spender.GetHash())) kept.push_back(&spender);
+        });
+    }
+    if (archived.empty()) return 0;
+
+    size_t count{0};
+    WalletWriteGroup write_group{GetDatabase()};
+    WalletBatch batch{GetDatabase()};
+    for (const uint256& hash : archived) {
+        const auto it = mapWallet.find(hash);
+        const CWalletTx& wtx{it->second};
+        ArchivedTx archived_tx;
+        for (uint32_t n = 0; n < wtx.tx->vout.size(); ++n) {
+            const isminetype mine{IsMine(wtx.tx->vout[n])};
+            if (mine != ISMINE_NO) archived_tx.outputs.push_back({n, wtx.tx->vout[n].nValue, static_cast<uint8_t>(mine)});
+        }
+        if (!batch.WriteArchivedTx(wtx, archived_tx) || !batch.EraseTx(hash)) {
+            WalletLogPrintf("%s: Failed to archive transaction %s\n", __func__, hash.ToString());
+            break;
+        }
+        for (const CTxIn& txin : wtx.tx->vin) {
+            const auto range = mapTxSpends.equal_range(txin.prevout);
+            for (auto spend = range.first; spend != range.second;) {
+                spend = spend->second == hash ? mapTxSpends.erase(spend) : std::next(spend);
+            }
+        }
+        UnindexListedTx(it->second);
+        wtxOrdered.erase(wtx.m_it_wtxOrdered);
+        mapWallet.erase(it);
+        m_archived_txs.emplace(hash, std::move(archived_tx));
+        NotifyTransactionChanged(hash, CT_DELETED);
+        ++count;
+    }
+    MarkBalanceDirty();
+    WalletLogPrintf("Archived %u spent transactions, %u kept in memory\n", count, mapWallet.size());
+    return count;
+}
+
+std::unique_ptr<CWalletTx> CWallet::ReadArchivedTx(const uint256& hash) const
+{
+    AssertLockHeld(cs_wallet);
+    if (!m_archived_txs.count(hash)) return nullptr;
+    auto wtx{std::make_unique<CWalletTx>(nullptr, TxStateInactive{})};
+    if (!WalletBatch(GetDatabase()).ReadArchivedTx(hash, *wtx)) return nullptr;
+    if (auto* conf = wtx->state<TxStateConfirmed>(); conf && HaveChain()) {
+        chain().findBlock(conf->confirmed_block_hash, FoundBlock().height(conf->confirmed_block_height));
+    }
+    return wtx;
+}
+
+const ArchivedOutput* CWallet::GetArchivedOutput(const COutPoint& outpoint) const
+{
+    AssertLockHeld(cs_wallet);
+    const auto it = m_archived_txs.find(outpoint.hash);
+    if (it == m_archived_txs.end()) return nullptr;
+    for (const ArchivedOutput& output : it->second.outputs) {
+        if (output.n == outpoint.n) return &output;
+    }
+    return nullptr;
+}
+
 bool CWallet::SetAddressBookWithDB(WalletBatch& batch, const CTxDestination& address, const std::string& strName, const std::optional<AddressPurpose>& new_purpose)
 {
     bool fUpdated = false;
@@ -2549,6 +3028,7 @@ void CWallet::MarkDestinationsDirty(const std::set<CTxDestination>& destinations
             }
         }
     }
+    MarkBalanceDirty();
 }
 
 void CWallet::ForEachAddrBookEntry(const ListAddrBookFunc& func) const
@@ -3146,6 +3626,33 @@ std::shared_ptr<CWallet> CWallet::Create(WalletContext& context, const std::stri
     walletInstance->m_spend_zero_conf_change = args.GetBoolArg("-spendzeroconfchange", DEFAULT_SPEND_ZEROCONF_CHANGE);
     walletInstance->m_signal_rbf = args.GetBoolArg("-walletrbf", DEFAULT_WALLET_RBF);
 
+    StakeOutputPolicy stake_policy;
+    if (args.IsArgSet("-staketargetsize")) {
+        std::optional<CAmount> target_size = ParseMoney(args.GetArg("-staketargetsize", ""));
+        if (!target_size || *target_size <= 0) {
+            error = AmountErrMsg("staketargetsize", args.GetArg("-staketargetsize", ""));
+            return nullptr;
+        }
+        stake_policy.target_size = *target_size;
+    }
+    // Outputs are combined up to the target size unless told otherwise
+    stake_policy.combine_threshold = stake_policy.target_size;
+    if (args.IsArgSet("-stakecombinethreshold")) {
+        std::optional<CAmount> combine_threshold = ParseMoney(args.GetArg("-stakecombinethreshold", ""));
+        if (!combine_threshold) {
+            error = AmountErrMsg("stakecombinethreshold", args.GetArg("-stakecombinethreshold", ""));
+            return nullptr;
+        }
+        stake_policy.combine_threshold = *combine_threshold;
+    }
+    stake_policy.max_combine = std::max<int64_t>(0, args.GetIntArg("-stakemaxcombine", DEFAULT_STAKE_MAX_COMBINE));
+    stake_policy.max_split = std::max<int64_t>(1, args.GetIntArg("-stakemaxsplit", DEFAULT_STAKE_MAX_SPLIT));
+    WITH_LOCK(walletInstance->cs_wallet, walletInstance->m_stake_policy = stake_policy);
+    walletInstance->m_rescan_threads = std::clamp<int64_t>(args.GetIntArg("-rescanthreads", DEFAULT_RESCAN_THREADS), 0, MAX_RESCAN_THREADS);
+    if (const int64_t archive_depth{args.GetIntArg("-walletarchivedepth", DEFAULT_WALLET_ARCHIVE_DEPTH)}; archive_depth > 0) {
+        walletInstance->m_archive_depth = std::clamp<int64_t>(archive_depth, MIN_WALLET_ARCHIVE_DEPTH, std::numeric_limits<int>::max());
+    }
+
     walletInstance->WalletLogPrintf("Wallet completed loading in %15dms\n", Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
 
     // Try to top up keypool. No-op if the wallet is locked.
@@ -3159,7 +3666,9 @@ std::shared_ptr<CWallet> CWallet::Create(WalletContext& context, const std::stri
         LOCK(walletInstance->cs_wallet);
         walletInstance->SetBroadcastTransactions(args.GetBoolArg("-walletbroadcast", DEFAULT_WALLETBROADCAST));
         walletInstance->WalletLogPrintf("setKeyPool.size() = %u\n",      walletInstance->GetKeyPoolSize());
+        if (chain && walletInstance->m_archive_depth > 0) walletInstance->ArchiveSpentTransactions();
         walletInstance->WalletLogPrintf("mapWallet.size() = %u\n",       walletInstance->mapWallet.size());
+        walletInstance->WalletLogPrintf("m_archived_txs.size() = %u\n",  walletInstance->m_archived_txs.size());
         walletInstance->WalletLogPrintf("m_address_book.size() = %u\n",  walletInstance->m_address_book.size());
     }
 
@@ -3480,11 +3989,15 @@ std::set<ScriptPubKeyMan*> CWallet::GetScriptPubKeyMans(const CScript& script) c
 {
     std::set<ScriptPubKeyMan*> spk_mans;
     SignatureData sigdata;
-    for (const auto& spk_man_pair : m_spk_managers) {
-        if (spk_man_pair.second->CanProvide(script, sigdata)) {
-            spk_mans.insert(spk_man_pair.second.get());
+    const auto it = m_cached_spks.find(script);
+    if (it != m_cached_spks.end()) {
+        for (ScriptPubKeyMan* spk_man : it->second) {
+            if (spk_man->CanProvide(script, sigdata)) spk_mans.insert(spk_man);
         }
     }
+    if (LegacyScriptPubKeyMan* spk_man = GetLegacyScriptPubKeyMan(); spk_man && spk_man->CanProvide(script, sigdata)) {
+        spk_mans.insert(spk_man);
+    }
     return spk_mans;
 }
 
@@ -3504,11 +4017,32 @@ std::unique_ptr<SigningProvider> CWallet::GetSolvingProvider(const CScript& scri
 
 std::unique_ptr<SigningProvider> CWallet::GetSolvingProvider(const CScript& script, SignatureData& sigdata) const
 {
-    for (const auto& spk_man_pair : m_spk_managers) {
-        if (spk_man_pair.second->CanProvide(script, sigdata)) {
-            return spk_man_pair.second->GetSolvingProvider(script);
+    const auto it = m_cached_spks.find(script);
+    if (it != m_cached_spks.end()) {
+        for (ScriptPubKeyMan* spk_man : it->second) {
+            if (spk_man->CanProvide(script, sigdata)) return spk_man->GetSolvingProvider(script);
+        }
+    }
+    if (LegacyScriptPubKeyMan* spk_man = GetLegacyScriptPubKeyMan(); spk_man && spk_man->CanProvide(script, sigdata)) {
+        return spk_man->GetSolvingProvider(script);
+    }
+    return nullptr;
+}
+
+std::unique_ptr<SigningProvider> CWallet::GetSigningProvider(const CScript& script) const
+{
+    const auto it = m_cached_spks.find(script);
+    if (it != m_cached_spks.end()) {
+        for (ScriptPubKeyMan* spk_man : it->second) {
+            const auto desc_spk_man = dynamic_cast<DescriptorScriptPubKeyMan*>(spk_man);
+            if (desc_spk_man && desc_spk_man->IsMine(script) == ISMINE_SPENDABLE) {
+                return desc_spk_man->GetSigningProvider(script, /*include_private=*/true);
+            }
         }
     }
+    if (const LegacyScriptPubKeyMan* spk_man = GetLegacyScriptPubKeyMan()) {
+        return std::make_unique<HidingSigningProvider>(spk_man, /*hide_secret=*/false, /*hide_origin=*/false);
+    }
     return nullptr;
 }
 
@@ -3524,6 +4058,22 @@ std::vector<WalletDescriptor> CWallet::GetWalletDescriptors(const CScript& scrip
     return descs;
 }
 
+void CWallet::CacheNewScriptPubKeys(const std::set<CScript>& spks, ScriptPubKeyMan* spk_man)
+{
+    for (const CScript& script : spks) {
+        std::vector<ScriptPubKeyMan*>& spk_mans{m_cached_spks[script]};
+        if (std::find(spk_mans.begin(), spk_mans.end(), spk_man) == spk_mans.end()) {
+            spk_mans.push_back(spk_man);
+        }
+    }
+}
+
+void CWallet::TopUpCallback(const std::set<CScript>& spks, ScriptPubKeyMan* spk_man)
+{
+    // Legacy ScriptPubKeyMans do not call this, they are asked directly
+    CacheNewScriptPubKeys(spks, spk_man);
+}
+
 LegacyScriptPubKeyMan* CWallet::GetLegacyScriptPubKeyMan() const
 {
     if (IsWalletFlagSet(WALLET_FLAG_DESCRIPTORS)) {
@@ -32,6 +32,8 @@
 
 #include <algorithm>
 #include <atomic>
+#include <functional>
+#include <limits>
 #include <map>
 #include <memory>
 #include <optional>
@@ -116,6 +118,21 @@ constexpr CAmount HIGH_TX_FEE_PER_KB{COIN / 100};
 constexpr CAmount HIGH_MAX_TX_FEE{100 * HIGH_TX_FEE_PER_KB};
 //! Pre-calculated constants for input size estimation in *virtual size*
 static constexpr size_t DUMMY_NESTED_P2WPKH_INPUT_SIZE = 91;
+//! -staketargetsize default
+static const CAmount DEFAULT_STAKE_TARGET_SIZE = 1000 * COIN;
+//! -stakemaxcombine default
+static const unsigned int DEFAULT_STAKE_MAX_COMBINE = 3;
+//! -stakemaxsplit default
+static const unsigned int DEFAULT_STAKE_MAX_SPLIT = 2;
+//! -rescanthreads default, threads looking up blocks ahead of the one a rescan is at
+static constexpr int64_t DEFAULT_RESCAN_THREADS{2};
+static constexpr int64_t MAX_RESCAN_THREADS{16};
+//! -walletarchivedepth default, 0 keeps every transaction in memory
+static constexpr int64_t DEFAULT_WALLET_ARCHIVE_DEPTH{0};
+//! Shallowest depth transactions are archived at, below any reorg the wallet is to follow
+static constexpr int64_t MIN_WALLET_ARCHIVE_DEPTH{100};
+//! Blocks between two passes archiving transactions
+static constexpr int WALLET_ARCHIVE_INTERVAL{1000};
 
 class CCoinControl;
 class CWalletTx;
@@ -264,6 +281,54 @@ struct CRecipient
     bool fSubtractFeeFromAmount;
 };
 
+struct Balance {
+    CAmount m_mine_trusted{0};           //!< Trusted, at depth=GetBalance.min_depth or more
+    CAmount m_mine_untrusted_pending{0}; //!< Untrusted, but in mempool (pending)
+    CAmount m_mine_immature{0};          //!< Immature coinbases in the main chain
+    CAmount m_watchonly_trusted{0};
+    CAmount m_watchonly_untrusted_pending{0};
+    CAmount m_watchonly_immature{0};
+};
+
+/**
+ * How the staker shapes the outputs it stakes with. Small outputs are folded
+ * into coinstakes until they reach the target size, so kernel searches do not
+ * go through dust, and large ones are split, so a wallet keeps enough outputs
+ * to stake often.
+ */
+struct StakeOutputPolicy {
+    //! Size of output to aim for
+    CAmount target_size{DEFAULT_STAKE_TARGET_SIZE};
+    //! Outputs smaller than this are combined into coinstakes with the kernel
+    CAmount combine_threshold{DEFAULT_STAKE_TARGET_SIZE};
+    //! Most outputs combined into a coinstake besides the kernel
+    unsigned int max_combine{DEFAULT_STAKE_MAX_COMBINE};
+    //! Most outputs a coinstake pays to
+    unsigned int max_split{DEFAULT_STAKE_MAX_SPLIT};
+
+    //! The output amounts a coinstake of credit pays: as many as leave each at least target_size, up to max_split
+    std::vector<CAmount> SplitCredit(CAmount credit) const;
+};
+
+/** Which transactions a listing of pages through the wallet takes, see CWallet::ForEachListedTx() */
+struct TxListFilter {
+    //! Leave out coinstakes, of which staking wallets hold most
+    bool exclude_coinstakes{false};
+    //! Only the transactions paying to an address with this label
+    std::optional<std::string> label;
+    //! Only the transactions confirmed in this range of heights, those not confirmed being listed after every block
+    int min_height{0};
+    int max_height{std::numeric_limits<int>::max()};
+
+    bool HasHeightRange() const { return min_height > 0 || max_height < std::numeric_limits<int>::max(); }
+};
+
+/** Where a listing of the wallet transactions stopped: the height and order position of the last one listed */
+struct TxListCursor {
+    int height{0};
+    int64_t order_pos{0};
+};
+
 class WalletRescanReserver; //forward declarations for ScanForWalletTransactions/RescanFromTime
 /**
  * A CWallet maintains a set of transactions and balances, and provides the ability to create new transactions.
@@ -301,9 +366,36 @@ private:
      */
     typedef std::unordered_multimap<COutPoint, uint256, SaltedOutpointHasher> TxSpends;
     TxSpends mapTxSpends GUARDED_BY(cs_wallet);
+    /**
+     * Transactions archived out of mapWallet, by txid. Only their outputs of
+     * the wallet are kept, for the debits of the transactions spending them.
+     */
+    std::unordered_map<uint256, ArchivedTx, SaltedTxidHasher> m_archived_txs GUARDED_BY(cs_wallet);
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid, WalletBatch* batch = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void AddToSpends(const CWalletTx& wtx, WalletBatch* batch = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /**
+     * Indexes of mapWallet for the listings that page through it, so a page
+     * costs as much as the transactions on it. They are filled once the
+     * wallet has loaded, and kept up to date by IndexListedTx().
+     */
+    bool m_list_indexes_loaded GUARDED_BY(cs_wallet){false};
+    //! Transactions other than coinstakes, by order position
+    std::map<int64_t, CWalletTx*> m_txs_no_coinstake GUARDED_BY(cs_wallet);
+    //! Transactions by the height of the block confirming them, std::numeric_limits<int>::max() for the others, then order position
+    std::map<std::pair<int, int64_t>, CWalletTx*> m_txs_by_height GUARDED_BY(cs_wallet);
+    //! Transactions by the destinations of the outputs they pay the wallet, then order position
+    std::map<CTxDestination, std::map<int64_t, CWalletTx*>> m_txs_by_destination GUARDED_BY(cs_wallet);
+    //! Outputs of the wallet no transaction spends, as IsSpent() tells
+    std::set<COutPoint> m_unspent_outputs GUARDED_BY(cs_wallet);
+
+    //! Add wtx to the list indexes, or update it there after its state changed
+    void IndexListedTx(CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    //! Remove wtx from the list indexes, before it leaves mapWallet
+    void UnindexListedTx(CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    //! Put outpoint in m_unspent_outputs or take it out, as IsSpent() and IsMine() tell
+    void UpdateUnspentOutput(const COutPoint& outpoint) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     /**
      * Add a transaction to the wallet, or update it.  confirm.block_* should
      * be set when the transaction was known to be included in a block.  When
@@ -368,6 +460,16 @@ private:
      */
     int m_last_block_processed_height GUARDED_BY(cs_wallet) = -1;
 
+    /**
+     * Balances by the min_depth and avoid_reuse GetBalance was called with, as of
+     * m_balance_cache_block. Depths change with the tip, and everything else that
+     * moves a balance changes a transaction or its state, which calls MarkBalanceDirty.
+     * The staker asks for the balance on every pass, which would otherwise walk
+     * every transaction of the wallet each time.
+     */
+    mutable std::map<std::pair<int, bool>, Balance> m_balance_cache GUARDED_BY(cs_wallet);
+    mutable uint256 m_balance_cache_block GUARDED_BY(cs_wallet);
+
     std::map<OutputType, ScriptPubKeyMan*> m_external_spk_managers;
     std::map<OutputType, ScriptPubKeyMan*> m_internal_spk_managers;
 
@@ -375,6 +477,12 @@ private:
     // ScriptPubKeyMan::GetID. In many cases it will be the hash of an internal structure
     std::map<uint256, std::unique_ptr<ScriptPubKeyMan>> m_spk_managers;
 
+    /**
+     * The descriptor ScriptPubKeyMans watching each script, so that IsMine asks
+     * only those rather than every one. Filled through TopUpCallback.
+     */
+    std::unordered_map<CScript, std::vector<ScriptPubKeyMan*>, SaltedSipHasher> m_cached_spks;
+
     /**
      * Catch wallet up to current chain, scanning new blocks, updating the best
      * block locator and m_last_block_processed, and registering for
@@ -537,6 +645,11 @@ public:
     DBErrors ReorderTransactions();
 
     void MarkDirty();
+    //! Drop the cached balances, for when a transaction or its state changes
+    void MarkBalanceDirty() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) { AssertLockHeld(cs_wallet); m_balance_cache.clear(); }
+    //! The balance cached for these GetBalance arguments at the current tip, or nullptr
+    const Balance* GetCachedBalance(int min_depth, bool avoid_reuse) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    void SetCachedBalance(int min_depth, bool avoid_reuse, const Balance& balance) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
     //! Callback for updating transaction metadata in mapWallet.
     //!
@@ -552,6 +665,7 @@ public:
      */
     CWalletTx* AddToWallet(CTransactionRef tx, const TxState& state, const UpdateWalletTxFn& update_wtx=nullptr, bool fFlushOnClose=true, bool rescanning_old_block = false);
     bool LoadToWallet(const uint256& hash, const UpdateWalletTxFn& fill_wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    void LoadArchivedTx(const uint256& hash, ArchivedTx archived) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void transactionAddedToMempool(const CTransactionRef& tx) override;
     void blockConnected(const interfaces::BlockInfo& block) override;
     void blockDisconnected(const interfaces::BlockInfo& block) override;
@@ -636,6 +750,10 @@ public:
 
     CFeeRate m_pay_tx_fee{DEFAULT_PAY_TX_FEE};
     unsigned int m_confirm_target{DEFAULT_TX_CONFIRM_TARGET};
+    //! See -rescanthreads
+    int m_rescan_threads{DEFAULT_RESCAN_THREADS};
+    //! See -walletarchivedepth
+    int m_archive_depth{DEFAULT_WALLET_ARCHIVE_DEPTH};
     /** Allow Coin Selection to pick unconfirmed UTXOs that were sent from our own wallet if it
      * cannot fund the transaction otherwise. */
     bool m_spend_zero_conf_change{DEFAULT_SPEND_ZEROCONF_CHANGE};
@@ -733,8 +851,43 @@ public:
     void chainStateFlushed(const CBlockLocator& loc) override;
 
     DBErrors LoadWallet();
+
+    /**
+     * Call visit on the transactions filter takes, newest first: by height
+     * when filter has a height range, else in the order they were added to
+     * the wallet. Starts after the transaction the cursor points to, and
+     * stops once visit returns false. Costs as much as the transactions the
+     * index used leaves to filter: those of the range, of the label, or those
+     * other than coinstakes, in that order of preference.
+     */
+    void ForEachListedTx(const TxListFilter& filter, const std::optional<TxListCursor>& after,
+                         const std::function<bool(const CWalletTx&, const TxListCursor&)>& visit) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    /**
+     * Call visit on the transactions with outputs of the wallet no
+     * transaction spends, and how many they have, by txid, starting after the
+     * txid given, until visit returns false.
+     */
+    void ForEachTxWithUnspent(const std::optional<uint256>& after, const std::function<bool(const CWalletTx&, size_t)>& visit) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     DBErrors ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256>& vHashOut) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /**
+     * Move the transactions at least m_archive_depth deep, whose outputs of the
+     * wallet are all spent by transactions as deep, out of mapWallet and into
+     * archived records on disk. Transactions spending outputs of one kept in
+     * memory are kept too, so that no output is taken for unspent.
+     * @return the number of transactions archived
+     */
+    size_t ArchiveSpentTransactions() EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Read back an archived transaction from disk, nullptr if there is none of that txid. */
+    std::unique_ptr<CWalletTx> ReadArchivedTx(const uint256& hash) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    /** Memory held by the transactions in mapWallet, their spends, indexes and archived records, and the address book. */
+    size_t DynamicMemoryUsage() const EXCLUSIVE_LOCKS_REQUIRED(!cs_wallet);
+    /** The archived output of the wallet at outpoint, nullptr if there is none. */
+    const ArchivedOutput* GetArchivedOutput(const COutPoint& outpoint) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    size_t GetArchivedTxCount() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) { return m_archived_txs.size(); }
+
     bool SetAddressBook(const CTxDestination& address, const std::string& strName, const std::optional<AddressPurpose>& purpose);
 
     bool DelAddressBook(const CTxDestination& address);
@@ -798,6 +951,12 @@ public:
      */
     boost::signals2::signal<void (CWallet* wallet)> NotifyStatusChanged;
 
+    /**
+     * Wallet may stake again: it was unlocked, or received coins while short of balance.
+     * Note: Called with lock cs_wallet held when unlocking.
+     */
+    boost::signals2::signal<void (CWallet* wallet)> NotifyCanStake;
+
     /** Inquire whether this wallet broadcasts transactions. */
     bool GetBroadcastTransactions() const { return fBroadcastTransactions; }
     /** Set whether this wallet broadcasts transactions. */
@@ -889,6 +1048,8 @@ public:
     //! Get the SigningProvider for a script
     std::unique_ptr<SigningProvider> GetSolvingProvider(const CScript& script) const;
     std::unique_ptr<SigningProvider> GetSolvingProvider(const CScript& script, SignatureData& sigdata) const;
+    //! Get a SigningProvider with the private keys for a script, as to sign blocks and coinstakes with
+    std::unique_ptr<SigningProvider> GetSigningProvider(const CScript& script) const;
 
     //! Get the wallet descriptors for a script.
     std::vector<WalletDescriptor> GetWalletDescriptors(const CScript& script) const;
@@ -903,6 +1064,10 @@ public:
     const CKeyingMaterial& GetEncryptionKey() const override;
     bool HasEncryptionKeys() const override;
 
+    //! Cache the ScriptPubKeyMan watching each of spks, for IsMine
+    void CacheNewScriptPubKeys(const std::set<CScript>& spks, ScriptPubKeyMan* spk_man);
+    void TopUpCallback(const std::set<CScript>& spks, ScriptPubKeyMan* spk_man) override;
+
     /** Get last block processed height */
     int GetLastBlockHeight() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet)
     {
@@ -980,24 +1145,28 @@ public:
     //! Whether the (external) signer performs R-value signature grinding
     bool CanGrindR() const;
 
-    //! staking-related variables
-    size_t nStakeThread = 1;
-
-    int nStakeLimitHeight = 0;
+    //! staking-related variables, atomic where the stake threads keep them,
+    //! so that they need not take cs_wallet from the wallet's notifications
+    std::atomic<int> nStakeLimitHeight{0};
     std::atomic<bool> fStakingEnabled{true};
-    CAmount nReserveBalance{0};
-    CAmount nStakeCombineThreshold;
-    CAmount nStakeSplitThreshold{COIN / 2};
-
-    //
-    // Uncomment the following line to rollback double staking transaction commit - MH
-    //CAmount nStakeSplitThreshold;
-    size_t nMaxStakeCombine = 3;
-    int64_t nLastCoinStakeSearchTime = 0;
-    mutable int m_greatest_txn_depth = 0;
+    std::atomic<CAmount> nReserveBalance{0};
+    //! See -staketargetsize and setstakepolicy
+    StakeOutputPolicy m_stake_policy GUARDED_BY(cs_wallet);
+    std::atomic<int64_t> nLastCoinStakeSearchTime{0};
+    //! Time the next stake candidate comes of age, 0 if none is too young
+    std::atomic<int64_t> m_stake_next_candidate_time{0};
+    mutable std::atomic<int> m_greatest_txn_depth{0};
     mutable std::atomic_bool m_have_spendable_balance_cached {false};
     mutable CAmount m_spendable_balance_cached = 0;
 
+    //! Outputs the staker may select, ordered by the time their age counts from
+    std::set<std::pair<int64_t, COutPoint>> m_stake_candidates GUARDED_BY(cs_wallet);
+    //! Whether m_stake_candidates holds the whole wallet, it is only filled once staking asks for it
+    bool m_stake_candidates_loaded GUARDED_BY(cs_wallet){false};
+
+    //! Add the spendable outputs of wtx to the stake candidates, once they are loaded
+    void AddStakeCandidates(const CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     enum stakingState {
         NOT_STAKING = 0,
         IS_STAKING = 1,
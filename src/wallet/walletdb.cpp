@@ -31,6 +31,7 @@ namespace DBKeys {
 const std::string ACENTRY{"acentry"};
 const std::string ACTIVEEXTERNALSPK{"activeexternalspk"};
 const std::string ACTIVEINTERNALSPK{"activeinternalspk"};
+const std::string ARCHIVED_TX{"archivedtx"};
 const std::string BESTBLOCK_NOMERKLE{"bestblock_nomerkle"};
 const std::string BESTBLOCK{"bestblock"};
 const std::string CRYPTED_KEY{"ckey"};
@@ -98,6 +99,37 @@ bool WalletBatch::EraseTx(uint256 hash)
     return EraseIC(std::make_pair(DBKeys::TX, hash));
 }
 
+namespace {
+/** An archived transaction record: what stays in memory of it, then the whole transaction */
+template <typename Archived, typename WalletTx>
+struct ArchivedTxRecord {
+    Archived& archived;
+    WalletTx& wtx;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const { s << archived << wtx; }
+    template <typename Stream>
+    void Unserialize(Stream& s) { s >> archived >> wtx; }
+};
+} // namespace
+
+bool WalletBatch::WriteArchivedTx(const CWalletTx& wtx, const ArchivedTx& archived)
+{
+    return WriteIC(std::make_pair(DBKeys::ARCHIVED_TX, wtx.GetHash()), ArchivedTxRecord<const ArchivedTx, const CWalletTx>{archived, wtx});
+}
+
+bool WalletBatch::ReadArchivedTx(const uint256& hash, CWalletTx& wtx)
+{
+    ArchivedTx archived;
+    ArchivedTxRecord<ArchivedTx, CWalletTx> record{archived, wtx};
+    return m_batch->Read(std::make_pair(DBKeys::ARCHIVED_TX, hash), record);
+}
+
+bool WalletBatch::EraseArchivedTx(const uint256& hash)
+{
+    return EraseIC(std::make_pair(DBKeys::ARCHIVED_TX, hash));
+}
+
 bool WalletBatch::WriteKeyMetadata(const CKeyMetadata& meta, const CPubKey& pubkey, const bool overwrite)
 {
     return WriteIC(std::make_pair(DBKeys::KEYMETA, pubkey), meta, overwrite);
@@ -400,6 +432,13 @@ ReadKeyValue(CWallet* pwallet, DataStream& ssKey, CDataStream& ssValue,
             if (!pwallet->LoadToWallet(hash, fill_wtx)) {
                 return false;
             }
+        } else if (strType == DBKeys::ARCHIVED_TX) {
+            uint256 hash;
+            ssKey >> hash;
+            // Only what stays in memory, the rest of the record is read when asked for
+            ArchivedTx archived;
+            ssValue >> archived;
+            pwallet->LoadArchivedTx(hash, std::move(archived));
         } else if (strType == DBKeys::WATCHS) {
             wss.nWatchKeys++;
             CScript script;
@@ -1159,6 +1198,20 @@ bool WalletBatch::TxnAbort()
     return m_batch->TxnAbort();
 }
 
+WalletWriteGroup::WalletWriteGroup(WalletDatabase& database)
+{
+    if (!database.BatchesShareTxn()) return;
+    m_batch = database.MakeBatch(/*flush_on_close=*/false);
+    if (!m_batch->TxnBegin()) m_batch.reset();
+}
+
+WalletWriteGroup::~WalletWriteGroup()
+{
+    if (m_batch && !m_batch->TxnCommit()) {
+        LogPrintf("%s: Failed to commit the grouped wallet writes\n", __func__);
+    }
+}
+
 std::unique_ptr<WalletDatabase> MakeDatabase(const fs::path& path, const DatabaseOptions& options, DatabaseStatus& status, bilingual_str& error)
 {
     bool exists;
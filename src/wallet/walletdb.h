@@ -24,6 +24,7 @@ namespace wallet {
 class CKeyPool;
 class CMasterKey;
 class CWallet;
+struct ArchivedTx;
 class CWalletTx;
 struct WalletContext;
 
@@ -60,6 +61,7 @@ namespace DBKeys {
 extern const std::string ACENTRY;
 extern const std::string ACTIVEEXTERNALSPK;
 extern const std::string ACTIVEINTERNALSPK;
+extern const std::string ARCHIVED_TX;
 extern const std::string BESTBLOCK;
 extern const std::string BESTBLOCK_NOMERKLE;
 extern const std::string CRYPTED_KEY;
@@ -232,6 +234,10 @@ public:
     bool WriteTx(const CWalletTx& wtx);
     bool EraseTx(uint256 hash);
 
+    bool WriteArchivedTx(const CWalletTx& wtx, const ArchivedTx& archived);
+    bool ReadArchivedTx(const uint256& hash, CWalletTx& wtx);
+    bool EraseArchivedTx(const uint256& hash);
+
     bool WriteKeyMetadata(const CKeyMetadata& meta, const CPubKey& pubkey, const bool overwrite);
     bool WriteKey(const CPubKey& vchPubKey, const CPrivKey& vchPrivKey, const CKeyMetadata &keyMeta);
     bool WriteCryptedKey(const CPubKey& vchPubKey, const std::vector<unsigned char>& vchCryptedSecret, const CKeyMetadata &keyMeta);
@@ -296,6 +302,26 @@ private:
     WalletDatabase& m_database;
 };
 
+/**
+ * Groups the writes all batches of a database make while it is in scope into one
+ * transaction, committed when it goes out of scope, so that the records a block
+ * touches cost one commit rather than one each. It does nothing for databases
+ * whose batches do not share transactions, or when a transaction is already in
+ * progress, whose writes are then committed as they would have been.
+ */
+class WalletWriteGroup
+{
+public:
+    explicit WalletWriteGroup(WalletDatabase& database);
+    ~WalletWriteGroup();
+
+    WalletWriteGroup(const WalletWriteGroup&) = delete;
+    WalletWriteGroup& operator=(const WalletWriteGroup&) = delete;
+
+private:
+    std::unique_ptr<DatabaseBatch> m_batch;
+};
+
 //! Compacts BDB state so that wallet.dat is self-contained (if there are changes)
 void MaybeCompactWalletDB(WalletContext& context);
 
@@ -42,3 +42,23 @@ bool CZMQAbstractNotifier::NotifyTransactionRemoval(const CTransaction &/*transa
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyJob(const node::JobInfo &/*job*/)
+{
+    return true;
+}
+
+bool CZMQAbstractNotifier::NotifyAssetConfirmed(const std::string &/*uuid*/, int /*height*/)
+{
+    return true;
+}
+
+bool CZMQAbstractNotifier::NotifyAuthListChanged(const uint160 &/*member*/, bool /*added*/)
+{
+    return true;
+}
+
+bool CZMQAbstractNotifier::NotifyStakeAttempt(const StakeAttempt &/*attempt*/)
+{
+    return true;
+}
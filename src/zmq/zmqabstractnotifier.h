@@ -12,6 +12,12 @@
 class CBlockIndex;
 class CTransaction;
 class CZMQAbstractNotifier;
+struct StakeAttempt;
+class uint160;
+
+namespace node {
+struct JobInfo;
+} // namespace node
 
 using CZMQNotifierFactory = std::unique_ptr<CZMQAbstractNotifier> (*)();
 
@@ -55,6 +61,14 @@ public:
     virtual bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence);
     // Notifies of transactions added to mempool or appearing in blocks
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    // Notifies of every background job that has finished
+    virtual bool NotifyJob(const node::JobInfo &job);
+    // Notifies of every stored asset whose chunks have all been mined
+    virtual bool NotifyAssetConfirmed(const std::string &uuid, int height);
+    // Notifies of every storage authlist addition and removal
+    virtual bool NotifyAuthListChanged(const uint160 &member, bool added);
+    // Notifies of every coin search of the stake threads
+    virtual bool NotifyStakeAttempt(const StakeAttempt &attempt);
 
 protected:
     void* psocket{nullptr};
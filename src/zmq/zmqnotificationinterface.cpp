@@ -4,15 +4,21 @@
 
 #include <zmq/zmqnotificationinterface.h>
 
+#include <interfaces/handler.h>
 #include <logging.h>
+#include <node/interface_ui.h>
+#include <node/jobs.h>
+#include <pos/minter.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
+#include <uint256.h>
 #include <util/system.h>
 #include <validationinterface.h>
 #include <zmq/zmqabstractnotifier.h>
 #include <zmq/zmqpublishnotifier.h>
 #include <zmq/zmqutil.h>
 
+#include <boost/signals2/connection.hpp>
 #include <zmq.h>
 
 #include <cassert>
@@ -47,6 +53,10 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    factories["pubjob"] = CZMQAbstractNotifier::Create<CZMQPublishJobNotifier>;
+    factories["pubassetconfirmed"] = CZMQAbstractNotifier::Create<CZMQPublishAssetConfirmedNotifier>;
+    factories["pubauthlist"] = CZMQAbstractNotifier::Create<CZMQPublishAuthListNotifier>;
+    factories["pubstake"] = CZMQAbstractNotifier::Create<CZMQPublishStakeNotifier>;
 
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
     for (const auto& entry : factories)
@@ -68,6 +78,7 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
         notificationInterface->notifiers = std::move(notifiers);
 
         if (notificationInterface->Initialize()) {
+            notificationInterface->ConnectEventSignals();
             return notificationInterface.release();
         }
     }
@@ -109,6 +120,7 @@ bool CZMQNotificationInterface::Initialize()
 void CZMQNotificationInterface::Shutdown()
 {
     LogPrint(BCLog::ZMQ, "Shutdown notification interface\n");
+    m_event_handlers.clear();
     if (pcontext)
     {
         for (auto& notifier : notifiers) {
@@ -139,6 +151,38 @@ void TryForEachAndRemoveFailed(std::list<std::unique_ptr<CZMQAbstractNotifier>>&
 
 } // anonymous namespace
 
+void CZMQNotificationInterface::ConnectEventSignals()
+{
+    m_event_handlers.push_back(interfaces::MakeSignalHandler(uiInterface.NotifyJobFinished_connect([this](const node::JobInfo& job) {
+        CallFunctionInValidationInterfaceQueue([this, job] {
+            TryForEachAndRemoveFailed(notifiers, [&job](CZMQAbstractNotifier* notifier) {
+                return notifier->NotifyJob(job);
+            });
+        });
+    })));
+    m_event_handlers.push_back(interfaces::MakeSignalHandler(uiInterface.NotifyAssetConfirmed_connect([this](const std::string& uuid, int height) {
+        CallFunctionInValidationInterfaceQueue([this, uuid, height] {
+            TryForEachAndRemoveFailed(notifiers, [&uuid, height](CZMQAbstractNotifier* notifier) {
+                return notifier->NotifyAssetConfirmed(uuid, height);
+            });
+        });
+    })));
+    m_event_handlers.push_back(interfaces::MakeSignalHandler(uiInterface.NotifyAuthListChanged_connect([this](const uint160& member, bool added) {
+        CallFunctionInValidationInterfaceQueue([this, member, added] {
+            TryForEachAndRemoveFailed(notifiers, [&member, added](CZMQAbstractNotifier* notifier) {
+                return notifier->NotifyAuthListChanged(member, added);
+            });
+        });
+    })));
+    m_event_handlers.push_back(interfaces::MakeSignalHandler(uiInterface.NotifyStakeAttempt_connect([this](const StakeAttempt& attempt) {
+        CallFunctionInValidationInterfaceQueue([this, attempt] {
+            TryForEachAndRemoveFailed(notifiers, [&attempt](CZMQAbstractNotifier* notifier) {
+                return notifier->NotifyStakeAttempt(attempt);
+            });
+        });
+    })));
+}
+
 void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
 {
     if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
@@ -11,10 +11,14 @@
 #include <cstdint>
 #include <list>
 #include <memory>
+#include <vector>
 
 class CBlock;
 class CBlockIndex;
 class CZMQAbstractNotifier;
+namespace interfaces {
+class Handler;
+} // namespace interfaces
 
 class CZMQNotificationInterface final : public CValidationInterface
 {
@@ -39,8 +43,13 @@ protected:
 private:
     CZMQNotificationInterface();
 
+    // Storage and staking events come from many threads, and are published
+    // from the validation interface queue, which owns the sockets
+    void ConnectEventSignals();
+
     void* pcontext{nullptr};
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
+    std::vector<std::unique_ptr<interfaces::Handler>> m_event_handlers;
 };
 
 extern CZMQNotificationInterface* g_zmq_notification_interface;
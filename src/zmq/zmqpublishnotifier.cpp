@@ -12,6 +12,8 @@
 #include <netaddress.h>
 #include <netbase.h>
 #include <node/blockstorage.h>
+#include <node/jobs.h>
+#include <pos/minter.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/server.h>
@@ -19,6 +21,7 @@
 #include <streams.h>
 #include <sync.h>
 #include <uint256.h>
+#include <univalue.h>
 #include <version.h>
 #include <zmq/zmqutil.h>
 
@@ -48,6 +51,10 @@ static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
 static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_JOB       = "job";
+static const char *MSG_ASSETCONFIRMED = "assetconfirmed";
+static const char *MSG_AUTHLIST  = "authlist";
+static const char *MSG_STAKE     = "stake";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -309,3 +316,54 @@ bool CZMQPublishSequenceNotifier::NotifyTransactionRemoval(const CTransaction &t
     LogPrint(BCLog::ZMQ, "Publish hashtx mempool removal %s to %s\n", hash.GetHex(), this->address);
     return SendSequenceMsg(*this, hash, /* Mempool (R)emoval */ 'R', mempool_sequence);
 }
+
+// Helper function to send a topic message whose body is a JSON object
+static bool SendJSONMsg(CZMQAbstractPublishNotifier& notifier, const char* command, const UniValue& obj)
+{
+    const std::string body{obj.write()};
+    return notifier.SendZmqMessage(command, body.data(), body.size());
+}
+
+bool CZMQPublishJobNotifier::NotifyJob(const node::JobInfo &job)
+{
+    LogPrint(BCLog::ZMQ, "Publish job %s %s to %s\n", job.id, node::JobStateString(job.state), this->address);
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("id", job.id);
+    obj.pushKV("kind", job.kind);
+    obj.pushKV("state", node::JobStateString(job.state));
+    obj.pushKV("finished", job.finished);
+    if (job.state == node::JobState::FAILED) obj.pushKV("error", job.error);
+    return SendJSONMsg(*this, MSG_JOB, obj);
+}
+
+bool CZMQPublishAssetConfirmedNotifier::NotifyAssetConfirmed(const std::string &uuid, int height)
+{
+    LogPrint(BCLog::ZMQ, "Publish assetconfirmed %s to %s\n", uuid, this->address);
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("uuid", uuid);
+    obj.pushKV("height", height);
+    return SendJSONMsg(*this, MSG_ASSETCONFIRMED, obj);
+}
+
+bool CZMQPublishAuthListNotifier::NotifyAuthListChanged(const uint160 &member, bool added)
+{
+    LogPrint(BCLog::ZMQ, "Publish authlist %s %s to %s\n", added ? "add" : "remove", member.ToString(), this->address);
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("member", member.ToString());
+    obj.pushKV("action", added ? "add" : "remove");
+    return SendJSONMsg(*this, MSG_AUTHLIST, obj);
+}
+
+bool CZMQPublishStakeNotifier::NotifyStakeAttempt(const StakeAttempt &attempt)
+{
+    LogPrint(BCLog::ZMQ, "Publish stake %s at height %d to %s\n", attempt.result, attempt.height, this->address);
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("wallet", attempt.wallet);
+    obj.pushKV("height", attempt.height);
+    obj.pushKV("searchtime", attempt.search_time);
+    obj.pushKV("candidates", (uint64_t)attempt.candidates);
+    obj.pushKV("kernelhashes", attempt.kernel_hashes);
+    obj.pushKV("result", attempt.result);
+    obj.pushKV("staked", attempt.result == "staked");
+    return SendJSONMsg(*this, MSG_STAKE, obj);
+}
@@ -9,6 +9,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <string>
 
 class CBlockIndex;
 class CTransaction;
@@ -65,4 +66,28 @@ public:
     bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence) override;
 };
 
+class CZMQPublishJobNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyJob(const node::JobInfo &job) override;
+};
+
+class CZMQPublishAssetConfirmedNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyAssetConfirmed(const std::string &uuid, int height) override;
+};
+
+class CZMQPublishAuthListNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyAuthListChanged(const uint160 &member, bool added) override;
+};
+
+class CZMQPublishStakeNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyStakeAttempt(const StakeAttempt &attempt) override;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
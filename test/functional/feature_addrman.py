@@ -148,6 +148,29 @@ class AddrmanTest(BitcoinTestFramework):
             self.start_node(0)
         assert_equal(self.nodes[0].getnodeaddresses(), [])
 
+        self.log.info("Check that -peersjournal appends changes instead of rewriting peers.dat")
+        peers_journal = os.path.join(self.nodes[0].datadir, self.chain, "peers_journal.dat")
+        self.restart_node(0, extra_args=["-peersjournal"])
+        assert_equal(os.path.exists(peers_journal), False)
+        self.nodes[0].addpeeraddress(address="1.2.3.4", port=8333)
+        # The first flush writes peers.dat and starts the journal
+        self.restart_node(0, extra_args=["-peersjournal"])
+        assert_equal(os.path.exists(peers_journal), True)
+        with open(peers_dat, "rb") as f:
+            snapshot = f.read()
+        self.nodes[0].addpeeraddress(address="2.3.4.5", port=8333)
+        self.stop_node(0)
+        with open(peers_dat, "rb") as f:
+            assert_equal(f.read(), snapshot)
+        with self.nodes[0].assert_debug_log(["Loaded 2 addresses from peers.dat"]):
+            self.start_node(0, extra_args=["-peersjournal"])
+        assert_equal(len(self.nodes[0].getnodeaddresses(0)), 2)
+
+        self.log.info("Check that the journal is folded into peers.dat without -peersjournal")
+        self.restart_node(0)
+        assert_equal(os.path.exists(peers_journal), False)
+        assert_equal(len(self.nodes[0].getnodeaddresses(0)), 2)
+
 
 if __name__ == "__main__":
     AddrmanTest().main()
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test changing cache sizes at runtime with setcachesizes and -memorybudget."""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error
+
+MIB = 1 << 20
+
+
+class CacheSizesTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.extra_args = [
+            ["-maxmempool=300", "-blockcachesize=32"],
+            ["-maxmempool=300", "-blockcachesize=32", "-memorybudget=1"],
+        ]
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Check the sizes given at startup")
+        sizes = node.setcachesizes()
+        assert_equal(sizes["targets"], sizes["applied"])
+        assert_equal(sizes["targets"]["maxmempool"], 300 * 1000 * 1000)
+        assert_equal(sizes["targets"]["blockcache"], 32 * MIB)
+        assert_equal(sizes["budget"], 0)
+        assert_equal(sizes["scale"], 1)
+
+        self.log.info("Resize the coins cache, the mempool and the block cache")
+        sizes = node.setcachesizes(coinscache=8, maxmempool=10, maxstoragemempool=2, blockcache=4)
+        assert_equal(sizes["applied"], {
+            "coinscache": 8 * MIB,
+            "maxmempool": 10 * 1000 * 1000,
+            "maxstoragemempool": 2 * 1000 * 1000,
+            "blockcache": 4 * MIB,
+        })
+        mempool = node.getmempoolinfo()
+        assert_equal(mempool["maxmempool"], 10 * 1000 * 1000)
+        assert_equal(mempool["maxstoragemempool"], 2 * 1000 * 1000)
+
+        self.log.info("Sizes not given are left alone")
+        assert_equal(node.setcachesizes(maxmempool=20)["applied"]["coinscache"], 8 * MIB)
+
+        self.log.info("Check the limits")
+        assert_raises_rpc_error(-8, "maxmempool must be at least 5 MB", node.setcachesizes, maxmempool=1)
+        assert_raises_rpc_error(-8, "coinscache must be between 1 and", node.setcachesizes, coinscache=0)
+        assert_raises_rpc_error(-8, "blockcache out of range", node.setcachesizes, blockcache=-1)
+
+        self.log.info("Caches shrink when the node is over its memory budget")
+        budget_node = self.nodes[1]
+        self.wait_until(lambda: budget_node.setcachesizes()["shrinks"] > 0, timeout=60)
+        sizes = budget_node.setcachesizes()
+        assert_equal(sizes["budget"], MIB)
+        assert sizes["scale"] < 1
+        assert sizes["memory_used"] > MIB
+        assert sizes["applied"]["maxmempool"] < sizes["targets"]["maxmempool"]
+        assert_equal(budget_node.getmempoolinfo()["maxmempool"], sizes["applied"]["maxmempool"])
+        # Down to a quarter of the targets at most
+        self.wait_until(lambda: budget_node.setcachesizes()["scale"] == 0.25, timeout=60)
+        assert_equal(budget_node.setcachesizes()["applied"]["maxmempool"], 75 * 1000 * 1000)
+
+
+if __name__ == '__main__':
+    CacheSizesTest().main()
@@ -8,6 +8,7 @@
 - Stop the node and restart it with -reindex. Verify that the node has reindexed up to block 3.
 - Stop the node and restart it with -reindex-chainstate. Verify that the node has reindexed up to block 3.
 - Verify that out-of-order blocks are correctly processed, see LoadExternalBlockFile()
+  and LoadExternalBlocks(), with block files parsed as they are indexed or ahead of it.
 """
 
 import os
@@ -21,19 +22,21 @@ class ReindexTest(BitcoinTestFramework):
         self.setup_clean_chain = True
         self.num_nodes = 1
 
-    def reindex(self, justchainstate=False):
+    def reindex(self, justchainstate=False, reindexthreads=None):
         self.generatetoaddress(self.nodes[0], 3, self.nodes[0].get_deterministic_priv_key().address)
         blockcount = self.nodes[0].getblockcount()
         self.stop_nodes()
         extra_args = [["-reindex-chainstate" if justchainstate else "-reindex"]]
+        if reindexthreads is not None:
+            extra_args[0].append(f"-reindexthreads={reindexthreads}")
         self.start_nodes(extra_args)
         assert_equal(self.nodes[0].getblockcount(), blockcount)  # start_node is blocking on reindex
         self.log.info("Success")
 
     # Check that blocks can be processed out of order
     def out_of_order(self):
-        # The previous test created 12 blocks
-        assert_equal(self.nodes[0].getblockcount(), 12)
+        # The previous test created 15 blocks
+        assert_equal(self.nodes[0].getblockcount(), 15)
         self.stop_nodes()
 
         # In this test environment, blocks will always be in order (since
@@ -63,22 +66,27 @@ class ReindexTest(BitcoinTestFramework):
             bf.write(b[b3_start:b4_start])
             bf.write(b[b2_start:b3_start])
 
-        # The reindexing code should detect and accommodate out of order blocks.
-        with self.nodes[0].assert_debug_log([
-            'LoadExternalBlockFile: Out of order block',
-            'LoadExternalBlockFile: Processing out of order child',
-        ]):
-            extra_args = [["-reindex"]]
-            self.start_nodes(extra_args)
-
-        # All blocks should be accepted and processed.
-        assert_equal(self.nodes[0].getblockcount(), 12)
+        # The reindexing code should detect and accommodate out of order blocks,
+        # whether it parses the block files as it indexes them or ahead of it.
+        for load_function, reindexthreads in [('LoadExternalBlockFile', 0), ('LoadExternalBlocks', 2)]:
+            with self.nodes[0].assert_debug_log([
+                f'{load_function}: Out of order block',
+                'LoadUnknownParentChildren: Processing out of order child',
+            ]):
+                extra_args = [["-reindex", f"-reindexthreads={reindexthreads}"]]
+                self.start_nodes(extra_args)
+
+            # All blocks should be accepted and processed.
+            assert_equal(self.nodes[0].getblockcount(), 15)
+            self.stop_nodes()
+        self.start_nodes()
 
     def run_test(self):
         self.reindex(False)
         self.reindex(True)
         self.reindex(False)
         self.reindex(True)
+        self.reindex(False, reindexthreads=0)
 
         self.out_of_order()
 
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test that small fetches do not wait behind a large store.
+
+With a single job thread, a large store lets the jobs waiting for a thread
+that are small, or more urgent, run between its batches of chunks.
+"""
+
+import os
+
+from test_framework.storage import make_key, wait_for_job, write_file
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+SMALL_FILE_SIZE = 3000
+# Enough batches of chunks that the fetch is queued while the store runs
+LARGE_FILE_SIZE = 10 * 1000 * 1000
+
+
+class StorageQosTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={manager_user}", "-storageindex", "-jobthreads=1"]]
+        self.rpc_timeout = 600
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Authorize a tenant and store a small asset")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenant_wif, tenant_user = make_key(bytes(range(2, 34)))
+        assert_equal(node.allow(tenant_user), "success")
+        self.generate(node, 1)
+        assert_equal(node.auth(tenant_wif)[0], "success")
+        small = node.store(write_file(self.options.tmpdir, "small", os.urandom(SMALL_FILE_SIZE)), "", False, "high")
+        wait_for_job(node, small, timeout=600)
+        self.generate(node, 1)
+        # The size of an asset the index holds tells a small fetch from a large one
+        self.wait_until(lambda: node.getindexinfo("storageindex")["storageindex"]["best_block_height"] == node.getblockcount())
+
+        self.log.info("Check the priority hints")
+        fetch_dir = os.path.join(self.options.tmpdir, "fetch")
+        os.mkdir(fetch_dir)
+        assert_equal(node.store(write_file(self.options.tmpdir, "other", os.urandom(SMALL_FILE_SIZE)), "", False, "urgent"), "invalid-priority")
+        assert_equal(node.fetch(small, fetch_dir, "urgent"), "invalid-priority")
+
+        self.log.info("Fetch the small asset while a large store runs on the only job thread")
+        large = node.store(write_file(self.options.tmpdir, "large", os.urandom(LARGE_FILE_SIZE)), "", False, "low")
+        self.wait_until(lambda: node.getjob(large)["progress_done"] > 0)
+        fetch = node.fetch(small, fetch_dir)
+        fetched = wait_for_job(node, fetch, timeout=600)
+        assert_equal(node.getjob(large)["state"], "running")
+        assert fetched["finished"] <= wait_for_job(node, large, timeout=600)["finished"]
+        with open(os.path.join(fetch_dir, small), "rb") as f:
+            assert_equal(len(f.read()), SMALL_FILE_SIZE)
+
+
+if __name__ == '__main__':
+    StorageQosTest().main()
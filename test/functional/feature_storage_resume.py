@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test resuming a store cut short by a shutdown.
+
+Each batch of chunks a store commits to the wallet is recorded in
+storageuploads.dat. At startup the store is queued again under its uuid,
+skipping the batches the wallet still holds, without the tenant
+authenticating again.
+"""
+
+import os
+
+from test_framework.storage import make_key, wait_for_job
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+# Enough batches of chunks that the shutdown lands in the middle of the store
+FILE_SIZE = 10 * 1000 * 1000
+
+
+class StorageResumeTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={manager_user}", "-storageindex"]]
+        self.rpc_timeout = 600
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Authorize a tenant")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenant_wif, tenant_user = make_key(bytes(range(2, 34)))
+        assert_equal(node.allow(tenant_user), "success")
+        self.generate(node, 1)
+        assert_equal(node.auth(tenant_wif)[0], "success")
+
+        self.log.info("Shut down while a store is committing its batches")
+        path = os.path.join(self.options.tmpdir, "asset")
+        with open(path, "wb") as f:
+            f.write(os.urandom(FILE_SIZE))
+        uuid = node.store(path)
+        self.wait_until(lambda: node.getjob(uuid)["progress_done"] > 0)
+        self.stop_node(0)
+        assert os.path.exists(node.chain_path / "storageuploads.dat")
+
+        self.log.info("Resume the store at startup, skipping the batches committed")
+        with node.assert_debug_log([f"Resuming put of {path} as uuid {uuid}", f"Resuming put of uuid {uuid} after"]):
+            self.start_node(0)
+            wait_for_job(node, uuid, timeout=600)
+        while node.getmempoolinfo()["size"] > 0:
+            self.generate(node, 1)
+
+        self.log.info("Fetch the asset the two runs stored")
+        fetch_dir = os.path.join(self.options.tmpdir, "fetch")
+        os.mkdir(fetch_dir)
+        wait_for_job(node, node.fetch(uuid, fetch_dir), timeout=600)
+        with open(os.path.join(fetch_dir, uuid), "rb") as fetched, open(path, "rb") as original:
+            assert fetched.read() == original.read()
+
+        self.log.info("Check that a finished store is not resumed")
+        with node.assert_debug_log([], unexpected_msgs=["Resuming put"]):
+            self.restart_node(0)
+
+
+if __name__ == '__main__':
+    StorageResumeTest().main()
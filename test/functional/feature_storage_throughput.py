@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Measure the throughput of storing, fetching and listing files end to end.
+
+A regtest node managing its own authList authorizes a tenant, which stores
+files of each size given, a batch per size, mining each batch before the next.
+It then fetches them as the chain grows and lists them as they are added.
+
+Reports:
+- store latency and chunks/s of each file, from the store call to its job done;
+- fetch latency of each file against the chain length;
+- list latency against the number of files stored.
+
+The default sizes keep the test short. For the nightly numbers, run e.g.
+    feature_storage_throughput.py --sizes=1000,100000,1000000,23000000 --results=storage.json
+"""
+
+import json
+import os
+import time
+
+from test_framework.storage import make_key, wait_for_job
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_greater_than,
+)
+
+# Payload bytes of a chunk, OPENCODING_CHUNKMAX
+CHUNK_SIZE = 512
+# Last block of regtest that may be mined by proof of work, consensus.lastPoWBlock
+LAST_POW_BLOCK = 250
+# Blocks mined between fetch rounds, to fetch against longer chains
+FETCH_ROUND_BLOCKS = 10
+
+
+class StorageThroughputTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+        parser.add_argument("--sizes", dest="sizes", default="1000,100000",
+                            help="Comma separated sizes in bytes of the files stored (default: %(default)s)")
+        parser.add_argument("--files-per-size", dest="files_per_size", type=int, default=2,
+                            help="Files stored of each size, in one batch (default: %(default)s)")
+        parser.add_argument("--fetch-rounds", dest="fetch_rounds", type=int, default=2,
+                            help="Rounds of fetching every file, %d blocks apart (default: %%(default)s)" % FETCH_ROUND_BLOCKS)
+        parser.add_argument("--results", dest="results", default=None,
+                            help="Write the measurements to this JSON file")
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[
+            f"-regtestauthuser={manager_user}",
+            "-storageindex",
+            # measure fetches from the chain, not copies of earlier fetches
+            "-storagecachesize=0",
+        ]]
+        self.rpc_timeout = 600
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def authorize_tenant(self):
+        node = self.nodes[0]
+        self.log.info("Authorize a tenant with the key managing the authList")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenant_wif, tenant_user = make_key(bytes(range(2, 34)))
+        assert_equal(node.allow(tenant_user), "success")
+        self.generate(node, 1)
+        assert tenant_user in node.tenants()
+        assert_equal(node.auth(tenant_wif)[0], "success")
+
+    def store_files(self, sizes):
+        node = self.nodes[0]
+        stored = []
+        list_latency = []
+        for size in sizes:
+            self.log.info(f"Store {self.options.files_per_size} files of {size} bytes")
+            for n in range(self.options.files_per_size):
+                path = os.path.join(self.options.tmpdir, f"file_{size}_{n}")
+                with open(path, "wb") as f:
+                    f.write(os.urandom(size))
+                start = time.perf_counter()
+                uuid = node.store(path)
+                assert_equal(len(uuid), 64)
+                wait_for_job(node, uuid, timeout=3600)
+                elapsed = time.perf_counter() - start
+                chunks = (size + CHUNK_SIZE - 1) // CHUNK_SIZE
+                stored.append({"uuid": uuid, "path": path, "size": size, "store_s": elapsed, "chunks_per_s": chunks / elapsed})
+                self.log.info(f"  {uuid}: {elapsed:.3f}s, {chunks / elapsed:.1f} chunks/s")
+
+                start = time.perf_counter()
+                listed = node.list()[0]
+                list_latency.append({"files": len(listed), "list_s": time.perf_counter() - start})
+                assert_equal(len(listed), len(stored))
+
+            # Mine the batch, over as many blocks as it takes
+            while node.getmempoolinfo()["size"] > 0:
+                assert_greater_than(LAST_POW_BLOCK, node.getblockcount())
+                self.generate(node, 1)
+            assert all(asset["height"] != -1 for asset in node.list()[0])
+        return stored, list_latency
+
+    def fetch_files(self, stored):
+        node = self.nodes[0]
+        fetch_latency = []
+        for fetch_round in range(self.options.fetch_rounds):
+            height = node.getblockcount()
+            self.log.info(f"Fetch every file at height {height}")
+            fetch_dir = os.path.join(self.options.tmpdir, f"fetch_{fetch_round}")
+            os.mkdir(fetch_dir)
+            for file in stored:
+                start = time.perf_counter()
+                wait_for_job(node, node.fetch(file["uuid"], fetch_dir), timeout=3600)
+                elapsed = time.perf_counter() - start
+                with open(os.path.join(fetch_dir, file["uuid"]), "rb") as fetched, open(file["path"], "rb") as original:
+                    assert fetched.read() == original.read()
+                fetch_latency.append({"height": height, "size": file["size"], "fetch_s": elapsed})
+                self.log.info(f"  {file['uuid']} ({file['size']} bytes): {elapsed:.3f}s")
+            if fetch_round + 1 < self.options.fetch_rounds:
+                assert_greater_than(LAST_POW_BLOCK, node.getblockcount() + FETCH_ROUND_BLOCKS)
+                self.generate(node, FETCH_ROUND_BLOCKS)
+        return fetch_latency
+
+    def run_test(self):
+        sizes = [int(size) for size in self.options.sizes.split(",")]
+        self.authorize_tenant()
+        stored, list_latency = self.store_files(sizes)
+        fetch_latency = self.fetch_files(stored)
+
+        self.log.info("Summary")
+        for size in sizes:
+            files = [file for file in stored if file["size"] == size]
+            store_s = sum(file["store_s"] for file in files) / len(files)
+            chunks_per_s = sum(file["chunks_per_s"] for file in files) / len(files)
+            fetches = [fetch["fetch_s"] for fetch in fetch_latency if fetch["size"] == size]
+            self.log.info(f"  {size:>10} bytes: store {store_s:.3f}s, {chunks_per_s:.1f} chunks/s, fetch {sum(fetches) / len(fetches):.3f}s")
+        for entry in list_latency:
+            self.log.info(f"  list of {entry['files']:>4} files: {entry['list_s'] * 1000:.1f}ms")
+
+        if self.options.results:
+            with open(self.options.results, "w", encoding="utf8") as f:
+                json.dump({
+                    "store": [{key: file[key] for key in ("size", "store_s", "chunks_per_s")} for file in stored],
+                    "fetch": fetch_latency,
+                    "list": list_latency,
+                }, f, indent=2)
+
+
+if __name__ == '__main__':
+    StorageThroughputTest().main()
@@ -15,6 +15,7 @@ import urllib.parse
 from test_framework.messages import (
     BLOCK_HEADER_SIZE,
     COIN,
+    ser_compact_size,
 )
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
@@ -65,6 +66,7 @@ class RESTTest (BitcoinTestFramework):
             status: int = 200,
             ret_type: RetType = RetType.JSON,
             query_params: typing.Dict[str, typing.Any] = None,
+            headers: typing.Dict[str, str] = None,
             ) -> typing.Union[http.client.HTTPResponse, bytes, str, None]:
         rest_uri = '/rest' + uri
         if req_type in ReqType:
@@ -75,9 +77,9 @@ class RESTTest (BitcoinTestFramework):
         conn = http.client.HTTPConnection(self.url.hostname, self.url.port)
         self.log.debug(f'{http_method} {rest_uri} {body}')
         if http_method == 'GET':
-            conn.request('GET', rest_uri)
+            conn.request('GET', rest_uri, headers=headers or {})
         elif http_method == 'POST':
-            conn.request('POST', rest_uri, body)
+            conn.request('POST', rest_uri, body, headers=headers or {})
         resp = conn.getresponse()
 
         assert_equal(resp.status, status)
@@ -117,6 +119,20 @@ class RESTTest (BitcoinTestFramework):
         # Test /tx with an invalid and an unknown txid
         resp = self.test_rest_request(uri=f"/tx/{INVALID_PARAM}", ret_type=RetType.OBJ, status=400)
         assert_equal(resp.read().decode('utf-8').rstrip(), f"Invalid hash: {INVALID_PARAM}")
+
+        self.log.info("Test the /metrics URI")
+        self.nodes[0].getblockcount()
+        metrics = self.test_rest_request("/metrics", req_type=None, ret_type=RetType.BYTES).decode('utf-8')
+        assert '# TYPE lynx_rpc_duration_seconds histogram' in metrics
+        assert 'lynx_rpc_duration_seconds_bucket{method="getblockcount",le="+Inf"}' in metrics
+        assert 'lynx_rpc_errors_total{method="getblockcount"} 0' in metrics
+        assert 'lynx_http_workers ' in metrics
+        assert f'lynx_chain_height {self.nodes[0].getblockcount()}' in metrics
+        assert 'lynx_mempool_transactions ' in metrics
+        assert 'lynx_peers{direction="outbound"} ' in metrics
+        assert 'lynx_net_message_bytes_total{direction="sent",type="verack"} ' in metrics
+        assert 'lynx_block_connect_seconds_total{stage="total"} ' in metrics
+        assert 'lynx_staking ' in metrics
         resp = self.test_rest_request(uri=f"/tx/{UNKNOWN_PARAM}", ret_type=RetType.OBJ, status=404)
         assert_equal(resp.read().decode('utf-8').rstrip(), f"{UNKNOWN_PARAM} not found")
 
@@ -213,6 +229,20 @@ class RESTTest (BitcoinTestFramework):
         long_uri = '/'.join([f'{txid}-{n_}' for n_ in range(15)])
         self.test_rest_request(f"/getutxos/checkmempool/{long_uri}", http_method='POST', status=200)
 
+        self.log.info("Query many TXOs at once with a binary request")
+        def bulk_request(outpoints):
+            body = b'\x00' + ser_compact_size(len(outpoints))
+            for txid_, n_ in outpoints:
+                body += bytes.fromhex(txid_)[::-1] + n_.to_bytes(4, 'little')
+            return body
+        outpoints = [(txid, n_) for n_ in range(1000)]
+        bin_response = self.test_rest_request("/getutxos", http_method='POST', req_type=ReqType.BIN, body=bulk_request(outpoints), ret_type=RetType.BYTES)
+        bitmap = bin_response[36 + len(ser_compact_size(125)):36 + len(ser_compact_size(125)) + 125]
+        # Every output of the transaction is unspent, and the others do not exist
+        n_outputs = len(self.test_rest_request(f"/tx/{txid}")['vout'])
+        assert_equal([n_ for n_ in range(1000) if bitmap[n_ // 8] >> (n_ % 8) & 1], list(range(n_outputs)))
+        self.test_rest_request("/getutxos", http_method='POST', req_type=ReqType.BIN, body=bulk_request([(txid, 0)] * 10001), status=400, ret_type=RetType.OBJ)
+
         self.generate(self.nodes[0], 1)  # generate block to not affect upcoming tests
 
         self.log.info("Test the /block, /blockhashbyheight, /headers, and /blockfilterheaders URIs")
@@ -311,6 +341,14 @@ class RESTTest (BitcoinTestFramework):
         resp = self.test_rest_request(f"/blockfilterheaders/basic/{INVALID_PARAM}", ret_type=RetType.OBJ, status=400)
         assert_equal(resp.read().decode('utf-8').rstrip(), f"Invalid hash: {INVALID_PARAM}")
 
+        self.log.info("Test the /metrics URI")
+        self.nodes[0].getblockcount()
+        metrics = self.test_rest_request("/metrics", req_type=None, ret_type=RetType.BYTES).decode('utf-8')
+        assert '# TYPE lynx_rpc_duration_seconds histogram' in metrics
+        assert 'lynx_rpc_duration_seconds_bucket{method="getblockcount",le="+Inf"}' in metrics
+        assert 'lynx_rpc_errors_total{method="getblockcount"} 0' in metrics
+        assert 'lynx_http_workers ' in metrics
+
         # Test number parsing
         for num in ['5a', '-5', '0', '2001', '99999999999999999999999999999999999']:
             assert_equal(
@@ -318,6 +356,15 @@ class RESTTest (BitcoinTestFramework):
                 self.test_rest_request(f"/headers/{bb_hash}", ret_type=RetType.BYTES, status=400, query_params={"count": num}),
             )
 
+        # Binary responses take up to 10000 headers
+        genesis_hash = self.nodes[0].getblockhash(0)
+        response = self.test_rest_request(f"/headers/{genesis_hash}", req_type=ReqType.BIN, ret_type=RetType.BYTES, query_params={"count": 10000})
+        assert_equal(len(response), (self.nodes[0].getblockcount() + 1) * BLOCK_HEADER_SIZE)
+        assert_equal(
+            bytes('Header count is invalid or out of acceptable range (1-10000): 10001\r\n', 'ascii'),
+            self.test_rest_request(f"/headers/{genesis_hash}", req_type=ReqType.BIN, ret_type=RetType.BYTES, status=400, query_params={"count": 10001}),
+        )
+
         self.log.info("Test tx inclusion in the /mempool and /block URIs")
 
         # Make 3 chained txs and mine them on node 1
@@ -395,6 +442,26 @@ class RESTTest (BitcoinTestFramework):
                 else:
                     assert "prevout" not in vin
 
+        self.log.info("Test the renderings of deep blocks and their ETags")
+        deep_hash = newblockhash[0]
+        self.generate(self.nodes[1], 5)
+        [uncached] = self.nodes[0].batch([{"method": "getblock", "id": 1, "params": [deep_hash, 3]}])
+        for _ in range(2):  # rendered, then from the cache
+            assert_equal(self.test_rest_request(f"/block/{deep_hash}"), uncached['result'])
+            assert_equal(self.nodes[0].getblock(deep_hash, 3), uncached['result'])
+            hex_block = self.test_rest_request(f"/block/{deep_hash}", req_type=ReqType.HEX, ret_type=RetType.BYTES)
+            assert_equal(hex_block.decode().strip(), self.nodes[0].getblock(deep_hash, 0))
+        for req_type in [ReqType.BIN, ReqType.HEX, ReqType.JSON]:
+            etag = self.test_rest_request(f"/block/{deep_hash}", req_type=req_type, ret_type=RetType.OBJ).getheader('ETag')
+            self.test_rest_request(f"/block/{deep_hash}", req_type=req_type, ret_type=RetType.OBJ, status=304, headers={"If-None-Match": etag})
+            self.test_rest_request(f"/block/{deep_hash}", req_type=req_type, ret_type=RetType.OBJ, status=304, headers={"If-None-Match": f'"other", W/{etag}'})
+        # The JSON description changes with the tip, the block does not
+        json_etag = self.test_rest_request(f"/block/{deep_hash}", ret_type=RetType.OBJ).getheader('ETag')
+        hex_etag = self.test_rest_request(f"/block/{deep_hash}", req_type=ReqType.HEX, ret_type=RetType.OBJ).getheader('ETag')
+        self.generate(self.nodes[1], 1)
+        self.test_rest_request(f"/block/{deep_hash}", ret_type=RetType.OBJ, headers={"If-None-Match": json_etag})
+        self.test_rest_request(f"/block/{deep_hash}", req_type=ReqType.HEX, ret_type=RetType.OBJ, status=304, headers={"If-None-Match": hex_etag})
+
         # Check the same but without tx details
         json_obj = self.test_rest_request(f"/block/notxdetails/{newblockhash[0]}")
         for tx in txs:
@@ -428,5 +495,13 @@ class RESTTest (BitcoinTestFramework):
         resp = self.test_rest_request(f"/deploymentinfo/{INVALID_PARAM}", ret_type=RetType.OBJ, status=400)
         assert_equal(resp.read().decode('utf-8').rstrip(), f"Invalid hash: {INVALID_PARAM}")
 
+        self.log.info("Test the /metrics URI")
+        self.nodes[0].getblockcount()
+        metrics = self.test_rest_request("/metrics", req_type=None, ret_type=RetType.BYTES).decode('utf-8')
+        assert '# TYPE lynx_rpc_duration_seconds histogram' in metrics
+        assert 'lynx_rpc_duration_seconds_bucket{method="getblockcount",le="+Inf"}' in metrics
+        assert 'lynx_rpc_errors_total{method="getblockcount"} 0' in metrics
+        assert 'lynx_http_workers ' in metrics
+
 if __name__ == '__main__':
     RESTTest().main()
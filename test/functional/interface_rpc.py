@@ -48,6 +48,25 @@ class RPCInterfaceTest(BitcoinTestFramework):
         assert_greater_than_or_equal(command['duration'], 0)
         assert_equal(info['logpath'], os.path.join(self.nodes[0].datadir, self.chain, 'debug.log'))
 
+        self.log.info("Testing that getrpcinfo counts requests kept alive on a connection...")
+        http = self.nodes[0].getrpcinfo()['http']
+        assert_equal(http['workers'], 4)
+        assert_equal(http['max_workers'], 16)
+        assert_equal(http['requests_rejected'], 0)
+        # The test framework keeps its connection to the node open between calls
+        assert_greater_than_or_equal(http['requests_reused'], 1)
+        assert_greater_than_or_equal(http['requests'], http['requests_reused'] + http['connections'])
+
+        self.log.info("Testing that getrpcinfo keeps latency statistics per method...")
+        self.nodes[0].getblockcount()
+        stats = self.nodes[0].getrpcinfo()['methods']['getblockcount']
+        assert_greater_than_or_equal(stats['calls'], 1)
+        assert_equal(stats['errors'], 0)
+        assert_greater_than_or_equal(stats['bytes_out'], 1)
+        assert stats['p50'] <= stats['p95'] <= stats['p99']
+        assert_greater_than_or_equal(stats['max'], stats['mean'])
+        assert 'invalidmethod' not in self.nodes[0].getrpcinfo()['methods']
+
     def test_batch_request(self):
         self.log.info("Testing basic JSON-RPC batch request...")
 
@@ -74,15 +93,48 @@ class RPCInterfaceTest(BitcoinTestFramework):
         assert_equal(result_by_id[3]['error'], None)
         assert result_by_id[3]['result'] is not None
 
+        self.log.info("Testing that a large batch request keeps the order of its requests...")
+        self.generate(self.nodes[0], 20)
+        requests = [{"method": "getblockhash", "id": i, "params": [i % 21]} for i in range(200)]
+        results = self.nodes[0].batch(requests)
+        assert_equal([res["id"] for res in results], list(range(200)))
+        for i, res in enumerate(results):
+            assert_equal(res['error'], None)
+            assert_equal(res['result'], self.nodes[0].getblockhash(i % 21))
+
+    def test_streamed_result(self):
+        self.log.info("Testing that a streamed result matches the result returned whole...")
+        node = self.nodes[0]
+        blockhash = node.getbestblockhash()
+        # Requests of a batch are never streamed
+        for verbosity in [2, 3]:
+            [batched] = node.batch([{"method": "getblock", "id": 1, "params": [blockhash, verbosity]}])
+            assert_equal(node.getblock(blockhash, verbosity), batched['result'])
+        [batched] = node.batch([{"method": "getrawmempool", "id": 1, "params": [True]}])
+        assert_equal(node.getrawmempool(True), batched['result'])
+
     def test_http_status_codes(self):
         self.log.info("Testing HTTP status codes for JSON-RPC requests...")
 
         expect_http_status(404, -32601, self.nodes[0].invalidmethod)
         expect_http_status(500, -8, self.nodes[0].getblockhash, 42)
 
+    def test_worker_pool_growth(self):
+        self.log.info("Testing that the worker pool grows while requests wait...")
+        self.restart_node(0, ['-rpcthreads=1', '-rpcmaxthreads=3'])
+        threads = [Thread(target=lambda: self.nodes[0].cli("waitfornewblock", "500").send_cli()) for _ in range(3)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        http = self.nodes[0].getrpcinfo()['http']
+        assert_greater_than_or_equal(http['workers'], 2)
+        assert_greater_than_or_equal(3, http['workers'])
+        assert_equal(http['max_workers'], 3)
+
     def test_work_queue_exceeded(self):
         self.log.info("Testing work queue exceeded...")
-        self.restart_node(0, ['-rpcworkqueue=1', '-rpcthreads=1'])
+        self.restart_node(0, ['-rpcworkqueue=1', '-rpcthreads=1', '-rpcmaxthreads=1'])
         got_exceeded_error = []
         threads = []
         for _ in range(3):
@@ -95,7 +147,9 @@ class RPCInterfaceTest(BitcoinTestFramework):
     def run_test(self):
         self.test_getrpcinfo()
         self.test_batch_request()
+        self.test_streamed_result()
         self.test_http_status_codes()
+        self.test_worker_pool_growth()
         self.test_work_queue_exceeded()
 
 
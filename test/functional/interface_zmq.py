@@ -3,6 +3,7 @@
 # Distributed under the MIT software license, see the accompanying
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 """Test the ZMQ notification interface."""
+import json
 import struct
 from time import sleep
 
@@ -123,6 +124,7 @@ class ZMQTest (BitcoinTestFramework):
             self.test_reorg()
             self.test_multiple_interfaces()
             self.test_ipv6()
+            self.test_job()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -575,6 +577,35 @@ class ZMQTest (BitcoinTestFramework):
         # Should receive the same block hash
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[0].receive().hex())
 
+    def test_job(self):
+        self.log.info("Testing the job notification")
+        address = f"tcp://127.0.0.1:{self.zmq_port_base}"
+        socket = self.ctx.socket(zmq.SUB)
+        sub = ZMQSubscriber(socket, b"job")
+        self.restart_node(0, [f"-zmqpubjob={address}"] + self.extra_args[0])
+        socket.connect(address)
+
+        # Jobs are submitted until the subscriber has joined
+        socket.set(zmq.RCVTIMEO, 1000)
+        while True:
+            job_id = self.nodes[0].submitjob("getblockcount")
+            try:
+                job = json.loads(sub.receive())
+                break
+            except zmq.error.Again:
+                self.log.debug("Didn't receive the job notification, trying again.")
+        while job['id'] != job_id:
+            job = json.loads(sub.receive())
+        assert_equal(job['kind'], "getblockcount")
+        assert_equal(job['state'], "done")
+        assert 'result' not in job
+
+        job_id = self.nodes[0].submitjob("getblockhash", [100000])
+        job = json.loads(sub.receive())
+        assert_equal(job['id'], job_id)
+        assert_equal(job['state'], "failed")
+        assert_equal(job['error'], "Block height out of range")
+
 
 if __name__ == '__main__':
     ZMQTest().main()
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test exchanging headers as "cheaders" messages, negotiated with "sendcheaders".
+
+A node sends "sendcheaders" after verack, and answers the getheaders of the
+peers that sent it one with "cheaders", which leave out hashPrevBlock and
+encode nTime, nVersion and nBits against the headers before.
+"""
+
+from test_framework.messages import (
+    msg_cheaders,
+    msg_getheaders,
+    msg_sendcheaders,
+)
+from test_framework.p2p import P2PInterface
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+BLOCKS = 50
+
+
+class CompressedHeadersTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 3
+        self.extra_args = [[], [], ["-compressedheaders=0"]]
+
+    def setup_network(self):
+        self.setup_nodes()
+
+    def get_headers(self, peer, node):
+        msg = msg_getheaders()
+        msg.locator.vHave = [int(node.getblockhash(0), 16)]
+        peer.send_and_ping(msg)
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.generate(node, BLOCKS, sync_fun=self.no_op)
+        hashes = [node.getblockhash(height) for height in range(1, BLOCKS + 1)]
+
+        self.log.info("Check that sendcheaders is sent after verack")
+        peer = node.add_p2p_connection(P2PInterface())
+        peer.wait_until(lambda: "sendcheaders" in peer.last_message)
+        assert_equal(peer.last_message["sendcheaders"].version, 1)
+
+        self.log.info("Check that a peer sending sendcheaders gets cheaders")
+        peer.send_message(msg_sendcheaders())
+        self.get_headers(peer, node)
+        assert "headers" not in peer.last_message
+        headers = peer.last_message["cheaders"].headers
+        assert_equal(headers[0].hashPrevBlock, int(node.getblockhash(0), 16))
+        assert_equal([f"{header.rehash():064x}" for header in headers], hashes)
+        for header, block_hash in zip(headers, hashes):
+            block = node.getblockheader(block_hash)
+            assert_equal(header.nTime, block["time"])
+            assert_equal(f"{header.nBits:08x}", block["bits"])
+            assert_equal(header.nVersion, block["version"])
+
+        self.log.info("Check that other peers still get headers")
+        plain_peer = node.add_p2p_connection(P2PInterface())
+        self.get_headers(plain_peer, node)
+        assert "cheaders" not in plain_peer.last_message
+        assert_equal(len(plain_peer.last_message["headers"].headers), BLOCKS)
+
+        self.log.info("Check that an unknown encoding version is ignored")
+        future_peer = node.add_p2p_connection(P2PInterface())
+        future_peer.send_message(msg_sendcheaders(version=2))
+        self.get_headers(future_peer, node)
+        assert "cheaders" not in future_peer.last_message
+
+        self.log.info("Check that a node with -compressedheaders=0 neither offers nor sends cheaders")
+        disabled = self.nodes[2]
+        self.generate(disabled, 1, sync_fun=self.no_op)
+        disabled_peer = disabled.add_p2p_connection(P2PInterface())
+        disabled_peer.sync_with_ping()
+        assert "sendcheaders" not in disabled_peer.last_message
+        disabled_peer.send_message(msg_sendcheaders())
+        self.get_headers(disabled_peer, disabled)
+        assert "cheaders" not in disabled_peer.last_message
+        assert "headers" in disabled_peer.last_message
+
+        self.log.info("Check that headers received as cheaders are accepted")
+        receiver = self.nodes[1]
+        sender = receiver.add_p2p_connection(P2PInterface())
+        sender.send_and_ping(msg_cheaders(headers))
+        assert_equal(receiver.getblockheader(hashes[-1])["height"], BLOCKS)
+
+        self.log.info("Check that nodes sync headers with each other as cheaders")
+        # The blocks are downloaded from node0, not from the peer that only sent their headers
+        receiver.disconnect_p2ps()
+        self.connect_nodes(1, 0)
+        self.connect_nodes(2, 0)
+        self.sync_blocks()
+        assert "cheaders" in receiver.getpeerinfo()[0]["bytesrecv_per_msg"]
+        assert "cheaders" not in disabled.getpeerinfo()[-1]["bytesrecv_per_msg"]
+        assert "headers" in disabled.getpeerinfo()[-1]["bytesrecv_per_msg"]
+
+if __name__ == '__main__':
+    CompressedHeadersTest().main()
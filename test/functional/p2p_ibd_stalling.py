@@ -53,6 +53,10 @@ class P2PIBDStallingTest(BitcoinTestFramework):
         NUM_BLOCKS = 1025
         NUM_PEERS = 4
         node = self.nodes[0]
+        # Freeze the time, so that no block download throughput is measured. This keeps the
+        # download window at 1024 blocks and leaves the staller to the stalling logic.
+        self.mocktime = int(time.time()) + 1
+        node.setmocktime(self.mocktime)
         tip = int(node.getbestblockhash(), 16)
         blocks = []
         height = 1
@@ -84,7 +88,7 @@ class P2PIBDStallingTest(BitcoinTestFramework):
 
         self.all_sync_send_with_ping(peers)
         # If there was a peer marked for stalling, it would get disconnected
-        self.mocktime = int(time.time()) + 3
+        self.mocktime += 3
         node.setmocktime(self.mocktime)
         self.all_sync_send_with_ping(peers)
         assert_equal(node.num_test_p2p_connections(), NUM_PEERS)
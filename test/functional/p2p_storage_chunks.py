@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test fetching stored assets from peers with getassetchunks.
+
+Node 0 keeps the storage index and serves asset chunks (-peerstorage). Nodes 1
+and 2 run -blocksonly, so they do not hold an asset while it is unconfirmed and
+can only fetch it from node 0. Node 2 does not fetch from peers.
+"""
+
+import os
+
+from test_framework.messages import (
+    NODE_STORAGE,
+    msg_getassetchunks,
+)
+from test_framework.p2p import P2PInterface
+from test_framework.storage import make_key, wait_for_job
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_greater_than,
+)
+
+# Most data chunks asked for in one getassetchunks, MAX_ASSET_CHUNKS_PER_MSG
+MAX_ASSET_CHUNKS_PER_MSG = 1024
+# Data chunks asked of a peer at a time, ASSET_CHUNKS_PER_REQUEST
+ASSET_CHUNKS_PER_REQUEST = 256
+
+
+class AssetChunksCollector(P2PInterface):
+    def __init__(self):
+        super().__init__()
+        self.answers = []
+
+    def on_assetchunks(self, message):
+        self.answers.append(message)
+
+
+class P2PStorageChunksTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 3
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [
+            [f"-regtestauthuser={manager_user}", "-storageindex", "-peerstorage"],
+            [f"-regtestauthuser={manager_user}", "-storageindex", "-blocksonly"],
+            [f"-regtestauthuser={manager_user}", "-blocksonly", "-storagepeerfetch=0"],
+        ]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def setup_network(self):
+        self.setup_nodes()
+        self.connect_nodes(1, 0)
+        self.connect_nodes(2, 0)
+        self.sync_all()
+
+    def store_asset(self, size):
+        node = self.nodes[0]
+        self.log.info("Authorize a tenant and store an asset")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenant_wif, tenant_user = make_key(bytes(range(2, 34)))
+        assert_equal(node.allow(tenant_user), "success")
+        self.generate(node, 1)
+        assert_equal(node.auth(tenant_wif)[0], "success")
+
+        self.path = os.path.join(self.options.tmpdir, "asset")
+        with open(self.path, "wb") as f:
+            f.write(os.urandom(size))
+        uuid = node.store(self.path)
+        wait_for_job(node, uuid)
+        # Left unconfirmed, so only node 0 holds it
+        assert_greater_than(node.getmempoolinfo()["size"], 0)
+        assert_equal(self.nodes[1].getmempoolinfo()["size"], 0)
+        return uuid
+
+    def test_services(self):
+        self.log.info("Check that only node 0 advertises NODE_STORAGE")
+        assert "STORAGE" in self.nodes[0].getnetworkinfo()["localservicesnames"]
+        assert "STORAGE" not in self.nodes[1].getnetworkinfo()["localservicesnames"]
+        assert int(self.nodes[1].getpeerinfo()[0]["services"], 16) & NODE_STORAGE
+
+        self.log.info("Check that -peerstorage requires -storageindex")
+        self.nodes[2].stop_node()
+        self.nodes[2].assert_start_raises_init_error(
+            ["-peerstorage"],
+            "Error: Cannot set -peerstorage without -storageindex.")
+        self.start_node(2, self.extra_args[2])
+        self.connect_nodes(2, 0)
+
+    def test_fetch(self, uuid):
+        self.log.info("Fetch the unconfirmed asset from node 0")
+        fetch_dir = os.path.join(self.options.tmpdir, "fetch")
+        os.mkdir(fetch_dir)
+        with self.nodes[1].assert_debug_log([f"uuid {uuid} not held locally, fetching it from peers"], unexpected_msgs=["did not send"]):
+            wait_for_job(self.nodes[1], self.nodes[1].fetch(uuid, fetch_dir))
+        with open(os.path.join(fetch_dir, uuid), "rb") as fetched, open(self.path, "rb") as original:
+            assert fetched.read() == original.read()
+
+        self.log.info("Check that a node not fetching from peers does not find it")
+        wait_for_job(self.nodes[2], self.nodes[2].fetch(uuid, fetch_dir), state="failed")
+
+    def test_messages(self, uuid):
+        node = self.nodes[0]
+        self.log.info("Ask node 0 for the header chunk and a range of data chunks")
+        peer = node.add_p2p_connection(AssetChunksCollector())
+        peer.send_and_ping(msg_getassetchunks(bytes.fromhex(uuid), 0, 0))
+        header = peer.answers[-1]
+        assert_equal(header.uuid.hex(), uuid)
+        assert_greater_than(header.chunk_total, ASSET_CHUNKS_PER_REQUEST)
+        assert_greater_than(len(header.header), 0)
+        assert_equal(header.chunks, [])
+
+        peer.send_and_ping(msg_getassetchunks(bytes.fromhex(uuid), 2, 3))
+        answer = peer.answers[-1]
+        assert_equal((answer.first, answer.chunk_total, answer.header), (2, header.chunk_total, header.header))
+        assert_equal(len(answer.chunks), 3)
+
+        self.log.info("Check that chunks not held are answered with none")
+        peer.send_and_ping(msg_getassetchunks(bytes.fromhex(uuid), header.chunk_total, 2))
+        assert_equal((peer.answers[-1].chunk_total, peer.answers[-1].chunks), (0, []))
+        peer.send_and_ping(msg_getassetchunks(bytes(32), 0, 0))
+        assert_equal(peer.answers[-1].chunk_total, 0)
+
+        self.log.info("Check that asking for too many chunks disconnects")
+        with node.assert_debug_log(["requested too many asset chunks"]):
+            peer.send_message(msg_getassetchunks(bytes.fromhex(uuid), 1, MAX_ASSET_CHUNKS_PER_MSG + 1))
+            peer.wait_for_disconnect()
+
+        self.log.info("Check that a node not serving stored assets disconnects")
+        peer = self.nodes[1].add_p2p_connection(P2PInterface())
+        with self.nodes[1].assert_debug_log(["requested asset chunks, which we do not serve"]):
+            peer.send_message(msg_getassetchunks(bytes.fromhex(uuid), 0, 0))
+            peer.wait_for_disconnect()
+
+    def run_test(self):
+        self.test_services()
+        # Enough chunks for a few ranges
+        uuid = self.store_asset(ASSET_CHUNKS_PER_REQUEST * 600 * 2)
+        self.test_messages(uuid)
+        self.test_fetch(uuid)
+
+
+if __name__ == '__main__':
+    P2PStorageChunksTest().main()
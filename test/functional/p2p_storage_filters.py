@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the storage block filter.
+
+Node 0 keeps the basic and storage filter indexes and serves them to peers.
+Node 1 keeps only the storage filter index, which its chain scans use to read
+only the blocks that may hold an asset.
+"""
+
+import os
+
+from test_framework.blockfilter import gcs_filter_matches
+from test_framework.messages import msg_getcfilters
+from test_framework.p2p import P2PInterface
+from test_framework.storage import make_key, wait_for_job
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+)
+
+FILTER_TYPE_STORAGE = 1
+
+
+class FiltersCollector(P2PInterface):
+    def __init__(self):
+        super().__init__()
+        self.cfilters = []
+
+    def on_cfilter(self, message):
+        self.cfilters.append(message)
+
+
+class P2PStorageFiltersTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [
+            [f"-regtestauthuser={manager_user}", "-blockfilterindex=basic", "-blockfilterindex=storage", "-peerblockfilters"],
+            [f"-regtestauthuser={manager_user}", "-blockfilterindex=storage"],
+        ]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def storage_filter(self, node, block_hash):
+        return bytes.fromhex(node.getblockfilter(block_hash, "storage")["filter"])
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Authorize a tenant and store an asset")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenant_wif, tenant_user = make_key(bytes(range(2, 34)))
+        # The tenant as the filter holds it, in memory order
+        tenant = bytes.fromhex(tenant_user)[::-1]
+        assert_equal(node.allow(tenant_user), "success")
+        allow_block = self.generate(node, 1)[0]
+        assert_equal(node.auth(tenant_wif)[0], "success")
+
+        path = os.path.join(self.options.tmpdir, "asset")
+        with open(path, "wb") as f:
+            f.write(os.urandom(5000))
+        uuid = node.store(path)
+        wait_for_job(node, uuid)
+        asset_block = self.generate(node, 1)[0]
+        # Chain scans start below the tip
+        self.generate(node, 1)
+
+        self.log.info("Check the storage filters of the blocks adding the tenant and storing the asset")
+        for n in self.nodes:
+            assert "storage block filter index" in n.getindexinfo()
+        self.wait_until(lambda: all(n.getindexinfo()["storage block filter index"]["synced"] for n in self.nodes))
+        asset_filter = self.storage_filter(node, asset_block)
+        assert gcs_filter_matches(asset_filter, bytes.fromhex(uuid), asset_block)
+        assert gcs_filter_matches(asset_filter, tenant, asset_block)
+        assert not gcs_filter_matches(asset_filter, bytes(32), asset_block)
+        allow_filter = self.storage_filter(node, allow_block)
+        assert gcs_filter_matches(allow_filter, tenant, allow_block)
+        assert not gcs_filter_matches(allow_filter, bytes.fromhex(uuid), allow_block)
+        assert_equal(self.storage_filter(self.nodes[1], asset_block), asset_filter)
+
+        self.log.info("Check that the storage filter is served over P2P")
+        peer = node.add_p2p_connection(FiltersCollector())
+        height = node.getblock(asset_block)["height"]
+        peer.send_and_ping(msg_getcfilters(filter_type=FILTER_TYPE_STORAGE, start_height=height, stop_hash=int(asset_block, 16)))
+        assert_equal(len(peer.cfilters), 1)
+        assert_equal(peer.cfilters[0].filter_type, FILTER_TYPE_STORAGE)
+        assert_equal(peer.cfilters[0].filter_data, asset_filter)
+
+        self.log.info("Fetch the asset, reading only the blocks its storage filter matches")
+        fetch_dir = os.path.join(self.options.tmpdir, "fetch")
+        os.mkdir(fetch_dir)
+        with self.nodes[1].assert_debug_log(["Storage filter leaves 1 of", f"blocks to scan for uuid {uuid}"]):
+            wait_for_job(self.nodes[1], self.nodes[1].fetch(uuid, fetch_dir))
+        with open(os.path.join(fetch_dir, uuid), "rb") as fetched, open(path, "rb") as original:
+            assert fetched.read() == original.read()
+
+        self.log.info("Check that scanblocks does not scan the storage filter")
+        assert_raises_rpc_error(-8, "scanblocks does not scan the storage filter",
+                                node.scanblocks, "start", [], 0, None, "storage")
+
+        self.log.info("Check that -blockfilterindex=1 does not build the storage filter")
+        self.restart_node(1, extra_args=[self.extra_args[1][0], "-blockfilterindex=1"])
+        assert "basic block filter index" in self.nodes[1].getindexinfo()
+        assert "storage block filter index" not in self.nodes[1].getindexinfo()
+        assert_raises_rpc_error(-1, "Index is not enabled for filtertype storage",
+                                self.nodes[1].getblockfilter, asset_block, "storage")
+
+
+if __name__ == '__main__':
+    P2PStorageFiltersTest().main()
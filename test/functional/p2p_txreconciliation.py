@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+# Copyright (c) 2022 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test announcing transactions by reconciling sets of them (BIP 330)
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+
+class TxReconciliationTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 2
+        self.extra_args = [["-txreconciliation"], ["-txreconciliation"]]
+
+    def run_test(self):
+        wallet = MiniWallet(self.nodes[1])
+        wallet.rescan_utxos()
+
+        self.log.info('Check transactions reach the peer initiating reconciliations')
+        # The node connected to is the responder, reconciling every transaction rather than flooding it
+        wtxids = [wallet.send_self_transfer(from_node=self.nodes[1])["wtxid"] for _ in range(10)]
+        self.sync_mempools()
+        assert_equal(sorted(self.nodes[0].getrawmempool()), sorted(self.nodes[1].getrawmempool()))
+        assert_equal(len(self.nodes[0].getrawmempool()), len(wtxids))
+
+        responder_peer = self.nodes[1].getpeerinfo()[0]
+        assert_equal(responder_peer["txs_flooded"], 0)
+        assert_equal(responder_peer["txs_reconciled"], len(wtxids))
+        assert_equal(responder_peer["recon_txs_announced"], len(wtxids))
+        assert responder_peer["recon_rounds"] >= 1
+        assert "sketch" in responder_peer["bytessent_per_msg"]
+
+        initiator_peer = self.nodes[0].getpeerinfo()[0]
+        assert initiator_peer["recon_rounds"] >= 1
+        assert "reqrecon" in initiator_peer["bytessent_per_msg"]
+        assert "reconcildiff" in initiator_peer["bytessent_per_msg"]
+
+        self.log.info('Check transactions reach the responder, flooded or reconciled')
+        for _ in range(10):
+            wallet.send_self_transfer(from_node=self.nodes[0])
+        self.sync_mempools()
+        initiator_peer = self.nodes[0].getpeerinfo()[0]
+        assert_equal(initiator_peer["txs_flooded"] + initiator_peer["txs_reconciled"], 10)
+
+
+if __name__ == '__main__':
+    TxReconciliationTest().main()
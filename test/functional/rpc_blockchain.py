@@ -71,6 +71,7 @@ class BlockchainTest(BitcoinTestFramework):
         self.wallet = MiniWallet(self.nodes[0])
         self._test_prune_disk_space()
         self.mine_chain()
+        self._test_getblockvalidationstats()
         self._test_max_future_block_time()
         self.restart_node(
             0,
@@ -108,6 +109,22 @@ class BlockchainTest(BitcoinTestFramework):
         self.log.info("Avoid warning when assumed chain size is enough")
         self.restart_node(0, extra_args=["-prune=123456789"])
 
+    def _test_getblockvalidationstats(self):
+        self.log.info("Test getblockvalidationstats")
+        node = self.nodes[0]
+        stats = node.getblockvalidationstats()
+        assert_equal(len(stats), 10)
+        assert_equal(stats[0]["hash"], node.getbestblockhash())
+        assert_equal([block["height"] for block in stats], list(range(HEIGHT, HEIGHT - 10, -1)))
+        assert_equal(stats[0]["txs"], len(node.getblock(stats[0]["hash"])["tx"]))
+        assert not stats[0]["proof_of_stake"]
+        for stage in ("check", "stake", "connect", "verify", "total"):
+            assert_greater_than_or_equal(stats[0][stage], 0)
+        assert_greater_than_or_equal(stats[0]["total"], stats[0]["verify"])
+        assert_equal(len(node.getblockvalidationstats(HEIGHT + 1)), HEIGHT)
+        assert_equal(node.getblockvalidationstats(0), [])
+        assert_raises_rpc_error(-8, "count must be between 0 and 1000", node.getblockvalidationstats, 1001)
+
     def _test_max_future_block_time(self):
         self.stop_node(0)
         self.log.info("A block tip of more than MAX_FUTURE_BLOCK_TIME in the future raises an error")
@@ -126,6 +143,7 @@ class BlockchainTest(BitcoinTestFramework):
 
         keys = [
             'bestblockhash',
+            'blockcache',
             'blocks',
             'chain',
             'chainwork',
@@ -135,6 +153,7 @@ class BlockchainTest(BitcoinTestFramework):
             'mediantime',
             'pruned',
             'size_on_disk',
+            'stored_pow_skipped',
             'time',
             'verificationprogress',
             'warnings',
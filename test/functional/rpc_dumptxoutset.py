@@ -2,7 +2,7 @@
 # Copyright (c) 2019-2022 The Bitcoin Core developers
 # Distributed under the MIT software license, see the accompanying
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
-"""Test the generation of UTXO snapshots using `dumptxoutset`.
+"""Test the generation of UTXO snapshots using `dumptxoutset` and the refusal of `loadtxoutset` to load them.
 """
 
 from test_framework.blocktools import COINBASE_MATURITY
@@ -48,6 +48,9 @@ class DumptxoutsetTest(BitcoinTestFramework):
         assert_equal(
             out['txoutset_hash'], '1f7e3befd45dc13ae198dfbb22869a9c5c4196f8e9ef9735831af1288033f890')
         assert_equal(out['nchaintx'], 101)
+        # The stake modifier of a proof-of-work chain only depends on its height.
+        assert_equal(
+            out['stake_modifier'], 'a5d410570158bd56f6a05f023407ca87339c38178daac60931a08b6d33291b64')
 
         # Specifying a path to an existing or invalid file will fail.
         assert_raises_rpc_error(
@@ -56,6 +59,12 @@ class DumptxoutsetTest(BitcoinTestFramework):
         assert_raises_rpc_error(
             -8, "Couldn't open file {}.incomplete for writing".format(invalid_path), node.dumptxoutset, invalid_path)
 
+        # There is no assumeutxo entry for the snapshot height, so the snapshot is refused.
+        assert_raises_rpc_error(
+            -32603, "Unable to load UTXO snapshot {}".format(expected_path), node.loadtxoutset, FILENAME)
+        assert_raises_rpc_error(
+            -8, "Couldn't open file {} for reading".format(invalid_path), node.loadtxoutset, invalid_path)
+
 
 if __name__ == '__main__':
     DumptxoutsetTest().main()
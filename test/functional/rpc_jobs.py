@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test running RPC methods as background jobs with submitjob, getjob, listjobs and canceljob."""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+)
+
+
+class RPCJobsTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.extra_args = [["-jobthreads=2"]]
+
+    def wait_for_job(self, job_id):
+        def finished():
+            return self.nodes[0].getjob(job_id)['state'] not in ('queued', 'running')
+        self.wait_until(finished)
+        return self.nodes[0].getjob(job_id)
+
+    def run_test(self):
+        node = self.nodes[0]
+
+        self.log.info("A job returns what the method returns")
+        job_id = node.submitjob("gettxoutsetinfo", ["muhash"])
+        job = self.wait_for_job(job_id)
+        assert_equal(job['id'], job_id)
+        assert_equal(job['kind'], "gettxoutsetinfo")
+        assert_equal(job['state'], "done")
+        assert_equal(job['result'], node.gettxoutsetinfo("muhash"))
+        assert job['finished'] >= job['started'] >= job['submitted']
+
+        self.log.info("A scan reports its progress")
+        job = self.wait_for_job(node.submitjob("scantxoutset", ["start", ["raw(51)"]]))
+        assert_equal(job['state'], "done")
+        assert_equal(job['result']['success'], True)
+        assert_equal(job['progress_done'], job['progress_total'])
+
+        self.log.info("A job fails with the error of the method")
+        job = self.wait_for_job(node.submitjob("getblockhash", [100000]))
+        assert_equal(job['state'], "failed")
+        assert_equal(job['error'], "Block height out of range")
+        assert 'result' not in job
+
+        self.log.info("Methods are checked when submitted")
+        assert_raises_rpc_error(-32601, "Method not found", node.submitjob, "nosuchmethod")
+        assert_raises_rpc_error(-8, "A job cannot submit jobs", node.submitjob, "submitjob", ["getblockcount"])
+
+        self.log.info("Jobs are listed oldest first, without their results")
+        jobs = node.listjobs()
+        assert_equal([job['kind'] for job in jobs], ["gettxoutsetinfo", "scantxoutset", "getblockhash"])
+        assert all('result' not in job for job in jobs)
+        assert_equal(len(node.listjobs(1)), 1)
+
+        self.log.info("A finished job cannot be cancelled")
+        assert_equal(node.canceljob(job_id), False)
+        assert_raises_rpc_error(-8, "No such job", node.getjob, "0123456789abcdef")
+
+
+if __name__ == '__main__':
+    RPCJobsTest().main()
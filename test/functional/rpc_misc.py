@@ -42,6 +42,17 @@ class RpcMiscTest(BitcoinTestFramework):
         assert_greater_than(memory['chunks_free'], 0)
         assert_equal(memory['used'] + memory['free'], memory['total'])
 
+        self.log.info("test getmemoryinfo usage of each subsystem")
+        usage = node.getmemoryinfo()['usage']
+        # The chain of the cache holds blocks, and the tables of addrman are allocated whole
+        assert_greater_than(usage['block_index'], 0)
+        assert_greater_than(usage['addrman'], 0)
+        subsystems = ['coins_cache', 'mempool', 'block_index', 'addrman', 'jobs', 'storage_cache', 'auth_list', 'auth_signers', 'stake_seen']
+        wallets = sum(usage['wallets'].values()) if 'wallets' in usage else 0
+        assert_equal(sum(usage[subsystem] for subsystem in subsystems) + wallets, usage['total'])
+        if 'resident' in usage:
+            assert_greater_than(usage['resident'], usage['total'])
+
         self.log.info("test mallocinfo")
         try:
             mallocinfo = node.getmemoryinfo(mode="mallocinfo")
@@ -21,6 +21,7 @@ from test_framework.util import (
     assert_approx,
     assert_equal,
     assert_greater_than,
+    assert_greater_than_or_equal,
     assert_raises_rpc_error,
     p2p_port,
 )
@@ -60,6 +61,7 @@ class NetTest(BitcoinTestFramework):
         self.test_connection_count()
         self.test_getpeerinfo()
         self.test_getnettotals()
+        self.test_getnetmsgstats()
         self.test_getnetworkinfo()
         self.test_getaddednodeinfo()
         self.test_service_flags()
@@ -124,6 +126,9 @@ class NetTest(BitcoinTestFramework):
                 "bytesrecv_per_msg": {},
                 "bytessent": 0,
                 "bytessent_per_msg": {},
+                "cmpctblocks_failed": 0,
+                "cmpctblocks_reconstructed": 0,
+                "cmpctblocks_txn_requested": 0,
                 "connection_type": "inbound",
                 "conntime": no_version_peer_conntime,
                 "id": no_version_peer_id,
@@ -134,9 +139,13 @@ class NetTest(BitcoinTestFramework):
                 "lastrecv": 0,
                 "lastsend": 0,
                 "minfeefilter": Decimal("0E-8"),
+                "msgtime_per_msg": {},
                 "network": "not_publicly_routable",
                 "permissions": [],
                 "presynced_headers": -1,
+                "recon_failed": 0,
+                "recon_rounds": 0,
+                "recon_txs_announced": 0,
                 "relaytxes": False,
                 "services": "0000000000000000",
                 "servicesnames": [],
@@ -145,6 +154,8 @@ class NetTest(BitcoinTestFramework):
                 "synced_blocks": -1,
                 "synced_headers": -1,
                 "timeoffset": 0,
+                "txs_flooded": 0,
+                "txs_reconciled": 0,
                 "version": 0,
             },
         )
@@ -168,6 +179,25 @@ class NetTest(BitcoinTestFramework):
             self.wait_until(lambda: peer_after()['bytesrecv_per_msg'].get('pong', 0) >= peer_before['bytesrecv_per_msg'].get('pong', 0) + 32, timeout=1)
             self.wait_until(lambda: peer_after()['bytessent_per_msg'].get('ping', 0) >= peer_before['bytessent_per_msg'].get('ping', 0) + 32, timeout=1)
 
+    def test_getnetmsgstats(self):
+        self.log.info("Test getnetmsgstats")
+        # Every peer sent a version and pongs by now, so both are accounted
+        # for each peer in getpeerinfo and across peers in getnetmsgstats.
+        for peer in self.nodes[0].getpeerinfo():
+            for msg_type in ["version", "pong"]:
+                msg_time = peer["msgtime_per_msg"][msg_type]
+                assert_greater_than_or_equal(msg_time["count"], 1)
+                assert_greater_than_or_equal(msg_time["handler_us"], 0)
+                assert_greater_than_or_equal(msg_time["deserialize_us"], 0)
+                assert_greater_than_or_equal(msg_time["cs_main_wait_us"], 0)
+
+        stats = self.nodes[0].getnetmsgstats()
+        for msg_type in ["version", "pong"]:
+            assert_greater_than_or_equal(stats[msg_type]["count"], 2)
+            for duration in ["deserialize", "handler", "cs_main_wait"]:
+                assert_equal(sum(stats[msg_type][duration]["histogram"]), stats[msg_type]["count"])
+                assert_equal(len(stats[msg_type][duration]["histogram"]), 24)
+
     def test_getnetworkinfo(self):
         self.log.info("Test getnetworkinfo")
         info = self.nodes[0].getnetworkinfo()
@@ -0,0 +1,37 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the getstartupinfo RPC.
+
+The steps of startup run alongside the others are listed with how long
+they took, and getstartupinfo is callable while startup goes on.
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class StartupInfoTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Check the steps of a finished startup")
+        info = node.getstartupinfo()
+        assert_equal(info["warmup"], False)
+        assert_equal(info["status"], "Done loading")
+        assert_equal([step["name"] for step in info["steps"]], ["addrman", "wallets", "authlist"])
+        for step in info["steps"]:
+            assert_equal(step["state"], "done")
+            assert step["elapsed"] >= 0
+
+        self.log.info("Check that the steps are logged as they finish")
+        with node.assert_debug_log(["Startup step addrman done", "Startup step wallets done", "Startup step authlist done"]):
+            self.restart_node(0)
+
+
+if __name__ == '__main__':
+    StartupInfoTest().main()
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test storing several files at once with storebatch.
+
+Each file of a batch is stored as its own asset, with its own uuid and header
+chunk, while their chunks share transactions, chained on a single input.
+"""
+
+import os
+
+from test_framework.storage import make_key, wait_for_job, write_file
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class StorageBatchTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={manager_user}", "-storageindex"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Authorize a tenant")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenant_wif, tenant_user = make_key(bytes(range(2, 34)))
+        assert_equal(node.allow(tenant_user), "success")
+        self.generate(node, 1)
+        assert_equal(node.auth(tenant_wif)[0], "success")
+
+        self.log.info("Store small files and one spanning more than a transaction in a batch")
+        contents = [os.urandom(size) for size in (1000, 1, 3000, 200000, 500, 2000)]
+        paths = [write_file(self.options.tmpdir, f"file{i}.bin", data) for i, data in enumerate(contents)]
+        mempool_before = set(node.getrawmempool())
+        result = node.storebatch(paths)
+        assert_equal([asset["filepath"] for asset in result["assets"]], paths)
+        uuids = [asset["uuid"] for asset in result["assets"]]
+        assert_equal(len(set(uuids)), len(paths))
+        wait_for_job(node, result["job"])
+
+        # The large file fills one transaction, the rest of its chunks and the small files share another
+        assert_equal(len(set(node.getrawmempool()) - mempool_before), 2)
+        self.generate(node, 1)
+
+        self.log.info("Fetch each asset of the batch")
+        fetch_dir = os.path.join(self.options.tmpdir, "fetch")
+        os.mkdir(fetch_dir)
+        for uuid, data in zip(uuids, contents):
+            wait_for_job(node, node.fetch(uuid, fetch_dir))
+            with open(os.path.join(fetch_dir, uuid), "rb") as f:
+                assert_equal(f.read(), data)
+
+        self.log.info("Check the limits of a batch")
+        assert_equal(node.storebatch([]), "invalid-count")
+        assert_equal(node.storebatch([paths[0]] * 1001), "invalid-count")
+        assert_equal(node.storebatch([os.path.join(self.options.tmpdir, "missing")]), "failure")
+        big = write_file(self.options.tmpdir, "big.bin", os.urandom(5 << 20))
+        assert_equal(node.storebatch([big, big]), "batch-too-large")
+        assert_equal(node.storebatch(paths, "urgent"), "invalid-priority")
+
+
+if __name__ == '__main__':
+    StorageBatchTest().main()
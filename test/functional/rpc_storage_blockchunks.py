@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test reading the storage payloads of a block by RPC and REST."""
+
+import http.client
+import json
+import os
+import urllib.parse
+from io import BytesIO
+
+from test_framework.messages import deser_compact_size, deser_string
+from test_framework.storage import make_key, wait_for_job
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error
+
+# Payload bytes of a chunk, OPENCODING_CHUNKMAX
+CHUNK_SIZE = 512
+
+PAYLOAD_TYPES = ["auth", "header", "data"]
+
+
+def deser_block_payloads(data):
+    """Parse the binary form into (txid, index, [(vout, type, payload)])"""
+    f = BytesIO(data)
+    txs = []
+    for _ in range(deser_compact_size(f)):
+        txid = f.read(32)[::-1].hex()
+        index = deser_compact_size(f)
+        payloads = []
+        for _ in range(deser_compact_size(f)):
+            vout = deser_compact_size(f)
+            payload_type = PAYLOAD_TYPES[f.read(1)[0]]
+            payloads.append((vout, payload_type, deser_string(f)))
+        txs.append((txid, index, payloads))
+    assert_equal(f.read(), b"")
+    return txs
+
+
+class StorageBlockChunksTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={manager_user}", "-rest"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def rest_request(self, uri, status=200):
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request("GET", uri)
+        resp = conn.getresponse()
+        assert_equal(resp.status, status)
+        return resp.read()
+
+    def check_formats(self, blockhash, verbose):
+        """The binary, hex and json forms by REST agree with the RPC"""
+        node = self.nodes[0]
+        raw = node.getblockstoragechunks(blockhash, False)
+        assert_equal(self.rest_request(f"/rest/storagechunks/{blockhash}.hex").decode().strip(), raw)
+        assert_equal(self.rest_request(f"/rest/storagechunks/{blockhash}.bin"), bytes.fromhex(raw))
+        assert_equal(json.loads(self.rest_request(f"/rest/storagechunks/{blockhash}.json")), verbose)
+
+        txs = deser_block_payloads(bytes.fromhex(raw))
+        assert_equal(len(txs), len(verbose["transactions"]))
+        for (txid, index, payloads), tx in zip(txs, verbose["transactions"]):
+            assert_equal(txid, tx["txid"])
+            assert_equal(index, tx["index"])
+            assert_equal([(vout, payload_type) for vout, payload_type, _ in payloads],
+                         [(p["vout"], p["type"]) for p in tx["payloads"]])
+            for (_, payload_type, payload), p in zip(payloads, tx["payloads"]):
+                if payload_type == "data":
+                    assert payload.endswith(bytes.fromhex(p["data"]))
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Authorize a tenant and read the auth payload of its block")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenant_wif, tenant_user = make_key(bytes(range(2, 34)))
+        assert_equal(node.allow(tenant_user), "success")
+        blockhash = self.generate(node, 1)[0]
+        res = node.getblockstoragechunks(blockhash)
+        assert_equal(res["hash"], blockhash)
+        assert_equal(res["height"], node.getblockcount())
+        payloads = [p for tx in res["transactions"] for p in tx["payloads"]]
+        assert_equal(len(payloads), 1)
+        assert_equal(payloads[0]["type"], "auth")
+        assert_equal(payloads[0]["operation"], "add")
+        assert_equal(payloads[0]["user"], tenant_user)
+        self.check_formats(blockhash, res)
+
+        self.log.info("Store an asset and read its chunks from the block")
+        assert_equal(node.auth(tenant_wif)[0], "success")
+        path = os.path.join(self.options.tmpdir, "asset")
+        with open(path, "wb") as f:
+            f.write(os.urandom(CHUNK_SIZE * 20))
+        uuid = node.store(path)
+        wait_for_job(node, uuid)
+        blockhash = self.generate(node, 1)[0]
+        res = node.getblockstoragechunks(blockhash)
+        payloads = [p for tx in res["transactions"] for p in tx["payloads"]]
+        assert all(p["uuid"] == uuid for p in payloads)
+        headers = [p for p in payloads if p["type"] == "header"]
+        assert_equal(len(headers), 1)
+        assert_equal(headers[0]["tenant"], tenant_user)
+        assert_equal(headers[0]["filelength"], CHUNK_SIZE * 20)
+        chunknums = sorted(p["chunknum"] for p in payloads if p["type"] == "data")
+        assert_equal(len(chunknums), headers[0]["chunktotal"])
+        assert_equal(chunknums, list(range(chunknums[0], chunknums[0] + len(chunknums))))
+        # The coinbase carries no payload and is left out
+        assert all(tx["index"] > 0 for tx in res["transactions"])
+        self.check_formats(blockhash, res)
+
+        self.log.info("Check a block without storage payloads")
+        blockhash = self.generate(node, 1)[0]
+        assert_equal(node.getblockstoragechunks(blockhash)["transactions"], [])
+        assert_equal(node.getblockstoragechunks(blockhash, False), "00")
+
+        self.log.info("Check an unknown block")
+        assert_raises_rpc_error(-5, "Block not found", node.getblockstoragechunks, "00" * 32)
+        self.rest_request(f"/rest/storagechunks/{'00' * 32}.json", status=404)
+
+
+if __name__ == '__main__':
+    StorageBlockChunksTest().main()
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test storing assets encrypted with -storageencrypt.
+
+The chunks of an encrypted asset are encrypted with a key derived from the
+tenant key, and decrypted as they are fetched. Another tenant fetches nothing.
+"""
+
+import os
+
+from test_framework.storage import make_key, wait_for_job, write_file
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class StorageEncryptTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={manager_user}", "-storagecompress", "-storageencrypt", "-storageindex"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def fetch_batch(self, uuids, name):
+        node = self.nodes[0]
+        fetch_dir = os.path.join(self.options.tmpdir, name)
+        os.mkdir(fetch_dir)
+        return fetch_dir, wait_for_job(node, node.fetchbatch(uuids, fetch_dir)).get("result")
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Authorize two tenants")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenants = [make_key(bytes(range(i, i + 32))) for i in (2, 3)]
+        for _, user in tenants:
+            assert_equal(node.allow(user), "success")
+        self.generate(node, 1)
+        assert_equal(node.auth(tenants[0][0])[0], "success")
+
+        self.log.info("Store a compressible and an incompressible asset encrypted")
+        contents = {}
+        paths = []
+        for name, data in (("text", b"lynx storage " * 20000), ("random", os.urandom(200000))):
+            paths.append(write_file(self.options.tmpdir, name, data))
+            uuid = node.store(paths[-1])
+            wait_for_job(node, uuid)
+            contents[uuid] = data
+        self.generate(node, 1)
+        uuids = list(contents)
+
+        self.log.info("Check that encrypted assets are stored again rather than reused")
+        for path in paths:
+            again = node.store(path, "", True)
+            assert again not in uuids
+            wait_for_job(node, again)
+        self.generate(node, 1)
+
+        self.log.info("Fetch them decrypted, as the tenant that stored them")
+        fetch_dir, result = self.fetch_batch(uuids, "owner")
+        assert_equal(result, {uuid: "success" for uuid in uuids})
+        for uuid, data in contents.items():
+            with open(os.path.join(fetch_dir, uuid), "rb") as f:
+                assert_equal(f.read(), data)
+            span = node.fetchrange(uuid, 1000, 70000)
+            assert_equal(span["filelength"], len(data))
+            assert_equal(bytes.fromhex(span["data"]), data[1000:71000])
+
+        self.log.info("Check that another tenant can not decrypt them")
+        assert_equal(node.auth(tenants[1][0])[0], "success")
+        _, result = self.fetch_batch(uuids, "other")
+        assert_equal(result, {uuid: "ERR_DECRYPT" for uuid in uuids})
+        assert_equal(node.fetchrange(uuids[0], 0, 100), "not-decryptable")
+
+        self.log.info("Check that the assets were not cached decrypted")
+        self.restart_node(0, extra_args=self.extra_args[0][:1])
+        assert_equal(node.auth(tenants[1][0])[0], "success")
+        _, result = self.fetch_batch(uuids, "scan")
+        assert_equal(result, {uuid: "ERR_DECRYPT" for uuid in uuids})
+        assert_equal(node.auth(tenants[0][0])[0], "success")
+        fetch_dir, result = self.fetch_batch(uuids, "rescan")
+        assert_equal(result, {uuid: "success" for uuid in uuids})
+        for uuid, data in contents.items():
+            with open(os.path.join(fetch_dir, uuid), "rb") as f:
+                assert_equal(f.read(), data)
+
+
+if __name__ == '__main__':
+    StorageEncryptTest().main()
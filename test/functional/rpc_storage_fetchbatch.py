@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test fetching several assets at once with fetchbatch.
+
+Without the storage index the assets are gathered in a single pass over the
+blocks; with it each is read from the index. Either way the job gives the
+outcome of each uuid.
+"""
+
+import os
+
+from test_framework.storage import make_key, wait_for_job, write_file
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class StorageFetchBatchTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={manager_user}"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def fetch_batch(self, uuids, name):
+        node = self.nodes[0]
+        fetch_dir = os.path.join(self.options.tmpdir, name)
+        os.mkdir(fetch_dir)
+        return fetch_dir, wait_for_job(node, node.fetchbatch(uuids, fetch_dir)).get("result")
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Authorize a tenant and store assets across several blocks")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenant_wif, tenant_user = make_key(bytes(range(2, 34)))
+        assert_equal(node.allow(tenant_user), "success")
+        self.generate(node, 1)
+        assert_equal(node.auth(tenant_wif)[0], "success")
+
+        contents = {}
+        for i, size in enumerate((100, 3000, 200000, 1)):
+            data = os.urandom(size)
+            uuid = node.store(write_file(self.options.tmpdir, f"file{i}", data))
+            wait_for_job(node, uuid)
+            contents[uuid] = data
+            self.generate(node, 1)
+        uuids = list(contents)
+        missing = "ab" * 32
+
+        self.log.info("Fetch them in one pass over the blocks")
+        fetch_dir, result = self.fetch_batch(uuids + [missing, uuids[0]], "scan")
+        assert_equal(result, {**{uuid: "success" for uuid in uuids}, missing: "ERR_CHUNKAUTHNONE"})
+        for uuid, data in contents.items():
+            with open(os.path.join(fetch_dir, uuid), "rb") as f:
+                assert_equal(f.read(), data)
+        assert not os.path.exists(os.path.join(fetch_dir, missing))
+
+        self.log.info("Fetch them from the storage index")
+        self.restart_node(0, extra_args=self.extra_args[0] + ["-storageindex"])
+        self.wait_until(lambda: node.getindexinfo("storageindex")["storageindex"]["best_block_height"] == node.getblockcount())
+        fetch_dir, result = self.fetch_batch(uuids + [missing], "index")
+        assert_equal(result[missing], "ERR_CHUNKAUTHNONE")
+        for uuid, data in contents.items():
+            assert_equal(result[uuid], "success")
+            with open(os.path.join(fetch_dir, uuid), "rb") as f:
+                assert_equal(f.read(), data)
+
+        self.log.info("Check invalid arguments")
+        assert_equal(node.fetchbatch([], fetch_dir), "invalid-count")
+        assert_equal(node.fetchbatch(["00"], fetch_dir), "invalid-length")
+        assert_equal(node.fetchbatch(uuids, os.path.join(self.options.tmpdir, "none")), "invalid-path")
+        assert_equal(node.fetchbatch(uuids, fetch_dir, "urgent"), "invalid-priority")
+
+
+if __name__ == '__main__':
+    StorageFetchBatchTest().main()
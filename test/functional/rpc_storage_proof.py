@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the fetchproof RPC, proving the chunks of a stored asset against block headers."""
+
+import os
+
+from test_framework.storage import make_key, wait_for_job
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+# Payload bytes of a chunk, OPENCODING_CHUNKMAX
+CHUNK_SIZE = 512
+
+
+class StorageProofTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={manager_user}", "-storageindex"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def store_asset(self, size):
+        node = self.nodes[0]
+        path = os.path.join(self.options.tmpdir, f"asset{size}")
+        with open(path, "wb") as f:
+            f.write(os.urandom(size))
+        uuid = node.store(path)
+        wait_for_job(node, uuid)
+        return uuid
+
+    def check_proof(self, uuid, proof):
+        node = self.nodes[0]
+        assert_equal(proof["uuid"], uuid)
+        chunk_outputs = 0
+        heights = []
+        for block in proof["blocks"]:
+            heights.append(block["height"])
+            assert_equal(node.getblockhash(block["height"]), block["blockhash"])
+            # The merkle proof commits to exactly the transactions given
+            txs = [node.decoderawtransaction(tx) for tx in block["transactions"]]
+            assert_equal(sorted(node.verifytxoutproof(block["proof"])), sorted(tx["txid"] for tx in txs))
+            for tx in txs:
+                chunk_outputs += sum(uuid in out["scriptPubKey"]["hex"] for out in tx["vout"])
+        assert_equal(heights, sorted(set(heights)))
+        # The header chunk and every data chunk
+        assert_equal(chunk_outputs, proof["chunktotal"] + 1)
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Authorize a tenant")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenant_wif, tenant_user = make_key(bytes(range(2, 34)))
+        assert_equal(node.allow(tenant_user), "success")
+        self.generate(node, 1)
+        assert_equal(node.auth(tenant_wif)[0], "success")
+
+        self.log.info("Check that an unconfirmed asset is not proven")
+        uuid = self.store_asset(CHUNK_SIZE * 20)
+        assert_equal(node.fetchproof(uuid), "unconfirmed")
+
+        self.log.info("Prove an asset once mined")
+        self.generate(node, 1)
+        proof = node.fetchproof(uuid)
+        assert_equal(len(proof["blocks"]), 1)
+        self.check_proof(uuid, proof)
+        assert_equal(node.fetchproof(uuid.upper()), proof)
+
+        self.log.info("Check the failures")
+        assert_equal(node.fetchproof("00" * 32), "not-found")
+        assert_equal(node.fetchproof("00" * 31), "invalid-length")
+        self.restart_node(0, extra_args=[self.extra_args[0][0]])
+        assert_equal(node.fetchproof(uuid), "storageindex-required")
+
+
+if __name__ == '__main__':
+    StorageProofTest().main()
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test storing a file again with store's reuse argument.
+
+With -storagecontenthash the header of a protocol 02 asset carries the sha256
+of the file, which the storage index keys the asset by. Storing the same file
+again with reuse gives back the confirmed asset of the tenant instead of
+writing it again.
+"""
+
+import os
+
+from test_framework.storage import make_key, wait_for_job, write_file
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class StorageReuseTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={manager_user}", "-storagecontenthash", "-storageindex"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Authorize two tenants")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenants = [make_key(bytes(range(i, i + 32))) for i in (2, 3)]
+        for _, user in tenants:
+            assert_equal(node.allow(user), "success")
+        self.generate(node, 1)
+        assert_equal(node.auth(tenants[0][0])[0], "success")
+
+        data = os.urandom(3000)
+        path = write_file(self.options.tmpdir, "asset", data)
+        copy = write_file(self.options.tmpdir, "copy", data)
+        other = write_file(self.options.tmpdir, "other", os.urandom(3000))
+
+        self.log.info("Check that an unconfirmed asset is not reused")
+        uuid = node.store(path, "", True)
+        wait_for_job(node, uuid)
+        pending = node.store(copy, "", True)
+        assert pending != uuid
+        wait_for_job(node, pending)
+        self.generate(node, 1)
+
+        self.log.info("Reuse the asset once confirmed, under another name")
+        reused = node.store(copy, "", True)
+        assert reused in (uuid, pending)
+        assert_equal(node.store(path, "", True), reused)
+
+        self.log.info("Check that other files and plain stores are stored")
+        different = node.store(other, "", True)
+        assert different not in (uuid, pending)
+        wait_for_job(node, different)
+        again = node.store(path)
+        assert again not in (uuid, pending)
+        wait_for_job(node, again)
+        self.generate(node, 1)
+
+        self.log.info("Check that the asset of another tenant is not reused")
+        assert_equal(node.auth(tenants[1][0])[0], "success")
+        theirs = node.store(path, "", True)
+        assert theirs not in (uuid, pending, again)
+        wait_for_job(node, theirs)
+
+        self.log.info("Fetch the reused asset, checked against the content hash")
+        fetch_dir = os.path.join(self.options.tmpdir, "fetch")
+        os.mkdir(fetch_dir)
+        wait_for_job(node, node.fetch(reused, fetch_dir))
+        with open(os.path.join(fetch_dir, reused), "rb") as f:
+            assert_equal(f.read(), data)
+
+        self.log.info("Check that reuse requires the storage index")
+        self.restart_node(0, extra_args=[self.extra_args[0][0]])
+        assert_equal(node.auth(tenants[0][0])[0], "success")
+        assert_equal(node.store(path, "", True), "storageindex-required")
+
+
+if __name__ == '__main__':
+    StorageReuseTest().main()
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test getstoragestats.
+
+Stores and fetches assets, and checks what the storage subsystem reports of
+them: the totals of the storage index, the latency of the operations, the
+storage jobs and the caches.
+"""
+
+import os
+
+from test_framework.storage import make_key, wait_for_job, write_file
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class StorageStatsTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={manager_user}", "-storageindex", "-storagecachesize=10"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def fetch(self, uuid, name):
+        node = self.nodes[0]
+        fetch_dir = os.path.join(self.options.tmpdir, name)
+        os.mkdir(fetch_dir)
+        assert_equal(wait_for_job(node, node.fetchbatch([uuid], fetch_dir)).get("result"), {uuid: "success"})
+
+    def run_test(self):
+        node = self.nodes[0]
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+
+        self.log.info("Check the stats of an empty store")
+        stats = node.getstoragestats()
+        assert_equal(stats["assets"], 0)
+        assert_equal(stats["chunks"], 0)
+        assert_equal(stats["indexes"]["storageindex"]["synced"], True)
+        assert_equal(stats["indexes"]["storageindex"]["best_block_height"], node.getblockcount())
+        for op in ("list", "fetch", "store"):
+            assert_equal(stats["latency"][op]["total"], 0)
+            assert_equal([w["count"] for w in stats["latency"][op]["windows"]], [0, 0, 0])
+        assert_equal(stats["worker"]["queued"], 0)
+        assert_equal(stats["cache"]["fetch"]["entries"], 0)
+
+        self.log.info("Store two assets, and bury them deep enough to be cached")
+        uuids = []
+        for name, size in (("small", 1000), ("large", 200000)):
+            uuids.append(node.store(write_file(self.options.tmpdir, name, os.urandom(size))))
+            wait_for_job(node, uuids[-1])
+        self.generate(node, 7)
+
+        self.log.info("Fetch one twice, and list them")
+        self.fetch(uuids[0], "first")
+        self.fetch(uuids[0], "second")
+        assert_equal(len(node.list()[0]), 2)
+
+        stats = node.getstoragestats()
+        assert_equal(stats["assets"], 2)
+        assert stats["chunks"] > 2
+        assert_equal(stats["tenants"], 1)
+        assert_equal(stats["bytes"], 201000)
+        assert stats["fees"] > 0
+        assert stats["indexes"]["storageindex"]["disk_size"] >= 0
+        assert_equal(stats["latency"]["store"]["total"], 2)
+        assert_equal(stats["latency"]["fetch"]["total"], 2)
+        assert_equal(stats["latency"]["list"]["total"], 1)
+        for op in ("list", "fetch", "store"):
+            window = stats["latency"][op]["windows"][0]
+            assert_equal(window["count"], stats["latency"][op]["total"])
+            assert window["max_ms"] >= window["average_ms"] >= 0
+        assert_equal(stats["worker"]["wait"]["total"], 4)
+        fetch_cache = stats["cache"]["fetch"]
+        assert_equal((fetch_cache["entries"], fetch_cache["hits"], fetch_cache["misses"]), (1, 1, 1))
+        assert_equal(fetch_cache["hit_rate"], 0.5)
+        assert_equal(fetch_cache["max_size"], 10 << 20)
+
+        self.log.info("Check the cached listing, without the index")
+        self.restart_node(0, extra_args=self.extra_args[0][:1])
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        stats = node.getstoragestats()
+        assert "assets" not in stats
+        assert "storageindex" not in stats["indexes"]
+        assert "fetch" not in stats["cache"]
+        assert_equal(len(node.list()[0]), 2)
+        self.generate(node, 1)
+        assert_equal(len(node.list()[0]), 2)
+        assert_equal(node.getstoragestats()["cache"]["list"], {"extended": 1, "rescanned": 1, "tenants": 1})
+
+
+if __name__ == '__main__':
+    StorageStatsTest().main()
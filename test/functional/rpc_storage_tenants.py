@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the tenants RPC at past heights.
+
+The authlist history records the heights over which each tenant was on the
+authlist. It follows the chain through reorgs, is kept in authlist.dat across
+restarts and is rebuilt from the blocks without it.
+"""
+
+import os
+
+from test_framework.storage import make_key
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class StorageTenantsTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, self.manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={self.manager_user}"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def check_history(self, tenant, before, allowed, denied):
+        node = self.nodes[0]
+        assert_equal(node.tenants(before), [self.manager_user])
+        assert_equal(sorted(node.tenants(allowed)), sorted([self.manager_user, tenant]))
+        assert_equal(node.tenants(denied), [self.manager_user])
+
+    def run_test(self):
+        node = self.nodes[0]
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        _, tenant_user = make_key(bytes(range(2, 34)))
+
+        self.log.info("Add a tenant, then remove it")
+        before = node.getblockcount()
+        assert_equal(node.allow(tenant_user), "success")
+        self.generate(node, 1)
+        allowed = node.getblockcount()
+        assert_equal(node.deny(tenant_user), "success")
+        deny_block = self.generate(node, 1)[0]
+        denied = node.getblockcount()
+        self.generate(node, 2)
+
+        self.log.info("Check the tenants at each height")
+        assert_equal(node.tenants(), [self.manager_user])
+        self.check_history(tenant_user, before, allowed, denied)
+        assert_equal(node.tenants(denied + 2), [self.manager_user])
+        assert_equal(node.tenants(denied + 3), "height-out-of-range")
+        assert_equal(node.tenants(-1), "height-out-of-range")
+
+        self.log.info("Check that the history follows the chain through a reorg")
+        node.invalidateblock(deny_block)
+        assert_equal(node.getblockcount(), allowed)
+        assert_equal(node.tenants(denied), "height-out-of-range")
+        assert_equal(sorted(node.tenants(allowed)), sorted([self.manager_user, tenant_user]))
+        node.reconsiderblock(deny_block)
+        self.check_history(tenant_user, before, allowed, denied)
+
+        self.log.info("Check that the history is kept across restarts")
+        self.restart_node(0)
+        self.check_history(tenant_user, before, allowed, denied)
+
+        self.log.info("Check that the history is rebuilt from the blocks")
+        self.stop_node(0)
+        os.remove(os.path.join(node.chain_path, "authlist.dat"))
+        self.start_node(0)
+        self.check_history(tenant_user, before, allowed, denied)
+
+
+if __name__ == '__main__':
+    StorageTenantsTest().main()
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the tenantusage RPC and the -storagequota store check.
+
+The storage index keeps the assets, bytes and fees of the confirmed chunks of
+each tenant as running totals, which follow the chain through reorgs.
+"""
+
+import os
+
+from test_framework.script import hash160
+from test_framework.storage import make_key, wait_for_job
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+# Random data does not compress, so files are stored as they are
+FILE_SIZE = 3000
+QUOTA_FILE_SIZE = 600 * 1000
+
+
+class StorageUsageTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={manager_user}", "-storageindex"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def store(self, name, size):
+        node = self.nodes[0]
+        path = os.path.join(self.options.tmpdir, name)
+        with open(path, "wb") as f:
+            f.write(os.urandom(size))
+        uuid = node.store(path)
+        wait_for_job(node, uuid)
+        return path
+
+    def check_usage(self, tenant, assets, size, fees):
+        usage = self.nodes[0].tenantusage(tenant)
+        assert_equal(usage, {"tenant": tenant, "assets": assets, "bytes": size, "fees": fees})
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Authorize a tenant")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenant_wif, tenant_user = make_key(bytes(range(2, 34)))
+        _, other_user = make_key(bytes(range(3, 35)))
+        assert_equal(node.allow(tenant_user), "success")
+        self.generate(node, 1)
+        assert_equal(node.auth(tenant_wif)[0], "success")
+        self.check_usage(tenant_user, 0, 0, 0)
+
+        self.log.info("Check that only confirmed chunks count")
+        self.store("asset", FILE_SIZE)
+        self.check_usage(tenant_user, 0, 0, 0)
+        block = self.generate(node, 1)[0]
+        # Every transaction of the block but the coinbase holds chunks of the asset
+        fees = -sum(node.gettransaction(txid)["fee"] for txid in node.getblock(block)["tx"][1:])
+        self.check_usage(tenant_user, 1, FILE_SIZE, fees)
+        assert_equal(node.tenantusage(), node.tenantusage(tenant_user))
+        self.check_usage(other_user, 0, 0, 0)
+
+        self.log.info("Check that the usage follows the chain through a reorg")
+        node.invalidateblock(block)
+        self.check_usage(tenant_user, 0, 0, 0)
+        node.reconsiderblock(block)
+        self.check_usage(tenant_user, 1, FILE_SIZE, fees)
+
+        self.log.info("Check the failures")
+        assert_equal(node.tenantusage("00" * 19), "hash160-wrong-size")
+        self.restart_node(0, extra_args=[self.extra_args[0][0]])
+        assert_equal(node.tenantusage(tenant_user), "storageindex-required")
+
+        self.log.info("Check that a tenant past its quota stores nothing more")
+        self.restart_node(0, extra_args=self.extra_args[0] + ["-storagequota=1"])
+        assert_equal(node.auth(tenant_wif)[0], "success")
+        self.store("first", QUOTA_FILE_SIZE)
+        self.generate(node, 1)
+        path = os.path.join(self.options.tmpdir, "second")
+        with open(path, "wb") as f:
+            f.write(os.urandom(QUOTA_FILE_SIZE))
+        assert_equal(node.store(path), "quota-exceeded")
+        assert_equal(node.tenantusage()["bytes"], FILE_SIZE + QUOTA_FILE_SIZE)
+
+
+if __name__ == '__main__':
+    StorageUsageTest().main()
@@ -4,8 +4,14 @@
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 """Helper routines relevant for compact block filters (BIP158).
 """
+from io import BytesIO
+
+from .messages import deser_compact_size
 from .siphash import siphash
 
+# Golomb-Rice parameter of the basic and storage filters, BASIC_FILTER_P
+BASIC_FILTER_P = 19
+
 
 def bip158_basic_element_hash(script_pub_key, N, block_hash):
     """ Calculates the ranged hash of a filter element as defined in BIP158:
@@ -47,3 +53,25 @@ def bip158_relevant_scriptpubkeys(node, block_hash):
             if o['scriptPubKey']['type'] != 'nulldata':
                 spks.add(bytes.fromhex(o['scriptPubKey']['hex']))
     return spks
+
+
+def gcs_filter_matches(filter_bytes, element, block_hash):
+    """ Whether a basic or storage filter, as getblockfilter and cfilter carry it,
+    may hold element. Decodes the Golomb-Rice coded set as defined in BIP158."""
+    f = BytesIO(filter_bytes)
+    N = deser_compact_size(f)
+    bits = ''.join(f'{byte:08b}' for byte in f.read())
+    target = bip158_basic_element_hash(element, N, block_hash)
+    pos = 0
+    value = 0
+    for _ in range(N):
+        quotient = 0
+        while bits[pos] == '1':
+            quotient += 1
+            pos += 1
+        pos += 1
+        value += (quotient << BASIC_FILTER_P) | int(bits[pos:pos + BASIC_FILTER_P], 2)
+        pos += BASIC_FILTER_P
+        if value == target:
+            return True
+    return False
@@ -51,6 +51,7 @@ NODE_BLOOM = (1 << 2)
 NODE_WITNESS = (1 << 3)
 NODE_COMPACT_FILTERS = (1 << 6)
 NODE_NETWORK_LIMITED = (1 << 10)
+NODE_STORAGE = (1 << 12)
 
 MSG_TX = 1
 MSG_BLOCK = 2
@@ -1839,6 +1840,178 @@ class msg_cfcheckpt:
         return "msg_cfcheckpt(filter_type={:#x}, stop_hash={:x})".format(
             self.filter_type, self.stop_hash)
 
+class msg_getassetchunks:
+    __slots__ = ("uuid", "first", "count")
+    msgtype = b"getassetchunks"
+
+    def __init__(self, uuid=b"", first=0, count=0):
+        # 32 bytes, in the order of the hex form of the uuid
+        self.uuid = uuid
+        self.first = first
+        self.count = count
+
+    def deserialize(self, f):
+        self.uuid = f.read(32)
+        self.first = struct.unpack("<I", f.read(4))[0]
+        self.count = struct.unpack("<I", f.read(4))[0]
+
+    def serialize(self):
+        r = b""
+        r += self.uuid
+        r += struct.pack("<I", self.first)
+        r += struct.pack("<I", self.count)
+        return r
+
+    def __repr__(self):
+        return "msg_getassetchunks(uuid=%s, first=%i, count=%i)" % (self.uuid.hex(), self.first, self.count)
+
+class msg_assetchunks:
+    __slots__ = ("uuid", "first", "chunk_total", "header", "chunks")
+    msgtype = b"assetchunks"
+
+    def __init__(self):
+        self.uuid = b""
+        self.first = 0
+        self.chunk_total = 0
+        self.header = b""
+        self.chunks = []
+
+    def deserialize(self, f):
+        self.uuid = f.read(32)
+        self.first = struct.unpack("<I", f.read(4))[0]
+        self.chunk_total = struct.unpack("<I", f.read(4))[0]
+        self.header = deser_string(f)
+        self.chunks = deser_string_vector(f)
+
+    def serialize(self):
+        r = b""
+        r += self.uuid
+        r += struct.pack("<I", self.first)
+        r += struct.pack("<I", self.chunk_total)
+        r += ser_string(self.header)
+        r += ser_string_vector(self.chunks)
+        return r
+
+    def __repr__(self):
+        return "msg_assetchunks(uuid=%s, first=%i, chunk_total=%i, chunks=%i)" % (self.uuid.hex(), self.first, self.chunk_total, len(self.chunks))
+
+def ser_varint(n):
+    """VARINT of serialize.h, base 128 with the high bit on all bytes but the last"""
+    tmp = []
+    while True:
+        tmp.append((n & 0x7f) | (0x80 if tmp else 0))
+        if n <= 0x7f:
+            break
+        n = (n >> 7) - 1
+    return bytes(reversed(tmp))
+
+
+def deser_varint(f):
+    n = 0
+    while True:
+        ch = f.read(1)[0]
+        n = (n << 7) | (ch & 0x7f)
+        if not ch & 0x80:
+            return n
+        n += 1
+
+
+class msg_sendcheaders:
+    __slots__ = ("version",)
+    msgtype = b"sendcheaders"
+
+    def __init__(self, version=1):
+        self.version = version
+
+    def deserialize(self, f):
+        self.version = struct.unpack("<Q", f.read(8))[0]
+
+    def serialize(self):
+        return struct.pack("<Q", self.version)
+
+    def __repr__(self):
+        return "msg_sendcheaders(version=%i)" % self.version
+
+class msg_cheaders:
+    """Headers of consecutive blocks, the first in full and the others against the one before"""
+    __slots__ = ("headers",)
+    msgtype = b"cheaders"
+
+    def __init__(self, headers=None):
+        self.headers = headers if headers is not None else []
+
+    @staticmethod
+    def recent_index(recent, value):
+        """Position plus one of a value among the recent ones, moved to the front, or 0 once added"""
+        if value in recent:
+            index = recent.index(value)
+            recent.insert(0, recent.pop(index))
+            return index + 1
+        recent.insert(0, value)
+        del recent[3:]
+        return 0
+
+    @staticmethod
+    def recent_value(recent, index):
+        value = recent.pop(index - 1)
+        recent.insert(0, value)
+        return value
+
+    def deserialize(self, f):
+        self.headers = []
+        count = deser_compact_size(f)
+        if count == 0:
+            return
+        first = CBlockHeader()
+        first.deserialize(f)
+        self.headers.append(first)
+        versions, bits = [first.nVersion], [first.nBits]
+        for _ in range(count - 1):
+            prev = self.headers[-1]
+            prev.calc_sha256()
+            header = CBlockHeader()
+            header.hashPrevBlock = prev.sha256
+            flags = f.read(1)[0]
+            assert flags < 0x10
+            if flags & 3:
+                header.nVersion = self.recent_value(versions, flags & 3)
+            else:
+                header.nVersion = struct.unpack("<i", f.read(4))[0]
+                self.recent_index(versions, header.nVersion)
+            if (flags >> 2) & 3:
+                header.nBits = self.recent_value(bits, (flags >> 2) & 3)
+            else:
+                header.nBits = struct.unpack("<I", f.read(4))[0]
+                self.recent_index(bits, header.nBits)
+            zigzag = deser_varint(f)
+            header.nTime = prev.nTime + (-(zigzag >> 1) - 1 if zigzag & 1 else zigzag >> 1)
+            header.hashMerkleRoot = deser_uint256(f)
+            header.nNonce = struct.unpack("<I", f.read(4))[0]
+            self.headers.append(header)
+
+    def serialize(self):
+        r = ser_compact_size(len(self.headers))
+        if not self.headers:
+            return r
+        r += self.headers[0].serialize()
+        versions, bits = [self.headers[0].nVersion], [self.headers[0].nBits]
+        for prev, header in zip(self.headers, self.headers[1:]):
+            version_index = self.recent_index(versions, header.nVersion)
+            bits_index = self.recent_index(bits, header.nBits)
+            r += bytes([version_index | (bits_index << 2)])
+            if not version_index:
+                r += struct.pack("<i", header.nVersion)
+            if not bits_index:
+                r += struct.pack("<I", header.nBits)
+            delta = header.nTime - prev.nTime
+            r += ser_varint(-2 * delta - 1 if delta < 0 else 2 * delta)
+            r += ser_uint256(header.hashMerkleRoot)
+            r += struct.pack("<I", header.nNonce)
+        return r
+
+    def __repr__(self):
+        return "msg_cheaders(headers=%s)" % repr(self.headers)
+
 class msg_sendtxrcncl:
     __slots__ = ("version", "salt")
     msgtype = b"sendtxrcncl"
@@ -33,18 +33,21 @@ from test_framework.messages import (
     MAX_HEADERS_RESULTS,
     msg_addr,
     msg_addrv2,
+    msg_assetchunks,
     msg_block,
     MSG_BLOCK,
     msg_blocktxn,
     msg_cfcheckpt,
     msg_cfheaders,
     msg_cfilter,
+    msg_cheaders,
     msg_cmpctblock,
     msg_feefilter,
     msg_filteradd,
     msg_filterclear,
     msg_filterload,
     msg_getaddr,
+    msg_getassetchunks,
     msg_getblocks,
     msg_getblocktxn,
     msg_getcfcheckpt,
@@ -60,6 +63,7 @@ from test_framework.messages import (
     msg_ping,
     msg_pong,
     msg_sendaddrv2,
+    msg_sendcheaders,
     msg_sendcmpct,
     msg_sendheaders,
     msg_sendtxrcncl,
@@ -99,17 +103,20 @@ NONPREF_PEER_TX_DELAY = 2
 MESSAGEMAP = {
     b"addr": msg_addr,
     b"addrv2": msg_addrv2,
+    b"assetchunks": msg_assetchunks,
     b"block": msg_block,
     b"blocktxn": msg_blocktxn,
     b"cfcheckpt": msg_cfcheckpt,
     b"cfheaders": msg_cfheaders,
     b"cfilter": msg_cfilter,
+    b"cheaders": msg_cheaders,
     b"cmpctblock": msg_cmpctblock,
     b"feefilter": msg_feefilter,
     b"filteradd": msg_filteradd,
     b"filterclear": msg_filterclear,
     b"filterload": msg_filterload,
     b"getaddr": msg_getaddr,
+    b"getassetchunks": msg_getassetchunks,
     b"getblocks": msg_getblocks,
     b"getblocktxn": msg_getblocktxn,
     b"getcfcheckpt": msg_getcfcheckpt,
@@ -125,6 +132,7 @@ MESSAGEMAP = {
     b"ping": msg_ping,
     b"pong": msg_pong,
     b"sendaddrv2": msg_sendaddrv2,
+    b"sendcheaders": msg_sendcheaders,
     b"sendcmpct": msg_sendcmpct,
     b"sendheaders": msg_sendheaders,
     b"sendtxrcncl": msg_sendtxrcncl,
@@ -400,17 +408,20 @@ class P2PInterface(P2PConnection):
 
     def on_addr(self, message): pass
     def on_addrv2(self, message): pass
+    def on_assetchunks(self, message): pass
     def on_block(self, message): pass
     def on_blocktxn(self, message): pass
     def on_cfcheckpt(self, message): pass
     def on_cfheaders(self, message): pass
     def on_cfilter(self, message): pass
+    def on_cheaders(self, message): pass
     def on_cmpctblock(self, message): pass
     def on_feefilter(self, message): pass
     def on_filteradd(self, message): pass
     def on_filterclear(self, message): pass
     def on_filterload(self, message): pass
     def on_getaddr(self, message): pass
+    def on_getassetchunks(self, message): pass
     def on_getblocks(self, message): pass
     def on_getblocktxn(self, message): pass
     def on_getdata(self, message): pass
@@ -421,6 +432,7 @@ class P2PInterface(P2PConnection):
     def on_notfound(self, message): pass
     def on_pong(self, message): pass
     def on_sendaddrv2(self, message): pass
+    def on_sendcheaders(self, message): pass
     def on_sendcmpct(self, message): pass
     def on_sendheaders(self, message): pass
     def on_sendtxrcncl(self, message): pass
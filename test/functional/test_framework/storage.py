@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Helpers for the tests of the storage subsystem."""
+
+import os
+
+from test_framework.key import ECKey
+from test_framework.script import hash160
+from test_framework.util import (
+    assert_equal,
+    wait_until_helper,
+)
+from test_framework.wallet_util import bytes_to_wif
+
+# States a storage job does not leave
+JOB_END_STATES = ("done", "failed", "cancelled")
+
+
+def make_key(secret):
+    """Return the WIF of the key of secret, and the user the auth RPCs know the key as."""
+    key = ECKey()
+    key.set(secret, True)
+    wif = bytes_to_wif(key.get_bytes())
+    # uint160 as the auth RPCs parse and print it, in reverse byte order
+    user = hash160(key.get_pubkey().get_bytes())[::-1].hex()
+    return wif, user
+
+
+def wait_for_job(node, job_id, *, state="done", timeout=60):
+    """Wait for job job_id of node to end, check that it ended in state, and return it."""
+    job = {}
+
+    def job_finished():
+        nonlocal job
+        job = node.getjob(job_id)
+        return job["state"] in JOB_END_STATES
+    wait_until_helper(job_finished, timeout=timeout, timeout_factor=node.timeout_factor)
+    assert_equal(job["state"], state)
+    return job
+
+
+def write_file(directory, name, data):
+    """Write data to file name in directory, and return its path."""
+    path = os.path.join(directory, name)
+    with open(path, "wb") as f:
+        f.write(data)
+    return path
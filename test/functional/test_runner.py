@@ -86,6 +86,7 @@ EXTENDED_SCRIPTS = [
     'feature_dbcrash.py',
     'feature_index_prune.py',
     'wallet_pruning.py --legacy-wallet',
+    'feature_storage_throughput.py',
 ]
 
 BASE_SCRIPTS = [
@@ -99,6 +100,9 @@ BASE_SCRIPTS = [
     'mining_getblocktemplate_longpoll.py',
     'p2p_segwit.py',
     'feature_maxuploadtarget.py',
+    'feature_storage_resume.py',
+    'feature_storage_qos.py',
+    'feature_cache_sizes.py',
     'mempool_updatefromblock.py',
     'mempool_persist.py --descriptors',
     # vv Tests less than 60s vv
@@ -142,6 +146,8 @@ BASE_SCRIPTS = [
     'p2p_sendheaders.py',
     'wallet_listtransactions.py --legacy-wallet',
     'wallet_listtransactions.py --descriptors',
+    'wallet_list_pages.py --legacy-wallet',
+    'wallet_list_pages.py --descriptors',
     # vv Tests less than 30s vv
     'p2p_invalid_messages.py',
     'rpc_createmultisig.py',
@@ -178,9 +184,11 @@ BASE_SCRIPTS = [
     'tool_wallet.py --descriptors',
     'tool_signet_miner.py --legacy-wallet',
     'tool_signet_miner.py --descriptors',
+    'tool_storage_tx.py',
     'wallet_txn_clone.py',
     'wallet_txn_clone.py --segwit',
     'rpc_getchaintips.py',
+    'rpc_jobs.py',
     'rpc_misc.py',
     'interface_rest.py',
     'mempool_spend_coinbase.py',
@@ -212,6 +220,8 @@ BASE_SCRIPTS = [
     'wallet_transactiontime_rescan.py --legacy-wallet',
     'p2p_addrv2_relay.py',
     'p2p_compactblocks_hb.py',
+    'p2p_storage_chunks.py',
+    'p2p_storage_filters.py',
     'p2p_disconnect_ban.py',
     'feature_posix_fs_permissions.py',
     'rpc_decodescript.py',
@@ -246,6 +256,15 @@ BASE_SCRIPTS = [
     'wallet_txn_clone.py --mineblock',
     'feature_notifications.py',
     'rpc_getblockfilter.py',
+    'rpc_storage_batch.py',
+    'rpc_storage_blockchunks.py',
+    'rpc_storage_encrypt.py',
+    'rpc_storage_fetchbatch.py',
+    'rpc_storage_proof.py',
+    'rpc_storage_reuse.py',
+    'rpc_storage_stats.py',
+    'rpc_storage_tenants.py',
+    'rpc_storage_usage.py',
     'rpc_getblockfrompeer.py',
     'rpc_invalidateblock.py',
     'feature_utxo_set_hash.py',
@@ -266,6 +285,7 @@ BASE_SCRIPTS = [
     'wallet_balance.py --legacy-wallet',
     'wallet_balance.py --descriptors',
     'p2p_initial_headers_sync.py',
+    'p2p_compressed_headers.py',
     'feature_nulldummy.py',
     'mempool_accept.py',
     'mempool_expiry.py',
@@ -289,6 +309,7 @@ BASE_SCRIPTS = [
     'feature_dersig.py',
     'feature_cltv.py',
     'rpc_uptime.py',
+    'rpc_startupinfo.py',
     'feature_discover.py',
     'wallet_resendwallettransactions.py --legacy-wallet',
     'wallet_resendwallettransactions.py --descriptors',
@@ -332,6 +353,7 @@ BASE_SCRIPTS = [
     'p2p_tx_privacy.py',
     'rpc_scanblocks.py',
     'p2p_sendtxrcncl.py',
+    'p2p_txreconciliation.py',
     'rpc_scantxoutset.py',
     'feature_txindex_compatibility.py',
     'feature_unsupported_utxo_db.py',
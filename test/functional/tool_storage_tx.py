@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test encoding an asset offline with bitcoin-util storagetx.
+
+The tool signs the header chunk with the tenant key and prints the unsigned
+transactions carrying the chunks. The node funds, signs and broadcasts them
+as any raw transaction, then fetches the asset as if it had stored it.
+"""
+
+import json
+import os
+import subprocess
+
+from test_framework.storage import make_key, wait_for_job
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class StorageTxToolTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.manager_wif, manager_user = make_key(bytes(range(1, 33)))
+        self.extra_args = [[f"-regtestauthuser={manager_user}"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+        self.skip_if_no_bitcoin_util()
+
+    def storagetx(self, *args):
+        return subprocess.run([self.options.bitcoinutil, "-regtest", "storagetx", *args],
+                              capture_output=True, text=True)
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.log.info("Authorize a tenant, whose key stays out of the node")
+        assert_equal(node.auth(self.manager_wif)[0], "success")
+        tenant_wif, tenant_user = make_key(bytes(range(2, 34)))
+        assert_equal(node.allow(tenant_user), "success")
+        self.generate(node, 1)
+
+        # More chunks than one transaction carries
+        data = os.urandom(40000)
+        path = os.path.join(self.options.tmpdir, "asset")
+        with open(path, "wb") as f:
+            f.write(data)
+
+        self.log.info("Encode the asset offline")
+        uuid = "ab" * 32
+        res = self.storagetx(path, tenant_wif, uuid)
+        assert_equal(res.returncode, 0)
+        encoded = json.loads(res.stdout)
+        assert_equal(encoded["uuid"], uuid)
+        assert len(encoded["transactions"]) > 1
+        for tx_hex in encoded["transactions"]:
+            tx = node.decoderawtransaction(tx_hex)
+            assert_equal(tx["vin"], [])
+            assert all(out["scriptPubKey"]["type"] == "nulldata" for out in tx["vout"])
+
+        self.log.info("Fund, sign and broadcast the transactions from the wallet")
+        for tx_hex in encoded["transactions"]:
+            funded = node.fundrawtransaction(tx_hex)["hex"]
+            signed = node.signrawtransactionwithwallet(funded)
+            assert signed["complete"]
+            node.sendrawtransaction(signed["hex"])
+        self.generate(node, 1)
+
+        self.log.info("Fetch the asset stored")
+        fetch_dir = os.path.join(self.options.tmpdir, "fetch")
+        os.mkdir(fetch_dir)
+        wait_for_job(node, node.fetch(uuid, fetch_dir))
+        with open(os.path.join(fetch_dir, uuid), "rb") as f:
+            assert_equal(f.read(), data)
+
+        self.log.info("Check that the uuid is chosen when not given")
+        res = self.storagetx(path, tenant_wif)
+        assert_equal(res.returncode, 0)
+        assert_equal(len(json.loads(res.stdout)["uuid"]), 64)
+
+        self.log.info("Check the arguments")
+        res = self.storagetx(path, "notakey")
+        assert_equal(res.returncode, 1)
+        assert_equal(res.stderr.strip(), "Invalid tenant key")
+        res = self.storagetx(path, tenant_wif, "abcd")
+        assert_equal(res.returncode, 1)
+        assert_equal(res.stderr.strip(), "Invalid uuid, must be 64 hex characters")
+        res = self.storagetx(os.path.join(self.options.tmpdir, "missing"), tenant_wif)
+        assert_equal(res.returncode, 1)
+
+
+if __name__ == '__main__':
+    StorageTxToolTest().main()
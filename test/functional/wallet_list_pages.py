@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Lynx Core Developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test paging through listtransactions, listsinceblock and listunspent with cursors."""
+
+from test_framework.blocktools import COINBASE_MATURITY
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+)
+
+
+def entry_key(entry):
+    return (entry["txid"], entry["category"], entry["vout"])
+
+
+class WalletListPagesTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        self.add_wallet_options(parser)
+
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.generate(node, COINBASE_MATURITY + 10)
+        self.since_hash = node.getbestblockhash()
+        self.since_height = node.getblockcount()
+        # Transactions at several heights, some to a label, the last ones unconfirmed
+        for i in range(12):
+            label = "pages" if i % 3 == 0 else ""
+            node.sendtoaddress(node.getnewaddress(label), 1 + i)
+            if i % 4 == 3:
+                self.generate(node, 1)
+        node.sendtoaddress(node.getnewaddress("pages"), 2)
+
+        self.test_listtransactions()
+        self.test_listsinceblock()
+        self.test_listunspent()
+        self.test_errors()
+
+    def page_transactions(self, label, count, options):
+        node = self.nodes[0]
+        listed = []
+        pages = 0
+        while True:
+            page = node.listtransactions(label, count, 0, False, options)
+            pages += 1
+            # Each page is oldest first, and comes before the previous one
+            listed = page["transactions"] + listed
+            if "cursor" not in page:
+                return listed, pages
+            options = dict(options, cursor=page["cursor"])
+
+    def test_listtransactions(self):
+        self.log.info("Test paging through listtransactions")
+        node = self.nodes[0]
+        full = node.listtransactions("*", 10000)
+        paged, pages = self.page_transactions("*", 7, {})
+        assert_equal([entry_key(e) for e in paged], [entry_key(e) for e in full])
+        assert pages > 1
+
+        self.log.info("Test leaving out coinstakes, of which this chain has none")
+        paged, _ = self.page_transactions("*", 7, {"exclude_coinstakes": True})
+        assert_equal([entry_key(e) for e in paged], [entry_key(e) for e in full])
+
+        self.log.info("Test paging through the transactions of a label")
+        full_label = node.listtransactions("pages", 10000)
+        assert len(full_label) >= 5
+        paged, _ = self.page_transactions("pages", 2, {})
+        assert_equal([entry_key(e) for e in paged], [entry_key(e) for e in full_label])
+
+        self.log.info("Test a height range, which leaves out unconfirmed transactions")
+        min_height = self.since_height - 3
+        max_height = self.since_height + 2
+        in_range = sorted(entry_key(e) for e in full if "blockheight" in e and min_height <= e["blockheight"] <= max_height)
+        paged, _ = self.page_transactions("*", 3, {"min_height": min_height, "max_height": max_height})
+        assert_equal(sorted(entry_key(e) for e in paged), in_range)
+        assert all(min_height <= e["blockheight"] <= max_height for e in paged)
+
+    def test_listsinceblock(self):
+        self.log.info("Test paging through listsinceblock")
+        node = self.nodes[0]
+        for blockhash in ["", self.since_hash]:
+            full = node.listsinceblock(blockhash)
+            listed = []
+            options = {"page_size": 4}
+            while True:
+                page = node.listsinceblock(blockhash, 1, False, True, False, None, options)
+                assert_equal(page["lastblock"], full["lastblock"])
+                assert_equal("removed" in page, "cursor" not in options)
+                listed += page["transactions"]
+                if "cursor" not in page:
+                    break
+                options["cursor"] = page["cursor"]
+            assert_equal(sorted(entry_key(e) for e in listed), sorted(entry_key(e) for e in full["transactions"]))
+
+    def test_listunspent(self):
+        self.log.info("Test paging through listunspent")
+        node = self.nodes[0]
+        for minconf in [0, 1]:
+            full = node.listunspent(minconf)
+            listed = []
+            options = {"page_size": 3}
+            pages = 0
+            while True:
+                page = node.listunspent(minconf, 9999999, [], True, options)
+                pages += 1
+                listed += page["unspents"]
+                if "cursor" not in page:
+                    break
+                options["cursor"] = page["cursor"]
+            assert_equal(sorted((u["txid"], u["vout"]) for u in listed), sorted((u["txid"], u["vout"]) for u in full))
+            assert pages > 1
+
+        self.log.info("Test that spent outputs leave the pages")
+        spent = node.listunspent(1)[0]
+        inputs = [{"txid": spent["txid"], "vout": spent["vout"]}]
+        txid = node.send(outputs=[{node.getnewaddress(): spent["amount"] / 2}], options={"inputs": inputs, "add_inputs": False})["txid"]
+        listed = node.listunspent(0, 9999999, [], True, {"page_size": 100000})["unspents"]
+        assert (spent["txid"], spent["vout"]) not in [(u["txid"], u["vout"]) for u in listed]
+        assert txid in [u["txid"] for u in listed]
+
+    def test_errors(self):
+        self.log.info("Test invalid paging arguments")
+        node = self.nodes[0]
+        assert_raises_rpc_error(-8, "Invalid cursor", node.listtransactions, "*", 10, 0, False, {"cursor": "nonsense"})
+        assert_raises_rpc_error(-8, "skip cannot be used with options", node.listtransactions, "*", 10, 1, False, {})
+        assert_raises_rpc_error(-8, "Invalid height range", node.listtransactions, "*", 10, 0, False, {"min_height": 5, "max_height": 4})
+        assert_raises_rpc_error(-8, "page_size must be at least 1", node.listsinceblock, "", 1, False, True, False, None, {"page_size": 0})
+        assert_raises_rpc_error(-8, "page_size must be at least 1", node.listunspent, 1, 9999999, [], True, {"page_size": 0})
+
+
+if __name__ == '__main__':
+    WalletListPagesTest().main()